@@ -31,6 +31,12 @@ blacklist = [
 
 minimum = int(sys.argv[6]) if len(sys.argv) > 5 else 0
 android = int(sys.argv[7]) if len(sys.argv) > 6 else 0
+openmp = int(sys.argv[8]) if len(sys.argv) > 7 else 0
+nnpack = int(sys.argv[9]) if len(sys.argv) > 8 else 0
+
+# keep the OpenMP header when the operators are parallelized
+if openmp != 0:
+    blacklist.remove('omp.h')
 
 # blacklist linear algebra headers when building without blas.
 if minimum != 0:
@@ -165,6 +171,10 @@ print >>f, '''
 #endif
 '''
 
+# the nnpack headers are left out unless the library is built with NNPACK
+if nnpack != 0:
+    print >>f, "#include <nnpack.h>"
+
 if minimum != 0 and android != 0 and 'complex.h' not in sysheaders:
     sysheaders.append('complex.h')
 
@@ -40,7 +40,9 @@
 
 #define MXNET_USE_OPENCV    0
 #define MXNET_PREDICT_ONLY  1
+#ifndef MXNET_PREDICT_USE_OPENMP
 #define DISABLE_OPENMP 1
+#endif
 #define DMLC_LOG_STACK_TRACE 0
 
 
@@ -51,6 +53,7 @@
 #include "src/engine/engine.cc"
 #include "src/engine/naive_engine.cc"
 #include "src/engine/profiler.cc"
+#include "src/engine/openmp.cc"
 
 #include "src/executor/graph_executor.cc"
 #include "src/executor/attach_op_execs_pass.cc"
@@ -78,6 +81,7 @@
 #include "src/operator/tensor/elemwise_binary_scalar_op_basic.cc"
 #include "src/operator/tensor/elemwise_unary_op.cc"
 #include "src/operator/tensor/matrix_op.cc"
+#include "src/operator/nnpack/nnpack_util.cc"
 
 #include "src/storage/storage.cc"
 
@@ -0,0 +1,76 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Keep only the operator sources used by a symbol in the amalgamation.
+
+Usage: python select_ops.py symbol.json mxnet_predict0.cc mxnet_predict1.cc
+
+The operator files included by mxnet_predict0.cc which register none of
+the operators of the symbol are left out of the output. Files registering
+no operator, like operator.cc, are always kept.
+"""
+from __future__ import print_function
+import json
+import os.path
+import re
+import sys
+
+# NNVM_REGISTER_OP(name), MXNET_REGISTER_OP_PROPERTY(name, ...) and the
+# MXNET_OPERATOR_REGISTER_* macros all take the operator name first
+re_register = re.compile(r'^\s*(?:NNVM_REGISTER_OP|MXNET_\w*REGISTER\w*)\(\s*(\w+)', re.M)
+re_alias = re.compile(r'\.add_alias\("(\w+)"\)')
+re_include = re.compile(r'^#include "(src/operator/[^"]+\.cc)"')
+
+
+def used_ops(symbol_file):
+    with open(symbol_file) as f:
+        graph = json.load(f)
+    return set(node['op'] for node in graph['nodes'] if node['op'] != 'null')
+
+
+def registered_ops(source):
+    with open(source) as f:
+        text = f.read()
+    return set(re_register.findall(text)) | set(re_alias.findall(text))
+
+
+def main(symbol_file, predict_in, predict_out):
+    root = os.path.join(os.path.dirname(os.path.realpath(__file__)), os.pardir)
+    ops = used_ops(symbol_file)
+    found = set()
+    lines = []
+    with open(predict_in) as f:
+        for line in f:
+            m = re_include.match(line)
+            if m:
+                registered = registered_ops(os.path.join(root, m.group(1)))
+                found |= registered & ops
+                if registered and not registered & ops:
+                    print('Leaving out', m.group(1))
+                    continue
+            lines.append(line)
+    for op in sorted(ops - found):
+        print('Warning: operator %s of %s is not in the amalgamation' % (op, symbol_file))
+    with open(predict_out, 'w') as f:
+        f.writelines(lines)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4:
+        print(__doc__)
+        sys.exit(1)
+    main(*sys.argv[1:])
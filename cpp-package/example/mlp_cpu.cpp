@@ -97,6 +97,16 @@ int main(int argc, char** argv) {
   auto arg_names = net.ListArguments();
 
   // Start training
+  // the parameters are updated together with one operator call
+  std::vector<int> param_indices;
+  std::vector<NDArray> params, grads;
+  for (size_t i = 0; i < arg_names.size(); ++i) {
+    if (arg_names[i] == "X" || arg_names[i] == "label") continue;
+    param_indices.push_back(i);
+    params.push_back(exec->arg_arrays[i]);
+    grads.push_back(exec->grad_arrays[i]);
+  }
+
   for (int iter = 0; iter < max_epoch; ++iter) {
     int samples = 0;
     train_iter.Reset();
@@ -113,10 +123,7 @@ int main(int argc, char** argv) {
       exec->Forward(true);
       exec->Backward();
       // Update parameters
-      for (size_t i = 0; i < arg_names.size(); ++i) {
-        if (arg_names[i] == "X" || arg_names[i] == "label") continue;
-        opt->Update(i, exec->arg_arrays[i], exec->grad_arrays[i]);
-      }
+      opt->Update(param_indices, params, grads);
     }
     auto toc = chrono::system_clock::now();
 
@@ -61,6 +61,7 @@ int main(int argc, char** argv) {
       .SetParam("label", "./mnist_data/train-labels-idx1-ubyte")
       .SetParam("batch_size", batch_size)
       .SetParam("flat", 1)
+      .SetParam("ctx", "cpu_pinned")
       .CreateDataIter();
   auto val_iter = MXDataIter("MNISTIter")
       .SetParam("image", "./mnist_data/t10k-images-idx3-ubyte")
@@ -101,21 +102,22 @@ int main(int argc, char** argv) {
   // Create metrics
   Accuracy train_acc, val_acc;
 
+  // The batches are copied to the GPU one batch ahead, while the previous one is trained
+  DevicePrefetchIter train_gpu_iter(&train_iter, ctx);
+
   // Start training
   for (int iter = 0; iter < max_epoch; ++iter) {
     int samples = 0;
-    train_iter.Reset();
+    train_gpu_iter.Reset();
     train_acc.Reset();
 
     auto tic = chrono::system_clock::now();
-    while (train_iter.Next()) {
+    while (train_gpu_iter.Next()) {
       samples += batch_size;
-      auto data_batch = train_iter.GetDataBatch();
-      // Data provided by DataIter are stored in memory, should be copied to GPU first.
+      auto data_batch = train_gpu_iter.GetDataBatch();
+      // The engine orders these copies after the copies of the batch to the GPU
       data_batch.data.CopyTo(&args["X"]);
       data_batch.label.CopyTo(&args["label"]);
-      // CopyTo is imperative, need to wait for it to complete.
-      NDArray::WaitAll();
 
       // Compute gradients
       exec->Forward(true);
@@ -0,0 +1,568 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file train_throughput.cpp
+ * \brief Training throughput of standard models on synthetic in-memory data,
+ *  across GPU counts and kvstore types, without any IO in the loop.
+ *
+ * Usage: train_throughput [--model resnet50,inception_v3,lstm_lm,wide_deep]
+ *                         [--gpus 4] [--kvstore local,device] [--batch-size 32]
+ *                         [--warmup 5] [--iters 20]
+ *
+ * Every model is trained data parallel on 1, 2, ... --gpus GPUs (the CPU with
+ * --gpus 0), --batch-size samples per device, and prints one JSON line per
+ * configuration with the samples per second and the scaling efficiency, the
+ * speedup over one GPU divided by the number of GPUs. dist_sync runs alone in
+ * --kvstore, with the processes started by tools/launch.py.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mxnet-cpp/MxNetCpp.h"
+// Allow IDE to parse the types
+#include "../include/mxnet-cpp/op.h"
+
+using namespace mxnet::cpp;
+
+namespace {
+
+Symbol ConvLayer(const std::string& name, Symbol data, int num_filter, Shape kernel,
+                 Shape stride = Shape(1, 1), Shape pad = Shape(0, 0)) {
+  return Operator("Convolution")
+      .SetParam("kernel", kernel)
+      .SetParam("num_filter", num_filter)
+      .SetParam("stride", stride)
+      .SetParam("pad", pad)
+      .SetParam("no_bias", true)
+      .SetParam("workspace", 1024)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol BNLayer(const std::string& name, Symbol data) {
+  return Operator("BatchNorm")
+      .SetParam("fix_gamma", false)
+      .SetParam("eps", 2e-5)
+      .SetParam("momentum", 0.9)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol ActLayer(const std::string& name, Symbol data, const std::string& act_type = "relu") {
+  return Operator("Activation")
+      .SetParam("act_type", act_type)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol ConvBNReLU(const std::string& name, Symbol data, int num_filter, Shape kernel,
+                  Shape stride = Shape(1, 1), Shape pad = Shape(0, 0)) {
+  Symbol conv = ConvLayer(name + "_conv", data, num_filter, kernel, stride, pad);
+  return ActLayer(name + "_relu", BNLayer(name + "_bn", conv));
+}
+
+Symbol PoolLayer(const std::string& name, Symbol data, const std::string& pool_type,
+                 Shape kernel, Shape stride = Shape(1, 1), Shape pad = Shape(0, 0),
+                 bool global_pool = false) {
+  return Operator("Pooling")
+      .SetParam("kernel", kernel)
+      .SetParam("stride", stride)
+      .SetParam("pad", pad)
+      .SetParam("pool_type", pool_type)
+      .SetParam("global_pool", global_pool)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol FCLayer(const std::string& name, Symbol data, int num_hidden) {
+  return Operator("FullyConnected")
+      .SetParam("num_hidden", num_hidden)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol FCLayer(const std::string& name, Symbol data, Symbol weight, Symbol bias,
+               int num_hidden) {
+  return Operator("FullyConnected")
+      .SetParam("num_hidden", num_hidden)
+      .SetInput("data", data)
+      .SetInput("weight", weight)
+      .SetInput("bias", bias)
+      .CreateSymbol(name);
+}
+
+Symbol ConcatLayer(const std::string& name, const std::vector<Symbol>& inputs, int dim = 1) {
+  return Operator("Concat")
+      .SetParam("num_args", inputs.size())
+      .SetParam("dim", dim)(inputs)
+      .CreateSymbol(name);
+}
+
+Symbol FlattenLayer(const std::string& name, Symbol data) {
+  return Operator("Flatten").SetInput("data", data).CreateSymbol(name);
+}
+
+Symbol EmbeddingLayer(const std::string& name, Symbol data, int input_dim, int output_dim) {
+  return Operator("Embedding")
+      .SetParam("input_dim", input_dim)
+      .SetParam("output_dim", output_dim)
+      .SetInput("data", data)
+      .CreateSymbol(name);
+}
+
+Symbol SoftmaxLayer(Symbol data, Symbol label) {
+  return Operator("SoftmaxOutput")
+      .SetInput("data", data)
+      .SetInput("label", label)
+      .CreateSymbol("softmax");
+}
+
+/*! \brief bottleneck unit of the pre-activation ResNet */
+Symbol ResNetUnit(const std::string& name, Symbol data, int num_filter, int stride,
+                  bool dim_match) {
+  Symbol act1 = ActLayer(name + "_relu1", BNLayer(name + "_bn1", data));
+  Symbol conv1 = ConvLayer(name + "_conv1", act1, num_filter / 4, Shape(1, 1));
+  Symbol act2 = ActLayer(name + "_relu2", BNLayer(name + "_bn2", conv1));
+  Symbol conv2 = ConvLayer(name + "_conv2", act2, num_filter / 4, Shape(3, 3),
+                           Shape(stride, stride), Shape(1, 1));
+  Symbol act3 = ActLayer(name + "_relu3", BNLayer(name + "_bn3", conv2));
+  Symbol conv3 = ConvLayer(name + "_conv3", act3, num_filter, Shape(1, 1));
+  Symbol shortcut = dim_match ? data :
+      ConvLayer(name + "_sc", act1, num_filter, Shape(1, 1), Shape(stride, stride));
+  return conv3 + shortcut;
+}
+
+Symbol ResNet50(int num_classes) {
+  const int units[] = {3, 4, 6, 3};
+  const int filters[] = {256, 512, 1024, 2048};
+  Symbol data = Symbol::Variable("data");
+  Symbol body = ConvLayer("conv0", BNLayer("bn_data", data), 64, Shape(7, 7),
+                          Shape(2, 2), Shape(3, 3));
+  body = ActLayer("relu0", BNLayer("bn0", body));
+  body = PoolLayer("pool0", body, "max", Shape(3, 3), Shape(2, 2), Shape(1, 1));
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < units[i]; ++j) {
+      body = ResNetUnit("stage" + std::to_string(i + 1) + "_unit" + std::to_string(j + 1),
+                        body, filters[i], (i == 0 || j > 0) ? 1 : 2, j > 0);
+    }
+  }
+  body = ActLayer("relu1", BNLayer("bn1", body));
+  Symbol pool = PoolLayer("pool1", body, "avg", Shape(7, 7), Shape(1, 1), Shape(0, 0), true);
+  Symbol fc = FCLayer("fc1", FlattenLayer("flatten", pool), num_classes);
+  return SoftmaxLayer(fc, Symbol::Variable("softmax_label"));
+}
+
+Symbol InceptionA(const std::string& name, Symbol data, int proj) {
+  Symbol b1 = ConvBNReLU(name + "_1x1", data, 64, Shape(1, 1));
+  Symbol b5 = ConvBNReLU(name + "_5x5_reduce", data, 48, Shape(1, 1));
+  b5 = ConvBNReLU(name + "_5x5", b5, 64, Shape(5, 5), Shape(1, 1), Shape(2, 2));
+  Symbol b3 = ConvBNReLU(name + "_3x3_reduce", data, 64, Shape(1, 1));
+  b3 = ConvBNReLU(name + "_3x3_1", b3, 96, Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  b3 = ConvBNReLU(name + "_3x3_2", b3, 96, Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  Symbol bp = PoolLayer(name + "_pool", data, "avg", Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  bp = ConvBNReLU(name + "_proj", bp, proj, Shape(1, 1));
+  return ConcatLayer(name + "_concat", {b1, b5, b3, bp});
+}
+
+Symbol ReductionA(const std::string& name, Symbol data) {
+  Symbol b3 = ConvBNReLU(name + "_3x3", data, 384, Shape(3, 3), Shape(2, 2));
+  Symbol bd = ConvBNReLU(name + "_3x3d_reduce", data, 64, Shape(1, 1));
+  bd = ConvBNReLU(name + "_3x3d_1", bd, 96, Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  bd = ConvBNReLU(name + "_3x3d_2", bd, 96, Shape(3, 3), Shape(2, 2));
+  Symbol bp = PoolLayer(name + "_pool", data, "max", Shape(3, 3), Shape(2, 2));
+  return ConcatLayer(name + "_concat", {b3, bd, bp});
+}
+
+/*! \brief the 17x17 block, with the 7x7 convolutions factorized in 1x7 and 7x1 */
+Symbol InceptionB(const std::string& name, Symbol data, int c7) {
+  Symbol b1 = ConvBNReLU(name + "_1x1", data, 192, Shape(1, 1));
+  Symbol b7 = ConvBNReLU(name + "_7x7_reduce", data, c7, Shape(1, 1));
+  b7 = ConvBNReLU(name + "_1x7", b7, c7, Shape(1, 7), Shape(1, 1), Shape(0, 3));
+  b7 = ConvBNReLU(name + "_7x1", b7, 192, Shape(7, 1), Shape(1, 1), Shape(3, 0));
+  Symbol bd = ConvBNReLU(name + "_7x7d_reduce", data, c7, Shape(1, 1));
+  bd = ConvBNReLU(name + "_7x1d_1", bd, c7, Shape(7, 1), Shape(1, 1), Shape(3, 0));
+  bd = ConvBNReLU(name + "_1x7d_1", bd, c7, Shape(1, 7), Shape(1, 1), Shape(0, 3));
+  bd = ConvBNReLU(name + "_7x1d_2", bd, c7, Shape(7, 1), Shape(1, 1), Shape(3, 0));
+  bd = ConvBNReLU(name + "_1x7d_2", bd, 192, Shape(1, 7), Shape(1, 1), Shape(0, 3));
+  Symbol bp = PoolLayer(name + "_pool", data, "avg", Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  bp = ConvBNReLU(name + "_proj", bp, 192, Shape(1, 1));
+  return ConcatLayer(name + "_concat", {b1, b7, bd, bp});
+}
+
+Symbol ReductionB(const std::string& name, Symbol data) {
+  Symbol b3 = ConvBNReLU(name + "_3x3_reduce", data, 192, Shape(1, 1));
+  b3 = ConvBNReLU(name + "_3x3", b3, 320, Shape(3, 3), Shape(2, 2));
+  Symbol b7 = ConvBNReLU(name + "_7x7_reduce", data, 192, Shape(1, 1));
+  b7 = ConvBNReLU(name + "_1x7", b7, 192, Shape(1, 7), Shape(1, 1), Shape(0, 3));
+  b7 = ConvBNReLU(name + "_7x1", b7, 192, Shape(7, 1), Shape(1, 1), Shape(3, 0));
+  b7 = ConvBNReLU(name + "_7x7_3x3", b7, 192, Shape(3, 3), Shape(2, 2));
+  Symbol bp = PoolLayer(name + "_pool", data, "max", Shape(3, 3), Shape(2, 2));
+  return ConcatLayer(name + "_concat", {b3, b7, bp});
+}
+
+/*! \brief the 8x8 block, with the 3x3 convolutions split in parallel 1x3 and 3x1 */
+Symbol InceptionC(const std::string& name, Symbol data) {
+  Symbol b1 = ConvBNReLU(name + "_1x1", data, 320, Shape(1, 1));
+  Symbol b3 = ConvBNReLU(name + "_3x3_reduce", data, 384, Shape(1, 1));
+  Symbol b3a = ConvBNReLU(name + "_1x3", b3, 384, Shape(1, 3), Shape(1, 1), Shape(0, 1));
+  Symbol b3b = ConvBNReLU(name + "_3x1", b3, 384, Shape(3, 1), Shape(1, 1), Shape(1, 0));
+  Symbol bd = ConvBNReLU(name + "_3x3d_reduce", data, 448, Shape(1, 1));
+  bd = ConvBNReLU(name + "_3x3d", bd, 384, Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  Symbol bda = ConvBNReLU(name + "_1x3d", bd, 384, Shape(1, 3), Shape(1, 1), Shape(0, 1));
+  Symbol bdb = ConvBNReLU(name + "_3x1d", bd, 384, Shape(3, 1), Shape(1, 1), Shape(1, 0));
+  Symbol bp = PoolLayer(name + "_pool", data, "avg", Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  bp = ConvBNReLU(name + "_proj", bp, 192, Shape(1, 1));
+  return ConcatLayer(name + "_concat", {b1, b3a, b3b, bda, bdb, bp});
+}
+
+Symbol InceptionV3(int num_classes) {
+  Symbol data = Symbol::Variable("data");
+  Symbol body = ConvBNReLU("conv0", data, 32, Shape(3, 3), Shape(2, 2));
+  body = ConvBNReLU("conv1", body, 32, Shape(3, 3));
+  body = ConvBNReLU("conv2", body, 64, Shape(3, 3), Shape(1, 1), Shape(1, 1));
+  body = PoolLayer("pool0", body, "max", Shape(3, 3), Shape(2, 2));
+  body = ConvBNReLU("conv3", body, 80, Shape(1, 1));
+  body = ConvBNReLU("conv4", body, 192, Shape(3, 3));
+  body = PoolLayer("pool1", body, "max", Shape(3, 3), Shape(2, 2));
+  body = InceptionA("mixed0", body, 32);
+  body = InceptionA("mixed1", body, 64);
+  body = InceptionA("mixed2", body, 64);
+  body = ReductionA("mixed3", body);
+  body = InceptionB("mixed4", body, 128);
+  body = InceptionB("mixed5", body, 160);
+  body = InceptionB("mixed6", body, 160);
+  body = InceptionB("mixed7", body, 192);
+  body = ReductionB("mixed8", body);
+  body = InceptionC("mixed9", body);
+  body = InceptionC("mixed10", body);
+  Symbol pool = PoolLayer("pool2", body, "avg", Shape(8, 8), Shape(1, 1), Shape(0, 0), true);
+  Symbol fc = FCLayer("fc1", FlattenLayer("flatten", pool), num_classes);
+  return SoftmaxLayer(fc, Symbol::Variable("softmax_label"));
+}
+
+/*!
+ * \brief LSTM language model unrolled over seq_len steps, the initial states
+ *  are the inputs l<i>_init_h and l<i>_init_c
+ */
+Symbol LSTMLanguageModel(int batch_size, int seq_len, int vocab_size, int num_hidden,
+                         int num_layers) {
+  Symbol data = Symbol::Variable("data");
+  Symbol embed = EmbeddingLayer("embed", data, vocab_size, num_hidden);
+  Symbol steps = Operator("SliceChannel")
+      .SetParam("num_outputs", seq_len)
+      .SetParam("axis", 1)
+      .SetParam("squeeze_axis", true)
+      .SetInput("data", embed)
+      .CreateSymbol("steps");
+  std::vector<Symbol> inputs;
+  for (int t = 0; t < seq_len; ++t) {
+    inputs.push_back(steps[t]);
+  }
+  for (int l = 0; l < num_layers; ++l) {
+    const std::string prefix = "l" + std::to_string(l);
+    Symbol i2h_weight(prefix + "_i2h_weight"), i2h_bias(prefix + "_i2h_bias");
+    Symbol h2h_weight(prefix + "_h2h_weight"), h2h_bias(prefix + "_h2h_bias");
+    Symbol h = Symbol::Variable(prefix + "_init_h");
+    Symbol c = Symbol::Variable(prefix + "_init_c");
+    for (int t = 0; t < seq_len; ++t) {
+      const std::string name = prefix + "_t" + std::to_string(t);
+      Symbol gates = FCLayer(name + "_i2h", inputs[t], i2h_weight, i2h_bias, 4 * num_hidden) +
+                     FCLayer(name + "_h2h", h, h2h_weight, h2h_bias, 4 * num_hidden);
+      Symbol slices = Operator("SliceChannel")
+          .SetParam("num_outputs", 4)
+          .SetInput("data", gates)
+          .CreateSymbol(name + "_slice");
+      Symbol in_gate = ActLayer(name + "_in", slices[0], "sigmoid");
+      Symbol forget_gate = ActLayer(name + "_forget", slices[1], "sigmoid");
+      Symbol transform = ActLayer(name + "_transform", slices[2], "tanh");
+      Symbol out_gate = ActLayer(name + "_out", slices[3], "sigmoid");
+      c = forget_gate * c + in_gate * transform;
+      h = out_gate * ActLayer(name + "_tanh", c, "tanh");
+      inputs[t] = h;
+    }
+  }
+  // time major rows, and the labels transposed to match
+  Symbol hidden = ConcatLayer("hidden", inputs, 0);
+  Symbol pred = FCLayer("pred", hidden, vocab_size);
+  Symbol label = Operator("transpose")
+      .SetInput("data", Symbol::Variable("softmax_label"))
+      .CreateSymbol("label_t");
+  label = Operator("Reshape")
+      .SetParam("shape", Shape(seq_len * batch_size))
+      .SetInput("data", label)
+      .CreateSymbol("label_flat");
+  return SoftmaxLayer(pred, label);
+}
+
+/*! \brief linear model on dense features plus an MLP on embedded categorical features */
+Symbol WideAndDeep(int num_embed_features, int embed_input_dim, int embed_dim) {
+  Symbol wide = FCLayer("wide", Symbol::Variable("wide_data"), 2);
+  Symbol deep = EmbeddingLayer("embed", Symbol::Variable("deep_data"), embed_input_dim,
+                               embed_dim);
+  deep = FlattenLayer("embed_flat", deep);
+  const int hidden[] = {1024, 512, 256};
+  for (int i = 0; i < 3; ++i) {
+    deep = ActLayer("deep_relu" + std::to_string(i),
+                    FCLayer("deep_fc" + std::to_string(i), deep, hidden[i]));
+  }
+  deep = FCLayer("deep_out", deep, 2);
+  return SoftmaxLayer(wide + deep, Symbol::Variable("softmax_label"));
+}
+
+/*! \brief an input of a model, uniform in [0, high), truncated when integer */
+struct InputSpec {
+  std::string name;
+  Shape shape;
+  float high;
+  bool integer;
+};
+
+struct ModelSpec {
+  Symbol net;
+  std::vector<InputSpec> inputs;
+  /*! \brief key of the rate in the report */
+  std::string rate_key;
+};
+
+ModelSpec CreateModel(const std::string& name, int batch_size) {
+  const mx_uint batch = batch_size;
+  ModelSpec spec;
+  if (name == "resnet50" || name == "inception_v3") {
+    const mx_uint size = name == "resnet50" ? 224 : 299;
+    spec.net = name == "resnet50" ? ResNet50(1000) : InceptionV3(1000);
+    spec.inputs = {{"data", Shape(batch, 3, size, size), 1.0f, false},
+                   {"softmax_label", Shape(batch), 1000.0f, true}};
+    spec.rate_key = "images_per_sec";
+  } else if (name == "lstm_lm") {
+    const int seq_len = 35, vocab_size = 10000, num_hidden = 650, num_layers = 2;
+    spec.net = LSTMLanguageModel(batch_size, seq_len, vocab_size, num_hidden, num_layers);
+    spec.inputs = {{"data", Shape(batch, seq_len), static_cast<float>(vocab_size), true},
+                   {"softmax_label", Shape(batch, seq_len), static_cast<float>(vocab_size),
+                    true}};
+    for (int l = 0; l < num_layers; ++l) {
+      spec.inputs.push_back({"l" + std::to_string(l) + "_init_h", Shape(batch, num_hidden),
+                             0.0f, false});
+      spec.inputs.push_back({"l" + std::to_string(l) + "_init_c", Shape(batch, num_hidden),
+                             0.0f, false});
+    }
+    spec.rate_key = "samples_per_sec";
+  } else if (name == "wide_deep") {
+    const int num_wide = 1000, num_embed = 26, embed_input_dim = 100000, embed_dim = 16;
+    spec.net = WideAndDeep(num_embed, embed_input_dim, embed_dim);
+    spec.inputs = {{"wide_data", Shape(batch, num_wide), 2.0f, true},
+                   {"deep_data", Shape(batch, num_embed), static_cast<float>(embed_input_dim),
+                    true},
+                   {"softmax_label", Shape(batch), 2.0f, true}};
+    spec.rate_key = "samples_per_sec";
+  } else {
+    LG << "Unknown model " << name;
+    exit(1);
+  }
+  return spec;
+}
+
+/*!
+ * \brief Synthetic data iterator: one random batch is generated at the start
+ *  and stays on the device, every iteration trains on it without any IO.
+ */
+class SyntheticDataIter {
+ public:
+  SyntheticDataIter(const std::vector<InputSpec>& inputs, const Context& ctx,
+                    unsigned seed) {
+    std::mt19937 rng(seed);
+    for (const auto& input : inputs) {
+      std::uniform_real_distribution<float> dist(0.0f, input.high);
+      std::vector<mx_float> values(input.shape.Size());
+      for (auto& v : values) {
+        v = input.integer ? static_cast<int>(dist(rng)) : dist(rng);
+      }
+      batch_[input.name] = NDArray(values, input.shape, ctx);
+    }
+    NDArray::WaitAll();
+  }
+  /*! \brief the arrays of the batch, by input name */
+  const std::map<std::string, NDArray>& GetBatch() const {
+    return batch_;
+  }
+
+ private:
+  std::map<std::string, NDArray> batch_;
+};
+
+/*!
+ * \brief train a model data parallel on the devices for warmup + iters steps
+ * \param key_base first kvstore key of the parameters, moved past them
+ * \return samples per second of the iters timed steps, on this worker
+ */
+double Run(const ModelSpec& spec, const std::vector<Context>& ctxs, int batch_size,
+           int warmup, int iters, bool dist, int* key_base) {
+  std::vector<std::unique_ptr<SyntheticDataIter> > data;
+  std::vector<std::unique_ptr<Executor> > execs;
+  std::map<std::string, OpReqType> grad_req;
+  for (const auto& input : spec.inputs) {
+    grad_req[input.name] = kNullOp;
+  }
+  Symbol net = spec.net;
+  for (size_t d = 0; d < ctxs.size(); ++d) {
+    data.emplace_back(new SyntheticDataIter(spec.inputs, ctxs[d], d));
+    execs.emplace_back(net.SimpleBind(ctxs[d], data.back()->GetBatch(),
+                                      std::map<std::string, NDArray>(), grad_req));
+  }
+
+  // the parameters are the arguments which are not inputs
+  const auto arg_names = net.ListArguments();
+  std::vector<size_t> params;
+  for (size_t i = 0; i < arg_names.size(); ++i) {
+    if (grad_req.count(arg_names[i]) == 0) params.push_back(i);
+  }
+  Xavier xavier(Xavier::gaussian, Xavier::in, 2.34);
+  for (auto& exec : execs) {
+    for (size_t i : params) xavier(arg_names[i], &exec->arg_arrays[i]);
+    auto aux = exec->aux_dict();
+    for (auto& kv : aux) xavier(kv.first, &kv.second);
+  }
+
+  const int num_workers = dist ? KVStore::GetNumWorkers() : 1;
+  std::unique_ptr<Optimizer> opt(OptimizerRegistry::Find("sgd"));
+  opt->SetParam("lr", 0.01)
+     ->SetParam("momentum", 0.9)
+     ->SetParam("wd", 1e-4)
+     ->SetParam("rescale_grad", 1.0 / (batch_size * ctxs.size() * num_workers));
+  KVStore::SetOptimizer(std::move(opt), !dist);
+  // the kvstore holds the weights of the first device, all devices pull them
+  for (size_t p = 0; p < params.size(); ++p) {
+    const int key = *key_base + p;
+    KVStore::Init(key, execs[0]->arg_arrays[params[p]]);
+    std::vector<NDArray> weights;
+    for (auto& exec : execs) weights.push_back(exec->arg_arrays[params[p]]);
+    KVStore::Pull(std::vector<int>(execs.size(), key), &weights);
+  }
+
+  auto step = [&]() {
+    for (auto& exec : execs) exec->Forward(true);
+    for (auto& exec : execs) exec->Backward();
+    // the gradients of the last layers are ready first
+    for (int p = params.size() - 1; p >= 0; --p) {
+      std::vector<int> keys(execs.size(), *key_base + p);
+      std::vector<NDArray> grads, weights;
+      for (auto& exec : execs) {
+        grads.push_back(exec->grad_arrays[params[p]]);
+        weights.push_back(exec->arg_arrays[params[p]]);
+      }
+      KVStore::Push(keys, grads, -p);
+      KVStore::Pull(keys, &weights, -p);
+    }
+  };
+  for (int i = 0; i < warmup; ++i) step();
+  NDArray::WaitAll();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; ++i) step();
+  NDArray::WaitAll();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  *key_base += params.size();
+  return static_cast<double>(iters) * batch_size * ctxs.size() / elapsed.count();
+}
+
+std::vector<std::string> Split(const std::string& list) {
+  std::vector<std::string> ret;
+  std::istringstream is(list);
+  std::string item;
+  while (std::getline(is, item, ',')) {
+    if (!item.empty()) ret.push_back(item);
+  }
+  return ret;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+  std::map<std::string, std::string> args = {
+    {"--model", "resnet50,inception_v3,lstm_lm,wide_deep"},
+    {"--gpus", "1"},
+    {"--kvstore", "local,device"},
+    {"--batch-size", "32"},
+    {"--warmup", "5"},
+    {"--iters", "20"}};
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (args.count(argv[i]) == 0) {
+      LG << "Unknown argument " << argv[i];
+      return 1;
+    }
+    args[argv[i]] = argv[i + 1];
+  }
+  const auto models = Split(args["--model"]);
+  const auto kvstores = Split(args["--kvstore"]);
+  const int num_gpus = std::stoi(args["--gpus"]);
+  const int batch_size = std::stoi(args["--batch-size"]);
+  const int warmup = std::stoi(args["--warmup"]);
+  const int iters = std::stoi(args["--iters"]);
+
+  const bool dist = kvstores.size() == 1 && kvstores[0].compare(0, 4, "dist") == 0;
+  if (dist) {
+    KVStore::SetType(kvstores[0]);
+    if (KVStore::GetRole() != "worker") {
+      KVStore::RunServer();
+      MXNotifyShutdown();
+      return 0;
+    }
+  }
+  for (const auto& kvstore : kvstores) {
+    if (!dist && kvstore.compare(0, 4, "dist") == 0) {
+      LG << "dist kvstores run alone in --kvstore";
+      return 1;
+    }
+  }
+
+  int key_base = 0;
+  for (const auto& model : models) {
+    for (const auto& kvstore : kvstores) {
+      double single_rate = 0;
+      for (int n = num_gpus > 0 ? 1 : 0; n <= num_gpus; ++n) {
+        std::vector<Context> ctxs;
+        for (int i = 0; i < n; ++i) ctxs.push_back(Context::gpu(i));
+        if (n == 0) ctxs.push_back(Context::cpu());
+        if (!dist) KVStore::SetType(kvstore);
+        ModelSpec spec = CreateModel(model, batch_size);
+        const double rate = Run(spec, ctxs, batch_size, warmup, iters, dist, &key_base);
+        if (n <= 1) single_rate = rate;
+        if (dist && KVStore::GetRank() != 0) continue;
+        const int num_workers = dist ? KVStore::GetNumWorkers() : 1;
+        std::printf("{\"model\": \"%s\", \"kvstore\": \"%s\", \"num_gpus\": %d, "
+                    "\"num_workers\": %d, \"batch_size\": %d, \"%s\": %.2f, "
+                    "\"scaling_efficiency\": %.3f}\n",
+                    model.c_str(), kvstore.c_str(), n, num_workers,
+                    batch_size * static_cast<int>(ctxs.size()) * num_workers,
+                    spec.rate_key.c_str(), rate * num_workers,
+                    rate / (single_rate * ctxs.size()));
+        std::fflush(stdout);
+      }
+    }
+  }
+  MXNotifyShutdown();
+  return 0;
+}
@@ -44,27 +44,30 @@ class Optimizer;
 class Executor {
   friend class Monitor;
  public:
+  /*!
+  * \brief bind an executor, the arrays are taken by value so that
+  *  temporaries passed by the caller are moved instead of copied.
+  */
   Executor(const Symbol &symbol, Context context,
-           const std::vector<NDArray> &arg_arrays,
-           const std::vector<NDArray> &grad_arrays,
+           std::vector<NDArray> arg_arrays,
+           std::vector<NDArray> grad_arrays,
            const std::vector<OpReqType> &grad_reqs,
-           const std::vector<NDArray> &aux_arrays,
+           std::vector<NDArray> aux_arrays,
            const std::map<std::string, Context> &group_to_ctx =
                std::map<std::string, Context>(),
            Executor *shared_exec = nullptr);
-  explicit Executor(const ExecutorHandle &h) { handle_ = h; }
+  explicit Executor(const ExecutorHandle &h) {
+    handle_ = h;
+    GetOutputs();
+  }
   /*!
   * \brief Perform a Forward operation of Operator
   *  After this operation, user can get the result by using function head.
+  *  The outputs of an executor are the same arrays from bind on, so
+  *  they are not fetched again and a forward allocates nothing.
   */
   void Forward(bool is_train) {
-    MXExecutorForward(handle_, is_train ? 1 : 0);
-    mx_uint out_size;
-    NDArrayHandle *out_array;
-    CHECK_EQ(MXExecutorOutputs(handle_, &out_size, &out_array), 0);
-    for (mx_uint i = 0; i < out_size; ++i) {
-      outputs[i] = NDArray(out_array[i]);
-    }
+    CHECK_EQ(MXExecutorForward(handle_, is_train ? 1 : 0), 0);
   }
   /*!
   * \brief Perform a Backward operation of the Operator.
@@ -78,12 +81,12 @@ class Executor {
   */
   void Backward(const std::vector<NDArray> &head_grads =
                     std::vector<NDArray>()) {
-    std::vector<NDArrayHandle> head_grads_;
-    for (auto d : head_grads) {
-      head_grads_.push_back(d.GetHandle());
+    head_grad_handles_.clear();
+    for (const auto &d : head_grads) {
+      head_grad_handles_.push_back(d.GetHandle());
     }
-    if (head_grads_.size() > 0) {
-      MXExecutorBackward(handle_, head_grads_.size(), head_grads_.data());
+    if (head_grad_handles_.size() > 0) {
+      MXExecutorBackward(handle_, head_grad_handles_.size(), head_grad_handles_.data());
     } else {
       MXExecutorBackward(handle_, 0, nullptr);
     }
@@ -122,6 +125,17 @@ class Executor {
   Executor &operator=(const Executor &e);
   ExecutorHandle handle_;
   Symbol symbol_;
+  /*! \brief handles of the head gradients, kept to reuse their memory */
+  std::vector<NDArrayHandle> head_grad_handles_;
+  void GetOutputs() {
+    mx_uint out_size;
+    NDArrayHandle *out_array;
+    CHECK_EQ(MXExecutorOutputs(handle_, &out_size, &out_array), 0);
+    outputs.clear();
+    for (mx_uint i = 0; i < out_size; ++i) {
+      outputs.push_back(NDArray(out_array[i]));
+    }
+  }
   std::map<std::string, NDArray> GetDict(const std::vector<std::string> &names,
                                          const std::vector<NDArray> &arrays) {
     std::map<std::string, NDArray> ret;
@@ -29,34 +29,35 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <utility>
 #include "mxnet-cpp/executor.h"
 #include "mxnet-cpp/optimizer.h"
 
 namespace mxnet {
 namespace cpp {
 inline Executor::Executor(const Symbol &symbol, Context context,
-                          const std::vector<NDArray> &arg_arrays,
-                          const std::vector<NDArray> &grad_arrays,
+                          std::vector<NDArray> arg_arrays,
+                          std::vector<NDArray> grad_arrays,
                           const std::vector<OpReqType> &grad_reqs,
-                          const std::vector<NDArray> &aux_arrays,
+                          std::vector<NDArray> aux_arrays,
                           const std::map<std::string, Context> &group_to_ctx,
                           Executor *shared_exec) {
-  this->arg_arrays = arg_arrays;
-  this->grad_arrays = grad_arrays;
-  this->aux_arrays = aux_arrays;
+  this->arg_arrays = std::move(arg_arrays);
+  this->grad_arrays = std::move(grad_arrays);
+  this->aux_arrays = std::move(aux_arrays);
   this->symbol_ = symbol;
 
   std::vector<NDArrayHandle> arg_handles;
   std::vector<NDArrayHandle> grad_handles;
   std::vector<NDArrayHandle> aux_handles;
 
-  for (const auto &array : arg_arrays) {
+  for (const auto &array : this->arg_arrays) {
     arg_handles.push_back(array.GetHandle());
   }
-  for (const auto &array : grad_arrays) {
+  for (const auto &array : this->grad_arrays) {
     grad_handles.push_back(array.GetHandle());
   }
-  for (const auto &array : aux_arrays) {
+  for (const auto &array : this->aux_arrays) {
     aux_handles.push_back(array.GetHandle());
   }
 
@@ -82,13 +83,7 @@ inline Executor::Executor(const Symbol &symbol, Context context,
                             aux_handles.size(), aux_handles.data(),
                             shared_exec_handle, &handle_),
            0);
-
-  mx_uint out_size;
-  NDArrayHandle *out_array;
-  CHECK_EQ(MXExecutorOutputs(handle_, &out_size, &out_array), 0);
-  for (mx_uint i = 0; i < out_size; ++i) {
-    outputs.push_back(NDArray(out_array[i]));
-  }
+  GetOutputs();
 }
 
 inline std::string Executor::DebugStr() {
@@ -111,7 +111,16 @@ class MXDataIter : public DataIter {
   }
   void BeforeFirst();
   bool Next();
+  /*!
+  * \brief the data of the current batch. The array shares the memory of a
+  *  prefetch buffer of the iterator, no data is copied. The buffer is
+  *  written again once prefetch_buffer more batches are read, after the
+  *  pending reads of the array by the engine complete, so copy the array
+  *  to keep it longer. Setting the parameter ctx to cpu_pinned allocates
+  *  the buffers in pinned memory, which speeds up their copy to a GPU.
+  */
   NDArray GetData();
+  /*! \brief the label of the current batch, see GetData for its lifetime */
   NDArray GetLabel();
   int GetPadNum();
   std::vector<int> GetIndex();
@@ -139,6 +148,41 @@ class MXDataIter : public DataIter {
   std::shared_ptr<MXDataIterBlob> blob_ptr_;
   static MXDataIterMap*& mxdataiter_map();
 };
+
+/*!
+* \brief Iterator copying the batches of another iterator to a device ahead of
+*  time. Next copies the following batch with asynchronous engine copies
+*  into a second set of device arrays, so it runs while the current batch
+*  is used and the batches are already on the device when they are read.
+*
+*  The data and label returned for a batch are valid until the second call
+*  of Next after it, their arrays are reused then. The copies are float32.
+*/
+class DevicePrefetchIter : public DataIter {
+ public:
+  /*!
+  * \brief constructor
+  * \param iter the iterator read, which must outlive this iterator
+  * \param context the device the batches are copied to
+  */
+  DevicePrefetchIter(DataIter *iter, const Context &context)
+      : iter_(iter), context_(context) {}
+  void BeforeFirst();
+  bool Next();
+  NDArray GetData() { return slots_[current_].data; }
+  NDArray GetLabel() { return slots_[current_].label; }
+  int GetPadNum() { return slots_[current_].pad_num; }
+  std::vector<int> GetIndex() { return slots_[current_].index; }
+
+ private:
+  /*! \brief read the next batch of iter_ and start copying it to slot */
+  bool Fetch_(int slot);
+  DataIter *iter_;
+  Context context_;
+  DataBatch slots_[2];
+  int current_ = 0;
+  bool started_ = false, has_next_ = false;
+};
 }  // namespace cpp
 }  // namespace mxnet
 
@@ -99,6 +99,42 @@ inline MXDataIter MXDataIter::CreateDataIter() {
   return *this;
 }
 
+inline void DevicePrefetchIter::BeforeFirst() {
+  iter_->BeforeFirst();
+  started_ = has_next_ = false;
+}
+
+inline bool DevicePrefetchIter::Next() {
+  if (!started_) {
+    has_next_ = Fetch_(1 - current_);
+    started_ = true;
+  }
+  if (!has_next_) return false;
+  current_ = 1 - current_;
+  // the copies of the following batch wait for the reads of the batch
+  // returned before, whose arrays they overwrite
+  has_next_ = Fetch_(1 - current_);
+  return true;
+}
+
+inline bool DevicePrefetchIter::Fetch_(int slot) {
+  if (!iter_->Next()) return false;
+  DataBatch &batch = slots_[slot];
+  NDArray data = iter_->GetData();
+  NDArray label = iter_->GetLabel();
+  if (batch.data.GetShape() != data.GetShape()) {
+    batch.data = NDArray(data.GetShape(), context_, false);
+  }
+  if (batch.label.GetShape() != label.GetShape()) {
+    batch.label = NDArray(label.GetShape(), context_, false);
+  }
+  data.CopyTo(&batch.data);
+  label.CopyTo(&batch.label);
+  batch.pad_num = iter_->GetPadNum();
+  batch.index = iter_->GetIndex();
+  return true;
+}
+
 // MXDataIter MNIst
 
 }  // namespace cpp
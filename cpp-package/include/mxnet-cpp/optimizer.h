@@ -93,10 +93,17 @@ class Optimizer {
   *  \param grad gradient for the weight.
   */
   virtual void Update(int index, NDArray weight, NDArray grad) = 0;
-  // TODO(zhangcheng-qinyinghua)
-  // implement Update a list of arrays, maybe in the form of map
-  // void Update(int index, std::vector<NDArray> weights, std::vector<NDArray>
-  // grad, mx_float lr);
+  /*!
+  *  \brief Update a list of weights with their gradients. Optimizers with a
+  *   multi-weight update operator update them all with one operator call,
+  *   the others update them one by one.
+  *  \param indices the unique indices for the weights.
+  *  \param weights the weights to update.
+  *  \param grads gradients for the weights.
+  */
+  virtual void Update(const std::vector<int> &indices,
+                      const std::vector<NDArray> &weights,
+                      const std::vector<NDArray> &grads);
 
   /*!
   *  \brief Serialize the optimizer parameters to a string.
@@ -139,12 +146,19 @@ class SGDOptimizer : public Optimizer {
   explicit SGDOptimizer(unsigned begin_num_update = 0);
   std::string GetType() const override;
   void Update(int index, NDArray weight, NDArray grad) override;
+  void Update(const std::vector<int> &indices,
+              const std::vector<NDArray> &weights,
+              const std::vector<NDArray> &grads) override;
  private:
   virtual ~SGDOptimizer();
   void CreateState_(int index, NDArray weight) override;
   std::map<int, NDArray*> states_;
   AtomicSymbolCreator update_handle_;
   AtomicSymbolCreator mom_update_handle_;
+  AtomicSymbolCreator multi_update_handle_;
+  AtomicSymbolCreator multi_mom_update_handle_;
+  // buffers of the multi-weight update, kept to reuse their memory
+  std::vector<NDArrayHandle> multi_inputs_, multi_outputs_;
 };
 
 class RMSPropOptimizer : public Optimizer {
@@ -31,6 +31,7 @@
 #include <numeric>
 #include <map>
 #include <cmath>
+#include <sstream>
 #include <string>
 #include <vector>
 #include "mxnet-cpp/optimizer.h"
@@ -79,6 +80,16 @@ inline Optimizer::~Optimizer() {}
 inline void Optimizer::CreateState_(int index, NDArray weight) {
 }
 
+inline void Optimizer::Update(const std::vector<int> &indices,
+                              const std::vector<NDArray> &weights,
+                              const std::vector<NDArray> &grads) {
+  CHECK_EQ(indices.size(), weights.size());
+  CHECK_EQ(indices.size(), grads.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    Update(indices[i], weights[i], grads[i]);
+  }
+}
+
 inline std::string Optimizer::Serialize() const {
   using ValueType = std::map<std::string, std::string>::value_type;
   auto params = params_;
@@ -147,6 +158,8 @@ inline SGDOptimizer::SGDOptimizer(unsigned begin_num_update)
   : Optimizer(begin_num_update) {
   update_handle_ = op_map()->GetSymbolCreator("sgd_update");
   mom_update_handle_ = op_map()->GetSymbolCreator("sgd_mom_update");
+  multi_update_handle_ = op_map()->GetSymbolCreator("multi_sgd_update");
+  multi_mom_update_handle_ = op_map()->GetSymbolCreator("multi_sgd_mom_update");
 }
 
 inline std::string SGDOptimizer::GetType() const {
@@ -191,6 +204,55 @@ inline void SGDOptimizer::Update(int index, NDArray weight, NDArray grad) {
   }
 }
 
+inline void SGDOptimizer::Update(const std::vector<int> &indices,
+                                 const std::vector<NDArray> &weights,
+                                 const std::vector<NDArray> &grads) {
+  CHECK_EQ(indices.size(), weights.size());
+  CHECK_EQ(indices.size(), grads.size());
+  if (indices.empty()) return;
+  const bool has_mom = params_.count("momentum") > 0;
+  std::ostringstream lrs, wds;
+  multi_inputs_.clear();
+  multi_outputs_.clear();
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const int index = indices[i];
+    if (states_.count(index) == 0) {
+      CreateState_(index, weights[i]);
+    }
+    lrs << (i == 0 ? "(" : ",") << GetLR_(index);
+    wds << (i == 0 ? "(" : ",") << GetWD_(index);
+    UpdateCount_(index);
+    multi_inputs_.push_back(weights[i].GetHandle());
+    multi_inputs_.push_back(grads[i].GetHandle());
+    if (has_mom) multi_inputs_.push_back(states_[index]->GetHandle());
+    multi_outputs_.push_back(weights[i].GetHandle());
+  }
+  lrs << ")";
+  wds << ")";
+
+  // the multi-weight operators take lists of learning rates and weight decays
+  std::map<std::string, std::string> params;
+  params["lrs"] = lrs.str();
+  params["wds"] = wds.str();
+  params["num_weights"] = std::to_string(indices.size());
+  for (const char *key : {"momentum", "rescale_grad", "clip_gradient"}) {
+    auto it = params_.find(key);
+    if (it != params_.end()) params[key] = it->second;
+  }
+  std::vector<const char*> keys, values;
+  for (const auto &p : params) {
+    keys.push_back(p.first.c_str());
+    values.push_back(p.second.c_str());
+  }
+
+  int num_outputs = multi_outputs_.size();
+  NDArrayHandle *outputs = multi_outputs_.data();
+  CHECK_EQ(MXImperativeInvoke(has_mom ? multi_mom_update_handle_ : multi_update_handle_,
+                              multi_inputs_.size(), multi_inputs_.data(),
+                              &num_outputs, &outputs,
+                              keys.size(), keys.data(), values.data()), 0);
+}
+
 inline void SGDOptimizer::CreateState_(int index, NDArray weight) {
   if (params_.count("momentum") == 0) {
     states_[index] = nullptr;
@@ -30,6 +30,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <utility>
 
 #include "dmlc/logging.h"
 #include "mxnet-cpp/symbol.h"
@@ -338,8 +339,8 @@ inline Executor *Symbol::SimpleBind(
                       &aux_arrays, args_map, arg_grad_store, grad_req_type,
                       aux_map);
 
-  return new Executor(*this, context, arg_arrays, grad_arrays, grad_reqs,
-                      aux_arrays);
+  return new Executor(*this, context, std::move(arg_arrays), std::move(grad_arrays),
+                      grad_reqs, std::move(aux_arrays));
 }
 
 inline Executor *Symbol::Bind(const Context &context,
@@ -36,6 +36,9 @@ def add_data_args(parser):
                       help='number of threads for data decoding')
     data.add_argument('--benchmark', type=int, default=0,
                       help='if 1, then feed the network with synthetic data')
+    data.add_argument('--dynamic-parts', type=int, default=0,
+                      help='if positive, the workers of a distributed kvstore read this '
+                           'many parts of the training data in the order they ask for them')
     return data
 
 def add_data_aug_args(parser):
@@ -142,7 +145,8 @@ def get_rec_iter(args, kv=None):
         preprocess_threads  = args.data_nthreads,
         shuffle             = True,
         num_parts           = nworker,
-        part_index          = rank)
+        part_index          = rank,
+        dynamic_parts       = args.dynamic_parts if nworker > 1 else 0)
     if args.data_val is None:
         return (train, None)
     val = mx.io.ImageRecordIter(
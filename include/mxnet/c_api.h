@@ -84,10 +84,14 @@ typedef void *KVStoreHandle;
 typedef void *RecordIOHandle;
 /*! \brief handle to MXRtc*/
 typedef void *RtcHandle;
+/*! \brief handle to a DLManagedTensor of DLPack */
+typedef void *DLManagedTensorHandle;
 
 typedef void (*ExecutorMonitorCallback)(const char*,
                                         NDArrayHandle,
                                         void *);
+/*! \brief called once an asynchronize copy is done */
+typedef void (*NDArrayCopyCallback)(void *);
 
 struct NativeOpInfo {
   void (*forward)(int, float**, int*, unsigned**, int*, void*);
@@ -204,6 +208,14 @@ MXNET_DLL int MXRandomSeed(int seed);
  * \return 0 when success, -1 when failure happens.
  */
 MXNET_DLL int MXNotifyShutdown();
+/*!
+ * \brief Set the maximum number of synchronous operations the calling thread
+ *  pushes that the engine merges into one engine operation.
+ * \param bulk_size the new limit, 0 to dispatch every operation at once
+ * \param prev_bulk_size the previous limit
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXEngineSetBulkSize(int bulk_size, int* prev_bulk_size);
 /*!
  * \brief Set up configuration of profiler
  * \param mode indicate the working mode of profiler,
@@ -225,9 +237,57 @@ MXNET_DLL int MXSetProfilerState(int state);
 /*! \brief Save profile and stop profiler */
 MXNET_DLL int MXDumpProfile();
 
+/*!
+ * \brief Save the profile recorded since the last dump
+ * \param finished whether to stop the profiler and complete the trace file,
+ *  otherwise the profiler keeps running and the next dump appends to the file
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXDumpProfileEx(int finished);
+
+/*!
+ * \brief Print the aggregated statistics of the operators recorded by the profiler
+ * \param out_str table with the count, total, min, max, average, p50 and p99
+ *  durations of every operator by device
+ * \param reset whether to clear the aggregated statistics afterwards
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXAggregateProfileStatsPrint(const char **out_str, int reset);
+
 /*! \brief Set the number of OMP threads to use */
 MXNET_DLL int MXSetNumOMPThreads(int thread_num);
 
+/*!
+ * \brief Get memory allocation statistics of a context
+ * \param dev_type device type, 1 for cpu, 2 for gpu and 3 for cpu pinned
+ * \param dev_id device id
+ * \param out_size number of statistics
+ * \param out_keys names of the statistics
+ * \param out_vals values of the statistics
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXStorageGetStats(int dev_type, int dev_id,
+                                mx_uint *out_size,
+                                const char ***out_keys,
+                                const uint64_t **out_vals);
+
+/*!
+ * \brief Page-lock a host buffer owned by the caller, so that the copies
+ *  between it and the gpus, e.g. by MXNDArraySyncCopyFromCPU or MXPredSetInput,
+ *  are done by DMA instead of staging through a driver buffer.
+ *  Registering is slow, it is meant for buffers reused for the whole process.
+ * \param data start of the buffer, which must stay allocated until unregistered
+ * \param size size of the buffer in bytes
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXStorageRegisterHostMemory(void *data, size_t size);
+/*!
+ * \brief Unregister a buffer registered by MXStorageRegisterHostMemory
+ * \param data start of the buffer, as registered
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXStorageUnregisterHostMemory(void *data);
+
 //-------------------------------------
 // Part 1: NDArray creation and deletion
 //-------------------------------------
@@ -318,6 +378,91 @@ MXNET_DLL int MXNDArrayCreateSparseEx(int storage_type,
 MXNET_DLL int MXNDArrayLoadFromRawBytes(const void *buf,
                                         size_t size,
                                         NDArrayHandle *out);
+/*!
+ * \brief get the ids another process maps the shared memory of a cpu_shared
+ *  NDArray with. The memory can be mapped while the NDArray lives.
+ * \param handle the NDArray handle
+ * \param shared_pid id of the process that allocated the memory
+ * \param shared_id id of the memory within that process
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid,
+                                          int* shared_id);
+/*!
+ * \brief create an NDArray on the shared memory of a cpu_shared NDArray of
+ *  another process, given by MXNDArrayGetSharedMemHandle.
+ * \param shared_pid id of the process that allocated the memory
+ * \param shared_id id of the memory within that process
+ * \param shape the shape of the NDArray
+ * \param ndim the dimension of the shape
+ * \param dtype data type of the NDArray
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCreateFromSharedMem(int shared_pid, int shared_id, const mx_uint *shape,
+                                           mx_uint ndim, int dtype, NDArrayHandle *out);
+/*!
+ * \brief get the CUDA IPC handle another process opens the data of a GPU
+ *  NDArray with, without copy. The data stays valid while the NDArray lives.
+ * \param handle the NDArray handle
+ * \param out_size size of the IPC handle
+ * \param out_buf the bytes of the IPC handle
+ * \param out_offset the byte offset of the data in the shared allocation
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayExportCUDAIPC(NDArrayHandle handle,
+                                     size_t *out_size,
+                                     const char **out_buf,
+                                     uint64_t *out_offset);
+/*!
+ * \brief open the data of a GPU NDArray of another process given by
+ *  MXNDArrayExportCUDAIPC.
+ * \param buf the bytes of the IPC handle
+ * \param size size of the IPC handle
+ * \param offset the byte offset of the data in the shared allocation
+ * \param shape the shape of the NDArray
+ * \param ndim the dimension of the shape
+ * \param dtype data type of the NDArray
+ * \param dev_id the GPU the data sits on
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayImportCUDAIPC(const char *buf,
+                                     size_t size,
+                                     uint64_t offset,
+                                     const mx_uint *shape,
+                                     mx_uint ndim,
+                                     int dtype,
+                                     int dev_id,
+                                     NDArrayHandle *out);
+/*!
+ * \brief share the data of a dense NDArray with another framework as a
+ *  DLPack tensor, without copy. The tensor keeps the data alive until its
+ *  deleter is called. The pending operations on the NDArray are not waited
+ *  for, call MXNDArrayWaitToRead (to read) or MXNDArrayWaitToWrite (to write)
+ *  first.
+ * \param handle the NDArray handle
+ * \param out_dlpack the returned DLManagedTensor
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayToDLPack(NDArrayHandle handle,
+                                DLManagedTensorHandle *out_dlpack);
+/*!
+ * \brief create an NDArray on the data of a DLPack tensor, without copy.
+ *  The NDArray owns the tensor on success, and calls its deleter once it is
+ *  freed and the operations pending on it have finished.
+ * \param dlpack the compact DLManagedTensor
+ * \param out_handle the returned NDArray handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayFromDLPack(DLManagedTensorHandle dlpack,
+                                  NDArrayHandle *out_handle);
+/*!
+ * \brief call the deleter of a DLPack tensor which has not been consumed.
+ * \param dlpack the DLManagedTensor
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCallDLPackDeleter(DLManagedTensorHandle dlpack);
 /*!
  * \brief save the NDArray into raw bytes.
  * \param handle the NDArray handle
@@ -340,8 +485,43 @@ MXNET_DLL int MXNDArraySave(const char* fname,
                             mx_uint num_args,
                             NDArrayHandle* args,
                             const char** keys);
+/*!
+ * \brief Save list of dense narray into the file in the mappable format,
+ *  which MXNDArrayLoad memory maps instead of reading.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveMappable(const char* fname,
+                                    mx_uint num_args,
+                                    NDArrayHandle* args,
+                                    const char** keys);
+/*!
+ * \brief Save list of narray into the file on a background thread. It returns
+ *  once the copies of the arrays to the cpu are pushed to the engine, so the
+ *  arrays can be modified right away without changing what is saved.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \param mappable whether to save in the format of MXNDArraySaveMappable
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveAsync(const char* fname,
+                                 mx_uint num_args,
+                                 NDArrayHandle* args,
+                                 const char** keys,
+                                 int mappable);
+/*!
+ * \brief Wait until the saves issued by MXNDArraySaveAsync are written.
+ * \return 0 when success, -1 when one of them failed since the last wait
+ */
+MXNET_DLL int MXNDArrayWaitAllSaves();
 /*!
  * \brief Load list of narray from the file.
+ *  Files in the mappable format are memory mapped.
  * \param fname name of the file.
  * \param out_size number of narray loaded.
  * \param out_arr head of the returning narray handles.
@@ -354,6 +534,24 @@ MXNET_DLL int MXNDArrayLoad(const char* fname,
                             NDArrayHandle** out_arr,
                             mx_uint *out_name_size,
                             const char*** out_names);
+/*!
+ * \brief Load the narrays of the given names from the file.
+ * \param fname name of the file.
+ * \param num_select number of names to load.
+ * \param select the names of the narrays to load.
+ * \param out_size number of narray loaded.
+ * \param out_arr head of the returning narray handles.
+ * \param out_name_size size of output name arrray.
+ * \param out_names the names of returning NDArrays
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayLoadSelected(const char* fname,
+                                    mx_uint num_select,
+                                    const char** select,
+                                    mx_uint *out_size,
+                                    NDArrayHandle** out_arr,
+                                    mx_uint *out_name_size,
+                                    const char*** out_names);
 /*!
  * \brief Perform a synchronize copy from a continugous CPU memory region.
  *
@@ -382,6 +580,25 @@ MXNET_DLL int MXNDArraySyncCopyFromCPU(NDArrayHandle handle,
 MXNET_DLL int MXNDArraySyncCopyToCPU(NDArrayHandle handle,
                                      void *data,
                                      size_t size);
+/*!
+ * \brief Push an asynchronize copy to a continugous CPU memory region.
+ *
+ *  The copy runs in the engine after the pending writes of the NDArray and
+ *  the function returns at once. MXNDArrayWaitToWrite on the NDArray also
+ *  waits for the copy. Use pinned memory for fast copies from the GPU.
+ *
+ * \param handle the NDArray handle
+ * \param data the data source to copy into, valid until callback is called.
+ * \param size the memory size we want to copy into.
+ * \param callback called from an engine thread once the copy is done, can be NULL
+ * \param callback_param the argument of callback
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCopyToCPUAsync(NDArrayHandle handle,
+                                      void *data,
+                                      size_t size,
+                                      NDArrayCopyCallback callback,
+                                      void *callback_param);
 /*!
  * \brief Copy src.data() to dst.data() if i = -1, else dst.aux_data(i) if i >= 0
  * This function blocks. Do not use it in performance critical code.
@@ -400,6 +617,26 @@ MXNET_DLL int MXNDArraySyncCopyFromNDArray(NDArrayHandle handle_dst,
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXNDArrayWaitToRead(NDArrayHandle handle);
+/*!
+ * \brief Check without blocking whether the pending writes with respect
+ *  NDArray are finished.
+ * \param handle the NDArray handle
+ * \param out 1 when the NDArray can be read, 0 otherwise
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayIsReady(NDArrayHandle handle, int *out);
+/*!
+ * \brief Call a function once the pending writes with respect NDArray are
+ *  finished. The function is called at once when the NDArray is ready, and
+ *  otherwise by an engine thread, so it must not block.
+ * \param handle the NDArray handle
+ * \param callback the function, called with param
+ * \param param the argument of callback
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayOnReady(NDArrayHandle handle,
+                               void (*callback)(void *),
+                               void *param);
 /*!
  * \brief Wait until all the pending read/write with respect NDArray are finished.
  *  Always call this before write data into NDArray synchronizely.
@@ -682,6 +919,31 @@ MXNET_DLL int MXImperativeInvokeEx(AtomicSymbolCreator creator,
                                    const char **param_keys,
                                    const char **param_vals,
                                    const int **out_stypes);
+/*!
+ * \brief invoke a list of nnvm ops in one call. The parsed parameters of the
+ *  ops are cached, and consecutive ops of dense arrays on the same context
+ *  are pushed to the engine as one operation, when autograd is not recording.
+ * \param num_ops number of ops
+ * \param creators the ops
+ * \param num_inputs number of input NDArrays of every op
+ * \param inputs input NDArrays of all ops, one op after another
+ * \param num_outputs number of output NDArrays of every op
+ * \param outputs output NDArrays of all ops, one op after another, which must
+ *  have been created
+ * \param num_params number of keyword parameters of every op
+ * \param param_keys keys for keyword parameters of all ops
+ * \param param_vals values for keyword parameters of all ops
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXImperativeInvokeBatch(int num_ops,
+                                      AtomicSymbolCreator *creators,
+                                      const int *num_inputs,
+                                      NDArrayHandle *inputs,
+                                      const int *num_outputs,
+                                      NDArrayHandle *outputs,
+                                      const int *num_params,
+                                      const char **param_keys,
+                                      const char **param_vals);
 /*!
  * \brief set whether to record operator for autograd
  * \param is_recording 1 when recording, 0 when not recording.
@@ -752,6 +1014,20 @@ MXNET_DLL int MXAutogradBackwardEx(mx_uint num_output,
                                    NDArrayHandle* ograd_handles,
                                    int retain_graph,
                                    int is_train);
+/*!
+* \brief compute the gradient of outputs w.r.t variabels, and record the
+*  backward pass so that the gradients can be differentiated again.
+*  The graph is retained, as the recorded gradients refer to it.
+* \param num_output number of output NDArray
+* \param output_handles output NDArrays
+* \param ograd_handles head gradient for NDArrays
+* \param is_train whether to do backward for training or inference
+* \return 0 when success, -1 when failure happens
+*/
+MXNET_DLL int MXAutogradBackwardCreateGraph(mx_uint num_output,
+                                            NDArrayHandle* output_handles,
+                                            NDArrayHandle* ograd_handles,
+                                            int is_train);
 /*
  * \brief get the graph constructed by autograd.
  * \param handle ndarray handle
@@ -763,6 +1039,22 @@ MXNET_DLL int MXAutogradGetSymbol(NDArrayHandle handle, SymbolHandle *out);
  */
 MXNET_DLL int MXCreateCachedOp(SymbolHandle handle,
                                CachedOpHandle *out);
+/*!
+ * \brief create cached operator with flags
+ * \param handle the symbol of the cached op
+ * \param num_flags number of flags
+ * \param keys names of the flags. static_alloc makes calls outside of autograd
+ *  recording run in an executor bound for the input shapes, which plans the
+ *  memory once and reuses it across calls
+ * \param vals values of the flags
+ * \param out the created cached op
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXCreateCachedOpEx(SymbolHandle handle,
+                                 int num_flags,
+                                 const char** keys,
+                                 const char** vals,
+                                 CachedOpHandle *out);
 /*!
  * \brief free cached operator
  */
@@ -1186,6 +1478,39 @@ MXNET_DLL int MXSymbolInferType(SymbolHandle sym,
                                 mx_uint *aux_type_size,
                                 const int **aux_type_data,
                                 int *complete);
+/*!
+ * \brief Convert a symbol into a quantized symbol running the supported operators on int8
+ * \param sym_handle the float symbol
+ * \param ret_sym_handle returned quantized symbol
+ * \param num_excluded_symbols number of layers kept in float
+ * \param excluded_symbols the names of the layers kept in float
+ * \param num_offline number of parameters quantized offline
+ * \param offline_params the names of the parameters quantized offline, which are
+ *  replaced by the variables <name>_quantize, <name>_min and <name>_max
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXQuantizeSymbol(SymbolHandle sym_handle,
+                               SymbolHandle *ret_sym_handle,
+                               const mx_uint num_excluded_symbols,
+                               const char **excluded_symbols,
+                               const mx_uint num_offline,
+                               const char **offline_params);
+/*!
+ * \brief Set the calibrated ranges of the requantize operators of a quantized symbol
+ * \param qsym_handle the quantized symbol
+ * \param num_layers number of calibrated layers
+ * \param layer_names the names of the outputs of the float layers, <name>_output
+ * \param low_quantiles the low ends of the ranges
+ * \param high_quantiles the high ends of the ranges
+ * \param ret_sym_handle returned symbol
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXSetCalibTableToQuantizedSymbol(SymbolHandle qsym_handle,
+                                               const mx_uint num_layers,
+                                               const char **layer_names,
+                                               const float *low_quantiles,
+                                               const float *high_quantiles,
+                                               SymbolHandle *ret_sym_handle);
 
 
 
@@ -1206,6 +1531,17 @@ MXNET_DLL int MXExecutorFree(ExecutorHandle handle);
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXExecutorPrint(ExecutorHandle handle, const char **out_str);
+/*!
+ * \brief Get the memory plan of the executor as a JSON string.
+ *  The object holds "entries", the plan of every node entry by entry id with
+ *  its name, storage_id, bytes, req, inplace_input and context, and "totals",
+ *  the bytes of the storage blocks planned on each context for the forward
+ *  pass alone and for training.
+ * \param handle the executor.
+ * \param out_json pointer to hold the JSON string.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorGetMemoryPlan(ExecutorHandle handle, const char **out_json);
 /*!
  * \brief Executor forward method
  *
@@ -1252,6 +1588,20 @@ MXNET_DLL int MXExecutorOutputs(ExecutorHandle handle,
                                 mx_uint *out_size,
                                 NDArrayHandle **out);
 
+/*!
+ * \brief Get the second buffer of an input argument of the executor. The input
+ *  of the next forward can be written to it while the current iteration runs,
+ *  and the next forward swaps it with the bound argument.
+ *
+ * \param handle executor handle
+ * \param name name of the input argument
+ * \param out the second buffer
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorNextInput(ExecutorHandle handle,
+                                  const char *name,
+                                  NDArrayHandle *out);
+
 /*!
  * \brief Generate Executor from symbol
  *
@@ -1793,6 +2143,20 @@ MXNET_DLL int MXKVStoreSendCommmandToServers(KVStoreHandle handle,
                                              int cmd_id,
                                              const char* cmd_body);
 
+/**
+ * \brief Set the gradient compression of the pushed values
+ *
+ * \param handle handle to the KVStore
+ * \param num_params number of parameters
+ * \param keys the names of the parameters, such as type and threshold
+ * \param vals the values of the parameters
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXKVStoreSetGradientCompression(KVStoreHandle handle,
+                                              mx_uint num_params,
+                                              const char** keys,
+                                              const char** vals);
+
 /**
  * \brief Get the number of ps dead node(s) specified by {node_id}
  *
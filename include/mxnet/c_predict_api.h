@@ -48,6 +48,21 @@ typedef float mx_float;
 typedef void *PredictorHandle;
 /*! \brief handle to NDArray list */
 typedef void *NDListHandle;
+/*! \brief handle to batching Predictor */
+typedef void *BatchPredictorHandle;
+/*!
+ * \brief callback receiving the outputs of a request to a batching predictor
+ * \param status 0 when success, -1 when the batch of the request failed
+ * \param num_outputs The number of outputs, 0 on failure.
+ * \param outputs The outputs of the sample, only valid during the call.
+ * \param output_sizes The number of values of every output.
+ * \param user_data The user data given with the request.
+ */
+typedef void (*MXPredBatchCallback)(int status,
+                                    mx_uint num_outputs,
+                                    const mx_float** outputs,
+                                    const mx_uint* output_sizes,
+                                    void* user_data);
 
 /*!
  * \brief Get the last error happeneed.
@@ -118,6 +133,70 @@ MXNET_DLL int MXPredCreatePartialOut(const char* symbol_json_str,
                                      mx_uint num_output_nodes,
                                      const char** output_keys,
                                      PredictorHandle* out);
+
+/*!
+ * \brief create several predictors of the same model, for instance one per
+ *  serving thread. The parameters are loaded once on the device and shared
+ *  by the predictors, every predictor has its own inputs, outputs and
+ *  intermediate results, and can run concurrently with the others.
+ * \param symbol_json_str The JSON string of the symbol.
+ * \param param_bytes The in-memory raw bytes of parameter ndarray file.
+ * \param param_size The size of parameter ndarray file.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictors.
+ * \param num_input_nodes Number of input nodes to the net,
+ *    For feedforward net, this is 1.
+ * \param input_keys The name of input argument.
+ *    For feedforward net, this is {"data"}
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ *    For feedforward net that takes 4 dimensional input, this is {0, 4}.
+ * \param input_shape_data A flatted data of shapes of each input node.
+ *    For feedforward net that takes 4 dimensional input, this is the shape data.
+ * \param num_threads The number of predictors to create.
+ * \param out The num_threads created predictor handles, each freed by MXPredFree.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredCreateMultiThread(const char* symbol_json_str,
+                                      const void* param_bytes,
+                                      int param_size,
+                                      int dev_type, int dev_id,
+                                      mx_uint num_input_nodes,
+                                      const char** input_keys,
+                                      const mx_uint* input_shape_indptr,
+                                      const mx_uint* input_shape_data,
+                                      int num_threads,
+                                      PredictorHandle* out);
+/*!
+ * \brief save a predictor as a compiled model, loaded by MXPredCreateFromCompiled.
+ *  The compiled model holds the symbol in the current format, the input shapes
+ *  of the predictor, the shapes inferred from them for the whole graph, and
+ *  only the parameters used by the symbol, so that loading it needs neither
+ *  the upgrade of the symbol nor the shape inference of the predictor.
+ *  The memory plan and the operators are still set up when it is bound.
+ * \param handle The handle of the predictor.
+ * \param out_bytes Set to the bytes of the compiled model, valid until the
+ *    next call to this function or the free of the predictor.
+ * \param out_size Set to the number of bytes.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredSaveCompiled(PredictorHandle handle,
+                                 const char** out_bytes,
+                                 mx_uint* out_size);
+/*!
+ * \brief create a predictor from a compiled model saved by MXPredSaveCompiled,
+ *  with the input shapes and the outputs of the saved predictor.
+ * \param model_bytes The in-memory bytes of the compiled model.
+ * \param model_size The number of bytes of the compiled model.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param out The created predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredCreateFromCompiled(const void* model_bytes,
+                                       int model_size,
+                                       int dev_type, int dev_id,
+                                       PredictorHandle* out);
 /*!
  * \brief Get the shape of output node.
  *  The returned shape_data and shape_ndim is only valid before next call to MXPred function.
@@ -144,6 +223,65 @@ MXNET_DLL int MXPredSetInput(PredictorHandle handle,
                              const char* key,
                              const mx_float* data,
                              mx_uint size);
+/*!
+ * \brief Bind a buffer owned by the caller as an input of the predictor,
+ *  instead of copying the input at every MXPredSetInput.
+ *  On cpu predictors the buffer becomes the input array of the executor,
+ *  which is bound again once, so the data written in the buffer is read in
+ *  place by the next forward. A 64 bytes aligned buffer is best for the
+ *  vectorized operators. On other devices the buffer is copied to the device
+ *  asynchronously by every forward, a buffer registered by
+ *  MXPredRegisterHostMemory makes this copy faster. The buffer must stay valid while the predictor is used, and must
+ *  not be written between a forward and the read of its outputs.
+ *  A later MXPredSetInput of the same key stops using the buffer on non cpu
+ *  predictors, and writes into it on cpu predictors.
+ * \param handle The predictor handle.
+ * \param key The name of the input key.
+ * \param data The buffer of the input.
+ * \param size The number of values of the buffer, used for safe checking.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredSetInputBuffer(PredictorHandle handle,
+                                   const char* key,
+                                   mx_float* data,
+                                   mx_uint size);
+/*!
+ * \brief Page-lock a buffer owned by the caller, so that the copies from and
+ *  to gpu predictors, by MXPredSetInput, MXPredSetInputBuffer or MXPredGetOutput,
+ *  are done by DMA instead of staging through a driver buffer. Registering is
+ *  slow, it is meant for buffers reused for the whole process. Does nothing
+ *  without gpus.
+ * \param data The buffer, which must stay allocated until unregistered.
+ * \param size The number of values of the buffer.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredRegisterHostMemory(mx_float* data, mx_uint size);
+/*!
+ * \brief Unregister a buffer registered by MXPredRegisterHostMemory.
+ * \param data The buffer, as registered.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredUnregisterHostMemory(mx_float* data);
+/*!
+ * \brief Change the shapes of the inputs of a predictor, such as its batch size.
+ *  The parameters are kept, and the executor of the new shapes reuses the
+ *  memory of the current one. The executors of the last few shapes, set by
+ *  MXNET_PREDICTOR_RESHAPE_CACHE_SIZE, are kept so that switching back to
+ *  them does not bind again. The inputs of the given keys must be set again,
+ *  and the buffers bound by MXPredSetInputBuffer are not used for the new shapes.
+ * \param handle The predictor handle.
+ * \param num_input_nodes Number of input nodes whose shape changes.
+ * \param input_keys The name of input argument.
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ * \param input_shape_data A flatted data of shapes of each input node.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredReshape(PredictorHandle handle,
+                            mx_uint num_input_nodes,
+                            const char** input_keys,
+                            const mx_uint* input_shape_indptr,
+                            const mx_uint* input_shape_data);
 /*!
  * \brief Run a forward pass to get the output.
  * \param handle The handle of the predictor.
@@ -179,12 +317,81 @@ MXNET_DLL int MXPredGetOutput(PredictorHandle handle,
                               mx_uint index,
                               mx_float* data,
                               mx_uint size);
+/*!
+ * \brief Get the output of the predictor without copying it to a caller buffer.
+ *  On cpu predictors the returned pointer is the output array of the executor,
+ *  on other devices it is a pinned host copy of the output. The data is valid
+ *  until the next forward or MXPredSetInputBuffer.
+ * \param handle The handle of the predictor.
+ * \param index The index of output node.
+ * \param data Set to the output data.
+ * \param size Set to the number of values of the output.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredGetOutputBuffer(PredictorHandle handle,
+                                    mx_uint index,
+                                    const mx_float** data,
+                                    mx_uint* size);
 /*!
  * \brief Free a predictor handle.
  * \param handle The handle of the predictor.
  * \return 0 when success, -1 when failure.
  */
 MXNET_DLL int MXPredFree(PredictorHandle handle);
+/*!
+ * \brief create a predictor which runs the requests of single samples in batches.
+ *  The requests are collected until max_batch_size of them are pending, or
+ *  until max_delay_us microseconds after the oldest one, and run by one forward.
+ *  A batch is run by the predictor bound for the smallest power of two batch
+ *  size it fits in, bound at its first use, so partial batches never rebind.
+ *  Every output of the model must have the batch size as first axis.
+ * \param symbol_json_str The JSON string of the symbol.
+ * \param param_bytes The in-memory raw bytes of parameter ndarray file.
+ * \param param_size The size of parameter ndarray file.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param num_input_nodes Number of input nodes to the net.
+ * \param input_keys The name of input argument.
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ * \param input_shape_data A flatted data of shapes of each input node, for one
+ *    sample. The first axis of every shape is the batch axis, of size 1.
+ * \param max_batch_size The largest number of requests run together.
+ * \param max_delay_us The longest time a request waits for a batch to fill.
+ * \param out The created batching predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchCreate(const char* symbol_json_str,
+                                const void* param_bytes,
+                                int param_size,
+                                int dev_type, int dev_id,
+                                mx_uint num_input_nodes,
+                                const char** input_keys,
+                                const mx_uint* input_shape_indptr,
+                                const mx_uint* input_shape_data,
+                                mx_uint max_batch_size,
+                                mx_uint max_delay_us,
+                                BatchPredictorHandle* out);
+/*!
+ * \brief submit the request of one sample to a batching predictor.
+ *  The call returns at once, the callback is called from the thread of the
+ *  predictor when the batch of the request has run.
+ * \param handle The handle of the batching predictor.
+ * \param inputs The data of every input node for one sample, in the order of
+ *    the input keys, copied before the call returns.
+ * \param callback The function receiving the outputs of the sample.
+ * \param user_data Passed to the callback.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredSubmit(BatchPredictorHandle handle,
+                           const mx_float** inputs,
+                           MXPredBatchCallback callback,
+                           void* user_data);
+/*!
+ * \brief Free a batching predictor handle, after running the pending requests.
+ * \param handle The handle of the batching predictor.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchFree(BatchPredictorHandle handle);
 /*!
  * \brief Create a NDArray List by loading from ndarray file.
  *     This can be used to load mean image file.
@@ -27,6 +27,8 @@
 #include <dmlc/base.h>
 #if DMLC_USE_CXX11
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <functional>
 #endif
@@ -70,6 +72,95 @@ class CallbackOnComplete {
   /*! \brief the parameter set on callback */
   void* param_;
 };
+
+/*!
+ * \brief the priority classes of the operations pushed to the engine.
+ *  ThreadedEnginePerDevice runs the operations with a priority of at least
+ *  kRealtimePriority on workers and streams of their own, so they do not
+ *  queue behind the normal operations of the device, and the ones with a
+ *  priority below kBackgroundPriority on background workers. Within a class
+ *  the priority orders the ready operations.
+ */
+constexpr int kRealtimePriority = 1 << 20;
+/*! \brief the operations below this priority run on the background workers */
+constexpr int kBackgroundPriority = -(1 << 20);
+
+#if DMLC_USE_CXX11
+/*!
+ * \brief Token shared by the operations that are cancelled together, e.g. the
+ *  operations of one request of a server. An operation pushed with a token
+ *  that is cancelled, or whose deadline has passed, by the time the operation
+ *  is about to run is skipped: its function is not called and its variables
+ *  are released as if it had completed, so their content is undefined. The
+ *  token counts the skipped operations.
+ *
+ *  A default constructed token is empty and never cancels anything. Copies of
+ *  a token share their state.
+ */
+class CancelToken {
+ public:
+  /*! \return a new token that is not cancelled and has no deadline */
+  static CancelToken Create() {
+    CancelToken ret;
+    ret.state_ = std::make_shared<State>();
+    return ret;
+  }
+  /*! \brief cancel the operations that have not started yet */
+  inline void Cancel() const {
+    state_->cancelled = true;
+  }
+  /*!
+   * \brief cancel the operations that have not started in timeout_ms milliseconds
+   * \param timeout_ms the time from now, in milliseconds
+   */
+  inline void SetDeadline(int64_t timeout_ms) const {
+    state_->deadline = Now() + timeout_ms * 1000;
+  }
+  /*! \return whether the token was cancelled or its deadline has passed */
+  inline bool cancelled() const {
+    if (state_ == nullptr) return false;
+    if (state_->cancelled) return true;
+    const int64_t deadline = state_->deadline;
+    if (deadline >= 0 && Now() >= deadline) {
+      state_->cancelled = true;
+      return true;
+    }
+    return false;
+  }
+  /*! \return the number of operations the token skipped */
+  inline int num_skipped() const {
+    return state_ == nullptr ? 0 : state_->num_skipped.load();
+  }
+  /*!
+   * \brief called by the engine before running an operation with this token
+   * \return whether the operation must be skipped
+   */
+  inline bool Skip() const {
+    if (!cancelled()) return false;
+    ++state_->num_skipped;
+    return true;
+  }
+  /*! \return whether the token is not empty */
+  explicit operator bool() const {
+    return state_ != nullptr;
+  }
+
+ private:
+  /*! \brief state shared by the copies of a token */
+  struct State {
+    std::atomic<bool> cancelled{false};
+    /*! \brief deadline in microseconds of the steady clock, -1 for none */
+    std::atomic<int64_t> deadline{-1};
+    std::atomic<int> num_skipped{0};
+  };
+  /*! \return the time of the steady clock in microseconds */
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  std::shared_ptr<State> state_;
+};
+#endif  // DMLC_USE_CXX11
 }  // namespace engine
 
 #if DMLC_USE_CXX11
@@ -159,7 +250,8 @@ class MXNET_API Engine {
    *                   mutate.
    * \param mutable_vars The variables that current operation will mutate.
    * \param prop Property of the function.
-   * \param priority Priority of the action, as hint to the engine.
+   * \param priority Priority of the action, as hint to the engine,
+   *  see kRealtimePriority and kBackgroundPriority for the priority classes.
    * \param opr_name The operator name.
    */
   virtual void PushAsync(AsyncFn exec_fun, Context exec_ctx,
@@ -168,6 +260,37 @@ class MXNET_API Engine {
                          FnProperty prop = FnProperty::kNormal,
                          int priority = 0,
                          const char* opr_name = nullptr) = 0;
+  /*!
+   * \brief Push an asynchronous operation that is skipped when token is
+   *  cancelled before the operation starts, see engine::CancelToken.
+   *  The arguments are the ones of PushAsync.
+   */
+  inline void PushAsyncCancellable(AsyncFn exec_fun, Context exec_ctx,
+                                   std::vector<VarHandle> const& const_vars,
+                                   std::vector<VarHandle> const& mutable_vars,
+                                   const engine::CancelToken& token,
+                                   FnProperty prop = FnProperty::kNormal,
+                                   int priority = 0,
+                                   const char* opr_name = nullptr) {
+    this->PushAsync(Cancellable(exec_fun, token), exec_ctx, const_vars, mutable_vars,
+                    prop, priority, opr_name);
+  }
+  /*!
+   * \brief wrap an operation so that it completes without running when token
+   *  is cancelled before it starts.
+   * \param exec_fun the operation
+   * \param token the cancellation token, exec_fun is returned when it is empty
+   */
+  static AsyncFn Cancellable(AsyncFn exec_fun, const engine::CancelToken& token) {
+    if (!token) return exec_fun;
+    return [exec_fun, token](RunContext ctx, CallbackOnComplete on_complete) {
+      if (token.Skip()) {
+        on_complete();
+      } else {
+        exec_fun(ctx, on_complete);
+      }
+    };
+  }
   /*!
    * \brief Schedule the deletion of a variable.
    *
@@ -188,6 +311,31 @@ class MXNET_API Engine {
    *            variable is ready.
    */
   virtual void WaitForVar(VarHandle var) = 0;
+  /*!
+   * \brief Check without blocking whether the writes pushed to a variable
+   *  have completed, i.e. whether WaitForVar would return at once.
+   *  The default implementation, for engines running the operations
+   *  synchronously, waits for the variable.
+   * \param var the variable to check.
+   * \return whether the variable is ready to read.
+   */
+  virtual bool IsVarReady(VarHandle var) {
+    this->WaitForVar(var);
+    return true;
+  }
+  /*!
+   * \brief Call a function once the writes pushed to a variable so far have
+   *  completed, without pushing an operation to the engine. The function
+   *  is called at once when the variable is ready, and otherwise by the
+   *  engine thread completing the last write, so it must not block nor
+   *  push operations waiting for the variable.
+   * \param var the variable to wait for.
+   * \param callback the function to call.
+   */
+  virtual void OnVarReady(VarHandle var, std::function<void()> callback) {
+    this->WaitForVar(var);
+    callback();
+  }
   /*!
    * \brief Wait until all the activity of engine finishes.
    */
@@ -218,18 +366,40 @@ class MXNET_API Engine {
    * \param priority Priority of the action, as hint to the engine.
    * \param opr_name The operator name.
    * \tparam SyncFn the synchronous function to be pushed.
+   *
+   *  An engine may hold back the operation and run it later in one engine
+   *  operation together with the next ones pushed by the same thread, see
+   *  set_bulk_size. In that case RunContext::is_bulk is set.
    */
-  inline void PushSync(SyncFn exec_fn, Context exec_ctx,
-                       std::vector<VarHandle> const& const_vars,
-                       std::vector<VarHandle> const& mutable_vars,
-                       FnProperty prop = FnProperty::kNormal,
-                       int priority = 0,
-                       const char* opr_name = nullptr) {
+  virtual void PushSync(SyncFn exec_fn, Context exec_ctx,
+                        std::vector<VarHandle> const& const_vars,
+                        std::vector<VarHandle> const& mutable_vars,
+                        FnProperty prop = FnProperty::kNormal,
+                        int priority = 0,
+                        const char* opr_name = nullptr) {
     this->PushAsync([exec_fn](RunContext ctx, CallbackOnComplete on_complete) {
         exec_fn(ctx);
         on_complete();
       }, exec_ctx, const_vars, mutable_vars, prop, priority, opr_name);
   }
+  /*!
+   * \brief Set the maximum number of synchronous operations the calling
+   *  thread pushes with PushSync that are merged into one engine operation.
+   *
+   *  The merged operations are dispatched when the limit is reached, when the
+   *  thread pushes to another device or pushes any other operation, and when
+   *  the thread waits for a variable or for the engine. 0 or 1 dispatch every
+   *  operation at once. Engines that do not merge operations ignore it.
+   * \param bulk_size the new limit of the calling thread.
+   * \return the previous limit.
+   */
+  virtual int set_bulk_size(int bulk_size) {
+    return 0;
+  }
+  /*! \return the limit set by set_bulk_size for the calling thread */
+  virtual int bulk_size() const {
+    return 0;
+  }
 
   /*!
    * \brief factory function to create OnComplete callback.
@@ -51,6 +51,33 @@ using nnvm::Symbol;
  */
 class Executor {
  public:
+  /*! \brief Memory plan of one node entry */
+  struct MemoryPlanEntry {
+    /*! \brief name of the node, followed by [index] for nodes with several outputs */
+    std::string name;
+    /*!
+     * \brief id of the storage block planned for the entry, or -1 if it is not
+     *  allocated, -2 if it is bound from outside and -3 if it is allocated at run time
+     */
+    int storage_id;
+    /*! \brief size of the entry in bytes */
+    size_t bytes;
+    /*! \brief OpReqType of the node writing the entry, -1 for variables */
+    int req;
+    /*! \brief index of the input the entry reuses the memory of inplace, -1 if none */
+    int inplace_input;
+    /*! \brief context of the entry */
+    Context ctx;
+  };
+  /*! \brief Memory of the storage blocks planned on one context */
+  struct MemoryPlanTotal {
+    /*! \brief the context */
+    Context ctx;
+    /*! \brief bytes of the blocks used by the forward pass */
+    size_t forward_bytes;
+    /*! \brief bytes of the blocks used by the forward and backward passes */
+    size_t train_bytes;
+  };
   /*! \brief destructor */
   virtual ~Executor() {}
   /*!
@@ -58,6 +85,15 @@ class Executor {
    *  After this operation, user can get the result by using function head.
    */
   virtual void Forward(bool is_train) = 0;
+  /*!
+   * \brief Perform a Forward operation whose operators are skipped when
+   *  token is cancelled, or its deadline passed, before they start.
+   *  The outputs are undefined when token.num_skipped() is not 0 after the
+   *  outputs are ready.
+   * \param is_train whether this is a training forward
+   * \param token the cancellation token of the operators
+   */
+  virtual void Forward(bool is_train, const engine::CancelToken& token) = 0;
   /*!
    * \brief Perform a Partial Forward operation of Operator.
    *  Only issue operation specified by step.
@@ -82,6 +118,13 @@ class Executor {
    * \param os the output stream we like to print to.
    */
   virtual void Print(std::ostream &os) const {} // NOLINT(*)
+  /*!
+   * \brief get the memory plan of the executor.
+   * \param entries the plan of every node entry, by entry id
+   * \param totals the bytes planned on every context
+   */
+  virtual void GetMemoryPlan(std::vector<MemoryPlanEntry>* entries,
+                             std::vector<MemoryPlanTotal>* totals) const {}
   /*!
    * \brief get array of outputs in the executor.
    * \return array of outputs in the executor.
@@ -102,6 +145,20 @@ class Executor {
    * \return aux state map in the executor.
    */
   virtual const std::unordered_map<std::string, NDArray>& aux_state_map() const = 0;
+  /*!
+   * \brief Get the second buffer of an input argument, to be filled with the
+   *  input of the next Forward. The ops of the running iteration read the
+   *  bound argument only, so that writing this buffer, e.g. by a copy from
+   *  the host, overlaps their computation. The next Forward exchanges the
+   *  memory of the two arrays, so that the bound argument holds the data
+   *  written here, without binding again. Call it before each such write.
+   * \param name name of the input argument, of default storage.
+   * \return the second buffer, with the shape, type and context of the argument.
+   */
+  virtual NDArray NextInput(const std::string& name) {
+    LOG(FATAL) << "NextInput is not supported by this executor";
+    return NDArray();
+  }
   /*!
    * \brief Create an operator by bind symbol with context and arguments.
    *  If user do not want to compute the gradients of i-th argument, grad_req_type[i] can be kNullOp.
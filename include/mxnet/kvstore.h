@@ -338,6 +338,21 @@ class KVStore {
    */
   virtual void Barrier() { }
 
+  /**
+   * \brief set the gradient compression of the pushed values
+   *
+   * Only supported by the distributed kvstore, where the dense gradients
+   * pushed by the workers are compressed before being sent to the servers.
+   * Must be called before \ref Init.
+   *
+   * \param kwargs the parameters of the compression, such as
+   *  {{"type", "2bit"}, {"threshold", "0.5"}}
+   */
+  virtual void SetGradientCompression(
+      const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    LOG(FATAL) << "gradient compression is only supported by the distributed kvstore";
+  }
+
   /**
    * \brief Send a command to all server nodes
    *
@@ -351,6 +366,32 @@ class KVStore {
    */
   virtual void SendCommandToServers(int cmd_id, const std::string& cmd_body) { }
 
+  /**
+   * \brief get the next part of the data to read in an epoch
+   *
+   * The data named \a name is divided into \a num_parts parts, which the
+   * first server hands out to the workers one at a time, in the order they
+   * ask for them. The workers reading faster thus read more parts, and all
+   * finish an epoch at about the same time.
+   *
+   * Only supported by the distributed kvstore.
+   *
+   * \param name the name of the data, the same on all workers
+   * \param epoch the epoch, counted by every worker
+   * \param num_parts the number of parts of the data
+   * \return the index of the part, or -1 once all parts of the epoch are handed out
+   */
+  virtual int NextPart(const std::string& name, int epoch, int num_parts) {
+    LOG(FATAL) << "dynamic sharding is only supported by the distributed kvstore";
+    return -1;
+  }
+
+  /**
+   * \return the distributed kvstore of this worker process, or nullptr if
+   *  there is none, which the data iterators ask for their parts
+   */
+  static KVStore* DistWorker();
+
   /**
    * \brief the prototype of a server controller
    */
@@ -372,6 +413,11 @@ class KVStore {
   virtual void RunServer(const Controller& controller) { }
 
  protected:
+  /**
+   * \brief set the kvstore returned by \ref DistWorker
+   */
+  static void SetDistWorker(KVStore* kv);
+
   /**
    * \brief the user-defined updater
    */
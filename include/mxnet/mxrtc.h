@@ -76,15 +76,32 @@ class MXRtc {
             unsigned int  block_dim_X,
             unsigned int  block_dim_Y,
             unsigned int  block_dim_Z);
+  /*!
+   * \brief compile the kernel with nvrtc.
+   * \param name name of the kernel function.
+   * \param code cuda code of the kernel.
+   * \return the ptx of the kernel, owned by the caller.
+   */
+  static char* compile(const std::string& name, const std::string& code);
+  /*!
+   * \brief get the ptx of a kernel for the compute capability of a device.
+   *
+   * The kernels are compiled once per nvrtc version, options, compute
+   * capability and code, and kept in memory. When MXNET_RTC_CACHE_DIR is
+   * set, they are also kept in that directory and shared across processes.
+   * \param name name of the kernel function.
+   * \param code cuda code of the kernel.
+   * \param dev_id the device the kernel is compiled for.
+   * \return the ptx of the kernel.
+   */
+  static std::string GetPTX(const std::string& name, const std::string& code, int dev_id);
 
  private:
   static const char str_type[];
-  static std::unordered_map<std::string, char*> kernel_registry;
 
   std::string name_;
   index_t num_input_, num_output_;
   std::string code_;
-  char* ptx_;
   std::unordered_map<int, CUmodule> module_;
   std::unordered_map<int, CUfunction> func_;
 
@@ -95,10 +112,6 @@ class MXRtc {
                        std::vector<std::pair<std::string, NDArray> > const& input,
                        std::vector<std::pair<std::string, NDArray> > const& output,
                        const std::string kernel);
-  /*!
-   * \brief compile the kernel with nvrtc.
-   */
-  char* compile(const std::string& name, const std::string& code);
 };
 
 }  // namespace mxnet
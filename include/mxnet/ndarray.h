@@ -31,6 +31,7 @@
 #include <dmlc/registry.h>
 #include <nnvm/node.h>
 #include <vector>
+#include <functional>
 #include <map>
 #include <string>
 #include <memory>
@@ -172,6 +173,32 @@ class NDArray {
     Mkl_mem_ = std::make_shared<MKLMemHolder>();
 #endif
   }
+  /*!
+   * \brief constructing an NDArray on the shared memory another process
+   *  allocated on the kCPUShared context, see GetSharedMemHandle.
+   * \param shared_pid id of the process that allocated the memory
+   * \param shared_id id of the memory within that process
+   * \param shape the shape of the array
+   * \param dtype data type of the array
+   */
+  NDArray(int shared_pid, int shared_id, const TShape& shape, int dtype)
+      : ptr_(std::make_shared<Chunk>(shared_pid, shared_id, shape, dtype)), shape_(shape),
+        dtype_(dtype), entry_({nullptr, 0, 0}) {
+#if MKL_EXPERIMENTAL == 1
+    Mkl_mem_ = std::make_shared<MKLMemHolder>();
+#endif
+  }
+  /*!
+   * \brief constructing a static NDArray that shares data with TBlob, and keeps
+   *  the memory of the data alive with holder until the NDArray is freed
+   * \param data the memory content of static data
+   * \param dev_id the device id this tensor sits at
+   * \param holder owner of the memory of data, released after the last use of data
+   */
+  NDArray(const TBlob &data, int dev_id, std::shared_ptr<void> holder)
+      : NDArray(data, dev_id) {
+    ptr_->static_holder = holder;
+  }
 
   /*!
    * \brief constructing a static NDArray of non-default storage that shares data with TBlob
@@ -337,6 +364,40 @@ class NDArray {
     if (is_none()) return;
     Engine::Get()->WaitForVar(ptr_->var);
   }
+  /*!
+   * \brief Get the ids another process maps the memory of this kCPUShared
+   *  NDArray with. The memory can be mapped while this NDArray lives.
+   * \param shared_pid id of the process that allocated the memory
+   * \param shared_id id of the memory within that process
+   */
+  inline void GetSharedMemHandle(int* shared_pid, int* shared_id) const {
+    CHECK_EQ(ctx().dev_type, Context::kCPUShared)
+        << "Only NDArrays of the cpu_shared context have a shared memory handle";
+    ptr_->CheckAndAlloc();
+    *shared_pid = ptr_->shandle.shared_pid;
+    *shared_id = ptr_->shandle.shared_id;
+  }
+  /*!
+   * \brief Check without blocking whether the pending write operations with
+   *    respect to current NDArray are finished.
+   * \return whether read can be performed.
+   */
+  inline bool IsReady() const {
+    if (is_none()) return true;
+    return Engine::Get()->IsVarReady(ptr_->var);
+  }
+  /*!
+   * \brief Call a function once the pending write operations with respect to
+   *    current NDArray are finished, see Engine::OnVarReady.
+   * \param callback the function to call.
+   */
+  inline void OnReady(std::function<void()> callback) const {
+    if (is_none()) {
+      callback();
+      return;
+    }
+    Engine::Get()->OnVarReady(ptr_->var, std::move(callback));
+  }
   /*!
    * \brief Block until all the pending read/write operations with respect
    *    to current NDArray are finished, and write can be performed.
@@ -472,6 +533,19 @@ class NDArray {
    * \param size the memory size we want to copy into, in sizeof(DType) not raw btyes.
    */
   void SyncCopyToCPU(void *data, size_t size) const;
+  /*!
+   * \brief Do an asynchronize copy to a continugous CPU memory region.
+   *
+   *  The copy is pushed to the engine after the pending writes of the NDArray,
+   *  and the function returns at once. Use pinned memory for fast copies from
+   *  the GPU. The memory region must stay valid until on_complete is called.
+   *
+   * \param data the data source to copyinto.
+   * \param size the memory size we want to copy into, in sizeof(DType) not raw btyes.
+   * \param on_complete called from an engine thread once the data is copied
+   */
+  void CopyToCPUAsync(void *data, size_t size,
+                      const std::function<void()>& on_complete) const;
   /*!
    * \brief Slice a NDArray
    * \param begin begin index in first dim (inclusive)
@@ -529,6 +603,22 @@ class NDArray {
    * \return NDArray in new shape
    */
   NDArray Reshape(const TShape &shape) const;
+  /*!
+   * \brief Create a default storage array with the shape, type and context
+   *  of this one, backed by memory of the same size, so that the two arrays
+   *  can exchange their memory with SwapStorage.
+   * \return the twin array
+   */
+  NDArray StorageTwin() const;
+  /*!
+   * \brief Exchange the memory of this array with the one of a twin created
+   *  by StorageTwin. Both arrays keep their engine variables, and the arrays
+   *  sharing the memory of either one, such as its views, follow the exchange.
+   *  This is an internal function, to be run by the engine with the write
+   *  dependency on both arrays.
+   * \param twin the array to exchange the memory with
+   */
+  void SwapStorage(const NDArray& twin) const;
   /*!
    * \brief Return a copy of this NDArray without autograd history
    */
@@ -607,6 +697,69 @@ class NDArray {
   static void Load(dmlc::Stream* fi,
                    std::vector<NDArray>* data,
                    std::vector<std::string>* keys);
+  /*!
+   * \brief Save list of dense ndarray into the Stream in the mappable format,
+   *  an index of names, shapes, types and offsets followed by the aligned
+   *  content of the arrays, which can be loaded by LoadMapped.
+   * \param fo The stream of output.
+   * \param data the NDArrays to be saved.
+   * \param names the name of the NDArray, optional, can be zero length.
+   */
+  static void SaveMappable(dmlc::Stream* fo,
+                           const std::vector<NDArray>& data,
+                           const std::vector<std::string>& names);
+  /*!
+   * \brief Load list of ndarray from a file in the mappable format. Local
+   *  files are memory mapped, and the arrays of the cpu point at the mapped
+   *  pages, which are copied on first write.
+   * \param fname The name of the file.
+   * \param select the names of the arrays to load, all arrays if empty.
+   * \param data the NDArrays to be loaded
+   * \param keys the name of the NDArray, if saved in the file.
+   * \return false if the file is not in the mappable format.
+   */
+  static bool LoadMapped(const std::string& fname,
+                         const std::vector<std::string>& select,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys);
+  /*!
+   * \brief Get the CUDA IPC handle another process opens the data of this
+   *  dense GPU NDArray with, see ImportCUDAIPC. The data is shared without
+   *  copy, and stays valid while this NDArray lives. The pending writes to
+   *  the NDArray are waited for.
+   * \param ipc_handle the handle of the cudaMalloc allocation holding the data
+   * \param offset the byte offset of the data in the allocation
+   */
+  void ExportCUDAIPC(std::string* ipc_handle, size_t* offset) const;
+  /*!
+   * \brief Open the data of a GPU NDArray of another process, given by
+   *  ExportCUDAIPC. The processes must order their reads and writes to the
+   *  data themselves.
+   * \param ipc_handle the handle of the allocation
+   * \param offset the byte offset of the data in the allocation
+   * \param shape the shape of the NDArray
+   * \param dtype the data type of the NDArray
+   * \param dev_id the GPU the data sits on
+   * \return the NDArray, which closes the handle when it is freed
+   */
+  static NDArray ImportCUDAIPC(const std::string& ipc_handle, size_t offset,
+                               const TShape& shape, int dtype, int dev_id);
+  /*!
+   * \brief Share the data of this dense NDArray with another framework
+   *  through DLPack, without copy. The returned tensor keeps the data alive
+   *  until its deleter is called. The pending reads or writes to the NDArray
+   *  are not waited for, the caller calls WaitToRead or WaitToWrite first.
+   * \return the DLPack tensor, freed by calling its deleter
+   */
+  DLManagedTensor* ToDLPack() const;
+  /*!
+   * \brief Create an NDArray on the data of a DLPack tensor of another
+   *  framework, without copy. The deleter of the tensor is called once the
+   *  NDArray is freed and the operations pending on it have finished.
+   * \param tensor the compact DLPack tensor, owned by the NDArray afterwards
+   * \return the NDArray
+   */
+  static NDArray FromDLPack(DLManagedTensor* tensor);
 
  private:
   friend class autograd::AutogradRuntime;
@@ -648,6 +801,8 @@ class NDArray {
     // The shape of aux data. The default value for the shape depends on the type of storage.
     // If aux_shapes[i].Size() is zero, aux data i is empty.
     std::vector<TShape> aux_shapes;
+    /*! \brief owner of the memory of static data, if any */
+    std::shared_ptr<void> static_holder;
 
     /*! \brief default cosntructor */
     Chunk() : static_data(true), delay_alloc(false) {}
@@ -663,6 +818,15 @@ class NDArray {
       if (!delay_alloc_) this->CheckAndAlloc();
     }
 
+    /*! \brief construct a chunk on the shared memory of another process */
+    Chunk(int shared_pid, int shared_id, const TShape& shape, int dtype)
+        : static_data(false), delay_alloc(false), ctx(Context::CPUShared(0)) {
+      var = Engine::Get()->NewVariable();
+      storage_shape = shape;
+      shandle = Storage::Get()->AttachShared(
+          shared_pid, shared_id, shape.Size() * mshadow::mshadow_sizeof(dtype));
+    }
+
     Chunk(const TBlob &data, int dev_id)
         : static_data(true), delay_alloc(false) {
       CHECK(storage_type == kDefaultStorage);
@@ -832,7 +996,8 @@ class NDArray {
       bool skip_free = static_data || delay_alloc;
       Storage::Handle h = this->shandle;
       std::vector<Storage::Handle> aux_h = this->aux_handles;
-      Engine::Get()->DeleteVariable([h, aux_h, skip_free](RunContext s) {
+      std::shared_ptr<void> holder = this->static_holder;
+      Engine::Get()->DeleteVariable([h, aux_h, skip_free, holder](RunContext s) {
         if (skip_free == false) {
           Storage::Get()->Free(h);
           for (size_t i = 0; i < aux_h.size(); i++) {
@@ -905,6 +1070,19 @@ size_t num_aux_data(NDArrayStorageType stype);
  */
 void CopyFromTo(const NDArray &from, NDArray *to, int priority = 0);
 
+/*!
+ * \brief issue the copies from[i] to (*to)[i], as if by CopyFromTo in order.
+ *  The copies of dense arrays between the same pair of contexts run in one
+ *  engine operation that waits for the stream once, and the copies of
+ *  adjacent regions to adjacent regions are merged.
+ *
+ * \param from the ndarrays we want to copy data from
+ * \param to the target ndarrays
+ * \param priority Priority of the action.
+ */
+void CopyFromTo(const std::vector<NDArray> &from, std::vector<NDArray> *to,
+                int priority = 0);
+
 /*!
  * \brief Perform elementwise sum over each data from source, store result into out.
  * \param source the ndarray we want to sum
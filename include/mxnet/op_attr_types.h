@@ -207,6 +207,29 @@ using FStatefulComputeEx = std::function<void (const OpStatePtr& state,
  */
 using FResourceRequest = std::function<
   std::vector<ResourceRequest> (const NodeAttrs& n)>;
+/*!
+ * \brief The size in bytes of the temporary space the operator requests for
+ *  the given input shapes and types. The executor allocates the temporary
+ *  space needed by its largest operator at bind time, instead of growing it
+ *  while the first iterations run.
+ *
+ * \note Register under "FTempSpaceSize<cpu>" and "FTempSpaceSize<gpu>"
+ */
+using FTempSpaceSize = std::function<size_t (const NodeAttrs& attrs,
+                                             const std::vector<TShape>& in_shape,
+                                             const std::vector<int>& in_type)>;
+/*!
+ * \brief The offsets, in elements, of the outputs of the operator in its
+ *  input when every output is a contiguous block of the input, such as the
+ *  slices along the outermost axis. Returns false when it is not the case
+ *  for the given attributes and input shape. The outputs may then be views
+ *  of the input instead of copies.
+ *
+ * \note Register under "FOutputViews"
+ */
+using FOutputViews = std::function<bool (const NodeAttrs& attrs,
+                                         const TShape& in_shape,
+                                         std::vector<size_t>* offsets)>;
 /*!
  * \brief Register an operator called as a NDArray function
  *
@@ -242,6 +265,24 @@ using FInferStorageType = std::function<bool (const NodeAttrs& attrs,
                                               std::vector<int>* in_attrs,
                                               std::vector<int>* out_attrs)>;
 
+/*!
+ * \brief Create the int8 version of a node, or return nullptr if the
+ *  attributes of the node are not supported by the quantized operator.
+ *  The quantized node takes the int8 inputs followed by the min and max
+ *  ranges of every input, and produces its outputs followed by their ranges.
+ *
+ * \note Register under "FQuantizedOp"
+ */
+using FQuantizedOp = std::function<nnvm::NodePtr (const NodeAttrs& attrs)>;
+
+/*!
+ * \brief Whether the int32 outputs of a quantized operator are converted
+ *  back to int8 by a requantize operator
+ *
+ * \note Register under "FNeedRequantize"
+ */
+using FNeedRequantize = std::function<bool (const NodeAttrs& attrs)>;
+
 }  // namespace mxnet
 
 #endif  // MXNET_OP_ATTR_TYPES_H_
@@ -30,6 +30,12 @@
 
 namespace mxnet {
 
+namespace common {
+namespace random {
+class RandGenerator;
+}  // namespace random
+}  // namespace common
+
 /*!
  * \brief The resources that can be requested by Operator
  */
@@ -39,7 +45,13 @@ struct ResourceRequest {
     /*! \brief mshadow::Random<xpu> object */
     kRandom,
     /*! \brief A dynamic temp space that can be arbitrary size */
-    kTempSpace
+    kTempSpace,
+    /*!
+     * \brief common::random::RandGenerator object, a counter-based generator
+     *  with its own stream, so operators using different copies can run in
+     *  parallel.
+     */
+    kParallelRandom
   };
   /*! \brief type of resources */
   Type type;
@@ -62,7 +74,10 @@ struct ResourceRequest {
 struct Resource {
   /*! \brief The original request */
   ResourceRequest req;
-  /*! \brief engine variable */
+  /*!
+   * \brief engine variable, nullptr when the resource is local to the
+   *  executing thread and must not be added to the dependencies.
+   */
   engine::VarHandle var;
   /*! \brief identifier of id information, used for debug purpose */
   int32_t id;
@@ -88,6 +103,14 @@ struct Resource {
     ret->set_stream(stream);
     return ret;
   }
+  /*!
+   * \brief Get the parallel random number generator.
+   * \return the generator, its numbers can be drawn from any device.
+   */
+  inline common::random::RandGenerator* get_parallel_random() const {
+    CHECK_EQ(req.type, ResourceRequest::kParallelRandom);
+    return static_cast<common::random::RandGenerator*>(ptr_);
+  }
   /*!
    * \brief Get space requested as mshadow Tensor.
    *  The caller can request arbitrary size.
@@ -50,6 +50,35 @@ class Storage {
      * \brief Context information about device and ID.
      */
     Context ctx;
+    /*!
+     * \brief Id of the process that created the shared memory of a
+     *  kCPUShared handle, -1 otherwise.
+     */
+    int shared_pid{-1};
+    /*!
+     * \brief Id of the shared memory of a kCPUShared handle within the
+     *  process that created it, -1 otherwise.
+     */
+    int shared_id{-1};
+  };
+  /*!
+   * \brief Memory allocation statistics of one context.
+   */
+  struct Stats {
+    /*! \brief bytes handed out and not freed yet */
+    size_t bytes_in_use{0};
+    /*! \brief bytes held by the memory pool for reuse */
+    size_t bytes_cached{0};
+    /*! \brief maximum of bytes_in_use seen so far */
+    size_t peak_bytes_in_use{0};
+    /*! \brief number of allocations */
+    uint64_t num_alloc{0};
+    /*! \brief number of frees, including direct frees */
+    uint64_t num_free{0};
+    /*! \brief number of allocations not served from the memory pool */
+    uint64_t num_miss{0};
+    /*! \brief number of times the memory pool gave all cached memory back */
+    uint64_t num_release_all{0};
   };
   /*!
    * \brief Allocate a new contiguous memory for a given size.
@@ -58,6 +87,15 @@ class Storage {
    * \return Handle struct.
    */
   virtual Handle Alloc(size_t size, Context ctx) = 0;
+  /*!
+   * \brief Map the shared memory another process allocated on the
+   *  kCPUShared context, given by its shared_pid and shared_id.
+   * \param shared_pid Id of the process that allocated the memory.
+   * \param shared_id Id of the memory within that process.
+   * \param size Size of the memory in bytes.
+   * \return Handle struct, freed with Free.
+   */
+  virtual Handle AttachShared(int shared_pid, int shared_id, size_t size) = 0;
   /*!
    * \brief Free storage.
    * \param handle Handle struect.
@@ -73,6 +111,28 @@ class Storage {
    * \param handle Handle struct.
    */
   virtual void DirectFree(Handle handle) = 0;
+  /*!
+   * \brief Get the memory allocation statistics of a context.
+   *  All counters are zero for a context that has never been allocated on.
+   * \param ctx Context information about the device and ID.
+   * \return The statistics.
+   */
+  virtual Stats GetStats(Context ctx) = 0;
+  /*!
+   * \brief Page-lock a host memory region allocated by the user, so that
+   *  the copies between it and the gpus are done by DMA without staging
+   *  through a driver buffer. The region must stay allocated until it is
+   *  unregistered. Regions still registered are unregistered when the
+   *  storage is destroyed. Regions are only tracked when compiled without cuda.
+   * \param ptr Start of the region.
+   * \param size Size of the region in bytes.
+   */
+  virtual void RegisterHostMemory(void* ptr, size_t size) = 0;
+  /*!
+   * \brief Unregister a host memory region registered by RegisterHostMemory.
+   * \param ptr Start of the region, as registered.
+   */
+  virtual void UnregisterHostMemory(void* ptr) = 0;
   /*!
    * \brief Destructor.
    */
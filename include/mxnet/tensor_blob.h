@@ -347,7 +347,8 @@ class TBlob {
         {2, {2, 16, 1}},  // Float16
         {3, {1,  8, 1}},  // UInt8
         {4, {0, 32, 1}},  // Int32
-        {5, {0,  8, 1}}   // Int8
+        {5, {0,  8, 1}},  // Int8
+        {6, {0, 64, 1}}   // Int64
       };
     return MSHADOW_DTYPE_TO_DLPACK_DTYPE[type_flag];
   }
@@ -33,6 +33,13 @@ DEBUG = 0
 # whether compiler with profiler
 USE_PROFILER =
 
+# whether the profiler traces the kernels and copies on the gpus with CUPTI,
+# needs USE_PROFILER and USE_CUDA, CUPTI is searched under USE_CUDA_PATH/extras/CUPTI
+USE_CUPTI = 0
+
+# whether the dependency engine guards its variables with spin locks instead of mutexes
+USE_ENGINE_SPINLOCK = 1
+
 # the additional link flags you want to add
 ADD_LDFLAGS =
 
@@ -54,6 +61,13 @@ USE_CUDA_PATH = NONE
 # whether use CuDNN R3 library
 USE_CUDNN = 0
 
+# whether use NCCL for the nccl kvstore, NCCL 2 is required
+USE_NCCL = 0
+
+# add the path to NCCL library to link and compile flag
+# if you have already add them to environment variable, leave it as NONE
+USE_NCCL_PATH = NONE
+
 # whether use cuda runtime compiling for writing kernels in native language (i.e. Python)
 USE_NVRTC = 0
 
@@ -83,6 +97,9 @@ USE_MKL2017_EXPERIMENTAL = 0
 # whether use NNPACK library
 USE_NNPACK = 0
 
+# whether use libnuma to bind CPU contexts and workers to NUMA nodes
+USE_NUMA = 0
+
 # choose the version of blas you want to use
 # can be: mkl, blas, atlas, openblas
 # in default use atlas for linux while apple for osx
@@ -130,6 +147,10 @@ endif
 # whether or not to enable multi-machine supporting
 USE_DIST_KVSTORE = 0
 
+# whether to build ps-lite with its RDMA transport over InfiniBand verbs,
+# selected at runtime by DMLC_ENABLE_RDMA=1. Prerequisite USE_DIST_KVSTORE=1
+USE_IBVERBS = 0
+
 # whether or not allow to read and write HDFS directly. If yes, then hadoop is
 # required
 USE_HDFS = 0
@@ -26,8 +26,11 @@
 #include <mxnet/base.h>
 #include <mxnet/ndarray.h>
 #include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
 #include "cv_api.h"
 #include "../../src/c_api/c_api_error.h"
+#include "../../src/engine/openmp.h"
 
 
 using namespace mxnet;
@@ -135,6 +138,53 @@ MXNET_DLL int MXCVResize(NDArrayHandle src, const mx_uint w, const mx_uint h,
   API_END();
 }
 
+MXNET_DLL int MXCVImdecodeResizeBatch(const unsigned char **imgs,
+                                      const mx_uint *lens,
+                                      const mx_uint num_imgs,
+                                      const int flag,
+                                      const int interpolation,
+                                      NDArrayHandle out) {
+  API_BEGIN();
+  NDArray ndout = *static_cast<NDArray*>(out);
+  CHECK_GE(flag, 0) << "flag must be 0 (grayscale) or 1 (colored).";
+  CHECK_EQ(ndout.shape().ndim(), 4) << "the batch must be in (num, height, width, channels)";
+  CHECK_EQ(ndout.shape()[0], num_imgs);
+  CHECK_EQ(ndout.shape()[3], flag == 0 ? 1 : 3);
+  CHECK_EQ(ndout.ctx().dev_mask(), cpu::kDevMask);
+  CHECK_EQ(ndout.dtype(), mshadow::kUint8);
+  const int h = ndout.shape()[1], w = ndout.shape()[2];
+  const int type = flag == 0 ? CV_8U : CV_8UC3;
+  // the buffers are copied since the caller may free them before the op runs
+  auto bufs = std::make_shared<std::vector<std::vector<unsigned char> > >(num_imgs);
+  for (mx_uint i = 0; i < num_imgs; ++i) {
+    (*bufs)[i].assign(imgs[i], imgs[i] + lens[i]);
+  }
+  Engine::Get()->PushSync([=](RunContext ctx){
+      ndout.CheckAndAlloc();
+      unsigned char *dptr = ndout.data().dptr<unsigned char>();
+      const size_t img_size = static_cast<size_t>(h) * w * (flag == 0 ? 1 : 3);
+      std::vector<int> failed(num_imgs, 0);
+      const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+      #pragma omp parallel for num_threads(omp_threads) schedule(dynamic)
+      for (int i = 0; i < static_cast<int>(num_imgs); ++i) {
+        cv::Mat buf(1, static_cast<int>((*bufs)[i].size()), CV_8U, (*bufs)[i].data());
+        cv::Mat dst(h, w, type, dptr + i * img_size);
+        cv::Mat img = cv::imdecode(buf, flag);
+        if (img.empty()) {
+          failed[i] = 1;
+        } else if (img.rows == h && img.cols == w) {
+          img.copyTo(dst);
+        } else {
+          cv::resize(img, dst, cv::Size(w, h), 0, 0, interpolation);
+        }
+      }
+      for (mx_uint i = 0; i < num_imgs; ++i) {
+        CHECK(!failed[i]) << "Failed to decode image " << i << " of the batch";
+      }
+    }, ndout.ctx(), {}, {ndout.var()});
+  API_END();
+}
+
 MXNET_DLL int MXCVcopyMakeBorder(NDArrayHandle src,
                                  const int top,
                                  const int bot,
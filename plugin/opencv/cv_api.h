@@ -40,6 +40,24 @@ MXNET_DLL int MXCVResize(
   const int interpolation,
   NDArrayHandle *out);
 
+/*!
+ * \brief decode a batch of png or jpg images and resize them to the height
+ *  and width of out, as one engine operation decoding the images in parallel
+ * \param imgs the encoded images, copied before the function returns
+ * \param lens the sizes of the encoded images
+ * \param num_imgs the number of images
+ * \param flag 0 to decode to grayscale, 1 to decode to BGR
+ * \param interpolation the interpolation of cv::resize
+ * \param out a uint8 cpu array of shape (num_imgs, height, width, channels)
+ */
+MXNET_DLL int MXCVImdecodeResizeBatch(
+  const unsigned char **imgs,
+  const mx_uint *lens,
+  const mx_uint num_imgs,
+  const int flag,
+  const int interpolation,
+  NDArrayHandle out);
+
 MXNET_DLL int MXCVcopyMakeBorder(
   NDArrayHandle src,
   const int top,
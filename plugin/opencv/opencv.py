@@ -71,6 +71,40 @@ def resize(src, size, interpolation=cv2.INTER_LINEAR):
                                interpolation, ctypes.byref(hdl)))
     return mx.nd.NDArray(hdl)
 
+def imdecode_resize_batch(str_imgs, size, flag=1, interpolation=cv2.INTER_LINEAR, out=None):
+    """Decode a list of images from str buffers and resize them into one batch.
+    The images are decoded in parallel by one operation.
+
+    Parameters
+    ----------
+    str_imgs : list of str
+        str buffers read from image files
+    size : tuple
+        target size in (width, height)
+    flag : int
+        same as flag for cv2.imdecode
+    interpolation : int
+        same as interpolation for cv2.imresize
+    out : NDArray, optional
+        uint8 array of shape (len(str_imgs), height, width, channels) to write to
+
+    Returns
+    -------
+    batch : NDArray
+        decoded images in (num, height, width, channels)
+        with BGR color channel order
+    """
+    channels = 1 if flag == 0 else 3
+    if out is None:
+        out = mx.nd.empty((len(str_imgs), size[1], size[0], channels), dtype='uint8')
+    num = len(str_imgs)
+    bufs = (ctypes.c_char_p * num)(*str_imgs)
+    lens = (mx_uint * num)(*[len(img) for img in str_imgs])
+    check_call(_LIB.MXCVImdecodeResizeBatch(ctypes.cast(bufs, ctypes.POINTER(ctypes.c_char_p)),
+                                            lens, mx_uint(num), flag, interpolation,
+                                            out.handle))
+    return out
+
 def copyMakeBorder(src, top, bot, left, right, border_type=cv2.BORDER_CONSTANT, value=0):
     """Pad image border
     Wrapper for cv2.copyMakeBorder that uses mx.nd.NDArray
@@ -29,8 +29,11 @@
 #include <dmlc/omp.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
+#include <algorithm>
 #include <string>
+#include <sstream>
 #include <memory>
+#include <vector>
 #include <unity/lib/image_util.hpp>
 #include <unity/lib/gl_sframe.hpp>
 #include <unity/lib/gl_sarray.hpp>
@@ -210,7 +213,141 @@ class SFrameDataIter : public SFrameIterBase {
   typedef SFrameIterBase Parent;
 };  // class SFrameDataIter
 
+struct SFrameColumnParam : public dmlc::Parameter<SFrameColumnParam> {
+  /*! \brief sframe path */
+  std::string path_sframe;
+  std::string data_fields;
+  std::string label_field;
+  int num_reader_threads;
+  DMLC_DECLARE_PARAMETER(SFrameColumnParam) {
+    DMLC_DECLARE_FIELD(path_sframe).set_default("")
+    .describe("Dataset Param: path to dataset sframe");
+    DMLC_DECLARE_FIELD(data_fields).set_default("data")
+    .describe("Dataset Param: comma separated data columns in sframe, "
+              "numeric or vector columns concatenated in this order");
+    DMLC_DECLARE_FIELD(label_field).set_default("label")
+    .describe("Dataset Param: label column in sframe");
+    DMLC_DECLARE_FIELD(num_reader_threads).set_default(4).set_lower_bound(1)
+    .describe("Number of threads reading the columns of a batch in parallel");
+  }
+};  // struct SFrameColumnParam
+
+/*!
+ * \brief iterator reading batches column by column from the columnar storage
+ *  of a sframe. The columns of a batch are read in parallel, every column
+ *  is read over the rows of the batch with one range iterator and written
+ *  straight to its slice of the batch.
+ */
+class SFrameColumnIter : public IIterator<TBlobBatch> {
+ public:
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    graphlab::gl_sframe sframe(param_.path_sframe);
+    std::stringstream ss(param_.data_fields);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+      if (!field.empty()) columns_.push_back(sframe[field]);
+    }
+    CHECK(!columns_.empty()) << "data_fields must name at least one column";
+    columns_.push_back(sframe[param_.label_field]);
+    num_rows_ = sframe.size();
+    CHECK_GT(num_rows_, 0U) << "Empty sframe " << param_.path_sframe;
+    // the widths of the columns are the ones of their first row, the data
+    // columns are concatenated and the label column is on its own
+    size_t data_width = 0;
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      widths_.push_back(Width_(columns_[i][0]));
+      offsets_.push_back(i + 1 < columns_.size() ? data_width : 0);
+      if (i + 1 < columns_.size()) data_width += widths_.back();
+    }
+    const index_t batch_size = batch_param_.batch_size;
+    data_.resize(mshadow::Shape2(batch_size, data_width), mshadow::kFloat32);
+    if (widths_.back() == 1) {
+      label_.resize(mshadow::Shape1(batch_size), mshadow::kFloat32);
+    } else {
+      label_.resize(mshadow::Shape2(batch_size, widths_.back()), mshadow::kFloat32);
+    }
+    out_.data.clear();
+    out_.data.push_back(data_);
+    out_.data.push_back(label_);
+    out_.batch_size = batch_size;
+    this->BeforeFirst();
+  }
+
+  void BeforeFirst() override {
+    head_ = 0;
+  }
+
+  bool Next() override {
+    if (head_ >= num_rows_) return false;
+    const size_t batch_size = batch_param_.batch_size;
+    const size_t end = std::min(head_ + batch_size, num_rows_);
+    const size_t num_read = end - head_;
+    // the rows looped over to fill the last batch
+    const size_t num_round = batch_param_.round_batch ?
+        std::min(batch_size - num_read, num_rows_) : 0;
+    std::vector<int> failed(columns_.size(), 0);
+    #pragma omp parallel for num_threads(param_.num_reader_threads) schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+      const bool is_label = i + 1 == static_cast<int>(columns_.size());
+      float *dst = is_label ? label_.dptr<float>() : data_.dptr<float>() + offsets_[i];
+      const size_t stride = is_label ? widths_[i] : data_.shape_[1];
+      failed[i] = !ReadColumn_(columns_[i], head_, end, widths_[i], stride, dst) ||
+          !ReadColumn_(columns_[i], 0, num_round, widths_[i], stride,
+                       dst + num_read * stride);
+    }
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      CHECK(!failed[i]) << "The rows of column " << i
+                        << " do not all have the width of its first row";
+    }
+    out_.num_batch_padd = batch_size - num_read - num_round;
+    head_ = end;
+    return true;
+  }
+
+  const TBlobBatch &Value() const override {
+    return out_;
+  }
+
+ private:
+  /*! \brief number of floats of a numeric or vector value */
+  static size_t Width_(const graphlab::flexible_type& value) {
+    return value.get_type() == graphlab::flex_type_enum::VECTOR ?
+        value.get<graphlab::flex_vec>().size() : 1;
+  }
+  /*! \brief read rows [begin, end) of a column to dst, one row every stride floats */
+  static bool ReadColumn_(const graphlab::gl_sarray& column, size_t begin, size_t end,
+                          size_t width, size_t stride, float *dst) {
+    if (begin >= end) return true;
+    for (const graphlab::flexible_type& value : column.range_iterator(begin, end)) {
+      if (value.get_type() == graphlab::flex_type_enum::VECTOR) {
+        const graphlab::flex_vec& vec = value.get<graphlab::flex_vec>();
+        if (vec.size() != width) return false;
+        for (size_t j = 0; j < width; ++j) dst[j] = static_cast<float>(vec[j]);
+      } else {
+        if (width != 1) return false;
+        dst[0] = static_cast<float>(value.to<graphlab::flex_float>());
+      }
+      dst += stride;
+    }
+    return true;
+  }
+  /*! \brief parameters */
+  SFrameColumnParam param_;
+  BatchParam batch_param_;
+  /*! \brief the data columns followed by the label column */
+  std::vector<graphlab::gl_sarray> columns_;
+  /*! \brief width of every column and offset of the data columns in a row */
+  std::vector<size_t> widths_, offsets_;
+  size_t num_rows_, head_;
+  /*! \brief output batch */
+  TBlobContainer data_, label_;
+  TBlobBatch out_;
+};  // class SFrameColumnIter
+
 DMLC_REGISTER_PARAMETER(SFrameParam);
+DMLC_REGISTER_PARAMETER(SFrameColumnParam);
 
 MXNET_REGISTER_IO_ITER(SFrameImageIter)
 .describe("Naive SFrame image iterator prototype")
@@ -237,6 +374,14 @@ MXNET_REGISTER_IO_ITER(SFrameDataIter)
               new SFrameDataIter()));
     });
 
+MXNET_REGISTER_IO_ITER(SFrameColumnIter)
+.describe("SFrame iterator reading the numeric and vector columns of a batch in parallel")
+.add_arguments(SFrameColumnParam::__FIELDS__())
+.add_arguments(BatchParam::__FIELDS__())
+.add_arguments(PrefetcherParam::__FIELDS__())
+.set_body([]() {
+    return new PrefetcherIter(new SFrameColumnIter());
+    });
 
 }  // namespace io
 }  // namespace mxnet
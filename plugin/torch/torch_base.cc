@@ -60,7 +60,10 @@ void TorchState::SetStream(mshadow::Stream<mshadow::cpu>* s) {
 #if MXNET_USE_CUDA
 template<>
 void TorchState::SetStream(mshadow::Stream<mshadow::gpu>* s) {
-  CudaState()->currentStream = mshadow::Stream<gpu>::GetStream(s);
+  // torch runs its kernels on the stream of the mxnet RunContext
+  THCState* state = CudaState();
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  if (state->currentStream != stream) state->currentStream = stream;
 }
 #endif  // MXNET_USE_CUDA
 }  // namespace mxnet
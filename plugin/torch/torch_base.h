@@ -54,13 +54,15 @@ class TorchState {
 
 #if MXNET_USE_CUDA
   THCState* CudaState() {
+    // the state of cutorch lives as long as the lua state, look it up once
+    if (cuda_state_ != nullptr) return cuda_state_;
     lua_getglobal(L, "cutorch");
     CHECK(!lua_isnil(L, -1));
     lua_getfield(L, -1, "_state");
     CHECK(!lua_isnil(L, -1));
-    THCState* state = reinterpret_cast<THCState*>(lua_touserdata(L, -1));
+    cuda_state_ = reinterpret_cast<THCState*>(lua_touserdata(L, -1));
     lua_pop(L, 2);
-    return state;
+    return cuda_state_;
   }
 #endif  // MXNET_USE_CUDA
 
@@ -111,6 +113,11 @@ class TorchState {
     lua_pop(L, 2);
     return 0;
   }
+
+#if MXNET_USE_CUDA
+ private:
+  THCState* cuda_state_ = nullptr;
+#endif  // MXNET_USE_CUDA
 };
 
 typedef void* THGeneralTensor;
@@ -207,7 +214,29 @@ class TorchTensor {
     }
   }
 
+  /*! \brief whether tensor already wraps the memory of blob */
+  static bool Wraps(THGeneralTensor tensor, const TBlob& blob) {
+    switch (blob.dev_mask()) {
+      case cpu::kDevMask: {
+        THFloatStorage* storage = static_cast<THFloatTensor*>(tensor)->storage;
+        return storage != NULL && storage->data == blob.dptr_ &&
+            storage->size == static_cast<ptrdiff_t>(blob.Size());
+      }
+#if MXNET_USE_CUDA
+      case gpu::kDevMask: {
+        THCudaStorage* storage = static_cast<THCudaTensor*>(tensor)->storage;
+        return storage != NULL && storage->data == blob.dptr_ &&
+            storage->size == static_cast<ptrdiff_t>(blob.Size());
+      }
+#endif
+      default:
+        return false;
+    }
+  }
+
   static void SetInternal(TorchState* torchState, THGeneralTensor tensor, const TBlob& blob) {
+    // parameters usually keep their memory, the storage is then left as is
+    if (Wraps(tensor, blob)) return;
     size_t size = blob.Size();
     switch (blob.dev_mask()) {
       case cpu::kDevMask: {
@@ -264,6 +293,48 @@ class TorchTensor {
     return res;
   }
 
+  /*!
+   * \brief the torch tensors wrapping a list of TBlobs, as pushed by
+   *  TBlobVectorAsTable. The pushed value is kept in the lua registry and
+   *  pushed again while the TBlobs keep their memory and shapes, instead of
+   *  wrapping all of them at every call.
+   */
+  class TableCache {
+   public:
+    std::vector<THGeneralTensor> Push(TorchState* torchState,
+                                      const std::vector<TBlob>::const_iterator begin,
+                                      const std::vector<TBlob>::const_iterator end) {
+      lua_State* L = torchState->L;
+      if (ref_ != LUA_NOREF && Matches(begin, end)) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref_);
+        return tensors_;
+      }
+      if (ref_ != LUA_NOREF) luaL_unref(L, LUA_REGISTRYINDEX, ref_);
+      tensors_ = TBlobVectorAsTable(torchState, begin, end);
+      lua_pushvalue(L, -1);
+      ref_ = luaL_ref(L, LUA_REGISTRYINDEX);
+      blobs_.assign(begin, end);
+      return tensors_;
+    }
+
+   private:
+    bool Matches(const std::vector<TBlob>::const_iterator begin,
+                 const std::vector<TBlob>::const_iterator end) const {
+      if (static_cast<size_t>(end - begin) != blobs_.size()) return false;
+      for (size_t i = 0; i < blobs_.size(); ++i) {
+        const TBlob& blob = *(begin + i);
+        if (blob.dptr_ != blobs_[i].dptr_ || blob.shape_ != blobs_[i].shape_ ||
+            blob.dev_mask() != blobs_[i].dev_mask() || !Wraps(tensors_[i], blob)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    int ref_ = LUA_NOREF;
+    std::vector<TBlob> blobs_;
+    std::vector<THGeneralTensor> tensors_;
+  };
+
   static void CopyIfDifferent(TorchState* torchState, TBlob dst, THGeneralTensor th_dst) {
     lua_State* L = torchState->L;
     if (luaT_isudata(L, -1, TorchTensor::TensorType(cpu::kDevMask))) {
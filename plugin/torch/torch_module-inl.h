@@ -66,6 +66,9 @@ class TorchModuleOp : public Operator {
   TorchModuleParam param_;
   TorchState* torchState_;
   int lua_reference_;
+  // torch tensors wrapping the arrays of the previous calls
+  TorchTensor::TableCache fwd_in_, fwd_out_;
+  TorchTensor::TableCache bwd_in_, bwd_out_, bwd_out_grad_, bwd_in_grad_;
 
  public:
   explicit TorchModuleOp(TorchModuleParam p, TorchState* torchState) : torchState_(torchState) {
@@ -127,8 +130,7 @@ class TorchModuleOp : public Operator {
     lua_rawgeti(L, LUA_REGISTRYINDEX, lua_reference_);
 
     std::vector<THGeneralTensor> th_output =
-      TorchTensor::TBlobVectorAsTable(torchState_, out_data.begin(),
-                                      out_data.begin() + param_.num_outputs);
+      fwd_out_.Push(torchState_, out_data.begin(), out_data.begin() + param_.num_outputs);
     // set the output field
     lua_setfield(L, -2, "output");
     // set the parameters
@@ -156,8 +158,7 @@ class TorchModuleOp : public Operator {
     // | self | updateOutput
     lua_pushvalue(L, -2);
     // | self | updateOutput | self
-    TorchTensor::TBlobVectorAsTable(torchState_, in_data.begin(),
-                                    in_data.begin() + param_.num_data);
+    fwd_in_.Push(torchState_, in_data.begin(), in_data.begin() + param_.num_data);
     // | self | updateOutput | self | inputs
     int err = lua_pcall(L, 2, 1, 0);  // doesn't need the output
     CHECK_EQ(err, 0) << lua_tostring(L, -1);
@@ -183,11 +184,10 @@ class TorchModuleOp : public Operator {
     mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
     torchState_->SetStream(s);
     lua_rawgeti(L, LUA_REGISTRYINDEX, lua_reference_);
-    TorchTensor::TBlobVectorAsTable(torchState_, out_data.begin(), out_data.end());
+    bwd_out_.Push(torchState_, out_data.begin(), out_data.end());
     lua_setfield(L, -2, "output");
     std::vector<THGeneralTensor> th_grad =
-      TorchTensor::TBlobVectorAsTable(torchState_, in_grad.begin(),
-                                      in_grad.begin() + param_.num_data);
+      bwd_in_grad_.Push(torchState_, in_grad.begin(), in_grad.begin() + param_.num_data);
     lua_setfield(L, -2, "gradInput");
     if (param_.num_params != 0) {
       // get the parameters into the stack
@@ -222,9 +222,8 @@ class TorchModuleOp : public Operator {
     lua_getfield(L, -1, "zeroGradParameters");
     lua_pushvalue(L, -2);
     CHECK_EQ(lua_pcall(L, 1, 0, 0), 0);
-    TorchTensor::TBlobVectorAsTable(torchState_, in_data.begin(),
-                                    in_data.begin() + param_.num_data);
-    TorchTensor::TBlobVectorAsTable(torchState_, out_grad.begin(), out_grad.end());
+    bwd_in_.Push(torchState_, in_data.begin(), in_data.begin() + param_.num_data);
+    bwd_out_grad_.Push(torchState_, out_grad.begin(), out_grad.end());
     // call
     lua_getfield(L, -3, "accGradParameters");
     lua_pushvalue(L, -4);
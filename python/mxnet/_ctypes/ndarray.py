@@ -105,10 +105,14 @@ def _imperative_invoke(handle, ndargs, keys, vals, out):
 class CachedOp(object):
     """Cached operator handle."""
     __slots__ = ["handle"]
-    def __init__(self, sym):
+    def __init__(self, sym, flags=()):
         self.handle = CachedOpHandle()
-        check_call(_LIB.MXCreateCachedOp(
+        flags = dict(flags)
+        check_call(_LIB.MXCreateCachedOpEx(
             sym.handle,
+            ctypes.c_int(len(flags)),
+            c_array(ctypes.c_char_p, [c_str(key) for key in flags.keys()]),
+            c_array(ctypes.c_char_p, [c_str(str(val)) for val in flags.values()]),
             ctypes.byref(self.handle)))
 
     def __del__(self):
@@ -224,7 +224,8 @@ def mark_variables(variables, gradients, grad_reqs='write'):
         c_array(NDArrayHandle, gradient_handles)))
 
 
-def backward(heads, head_grads=None, retain_graph=False, train_mode=True): #pylint: disable=redefined-outer-name
+def backward(heads, head_grads=None, retain_graph=False, train_mode=True, #pylint: disable=redefined-outer-name
+             create_graph=False):
     """Compute the gradients of heads w.r.t previously marked variables.
 
     Parameters
@@ -233,8 +234,15 @@ def backward(heads, head_grads=None, retain_graph=False, train_mode=True): #pyli
         Output NDArray(s)
     head_grads: NDArray or list of NDArray or None
         Gradients with respect to heads.
+    retain_graph: bool, optional
+        Whether to retain the computation graph for another backward pass on
+        the same graph. Otherwise the recorded arrays are released during the
+        backward pass, each one after the last operator reading it has run.
     train_mode: bool, optional
         Whether to do backward for training or predicting.
+    create_graph: bool, optional
+        Whether to record the backward pass, so that the gradients can be
+        differentiated again. The computation graph is then retained.
     """
     if isinstance(heads, NDArray):
         assert head_grads is None or isinstance(head_grads, NDArray)
@@ -246,27 +254,30 @@ def backward(heads, head_grads=None, retain_graph=False, train_mode=True): #pyli
         output_handles.append(arr.handle)
 
     if head_grads is None:
-        check_call(_LIB.MXAutogradBackwardEx(
+        ograd_handles = ctypes.c_void_p(0)
+    else:
+        ograd_handles = []
+        for arr in head_grads:
+            if arr is not None:
+                ograd_handles.append(arr.handle)
+            else:
+                ograd_handles.append(NDArrayHandle(0))
+        assert len(ograd_handles) == len(output_handles), \
+            "heads and head_grads must have the same length"
+        ograd_handles = c_array(NDArrayHandle, ograd_handles)
+
+    if create_graph:
+        check_call(_LIB.MXAutogradBackwardCreateGraph(
             len(output_handles),
             c_array(NDArrayHandle, output_handles),
-            ctypes.c_void_p(0),
-            ctypes.c_int(retain_graph),
+            ograd_handles,
             ctypes.c_int(train_mode)))
         return
 
-    ograd_handles = []
-    for arr in head_grads:
-        if arr is not None:
-            ograd_handles.append(arr.handle)
-        else:
-            ograd_handles.append(NDArrayHandle(0))
-    assert len(ograd_handles) == len(output_handles), \
-        "heads and head_grads must have the same length"
-
     check_call(_LIB.MXAutogradBackwardEx(
         len(output_handles),
         c_array(NDArrayHandle, output_handles),
-        c_array(NDArrayHandle, ograd_handles),
+        ograd_handles,
         ctypes.c_int(retain_graph),
         ctypes.c_int(train_mode)))
 
@@ -0,0 +1,337 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# coding: utf-8
+"""Quantization of float models to int8 for inference."""
+from __future__ import absolute_import
+
+import ctypes
+import json
+import logging
+
+import numpy as np
+
+from ..base import _LIB, check_call, c_array, c_str, mx_uint, SymbolHandle
+from ..context import cpu
+from ..symbol import Symbol
+from .. import ndarray
+
+
+def _quantize_params(qsym, params):
+    """Quantize the parameters replaced by int8 variables in the quantized symbol.
+
+    Parameters
+    ----------
+    qsym : Symbol
+        Quantized symbol returned by `_quantize_symbol`.
+    params : dict of str to NDArray
+        The float parameters.
+
+    Returns
+    -------
+    dict of str to NDArray
+        The parameters of qsym, the int8 values of a parameter `w` and its range are
+        stored as `w_quantize`, `w_min` and `w_max`.
+    """
+    quantized_params = {}
+    for name in qsym.list_arguments():
+        if name.endswith('_quantize') and name[:-len('_quantize')] in params:
+            original = name[:-len('_quantize')]
+            param = params[original]
+            val, vmin, vmax = ndarray.contrib.quantize(param, ndarray.min(param),
+                                                       ndarray.max(param), out_type='int8')
+            quantized_params[name] = val
+            quantized_params[original + '_min'] = vmin
+            quantized_params[original + '_max'] = vmax
+        elif name in params:
+            quantized_params[name] = params[name]
+    return quantized_params
+
+
+def _quantize_symbol(sym, excluded_symbols=None, offline_params=None):
+    """Replace the supported operators of a symbol by their int8 versions.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float symbol.
+    excluded_symbols : list of str
+        Names of the layers kept in float.
+    offline_params : list of str
+        Names of the parameters quantized offline by `_quantize_params`.
+
+    Returns
+    -------
+    Symbol
+        The quantized symbol.
+    """
+    excluded_symbols = excluded_symbols if excluded_symbols is not None else []
+    offline_params = offline_params if offline_params is not None else []
+    out = SymbolHandle()
+    check_call(_LIB.MXQuantizeSymbol(sym.handle, ctypes.byref(out),
+                                     mx_uint(len(excluded_symbols)),
+                                     c_array(ctypes.c_char_p,
+                                             [c_str(s) for s in excluded_symbols]),
+                                     mx_uint(len(offline_params)),
+                                     c_array(ctypes.c_char_p,
+                                             [c_str(s) for s in offline_params])))
+    return Symbol(out)
+
+
+def _calibrate_quantized_sym(qsym, th_dict):
+    """Set the calibrated ranges of the requantize operators of a quantized symbol.
+
+    Parameters
+    ----------
+    qsym : Symbol
+        The quantized symbol.
+    th_dict : dict of str to (float, float)
+        The range of the output of every calibrated float layer, keyed by the name of
+        the output, such as `conv0_output`.
+
+    Returns
+    -------
+    Symbol
+        A copy of qsym with the calibrated ranges.
+    """
+    if th_dict is None or len(th_dict) == 0:
+        return qsym
+    layer_names = list(th_dict.keys())
+    low_quantiles = [th_dict[k][0] for k in layer_names]
+    high_quantiles = [th_dict[k][1] for k in layer_names]
+    out = SymbolHandle()
+    check_call(_LIB.MXSetCalibTableToQuantizedSymbol(qsym.handle,
+                                                     mx_uint(len(layer_names)),
+                                                     c_array(ctypes.c_char_p,
+                                                             [c_str(k) for k in layer_names]),
+                                                     c_array(ctypes.c_float, low_quantiles),
+                                                     c_array(ctypes.c_float, high_quantiles),
+                                                     ctypes.byref(out)))
+    return Symbol(out)
+
+
+def _calib_layer_names(qsym):
+    """Names of the outputs of the float layers followed by a requantize operator."""
+    suffix = '_requantize'
+    names = []
+    for node in json.loads(qsym.tojson())['nodes']:
+        if node['op'] == '_contrib_requantize' and node['name'].endswith(suffix):
+            names.append(node['name'][:-len(suffix)] + '_output')
+    return names
+
+
+def _run_calib_batches(sym, arg_params, aux_params, ctx, calib_data, num_calib_examples,
+                       callback):
+    """Run the float symbol on the calibration batches, calling callback(name, array)
+    with the outputs of every layer.
+
+    Returns
+    -------
+    int
+        The number of examples seen.
+    """
+    shapes = {d[0]: d[1] for d in calib_data.provide_data}
+    if calib_data.provide_label is not None:
+        shapes.update({d[0]: d[1] for d in calib_data.provide_label})
+    shapes = {k: v for k, v in shapes.items() if k in sym.list_arguments()}
+    exe = sym.simple_bind(ctx, grad_req='null', **shapes)
+    exe.copy_params_from(arg_params, aux_params, allow_extra_params=True)
+
+    def monitor(name, handle):
+        """Wrap the output array of the executor for the callback."""
+        name = name.decode() if isinstance(name, bytes) else name
+        callback(name, ndarray.NDArray(handle, writable=False))
+    exe.set_monitor_callback(monitor)
+
+    calib_data.reset()
+    num_examples = 0
+    for batch in calib_data:
+        for desc, array in zip(calib_data.provide_data, batch.data):
+            array.copyto(exe.arg_dict[desc[0]])
+        exe.forward(is_train=False)
+        ndarray.waitall()
+        num_examples += batch.data[0].shape[0] - batch.pad
+        if num_calib_examples is not None and num_examples >= num_calib_examples:
+            break
+    return num_examples
+
+
+def _get_optimal_threshold(hist, bin_width, num_quantized_bins=128):
+    """Return the threshold of the magnitudes minimizing the KL divergence between
+    their distribution and its quantization to num_quantized_bins levels.
+
+    Parameters
+    ----------
+    hist : numpy.ndarray
+        Histogram of the magnitudes of the values, starting at 0.
+    bin_width : float
+        Width of the bins of hist.
+    num_quantized_bins : int
+        Number of levels of the magnitudes of the quantized values.
+    """
+    hist = hist.astype(np.float64)
+    num_bins = hist.size
+    if num_bins <= num_quantized_bins:
+        return num_bins * bin_width
+    best_kl = np.inf
+    best_i = num_bins
+    for i in range(num_quantized_bins, num_bins + 1):
+        # reference distribution, the values beyond the threshold are clipped to it
+        p = hist[:i].copy()
+        p[i - 1] += hist[i:].sum()
+        if p.sum() == 0:
+            continue
+        # merge the bins to the quantized levels, and spread every level
+        # uniformly over its nonempty bins
+        q = np.zeros(i)
+        edges = np.linspace(0, i, num_quantized_bins + 1).astype(np.int64)
+        for start, stop in zip(edges[:-1], edges[1:]):
+            chunk = hist[start:stop]
+            nonzero = chunk != 0
+            count = nonzero.sum()
+            if count > 0:
+                q[start:stop][nonzero] = chunk.sum() / count
+        p /= p.sum()
+        if q.sum() == 0:
+            continue
+        q /= q.sum()
+        mask = p > 0
+        if np.any(q[mask] == 0):
+            continue
+        kl = np.sum(p[mask] * np.log(p[mask] / q[mask]))
+        if kl < best_kl:
+            best_kl = kl
+            best_i = i
+    return (best_i + 0.5) * bin_width
+
+
+def _collect_layer_ranges(sym, arg_params, aux_params, ctx, calib_data, num_calib_examples,
+                          layer_names, calib_mode, num_bins, logger):
+    """Collect the range of the outputs of the layers on the calibration data.
+
+    Returns
+    -------
+    dict of str to (float, float)
+        The calibrated range of every layer output.
+    """
+    layer_names = set(layer_names)
+    min_max = {}
+
+    def collect_min_max(name, array):
+        """Track the smallest and largest values of every output."""
+        if name not in layer_names:
+            return
+        vmin = ndarray.min(array).asscalar()
+        vmax = ndarray.max(array).asscalar()
+        if name in min_max:
+            vmin = min(vmin, min_max[name][0])
+            vmax = max(vmax, min_max[name][1])
+        min_max[name] = (vmin, vmax)
+
+    num_examples = _run_calib_batches(sym, arg_params, aux_params, ctx, calib_data,
+                                      num_calib_examples, collect_min_max)
+    logger.info('Collected the ranges of %d layers from %d examples',
+                len(min_max), num_examples)
+    if calib_mode == 'naive':
+        return min_max
+
+    # histograms of the magnitudes over the largest magnitude of every output
+    hists = {}
+
+    def collect_hist(name, array):
+        """Accumulate the histogram of the magnitudes of every output."""
+        if name not in min_max:
+            return
+        r = max(abs(min_max[name][0]), abs(min_max[name][1]))
+        hist, _ = np.histogram(np.abs(array.asnumpy()), bins=num_bins, range=(0, r))
+        hists[name] = hists[name] + hist if name in hists else hist
+
+    _run_calib_batches(sym, arg_params, aux_params, ctx, calib_data, num_calib_examples,
+                       collect_hist)
+    th_dict = {}
+    for name, hist in hists.items():
+        r = max(abs(min_max[name][0]), abs(min_max[name][1]))
+        if r == 0:
+            th_dict[name] = min_max[name]
+            continue
+        th = min(_get_optimal_threshold(hist, r / num_bins), r)
+        th_dict[name] = (-th, th)
+        logger.debug('Layer %s range %s, threshold %f', name, str(min_max[name]), th)
+    logger.info('Computed the entropy thresholds of %d layers', len(th_dict))
+    return th_dict
+
+
+def quantize_model(sym, arg_params, aux_params, ctx=cpu(), excluded_sym_names=None,
+                   calib_mode='none', calib_data=None, num_calib_examples=None,
+                   num_calib_bins=2048, logger=logging):
+    """Convert a float model to a model running the supported layers on int8.
+
+    The Convolution, FullyConnected, Pooling and relu Activation layers are replaced
+    by their int8 versions. The weights and biases are quantized offline. The outputs
+    of the int8 convolutions and fully connected layers are converted back to int8,
+    with the range of their values computed at every batch, or with a range
+    calibrated once on sample data.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float symbol.
+    arg_params : dict of str to NDArray
+        The float arguments.
+    aux_params : dict of str to NDArray
+        The auxiliary states, kept in float.
+    ctx : Context
+        The context running the float model on the calibration data.
+    excluded_sym_names : list of str
+        Names of the layers kept in float, the first convolution of a network is
+        often more accurate in float.
+    calib_mode : str
+        'none' computes the ranges at every batch. 'naive' uses the smallest and
+        largest values of the float layer outputs on calib_data. 'entropy' clips the
+        magnitudes at the threshold minimizing the KL divergence between the
+        distribution of the outputs and its int8 quantization, which is more accurate
+        on outputs with long tails.
+    calib_data : DataIter
+        The calibration data, required by the 'naive' and 'entropy' modes.
+    num_calib_examples : int
+        Number of examples of calib_data to use, all of them by default.
+    num_calib_bins : int
+        Number of bins of the histograms of the 'entropy' mode.
+    logger : Object
+        Logger of the progress.
+
+    Returns
+    -------
+    tuple
+        The quantized symbol, its arguments and its auxiliary states.
+    """
+    if calib_mode not in ('none', 'naive', 'entropy'):
+        raise ValueError('unknown calib_mode %s' % calib_mode)
+    if calib_mode != 'none' and calib_data is None:
+        raise ValueError('calib_data is required by calib_mode %s' % calib_mode)
+    logger.info('Quantizing symbol')
+    qsym = _quantize_symbol(sym, excluded_symbols=excluded_sym_names,
+                            offline_params=list(arg_params.keys()))
+    logger.info('Quantizing parameters')
+    qarg_params = _quantize_params(qsym, arg_params)
+    if calib_mode != 'none':
+        logger.info('Calibrating the quantized symbol with mode %s', calib_mode)
+        th_dict = _collect_layer_ranges(sym, arg_params, aux_params, ctx, calib_data,
+                                        num_calib_examples, _calib_layer_names(qsym),
+                                        calib_mode, num_calib_bins, logger)
+        qsym = _calibrate_quantized_sym(qsym, th_dict)
+    return qsym, qarg_params, aux_params
@@ -101,6 +101,11 @@ cdef extern from "mxnet/c_api.h":
     int MXNDArrayFree(NDArrayHandle handle);
     int MXCreateCachedOp(SymbolHandle handle,
                          CachedOpHandle *out);
+    int MXCreateCachedOpEx(SymbolHandle handle,
+                           int num_flags,
+                           const char** keys,
+                           const char** vals,
+                           CachedOpHandle *out);
     int MXFreeCachedOp(CachedOpHandle handle);
     int MXInvokeCachedOp(CachedOpHandle handle,
                        int num_inputs,
@@ -82,10 +82,22 @@ cdef class CachedOp:
         def __set__(self, value):
             self._set_handle(value)
 
-    def __init__(self, sym):
+    def __init__(self, sym, flags=()):
+        cdef vector[string] s_flag_keys
+        cdef vector[string] s_flag_vals
+        flags = dict(flags)
+        for k, v in flags.items():
+            s_flag_keys.push_back(c_str(k))
+            s_flag_vals.push_back(c_str(str(v)))
+        cdef vector[const char*] c_flag_keys = SVec2Ptr(s_flag_keys)
+        cdef vector[const char*] c_flag_vals = SVec2Ptr(s_flag_vals)
+
         cdef unsigned long long ptr = sym.handle.value
-        CALL(MXCreateCachedOp(
+        CALL(MXCreateCachedOpEx(
             (<SymbolHandle>ptr),
+            len(flags),
+            CBeginPtr(c_flag_keys),
+            CBeginPtr(c_flag_vals),
             &self.chandle))
 
     def __del__(self):
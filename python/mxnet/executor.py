@@ -22,10 +22,11 @@ from __future__ import absolute_import
 
 import ctypes
 import copy
+import json
 import numpy as np
 from .base import _LIB
 from .base import mx_uint, NDArrayHandle, ExecutorHandle
-from .base import check_call, c_array, py_str
+from .base import check_call, c_array, c_str, py_str
 from .ndarray import NDArray
 from .ndarray import _ndarray_cls
 from . import ndarray as nd
@@ -81,6 +82,7 @@ class Executor(object):
         self._ctx = copy.deepcopy(ctx)
         self._grad_req = copy.deepcopy(grad_req)
         self._group2ctx = copy.deepcopy(group2ctx)
+        self._reshape_cache = {}
 
     def __del__(self):
         check_call(_LIB.MXExecutorFree(self.handle))
@@ -255,6 +257,39 @@ class Executor(object):
             self._monitor_callback,
             None))
 
+    def next_input(self, name):
+        """Get the second buffer of an input argument, to write the input of the
+        next forward into while the current forward and backward still run.
+
+        The operators of the running iteration only read the bound argument, so
+        a copy into this buffer, e.g. from the host, overlaps their computation.
+        The next call to `forward` swaps the memory of the two arrays without
+        binding again, after which ``arg_dict[name]`` holds the data written here.
+        Call it again before writing the input of every iteration.
+
+        Parameters
+        ----------
+        name : str
+            The name of the input argument.
+
+        Returns
+        -------
+        NDArray
+            The second buffer, of the shape, type and context of the argument.
+
+        Examples
+        --------
+        >>> texec = sym.simple_bind(mx.cpu(), data=(2, 3))
+        >>> texec.next_input('data')[:] = mx.nd.ones((2, 3))
+        >>> texec.forward()
+        >>> texec.arg_dict['data'].asnumpy()
+        array([[ 1.,  1.,  1.],
+               [ 1.,  1.,  1.]], dtype=float32)
+        """
+        handle = NDArrayHandle()
+        check_call(_LIB.MXExecutorNextInput(self.handle, c_str(name), ctypes.byref(handle)))
+        return NDArray(handle)
+
     @property
     def arg_dict(self):
         """Get dictionary representation of argument arrrays.
@@ -374,6 +409,8 @@ class Executor(object):
         For runtime reshaping, variable length sequences, etc.
         The returned executor shares state with the current one,
         and cannot be used in parallel with it.
+        Executors are cached by their shapes, so reshaping again to shapes
+        seen before returns the same executor without binding again.
 
         Parameters
         ----------
@@ -399,6 +436,10 @@ class Executor(object):
         >>> texec.reshape(allow_up_sizing=True, **new_shape)
         """
         # pylint: disable=too-many-branches
+        key = (partial_shaping, allow_up_sizing,
+               tuple(sorted((name, tuple(shape)) for name, shape in kwargs.items())))
+        if key in self._reshape_cache:
+            return self._reshape_cache[key]
         arg_shapes, _, aux_shapes = self._symbol.infer_shape(**kwargs)
         if arg_shapes is None:
             raise ValueError("Insufficient argument shapes provided.")
@@ -448,13 +489,15 @@ class Executor(object):
                     "with the old one. Please check for error in network." +\
                     "If this is intended, set partial_shaping=True to suppress this warning.")
 
-        return self._symbol.bind(self._ctx,
-                                 args=new_arg_dict,
-                                 args_grad=new_grad_dict,
-                                 grad_req=self._grad_req,
-                                 aux_states=new_aux_dict,
-                                 group2ctx=self._group2ctx,
-                                 shared_exec=self)
+        executor = self._symbol.bind(self._ctx,
+                                     args=new_arg_dict,
+                                     args_grad=new_grad_dict,
+                                     grad_req=self._grad_req,
+                                     aux_states=new_aux_dict,
+                                     group2ctx=self._group2ctx,
+                                     shared_exec=self)
+        self._reshape_cache[key] = executor
+        return executor
 
     def debug_str(self):
         """Get a debug string about internal execution plan.
@@ -496,3 +539,236 @@ class Executor(object):
         check_call(_LIB.MXExecutorPrint(
             self.handle, ctypes.byref(debug_str)))
         return py_str(debug_str.value)
+
+    def memory_plan(self):
+        """Get the memory plan of the executor.
+
+        Returns
+        -------
+        plan : dict
+            ``plan['entries']`` lists every node entry in the order of the entry
+            ids, as a dict with its ``name``, the ``storage_id`` of the block
+            planned for it (-1 if it is not allocated, -2 if it is bound from
+            outside and -3 if it is allocated at run time), its size in ``bytes``,
+            the ``req`` of the node writing it (0 null, 1 write, 2 inplace, 3 add,
+            -1 for variables), the ``inplace_input`` whose memory it reuses
+            (-1 if none) and its ``context``.
+            ``plan['totals']`` gives for each ``context`` the ``forward_bytes`` of
+            the blocks used by the forward pass and the ``train_bytes`` of the
+            blocks used by the forward and backward passes.
+
+        Examples
+        --------
+        >>> data = mx.sym.Variable('data')
+        >>> net = mx.sym.FullyConnected(data, num_hidden=256, name='fc')
+        >>> texec = net.simple_bind(mx.cpu(), data=(1024, 16))
+        >>> plan = texec.memory_plan()
+        >>> [e['name'] for e in plan['entries']]
+        [u'data', u'fc_weight', u'fc_bias', u'fc', ...]
+        >>> plan['totals'][0]['context']
+        u'cpu(0)'
+        """
+        plan = ctypes.c_char_p()
+        check_call(_LIB.MXExecutorGetMemoryPlan(
+            self.handle, ctypes.byref(plan)))
+        return json.loads(py_str(plan.value))
+
+
+class PipelineExecutor(object):
+    """Executor of a symbol placed on several devices with ``group2ctx``, which
+    pipelines the micro-batches of every batch through the devices.
+
+    The batch is split along its first axis into ``num_micro_batches``
+    micro-batches, each run by an executor of its own. The executors share the
+    parameters, the auxiliary states and the gradients, which they accumulate
+    with ``kAddTo``. The operators of successive micro-batches are pushed so
+    that the engine runs a device on one micro-batch while the others work on
+    the next ones.
+
+    With the ``'gpipe'`` schedule the forward passes of all micro-batches are
+    pushed before their backward passes, and one executor is bound per
+    micro-batch. With the ``'1f1b'`` schedule the backward pass of a
+    micro-batch follows as soon as the forward passes filling the pipeline are
+    pushed, so only one executor per device is bound and reused, which keeps
+    the activations of as many micro-batches as there are devices.
+
+    Parameters
+    ----------
+    symbol : Symbol
+        The symbol, with its nodes grouped by ``ctx_group`` attributes.
+    ctx : Context
+        The context of the nodes not in a group.
+    group2ctx : dict of str to Context
+        The context of every group.
+    num_micro_batches : int
+        Number of micro-batches every batch is split into, which must divide
+        the batch size.
+    grad_req : str
+        ``'write'`` to clear the gradients at every step, ``'add'`` to keep
+        adding to them, ``'null'`` for inference only.
+    schedule : str
+        ``'1f1b'`` or ``'gpipe'``.
+    kwargs : dict of str to tuple
+        The shapes of the full batch of every input, all split along their
+        first axis.
+
+    Examples
+    --------
+    >>> with mx.AttrScope(ctx_group='stage1'):
+    ...     net = mx.sym.FullyConnected(mx.sym.Variable('data'), num_hidden=128)
+    >>> with mx.AttrScope(ctx_group='stage2'):
+    ...     net = mx.sym.SoftmaxOutput(mx.sym.FullyConnected(net, num_hidden=10))
+    >>> pexec = mx.executor.PipelineExecutor(
+    ...     net, mx.gpu(0), {'stage1': mx.gpu(0), 'stage2': mx.gpu(1)}, 4,
+    ...     data=(64, 100), softmax_label=(64,))
+    >>> pexec.forward_backward(data=data, softmax_label=label)
+    """
+    def __init__(self, symbol, ctx, group2ctx, num_micro_batches, grad_req='write',
+                 schedule='1f1b', **kwargs):
+        if schedule not in ('1f1b', 'gpipe'):
+            raise ValueError("schedule must be '1f1b' or 'gpipe', got %s" % schedule)
+        if grad_req not in ('write', 'add', 'null'):
+            raise ValueError("grad_req must be 'write', 'add' or 'null', got %s" % grad_req)
+        self._num_micro_batches = num_micro_batches
+        self._schedule = schedule
+        self._grad_req = grad_req
+        self._input_names = list(kwargs.keys())
+        self._batch_size = None
+        micro_shapes = {}
+        for name, shape in kwargs.items():
+            if self._batch_size is None:
+                self._batch_size = shape[0]
+            if shape[0] != self._batch_size:
+                raise ValueError("all inputs must have the same batch size, %s has shape %s"
+                                 % (name, str(shape)))
+            if shape[0] % num_micro_batches != 0:
+                raise ValueError("the batch size %d is not divisible by %d micro-batches"
+                                 % (shape[0], num_micro_batches))
+            micro_shapes[name] = (shape[0] // num_micro_batches,) + tuple(shape[1:])
+        self._micro_batch_size = self._batch_size // num_micro_batches
+        num_stages = len(set(list(group2ctx.values()) + [ctx]))
+        if schedule == 'gpipe':
+            num_execs = num_micro_batches
+        else:
+            num_execs = min(num_micro_batches, num_stages)
+
+        arg_names = symbol.list_arguments()
+        param_grad_req = 'null' if grad_req == 'null' else 'add'
+        req = dict((name, 'null' if name in kwargs else param_grad_req) for name in arg_names)
+        first = symbol.simple_bind(ctx, grad_req=req, group2ctx=group2ctx, **micro_shapes)
+        self.arg_dict = dict((k, v) for k, v in first.arg_dict.items() if k not in kwargs)
+        self.grad_dict = dict((k, v) for k, v in first.grad_dict.items()
+                              if k not in kwargs and v is not None)
+        self.aux_dict = first.aux_dict
+        self._execs = [first]
+        for _ in range(1, num_execs):
+            args = {}
+            for name in arg_names:
+                if name in kwargs:
+                    arr = first.arg_dict[name]
+                    args[name] = nd.zeros(arr.shape, ctx=arr.context, dtype=arr.dtype)
+                else:
+                    args[name] = first.arg_dict[name]
+            self._execs.append(symbol.bind(ctx, args, args_grad=self.grad_dict, grad_req=req,
+                                           aux_states=self.aux_dict, group2ctx=group2ctx))
+        self.outputs = [nd.zeros((self._batch_size,) + out.shape[1:], ctx=out.context,
+                                 dtype=out.dtype)
+                        for out in first.outputs]
+
+    def _micro_batch(self, i):
+        """Begin and end of the i-th micro-batch in the batch."""
+        return i * self._micro_batch_size, (i + 1) * self._micro_batch_size
+
+    def _forward(self, i, is_train, inputs):
+        """Push the forward pass of micro-batch i, whose outputs are copied into the
+        outputs of the batch."""
+        exe = self._execs[i % len(self._execs)]
+        begin, end = self._micro_batch(i)
+        for name in self._input_names:
+            inputs[name][begin:end].copyto(exe.arg_dict[name])
+        exe.forward(is_train=is_train)
+        for out, micro_out in zip(self.outputs, exe.outputs):
+            out[begin:end] = micro_out
+
+    def _backward(self, i, out_grads):
+        """Push the backward pass of micro-batch i."""
+        exe = self._execs[i % len(self._execs)]
+        begin, end = self._micro_batch(i)
+        if out_grads is None:
+            exe.backward()
+        else:
+            exe.backward([grad[begin:end] for grad in out_grads])
+
+    def _check_inputs(self, kwargs):
+        inputs = {}
+        for name in self._input_names:
+            if name not in kwargs:
+                raise ValueError("input %s is missing" % name)
+            arr = kwargs[name]
+            if not isinstance(arr, NDArray):
+                arr = nd.array(arr)
+            if arr.shape[0] != self._batch_size:
+                raise ValueError("input %s has batch size %d instead of %d"
+                                 % (name, arr.shape[0], self._batch_size))
+            inputs[name] = arr
+        return inputs
+
+    def forward(self, **kwargs):
+        """Run the inference of a batch.
+
+        Parameters
+        ----------
+        kwargs : dict of str to NDArray or numpy.ndarray
+            The full batch of every input.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            The outputs of the batch.
+        """
+        inputs = self._check_inputs(kwargs)
+        for i in range(self._num_micro_batches):
+            self._forward(i, False, inputs)
+        return self.outputs
+
+    def forward_backward(self, out_grads=None, **kwargs):
+        """Run the forward and backward passes of a batch, the gradients of the
+        micro-batches are summed into ``grad_dict``.
+
+        Parameters
+        ----------
+        out_grads : list of NDArray, optional
+            The gradients of the full batch of the outputs, not needed for
+            outputs that are losses.
+        kwargs : dict of str to NDArray or numpy.ndarray
+            The full batch of every input.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            The outputs of the batch.
+        """
+        if self._grad_req == 'null':
+            raise ValueError("the PipelineExecutor is bound with grad_req='null'")
+        inputs = self._check_inputs(kwargs)
+        if self._grad_req == 'write':
+            for grad in self.grad_dict.values():
+                grad[:] = 0
+        num = self._num_micro_batches
+        if self._schedule == 'gpipe':
+            for i in range(num):
+                self._forward(i, True, inputs)
+            for i in reversed(range(num)):
+                self._backward(i, out_grads)
+        else:
+            # fill the pipeline, then push one backward pass after every
+            # forward pass, the backward pass freeing the executor the next
+            # forward pass reuses
+            warmup = len(self._execs)
+            for i in range(num):
+                self._forward(i, True, inputs)
+                if i >= warmup - 1:
+                    self._backward(i - warmup + 1, out_grads)
+            for i in range(num - warmup + 1, num):
+                self._backward(i, out_grads)
+        return self.outputs
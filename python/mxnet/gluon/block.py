@@ -251,7 +251,7 @@ class Block(object):
         """
         self.collect_params().initialize(init, ctx, verbose)
 
-    def hybridize(self, active=True):
+    def hybridize(self, active=True, **kwargs):
         """Activates or deactivates `HybridBlock`s recursively. Has no effect on
         non-hybrid children.
 
@@ -259,9 +259,13 @@ class Block(object):
         ----------
         active : bool, default True
             Whether to turn hybrid on or off.
+        static_alloc : bool, default False
+            Statically allocate memory to improve speed. Calls made outside of
+            `autograd.record` run in an executor bound for the input shapes,
+            which plans the memory once and reuses it across calls.
         """
         for cld in self._children:
-            cld.hybridize(active)
+            cld.hybridize(active, **kwargs)
 
     def __call__(self, *args):
         """Calls forward. Only accepts positional arguments."""
@@ -306,6 +310,7 @@ class HybridBlock(Block):
         self._out_format = None
         self._in_format = None
         self._active = False
+        self._flags = {}
 
     def __setattr__(self, name, value):
         """Registers parameters."""
@@ -327,9 +332,12 @@ class HybridBlock(Block):
                     str(block), str(type(block))))
         super(HybridBlock, self).register_child(block)
 
-    def hybridize(self, active=True):
+    def hybridize(self, active=True, **kwargs):
         self._active = active
-        super(HybridBlock, self).hybridize(active)
+        if kwargs != self._flags:
+            self._flags = kwargs
+            self._cached_op = None
+        super(HybridBlock, self).hybridize(active, **kwargs)
 
     def _get_graph(self, *args):
         if not self._cached_graph:
@@ -360,7 +368,7 @@ class HybridBlock(Block):
 
     def _build_cache(self, *args):
         inputs, out = self._get_graph(*args)
-        self._cached_op = ndarray.CachedOp(out)
+        self._cached_op = ndarray.CachedOp(out, self._flags)
 
         params = dict(self.collect_params().items())
         self._cached_params = [params.get(name, None) for name in out.list_inputs()]
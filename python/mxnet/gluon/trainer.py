@@ -131,6 +131,9 @@ class Trainer(object):
 
         self._optimizer.rescale_grad = self._scale / batch_size
 
+        # the weights of every device are given to its updater together,
+        # so that the optimizer can update them with aggregated operators
+        updates = [[] for _ in self._updaters]
         for i, param in enumerate(self._params):
             if param.grad_req == 'null':
                 continue
@@ -154,7 +157,12 @@ class Trainer(object):
                 else:
                     self._kvstore.pull(i, param.list_grad(), priority=-i)
 
-            for upd, arr, grad in zip(self._updaters, param.list_data(), param.list_grad()):
+            for upd, arr, grad in zip(updates, param.list_data(), param.list_grad()):
                 if not ignore_stale_grad or arr._fresh_grad:
-                    upd(i, grad, arr)
+                    upd.append((i, grad, arr))
                     arr._fresh_grad = False
+
+        for updater, upd in zip(self._updaters, updates):
+            if upd:
+                indices, grads, arrs = zip(*upd)
+                updater(list(indices), list(grads), list(arrs))
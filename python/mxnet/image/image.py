@@ -96,6 +96,11 @@ def imdecode(buf, *args, **kwargs):
         1 for three channel color output. 0 for grayscale output.
     to_rgb : int, optional, default=1
         1 for RGB formatted output (MXNet default). 0 for BGR formatted output (OpenCV default).
+    min_width : int, optional, default=0
+        Decode a JPEG image at 1/2, 1/4 or 1/8 of its resolution, which is much faster,
+        when the result is still at least `min_width` wide and `min_height` high.
+    min_height : int, optional, default=0
+        See `min_width`.
     out : NDArray, optional
         Output buffer. Use `None` for automatic allocation.
 
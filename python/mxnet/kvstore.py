@@ -28,6 +28,10 @@ from .base import check_call, c_array, c_str, string_types, mx_uint, py_str
 from .base import NDArrayHandle, KVStoreHandle
 from . import optimizer as opt
 
+# the commands of the servers, as in src/kvstore/kvstore_dist_server.h
+_SAVE_SHARDS = -6
+_LOAD_SHARDS = -7
+
 def _ctype_key_value(keys, vals):
     """
     Returns ctype arrays for the key-value args, and the whether string keys are used.
@@ -363,7 +367,7 @@ class KVStore(object):
         check_call(_LIB.MXKVStoreIsWorkerNode(ctypes.byref(is_worker)))
 
         # pylint: disable=invalid-name
-        if 'dist' in self.type and is_worker.value:
+        if 'dist' in self.type and 'allreduce' not in self.type and is_worker.value:
             # send the optimizer to server
             try:
                 # use ASCII protocol 0, might be slower, but not a big ideal
@@ -374,6 +378,38 @@ class KVStore(object):
         else:
             self._set_updater(opt.get_updater(optimizer))
 
+    def set_gradient_compression(self, compression_params):
+        """ Specifies the type of the gradient compression and its parameters.
+
+        Gradient compression reduces the size of the dense gradients pushed by the
+        workers of a distributed kvstore. With the ``2bit`` type, every value is
+        sent as 2 bits. The gradient is added to a residual kept on the worker,
+        the values of the residual which are at least ``threshold`` in magnitude
+        are sent as ``+threshold`` or ``-threshold`` and subtracted from it,
+        the other values are sent as 0 and stay in the residual.
+
+        This function must be called before any key is initialized.
+
+        Parameters
+        ----------
+        compression_params : dict
+            A dictionary of the parameters of the compression, with the keys
+            ``type`` ('none' or '2bit') and ``threshold`` (default 0.5).
+
+        Examples
+        --------
+        >>> kv = mx.kv.create('dist_sync')
+        >>> kv.set_gradient_compression({'type': '2bit', 'threshold': 0.5})
+        """
+        if 'dist' not in self.type:
+            raise ValueError('Gradient compression is only supported by the '
+                             'distributed kvstore, not by %s' % self.type)
+        params = list(compression_params.items())
+        ckeys = c_array(ctypes.c_char_p, [c_str(k) for k, _ in params])
+        cvals = c_array(ctypes.c_char_p, [c_str(str(v)) for _, v in params])
+        check_call(_LIB.MXKVStoreSetGradientCompression(
+            self.handle, mx_uint(len(params)), ckeys, cvals))
+
     @property
     def type(self):
         """ Returns the type of this kvstore.
@@ -488,6 +524,37 @@ class KVStore(object):
         """
         check_call(_LIB.MXKVStoreBarrier(self.handle))
 
+    def save_server_shards(self, prefix):
+        """Makes every server of a distributed kvstore write the values it stores.
+
+        The servers write their shards in parallel, to ``prefix-server<rank>.params``
+        on a filesystem shared by them, instead of the values being pulled and saved
+        by a worker. The shards hold the values only, not the states of the optimizer.
+
+        Call it from a single worker once the pushes of all the workers are
+        finished, such as after a ``_barrier``. It returns once all the servers are done.
+
+        Parameters
+        ----------
+        prefix : str
+            The path prefix of the files.
+        """
+        self._send_command_to_servers(_SAVE_SHARDS, prefix)
+
+    def load_server_shards(self, prefix):
+        """Makes every server of a distributed kvstore restore the values saved by
+        ``save_server_shards``.
+
+        The keys must be initialized first, with as many servers as when they were
+        saved. The workers then pull the restored values.
+
+        Parameters
+        ----------
+        prefix : str
+            The path prefix the files were saved with.
+        """
+        self._send_command_to_servers(_LOAD_SHARDS, prefix)
+
     def _send_command_to_servers(self, head, body):
         """Sends a command to all server nodes.
 
@@ -524,6 +591,8 @@ def create(name='local'):
     With ``dist_sync``, batch-size now means the batch size used on each machine.
     So if there are ``n`` machines and we use batch size ``b``,
     then ``dist_sync`` behaves like ``local`` with batch size ``n * b``.
+    With ``MXNET_KVSTORE_BACKUP_WORKERS`` set to ``k``, the servers update a key once
+    ``n - k`` machines have pushed it, and drop the late pushes of that round.
 
     ``dist_device_sync``: Identical to ``dist_sync`` with the difference similar
     to ``device`` vs ``local``.
@@ -533,9 +602,21 @@ def create(name='local'):
     No two updates happen on the same weight at the same time. However, the order is not
     guaranteed.
 
+    ``dist_ssp``: Performs asynchronous updates with bounded staleness. A machine
+    whose pushes of a key are more than ``MXNET_KVSTORE_SSP_STALENESS`` (2 by default)
+    ahead of the slowest machine waits for it, the other machines are not blocked.
+
+    ``nccl``: Like ``device``, with the values summed and broadcast over the GPUs by NCCL.
+    ``dist_sync_nccl`` uses it within every machine of ``dist_sync``.
+
+    ``dist_sync_allreduce``: Behaves like ``dist_sync`` without servers. The gradients are
+    summed over the machines by a ring allreduce, and every machine updates its own copy of
+    the weights. All machines must push the same keys in the same order.
+
     Parameters
     ----------
-    name : {'local', 'device', 'dist_sync', 'dist_device_sync', 'dist_async'}
+    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_sync_nccl',
+            'dist_async', 'dist_ssp', 'dist_sync_allreduce'}
         The type of KVStore.
     Returns
     -------
@@ -20,6 +20,7 @@
 """Executor group is a convenient tool for managing a group of executors."""
 
 import logging
+import os
 from collections import OrderedDict
 
 from .. import context as ctx
@@ -213,6 +214,9 @@ class DataParallelExecutorGroup(object):
         self.label_arrays = None
         self.param_arrays = None
         self.state_arrays = None
+        # copy the inputs into the second buffers of the executors, so that
+        # the copies overlap the computation of the previous batch
+        self._double_buffer = int(os.getenv('MXNET_MODULE_DOUBLE_BUFFER_INPUTS', '0')) != 0
         self.grad_arrays = None
         self.aux_arrays = None
         self.input_grad_arrays = None
@@ -399,16 +403,31 @@ class DataParallelExecutorGroup(object):
         -------
 
         """
-        _load_data(data_batch, self.data_arrays, self.data_layouts)
+        if self._double_buffer:
+            _load_data(data_batch, self._next_inputs(self.data_names, self.data_arrays),
+                       self.data_layouts)
+        else:
+            _load_data(data_batch, self.data_arrays, self.data_layouts)
         if is_train is None:
             is_train = self.for_training
 
         if self.label_arrays is not None and data_batch.label:
-            _load_label(data_batch, self.label_arrays, self.label_layouts)
+            if self._double_buffer:
+                _load_label(data_batch, self._next_inputs(self.label_names, self.label_arrays),
+                            self.label_layouts)
+            else:
+                _load_label(data_batch, self.label_arrays, self.label_layouts)
 
         for exec_ in self.execs:
             exec_.forward(is_train=is_train)
 
+    def _next_inputs(self, names, arrays):
+        """Get the second buffers of the default storage inputs in `arrays`,
+        which the next forward of the executors swaps with the bound inputs."""
+        return [[(slice_idx, e.next_input(name) if dst.stype == 'default' else dst)
+                 for (slice_idx, dst), e in zip(targets, self.execs)]
+                for name, targets in zip(names, arrays)]
+
     def get_output_shapes(self):
         """Get the shapes of the outputs."""
         outputs = self.execs[0].outputs
@@ -28,12 +28,13 @@ except ImportError:
     from builtins import slice as py_slice
 
 import ctypes
+import threading
 import warnings
 import operator
 import numpy as np
 from ..base import _LIB, numeric_types, integer_types
 from ..base import c_array, mx_real_t
-from ..base import mx_uint, NDArrayHandle, check_call
+from ..base import mx_uint, NDArrayHandle, check_call, MXNetError
 from ..base import ctypes2buffer
 from ..context import Context
 from . import _internal
@@ -44,7 +45,7 @@ __all__ = ["NDArray", "concatenate", "_DTYPE_NP_TO_MX", "_DTYPE_MX_TO_NP", "_GRA
            "ones", "add", "arange", "divide", "equal", "full", "greater", "greater_equal",
            "imdecode", "lesser", "lesser_equal", "maximum", "minimum", "moveaxis", "modulo",
            "multiply", "not_equal", "onehot_encode", "power", "subtract", "true_divide",
-           "waitall", "_new_empty_handle"]
+           "waitall", "_new_empty_handle", "from_dlpack"]
 
 _STORAGE_TYPE_UNDEFINED = -1
 _STORAGE_TYPE_DEFAULT = 0
@@ -133,6 +134,86 @@ def _new_alloc_handle(shape, ctx, delay_alloc, dtype=mx_real_t):
     return hdl
 
 
+def _new_from_shared_mem(shared_pid, shared_id, shape, dtype):
+    """Returns a new handle on the shared memory of a `cpu_shared` array of
+    another process, given by `NDArray._to_shared_mem`."""
+    hdl = NDArrayHandle()
+    check_call(_LIB.MXNDArrayCreateFromSharedMem(
+        ctypes.c_int(shared_pid),
+        ctypes.c_int(shared_id),
+        c_array(mx_uint, shape),
+        mx_uint(len(shape)),
+        ctypes.c_int(int(_DTYPE_NP_TO_MX[np.dtype(dtype).type])),
+        ctypes.byref(hdl)))
+    return hdl
+
+
+# DLPack tensors are exchanged as PyCapsules named "dltensor", renamed to
+# "used_dltensor" by the framework consuming them
+_PyCapsuleDestructor = ctypes.CFUNCTYPE(None, ctypes.c_void_p)
+ctypes.pythonapi.PyCapsule_New.restype = ctypes.py_object
+ctypes.pythonapi.PyCapsule_New.argtypes = [ctypes.c_void_p, ctypes.c_char_p,
+                                           _PyCapsuleDestructor]
+ctypes.pythonapi.PyCapsule_IsValid.restype = ctypes.c_int
+ctypes.pythonapi.PyCapsule_IsValid.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+ctypes.pythonapi.PyCapsule_GetPointer.restype = ctypes.c_void_p
+ctypes.pythonapi.PyCapsule_GetPointer.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+_DLTENSOR_NAME = b'dltensor'
+_USED_DLTENSOR_NAME = b'used_dltensor'
+
+
+def _dlpack_deleter(capsule):
+    """Frees the DLPack tensor of a capsule which was never consumed."""
+    if ctypes.pythonapi.PyCapsule_IsValid(capsule, _DLTENSOR_NAME):
+        dlpack = ctypes.pythonapi.PyCapsule_GetPointer(capsule, _DLTENSOR_NAME)
+        check_call(_LIB.MXNDArrayCallDLPackDeleter(ctypes.c_void_p(dlpack)))
+
+_c_dlpack_deleter = _PyCapsuleDestructor(_dlpack_deleter)
+
+
+def _to_dlpack(handle):
+    """Returns a "dltensor" PyCapsule sharing the data of the array."""
+    dlpack = ctypes.c_void_p()
+    check_call(_LIB.MXNDArrayToDLPack(handle, ctypes.byref(dlpack)))
+    return ctypes.pythonapi.PyCapsule_New(dlpack, _DLTENSOR_NAME, _c_dlpack_deleter)
+
+
+def from_dlpack(dlpack):
+    """Returns an array sharing the data of a DLPack tensor of another framework.
+
+    The data is not copied. The capsule is consumed and cannot be used again;
+    the other framework is told to free the data once the array is freed and
+    the operations pending on it have finished.
+
+    Parameters
+    ----------
+    dlpack : PyCapsule
+        A "dltensor" capsule holding a compact CPU or GPU DLPack tensor.
+
+    Returns
+    -------
+    NDArray
+        An array on the data of the tensor.
+
+    Examples
+    --------
+    >>> x = mx.nd.ones((2,3))
+    >>> y = mx.nd.from_dlpack(x.to_dlpack_for_read())
+    >>> y
+    <NDArray 2x3 @cpu(0)>
+    """
+    ptr = ctypes.c_void_p(id(dlpack))
+    if not ctypes.pythonapi.PyCapsule_IsValid(ptr, _DLTENSOR_NAME):
+        raise ValueError('Invalid DLPack tensor, a "dltensor" capsule is consumed only once')
+    tensor = ctypes.pythonapi.PyCapsule_GetPointer(ptr, _DLTENSOR_NAME)
+    handle = NDArrayHandle()
+    check_call(_LIB.MXNDArrayFromDLPack(ctypes.c_void_p(tensor), ctypes.byref(handle)))
+    # the array owns the tensor now, the capsule must not free it
+    ctypes.pythonapi.PyCapsule_SetName(ctypes.py_object(dlpack),
+                                       ctypes.c_char_p(_USED_DLTENSOR_NAME))
+    return NDArray(handle=handle)
+
+
 def waitall():
     """Wait for all async operations to finish in MXNet.
 
@@ -147,6 +228,49 @@ def _storage_type(handle):
     return storage_type.value
 
 
+_NDARRAY_COPY_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_void_p)
+
+
+class AsyncCopy(object):
+    """Handle of a copy started by ``NDArray.asnumpy_async``."""
+    # copies in flight, kept alive until their callback is called
+    _pending = set()
+
+    def __init__(self, src, out, callback):
+        self._out = out
+        self._callback = callback
+        self._done = threading.Event()
+        self._c_callback = _NDARRAY_COPY_CALLBACK(self._on_complete)
+        AsyncCopy._pending.add(self)
+        try:
+            check_call(_LIB.MXNDArrayCopyToCPUAsync(
+                src.handle,
+                out.ctypes.data_as(ctypes.c_void_p),
+                ctypes.c_size_t(out.size),
+                self._c_callback,
+                None))
+        except MXNetError:
+            AsyncCopy._pending.discard(self)
+            raise
+
+    def _on_complete(self, _):
+        try:
+            if self._callback is not None:
+                self._callback(self._out)
+        finally:
+            self._done.set()
+            AsyncCopy._pending.discard(self)
+
+    def done(self):
+        """Returns whether the copy is done."""
+        return self._done.is_set()
+
+    def wait(self):
+        """Blocks until the copy is done, and returns the copied numpy array."""
+        self._done.wait()
+        return self._out
+
+
 class NDArray(NDArrayBase):
     """An array object representing a multidimensional, homogeneous array of
 fixed-size items.
@@ -167,6 +291,17 @@ fixed-size items.
     def __reduce__(self):
         return NDArray, (None,), self.__getstate__()
 
+    def _to_shared_mem(self):
+        """Returns `(shared_pid, shared_id, shape, dtype)`, with which another
+        process opens this `cpu_shared` array without copy, see
+        `_new_from_shared_mem`. The memory can be opened while this array lives.
+        """
+        shared_pid = ctypes.c_int()
+        shared_id = ctypes.c_int()
+        check_call(_LIB.MXNDArrayGetSharedMemHandle(
+            self.handle, ctypes.byref(shared_pid), ctypes.byref(shared_id)))
+        return shared_pid.value, shared_id.value, self.shape, self.dtype
+
     def __add__(self, other):
         """x.__add__(y) <=> x+y <=> mx.nd.add(x, y) """
         return add(self, other)
@@ -1070,6 +1205,57 @@ fixed-size items.
         """
         check_call(_LIB.MXNDArrayWaitToRead(self.handle))
 
+    def to_dlpack_for_read(self):
+        """Returns a DLPack tensor sharing the data of this array, to be read by
+        another framework.
+
+        The pending writes to the array are waited for. The data is not copied,
+        and stays valid until the other framework frees the tensor.
+
+        Returns
+        -------
+        PyCapsule
+            A "dltensor" capsule, see `from_dlpack`.
+        """
+        self.wait_to_read()
+        return _to_dlpack(self.handle)
+
+    def to_dlpack_for_write(self):
+        """Returns a DLPack tensor sharing the data of this array, to be written
+        by another framework.
+
+        The pending reads and writes of the array are waited for. The data is not
+        copied, and stays valid until the other framework frees the tensor.
+
+        Returns
+        -------
+        PyCapsule
+            A "dltensor" capsule, see `from_dlpack`.
+        """
+        check_call(_LIB.MXNDArrayWaitToWrite(self.handle))
+        return _to_dlpack(self.handle)
+
+    def is_ready(self):
+        """Returns whether all previous write operations on the current array
+        are finished, without blocking.
+
+        Unlike `wait_to_read`, this does not wait, so the host can keep working
+        while the array is being computed.
+
+        Examples
+        --------
+        >>> a = mx.nd.ones((1000,1000))
+        >>> b = mx.nd.dot(a, a)
+        >>> b.is_ready() # doctest: +SKIP
+        False
+        >>> b.wait_to_read()
+        >>> b.is_ready()
+        True
+        """
+        ready = ctypes.c_int()
+        check_call(_LIB.MXNDArrayIsReady(self.handle, ctypes.byref(ready)))
+        return ready.value != 0
+
     @property
     def ndim(self):
         """Returns the number of dimensions of this array
@@ -1245,6 +1431,42 @@ fixed-size items.
             ctypes.c_size_t(data.size)))
         return data
 
+    def asnumpy_async(self, out=None, callback=None):
+        """Starts copying this array into a ``numpy.ndarray`` without blocking.
+
+        The copy runs after the pending writes of this array. ``out`` must not be
+        used before the copy is done.
+
+        Parameters
+        ----------
+        out : numpy.ndarray, optional
+            C contiguous array of the same size and dtype receiving the copy.
+            A new array is created if None.
+        callback : function, optional
+            Called with ``out`` from an engine thread once the copy is done.
+
+        Returns
+        -------
+        AsyncCopy
+            Handle of the copy, whose ``wait`` blocks until the copy is done and
+            returns ``out``.
+
+        Examples
+        --------
+        >>> x = mx.nd.ones((2,3))
+        >>> copy = x.asnumpy_async()
+        >>> copy.wait()
+        array([[ 1.,  1.,  1.],
+               [ 1.,  1.,  1.]], dtype=float32)
+        """
+        if out is None:
+            out = np.empty(self.shape, dtype=self.dtype)
+        if out.size != self.size or out.dtype != np.dtype(self.dtype) or \
+                not out.flags['C_CONTIGUOUS']:
+            raise ValueError('out must be a C contiguous array of size %d and dtype %s'
+                             % (self.size, np.dtype(self.dtype)))
+        return AsyncCopy(self, out, callback)
+
     def asscalar(self):
         """Returns a scalar whose value is copied from this array.
 
@@ -1410,7 +1632,8 @@ fixed-size items.
         check_call(_LIB.MXNDArrayDetach(self.handle, ctypes.byref(hdl)))
         return NDArray(hdl)
 
-    def backward(self, out_grad=None, retain_graph=False, train_mode=True):
+    def backward(self, out_grad=None, retain_graph=False, train_mode=True,
+                 create_graph=False):
         """Compute the gradients of this NDArray w.r.t variables.
 
         Parameters
@@ -1420,15 +1643,26 @@ fixed-size items.
         retain_graph : bool, optional
             Whether to retain the computaion graph for another backward
             pass on the same graph. By default the computaion history
-            is cleared.
+            is cleared, and the recorded arrays are released during the
+            backward pass as soon as they are no longer needed.
         train_mode : bool, optional
             Whether to compute gradient for training or inference.
+        create_graph : bool, optional
+            Whether to record the backward pass, so that the gradients can
+            be differentiated again. The computation graph is then retained.
         """
         if out_grad is None:
             ograd_handles = [NDArrayHandle(0)]
         else:
             ograd_handles = [out_grad.handle]
 
+        if create_graph:
+            check_call(_LIB.MXAutogradBackwardCreateGraph(
+                1, c_array(NDArrayHandle, [self.handle]),
+                c_array(NDArrayHandle, ograd_handles),
+                ctypes.c_int(train_mode)))
+            return
+
         check_call(_LIB.MXAutogradBackwardEx(
             1, c_array(NDArrayHandle, [self.handle]),
             c_array(NDArrayHandle, ograd_handles),
@@ -20,6 +20,7 @@
 import ctypes
 
 from ..base import _LIB, check_call, py_str, c_str, string_types, mx_uint, NDArrayHandle, c_array
+from ..base import OpHandle
 from .ndarray import NDArray
 from .ndarray import array as _array
 from .ndarray import empty as _empty_ndarray
@@ -155,15 +156,19 @@ def array(source_array, ctx=None, dtype=None, aux_types=None):
         return _array(source_array, ctx=ctx, dtype=dtype)
 
 
-def load(fname):
+def load(fname, names=None):
     """Loads an array from file.
 
-    See more details in ``save``.
+    See more details in ``save``. Files saved with ``mappable=True`` are memory
+    mapped, and the arrays on cpu point at the mapped file until they are written,
+    so the file must not be modified while they are in use.
 
     Parameters
     ----------
     fname : str
         The filename.
+    names : list of str, optional
+        The names of the arrays to load, all arrays are loaded if None.
 
     Returns
     -------
@@ -176,22 +181,32 @@ def load(fname):
     out_size = mx_uint()
     out_name_size = mx_uint()
     handles = ctypes.POINTER(NDArrayHandle)()
-    names = ctypes.POINTER(ctypes.c_char_p)()
-    check_call(_LIB.MXNDArrayLoad(c_str(fname),
-                                  ctypes.byref(out_size),
-                                  ctypes.byref(handles),
-                                  ctypes.byref(out_name_size),
-                                  ctypes.byref(names)))
+    out_names = ctypes.POINTER(ctypes.c_char_p)()
+    if names is None:
+        check_call(_LIB.MXNDArrayLoad(c_str(fname),
+                                      ctypes.byref(out_size),
+                                      ctypes.byref(handles),
+                                      ctypes.byref(out_name_size),
+                                      ctypes.byref(out_names)))
+    else:
+        check_call(_LIB.MXNDArrayLoadSelected(c_str(fname),
+                                              mx_uint(len(names)),
+                                              c_array(ctypes.c_char_p,
+                                                      [c_str(n) for n in names]),
+                                              ctypes.byref(out_size),
+                                              ctypes.byref(handles),
+                                              ctypes.byref(out_name_size),
+                                              ctypes.byref(out_names)))
     if out_name_size.value == 0:
         return [_ndarray_cls(NDArrayHandle(handles[i])) for i in range(out_size.value)]
     else:
         assert out_name_size.value == out_size.value
         return dict(
-            (py_str(names[i]), _ndarray_cls(NDArrayHandle(handles[i])))
+            (py_str(out_names[i]), _ndarray_cls(NDArrayHandle(handles[i])))
             for i in range(out_size.value))
 
 
-def save(fname, data):
+def save(fname, data, mappable=False, background=False):
     """Saves a list of arrays or a dict of str->array to file.
 
     Examples of filenames:
@@ -208,6 +223,15 @@ def save(fname, data):
            or list of NDArray, RowSparseNDArray or CSRNDArray, \
            or dict of str to NDArray, RowSparseNDArray or CSRNDArray
         The data to save.
+    mappable : bool, optional
+        Whether to save in the mappable format, an aligned file with an index
+        of the arrays that ``load`` memory maps instead of reading. Only dense
+        arrays can be saved in this format.
+    background : bool, optional
+        Whether to write the file on a background thread. The call returns once
+        the copies of the arrays to the cpu are issued, and the arrays can be
+        modified right away without changing what is saved. Use ``wait_saves``
+        to wait for the file to be written.
 
     Examples
     --------
@@ -242,7 +266,87 @@ def save(fname, data):
     else:
         raise ValueError("data needs to either be a NDArray, dict of str, NDArray pairs "
                          "or a list of NDarrays.")
-    check_call(_LIB.MXNDArraySave(c_str(fname),
-                                  mx_uint(len(handles)),
-                                  c_array(NDArrayHandle, handles),
-                                  keys))
+    if background:
+        check_call(_LIB.MXNDArraySaveAsync(c_str(fname),
+                                           mx_uint(len(handles)),
+                                           c_array(NDArrayHandle, handles),
+                                           keys,
+                                           ctypes.c_int(mappable)))
+        return
+    save_fn = _LIB.MXNDArraySaveMappable if mappable else _LIB.MXNDArraySave
+    check_call(save_fn(c_str(fname),
+                       mx_uint(len(handles)),
+                       c_array(NDArrayHandle, handles),
+                       keys))
+
+
+def wait_saves():
+    """Waits until the files saved by ``save`` with ``background=True`` are written.
+
+    Raises an error if one of the saves failed since the last call.
+
+    Examples
+    --------
+    >>> x = mx.nd.ones((2,3))
+    >>> mx.nd.save('my_list', [x], background=True)
+    >>> x += 1  # does not change what is saved
+    >>> mx.nd.wait_saves()
+    >>> mx.nd.load('my_list')[0].asnumpy()
+    array([[ 1.,  1.,  1.],
+           [ 1.,  1.,  1.]], dtype=float32)
+    """
+    check_call(_LIB.MXNDArrayWaitAllSaves())
+
+
+_OP_HANDLES = {}
+
+def invoke_batch(ops):
+    """Invokes a list of operators in one call.
+
+    This saves the overhead of calling the operators one at a time, like in the
+    update of many parameters. The parsed parameters of the operators are cached,
+    and consecutive operators on dense arrays of the same context run as one
+    engine operation, unless autograd is recording.
+
+    Parameters
+    ----------
+    ops : list of tuple
+        Every tuple is ``(op_name, inputs, outputs, kwargs)``, with the list of
+        input arrays, the list of output arrays, which must be created, and the
+        dict of parameters of the operator.
+
+    Examples
+    --------
+    >>> w = [mx.nd.ones((2, 3)), mx.nd.ones((4,))]
+    >>> g = [mx.nd.ones((2, 3)), mx.nd.ones((4,))]
+    >>> mx.nd.invoke_batch([('sgd_update', [x, y], [x], {'lr': 0.1})
+    ...                     for x, y in zip(w, g)])
+    >>> w[1].asnumpy()
+    array([ 0.9,  0.9,  0.9,  0.9], dtype=float32)
+    """
+    creators, num_inputs, inputs, num_outputs, outputs = [], [], [], [], []
+    num_params, keys, vals = [], [], []
+    for op_name, op_inputs, op_outputs, kwargs in ops:
+        if op_name not in _OP_HANDLES:
+            hdl = OpHandle()
+            check_call(_LIB.NNGetOpHandle(c_str(op_name), ctypes.byref(hdl)))
+            _OP_HANDLES[op_name] = hdl
+        creators.append(_OP_HANDLES[op_name])
+        num_inputs.append(len(op_inputs))
+        inputs.extend(x.handle for x in op_inputs)
+        num_outputs.append(len(op_outputs))
+        outputs.extend(x.handle for x in op_outputs)
+        num_params.append(len(kwargs))
+        for key, val in kwargs.items():
+            keys.append(c_str(key))
+            vals.append(c_str(str(val)))
+    check_call(_LIB.MXImperativeInvokeBatch(
+        ctypes.c_int(len(creators)),
+        c_array(OpHandle, creators),
+        c_array(ctypes.c_int, num_inputs),
+        c_array(NDArrayHandle, inputs),
+        c_array(ctypes.c_int, num_outputs),
+        c_array(NDArrayHandle, outputs),
+        c_array(ctypes.c_int, num_params),
+        c_array(ctypes.c_char_p, keys),
+        c_array(ctypes.c_char_p, vals)))
@@ -17,14 +17,18 @@
 
 """Weight updating functions."""
 import math
+import os
 import pickle
 import logging
 import warnings
 import numpy
 from .base import py_str
-from .ndarray import (NDArray, zeros, clip, sqrt, sign, array, maximum, abs as NDabs)
+from .ndarray import (NDArray, zeros, clip, sqrt, array, maximum, cast, abs as NDabs)
 from .ndarray import (sgd_update, sgd_mom_update, adam_update, rmsprop_update, rmspropalex_update,
-                      mp_sgd_update, mp_sgd_mom_update)
+                      mp_sgd_update, mp_sgd_mom_update, multi_all_finite,
+                      multi_sgd_update, multi_sgd_mom_update, multi_mp_sgd_update,
+                      multi_mp_sgd_mom_update, lars_update, lamb_update,
+                      ftrl_update, adagrad_update)
 from .random import normal
 
 
@@ -58,11 +62,18 @@ class Optimizer(object):
 
     begin_num_update : int, optional
         The initial number of updates.
+
+    multi_precision : bool, optional
+       Flag to control the internal precision of the optimizer.
+       ``False`` results in using the same precision as the weights (default),
+       ``True`` makes internal 32-bit copy of the weights and applies gradients
+                in 32-bit precision even if actual weights used in the model have lower precision.
+                Turning this on can improve convergence and accuracy when training with float16.
     """
     def __init__(self, rescale_grad=1., param_idx2name=None, wd=0.,
                  clip_gradient=None, learning_rate=0.01,
                  lr_scheduler=None, sym=None, begin_num_update=0,
-                 param_dict=None):
+                 param_dict=None, multi_precision=False):
         self.rescale_grad = rescale_grad
         self.lr = learning_rate
         self.lr_scheduler = lr_scheduler
@@ -76,6 +87,9 @@ class Optimizer(object):
         self.num_update = begin_num_update
         self._index_update_count = {}
         self.clip_gradient = clip_gradient
+        self.multi_precision = multi_precision
+        # number of weights updated together by update() receiving lists, 0 if unsupported
+        self.aggregate_num = 0
 
         if param_idx2name is None:
             param_idx2name = {}
@@ -192,6 +206,49 @@ class Optimizer(object):
         """
         raise NotImplementedError()
 
+    def create_state_multi_precision(self, index, weight):
+        """Creates auxiliary state for a given weight, including the float32 master
+        copy of a float16 weight if `multi_precision` is on.
+
+        Parameters
+        ----------
+        index : int
+            An unique index to identify the weight.
+        weight : NDArray
+            The weight.
+
+        Returns
+        -------
+        state : any obj
+            The state associated with the weight.
+        """
+        if self.multi_precision and weight.dtype == numpy.float16:
+            weight_master_copy = weight.astype(numpy.float32)
+            return (weight_master_copy, self.create_state(index, weight_master_copy))
+        return self.create_state(index, weight)
+
+    def update_multi_precision(self, index, weight, grad, state):
+        """Updates the given parameter using the corresponding gradient and state.
+        The float16 weights with a master copy are updated in float32 and cast back.
+
+        Parameters
+        ----------
+        index : int
+            The unique index of the parameter.
+        weight : NDArray
+            The parameter to be updated.
+        grad : NDArray
+            The gradient of the objective with respect to this parameter.
+        state : any obj
+            The state returned by `create_state_multi_precision()`.
+        """
+        if self.multi_precision and weight.dtype == numpy.float16:
+            weight_master_copy, original_state = state
+            self.update(index, weight_master_copy, grad.astype(numpy.float32), original_state)
+            cast(weight_master_copy, dtype=weight.dtype, out=weight)
+        else:
+            self.update(index, weight, grad, state)
+
     def set_lr_scale(self, args_lrscale): # pylint: disable=unused-argument
         """[DEPRECATED] Sets lr scale. Use set_lr_mult instead."""
         raise DeprecationWarning
@@ -356,11 +413,25 @@ class SGD(Optimizer):
        ``True`` makes internal 32-bit copy of the weights and applies gradients
                 in 32-bit precision even if actual weights used in the model have lower precision.
                 Turning this on can improve convergence and accuracy when training with float16.
+    lazy_update : bool, optional
+       If ``True``, a ``row_sparse`` gradient only updates the rows of the weight and
+       momentum that appear in it, also when they have the default storage type.
+
+    The dense weights given together to `update` as lists are updated by groups of
+    ``MXNET_OPTIMIZER_AGGREGATION_SIZE`` weights, with one operator per group.
     """
-    def __init__(self, momentum=0.0, multi_precision=False, **kwargs):
-        super(SGD, self).__init__(**kwargs)
+    def __init__(self, momentum=0.0, multi_precision=False, lazy_update=True, **kwargs):
+        super(SGD, self).__init__(multi_precision=multi_precision, **kwargs)
         self.momentum = momentum
-        self.multi_precision = multi_precision
+        self.lazy_update = lazy_update
+        self.aggregate_num = int(os.getenv('MXNET_OPTIMIZER_AGGREGATION_SIZE', '4'))
+
+    def create_state_multi_precision(self, index, weight):
+        # the master copy is handled by create_state and the mp_sgd operators
+        return self.create_state(index, weight)
+
+    def update_multi_precision(self, index, weight, grad, state):
+        self.update(index, weight, grad, state)
 
     def create_state(self, index, weight):
         momentum = None
@@ -380,7 +451,44 @@ class SGD(Optimizer):
             momentum = zeros(weight.shape, weight.context, dtype=weight.dtype, stype=weight.stype)
         return momentum
 
+    def _update_aggregated(self, indices, weights, grads, states):
+        """Updates dense weights sharing a precision with one multi_*sgd*_update."""
+        lrs = []
+        wds = []
+        for index in indices:
+            lrs.append(self._get_lr(index))
+            wds.append(self._get_wd(index))
+            self._update_count(index)
+        kwargs = {'rescale_grad': self.rescale_grad, 'num_weights': len(indices),
+                  'lrs': lrs, 'wds': wds}
+        if self.momentum > 0:
+            kwargs['momentum'] = self.momentum
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        inputs = []
+        if isinstance(states[0], (list, tuple)):
+            for weight, grad, state in zip(weights, grads, states):
+                inputs += [weight, grad] + ([state[0]] if self.momentum > 0 else []) + [state[1]]
+            op = multi_mp_sgd_mom_update if self.momentum > 0 else multi_mp_sgd_update
+        else:
+            for weight, grad, state in zip(weights, grads, states):
+                inputs += [weight, grad] + ([state] if self.momentum > 0 else [])
+            op = multi_sgd_mom_update if self.momentum > 0 else multi_sgd_update
+        op(*inputs, out=list(weights), **kwargs)
+
     def update(self, index, weight, grad, state):
+        if isinstance(index, (list, tuple)):
+            aggregate = len(index) > 1 and \
+                all(w.stype == 'default' and g.stype == 'default'
+                    for w, g in zip(weight, grad)) and \
+                len(set((w.dtype, w.context, isinstance(s, (list, tuple)))
+                        for w, s in zip(weight, state))) == 1
+            if aggregate:
+                self._update_aggregated(index, weight, grad, state)
+            else:
+                for i, w, g, s in zip(index, weight, grad, state):
+                    self.update(i, w, g, s)
+            return
         assert(isinstance(weight, NDArray))
         assert(isinstance(grad, NDArray))
         lr = self._get_lr(index)
@@ -397,10 +505,10 @@ class SGD(Optimizer):
         if not use_multi_precision:
             if state is not None:
                 sgd_mom_update(weight, grad, state, out=weight,
-                               lr=lr, wd=wd, **kwargs)
+                               lr=lr, wd=wd, lazy_update=self.lazy_update, **kwargs)
             else:
                 sgd_update(weight, grad, out=weight,
-                           lr=lr, wd=wd, **kwargs)
+                           lr=lr, wd=wd, lazy_update=self.lazy_update, **kwargs)
         else:
             if state[0] is not None:
                 mp_sgd_mom_update(weight, grad, state[0], state[1], out=weight,
@@ -556,13 +664,17 @@ class Adam(Optimizer):
         Exponential decay rate for the second moment estimates.
     epsilon : float, optional
         Small value to avoid division by 0.
+    lazy_update : bool, optional
+       If ``True``, a ``row_sparse`` gradient only updates the rows of the weight, mean
+       and variance that appear in it, also when they have the default storage type.
     """
     def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-8,
-                 **kwargs):
+                 lazy_update=True, **kwargs):
         super(Adam, self).__init__(learning_rate=learning_rate, **kwargs)
         self.beta1 = beta1
         self.beta2 = beta2
         self.epsilon = epsilon
+        self.lazy_update = lazy_update
 
     def create_state(self, index, weight):
         return (zeros(weight.shape, weight.context, dtype=weight.dtype,
@@ -583,7 +695,7 @@ class Adam(Optimizer):
         lr *= math.sqrt(coef2)/coef1
 
         kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
-                  'rescale_grad': self.rescale_grad}
+                  'rescale_grad': self.rescale_grad, 'lazy_update': self.lazy_update}
         if self.clip_gradient:
             kwargs['clip_gradient'] = self.clip_gradient
 
@@ -591,6 +703,115 @@ class Adam(Optimizer):
         adam_update(weight, grad, mean, var, out=weight,
                     lr=lr, wd=wd, **kwargs)
 
+@register
+class LARS(Optimizer):
+    """The LARS optimizer, momentum SGD with a layer-wise learning rate.
+
+    This class implements the optimizer described in *Large Batch Training of
+    Convolutional Networks*, available at https://arxiv.org/abs/1708.03888.
+    The learning rate of every weight is scaled by the ratio of the norm of the
+    weight to the norm of its update, which keeps the training stable with very
+    large batches.
+
+    This optimizer accepts the following parameters in addition to those accepted
+    by :class:`.Optimizer`.
+
+    For details of the update algorithm, see :class:`ndarray.lars_update`.
+
+    Parameters
+    ----------
+    momentum : float, optional
+        The momentum value.
+    eta : float, optional
+        The trust coefficient of the layer-wise learning rate.
+    epsilon : float, optional
+        Small value to avoid division by 0.
+    """
+    def __init__(self, momentum=0.9, eta=0.001, epsilon=1e-9, **kwargs):
+        super(LARS, self).__init__(**kwargs)
+        self.momentum = momentum
+        self.eta = eta
+        self.epsilon = epsilon
+
+    def create_state(self, index, weight):
+        return zeros(weight.shape, weight.context, dtype=weight.dtype)
+
+    def update(self, index, weight, grad, state):
+        assert(isinstance(weight, NDArray))
+        assert(isinstance(grad, NDArray))
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        kwargs = {'momentum': self.momentum, 'eta': self.eta, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        lars_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
+
+@register
+class LAMB(Optimizer):
+    """The LAMB optimizer, Adam with a layer-wise trust ratio.
+
+    This class implements the optimizer described in *Large Batch Optimization
+    for Deep Learning: Training BERT in 76 minutes*, available at
+    https://arxiv.org/abs/1904.00962.
+
+    This optimizer accepts the following parameters in addition to those accepted
+    by :class:`.Optimizer`.
+
+    For details of the update algorithm, see :class:`ndarray.lamb_update`.
+
+    Parameters
+    ----------
+    beta1 : float, optional
+        Exponential decay rate for the first moment estimates.
+    beta2 : float, optional
+        Exponential decay rate for the second moment estimates.
+    epsilon : float, optional
+        Small value to avoid division by 0.
+    lower_bound : float, optional
+        Lower bound of the weight norm in the trust ratio.
+    upper_bound : float, optional
+        Upper bound of the weight norm in the trust ratio.
+    bias_correction : bool, optional
+        Whether to correct the bias of the moment estimates.
+    """
+    def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-6,
+                 lower_bound=None, upper_bound=None, bias_correction=True, **kwargs):
+        super(LAMB, self).__init__(learning_rate=learning_rate, **kwargs)
+        self.beta1 = beta1
+        self.beta2 = beta2
+        self.epsilon = epsilon
+        self.lower_bound = lower_bound
+        self.upper_bound = upper_bound
+        self.bias_correction = bias_correction
+
+    def create_state(self, index, weight):
+        return (zeros(weight.shape, weight.context, dtype=weight.dtype),  # mean
+                zeros(weight.shape, weight.context, dtype=weight.dtype))  # variance
+
+    def update(self, index, weight, grad, state):
+        assert(isinstance(weight, NDArray))
+        assert(isinstance(grad, NDArray))
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
+                  't': self._index_update_count[index],
+                  'bias_correction': self.bias_correction,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        if self.lower_bound is not None:
+            kwargs['lower_bound'] = self.lower_bound
+        if self.upper_bound is not None:
+            kwargs['upper_bound'] = self.upper_bound
+
+        mean, var = state
+        lamb_update(weight, grad, mean, var, out=weight, lr=lr, wd=wd, **kwargs)
+
 @register
 class AdaGrad(Optimizer):
     """AdaGrad optimizer.
@@ -602,6 +823,8 @@ class AdaGrad(Optimizer):
     This optimizer accepts the following parameters in addition to those accepted
     by :class:`.Optimizer`.
 
+    For details of the update algorithm, see :class:`ndarray.adagrad_update`.
+
     Parameters
     ----------
     eps: float, optional
@@ -612,7 +835,7 @@ class AdaGrad(Optimizer):
         self.float_stable_eps = eps
 
     def create_state(self, index, weight):
-        return zeros(weight.shape, weight.context)  # history
+        return zeros(weight.shape, weight.context, stype=weight.stype)  # history
 
     def update(self, index, weight, grad, state):
         assert(isinstance(weight, NDArray))
@@ -621,12 +844,10 @@ class AdaGrad(Optimizer):
         wd = self._get_wd(index)
         self._update_count(index)
 
-        grad = grad * self.rescale_grad
-        if self.clip_gradient is not None:
-            grad = clip(grad, -self.clip_gradient, self.clip_gradient)
-        history = state
-        history[:] += (grad * grad)
-        weight[:] += -lr * (grad / sqrt(history + self.float_stable_eps) + wd * weight)
+        kwargs = {'epsilon': self.float_stable_eps, 'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        adagrad_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
 
 @register
 class RMSProp(Optimizer):
@@ -760,6 +981,8 @@ class Ftrl(Optimizer):
     Referenced from *Ad Click Prediction: a View from the Trenches*, available at
     http://dl.acm.org/citation.cfm?id=2488200.
 
+    For details of the update algorithm, see :class:`ndarray.ftrl_update`.
+
     Parameters
     ----------
     lamda1 : float, optional
@@ -780,8 +1003,8 @@ class Ftrl(Optimizer):
         self.lr = learning_rate
 
     def create_state(self, index, weight):
-        return (zeros(weight.shape, weight.context),  # dn
-                zeros(weight.shape, weight.context))  # n
+        return (zeros(weight.shape, weight.context, stype=weight.stype),  # z
+                zeros(weight.shape, weight.context, stype=weight.stype))  # n
 
     def update(self, index, weight, grad, state):
         assert(isinstance(weight, NDArray))
@@ -790,21 +1013,12 @@ class Ftrl(Optimizer):
         wd = self._get_wd(index)
         lr = self._get_lr(index)
 
-        # preprocess grad
-        grad *= self.rescale_grad
-        if self.clip_gradient is not None:
-            grad = clip(grad, -self.clip_gradient, self.clip_gradient)
-
-        # accumulated g and delta initialization
-        dn, n = state
-
-        #update dn, n
-        dn += grad - (sqrt(n + grad * grad) - sqrt(n)) * weight / lr
-        n += grad * grad
+        kwargs = {'lamda1': self.lamda1, 'beta': self.beta, 'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
 
-        # update weight
-        weight[:] = (sign(dn) * self.lamda1 - dn) / \
-                    ((self.beta + sqrt(n)) / lr + wd) * (NDabs(dn) > self.lamda1)
+        z, n = state
+        ftrl_update(weight, grad, z, n, out=weight, lr=lr, wd=wd, **kwargs)
 
 @register
 class Adamax(Optimizer):
@@ -941,6 +1155,72 @@ class Test(Optimizer):
 # backward compatibility wrapper for Optimizer.CreateOptimizer
 create = Optimizer.create_optimizer  # pylint: disable=invalid-name
 
+class DynamicLossScaler(object):
+    """Dynamic loss scaling for float16 training.
+
+    The loss is multiplied by `loss_scale` before the backward pass, keeping the
+    small float16 gradients from flushing to zero, and the optimizer divides the
+    gradients back with ``rescale_grad``. The scale is reduced every time the
+    gradients overflow, in which case the update is skipped, and increased after
+    `scale_window` steps without overflow.
+
+    Parameters
+    ----------
+    init_scale : float, optional
+        The initial loss scale.
+    scale_factor : float, optional
+        The factor the scale is multiplied or divided by.
+    scale_window : int, optional
+        The number of steps without overflow before the scale is increased.
+
+    Examples
+    --------
+    >>> scaler = mx.optimizer.DynamicLossScaler()
+    >>> # after the backward pass on loss * scaler.loss_scale
+    >>> overflow = scaler.has_overflow(grads)
+    >>> if not overflow:
+    ...     opt.rescale_grad = 1.0 / (batch_size * scaler.loss_scale)
+    ...     # update the weights
+    >>> scaler.update_scale(overflow)
+    """
+    def __init__(self, init_scale=2.**15, scale_factor=2., scale_window=2000):
+        self.loss_scale = init_scale
+        self.scale_factor = scale_factor
+        self.scale_window = scale_window
+        self._num_good_steps = 0
+
+    def has_overflow(self, grads):
+        """Returns whether any of the gradients holds an infinity or a NaN.
+
+        Parameters
+        ----------
+        grads : list of NDArray
+            The gradients, possibly on different devices.
+        """
+        by_ctx = {}
+        for grad in grads:
+            by_ctx.setdefault(grad.context, []).append(grad)
+        finite = [multi_all_finite(*arrays, num_arrays=len(arrays))
+                  for arrays in by_ctx.values()]
+        return any(f.asscalar() == 0 for f in finite)
+
+    def update_scale(self, overflow):
+        """Updates the loss scale after a step.
+
+        Parameters
+        ----------
+        overflow : bool
+            Whether the gradients of the step overflowed.
+        """
+        if overflow:
+            self.loss_scale = max(self.loss_scale / self.scale_factor, 1.)
+            self._num_good_steps = 0
+        else:
+            self._num_good_steps += 1
+            if self._num_good_steps == self.scale_window:
+                self.loss_scale *= self.scale_factor
+                self._num_good_steps = 0
+
 class Updater(object):
     """Updater for kvstore."""
     def __init__(self, optimizer):
@@ -949,18 +1229,32 @@ class Updater(object):
         self.states_synced = {}
 
     def __call__(self, index, grad, weight):
-        """Updates weight given gradient and index."""
+        """Updates weight given gradient and index.
+
+        index, grad and weight can be lists of the weights of one device, the
+        optimizer then updates them by groups of `aggregate_num` if it supports it.
+        """
+        if not isinstance(index, (list, tuple)):
+            index, grad, weight = [index], [grad], [weight]
         # convert ctypes.char_p.value back to python str if needed
-        if isinstance(index, bytes):
-            index = py_str(index)
-        if index not in self.states:
-            self.states[index] = self.optimizer.create_state(index, weight)
-            self.states_synced[index] = True
-        elif not self.states_synced[index]:
-            self.states[index] = \
-                self.sync_state_context(self.states[index], weight.context)
-            self.states_synced[index] = True
-        self.optimizer.update(index, weight, grad, self.states[index])
+        index = [py_str(i) if isinstance(i, bytes) else i for i in index]
+        for i, w in zip(index, weight):
+            if i not in self.states:
+                self.states[i] = self.optimizer.create_state_multi_precision(i, w)
+                self.states_synced[i] = True
+            elif not self.states_synced[i]:
+                self.states[i] = self.sync_state_context(self.states[i], w.context)
+                self.states_synced[i] = True
+        aggregate_num = self.optimizer.aggregate_num
+        if aggregate_num > 1 and len(index) > 1:
+            for start in range(0, len(index), aggregate_num):
+                end = start + aggregate_num
+                self.optimizer.update_multi_precision(
+                    index[start:end], weight[start:end], grad[start:end],
+                    [self.states[i] for i in index[start:end]])
+        else:
+            for i, w, g in zip(index, weight, grad):
+                self.optimizer.update_multi_precision(i, w, g, self.states[i])
 
     def sync_state_context(self, state, context):
         if isinstance(state, NDArray):
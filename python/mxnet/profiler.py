@@ -22,7 +22,8 @@
 from __future__ import absolute_import
 
 import ctypes
-from .base import _LIB, check_call, c_str
+from .base import _LIB, check_call, c_str, py_str, mx_uint
+from .context import current_context
 
 def profiler_set_config(mode='symbolic', filename='profile.json'):
     """Set up the configure of profiler.
@@ -52,7 +53,67 @@ def profiler_set_state(state='stop'):
     state2int = {'stop': 0, 'run': 1}
     check_call(_LIB.MXSetProfilerState(ctypes.c_int(state2int[state])))
 
-def dump_profile():
+def dump_profile(finished=True):
     """Dump profile and stop profiler. Use this to save profile
-    in advance in case your program cannot exit normally."""
-    check_call(_LIB.MXDumpProfile())
+    in advance in case your program cannot exit normally.
+
+    Parameters
+    ----------
+    finished : boolean, optional
+        Whether to stop the profiler and complete the trace file. If False,
+        only the operators recorded since the last dump are written, the
+        profiler keeps running and the next dump appends to the same file.
+        Defaults to True.
+    """
+    check_call(_LIB.MXDumpProfileEx(ctypes.c_int(finished)))
+
+def dumps(reset=False):
+    """Return a printable table of the aggregated operator statistics.
+
+    For every operator on every device, the table lists how often it ran
+    and the total, min, max, average, median and 99th percentile of its
+    duration in microseconds since the profiler was started or reset.
+
+    Parameters
+    ----------
+    reset : boolean, optional
+        Whether to clear the aggregated statistics afterwards.
+        Defaults to False.
+    """
+    debug_str = ctypes.c_char_p()
+    check_call(_LIB.MXAggregateProfileStatsPrint(ctypes.byref(debug_str),
+                                                 ctypes.c_int(reset)))
+    return py_str(debug_str.value)
+
+def storage_stats(ctx=None):
+    """Get memory allocation statistics of a context.
+
+    Parameters
+    ----------
+    ctx : Context, optional
+        The context to query. Defaults to the current context.
+
+    Returns
+    -------
+    dict of str to int
+        Bytes in use, bytes cached by the memory pool, peak bytes in use,
+        and the number of allocations, frees, pool misses and times the
+        pool released all its cached memory.
+
+    Examples
+    --------
+    >>> a = mx.nd.ones((1024, 1024))
+    >>> mx.profiler.storage_stats(mx.cpu())['bytes_in_use']
+    4194304
+    """
+    if ctx is None:
+        ctx = current_context()
+    size = mx_uint()
+    keys = ctypes.POINTER(ctypes.c_char_p)()
+    vals = ctypes.POINTER(ctypes.c_uint64)()
+    check_call(_LIB.MXStorageGetStats(ctypes.c_int(ctx.device_typeid),
+                                      ctypes.c_int(ctx.device_id),
+                                      ctypes.byref(size),
+                                      ctypes.byref(keys),
+                                      ctypes.byref(vals)))
+    return {py_str(keys[i]): vals[i] for i in range(size.value)}
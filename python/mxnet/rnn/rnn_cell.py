@@ -535,8 +535,9 @@ class GRUCell(BaseRNNCell):
 
 class FusedRNNCell(BaseRNNCell):
     """Fusing RNN layers across time step into one kernel.
-    Improves speed but is less flexible. Currently only
-    supported if using cuDNN on GPU.
+    Improves speed but is less flexible. Runs with cuDNN on GPU
+    and with a fused implementation on CPU, where dropout between
+    the layers is not supported yet.
 
     Parameters
     ----------
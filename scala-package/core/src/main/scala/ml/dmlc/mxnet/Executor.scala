@@ -17,6 +17,8 @@
 
 package ml.dmlc.mxnet
 
+import java.nio.ByteBuffer
+
 import ml.dmlc.mxnet.Base._
 
 import scala.collection.mutable.ArrayBuffer
@@ -190,6 +192,34 @@ class Executor private[mxnet](private[mxnet] val handle: ExecutorHandle,
     forward(isTrain = false)
   }
 
+  /**
+   * Run an inference pass on a batch held in direct ByteBuffers, crossing JNI
+   * once: the inputs are copied into the named arguments, the forward pass
+   * runs and the outputs are copied into outputBuffers, without Java arrays.
+   * Every buffer holds its elements in the dtype of its NDArray and the native
+   * byte order, see NDArray.allocateDirectBuffer.
+   * @param inputs Direct buffers of the arguments to set, by name.
+   * @param outputBuffers Direct buffers receiving the outputs, one per output.
+   */
+  def predict(inputs: Map[String, ByteBuffer], outputBuffers: Array[ByteBuffer]): Unit = {
+    require(outputBuffers.length == outputs.length,
+      s"expect ${outputs.length} output buffers, got ${outputBuffers.length}")
+    val (names, inputBuffers) = inputs.toArray.unzip
+    val inputArrays = names.map { name =>
+      require(argDict.contains(name), s"Unknown argument $name")
+      argDict(name)
+    }
+    (inputArrays zip inputBuffers).foreach { case (arr, buf) =>
+      NDArray.checkDirectBuffer(buf, DType.numOfBytes(arr.dtype) * arr.size)
+    }
+    (outputs zip outputBuffers).foreach { case (arr, buf) =>
+      NDArray.checkDirectBuffer(buf, DType.numOfBytes(arr.dtype) * arr.size)
+    }
+    checkCall(_LIB.mxExecutorPredict(handle,
+      inputArrays.map(_.handle), inputBuffers, inputArrays.map(_.size),
+      outputs.map(_.handle), outputBuffers, outputs.map(_.size)))
+  }
+
   /**
    * Do backward pass to get the gradient of arguments.
    * @param outGrads Gradient on the outputs to be propagated back.
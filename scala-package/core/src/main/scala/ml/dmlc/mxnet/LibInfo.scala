@@ -17,6 +17,8 @@
 
 package ml.dmlc.mxnet
 
+import java.nio.ByteBuffer
+
 import ml.dmlc.mxnet.Base._
 
 import scala.collection.mutable.{ArrayBuffer, ListBuffer}
@@ -93,6 +95,12 @@ private[mxnet] class LibInfo {
   @native def mxNDArraySyncCopyFromCPU(handle: NDArrayHandle,
                                        source: Array[MXFloat],
                                        size: Int): Int
+  @native def mxNDArraySyncCopyFromBuffer(handle: NDArrayHandle,
+                                          source: ByteBuffer,
+                                          size: Int): Int
+  @native def mxNDArraySyncCopyToBuffer(handle: NDArrayHandle,
+                                        target: ByteBuffer,
+                                        size: Int): Int
   @native def mxNDArrayLoad(fname: String,
                             outSize: MXUintRef,
                             handles: ArrayBuffer[NDArrayHandle],
@@ -180,6 +188,13 @@ private[mxnet] class LibInfo {
   @native def mxExecutorOutputs(handle: ExecutorHandle, outputs: ArrayBuffer[NDArrayHandle]): Int
   @native def mxExecutorFree(handle: ExecutorHandle): Int
   @native def mxExecutorForward(handle: ExecutorHandle, isTrain: Int): Int
+  @native def mxExecutorPredict(handle: ExecutorHandle,
+                                inputs: Array[NDArrayHandle],
+                                inputBufs: Array[ByteBuffer],
+                                inputSizes: Array[Int],
+                                outputs: Array[NDArrayHandle],
+                                outputBufs: Array[ByteBuffer],
+                                outputSizes: Array[Int]): Int
   @native def mxExecutorBackward(handle: ExecutorHandle,
                                  grads: Array[NDArrayHandle]): Int
   @native def mxExecutorPrint(handle: ExecutorHandle, debugStr: RefString): Int
@@ -37,6 +37,21 @@ object NDArray {
 
   private val functions: Map[String, NDArrayFunction] = initNDArrayModule()
 
+  private[mxnet] def checkDirectBuffer(buffer: ByteBuffer, numBytes: Int): Unit = {
+    require(buffer.isDirect, "only direct ByteBuffers can be copied without a Java array")
+    require(buffer.capacity >= numBytes,
+      s"buffer capacity (${buffer.capacity}) is smaller than the NDArray ($numBytes bytes)")
+  }
+
+  /**
+   * Allocate a direct ByteBuffer in the native byte order, large enough for
+   * the elements of an NDArray of the given shape and dtype.
+   */
+  def allocateDirectBuffer(shape: Shape, dtype: DType = Base.MX_REAL_TYPE): ByteBuffer = {
+    ByteBuffer.allocateDirect(DType.numOfBytes(dtype) * shape.product)
+      .order(ByteOrder.nativeOrder())
+  }
+
   private def addDependency(froms: Array[NDArray], tos: Array[NDArray]): Unit = {
     froms.foreach { from =>
       val weakRef = new WeakReference(from)
@@ -622,6 +637,28 @@ class NDArray private[mxnet](private[mxnet] val handle: NDArrayHandle,
     checkCall(_LIB.mxNDArraySyncCopyFromCPU(handle, source, source.length))
   }
 
+  /**
+   * Perform a synchronized copy from a direct ByteBuffer, without going through
+   * a Java array. The buffer holds the elements in the dtype of the array and
+   * the native byte order, starting from its beginning.
+   * @param source The direct buffer we should like to copy from.
+   */
+  def copyFromBuffer(source: ByteBuffer): Unit = {
+    NDArray.checkDirectBuffer(source, DType.numOfBytes(dtype) * size)
+    checkCall(_LIB.mxNDArraySyncCopyFromBuffer(handle, source, size))
+  }
+
+  /**
+   * Perform a synchronized copy into a direct ByteBuffer, without going through
+   * a Java array. The elements are written from the beginning of the buffer in
+   * the dtype of the array and the native byte order.
+   * @param target The direct buffer we should like to copy to.
+   */
+  def copyToBuffer(target: ByteBuffer): Unit = {
+    NDArray.checkDirectBuffer(target, DType.numOfBytes(dtype) * size)
+    checkCall(_LIB.mxNDArraySyncCopyToBuffer(handle, target, size))
+  }
+
   /**
    * Return a sliced NDArray that shares memory with current one.
    * NDArray only support continuous slicing on axis 0
@@ -77,4 +77,20 @@ class ExecutorSuite extends FunSuite with BeforeAndAfterAll {
     exec.forward(isTrain = false)
     assert(exec.outputs(0).toArray.forall(_ == 4))
   }
+
+  test("predict from direct buffers") {
+    val x = Symbol.Variable("x")
+    val y = Symbol.FullyConnected()()(Map("data" -> x, "num_hidden" -> 4))
+
+    val exec = y.simpleBind(Context.cpu(), "null", shapeDict = Map("x" -> Shape(5, 4)))
+    exec.argArrays(1).set(1)
+    exec.argArrays(2).set(1)
+
+    val input = NDArray.allocateDirectBuffer(Shape(5, 4))
+    (0 until 20).foreach(i => input.putFloat(i * 4, 2f))
+    val output = NDArray.allocateDirectBuffer(Shape(5, 4))
+    exec.predict(Map("x" -> input), Array(output))
+    assert((0 until 20).forall(i => output.getFloat(i * 4) == 9f))
+    assert(exec.outputs(0).toArray.forall(_ == 9))
+  }
 }
@@ -575,4 +575,23 @@ class NDArraySuite extends FunSuite with BeforeAndAfterAll with Matchers {
     assert(arr.internal.toDoubleArray === Array(2d, 2d))
     assert(arr.internal.toByteArray === Array(2.toByte, 2.toByte))
   }
+
+  test("copy from and to direct buffer") {
+    val buffer = NDArray.allocateDirectBuffer(Shape(2, 3))
+    (0 until 6).foreach(i => buffer.putFloat(i * 4, i.toFloat))
+    val arr = NDArray.empty(2, 3)
+    arr.copyFromBuffer(buffer)
+    assert(arr.toArray === Array(0f, 1f, 2f, 3f, 4f, 5f))
+
+    val doubled = NDArray.allocateDirectBuffer(Shape(2, 3))
+    (arr * 2).copyToBuffer(doubled)
+    assert((0 until 6).map(i => doubled.getFloat(i * 4)) === Seq(0f, 2f, 4f, 6f, 8f, 10f))
+
+    intercept[IllegalArgumentException] {
+      arr.copyFromBuffer(java.nio.ByteBuffer.allocate(24))
+    }
+    intercept[IllegalArgumentException] {
+      arr.copyToBuffer(NDArray.allocateDirectBuffer(Shape(2, 2)))
+    }
+  }
 }
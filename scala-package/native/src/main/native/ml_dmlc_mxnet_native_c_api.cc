@@ -422,6 +422,22 @@ JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxNDArraySyncCopyFromCPU
   return ret;
 }
 
+// Direct ByteBuffers live outside of the Java heap and are not moved by the GC,
+// the NDArrays copy from and to their memory without an intermediate Java array.
+JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxNDArraySyncCopyFromBuffer
+  (JNIEnv *env, jobject obj, jlong arrayPtr, jobject sourceBuf, jint size) {
+  void *sourcePtr = env->GetDirectBufferAddress(sourceBuf);
+  return MXNDArraySyncCopyFromCPU(reinterpret_cast<NDArrayHandle>(arrayPtr),
+                                  sourcePtr, size);
+}
+
+JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxNDArraySyncCopyToBuffer
+  (JNIEnv *env, jobject obj, jlong arrayPtr, jobject targetBuf, jint size) {
+  void *targetPtr = env->GetDirectBufferAddress(targetBuf);
+  return MXNDArraySyncCopyToCPU(reinterpret_cast<NDArrayHandle>(arrayPtr),
+                                targetPtr, size);
+}
+
 JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxNDArrayGetContext
   (JNIEnv *env, jobject obj, jlong arrayPtr, jobject devTypeId, jobject devId) {
   int outDevType;
@@ -869,6 +885,41 @@ JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxExecutorForward
   return MXExecutorForward(reinterpret_cast<ExecutorHandle>(ptr), static_cast<int>(isTrain));
 }
 
+JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxExecutorPredict
+  (JNIEnv *env, jobject obj, jlong executorPtr,
+    jlongArray inputs, jobjectArray inputBufs, jintArray inputSizes,
+    jlongArray outputs, jobjectArray outputBufs, jintArray outputSizes) {
+  // one call per batch: copy the inputs in, run the forward pass
+  // and copy the outputs out
+  int numInputs = env->GetArrayLength(inputs);
+  int numOutputs = env->GetArrayLength(outputs);
+  jlong *inputArr = env->GetLongArrayElements(inputs, NULL);
+  jint *inputSizeArr = env->GetIntArrayElements(inputSizes, NULL);
+  jlong *outputArr = env->GetLongArrayElements(outputs, NULL);
+  jint *outputSizeArr = env->GetIntArrayElements(outputSizes, NULL);
+  int ret = 0;
+  for (int i = 0; i < numInputs && ret == 0; ++i) {
+    jobject buf = env->GetObjectArrayElement(inputBufs, i);
+    ret = MXNDArraySyncCopyFromCPU(reinterpret_cast<NDArrayHandle>(inputArr[i]),
+                                   env->GetDirectBufferAddress(buf), inputSizeArr[i]);
+    env->DeleteLocalRef(buf);
+  }
+  if (ret == 0) {
+    ret = MXExecutorForward(reinterpret_cast<ExecutorHandle>(executorPtr), 0);
+  }
+  for (int i = 0; i < numOutputs && ret == 0; ++i) {
+    jobject buf = env->GetObjectArrayElement(outputBufs, i);
+    ret = MXNDArraySyncCopyToCPU(reinterpret_cast<NDArrayHandle>(outputArr[i]),
+                                 env->GetDirectBufferAddress(buf), outputSizeArr[i]);
+    env->DeleteLocalRef(buf);
+  }
+  env->ReleaseLongArrayElements(inputs, inputArr, JNI_ABORT);
+  env->ReleaseIntArrayElements(inputSizes, inputSizeArr, JNI_ABORT);
+  env->ReleaseLongArrayElements(outputs, outputArr, JNI_ABORT);
+  env->ReleaseIntArrayElements(outputSizes, outputSizeArr, JNI_ABORT);
+  return ret;
+}
+
 JNIEXPORT jint JNICALL Java_ml_dmlc_mxnet_LibInfo_mxExecutorBackward
   (JNIEnv * env, jobject obj, jlong executorPtr, jlongArray grads) {
   int gradsSize = env->GetArrayLength(grads);
@@ -38,11 +38,16 @@
 #include <sstream>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <map>
 #include <memory>
 #include <functional>
 #include <utility>
 #include "./c_api_common.h"
 #include "../operator/custom/custom-inl.h"
+#include "../engine/openmp.h"
 #include "../engine/profiler.h"
 
 using namespace mxnet;
@@ -95,6 +100,12 @@ int MXNotifyShutdown() {
   API_END();
 }
 
+int MXEngineSetBulkSize(int bulk_size, int* prev_bulk_size) {
+  API_BEGIN();
+  *prev_bulk_size = Engine::Get()->set_bulk_size(bulk_size);
+  API_END();
+}
+
 int MXSetProfilerConfig(int mode, const char* filename) {
   // mode, kOnlySymbolic: 0, kAllOperator: 1
   API_BEGIN();
@@ -119,6 +130,31 @@ int MXDumpProfile() {
   API_END()
 }
 
+int MXDumpProfileEx(int finished) {
+  API_BEGIN();
+#if MXNET_USE_PROFILER
+  engine::Profiler *profiler = engine::Profiler::Get();
+  CHECK(profiler->IsEnableOutput())
+    << "Profiler haven't been run. Config and start profiler first";
+  profiler->DumpProfile(finished != 0);
+#else
+  LOG(FATAL) << "Need to compile with USE_PROFILER=1 for MXNet Profiler";
+#endif
+  API_END()
+}
+
+int MXAggregateProfileStatsPrint(const char **out_str, int reset) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+#if MXNET_USE_PROFILER
+  ret->ret_str = engine::Profiler::Get()->AggregateStatsPrint(reset != 0);
+  *out_str = ret->ret_str.c_str();
+#else
+  LOG(FATAL) << "Need to compile with USE_PROFILER=1 for MXNet Profiler";
+#endif
+  API_END();
+}
+
 int MXSetProfilerState(int state) {
   // state, kNotRunning: 0, kRunning: 1
   API_BEGIN();
@@ -133,6 +169,41 @@ int MXSetProfilerState(int state) {
 int MXSetNumOMPThreads(int thread_num) {
   API_BEGIN();
   omp_set_num_threads(thread_num);
+  engine::OpenMP::Get()->set_thread_max(thread_num);
+  API_END();
+}
+
+int MXStorageGetStats(int dev_type, int dev_id,
+                      mx_uint *out_size,
+                      const char ***out_keys,
+                      const uint64_t **out_vals) {
+  static const char* keys[] = {
+    "bytes_in_use", "bytes_cached", "peak_bytes_in_use",
+    "num_alloc", "num_free", "num_miss", "num_release_all"
+  };
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  Storage::Stats stats = Storage::Get()->GetStats(ctx);
+  ret->ret_vec_uint64 = {
+    stats.bytes_in_use, stats.bytes_cached, stats.peak_bytes_in_use,
+    stats.num_alloc, stats.num_free, stats.num_miss, stats.num_release_all
+  };
+  *out_size = static_cast<mx_uint>(ret->ret_vec_uint64.size());
+  *out_keys = keys;
+  *out_vals = dmlc::BeginPtr(ret->ret_vec_uint64);
+  API_END();
+}
+
+int MXStorageRegisterHostMemory(void *data, size_t size) {
+  API_BEGIN();
+  Storage::Get()->RegisterHostMemory(data, size);
+  API_END();
+}
+
+int MXStorageUnregisterHostMemory(void *data) {
+  API_BEGIN();
+  Storage::Get()->UnregisterHostMemory(data);
   API_END();
 }
 
@@ -232,6 +303,71 @@ int MXNDArraySaveRawBytes(NDArrayHandle handle,
   API_END();
 }
 
+int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid,
+                                int* shared_id) {
+  API_BEGIN();
+  static_cast<NDArray*>(handle)->GetSharedMemHandle(shared_pid, shared_id);
+  API_END();
+}
+
+int MXNDArrayCreateFromSharedMem(int shared_pid, int shared_id, const mx_uint *shape,
+                                 mx_uint ndim, int dtype, NDArrayHandle *out) {
+  API_BEGIN();
+  *out = new NDArray(shared_pid, shared_id, TShape(shape, shape + ndim), dtype);
+  API_END();
+}
+
+int MXNDArrayExportCUDAIPC(NDArrayHandle handle,
+                           size_t *out_size,
+                           const char **out_buf,
+                           uint64_t *out_offset) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  size_t offset;
+  static_cast<NDArray*>(handle)->ExportCUDAIPC(&ret->ret_str, &offset);
+  *out_size = ret->ret_str.length();
+  *out_buf = ret->ret_str.c_str();
+  *out_offset = offset;
+  API_END();
+}
+
+int MXNDArrayImportCUDAIPC(const char *buf,
+                           size_t size,
+                           uint64_t offset,
+                           const mx_uint *shape,
+                           mx_uint ndim,
+                           int dtype,
+                           int dev_id,
+                           NDArrayHandle *out) {
+  API_BEGIN();
+  *out = new NDArray(NDArray::ImportCUDAIPC(std::string(buf, size), offset,
+                                            TShape(shape, shape + ndim), dtype, dev_id));
+  API_END();
+}
+
+int MXNDArrayToDLPack(NDArrayHandle handle,
+                      DLManagedTensorHandle *out_dlpack) {
+  API_BEGIN();
+  *out_dlpack = static_cast<NDArray*>(handle)->ToDLPack();
+  API_END();
+}
+
+int MXNDArrayFromDLPack(DLManagedTensorHandle dlpack,
+                        NDArrayHandle *out_handle) {
+  API_BEGIN();
+  *out_handle = new NDArray(NDArray::FromDLPack(static_cast<DLManagedTensor*>(dlpack)));
+  API_END();
+}
+
+int MXNDArrayCallDLPackDeleter(DLManagedTensorHandle dlpack) {
+  API_BEGIN();
+  if (dlpack != nullptr) {
+    DLManagedTensor* tensor = static_cast<DLManagedTensor*>(dlpack);
+    if (tensor->deleter != nullptr) tensor->deleter(tensor);
+  }
+  API_END();
+}
+
 int MXNDArraySyncCopyFromCPU(NDArrayHandle handle,
                              const void *data,
                              size_t size) {
@@ -248,6 +384,18 @@ int MXNDArraySyncCopyToCPU(NDArrayHandle handle,
   API_END();
 }
 
+int MXNDArrayCopyToCPUAsync(NDArrayHandle handle,
+                            void *data,
+                            size_t size,
+                            NDArrayCopyCallback callback,
+                            void *callback_param) {
+  API_BEGIN();
+  static_cast<NDArray*>(handle)->CopyToCPUAsync(data, size, [callback, callback_param]() {
+      if (callback != nullptr) callback(callback_param);
+    });
+  API_END();
+}
+
 /*!
  * \brief Copy src.data() to dst.data() if i = -1, else dst.aux_data(i) if i >= 0
  * This function blocks. Do not use it in performance critical code.
@@ -271,6 +419,20 @@ int MXNDArrayWaitToRead(NDArrayHandle handle) {
   API_END();
 }
 
+int MXNDArrayIsReady(NDArrayHandle handle, int *out) {
+  API_BEGIN();
+  *out = static_cast<NDArray*>(handle)->IsReady() ? 1 : 0;
+  API_END();
+}
+
+int MXNDArrayOnReady(NDArrayHandle handle,
+                     void (*callback)(void *),
+                     void *param) {
+  API_BEGIN();
+  static_cast<NDArray*>(handle)->OnReady([callback, param]() { callback(param); });
+  API_END();
+}
+
 int MXNDArrayWaitToWrite(NDArrayHandle handle) {
   API_BEGIN();
   static_cast<NDArray*>(handle)->WaitToWrite();
@@ -283,42 +445,149 @@ int MXNDArrayWaitAll() {
   API_END();
 }
 
-int MXNDArraySave(const char* fname,
-                  mx_uint num_args,
-                  NDArrayHandle* args,
-                  const char** keys) {
-  API_BEGIN();
-  std::vector<NDArray> data(num_args);
-  std::vector<std::string> names;
+namespace {
+/*! \brief collect the arrays and names to save */
+void GetSaveArgs(mx_uint num_args, NDArrayHandle* args, const char** keys,
+                 std::vector<NDArray>* data, std::vector<std::string>* names) {
+  data->resize(num_args);
   for (mx_uint i = 0; i < num_args; ++i) {
-    data[i] = *static_cast<NDArray*>(args[i]);
+    (*data)[i] = *static_cast<NDArray*>(args[i]);
   }
   if (keys != nullptr) {
-    names.resize(num_args);
+    names->resize(num_args);
     for (mx_uint i = 0; i < num_args; ++i) {
-      names[i] = keys[i];
+      (*names)[i] = keys[i];
     }
   }
-  {
-    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
-    mxnet::NDArray::Save(fo.get(), data, names);
-  }
-  API_END();
 }
 
-int MXNDArrayLoad(const char* fname,
-                  mx_uint *out_size,
-                  NDArrayHandle** out_arr,
-                  mx_uint *out_name_size,
-                  const char*** out_names) {
+/*!
+ * \brief writes snapshots of arrays to files on a background thread. The
+ *  snapshots are engine copies on the cpu, ordered after the pending writes
+ *  of the arrays and before the next ones, so the arrays can be updated as
+ *  soon as the copies are pushed.
+ */
+class AsyncSaver {
+ public:
+  static AsyncSaver* Get() {
+    static AsyncSaver inst;
+    return &inst;
+  }
+
+  ~AsyncSaver() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      exit_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+  }
+
+  void Save(const std::string& fname, std::vector<NDArray> data,
+            std::vector<std::string> names, bool mappable) {
+    for (auto& nd : data) {
+      if (nd.is_none()) continue;
+      // pinned memory makes the copies from the gpus asynchronous
+      nd = nd.Copy(nd.ctx().dev_mask() == cpu::kDevMask ? Context::CPU() :
+                   Context::CPUPinned(nd.ctx().dev_id));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (!worker_.joinable()) worker_ = std::thread([this]() { Run(); });
+      jobs_.push_back(Job{fname, std::move(data), std::move(names), mappable});
+    }
+    cv_.notify_all();
+  }
+
+  /*! \brief wait for the pending saves, fails with the first error since the last wait */
+  void WaitAll() {
+    std::unique_lock<std::mutex> lock(mu_);
+    done_.wait(lock, [this]() { return jobs_.empty() && !busy_; });
+    std::string error;
+    error.swap(error_);
+    lock.unlock();
+    CHECK(error.empty()) << error;
+  }
+
+ private:
+  struct Job {
+    std::string fname;
+    std::vector<NDArray> data;
+    std::vector<std::string> names;
+    bool mappable;
+  };
+
+  AsyncSaver() : engine_ref_(Engine::_GetSharedRef()) {}
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      cv_.wait(lock, [this]() { return exit_ || !jobs_.empty(); });
+      if (jobs_.empty()) return;
+      Job job = std::move(jobs_.front());
+      jobs_.pop_front();
+      busy_ = true;
+      lock.unlock();
+      std::string error;
+      try {
+        std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(job.fname.c_str(), "w"));
+        if (job.mappable) {
+          mxnet::NDArray::SaveMappable(fo.get(), job.data, job.names);
+        } else {
+          mxnet::NDArray::Save(fo.get(), job.data, job.names);
+        }
+      } catch (const dmlc::Error& e) {
+        error = "Failed to save " + job.fname + ": " + e.what();
+      }
+      // free the snapshots before waking up the waiters
+      job.data.clear();
+      lock.lock();
+      if (error_.empty()) error_ = error;
+      busy_ = false;
+      done_.notify_all();
+    }
+  }
+
+  /*! \brief the engine must outlive the snapshots */
+  std::shared_ptr<Engine> engine_ref_;
+  std::mutex mu_;
+  std::condition_variable cv_, done_;
+  std::deque<Job> jobs_;
+  /*! \brief whether a job is being written */
+  bool busy_ = false;
+  bool exit_ = false;
+  std::string error_;
+  std::thread worker_;
+};
+
+/*!
+ * \brief load the arrays of a file in either format, the mappable one is memory
+ *  mapped, and keep the ones of select, or all if it is empty
+ */
+void LoadArrays(const char* fname, const std::vector<std::string>& select,
+                mx_uint *out_size, NDArrayHandle** out_arr,
+                mx_uint *out_name_size, const char*** out_names) {
   MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
   ret->ret_vec_str.clear();
-  API_BEGIN();
   std::vector<NDArray> data;
   std::vector<std::string> &names = ret->ret_vec_str;
-  {
-    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
-    mxnet::NDArray::Load(fi.get(), &data, &names);
+  if (!mxnet::NDArray::LoadMapped(fname, select, &data, &names)) {
+    {
+      std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
+      mxnet::NDArray::Load(fi.get(), &data, &names);
+    }
+    if (!select.empty()) {
+      CHECK_EQ(names.size(), data.size())
+          << "Cannot select arrays by name in " << fname << ", which has no names";
+      std::map<std::string, NDArray> arrays;
+      for (size_t i = 0; i < names.size(); ++i) arrays[names[i]] = data[i];
+      data.clear();
+      for (const auto& name : select) {
+        CHECK(arrays.count(name)) << "Cannot find array " << name << " in " << fname;
+        data.push_back(arrays[name]);
+      }
+      names = select;
+    }
   }
   ret->ret_handles.resize(data.size());
   for (size_t i = 0; i < data.size(); ++i) {
@@ -334,6 +603,80 @@ int MXNDArrayLoad(const char* fname,
   *out_arr = dmlc::BeginPtr(ret->ret_handles);
   *out_name_size = static_cast<mx_uint>(names.size());
   *out_names = dmlc::BeginPtr(ret->ret_vec_charp);
+}
+}  // namespace
+
+int MXNDArraySave(const char* fname,
+                  mx_uint num_args,
+                  NDArrayHandle* args,
+                  const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  GetSaveArgs(num_args, args, keys, &data, &names);
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::Save(fo.get(), data, names);
+  }
+  API_END();
+}
+
+int MXNDArraySaveMappable(const char* fname,
+                          mx_uint num_args,
+                          NDArrayHandle* args,
+                          const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  GetSaveArgs(num_args, args, keys, &data, &names);
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::SaveMappable(fo.get(), data, names);
+  }
+  API_END();
+}
+
+int MXNDArraySaveAsync(const char* fname,
+                       mx_uint num_args,
+                       NDArrayHandle* args,
+                       const char** keys,
+                       int mappable) {
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  GetSaveArgs(num_args, args, keys, &data, &names);
+  AsyncSaver::Get()->Save(fname, std::move(data), std::move(names), mappable != 0);
+  API_END();
+}
+
+int MXNDArrayWaitAllSaves() {
+  API_BEGIN();
+  AsyncSaver::Get()->WaitAll();
+  API_END();
+}
+
+int MXNDArrayLoad(const char* fname,
+                  mx_uint *out_size,
+                  NDArrayHandle** out_arr,
+                  mx_uint *out_name_size,
+                  const char*** out_names) {
+  API_BEGIN();
+  LoadArrays(fname, std::vector<std::string>(), out_size, out_arr,
+             out_name_size, out_names);
+  API_END();
+}
+
+int MXNDArrayLoadSelected(const char* fname,
+                          mx_uint num_select,
+                          const char** select,
+                          mx_uint *out_size,
+                          NDArrayHandle** out_arr,
+                          mx_uint *out_name_size,
+                          const char*** out_names) {
+  API_BEGIN();
+  std::vector<std::string> names(select, select + num_select);
+  CHECK_GT(names.size(), 0U) << "No array is selected";
+  LoadArrays(fname, names, out_size, out_arr, out_name_size, out_names);
   API_END();
 }
 
@@ -987,6 +1330,19 @@ int MXKVStoreSendCommmandToServers(KVStoreHandle handle,
   API_END();
 }
 
+int MXKVStoreSetGradientCompression(KVStoreHandle handle,
+                                    mx_uint num_params,
+                                    const char** keys,
+                                    const char** vals) {
+  API_BEGIN();
+  std::vector<std::pair<std::string, std::string> > kwargs;
+  for (mx_uint i = 0; i < num_params; ++i) {
+    kwargs.emplace_back(keys[i], vals[i]);
+  }
+  static_cast<KVStore*>(handle)->SetGradientCompression(kwargs);
+  API_END();
+}
+
 int MXKVStoreGetType(KVStoreHandle handle,
                      const char** type) {
   API_BEGIN();
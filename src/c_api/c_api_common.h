@@ -70,6 +70,8 @@ struct MXAPIThreadLocalEntry {
   std::vector<std::string> ret_vec_str;
   /*! \brief result holder for returning string pointers */
   std::vector<const char *> ret_vec_charp;
+  /*! \brief result holder for returning uint64 values */
+  std::vector<uint64_t> ret_vec_uint64;
   /*! \brief result holder for returning handles */
   std::vector<void *> ret_handles;
   /*! \brief result holder for returning shapes */
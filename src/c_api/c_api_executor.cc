@@ -24,6 +24,10 @@
 #include <mxnet/base.h>
 #include <mxnet/c_api.h>
 #include <mxnet/executor.h>
+#include <dmlc/json.h>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "./c_api_common.h"
 
 int MXExecutorPrint(ExecutorHandle handle, const char **out_str) {
@@ -37,6 +41,49 @@ int MXExecutorPrint(ExecutorHandle handle, const char **out_str) {
   API_END();
 }
 
+/*! \return the name of a context, like gpu(0) */
+static std::string ContextName(const Context& ctx) {
+  std::ostringstream os;
+  os << ctx;
+  return os.str();
+}
+
+int MXExecutorGetMemoryPlan(ExecutorHandle handle, const char **out_json) {
+  Executor *exec = static_cast<Executor*>(handle);
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  std::vector<Executor::MemoryPlanEntry> entries;
+  std::vector<Executor::MemoryPlanTotal> totals;
+  exec->GetMemoryPlan(&entries, &totals);
+  std::ostringstream json;
+  json << "{\n  \"entries\": [";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const Executor::MemoryPlanEntry& e = entries[i];
+    json << (i == 0 ? "\n    " : ",\n    ") << "{";
+    // JSONWriter escapes the name
+    std::ostringstream name;
+    dmlc::JSONWriter(&name).WriteString(e.name);
+    json << "\"name\": " << name.str()
+         << ", \"storage_id\": " << e.storage_id
+         << ", \"bytes\": " << e.bytes
+         << ", \"req\": " << e.req
+         << ", \"inplace_input\": " << e.inplace_input
+         << ", \"context\": \"" << ContextName(e.ctx) << "\"}";
+  }
+  json << "\n  ],\n  \"totals\": [";
+  for (size_t i = 0; i < totals.size(); ++i) {
+    const Executor::MemoryPlanTotal& t = totals[i];
+    json << (i == 0 ? "\n    " : ",\n    ")
+         << "{\"context\": \"" << ContextName(t.ctx) << "\""
+         << ", \"forward_bytes\": " << t.forward_bytes
+         << ", \"train_bytes\": " << t.train_bytes << "}";
+  }
+  json << "\n  ]\n}";
+  ret->ret_str = json.str();
+  *out_json = (ret->ret_str).c_str();
+  API_END();
+}
+
 int MXExecutorFree(ExecutorHandle handle) {
   API_BEGIN();
   delete static_cast<Executor*>(handle);
@@ -89,6 +136,15 @@ int MXExecutorOutputs(ExecutorHandle handle,
   API_END();
 }
 
+int MXExecutorNextInput(ExecutorHandle handle,
+                        const char *name,
+                        NDArrayHandle *out) {
+  API_BEGIN();
+  Executor *exec = static_cast<Executor*>(handle);
+  *out = new NDArray(exec->NextInput(name));
+  API_END();
+}
+
 int MXExecutorBind(SymbolHandle symbol_handle,
                    int dev_type,
                    int dev_id,
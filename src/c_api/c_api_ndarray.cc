@@ -25,12 +25,18 @@
 
 #include <mxnet/base.h>
 #include <mxnet/c_api.h>
+#include <mxnet/executor.h>
 #include <mxnet/operator.h>
 #include <mxnet/operator_util.h>
 #include <mxnet/op_attr_types.h>
 #include <nnvm/node.h>
 #include <nnvm/op_attr_types.h>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include "./c_api_common.h"
 #include "../common/utils.h"
 #include "../ndarray/autograd.h"
@@ -59,6 +65,50 @@ void SetOpAttrs(const nnvm::Op *op,
   }
 }
 
+/*! \brief whether the imperative path caches parsed attributes and inference results */
+inline bool ImperativeCacheEnabled() {
+  static bool enabled = dmlc::GetEnv("MXNET_IMPERATIVE_CACHE", true);
+  return enabled;
+}
+
+/*!
+ * \brief get the parsed attributes of an op, which are cached by op, number
+ *  of inputs and parameters.
+ * \param key set to the key of the attributes, which keys the cache of
+ *  SetShapeType, or to empty if caching is disabled
+ */
+nnvm::NodeAttrs GetCachedOpAttrs(const nnvm::Op *op,
+                                 int num_inputs,
+                                 int num_params,
+                                 const char **param_keys,
+                                 const char **param_vals,
+                                 std::string* key) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, nnvm::NodeAttrs> cache;
+  const size_t kMaxCacheSize = 4096;
+  key->clear();
+  if (!ImperativeCacheEnabled()) {
+    nnvm::NodeAttrs attrs;
+    SetOpAttrs(op, &attrs, num_inputs, num_params, param_keys, param_vals);
+    return attrs;
+  }
+  *key = op->name + '\0' + std::to_string(num_inputs);
+  for (int i = 0; i < num_params; ++i) {
+    key->append(1, '\0').append(param_keys[i]).append(1, '\0').append(param_vals[i]);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(*key);
+    if (it != cache.end()) return it->second;
+  }
+  nnvm::NodeAttrs attrs;
+  SetOpAttrs(op, &attrs, num_inputs, num_params, param_keys, param_vals);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() >= kMaxCacheSize) cache.clear();
+  cache[*key] = attrs;
+  return attrs;
+}
+
 void SetNumOutputs(const nnvm::Op *op,
                    const nnvm::NodeAttrs& attrs,
                    const int& num_inputs,
@@ -139,8 +189,8 @@ void SetContext(Context* p_ctx,
   } else {
     ctx = default_ctx;
   }
-  // Pinned context doesn't propagate
-  if (ctx.dev_type == Context::kCPUPinned) {
+  // Pinned and shared contexts don't propagate
+  if (ctx.dev_type == Context::kCPUPinned || ctx.dev_type == Context::kCPUShared) {
     ctx = Context::CPU();
   }
 #if !MXNET_USE_CUDA
@@ -151,14 +201,13 @@ void SetContext(Context* p_ctx,
 #endif  // MXNET_USE_CUDA
 }
 
-// Set the shape, dtype and storage type
-void SetShapeType(const nnvm::Op* op,
-                  const nnvm::NodeAttrs& attrs,
-                  const Context& ctx,
-                  const std::vector<NDArray>& ndinputs,
-                  std::vector<NDArray>* p_ndoutputs,
-                  int* dispatch_stype) {
-  std::vector<NDArray>& ndoutputs = *p_ndoutputs;
+// Infer the shape, dtype and storage type into the thread local entry
+void InferShapeType(const nnvm::Op* op,
+                    const nnvm::NodeAttrs& attrs,
+                    const Context& ctx,
+                    const std::vector<NDArray>& ndinputs,
+                    const std::vector<NDArray>& ndoutputs,
+                    int* dispatch_stype) {
   static auto& infershape = nnvm::Op::GetAttr<nnvm::FInferShape>("FInferShape");
   static auto& infertype = nnvm::Op::GetAttr<nnvm::FInferType>("FInferType");
   static auto& inferstorage = nnvm::Op::GetAttr<FInferStorageType>("FInferStorageType");
@@ -217,6 +266,120 @@ void SetShapeType(const nnvm::Op* op,
   contains_non_default |= common::ContainsNonDefaultStorage(out_storage_types);
   int kNonDefaultStorage = -2;
   *dispatch_stype = contains_non_default ? kNonDefaultStorage : kDefaultStorage;
+}
+
+/*! \brief results of the inference of SetShapeType */
+struct InferResult {
+  std::vector<TShape> in_shapes, out_shapes;
+  std::vector<int> in_types, out_types;
+  std::vector<int> out_storage_types;
+  int dispatch_stype;
+};
+
+/*! \brief per thread cache of the inference results of SetShapeType */
+struct InferCache {
+  std::unordered_map<std::string, InferResult> results;
+  std::string key;
+};
+
+/*! \brief append the shape, type and storage type of arrays to a cache key */
+inline void AppendInferKey(const std::vector<NDArray>& arrays, std::string* key) {
+  for (const auto& nd : arrays) {
+    key->append(1, '|');
+    if (nd.is_none()) continue;
+    for (index_t i = 0; i < nd.shape().ndim(); ++i) {
+      key->append(std::to_string(nd.shape()[i])).append(1, ',');
+    }
+    key->append(std::to_string(nd.dtype())).append(1, ',')
+        .append(std::to_string(nd.storage_type()));
+  }
+}
+
+/*!
+ * \brief per thread cache of the states of the legacy operators called
+ *  imperatively, so that their operators, with the cuDNN descriptors and the
+ *  algorithms they chose, are created once for every combination of parameters,
+ *  context and input shapes and types. The engine variable of a state
+ *  serializes the calls sharing it.
+ */
+struct OpStateCache {
+  std::unordered_map<std::string, OpStatePtr> states;
+  std::string key;
+  // the states delete their variables in the engine
+  std::shared_ptr<Engine> engine_ref{Engine::_GetSharedRef()};
+};
+
+// Get the state of a stateful operator, from the cache for the legacy operators
+OpStatePtr GetOpState(const nnvm::Op* op,
+                      const nnvm::NodeAttrs& attrs,
+                      const Context& ctx,
+                      const std::vector<NDArray>& ndinputs,
+                      const std::string& attr_key) {
+  static auto& createop = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
+  static auto& is_legacy = nnvm::Op::GetAttr<bool>("TIsLegacyOp");
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  // autograd keeps the state of the recorded operators for their backward
+  if (attr_key.empty() || !is_legacy.get(op, false) ||
+      AutogradRuntime::Get()->IsRecording()) {
+    return createop[op](attrs, ctx, ret->arg_shapes, ret->arg_types);
+  }
+  OpStateCache* cache = dmlc::ThreadLocalStore<OpStateCache>::Get();
+  cache->key = attr_key;
+  cache->key.append(1, '|').append(std::to_string(ctx.dev_type))
+      .append(1, ',').append(std::to_string(ctx.dev_id));
+  AppendInferKey(ndinputs, &cache->key);
+  auto it = cache->states.find(cache->key);
+  if (it != cache->states.end()) return it->second;
+  auto state = createop[op](attrs, ctx, ret->arg_shapes, ret->arg_types);
+  const size_t kMaxCacheSize = 256;
+  if (cache->states.size() >= kMaxCacheSize) cache->states.clear();
+  cache->states[cache->key] = state;
+  return state;
+}
+
+// Set the shape, dtype and storage type
+void SetShapeType(const nnvm::Op* op,
+                  const nnvm::NodeAttrs& attrs,
+                  const Context& ctx,
+                  const std::vector<NDArray>& ndinputs,
+                  std::vector<NDArray>* p_ndoutputs,
+                  int* dispatch_stype,
+                  const std::string& attr_key = std::string()) {
+  std::vector<NDArray>& ndoutputs = *p_ndoutputs;
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  std::vector<TShape>& in_shapes  = ret->arg_shapes;
+  std::vector<TShape>& out_shapes = ret->out_shapes;
+  std::vector<int>& in_types = ret->arg_types;
+  std::vector<int>& out_types = ret->out_types;
+  auto& out_storage_types = ret->out_storage_types;
+  // the inference only depends on the attributes, the context and the arrays
+  InferCache* cache = nullptr;
+  InferResult* cached = nullptr;
+  if (!attr_key.empty()) {
+    cache = dmlc::ThreadLocalStore<InferCache>::Get();
+    cache->key = attr_key;
+    cache->key.append(1, '|').append(std::to_string(ctx.dev_mask()));
+    AppendInferKey(ndinputs, &cache->key);
+    AppendInferKey(ndoutputs, &cache->key);
+    auto it = cache->results.find(cache->key);
+    if (it != cache->results.end()) cached = &it->second;
+  }
+  if (cached != nullptr) {
+    in_shapes = cached->in_shapes;
+    out_shapes = cached->out_shapes;
+    in_types = cached->in_types;
+    out_types = cached->out_types;
+    out_storage_types = cached->out_storage_types;
+    *dispatch_stype = cached->dispatch_stype;
+  } else {
+    InferShapeType(op, attrs, ctx, ndinputs, ndoutputs, dispatch_stype);
+    if (cache != nullptr) {
+      const size_t kMaxCacheSize = 4096;
+      if (cache->results.size() >= kMaxCacheSize) cache->results.clear();
+      cache->results[cache->key] = InferResult{in_shapes, out_shapes, in_types, out_types,
+                                               out_storage_types, *dispatch_stype};
+    }
+  }
   for (size_t i = 0; i < ndoutputs.size(); ++i) {
     NDArrayStorageType storage_type = static_cast<NDArrayStorageType>(out_storage_types[i]);
     if (ndoutputs[i].is_none()) {
@@ -263,8 +426,9 @@ void SetDependency(std::vector<engine::VarHandle> *p_read_vars,
        case ResourceRequest::kTempSpace:
         ++ntmp;
        case ResourceRequest::kRandom:
+       case ResourceRequest::kParallelRandom:
         requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
+        if (requested.back().var != nullptr) write_vars.push_back(requested.back().var);
         break;
        default:
         LOG(FATAL) << "resource type not yet supported";
@@ -316,10 +480,9 @@ void PushFCompute(const FCompute& fn,
                   const std::vector<uint32_t>& mutate_idx) {
   using namespace common;
   bool is_train = AutogradRuntime::Get()->IsTraining();
-  Engine::Get()->PushAsync(
-    [ctx, attrs, fn, ndinputs, ndoutputs, requested, is_train, mutate_idx](
-        RunContext rctx,
-        engine::CallbackOnComplete on_complete) {
+  Engine::Get()->PushSync(
+    [ctx, op, attrs, fn, ndinputs, ndoutputs, requested, is_train, mutate_idx](
+        RunContext rctx) {
       std::vector<TBlob> input_blobs, output_blobs;
       // pre-fcompute and post-fcompute storage fallback src NDArrays and dst NDArrays
       std::vector<NDArray> pre_temp_src, pre_temp_dst, post_temp_dst, post_temp_src;
@@ -342,21 +505,20 @@ void PushFCompute(const FCompute& fn,
       std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
       if (ctx.dev_mask() == gpu::kDevMask) {
 #if MXNET_USE_CUDA
-        CastNonDefaultStorage<gpu>(pre_temp_src, pre_temp_dst, opctx);
+        CastNonDefaultStorage<gpu>(pre_temp_src, pre_temp_dst, opctx, false, op->name);
         fn(attrs, opctx, input_blobs, req, output_blobs);
         // cast to original storage type, if necessary
-        CastNonDefaultStorage<gpu>(post_temp_src, post_temp_dst, opctx);
-        rctx.get_stream<gpu>()->Wait();
+        CastNonDefaultStorage<gpu>(post_temp_src, post_temp_dst, opctx, false, op->name);
+        if (!rctx.is_bulk) rctx.get_stream<gpu>()->Wait();
 #else
         LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
       } else {
-        CastNonDefaultStorage<cpu>(pre_temp_src, pre_temp_dst, opctx);
+        CastNonDefaultStorage<cpu>(pre_temp_src, pre_temp_dst, opctx, false, op->name);
         fn(attrs, opctx, input_blobs, req, output_blobs);
         // cast to original storage type, if necessary
-        CastNonDefaultStorage<cpu>(post_temp_src, post_temp_dst, opctx);
+        CastNonDefaultStorage<cpu>(post_temp_src, post_temp_dst, opctx, false, op->name);
       }
-      on_complete();
     }, ctx, read_vars, write_vars, FnProperty::kNormal,
     0, PROFILER_MESSAGE(op->name.c_str()));
 }
@@ -370,10 +532,8 @@ void PushFComputeEx(const FComputeEx& fn,
                     const std::vector<Resource>& requested,
                     const std::vector<NDArray>& ndinputs,
                     const std::vector<NDArray>& ndoutputs) {
-  Engine::Get()->PushAsync(
-    [ctx, attrs, fn, ndinputs, ndoutputs, requested](
-        RunContext rctx,
-        engine::CallbackOnComplete on_complete) {
+  Engine::Get()->PushSync(
+    [ctx, attrs, fn, ndinputs, ndoutputs, requested](RunContext rctx) {
       std::vector<TBlob> input_blobs, output_blobs;
       OpContext opctx{false, rctx,
                       engine::CallbackOnComplete(),
@@ -381,10 +541,9 @@ void PushFComputeEx(const FComputeEx& fn,
       std::vector<OpReqType> req(ndoutputs.size(), kWriteTo);
       SetWriteInplaceReq(ndinputs, ndoutputs, &req);
       fn(attrs, opctx, ndinputs, req, ndoutputs);
-      if (ctx.dev_mask() == gpu::kDevMask) {
+      if (ctx.dev_mask() == gpu::kDevMask && !rctx.is_bulk) {
         rctx.get_stream<gpu>()->Wait();
       }
-      on_complete();
     }, ctx, read_vars, write_vars, FnProperty::kNormal,
     0, PROFILER_MESSAGE(op->name.c_str()));
 }
@@ -412,7 +571,7 @@ void PushOperator(const OpStatePtr& state,
   if (fcompute != nullptr) {
     CHECK(exec_type == ExecType::kSync || exec_type == ExecType::kAsync);
     Engine::Get()->PushAsync(
-      [state, fcompute, ndinputs, ndoutputs, requested, is_train, exec_type, mutate_idx](
+      [state, op, fcompute, ndinputs, ndoutputs, requested, is_train, exec_type, mutate_idx](
           RunContext rctx,
           engine::CallbackOnComplete on_complete) {
         OpContext opctx{is_train, rctx, on_complete, requested};
@@ -435,16 +594,16 @@ void PushOperator(const OpStatePtr& state,
         std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
         if (rctx.get_ctx().dev_mask() == gpu::kDevMask) {
 #if MXNET_USE_CUDA
-          CastNonDefaultStorage<gpu>(pre_temp_src, pre_temp_dst, opctx);
+          CastNonDefaultStorage<gpu>(pre_temp_src, pre_temp_dst, opctx, false, op->name);
           fcompute(state, opctx, input_blobs, req, output_blobs);
-          CastNonDefaultStorage<gpu>(post_temp_src, post_temp_dst, opctx);
+          CastNonDefaultStorage<gpu>(post_temp_src, post_temp_dst, opctx, false, op->name);
 #else
           LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
         } else {
-          CastNonDefaultStorage<cpu>(pre_temp_src, pre_temp_dst, opctx);
+          CastNonDefaultStorage<cpu>(pre_temp_src, pre_temp_dst, opctx, false, op->name);
           fcompute(state, opctx, input_blobs, req, output_blobs);
-          CastNonDefaultStorage<cpu>(post_temp_src, post_temp_dst, opctx);
+          CastNonDefaultStorage<cpu>(post_temp_src, post_temp_dst, opctx, false, op->name);
         }
         if (exec_type == ExecType::kSync) {
           if (rctx.get_ctx().dev_mask() == gpu::kDevMask) {
@@ -483,15 +642,42 @@ void PushOperator(const OpStatePtr& state,
   }
 }
 
+// Make the outputs views of the input when the operator only takes blocks of it
+bool SetOutputViews(const nnvm::Op* op,
+                    const nnvm::NodeAttrs& attrs,
+                    const std::vector<NDArray>& ndinputs,
+                    std::vector<NDArray>* p_ndoutputs) {
+  static auto& foutput_views = nnvm::Op::GetAttr<FOutputViews>("FOutputViews");
+  static const bool enabled = dmlc::GetEnv("MXNET_IMPERATIVE_SLICE_VIEW", false);
+  std::vector<NDArray>& ndoutputs = *p_ndoutputs;
+  // the recorded operators need their outputs computed for the backward pass
+  if (!enabled || !foutput_views.count(op) || ndinputs.size() != 1 ||
+      AutogradRuntime::Get()->IsRecording() ||
+      ndinputs[0].storage_type() != kDefaultStorage) return false;
+  std::vector<size_t> offsets;
+  if (!foutput_views[op](attrs, ndinputs[0].shape(), &offsets) ||
+      offsets.size() != ndoutputs.size()) return false;
+  for (const NDArray& out : ndoutputs) {
+    if (out.storage_type() != kDefaultStorage || out.dtype() != ndinputs[0].dtype()) return false;
+  }
+  NDArray flat = ndinputs[0].Reshape(mshadow::Shape1(ndinputs[0].shape().Size()));
+  for (size_t i = 0; i < ndoutputs.size(); ++i) {
+    const index_t begin = offsets[i];
+    const TShape shape = ndoutputs[i].shape();
+    ndoutputs[i] = flat.Slice(begin, begin + shape.Size()).Reshape(shape);
+  }
+  return true;
+}
+
 void ImperativeInvokeImpl(const Context& default_ctx,
                           nnvm::NodeAttrs&& attrs,
                           std::vector<NDArray>* p_ndinputs,
                           std::vector<NDArray>* p_ndoutputs,
                           std::vector<bool>* p_save_inputs = nullptr,
-                          std::vector<bool>* p_save_outputs = nullptr) {
+                          std::vector<bool>* p_save_outputs = nullptr,
+                          const std::string& attr_key = std::string()) {
   static auto& ndfunc = nnvm::Op::GetAttr<FNDArrayFunction>("FNDArrayFunction");
   static auto& createop = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
-  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
 
   const nnvm::Op *op = attrs.op;
   std::vector<NDArray>& ndinputs  = *p_ndinputs;
@@ -504,8 +690,12 @@ void ImperativeInvokeImpl(const Context& default_ctx,
     // TODO(piiswrong): infer ctx
     Context ctx;
     int stype;
+    // outputs given by the caller are written to, the others may be views
+    bool new_outputs = true;
+    for (const NDArray& out : ndoutputs) new_outputs = new_outputs && out.is_none();
     SetContext(&ctx, attrs, ndinputs, ndoutputs, default_ctx);
-    SetShapeType(op, attrs, ctx, ndinputs, &ndoutputs, &stype);
+    SetShapeType(op, attrs, ctx, ndinputs, &ndoutputs, &stype, attr_key);
+    if (new_outputs && SetOutputViews(op, attrs, ndinputs, &ndoutputs)) return;
 
     std::vector<engine::VarHandle> read_vars, write_vars;
     std::vector<Resource> requested;
@@ -532,8 +722,7 @@ void ImperativeInvokeImpl(const Context& default_ctx,
             p_save_inputs, p_save_outputs);
       }
     } else if (createop.count(op)) {
-      auto state =
-          createop[op](attrs, ctx, ret->arg_shapes, ret->arg_types);
+      auto state = GetOpState(op, attrs, ctx, ndinputs, attr_key);
       write_vars.push_back(state.get_var());
       PushOperator(state, op, attrs, ctx, read_vars, write_vars,
           requested, ndinputs, ndoutputs, mutate_idx);
@@ -563,8 +752,9 @@ int MXImperativeInvoke(AtomicSymbolCreator creator,
   NDArray** outarray = *reinterpret_cast<NDArray***>(outputs);
 
   API_BEGIN();
-  nnvm::NodeAttrs attrs;
-  SetOpAttrs(op, &attrs, num_inputs, num_params, param_keys, param_vals);
+  std::string attr_key;
+  nnvm::NodeAttrs attrs = GetCachedOpAttrs(op, num_inputs, num_params,
+                                           param_keys, param_vals, &attr_key);
 
   int infered_num_outputs;
   int num_visible_outputs;
@@ -574,7 +764,8 @@ int MXImperativeInvoke(AtomicSymbolCreator creator,
   SetNDInputsOutputs(op, &ndinputs, &ndoutputs, num_inputs, inputs,
       num_outputs, infered_num_outputs, num_visible_outputs, outarray);
 
-  ImperativeInvokeImpl(Context::CPU(), std::move(attrs), &ndinputs, &ndoutputs);
+  ImperativeInvokeImpl(Context::CPU(), std::move(attrs), &ndinputs, &ndoutputs,
+                       nullptr, nullptr, attr_key);
 
   if (outarray == nullptr) {
     ret->ret_handles.clear();
@@ -613,11 +804,239 @@ int MXImperativeInvokeEx(AtomicSymbolCreator creator,
   API_END();
 }
 
+/*! \brief an op of a batched invocation run in a bulked engine operation */
+struct BulkedOp {
+  FCompute fn;
+  nnvm::NodeAttrs attrs;
+  std::vector<NDArray> ndinputs;
+  std::vector<NDArray> ndoutputs;
+  std::vector<Resource> requested;
+};
+
+/*! \brief push the ops as one engine operation running them in order */
+void PushBulkedOps(std::vector<BulkedOp>* ops,
+                   const Context& ctx,
+                   std::vector<engine::VarHandle>* read_vars,
+                   std::vector<engine::VarHandle>* write_vars) {
+  if (ops->empty()) return;
+  Engine::Get()->DeduplicateVarHandle(read_vars, write_vars);
+  bool is_train = AutogradRuntime::Get()->IsTraining();
+  auto bulk = std::make_shared<std::vector<BulkedOp> >(std::move(*ops));
+  Engine::Get()->PushAsync(
+    [ctx, bulk, is_train](RunContext rctx, engine::CallbackOnComplete on_complete) {
+      std::vector<TBlob> input_blobs, output_blobs;
+      std::vector<OpReqType> req;
+      for (const auto& op : *bulk) {
+        input_blobs.clear();
+        output_blobs.clear();
+        for (const auto& nd : op.ndinputs) input_blobs.push_back(nd.data());
+        for (const auto& nd : op.ndoutputs) output_blobs.push_back(nd.data());
+        req.assign(output_blobs.size(), kWriteTo);
+        OpContext opctx{is_train, rctx, engine::CallbackOnComplete(), op.requested};
+        op.fn(op.attrs, opctx, input_blobs, req, output_blobs);
+      }
+      if (ctx.dev_mask() == gpu::kDevMask) {
+        rctx.get_stream<gpu>()->Wait();
+      }
+      on_complete();
+    }, ctx, *read_vars, *write_vars, FnProperty::kNormal,
+    0, PROFILER_MESSAGE("ImperativeBulk"));
+  ops->clear();
+  read_vars->clear();
+  write_vars->clear();
+}
+
+int MXImperativeInvokeBatch(int num_ops,
+                            AtomicSymbolCreator *creators,
+                            const int *num_inputs,
+                            NDArrayHandle *inputs,
+                            const int *num_outputs,
+                            NDArrayHandle *outputs,
+                            const int *num_params,
+                            const char **param_keys,
+                            const char **param_vals) {
+  static auto& ndfunc = nnvm::Op::GetAttr<FNDArrayFunction>("FNDArrayFunction");
+  API_BEGIN();
+  // consecutive dense FCompute ops on the same context are run by one engine
+  // operation. The others, and all ops while recording, are pushed alone.
+  const bool recording = AutogradRuntime::Get()->IsRecording();
+  std::vector<BulkedOp> bulk;
+  std::vector<engine::VarHandle> bulk_read_vars, bulk_write_vars;
+  Context bulk_ctx;
+  size_t input_pos = 0, output_pos = 0, param_pos = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    const nnvm::Op* op = static_cast<nnvm::Op*>(creators[i]);
+    std::string attr_key;
+    nnvm::NodeAttrs attrs = GetCachedOpAttrs(op, num_inputs[i], num_params[i],
+                                             param_keys + param_pos, param_vals + param_pos,
+                                             &attr_key);
+    int infered_num_outputs;
+    int num_visible_outputs;
+    SetNumOutputs(op, attrs, num_inputs[i], &infered_num_outputs, &num_visible_outputs);
+    std::vector<NDArray> ndinputs, ndoutputs;
+    NDArray** outarray = reinterpret_cast<NDArray**>(outputs + output_pos);
+    int num_out = num_outputs[i];
+    SetNDInputsOutputs(op, &ndinputs, &ndoutputs, num_inputs[i], inputs + input_pos,
+        &num_out, infered_num_outputs, num_visible_outputs, outarray);
+    input_pos += num_inputs[i];
+    output_pos += num_outputs[i];
+    param_pos += num_params[i];
+
+    bool bulked = false;
+    if (!recording && !ndfunc.count(op)) {
+      Context ctx;
+      int stype;
+      SetContext(&ctx, attrs, ndinputs, ndoutputs, Context::CPU());
+      SetShapeType(op, attrs, ctx, ndinputs, &ndoutputs, &stype, attr_key);
+      FCompute fn = common::GetFCompute<FCompute>(op, "FCompute", ctx);
+      if (fn != nullptr && stype == kDefaultStorage) {
+        if (!bulk.empty() && bulk_ctx != ctx) {
+          PushBulkedOps(&bulk, bulk_ctx, &bulk_read_vars, &bulk_write_vars);
+        }
+        BulkedOp bop;
+        std::vector<uint32_t> mutate_idx;
+        SetDependency(&bulk_read_vars, &bulk_write_vars, &bop.requested, &mutate_idx,
+            op, attrs, ctx, ndinputs, ndoutputs);
+        bop.fn = fn;
+        bop.attrs = std::move(attrs);
+        bop.ndinputs = ndinputs;
+        bop.ndoutputs = ndoutputs;
+        bulk.push_back(std::move(bop));
+        bulk_ctx = ctx;
+        bulked = true;
+      }
+    }
+    if (!bulked) {
+      PushBulkedOps(&bulk, bulk_ctx, &bulk_read_vars, &bulk_write_vars);
+      ImperativeInvokeImpl(Context::CPU(), std::move(attrs), &ndinputs, &ndoutputs,
+                           nullptr, nullptr, attr_key);
+    }
+    for (int j = 0; j < num_out; ++j) {
+      *outarray[j] = std::move(ndoutputs[j]);
+    }
+  }
+  PushBulkedOps(&bulk, bulk_ctx, &bulk_read_vars, &bulk_write_vars);
+  API_END();
+}
+
+/*!
+ * \brief State of a cached op created with static_alloc. The graph runs in an
+ *  executor bound for the last input signature, so memory is planned once
+ *  and the nodes are pushed in bulk. Inputs that keep the same array between
+ *  calls, like parameters, are bound directly. The others are copied into
+ *  arrays owned by the executor.
+ */
+struct CachedOpStatic {
+  /*! \brief the symbol of the graph */
+  nnvm::Symbol sym;
+  /*! \brief position of every argument in the inputs of the cached op */
+  std::vector<size_t> arg_pos;
+  /*! \brief position of every auxiliary state in the inputs of the cached op */
+  std::vector<size_t> aux_pos;
+  /*! \brief protects the fields below */
+  std::mutex mutex;
+  /*! \brief the input signature the executor is bound for */
+  std::string signature;
+  /*! \brief the executor */
+  std::unique_ptr<Executor> exec;
+  /*! \brief the arrays the executor is bound to, one per input */
+  std::vector<NDArray> bound;
+  /*! \brief whether an input is copied into its bound array on every call */
+  std::vector<bool> copied;
+};
+
+/*!
+ * \brief run a cached op created with static_alloc. The outputs are copied
+ *  out of the executor, so that they stay valid across calls.
+ */
+void InvokeStaticCachedOp(CachedOpStatic* st,
+                          const Context& default_ctx,
+                          const std::vector<NDArray>& inputs,
+                          std::vector<NDArray>* outputs) {
+  std::lock_guard<std::mutex> lock(st->mutex);
+  std::ostringstream os;
+  for (const auto& nd : inputs) {
+    os << nd.shape() << ',' << nd.dtype() << ',' << nd.storage_type() << ','
+       << nd.ctx().dev_type << ',' << nd.ctx().dev_id << ';';
+  }
+  std::string signature = os.str();
+  if (st->copied.empty()) st->copied.resize(inputs.size(), false);
+  bool rebind = st->exec == nullptr || signature != st->signature;
+  std::vector<bool> is_aux(inputs.size(), false);
+  for (size_t i : st->aux_pos) is_aux[i] = true;
+  if (!rebind) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (st->copied[i] || inputs[i].var() == st->bound[i].var()) continue;
+      // auxiliary states can be updated by the graph and sparse inputs can
+      // change their storage shape, so they are always bound directly
+      if (!is_aux[i] && inputs[i].storage_type() == kDefaultStorage) {
+        st->copied[i] = true;
+      }
+      rebind = true;
+    }
+  }
+  if (rebind) {
+    st->bound.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (st->copied[i] && !is_aux[i] && inputs[i].storage_type() == kDefaultStorage) {
+        st->bound[i] = NDArray(inputs[i].shape(), inputs[i].ctx(), false, inputs[i].dtype());
+      } else {
+        st->bound[i] = inputs[i];
+      }
+    }
+    std::vector<NDArray> in_args, aux_states;
+    for (size_t i : st->arg_pos) in_args.push_back(st->bound[i]);
+    for (size_t i : st->aux_pos) aux_states.push_back(st->bound[i]);
+    std::vector<NDArray> arg_grads(in_args.size());
+    std::vector<OpReqType> grad_reqs(in_args.size(), kNullOp);
+    // share the memory of the previous executor
+    Executor* exec = Executor::Bind(st->sym, default_ctx, std::map<std::string, Context>(),
+                                    in_args, arg_grads, grad_reqs, aux_states, st->exec.get());
+    st->exec.reset(exec);
+    st->signature = signature;
+  }
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (inputs[i].var() != st->bound[i].var()) CopyFromTo(inputs[i], &st->bound[i]);
+  }
+  st->exec->Forward(AutogradRuntime::Get()->IsTraining());
+  const std::vector<NDArray>& exec_outputs = st->exec->outputs();
+  outputs->resize(exec_outputs.size());
+  for (size_t i = 0; i < exec_outputs.size(); ++i) {
+    const NDArray& src = exec_outputs[i];
+    NDArray& dst = outputs->at(i);
+    if (dst.is_none()) {
+      if (src.storage_type() == kDefaultStorage) {
+        dst = NDArray(src.shape(), src.ctx(), true, src.dtype());
+      } else {
+        dst = NDArray(src.storage_type(), src.shape(), src.ctx(), true, src.dtype());
+      }
+    }
+    CopyFromTo(src, &dst);
+  }
+}
+
 int MXCreateCachedOp(SymbolHandle handle,
                      CachedOpHandle *out) {
+  return MXCreateCachedOpEx(handle, 0, nullptr, nullptr, out);
+}
+
+int MXCreateCachedOpEx(SymbolHandle handle,
+                       int num_flags,
+                       const char** keys,
+                       const char** vals,
+                       CachedOpHandle *out) {
   nnvm::Symbol* sym = static_cast<nnvm::Symbol*>(handle);
 
   API_BEGIN();
+  bool static_alloc = false;
+  for (int i = 0; i < num_flags; ++i) {
+    std::string key(keys[i]), val(vals[i]);
+    if (key == "static_alloc") {
+      static_alloc = val == "1" || val == "true" || val == "True";
+    } else {
+      LOG(FATAL) << "Unknown flag " << key << " for CachedOp";
+    }
+  }
   nnvm::Graph *g = new nnvm::Graph;
   g->outputs = sym->outputs;
   auto vars = sym->ListInputs(nnvm::Symbol::kAll);
@@ -637,6 +1056,21 @@ int MXCreateCachedOp(SymbolHandle handle,
   g->attrs["save_inputs"] = std::make_shared<dmlc::any>(std::move(save_inputs));
   g->attrs["save_outputs"] = std::make_shared<dmlc::any>(std::move(save_outputs));
 
+  if (static_alloc) {
+    auto st = std::make_shared<CachedOpStatic>();
+    st->sym = *sym;
+    const auto& inputs = g->GetAttr<std::vector<nnvm::NodePtr> >("vars");
+    std::unordered_map<const nnvm::Node*, size_t> pos;
+    for (size_t i = 0; i < inputs.size(); ++i) pos[inputs[i].get()] = i;
+    for (const auto& n : sym->ListInputs(nnvm::Symbol::kReadOnlyArgs)) {
+      st->arg_pos.push_back(pos.at(n.get()));
+    }
+    for (const auto& n : sym->ListInputs(nnvm::Symbol::kAuxiliaryStates)) {
+      st->aux_pos.push_back(pos.at(n.get()));
+    }
+    g->attrs["static_alloc"] = std::make_shared<dmlc::any>(std::move(st));
+  }
+
   *out = g;
   API_END();
 }
@@ -669,43 +1103,61 @@ int MXInvokeCachedOp(CachedOpHandle handle,
       << "Actually number of inputs differs from expected number of inputs";
   Context default_ctx = static_cast<NDArray*>(inputs[0])->ctx();
 
-  std::vector<NDArray> buff(idx.num_node_entries());
-  for (size_t i = 0; i < vars.size(); ++i) {
-    buff[idx.entry_id(idx.node_id(vars[i].get()), 0)] =
-        *static_cast<NDArray*>(inputs[i]);
+  std::vector<NDArray> result;
+  if (outarray != nullptr) {
+    CHECK_EQ(static_cast<size_t>(*num_outputs), idx.outputs().size())
+        << "Specifed number of output differs from expected number of outputs";
   }
-
-  for (size_t i = 0; i < idx.num_nodes(); ++i) {
-    const nnvm::IndexedGraph::Node& node = idx[i];
-    if (node.source->attrs.op == nullptr) continue;
+  // autograd records every node, so it needs the node by node execution
+  if (g->attrs.count("static_alloc") && !AutogradRuntime::Get()->IsRecording()) {
+    auto st = g->GetAttr<std::shared_ptr<CachedOpStatic> >("static_alloc");
     std::vector<NDArray> in;
-    in.reserve(node.inputs.size());
-    for (const auto& j : node.inputs) {
-      in.emplace_back(buff[idx.entry_id(j)]);
+    for (int i = 0; i < num_inputs; ++i) {
+      in.emplace_back(*static_cast<NDArray*>(inputs[i]));
+    }
+    if (outarray != nullptr) {
+      for (int i = 0; i < *num_outputs; ++i) result.emplace_back(*outarray[i]);
+    }
+    InvokeStaticCachedOp(st.get(), default_ctx, in, &result);
+  } else {
+    std::vector<NDArray> buff(idx.num_node_entries());
+    for (size_t i = 0; i < vars.size(); ++i) {
+      buff[idx.entry_id(idx.node_id(vars[i].get()), 0)] =
+          *static_cast<NDArray*>(inputs[i]);
     }
-    std::vector<NDArray> out(node.source->num_outputs());
-    ImperativeInvokeImpl(default_ctx, nnvm::NodeAttrs(node.source->attrs), &in, &out,
-                         &save_inputs[i], &save_outputs[i]);
 
-    for (size_t j = 0; j < node.source->num_outputs(); ++j) {
-      buff[idx.entry_id(i, j)] = std::move(out[j]);
+    for (size_t i = 0; i < idx.num_nodes(); ++i) {
+      const nnvm::IndexedGraph::Node& node = idx[i];
+      if (node.source->attrs.op == nullptr) continue;
+      std::vector<NDArray> in;
+      in.reserve(node.inputs.size());
+      for (const auto& j : node.inputs) {
+        in.emplace_back(buff[idx.entry_id(j)]);
+      }
+      std::vector<NDArray> out(node.source->num_outputs());
+      ImperativeInvokeImpl(default_ctx, nnvm::NodeAttrs(node.source->attrs), &in, &out,
+                           &save_inputs[i], &save_outputs[i]);
+
+      for (size_t j = 0; j < node.source->num_outputs(); ++j) {
+        buff[idx.entry_id(i, j)] = std::move(out[j]);
+      }
+    }
+    for (const auto& i : idx.outputs()) {
+      result.emplace_back(buff[idx.entry_id(i)]);
     }
   }
 
   if (outarray == nullptr) {
     ret->ret_handles.clear();
-    for (const auto& i : idx.outputs()) {
+    for (const auto& nd : result) {
       ret->ret_handles.push_back(
-        reinterpret_cast<NDArrayHandle>(
-          new NDArray(buff[idx.entry_id(i)])));
+        reinterpret_cast<NDArrayHandle>(new NDArray(nd)));
     }
-    *num_outputs = idx.outputs().size();
+    *num_outputs = result.size();
     *outputs = dmlc::BeginPtr(ret->ret_handles);
   } else {
-    CHECK_EQ(static_cast<size_t>(*num_outputs), idx.outputs().size())
-        << "Specifed number of output differs from expected number of outputs";
-    for (size_t i = 0; i < idx.outputs().size(); ++i) {
-      *outarray[i] = buff[idx.entry_id(idx.outputs()[i])];
+    for (size_t i = 0; i < result.size(); ++i) {
+      *outarray[i] = result[i];
     }
   }
   API_END();
@@ -784,14 +1236,14 @@ int MXAutogradBackward(mx_uint num_output,
   return MXAutogradBackwardEx(num_output, output_handles, ograd_handles, retain_graph, true);
 }
 
-int MXAutogradBackwardEx(mx_uint num_output,
-                         NDArrayHandle *output_handles,
-                         NDArrayHandle *ograd_handles,
-                         int retain_graph,
-                         int is_train) {
-  API_BEGIN();
-  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
-
+namespace {
+/*! \brief compute the gradient of the outputs given by handles */
+void AutogradBackward(mx_uint num_output,
+                      NDArrayHandle *output_handles,
+                      NDArrayHandle *ograd_handles,
+                      bool retain_graph,
+                      bool is_train,
+                      bool create_graph) {
   std::vector<NDArray> outputs, ograds;
   outputs.reserve(num_output);
   for (mx_uint i = 0; i < num_output; ++i) {
@@ -807,7 +1259,27 @@ int MXAutogradBackwardEx(mx_uint num_output,
     }
   }
 
-  AutogradRuntime::Get()->ComputeGradient(outputs, ograds, retain_graph, is_train);
+  AutogradRuntime::Get()->ComputeGradient(outputs, ograds, retain_graph, is_train,
+                                          create_graph);
+}
+}  // namespace
+
+int MXAutogradBackwardEx(mx_uint num_output,
+                         NDArrayHandle *output_handles,
+                         NDArrayHandle *ograd_handles,
+                         int retain_graph,
+                         int is_train) {
+  API_BEGIN();
+  AutogradBackward(num_output, output_handles, ograd_handles, retain_graph, is_train, false);
+  API_END();
+}
+
+int MXAutogradBackwardCreateGraph(mx_uint num_output,
+                                  NDArrayHandle *output_handles,
+                                  NDArrayHandle *ograd_handles,
+                                  int is_train) {
+  API_BEGIN();
+  AutogradBackward(num_output, output_handles, ograd_handles, true, is_train, true);
   API_END();
 }
 
@@ -26,8 +26,18 @@
 #include <mxnet/c_predict_api.h>
 #include <mxnet/executor.h>
 #include <mxnet/ndarray.h>
+#include <mxnet/storage.h>
 #include <nnvm/pass_functions.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include "./c_api_common.h"
@@ -50,6 +60,59 @@ struct MXAPIPredictor {
   std::unordered_map<std::string, size_t> key2arg;
   // executor
   std::unique_ptr<Executor> exec;
+  // symbol, context and auxiliary states the executor is bound with
+  nnvm::Symbol sym;
+  Context ctx;
+  std::vector<NDArray> aux_arrays;
+  // caller buffers of the inputs of non cpu predictors, by argument index,
+  // copied to the inputs at every forward
+  std::unordered_map<size_t, NDArray> input_buffers;
+  // pinned host copies of the outputs of non cpu predictors
+  std::vector<NDArray> out_buffers;
+  // key of the input shapes the executor is bound for, and these shapes
+  std::string shape_key;
+  std::unordered_map<std::string, TShape> input_shapes;
+  // names of the parameters, "arg:" or "aux:" followed by the array name
+  std::vector<std::string> param_names;
+  // buffer of MXPredSaveCompiled
+  std::string saved_model;
+  // the bound states of other input shapes, most recently used first
+  std::list<std::unique_ptr<MXAPIPredictor> > reshape_cache;
+
+  /*! \brief swap the executor and the arrays bound with it */
+  void SwapBoundState(MXAPIPredictor* other) {
+    std::swap(out_arrays, other->out_arrays);
+    std::swap(arg_arrays, other->arg_arrays);
+    std::swap(out_shapes, other->out_shapes);
+    std::swap(exec, other->exec);
+    std::swap(aux_arrays, other->aux_arrays);
+    std::swap(input_buffers, other->input_buffers);
+    std::swap(out_buffers, other->out_buffers);
+    std::swap(shape_key, other->shape_key);
+    std::swap(input_shapes, other->input_shapes);
+  }
+
+  /*! \brief bind the executor again, after arg_arrays changed */
+  void Rebind() {
+    std::map<std::string, Context> ctx_map;
+    std::vector<NDArray> grad_store(arg_arrays.size());
+    std::vector<OpReqType> grad_req(arg_arrays.size(), kNullOp);
+    std::unique_ptr<Executor> new_exec(Executor::Bind(sym, ctx, ctx_map, arg_arrays,
+                                                      grad_store, grad_req, aux_arrays,
+                                                      exec.get()));
+    exec = std::move(new_exec);
+    out_arrays = exec->outputs();
+  }
+
+  /*! \brief push the copies of the caller buffers to the inputs */
+  void CopyInputBuffers() {
+    std::vector<NDArray> from, to;
+    for (auto& kv : input_buffers) {
+      from.push_back(kv.second);
+      to.push_back(arg_arrays[kv.first]);
+    }
+    CopyFromTo(from, &to);
+  }
 };
 
 struct MXAPINDList {
@@ -87,22 +150,70 @@ namespace mxnet {
 
 }  // namespace mxnet
 
-int MXPredCreatePartialOut(const char* symbol_json_str,
-                           const void* param_bytes,
-                           int param_size,
-                           int dev_type, int dev_id,
-                           mx_uint num_input_nodes,
-                           const char** input_keys,
-                           const mx_uint* input_shape_indptr,
-                           const mx_uint* input_shape_data,
-                           mx_uint num_output_nodes,
-                           const char** output_keys,
-                           PredictorHandle* out) {
+/*! \brief a model loaded for predictors, its parameters are on the device */
+struct PredModel {
+  // the symbol, restricted to the requested outputs
+  nnvm::Symbol sym;
+  // device of the predictors
+  Context ctx;
+  // parameters by name, shared by the predictors which only read them
+  std::unordered_map<std::string, NDArray> arg_params, aux_params;
+  // shapes of all the entries of the symbol saved with a model, and the key
+  // of the input shapes they were inferred for
+  nnvm::ShapeVector entry_shapes;
+  std::string entry_shapes_key;
+};
+
+/*!
+ * \brief copy to the device of a model the parameters of its symbol, named
+ *  "arg:" or "aux:" followed by the name of the argument or auxiliary state
+ */
+static void CopyPredParams(const std::vector<NDArray>& data,
+                           const std::vector<std::string>& names,
+                           PredModel* model) {
   using nnvm::Symbol;
+  std::unordered_set<std::string> arg_names, aux_names;
+  std::vector<std::string> arg_names_vec = model->sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names_vec = model->sym.ListInputNames(Symbol::kAuxiliaryStates);
+  for (size_t i = 0; i < arg_names_vec.size(); ++i) {
+    arg_names.insert(arg_names_vec[i]);
+  }
+  for (size_t i = 0; i < aux_names_vec.size(); ++i) {
+    aux_names.insert(aux_names_vec[i]);
+  }
+  // the copies to the device are issued together
+  std::vector<NDArray> from, to;
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::unordered_map<std::string, NDArray>* params = nullptr;
+    std::string name;
+    if (!strncmp(names[i].c_str(), "aux:", 4)) {
+      name = names[i].c_str() + 4;
+      if (aux_names.count(name) != 0) params = &model->aux_params;
+    }
+    if (!strncmp(names[i].c_str(), "arg:", 4)) {
+      name = names[i].c_str() + 4;
+      if (arg_names.count(name) != 0) params = &model->arg_params;
+    }
+    if (params != nullptr) {
+      NDArray nd = NDArray(data[i].shape(), model->ctx);
+      from.push_back(data[i]);
+      to.push_back(nd);
+      (*params)[name] = nd;
+    }
+  }
+  CopyFromTo(from, &to);
+}
 
-  MXAPIPredictor* ret = new MXAPIPredictor();
-  API_BEGIN();
-  Symbol sym;
+/*! \brief load the symbol and the parameters of a model on the device */
+static void LoadPredModel(const char* symbol_json_str,
+                          const void* param_bytes,
+                          int param_size,
+                          int dev_type, int dev_id,
+                          mx_uint num_output_nodes,
+                          const char** output_keys,
+                          PredModel* model) {
+  using nnvm::Symbol;
+  Symbol& sym = model->sym;
   // make sure symbols are registered
   {
   mx_uint outSize;
@@ -135,111 +246,359 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
   }
 
   // load the parameters
-  std::unordered_map<std::string, NDArray> arg_params, aux_params;
-  {
-    std::unordered_set<std::string> arg_names, aux_names;
-    std::vector<std::string> arg_names_vec = sym.ListInputNames(Symbol::kReadOnlyArgs);
-    std::vector<std::string> aux_names_vec = sym.ListInputNames(Symbol::kAuxiliaryStates);
-    for (size_t i = 0; i < arg_names_vec.size(); ++i) {
-      arg_names.insert(arg_names_vec[i]);
-    }
-    for (size_t i = 0; i < aux_names_vec.size(); ++i) {
-      aux_names.insert(aux_names_vec[i]);
-    }
-    std::vector<NDArray> data;
-    std::vector<std::string> names;
-    dmlc::MemoryFixedSizeStream fi((void*)param_bytes, param_size);  // NOLINT(*)
-    NDArray::Load(&fi, &data, &names);
-    CHECK_EQ(names.size(), data.size())
-        << "Invalid param file format";
-    for (size_t i = 0; i < names.size(); ++i) {
-      if (!strncmp(names[i].c_str(), "aux:", 4)) {
-        std::string name(names[i].c_str() + 4);
-        if (aux_names.count(name) != 0) {
-          aux_params[name] = data[i];
-        }
-      }
-      if (!strncmp(names[i].c_str(), "arg:", 4)) {
-        std::string name(names[i].c_str() + 4);
-        if (arg_names.count(name) != 0) {
-          arg_params[name] = data[i];
-        }
-      }
-    }
-  }
-
-  // shape inference and bind
-  std::unordered_map<std::string, TShape> known_shape;
-  for (mx_uint i = 0; i < num_input_nodes; ++i) {
-    known_shape[std::string(input_keys[i])] =
-        TShape(input_shape_data + input_shape_indptr[i],
-               input_shape_data + input_shape_indptr[i + 1]);
-  }
-  std::vector<std::string> arg_names = sym.ListInputNames(Symbol::kReadOnlyArgs);
-  std::vector<std::string> aux_names = sym.ListInputNames(Symbol::kAuxiliaryStates);
-  std::vector<TShape> out_shapes(sym.ListOutputNames().size());
-  std::vector<TShape> aux_shapes(aux_names.size());
-  std::vector<TShape> arg_shapes;
-  for (size_t i = 0; i < arg_names.size(); ++i) {
-    std::string key = arg_names[i];
-    ret->key2arg[key] = i;
-  }
+  model->ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  dmlc::MemoryFixedSizeStream fi((void*)param_bytes, param_size);  // NOLINT(*)
+  NDArray::Load(&fi, &data, &names);
+  CHECK_EQ(names.size(), data.size())
+      << "Invalid param file format";
+  CopyPredParams(data, names, model);
+}
 
+/*! \brief infer the shapes of all the entries of a symbol */
+static nnvm::ShapeVector InferEntryShapes(const nnvm::Symbol& sym,
+                                          const std::unordered_map<std::string, TShape>& known_shape) {
+  using nnvm::Symbol;
   try {
     std::vector<TShape> in_shapes;
     for (std::string key : sym.ListInputNames(Symbol::kAll)) {
-      if (known_shape.count(key) != 0) {
-        in_shapes.push_back(known_shape[key]);
-      } else {
-        in_shapes.push_back(TShape());
-      }
+      auto it = known_shape.find(key);
+      in_shapes.push_back(it != known_shape.end() ? it->second : TShape());
     }
     nnvm::Graph g; g.outputs = sym.outputs;
     g = mxnet::exec::InferShape(std::move(g), in_shapes, "__shape__");
     bool infer_complete = (g.GetAttr<size_t>("shape_num_unknown_nodes") == 0);
     CHECK(infer_complete)
       << "The shape information of is not enough to get the shapes";
-    CopyAttr(g.indexed_graph(),
-             g.GetAttr<nnvm::ShapeVector>("shape"),
-             &arg_shapes, &out_shapes, &aux_shapes);
+    return g.MoveCopyAttr<nnvm::ShapeVector>("shape");
   } catch (const mxnet::op::InferShapeError &err) {
     throw dmlc::Error(err.msg);
   }
+}
+
+/*!
+ * \brief the shapes of the arguments, outputs and auxiliary states of a symbol
+ * \param entry_shapes the shapes of all the entries if they are already known, or null
+ */
+static void InferPredShapes(const nnvm::Symbol& sym,
+                            const std::unordered_map<std::string, TShape>& known_shape,
+                            const nnvm::ShapeVector* entry_shapes,
+                            std::vector<TShape>* arg_shapes,
+                            std::vector<TShape>* out_shapes,
+                            std::vector<TShape>* aux_shapes) {
+  using nnvm::Symbol;
+  out_shapes->resize(sym.ListOutputNames().size());
+  aux_shapes->resize(sym.ListInputNames(Symbol::kAuxiliaryStates).size());
+  nnvm::Graph g; g.outputs = sym.outputs;
+  const auto& idx = g.indexed_graph();
+  if (entry_shapes != nullptr) {
+    CHECK_EQ(entry_shapes->size(), idx.num_node_entries())
+        << "the saved shapes do not match the symbol";
+    CopyAttr(idx, *entry_shapes, arg_shapes, out_shapes, aux_shapes);
+  } else {
+    CopyAttr(idx, InferEntryShapes(sym, known_shape), arg_shapes, out_shapes, aux_shapes);
+  }
+}
 
-  Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+/*! \brief a key identifying input shapes */
+static std::string ShapeKey(const std::unordered_map<std::string, TShape>& known_shape) {
+  std::map<std::string, TShape> sorted(known_shape.begin(), known_shape.end());
+  std::ostringstream os;
+  for (const auto& kv : sorted) os << kv.first << kv.second << ';';
+  return os.str();
+}
 
-  std::vector<NDArray> arg_arrays, aux_arrays;
+/*!
+ * \brief bind a predictor of a model for the given input shapes
+ * \param shared_exec executor whose memory is reused, only for predictors
+ *  which never run at the same time as it
+ */
+static MXAPIPredictor* BindPredictor(const PredModel& model,
+                                     const std::unordered_map<std::string, TShape>& known_shape,
+                                     Executor* shared_exec) {
+  using nnvm::Symbol;
+  const Symbol& sym = model.sym;
+  std::unique_ptr<MXAPIPredictor> ret(new MXAPIPredictor());
+  // shape inference and bind
+  std::vector<std::string> arg_names = sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names = sym.ListInputNames(Symbol::kAuxiliaryStates);
+  std::vector<TShape> arg_shapes, out_shapes, aux_shapes;
+  for (size_t i = 0; i < arg_names.size(); ++i) {
+    std::string key = arg_names[i];
+    ret->key2arg[key] = i;
+  }
+  const std::string shape_key = ShapeKey(known_shape);
+  InferPredShapes(sym, known_shape,
+                  shape_key == model.entry_shapes_key ? &model.entry_shapes : nullptr,
+                  &arg_shapes, &out_shapes, &aux_shapes);
+
+  // the parameters are shared, the other arrays belong to the predictor
+  auto get_array = [&model](const std::unordered_map<std::string, NDArray>& params,
+                            const std::string& name, const TShape& shape) {
+    auto it = params.find(name);
+    if (it == params.end()) return NDArray(shape, model.ctx);
+    CHECK_EQ(it->second.shape(), shape)
+        << "the shape of parameter " << name << " does not match the model";
+    return it->second;
+  };
   for (size_t i = 0; i < arg_shapes.size(); ++i) {
-    NDArray nd = NDArray(arg_shapes[i], ctx);
-    if (arg_params.count(arg_names[i]) != 0) {
-      CopyFromTo(arg_params[arg_names[i]], &nd);
-    }
-    arg_arrays.push_back(nd);
+    ret->arg_arrays.push_back(get_array(model.arg_params, arg_names[i], arg_shapes[i]));
   }
   for (size_t i = 0; i < aux_shapes.size(); ++i) {
-    NDArray nd = NDArray(aux_shapes[i], ctx);
-    if (aux_params.count(aux_names[i]) != 0) {
-      CopyFromTo(aux_params[aux_names[i]], &nd);
-    }
-    aux_arrays.push_back(nd);
+    ret->aux_arrays.push_back(get_array(model.aux_params, aux_names[i], aux_shapes[i]));
   }
-  ret->arg_arrays = arg_arrays;
   // bind
   {
     std::map<std::string, Context> ctx_map;
-    std::vector<NDArray> grad_store(arg_arrays.size());
-    std::vector<OpReqType> grad_req(arg_arrays.size(), kNullOp);
+    std::vector<NDArray> grad_store(ret->arg_arrays.size());
+    std::vector<OpReqType> grad_req(ret->arg_arrays.size(), kNullOp);
 
-
-    ret->exec.reset(Executor::Bind(sym, ctx, ctx_map,
-                                   arg_arrays,
+    ret->exec.reset(Executor::Bind(sym, model.ctx, ctx_map,
+                                   ret->arg_arrays,
                                    grad_store, grad_req,
-                                   aux_arrays));
+                                   ret->aux_arrays, shared_exec));
+    ret->sym = sym;
+    ret->ctx = model.ctx;
+    ret->shape_key = shape_key;
+    ret->input_shapes = known_shape;
+    for (const auto& kv : model.arg_params) ret->param_names.push_back("arg:" + kv.first);
+    for (const auto& kv : model.aux_params) ret->param_names.push_back("aux:" + kv.first);
     ret->out_shapes = out_shapes;
     ret->out_arrays = ret->exec->outputs();
+    ret->out_buffers.resize(ret->out_arrays.size());
   }
-  *out = ret;
-  API_END_HANDLE_ERROR(delete ret);
+  return ret.release();
+}
+
+/*!
+ * \brief bind a predictor for new input shapes. The arrays of the arguments
+ *  and auxiliary states which keep their shape, the parameters among them,
+ *  are reused, and the new executor shares the memory of the current one.
+ *  The executors of the last MXNET_PREDICTOR_RESHAPE_CACHE_SIZE other
+ *  shapes are kept and switched back to without binding.
+ */
+static void ReshapePredictor(MXAPIPredictor* p,
+                             const std::unordered_map<std::string, TShape>& known_shape) {
+  using nnvm::Symbol;
+  static const size_t cache_size = dmlc::GetEnv("MXNET_PREDICTOR_RESHAPE_CACHE_SIZE", 4);
+  const std::string key = ShapeKey(known_shape);
+  if (key == p->shape_key) return;
+  std::unique_ptr<MXAPIPredictor> state;
+  for (auto it = p->reshape_cache.begin(); it != p->reshape_cache.end(); ++it) {
+    if ((*it)->shape_key == key) {
+      state = std::move(*it);
+      p->reshape_cache.erase(it);
+      break;
+    }
+  }
+  if (state == nullptr) {
+    std::vector<std::string> arg_names = p->sym.ListInputNames(Symbol::kReadOnlyArgs);
+    std::vector<TShape> arg_shapes, out_shapes, aux_shapes;
+    InferPredShapes(p->sym, known_shape, nullptr, &arg_shapes, &out_shapes, &aux_shapes);
+    state.reset(new MXAPIPredictor());
+    for (size_t i = 0; i < arg_shapes.size(); ++i) {
+      const NDArray& nd = p->arg_arrays[i];
+      state->arg_arrays.push_back(known_shape.count(arg_names[i]) == 0 &&
+                                  nd.shape() == arg_shapes[i] ?
+                                  nd : NDArray(arg_shapes[i], p->ctx));
+    }
+    for (size_t i = 0; i < aux_shapes.size(); ++i) {
+      const NDArray& nd = p->aux_arrays[i];
+      state->aux_arrays.push_back(nd.shape() == aux_shapes[i] ?
+                                  nd : NDArray(aux_shapes[i], p->ctx));
+    }
+    std::map<std::string, Context> ctx_map;
+    std::vector<NDArray> grad_store(arg_shapes.size());
+    std::vector<OpReqType> grad_req(arg_shapes.size(), kNullOp);
+    state->exec.reset(Executor::Bind(p->sym, p->ctx, ctx_map, state->arg_arrays,
+                                     grad_store, grad_req, state->aux_arrays,
+                                     p->exec.get()));
+    state->out_shapes = out_shapes;
+    state->out_arrays = state->exec->outputs();
+    state->out_buffers.resize(state->out_arrays.size());
+    state->shape_key = key;
+    state->input_shapes = known_shape;
+  }
+  p->SwapBoundState(state.get());
+  if (cache_size != 0) {
+    p->reshape_cache.push_front(std::move(state));
+    if (p->reshape_cache.size() > cache_size) p->reshape_cache.pop_back();
+  }
+}
+
+/*! \brief the shapes of the input nodes given to the C API */
+static std::unordered_map<std::string, TShape> InputShapes(mx_uint num_input_nodes,
+                                                            const char** input_keys,
+                                                            const mx_uint* input_shape_indptr,
+                                                            const mx_uint* input_shape_data) {
+  std::unordered_map<std::string, TShape> known_shape;
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    known_shape[std::string(input_keys[i])] =
+        TShape(input_shape_data + input_shape_indptr[i],
+               input_shape_data + input_shape_indptr[i + 1]);
+  }
+  return known_shape;
+}
+
+/*!
+ * \brief create num_threads predictors of the same model, the parameters
+ *  are loaded once and shared by the predictors, which only read them.
+ *  Every predictor has its own inputs, outputs and intermediate results.
+ */
+static int CreatePredictors(const char* symbol_json_str,
+                            const void* param_bytes,
+                            int param_size,
+                            int dev_type, int dev_id,
+                            mx_uint num_input_nodes,
+                            const char** input_keys,
+                            const mx_uint* input_shape_indptr,
+                            const mx_uint* input_shape_data,
+                            mx_uint num_output_nodes,
+                            const char** output_keys,
+                            int num_threads,
+                            PredictorHandle* out) {
+  API_BEGIN();
+  CHECK_GT(num_threads, 0) << "the number of predictors must be positive";
+  PredModel model;
+  LoadPredModel(symbol_json_str, param_bytes, param_size, dev_type, dev_id,
+                num_output_nodes, output_keys, &model);
+  std::unordered_map<std::string, TShape> known_shape = InputShapes(
+      num_input_nodes, input_keys, input_shape_indptr, input_shape_data);
+  std::vector<std::unique_ptr<MXAPIPredictor> > preds(num_threads);
+  for (int n = 0; n < num_threads; ++n) {
+    preds[n].reset(BindPredictor(model, known_shape, nullptr));
+  }
+  for (int n = 0; n < num_threads; ++n) {
+    out[n] = preds[n].release();
+  }
+  API_END();
+}
+
+int MXPredCreatePartialOut(const char* symbol_json_str,
+                           const void* param_bytes,
+                           int param_size,
+                           int dev_type, int dev_id,
+                           mx_uint num_input_nodes,
+                           const char** input_keys,
+                           const mx_uint* input_shape_indptr,
+                           const mx_uint* input_shape_data,
+                           mx_uint num_output_nodes,
+                           const char** output_keys,
+                           PredictorHandle* out) {
+  return CreatePredictors(symbol_json_str, param_bytes, param_size, dev_type, dev_id,
+                          num_input_nodes, input_keys, input_shape_indptr, input_shape_data,
+                          num_output_nodes, output_keys, 1, out);
+}
+
+int MXPredCreateMultiThread(const char* symbol_json_str,
+                            const void* param_bytes,
+                            int param_size,
+                            int dev_type, int dev_id,
+                            mx_uint num_input_nodes,
+                            const char** input_keys,
+                            const mx_uint* input_shape_indptr,
+                            const mx_uint* input_shape_data,
+                            int num_threads,
+                            PredictorHandle* out) {
+  return CreatePredictors(symbol_json_str, param_bytes, param_size, dev_type, dev_id,
+                          num_input_nodes, input_keys, input_shape_indptr, input_shape_data,
+                          0, NULL, num_threads, out);
+}
+
+/*! \brief magic number of the models saved by MXPredSaveCompiled */
+static const uint64_t kMXAPIPredModelMagic = 0x5052454d4f44454c;
+
+int MXPredSaveCompiled(PredictorHandle handle,
+                       const char** out_bytes,
+                       mx_uint* out_size) {
+  using nnvm::Symbol;
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  p->saved_model.clear();
+  dmlc::MemoryStringStream fo(&p->saved_model);
+  uint64_t header = kMXAPIPredModelMagic, reserved = 0;
+  fo.Write(&header, sizeof(header));
+  fo.Write(&reserved, sizeof(reserved));
+  // the symbol, in the current version so that no upgrade runs at load
+  {
+    nnvm::Graph g;
+    g.outputs = p->sym.outputs;
+    g.attrs["mxnet_version"] = std::make_shared<nnvm::any>(static_cast<int>(MXNET_VERSION));
+    fo.Write(nnvm::pass::SaveJSON(g));
+  }
+  // the input shapes and the shapes of all the entries inferred from them
+  {
+    std::vector<std::string> keys;
+    for (const auto& kv : p->input_shapes) keys.push_back(kv.first);
+    fo.Write(keys);
+    for (const std::string& key : keys) p->input_shapes.at(key).Save(&fo);
+    const nnvm::ShapeVector shapes = InferEntryShapes(p->sym, p->input_shapes);
+    uint64_t num_shapes = shapes.size();
+    fo.Write(&num_shapes, sizeof(num_shapes));
+    for (const TShape& shape : shapes) shape.Save(&fo);
+  }
+  // the parameters
+  {
+    std::vector<std::string> aux_names = p->sym.ListInputNames(Symbol::kAuxiliaryStates);
+    std::unordered_map<std::string, size_t> key2aux;
+    for (size_t i = 0; i < aux_names.size(); ++i) key2aux[aux_names[i]] = i;
+    std::vector<NDArray> data;
+    for (const std::string& name : p->param_names) {
+      const std::string key = name.substr(4);
+      data.push_back(name.compare(0, 4, "arg:") == 0 ?
+                     p->arg_arrays[p->key2arg.at(key)] : p->aux_arrays[key2aux.at(key)]);
+    }
+    NDArray::Save(&fo, data, p->param_names);
+  }
+  *out_bytes = p->saved_model.data();
+  *out_size = static_cast<mx_uint>(p->saved_model.size());
+  API_END();
+}
+
+int MXPredCreateFromCompiled(const void* model_bytes,
+                             int model_size,
+                             int dev_type, int dev_id,
+                             PredictorHandle* out) {
+  API_BEGIN();
+  dmlc::MemoryFixedSizeStream fi((void*)model_bytes, model_size);  // NOLINT(*)
+  uint64_t header, reserved;
+  CHECK(fi.Read(&header, sizeof(header)) && header == kMXAPIPredModelMagic)
+      << "Invalid compiled model format";
+  CHECK(fi.Read(&reserved, sizeof(reserved))) << "Invalid compiled model format";
+  PredModel model;
+  {
+    std::string json;
+    CHECK(fi.Read(&json)) << "Invalid compiled model format";
+    nnvm::Graph g;
+    g.attrs["json"] = std::make_shared<nnvm::any>(std::move(json));
+    model.sym.outputs = nnvm::ApplyPass(g, "LoadLegacyJSON").outputs;
+  }
+  std::unordered_map<std::string, TShape> known_shape;
+  {
+    std::vector<std::string> keys;
+    CHECK(fi.Read(&keys)) << "Invalid compiled model format";
+    for (const std::string& key : keys) {
+      CHECK(known_shape[key].Load(&fi)) << "Invalid compiled model format";
+    }
+    uint64_t num_shapes;
+    CHECK(fi.Read(&num_shapes, sizeof(num_shapes))) << "Invalid compiled model format";
+    model.entry_shapes.resize(num_shapes);
+    for (TShape& shape : model.entry_shapes) {
+      CHECK(shape.Load(&fi)) << "Invalid compiled model format";
+    }
+    model.entry_shapes_key = ShapeKey(known_shape);
+  }
+  model.ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  {
+    std::vector<NDArray> data;
+    std::vector<std::string> names;
+    NDArray::Load(&fi, &data, &names);
+    CHECK_EQ(names.size(), data.size()) << "Invalid compiled model format";
+    CopyPredParams(data, names, &model);
+  }
+  *out = BindPredictor(model, known_shape, nullptr);
+  API_END();
 }
 
 int MXPredGetOutputShape(PredictorHandle handle,
@@ -271,12 +630,65 @@ int MXPredSetInput(PredictorHandle handle,
   }
   NDArray& nd = p->arg_arrays[it->second];
   nd.SyncCopyFromCPU(data, size);
+  p->input_buffers.erase(it->second);
+  API_END();
+}
+
+int MXPredSetInputBuffer(PredictorHandle handle,
+                         const char* key,
+                         mx_float* data,
+                         mx_uint size) {
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  auto it = p->key2arg.find(key);
+  if (it == p->key2arg.end()) {
+    LOG(FATAL) << "cannot find input key " << key;
+  }
+  const TShape& shape = p->arg_arrays[it->second].shape();
+  CHECK_EQ(static_cast<size_t>(size), shape.Size())
+      << "the buffer of input " << key << " must hold " << shape.Size() << " values";
+  NDArray buffer(TBlob(data, shape, cpu::kDevMask), 0);
+  if (p->ctx.dev_mask() == cpu::kDevMask) {
+    // the buffer becomes the input of the executor
+    p->arg_arrays[it->second] = buffer;
+    p->Rebind();
+  } else {
+    p->input_buffers[it->second] = buffer;
+  }
+  API_END();
+}
+
+int MXPredRegisterHostMemory(mx_float* data, mx_uint size) {
+  API_BEGIN();
+  Storage::Get()->RegisterHostMemory(data, size * sizeof(mx_float));
+  API_END();
+}
+
+int MXPredUnregisterHostMemory(mx_float* data) {
+  API_BEGIN();
+  Storage::Get()->UnregisterHostMemory(data);
+  API_END();
+}
+
+int MXPredReshape(PredictorHandle handle,
+                  mx_uint num_input_nodes,
+                  const char** input_keys,
+                  const mx_uint* input_shape_indptr,
+                  const mx_uint* input_shape_data) {
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    CHECK(p->key2arg.count(input_keys[i]) != 0) << "cannot find input key " << input_keys[i];
+  }
+  ReshapePredictor(p, InputShapes(num_input_nodes, input_keys,
+                                  input_shape_indptr, input_shape_data));
   API_END();
 }
 
 int MXPredForward(PredictorHandle handle) {
   MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
   API_BEGIN();
+  p->CopyInputBuffers();
   p->exec->Forward(false);
   API_END();
 }
@@ -284,6 +696,7 @@ int MXPredForward(PredictorHandle handle) {
 int MXPredPartialForward(PredictorHandle handle, int step, int* step_left) {
   MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
   API_BEGIN();
+  if (step == 0) p->CopyInputBuffers();
   p->exec->PartialForward(false, step, step_left);
   API_END();
 }
@@ -301,12 +714,228 @@ int MXPredGetOutput(PredictorHandle handle,
   API_END();
 }
 
+int MXPredGetOutputBuffer(PredictorHandle handle,
+                          mx_uint index,
+                          const mx_float** data,
+                          mx_uint* size) {
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  CHECK_LT(index, p->out_arrays.size())
+      << "Output index out of range";
+  const NDArray& nd = p->out_arrays[index];
+  if (nd.ctx().dev_mask() == cpu::kDevMask) {
+    nd.WaitToRead();
+    *data = nd.data().dptr<mx_float>();
+  } else {
+    NDArray& buffer = p->out_buffers[index];
+    if (buffer.is_none()) {
+      buffer = NDArray(nd.shape(), Context::CPUPinned(p->ctx.dev_id), false, nd.dtype());
+    }
+    CopyFromTo(nd, &buffer);
+    buffer.WaitToRead();
+    *data = buffer.data().dptr<mx_float>();
+  }
+  *size = static_cast<mx_uint>(nd.shape().Size());
+  API_END();
+}
+
 int MXPredFree(PredictorHandle handle) {
   API_BEGIN();
   delete static_cast<MXAPIPredictor*>(handle);
   API_END();
 }
 
+/*! \brief a request to the batching predictor */
+struct MXAPIBatchRequest {
+  // the inputs of one sample, in the order of the input keys
+  std::vector<std::vector<mx_float> > inputs;
+  // called with the outputs of the sample
+  MXPredBatchCallback callback;
+  void* user_data;
+  // time of the submission
+  std::chrono::steady_clock::time_point time;
+};
+
+/*!
+ * \brief predictor running the requests of single samples in batches. A
+ *  worker thread waits for max_batch_size requests, or for max_delay after
+ *  the oldest request, and runs them at once. The batches are run by
+ *  predictors bound for the power of two batch sizes, created when first
+ *  needed, so a partial batch fills the smallest one it fits in.
+ */
+struct MXAPIBatchPredictor {
+  // the model shared by the predictors
+  PredModel model;
+  // input keys and the shapes of the inputs of one sample
+  std::vector<std::string> input_keys;
+  std::vector<TShape> input_shapes;
+  mx_uint max_batch_size;
+  std::chrono::microseconds max_delay;
+  // predictors by batch size, only used by the worker thread
+  std::map<mx_uint, std::unique_ptr<MXAPIPredictor> > preds;
+  // pending requests
+  std::deque<MXAPIBatchRequest> queue;
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool stop = false;
+  std::thread worker;
+
+  ~MXAPIBatchPredictor() {
+    if (worker.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      cond.notify_all();
+      worker.join();
+    }
+  }
+
+  /*! \brief the worker loop, which runs the pending requests before stopping */
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      cond.wait(lock, [this] { return stop || !queue.empty(); });
+      if (queue.empty()) return;
+      const auto deadline = queue.front().time + max_delay;
+      while (!stop && queue.size() < max_batch_size &&
+             cond.wait_until(lock, deadline) == std::cv_status::no_timeout) {}
+      std::vector<MXAPIBatchRequest> batch;
+      while (!queue.empty() && batch.size() < max_batch_size) {
+        batch.push_back(std::move(queue.front()));
+        queue.pop_front();
+      }
+      lock.unlock();
+      RunBatch(batch);
+      lock.lock();
+    }
+  }
+
+  /*! \brief the predictor of a batch size, sharing the memory of the others */
+  MXAPIPredictor* GetPredictor(mx_uint batch_size) {
+    auto it = preds.find(batch_size);
+    if (it != preds.end()) return it->second.get();
+    std::unordered_map<std::string, TShape> known_shape;
+    for (size_t k = 0; k < input_keys.size(); ++k) {
+      TShape shape = input_shapes[k];
+      shape[0] = batch_size;
+      known_shape[input_keys[k]] = shape;
+    }
+    // the predictors are never run at the same time
+    Executor* shared_exec = preds.empty() ? nullptr : preds.rbegin()->second->exec.get();
+    MXAPIPredictor* pred = BindPredictor(model, known_shape, shared_exec);
+    preds[batch_size].reset(pred);
+    return pred;
+  }
+
+  /*! \brief run a batch and call back every request with its outputs */
+  void RunBatch(const std::vector<MXAPIBatchRequest>& batch) {
+    mx_uint batch_size = 1;
+    while (batch_size < batch.size()) batch_size *= 2;
+    batch_size = std::min(batch_size, max_batch_size);
+    std::vector<std::vector<mx_float> > outputs;
+    std::vector<mx_uint> sizes;
+    int status = 0;
+    try {
+      MXAPIPredictor* pred = GetPredictor(batch_size);
+      for (size_t k = 0; k < input_keys.size(); ++k) {
+        const size_t size = input_shapes[k].Size();
+        std::vector<mx_float> data(batch_size * size, 0.0f);
+        for (size_t i = 0; i < batch.size(); ++i) {
+          std::copy(batch[i].inputs[k].begin(), batch[i].inputs[k].end(),
+                    data.begin() + i * size);
+        }
+        pred->arg_arrays[pred->key2arg.at(input_keys[k])].SyncCopyFromCPU(data.data(),
+                                                                          data.size());
+      }
+      pred->exec->Forward(false);
+      for (const NDArray& nd : pred->out_arrays) {
+        CHECK(nd.shape().ndim() > 0 && nd.shape()[0] == batch_size)
+            << "the outputs of a batching predictor must have the batch size as first axis";
+        outputs.emplace_back(nd.shape().Size());
+        nd.SyncCopyToCPU(outputs.back().data(), outputs.back().size());
+        sizes.push_back(nd.shape().Size() / batch_size);
+      }
+    } catch (const dmlc::Error& err) {
+      LOG(WARNING) << "batch prediction failed: " << err.what();
+      status = -1;
+      outputs.clear();
+      sizes.clear();
+    }
+    std::vector<const mx_float*> ptrs(outputs.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      for (size_t o = 0; o < outputs.size(); ++o) {
+        ptrs[o] = outputs[o].data() + i * sizes[o];
+      }
+      batch[i].callback(status, static_cast<mx_uint>(ptrs.size()), ptrs.data(), sizes.data(),
+                        batch[i].user_data);
+    }
+  }
+};
+
+int MXPredBatchCreate(const char* symbol_json_str,
+                      const void* param_bytes,
+                      int param_size,
+                      int dev_type, int dev_id,
+                      mx_uint num_input_nodes,
+                      const char** input_keys,
+                      const mx_uint* input_shape_indptr,
+                      const mx_uint* input_shape_data,
+                      mx_uint max_batch_size,
+                      mx_uint max_delay_us,
+                      BatchPredictorHandle* out) {
+  MXAPIBatchPredictor* ret = new MXAPIBatchPredictor();
+  API_BEGIN();
+  CHECK_GT(max_batch_size, 0U) << "max_batch_size must be positive";
+  LoadPredModel(symbol_json_str, param_bytes, param_size, dev_type, dev_id,
+                0, NULL, &ret->model);
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    TShape shape(input_shape_data + input_shape_indptr[i],
+                 input_shape_data + input_shape_indptr[i + 1]);
+    CHECK(shape.ndim() > 0 && shape[0] == 1)
+        << "the shape of input " << input_keys[i] << " must be the one of a single sample, "
+        << "with a first axis of size 1";
+    ret->input_keys.push_back(input_keys[i]);
+    ret->input_shapes.push_back(shape);
+  }
+  ret->max_batch_size = max_batch_size;
+  ret->max_delay = std::chrono::microseconds(max_delay_us);
+  // bind the largest batch first, the smaller ones reuse its memory
+  ret->GetPredictor(max_batch_size);
+  ret->worker = std::thread([ret] { ret->Run(); });
+  *out = ret;
+  API_END_HANDLE_ERROR(delete ret);
+}
+
+int MXPredSubmit(BatchPredictorHandle handle,
+                 const mx_float** inputs,
+                 MXPredBatchCallback callback,
+                 void* user_data) {
+  MXAPIBatchPredictor* p = static_cast<MXAPIBatchPredictor*>(handle);
+  API_BEGIN();
+  CHECK(callback != nullptr) << "the callback of a request must not be NULL";
+  MXAPIBatchRequest req;
+  for (size_t k = 0; k < p->input_keys.size(); ++k) {
+    req.inputs.emplace_back(inputs[k], inputs[k] + p->input_shapes[k].Size());
+  }
+  req.callback = callback;
+  req.user_data = user_data;
+  req.time = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    CHECK(!p->stop) << "the batching predictor is being freed";
+    p->queue.push_back(std::move(req));
+  }
+  p->cond.notify_one();
+  API_END();
+}
+
+int MXPredBatchFree(BatchPredictorHandle handle) {
+  API_BEGIN();
+  delete static_cast<MXAPIBatchPredictor*>(handle);
+  API_END();
+}
+
 int MXNDListCreate(const char* nd_file_bytes,
                    int nd_file_size,
                    NDListHandle *out,
@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bfloat16.h
+ * \brief bfloat16, the upper half of a float32
+ */
+#ifndef MXNET_COMMON_BFLOAT16_H_
+#define MXNET_COMMON_BFLOAT16_H_
+
+#include <mshadow/base.h>
+#include <cstdint>
+
+namespace mxnet {
+namespace common {
+
+/*!
+ * \brief bfloat16 value, with the sign, the 8 bits of exponent and the 7
+ *  upper bits of mantissa of a float32. It has the range of float32, so that
+ *  gradients need no loss scaling, with fewer bits of precision than float16.
+ */
+struct bf16_t {
+  uint16_t bits;
+
+  MSHADOW_XINLINE bf16_t() {}
+  /*! \brief round to the nearest bfloat16, ties to even, keeping NaNs quiet */
+  MSHADOW_XINLINE explicit bf16_t(float value) {
+    Bits v;
+    v.f = value;
+    if ((v.u & 0x7fffffffU) > 0x7f800000U) {
+      bits = static_cast<uint16_t>((v.u >> 16) | 0x40U);
+    } else {
+      bits = static_cast<uint16_t>((v.u + 0x7fffU + ((v.u >> 16) & 1U)) >> 16);
+    }
+  }
+  MSHADOW_XINLINE operator float() const {
+    Bits v;
+    v.u = static_cast<uint32_t>(bits) << 16;
+    return v.f;
+  }
+
+ private:
+  union Bits {
+    float f;
+    uint32_t u;
+  };
+};
+
+static_assert(sizeof(bf16_t) == 2, "bf16_t must be 16 bits");
+
+}  // namespace common
+}  // namespace mxnet
+#endif  // MXNET_COMMON_BFLOAT16_H_
@@ -24,9 +24,62 @@
  */
 #include <mxnet/mxrtc.h>
 #if ((MXNET_USE_CUDA) && (MXNET_USE_NVRTC))
+#include <dmlc/parameter.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
 namespace mxnet {
 const char MXRtc::str_type[] = "float";
-std::unordered_map<std::string, char*> MXRtc::kernel_registry;
+
+namespace {
+/*! \brief FNV-1a hash of the key, to name its file in MXNET_RTC_CACHE_DIR */
+std::string HashKey(const std::string& key) {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h));  // NOLINT(*)
+    return std::string(buf);
+}
+
+/*! \brief compile code to ptx with nvrtc */
+std::string CompilePTX(const std::string& name, const std::string& code,
+                       const std::vector<std::string>& options) {
+    nvrtcProgram prog;
+    CHECK_EQ(nvrtcCreateProgram(&prog,
+                                code.c_str(),
+                                (name+".cu").c_str(),
+                                0,
+                                NULL,
+                                NULL), NVRTC_SUCCESS);
+    std::vector<const char*> opts;
+    for (const auto& opt : options) opts.push_back(opt.c_str());
+    nvrtcResult compile_res = nvrtcCompileProgram(prog, opts.size(), opts.data());
+    size_t log_size;
+    CHECK_EQ(nvrtcGetProgramLogSize(prog, &log_size), NVRTC_SUCCESS);
+    std::string log(log_size, '\0');
+    CHECK_EQ(nvrtcGetProgramLog(prog, &log[0]), NVRTC_SUCCESS);
+    CHECK_EQ(compile_res, NVRTC_SUCCESS) << log;
+
+    size_t ptx_size;
+    CHECK_EQ(nvrtcGetPTXSize(prog, &ptx_size), NVRTC_SUCCESS);
+    std::string ptx(ptx_size, '\0');
+    CHECK_EQ(nvrtcGetPTX(prog, &ptx[0]), NVRTC_SUCCESS);
+    CHECK_EQ(nvrtcDestroyProgram(&prog), NVRTC_SUCCESS);
+    // the size counts the terminating null character
+    if (!ptx.empty() && ptx.back() == '\0') ptx.pop_back();
+    return ptx;
+}
+}  // namespace
 
 MXRtc::MXRtc(const std::string& name,
              std::vector<std::pair<std::string, NDArray> > const& input,
@@ -36,11 +89,9 @@ MXRtc::MXRtc(const std::string& name,
     num_input_ = input.size();
     num_output_ = output.size();
     code_ = decorate(name, input, output, kernel);
-    if (MXRtc::kernel_registry.find(code_) != MXRtc::kernel_registry.end()) {
-        ptx_ = MXRtc::kernel_registry[code_];
-    } else {
-        ptx_ = compile(name, code_);
-    }
+    // compile now to report the errors of the code, push gets it from the cache
+    CHECK(output.size());
+    GetPTX(name_, code_, output[0].second.ctx().dev_id);
 }
 
 void MXRtc::push(std::vector<NDArray> const& input,
@@ -61,7 +112,8 @@ void MXRtc::push(std::vector<NDArray> const& input,
         func = func_[dev_id];
     } else {
         CUmodule module;
-        CHECK_EQ(err = cuModuleLoadDataEx(&module, ptx_, 0, 0, 0), CUDA_SUCCESS)
+        std::string ptx = GetPTX(name_, code_, dev_id);
+        CHECK_EQ(err = cuModuleLoadDataEx(&module, ptx.c_str(), 0, 0, 0), CUDA_SUCCESS)
             << "CudaError: " << err;
         CHECK_EQ(err = cuModuleGetFunction(&func, module, name_.c_str()), CUDA_SUCCESS)
             << "CudaError: " << err;
@@ -132,26 +184,65 @@ std::string MXRtc::decorate(const std::string& name,
 }
 
 char* MXRtc::compile(const std::string& name, const std::string& code) {
-    nvrtcProgram prog;
-    CHECK_EQ(nvrtcCreateProgram(&prog,
-                                code.c_str(),
-                                (name+".cu").c_str(),
-                                0,
-                                NULL,
-                                NULL), NVRTC_SUCCESS);
-    nvrtcResult compile_res = nvrtcCompileProgram(prog, 0, NULL);
-    size_t log_size;
-    CHECK_EQ(nvrtcGetProgramLogSize(prog, &log_size), NVRTC_SUCCESS);
-    char *log = new char[log_size];
-    CHECK_EQ(nvrtcGetProgramLog(prog, log), NVRTC_SUCCESS);
-    CHECK_EQ(compile_res, NVRTC_SUCCESS) << log;
+    int dev_id;
+    CHECK_EQ(cudaGetDevice(&dev_id), cudaSuccess);
+    std::string ptx = GetPTX(name, code, dev_id);
+    char *ret = new char[ptx.size() + 1];
+    memcpy(ret, ptx.c_str(), ptx.size() + 1);
+    return ret;
+}
 
-    size_t ptx_size;
-    CHECK_EQ(nvrtcGetPTXSize(prog, &ptx_size), NVRTC_SUCCESS);
-    char *ptx = new char[ptx_size];
-    CHECK_EQ(nvrtcGetPTX(prog, ptx), NVRTC_SUCCESS);
-    CHECK_EQ(nvrtcDestroyProgram(&prog), NVRTC_SUCCESS);
-    return ptx;
+std::string MXRtc::GetPTX(const std::string& name, const std::string& code, int dev_id) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::string> cache;
+    static const std::string cache_dir = dmlc::GetEnv("MXNET_RTC_CACHE_DIR", std::string());
+    int major, minor, nvrtc_major, nvrtc_minor;
+    CHECK_EQ(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev_id),
+             cudaSuccess);
+    CHECK_EQ(cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, dev_id),
+             cudaSuccess);
+    CHECK_EQ(nvrtcVersion(&nvrtc_major, &nvrtc_minor), NVRTC_SUCCESS);
+    const std::vector<std::string> options = {
+      "--gpu-architecture=compute_" + std::to_string(major * 10 + minor)};
+    std::ostringstream os;
+    os << "nvrtc " << nvrtc_major << '.' << nvrtc_minor << '\n' << name << '\n';
+    for (const auto& opt : options) os << opt << '\n';
+    os << code;
+    const std::string key = os.str();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    // a cache file holds the key, a null character and the ptx
+    const std::string path = cache_dir.empty() ? std::string() :
+        cache_dir + "/" + HashKey(key) + ".ptx";
+    if (!path.empty()) {
+        std::ifstream is(path, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(is)),
+                            std::istreambuf_iterator<char>());
+        if (content.size() > key.size() && content.compare(0, key.size(), key) == 0 &&
+            content[key.size()] == '\0') {
+            return cache[key] = content.substr(key.size() + 1);
+        }
+    }
+    std::string ptx = CompilePTX(name, code, options);
+    if (!path.empty()) {
+        // written to a temporary file first, processes sharing the directory
+        // never read a partial file
+        std::ostringstream tmp;
+        tmp << path << '.' << std::hash<std::thread::id>()(std::this_thread::get_id())
+            << '.' << std::chrono::steady_clock::now().time_since_epoch().count();
+        {
+            std::ofstream fo(tmp.str(), std::ios::binary);
+            fo.write(key.c_str(), key.size() + 1);
+            fo.write(ptx.c_str(), ptx.size());
+        }
+        if (std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+            std::remove(tmp.str().c_str());
+            LOG(WARNING) << "Cannot write the compiled kernel to " << path;
+        }
+    }
+    return cache[key] = ptx;
 }
 
 }  // namespace mxnet
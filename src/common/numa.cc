@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file numa.cc
+ * \brief Binding of CPU contexts, threads and memory to NUMA nodes.
+ */
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mutex>
+#include <vector>
+#include "./numa.h"
+
+#if MXNET_USE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif  // MXNET_USE_NUMA
+
+namespace mxnet {
+namespace common {
+
+int NumNUMANodes() {
+#if MXNET_USE_NUMA
+  static int num_nodes = numa_available() < 0 ? 1 : numa_num_configured_nodes();
+  return num_nodes;
+#else
+  return 1;
+#endif  // MXNET_USE_NUMA
+}
+
+/*! \brief whether MXNET_CPU_NUMA_BIND is set and can be honoured */
+static bool NUMABindEnabled() {
+  if (!dmlc::GetEnv("MXNET_CPU_NUMA_BIND", false)) return false;
+#if MXNET_USE_NUMA
+  if (numa_available() < 0) {
+    LOG(WARNING) << "MXNET_CPU_NUMA_BIND is ignored, NUMA is not available";
+    return false;
+  }
+  return true;
+#else
+  LOG(WARNING) << "MXNET_CPU_NUMA_BIND is ignored, compile with USE_NUMA=1 to enable it";
+  return false;
+#endif  // MXNET_USE_NUMA
+}
+
+int GetNUMANodeOfCPUContext(int dev_id) {
+  static const bool enabled = NUMABindEnabled();
+  if (!enabled || dev_id < 0) return -1;
+  return dev_id % NumNUMANodes();
+}
+
+void BindThreadToNUMANode(int node) {
+  if (node < 0) return;
+#if MXNET_USE_NUMA
+  static bool pin_core = dmlc::GetEnv("MXNET_CPU_WORKER_PIN_CORE", false);
+  struct bitmask* cpus = numa_allocate_cpumask();
+  CHECK_EQ(numa_node_to_cpus(node, cpus), 0) << "Cannot get the cores of NUMA node " << node;
+  if (pin_core) {
+    // hand out the cores of every node in turn to the threads bound to it
+    static std::mutex mutex;
+    static std::vector<int> next_core;
+    std::vector<int> cores;
+    for (unsigned i = 0; i < cpus->size; ++i) {
+      if (numa_bitmask_isbitset(cpus, i)) cores.push_back(i);
+    }
+    if (!cores.empty()) {
+      int core;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (next_core.size() <= static_cast<size_t>(node)) next_core.resize(node + 1, 0);
+        core = cores[next_core[node]++ % cores.size()];
+      }
+      numa_bitmask_clearall(cpus);
+      numa_bitmask_setbit(cpus, core);
+    }
+  }
+  if (numa_sched_setaffinity(0, cpus) != 0) {
+    LOG(WARNING) << "Cannot pin thread to NUMA node " << node;
+  }
+  numa_bitmask_free(cpus);
+  numa_set_preferred(node);
+#endif  // MXNET_USE_NUMA
+}
+
+void BindMemoryToNUMANode(void* ptr, size_t size, int node) {
+  if (node < 0 || size == 0) return;
+#if MXNET_USE_NUMA
+  struct bitmask* nodes = numa_allocate_nodemask();
+  numa_bitmask_setbit(nodes, node);
+  // prefer rather than bind, so allocations fall back to other nodes when full
+  if (mbind(ptr, size, MPOL_PREFERRED, nodes->maskp, nodes->size + 1, 0) != 0) {
+    LOG(WARNING) << "Cannot bind memory to NUMA node " << node;
+  }
+  numa_bitmask_free(nodes);
+#endif  // MXNET_USE_NUMA
+}
+
+}  // namespace common
+}  // namespace mxnet
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file numa.h
+ * \brief Binding of CPU contexts, threads and memory to NUMA nodes.
+ */
+#ifndef MXNET_COMMON_NUMA_H_
+#define MXNET_COMMON_NUMA_H_
+
+#include <cstddef>
+
+namespace mxnet {
+namespace common {
+
+/*!
+ * \return The number of NUMA nodes of the machine, 1 when MXNet is not
+ *  compiled with USE_NUMA or NUMA is not available.
+ */
+int NumNUMANodes();
+/*!
+ * \brief Get the NUMA node bound to the CPU context with device id dev_id.
+ *  Context::CPU(dev_id) is bound to node dev_id % NumNUMANodes() when
+ *  MXNET_CPU_NUMA_BIND is set.
+ * \param dev_id Device id of the CPU context.
+ * \return The node, or -1 if CPU contexts are not bound to nodes.
+ */
+int GetNUMANodeOfCPUContext(int dev_id);
+/*!
+ * \brief Pin the calling thread to the cores of a NUMA node and make the node
+ *  its preferred one for memory. If MXNET_CPU_WORKER_PIN_CORE is set, the
+ *  threads bound to a node are pinned to its cores one by one instead.
+ * \param node The node, nothing is done if it is negative.
+ */
+void BindThreadToNUMANode(int node);
+/*!
+ * \brief Place the pages of a memory region on a NUMA node. Must be called
+ *  before the region is touched, pages already backed are not moved.
+ * \param ptr Start of the region, must be page aligned.
+ * \param size Size of the region.
+ * \param node The node, nothing is done if it is negative.
+ */
+void BindMemoryToNUMANode(void* ptr, size_t size, int node);
+
+}  // namespace common
+}  // namespace mxnet
+
+#endif  // MXNET_COMMON_NUMA_H_
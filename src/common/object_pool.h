@@ -22,7 +22,9 @@
 #ifndef MXNET_COMMON_OBJECT_POOL_H_
 #define MXNET_COMMON_OBJECT_POOL_H_
 #include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
 #include <cstdlib>
+#include <memory>
 #include <mutex>
 #include <utility>
 #include <vector>
@@ -31,6 +33,13 @@ namespace mxnet {
 namespace common {
 /*!
  * \brief Object pool for fast allocation and deallocation.
+ *
+ *  Every thread keeps its own list of free objects, New and Delete only
+ *  touch the list of the calling thread and take no lock. The lists are
+ *  refilled from, and handed back to, the shared free list kBatchSize objects
+ *  at a time, so objects created on one thread and deleted on another, like
+ *  the engine operator blocks, take the shared lock once every kBatchSize
+ *  operations.
  */
 template <typename T>
 class ObjectPool {
@@ -80,12 +89,26 @@ class ObjectPool {
     };
 #endif
   };
+  /*! \brief free objects of the calling thread */
+  struct ThreadCache {
+    /*! \brief keep the pool alive until the thread exits */
+    std::shared_ptr<ObjectPool> pool;
+    /*! \brief head of the free list */
+    LinkedList* head{nullptr};
+    /*! \brief length of the free list */
+    std::size_t size{0};
+    ~ThreadCache() {
+      if (pool != nullptr && head != nullptr) pool->GiveBack(head, size);
+    }
+  };
   /*!
    * \brief Page size of allocation.
    *
    * Currently defined to be 4KB.
    */
   constexpr static std::size_t kPageSize = 1 << 12;
+  /*! \brief number of objects moved at once between a thread and the shared list */
+  constexpr static std::size_t kBatchSize = 64;
   /*! \brief internal mutex */
   std::mutex m_;
   /*!
@@ -106,6 +129,12 @@ class ObjectPool {
    * This function is not protected and must be called with caution.
    */
   void AllocateChunk();
+  /*! \brief get the cache of the calling thread */
+  ThreadCache* LocalCache();
+  /*! \brief move kBatchSize objects from the shared list to the cache */
+  void Refill(ThreadCache* cache);
+  /*! \brief put the list of size objects starting at head back to the shared list */
+  void GiveBack(LinkedList* head, std::size_t size);
   DISALLOW_COPY_AND_ASSIGN(ObjectPool);
 };  // class ObjectPool
 
@@ -140,15 +169,13 @@ ObjectPool<T>::~ObjectPool() {
 template <typename T>
 template <typename... Args>
 T* ObjectPool<T>::New(Args&&... args) {
-  LinkedList* ret;
-  {
-    std::lock_guard<std::mutex> lock{m_};
-    if (head_->next == nullptr) {
-      AllocateChunk();
-    }
-    ret = head_;
-    head_ = head_->next;
+  ThreadCache* cache = LocalCache();
+  if (cache->head == nullptr) {
+    Refill(cache);
   }
+  LinkedList* ret = cache->head;
+  cache->head = ret->next;
+  --cache->size;
   return new (static_cast<void*>(ret)) T(std::forward<Args>(args)...);
 }
 
@@ -156,11 +183,57 @@ template <typename T>
 void ObjectPool<T>::Delete(T* ptr) {
   ptr->~T();
   auto linked_list_ptr = reinterpret_cast<LinkedList*>(ptr);
-  {
-    std::lock_guard<std::mutex> lock{m_};
-    linked_list_ptr->next = head_;
-    head_ = linked_list_ptr;
+  ThreadCache* cache = LocalCache();
+  linked_list_ptr->next = cache->head;
+  cache->head = linked_list_ptr;
+  ++cache->size;
+  if (cache->size >= 2 * kBatchSize) {
+    // hand the newest kBatchSize objects back, and keep the others
+    LinkedList* tail = cache->head;
+    for (std::size_t i = 1; i < kBatchSize; ++i) {
+      tail = tail->next;
+    }
+    LinkedList* batch = cache->head;
+    cache->head = tail->next;
+    cache->size -= kBatchSize;
+    tail->next = nullptr;
+    GiveBack(batch, kBatchSize);
+  }
+}
+
+template <typename T>
+typename ObjectPool<T>::ThreadCache* ObjectPool<T>::LocalCache() {
+  ThreadCache* cache = dmlc::ThreadLocalStore<ThreadCache>::Get();
+  if (cache->pool == nullptr) {
+    cache->pool = _GetSharedRef();
+  }
+  return cache;
+}
+
+template <typename T>
+void ObjectPool<T>::Refill(ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock{m_};
+  for (std::size_t i = 0; i < kBatchSize; ++i) {
+    if (head_ == nullptr) {
+      AllocateChunk();
+    }
+    LinkedList* obj = head_;
+    head_ = obj->next;
+    obj->next = cache->head;
+    cache->head = obj;
+  }
+  cache->size += kBatchSize;
+}
+
+template <typename T>
+void ObjectPool<T>::GiveBack(LinkedList* head, std::size_t size) {
+  LinkedList* tail = head;
+  for (std::size_t i = 1; i < size; ++i) {
+    tail = tail->next;
   }
+  std::lock_guard<std::mutex> lock{m_};
+  tail->next = head_;
+  head_ = head;
 }
 
 template <typename T>
@@ -0,0 +1,223 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file random_generator.h
+ * \brief Counter-based random number generator used by the parallel random
+ *  resource.
+ *
+ *  Philox4x32-10 maps a 128-bit counter and a 64-bit key to four independent
+ *  32-bit words. Element i of a request of n numbers uses the counter
+ *  offset + i, and the offset of the generator moves by n, so the numbers do
+ *  not depend on the number of threads and every key is its own stream.
+ */
+#ifndef MXNET_COMMON_RANDOM_GENERATOR_H_
+#define MXNET_COMMON_RANDOM_GENERATOR_H_
+
+#include <mshadow/base.h>
+#include <math.h>
+#include <stdint.h>
+
+namespace mxnet {
+namespace common {
+namespace random {
+
+/*!
+ * \brief the numbers of one request to a RandGenerator, passed by value to
+ *  the kernels.
+ */
+struct PhiloxStream {
+  /*! \brief the key of the generator */
+  uint32_t key[2];
+  /*! \brief the counter of the first element */
+  uint64_t offset;
+  /*!
+   * \brief the four words of element i. The samplers which need more than
+   *  four words per element take the next rounds of the same element.
+   */
+  MSHADOW_XINLINE void Generate(uint64_t i, uint32_t out[4], uint32_t round = 0) const {
+    const uint64_t counter = offset + i;
+    uint32_t c0 = static_cast<uint32_t>(counter);
+    uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+    uint32_t c2 = round, c3 = 0;
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r) {
+      const uint64_t p0 = static_cast<uint64_t>(0xD2511F53U) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57U) * c2;
+      const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c1 = static_cast<uint32_t>(p1);
+      c3 = static_cast<uint32_t>(p0);
+      c0 = n0;
+      c2 = n2;
+      k0 += 0x9E3779B9U;
+      k1 += 0xBB67AE85U;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+  /*! \brief uniform number in [0, 1) made of the 24 high bits of a word */
+  MSHADOW_XINLINE static float ToUniform(uint32_t x) {
+    return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+  }
+  /*! \brief uniform number of element i in [0, 1) */
+  MSHADOW_XINLINE float Uniform(uint64_t i) const {
+    uint32_t w[4];
+    Generate(i, w);
+    return ToUniform(w[0]);
+  }
+  /*! \brief standard normal number of element i, by the Box-Muller transform */
+  MSHADOW_XINLINE float Normal(uint64_t i) const {
+    uint32_t w[4];
+    Generate(i, w);
+    const float u = static_cast<float>((w[0] >> 8) + 1) * (1.0f / 16777216.0f);
+    const float v = ToUniform(w[1]);
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853071795864f * v);
+  }
+};
+
+/*!
+ * \brief the subsequence of element i of a request, for the samplers drawing
+ *  a variable number of words per element such as the rejection samplers.
+ *  The words of element i never overlap with the ones of another element.
+ */
+class PhiloxSequence {
+ public:
+  MSHADOW_XINLINE PhiloxSequence(const PhiloxStream& stream, uint64_t i)
+    : stream_(stream), i_(i), round_(0), pos_(4) {}
+  /*! \brief next word of the subsequence */
+  MSHADOW_XINLINE uint32_t Next() {
+    if (pos_ == 4) {
+      stream_.Generate(i_, words_, round_++);
+      pos_ = 0;
+    }
+    return words_[pos_++];
+  }
+  /*! \brief uniform number in [0, 1) */
+  MSHADOW_XINLINE float Uniform() {
+    return PhiloxStream::ToUniform(Next());
+  }
+  /*! \brief uniform number in (0, 1], safe to take the log of */
+  MSHADOW_XINLINE float UniformPositive() {
+    return static_cast<float>((Next() >> 8) + 1) * (1.0f / 16777216.0f);
+  }
+  /*! \brief standard normal number, by the Box-Muller transform */
+  MSHADOW_XINLINE float Normal() {
+    const float u = UniformPositive();
+    const float v = Uniform();
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853071795864f * v);
+  }
+  /*!
+   * \brief gamma number of shape alpha and scale 1, by the method of Marsaglia
+   *  and Tsang. Shapes below one are boosted with Gamma(alpha) = Gamma(alpha + 1) * U^(1/alpha).
+   */
+  MSHADOW_XINLINE float Gamma(float alpha) {
+    if (alpha <= 0.0f) return 0.0f;
+    const float boost = alpha < 1.0f ? powf(UniformPositive(), 1.0f / alpha) : 1.0f;
+    const float d = (alpha < 1.0f ? alpha + 1.0f : alpha) - 1.0f / 3.0f;
+    const float c = 1.0f / sqrtf(9.0f * d);
+    while (true) {
+      const float x = Normal();
+      float v = 1.0f + c * x;
+      if (v <= 0.0f) continue;
+      v = v * v * v;
+      const float u = UniformPositive();
+      if (u < 1.0f - 0.0331f * x * x * x * x ||
+          logf(u) < 0.5f * x * x + d * (1.0f - v + logf(v))) {
+        return boost * d * v;
+      }
+    }
+  }
+  /*!
+   * \brief Poisson number of rate lambda, by multiplying uniforms for small
+   *  rates and by the transformed rejection of Hormann (PTRS) otherwise.
+   */
+  MSHADOW_XINLINE float Poisson(float lambda) {
+    if (lambda < 10.0f) {
+      const float limit = expf(-lambda);
+      float prod = Uniform();
+      int k = 0;
+      while (prod > limit) {
+        prod *= Uniform();
+        ++k;
+      }
+      return static_cast<float>(k);
+    }
+    const float slam = sqrtf(lambda);
+    const float loglam = logf(lambda);
+    const float b = 0.931f + 2.53f * slam;
+    const float a = -0.059f + 0.02483f * b;
+    const float invalpha = 1.1239f + 1.1328f / (b - 3.4f);
+    const float vr = 0.9277f - 3.6224f / (b - 2.0f);
+    while (true) {
+      const float u = Uniform() - 0.5f;
+      const float v = UniformPositive();
+      const float us = 0.5f - fabsf(u);
+      const float k = floorf((2.0f * a / us + b) * u + lambda + 0.43f);
+      if (us >= 0.07f && v <= vr) return k;
+      if (k < 0.0f || (us < 0.013f && v > us)) continue;
+      if (logf(v) + logf(invalpha) - logf(a / (us * us) + b) <=
+          -lambda + k * loglam - lgammaf(k + 1.0f)) {
+        return k;
+      }
+    }
+  }
+
+ private:
+  PhiloxStream stream_;
+  uint64_t i_;
+  uint32_t round_;
+  int pos_;
+  uint32_t words_[4];
+};
+
+/*!
+ * \brief host side state of a parallel random resource. It gives the
+ *  requests consecutive ranges of counters, the requesting operator holds the
+ *  write dependency on the resource so Take is never called concurrently.
+ */
+class RandGenerator {
+ public:
+  RandGenerator(uint32_t seed, uint32_t stream) {
+    Seed(seed, stream);
+  }
+  /*! \brief restart the generator on the stream of seed */
+  void Seed(uint32_t seed, uint32_t stream) {
+    stream_.key[0] = seed;
+    stream_.key[1] = stream;
+    stream_.offset = 0;
+  }
+  /*! \brief reserve n elements for a request */
+  PhiloxStream Take(uint64_t n) {
+    PhiloxStream ret = stream_;
+    stream_.offset += n;
+    return ret;
+  }
+
+ private:
+  PhiloxStream stream_;
+};
+
+}  // namespace random
+}  // namespace common
+}  // namespace mxnet
+#endif  // MXNET_COMMON_RANDOM_GENERATOR_H_
@@ -32,11 +32,14 @@
 #include <mxnet/graph_attr_types.h>
 #include <nnvm/graph_attr_types.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <type_traits>
 #include <utility>
 #include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <algorithm>
@@ -85,6 +88,83 @@ inline bool SetupDefaultBlobs(const std::vector<NDArray>& src,
   return require_cast;
 }
 
+/*!
+ * \brief Per operator counters of the storage fallbacks, enabled by setting
+ *  `MXNET_STORAGE_FALLBACK_LOG_VERBOSE`. With 1 the first fallback of every
+ *  operator is logged, with 2 every fallback is logged. The counters are
+ *  printed when the process exits.
+ */
+class StorageFallbackLog {
+ public:
+  static StorageFallbackLog* Get() {
+    static StorageFallbackLog inst;
+    return &inst;
+  }
+  /*! \brief the verbosity level, 0 when the log is disabled */
+  int verbose() const {
+    return verbose_;
+  }
+  /*!
+   * \brief record the cast of `arrays` to or from the default storage
+   * \param opr_name name of the operator which falls back
+   * \param arrays the non-default storage arrays being cast
+   */
+  void Record(const std::string& opr_name, const std::vector<NDArray>& arrays) {
+    size_t bytes = 0;
+    for (const auto& nd : arrays) {
+      bytes += nd.shape().Size() * mshadow::mshadow_sizeof(nd.dtype());
+    }
+    uint64_t count;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Stat& stat = stats_[opr_name];
+      count = ++stat.count;
+      stat.bytes += bytes;
+    }
+    if (verbose_ >= 2 || count == 1) {
+      std::ostringstream os;
+      for (size_t i = 0; i < arrays.size(); ++i) {
+        os << (i == 0 ? "" : ", ") << StorageTypeName(arrays[i].storage_type())
+           << arrays[i].shape();
+      }
+      LOG(INFO) << "Storage fallback #" << count << " in operator " << opr_name
+                << ": " << arrays.size() << " array(s) " << os.str()
+                << " fall back to default storage, " << bytes << " bytes materialized";
+    }
+  }
+
+  ~StorageFallbackLog() {
+    if (stats_.empty()) return;
+    std::ostringstream os;
+    os << "Storage fallback summary:";
+    for (const auto& kv : stats_) {
+      os << "\n  " << kv.first << ": " << kv.second.count << " fallback(s), "
+         << kv.second.bytes << " bytes materialized";
+    }
+    LOG(INFO) << os.str();
+  }
+
+ private:
+  struct Stat {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+  };
+  StorageFallbackLog()
+      : verbose_(dmlc::GetEnv("MXNET_STORAGE_FALLBACK_LOG_VERBOSE", 0)) {}
+  static const char* StorageTypeName(NDArrayStorageType stype) {
+    switch (stype) {
+      case kRowSparseStorage: return "row_sparse";
+      case kCSRStorage: return "csr";
+      case kDefaultStorage: return "default";
+      default: return "undefined";
+    }
+  }
+
+  int verbose_;
+  std::mutex mutex_;
+  std::map<std::string, Stat> stats_;
+};
+
 /*
  * \brief cast the NDArrays in `src` and store the result in NDArrays in `dst`.
  *        This is only used for storage fallback in executor.
@@ -95,12 +175,14 @@ inline bool SetupDefaultBlobs(const std::vector<NDArray>& src,
  * \param ctx operator context for cast_storage operation
  * \param storage_fallback whether storage_fallback is allowed. When set to false,
  *        its value depends on `MXNET_EXEC_STORAGE_FALLBACK`.
+ * \param opr_name name of the operator, reported by StorageFallbackLog
  */
 template <typename xpu>
 inline void CastNonDefaultStorage(const std::vector<NDArray>& src,
                                   const std::vector<NDArray>& dst,
                                   const OpContext& ctx,
-                                  bool storage_fallback = false) {
+                                  bool storage_fallback = false,
+                                  const std::string& opr_name = "") {
   CHECK_GE(dst.size(), src.size());
   if (src.size() == 0) return;
   if (storage_fallback == false) {
@@ -111,6 +193,12 @@ inline void CastNonDefaultStorage(const std::vector<NDArray>& src,
                << "You are probably executing an operator which "
                << "doesn't support NDArray inputs with non-default storage.";
   }
+  if (StorageFallbackLog::Get()->verbose()) {
+    // the source of the cast after fcompute is the dense temporary
+    const bool to_default = src[0].storage_type() != kDefaultStorage;
+    StorageFallbackLog::Get()->Record(opr_name.empty() ? "unknown" : opr_name,
+                                      to_default ? src : dst);
+  }
   for (size_t i = 0; i < src.size(); i++) {
     CastStorageDispatch<xpu>(ctx, src[i], dst[i]);
   }
@@ -158,6 +246,46 @@ V ParallelAccumulate(const T* a, const int n, V start) {
   return sum;
 }
 
+/*!
+ * \brief Split the rows of a csr matrix into `num_parts` contiguous blocks with
+ *  about the same number of rows plus non-zero elements, so that the blocks
+ *  stay balanced when a few rows hold most of the non-zeros. The work before
+ *  row r is indptr[r] + r, and the block boundaries are found by binary
+ *  search over indptr. Block i covers the rows [bounds[i], bounds[i+1]).
+ * \param indptr indptr array of the csr matrix, on cpu
+ * \param num_rows number of rows of the csr matrix
+ * \param num_parts number of blocks
+ * \param bounds the num_parts + 1 block boundaries to return
+ */
+template<typename IType>
+inline void PartitionCsrRows(const IType* indptr,
+                             const nnvm::dim_t num_rows,
+                             const nnvm::dim_t num_parts,
+                             std::vector<nnvm::dim_t>* bounds) {
+  using nnvm::dim_t;
+  CHECK_GT(num_parts, 0);
+  bounds->resize(num_parts + 1);
+  const dim_t base = static_cast<dim_t>(indptr[0]);
+  const dim_t total = static_cast<dim_t>(indptr[num_rows]) - base + num_rows;
+  (*bounds)[0] = 0;
+  (*bounds)[num_parts] = num_rows;
+  dim_t low = 0;
+  for (dim_t p = 1; p < num_parts; ++p) {
+    const dim_t target = total / num_parts * p + total % num_parts * p / num_parts;
+    // the first row whose preceding work reaches the target
+    dim_t high = num_rows;
+    while (low < high) {
+      const dim_t mid = low + (high - low) / 2;
+      if (static_cast<dim_t>(indptr[mid]) - base + mid < target) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    (*bounds)[p] = low;
+  }
+}
+
 /*!
  * \brief
  * Helper function for ParallelSort.
@@ -146,6 +146,8 @@ class NaiveEngine final : public Engine {
       SetOprStart(opr->opr_stat);
     }
 #endif
+    // attribute the memory allocated by the operation to it in the profile
+    MemoryScope memory_scope(opr_name);
     if (exec_ctx.dev_mask() == gpu::kDevMask) {
 #if MXNET_USE_CUDA
       size_t dev_id = static_cast<size_t>(exec_ctx.dev_id);
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file openmp.cc
+ * \brief number of OpenMP threads used by the CPU kernels
+ */
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <cstdlib>
+#include "./openmp.h"
+
+namespace mxnet {
+namespace engine {
+
+OpenMP* OpenMP::Get() {
+  static OpenMP inst;
+  return &inst;
+}
+
+OpenMP::OpenMP() {
+  const bool env_set = std::getenv("OMP_NUM_THREADS") != nullptr;
+  thread_max_ = env_set ? omp_get_max_threads() : omp_get_num_procs();
+  thread_max_set_ = env_set;
+  min_parallel_size_ = dmlc::GetEnv("MXNET_CPU_PARALLEL_SIZE", 4096);
+  io_nthreads_ = std::max(0, dmlc::GetEnv("MXNET_CPU_IO_NTHREADS", 0));
+}
+
+int OpenMP::GetRecommendedOMPThreadCount() const {
+  if (thread_max_set_) return thread_max_;
+  return std::max(1, (thread_max_ - io_nthreads_) / cpu_worker_nthreads_);
+}
+
+int OpenMP::GetIOThreadCount(int requested) const {
+  if (io_nthreads_ == 0) return requested;
+  return std::max(1, std::min(requested, io_nthreads_));
+}
+
+void OpenMP::on_start_worker_thread(bool use_omp) {
+  omp_set_num_threads(use_omp ? GetRecommendedOMPThreadCount() : 1);
+}
+
+void OpenMP::set_thread_max(int thread_max) {
+  thread_max_ = std::max(1, thread_max);
+  thread_max_set_ = true;
+}
+
+void OpenMP::set_cpu_worker_nthreads(int nthreads) {
+  cpu_worker_nthreads_ = std::max(1, nthreads);
+}
+
+}  // namespace engine
+}  // namespace mxnet
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file openmp.h
+ * \brief number of OpenMP threads used by the CPU kernels
+ */
+#ifndef MXNET_ENGINE_OPENMP_H_
+#define MXNET_ENGINE_OPENMP_H_
+
+#include <atomic>
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief OpenMP thread budget of the CPU kernels.
+ *
+ *  The engine can run several CPU operators at once, one per CPU worker
+ *  thread. A parallel region of a kernel uses the threads of the process
+ *  divided by the number of CPU workers, so that concurrent operators do
+ *  not oversubscribe the cores. OMP_NUM_THREADS, when set, is the size of
+ *  every parallel region.
+ *
+ *  MXNET_CPU_IO_NTHREADS sets aside threads for the data iterators: their
+ *  preprocessing threads are limited to it, and the kernels share the
+ *  remaining threads.
+ */
+class OpenMP {
+ public:
+  /*! \return the process wide instance */
+  static OpenMP* Get();
+  /*! \return the number of threads a parallel region of a CPU kernel uses */
+  int GetRecommendedOMPThreadCount() const;
+  /*!
+   * \brief set the number of threads available to the CPU kernels,
+   *  which is then the size of every parallel region
+   */
+  void set_thread_max(int thread_max);
+  /*! \brief set the number of engine threads running CPU operators concurrently */
+  void set_cpu_worker_nthreads(int nthreads);
+  /*!
+   * \return the number of preprocessing threads given to a data iterator
+   *  asking for requested threads
+   */
+  int GetIOThreadCount(int requested) const;
+  /*!
+   * \brief set the default size of the parallel regions of the calling
+   *  engine worker, kernels with a plain omp parallel pragma then use the
+   *  thread budget of the worker too
+   * \param use_omp whether the worker runs CPU kernels, otherwise its
+   *  parallel regions use a single thread
+   */
+  void on_start_worker_thread(bool use_omp);
+  /*! \return the minimum number of items of a CPU kernel run in parallel */
+  int min_parallel_size() const {
+    return min_parallel_size_;
+  }
+
+ private:
+  OpenMP();
+  /*! \brief threads available to the CPU kernels */
+  std::atomic<int> thread_max_;
+  /*! \brief whether thread_max_ was set explicitly, and is not divided between workers */
+  std::atomic<bool> thread_max_set_;
+  /*! \brief engine threads running CPU operators */
+  std::atomic<int> cpu_worker_nthreads_{1};
+  /*! \brief threads set aside for the data iterators, 0 when they are not limited */
+  int io_nthreads_;
+  /*! \brief minimum number of items of a kernel run in parallel */
+  int min_parallel_size_;
+};
+
+}  // namespace engine
+}  // namespace mxnet
+#endif  // MXNET_ENGINE_OPENMP_H_
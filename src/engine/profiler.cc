@@ -23,13 +23,20 @@
  */
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
 #include <mxnet/base.h>
 #include <set>
 #include <map>
 #include <mutex>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstring>
 #include "./profiler.h"
 
 #if defined(_MSC_VER) && _MSC_VER <= 1800
@@ -38,7 +45,17 @@
 
 namespace mxnet {
 namespace engine {
-const int INITIAL_SIZE = 1024;
+#if MXNET_USE_CUPTI
+/*! \brief the row of a gpu stream in the trace is this plus the CUPTI stream id */
+const uint32_t kGpuStreamTidBase = 1U << 31;
+#endif
+
+MX_THREAD_LOCAL const char* MemoryScope::current_ = nullptr;
+
+/*! \brief holds the records of a thread until the thread exits */
+struct ThreadStatHolder {
+  std::shared_ptr<ThreadStat> stat;
+};
 
 Profiler::Profiler()
   : state_(kNotRunning), enable_output_(false), filename_("profile.json") {
@@ -55,7 +72,6 @@ Profiler::Profiler()
 #endif
 
   this->profile_stat = new DevStat[cpu_num_ + gpu_num_ + 1];
-  this->profile_stat->opr_exec_stats.reserve(INITIAL_SIZE);
   for (unsigned int i = 0; i < cpu_num_; ++i) {
     profile_stat[i].dev_name = "cpu/" + std::to_string(i);
   }
@@ -64,10 +80,18 @@ Profiler::Profiler()
   }
   profile_stat[cpu_num_ + gpu_num_].dev_name = "cpu pinned/";
 
+  buffer_size_ = dmlc::GetEnv("MXNET_PROFILER_BUFFER_SIZE", 16384);
+  CHECK_GT(buffer_size_, 0U) << "MXNET_PROFILER_BUFFER_SIZE must be positive";
   mode_ = (ProfilerMode)dmlc::GetEnv("MXNET_PROFILER_MODE", static_cast<int>(kOnlySymbolic));
+#if MXNET_USE_CUPTI
+  use_cupti_ = dmlc::GetEnv("MXNET_PROFILER_CUPTI", true);
+#endif
   if (dmlc::GetEnv("MXNET_PROFILER_AUTOSTART", 0)) {
     this->state_ = ProfilerState::kRunning;
     this->enable_output_ = true;
+#if MXNET_USE_CUPTI
+    if (use_cupti_) cupti::Start(init_time_, buffer_size_ * gpu_num_);
+#endif
   }
 }
 
@@ -86,6 +110,15 @@ void Profiler::SetState(ProfilerState state) {
   // once running, output will be enabled.
   if (state == kRunning)
       this->enable_output_ = true;
+#if MXNET_USE_CUPTI
+  if (use_cupti_) {
+    if (state == kRunning) {
+      cupti::Start(init_time_, buffer_size_ * gpu_num_);
+    } else {
+      cupti::Stop();
+    }
+  }
+#endif
 }
 
 void Profiler::SetConfig(ProfilerMode mode, std::string output_filename) {
@@ -94,34 +127,235 @@ void Profiler::SetConfig(ProfilerMode mode, std::string output_filename) {
   this->filename_ = output_filename;
 }
 
+ThreadStat* Profiler::GetThreadStat() {
+  ThreadStatHolder* holder = dmlc::ThreadLocalStore<ThreadStatHolder>::Get();
+  if (holder->stat == nullptr) {
+    holder->stat = std::make_shared<ThreadStat>(buffer_size_);
+    std::lock_guard<std::mutex> lock{thread_stats_m_};
+    thread_stats_.push_back(holder->stat);
+  }
+  return holder->stat.get();
+}
+
 OprExecStat *Profiler::AddOprStat(int dev_type, uint32_t dev_id) {
+  if (DevStatIndex(dev_type, dev_id) < 0) {
+    LOG(FATAL) << "Unkown dev_type";
+    return NULL;
+  }
   OprExecStat* opr_stat = new OprExecStat;
   opr_stat->dev_type = dev_type;
   opr_stat->dev_id   = dev_id;
   opr_stat->opr_name[sizeof(opr_stat->opr_name)-1] = '\0';
+  return opr_stat;
+}
 
-  int idx;
+void Profiler::RecordOprStat(const OprExecStat& opr_stat) {
+  ThreadStat* thread_stat = GetThreadStat();
+  if (!thread_stat->opr_exec_stats.Push(opr_stat)) ++thread_stat->num_dropped;
+  std::lock_guard<std::mutex> lock{thread_stat->aggregates_m};
+  thread_stat->aggregates[std::make_pair(
+      static_cast<uint32_t>(DevStatIndex(opr_stat.dev_type, opr_stat.dev_id)),
+      std::string(opr_stat.opr_name))].Add(opr_stat);
+}
+
+void Profiler::AddCounterStat(int dev_type, uint32_t dev_id,
+                              const char* name, uint64_t value) {
+  if (DevStatIndex(dev_type, dev_id) < 0) return;
+  CounterStat counter_stat;
+  strncpy(counter_stat.counter_name, name, sizeof(counter_stat.counter_name) - 1);
+  counter_stat.counter_name[sizeof(counter_stat.counter_name) - 1] = '\0';
+  counter_stat.rel_micros = NowInUsec() - init_time_;
+  counter_stat.value = value;
+  counter_stat.dev_type = dev_type;
+  counter_stat.dev_id = dev_id;
+
+  ThreadStat* thread_stat = GetThreadStat();
+  if (!thread_stat->counter_stats.Push(counter_stat)) ++thread_stat->num_dropped;
+}
+
+void Profiler::AddMemoryStat(int dev_type, uint32_t dev_id,
+                             int64_t bytes, uint64_t in_use) {
+  if (DevStatIndex(dev_type, dev_id) < 0) return;
+  MemoryStat memory_stat;
+  const char* opr_name = MemoryScope::Current();
+  strncpy(memory_stat.opr_name, opr_name ? opr_name : "",
+          sizeof(memory_stat.opr_name) - 1);
+  memory_stat.opr_name[sizeof(memory_stat.opr_name) - 1] = '\0';
+  memory_stat.rel_micros = NowInUsec() - init_time_;
+  memory_stat.bytes = bytes;
+  memory_stat.in_use = in_use;
+  memory_stat.thread_id = std::hash<std::thread::id>()(std::this_thread::get_id());
+  memory_stat.dev_type = dev_type;
+  memory_stat.dev_id = dev_id;
+
+  ThreadStat* thread_stat = GetThreadStat();
+  if (!thread_stat->memory_stats.Push(memory_stat)) ++thread_stat->num_dropped;
+}
+
+void Profiler::AddFlowStat(const FlowEndpoint& from, const FlowEndpoint& to) {
+  if (from.rel_micros == 0 || to.rel_micros == 0) return;
+  FlowStat flow_stat;
+  flow_stat.flow_id = next_flow_id_++;
+  flow_stat.from = from;
+  flow_stat.to = to;
+
+  ThreadStat* thread_stat = GetThreadStat();
+  if (!thread_stat->flow_stats.Push(flow_stat)) ++thread_stat->num_dropped;
+}
+
+std::string Profiler::AggregateStatsPrint(bool reset) {
+  AggregateTable table;
+  {
+    std::lock_guard<std::mutex> lock{thread_stats_m_};
+    for (const auto& kv : exited_aggregates_) table[kv.first].Merge(kv.second);
+    if (reset) exited_aggregates_.clear();
+    for (const auto& thread_stat : thread_stats_) {
+      std::lock_guard<std::mutex> thread_lock{thread_stat->aggregates_m};
+      for (const auto& kv : thread_stat->aggregates) table[kv.first].Merge(kv.second);
+      if (reset) thread_stat->aggregates.clear();
+    }
+  }
+
+  std::ostringstream os;
+  os << "Profile Statistics.\n"
+     << "\tNote that times are in microseconds (us).\n";
+  auto it = table.begin();
+  while (it != table.end()) {
+    const uint32_t dev = it->first.first;
+    // operators of one device, the most expensive first
+    std::vector<std::pair<std::string, const OprAggregateStat*> > oprs;
+    for (; it != table.end() && it->first.first == dev; ++it) {
+      oprs.emplace_back(it->first.second, &it->second);
+    }
+    std::sort(oprs.begin(), oprs.end(),
+              [](const std::pair<std::string, const OprAggregateStat*>& a,
+                 const std::pair<std::string, const OprAggregateStat*>& b) {
+                return a.second->duration.total_micros > b.second->duration.total_micros;
+              });
+    os << "\nDevice " << profile_stat[dev].dev_name << "\n"
+       << std::left << std::setw(40) << "Name" << std::right
+       << std::setw(12) << "Count" << std::setw(16) << "Total"
+       << std::setw(12) << "Min" << std::setw(12) << "Max"
+       << std::setw(12) << "Avg" << std::setw(12) << "P50"
+       << std::setw(12) << "P99" << std::setw(16) << "DepWait(Avg)"
+       << std::setw(16) << "DepWait(P99)" << std::setw(16) << "WorkerWait(Avg)"
+       << std::setw(16) << "WorkerWait(P99)" << "\n"
+       << std::left << std::setw(40) << "----" << std::right
+       << std::setw(12) << "-----" << std::setw(16) << "-----"
+       << std::setw(12) << "---" << std::setw(12) << "---"
+       << std::setw(12) << "---" << std::setw(12) << "---"
+       << std::setw(12) << "---" << std::setw(16) << "------------"
+       << std::setw(16) << "------------" << std::setw(16) << "---------------"
+       << std::setw(16) << "---------------" << "\n";
+    for (const auto& opr : oprs) {
+      const AggregateStat& stat = opr.second->duration;
+      const AggregateStat& dependency_wait = opr.second->dependency_wait;
+      const AggregateStat& worker_wait = opr.second->worker_wait;
+      os << std::left << std::setw(40) << opr.first << std::right
+         << std::setw(12) << stat.count << std::setw(16) << stat.total_micros
+         << std::setw(12) << stat.min_micros << std::setw(12) << stat.max_micros
+         << std::setw(12) << stat.Average()
+         << std::setw(12) << stat.Percentile(0.5)
+         << std::setw(12) << stat.Percentile(0.99)
+         << std::setw(16) << dependency_wait.Average()
+         << std::setw(16) << dependency_wait.Percentile(0.99)
+         << std::setw(16) << worker_wait.Average()
+         << std::setw(16) << worker_wait.Percentile(0.99) << "\n";
+    }
+  }
+  return os.str();
+}
+
+/*! \brief number of histogram buckets per power of two */
+static const int kAggregateSubBuckets = 16;
+/*! \brief log2 of kAggregateSubBuckets */
+static const int kAggregateSubBucketBits = 4;
+
+/*! \return the histogram bucket of a duration */
+static size_t AggregateBucket(uint64_t micros) {
+  if (micros < kAggregateSubBuckets) return micros;
+  int exponent = 63;
+  while (!(micros >> exponent)) --exponent;
+  int shift = exponent - kAggregateSubBucketBits;
+  return kAggregateSubBuckets * (shift + 1) + ((micros >> shift) - kAggregateSubBuckets);
+}
+
+/*! \return the middle of the durations of a histogram bucket */
+static uint64_t AggregateBucketValue(size_t bucket) {
+  if (bucket < kAggregateSubBuckets) return bucket;
+  int shift = bucket / kAggregateSubBuckets - 1;
+  uint64_t lower = (kAggregateSubBuckets + bucket % kAggregateSubBuckets) << shift;
+  return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void AggregateStat::Add(uint64_t micros) {
+  ++count;
+  total_micros += micros;
+  if (micros < min_micros) min_micros = micros;
+  if (micros > max_micros) max_micros = micros;
+  size_t bucket = AggregateBucket(micros);
+  if (histogram.size() <= bucket) histogram.resize(bucket + 1, 0);
+  ++histogram[bucket];
+}
+
+void AggregateStat::Merge(const AggregateStat& other) {
+  count += other.count;
+  total_micros += other.total_micros;
+  if (other.min_micros < min_micros) min_micros = other.min_micros;
+  if (other.max_micros > max_micros) max_micros = other.max_micros;
+  if (histogram.size() < other.histogram.size()) histogram.resize(other.histogram.size(), 0);
+  for (size_t i = 0; i < other.histogram.size(); ++i) histogram[i] += other.histogram[i];
+}
+
+void OprAggregateStat::Add(const OprExecStat& opr_stat) {
+  const uint64_t start = opr_stat.opr_start_rel_micros;
+  const uint64_t end = opr_stat.opr_end_rel_micros;
+  const uint64_t push = opr_stat.opr_push_rel_micros;
+  const uint64_t ready = opr_stat.opr_ready_rel_micros;
+  duration.Add(end > start ? end - start : 0);
+  // the wait times are only known for operators pushed to a threaded engine
+  if (push != 0 && ready >= push) dependency_wait.Add(ready - push);
+  if (ready != 0 && start >= ready) worker_wait.Add(start - ready);
+}
+
+uint64_t AggregateStat::Percentile(double q) const {
+  if (count == 0) return 0;
+  // rank of the execution looked for, starting from 1
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * count));
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    seen += histogram[i];
+    if (seen >= rank) {
+      return std::min(std::max(AggregateBucketValue(i), min_micros), max_micros);
+    }
+  }
+  return max_micros;
+}
+
+int Profiler::DevStatIndex(int dev_type, uint32_t dev_id) const {
   switch (dev_type) {
     case Context::kCPU:
-      idx = dev_id;
-      break;
+    case Context::kCPUShared:
+      if (dev_id >= cpu_num_) return -1;
+      return dev_id;
     case Context::kGPU:
-      idx = cpu_num_ + dev_id;
-      break;
+      if (dev_id >= gpu_num_) return -1;
+      return cpu_num_ + dev_id;
     case Context::kCPUPinned:
-      idx = cpu_num_ + gpu_num_;
-      break;
+      return cpu_num_ + gpu_num_;
     default:
-      LOG(FATAL) << "Unkown dev_type";
-      return NULL;
+      return -1;
   }
+}
 
-  DevStat& dev_stat = profile_stat[idx];
-  {
-    std::lock_guard<std::mutex> lock{dev_stat.m_};
-    dev_stat.opr_exec_stats.push_back(opr_stat);
+void Profiler::EmitSeparator() {
+  if (first_event_) {
+    first_event_ = false;
+  } else {
+    file_ << ",";
   }
-  return opr_stat;
+  file_ << std::endl;
 }
 
 void Profiler::EmitPid(std::ostream *os, const std::string& name, uint32_t pid) {
@@ -137,72 +371,195 @@ void Profiler::EmitPid(std::ostream *os, const std::string& name, uint32_t pid)
 
 void Profiler::EmitEvent(std::ostream *os, const std::string& name,
                        const std::string& category, const std::string& ph,
-                       uint64_t ts, uint32_t pid, uint32_t tid) {
+                       uint64_t ts, uint32_t pid, uint32_t tid,
+                       const std::string& args) {
   (*os) << "        {\n"
         << "            \"name\": \""  << name << "\",\n"
         << "            \"cat\": " << "\"" << category << "\",\n"
         << "            \"ph\": \""<< ph << "\",\n"
         << "            \"ts\": "  << ts << ",\n"
-        << "            \"pid\": " << pid << ",\n"
-        << "            \"tid\": " << tid << "\n"
+        << "            \"pid\": " << pid << ",\n";
+  if (!args.empty()) {
+    (*os) << "            \"args\": {\n"
+          << args
+          << "            },\n";
+  }
+  (*os) << "            \"tid\": " << tid << "\n"
         << "        }";
 }
 
+void Profiler::EmitCounter(std::ostream *os, const std::string& name,
+                           uint64_t value, uint64_t ts, uint32_t pid) {
+  (*os) << "        {\n"
+        << "            \"name\": \""  << name << "\",\n"
+        << "            \"ph\": \"C\",\n"
+        << "            \"ts\": "  << ts << ",\n"
+        << "            \"pid\": " << pid << ",\n"
+        << "            \"args\": {\n"
+        << "                \"" << name << "\": " << value << "\n"
+        << "            }\n"
+        << "        }";
+}
 
-void Profiler::DumpProfile() {
-  SetState(kNotRunning);
-
-  std::lock_guard<std::mutex> lock{this->m_};
-  std::ofstream file;
-  file.open(filename_);
+void Profiler::EmitFlow(std::ostream *os, const std::string& ph, uint64_t id,
+                        uint64_t ts, uint32_t pid, uint32_t tid) {
+  (*os) << "        {\n"
+        << "            \"name\": \"dependency\",\n"
+        << "            \"cat\": \"dependency\",\n"
+        << "            \"ph\": \"" << ph << "\",\n"
+        << "            \"id\": " << id << ",\n"
+        << "            \"ts\": "  << ts << ",\n"
+        << "            \"pid\": " << pid << ",\n"
+        << "            \"tid\": " << tid << ",\n"
+        << "            \"bp\": \"e\"\n"
+        << "        }";
+}
 
-  file << "{" << std::endl;
-  file << "    \"traceEvents\": [" << std::endl;
 
-  uint32_t dev_num = cpu_num_ + gpu_num_ + 1;
+void Profiler::DumpProfile(bool finished) {
+  if (finished) SetState(kNotRunning);
 
-  for (uint32_t i = 0; i < dev_num; ++i) {
-    const DevStat &d = profile_stat[i];
-    this->EmitPid(&file, d.dev_name, i);
-    file << ",\n";
+  std::lock_guard<std::mutex> lock{this->m_};
+  if (!file_.is_open()) {
+    // the array format of chrome tracing does not need the closing bracket,
+    // so the file can be loaded after every dump
+    file_.open(filename_);
+    file_ << "[";
+    first_event_ = true;
+    uint32_t dev_num = cpu_num_ + gpu_num_ + 1;
+    for (uint32_t i = 0; i < dev_num; ++i) {
+      EmitSeparator();
+      this->EmitPid(&file_, profile_stat[i].dev_name, i);
+    }
   }
 
-  bool first_flag = true;
-  for (uint32_t i = 0; i < dev_num; ++i) {
-    DevStat &d = profile_stat[i];
-    std::lock_guard<std::mutex> lock(d.m_);
-    uint32_t opr_num = d.opr_exec_stats.size();
-
-    for (uint32_t j = 0; j < opr_num; ++j) {
-      const OprExecStat* opr_stat = d.opr_exec_stats[j];
-
-      uint32_t pid = i;
-      uint32_t tid = opr_stat->thread_id;
-
-      if (first_flag) {
-        first_flag = false;
+  std::vector<std::shared_ptr<ThreadStat> > thread_stats;
+  {
+    std::lock_guard<std::mutex> lock{thread_stats_m_};
+    thread_stats = thread_stats_;
+  }
+  uint64_t num_dropped = 0;
+  for (const auto& thread_stat : thread_stats) {
+    thread_stat->opr_exec_stats.ConsumeAll([this](const OprExecStat& opr_stat) {
+        int pid = DevStatIndex(opr_stat.dev_type, opr_stat.dev_id);
+        std::ostringstream args;
+        if (opr_stat.opr_push_rel_micros != 0 && opr_stat.opr_ready_rel_micros != 0) {
+          args << "                \"dependency_wait_us\": "
+               << opr_stat.opr_ready_rel_micros - opr_stat.opr_push_rel_micros << ",\n"
+               << "                \"worker_wait_us\": "
+               << opr_stat.opr_start_rel_micros - opr_stat.opr_ready_rel_micros
+               << (opr_stat.opr_id != 0 ? ",\n" : "\n");
+        }
+        if (opr_stat.opr_id != 0) {
+          args << "                \"opr_id\": " << opr_stat.opr_id << "\n";
+        }
+        EmitSeparator();
+        this->EmitEvent(&file_, opr_stat.opr_name, "category", "B",
+              opr_stat.opr_start_rel_micros, pid, opr_stat.thread_id, args.str());
+        EmitSeparator();
+        this->EmitEvent(&file_, opr_stat.opr_name, "category", "E",
+              opr_stat.opr_end_rel_micros, pid, opr_stat.thread_id);
+      });
+    thread_stat->counter_stats.ConsumeAll([this](const CounterStat& counter_stat) {
+        EmitSeparator();
+        this->EmitCounter(&file_, counter_stat.counter_name, counter_stat.value,
+              counter_stat.rel_micros,
+              DevStatIndex(counter_stat.dev_type, counter_stat.dev_id));
+      });
+    thread_stat->flow_stats.ConsumeAll([this](const FlowStat& flow_stat) {
+        int from_pid = DevStatIndex(flow_stat.from.dev_type, flow_stat.from.dev_id);
+        int to_pid = DevStatIndex(flow_stat.to.dev_type, flow_stat.to.dev_id);
+        if (from_pid < 0 || to_pid < 0) return;
+        EmitSeparator();
+        this->EmitFlow(&file_, "s", flow_stat.flow_id, flow_stat.from.rel_micros,
+              from_pid, flow_stat.from.thread_id);
+        EmitSeparator();
+        this->EmitFlow(&file_, "f", flow_stat.flow_id, flow_stat.to.rel_micros,
+              to_pid, flow_stat.to.thread_id);
+      });
+    thread_stat->memory_stats.ConsumeAll([this](const MemoryStat& memory_stat) {
+        int pid = DevStatIndex(memory_stat.dev_type, memory_stat.dev_id);
+        std::ostringstream args;
+        args << "                \"bytes\": "
+             << (memory_stat.bytes < 0 ? -memory_stat.bytes : memory_stat.bytes) << ",\n"
+             << "                \"operator\": \"" << memory_stat.opr_name << "\"\n";
+        EmitSeparator();
+        this->EmitEvent(&file_, memory_stat.bytes < 0 ? "Free" : "Alloc", "memory", "i",
+              memory_stat.rel_micros, pid, memory_stat.thread_id, args.str());
+        EmitSeparator();
+        this->EmitCounter(&file_, "Memory in use", memory_stat.in_use,
+              memory_stat.rel_micros, pid);
+      });
+    num_dropped += thread_stat->num_dropped.exchange(0);
+  }
+  thread_stats.clear();
+  {
+    // forget the threads that exited once all their records are written
+    std::lock_guard<std::mutex> lock{thread_stats_m_};
+    auto it = thread_stats_.begin();
+    while (it != thread_stats_.end()) {
+      const ThreadStat& thread_stat = **it;
+      if (it->use_count() == 1 && thread_stat.opr_exec_stats.Empty() &&
+          thread_stat.counter_stats.Empty() && thread_stat.flow_stats.Empty() &&
+          thread_stat.memory_stats.Empty()) {
+        for (const auto& kv : thread_stat.aggregates) {
+          exited_aggregates_[kv.first].Merge(kv.second);
+        }
+        it = thread_stats_.erase(it);
       } else {
-        file << ",";
+        ++it;
       }
-      file << std::endl;
-      this->EmitEvent(&file, opr_stat->opr_name, "category", "B",
-            opr_stat->opr_start_rel_micros, pid, tid);
-      file << ",\n";
-      this->EmitEvent(&file, opr_stat->opr_name, "category", "E",
-            opr_stat->opr_end_rel_micros, pid, tid);
     }
   }
+  if (num_dropped != 0) {
+    LOG(WARNING) << num_dropped << " profiler records were dropped because the buffer "
+                 << "of their thread was full. Increase MXNET_PROFILER_BUFFER_SIZE "
+                 << "or dump the profile more often.";
+  }
+#if MXNET_USE_CUPTI
+  if (use_cupti_) {
+    uint64_t num_gpu_dropped = cupti::ConsumeAll([this](const GpuActivityStat& stat) {
+        int pid = DevStatIndex(Context::kGPU, stat.dev_id);
+        if (pid < 0) return;
+        // the streams get their own rows, apart from the engine threads
+        uint32_t tid = kGpuStreamTidBase + stat.stream_id;
+        std::ostringstream args;
+        if (stat.opr_id != 0) {
+          args << "                \"opr_id\": " << stat.opr_id << "\n";
+        }
+        EmitSeparator();
+        this->EmitEvent(&file_, stat.name, "gpu", "B", stat.start_rel_micros,
+              pid, tid, args.str());
+        EmitSeparator();
+        this->EmitEvent(&file_, stat.name, "gpu", "E", stat.end_rel_micros, pid, tid);
+        int from_pid = DevStatIndex(stat.opr.dev_type, stat.opr.dev_id);
+        if (stat.opr_id == 0 || from_pid < 0) return;
+        uint64_t flow_id = next_flow_id_++;
+        EmitSeparator();
+        this->EmitFlow(&file_, "s", flow_id, stat.opr.rel_micros,
+              from_pid, stat.opr.thread_id);
+        EmitSeparator();
+        this->EmitFlow(&file_, "f", flow_id, stat.start_rel_micros, pid, tid);
+      });
+    if (num_gpu_dropped != 0) {
+      LOG(WARNING) << num_gpu_dropped << " gpu activities were dropped because the "
+                   << "buffer was full. Increase MXNET_PROFILER_BUFFER_SIZE "
+                   << "or dump the profile more often.";
+    }
+  }
+#endif
 
-  file << "\n" << std::endl;
-  file << "    ]," << std::endl;
-  file << "    \"displayTimeUnit\": \"ms\"" << std::endl;
-  file << "}" << std::endl;
-
-  enable_output_ = false;
+  if (finished) {
+    file_ << "\n]" << std::endl;
+    file_.close();
+    enable_output_ = false;
+  } else {
+    file_.flush();
+  }
 }
 
 
-inline uint64_t NowInUsec() {
+uint64_t NowInUsec() {
 #if defined(_MSC_VER) && _MSC_VER <= 1800
   LARGE_INTEGER frequency, counter;
   QueryPerformanceFrequency(&frequency);
@@ -220,6 +577,11 @@ void SetOprStart(OprExecStat* opr_stat) {
     return;
   }
   opr_stat->opr_start_rel_micros = NowInUsec() - Profiler::Get()->GetInitTime();
+#if MXNET_USE_CUPTI
+  if (opr_stat->dev_type == Context::kGPU) {
+    opr_stat->opr_id = cupti::BeginOpr(MakeFlowEndpoint(opr_stat));
+  }
+#endif
 }
 
 void SetOprEnd(OprExecStat* opr_stat) {
@@ -228,6 +590,20 @@ void SetOprEnd(OprExecStat* opr_stat) {
     return;
   }
   opr_stat->opr_end_rel_micros   = NowInUsec() - Profiler::Get()->GetInitTime();
+#if MXNET_USE_CUPTI
+  if (opr_stat->opr_id != 0) cupti::EndOpr(opr_stat->opr_id);
+#endif
+  Profiler::Get()->RecordOprStat(*opr_stat);
+  delete opr_stat;
+}
+
+FlowEndpoint MakeFlowEndpoint(const OprExecStat* opr_stat) {
+  FlowEndpoint endpoint;
+  endpoint.rel_micros = opr_stat->opr_start_rel_micros;
+  endpoint.thread_id = opr_stat->thread_id;
+  endpoint.dev_type = opr_stat->dev_type;
+  endpoint.dev_id = opr_stat->dev_id;
+  return endpoint;
 }
 
 }  // namespace engine
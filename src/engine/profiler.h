@@ -24,10 +24,17 @@
 #ifndef MXNET_ENGINE_PROFILER_H_
 #define MXNET_ENGINE_PROFILER_H_
 
+#include <dmlc/base.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
 #include <vector>
 #include <string>
 #include <mutex>
 #include <memory>
+#include <utility>
 
 namespace mxnet {
 namespace engine {
@@ -37,7 +44,7 @@ namespace engine {
  */
 struct OprExecStat {
   /*! \brief operation name */
-  char opr_name[32];
+  char opr_name[64];
   /*!
    * \brief operation execution start relative timestamp
    *        time unit is microsecond (10^-6 s)
@@ -48,6 +55,16 @@ struct OprExecStat {
    *        time unit is microsecond (10^-6 s)
    */
   uint64_t opr_end_rel_micros;
+  /*!
+   * \brief relative timestamp of the push of the operation to the engine,
+   *        0 if unknown (time unit is microsecond)
+   */
+  uint64_t opr_push_rel_micros{0};
+  /*!
+   * \brief relative timestamp at which all dependencies of the operation were
+   *        satisfied and it was handed to a worker, 0 if unknown
+   */
+  uint64_t opr_ready_rel_micros{0};
   /*! \brief id of thread which operation run on */
   uint32_t thread_id;
   /*!
@@ -57,6 +74,289 @@ struct OprExecStat {
   uint32_t dev_type;
   /*! \brief device id */
   uint32_t dev_id;
+  /*!
+   * \brief id correlating the operation with the kernels and copies it runs
+   *        on the gpu, 0 if they are not traced
+   */
+  uint64_t opr_id{0};
+};
+
+/*!
+ * \brief Sampled value of a counter, such as the memory in use
+ */
+struct CounterStat {
+  /*! \brief counter name */
+  char counter_name[32];
+  /*!
+   * \brief sample relative timestamp
+   *        time unit is microsecond (10^-6 s)
+   */
+  uint64_t rel_micros;
+  /*! \brief value of the counter */
+  uint64_t value;
+  /*! \brief device type */
+  uint32_t dev_type;
+  /*! \brief device id */
+  uint32_t dev_id;
+};
+
+/*!
+ * \brief Allocation or free of device memory
+ */
+struct MemoryStat {
+  /*! \brief name of the operation running on the thread, empty if none */
+  char opr_name[64];
+  /*!
+   * \brief relative timestamp
+   *        time unit is microsecond (10^-6 s)
+   */
+  uint64_t rel_micros;
+  /*! \brief bytes allocated, negative for a free */
+  int64_t bytes;
+  /*! \brief bytes in use on the device afterwards */
+  uint64_t in_use;
+  /*! \brief id of thread which allocated or freed */
+  uint32_t thread_id;
+  /*! \brief device type */
+  uint32_t dev_type;
+  /*! \brief device id */
+  uint32_t dev_id;
+};
+
+/*!
+ * \brief Names the operation the calling thread runs while in scope, so the
+ *  memory it allocates and frees is attributed to the operation.
+ */
+class MemoryScope {
+ public:
+  /*! \param opr_name name of the operation, nullptr for none */
+  explicit MemoryScope(const char* opr_name) : prev_(current_) {
+    current_ = opr_name;
+  }
+  ~MemoryScope() {
+    current_ = prev_;
+  }
+  /*! \return name of the operation in scope on the calling thread, nullptr if none */
+  static const char* Current() {
+    return current_;
+  }
+
+ private:
+  /*! \brief the scope this one is nested in */
+  const char* prev_;
+  /*! \brief the innermost scope of the thread */
+  static MX_THREAD_LOCAL const char* current_;
+};
+
+/*!
+ * \brief One end of a dependency between two operations
+ */
+struct FlowEndpoint {
+  /*!
+   * \brief relative timestamp within the operation, 0 if there is none
+   *        time unit is microsecond (10^-6 s)
+   */
+  uint64_t rel_micros{0};
+  /*! \brief id of thread which operation run on */
+  uint32_t thread_id{0};
+  /*! \brief device type */
+  uint32_t dev_type{0};
+  /*! \brief device id */
+  uint32_t dev_id{0};
+};
+
+/*!
+ * \brief Dependency from an operation writing a variable to one using it
+ */
+struct FlowStat {
+  /*! \brief unique id of the dependency */
+  uint64_t flow_id;
+  /*! \brief the operation that wrote the variable */
+  FlowEndpoint from;
+  /*! \brief the operation waiting for the write */
+  FlowEndpoint to;
+};
+
+/*!
+ * \brief Execution of a kernel, memory copy or memset on a gpu, as traced by CUPTI
+ */
+struct GpuActivityStat {
+  /*! \brief name of the kernel, or kind of the copy */
+  std::string name;
+  /*! \brief start relative timestamp, time unit is microsecond (10^-6 s) */
+  uint64_t start_rel_micros;
+  /*! \brief end relative timestamp, time unit is microsecond (10^-6 s) */
+  uint64_t end_rel_micros;
+  /*! \brief device id */
+  uint32_t dev_id;
+  /*! \brief CUPTI id of the stream it ran on */
+  uint32_t stream_id;
+  /*! \brief id of the operation which launched it, 0 if unknown */
+  uint64_t opr_id;
+  /*! \brief the start of the operation which launched it */
+  FlowEndpoint opr;
+};
+
+#if MXNET_USE_CUPTI
+/*!
+ * \brief Tracing of the gpu activities with CUPTI. The runtime API calls
+ *  issued while an operation runs are attributed to it, and so are the
+ *  kernels and copies they launch.
+ */
+namespace cupti {
+/*!
+ * \brief start tracing
+ * \param init_time the time the relative timestamps are counted from
+ * \param capacity maximum number of activities buffered between two dumps
+ */
+void Start(uint64_t init_time, size_t capacity);
+/*! \brief stop tracing, the activities traced so far can still be consumed */
+void Stop();
+/*!
+ * \brief attribute the gpu work launched by the calling thread to an operation
+ * \return the id of the operation, 0 if not tracing
+ */
+uint64_t BeginOpr(const FlowEndpoint& start);
+/*! \brief end the attribution started by BeginOpr on the calling thread */
+void EndOpr(uint64_t opr_id);
+/*!
+ * \brief pass the activities completed so far to fn and remove them
+ * \return number of activities dropped since the last call
+ */
+uint64_t ConsumeAll(const std::function<void(const GpuActivityStat&)>& fn);
+}  // namespace cupti
+#endif  // MXNET_USE_CUPTI
+
+/*!
+ * \brief Bounded single producer, single consumer ring buffer.
+ *  The owning thread pushes records without taking a lock, the profiler
+ *  drains them when dumping. Records pushed while the buffer is full are
+ *  dropped.
+ * \tparam T type of the records.
+ */
+template<typename T>
+class ProfileRingBuffer {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param capacity Maximum number of records buffered.
+   */
+  explicit ProfileRingBuffer(size_t capacity) : data_(capacity) {}
+  /*!
+   * \brief Push a record, only called by the owning thread.
+   * \return false if the buffer is full and the record was dropped.
+   */
+  bool Push(const T& record) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= data_.size()) return false;
+    data_[head % data_.size()] = record;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  /*!
+   * \brief Pass all buffered records to fn and remove them.
+   *  Only called by one consumer at a time.
+   */
+  template<typename Fn>
+  void ConsumeAll(Fn fn) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) fn(data_[tail % data_.size()]);
+    tail_.store(tail, std::memory_order_release);
+  }
+  /*! \return whether the buffer holds no record */
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  /*! \brief storage of the records */
+  std::vector<T> data_;
+  /*! \brief number of records ever pushed */
+  std::atomic<size_t> head_{0};
+  /*! \brief number of records ever consumed */
+  std::atomic<size_t> tail_{0};
+};
+
+/*!
+ * \brief Running aggregate of the durations of one operator on one device.
+ *  Percentiles come from a histogram with 16 buckets per power of two, so
+ *  they are exact up to 16us and within about 6% above.
+ */
+struct AggregateStat {
+  /*! \brief number of executions */
+  uint64_t count{0};
+  /*! \brief total duration, time unit is microsecond (10^-6 s) */
+  uint64_t total_micros{0};
+  /*! \brief shortest duration */
+  uint64_t min_micros{UINT64_MAX};
+  /*! \brief longest duration */
+  uint64_t max_micros{0};
+  /*! \brief number of executions by duration bucket */
+  std::vector<uint64_t> histogram;
+  /*! \brief add one execution */
+  void Add(uint64_t micros);
+  /*! \brief add all executions of another aggregate */
+  void Merge(const AggregateStat& other);
+  /*!
+   * \return the duration below which the fraction q of the executions fall
+   * \param q the fraction, between 0 and 1
+   */
+  uint64_t Percentile(double q) const;
+  /*! \return the average duration, 0 if there is no execution */
+  uint64_t Average() const {
+    return count == 0 ? 0 : total_micros / count;
+  }
+};
+
+/*!
+ * \brief Running aggregates of one operator on one device
+ */
+struct OprAggregateStat {
+  /*! \brief duration of the execution */
+  AggregateStat duration;
+  /*! \brief time from the push to the engine until the dependencies are satisfied */
+  AggregateStat dependency_wait;
+  /*! \brief time from the dependencies being satisfied until the execution starts */
+  AggregateStat worker_wait;
+  /*! \brief add one execution */
+  void Add(const OprExecStat& opr_stat);
+  /*! \brief add all executions of another aggregate */
+  void Merge(const OprAggregateStat& other) {
+    duration.Merge(other.duration);
+    dependency_wait.Merge(other.dependency_wait);
+    worker_wait.Merge(other.worker_wait);
+  }
+};
+
+/*! \brief aggregates by device index and operator name */
+typedef std::map<std::pair<uint32_t, std::string>, OprAggregateStat> AggregateTable;
+
+/*!
+ * \brief Records of one thread
+ */
+struct ThreadStat {
+  /*!
+   * \brief Constructor.
+   * \param capacity Maximum number of records of each kind buffered.
+   */
+  explicit ThreadStat(size_t capacity)
+      : opr_exec_stats(capacity), counter_stats(capacity), flow_stats(capacity),
+        memory_stats(capacity) {}
+  /*! \brief operation execution statistics */
+  ProfileRingBuffer<OprExecStat> opr_exec_stats;
+  /*! \brief counter samples */
+  ProfileRingBuffer<CounterStat> counter_stats;
+  /*! \brief dependencies between operations */
+  ProfileRingBuffer<FlowStat> flow_stats;
+  /*! \brief allocations and frees of memory */
+  ProfileRingBuffer<MemoryStat> memory_stats;
+  /*! \brief number of records dropped because a buffer was full */
+  std::atomic<uint64_t> num_dropped{0};
+  /*! \brief mutex protecting aggregates, only contended while printing */
+  std::mutex aggregates_m;
+  /*! \brief aggregates of the operations recorded on this thread */
+  AggregateTable aggregates;
 };
 
 /*!
@@ -65,16 +365,17 @@ struct OprExecStat {
 struct DevStat {
   /*! \brief device name */
   std::string dev_name;
-  /*! \brief operation execution statistics on this device */
-  std::vector<OprExecStat*> opr_exec_stats;
-  /*! \brief internal mutex of the execution state */
-  std::mutex m_;
 };
 
 
 /*!
  * \brief profiler that records the operation execution information
  *        and saves the profile statistics.
+ *
+ *  Every thread records into its own bounded ring buffers, so a long run
+ *  can be profiled without growing memory. The buffers are written to the
+ *  trace file in chrome tracing format on every dump, dumps that are not
+ *  finished leave the profiler running and keep appending to the file.
  */
 class Profiler {
  public:
@@ -102,15 +403,39 @@ class Profiler {
   inline bool IsEnableOutput() const {
     return this->enable_output_;
   }
-  /*! \brief dump the profile file */
-  void DumpProfile();
+  /*!
+   * \brief dump the records buffered since the last dump to the profile file
+   * \param finished whether to stop the profiler and complete the file,
+   *        otherwise the profiler keeps running and the next dump appends to it
+   */
+  void DumpProfile(bool finished = true);
   /*! \return the profiler init time, time unit is microsecond (10^-6) s */
   inline uint64_t GetInitTime() const {
     return init_time_;
   }
-  /*! \brief add one operation execution record in
-   *   corresponding device statistics */
+  /*! \brief create an operation execution record for an operation on a device,
+   *   it is recorded once SetOprEnd is called */
   OprExecStat* AddOprStat(int dev_type, uint32_t dev_id);
+  /*! \brief record a finished operation in the buffer of the calling thread */
+  void RecordOprStat(const OprExecStat& opr_stat);
+  /*! \brief add one counter sample in corresponding device statistics */
+  void AddCounterStat(int dev_type, uint32_t dev_id, const char* name, uint64_t value);
+  /*!
+   * \brief add one allocation or free of memory, attributed to the operation
+   *  in the MemoryScope of the calling thread
+   * \param bytes bytes allocated, negative for a free
+   * \param in_use bytes in use on the device afterwards
+   */
+  void AddMemoryStat(int dev_type, uint32_t dev_id, int64_t bytes, uint64_t in_use);
+  /*! \brief add one dependency between two operations */
+  void AddFlowStat(const FlowEndpoint& from, const FlowEndpoint& to);
+  /*!
+   * \brief print the aggregated statistics of every operator by device
+   * \param reset whether to clear the aggregates afterwards
+   * \return a table with the count, total, min, max, p50 and p99 durations,
+   *  and the average and p99 times spent waiting for dependencies and workers
+   */
+  std::string AggregateStatsPrint(bool reset);
   /*! \return Profiler singleton */
   static Profiler* Get();
 
@@ -119,11 +444,24 @@ class Profiler {
   Profiler();
 
  private:
+  /*! \return the records of the calling thread */
+  ThreadStat* GetThreadStat();
+  /*! \return index of the device statistics, -1 for an unknown device */
+  int DevStatIndex(int dev_type, uint32_t dev_id) const;
+  /*! \brief write the separator before the next event of the profile file */
+  void EmitSeparator();
   /*! \brief generate device information following chrome profile file format */
   void EmitPid(std::ostream *os, const std::string& name, uint32_t pid);
   /*! \brief generate event information following chrome profile file format */
   void EmitEvent(std::ostream *os, const std::string& name,
           const std::string& category, const std::string& ph,
+          uint64_t ts, uint32_t pid, uint32_t tid,
+          const std::string& args = std::string());
+  /*! \brief generate counter information following chrome profile file format */
+  void EmitCounter(std::ostream *os, const std::string& name,
+          uint64_t value, uint64_t ts, uint32_t pid);
+  /*! \brief generate flow information following chrome profile file format */
+  void EmitFlow(std::ostream *os, const std::string& ph, uint64_t id,
           uint64_t ts, uint32_t pid, uint32_t tid);
   /*! \brief Profiler instance */
   static Profiler* instance_;
@@ -137,8 +475,24 @@ class Profiler {
   ProfilerMode mode_;
   /*! \brief filename to output profile file */
   std::string filename_;
+  /*! \brief the profile file, open between the first and the finishing dump */
+  std::ofstream file_;
+  /*! \brief whether no event has been written to the profile file yet */
+  bool first_event_{true};
   /*! \brief profile statistics consist of multiple device statistics */
   DevStat* profile_stat;
+  /*! \brief mutex protecting thread_stats_ */
+  std::mutex thread_stats_m_;
+  /*! \brief records of every thread that recorded something */
+  std::vector<std::shared_ptr<ThreadStat> > thread_stats_;
+  /*! \brief aggregates of the threads that exited, protected by thread_stats_m_ */
+  AggregateTable exited_aggregates_;
+  /*! \brief maximum number of records of each kind buffered per thread */
+  size_t buffer_size_;
+  /*! \brief whether the kernels and copies on the gpus are traced with CUPTI */
+  bool use_cupti_{false};
+  /*! \brief id of the next dependency */
+  std::atomic<uint64_t> next_flow_id_{0};
   /*! \brief cpu number on the machine */
   unsigned int cpu_num_;
   /*! \brief gpu number on the machine */
@@ -148,11 +502,16 @@ class Profiler {
 };
 
 /*! \return current clock time, time unit is microsecond (10^-6 s) */
-inline uint64_t NowInUsec();
+uint64_t NowInUsec();
 /*! \brief set operation execution start timestamp */
 void SetOprStart(OprExecStat* opr_stat);
-/*! \brief set operation execution end timestamp */
+/*!
+ * \brief set operation execution end timestamp and record the operation,
+ *  opr_stat is released and must not be used afterwards
+ */
 void SetOprEnd(OprExecStat* opr_stat);
+/*! \return the start of a started operation as end of a dependency */
+FlowEndpoint MakeFlowEndpoint(const OprExecStat* opr_stat);
 
 }  // namespace engine
 }  // namespace mxnet
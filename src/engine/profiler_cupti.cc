@@ -0,0 +1,290 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file profiler_cupti.cc
+ * \brief traces the kernels and memory copies on the gpus with CUPTI
+ */
+#include "./profiler.h"
+
+#if MXNET_USE_CUPTI
+#include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
+#include <cuda.h>
+#include <cupti.h>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define CUPTI_CALL(func)                                                 \
+  {                                                                      \
+    CUptiResult e = (func);                                              \
+    if (e != CUPTI_SUCCESS) {                                            \
+      const char* msg;                                                   \
+      cuptiGetResultString(e, &msg);                                     \
+      LOG(FATAL) << "CUPTI: " << msg;                                    \
+    }                                                                    \
+  }
+
+namespace mxnet {
+namespace engine {
+namespace cupti {
+namespace {
+
+#if CUDA_VERSION >= 9000
+typedef CUpti_ActivityKernel4 ActivityKernel;
+#else
+typedef CUpti_ActivityKernel3 ActivityKernel;
+#endif
+
+/*! \brief size of the activity buffers handed to CUPTI */
+const size_t kBufferSize = 1 << 20;
+/*! \brief alignment of the activity buffers required by CUPTI */
+const size_t kBufferAlign = 8;
+
+/*! \brief the operation running on a thread */
+struct ThreadOpr {
+  uint64_t id{0};
+  FlowEndpoint start;
+};
+
+struct Tracer {
+  std::mutex mu;
+  bool running{false};
+  CUpti_SubscriberHandle subscriber;
+  /*! \brief the time the relative timestamps are counted from, in microseconds */
+  uint64_t init_time{0};
+  /*! \brief NowInUsec() in nanoseconds minus the CUPTI timestamp */
+  int64_t offset_ns{0};
+  size_t capacity{0};
+  uint64_t num_dropped{0};
+  uint64_t next_opr_id{1};
+  /*! \brief the operation calling the runtime API, by correlation id */
+  std::unordered_map<uint32_t, ThreadOpr> launches;
+  std::vector<GpuActivityStat> activities;
+};
+
+Tracer* GetTracer() {
+  static Tracer inst;
+  return &inst;
+}
+
+uint64_t RelMicros(const Tracer* t, uint64_t timestamp) {
+  int64_t micros = (static_cast<int64_t>(timestamp) + t->offset_ns) / 1000 -
+      static_cast<int64_t>(t->init_time);
+  return micros > 0 ? micros : 0;
+}
+
+/*! \brief whether a runtime API call launches work on a gpu */
+bool IsLaunch(CUpti_CallbackId cbid) {
+  switch (cbid) {
+    case CUPTI_RUNTIME_TRACE_CBID_cudaLaunch_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaLaunchKernel_v7000:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpyAsync_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy2D_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy2DAsync_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpyPeer_v4000:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemcpyPeerAsync_v4000:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemset_v3020:
+    case CUPTI_RUNTIME_TRACE_CBID_cudaMemsetAsync_v3020:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void CUPTIAPI OnRuntimeApi(void* userdata, CUpti_CallbackDomain domain,
+                           CUpti_CallbackId cbid, const void* cbdata) {
+  const auto* info = static_cast<const CUpti_CallbackData*>(cbdata);
+  if (info->callbackSite != CUPTI_API_ENTER || !IsLaunch(cbid)) return;
+  const ThreadOpr* opr = dmlc::ThreadLocalStore<ThreadOpr>::Get();
+  if (opr->id == 0) return;
+  Tracer* t = GetTracer();
+  std::lock_guard<std::mutex> lock(t->mu);
+  t->launches[info->correlationId] = *opr;
+}
+
+void CUPTIAPI OnBufferRequested(uint8_t** buffer, size_t* size, size_t* max_num_records) {
+  void* ptr = nullptr;
+  CHECK_EQ(posix_memalign(&ptr, kBufferAlign, kBufferSize), 0);
+  *buffer = static_cast<uint8_t*>(ptr);
+  *size = kBufferSize;
+  *max_num_records = 0;
+}
+
+const char* MemcpyName(uint8_t kind) {
+  switch (kind) {
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOD: return "Memcpy HtoD";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOH: return "Memcpy DtoH";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOD: return "Memcpy DtoD";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_PTOP: return "Memcpy PtoP";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOH: return "Memcpy HtoH";
+    default: return "Memcpy";
+  }
+}
+
+void CUPTIAPI OnBufferCompleted(CUcontext ctx, uint32_t stream_id, uint8_t* buffer,
+                                size_t size, size_t valid_size) {
+  Tracer* t = GetTracer();
+  {
+    std::lock_guard<std::mutex> lock(t->mu);
+    CUpti_Activity* record = nullptr;
+    while (cuptiActivityGetNextRecord(buffer, valid_size, &record) == CUPTI_SUCCESS) {
+      GpuActivityStat stat;
+      uint32_t correlation_id;
+      switch (record->kind) {
+        case CUPTI_ACTIVITY_KIND_KERNEL:
+        case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
+          const auto* kernel = reinterpret_cast<const ActivityKernel*>(record);
+          stat.name = kernel->name;
+          stat.start_rel_micros = RelMicros(t, kernel->start);
+          stat.end_rel_micros = RelMicros(t, kernel->end);
+          stat.dev_id = kernel->deviceId;
+          stat.stream_id = kernel->streamId;
+          correlation_id = kernel->correlationId;
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_MEMCPY: {
+          const auto* memcpy = reinterpret_cast<const CUpti_ActivityMemcpy*>(record);
+          stat.name = MemcpyName(memcpy->copyKind);
+          stat.start_rel_micros = RelMicros(t, memcpy->start);
+          stat.end_rel_micros = RelMicros(t, memcpy->end);
+          stat.dev_id = memcpy->deviceId;
+          stat.stream_id = memcpy->streamId;
+          correlation_id = memcpy->correlationId;
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_MEMSET: {
+          const auto* memset = reinterpret_cast<const CUpti_ActivityMemset*>(record);
+          stat.name = "Memset";
+          stat.start_rel_micros = RelMicros(t, memset->start);
+          stat.end_rel_micros = RelMicros(t, memset->end);
+          stat.dev_id = memset->deviceId;
+          stat.stream_id = memset->streamId;
+          correlation_id = memset->correlationId;
+          break;
+        }
+        default:
+          continue;
+      }
+      auto it = t->launches.find(correlation_id);
+      if (it != t->launches.end()) {
+        stat.opr_id = it->second.id;
+        stat.opr = it->second.start;
+        t->launches.erase(it);
+      } else {
+        stat.opr_id = 0;
+      }
+      if (t->activities.size() < t->capacity) {
+        t->activities.push_back(std::move(stat));
+      } else {
+        ++t->num_dropped;
+      }
+    }
+  }
+  free(buffer);
+}
+
+const CUpti_ActivityKind kActivityKinds[] = {
+  CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL,
+  CUPTI_ACTIVITY_KIND_MEMCPY,
+  CUPTI_ACTIVITY_KIND_MEMSET
+};
+
+}  // namespace
+
+void Start(uint64_t init_time, size_t capacity) {
+  Tracer* t = GetTracer();
+  std::lock_guard<std::mutex> lock(t->mu);
+  if (t->running) return;
+  t->init_time = init_time;
+  t->capacity = capacity;
+  uint64_t timestamp;
+  CUPTI_CALL(cuptiGetTimestamp(&timestamp));
+  t->offset_ns = static_cast<int64_t>(NowInUsec()) * 1000 - static_cast<int64_t>(timestamp);
+  CUPTI_CALL(cuptiActivityRegisterCallbacks(OnBufferRequested, OnBufferCompleted));
+  CUPTI_CALL(cuptiSubscribe(&t->subscriber,
+                            reinterpret_cast<CUpti_CallbackFunc>(OnRuntimeApi), nullptr));
+  CUPTI_CALL(cuptiEnableDomain(1, t->subscriber, CUPTI_CB_DOMAIN_RUNTIME_API));
+  for (CUpti_ActivityKind kind : kActivityKinds) {
+    CUPTI_CALL(cuptiActivityEnable(kind));
+  }
+  t->running = true;
+}
+
+void Stop() {
+  Tracer* t = GetTracer();
+  {
+    std::lock_guard<std::mutex> lock(t->mu);
+    if (!t->running) return;
+    for (CUpti_ActivityKind kind : kActivityKinds) {
+      CUPTI_CALL(cuptiActivityDisable(kind));
+    }
+    CUPTI_CALL(cuptiUnsubscribe(t->subscriber));
+    t->running = false;
+  }
+  // the completed buffers are handed over without the lock
+  CUPTI_CALL(cuptiActivityFlushAll(0));
+}
+
+uint64_t BeginOpr(const FlowEndpoint& start) {
+  Tracer* t = GetTracer();
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(t->mu);
+    if (!t->running) return 0;
+    id = t->next_opr_id++;
+  }
+  ThreadOpr* opr = dmlc::ThreadLocalStore<ThreadOpr>::Get();
+  opr->id = id;
+  opr->start = start;
+  return id;
+}
+
+void EndOpr(uint64_t opr_id) {
+  // an asynchronous operation may complete on another thread
+  ThreadOpr* opr = dmlc::ThreadLocalStore<ThreadOpr>::Get();
+  if (opr->id == opr_id) opr->id = 0;
+}
+
+uint64_t ConsumeAll(const std::function<void(const GpuActivityStat&)>& fn) {
+  CUPTI_CALL(cuptiActivityFlushAll(0));
+  Tracer* t = GetTracer();
+  std::vector<GpuActivityStat> activities;
+  uint64_t num_dropped;
+  {
+    std::lock_guard<std::mutex> lock(t->mu);
+    activities.swap(t->activities);
+    num_dropped = t->num_dropped;
+    t->num_dropped = 0;
+    // the launches whose activities are not completed yet are not attributed
+    t->launches.clear();
+  }
+  for (const auto& stat : activities) fn(stat);
+  return num_dropped;
+}
+
+}  // namespace cupti
+}  // namespace engine
+}  // namespace mxnet
+#endif  // MXNET_USE_CUPTI
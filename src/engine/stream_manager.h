@@ -37,7 +37,8 @@ namespace engine {
  * \brief Stream manager.
  *
  * Uses a basic round-robin algorithm to dispatch GPU streams. Returns default
- * context on CPU.
+ * context on CPU. The copies to and from each GPU get a stream per direction,
+ * so that uploads and downloads run on both copy engines at the same time.
  */
 template <std::size_t kNumGpus, std::size_t kStreams>
 class StreamManager {
@@ -47,14 +48,20 @@ class StreamManager {
     Finalize();
   }
   RunContext GetRunContext(Context const& ctx);
-  RunContext GetIORunContext(Context const& ctx);
+  /*!
+   * \brief Get the run context of the copies of one direction.
+   * \param ctx the context of the copy
+   * \param to_gpu whether the copy is to the GPU, otherwise from it
+   */
+  RunContext GetIORunContext(Context const& ctx, bool to_gpu);
   void Finalize();
  private:
   std::mutex m_;
 #if MXNET_USE_CUDA
   std::array<std::array<mshadow::Stream<gpu>*, kStreams>, kNumGpus>
       gpu_streams_;
-  std::array<mshadow::Stream<gpu>*, kNumGpus> gpu_io_streams_;
+  /*! \brief streams of the copies to each GPU, index 1, and from it, index 0 */
+  std::array<std::array<mshadow::Stream<gpu>*, 2>, kNumGpus> gpu_io_streams_;
   std::array<int, kNumGpus> gpu_cnt_;
 #endif  // MXNET_USE_CUDA
   DISALLOW_COPY_AND_ASSIGN(StreamManager);
@@ -96,7 +103,7 @@ RunContext StreamManager<kNumGpus, kStreams>::GetRunContext(
 
 template <std::size_t kNumGpus, std::size_t kStreams>
 RunContext StreamManager<kNumGpus, kStreams>::GetIORunContext(
-    Context const& ctx) {
+    Context const& ctx, bool to_gpu) {
   RunContext ret;
   switch (ctx.dev_mask()) {
     case cpu::kDevMask:
@@ -105,13 +112,16 @@ RunContext StreamManager<kNumGpus, kStreams>::GetIORunContext(
     case gpu::kDevMask: {
 #if MXNET_USE_CUDA
       CUDA_CALL(cudaSetDevice(ctx.dev_id));
+      mshadow::Stream<gpu>* stream;
       {
         std::lock_guard<std::mutex> lock{m_};
-        if (gpu_io_streams_.at(ctx.dev_id) == nullptr) {
-          gpu_io_streams_.at(ctx.dev_id) = mshadow::NewStream<gpu>(false, false, ctx.dev_id);
+        auto&& io_stream = gpu_io_streams_.at(ctx.dev_id).at(to_gpu);
+        if (io_stream == nullptr) {
+          io_stream = mshadow::NewStream<gpu>(false, false, ctx.dev_id);
         }
+        stream = io_stream;
       }
-      ret = RunContext{ctx, gpu_io_streams_.at(ctx.dev_id)};
+      ret = RunContext{ctx, stream};
       break;
 #else
       LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
@@ -128,7 +138,7 @@ StreamManager<kNumGpus, kStreams>::StreamManager() {
     gpu_cnt_.at(i) = -1;
   }
   for (auto&& i : gpu_io_streams_) {
-    i = nullptr;
+    i.fill(nullptr);
   }
 #endif  // MXNET_USE_CUDA
 }
@@ -144,6 +154,12 @@ void StreamManager<kNumGpus, kStreams>::Finalize() {
       }
       gpu_cnt_.at(i) = -1;
     }
+    for (auto&& j : gpu_io_streams_.at(i)) {
+      if (j != nullptr) {
+        MSHADOW_CATCH_ERROR(mshadow::DeleteStream<gpu>(j));
+        j = nullptr;
+      }
+    }
   }
 #endif  // MXNET_USE_CUDA
 }
@@ -26,6 +26,7 @@
 #include <cassert>
 #include <algorithm>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <utility>
 #include "./threaded_engine.h"
@@ -48,7 +49,7 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 }
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
-  std::lock_guard<std::mutex> lock{m_};
+  std::lock_guard<VarMutex> lock{m_};
   if (pending_write_ == nullptr) {
     // invariant: is_ready_to_read()
     CHECK_GE(num_pending_reads_, 0);
@@ -70,7 +71,7 @@ inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
 
 inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   auto&& new_var_block = VersionedVarBlock::New();
-  std::lock_guard<std::mutex> lock{m_};
+  std::lock_guard<VarMutex> lock{m_};
   // invariant.
   assert(head_->next == nullptr);
   assert(head_->trigger == nullptr);
@@ -101,7 +102,7 @@ inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
   OprBlock *trigger = nullptr;
   {
     // this is lock scope
-    std::lock_guard<std::mutex> lock{m_};
+    std::lock_guard<VarMutex> lock{m_};
     CHECK_GT(num_pending_reads_, 0);
 
     if (--num_pending_reads_ == 0) {
@@ -117,13 +118,23 @@ inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
   }
 }
 
+/*! \brief move the functions of OnVarReady registered on a block to *out */
+inline void MoveReadyCallbacks(VersionedVarBlock* block,
+                               std::vector<std::function<void()> >* out) {
+  if (block->on_ready.empty()) return;
+  for (auto& fn : block->on_ready) out->push_back(std::move(fn));
+  block->on_ready.clear();
+}
+
 template <typename Dispatcher>
 inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
   // this is lock scope
   VersionedVarBlock *old_pending_write, *end_of_read_chain;
   OprBlock* trigger_write = nullptr;
+  // the functions of OnVarReady waiting for this write
+  std::vector<std::function<void()> > on_ready;
   {
-    std::lock_guard<std::mutex> lock{m_};
+    std::unique_lock<VarMutex> lock{m_};
     // invariants
     assert(head_->next == nullptr);
     assert(pending_write_ != nullptr);
@@ -132,9 +143,12 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     // really delete
     if (to_delete_) {
       VersionedVarBlock *head = pending_write_->next;
+      on_ready.swap(head->on_ready);
       VersionedVarBlock::Delete(pending_write_);
       assert(head_ == head);
       VersionedVarBlock::Delete(head);
+      lock.unlock();
+      for (auto& fn : on_ready) fn();
       return true;
     }
     // detach pending write
@@ -146,8 +160,10 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     while (end_of_read_chain != head_ &&
            end_of_read_chain->write == false) {
       ++num_pending_reads_;
+      MoveReadyCallbacks(end_of_read_chain, &on_ready);
       end_of_read_chain = end_of_read_chain->next;
     }
+    MoveReadyCallbacks(end_of_read_chain, &on_ready);
     if (end_of_read_chain == head_) {
       pending_write_ = nullptr;
     } else {
@@ -182,19 +198,29 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
   if (trigger_write != nullptr && trigger_write->decr_wait() == 0) {
     dispatcher(trigger_write);
   }
+  for (auto& fn : on_ready) fn();
   return false;
 }
 
 inline void ThreadedVar::SetToDelete() {
-  std::lock_guard<std::mutex> lock{m_};
+  std::lock_guard<VarMutex> lock{m_};
   to_delete_ = true;
 }
 
 inline bool ThreadedVar::ready_to_read() {
-  std::lock_guard<std::mutex> lock{m_};
+  std::lock_guard<VarMutex> lock{m_};
   return this->is_ready_to_read();
 }
 
+inline bool ThreadedVar::AppendReadyCallback(std::function<void()>* callback) {
+  std::lock_guard<VarMutex> lock{m_};
+  if (this->is_ready_to_read()) return false;
+  // head_ is the block of the next operation appended, it is reached when
+  // the writes appended before are completed
+  head_->on_ready.push_back(std::move(*callback));
+  return true;
+}
+
 // implementation of threaded engine
 ThreadedVar* ThreadedEngine::NewVariable() {
   return ThreadedVar::New(VersionedVarBlock::New());
@@ -274,6 +300,8 @@ void ThreadedEngine::DeleteOperator(OprHandle op) {
 }
 
 void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool profiling) {
+  // keep the push order of the thread for the merged operations
+  BulkFlush();
   ThreadedOpr* threaded_opr = ThreadedOpr::CastFromBase(op);
   OprBlock* opr_block = OprBlock::New();
   opr_block->opr = threaded_opr;
@@ -284,6 +312,11 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
   opr_block->ctx = exec_ctx;
   opr_block->priority = priority;
   opr_block->profiling = profiling;
+#if MXNET_USE_PROFILER
+  if (profiling) {
+    opr_block->push_rel_micros = NowInUsec() - Profiler::Get()->GetInitTime();
+  }
+#endif
   ++pending_;
   // Add read dependencies.
   for (auto&& i : threaded_opr->const_vars) {
@@ -294,7 +327,7 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
     i->AppendWriteDependency(opr_block);
   }
   if (opr_block->decr_wait() == 0) {
-    this->PushToExecute(opr_block, true);
+    this->PushReady(opr_block, true);
   }
 }
 
@@ -316,6 +349,65 @@ void ThreadedEngine::PushAsync(AsyncFn fn, Context exec_ctx,
   Push(opr, exec_ctx, priority, profiling);
 }
 
+void ThreadedEngine::PushSync(SyncFn exec_fn, Context exec_ctx,
+                              std::vector<VarHandle> const& const_vars,
+                              std::vector<VarHandle> const& mutable_vars,
+                              FnProperty prop,
+                              int priority,
+                              const char* opr_name) {
+  BulkStatus* bulk = BulkStatusStore::Get();
+  if (bulk->bulk_size <= 1 || prop != FnProperty::kNormal || priority != 0) {
+    Engine::PushSync(std::move(exec_fn), exec_ctx, const_vars, mutable_vars,
+                     prop, priority, opr_name);
+    return;
+  }
+  if (bulk->count != 0 && bulk->ctx != exec_ctx) BulkFlush();
+  if (bulk->count == 0) {
+    bulk->ctx = exec_ctx;
+    bulk->functions = std::make_shared<std::vector<SyncFn> >();
+  }
+  bulk->functions->push_back(std::move(exec_fn));
+  bulk->const_vars.insert(bulk->const_vars.end(), const_vars.begin(), const_vars.end());
+  bulk->mutable_vars.insert(bulk->mutable_vars.end(), mutable_vars.begin(), mutable_vars.end());
+  if (++bulk->count >= bulk->bulk_size) BulkFlush();
+}
+
+void ThreadedEngine::BulkFlush() {
+  BulkStatus* bulk = BulkStatusStore::Get();
+  if (bulk->count == 0) return;
+  bulk->count = 0;
+  // the vars of an operation are distinct, this also drops the reads
+  // of the vars written by another of the merged operations
+  DeduplicateVarHandle(&bulk->const_vars, &bulk->mutable_vars);
+  std::shared_ptr<std::vector<SyncFn> > functions = std::move(bulk->functions);
+  std::vector<VarHandle> const_vars, mutable_vars;
+  const_vars.swap(bulk->const_vars);
+  mutable_vars.swap(bulk->mutable_vars);
+  const Context ctx = bulk->ctx;
+  this->PushAsync([functions](RunContext rctx, CallbackOnComplete on_complete) {
+      rctx.is_bulk = true;
+      for (const SyncFn& fn : *functions) fn(rctx);
+#if MXNET_USE_CUDA
+      if (rctx.ctx.dev_mask() == gpu::kDevMask) {
+        rctx.get_stream<gpu>()->Wait();
+      }
+#endif
+      on_complete();
+    }, ctx, const_vars, mutable_vars, FnProperty::kNormal, 0,
+    PROFILER_MESSAGE("EngineBulk"));
+}
+
+int ThreadedEngine::set_bulk_size(int bulk_size) {
+  BulkStatus* bulk = BulkStatusStore::Get();
+  std::swap(bulk->bulk_size, bulk_size);
+  if (bulk->count >= bulk->bulk_size) BulkFlush();
+  return bulk_size;
+}
+
+int ThreadedEngine::bulk_size() const {
+  return BulkStatusStore::Get()->bulk_size;
+}
+
 void ThreadedEngine::DeleteVariable(SyncFn delete_fn,
                                     Context exec_ctx,
                                     VarHandle var) {
@@ -330,6 +422,7 @@ void ThreadedEngine::DeleteVariable(SyncFn delete_fn,
 }
 
 void ThreadedEngine::WaitForVar(VarHandle var) {
+  BulkFlush();
   ThreadedVar* threaded_var = ThreadedVar::CastFromBase(var);
   if (threaded_var->ready_to_read()) return;
   if (engine_info_) {
@@ -337,7 +430,7 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
     debug_wait_var_ = threaded_var;
   }
   std::atomic<bool> done{false};
-  this->PushSync([this, &done](RunContext) {
+  this->PushAsync([this, &done](RunContext, CallbackOnComplete on_complete) {
       if (engine_info_) {
         LOG(INFO) << "Sync is executed";
       }
@@ -349,6 +442,7 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
       if (engine_info_) {
         LOG(INFO) << "Sync is notified";
       }
+      on_complete();
     }, Context::CPU(), {var}, {}, FnProperty::kNormal, 0,
     PROFILER_MESSAGE("WaitForVar"));
   {
@@ -359,7 +453,20 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
   }
 }
 
+bool ThreadedEngine::IsVarReady(VarHandle var) {
+  BulkFlush();
+  return ThreadedVar::CastFromBase(var)->ready_to_read();
+}
+
+void ThreadedEngine::OnVarReady(VarHandle var, std::function<void()> callback) {
+  BulkFlush();
+  if (!ThreadedVar::CastFromBase(var)->AppendReadyCallback(&callback)) {
+    callback();
+  }
+}
+
 void ThreadedEngine::WaitForAll() {
+  BulkFlush();
   std::unique_lock<std::mutex> lock{finished_m_};
   finished_cv_.wait(lock, [this]() {
       return pending_.load() == 0 || kill_.load();
@@ -371,7 +478,7 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
   // Mark complete for read variables
   for (auto&& i : threaded_opr->const_vars) {
     i->CompleteReadDependency([this](OprBlock* opr) {
-        this->PushToExecute(opr, false);
+        this->PushReady(opr, false);
       });
   }
   // Mark complete for write variables.
@@ -386,7 +493,7 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
             LOG(INFO) << "PushToExecute " << opr;
             debug_push_opr_ = opr;
           }
-          this->PushToExecute(opr, false);
+          this->PushReady(opr, false);
           if (debug_info) {
             LOG(INFO) << "Fin PushToExecute " << opr;
           }
@@ -422,8 +529,13 @@ void ThreadedEngine::OnCompleteStatic(
   ThreadedOpr *threaded_opr = opr_block->opr;
 #if MXNET_USE_PROFILER
   if (opr_block->profiling && threaded_opr->opr_name) {
+    // let the operators waiting for the writes link back to this one
+    FlowEndpoint start = MakeFlowEndpoint(opr_block->opr_stat);
+    for (ThreadedVar* var : threaded_opr->mutable_vars) var->last_write = start;
     // record operator end timestamp
     SetOprEnd(opr_block->opr_stat);
+  } else {
+    for (ThreadedVar* var : threaded_opr->mutable_vars) var->last_write = FlowEndpoint();
   }
 #endif
   static_cast<ThreadedEngine*>(engine)->OnComplete(threaded_opr);
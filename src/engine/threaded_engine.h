@@ -28,6 +28,9 @@
 
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
+#include <array>
+#include <memory>
 #include <vector>
 #include <functional>
 #include <condition_variable>
@@ -39,6 +42,14 @@
 #include "./profiler.h"
 #include "../common/object_pool.h"
 
+/*!
+ * \brief whether ThreadedVar is guarded by a spin lock instead of a mutex,
+ *  set with USE_ENGINE_SPINLOCK at build time
+ */
+#ifndef MXNET_ENGINE_SPINLOCK
+#define MXNET_ENGINE_SPINLOCK 1
+#endif
+
 namespace mxnet {
 namespace engine {
 
@@ -74,6 +85,12 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
   bool profiling{false};
   /*! \brief operator execution statistics */
   OprExecStat *opr_stat;
+#if MXNET_USE_PROFILER
+  /*! \brief relative timestamp of the push of a profiled operator */
+  uint64_t push_rel_micros{0};
+  /*! \brief relative timestamp at which a profiled operator became ready */
+  uint64_t ready_rel_micros{0};
+#endif  // MXNET_USE_PROFILER
   // define possible debug information
   DEFINE_ENGINE_DEBUG_INFO(OprBlock);
   /*!
@@ -100,10 +117,53 @@ struct VersionedVarBlock
   OprBlock* trigger{nullptr};
   /*! \brief whether this operation is a write(mutate) operation. */
   bool write{false};
+  /*!
+   * \brief functions registered by OnVarReady while this block was the head,
+   *  called when the writes before this block complete.
+   */
+  std::vector<std::function<void()> > on_ready;
   /*! \brief define possible debug information */
   DEFINE_ENGINE_DEBUG_INFO(VersionedVarBlock);
 };  // struct VersionedVarBlock
 
+#if MXNET_ENGINE_SPINLOCK
+/*!
+ * \brief Spin lock guarding a ThreadedVar.
+ *  The critical sections on a variable only update a few counters and
+ *  pointers, so spinning is cheaper than putting the thread to sleep.
+ *  The lock yields the thread after a while, so that a holder that got
+ *  preempted can finish.
+ */
+class VarSpinLock {
+ public:
+  inline void lock() {
+    int spins = 0;
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+      // spin on the cache line without writing it
+      while (locked_.load(std::memory_order_relaxed)) {
+        if (++spins == kSpinsBeforeYield) {
+          spins = 0;
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+  inline void unlock() {
+    locked_.store(false, std::memory_order_release);
+  }
+
+ private:
+  /*! \brief number of checks of the lock before yielding the thread */
+  static constexpr int kSpinsBeforeYield = 128;
+  std::atomic<bool> locked_{false};
+};
+/*! \brief lock type of ThreadedVar */
+typedef VarSpinLock VarMutex;
+#else
+/*! \brief lock type of ThreadedVar */
+typedef std::mutex VarMutex;
+#endif  // MXNET_ENGINE_SPINLOCK
+
 /*!
  * \brief Variable implementation.
  *  Each ThreadedVar is a linked list(queue) of operations to be performed.
@@ -158,6 +218,12 @@ class ThreadedVar final : public Var,
   inline void SetToDelete();
   /*! \return whether this variable is ready to read. */
   inline bool ready_to_read();
+  /*!
+   * \brief Register a function called once the writes appended so far complete.
+   * \param callback the function.
+   * \return false when the variable is ready, then callback is not registered.
+   */
+  inline bool AppendReadyCallback(std::function<void()>* callback);
   /*!
    * \brief Cast a Var pointer to ThreadedVar pointer
    * \param ptr pointer from base.
@@ -166,6 +232,14 @@ class ThreadedVar final : public Var,
   inline static ThreadedVar* CastFromBase(Var* ptr) {
     return ptr->Cast<ThreadedVar>();
   }
+#if MXNET_USE_PROFILER
+  /*!
+   * \brief Start of the last completed write, used to link it to the operations
+   *  using the variable in the profile. Only updated by the writing operation
+   *  before it completes, so the operations waiting for it can read it.
+   */
+  FlowEndpoint last_write;
+#endif  // MXNET_USE_PROFILER
   // code for debug.
 #if ENGINE_DEBUG
   static std::atomic<std::size_t> counter;
@@ -173,10 +247,9 @@ class ThreadedVar final : public Var,
 #endif  // ENGINE_DEBUG
 
  private:
-  // TODO(hotpxl) change this to spinlock for faster runtime
   // TODO(hotpxl) consider rename head
   /*! \brief inetrnal mutex of the ThreadedVar */
-  std::mutex m_;
+  VarMutex m_;
   /*!
    * \brief number of pending reads operation in the variable.
    *  will be marked as -1 when there is a already triggered pending write.
@@ -270,8 +343,18 @@ class ThreadedEngine : public Engine {
                  FnProperty prop = FnProperty::kNormal,
                  int priority = 0,
                  const char* opr_name = nullptr) override;
+  void PushSync(SyncFn exec_fn, Context exec_ctx,
+                std::vector<VarHandle> const& const_vars,
+                std::vector<VarHandle> const& mutable_vars,
+                FnProperty prop = FnProperty::kNormal,
+                int priority = 0,
+                const char* opr_name = nullptr) override;
+  int set_bulk_size(int bulk_size) override;
+  int bulk_size() const override;
   void DeleteVariable(SyncFn delete_fn, Context exec_ctx, VarHandle var) override;
   void WaitForVar(VarHandle var) override;
+  bool IsVarReady(VarHandle var) override;
+  void OnVarReady(VarHandle var, std::function<void()> callback) override;
   void WaitForAll() override;
   void NotifyShutdown() override {
     shutdown_phase_.store(true);
@@ -312,6 +395,7 @@ class ThreadedEngine : public Engine {
   void ExecuteOprBlock(RunContext run_ctx, OprBlock *opr_block) {
     ThreadedOpr* threaded_opr = opr_block->opr;
 #if MXNET_USE_PROFILER
+    UpdateQueueDepth(opr_block->ctx, -1);
     if (opr_block->profiling && threaded_opr->opr_name) {
       const Context& ctx = opr_block->ctx;
       opr_block->opr_stat = Profiler::Get()->AddOprStat(ctx.dev_type, ctx.dev_id);
@@ -320,8 +404,18 @@ class ThreadedEngine : public Engine {
       strncpy(opr_block->opr_stat->opr_name,
         threaded_opr->opr_name,
         sizeof(opr_block->opr_stat->opr_name) - 1);
+      opr_block->opr_stat->opr_push_rel_micros = opr_block->push_rel_micros;
+      opr_block->opr_stat->opr_ready_rel_micros = opr_block->ready_rel_micros;
       // record operator start timestamp
       SetOprStart(opr_block->opr_stat);
+      // link the operator to the writes it waited for
+      FlowEndpoint start = MakeFlowEndpoint(opr_block->opr_stat);
+      for (ThreadedVar* var : threaded_opr->const_vars) {
+        Profiler::Get()->AddFlowStat(var->last_write, start);
+      }
+      for (ThreadedVar* var : threaded_opr->mutable_vars) {
+        Profiler::Get()->AddFlowStat(var->last_write, start);
+      }
     }
 #endif
     CallbackOnComplete callback = this->CreateCallback(
@@ -336,7 +430,11 @@ class ThreadedEngine : public Engine {
         if (debug_info) {
           LOG(INFO) << "ExecuteOprFn ";
         }
+        // attribute the memory allocated by the operation to it in the profile
+        MemoryScope memory_scope(threaded_opr->opr_name);
         threaded_opr->fn(run_ctx, callback);
+        // dispatch the operations merged while running the function
+        BulkFlush();
         if (debug_info) {
           LOG(INFO) << "Fin ExecuteOprFn ";
         }
@@ -361,6 +459,25 @@ class ThreadedEngine : public Engine {
   }
 
  private:
+  /*! \brief the operations pushed by a thread with PushSync and not dispatched yet */
+  struct BulkStatus {
+    /*! \brief maximum number of merged operations */
+    int bulk_size;
+    /*! \brief number of merged operations */
+    int count{0};
+    /*! \brief context of the merged operations */
+    Context ctx;
+    /*! \brief the functions of the merged operations, in push order */
+    std::shared_ptr<std::vector<SyncFn> > functions;
+    /*! \brief the variables read and written by the merged operations */
+    std::vector<VarHandle> const_vars, mutable_vars;
+    BulkStatus() : bulk_size(dmlc::GetEnv("MXNET_ENGINE_BULK_SIZE", 0)) {}
+  };
+  typedef dmlc::ThreadLocalStore<BulkStatus> BulkStatusStore;
+  /*!
+   * \brief push the operations merged by the calling thread as one operation
+   */
+  void BulkFlush();
   /*!
    * \brief check if thee is duplication in const_vars and mutable_vars.
    * \param const_vars the variables to read from.
@@ -376,6 +493,38 @@ class ThreadedEngine : public Engine {
   inline void OnComplete(ThreadedOpr* threaded_opr);
   // callback to the threaded engine
   static void OnCompleteStatic(Engine *engine, void *threaded_opr);
+  /*!
+   * \brief Hand an operation whose dependencies are satisfied to PushToExecute.
+   * \param opr_block The operator block.
+   * \param pusher_thread whether the caller is the thread that calls push
+   */
+  inline void PushReady(OprBlock* opr_block, bool pusher_thread) {
+#if MXNET_USE_PROFILER
+    if (opr_block->profiling) {
+      opr_block->ready_rel_micros = NowInUsec() - Profiler::Get()->GetInitTime();
+    }
+    UpdateQueueDepth(opr_block->ctx, 1);
+#endif
+    this->PushToExecute(opr_block, pusher_thread);
+  }
+#if MXNET_USE_PROFILER
+  /*!
+   * \brief Update the number of ready operations waiting for a worker on ctx,
+   *  and sample it in the profile.
+   */
+  inline void UpdateQueueDepth(const Context& ctx, int delta) {
+    if (ctx.dev_type > Context::kMaxDevType ||
+        ctx.dev_id < 0 || ctx.dev_id > Context::kMaxDevID) return;
+    int depth = (queue_depth_[ctx.dev_type][ctx.dev_id] += delta);
+    Profiler *profiler = Profiler::Get();
+    if (profiler->GetState() == Profiler::kRunning) {
+      profiler->AddCounterStat(ctx.dev_type, ctx.dev_id, "Ready operations", depth);
+    }
+  }
+  /*! \brief number of ready operations waiting for a worker, by device */
+  std::array<std::array<std::atomic<int>, Context::kMaxDevID + 1>,
+             Context::kMaxDevType + 1> queue_depth_{};
+#endif  // MXNET_USE_PROFILER
   /*!
    * \brief Number of pending operations.
    */
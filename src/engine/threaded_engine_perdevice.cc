@@ -26,9 +26,12 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <dmlc/concurrency.h>
+#include "./openmp.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
+#include "./work_stealing_queue.h"
 #include "../common/lazy_alloc_array.h"
+#include "../common/numa.h"
 #include "../common/utils.h"
 
 namespace mxnet {
@@ -38,8 +41,11 @@ namespace engine {
  * The policy of this Engine:
  *  - Execute Async operation immediately if pushed from Pusher.
  *  - Use fixed amount of threads for each device.
- *  - Use special threads for copy operations.
+ *  - Use special threads for copy operations, apart for each direction
+ *    so that copies to and from a GPU overlap on its two copy engines.
  *  - Each stream is allocated and bound to each of the thread.
+ *  - Realtime and background operations, according to their priority,
+ *    have their own threads, and streams on GPU.
  */
 class ThreadedEnginePerDevice : public ThreadedEngine {
  public:
@@ -51,7 +57,12 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
 
   ThreadedEnginePerDevice() noexcept(false) {
     gpu_worker_nthreads_ = common::GetNumThreadPerGPU();
+    gpu_copy_nthreads_ = dmlc::GetEnv("MXNET_GPU_COPY_NTHREADS", 1);
     cpu_worker_nthreads_ = dmlc::GetEnv("MXNET_CPU_WORKER_NTHREADS", 1);
+    cpu_work_stealing_ = dmlc::GetEnv("MXNET_CPU_WORK_STEALING", false);
+    gpu_realtime_nthreads_ = dmlc::GetEnv("MXNET_GPU_REALTIME_NTHREADS", 1);
+    gpu_background_nthreads_ = dmlc::GetEnv("MXNET_GPU_BACKGROUND_NTHREADS", 1);
+    OpenMP::Get()->set_cpu_worker_nthreads(cpu_worker_nthreads_);
     // create CPU task
     int cpu_priority_nthreads = dmlc::GetEnv("MXNET_CPU_PRIORITY_NTHREADS", 4);
     cpu_priority_worker_.reset(new ThreadWorkerBlock<kPriorityQueue>());
@@ -59,14 +70,25 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         cpu_priority_nthreads, [this]() {
           this->CPUWorker(Context(), cpu_priority_worker_.get());
         }));
+    int cpu_background_nthreads = dmlc::GetEnv("MXNET_CPU_BACKGROUND_NTHREADS", 1);
+    cpu_background_worker_.reset(new ThreadWorkerBlock<kPriorityQueue>());
+    cpu_background_worker_->pool.reset(new ThreadPool(
+        cpu_background_nthreads, [this]() {
+          this->CPUWorker(Context(), cpu_background_worker_.get());
+        }));
     // GPU tasks will be created lazily
   }
   ~ThreadedEnginePerDevice() noexcept(false) {
     SignalQueuesForKill();
     gpu_normal_workers_.Clear();
-    gpu_copy_workers_.Clear();
+    gpu_realtime_workers_.Clear();
+    gpu_background_workers_.Clear();
+    gpu_copy_to_workers_.Clear();
+    gpu_copy_from_workers_.Clear();
     cpu_normal_workers_.Clear();
+    cpu_stealing_workers_.Clear();
     cpu_priority_worker_.reset(nullptr);
+    cpu_background_worker_.reset(nullptr);
   }
 
  protected:
@@ -81,8 +103,27 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
       this->ExecuteOprBlock(RunContext{ctx, nullptr}, opr_block);
     } else {
       if (ctx.dev_mask() == cpu::kDevMask) {
-        if (opr_block->opr->prop == FnProperty::kCPUPrioritized) {
+        if (opr_block->opr->prop == FnProperty::kCPUPrioritized ||
+            opr_block->priority >= kRealtimePriority) {
           cpu_priority_worker_->task_queue.Push(opr_block, opr_block->priority);
+        } else if (opr_block->priority < kBackgroundPriority) {
+          cpu_background_worker_->task_queue.Push(opr_block, opr_block->priority);
+        } else if (cpu_work_stealing_) {
+          int dev_id = ctx.dev_id;
+          int nthread = cpu_worker_nthreads_;
+          auto ptr =
+          cpu_stealing_workers_.Get(dev_id, [this, ctx, nthread]() {
+              auto blk = new WorkStealingWorkerBlock(nthread);
+              blk->pool.reset(new ThreadPool(nthread, [this, ctx, blk] () {
+                    blk->task_queue.RegisterWorker();
+                    common::BindThreadToNUMANode(common::GetNUMANodeOfCPUContext(ctx.dev_id));
+                    this->CPUWorker(ctx, blk);
+                  }));
+              return blk;
+            });
+          if (ptr) {
+            ptr->task_queue.Push(opr_block, opr_block->priority);
+          }
         } else {
           int dev_id = ctx.dev_id;
           int nthread = cpu_worker_nthreads_;
@@ -90,6 +131,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
           cpu_normal_workers_.Get(dev_id, [this, ctx, nthread]() {
               auto blk = new ThreadWorkerBlock<kWorkerQueue>();
               blk->pool.reset(new ThreadPool(nthread, [this, ctx, blk] () {
+                    common::BindThreadToNUMANode(common::GetNUMANodeOfCPUContext(ctx.dev_id));
                     this->CPUWorker(ctx, blk);
                   }));
               return blk;
@@ -105,21 +147,14 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         bool is_copy = (prop == FnProperty::kCopyFromGPU ||
                         prop == FnProperty::kCopyToGPU);
         int nthread = gpu_worker_nthreads_;
-        if (is_copy) {
-          auto ptr =
-          gpu_copy_workers_.Get(ctx.dev_id, [this, ctx, is_copy, nthread]() {
-              auto blk = new ThreadWorkerBlock<kCopyQueue>();
-              blk->pool.reset(new ThreadPool(
-                nthread,
-                [this, ctx, is_copy, blk]
-                  (std::shared_ptr<ThreadPool::SimpleEvent> ready_event) {
-                    this->GPUWorker(ctx, is_copy, blk, ready_event);
-                  }, true));
-              return blk;
-            });
-          if (ptr) {
-            ptr->task_queue.Push(opr_block, opr_block->priority);
-          }
+        if (prop == FnProperty::kCopyToGPU) {
+          PushToGPULane(&gpu_copy_to_workers_, gpu_copy_nthreads_, ctx, opr_block, true);
+        } else if (prop == FnProperty::kCopyFromGPU) {
+          PushToGPULane(&gpu_copy_from_workers_, gpu_copy_nthreads_, ctx, opr_block, true);
+        } else if (opr_block->priority >= kRealtimePriority) {
+          PushToGPULane(&gpu_realtime_workers_, gpu_realtime_nthreads_, ctx, opr_block);
+        } else if (opr_block->priority < kBackgroundPriority) {
+          PushToGPULane(&gpu_background_workers_, gpu_background_nthreads_, ctx, opr_block);
         } else {
           auto ptr = gpu_normal_workers_.Get(ctx.dev_id, [this, ctx, is_copy, nthread]() {
               auto blk = new ThreadWorkerBlock<kWorkerQueue>();
@@ -140,6 +175,23 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   }
 
  private:
+  template<typename Block>
+  void PushToGPULane(common::LazyAllocArray<Block> *lane, int nthread,
+                     const Context& ctx, OprBlock *opr_block, bool is_copy = false) {
+    auto ptr = lane->Get(ctx.dev_id, [this, ctx, nthread, is_copy]() {
+        auto blk = new Block();
+        blk->pool.reset(new ThreadPool(
+          nthread,
+          [this, ctx, blk, is_copy]
+            (std::shared_ptr<ThreadPool::SimpleEvent> ready_event) {
+              this->GPUWorker(ctx, is_copy, blk, ready_event);
+            }, true));
+        return blk;
+      });
+    if (ptr) {
+      ptr->task_queue.Push(opr_block, opr_block->priority);
+    }
+  }
   // working unit for each of the task.
   template<dmlc::ConcurrentQueueType type>
   struct ThreadWorkerBlock {
@@ -152,19 +204,48 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // destructor
     ~ThreadWorkerBlock() noexcept(false) {}
   };
+  // working unit whose threads steal tasks from each other
+  struct WorkStealingWorkerBlock {
+    // task queue on this task
+    WorkStealingQueue<OprBlock*> task_queue;
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+    // constructor
+    explicit WorkStealingWorkerBlock(size_t nthread) : task_queue(nthread) {}
+    // destructor
+    ~WorkStealingWorkerBlock() noexcept(false) {}
+  };
 
   /*! \brief number of concurrent thread cpu worker uses */
   int cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
   int gpu_worker_nthreads_;
+  /*! \brief number of threads copying in each direction on each gpu */
+  int gpu_copy_nthreads_;
+  /*! \brief number of threads of the realtime lane of each gpu */
+  int gpu_realtime_nthreads_;
+  /*! \brief number of threads of the background lane of each gpu */
+  int gpu_background_nthreads_;
+  /*! \brief whether cpu workers steal tasks from each other */
+  bool cpu_work_stealing_;
   // cpu worker
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > cpu_normal_workers_;
+  // cpu worker with work stealing
+  common::LazyAllocArray<WorkStealingWorkerBlock> cpu_stealing_workers_;
   // cpu priority worker
   std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_priority_worker_;
+  // cpu worker of the background operations
+  std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_background_worker_;
   // workers doing normal works on GPU
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > gpu_normal_workers_;
-  // workers doing copy works from/to GPU
-  common::LazyAllocArray<ThreadWorkerBlock<kCopyQueue> > gpu_copy_workers_;
+  // workers of the realtime operations on GPU, with streams of their own
+  common::LazyAllocArray<ThreadWorkerBlock<kPriorityQueue> > gpu_realtime_workers_;
+  // workers of the background operations on GPU
+  common::LazyAllocArray<ThreadWorkerBlock<kPriorityQueue> > gpu_background_workers_;
+  // workers doing copy works to GPU
+  common::LazyAllocArray<ThreadWorkerBlock<kCopyQueue> > gpu_copy_to_workers_;
+  // workers doing copy works from GPU
+  common::LazyAllocArray<ThreadWorkerBlock<kCopyQueue> > gpu_copy_from_workers_;
   /*!
    * \brief GPU worker that performs operations on a certain device.
    * \param dev_id The device id of the worker.
@@ -188,6 +269,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         stream = mshadow::NewStream<gpu>(true, MXNET_USE_CUDNN != 0, ctx.dev_id);
       }
     } while (false);
+    OpenMP::Get()->on_start_worker_thread(false);
     // execute task
     OprBlock* opr_block;
     RunContext run_ctx{ctx, stream};
@@ -205,11 +287,12 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
    * \brief CPU worker that performs operations on CPU.
    * \param block The task block of the worker.
    */
-  template<dmlc::ConcurrentQueueType type>
+  template<typename Block>
   inline void CPUWorker(Context ctx,
-                        ThreadWorkerBlock<type> *block) {
+                        Block *block) {
     auto* task_queue = &(block->task_queue);
     RunContext run_ctx{ctx, nullptr};
+    OpenMP::Get()->on_start_worker_thread(true);
     // execute task
     OprBlock* opr_block;
     while (task_queue->Pop(&opr_block)) {
@@ -228,11 +311,18 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   /*! Signal all queues for shutdown */
   void SignalQueuesForKill() {
     SignalQueueForKill(&gpu_normal_workers_);
-    SignalQueueForKill(&gpu_copy_workers_);
+    SignalQueueForKill(&gpu_realtime_workers_);
+    SignalQueueForKill(&gpu_background_workers_);
+    SignalQueueForKill(&gpu_copy_to_workers_);
+    SignalQueueForKill(&gpu_copy_from_workers_);
     SignalQueueForKill(&cpu_normal_workers_);
+    SignalQueueForKill(&cpu_stealing_workers_);
     if (cpu_priority_worker_) {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
+    if (cpu_background_worker_) {
+      cpu_background_worker_->task_queue.SignalForKill();
+    }
   }
 };
 
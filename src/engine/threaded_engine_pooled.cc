@@ -26,6 +26,7 @@
 #include <dmlc/logging.h>
 #include <dmlc/concurrency.h>
 #include <cassert>
+#include "./openmp.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
 #include "./stream_manager.h"
@@ -37,18 +38,22 @@ namespace engine {
  * The policy of this Engine:
  *  - Execute Async operation immediately if pushed from Pusher.
  *  - Use a common thread pool for normal operations on all devices.
- *  - Use special thread pool for copy operations.
+ *  - Use special thread pools for copy operations, one per direction.
  */
 class ThreadedEnginePooled : public ThreadedEngine {
  public:
   ThreadedEnginePooled() :
       thread_pool_(kNumWorkingThreads, [this]() { ThreadWorker(&task_queue_); }),
-      io_thread_pool_(1, [this]() { ThreadWorker(&io_task_queue_); }) {}
+      io_to_gpu_thread_pool_(1, [this]() { ThreadWorker(&io_to_gpu_task_queue_); }),
+      io_from_gpu_thread_pool_(1, [this]() { ThreadWorker(&io_from_gpu_task_queue_); }) {
+    OpenMP::Get()->set_cpu_worker_nthreads(kNumWorkingThreads);
+  }
 
   ~ThreadedEnginePooled() noexcept(false) {
     streams_.Finalize();
     task_queue_.SignalForKill();
-    io_task_queue_.SignalForKill();
+    io_to_gpu_task_queue_.SignalForKill();
+    io_from_gpu_task_queue_.SignalForKill();
   }
 
  protected:
@@ -75,12 +80,14 @@ class ThreadedEnginePooled : public ThreadedEngine {
    * \brief Task queues.
    */
   dmlc::ConcurrentBlockingQueue<OprBlock*> task_queue_;
-  dmlc::ConcurrentBlockingQueue<OprBlock*> io_task_queue_;
+  dmlc::ConcurrentBlockingQueue<OprBlock*> io_to_gpu_task_queue_;
+  dmlc::ConcurrentBlockingQueue<OprBlock*> io_from_gpu_task_queue_;
   /*!
    * \brief Thread pools.
    */
   ThreadPool thread_pool_;
-  ThreadPool io_thread_pool_;
+  ThreadPool io_to_gpu_thread_pool_;
+  ThreadPool io_from_gpu_thread_pool_;
   /*!
    * \brief Worker.
    * \param task_queue Queue to work on.
@@ -89,6 +96,7 @@ class ThreadedEnginePooled : public ThreadedEngine {
    */
   void ThreadWorker(dmlc::ConcurrentBlockingQueue<OprBlock*>* task_queue) {
     OprBlock* opr_block;
+    OpenMP::Get()->on_start_worker_thread(true);
     while (task_queue->Pop(&opr_block)) {
       DoExecute(opr_block);
     }
@@ -106,10 +114,10 @@ class ThreadedEnginePooled : public ThreadedEngine {
       LOG(FATAL) << "Please compile with CUDA enabled";
       #endif  // MXNET_USE_CUDA
     }
-    bool is_copy = (opr_block->opr->prop == FnProperty::kCopyFromGPU ||
-                    opr_block->opr->prop == FnProperty::kCopyToGPU);
+    const FnProperty prop = opr_block->opr->prop;
+    bool is_copy = (prop == FnProperty::kCopyFromGPU || prop == FnProperty::kCopyToGPU);
     auto&& rctx = is_copy
-        ? streams_.GetIORunContext(opr_block->ctx)
+        ? streams_.GetIORunContext(opr_block->ctx, prop == FnProperty::kCopyToGPU)
         : streams_.GetRunContext(opr_block->ctx);
     this->ExecuteOprBlock(rctx, opr_block);
   }
@@ -119,9 +127,12 @@ class ThreadedEnginePooled : public ThreadedEngine {
    */
   void DoPushToQueue(OprBlock* opr_block) {
     switch (opr_block->opr->prop) {
-      case FnProperty::kCopyFromGPU:
+      case FnProperty::kCopyFromGPU: {
+        io_from_gpu_task_queue_.Push(opr_block);
+        break;
+      }
       case FnProperty::kCopyToGPU: {
-        io_task_queue_.Push(opr_block);
+        io_to_gpu_task_queue_.Push(opr_block);
         break;
       }
       default: {
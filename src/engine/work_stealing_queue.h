@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file work_stealing_queue.h
+ * \brief Task queue with one deque per worker thread and work stealing.
+ */
+#ifndef MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+#define MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "mxnet/base.h"
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Blocking task queue shared by a fixed set of worker threads.
+ *
+ *  Every worker owns a deque. Tasks pushed by a worker go to the back of its
+ *  own deque and are popped from there again, so a task made ready by the
+ *  completion of another one usually runs on the same thread. Tasks pushed
+ *  from other threads are spread round-robin over the deques. A worker whose
+ *  deque is empty steals from the front of the deques of the other workers.
+ *  Each deque has its own lock, so workers do not contend on a single queue.
+ *
+ *  It offers the same Push, Pop and SignalForKill interface as
+ *  dmlc::ConcurrentBlockingQueue. The priority of a task is ignored.
+ * \tparam T type of the tasks.
+ */
+template<typename T>
+class WorkStealingQueue {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param num_workers Number of worker threads popping from the queue.
+   */
+  explicit WorkStealingQueue(size_t num_workers)
+      : deques_(num_workers) {
+    CHECK_GT(num_workers, 0U);
+    for (auto& deque : deques_) deque.reset(new Deque());
+  }
+  /*!
+   * \brief Register the calling thread as a worker of the queue.
+   *  Must be called once by every worker thread before it pops.
+   */
+  void RegisterWorker() {
+    size_t index = next_worker_++;
+    CHECK_LT(index, deques_.size()) << "Too many workers for the queue";
+    WorkerInfo* info = ThisWorker();
+    info->queue = this;
+    info->index = index;
+  }
+  /*!
+   * \brief Push a task.
+   * \param e The task.
+   * \param priority Ignored.
+   */
+  void Push(T const& e, int priority = 0) {
+    WorkerInfo* info = ThisWorker();
+    size_t index;
+    if (info->queue == this) {
+      index = info->index;
+    } else {
+      index = next_push_++ % deques_.size();
+    }
+    {
+      Deque* deque = deques_[index].get();
+      std::lock_guard<std::mutex> lock(deque->mutex);
+      deque->tasks.push_back(e);
+      ++num_pending_;
+    }
+    if (num_sleeping_.load() != 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      sleep_cond_.notify_one();
+    }
+  }
+  /*!
+   * \brief Pop a task, blocking until one is available.
+   *  Must be called from a registered worker.
+   * \param rv The popped task.
+   * \return false if the queue has been signalled for kill.
+   */
+  bool Pop(T* rv) {
+    WorkerInfo* info = ThisWorker();
+    CHECK(info->queue == this) << "Pop must be called from a registered worker";
+    while (true) {
+      if (exit_now_.load()) return false;
+      if (TryPop(info->index, rv)) return true;
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      ++num_sleeping_;
+      sleep_cond_.wait(lock, [this] {
+          return num_pending_.load() != 0 || exit_now_.load();
+        });
+      --num_sleeping_;
+    }
+  }
+  /*!
+   * \brief Wake up all workers and make them return from Pop.
+   */
+  void SignalForKill() {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    exit_now_.store(true);
+    sleep_cond_.notify_all();
+  }
+
+ private:
+  /*! \brief tasks owned by one worker */
+  struct Deque {
+    std::mutex mutex;
+    std::deque<T> tasks;
+  };
+  /*! \brief queue and index of the calling worker thread */
+  struct WorkerInfo {
+    const WorkStealingQueue* queue;
+    size_t index;
+  };
+  static WorkerInfo* ThisWorker() {
+#if DMLC_CXX11_THREAD_LOCAL
+    static thread_local WorkerInfo info = {nullptr, 0};
+#else
+    static MX_THREAD_LOCAL WorkerInfo info = {nullptr, 0};
+#endif
+    return &info;
+  }
+  /*! \brief pop from the own deque, or steal from the others */
+  bool TryPop(size_t index, T* rv) {
+    {
+      Deque* deque = deques_[index].get();
+      std::lock_guard<std::mutex> lock(deque->mutex);
+      if (!deque->tasks.empty()) {
+        *rv = deque->tasks.back();
+        deque->tasks.pop_back();
+        --num_pending_;
+        return true;
+      }
+    }
+    for (size_t i = 1; i < deques_.size(); ++i) {
+      Deque* deque = deques_[(index + i) % deques_.size()].get();
+      std::lock_guard<std::mutex> lock(deque->mutex);
+      if (!deque->tasks.empty()) {
+        *rv = deque->tasks.front();
+        deque->tasks.pop_front();
+        --num_pending_;
+        return true;
+      }
+    }
+    return false;
+  }
+  /*! \brief one deque per worker */
+  std::vector<std::unique_ptr<Deque> > deques_;
+  /*! \brief number of registered workers */
+  std::atomic<size_t> next_worker_{0};
+  /*! \brief round-robin counter for tasks pushed by non-workers */
+  std::atomic<size_t> next_push_{0};
+  /*! \brief number of tasks in all deques */
+  std::atomic<size_t> num_pending_{0};
+  /*! \brief number of workers waiting for tasks */
+  std::atomic<int> num_sleeping_{0};
+  /*! \brief whether the queue has been signalled for kill */
+  std::atomic<bool> exit_now_{false};
+  /*! \brief mutex and condition for sleeping workers */
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cond_;
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+}  // namespace engine
+}  // namespace mxnet
+
+#endif  // MXNET_ENGINE_WORK_STEALING_QUEUE_H_
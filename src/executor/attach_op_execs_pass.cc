@@ -46,8 +46,9 @@ namespace exec {
 // FComputeExecutor and FStatefulComputeExecutor inherit from this class
 class StorageFallbackOpExecutor : public OpExecutor {
  public:
-  explicit StorageFallbackOpExecutor(const std::vector<uint32_t> &mutate_idx)
-      : mutate_idx_(mutate_idx) {}
+  explicit StorageFallbackOpExecutor(const std::vector<uint32_t> &mutate_idx,
+                                     const std::string &opr_name)
+      : mutate_idx_(mutate_idx), opr_name_(opr_name) {}
 
   void Setup() override {
     init_ = false;
@@ -81,12 +82,12 @@ class StorageFallbackOpExecutor : public OpExecutor {
     InitBlobs();
     if (is_gpu) {
 #if MXNET_USE_CUDA
-      CastNonDefaultStorage<gpu>(pre_temp_src_, pre_temp_dst_, op_ctx);
+      CastNonDefaultStorage<gpu>(pre_temp_src_, pre_temp_dst_, op_ctx, false, opr_name_);
 #else
       LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
     } else {
-      CastNonDefaultStorage<cpu>(pre_temp_src_, pre_temp_dst_, op_ctx);
+      CastNonDefaultStorage<cpu>(pre_temp_src_, pre_temp_dst_, op_ctx, false, opr_name_);
     }
   }
 
@@ -95,12 +96,12 @@ class StorageFallbackOpExecutor : public OpExecutor {
     using namespace common;
     if (is_gpu) {
 #if MXNET_USE_CUDA
-      CastNonDefaultStorage<gpu>(post_temp_src_, post_temp_dst_, op_ctx);
+      CastNonDefaultStorage<gpu>(post_temp_src_, post_temp_dst_, op_ctx, false, opr_name_);
 #else
       LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
     } else {
-      CastNonDefaultStorage<cpu>(post_temp_src_, post_temp_dst_, op_ctx);
+      CastNonDefaultStorage<cpu>(post_temp_src_, post_temp_dst_, op_ctx, false, opr_name_);
     }
   }
 
@@ -114,6 +115,8 @@ class StorageFallbackOpExecutor : public OpExecutor {
   std::unordered_map<uint32_t, uint32_t> in_temp_idx_map_;
   // indices of mutatable inputs
   std::vector<uint32_t> mutate_idx_;
+  // name of the operator, for the storage fallback log
+  std::string opr_name_;
   // whether blobs are initialized
   bool init_;
 };
@@ -144,8 +147,9 @@ class StatefulComputeExecutor : public StorageFallbackOpExecutor {
   explicit StatefulComputeExecutor(const OpStatePtr& state,
                                    const FStatefulCompute& fcompute,
                                    ExecType exec_type,
-                                   const std::vector<uint32_t> &mutate_idx)
-      : StorageFallbackOpExecutor(mutate_idx),
+                                   const std::vector<uint32_t> &mutate_idx,
+                                   const std::string &opr_name)
+      : StorageFallbackOpExecutor(mutate_idx, opr_name),
         state_(state), fcompute_(fcompute), exec_type_(exec_type) {}
 
  private:
@@ -208,7 +212,7 @@ class FComputeExecutor : public StorageFallbackOpExecutor {
 
   explicit FComputeExecutor(const NodeAttrs& attrs, FCompute fcompute,
                             ExecType exec_type, const std::vector<uint32_t> &mutate_idx)
-      : StorageFallbackOpExecutor(mutate_idx),
+      : StorageFallbackOpExecutor(mutate_idx, attrs.op->name),
         attrs_(attrs), fcompute_(fcompute), exec_type_(exec_type) {
   }
 
@@ -299,7 +303,7 @@ Graph AttachOpExecs(Graph g) {
           op, "FStatefulCompute", vctx[i]);
       if (fcompute != nullptr) {
         ret[i] = std::make_shared<StatefulComputeExecutor>(state, fcompute,
-                                                           exec_type, mutate_index);
+                                                           exec_type, mutate_index, op->name);
       } else {
         FStatefulComputeEx fcompute_ex = common::GetFCompute<FStatefulComputeEx>(
             op, "FStatefulComputeEx", vctx[i]);
@@ -318,7 +322,7 @@ Graph AttachOpExecs(Graph g) {
       if (fcompute != nullptr) {
         ret[i] = std::make_shared<StatefulComputeExecutor>(
             dynamic_cast<StatefulComputeExecutor*>(ret[fwd_id].get())->state_,
-            fcompute, exec_type, mutate_index);
+            fcompute, exec_type, mutate_index, op->name);
       } else {
         FStatefulComputeEx fcompute_ex = common::GetFCompute<FStatefulComputeEx>(
             op, "FStatefulComputeEx", vctx[i]);
@@ -24,7 +24,9 @@
  */
 #include <mxnet/resource.h>
 #include <mxnet/op_attr_types.h>
+#include <algorithm>
 #include "./exec_pass.h"
+#include "../common/utils.h"
 
 namespace mxnet {
 namespace exec {
@@ -35,8 +37,14 @@ Graph AttachOpResources(Graph g) {
   auto& op_execs = nnvm::get<OpExecVector>(*g.attrs.at("op_execs"));
   const auto& vctx = g.GetAttr<ContextVector>("context");
   const auto& idx = g.indexed_graph();
+  const nnvm::ShapeVector* vshape = g.attrs.count("shape") ?
+      &g.GetAttr<nnvm::ShapeVector>("shape") : nullptr;
+  const nnvm::DTypeVector* vdtype = g.attrs.count("dtype") ?
+      &g.GetAttr<nnvm::DTypeVector>("dtype") : nullptr;
   // Use global resource pool for each executor for now.
   std::map<Context, Resource> cached_temp;
+  // the largest temp space declared by the operators of each context
+  std::map<Context, size_t> temp_size;
   // Resource allocation
   for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
     const auto& inode = idx[nid];
@@ -56,13 +64,40 @@ Graph AttachOpResources(Graph g) {
           requested.push_back(r);
           cached_temp[ctx] = r;
         }
-      } else if (req.type == ResourceRequest::kRandom) {
+        auto fsize = common::GetFCompute<FTempSpaceSize>(inode.source->op(),
+                                                         "FTempSpaceSize", ctx);
+        if (fsize != nullptr && vshape != nullptr && vdtype != nullptr) {
+          std::vector<TShape> in_shape;
+          std::vector<int> in_type;
+          bool known = true;
+          for (const auto& e : inode.inputs) {
+            in_shape.push_back((*vshape)[idx.entry_id(e)]);
+            in_type.push_back((*vdtype)[idx.entry_id(e)]);
+            known = known && in_shape.back().ndim() != 0 && in_type.back() != -1;
+          }
+          if (known) {
+            temp_size[ctx] = std::max(temp_size[ctx],
+                                      fsize(inode.source->attrs, in_shape, in_type));
+          }
+        }
+      } else if (req.type == ResourceRequest::kRandom ||
+                 req.type == ResourceRequest::kParallelRandom) {
         requested.push_back(ResourceManager::Get()->Request(ctx, req));
       } else {
         LOG(FATAL) << "resource type not yet supported";
       }
     }
   }
+  // allocate the temp spaces once, before the operators run
+  for (const auto& kv : temp_size) {
+    const Resource r = cached_temp.at(kv.first);
+    const size_t size = kv.second;
+    if (r.var == nullptr || size == 0) continue;
+    Engine::Get()->PushSync([r, size](RunContext rctx) {
+        r.get_space_internal(size);
+      }, kv.first, {}, {r.var}, FnProperty::kNormal, 0,
+      PROFILER_MESSAGE("ReserveTempSpace"));
+  }
   return g;
 }
 }  // namespace exec
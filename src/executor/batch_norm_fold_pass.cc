@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batch_norm_fold_pass.cc
+ * \brief Fold BatchNorm into the preceding Convolution or FullyConnected.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+/*! \brief value of an attribute, or the default when it is not set */
+inline std::string GetDictAttr(const nnvm::NodeAttrs& attrs, const std::string& key,
+                               const std::string& default_value) {
+  auto it = attrs.dict.find(key);
+  return it == attrs.dict.end() ? default_value : it->second;
+}
+
+/*!
+ * \brief whether the output channels of a layer are the first axis of its
+ *  weight and the second axis of its output
+ */
+bool IsFoldableLayer(const nnvm::Node& node) {
+  static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  if (node.op() == conv_op) {
+    const std::string layout = GetDictAttr(node.attrs, "layout", "None");
+    return layout == "None" || layout == "NCW" || layout == "NCHW" || layout == "NCDHW";
+  }
+  if (node.op() == fc_op) {
+    const std::string flatten = GetDictAttr(node.attrs, "flatten", "True");
+    return flatten == "True" || flatten == "true" || flatten == "1";
+  }
+  return false;
+}
+}  // namespace
+
+Graph FoldBatchNorm(Graph g) {
+  using nnvm::NodePtr;
+  using nnvm::NodeEntry;
+  static const nnvm::Op* bn_op = nnvm::Op::Get("BatchNorm");
+  static const nnvm::Op* fold_op = nnvm::Op::Get("_FoldBatchNorm");
+  const auto& idx = g.indexed_graph();
+  const uint32_t num_nodes = idx.num_nodes();
+  // number of uses of every entry
+  std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+  std::vector<bool> control_target(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (const auto& e : idx[nid].inputs) ++ref_count[idx.entry_id(e)];
+    for (uint32_t dep : idx[nid].control_deps) control_target[dep] = true;
+  }
+  for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+
+  // a BatchNorm is folded when its data is the only use of the output of a
+  // Convolution or FullyConnected, and only its normalized output is used
+  std::vector<bool> folded(num_nodes, false);
+  bool any_fold = false;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->op() != bn_op || inode.control_deps.size() != 0U ||
+        control_target[nid] || GetDictAttr(inode.source->attrs, "axis", "1") != "1") {
+      continue;
+    }
+    bool stats_used = false;
+    for (uint32_t i = 1; i < inode.source->num_outputs(); ++i) {
+      stats_used = stats_used || ref_count[idx.entry_id(nid, i)] != 0;
+    }
+    const auto& data = inode.inputs[0];
+    const auto& layer = idx[data.node_id];
+    if (stats_used || ref_count[idx.entry_id(data)] != 1 ||
+        layer.source->is_variable() || !IsFoldableLayer(*layer.source) ||
+        layer.control_deps.size() != 0U || control_target[data.node_id]) {
+      continue;
+    }
+    folded[nid] = true;
+    any_fold = true;
+  }
+  if (!any_fold) return g;
+
+  // copy the operator nodes, so that the nodes of the symbol are left intact.
+  // The variables are kept, as the executor identifies them by address.
+  std::vector<NodePtr> new_nodes(num_nodes);
+  auto map_entry = [&](const NodeEntry& e) {
+    return NodeEntry{new_nodes[idx.node_id(e.node.get())], e.index, e.version};
+  };
+  nnvm::DFSVisit(g.outputs, [&](const NodePtr& node) {
+    const uint32_t nid = idx.node_id(node.get());
+    if (node->is_variable()) {
+      new_nodes[nid] = node;
+      return;
+    }
+    if (!folded[nid]) {
+      NodePtr n = nnvm::Node::Create();
+      n->attrs = node->attrs;
+      for (const auto& e : node->inputs) n->inputs.push_back(map_entry(e));
+      for (const auto& dep : node->control_deps) {
+        n->control_deps.push_back(new_nodes[idx.node_id(dep.get())]);
+      }
+      new_nodes[nid] = n;
+      return;
+    }
+    // BatchNorm(layer(data, weight, bias), gamma, beta, mean, var) becomes
+    // layer(data, fold(weight, bias, gamma, beta, mean, var)). The inputs of
+    // fold keep the order of the variables in the depth first search.
+    const nnvm::Node* layer = node->inputs[0].node.get();
+    const bool no_bias = layer->inputs.size() == 2U;
+    NodePtr fold = nnvm::Node::Create();
+    fold->attrs.op = fold_op;
+    fold->attrs.name = node->attrs.name + "_fold";
+    fold->attrs.dict["eps"] = GetDictAttr(node->attrs, "eps", "0.001");
+    fold->attrs.dict["fix_gamma"] = GetDictAttr(node->attrs, "fix_gamma", "True");
+    fold->attrs.dict["no_bias"] = no_bias ? "True" : "False";
+    fold_op->attr_parser(&(fold->attrs));
+    for (size_t i = 1; i < layer->inputs.size(); ++i) {
+      fold->inputs.push_back(map_entry(layer->inputs[i]));
+    }
+    for (size_t i = 1; i < node->inputs.size(); ++i) {
+      fold->inputs.push_back(map_entry(node->inputs[i]));
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = layer->attrs;
+    n->attrs.dict["no_bias"] = "False";
+    n->attrs.op->attr_parser(&(n->attrs));
+    n->inputs.push_back(map_entry(layer->inputs[0]));
+    n->inputs.push_back(NodeEntry{fold, 0, 0});
+    n->inputs.push_back(NodeEntry{fold, 1, 0});
+    new_nodes[nid] = n;
+  });
+  Graph ret;
+  for (const auto& e : g.outputs) ret.outputs.push_back(map_entry(e));
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
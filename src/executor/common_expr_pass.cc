@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file common_expr_pass.cc
+ * \brief Merge the operator nodes computing the same expression.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+/*! \brief whether the node gives the same outputs for the same inputs */
+bool IsPure(const nnvm::Node& node) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  if (node.control_deps.size() != 0U || node.op()->name == "Dropout") return false;
+  if (fmutate.count(node.op()) && !fmutate[node.op()](node.attrs).empty()) return false;
+  if (fresource.count(node.op())) {
+    for (const auto& req : fresource[node.op()](node.attrs)) {
+      if (req.type == ResourceRequest::kRandom ||
+          req.type == ResourceRequest::kParallelRandom) return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+Graph EliminateCommonExpr(Graph g) {
+  using nnvm::NodePtr;
+  using nnvm::NodeEntry;
+  // operator, sorted attributes and inputs of a node
+  using ExprKey = std::tuple<const nnvm::Op*,
+                             std::vector<std::pair<std::string, std::string> >,
+                             std::vector<std::tuple<const nnvm::Node*, uint32_t, uint32_t> > >;
+  const auto& idx = g.indexed_graph();
+  std::vector<NodePtr> new_nodes(idx.num_nodes());
+  std::map<ExprKey, NodePtr> exprs;
+  bool any_merge = false;
+  auto map_entry = [&](const NodeEntry& e) {
+    return NodeEntry{new_nodes[idx.node_id(e.node.get())], e.index, e.version};
+  };
+  // copy the operator nodes, so that the nodes of the symbol are left intact.
+  // The variables are kept, as the executor identifies them by address.
+  nnvm::DFSVisit(g.outputs, [&](const NodePtr& node) {
+    const uint32_t nid = idx.node_id(node.get());
+    if (node->is_variable()) {
+      new_nodes[nid] = node;
+      return;
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = node->attrs;
+    for (const auto& e : node->inputs) n->inputs.push_back(map_entry(e));
+    for (const auto& dep : node->control_deps) {
+      n->control_deps.push_back(new_nodes[idx.node_id(dep.get())]);
+    }
+    new_nodes[nid] = n;
+    if (!IsPure(*node)) return;
+    ExprKey key;
+    std::get<0>(key) = node->op();
+    std::get<1>(key).assign(node->attrs.dict.begin(), node->attrs.dict.end());
+    std::sort(std::get<1>(key).begin(), std::get<1>(key).end());
+    for (const auto& e : n->inputs) {
+      std::get<2>(key).emplace_back(e.node.get(), e.index, e.version);
+    }
+    auto it = exprs.find(key);
+    if (it == exprs.end()) {
+      exprs.emplace(std::move(key), n);
+    } else {
+      // the first node computing the expression is used instead
+      new_nodes[nid] = it->second;
+      any_merge = true;
+    }
+  });
+  if (!any_merge) return g;
+  Graph ret;
+  for (const auto& e : g.outputs) ret.outputs.push_back(map_entry(e));
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
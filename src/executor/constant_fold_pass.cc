@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file constant_fold_pass.cc
+ * \brief Find the operators of an inference graph computed from the parameters only.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+std::vector<bool> FindConstantNodes(const Graph& g,
+                                    const std::unordered_set<std::string>& param_names) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  const auto& idx = g.indexed_graph();
+  const auto& mutable_nodes = idx.mutable_input_nodes();
+  std::vector<bool> constant(idx.num_nodes(), false);
+  // whether the node is a parameter, or an operator computed from them
+  std::vector<bool> from_params(idx.num_nodes(), false);
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    const nnvm::Node* node = inode.source;
+    if (node->is_variable()) {
+      from_params[nid] = param_names.count(node->attrs.name) != 0 &&
+          mutable_nodes.count(nid) == 0;
+      continue;
+    }
+    if (inode.control_deps.size() != 0U || node->op()->name == "Dropout" ||
+        (fmutate.count(node->op()) && !fmutate[node->op()](node->attrs).empty())) {
+      continue;
+    }
+    // operators using random numbers give another result every run
+    bool random = false;
+    if (fresource.count(node->op())) {
+      for (const auto& req : fresource[node->op()](node->attrs)) {
+        random = random || req.type == ResourceRequest::kRandom ||
+            req.type == ResourceRequest::kParallelRandom;
+      }
+    }
+    if (random) continue;
+    bool all_inputs = true;
+    for (const auto& e : inode.inputs) {
+      all_inputs = all_inputs && from_params[e.node_id];
+    }
+    constant[nid] = from_params[nid] = all_inputs;
+  }
+  return constant;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -33,6 +33,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 namespace mxnet {
 namespace exec {
@@ -132,6 +133,98 @@ Graph AttachOpResources(Graph g);
  */
 Graph DetectInplaceAddTo(Graph g);
 
+/*!
+ * \brief Fuse groups of pointwise operators into _FusedPointwise nodes, which
+ *  compute each group in one runtime compiled kernel.
+ *
+ *  A pointwise node joins the group of its consumer when that consumer is its
+ *  only use, so the intermediate results of a group never reach memory.
+ *  Forward and backward nodes are not fused together.
+ *
+ * \param g input graph, before its attributes are inferred
+ * \param num_forward_outputs number of outputs of the forward pass
+ * \return graph with the fused nodes. The operator nodes are copied, the
+ *  variables are those of g.
+ */
+Graph FusePointwise(Graph g, size_t num_forward_outputs);
+
+/*!
+ * \brief Fold every BatchNorm that follows a Convolution or FullyConnected
+ *  into the weight and bias of that layer, computed by a _FoldBatchNorm node.
+ *  BatchNorm is removed, only valid for graphs run for inference.
+ *
+ * \param g input graph without backward pass, before its attributes are inferred
+ * \return graph with the folded layers. The operator nodes are copied, the
+ *  variables are those of g and keep their order.
+ */
+Graph FoldBatchNorm(Graph g);
+
+/*!
+ * \brief Run the 2D Convolution and Pooling of a graph in NHWC, as well as the
+ *  BatchNorm, Activation and additions reading only NHWC outputs, so that the
+ *  cuDNN tensor core kernels need no transposes. Transposes are inserted at
+ *  the boundaries of the NHWC regions and on the convolution weights, the
+ *  parameters keep their shapes.
+ *
+ * \param g input graph, before its attributes are inferred
+ * \return graph running the operators in NHWC. The operator nodes are
+ *  copied, the variables are those of g and keep their order.
+ */
+Graph ConvertLayoutNHWC(Graph g);
+
+/*!
+ * \brief Merge the operator nodes with the same operator, attributes and
+ *  inputs, so that every expression is computed once. Operators using
+ *  random numbers, mutating their inputs or with control dependencies are
+ *  never merged.
+ *
+ * \param g input graph, before its attributes are inferred
+ * \return graph without repeated expressions. The operator nodes are
+ *  copied, the variables are those of g and keep their order.
+ */
+Graph EliminateCommonExpr(Graph g);
+
+/*!
+ * \brief Find the operators of an inference graph whose inputs are all
+ *  parameters no operator mutates, or outputs of such operators. Their results do not change
+ *  from one run to the next, so they are computed once and kept. Operators
+ *  using random numbers, mutating their inputs or with control dependencies
+ *  are never constant.
+ *
+ * \param g input graph without backward pass
+ * \param param_names names of the inputs holding parameters
+ * \return whether each node of g is a constant operator
+ */
+std::vector<bool> FindConstantNodes(const Graph& g,
+                                    const std::unordered_set<std::string>& param_names);
+
+/*!
+ * \brief Find the Concat operators whose inputs can be written by their
+ *  producers right into the output of the Concat. This is possible when the
+ *  inputs are contiguous blocks of the output, that is when all the axes of
+ *  the output before the concatenated one are 1, and the inputs are dense
+ *  outputs of operators on the same device, not placed by the memory plan yet.
+ *  An entry is placed in at most one Concat, a Concat output may itself be
+ *  an input of another one.
+ *
+ * \param g input graph with the "shape", "dtype", "context" and "storage_type" attributes
+ * \param storage the storage ids fixed before the memory planning
+ * \return the node ids of the Concat operators, in topological order
+ */
+std::vector<uint32_t> DetectInplaceConcat(const Graph& g, const nnvm::StorageVector& storage);
+
+/*!
+ * \brief Count the layout reorders of a graph run with the MKL2017 operators.
+ *  The MKL operators pass their outputs to each other in the internal layout
+ *  of MKL, an entry is reordered when it goes from a MKL operator to another
+ *  operator or to the outputs of the graph, or the other way around.
+ *
+ * \param g input graph with the "shape", "dtype" and "context" attributes
+ * \param reorder_entries if not null, the ids of the reordered entries are appended
+ * \return the number of reordered entries
+ */
+size_t CountMKLReorders(const Graph& g, std::vector<uint32_t>* reorder_entries);
+
 /*!
  * \brief Infer shapes in the graph given the information.
  * \param graph The input graph.
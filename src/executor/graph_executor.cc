@@ -26,11 +26,17 @@
 #include <nnvm/pass_functions.h>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <unordered_set>
 
 #include "./exec_pass.h"
 #include "./graph_executor.h"
 #include "../engine/profiler.h"
 #include "../common/utils.h"
+#include "../common/cuda_utils.h"
 
 namespace mxnet {
 namespace exec {
@@ -78,14 +84,24 @@ inline void EmplaceBackZeros(const NDArrayStorageType stype, const TShape &shape
   }
 }
 void GraphExecutor::Forward(bool is_train) {
+  SwapNextInputs();
+  FoldConstants();
   RunOps(is_train, 0, num_forward_nodes_);
 }
 
+void GraphExecutor::Forward(bool is_train, const engine::CancelToken& token) {
+  SwapNextInputs();
+  FoldConstants();
+  RunOps(is_train, 0, num_forward_nodes_, token);
+}
+
 void GraphExecutor::PartialForward(bool is_train, int step, int *step_left) {
   size_t sstep = static_cast<size_t>(step);
   if (sstep >= num_forward_nodes_) {
     *step_left = 0; return;
   }
+  if (sstep == 0) SwapNextInputs();
+  FoldConstants();
   RunOps(is_train, sstep, sstep + 1);
   *step_left = static_cast<int>(num_forward_nodes_ - sstep - 1);
 }
@@ -105,13 +121,18 @@ void GraphExecutor::Backward(const std::vector<NDArray>& head_grads, bool is_tra
       }
     }
   }
+  if (release_forward_entries_) PlanForwardRelease();
   RunOps(is_train, num_forward_nodes_, idx.num_nodes());
+  release_entries_.clear();
+  release_arrays_.clear();
 }
 
 void GraphExecutor::Print(std::ostream &os) const {  // NOLINT(*)
   nnvm::Symbol s; s.outputs = graph_.outputs;
   s.Print(os);
-  // message to be backward compatible with the memonger
+  PrintMemoryPlan(os);
+  // message to be backward compatible with the memonger, and the executor
+  // group reading the allocated size from the third line before the end
   size_t total_bytes = graph_.GetAttr<size_t>("storage_allocated_bytes");
   os << "Total " << (total_bytes >> 20UL) <<" MB allocated\n";
   os << "Total " << 11 << " TempSpace resource requested\n";
@@ -122,6 +143,51 @@ void GraphExecutor::SetMonitorCallback(const MonitorCallback& callback) {
   monitor_callback_ = callback;
 }
 
+NDArray GraphExecutor::NextInput(const std::string& name) {
+  auto it = in_arg_map_.find(name);
+  CHECK(it != in_arg_map_.end()) << "Cannot find input argument " << name;
+  auto next = next_inputs_.find(name);
+  if (next == next_inputs_.end()) {
+    next = next_inputs_.emplace(name, it->second.StorageTwin()).first;
+  }
+  if (std::find(pending_inputs_.begin(), pending_inputs_.end(), name) == pending_inputs_.end()) {
+    pending_inputs_.push_back(name);
+  }
+  return next->second;
+}
+
+void GraphExecutor::SwapNextInputs() {
+  if (pending_inputs_.empty()) return;
+  std::vector<NDArray> args, nexts;
+  std::vector<Engine::VarHandle> use_vars, mutate_vars;
+  for (const auto& name : pending_inputs_) {
+    args.push_back(in_arg_map_.at(name));
+    nexts.push_back(next_inputs_.at(name));
+    mutate_vars.push_back(args.back().var());
+    mutate_vars.push_back(nexts.back().var());
+  }
+  pending_inputs_.clear();
+  // the operator executors reading the arguments set up their blobs again
+  std::vector<std::shared_ptr<OpExecutor> > execs;
+  for (const auto& opnode : op_nodes_) {
+    if (opnode.exec == nullptr) continue;
+    for (const auto& nd : opnode.exec->in_array) {
+      if (std::find(mutate_vars.begin(), mutate_vars.end(), nd.var()) != mutate_vars.end()) {
+        execs.push_back(opnode.exec);
+        break;
+      }
+    }
+  }
+  Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
+  // writing both arrays orders the exchange after the operators of the last
+  // iteration reading the argument and the writes of its second buffer
+  Engine::Get()->PushSync([args, nexts, execs](RunContext rctx) {
+      for (size_t i = 0; i < args.size(); ++i) args[i].SwapStorage(nexts[i]);
+      for (const auto& exec : execs) exec->Setup();
+    }, Context::CPU(), use_vars, mutate_vars, FnProperty::kNormal, 0,
+    PROFILER_MESSAGE("SwapNextInputs"));
+}
+
 const std::vector<NDArray>& GraphExecutor::outputs() const {
   return output_arrays_;
 }
@@ -238,12 +304,107 @@ inline ValueType get_node_attr(
   }
 }
 
+/*!
+ * \brief Choose the forward nodes recomputed in the backward pass such that the
+ *  estimated memory of the activations fits in a budget.
+ *
+ *  The forward pass is cut into segments in topological order. The output of
+ *  the last node of every segment is kept and the other nodes are mirrored,
+ *  so the memory is estimated as the kept outputs plus the largest segment,
+ *  which is recomputed at once. The segment size is searched among powers of
+ *  sqrt(2) for the plan recomputing the fewest bytes within the budget, or
+ *  the plan using the least memory when none fits. Dropout, operators using
+ *  random numbers and operators mutating their inputs are never mirrored.
+ * \param g the forward graph, with "shape" and "dtype" attributes
+ * \param budget the memory budget of the activations in bytes
+ * \return the nodes to mirror
+ */
+std::unordered_set<const nnvm::Node*> PlanMirror(const nnvm::Graph& g, size_t budget) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  const auto& idx = g.indexed_graph();
+  const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+  std::vector<size_t> bytes(idx.num_nodes(), 0);
+  std::vector<bool> mirrorable(idx.num_nodes(), false);
+  size_t total = 0, smallest = std::numeric_limits<size_t>::max();
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const nnvm::Node* node = idx[nid].source;
+    if (node->is_variable()) continue;
+    for (uint32_t i = 0; i < node->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      if (vdtype[eid] == -1) continue;
+      bytes[nid] += vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]);
+    }
+    total += bytes[nid];
+    if (bytes[nid] != 0) smallest = std::min(smallest, bytes[nid]);
+    bool random = false;
+    if (fresource.count(node->op())) {
+      for (const auto& req : fresource[node->op()](node->attrs)) {
+        random = random || req.type == ResourceRequest::kRandom ||
+            req.type == ResourceRequest::kParallelRandom;
+      }
+    }
+    mirrorable[nid] = node->op()->name != "Dropout" && !random &&
+        (!fmutate.count(node->op()) || fmutate[node->op()](node->attrs).empty());
+  }
+  std::unordered_set<const nnvm::Node*> ret;
+  if (total <= budget) return ret;
+  // estimated memory and recomputed bytes of the plan with segments of size seg_size
+  auto evaluate = [&](size_t seg_size, std::vector<bool>* mirror, size_t* recomputed) {
+    size_t kept = 0, seg = 0, max_seg = 0;
+    *recomputed = 0;
+    mirror->assign(idx.num_nodes(), false);
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+      if (idx[nid].source->is_variable()) continue;
+      if (!mirrorable[nid] || (seg != 0 && seg + bytes[nid] > seg_size)) {
+        max_seg = std::max(max_seg, seg);
+        kept += bytes[nid];
+        seg = 0;
+        continue;
+      }
+      seg += bytes[nid];
+      *recomputed += bytes[nid];
+      (*mirror)[nid] = true;
+    }
+    return kept + std::max(max_seg, seg);
+  };
+  std::vector<bool> best, mirror;
+  size_t best_memory = 0, best_recomputed = 0;
+  bool best_fits = false;
+  for (double seg_size = smallest; seg_size < 2.0 * total; seg_size *= std::sqrt(2.0)) {
+    size_t recomputed;
+    const size_t memory = evaluate(static_cast<size_t>(seg_size), &mirror, &recomputed);
+    const bool fits = memory <= budget;
+    if (best.empty() || (fits && !best_fits) ||
+        (fits && recomputed < best_recomputed) ||
+        (!fits && !best_fits && memory < best_memory)) {
+      best.swap(mirror);
+      best_memory = memory;
+      best_recomputed = recomputed;
+      best_fits = fits;
+    }
+  }
+  if (!best_fits) {
+    LOG(WARNING) << "The activations need an estimated " << (best_memory >> 20)
+                 << "MB with mirroring, more than MXNET_BACKWARD_MIRROR_BUDGET_MB="
+                 << (budget >> 20);
+  }
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    if (best[nid]) ret.insert(idx[nid].source);
+  }
+  return ret;
+}
+
 /*!
  * \brief Create the graph for backward pass.
  * This is triggered by both simple_bind and bind flows.
  */
-nnvm::Graph GraphExecutor::InitFullGraph(nnvm::Symbol symbol,
-                                         const std::vector<OpReqType>& grad_req_types) {
+nnvm::Graph GraphExecutor::InitFullGraph(
+    nnvm::Symbol symbol,
+    const std::vector<OpReqType>& grad_req_types,
+    const std::unordered_map<std::string, TShape>& arg_shape_map,
+    const std::unordered_map<std::string, int>& arg_dtype_map) {
   using nnvm::NodePtr;
   using nnvm::NodeEntry;
   // initial information
@@ -271,11 +432,32 @@ nnvm::Graph GraphExecutor::InitFullGraph(nnvm::Symbol symbol,
   }
 
   int do_mirror = dmlc::GetEnv("MXNET_BACKWARD_DO_MIRROR", 0);
-  auto need_mirror = [do_mirror](const nnvm::Node& node) -> int {
+  size_t mirror_budget = dmlc::GetEnv("MXNET_BACKWARD_MIRROR_BUDGET_MB", 0);
+  std::unordered_set<const nnvm::Node*> mirror_plan;
+  if (mirror_budget != 0) {
+    // plan on a separate graph, as the outputs of g change below
+    nnvm::Graph fg;
+    fg.outputs = symbol.outputs;
+    const auto& fidx = fg.indexed_graph();
+    nnvm::ShapeVector shapes(fidx.input_nodes().size(), TShape());
+    nnvm::DTypeVector dtypes(fidx.input_nodes().size(), -1);
+    for (size_t i = 0; i < fidx.input_nodes().size(); ++i) {
+      const std::string& name = fidx[fidx.input_nodes()[i]].source->attrs.name;
+      auto it1 = arg_shape_map.find(name);
+      if (it1 != arg_shape_map.end()) shapes[i] = it1->second;
+      auto it2 = arg_dtype_map.find(name);
+      if (it2 != arg_dtype_map.end()) dtypes[i] = it2->second;
+    }
+    fg = InferShape(std::move(fg), shapes, "__shape__");
+    fg = InferType(std::move(fg), dtypes, "__dtype__");
+    mirror_plan = PlanMirror(fg, mirror_budget << 20);
+  }
+  auto need_mirror = [do_mirror, mirror_budget, &mirror_plan](const nnvm::Node& node) -> int {
     if (node.is_variable()) return 0;
     const std::string& type = node.attrs.op->name;
     if (type == "Dropout") return false;
     if (get_node_attr(node, "__force_mirroring__", false)) return true;
+    if (mirror_budget != 0) return mirror_plan.count(&node) != 0;
     if (do_mirror == 0) return false;
     if (type == "Convolution") return false;
     if (type == "FullyConnected") return false;
@@ -518,8 +700,22 @@ void GraphExecutor::Init(nnvm::Symbol symbol,
   std::vector<Context> aux_state_ctxes(aux_states.size());
   std::transform(aux_states.begin(), aux_states.end(), aux_state_ctxes.begin(), get_ctx1);
 
+  // shapes and types of the inputs, used to plan the mirroring
+  std::unordered_map<std::string, TShape> arg_shape_map;
+  std::unordered_map<std::string, int> arg_dtype_map;
+  std::vector<std::string> arg_names = symbol.ListInputNames(nnvm::Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names = symbol.ListInputNames(nnvm::Symbol::kAuxiliaryStates);
+  for (size_t i = 0; i < arg_names.size() && i < in_args.size(); ++i) {
+    arg_shape_map[arg_names[i]] = in_args[i].shape();
+    arg_dtype_map[arg_names[i]] = in_args[i].dtype();
+  }
+  for (size_t i = 0; i < aux_names.size() && i < aux_states.size(); ++i) {
+    arg_shape_map[aux_names[i]] = aux_states[i].shape();
+    arg_dtype_map[aux_names[i]] = aux_states[i].dtype();
+  }
   nnvm::Graph g = InitGraph(symbol, default_ctx, ctx_map, in_arg_ctxes,
-                            arg_grad_ctxes, aux_state_ctxes, grad_req_types);
+                            arg_grad_ctxes, aux_state_ctxes, grad_req_types,
+                            arg_shape_map, arg_dtype_map);
 
   // create arg_shapes and arg_dtypes for shape and type inferences
   const auto& idx = g.indexed_graph();
@@ -845,6 +1041,19 @@ void GraphExecutor::FinishInitGraph(nnvm::Symbol symbol,
       dispatch_stypes[nid] = contains_non_default ? kNonDefaultStorage : kDefaultStorage;
   }
   g.attrs["dispatch_stypes"] = std::make_shared<dmlc::any>(std::move(dispatch_stypes));
+#if MXNET_USE_MKL2017 == 1
+  if (dmlc::GetEnv("MXNET_MKL_REORDER_LOG", false)) {
+    std::vector<uint32_t> reorder_entries;
+    const size_t num_reorders = CountMKLReorders(g, &reorder_entries);
+    LOG(INFO) << "MKL layout reorders of the graph: " << num_reorders << " of "
+              << idx.num_node_entries() << " entries";
+    if (log_verbose_) {
+      for (uint32_t eid : reorder_entries) {
+        LOG(INFO) << "\treorder data entry\t" << eid;
+      }
+    }
+  }
+#endif
 
   // data entries for output gradients
   for (size_t j = num_forward_outputs_; j < idx.outputs().size(); ++j) {
@@ -862,6 +1071,113 @@ void GraphExecutor::FinishInitGraph(nnvm::Symbol symbol,
       data_entry_[eid] = kv.second;
       arg_storage_id[eid] = kExternalStorageID;
     }
+    if (keep_backward_outputs_) {
+      // every backward output gets its own array, which outlives the run
+      const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+      const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+      const auto& vctx = g.GetAttr<ContextVector>("context");
+      for (size_t nid = num_forward_nodes_; nid < idx.num_nodes(); ++nid) {
+        if (idx[nid].source->is_variable()) continue;
+        for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+          const uint32_t eid = idx.entry_id(nid, i);
+          if (arg_storage_id[eid] != kBadStorageID ||
+              vstorage_type[eid] != kDefaultStorage) continue;
+          data_entry_[eid] = NDArray(vshape[eid], vctx[nid], false, vdtype[eid]);
+          arg_storage_id[eid] = kExternalStorageID;
+        }
+      }
+    }
+    if (!constant_nodes_.empty()) {
+      // the constant entries read by the other nodes are computed once and
+      // kept, so they get their own arrays
+      const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+      const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+      const auto& vctx = g.GetAttr<ContextVector>("context");
+      auto keep_entry = [&](const nnvm::IndexedGraph::NodeEntry& e) {
+        const uint32_t eid = idx.entry_id(e);
+        if (!constant_nodes_[e.node_id] || arg_storage_id[eid] != kBadStorageID ||
+            vstorage_type[eid] != kDefaultStorage) return;
+        data_entry_[eid] = NDArray(vshape[eid], vctx[e.node_id], false, vdtype[eid]);
+        arg_storage_id[eid] = kExternalStorageID;
+        constant_entries_.insert(eid);
+      };
+      for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        if (constant_nodes_[nid]) continue;
+        for (const auto& e : idx[nid].inputs) keep_entry(e);
+      }
+      for (const auto& e : idx.outputs()) keep_entry(e);
+    }
+    if (dmlc::GetEnv("MXNET_EXEC_ENABLE_INPLACE_CONCAT", false)) {
+      // the producers of the inputs write into their blocks of the output,
+      // the Concat is then not run. The outer Concats go first, so a nested
+      // one gets its block before handing out the blocks of its own inputs.
+      const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+      const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+      const auto& vctx = g.GetAttr<ContextVector>("context");
+      std::vector<uint32_t> concat_nodes = DetectInplaceConcat(g, arg_storage_id);
+      for (auto it = concat_nodes.rbegin(); it != concat_nodes.rend(); ++it) {
+        const uint32_t out = idx.entry_id(*it, 0);
+        if (data_entry_[out].is_none()) {
+          data_entry_[out] = NDArray(vshape[out], vctx[*it], false, vdtype[out]);
+        }
+        arg_storage_id[out] = kExternalStorageID;
+        view_entries_.insert(out);
+        NDArray flat = data_entry_[out].Reshape(mshadow::Shape1(vshape[out].Size()));
+        index_t offset = 0;
+        for (const auto& e : idx[*it].inputs) {
+          const uint32_t eid = idx.entry_id(e);
+          const index_t size = vshape[eid].Size();
+          data_entry_[eid] = flat.Slice(offset, offset + size).Reshape(vshape[eid]);
+          arg_storage_id[eid] = kExternalStorageID;
+          view_entries_.insert(eid);
+          offset += size;
+        }
+        view_nodes_.insert(*it);
+      }
+    }
+    if (dmlc::GetEnv("MXNET_EXEC_ENABLE_SLICE_VIEW", false)) {
+      // the outputs of the slicing operators, such as SliceChannel and
+      // slice_axis along the outermost axis, are views of their input, which
+      // then gets its own array
+      static auto& foutput_views = nnvm::Op::GetAttr<FOutputViews>("FOutputViews");
+      const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+      const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+      const auto& vctx = g.GetAttr<ContextVector>("context");
+      std::vector<size_t> offsets;
+      for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        const auto& inode = idx[nid];
+        if (inode.source->is_variable() || !foutput_views.count(inode.source->op()) ||
+            inode.inputs.size() != 1) continue;
+        const auto& in = inode.inputs[0];
+        const uint32_t in_eid = idx.entry_id(in);
+        // arguments can be rebound, the views would then be stale
+        if (idx[in.node_id].source->is_variable() || vstorage_type[in_eid] != kDefaultStorage ||
+            (arg_storage_id[in_eid] != kBadStorageID && !view_entries_.count(in_eid))) continue;
+        bool ok = foutput_views[inode.source->op()](inode.source->attrs, vshape[in_eid],
+                                                    &offsets);
+        ok = ok && offsets.size() == inode.source->num_outputs();
+        for (uint32_t i = 0; ok && i < inode.source->num_outputs(); ++i) {
+          const uint32_t eid = idx.entry_id(nid, i);
+          ok = arg_storage_id[eid] == kBadStorageID && vstorage_type[eid] == kDefaultStorage &&
+               vdtype[eid] == vdtype[in_eid];
+        }
+        if (!ok) continue;
+        if (data_entry_[in_eid].is_none()) {
+          data_entry_[in_eid] = NDArray(vshape[in_eid], vctx[in.node_id], false, vdtype[in_eid]);
+        }
+        arg_storage_id[in_eid] = kExternalStorageID;
+        view_entries_.insert(in_eid);
+        NDArray flat = data_entry_[in_eid].Reshape(mshadow::Shape1(vshape[in_eid].Size()));
+        for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+          const uint32_t eid = idx.entry_id(nid, i);
+          const index_t begin = offsets[i];
+          data_entry_[eid] = flat.Slice(begin, begin + vshape[eid].Size()).Reshape(vshape[eid]);
+          arg_storage_id[eid] = kExternalStorageID;
+          view_entries_.insert(eid);
+        }
+        view_nodes_.insert(nid);
+      }
+    }
     for (size_t i = 0; i < idx.num_node_entries(); i++) {
       if (vstorage_type[i] != kDefaultStorage) arg_storage_id[i] = kDynamicStorageID;
     }
@@ -900,6 +1216,104 @@ void GraphExecutor::FinishInitGraph(nnvm::Symbol symbol,
   this->InitOpSegs();
 }
 
+void GraphExecutor::ReleaseArrays() {
+  for (auto& n : op_nodes_) {
+    if (n.cached_opr != nullptr) {
+      Engine::Get()->DeleteOperator(n.cached_opr);
+    }
+  }
+  op_nodes_.clear();
+  for (auto& seg : cached_seg_opr_) {
+    if (seg.opr != nullptr) {
+      Engine::Get()->DeleteOperator(seg.opr);
+    }
+  }
+  cached_seg_opr_.clear();
+  // the operator executors hold the arrays and the states of the last run
+  graph_.attrs.erase("op_execs");
+  graph_.attrs.erase("saved_states");
+  const auto& idx = graph_.indexed_graph();
+  const auto& vstorage = graph_.GetAttr<nnvm::StorageVector>("storage_id");
+  for (size_t i = 0; i < num_forward_inputs_; ++i) {
+    data_entry_[idx.entry_id(idx.input_nodes().at(i), 0)] = NDArray();
+  }
+  for (size_t i = 0; i < vstorage.size(); ++i) {
+    // the constant entries are kept, to be computed again after the rebind,
+    // and so are the arrays with views of each other
+    if (vstorage[i] == kExternalStorageID && !constant_entries_.count(i) &&
+        !view_entries_.count(i)) {
+      data_entry_[i] = NDArray();
+    }
+  }
+  output_arrays_.clear();
+  grad_store_.clear();
+  next_inputs_.clear();
+  pending_inputs_.clear();
+  in_arg_map_.clear();
+  arg_grad_map_.clear();
+  aux_state_map_.clear();
+}
+
+void GraphExecutor::Rebind(const std::vector<NDArray>& in_args,
+                           const std::vector<NDArray>& arg_grad_store,
+                           const std::vector<OpReqType>& grad_req_types,
+                           const std::vector<NDArray>& aux_states,
+                           const std::unordered_map<uint32_t, NDArray>& feed_entries,
+                           const std::unordered_map<uint32_t, OpStatePtr>& node_states) {
+  CHECK(op_nodes_.empty()) << "Rebind requires an executor released by ReleaseArrays";
+  {
+    const auto& idx = graph_.indexed_graph();
+    const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+    const auto& mutable_nodes = idx.mutable_input_nodes();
+    size_t arg_top = 0, aux_top = 0;
+    for (size_t i = 0; i < num_forward_inputs_; ++i) {
+      const uint32_t nid = idx.input_nodes().at(i);
+      const std::string& arg_name = idx[nid].source->attrs.name;
+      size_t eid = idx.entry_id(nid, 0);
+      if (mutable_nodes.count(nid)) {
+        CHECK_LT(aux_top, aux_states.size());
+        data_entry_[eid] = aux_states[aux_top];
+        aux_state_map_.emplace(arg_name, aux_states[aux_top]);
+        ++aux_top;
+      } else {
+        CHECK_LT(arg_top, in_args.size());
+        data_entry_[eid] = in_args[arg_top];
+        in_arg_map_.emplace(arg_name, in_args[arg_top]);
+        if (kNullOp != grad_req_types[arg_top]) {
+          grad_store_.emplace_back(grad_req_types[arg_top], arg_grad_store[arg_top]);
+          arg_grad_map_.emplace(arg_name, arg_grad_store[arg_top]);
+        }
+        ++arg_top;
+      }
+      CHECK_EQ(data_entry_[eid].shape(), vshape[eid])
+          << "Rebind requires arrays of the shapes bound before";
+    }
+    for (const auto& kv : feed_entries) {
+      CHECK_EQ(kv.second.shape(), vshape[kv.first])
+          << "Rebind requires arrays of the shapes bound before";
+      data_entry_[kv.first] = kv.second;
+    }
+    CHECK_EQ(grad_store_.size(), idx.outputs().size() - num_forward_outputs_);
+    for (size_t j = num_forward_outputs_; j < idx.outputs().size(); ++j) {
+      data_entry_[idx.entry_id(idx.outputs()[j])] = grad_store_[j - num_forward_outputs_].second;
+    }
+    for (size_t i = 0; i < num_forward_outputs_; ++i) {
+      output_arrays_.push_back(data_entry_[idx.entry_id(idx.outputs()[i])]);
+    }
+    std::unordered_map<const nnvm::Node*, OpStatePtr> saved_states;
+    for (const auto& kv : node_states) {
+      saved_states.emplace(idx[kv.first].source, kv.second);
+    }
+    graph_.attrs["saved_states"] = std::make_shared<nnvm::any>(std::move(saved_states));
+  }
+  // new operator executors, the ones of the last run may still be in use
+  constants_folded_ = false;
+  graph_ = AttachOpExecs(std::move(graph_));
+  graph_ = AttachOpResources(std::move(graph_));
+  this->InitCachedOps();
+  this->InitOpSegs();
+}
+
 /*!
  * \brief GraphExecutor initializer for simple bind flow in
  * which only certain input shapes and dtypes are provided by users.
@@ -932,7 +1346,8 @@ void GraphExecutor::Init(nnvm::Symbol symbol,
                          Executor* shared_exec,
                          const nnvm::NodeEntryMap<NDArray>& feed_dict) {
   nnvm::Graph g = InitGraph(symbol, default_ctx, ctx_map, in_arg_ctxes, arg_grad_ctxes,
-                            aux_state_ctxes, grad_req_types);
+                            aux_state_ctxes, grad_req_types, arg_shape_map, arg_dtype_map,
+                            shared_arg_names);
   // The following code of shape and dtype inferences and argument
   // initialization is for simple_bind only. Regular bind operation
   // should do this differently.
@@ -1016,9 +1431,39 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
                                const std::vector<Context>& in_arg_ctxes,
                                const std::vector<Context>& arg_grad_ctxes,
                                const std::vector<Context>& aux_state_ctxes,
-                               const std::vector<OpReqType>& grad_req_types) {
+                               const std::vector<OpReqType>& grad_req_types,
+                               const std::unordered_map<std::string, TShape>& arg_shape_map,
+                               const std::unordered_map<std::string, int>& arg_dtype_map,
+                               const std::unordered_set<std::string>& param_names) {
+  // compute every repeated expression of the forward graph once
+  if (dmlc::GetEnv("MXNET_EXEC_ENABLE_COMMON_EXPR_ELIMINATION", false)) {
+    nnvm::Graph fwd;
+    fwd.outputs = symbol.outputs;
+    symbol.outputs = EliminateCommonExpr(std::move(fwd)).outputs;
+  }
+#if MXNET_USE_CUDNN == 1
+  // run the convolutions in NHWC, transposing the data at the boundaries
+  if (default_ctx.dev_mask() == gpu::kDevMask && ctx_map.size() == 0 &&
+      dmlc::GetEnv("MXNET_EXEC_ENABLE_NHWC_LAYOUT", false)) {
+    nnvm::Graph fwd;
+    fwd.outputs = symbol.outputs;
+    symbol.outputs = ConvertLayoutNHWC(std::move(fwd)).outputs;
+  }
+#endif
   // setup gradient
-  nnvm::Graph g = InitFullGraph(symbol, grad_req_types);
+  nnvm::Graph g = InitFullGraph(symbol, grad_req_types, arg_shape_map, arg_dtype_map);
+  // fold BatchNorm into the preceding layer of inference graphs
+  if (num_forward_outputs_ == g.outputs.size() &&
+      dmlc::GetEnv("MXNET_EXEC_ENABLE_BATCHNORM_FOLDING", false)) {
+    g = FoldBatchNorm(std::move(g));
+  }
+#if ((MXNET_USE_CUDA) && (MXNET_USE_NVRTC))
+  // fuse pointwise operators into runtime compiled kernels
+  if (default_ctx.dev_mask() == gpu::kDevMask && ctx_map.size() == 0 &&
+      dmlc::GetEnv("MXNET_EXEC_ENABLE_POINTWISE_FUSION", false)) {
+    g = FusePointwise(std::move(g), num_forward_outputs_);
+  }
+#endif
 
   // create "device" and "context" attrs for the graph
   g = AssignContext(g, default_ctx, ctx_map,
@@ -1035,10 +1480,230 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
     num_forward_nodes_ = std::max(
         num_forward_nodes_, static_cast<size_t>(idx.outputs()[i].node_id + 1));
   }
+  // compute the operators reading only the parameters once, for inference graphs
+  constant_nodes_.clear();
+  if (num_forward_outputs_ == g.outputs.size() && !param_names.empty() &&
+      dmlc::GetEnv("MXNET_EXEC_ENABLE_CONSTANT_FOLDING", false)) {
+    // the auxiliary states no operator mutates, like the moving statistics
+    // of a folded BatchNorm, are parameters as well
+    std::unordered_set<std::string> names(param_names);
+    for (const auto& name : symbol.ListInputNames(nnvm::Symbol::kAuxiliaryStates)) {
+      names.insert(name);
+    }
+    constant_nodes_ = FindConstantNodes(g, names);
+    if (std::find(constant_nodes_.begin(), constant_nodes_.end(), true) ==
+        constant_nodes_.end()) {
+      constant_nodes_.clear();
+    }
+  }
   return g;
 }
 
+/*!
+ * \brief Find the nodes between which each storage block is alive.
+ * \param idx the indexed graph
+ * \param vstorage the storage id of each entry
+ * \param num_storage number of storage blocks
+ * \param begin index of the first node touching each block
+ * \param end index of the last node touching each block, the outputs of
+ *  the graph are alive until idx.num_nodes()
+ */
+inline void StorageLiveRanges(const nnvm::IndexedGraph& idx,
+                              const nnvm::StorageVector& vstorage,
+                              size_t num_storage,
+                              std::vector<uint32_t>* begin,
+                              std::vector<uint32_t>* end) {
+  begin->assign(num_storage, idx.num_nodes());
+  end->assign(num_storage, 0);
+  auto touch = [&](uint32_t eid, uint32_t nid) {
+    int sid = vstorage[eid];
+    if (sid < 0 || static_cast<size_t>(sid) >= num_storage) return;
+    (*begin)[sid] = std::min((*begin)[sid], nid);
+    (*end)[sid] = std::max((*end)[sid], nid);
+  };
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    for (const auto& e : idx[nid].inputs) touch(idx.entry_id(e), nid);
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      touch(idx.entry_id(nid, i), nid);
+    }
+  }
+  for (const auto& e : idx.outputs()) touch(idx.entry_id(e), idx.num_nodes());
+}
+
+void GraphExecutor::PrintMemoryPlan(std::ostream &os) const {  // NOLINT(*)
+  const auto& idx = graph_.indexed_graph();
+  const auto& vdtype = graph_.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vstorage = graph_.GetAttr<nnvm::StorageVector>("storage_id");
+  // size of each block, and the entries sharing it
+  std::vector<size_t> bytes;
+  std::vector<std::vector<uint32_t> > entries;
+  for (uint32_t eid = 0; eid < vstorage.size(); ++eid) {
+    if (vstorage[eid] < 0) continue;
+    size_t sid = static_cast<size_t>(vstorage[eid]);
+    if (sid >= bytes.size()) {
+      bytes.resize(sid + 1, 0);
+      entries.resize(sid + 1);
+    }
+    bytes[sid] = std::max(bytes[sid],
+                          vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]));
+    entries[sid].push_back(eid);
+  }
+  if (bytes.empty()) return;
+  std::vector<uint32_t> begin, end;
+  StorageLiveRanges(idx, vstorage, bytes.size(), &begin, &end);
+  // the node at which the blocks alive together are the largest
+  size_t peak_bytes = 0;
+  uint32_t peak_nid = 0;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    size_t live = 0;
+    for (size_t sid = 0; sid < bytes.size(); ++sid) {
+      if (begin[sid] <= nid && nid <= end[sid]) live += bytes[sid];
+    }
+    if (live > peak_bytes) {
+      peak_bytes = live;
+      peak_nid = nid;
+    }
+  }
+  // the node output of each entry
+  std::vector<std::pair<const nnvm::Node*, uint32_t> > producer(idx.num_node_entries());
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      producer[idx.entry_id(nid, i)] = std::make_pair(idx[nid].source, i);
+    }
+  }
+  std::vector<size_t> live_sids;
+  for (size_t sid = 0; sid < bytes.size(); ++sid) {
+    if (begin[sid] <= peak_nid && peak_nid <= end[sid] && bytes[sid] != 0) {
+      live_sids.push_back(sid);
+    }
+  }
+  std::stable_sort(live_sids.begin(), live_sids.end(), [&bytes](size_t lhs, size_t rhs) {
+      return bytes[lhs] > bytes[rhs];
+    });
+  os << "Peak of " << (peak_bytes >> 20UL) << " MB alive at node "
+     << idx[peak_nid].source->attrs.name << ", held by\n";
+  for (size_t sid : live_sids) {
+    os << "\t" << (bytes[sid] >> 10UL) << " KB\t";
+    for (size_t i = 0; i < entries[sid].size(); ++i) {
+      const nnvm::Node* node = producer[entries[sid][i]].first;
+      os << (i == 0 ? "" : ", ") << node->attrs.name;
+      if (node->num_outputs() > 1) os << "[" << producer[entries[sid][i]].second << "]";
+    }
+    os << "\n";
+  }
+}
+
+void GraphExecutor::GetMemoryPlan(std::vector<MemoryPlanEntry>* entries,
+                                  std::vector<MemoryPlanTotal>* totals) const {
+  const auto& idx = graph_.indexed_graph();
+  const auto& vdtype = graph_.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vstorage = graph_.GetAttr<nnvm::StorageVector>("storage_id");
+  const auto& vstorage_inplace = graph_.GetAttr<std::vector<int> >("storage_inplace_index");
+  const auto& vctx = graph_.GetAttr<ContextVector>("context");
+  entries->clear();
+  entries->resize(idx.num_node_entries());
+  std::vector<size_t> block_bytes;
+  std::vector<Context> block_ctx;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const nnvm::Node* node = idx[nid].source;
+    for (uint32_t i = 0; i < node->num_outputs(); ++i) {
+      uint32_t eid = idx.entry_id(nid, i);
+      MemoryPlanEntry& entry = entries->at(eid);
+      entry.name = node->attrs.name;
+      if (node->num_outputs() > 1) entry.name += "[" + std::to_string(i) + "]";
+      entry.storage_id = vstorage[eid];
+      entry.bytes = vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]);
+      entry.inplace_input = std::max(vstorage_inplace[eid], -1);
+      entry.ctx = vctx[nid];
+      if (node->is_variable()) {
+        entry.req = -1;
+      } else if (nid < op_nodes_.size() && op_nodes_[nid].exec != nullptr &&
+                 i < op_nodes_[nid].exec->req.size()) {
+        entry.req = op_nodes_[nid].exec->req[i];
+      } else {
+        entry.req = kNullOp;
+      }
+      if (entry.storage_id < 0) continue;
+      size_t sid = static_cast<size_t>(entry.storage_id);
+      if (sid >= block_bytes.size()) {
+        block_bytes.resize(sid + 1, 0);
+        block_ctx.resize(sid + 1);
+      }
+      block_bytes[sid] = std::max(block_bytes[sid], entry.bytes);
+      block_ctx[sid] = entry.ctx;
+    }
+  }
+  std::vector<uint32_t> begin, end;
+  StorageLiveRanges(idx, vstorage, block_bytes.size(), &begin, &end);
+  totals->clear();
+  for (size_t sid = 0; sid < block_bytes.size(); ++sid) {
+    if (block_bytes[sid] == 0) continue;
+    auto it = std::find_if(totals->begin(), totals->end(), [&](const MemoryPlanTotal& t) {
+        return t.ctx == block_ctx[sid];
+      });
+    if (it == totals->end()) {
+      totals->push_back(MemoryPlanTotal{block_ctx[sid], 0, 0});
+      it = totals->end() - 1;
+    }
+    it->train_bytes += block_bytes[sid];
+    if (begin[sid] < num_forward_nodes_) it->forward_bytes += block_bytes[sid];
+  }
+}
+
 // initialize the memory of each entries
+/*!
+ * \brief Assign an offset in a shared arena to every storage block, such that
+ *  blocks that are alive at the same time never overlap in memory.
+ *  Blocks are placed from the largest to the smallest, each one into the
+ *  smallest gap left by the already placed blocks with overlapping lifetime.
+ * \param bytes size of each block, blocks of size 0 are ignored
+ * \param begin index of the first node touching each block
+ * \param end index of the last node touching each block
+ * \param offsets the offset of each block
+ * \return the size of the arena
+ */
+inline size_t PlanArenaOffsets(const std::vector<size_t>& bytes,
+                               const std::vector<uint32_t>& begin,
+                               const std::vector<uint32_t>& end,
+                               std::vector<size_t>* offsets) {
+  std::vector<size_t> order(bytes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&bytes](size_t lhs, size_t rhs) {
+      return bytes[lhs] > bytes[rhs];
+    });
+  offsets->assign(bytes.size(), 0);
+  std::vector<size_t> placed;
+  std::vector<std::pair<size_t, size_t> > live;
+  size_t total = 0;
+  for (size_t i : order) {
+    if (bytes[i] == 0) continue;
+    // address ranges of the placed blocks alive together with block i
+    live.clear();
+    for (size_t j : placed) {
+      if (begin[j] <= end[i] && begin[i] <= end[j]) {
+        live.emplace_back(offsets->at(j), offsets->at(j) + bytes[j]);
+      }
+    }
+    std::sort(live.begin(), live.end());
+    const size_t kNotFound = std::numeric_limits<size_t>::max();
+    size_t best = kNotFound, best_gap = kNotFound, offset = 0;
+    for (const auto& range : live) {
+      if (range.first >= offset + bytes[i] && range.first - offset < best_gap) {
+        best = offset;
+        best_gap = range.first - offset;
+      }
+      offset = std::max(offset, range.second);
+    }
+    if (best == kNotFound) best = offset;
+    offsets->at(i) = best;
+    placed.push_back(i);
+    total = std::max(total, best + bytes[i]);
+  }
+  return total;
+}
+
 void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   using nnvm::DTypeVector;
   using nnvm::ShapeVector;
@@ -1123,6 +1788,55 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   data_pool_.clear();
   data_pool_.resize(pool_info.size());
 
+  if (dmlc::GetEnv("MXNET_EXEC_MEM_ARENA", false)) {
+    // Lay out the whole plan in one arena per context. All blocks of an
+    // arena share its engine variable, so the operators touching them run in
+    // the order they are pushed, which is the topological order of the nodes.
+    // This makes it safe to let blocks with disjoint lifetimes overlap.
+    const size_t kArenaAlign = 256;
+    std::vector<uint32_t> sid_begin, sid_end;
+    StorageLiveRanges(idx, vstorage, pool_info.size(), &sid_begin, &sid_end);
+
+    std::vector<Context> arena_ctx;
+    for (const PoolEntry& info : pool_info) {
+      if (info.bytes == 0) continue;
+      if (std::find(arena_ctx.begin(), arena_ctx.end(), info.ctx) == arena_ctx.end()) {
+        arena_ctx.push_back(info.ctx);
+      }
+    }
+    for (const Context& ctx : arena_ctx) {
+      std::vector<size_t> bytes(pool_info.size(), 0), offsets;
+      for (size_t i = 0; i < pool_info.size(); ++i) {
+        if (pool_info[i].ctx != ctx) continue;
+        bytes[i] = (pool_info[i].bytes + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+      }
+      size_t total = PlanArenaOffsets(bytes, sid_begin, sid_end, &offsets);
+      if (total == 0) continue;
+      NDArray arena;
+      for (auto it = free_pool.lower_bound(total); it != free_pool.end(); ++it) {
+        if (it->second.ctx() == ctx) {
+          arena = it->second;
+          free_pool.erase(it);
+          break;
+        }
+      }
+      if (arena.is_none()) {
+        size_t nword = total / 4;
+        CHECK_LE(nword, std::numeric_limits<index_t>::max());
+        arena = NDArray(TShape{static_cast<nnvm::dim_t>(nword)}, ctx, true);
+        if (shared_pool != nullptr) shared_pool->push_back(arena);
+      }
+      for (size_t i = 0; i < pool_info.size(); ++i) {
+        if (bytes[i] == 0) continue;
+        data_pool_[i] = arena.Slice(static_cast<index_t>(offsets[i] / 4),
+                                    static_cast<index_t>((offsets[i] + bytes[i]) / 4));
+      }
+      if (log_verbose_) {
+        LOG(INFO) << "\tinit memory arena on " << ctx << " of " << total << " bytes";
+      }
+    }
+  }
+
   // sort the pool info the descending order before allocating memory
   std::vector<size_t> sorted_pool_index;
   for (size_t i = 0; i < pool_info.size(); i++) {
@@ -1134,6 +1848,8 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   std::sort(sorted_pool_index.begin(), sorted_pool_index.end(), pool_comparator);
 
   for (size_t i : sorted_pool_index) {
+    // skip the blocks placed in an arena
+    if (!data_pool_[i].is_none()) continue;
     const Context& ctx = pool_info[i].ctx;
     size_t bytes = pool_info[i].bytes;
     NDArrayStorageType storage_type = pool_info[i].stype;
@@ -1221,12 +1937,13 @@ void GraphExecutor::InitCachedOps() {
 #else
     op_nodes_[nid].opr_name = nullptr;
 #endif
-    if (skip_plus_node.at(nid)) {
+    if (skip_plus_node.at(nid) || view_nodes_.count(nid)) {
       op_nodes_[nid].skip_exec_node = true; continue;
     }
 
     op_nodes_[nid].exec = op_execs[nid];
     op_nodes_[nid].ctx = vctx[nid];
+    op_nodes_[nid].constant = !constant_nodes_.empty() && constant_nodes_[nid];
     auto& exec = op_nodes_[nid].exec;
     CHECK_EQ(exec->in_array.size(), 0U);
     CHECK_EQ(exec->out_array.size(), 0U);
@@ -1270,7 +1987,7 @@ void GraphExecutor::InitCachedOps() {
       use_vars.push_back(nd.var());
     }
     for (auto& r : exec->op_ctx.requested) {
-      mutate_vars.push_back(r.var);
+      if (r.var != nullptr) mutate_vars.push_back(r.var);
     }
     for (auto& nd : exec->out_array) {
       mutate_vars.push_back(nd.var());
@@ -1312,11 +2029,54 @@ void GraphExecutor::InitCachedOps() {
     op_nodes_[nid].cached_opr = Engine::Get()->NewOperator(
         exec_fun, use_vars, mutate_vars, FnProperty::kNormal,
         PROFILER_MESSAGE(op_nodes_[nid].opr_name));
+    op_nodes_[nid].cached_fn = exec_fun;
     op_nodes_[nid].mutate_vars = mutate_vars;
     op_nodes_[nid].use_vars = use_vars;
   }
 }
 
+/*!
+ * \brief Estimate the cost of running a node, used to place the bulk segment
+ *  boundaries. The cost of most operators is the number of elements they read
+ *  and write. FullyConnected, Convolution and Deconvolution are dominated by
+ *  their multiply-adds, which are estimated from the weight shape. A backward
+ *  node costs twice its forward node.
+ * \param idx the indexed graph
+ * \param vshape the shape of every node entry
+ * \param nid the node
+ * \return the estimated cost, 0 for variables
+ */
+inline size_t EstimateOpCost(const nnvm::IndexedGraph& idx,
+                             const nnvm::ShapeVector& vshape,
+                             uint32_t nid) {
+  static const auto& is_backward = nnvm::Op::GetAttr<nnvm::TIsBackward>("TIsBackward");
+  const auto& inode = idx[nid];
+  if (inode.source->is_variable()) return 0;
+  const nnvm::Op* op = inode.source->op();
+  if (is_backward.get(op, false) && inode.source->control_deps.size() != 0U) {
+    const uint32_t fwd_nid = idx.node_id(inode.source->control_deps[0].get());
+    if (fwd_nid < nid) return 2 * EstimateOpCost(idx, vshape, fwd_nid);
+  }
+  const std::string& name = op->name;
+  if ((name == "FullyConnected" || name == "Convolution" || name == "Deconvolution") &&
+      inode.inputs.size() > 1) {
+    const TShape& data = vshape[idx.entry_id(inode.inputs[0])];
+    const TShape& weight = vshape[idx.entry_id(inode.inputs[1])];
+    const TShape& out = vshape[idx.entry_id(nid, 0)];
+    if (weight.ndim() > 1 && weight[0] != 0) {
+      // data and out swap roles for a deconvolution
+      const size_t size = name == "Deconvolution" ? data.Size() : out.Size();
+      return size * (weight.Size() / weight[0]);
+    }
+  }
+  size_t cost = 0;
+  for (const auto& e : inode.inputs) cost += vshape[idx.entry_id(e)].Size();
+  for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+    cost += vshape[idx.entry_id(nid, i)].Size();
+  }
+  return cost;
+}
+
 void GraphExecutor::InitOpSegs() {
   size_t total_num_nodes = graph_.indexed_graph().num_nodes();
   cached_seg_opr_.clear();
@@ -1330,14 +2090,43 @@ void GraphExecutor::InitOpSegs() {
   bool prefer_bulk_exec = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_TRAIN", 1);
   // The maximum number of node in a segment executed in bulk
   size_t num_nodes_threshold = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_MAX_NODE_TRAIN", 15);
+  // The maximum estimated cost of a segment executed in bulk, 0 to disable
+  size_t cost_threshold = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_MAX_COST_TRAIN", 0);
   if (prefer_bulk_exec_inference && num_forward_nodes_ == total_num_nodes) {
     // bulk the whole graph for inference
     num_nodes_threshold = std::numeric_limits<size_t>::max();
+    cost_threshold = 0;
+  }
+  // Whether independent branches are executed in separate segments
+  bool split_branches = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_SPLIT_BRANCHES", false);
+  // a node starts a new branch when it reads nothing computed by the segment,
+  // the segments of independent branches can then run on different streams
+  auto starts_branch = [this, split_branches](size_t nid, size_t topo_start) {
+    if (!split_branches || nid <= topo_start) return false;
+    const auto& inode = graph_.indexed_graph()[nid];
+    for (const auto& e : inode.inputs) {
+      if (e.node_id >= topo_start && e.node_id < nid) return false;
+    }
+    for (uint32_t dep : inode.control_deps) {
+      if (dep >= topo_start && dep < nid) return false;
+    }
+    return true;
+  };
+  // estimated cost of every node
+  std::vector<size_t> node_cost;
+  if (cost_threshold != 0) {
+    const auto& idx = graph_.indexed_graph();
+    const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+    node_cost.resize(total_num_nodes);
+    for (uint32_t nid = 0; nid < total_num_nodes; ++nid) {
+      node_cost[nid] = EstimateOpCost(idx, vshape, nid);
+    }
   }
 
   // create forward segments for training
   if (prefer_bulk_exec > 0) {
     size_t topo_start = 0;
+    size_t seg_cost = 0;
     for (size_t nid = 0; nid < num_forward_nodes_; nid++) {
       auto &node = graph_.indexed_graph()[nid].source;
       auto &op_node = op_nodes_[nid];
@@ -1348,6 +2137,17 @@ void GraphExecutor::InitOpSegs() {
         // create a new segment for the previous nodes if the current one cannot be bulked
         cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
         topo_start = nid + 1;
+        seg_cost = 0;
+      } else {
+        // start a new segment at the current node if it starts an independent
+        // branch, or makes the segment too expensive
+        if (starts_branch(nid, topo_start) || (cost_threshold != 0 && seg_cost != 0 &&
+                                               seg_cost + node_cost[nid] > cost_threshold)) {
+          cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
+          topo_start = nid;
+          seg_cost = 0;
+        }
+        if (cost_threshold != 0) seg_cost += node_cost[nid];
       }
     }
     // the last segmenet
@@ -1365,6 +2165,7 @@ void GraphExecutor::InitOpSegs() {
     }
     auto &idx = graph_.indexed_graph();
     size_t topo_start = num_forward_nodes_;
+    size_t seg_cost = 0;
     for (size_t nid = num_forward_nodes_; nid < total_num_nodes; nid++) {
       auto &op_node = op_nodes_[nid];
       if (op_node.skip_exec_node || op_node.exec == nullptr) {
@@ -1374,15 +2175,33 @@ void GraphExecutor::InitOpSegs() {
           op_node.exec->exec_type() != ExecType::kSync) {
         cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
         topo_start = nid + 1;
+        seg_cost = 0;
       } else {
-        // If it produces output gradient, don't include it in the segment
+        // If it produces output gradient, don't include it in the segment.
+        // The write of the gradient array then completes with its own operator,
+        // and the engine starts the kvstore push reading it right away.
         bool output_gradient = false;
         for (auto &out_arr : op_node.exec->out_array) {
           if (grad_vars.find(out_arr.var()) != grad_vars.end()) {
             output_gradient = true;
           }
         }
-        if (output_gradient) {
+        if (starts_branch(nid, topo_start) || (cost_threshold != 0 && seg_cost != 0 &&
+                                               seg_cost + node_cost[nid] > cost_threshold)) {
+          cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
+          topo_start = nid;
+          seg_cost = 0;
+        }
+        if (cost_threshold != 0) {
+          seg_cost += node_cost[nid];
+          // end the segment with the node producing the gradient, so that the
+          // gradient is ready for the kvstore once the segment is done
+          if (output_gradient) {
+            cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid + 1);
+            topo_start = nid + 1;
+            seg_cost = 0;
+          }
+        } else if (output_gradient) {
           cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
           topo_start = nid + 1;
         }
@@ -1418,12 +2237,118 @@ void GraphExecutor::ExecuteMonCallback(size_t nid) {
   }
 }
 
-void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
+void GraphExecutor::PlanForwardRelease() {
+  const auto& idx = graph_.indexed_graph();
+  const auto& vstorage = graph_.GetAttr<nnvm::StorageVector>("storage_id");
+  // the outputs of the forward nodes bound from outside, except the outputs
+  // of the graph and the entries kept over ReleaseArrays
+  std::vector<bool> releasable(idx.num_node_entries(), false);
+  for (uint32_t nid = 0; nid < num_forward_nodes_; ++nid) {
+    if (idx[nid].source->is_variable()) continue;
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      releasable[eid] = vstorage[eid] == kExternalStorageID &&
+          !constant_entries_.count(eid) && !view_entries_.count(eid);
+    }
+  }
+  for (size_t i = 0; i < num_forward_outputs_; ++i) {
+    releasable[idx.entry_id(idx.outputs()[i])] = false;
+  }
+  std::vector<int> last_use(idx.num_node_entries(), -1);
+  for (uint32_t nid = num_forward_nodes_; nid < idx.num_nodes(); ++nid) {
+    if (idx[nid].source->is_variable()) continue;
+    for (const auto& e : idx[nid].inputs) {
+      const uint32_t eid = idx.entry_id(e);
+      if (!releasable[eid]) continue;
+      if (op_nodes_[nid].skip_exec_node) {
+        // read through a node which does not run, keep it to the end
+        releasable[eid] = false;
+      } else {
+        last_use[eid] = nid;
+      }
+    }
+  }
+  release_entries_.assign(idx.num_nodes(), std::vector<uint32_t>());
+  release_arrays_.assign(idx.num_nodes(), std::vector<HeldArray>());
+  for (uint32_t eid = 0; eid < last_use.size(); ++eid) {
+    if (releasable[eid] && last_use[eid] >= 0) release_entries_[last_use[eid]].push_back(eid);
+  }
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const OpNode& opnode = op_nodes_[nid];
+    if (idx[nid].source->is_variable() || opnode.skip_exec_node) continue;
+    for (uint32_t i = 0; i < idx[nid].inputs.size(); ++i) {
+      const uint32_t eid = idx.entry_id(idx[nid].inputs[i]);
+      if (releasable[eid] && last_use[eid] >= 0) {
+        release_arrays_[last_use[eid]].push_back(HeldArray{opnode.exec, false, i});
+      }
+    }
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      if (releasable[eid] && last_use[eid] >= 0) {
+        release_arrays_[last_use[eid]].push_back(HeldArray{opnode.exec, true, i});
+      }
+    }
+  }
+}
+
+void GraphExecutor::ReleaseForwardEntries(size_t topo_start, size_t topo_end) {
+  if (release_entries_.empty()) return;
+  std::vector<Engine::VarHandle> use_vars, mutate_vars;
+  std::vector<HeldArray> held;
+  for (size_t nid = topo_start; nid < topo_end; ++nid) {
+    for (uint32_t eid : release_entries_[nid]) {
+      mutate_vars.push_back(data_entry_[eid].var());
+      data_entry_[eid] = NDArray();
+    }
+    held.insert(held.end(), release_arrays_[nid].begin(), release_arrays_[nid].end());
+  }
+  if (mutate_vars.empty()) return;
+  Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
+  // writing the entries orders the release after all the operators reading
+  // them, the memory is freed with the last reference to each array
+  Engine::Get()->PushSync([held](RunContext rctx) {
+      for (const auto& h : held) {
+        (h.output ? h.exec->out_array : h.exec->in_array)[h.index] = NDArray();
+      }
+    }, Context::CPU(), use_vars, mutate_vars, FnProperty::kNormal, 0,
+    PROFILER_MESSAGE("ReleaseForwardEntries"));
+}
+
+void GraphExecutor::FoldConstants() {
+  if (constant_nodes_.empty() || constants_folded_) return;
+  constants_folded_ = true;
+  const auto& idx = graph_.indexed_graph();
+  for (size_t nid = 0; nid < num_forward_nodes_; ++nid) {
+    OpNode& opnode = op_nodes_[nid];
+    if (!opnode.constant || opnode.skip_exec_node) continue;
+    opnode.exec->op_ctx.is_train = false;
+    if (opnode.exec->exec_type() == ExecType::kCrossDeviceCopy) {
+      CHECK_EQ(idx[nid].inputs.size(), 1U);
+      CopyFromTo(opnode.exec->in_array[0], &(opnode.exec->out_array[0]));
+    } else if (opnode.exec->exec_type() == ExecType::kLocal) {
+      bool is_gpu = opnode.ctx.dev_mask() == gpu::kDevMask;
+      opnode.exec->Run(RunContext{opnode.ctx, nullptr}, is_gpu);
+    } else {
+#if MXNET_USE_PROFILER
+      bool profiling = engine::Profiler::Get()->GetState() == engine::Profiler::kRunning;
+#else
+      bool profiling = false;
+#endif
+      Engine::Get()->Push(opnode.cached_opr, opnode.ctx, 0, profiling);
+    }
+    if (monitor_callback_) {
+      ExecuteMonCallback(nid);
+    }
+  }
+}
+
+void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end,
+                           const engine::CancelToken& token) {
   // Update context
   const auto& idx = graph_.indexed_graph();
   for (size_t nid = topo_start; nid < topo_end; ++nid) {
     OpNode& opnode = op_nodes_[nid];
-    if (opnode.skip_exec_node) continue;
+    if (opnode.skip_exec_node || opnode.constant) continue;
     const auto& inode = idx[nid];
     if (inode.source->is_variable()) continue;
     opnode.exec->op_ctx.is_train = is_train;
@@ -1439,7 +2364,15 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
 #else
       bool profiling = false;
 #endif
-      Engine::Get()->Push(seg_op.opr, seg_op.ctx, 0, profiling);
+      if (token) {
+        // the cached operators cannot carry a token, push their functions instead
+        Engine::Get()->PushAsyncCancellable(seg_op.fn, seg_op.ctx, seg_op.use_vars,
+                                            seg_op.mutate_vars, token, FnProperty::kNormal, 0,
+                                            PROFILER_MESSAGE("BulkExecution"));
+      } else {
+        Engine::Get()->Push(seg_op.opr, seg_op.ctx, 0, profiling);
+      }
+      ReleaseForwardEntries(nid, seg_op.topo_end);
       nid = seg_op.topo_end - 1;
       continue;
     }
@@ -1447,7 +2380,7 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
     const auto& inode = idx[nid];
     if (inode.source->is_variable()) continue;
     OpNode& opnode = op_nodes_[nid];
-    if (op_nodes_[nid].skip_exec_node) continue;
+    if (op_nodes_[nid].skip_exec_node || op_nodes_[nid].constant) continue;
     opnode.exec->op_ctx.is_train = is_train;
     if (opnode.exec->exec_type() == ExecType::kCrossDeviceCopy) {
       CHECK_EQ(inode.inputs.size(), 1U);
@@ -1463,7 +2396,13 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
 #else
       bool profiling = false;
 #endif
-      Engine::Get()->Push(opnode.cached_opr, opnode.ctx, 0, profiling);
+      if (token) {
+        Engine::Get()->PushAsyncCancellable(opnode.cached_fn, opnode.ctx, opnode.use_vars,
+                                            opnode.mutate_vars, token, FnProperty::kNormal, 0,
+                                            PROFILER_MESSAGE(opnode.opr_name));
+      } else {
+        Engine::Get()->Push(opnode.cached_opr, opnode.ctx, 0, profiling);
+      }
     } else {
       LOG(FATAL) << "Not accessed";
     }
@@ -1471,9 +2410,103 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
     if (monitor_callback_) {
       ExecuteMonCallback(nid);
     }
+    ReleaseForwardEntries(nid, nid + 1);
   }
 }
 
+#if MXNET_USE_CUDA && CUDART_VERSION >= 10000
+/*!
+ * \brief The kernels of a bulk segment captured in CUDA graphs, one for each
+ *  value of is_train, and replayed instead of launching every kernel.
+ *
+ *  The segment first runs normally kWarmupRuns times, so that the cuDNN
+ *  algorithms are chosen and the temporary spaces are allocated before the
+ *  capture. A graph is captured again when a temporary space has moved since
+ *  its capture. When the capture fails, e.g. because an operator copies to
+ *  the host, the segment keeps running normally.
+ */
+class CudaGraphCache {
+ public:
+  explicit CudaGraphCache(const std::vector<std::shared_ptr<OpExecutor> >& exec_list)
+      : exec_list_(exec_list) {}
+  ~CudaGraphCache() {
+    for (auto& graph : graphs_) Reset(&graph);
+  }
+  /*! \brief whether the operators of a segment can be captured */
+  static bool Capturable(const std::vector<std::shared_ptr<OpExecutor> >& exec_list) {
+    for (const auto& exec : exec_list) {
+      for (const auto& r : exec->op_ctx.requested) {
+        // random generators keep their state on the host
+        if (r.req.type != ResourceRequest::kTempSpace) return false;
+      }
+    }
+    return true;
+  }
+  /*! \brief run the segment on the stream of ctx */
+  void Run(RunContext ctx, bool is_train) {
+    Captured* graph = &graphs_[is_train ? 1 : 0];
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(ctx.get_stream<gpu>());
+    if (graph->exec != nullptr && graph->spaces != TempSpaces()) Reset(graph);
+    if (graph->exec == nullptr && !failed_ && ++graph->runs > kWarmupRuns) {
+      Capture(ctx, stream, graph);
+    }
+    if (graph->exec != nullptr) {
+      CUDA_CALL(cudaGraphLaunch(graph->exec, stream));
+    } else {
+      for (auto& exec : exec_list_) exec->Run(ctx, true);
+    }
+  }
+
+ private:
+  /*! \brief number of normal runs before the capture */
+  static const int kWarmupRuns = 2;
+  struct Captured {
+    cudaGraphExec_t exec = nullptr;
+    // the temporary spaces used by the captured kernels
+    std::vector<void*> spaces;
+    int runs = 0;
+  };
+  std::vector<void*> TempSpaces() const {
+    std::vector<void*> ret;
+    for (const auto& exec : exec_list_) {
+      for (const auto& r : exec->op_ctx.requested) ret.push_back(r.get_space_internal(0));
+    }
+    return ret;
+  }
+  void Capture(RunContext ctx, cudaStream_t stream, Captured* graph) {
+    cudaGraph_t captured = nullptr;
+#if CUDART_VERSION >= 10010
+    CUDA_CALL(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+#else
+    CUDA_CALL(cudaStreamBeginCapture(stream));
+#endif
+    for (auto& exec : exec_list_) exec->Run(ctx, true);
+    cudaError_t err = cudaStreamEndCapture(stream, &captured);
+    if (err == cudaSuccess) {
+      err = cudaGraphInstantiate(&graph->exec, captured, nullptr, nullptr, 0);
+    }
+    if (captured != nullptr) cudaGraphDestroy(captured);
+    if (err != cudaSuccess) {
+      // clear the error of the failed capture
+      cudaGetLastError();
+      graph->exec = nullptr;
+      failed_ = true;
+      LOG(INFO) << "Cannot capture a segment into a CUDA graph: " << cudaGetErrorString(err);
+      return;
+    }
+    graph->spaces = TempSpaces();
+  }
+  static void Reset(Captured* graph) {
+    if (graph->exec != nullptr) cudaGraphExecDestroy(graph->exec);
+    graph->exec = nullptr;
+    graph->runs = 0;
+  }
+  std::vector<std::shared_ptr<OpExecutor> > exec_list_;
+  Captured graphs_[2];
+  bool failed_ = false;
+};
+#endif  // MXNET_USE_CUDA && CUDART_VERSION >= 10000
+
 GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start, size_t topo_end) {
   std::vector<Engine::VarHandle> use_vars;
   std::vector<Engine::VarHandle> mutate_vars;
@@ -1497,7 +2530,7 @@ GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start,
     std::vector<Engine::VarHandle> all_vars;
     const auto& inode = idx[nid];
     OpNode& op_node = op_nodes_[nid];
-    if (op_node.skip_exec_node) continue;
+    if (op_node.skip_exec_node || op_node.constant) continue;
     if (inode.source->is_variable()) continue;
     if (op_node.exec->exec_type() != ExecType::kSync) {
       return ret;
@@ -1522,12 +2555,29 @@ GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start,
   Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
 
   bool is_gpu = pctx->dev_mask() == gpu::kDevMask;
+#if MXNET_USE_CUDA && CUDART_VERSION >= 10000
+  std::shared_ptr<CudaGraphCache> cuda_graphs;
+  if (is_gpu && dmlc::GetEnv("MXNET_EXEC_ENABLE_CUDA_GRAPHS", false) &&
+      CudaGraphCache::Capturable(exec_list)) {
+    cuda_graphs = std::make_shared<CudaGraphCache>(exec_list);
+  }
+  auto exec_fun = [exec_list, is_gpu, cuda_graphs] (
+      RunContext ctx, Engine::CallbackOnComplete on_complete) {
+    if (cuda_graphs != nullptr) {
+      cuda_graphs->Run(ctx, exec_list[0]->op_ctx.is_train);
+    } else {
+      for (auto &exec : exec_list) {
+        exec->Run(ctx, is_gpu);
+      }
+    }
+#else
   auto exec_fun = [exec_list, is_gpu] (
       RunContext ctx, Engine::CallbackOnComplete on_complete) {
     // Run all opr in the sub-graph
     for (auto &exec : exec_list) {
       exec->Run(ctx, is_gpu);
     }
+#endif
     if (is_gpu) {
 #if MXNET_USE_CUDA
       // Wait GPU kernel to finish.
@@ -1549,6 +2599,9 @@ GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start,
   ret.opr = Engine::Get()->NewOperator(
       exec_fun, use_vars, mutate_vars, FnProperty::kNormal,
       PROFILER_MESSAGE(p_opr_name));
+  ret.fn = exec_fun;
+  ret.use_vars = use_vars;
+  ret.mutate_vars = mutate_vars;
   return ret;
 }
 }  // namespace exec
@@ -62,6 +62,7 @@ class GraphExecutor : public Executor {
   GraphExecutor();
   virtual ~GraphExecutor();
   void Forward(bool is_train) override;
+  void Forward(bool is_train, const engine::CancelToken& token) override;
   void PartialForward(bool is_train, int step, int *step_left) override;
   void Backward(const std::vector<NDArray> &head_grads, bool is_train = true) override;
   const std::vector<NDArray>& outputs() const override;
@@ -69,7 +70,23 @@ class GraphExecutor : public Executor {
   const std::unordered_map<std::string, NDArray>& arg_grad_map() const override;
   const std::unordered_map<std::string, NDArray>& aux_state_map() const override;
   void Print(std::ostream &os) const override; // NOLINT(*)
+  void GetMemoryPlan(std::vector<MemoryPlanEntry>* entries,
+                     std::vector<MemoryPlanTotal>* totals) const override;
   void SetMonitorCallback(const MonitorCallback& callback) override;
+  NDArray NextInput(const std::string& name) override;
+  // Drop the operators and the arrays bound from outside, keeping the graph,
+  // its memory plan and the allocated data entries so that the executor
+  // can be bound again with Rebind.
+  void ReleaseArrays();
+  // Bind new arrays to an executor released by ReleaseArrays. The arrays
+  // must have the shapes, types and storage types of the ones bound before.
+  // feed_entries and node_states are indexed by entry id and node id.
+  void Rebind(const std::vector<NDArray>& in_args,
+              const std::vector<NDArray>& arg_grad_store,
+              const std::vector<OpReqType>& grad_req_types,
+              const std::vector<NDArray>& aux_states,
+              const std::unordered_map<uint32_t, NDArray>& feed_entries,
+              const std::unordered_map<uint32_t, OpStatePtr>& node_states);
   // Initialize the rest of attributes
   // after setting up arguments.
   void FinishInitGraph(nnvm::Symbol symbol, nnvm::Graph g,
@@ -119,8 +136,12 @@ class GraphExecutor : public Executor {
     std::shared_ptr<OpExecutor> exec;
     // skip the execution of this node
     bool skip_exec_node{false};
+    // computed from the parameters only, run once by FoldConstants
+    bool constant{false};
     // cached operator handle
     Engine::OprHandle cached_opr{nullptr};
+    // function of the cached operator, pushed directly when cancellable
+    Engine::AsyncFn cached_fn;
     // cached const vars, used for seg ops creation
     std::vector<Engine::VarHandle> use_vars;
     // cached mutate vars, used for seg ops creation
@@ -136,9 +157,19 @@ class GraphExecutor : public Executor {
     size_t topo_end;
     // the cached operator
     Engine::OprHandle opr = nullptr;
+    // function and variables of the cached operator, pushed directly when cancellable
+    Engine::AsyncFn fn;
+    std::vector<Engine::VarHandle> use_vars, mutate_vars;
     // list of op executors
     std::vector<std::shared_ptr<OpExecutor> > exec_list;
   };
+  // an array of an operator executor holding a released forward entry
+  struct HeldArray {
+    std::shared_ptr<OpExecutor> exec;
+    // whether it is in out_array rather than in_array
+    bool output;
+    uint32_t index;
+  };
   // Initialize in_args, arg_grads, and aux_states
   void InitArguments(const nnvm::IndexedGraph& idx,
                      const nnvm::ShapeVector& inferred_shapes,
@@ -174,20 +205,33 @@ class GraphExecutor : public Executor {
                   const std::vector<Context>& in_arg_ctxes,
                   const std::vector<Context>& arg_grad_ctxes,
                   const std::vector<Context>& aux_state_ctxes,
-                  const std::vector<OpReqType>& grad_req_types);
-  // intialize the full graph for simple bind, including gradient
+                  const std::vector<OpReqType>& grad_req_types,
+                  const std::unordered_map<std::string, TShape>& arg_shape_map,
+                  const std::unordered_map<std::string, int>& arg_dtype_map,
+                  const std::unordered_set<std::string>& param_names
+                    = std::unordered_set<std::string>());
+  // intialize the full graph for simple bind, including gradient.
+  // The known shapes and types of the inputs are used to plan the mirroring.
   Graph InitFullGraph(nnvm::Symbol symbol,
-                      const std::vector<OpReqType>& grad_req_types);
+                      const std::vector<OpReqType>& grad_req_types,
+                      const std::unordered_map<std::string, TShape>& arg_shape_map,
+                      const std::unordered_map<std::string, int>& arg_dtype_map);
   // initialize the cached operator
   void InitCachedOps();
   // initialize the opr segments for bulk exec
   void InitOpSegs();
+  // print the storage blocks alive at the peak of the memory plan, the
+  // largest first, with the node outputs sharing each of them
+  void PrintMemoryPlan(std::ostream &os) const;  // NOLINT(*)
   // initialize the resources in the graph
   // initialize the memory of data entries
   // shared_pool: extra memory shared from other parts
   void InitDataEntryMemory(std::vector<NDArray>* shared_pool);
+  // run the constant nodes, the first time the graph runs after a bind
+  void FoldConstants();
   // run ops from topo order start to end
-  void RunOps(bool is_train, size_t topo_start, size_t topo_end);
+  void RunOps(bool is_train, size_t topo_start, size_t topo_end,
+              const engine::CancelToken& token = engine::CancelToken());
   /*!
    * \brief Try to create a cached operator to run segments between start and end
    * \param topo_start beginning of segment
@@ -198,6 +242,14 @@ class GraphExecutor : public Executor {
   CachedSegOpr CreateCachedSegOpr(size_t topo_start, size_t topo_end);
   // run the monitor callback for node `nid`
   void ExecuteMonCallback(size_t nid);
+  // find the last backward node reading each forward entry, for
+  // release_forward_entries_
+  void PlanForwardRelease();
+  // release the forward entries read for the last time by the nodes from
+  // topo_start to topo_end, once these nodes have run
+  void ReleaseForwardEntries(size_t topo_start, size_t topo_end);
+  // exchange the memory of the inputs given by NextInput with their arguments
+  void SwapNextInputs();
 
   // internal graph
   nnvm::Graph graph_;
@@ -232,6 +284,30 @@ class GraphExecutor : public Executor {
   size_t num_forward_nodes_{0};
   // saved operator for autograd
   std::unordered_map<const nnvm::Node*, OpStatePtr> saved_states_;
+  // allocate every backward output separately, for autograd recording the backward pass
+  bool keep_backward_outputs_{false};
+  // release every forward entry after its last backward reader has run, set
+  // by autograd when the recorded graph is not retained
+  bool release_forward_entries_{false};
+  // per node, the forward entries it reads for the last time in Backward
+  std::vector<std::vector<uint32_t> > release_entries_;
+  // per node, the executor arrays holding the entries of release_entries_
+  std::vector<std::vector<HeldArray> > release_arrays_;
+  // second buffers of the input arguments, created by NextInput
+  std::unordered_map<std::string, NDArray> next_inputs_;
+  // arguments whose second buffer is swapped in by the next forward
+  std::vector<std::string> pending_inputs_;
+  // nodes computed from the parameters only, empty when constant folding is off
+  std::vector<bool> constant_nodes_;
+  // entries computed by the constant nodes and read by the other nodes
+  std::unordered_set<uint32_t> constant_entries_;
+  // whether the constant nodes have run since the arrays were bound
+  bool constants_folded_{false};
+  // nodes not run because their outputs or inputs are views of each other,
+  // such as a Concat written by its inputs or slices of an array
+  std::unordered_set<uint32_t> view_nodes_;
+  // entries of these nodes, their arrays are kept over ReleaseArrays
+  std::unordered_set<uint32_t> view_entries_;
   // monitor call back
   std::function<void(const char*, void*)> monitor_callback_{nullptr};
   // whether to enable bulk execution
@@ -57,6 +57,8 @@ Graph DetectInplaceAddTo(Graph g) {
     if (inode.source->op() != ewise_plus_op) continue;
     int sid = storage_id[idx.entry_id(inode.inputs[0])];
     if (sid != storage_id[idx.entry_id(nid, 0)]) continue;
+    // arrays bound from outside are never shared
+    if (sid == kExternalStorageID) continue;
     if (idx[inode.inputs[0].node_id].source->is_variable()) continue;
     if (idx[inode.inputs[1].node_id].source->is_variable()) continue;
     uint32_t eid_rhs  = idx.entry_id(inode.inputs[1]);
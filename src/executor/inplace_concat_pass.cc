@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file inplace_concat_pass.cc
+ * \brief Find the Concat operators whose inputs can be written into their output.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <cstdlib>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+std::vector<uint32_t> DetectInplaceConcat(const Graph& g, const nnvm::StorageVector& storage) {
+  static const Op* concat_op = Op::Get("Concat");
+  const auto& idx = g.indexed_graph();
+  const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& vctx = g.GetAttr<ContextVector>("context");
+  const auto& vstype = g.GetAttr<StorageTypeVector>("storage_type");
+  // whether the entry is already placed in the output of a Concat
+  std::vector<bool> claimed(idx.num_node_entries(), false);
+  std::vector<uint32_t> ret;
+
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->op() != concat_op) continue;
+    const uint32_t out = idx.entry_id(nid, 0);
+    const TShape& oshape = vshape[out];
+    if (storage[out] != kBadStorageID || vstype[out] != kDefaultStorage ||
+        oshape.ndim() == 0) continue;
+    const auto& dict = inode.source->attrs.dict;
+    auto it = dict.find("dim");
+    int dim = it == dict.end() ? 1 : std::atoi(it->second.c_str());
+    if (dim < 0) dim += oshape.ndim();
+    // the inputs are contiguous blocks of the output only when all the axes
+    // before dim are 1
+    size_t outer = 1;
+    for (int i = 0; i < dim; ++i) outer *= oshape[i];
+    if (outer != 1) continue;
+
+    bool ok = true;
+    std::vector<uint32_t> inputs;
+    for (const auto& e : inode.inputs) {
+      const uint32_t eid = idx.entry_id(e);
+      // arguments are bound from outside, they would have to be copied anyway
+      if (idx[e.node_id].source->is_variable() || claimed[eid] ||
+          storage[eid] != kBadStorageID || vstype[eid] != kDefaultStorage ||
+          vdtype[eid] != vdtype[out] || vctx[e.node_id] != vctx[nid]) {
+        ok = false;
+        break;
+      }
+      claimed[eid] = true;
+      inputs.push_back(eid);
+    }
+    if (!ok) {
+      for (uint32_t eid : inputs) claimed[eid] = false;
+      continue;
+    }
+    ret.push_back(nid);
+  }
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
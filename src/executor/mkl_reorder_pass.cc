@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file mkl_reorder_pass.cc
+ * \brief Count the layout reorders between the MKL operators and the others.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph_attr_types.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+/*! \brief value of an attribute, or the default when it is not set */
+inline std::string GetDictAttr(const nnvm::NodeAttrs& attrs, const std::string& key,
+                               const std::string& default_value) {
+  auto it = attrs.dict.find(key);
+  return it == attrs.dict.end() ? default_value : it->second;
+}
+
+/*! \brief the values of a tuple attribute such as "(3, 3)" */
+std::vector<int> GetTupleAttr(const nnvm::NodeAttrs& attrs, const std::string& key) {
+  std::string value = GetDictAttr(attrs, key, "()");
+  for (char& c : value) {
+    if (c == '(' || c == ')' || c == '[' || c == ']' || c == ',') c = ' ';
+  }
+  std::istringstream is(value);
+  std::vector<int> ret;
+  int v;
+  while (is >> v) ret.push_back(v);
+  return ret;
+}
+
+/*!
+ * \brief whether CreateOp<cpu> of a node picks its MKL2017 implementation,
+ *  which keeps its outputs in the internal layout of MKL.
+ *  The backward node of an operator follows its forward node.
+ * \param attrs the attributes of the node
+ * \param data_shape the shape of the first input of the forward node
+ * \param dtype the type of the first input of the forward node
+ */
+bool IsMKLNode(const nnvm::NodeAttrs& attrs, const TShape& data_shape, int dtype) {
+  if (dtype != mshadow::kFloat32 && dtype != mshadow::kFloat64) return false;
+  std::string name = attrs.op->name;
+  const std::string backward_prefix = "_backward_";
+  if (name.compare(0, backward_prefix.size(), backward_prefix) == 0) {
+    name = name.substr(backward_prefix.size());
+  }
+  if (name == "Convolution") {
+    const std::vector<int> dilate = GetTupleAttr(attrs, "dilate");
+    for (int d : dilate) {
+      if (d != 1) return false;
+    }
+    return GetTupleAttr(attrs, "kernel").size() == 2U;
+  }
+  if (name == "Pooling") {
+    const std::string pool_type = GetDictAttr(attrs, "pool_type", "max");
+    return GetTupleAttr(attrs, "kernel").size() == 2U &&
+        GetDictAttr(attrs, "pooling_convention", "valid") == "valid" &&
+        (pool_type == "max" || pool_type == "avg");
+  }
+  if (name == "Activation") {
+    return GetDictAttr(attrs, "act_type", "") == "relu" && data_shape.ndim() <= 4U;
+  }
+  if (name == "BatchNorm") {
+    return data_shape.ndim() == 4U && GetDictAttr(attrs, "axis", "1") == "1";
+  }
+  if (name == "Concat") return GetDictAttr(attrs, "dim", "1") == "1";
+  return name == "LRN";
+}
+}  // namespace
+
+size_t CountMKLReorders(const Graph& g, std::vector<uint32_t>* reorder_entries) {
+  const auto& idx = g.indexed_graph();
+  const auto& shapes = g.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& contexts = g.GetAttr<ContextVector>("context");
+  const uint32_t num_nodes = idx.num_nodes();
+  std::vector<bool> is_mkl(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable() || inode.inputs.size() == 0U ||
+        contexts[nid].dev_mask() != cpu::kDevMask) {
+      continue;
+    }
+    // the data of a backward node is the one of its forward node
+    const uint32_t fwd_nid = inode.control_deps.size() == 1U &&
+        !idx[inode.control_deps[0]].source->is_variable() ?
+        inode.control_deps[0] : nid;
+    const uint32_t data_eid = idx.entry_id(idx[fwd_nid].inputs[0]);
+    is_mkl[nid] = IsMKLNode(inode.source->attrs, shapes[data_eid], dtypes[data_eid]);
+  }
+  // an entry is reordered once from the plain layout when a MKL node reads the
+  // output of another node, and once back when a MKL output is read by another
+  // node or is an output of the graph
+  std::vector<bool> read_by_mkl(idx.num_node_entries(), false);
+  std::vector<bool> read_by_other(idx.num_node_entries(), false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (const auto& e : idx[nid].inputs) {
+      if (is_mkl[nid]) {
+        read_by_mkl[idx.entry_id(e)] = true;
+      } else {
+        read_by_other[idx.entry_id(e)] = true;
+      }
+    }
+  }
+  for (const auto& e : idx.outputs()) read_by_other[idx.entry_id(e)] = true;
+  size_t count = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      if (is_mkl[nid] ? read_by_other[eid] : read_by_mkl[eid]) {
+        ++count;
+        if (reorder_entries != nullptr) reorder_entries->push_back(eid);
+      }
+    }
+  }
+  return count;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file nhwc_layout_pass.cc
+ * \brief Run the convolutions, poolings and batch normalizations of a graph in NHWC.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph_attr_types.h>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+/*! \brief value of an attribute, or the default when it is not set */
+inline std::string GetDictAttr(const nnvm::NodeAttrs& attrs, const std::string& key,
+                               const std::string& default_value) {
+  auto it = attrs.dict.find(key);
+  return it == attrs.dict.end() ? default_value : it->second;
+}
+
+/*! \brief whether the node has a 2D kernel and the default layout */
+bool Is2DNCHW(const nnvm::NodeAttrs& attrs) {
+  TShape kernel;
+  std::istringstream is(GetDictAttr(attrs, "kernel", "()"));
+  is >> kernel;
+  const std::string layout = GetDictAttr(attrs, "layout", "None");
+  const std::string cudnn_off = GetDictAttr(attrs, "cudnn_off", "False");
+  return kernel.ndim() == 2U && (layout == "None" || layout == "NCHW") &&
+      cudnn_off != "True" && cudnn_off != "true" && cudnn_off != "1";
+}
+}  // namespace
+
+Graph ConvertLayoutNHWC(Graph g) {
+  using nnvm::NodePtr;
+  using nnvm::NodeEntry;
+  static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+  static const nnvm::Op* pool_op = nnvm::Op::Get("Pooling");
+  static const nnvm::Op* bn_op = nnvm::Op::Get("BatchNorm");
+  static const nnvm::Op* act_op = nnvm::Op::Get("Activation");
+  static const nnvm::Op* add_op = nnvm::Op::Get("elemwise_add");
+  static const nnvm::Op* add_n_op = nnvm::Op::Get("add_n");
+  static const nnvm::Op* transpose_op = nnvm::Op::Get("transpose");
+  const auto& idx = g.indexed_graph();
+  const uint32_t num_nodes = idx.num_nodes();
+
+  // nodes run in NHWC. The layout follows the BatchNorm and the elementwise
+  // operators reading NHWC entries only, the mean and variance outputs of
+  // BatchNorm have no layout.
+  std::vector<bool> nhwc(num_nodes, false);
+  auto nhwc_entry = [&](const nnvm::IndexedGraph::NodeEntry& e) {
+    return nhwc[e.node_id] && (idx[e.node_id].source->op() != bn_op || e.index == 0);
+  };
+  bool any_nhwc = false;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    const nnvm::Node* node = inode.source;
+    if (node->is_variable()) continue;
+    const nnvm::Op* op = node->op();
+    if (op == conv_op) {
+      nhwc[nid] = Is2DNCHW(node->attrs) && GetDictAttr(node->attrs, "num_group", "1") == "1";
+    } else if (op == pool_op) {
+      nhwc[nid] = Is2DNCHW(node->attrs) && GetDictAttr(node->attrs, "pool_type", "") != "sum";
+    } else if (op == bn_op) {
+      nhwc[nid] = GetDictAttr(node->attrs, "axis", "1") == "1" && nhwc_entry(inode.inputs[0]);
+    } else if (op == act_op || op == add_op || op == add_n_op) {
+      bool all_nhwc = inode.inputs.size() != 0U;
+      for (const auto& e : inode.inputs) all_nhwc = all_nhwc && nhwc_entry(e);
+      nhwc[nid] = all_nhwc;
+    }
+    any_nhwc = any_nhwc || nhwc[nid];
+  }
+  if (!any_nhwc) return g;
+
+  // copy the operator nodes, so that the nodes of the symbol are left intact.
+  // The variables are kept, as the executor identifies them by address.
+  std::vector<NodePtr> new_nodes(num_nodes);
+  // the transposed copy of every entry, at most one in each direction
+  std::unordered_map<uint32_t, NodeEntry> to_nhwc, to_nchw;
+  auto transpose = [&](const NodeEntry& e, bool nchw_to_nhwc) {
+    NodePtr n = nnvm::Node::Create();
+    n->attrs.op = transpose_op;
+    n->attrs.name = e.node->attrs.name + (nchw_to_nhwc ? "_nhwc" : "_nchw");
+    n->attrs.dict["axes"] = nchw_to_nhwc ? "(0, 2, 3, 1)" : "(0, 3, 1, 2)";
+    transpose_op->attr_parser(&(n->attrs));
+    n->inputs.push_back(e);
+    return NodeEntry{n, 0, 0};
+  };
+  // the entry e read by a node, in NHWC when to_layout_nhwc is set
+  auto map_entry = [&](const NodeEntry& e, bool to_layout_nhwc) {
+    const uint32_t nid = idx.node_id(e.node.get());
+    const uint32_t eid = idx.entry_id(nid, e.index);
+    NodeEntry ret{new_nodes[nid], e.index, e.version};
+    const bool is_nhwc = nhwc_entry(nnvm::IndexedGraph::NodeEntry{nid, e.index, e.version});
+    if (to_layout_nhwc && !is_nhwc) {
+      if (!to_nhwc.count(eid)) to_nhwc[eid] = transpose(ret, true);
+      return to_nhwc[eid];
+    }
+    if (!to_layout_nhwc && is_nhwc) {
+      if (!to_nchw.count(eid)) to_nchw[eid] = transpose(ret, false);
+      return to_nchw[eid];
+    }
+    return ret;
+  };
+  nnvm::DFSVisit(g.outputs, [&](const NodePtr& node) {
+    const uint32_t nid = idx.node_id(node.get());
+    if (node->is_variable()) {
+      new_nodes[nid] = node;
+      return;
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = node->attrs;
+    // inputs with a layout: the data of all, and the weight of a convolution,
+    // whose NHWC form is (num_filter, y, x, channel)
+    const nnvm::Op* op = node->op();
+    size_t num_layout_inputs = 1;
+    if (op == conv_op) num_layout_inputs = 2;
+    if (op == act_op || op == add_op || op == add_n_op) num_layout_inputs = node->inputs.size();
+    for (size_t i = 0; i < node->inputs.size(); ++i) {
+      n->inputs.push_back(map_entry(node->inputs[i], nhwc[nid] && i < num_layout_inputs));
+    }
+    for (const auto& dep : node->control_deps) {
+      n->control_deps.push_back(new_nodes[idx.node_id(dep.get())]);
+    }
+    if (nhwc[nid] && (op == conv_op || op == pool_op || op == bn_op)) {
+      if (op == bn_op) {
+        n->attrs.dict["axis"] = "3";
+      } else {
+        n->attrs.dict["layout"] = "NHWC";
+      }
+      op->attr_parser(&(n->attrs));
+    }
+    new_nodes[nid] = n;
+  });
+  Graph ret;
+  for (const auto& e : g.outputs) ret.outputs.push_back(map_entry(e, false));
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -0,0 +1,231 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file pointwise_fusion_pass.cc
+ * \brief Fuse groups of pointwise operators into one runtime compiled kernel.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+/*! \brief the scalar parameter of a node as a literal */
+inline std::string ScalarLiteral(const nnvm::NodeAttrs& attrs) {
+  auto it = attrs.dict.find("scalar");
+  CHECK(it != attrs.dict.end()) << "scalar is missing in operator " << attrs.name;
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<double>::max_digits10)
+     << std::stod(it->second);
+  return "DType(" + os.str() + ")";
+}
+
+/*!
+ * \brief the CUDA expression computing a pointwise node
+ * \param attrs the attributes of the node
+ * \param args the expressions of the inputs of the node
+ * \param expr the expression of the node
+ * \return false if the node cannot be fused
+ */
+bool PointwiseExpr(const nnvm::NodeAttrs& attrs,
+                   const std::vector<std::string>& args,
+                   std::string* expr) {
+  static const std::unordered_map<std::string, std::string> binary = {
+    {"elemwise_add", "(a + b)"}, {"_sub", "(a - b)"}, {"_mul", "(a * b)"},
+    {"_div", "(a / b)"}};
+  static const std::unordered_map<std::string, std::string> unary = {
+    {"negative", "(-a)"}, {"abs", "fabs(a)"}, {"square", "(a * a)"},
+    {"sqrt", "sqrt(a)"}, {"exp", "exp(a)"}, {"log", "log(a)"},
+    {"relu", "(a > DType(0) ? a : DType(0))"},
+    {"sigmoid", "(DType(1) / (DType(1) + exp(-a)))"}, {"tanh", "tanh(a)"}};
+  static const std::unordered_map<std::string, std::string> scalar = {
+    {"_plus_scalar", "(a + s)"}, {"_minus_scalar", "(a - s)"},
+    {"_rminus_scalar", "(s - a)"}, {"_mul_scalar", "(a * s)"},
+    {"_div_scalar", "(a / s)"}, {"_rdiv_scalar", "(s / a)"}};
+  static const std::unordered_map<std::string, std::string> activation = {
+    {"relu", "(a > DType(0) ? a : DType(0))"},
+    {"sigmoid", "(DType(1) / (DType(1) + exp(-a)))"}, {"tanh", "tanh(a)"},
+    {"softrelu", "(a > DType(20) ? a : log1p(exp(a)))"}};
+  const std::string& name = attrs.op->name;
+  std::string tmpl;
+  if (binary.count(name)) {
+    if (args.size() != 2) return false;
+    tmpl = binary.at(name);
+  } else if (unary.count(name)) {
+    if (args.size() != 1) return false;
+    tmpl = unary.at(name);
+  } else if (scalar.count(name)) {
+    if (args.size() != 1) return false;
+    tmpl = scalar.at(name);
+  } else if (name == "Activation") {
+    auto it = attrs.dict.find("act_type");
+    if (args.size() != 1 || it == attrs.dict.end() || !activation.count(it->second)) {
+      return false;
+    }
+    tmpl = activation.at(it->second);
+  } else {
+    return false;
+  }
+  expr->clear();
+  for (char c : tmpl) {
+    if (c == 'a') {
+      *expr += args[0];
+    } else if (c == 'b') {
+      *expr += args[1];
+    } else if (c == 's') {
+      *expr += ScalarLiteral(attrs);
+    } else {
+      *expr += c;
+    }
+  }
+  return true;
+}
+
+/*! \brief whether a node is a pointwise operator that can be fused */
+bool IsPointwise(const nnvm::IndexedGraph::Node& inode) {
+  if (inode.source->is_variable() || inode.source->num_outputs() != 1 ||
+      inode.control_deps.size() != 0U) {
+    return false;
+  }
+  std::vector<std::string> args(inode.inputs.size(), "x");
+  std::string expr;
+  return PointwiseExpr(inode.source->attrs, args, &expr);
+}
+}  // namespace
+
+Graph FusePointwise(Graph g, size_t num_forward_outputs) {
+  using nnvm::NodePtr;
+  using nnvm::NodeEntry;
+  static const nnvm::Op* fused_op = nnvm::Op::Get("_FusedPointwise");
+  const auto& idx = g.indexed_graph();
+  const uint32_t num_nodes = idx.num_nodes();
+  size_t num_forward_nodes = 0;
+  for (size_t i = 0; i < num_forward_outputs; ++i) {
+    num_forward_nodes = std::max(num_forward_nodes,
+                                 static_cast<size_t>(idx.outputs()[i].node_id + 1));
+  }
+  // number of uses of every entry, and nodes other nodes depend on
+  std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+  std::vector<bool> control_target(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (const auto& e : idx[nid].inputs) ++ref_count[idx.entry_id(e)];
+    for (uint32_t dep : idx[nid].control_deps) control_target[dep] = true;
+  }
+  for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+
+  std::vector<bool> pointwise(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    pointwise[nid] = !control_target[nid] && IsPointwise(idx[nid]);
+  }
+  // a pointwise node is merged into its consumer when that is its only use.
+  // Every group is a tree whose root produces the output of the group.
+  std::vector<bool> internal(num_nodes, false);
+  std::vector<bool> root(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!pointwise[nid]) continue;
+    for (const auto& e : idx[nid].inputs) {
+      if (pointwise[e.node_id] && ref_count[idx.entry_id(e)] == 1 &&
+          (e.node_id < num_forward_nodes) == (nid < num_forward_nodes)) {
+        internal[e.node_id] = true;
+        root[nid] = true;
+      }
+    }
+  }
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (internal[nid]) root[nid] = false;
+  }
+  bool any_group = false;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) any_group = any_group || root[nid];
+  if (!any_group) return g;
+
+  // copy the operator nodes, so that the nodes of the symbol are left intact.
+  // The variables are kept, as the executor identifies them by address.
+  std::vector<NodePtr> new_nodes(num_nodes);
+  auto map_entry = [&](const NodeEntry& e) {
+    return NodeEntry{new_nodes[idx.node_id(e.node.get())], e.index, e.version};
+  };
+  nnvm::DFSVisit(g.outputs, [&](const NodePtr& node) {
+    const uint32_t nid = idx.node_id(node.get());
+    if (node->is_variable()) {
+      new_nodes[nid] = node;
+      return;
+    }
+    if (internal[nid]) return;
+    NodePtr n = nnvm::Node::Create();
+    if (!root[nid]) {
+      n->attrs = node->attrs;
+      for (const auto& e : node->inputs) n->inputs.push_back(map_entry(e));
+      for (const auto& dep : node->control_deps) {
+        n->control_deps.push_back(new_nodes[idx.node_id(dep.get())]);
+      }
+      new_nodes[nid] = n;
+      return;
+    }
+    // generate the statements of the group, inputs are visited in the same
+    // order as the depth first search, which keeps the order of the variables
+    std::unordered_map<uint32_t, size_t> input_pos;
+    std::ostringstream code;
+    std::function<std::string(uint32_t)> emit = [&](uint32_t id) -> std::string {
+      std::vector<std::string> args;
+      for (const auto& e : idx[id].inputs) {
+        if (internal[e.node_id]) {
+          args.push_back(emit(e.node_id));
+          continue;
+        }
+        const uint32_t eid = idx.entry_id(e);
+        if (!input_pos.count(eid)) {
+          input_pos[eid] = n->inputs.size();
+          n->inputs.push_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+        }
+        args.push_back("v" + std::to_string(input_pos[eid]));
+      }
+      std::string expr, var = id == nid ? "r" : "t" + std::to_string(id);
+      CHECK(PointwiseExpr(idx[id].source->attrs, args, &expr));
+      code << "const DType " << var << " = " << expr << ";\n";
+      return var;
+    };
+    emit(nid);
+    n->attrs.op = fused_op;
+    n->attrs.name = node->attrs.name;
+    n->attrs.dict["num_inputs"] = std::to_string(n->inputs.size());
+    n->attrs.dict["code"] = code.str();
+    fused_op->attr_parser(&(n->attrs));
+    new_nodes[nid] = n;
+  });
+  Graph ret;
+  for (const auto& e : g.outputs) ret.outputs.push_back(map_entry(e));
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -79,6 +79,8 @@ struct DefaultImageAugmentParam : public dmlc::Parameter<DefaultImageAugmentPara
   int pad;
   /*! \brief shape of the image data*/
   TShape data_shape;
+  /*! \brief whether to interpolate only the crop window after resize */
+  bool fuse_resize_crop;
   // declare parameters
   DMLC_DECLARE_PARAMETER(DefaultImageAugmentParam) {
     DMLC_DECLARE_FIELD(resize).set_default(-1)
@@ -135,6 +137,11 @@ struct DefaultImageAugmentParam : public dmlc::Parameter<DefaultImageAugmentPara
     DMLC_DECLARE_FIELD(pad).set_default(0)
         .describe("Change size from ``[width, height]`` into "
                   "``[pad + width + pad, pad + height + pad]`` by padding pixes");
+    DMLC_DECLARE_FIELD(fuse_resize_crop).set_default(false)
+        .describe("When ``resize`` is followed by a crop of ``data_shape`` with bilinear "
+                  "interpolation and no affine transformation or padding, interpolate "
+                  "only the crop window from the source image in one pass. The result "
+                  "differs from the unfused path by interpolation rounding.");
   }
 };
 
@@ -196,6 +203,11 @@ class DefaultImageAugmenter : public ImageAugmenter {
   cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                   common::RANDOM_ENGINE *prnd) override {
     using mshadow::index_t;
+    // the intermediate images are kept in members, so that their storage is
+    // reused by the next image of the same size
+    if (CanFuseResizeCrop()) {
+      return ColorAugment(FusedResizeCrop(src, prnd), prnd);
+    }
     cv::Mat res;
     if (param_.resize != -1) {
       int new_height, new_width;
@@ -211,17 +223,15 @@ class DefaultImageAugmenter : public ImageAugmenter {
         << "invalid inter_method: valid value 0,1,2,3,9,10";
       int interpolation_method = GetInterMethod(param_.inter_method,
                    src.cols, src.rows, new_width, new_height, prnd);
-      cv::resize(src, res, cv::Size(new_width, new_height),
+      cv::resize(src, resize_buf_, cv::Size(new_width, new_height),
                    0, 0, interpolation_method);
+      res = resize_buf_;
     } else {
       res = src;
     }
 
     // normal augmentation by affine transformation.
-    if (param_.max_rotate_angle > 0 || param_.max_shear_ratio > 0.0f
-        || param_.rotate > 0 || rotate_list_.size() > 0 || param_.max_random_scale != 1.0
-        || param_.min_random_scale != 1.0 || param_.max_aspect_ratio != 0.0f
-        || param_.max_img_size != 1e10f || param_.min_img_size != 0.0f) {
+    if (NeedAffine()) {
       std::uniform_real_distribution<float> rand_uniform(0, 1);
       // shear
       float s = rand_uniform(*prnd) * param_.max_shear_ratio * 2 - param_.max_shear_ratio;
@@ -247,7 +257,7 @@ class DefaultImageAugmenter : public ImageAugmenter {
                                  std::min(param_.max_img_size, scale * res.cols));
       float new_height = std::max(param_.min_img_size,
                                   std::min(param_.max_img_size, scale * res.rows));
-      cv::Mat M(2, 3, CV_32F);
+      cv::Mat& M = rotateM_;
       M.at<float>(0, 0) = hs * a - s * b * ws;
       M.at<float>(1, 0) = -b * ws;
       M.at<float>(0, 1) = hs * b + s * a * ws;
@@ -270,9 +280,10 @@ class DefaultImageAugmenter : public ImageAugmenter {
 
     // pad logic
     if (param_.pad > 0) {
-      cv::copyMakeBorder(res, res, param_.pad, param_.pad, param_.pad, param_.pad,
+      cv::copyMakeBorder(res, pad_buf_, param_.pad, param_.pad, param_.pad, param_.pad,
                          cv::BORDER_CONSTANT,
                          cv::Scalar(param_.fill_value, param_.fill_value, param_.fill_value));
+      res = pad_buf_;
     }
 
     // crop logic
@@ -293,8 +304,9 @@ class DefaultImageAugmenter : public ImageAugmenter {
       cv::Rect roi(x, y, rand_crop_size, rand_crop_size);
       int interpolation_method = GetInterMethod(param_.inter_method, rand_crop_size, rand_crop_size,
                                                 param_.data_shape[2], param_.data_shape[1], prnd);
-      cv::resize(res(roi), res, cv::Size(param_.data_shape[2], param_.data_shape[1])
+      cv::resize(res(roi), crop_buf_, cv::Size(param_.data_shape[2], param_.data_shape[1])
                 , 0, 0, interpolation_method);
+      res = crop_buf_;
     } else {
       CHECK(static_cast<index_t>(res.rows) >= param_.data_shape[1]
             && static_cast<index_t>(res.cols) >= param_.data_shape[2])
@@ -310,8 +322,61 @@ class DefaultImageAugmenter : public ImageAugmenter {
       cv::Rect roi(x, y, param_.data_shape[2], param_.data_shape[1]);
       res = res(roi);
     }
+    return ColorAugment(res, prnd);
+  }
 
-    // color space augmentation
+ private:
+  // whether the affine transformation step is enabled
+  inline bool NeedAffine() const {
+    return param_.max_rotate_angle > 0 || param_.max_shear_ratio > 0.0f
+        || param_.rotate > 0 || rotate_list_.size() > 0 || param_.max_random_scale != 1.0
+        || param_.min_random_scale != 1.0 || param_.max_aspect_ratio != 0.0f
+        || param_.max_img_size != 1e10f || param_.min_img_size != 0.0f;
+  }
+  // whether resize and crop can be done by FusedResizeCrop
+  inline bool CanFuseResizeCrop() const {
+    return param_.fuse_resize_crop && param_.resize != -1 && param_.inter_method == 1 &&
+        !NeedAffine() && param_.pad == 0 &&
+        param_.max_crop_size == -1 && param_.min_crop_size == -1;
+  }
+  /*!
+   * \brief resize and crop in one bilinear pass, which maps every pixel of
+   *  the crop back to the source with the same coordinates as cv::resize,
+   *  so that the pixels of the resized image outside the crop are never computed.
+   */
+  cv::Mat FusedResizeCrop(const cv::Mat &src, common::RANDOM_ENGINE *prnd) {
+    using mshadow::index_t;
+    int new_height, new_width;
+    if (src.rows > src.cols) {
+      new_height = param_.resize*src.rows/src.cols;
+      new_width = param_.resize;
+    } else {
+      new_height = param_.resize;
+      new_width = param_.resize*src.cols/src.rows;
+    }
+    CHECK(static_cast<index_t>(new_height) >= param_.data_shape[1]
+          && static_cast<index_t>(new_width) >= param_.data_shape[2])
+        << "input image size smaller than input shape";
+    index_t y = new_height - param_.data_shape[1];
+    index_t x = new_width - param_.data_shape[2];
+    if (param_.rand_crop != 0) {
+      y = std::uniform_int_distribution<index_t>(0, y)(*prnd);
+      x = std::uniform_int_distribution<index_t>(0, x)(*prnd);
+    } else {
+      y /= 2; x /= 2;
+    }
+    // pixel (u, v) of the crop is (u + x, v + y) of the resized image, which
+    // cv::resize samples at ((u + x + 0.5) * sx - 0.5, (v + y + 0.5) * sy - 0.5)
+    const double sx = static_cast<double>(src.cols) / new_width;
+    const double sy = static_cast<double>(src.rows) / new_height;
+    cv::Mat M = (cv::Mat_<double>(2, 3) << sx, 0, (x + 0.5) * sx - 0.5,
+                                           0, sy, (y + 0.5) * sy - 0.5);
+    cv::warpAffine(src, crop_buf_, M, cv::Size(param_.data_shape[2], param_.data_shape[1]),
+                   cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+    return crop_buf_;
+  }
+  // color space augmentation
+  cv::Mat ColorAugment(cv::Mat res, common::RANDOM_ENGINE *prnd) {
     if (param_.random_h != 0 || param_.random_s != 0 || param_.random_l != 0) {
       std::uniform_real_distribution<float> rand_uniform(0, 1);
       cvtColor(res, res, CV_BGR2HLS);
@@ -334,10 +399,10 @@ class DefaultImageAugmenter : public ImageAugmenter {
     }
     return res;
   }
-
- private:
   // temporal space
   cv::Mat temp_;
+  // output of the resize, pad and crop steps
+  cv::Mat resize_buf_, pad_buf_, crop_buf_;
   // rotation param
   cv::Mat rotateM_;
   // parameters
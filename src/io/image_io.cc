@@ -36,10 +36,7 @@
 #include <fstream>
 
 #include "../operator/elemwise_op_common.h"
-
-#if MXNET_USE_OPENCV
-  #include <opencv2/opencv.hpp>
-#endif  // MXNET_USE_OPENCV
+#include "./image_io.h"
 
 namespace mxnet {
 namespace io {
@@ -99,6 +96,8 @@ bool get_png_size(const uint8_t* data, uint32_t data_size, int64_t *width, int64
 struct ImdecodeParam : public dmlc::Parameter<ImdecodeParam> {
   int flag;
   bool to_rgb;
+  int min_width;
+  int min_height;
   DMLC_DECLARE_PARAMETER(ImdecodeParam) {
     DMLC_DECLARE_FIELD(flag)
     .set_lower_bound(0)
@@ -108,6 +107,16 @@ struct ImdecodeParam : public dmlc::Parameter<ImdecodeParam> {
     .set_default(true)
     .describe("Whether to convert decoded image to mxnet's default RGB format "
               "(instead of opencv's default BGR).");
+    DMLC_DECLARE_FIELD(min_width)
+    .set_lower_bound(0)
+    .set_default(0)
+    .describe("Decode a JPEG image at 1/2, 1/4 or 1/8 of its resolution, which is much "
+              "faster, when it is still at least min_width wide and min_height high. "
+              "0 for both decodes at full resolution.");
+    DMLC_DECLARE_FIELD(min_height)
+    .set_lower_bound(0)
+    .set_default(0)
+    .describe("See min_width.");
   }
 };
 
@@ -136,11 +145,12 @@ DMLC_REGISTER_PARAMETER(ImreadParam);
 
 #if MXNET_USE_OPENCV
 void ImdecodeImpl(int flag, bool to_rgb, void* data, size_t size,
-                  NDArray* out) {
+                  NDArray* out, int scale_denom = 1) {
   cv::Mat buf(1, size, CV_8U, data);
   cv::Mat dst;
+  const int decode_flag = ReducedDecodeFlag(flag, scale_denom);
   if (out->is_none()) {
-    cv::Mat res = cv::imdecode(buf, flag);
+    cv::Mat res = cv::imdecode(buf, decode_flag);
     if (res.empty()) {
       LOG(INFO) << "Invalid image file. Only supports png and jpg.";
       *out = NDArray();
@@ -155,9 +165,9 @@ void ImdecodeImpl(int flag, bool to_rgb, void* data, size_t size,
     dst = cv::Mat(out->shape()[0], out->shape()[1], flag == 0 ? CV_8U : CV_8UC3,
                 out->data().dptr_);
 #if (CV_MAJOR_VERSION > 2 || (CV_MAJOR_VERSION == 2 && CV_MINOR_VERSION >=4))
-    cv::imdecode(buf, flag, &dst);
+    cv::imdecode(buf, decode_flag, &dst);
 #else
-    cv::Mat tmp = cv::imdecode(buf, flag);
+    cv::Mat tmp = cv::imdecode(buf, decode_flag);
     CHECK(!tmp.empty());
     tmp.copyTo(dst);
 #endif
@@ -184,7 +194,11 @@ void Imdecode(const nnvm::NodeAttrs& attrs,
   size_t len = inputs[0].shape().Size();
   TShape oshape(3);
   oshape[2] = param.flag == 0 ? 1 : 3;
+  int scale_denom = 1;
   if (get_jpeg_size(str_img, len, &oshape[1], &oshape[0])) {
+    scale_denom = JpegScaleDenom(oshape[1], oshape[0], param.min_width, param.min_height);
+    oshape[0] = (oshape[0] + scale_denom - 1) / scale_denom;
+    oshape[1] = (oshape[1] + scale_denom - 1) / scale_denom;
   } else if (get_png_size(str_img, len, &oshape[1], &oshape[0])) {
   } else {
     (*outputs)[0] = NDArray();
@@ -195,9 +209,9 @@ void Imdecode(const nnvm::NodeAttrs& attrs,
   const NDArray& ndin = inputs[0];
   NDArray& ndout = (*outputs)[0];
   ndout = NDArray(oshape, Context::CPU(), true, mshadow::kUint8);
-  Engine::Get()->PushSync([ndin, ndout, str_img, len, param](RunContext ctx){
+  Engine::Get()->PushSync([ndin, ndout, str_img, len, param, scale_denom](RunContext ctx){
       ImdecodeImpl(param.flag, param.to_rgb, str_img, len,
-                   const_cast<NDArray*>(&ndout));
+                   const_cast<NDArray*>(&ndout), scale_denom);
     }, ndout.ctx(), {ndin.var()}, {ndout.var()},
     FnProperty::kNormal, 0, PROFILER_MESSAGE("Imdecode"));
 #else
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file image_io.h
+ * \brief helpers to inspect encoded images before decoding them
+ */
+#ifndef MXNET_IO_IMAGE_IO_H_
+#define MXNET_IO_IMAGE_IO_H_
+
+#include <dmlc/base.h>
+#include <cstdint>
+
+#if MXNET_USE_OPENCV
+  #include <opencv2/opencv.hpp>
+#endif  // MXNET_USE_OPENCV
+
+namespace mxnet {
+namespace io {
+
+/*! \brief get the size of a JFIF image from its header, returns false if data is not one */
+bool get_jpeg_size(const uint8_t* data, uint32_t data_size, int64_t *width, int64_t *height);
+
+/*! \brief get the size of a PNG image from its header, returns false if data is not one */
+bool get_png_size(const uint8_t* data, uint32_t data_size, int64_t *width, int64_t *height);
+
+#if MXNET_USE_OPENCV
+/*!
+ * \brief the largest JPEG DCT scaling denominator, among 1, 2, 4 and 8, with
+ *  which a width x height image is still decoded to at least
+ *  min_width x min_height. libjpeg decodes to ceil(width / denom) x
+ *  ceil(height / denom) at a fraction of the cost of a full decode.
+ *  Returns 1 when OpenCV cannot decode at reduced resolution.
+ */
+inline int JpegScaleDenom(int64_t width, int64_t height,
+                          int64_t min_width, int64_t min_height) {
+#if (CV_MAJOR_VERSION > 3 || (CV_MAJOR_VERSION == 3 && CV_MINOR_VERSION >= 2))
+  for (int denom = 8; denom > 1; denom /= 2) {
+    if ((width + denom - 1) / denom >= min_width &&
+        (height + denom - 1) / denom >= min_height) {
+      return denom;
+    }
+  }
+#endif
+  return 1;
+}
+
+/*!
+ * \brief the cv::imdecode flag decoding at 1 / denom of the resolution.
+ * \param flag 0 for grayscale or 1 for color, other flags are returned as is
+ * \param denom the denominator returned by JpegScaleDenom
+ */
+inline int ReducedDecodeFlag(int flag, int denom) {
+#if (CV_MAJOR_VERSION > 3 || (CV_MAJOR_VERSION == 3 && CV_MINOR_VERSION >= 2))
+  if (flag != 0 && flag != 1) return flag;
+  switch (denom) {
+   case 2:
+    return flag == 0 ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+   case 4:
+    return flag == 0 ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+   case 8:
+    return flag == 0 ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+   default:
+    return flag;
+  }
+#else
+  return flag;
+#endif
+}
+#endif  // MXNET_USE_OPENCV
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_IMAGE_IO_H_
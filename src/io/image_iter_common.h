@@ -102,6 +102,8 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   std::string path_imglist;
   /*! \brief path to image recordio */
   std::string path_imgrec;
+  /*! \brief path to index file of image recordio */
+  std::string path_imgidx;
   /*! \brief a sequence of names of image augmenters, seperated by , */
   std::string aug_seq;
   /*! \brief label-width */
@@ -120,6 +122,16 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   size_t shuffle_chunk_size;
   /*! \brief the seed for chunk shuffling*/
   int shuffle_chunk_seed;
+  /*! \brief whether to decode JPEG images at reduced resolution */
+  bool reduced_decode;
+  /*! \brief number of worker processes decoding the images */
+  int worker_procs;
+  /*! \brief where to keep the decoded images of the first epoch */
+  std::string decoded_cache;
+  /*! \brief number of times every decoded image is augmented and returned */
+  int echo_factor;
+  /*! \brief number of parts handed out to the workers by the kvstore */
+  int dynamic_parts;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -130,6 +142,12 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
     DMLC_DECLARE_FIELD(path_imgrec).set_default("")
         .describe("Path to the image RecordIO (.rec) file or a directory path. "\
                   "Created with tools/im2rec.py.");
+    DMLC_DECLARE_FIELD(path_imgidx).set_default("")
+        .describe("Path to the index file of the RecordIO, created with tools/im2rec.py. "
+                  "When given, the records are read through the index, with ``shuffle`` "
+                  "in a new global random order every epoch, and ``num_parts`` split "
+                  "that order evenly between the parts. Only used by ImageRecordIter "
+                  "and ImageRecordUInt8Iter.");
     DMLC_DECLARE_FIELD(aug_seq).set_default("aug_default")
         .describe("The augmenter names to represent"\
                   " sequence of augmenters to be applied, seperated by comma." \
@@ -151,6 +169,35 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The data shuffle buffer size in MB. Only valid if shuffle is true.");
     DMLC_DECLARE_FIELD(shuffle_chunk_seed).set_default(0)
         .describe("The random seed for shuffling");
+    DMLC_DECLARE_FIELD(reduced_decode).set_default(false)
+        .describe("When ``resize`` is set, decode JPEG images at the lowest resolution "
+                  "among 1, 1/2, 1/4 and 1/8 whose shorter edge is still at least "
+                  "``resize``, which is much faster than a full decode. Only used by "
+                  "ImageRecordIter and ImageRecordUInt8Iter.");
+    DMLC_DECLARE_FIELD(worker_procs).set_default(0).set_lower_bound(0)
+        .describe("Decode in this many forked worker processes with one thread each, "
+                  "which write the batches into shared memory, instead of in "
+                  "``preprocess_threads`` threads of the training process. A batch is "
+                  "only valid until the next one is read. Only used by ImageRecordIter "
+                  "and ImageRecordUInt8Iter.");
+    DMLC_DECLARE_FIELD(decoded_cache).set_default("")
+        .describe("Keep the decoded images, resized to ``resize`` if it is set, of the "
+                  "first epoch in memory if ``mem``, or in the local file of this path "
+                  "otherwise. The later epochs read them back instead of reading and "
+                  "decoding the records again, and only apply the augmentations. Only "
+                  "used by ImageRecordIter and ImageRecordUInt8Iter.");
+    DMLC_DECLARE_FIELD(echo_factor).set_default(1).set_lower_bound(1)
+        .describe("Augment every decoded image this many times, so that an epoch "
+                  "returns ``echo_factor`` times as many images. Trades repeated "
+                  "images for less reading and decoding when these are the bottleneck. "
+                  "Only used by ImageRecordIter and ImageRecordUInt8Iter.");
+    DMLC_DECLARE_FIELD(dynamic_parts).set_default(0).set_lower_bound(0)
+        .describe("Divide the records into this many parts, which the workers get one "
+                  "at a time from the first server of the distributed kvstore, instead "
+                  "of reading the static part ``part_index`` of ``num_parts``. Faster "
+                  "workers read more parts, so that all of them finish an epoch "
+                  "together. The kvstore must be created before the first epoch is "
+                  "read. Only used by ImageRecordIter and ImageRecordUInt8Iter.");
   }
 };
 
@@ -309,6 +356,8 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   size_t prefetch_buffer;
   /*! \brief data type */
   dmlc::optional<int> dtype;
+  /*! \brief device type of the prefetched batches */
+  int ctx;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(PrefetcherParam) {
@@ -322,6 +371,12 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
       .add_enum("uint8", mshadow::kUint8)
       .set_default(dmlc::optional<int>())
       .describe("Output data type. ``None`` means no change.");
+    DMLC_DECLARE_FIELD(ctx)
+      .add_enum("cpu", Context::kCPU)
+      .add_enum("cpu_pinned", Context::kCPUPinned)
+      .set_default(Context::kCPU)
+      .describe("Memory of the prefetched batches. ``cpu_pinned`` allocates them in "
+                "page-locked memory, which makes their copy to the GPU faster.");
   }
 };
 
@@ -0,0 +1,187 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file indexed_recordio_split.h
+ * \brief input split reading the records of a RecordIO file through its index
+ */
+#ifndef MXNET_IO_INDEXED_RECORDIO_SPLIT_H_
+#define MXNET_IO_INDEXED_RECORDIO_SPLIT_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/recordio.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief Reads the records of a RecordIO file in the order of a permutation
+ *  of its index file, as written by im2rec.
+ *
+ *  With shuffle, every epoch draws a new permutation of all the records.
+ *  The permutation only depends on the seed and the epoch, so all parts see
+ *  the same one and take disjoint slices of it. A chunk holds the next
+ *  records of the slice, read in increasing file offset so that the reads
+ *  are close to sequential, and is formatted as RecordIO like the chunks of
+ *  dmlc::InputSplit.
+ */
+class IndexedRecordIOSplit : public dmlc::InputSplit {
+ public:
+  IndexedRecordIOSplit(const std::string& path_rec, const std::string& path_idx,
+                       unsigned part_index, unsigned num_parts, bool shuffle, int seed)
+      : shuffle_(shuffle), seed_(seed) {
+    fs_.reset(dmlc::SeekStream::CreateForRead(path_rec.c_str()));
+    CHECK(fs_ != nullptr) << "Cannot open " << path_rec;
+    LoadIndex(path_idx);
+    ResetPartition(part_index, num_parts);
+  }
+
+  virtual void HintChunkSize(size_t chunk_size) {
+    chunk_size_ = std::max(chunk_size, static_cast<size_t>(1));
+  }
+
+  virtual size_t GetTotalSize(void) {
+    size_t total = 0;
+    for (size_t i = begin_; i < end_; ++i) total += records_[i].second;
+    return total;
+  }
+
+  virtual void BeforeFirst(void) {
+    ++epoch_;
+    Permute();
+  }
+
+  virtual void ResetPartition(unsigned part_index, unsigned num_parts) {
+    CHECK_LT(part_index, num_parts);
+    begin_ = records_.size() * part_index / num_parts;
+    end_ = records_.size() * (part_index + 1) / num_parts;
+    Permute();
+  }
+
+  virtual bool NextRecord(Blob *out_rec) {
+    while (reader_ == nullptr || !reader_->NextRecord(out_rec)) {
+      Blob chunk;
+      if (!NextChunk(&chunk)) return false;
+      reader_.reset(new dmlc::RecordIOChunkReader(chunk));
+    }
+    return true;
+  }
+
+  virtual bool NextChunk(Blob *out_chunk) {
+    if (pos_ == end_) return false;
+    std::vector<size_t> chunk;
+    size_t size = 0;
+    while (pos_ < end_ && (chunk.empty() || size < chunk_size_)) {
+      chunk.push_back(order_[pos_]);
+      size += records_[order_[pos_]].second;
+      ++pos_;
+    }
+    std::sort(chunk.begin(), chunk.end(), [this](size_t a, size_t b) {
+        return records_[a].first < records_[b].first;
+      });
+    buffer_.resize(size);
+    size_t offset = 0;
+    for (size_t i : chunk) {
+      if (records_[i].first != fs_->Tell()) fs_->Seek(records_[i].first);
+      CHECK_EQ(fs_->Read(&buffer_[offset], records_[i].second), records_[i].second)
+          << "Invalid RecordIO index";
+      offset += records_[i].second;
+    }
+    out_chunk->dptr = dmlc::BeginPtr(buffer_);
+    out_chunk->size = size;
+    return true;
+  }
+
+ private:
+  /*! \brief read the offsets of the records and compute their sizes */
+  void LoadIndex(const std::string& path_idx) {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path_idx.c_str(), "r"));
+    dmlc::istream is(fi.get());
+    std::vector<size_t> offsets;
+    size_t key, offset;
+    while (is >> key >> offset) offsets.push_back(offset);
+    CHECK(!offsets.empty()) << "Empty RecordIO index " << path_idx;
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+      records_.emplace_back(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    records_.emplace_back(offsets.back(), LastRecordSize(offsets.back()));
+  }
+  /*! \brief size of the record at offset, following its continuation parts */
+  size_t LastRecordSize(size_t offset) {
+    size_t pos = offset;
+    while (true) {
+      uint32_t header[2];
+      fs_->Seek(pos);
+      CHECK_EQ(fs_->Read(header, sizeof(header)), sizeof(header)) << "Invalid RecordIO index";
+      CHECK_EQ(header[0], dmlc::RecordIOWriter::kMagic) << "Invalid RecordIO index";
+      uint32_t cflag = dmlc::RecordIOWriter::DecodeFlag(header[1]);
+      uint32_t len = dmlc::RecordIOWriter::DecodeLength(header[1]);
+      pos += sizeof(header) + ((len + 3U) & ~3U);
+      if (cflag == 0 || cflag == 3) break;
+    }
+    fs_->Seek(0);
+    return pos - offset;
+  }
+  /*! \brief order of the records in the current epoch */
+  void Permute() {
+    order_.resize(records_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    if (shuffle_) {
+      std::mt19937 rnd(seed_ + epoch_);
+      std::shuffle(order_.begin(), order_.end(), rnd);
+    }
+    pos_ = begin_;
+    reader_.reset();
+  }
+  /*! \brief whether to shuffle every epoch */
+  bool shuffle_;
+  /*! \brief random seed of the permutations */
+  int seed_;
+  /*! \brief number of BeforeFirst calls */
+  int epoch_{0};
+  /*! \brief RecordIO file */
+  std::unique_ptr<dmlc::SeekStream> fs_;
+  /*! \brief offset and size of every record, in file order */
+  std::vector<std::pair<size_t, size_t> > records_;
+  /*! \brief permutation of the records */
+  std::vector<size_t> order_;
+  /*! \brief slice of order_ read by this part, and the next position in it */
+  size_t begin_{0}, end_{0}, pos_{0};
+  /*! \brief target size of a chunk in bytes */
+  size_t chunk_size_{8 << 20UL};
+  /*! \brief content of the current chunk */
+  std::vector<char> buffer_;
+  /*! \brief reader of the current chunk for NextRecord */
+  std::unique_ptr<dmlc::RecordIOChunkReader> reader_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_INDEXED_RECORDIO_SPLIT_H_
@@ -89,8 +89,7 @@ class BatchLoader : public IIterator<TBlobBatch> {
         CHECK_EQ(unit_size_[i], d.data[i].Size());
         MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
             mshadow::Copy(
-              data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                  (top + 1) * unit_size_[i]),
+              OutData<DType>(i).Slice(top * unit_size_[i], (top + 1) * unit_size_[i]),
               d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
           });
       }
@@ -111,8 +110,7 @@ class BatchLoader : public IIterator<TBlobBatch> {
             CHECK_EQ(unit_size_[i], d.data[i].Size());
             MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
                 mshadow::Copy(
-                  data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                      (top + 1) * unit_size_[i]),
+                  OutData<DType>(i).Slice(top * unit_size_[i], (top + 1) * unit_size_[i]),
                   d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
               });
           }
@@ -128,6 +126,27 @@ class BatchLoader : public IIterator<TBlobBatch> {
   virtual const TBlobBatch &Value(void) const {
     return out_;
   }
+  /*!
+   * \brief make the next batches be written into data instead of the internal
+   *  buffers, so that the caller does not need to copy them out of Value().
+   *  data must have the shapes and types of Value().data. An empty data
+   *  switches back to the internal buffers.
+   */
+  inline void SetOutput(const std::vector<TBlob>& data) {
+    if (data.empty()) {
+      for (size_t i = 0; i < data_.size(); ++i) {
+        out_.data[i] = TBlob(data_[i].dptr_, shape_[i], cpu::kDevMask, data_[i].type_flag_, 0);
+      }
+      return;
+    }
+    CHECK_EQ(data.size(), out_.data.size()) << "SetOutput called before the first batch";
+    for (size_t i = 0; i < data.size(); ++i) {
+      CHECK_EQ(data[i].shape_, shape_[i]);
+      CHECK_EQ(data[i].type_flag_, data_[i].type_flag_);
+      CHECK_EQ(data[i].dev_mask(), cpu::kDevMask);
+      out_.data[i] = data[i];
+    }
+  }
 
  protected:
   /*! \brief batch parameters */
@@ -148,6 +167,11 @@ class BatchLoader : public IIterator<TBlobBatch> {
   std::vector<TShape> shape_;
   /*! \brief unit size */
   std::vector<size_t> unit_size_;
+  // flat view of the i-th output of the batch
+  template<typename DType>
+  inline mshadow::Tensor<cpu, 1, DType> OutData(size_t i) {
+    return out_.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(shape_[i].Size()));
+  }
   // initialize the data holder by using from the first batch.
   inline void InitData(const DataInst& first_batch) {
     shape_.resize(first_batch.data.size());
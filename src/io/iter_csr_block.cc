@@ -0,0 +1,228 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file iter_csr_block.cc
+ * \brief iterator over a binary file of preassembled csr batches
+ */
+#include <mxnet/io.h>
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+/*! \brief magic number of csr block files, "MXCSRBLK" */
+static const uint64_t kCSRBlockMagic = 0x4b4c42525343584dULL;
+
+struct CSRBlockIterParam : public dmlc::Parameter<CSRBlockIterParam> {
+  /*! \brief path to the csr block file */
+  std::string data_path;
+  /*! \brief partition the data into multiple parts */
+  int num_parts;
+  /*! \brief the index of the part will read*/
+  int part_index;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(CSRBlockIterParam) {
+    DMLC_DECLARE_FIELD(data_path)
+        .describe("The csr block file, created by tools/libsvm2csrblock.py.");
+    DMLC_DECLARE_FIELD(num_parts).set_default(1)
+        .describe("partition the data into multiple parts");
+    DMLC_DECLARE_FIELD(part_index).set_default(0)
+        .describe("the index of the part will read");
+  }
+};
+
+/*!
+ * \brief the file is a header of three uint64, the magic number, the
+ *  number of columns and the number of rows of a block, followed by the
+ *  blocks. A block is three uint64, the number of rows, the number of
+ *  padded rows at its end and the number of non zero values, followed
+ *  by the int64 indptr and indices, the float32 values and labels, and
+ *  zero bytes up to a multiple of 8 bytes.
+ */
+class CSRBlockIter : public IIterator<DataBatch> {
+ public:
+  CSRBlockIter() {}
+  virtual ~CSRBlockIter() {
+#ifndef _WIN32
+    if (data_ != nullptr) munmap(data_, size_);
+#endif  // _WIN32
+  }
+
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
+    CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
+    CHECK_LT(param_.part_index, param_.num_parts);
+    this->Map();
+    CHECK_GE(size_, 3 * sizeof(uint64_t)) << param_.data_path << " is not a csr block file";
+    const uint64_t* header = reinterpret_cast<const uint64_t*>(data_);
+    CHECK_EQ(header[0], kCSRBlockMagic) << param_.data_path << " is not a csr block file";
+    num_cols_ = header[1];
+    // the blocks are assigned to the parts round robin
+    size_t offset = 3 * sizeof(uint64_t);
+    for (size_t i = 0; offset < size_; ++i) {
+      CHECK_LE(offset + 3 * sizeof(uint64_t), size_) << param_.data_path << " is truncated";
+      const uint64_t* head = reinterpret_cast<const uint64_t*>(data_ + offset);
+      const uint64_t num_rows = head[0], nnz = head[2];
+      size_t bytes = 3 * sizeof(uint64_t) + (num_rows + 1 + nnz) * sizeof(int64_t) +
+                     (nnz + num_rows) * sizeof(float);
+      bytes = (bytes + 7) / 8 * 8;
+      CHECK_LE(offset + bytes, size_) << param_.data_path << " is truncated";
+      if (i % param_.num_parts == static_cast<size_t>(param_.part_index)) {
+        blocks_.push_back(offset);
+      }
+      offset += bytes;
+    }
+    CHECK(!blocks_.empty()) << "No block of " << param_.data_path << " in part "
+                            << param_.part_index;
+    out_.data.resize(2);
+    this->BeforeFirst();
+  }
+
+  virtual void BeforeFirst() {
+    next_ = 0;
+    row_counter_ = 0;
+  }
+
+  virtual bool Next() {
+    if (next_ == blocks_.size()) return false;
+    char* ptr = data_ + blocks_[next_++];
+    const uint64_t* head = reinterpret_cast<const uint64_t*>(ptr);
+    const index_t num_rows = static_cast<index_t>(head[0]);
+    const index_t nnz = static_cast<index_t>(head[2]);
+    ptr += 3 * sizeof(uint64_t);
+    TBlob indptr(reinterpret_cast<int64_t*>(ptr), mshadow::Shape1(num_rows + 1),
+                 cpu::kDevMask, mshadow::kInt64);
+    ptr += (num_rows + 1) * sizeof(int64_t);
+    TBlob indices(reinterpret_cast<int64_t*>(ptr), mshadow::Shape1(nnz),
+                  cpu::kDevMask, mshadow::kInt64);
+    ptr += nnz * sizeof(int64_t);
+    TBlob values(reinterpret_cast<real_t*>(ptr), mshadow::Shape1(nnz), cpu::kDevMask);
+    ptr += nnz * sizeof(float);
+    TBlob label(reinterpret_cast<real_t*>(ptr), mshadow::Shape1(num_rows), cpu::kDevMask);
+    out_.data[0] = NDArray(kCSRStorage, mshadow::Shape2(num_rows, num_cols_),
+                           values, {indptr, indices}, 0);
+    out_.data[1] = NDArray(label, 0);
+    out_.num_batch_padd = static_cast<int>(head[1]);
+    out_.index.resize(num_rows);
+    for (index_t i = 0; i < num_rows; ++i) out_.index[i] = row_counter_++;
+    return true;
+  }
+
+  virtual const DataBatch &Value(void) const {
+    return out_;
+  }
+
+ private:
+  /*! \brief map the file into memory, or read it on windows */
+  void Map() {
+#ifndef _WIN32
+    int fd = open(param_.data_path.c_str(), O_RDONLY);
+    CHECK_NE(fd, -1) << "Cannot open " << param_.data_path << ": " << strerror(errno);
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat " << param_.data_path;
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ != 0) {
+      // private writable mapping, so that writes to a batch never reach the file
+      void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      CHECK(ptr != MAP_FAILED) << "Cannot map " << param_.data_path << ": " << strerror(errno);
+      data_ = static_cast<char*>(ptr);
+    }
+    close(fd);
+#else
+    std::unique_ptr<dmlc::SeekStream> fi(dmlc::SeekStream::CreateForRead(
+        param_.data_path.c_str()));
+    CHECK(fi != nullptr) << "Cannot open " << param_.data_path;
+    fi->Seek(0);
+    char buf[1 << 16];
+    size_t n;
+    while ((n = fi->Read(buf, sizeof(buf))) != 0) {
+      buffer_.insert(buffer_.end(), buf, buf + n);
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif  // _WIN32
+  }
+
+  CSRBlockIterParam param_;
+  // the file content
+  char* data_{nullptr};
+  size_t size_{0};
+#ifdef _WIN32
+  std::vector<char> buffer_;
+#endif  // _WIN32
+  // number of columns of the data
+  index_t num_cols_{0};
+  // offsets of the blocks of this part
+  std::vector<size_t> blocks_;
+  // next block to return
+  size_t next_{0};
+  // index of the next row
+  uint64_t row_counter_{0};
+  // output batch
+  DataBatch out_;
+};
+
+DMLC_REGISTER_PARAMETER(CSRBlockIterParam);
+
+MXNET_REGISTER_IO_ITER(CSRBlockIter)
+.describe(R"code(Returns the iterator over a csr block file, a binary file of csr batches.
+
+Every block of the file is returned as one batch, whose data is a `csr` NDArray and
+label a 1D dense array. The arrays are views of the memory mapped file, they are not
+copied and are only valid as long as the iterator exists. The batch size is the number
+of rows of the blocks, set when the file is created from a libsvm file by
+``tools/libsvm2csrblock.py``. The last block is padded with empty rows, which are
+counted in the `pad` of its batch.
+
+If `num_parts` is larger than 1, the blocks are split between the parts round robin.
+
+Example::
+
+  python tools/libsvm2csrblock.py --num-features 3 --batch-size 3 data.t data.csrb
+  >>> data_iter = mx.io.CSRBlockIter(data_path='data.csrb')
+  >>> batch = data_iter.next()
+  >>> batch.data[0]
+  <CSRNDArray 3x3 @cpu(0)>
+
+)code" ADD_FILELINE)
+.add_arguments(CSRBlockIterParam::__FIELDS__())
+.set_body([]() {
+    return new CSRBlockIter();
+  });
+
+}  // namespace io
+}  // namespace mxnet
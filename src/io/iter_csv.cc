@@ -28,6 +28,7 @@
 #include <dmlc/data.h>
 #include "./iter_prefetcher.h"
 #include "./iter_batchloader.h"
+#include "./text_parser.h"
 
 namespace mxnet {
 namespace io {
@@ -41,6 +42,8 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
   std::string label_csv;
   /*! \brief label shape */
   TShape label_shape;
+  /*! \brief number of threads parsing the files */
+  int parse_threads;
   // declare parameters
   DMLC_DECLARE_PARAMETER(CSVIterParam) {
     DMLC_DECLARE_FIELD(data_csv)
@@ -53,6 +56,10 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
     index_t shape1[] = {1};
     DMLC_DECLARE_FIELD(label_shape).set_default(TShape(shape1, shape1 + 1))
         .describe("The shape of one label.");
+    DMLC_DECLARE_FIELD(parse_threads).set_default(0).set_lower_bound(0)
+        .describe("The number of threads parsing the CSV files. Every chunk of the "
+                  "files is split between the threads and the rows keep the order of "
+                  "the files. If 0, the parser of dmlc-core is used.");
   }
 };
 
@@ -66,9 +73,11 @@ class CSVIter: public IIterator<DataInst> {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
-    data_parser_.reset(dmlc::Parser<uint32_t>::Create(param_.data_csv.c_str(), 0, 1, "csv"));
+    data_parser_.reset(CreateTextParser<uint32_t>(param_.data_csv, 0, 1, "csv",
+                                                  param_.parse_threads));
     if (param_.label_csv != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint32_t>::Create(param_.label_csv.c_str(), 0, 1, "csv"));
+      label_parser_.reset(CreateTextParser<uint32_t>(param_.label_csv, 0, 1, "csv",
+                                                     param_.parse_threads));
     } else {
       dummy_label.set_pad(false);
       dummy_label.Resize(mshadow::Shape1(1));
@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file iter_device_prefetcher.cc
+ * \brief iterator wrapper that copies the batches to a device ahead of time
+ */
+#include <mxnet/io.h>
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <dmlc/registry.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+// Define device prefetcher parameters
+struct DevicePrefetcherParam : public dmlc::Parameter<DevicePrefetcherParam> {
+  /*! \brief name of the wrapped iterator */
+  std::string base_iter;
+  /*! \brief device type of the batches */
+  int device;
+  /*! \brief device id of the batches */
+  int dev_id;
+  /*! \brief number of batches kept on the device ahead of the current one */
+  int device_prefetch;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(DevicePrefetcherParam) {
+    DMLC_DECLARE_FIELD(base_iter)
+        .describe("Name of the wrapped iterator, e.g. ImageRecordIter. The arguments "
+                  "not listed here are passed to it.");
+    DMLC_DECLARE_FIELD(device)
+        .add_enum("cpu", Context::kCPU)
+        .add_enum("gpu", Context::kGPU)
+        .set_default(Context::kGPU)
+        .describe("Device type the batches are copied to.");
+    DMLC_DECLARE_FIELD(dev_id).set_default(0).set_lower_bound(0)
+        .describe("Device id the batches are copied to.");
+    DMLC_DECLARE_FIELD(device_prefetch).set_default(2).set_lower_bound(1)
+        .describe("Number of batches copied to the device ahead of the current one.");
+  }
+};
+
+/*!
+ * \brief Keeps the next batches of another iterator resident on a device.
+ *
+ *  The copies are pushed to the engine as soon as the wrapped iterator
+ *  produces a batch, so they run on the copy stream of the device while the
+ *  current batch is computed. Reusing a buffer is ordered by the engine after
+ *  the pending reads of the previous batch it held.
+ */
+class DevicePrefetcherIter : public IIterator<DataBatch> {
+ public:
+  DevicePrefetcherIter() : out_(nullptr) {}
+
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    std::vector<std::pair<std::string, std::string> > kwargs_left;
+    kwargs_left = param_.InitAllowUnknown(kwargs);
+    const DataIteratorReg* reg = dmlc::Registry<DataIteratorReg>::Find(param_.base_iter);
+    CHECK(reg != nullptr) << "Unknown iterator " << param_.base_iter;
+    CHECK_NE(param_.base_iter, "DevicePrefetchIter") << "DevicePrefetchIter cannot be nested";
+    ctx_ = Context::Create(static_cast<Context::DeviceType>(param_.device), param_.dev_id);
+    base_.reset(reg->body());
+    base_->Init(kwargs_left);
+    // the current batch and the prefetched ones
+    buffers_.resize(param_.device_prefetch + 1);
+    for (auto& batch : buffers_) free_.push_back(&batch);
+    this->Fill();
+  }
+
+  virtual void BeforeFirst(void) {
+    if (out_ != nullptr) {
+      free_.push_back(out_);
+      out_ = nullptr;
+    }
+    while (!ready_.empty()) {
+      free_.push_back(ready_.front());
+      ready_.pop_front();
+    }
+    base_->BeforeFirst();
+    end_ = false;
+    this->Fill();
+  }
+
+  virtual bool Next(void) {
+    if (out_ != nullptr) {
+      free_.push_back(out_);
+      out_ = nullptr;
+    }
+    if (ready_.empty()) this->Fill();
+    if (ready_.empty()) return false;
+    out_ = ready_.front();
+    ready_.pop_front();
+    this->Fill();
+    return true;
+  }
+
+  virtual const DataBatch &Value(void) const {
+    CHECK(out_ != nullptr) << "Value called before Next";
+    return *out_;
+  }
+
+ private:
+  /*! \brief issue the copies of the next batches until the buffers are full */
+  void Fill() {
+    while (!end_ && !free_.empty()) {
+      if (!base_->Next()) {
+        end_ = true;
+        break;
+      }
+      const DataBatch& src = base_->Value();
+      DataBatch* dst = free_.back();
+      free_.pop_back();
+      dst->data.resize(src.data.size());
+      for (size_t i = 0; i < src.data.size(); ++i) {
+        const NDArray& from = src.data[i];
+        NDArray& to = dst->data[i];
+        if (to.is_none() || to.storage_type() != from.storage_type() ||
+            to.dtype() != from.dtype() || to.shape() != from.shape()) {
+          if (from.storage_type() == kDefaultStorage) {
+            to = NDArray(from.shape(), ctx_, true, from.dtype());
+          } else {
+            to = NDArray(from.storage_type(), from.shape(), ctx_, true, from.dtype());
+          }
+        }
+        CopyFromTo(from, &to);
+      }
+      dst->index = src.index;
+      dst->extra_data = src.extra_data;
+      dst->num_batch_padd = src.num_batch_padd;
+      ready_.push_back(dst);
+    }
+  }
+  /*! \brief parameters */
+  DevicePrefetcherParam param_;
+  /*! \brief device of the batches */
+  Context ctx_;
+  /*! \brief wrapped iterator */
+  std::unique_ptr<IIterator<DataBatch> > base_;
+  /*! \brief storage of the batches */
+  std::vector<DataBatch> buffers_;
+  /*! \brief batches whose copies are issued, in order */
+  std::deque<DataBatch*> ready_;
+  /*! \brief batches that can be refilled */
+  std::vector<DataBatch*> free_;
+  /*! \brief current batch */
+  DataBatch* out_;
+  /*! \brief whether the wrapped iterator reached the end of the epoch */
+  bool end_{false};
+};
+
+DMLC_REGISTER_PARAMETER(DevicePrefetcherParam);
+
+MXNET_REGISTER_IO_ITER(DevicePrefetchIter)
+.describe(R"code(Wraps another iterator and keeps its next batches on a device.
+
+The copies of the upcoming batches to the device are issued while the current
+batch is computed, so that they are not on the critical path of ``forward``.
+The wrapped iterator is created from ``base_iter`` with the remaining
+arguments. With ``ctx='cpu_pinned'`` on the wrapped iterator the host side of
+the copies is page-locked memory and they run asynchronously.
+
+Example::
+
+  data_iter = mx.io.DevicePrefetchIter(base_iter='ImageRecordIter', dev_id=0,
+                                       path_imgrec='./sample.rec',
+                                       data_shape=(3, 227, 227), batch_size=4,
+                                       ctx='cpu_pinned')
+
+)code" ADD_FILELINE)
+.add_arguments(DevicePrefetcherParam::__FIELDS__())
+.set_body([]() {
+    return new DevicePrefetcherIter();
+  });
+
+}  // namespace io
+}  // namespace mxnet
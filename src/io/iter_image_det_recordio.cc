@@ -41,6 +41,7 @@
 #include "./iter_prefetcher.h"
 #include "./iter_normalize.h"
 #include "./iter_batchloader.h"
+#include "../engine/openmp.h"
 
 namespace mxnet {
 namespace io {
@@ -251,7 +252,8 @@ inline void ImageDetRecordIOParser<DType>::Init(
     // be conservative, set number of real cores - 1
     maxthread = std::max(omp_get_num_procs() - 1, 1);
   }
-  param_.preprocess_threads = std::min(maxthread, param_.preprocess_threads);
+  param_.preprocess_threads = engine::OpenMP::Get()->GetIOThreadCount(
+      std::min(maxthread, param_.preprocess_threads));
   #pragma omp parallel num_threads(param_.preprocess_threads)
   {
     threadget = omp_get_num_threads();
@@ -23,6 +23,7 @@
  */
 
 #include <mxnet/io.h>
+#include <mxnet/kvstore.h>
 #include <dmlc/parameter.h>
 #include <dmlc/threadediter.h>
 #include <dmlc/input_split_shuffle.h>
@@ -32,12 +33,27 @@
 #include <dmlc/omp.h>
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <thread>
 #include <type_traits>
 #include "./image_recordio.h"
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
+#include "./image_io.h"
+#include "./indexed_recordio_split.h"
 #include "./inst_vector.h"
 #include "../common/utils.h"
+#include "../engine/openmp.h"
 
 namespace mxnet {
 namespace io {
@@ -45,14 +61,20 @@ namespace io {
 template<typename DType>
 class ImageRecordIOParser2 {
  public:
-  // initialize the parser
-  inline void Init(const std::vector<std::pair<std::string, std::string> >& kwargs);
+  /*!
+   * \brief initialize the parser
+   * \param kwargs the parameters
+   * \param seed_offset offset of the seeds of the random augmentations, so that
+   *  worker processes do not draw the same ones
+   */
+  inline void Init(const std::vector<std::pair<std::string, std::string> >& kwargs,
+                   int seed_offset = 0);
 
   // set record to the head
   inline void BeforeFirst(void) {
     if (batch_param_.round_batch == 0 || !overflow) {
       n_parsed_ = 0;
-      return source_->BeforeFirst();
+      return ResetSource();
     } else {
       overflow = false;
     }
@@ -60,11 +82,45 @@ class ImageRecordIOParser2 {
   // parse next set of records, return an array of
   // instance vector to the user
   inline bool ParseNext(DataBatch *out);
+  /*!
+   * \brief make ParseNext write the data and label into out instead of the
+   *  NDArrays of the batch, which are then left empty
+   */
+  inline void SetOutput(const std::vector<TBlob>& out) {
+    out_blobs_ = out;
+  }
 
  private:
+  /*! \brief parse the next chunk of records, or of cached images, into temp_ */
+  inline bool NextChunk(void);
+  /*! \brief rewind the records, or the cached images once they hold an epoch */
+  inline void ResetSource(void);
   inline void ParseChunk(dmlc::InputSplit::Blob * chunk);
+  /*! \brief parse a chunk of the decoded image cache */
+  inline void ParseCachedChunk(const char* data, const std::vector<size_t>& offset);
+  #if MXNET_USE_OPENCV
+  /*! \brief augment and normalize a decoded image, and push it with its label */
+  inline void ProcessImage(int tid, const cv::Mat& img, unsigned index,
+                           const float* label, InstVector<DType>* out);
+  #endif
   inline void CreateMeanImg(void);
 
+  /*! \brief a chunk of the decoded image cache */
+  struct CachedChunk {
+    /*! \brief the images, empty once written to the cache file */
+    std::vector<char> data;
+    /*! \brief offset of every image in data, followed by the size of data */
+    std::vector<size_t> offset;
+  };
+  /*!
+   * \brief header of an image in the decoded image cache, followed by
+   *  label_width labels and the rows of the image
+   */
+  struct CachedImageHeader {
+    uint32_t index;
+    int32_t rows, cols, type;
+  };
+
   // magic number to seed prng
   static const int kRandMagic = 111;
   static const int kRandMagicNormalize = 0;
@@ -77,7 +133,39 @@ class ImageRecordIOParser2 {
   #if MXNET_USE_OPENCV
   /*! \brief augmenters */
   std::vector<std::vector<std::unique_ptr<ImageAugmenter> > > augmenters_;
+  /*! \brief per thread decode buffers, reused across records */
+  std::vector<cv::Mat> decode_buf_;
+  /*! \brief per thread buffers of the images resized before they are cached */
+  std::vector<cv::Mat> cache_resize_buf_;
   #endif
+  /*! \brief per thread labels of the current record */
+  std::vector<std::vector<float> > label_buf_;
+  /*! \brief chunks of the decoded image cache */
+  std::vector<CachedChunk> cache_;
+  /*! \brief per thread images of the chunk being parsed, added to cache_ */
+  std::vector<CachedChunk> cache_buf_;
+  /*! \brief order in which the cached chunks are read */
+  std::vector<size_t> cache_order_;
+  /*! \brief next chunk of cache_order_ to read */
+  size_t cache_pos_{0};
+  /*! \brief whether the cache holds a whole epoch */
+  bool cache_ready_{false};
+  /*! \brief number of images and bytes in the cache */
+  size_t cache_images_{0}, cache_bytes_{0};
+  /*! \brief the file holding the cache, empty if it is in memory */
+  std::string cache_file_;
+  /*! \brief stream writing or reading cache_file_ */
+  std::unique_ptr<dmlc::Stream> cache_stream_;
+  /*! \brief the chunk read from cache_file_ */
+  std::vector<char> cache_read_buf_;
+  /*! \brief epoch whose parts are read, if dynamic_parts is set */
+  int epoch_{0};
+  /*! \brief whether source_ reads a part of the current epoch */
+  bool part_open_{true};
+  /*! \brief shorter edge the augmenters resize to, -1 if they do not */
+  int resize_{-1};
+  /*! \brief output set by SetOutput */
+  std::vector<TBlob> out_blobs_;
   /*! \brief random samplers */
   std::vector<std::unique_ptr<common::RANDOM_ENGINE> > prnds_;
   common::RANDOM_ENGINE rnd_;
@@ -106,7 +194,7 @@ class ImageRecordIOParser2 {
 
 template<typename DType>
 inline void ImageRecordIOParser2<DType>::Init(
-    const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    const std::vector<std::pair<std::string, std::string> >& kwargs, int seed_offset) {
 #if MXNET_USE_OPENCV
   // initialize parameter
   // init image rec param
@@ -124,7 +212,8 @@ inline void ImageRecordIOParser2<DType>::Init(
     // be conservative, set number of real cores
     maxthread = std::max(omp_get_num_procs() / 2 - 1, 1);
   }
-  param_.preprocess_threads = std::min(maxthread, param_.preprocess_threads);
+  param_.preprocess_threads = engine::OpenMP::Get()->GetIOThreadCount(
+      std::min(maxthread, param_.preprocess_threads));
   #pragma omp parallel num_threads(param_.preprocess_threads)
   {
     threadget = omp_get_num_threads();
@@ -132,15 +221,22 @@ inline void ImageRecordIOParser2<DType>::Init(
   param_.preprocess_threads = threadget;
 
   std::vector<std::string> aug_names = dmlc::Split(param_.aug_seq, ',');
+  for (const auto& kv : kwargs) {
+    if (kv.first == "resize") resize_ = std::stoi(kv.second);
+  }
   augmenters_.clear();
   augmenters_.resize(threadget);
+  decode_buf_.resize(threadget);
+  cache_resize_buf_.resize(threadget);
+  cache_buf_.resize(threadget);
+  label_buf_.assign(threadget, std::vector<float>(param_.label_width));
   // setup decoders
   for (int i = 0; i < threadget; ++i) {
     for (const auto& aug_name : aug_names) {
       augmenters_[i].emplace_back(ImageAugmenter::Create(aug_name));
       augmenters_[i].back()->Init(kwargs);
     }
-    prnds_.emplace_back(new common::RANDOM_ENGINE((i + 1) * kRandMagic));
+    prnds_.emplace_back(new common::RANDOM_ENGINE((seed_offset + i + 1) * kRandMagic));
   }
   if (param_.path_imglist.length() != 0) {
     label_map_.reset(new ImageLabelMap(param_.path_imglist.c_str(),
@@ -153,10 +249,16 @@ inline void ImageRecordIOParser2<DType>::Init(
     LOG(INFO) << "ImageRecordIOParser2: " << param_.path_imgrec
               << ", use " << threadget << " threads for decoding..";
   }
-  source_.reset(dmlc::InputSplit::Create(
-      param_.path_imgrec.c_str(), param_.part_index,
-      param_.num_parts, "recordio"));
-  if (param_.shuffle_chunk_size > 0) {
+  if (param_.path_imgidx.length() != 0) {
+    source_.reset(new IndexedRecordIOSplit(
+        param_.path_imgrec, param_.path_imgidx, param_.part_index,
+        param_.num_parts, record_param_.shuffle, record_param_.seed));
+  } else {
+    source_.reset(dmlc::InputSplit::Create(
+        param_.path_imgrec.c_str(), param_.part_index,
+        param_.num_parts, "recordio"));
+  }
+  if (param_.shuffle_chunk_size > 0 && param_.path_imgidx.length() == 0) {
     if (param_.shuffle_chunk_size > 4096) {
       LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
                  << " MB which is larger than 4096 MB, please set "
@@ -182,6 +284,19 @@ inline void ImageRecordIOParser2<DType>::Init(
     // use 64 MB chunk when possible
     source_->HintChunkSize(8 << 20UL);
   }
+  if (param_.dynamic_parts > 0) {
+    CHECK_EQ(param_.decoded_cache.length(), 0)
+        << "decoded_cache cannot be used with dynamic_parts, "
+           "which read different records every epoch";
+    part_open_ = false;
+  }
+  if (param_.decoded_cache.length() != 0 && param_.decoded_cache != "mem") {
+    cache_file_ = param_.decoded_cache;
+    if (param_.num_parts > 1) {
+      cache_file_ += ".part" + std::to_string(param_.part_index);
+    }
+    cache_stream_.reset(dmlc::Stream::Create(cache_file_.c_str(), "w"));
+  }
   // Normalize init
   if (!std::is_same<DType, uint8_t>::value) {
     meanimg_.set_pad(false);
@@ -224,16 +339,14 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
   if (overflow)
     return false;
   CHECK(source_ != nullptr);
-  dmlc::InputSplit::Blob chunk;
   unsigned current_size = 0;
   out->index.resize(batch_param_.batch_size);
   while (current_size < batch_param_.batch_size) {
     int n_to_copy;
     if (n_parsed_ == 0) {
-      if (source_->NextChunk(&chunk)) {
+      if (NextChunk()) {
         inst_order_.clear();
         inst_index_ = 0;
-        ParseChunk(&chunk);
         unsigned n_read = 0;
         for (unsigned i = 0; i < temp_.size(); ++i) {
           const InstVector<DType>& tmp = temp_[i];
@@ -253,7 +366,7 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
         CHECK(!overflow) << "number of input images must be bigger than the batch size";
         if (batch_param_.round_batch != 0) {
           overflow = true;
-          source_->BeforeFirst();
+          ResetSource();
         } else {
           current_size = batch_param_.batch_size;
         }
@@ -269,9 +382,9 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
     if (out->data.size() == 0 && n_to_copy != 0) {
       std::pair<unsigned, unsigned> place = inst_order_[inst_index_];
       const DataInst& first_batch = temp_[place.first][place.second];
-      out->data.resize(first_batch.data.size());
+      if (out_blobs_.empty()) out->data.resize(first_batch.data.size());
       unit_size_.resize(first_batch.data.size());
-      for (size_t i = 0; i < out->data.size(); ++i) {
+      for (size_t i = 0; i < first_batch.data.size(); ++i) {
         TShape src_shape = first_batch.data[i].shape_;
         int src_type_flag = first_batch.data[i].type_flag_;
         // init object attributes
@@ -284,7 +397,13 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
         auto dtype = prefetch_param_.dtype
           ? prefetch_param_.dtype.value()
           : first_batch.data[i].type_flag_;
-        out->data.at(i) = NDArray(dst_shape, Context::CPUPinned(0), false, src_type_flag);
+        if (out_blobs_.empty()) {
+          out->data.at(i) = NDArray(dst_shape, Context::CPUPinned(0), false, src_type_flag);
+        } else {
+          CHECK_EQ(out_blobs_.size(), first_batch.data.size());
+          CHECK_EQ(out_blobs_[i].shape_, dst_shape);
+          CHECK_EQ(out_blobs_[i].type_flag_, src_type_flag);
+        }
         unit_size_[i] = src_shape.Size();
       }
     }
@@ -296,9 +415,10 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
       const DataInst& batch = temp_[place.first][place.second];
       for (unsigned j = 0; j < batch.data.size(); ++j) {
         CHECK_EQ(unit_size_[j], batch.data[j].Size());
-        MSHADOW_TYPE_SWITCH(out->data[j].data().type_flag_, dtype, {
+        const TBlob dst = out_blobs_.empty() ? out->data[j].data() : out_blobs_[j];
+        MSHADOW_TYPE_SWITCH(dst.type_flag_, dtype, {
         mshadow::Copy(
-            out->data[j].data().FlatTo1D<cpu, dtype>().Slice((current_size + i) * unit_size_[j],
+            dst.FlatTo1D<cpu, dtype>().Slice((current_size + i) * unit_size_[j],
               (current_size + i + 1) * unit_size_[j]),
             batch.data[j].get_with_shape<cpu, 1, dtype>(mshadow::Shape1(unit_size_[j])));
         });
@@ -310,10 +430,88 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
   return true;
 }
 
+template<typename DType>
+inline bool ImageRecordIOParser2<DType>::NextChunk(void) {
+  if (cache_ready_) {
+    if (cache_pos_ == cache_order_.size()) return false;
+    const CachedChunk& chunk = cache_[cache_order_[cache_pos_++]];
+    const char* data = chunk.data.data();
+    if (cache_file_.length() != 0) {
+      cache_read_buf_.resize(chunk.offset.back());
+      CHECK_EQ(cache_stream_->Read(cache_read_buf_.data(), cache_read_buf_.size()),
+               cache_read_buf_.size())
+          << "Invalid decoded image cache " << cache_file_;
+      data = cache_read_buf_.data();
+    }
+    ParseCachedChunk(data, chunk.offset);
+    return true;
+  }
+  dmlc::InputSplit::Blob chunk;
+  while (!part_open_ || !source_->NextChunk(&chunk)) {
+    if (param_.dynamic_parts > 0) {
+      KVStore* kv = KVStore::DistWorker();
+      CHECK(kv != nullptr) << "dynamic_parts needs the distributed kvstore";
+      const int part = kv->NextPart(param_.path_imgrec, epoch_, param_.dynamic_parts);
+      if (part >= 0) {
+        source_->ResetPartition(part, param_.dynamic_parts);
+        part_open_ = true;
+        continue;
+      }
+      part_open_ = false;
+    }
+    if (param_.decoded_cache.length() != 0) {
+      cache_stream_.reset();
+      cache_order_.resize(cache_.size());
+      std::iota(cache_order_.begin(), cache_order_.end(), 0);
+      cache_pos_ = cache_order_.size();
+      cache_ready_ = true;
+      if (param_.verbose) {
+        LOG(INFO) << "ImageRecordIOParser2: cached " << cache_images_ << " decoded images, "
+                  << (cache_bytes_ >> 20UL) << " MB, in "
+                  << (cache_file_.length() != 0 ? cache_file_ : "memory");
+      }
+    }
+    return false;
+  }
+  ParseChunk(&chunk);
+  return true;
+}
+
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::ResetSource(void) {
+  if (cache_ready_) {
+    cache_pos_ = 0;
+    if (cache_file_.length() != 0) {
+      cache_stream_.reset(dmlc::Stream::Create(cache_file_.c_str(), "r"));
+    } else if (record_param_.shuffle != 0) {
+      // the images are shuffled within a chunk by ParseNext, and the
+      // chunks of the file are read in order
+      std::shuffle(cache_order_.begin(), cache_order_.end(), rnd_);
+    }
+    return;
+  }
+  if (param_.decoded_cache.length() != 0 && cache_.size() != 0) {
+    // the epoch was not read to its end, start caching again
+    cache_.clear();
+    cache_images_ = cache_bytes_ = 0;
+    if (cache_file_.length() != 0) {
+      cache_stream_.reset(dmlc::Stream::Create(cache_file_.c_str(), "w"));
+    }
+  }
+  if (param_.dynamic_parts > 0) {
+    // the parts of the next epoch are asked for when it is read
+    ++epoch_;
+    part_open_ = false;
+    return;
+  }
+  source_->BeforeFirst();
+}
+
 template<typename DType>
 inline void ImageRecordIOParser2<DType>::ParseChunk(dmlc::InputSplit::Blob * chunk) {
   temp_.resize(param_.preprocess_threads);
 #if MXNET_USE_OPENCV
+  const bool caching = param_.decoded_cache.length() != 0;
   // save opencv out
   #pragma omp parallel num_threads(param_.preprocess_threads)
   {
@@ -325,21 +523,36 @@ inline void ImageRecordIOParser2<DType>::ParseChunk(dmlc::InputSplit::Blob * chu
     // image data
     InstVector<DType> &out = temp_[tid];
     out.Clear();
+    cv::Mat& decoded = decode_buf_[tid];
+    float* label = label_buf_[tid].data();
+    CachedChunk& cached = cache_buf_[tid];
+    cached.data.clear();
+    cached.offset.clear();
     while (reader.NextRecord(&blob)) {
-      // Opencv decode and augments
+      // Opencv decode and augments, the decode buffer is only reallocated
+      // when the image size changes
       cv::Mat res;
       rec.Load(blob.dptr, blob.size);
       cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
+      // the augmenters resize the shorter edge to resize_ anyway, so the
+      // image is decoded at the lowest resolution that still covers it
+      int scale_denom = 1;
+      int64_t width, height;
+      if (param_.reduced_decode && resize_ > 0 &&
+          get_jpeg_size(rec.content, rec.content_size, &width, &height)) {
+        scale_denom = height > width ? JpegScaleDenom(width, height, resize_, 0)
+                                     : JpegScaleDenom(width, height, 0, resize_);
+      }
       switch (param_.data_shape[0]) {
        case 1:
-        res = cv::imdecode(buf, 0);
+        res = cv::imdecode(buf, ReducedDecodeFlag(0, scale_denom), &decoded);
         break;
        case 3:
-        res = cv::imdecode(buf, 1);
+        res = cv::imdecode(buf, ReducedDecodeFlag(1, scale_denom), &decoded);
         break;
        case 4:
         // -1 to keep the number of channel of the encoded image, and not force gray or color.
-        res = cv::imdecode(buf, -1);
+        res = cv::imdecode(buf, -1, &decoded);
         CHECK_EQ(res.channels(), 4)
           << "Invalid image with index " << rec.image_index()
           << ". Expected 4 channels, got " << res.channels();
@@ -347,115 +560,209 @@ inline void ImageRecordIOParser2<DType>::ParseChunk(dmlc::InputSplit::Blob * chu
        default:
         LOG(FATAL) << "Invalid output shape " << param_.data_shape;
       }
-      const int n_channels = res.channels();
-      for (auto& aug : augmenters_[tid]) {
-        res = aug->Process(res, nullptr, prnds_[tid].get());
-      }
-      out.Push(static_cast<unsigned>(rec.image_index()),
-               mshadow::Shape3(n_channels, res.rows, res.cols),
-               mshadow::Shape1(param_.label_width));
-
-      mshadow::Tensor<cpu, 3, DType> data = out.data().Back();
-
-      // For RGB or RGBA data, swap the B and R channel:
-      // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-      std::vector<int> swap_indices;
-      if (n_channels == 1) swap_indices = {0};
-      if (n_channels == 3) swap_indices = {2, 1, 0};
-      if (n_channels == 4) swap_indices = {2, 1, 0, 3};
-
-      std::uniform_real_distribution<float> rand_uniform(0, 1);
-      std::bernoulli_distribution coin_flip(0.5);
-      bool is_mirrored = (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid])))
-                         || normalize_param_.mirror;
-      float contrast_scaled;
-      float illumination_scaled;
-      if (!std::is_same<DType, uint8_t>::value) {
-        contrast_scaled =
-          (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_contrast * 2
-          - normalize_param_.max_random_contrast + 1)*normalize_param_.scale;
-        illumination_scaled =
-          (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_illumination * 2
-          - normalize_param_.max_random_illumination) * normalize_param_.scale;
-      }
-      DType RGBA[4] = {};
-      for (int i = 0; i < res.rows; ++i) {
-        uchar* im_data = res.ptr<uchar>(i);
-        for (int j = 0; j < res.cols; ++j) {
-          for (int k = 0; k < n_channels; ++k) {
-            RGBA[k] = im_data[swap_indices[k]];
-          }
-          if (!std::is_same<DType, uint8_t>::value) {
-            // normalize/mirror here to avoid memory copies
-            // logic from iter_normalize.h, function SetOutImg
-
-            if (normalize_param_.mean_r > 0.0f || normalize_param_.mean_g > 0.0f ||
-                normalize_param_.mean_b > 0.0f || normalize_param_.mean_a > 0.0f) {
-              // subtract mean per channel
-              RGBA[0] -= normalize_param_.mean_r;
-              if (n_channels >= 3) {
-                RGBA[1] -= normalize_param_.mean_g;
-                RGBA[2] -= normalize_param_.mean_b;
-              }
-              if (n_channels == 4) {
-                RGBA[3] -= normalize_param_.mean_a;
-              }
-              for (int k = 0; k < n_channels; ++k) {
-                RGBA[k] = RGBA[k] * contrast_scaled + illumination_scaled;
-              }
-            } else if (!meanfile_ready_ || normalize_param_.mean_img.length() == 0) {
-              // do not subtract anything
-              for (int k = 0; k < n_channels; ++k) {
-                RGBA[k] = RGBA[k] * normalize_param_.scale;
-              }
-            } else {
-              CHECK(meanfile_ready_);
-              for (int k = 0; k < n_channels; ++k) {
-                  RGBA[k] = (RGBA[k] - meanimg_[k][i][j]) * contrast_scaled + illumination_scaled;
-              }
-            }
-          }
-          for (int k = 0; k < n_channels; ++k) {
-            if (!std::is_same<DType, uint8_t>::value) {
-              // normalize/mirror here to avoid memory copies
-              // logic from iter_normalize.h, function SetOutImg
-              if (is_mirrored) {
-                data[k][i][res.cols - j - 1] = RGBA[k];
-              } else {
-                data[k][i][j] = RGBA[k];
-              }
-            } else {
-              // do not do normalization in Uint8 reader
-              data[k][i][j] = RGBA[k];
-            }
-          }
-          im_data += n_channels;
-        }
-      }
 
-      mshadow::Tensor<cpu, 1> label = out.label().Back();
       if (label_map_ != nullptr) {
-        mshadow::Copy(label, label_map_->Find(rec.image_index()));
+        mshadow::Copy(mshadow::Tensor<cpu, 1>(label, mshadow::Shape1(param_.label_width)),
+                      label_map_->Find(rec.image_index()));
       } else if (rec.label != NULL) {
         CHECK_EQ(param_.label_width, rec.num_label)
           << "rec file provide " << rec.num_label << "-dimensional label "
              "but label_width is set to " << param_.label_width;
-        mshadow::Copy(label, mshadow::Tensor<cpu, 1>(rec.label,
-                                                     mshadow::Shape1(rec.num_label)));
+        std::copy(rec.label, rec.label + rec.num_label, label);
       } else {
         CHECK_EQ(param_.label_width, 1)
           << "label_width must be 1 unless an imglist is provided "
              "or the rec file is packed with multi dimensional label";
         label[0] = rec.header.label;
       }
+
+      if (caching) {
+        // resize the shorter edge with the same rounding as the resize
+        // augmenter, which then leaves the cached image as it is
+        if (resize_ > 0) {
+          int new_height = resize_, new_width = resize_;
+          if (res.rows > res.cols) {
+            new_height = resize_ * res.rows / res.cols;
+          } else {
+            new_width = resize_ * res.cols / res.rows;
+          }
+          if (new_height != res.rows || new_width != res.cols) {
+            cv::resize(res, cache_resize_buf_[tid], cv::Size(new_width, new_height),
+                       0, 0, cv::INTER_AREA);
+            res = cache_resize_buf_[tid];
+          }
+        }
+        const CachedImageHeader header = {static_cast<uint32_t>(rec.image_index()),
+                                          res.rows, res.cols, res.type()};
+        const size_t label_bytes = param_.label_width * sizeof(float);
+        const size_t row_bytes = res.cols * res.elemSize();
+        const size_t pos = cached.data.size();
+        cached.offset.push_back(pos);
+        cached.data.resize(pos + sizeof(header) + label_bytes + res.rows * row_bytes);
+        char* dst = &cached.data[pos];
+        std::memcpy(dst, &header, sizeof(header));
+        std::memcpy(dst + sizeof(header), label, label_bytes);
+        dst += sizeof(header) + label_bytes;
+        for (int i = 0; i < res.rows; ++i, dst += row_bytes) {
+          std::memcpy(dst, res.ptr<uchar>(i), row_bytes);
+        }
+      }
+      for (int k = 0; k < param_.echo_factor; ++k) {
+        ProcessImage(tid, res, static_cast<unsigned>(rec.image_index()), label, &out);
+      }
       res.release();
     }
   }
+  if (caching) {
+    CachedChunk cached;
+    for (const CachedChunk& buf : cache_buf_) {
+      const size_t base = cached.data.size();
+      for (size_t pos : buf.offset) cached.offset.push_back(base + pos);
+      cached.data.insert(cached.data.end(), buf.data.begin(), buf.data.end());
+    }
+    cached.offset.push_back(cached.data.size());
+    cache_images_ += cached.offset.size() - 1;
+    cache_bytes_ += cached.data.size();
+    if (cache_file_.length() != 0) {
+      cache_stream_->Write(cached.data.data(), cached.data.size());
+      std::vector<char>().swap(cached.data);
+    }
+    cache_.push_back(std::move(cached));
+  }
+#else
+      LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
+#endif
+}
+
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::ParseCachedChunk(const char* data,
+                                                          const std::vector<size_t>& offset) {
+  temp_.resize(param_.preprocess_threads);
+#if MXNET_USE_OPENCV
+  const int num_images = static_cast<int>(offset.size()) - 1;
+  const size_t label_bytes = param_.label_width * sizeof(float);
+  #pragma omp parallel num_threads(param_.preprocess_threads)
+  {
+    int tid = omp_get_thread_num();
+    InstVector<DType> &out = temp_[tid];
+    out.Clear();
+    float* label = label_buf_[tid].data();
+    // contiguous ranges of images, in the order ParseChunk returned them
+    const int begin = num_images * tid / param_.preprocess_threads;
+    const int end = num_images * (tid + 1) / param_.preprocess_threads;
+    for (int i = begin; i < end; ++i) {
+      const char* src = data + offset[i];
+      CachedImageHeader header;
+      std::memcpy(&header, src, sizeof(header));
+      std::memcpy(label, src + sizeof(header), label_bytes);
+      const cv::Mat img(header.rows, header.cols, header.type,
+                        const_cast<char*>(src + sizeof(header) + label_bytes));
+      for (int k = 0; k < param_.echo_factor; ++k) {
+        ProcessImage(tid, img, header.index, label, &out);
+      }
+    }
+  }
 #else
       LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
 #endif
 }
 
+#if MXNET_USE_OPENCV
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::ProcessImage(int tid, const cv::Mat& img,
+                                                      unsigned index, const float* label,
+                                                      InstVector<DType>* out) {
+  cv::Mat res = img;
+  const int n_channels = res.channels();
+  for (auto& aug : augmenters_[tid]) {
+    res = aug->Process(res, nullptr, prnds_[tid].get());
+  }
+  out->Push(index,
+            mshadow::Shape3(n_channels, res.rows, res.cols),
+            mshadow::Shape1(param_.label_width));
+
+  mshadow::Tensor<cpu, 3, DType> data = out->data().Back();
+
+  // For RGB or RGBA data, swap the B and R channel:
+  // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
+  static const int kSwapGray[] = {0};
+  static const int kSwapRGBA[] = {2, 1, 0, 3};
+  const int* swap_indices = n_channels == 1 ? kSwapGray : kSwapRGBA;
+
+  std::uniform_real_distribution<float> rand_uniform(0, 1);
+  std::bernoulli_distribution coin_flip(0.5);
+  bool is_mirrored = (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid])))
+                     || normalize_param_.mirror;
+  float contrast_scaled = 1.0f;
+  float illumination_scaled = 0.0f;
+  if (!std::is_same<DType, uint8_t>::value) {
+    contrast_scaled =
+      (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_contrast * 2
+      - normalize_param_.max_random_contrast + 1)*normalize_param_.scale;
+    illumination_scaled =
+      (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_illumination * 2
+      - normalize_param_.max_random_illumination) * normalize_param_.scale;
+  }
+  // normalize/mirror here to avoid memory copies, logic from
+  // iter_normalize.h, function SetOutImg. The output is
+  // (pixel - mean) * alpha + beta, computed one channel and row at a time
+  // so that the inner loops have no branches and can be vectorized.
+  const bool mean_rgb = normalize_param_.mean_r > 0.0f || normalize_param_.mean_g > 0.0f ||
+                        normalize_param_.mean_b > 0.0f || normalize_param_.mean_a > 0.0f;
+  const bool mean_img = !mean_rgb && meanfile_ready_ &&
+                        normalize_param_.mean_img.length() != 0;
+  float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  if (mean_rgb) {
+    mean[0] = normalize_param_.mean_r;
+    if (n_channels >= 3) {
+      mean[1] = normalize_param_.mean_g;
+      mean[2] = normalize_param_.mean_b;
+    }
+    if (n_channels == 4) {
+      mean[3] = normalize_param_.mean_a;
+    }
+  }
+  float alpha = normalize_param_.scale;
+  float beta = 0.0f;
+  if (mean_rgb || mean_img) {
+    alpha = contrast_scaled;
+    beta = illumination_scaled;
+  }
+  const int cols = res.cols;
+  for (int k = 0; k < n_channels; ++k) {
+    for (int i = 0; i < res.rows; ++i) {
+      const uchar* im_data = res.ptr<uchar>(i) + swap_indices[k];
+      DType* out_data = data[k][i].dptr_;
+      if (std::is_same<DType, uint8_t>::value) {
+        // do not do normalization in Uint8 reader
+        for (int j = 0; j < cols; ++j) {
+          out_data[j] = im_data[j * n_channels];
+        }
+        continue;
+      }
+      const int step = is_mirrored ? -1 : 1;
+      if (is_mirrored) out_data += cols - 1;
+      if (mean_img) {
+        const real_t* mean_data = meanimg_[k][i].dptr_;
+        for (int j = 0; j < cols; ++j) {
+          out_data[j * step] =
+            (static_cast<DType>(im_data[j * n_channels]) - mean_data[j]) * alpha + beta;
+        }
+      } else {
+        const float m = mean[k];
+        for (int j = 0; j < cols; ++j) {
+          out_data[j * step] =
+            (static_cast<DType>(im_data[j * n_channels]) - m) * alpha + beta;
+        }
+      }
+    }
+  }
+
+  mshadow::Tensor<cpu, 1> out_label = out->label().Back();
+  std::copy(label, label + param_.label_width, out_label.dptr_);
+}
+#endif
+
 // create mean image.
 template<typename DType>
 inline void ImageRecordIOParser2<DType>::CreateMeanImg(void) {
@@ -509,6 +816,248 @@ inline void ImageRecordIOParser2<DType>::CreateMeanImg(void) {
     this->BeforeFirst();
 }
 
+#ifndef _WIN32
+/*!
+ * \brief Decodes the batches of ImageRecordIter in worker processes.
+ *
+ *  The workers are forked by Init. Each one parses its own part of the data
+ *  with a single thread and writes the batches into its ring of slots in
+ *  anonymous shared memory. The batches are handed out round-robin over the
+ *  workers as NDArrays on the shared memory, without copies, and a slot goes
+ *  back to its worker at the next call of Next. BeforeFirst bumps an epoch
+ *  counter in the shared memory, the workers then restart their parts and
+ *  the batches they made for the previous epoch are dropped.
+ */
+template<typename DType>
+class ImageRecordProcIter : public IIterator<DataBatch> {
+ public:
+  virtual ~ImageRecordProcIter(void) {
+    if (ctrl_ == nullptr) return;
+    ctrl_->exit.store(1);
+    for (pid_t pid : workers_) waitpid(pid, nullptr, 0);
+    for (DataBatch& batch : batches_) {
+      for (NDArray& arr : batch.data) arr.WaitToWrite();
+    }
+    munmap(ctrl_, bytes_);
+  }
+
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    prefetch_param_.InitAllowUnknown(kwargs);
+    ImageNormalizeParam normalize_param;
+    normalize_param.InitAllowUnknown(kwargs);
+    if (!std::is_same<DType, uint8_t>::value && normalize_param.mean_img.length() != 0) {
+      std::unique_ptr<dmlc::Stream> fi(
+          dmlc::Stream::Create(normalize_param.mean_img.c_str(), "r", true));
+      CHECK(fi != nullptr) << "The mean image must exist with worker_procs, create "
+                           << normalize_param.mean_img << " with worker_procs=0 first";
+    }
+    num_workers_ = param_.worker_procs;
+    // one slot is held by the consumer, the others are prefetched
+    ring_size_ = std::max<size_t>(
+        2, (prefetch_param_.prefetch_buffer + num_workers_ - 1) / num_workers_ + 1);
+    data_shape_ = mshadow::Shape4(batch_param_.batch_size, param_.data_shape[0],
+                                  param_.data_shape[1], param_.data_shape[2]);
+    label_shape_ = mshadow::Shape2(batch_param_.batch_size, param_.label_width);
+    index_offset_ = Align(sizeof(Slot));
+    data_offset_ = index_offset_ + Align(batch_param_.batch_size * sizeof(uint64_t));
+    label_offset_ = data_offset_ + Align(data_shape_.Size() * sizeof(DType));
+    slot_bytes_ = label_offset_ + Align(label_shape_.Size() * sizeof(real_t));
+    bytes_ = Align(sizeof(Control)) + num_workers_ * ring_size_ * slot_bytes_;
+    void* addr = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(addr != MAP_FAILED) << "mmap of " << bytes_ << " bytes failed: " << strerror(errno);
+    // the mapping is zero filled, which is the initial state of the atomics
+    ctrl_ = static_cast<Control*>(addr);
+    const pid_t parent = getpid();
+    for (int w = 0; w < num_workers_; ++w) {
+      pid_t pid = fork();
+      CHECK_GE(pid, 0) << "fork failed: " << strerror(errno);
+      if (pid == 0) {
+        int ret = 0;
+        try {
+          RunWorker(w, kwargs, parent);
+        } catch (const dmlc::Error& e) {
+          LOG(INFO) << "ImageRecordIter worker " << w << " failed: " << e.what();
+          ret = 1;
+        }
+        _exit(ret);
+      }
+      workers_.push_back(pid);
+    }
+    batches_.resize(num_workers_ * ring_size_);
+    for (size_t i = 0; i < batches_.size(); ++i) {
+      char* slot = reinterpret_cast<char*>(GetSlot(i));
+      batches_[i].data.emplace_back(TBlob(reinterpret_cast<DType*>(slot + data_offset_),
+                                          data_shape_, cpu::kDevMask), 0);
+      batches_[i].data.emplace_back(TBlob(reinterpret_cast<real_t*>(slot + label_offset_),
+                                          label_shape_, cpu::kDevMask), 0);
+    }
+    read_pos_.assign(num_workers_, 0);
+    ended_.assign(num_workers_, false);
+  }
+
+  virtual void BeforeFirst(void) {
+    ctrl_->epoch.store(++epoch_, std::memory_order_release);
+    ended_.assign(num_workers_, false);
+    turn_ = 0;
+  }
+
+  virtual bool Next(void) {
+    if (out_ != kNone) {
+      for (NDArray& arr : batches_[out_].data) arr.WaitToWrite();
+      GetSlot(out_)->state.store(kFree, std::memory_order_release);
+      out_ = kNone;
+    }
+    while (std::find(ended_.begin(), ended_.end(), false) != ended_.end()) {
+      const int w = turn_;
+      if (ended_[w]) {
+        turn_ = (turn_ + 1) % num_workers_;
+        continue;
+      }
+      const size_t id = w * ring_size_ + read_pos_[w];
+      Slot* slot = GetSlot(id);
+      int state;
+      while ((state = slot->state.load(std::memory_order_acquire)) == kFree) {
+        CheckWorkers();
+        std::this_thread::sleep_for(std::chrono::microseconds(kPollMicros));
+      }
+      read_pos_[w] = (read_pos_[w] + 1) % ring_size_;
+      if (slot->epoch != epoch_ || state == kEnd) {
+        // a batch of the previous epoch, or the end of the part of the worker
+        if (slot->epoch == epoch_) ended_[w] = true;
+        slot->state.store(kFree, std::memory_order_release);
+        continue;
+      }
+      turn_ = (w + 1) % num_workers_;
+      DataBatch& batch = batches_[id];
+      const uint64_t* index = reinterpret_cast<uint64_t*>(
+          reinterpret_cast<char*>(slot) + index_offset_);
+      batch.index.assign(index, index + batch_param_.batch_size);
+      batch.num_batch_padd = slot->num_batch_padd;
+      out_ = id;
+      return true;
+    }
+    return false;
+  }
+
+  virtual const DataBatch &Value(void) const {
+    return batches_[out_];
+  }
+
+ private:
+  /*! \brief state of a slot */
+  enum SlotState {kFree = 0, kReady, kEnd};
+  /*! \brief header of a slot, followed by the index, data and label of a batch */
+  struct Slot {
+    std::atomic<int> state;
+    int epoch;
+    int num_batch_padd;
+  };
+  /*! \brief control block at the beginning of the shared memory */
+  struct Control {
+    std::atomic<int> epoch;
+    std::atomic<int> exit;
+  };
+  static const size_t kNone = static_cast<size_t>(-1);
+  static const int kPollMicros = 100;
+  static size_t Align(size_t bytes) {
+    return (bytes + 63) / 64 * 64;
+  }
+  Slot* GetSlot(size_t id) const {
+    return reinterpret_cast<Slot*>(
+        reinterpret_cast<char*>(ctrl_) + Align(sizeof(Control)) + id * slot_bytes_);
+  }
+  /*! \brief fail if a worker has exited */
+  void CheckWorkers() {
+    for (pid_t pid : workers_) {
+      int status;
+      CHECK_EQ(waitpid(pid, &status, WNOHANG), 0)
+          << "ImageRecordIter worker process " << pid << " exited";
+    }
+  }
+  /*! \brief body of worker process w */
+  void RunWorker(int w, const std::vector<std::pair<std::string, std::string> >& kwargs,
+                 pid_t parent) {
+    // the OpenMP thread pool of the parent does not survive the fork
+    omp_set_num_threads(1);
+    std::vector<std::pair<std::string, std::string> > args;
+    for (const auto& kv : kwargs) {
+      if (kv.first != "preprocess_threads" && kv.first != "num_parts" &&
+          kv.first != "part_index" && kv.first != "worker_procs") {
+        args.push_back(kv);
+      }
+    }
+    args.emplace_back("preprocess_threads", "1");
+    args.emplace_back("num_parts", std::to_string(param_.num_parts * num_workers_));
+    args.emplace_back("part_index", std::to_string(param_.part_index * num_workers_ + w));
+    ImageRecordIOParser2<DType> parser;
+    parser.Init(args, w);
+    int epoch = 0;
+    size_t next = 0;
+    bool end = false;
+    DataBatch batch;
+    while (ctrl_->exit.load() == 0 && getppid() == parent) {
+      const int e = ctrl_->epoch.load(std::memory_order_acquire);
+      if (e != epoch) {
+        parser.BeforeFirst();
+        epoch = e;
+        end = false;
+      }
+      const size_t id = w * ring_size_ + next;
+      Slot* slot = GetSlot(id);
+      if (end || slot->state.load(std::memory_order_acquire) != kFree) {
+        std::this_thread::sleep_for(std::chrono::microseconds(kPollMicros));
+        continue;
+      }
+      char* base = reinterpret_cast<char*>(slot);
+      parser.SetOutput({TBlob(reinterpret_cast<DType*>(base + data_offset_),
+                              data_shape_, cpu::kDevMask),
+                        TBlob(reinterpret_cast<real_t*>(base + label_offset_),
+                              label_shape_, cpu::kDevMask)});
+      end = !parser.ParseNext(&batch);
+      if (!end) {
+        std::copy(batch.index.begin(), batch.index.end(),
+                  reinterpret_cast<uint64_t*>(base + index_offset_));
+        slot->num_batch_padd = batch.num_batch_padd;
+      }
+      slot->epoch = epoch;
+      slot->state.store(end ? kEnd : kReady, std::memory_order_release);
+      next = (next + 1) % ring_size_;
+    }
+  }
+  /*! \brief parameters */
+  ImageRecParserParam param_;
+  BatchParam batch_param_;
+  PrefetcherParam prefetch_param_;
+  /*! \brief worker processes */
+  int num_workers_{0};
+  std::vector<pid_t> workers_;
+  /*! \brief shared memory, starting with the control block */
+  Control* ctrl_{nullptr};
+  size_t bytes_{0};
+  /*! \brief number of slots per worker */
+  size_t ring_size_{0};
+  /*! \brief size of a slot and offsets in it */
+  size_t slot_bytes_{0}, index_offset_{0}, data_offset_{0}, label_offset_{0};
+  mshadow::Shape<4> data_shape_;
+  mshadow::Shape<2> label_shape_;
+  /*! \brief NDArrays on the batches of the slots */
+  std::vector<DataBatch> batches_;
+  /*! \brief next slot to read of every worker */
+  std::vector<size_t> read_pos_;
+  /*! \brief whether every worker's part of the epoch is done */
+  std::vector<bool> ended_;
+  /*! \brief worker of the next batch */
+  int turn_{0};
+  /*! \brief current epoch */
+  int epoch_{0};
+  /*! \brief slot of the current batch */
+  size_t out_{kNone};
+};
+#endif  // _WIN32
+
 template<typename DType = real_t>
 class ImageRecordIter2 : public IIterator<DataBatch> {
  public:
@@ -520,6 +1069,19 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
 
     virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
       prefetch_param_.InitAllowUnknown(kwargs);
+      ImageRecParserParam param;
+      param.InitAllowUnknown(kwargs);
+      CHECK(param.worker_procs == 0 || param.dynamic_parts == 0)
+          << "dynamic_parts cannot be used with worker_procs";
+      if (param.worker_procs > 0) {
+#ifndef _WIN32
+        proc_iter_.reset(new ImageRecordProcIter<DType>());
+        proc_iter_->Init(kwargs);
+        return;
+#else
+        LOG(FATAL) << "worker_procs is not supported on Windows";
+#endif
+      }
       parser_.Init(kwargs);
       // maximum prefetch threaded iter internal size
       const int kMaxPrefetchBuffer = 16;
@@ -536,11 +1098,13 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     }
 
     virtual void BeforeFirst(void) {
+      if (proc_iter_ != nullptr) return proc_iter_->BeforeFirst();
       iter_.BeforeFirst();
     }
 
     // From iter_prefetcher.h
     virtual bool Next(void) {
+      if (proc_iter_ != nullptr) return proc_iter_->Next();
       if (out_ != nullptr) {
         recycle_queue_.push(out_); out_ = nullptr;
       }
@@ -558,10 +1122,13 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     }
 
     virtual const DataBatch &Value(void) const {
+      if (proc_iter_ != nullptr) return proc_iter_->Value();
       return *out_;
     }
 
  private:
+    /*! \brief decoding in worker processes, if worker_procs is set */
+    std::unique_ptr<IIterator<DataBatch> > proc_iter_;
     /*! \brief Backend thread */
     dmlc::ThreadedIter<DataBatch> iter_;
     /*! \brief Parameters */
@@ -615,6 +1182,10 @@ MXNET_REGISTER_IO_ITER(ImageRecordUInt8Iter)
 This iterator is identical to ``ImageRecordIter`` except for using ``uint8`` as
 the data type instead of ``float``.
 
+The batches are not normalized. Apply ``contrib.normalize_image`` to them on the
+GPU to normalize and randomly mirror them there, which copies 4x less data to
+the device and leaves the CPU threads to decoding.
+
 )code" ADD_FILELINE)
 .add_arguments(ImageRecParserParam::__FIELDS__())
 .add_arguments(ImageRecordParam::__FIELDS__())
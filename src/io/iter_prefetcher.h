@@ -39,6 +39,7 @@
 #include <algorithm>
 #include "./inst_vector.h"
 #include "./image_iter_common.h"
+#include "./iter_batchloader.h"
 
 namespace mxnet {
 namespace io {
@@ -72,7 +73,16 @@ class PrefetcherIter : public IIterator<DataBatch> {
     InitParams(kwargs);
     // use the kwarg to init batch loader
     loader_->Init(kwargs);
-    iter.Init([this](DataBatch **dptr) {
+    // a batch loader writes the batches directly into the recycled buffers
+    BatchLoader* direct_loader = dynamic_cast<BatchLoader*>(loader_.get());
+    iter.Init([this, direct_loader](DataBatch **dptr) {
+        if (direct_loader != nullptr) {
+          std::vector<TBlob> out;
+          if (*dptr != nullptr && !param_.dtype) {
+            for (const NDArray& arr : (*dptr)->data) out.push_back(arr.data());
+          }
+          direct_loader->SetOutput(out);
+        }
         if (!loader_->Next()) return false;
         const TBlobBatch& batch = loader_->Value();
         if (*dptr == nullptr) {
@@ -86,19 +96,21 @@ class PrefetcherIter : public IIterator<DataBatch> {
                              ? param_.dtype.value()
                              : batch.data[i].type_flag_;
             (*dptr)->data.at(i) = NDArray(batch.data[i].shape_,
-                                          Context::CPU(), false,
-                                          dtype);
+                                          Context::Create(
+                                            static_cast<Context::DeviceType>(param_.ctx), 0),
+                                          false, dtype);
           }
         }
         CHECK(batch.data.size() == (*dptr)->data.size());
-        // copy data over
+        // copy data over, unless the loader wrote it in place
         for (size_t i = 0; i < batch.data.size(); ++i) {
           CHECK_EQ((*dptr)->data.at(i).shape(), batch.data[i].shape_);
+          (*dptr)->num_batch_padd = batch.num_batch_padd;
+          if ((*dptr)->data.at(i).data().dptr_ == batch.data[i].dptr_) continue;
           MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, DType, {
               mshadow::Copy(((*dptr)->data)[i].data().FlatTo2D<cpu, DType>(),
                         batch.data[i].FlatTo2D<cpu, DType>());
           });
-          (*dptr)->num_batch_padd = batch.num_batch_padd;
         }
         if (batch.inst_index) {
           std::copy(batch.inst_index,
@@ -0,0 +1,268 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file text_parser.h
+ * \brief parse LibSVM and CSV files with a configurable number of threads
+ */
+#ifndef MXNET_IO_TEXT_PARSER_H_
+#define MXNET_IO_TEXT_PARSER_H_
+#include <dmlc/base.h>
+#include <dmlc/data.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/threadediter.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief Parser of LibSVM and CSV text splitting every chunk of the input
+ *  between nthread OpenMP threads, while the next chunk is read and parsed
+ *  in the background. The rows are returned in the order of the files, one
+ *  row block per thread and chunk.
+ */
+template<typename IndexType>
+class ParallelTextParser : public dmlc::Parser<IndexType> {
+ public:
+  /*! \brief format of the text */
+  enum Format {kLibSVM, kCSV};
+  /*!
+   * \param uri path of the files
+   * \param part_index the part of the files to read
+   * \param num_parts the number of parts the files are split into
+   * \param format format of the text
+   * \param nthread the number of parsing threads
+   */
+  ParallelTextParser(const char* uri, unsigned part_index, unsigned num_parts,
+                     Format format, int nthread)
+      : format_(format), nthread_(std::max(nthread, 1)) {
+    source_.reset(dmlc::InputSplit::Create(uri, part_index, num_parts, "text"));
+    iter_.set_max_capacity(2);
+    iter_.Init([this](std::vector<Block>** dptr) {
+        if (*dptr == nullptr) *dptr = new std::vector<Block>();
+        return ParseChunk(*dptr);
+      },
+      [this]() { source_->BeforeFirst(); });
+  }
+  virtual ~ParallelTextParser() {
+    iter_.Destroy();
+  }
+  virtual void BeforeFirst() {
+    if (blocks_ != nullptr) iter_.Recycle(&blocks_);
+    iter_.BeforeFirst();
+    pos_ = 0;
+  }
+  virtual bool Next() {
+    while (true) {
+      while (blocks_ != nullptr && pos_ < blocks_->size()) {
+        const Block& b = (*blocks_)[pos_++];
+        if (b.offset.size() > 1) {
+          value_ = b.GetBlock();
+          return true;
+        }
+      }
+      if (blocks_ != nullptr) iter_.Recycle(&blocks_);
+      if (!iter_.Next(&blocks_)) return false;
+      pos_ = 0;
+    }
+  }
+  virtual const dmlc::RowBlock<IndexType>& Value() const {
+    return value_;
+  }
+  virtual size_t BytesRead() const {
+    return bytes_read_;
+  }
+
+ private:
+  /*! \brief the rows parsed by one thread */
+  struct Block {
+    std::vector<size_t> offset;
+    std::vector<real_t> label;
+    std::vector<IndexType> index;
+    std::vector<real_t> value;
+    inline void Clear() {
+      offset.assign(1, 0);
+      label.clear();
+      index.clear();
+      value.clear();
+    }
+    inline dmlc::RowBlock<IndexType> GetBlock() const {
+      dmlc::RowBlock<IndexType> b = dmlc::RowBlock<IndexType>();
+      b.size = offset.size() - 1;
+      b.offset = offset.data();
+      b.label = label.data();
+      b.weight = nullptr;
+      b.index = index.data();
+      b.value = value.data();
+      return b;
+    }
+  };
+  /*! \brief whether c ends a line */
+  static inline bool IsEndLine(char c) {
+    return c == '\n' || c == '\r';
+  }
+  static inline bool IsBlank(char c) {
+    return c == ' ' || c == '\t';
+  }
+  /*! \brief the beginning of the line holding p, or begin */
+  static inline const char* BackFindEndLine(const char* p, const char* begin) {
+    while (p != begin && !IsEndLine(*(p - 1))) --p;
+    return p;
+  }
+  /*! \brief parse the number in [begin, end), which is not null terminated */
+  static inline real_t ParseFloat(const char* begin, const char* end) {
+    char buf[64];
+    size_t len = std::min(static_cast<size_t>(end - begin), sizeof(buf) - 1);
+    std::memcpy(buf, begin, len);
+    buf[len] = '\0';
+    return static_cast<real_t>(std::strtod(buf, nullptr));
+  }
+  static inline IndexType ParseIndex(const char* begin, const char* end) {
+    IndexType ret = 0;
+    for (const char* p = begin; p != end && *p >= '0' && *p <= '9'; ++p) {
+      ret = ret * 10 + static_cast<IndexType>(*p - '0');
+    }
+    return ret;
+  }
+  /*! \brief parse the line [begin, end) of a LibSVM file */
+  static void ParseLibSVMLine(const char* begin, const char* end, Block* out) {
+    const char* p = begin;
+    while (p != end && IsBlank(*p)) ++p;
+    if (p == end || *p == '#') return;
+    const char* q = p;
+    while (q != end && !IsBlank(*q) && *q != ':') ++q;
+    out->label.push_back(ParseFloat(p, q));
+    // skip the weight of the instance
+    while (q != end && !IsBlank(*q)) ++q;
+    while (true) {
+      p = q;
+      while (p != end && IsBlank(*p)) ++p;
+      if (p == end || *p == '#') break;
+      q = p;
+      while (q != end && !IsBlank(*q)) ++q;
+      if (q - p > 4 && std::strncmp(p, "qid:", 4) == 0) continue;
+      const char* colon = static_cast<const char*>(std::memchr(p, ':', q - p));
+      out->index.push_back(ParseIndex(p, colon != nullptr ? colon : q));
+      out->value.push_back(colon != nullptr ? ParseFloat(colon + 1, q) : 1.0f);
+    }
+    out->offset.push_back(out->index.size());
+  }
+  /*! \brief parse the line [begin, end) of a CSV file */
+  static void ParseCSVLine(const char* begin, const char* end, Block* out) {
+    if (begin == end) return;
+    IndexType column = 0;
+    const char* p = begin;
+    while (true) {
+      const char* q = static_cast<const char*>(std::memchr(p, ',', end - p));
+      if (q == nullptr) q = end;
+      out->index.push_back(column++);
+      out->value.push_back(ParseFloat(p, q));
+      if (q == end) break;
+      p = q + 1;
+    }
+    out->label.push_back(0.0f);
+    out->offset.push_back(out->index.size());
+  }
+  /*! \brief read the next chunk and parse it into one block per thread */
+  bool ParseChunk(std::vector<Block>* blocks) {
+    dmlc::InputSplit::Blob chunk;
+    if (!source_->NextChunk(&chunk)) return false;
+    bytes_read_ += chunk.size;
+    const char* head = static_cast<const char*>(chunk.dptr);
+    const char* tail = head + chunk.size;
+    blocks->resize(nthread_);
+    #pragma omp parallel num_threads(nthread_)
+    {
+      const int nthread = omp_get_num_threads();
+      const int tid = omp_get_thread_num();
+      // the threads that are not started leave their block empty
+      for (int i = tid; i < nthread_; i += nthread) {
+        const size_t step = (chunk.size + nthread_ - 1) / nthread_;
+        const char* begin = BackFindEndLine(head + std::min(chunk.size, step * i), head);
+        const char* end = i + 1 == nthread_ ? tail :
+            BackFindEndLine(head + std::min(chunk.size, step * (i + 1)), head);
+        Block* out = &(*blocks)[i];
+        out->Clear();
+        while (begin < end) {
+          const char* lend = begin;
+          while (lend != end && !IsEndLine(*lend)) ++lend;
+          if (format_ == kLibSVM) {
+            ParseLibSVMLine(begin, lend, out);
+          } else {
+            ParseCSVLine(begin, lend, out);
+          }
+          begin = lend;
+          while (begin != end && IsEndLine(*begin)) ++begin;
+        }
+      }
+    }
+    return true;
+  }
+  // format of the text
+  Format format_;
+  // number of parsing threads
+  int nthread_;
+  // bytes read from the source
+  std::atomic<size_t> bytes_read_{0};
+  // the input split
+  std::unique_ptr<dmlc::InputSplit> source_;
+  // the parsed chunks
+  dmlc::ThreadedIter<std::vector<Block> > iter_;
+  // blocks of the current chunk and the next one to return
+  std::vector<Block>* blocks_{nullptr};
+  size_t pos_{0};
+  // the current row block
+  dmlc::RowBlock<IndexType> value_;
+};
+
+/*!
+ * \brief create a parser of a LibSVM or CSV file
+ * \param nthread the number of parsing threads, the parser of dmlc-core is
+ *  used if it is 0
+ */
+template<typename IndexType>
+inline dmlc::Parser<IndexType>* CreateTextParser(const std::string& uri,
+                                                 unsigned part_index,
+                                                 unsigned num_parts,
+                                                 const std::string& type,
+                                                 int nthread) {
+  if (nthread == 0) {
+    return dmlc::Parser<IndexType>::Create(uri.c_str(), part_index, num_parts, type.c_str());
+  }
+  CHECK(type == "libsvm" || type == "csv") << "Unknown text format " << type;
+  return new ParallelTextParser<IndexType>(
+      uri.c_str(), part_index, num_parts,
+      type == "libsvm" ? ParallelTextParser<IndexType>::kLibSVM :
+                         ParallelTextParser<IndexType>::kCSV, nthread);
+}
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_TEXT_PARSER_H_
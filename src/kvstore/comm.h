@@ -24,9 +24,11 @@
 #include <dmlc/omp.h>
 #include <string>
 #include <algorithm>
+#include <set>
 #include <utility>
 #include <limits>
 #include <vector>
+#include <memory>
 #include <tuple>
 #include <thread>
 #include "mxnet/ndarray.h"
@@ -53,12 +55,38 @@ class Comm {
    */
   virtual const NDArray& Reduce(
       int key, const std::vector<NDArray>& src, int priority) = 0;
+  /**
+   * \brief reduces the values of several keys, merged[i] is the sum of srcs[i]
+   *
+   * The results are valid as long as the ones returned by Reduce. The default
+   * implementation reduces the keys one by one.
+   */
+  virtual void BatchReduce(const std::vector<int>& keys,
+                           const std::vector<std::vector<NDArray> >& srcs,
+                           int priority, std::vector<NDArray>* merged) {
+    merged->resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      (*merged)[i] = Reduce(keys[i], srcs[i], priority);
+    }
+  }
   /**
    * \brief copy from src to dst[i] for every i
    */
   virtual void Broadcast(
       int key, const NDArray& src,
       const std::vector<NDArray*> dst, int priority) = 0;
+  /**
+   * \brief broadcasts the values of several keys, srcs[i] is copied to every
+   *  array of dsts[i]. The default implementation broadcasts the keys one by one.
+   */
+  virtual void BatchBroadcast(const std::vector<int>& keys,
+                              const std::vector<NDArray>& srcs,
+                              const std::vector<std::vector<NDArray*> >& dsts,
+                              int priority) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      Broadcast(keys[i], srcs[i], dsts[i], priority);
+    }
+  }
 
   /**
    * \brief broadcast src to dst[i] with target row_ids for every i
@@ -121,22 +149,9 @@ class CommCPU : public Comm {
     }
 
     if (buf.merged.storage_type() == kDefaultStorage) {
+      std::vector<NDArray> reduce = CopyToMergeBuf(key, src, priority);
       std::vector<Engine::VarHandle> const_vars(src.size() - 1);
-      std::vector<NDArray> reduce(src.size());
-      CopyFromTo(src[0], &buf.merged, priority);
-      reduce[0] = buf.merged;
-
-      if (buf.copy_buf.empty()) {
-        buf.copy_buf.resize(src.size()-1);
-        for (size_t j = 0; j < src.size() - 1; ++j) {
-          // allocate NDArray basd on storage type
-          buf.copy_buf[j] = NDArray(
-            src[0].shape(), pinned_ctx_, false, src[0].dtype());
-        }
-      }
       for (size_t i = 1; i < src.size(); ++i) {
-        CopyFromTo(src[i], &(buf.copy_buf[i-1]), priority);
-        reduce[i] = buf.copy_buf[i-1];
         const_vars[i-1] = reduce[i].var();
       }
 
@@ -175,6 +190,38 @@ class CommCPU : public Comm {
     return buf.merged;
   }
 
+  /**
+   * \brief the dense keys smaller than MXNET_KVSTORE_BIGARRAY_BOUND are summed
+   *  together in one engine operator, which spreads the keys over
+   *  MXNET_KVSTORE_REDUCTION_NTHREADS threads. A batch is closed once it
+   *  holds MXNET_KVSTORE_BIGARRAY_BOUND values, so that the updates of the
+   *  first keys can start while the next ones are summed.
+   */
+  void BatchReduce(const std::vector<int>& keys,
+                   const std::vector<std::vector<NDArray> >& srcs,
+                   int priority, std::vector<NDArray>* merged) override {
+    merged->resize(keys.size());
+    std::vector<std::vector<NDArray> > batch;
+    size_t batch_size = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const std::vector<NDArray>& src = srcs[i];
+      auto& buf = merge_buf_[keys[i]];
+      if (src.size() == 1 || buf.merged.storage_type() != kDefaultStorage ||
+          src[0].shape().Size() >= bigarray_bound_) {
+        (*merged)[i] = Reduce(keys[i], src, priority);
+        continue;
+      }
+      batch.push_back(CopyToMergeBuf(keys[i], src, priority));
+      batch_size += src[0].shape().Size();
+      (*merged)[i] = buf.merged;
+      if (batch_size >= bigarray_bound_) {
+        PushBatchReduce(&batch, priority);
+        batch_size = 0;
+      }
+    }
+    if (!batch.empty()) PushBatchReduce(&batch, priority);
+  }
+
   void Broadcast(int key, const NDArray& src,
                  const std::vector<NDArray*> dst, int priority) override {
     int mask = src.ctx().dev_mask();
@@ -238,6 +285,58 @@ class CommCPU : public Comm {
   }
 
  private:
+  /*!
+   * \brief copy the dense values of key to its cpu buffers
+   * \return the buffers, the sum is written to the first one
+   */
+  std::vector<NDArray> CopyToMergeBuf(int key, const std::vector<NDArray>& src,
+                                      int priority) {
+    auto& buf = merge_buf_[key];
+    std::vector<NDArray> reduce(src.size());
+    CopyFromTo(src[0], &buf.merged, priority);
+    reduce[0] = buf.merged;
+
+    if (buf.copy_buf.empty()) {
+      buf.copy_buf.resize(src.size()-1);
+      for (size_t j = 0; j < src.size() - 1; ++j) {
+        // allocate NDArray basd on storage type
+        buf.copy_buf[j] = NDArray(
+          src[0].shape(), pinned_ctx_, false, src[0].dtype());
+      }
+    }
+    for (size_t i = 1; i < src.size(); ++i) {
+      CopyFromTo(src[i], &(buf.copy_buf[i-1]), priority);
+      reduce[i] = buf.copy_buf[i-1];
+    }
+    return reduce;
+  }
+
+  /*!
+   * \brief push one operator summing the buffers of all keys in batch,
+   *  batch is cleared afterwards
+   */
+  void PushBatchReduce(std::vector<std::vector<NDArray> >* batch, int priority) {
+    std::vector<Engine::VarHandle> const_vars, mutable_vars;
+    size_t total = 0;
+    for (const auto& reduce : *batch) {
+      mutable_vars.push_back(reduce[0].var());
+      for (size_t i = 1; i < reduce.size(); ++i) const_vars.push_back(reduce[i].var());
+      total += reduce[0].shape().Size() * reduce.size();
+    }
+    auto reduces = std::make_shared<std::vector<std::vector<NDArray> > >();
+    reduces->swap(*batch);
+    // the keys are small, the threads only pay off for enough of them
+    const int nthread = total < (16 << 10) ? 1 : nthread_reduction_;
+    Engine::Get()->PushSync([reduces, nthread, this](RunContext rctx) {
+        const long nkeys = static_cast<long>(reduces->size());  // NOLINT(*)
+        #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+        for (long j = 0; j < nkeys; ++j) {  // NOLINT(*)
+          ReduceSumCPU((*reduces)[j]);
+        }
+      }, Context::CPU(), const_vars, mutable_vars,
+      FnProperty::kCPUPrioritized, priority, PROFILER_MESSAGE("KVStoreBatchReduce"));
+  }
+
   /*!
    * \brief When src is a rsp with full rows,
    * simply copy retained rows directly from cpu to gpu
@@ -285,8 +384,13 @@ class CommCPU : public Comm {
             Shape2(src_data.shape_[0], row_length), cpu_stream);
         Tensor<gpu, 2, DType> dst_data_tensor = dst_data.get_with_shape<gpu, 2, DType>(
             Shape2(dst_data.shape_[0], row_length), gpu_stream);
-        for (size_t i = 0; i < num_rows_retained; ++i) {
-          Copy(dst_data_tensor[i], src_data_tensor[idx_tensor[i]], gpu_stream);
+        // the rows of consecutive indices are copied at once
+        for (size_t i = 0; i < num_rows_retained;) {
+          size_t end = i + 1;
+          while (end < num_rows_retained && idx_tensor[end] == idx_tensor[end - 1] + 1) ++end;
+          Copy(dst_data_tensor.Slice(i, end),
+               src_data_tensor.Slice(idx_tensor[i], idx_tensor[i] + (end - i)), gpu_stream);
+          i = end;
         }
       })
     })
@@ -461,6 +565,7 @@ class CommDevice : public Comm {
  public:
   CommDevice() {
     inited_ = false;
+    use_tree_ = dmlc::GetEnv("MXNET_KVSTORE_USETREE", 0);
   }
 
   virtual ~CommDevice() { }
@@ -494,6 +599,7 @@ class CommDevice : public Comm {
     }
 
     auto& buf = merge_buf_[key];
+    if (use_tree_) return ReduceTree(key, src, priority);
     std::vector<NDArray> reduce(src.size());
     CopyFromTo(src[0], &(buf.merged), priority);
     reduce[0] = buf.merged;
@@ -533,6 +639,10 @@ class CommDevice : public Comm {
     } else {
       auto& buf = merge_buf_[key];
       CopyFromTo(src, &buf.merged, priority);
+      if (use_tree_ && dst.size() > 1) {
+        BroadcastTree(buf.merged, dst, priority);
+        return;
+      }
       for (auto d : dst) {
         CopyFromTo(buf.merged, d, priority);
       }
@@ -568,6 +678,7 @@ class CommDevice : public Comm {
           if (e == cudaSuccess || e == cudaErrorPeerAccessAlreadyEnabled) {
             ++enabled;
             p2p[i*n+j] = 1;
+            peer_access_.insert(std::make_pair(gpus[i], gpus[j]));
           }
         }
       }
@@ -589,6 +700,124 @@ class CommDevice : public Comm {
 #endif
   }
 
+  /*! \brief pairs (receiver, sender) of array indices exchanged at one level */
+  using TreeLevel = std::vector<std::pair<size_t, size_t>>;
+  /*!
+   * \brief build a binary tree over the devices of ctxs rooted at root. At
+   *  every level each remaining device is paired with another one, preferring
+   *  a peer it has direct access to; the sender drops out of the next level.
+   *  The pairs of a level use distinct links, so their copies run concurrently
+   *  and no device handles more than log2(n) copies.
+   */
+  std::vector<TreeLevel> TreeSchedule(const std::vector<Context>& ctxs, size_t root) {
+    std::vector<size_t> active = {root};
+    for (size_t i = 0; i < ctxs.size(); ++i) {
+      if (i != root) active.push_back(i);
+    }
+    std::vector<TreeLevel> levels;
+    while (active.size() > 1) {
+      TreeLevel level;
+      std::vector<size_t> next;
+      std::vector<bool> used(active.size(), false);
+      for (size_t i = 0; i < active.size(); ++i) {
+        if (used[i]) continue;
+        used[i] = true;
+        next.push_back(active[i]);
+        size_t pick = active.size();
+        for (size_t j = i + 1; j < active.size(); ++j) {
+          if (used[j]) continue;
+          if (pick == active.size()) pick = j;
+          if (HasPeerAccess(ctxs[active[i]], ctxs[active[j]])) {
+            pick = j;
+            break;
+          }
+        }
+        if (pick != active.size()) {
+          used[pick] = true;
+          level.emplace_back(active[i], active[pick]);
+        }
+      }
+      levels.push_back(level);
+      active.swap(next);
+    }
+    return levels;
+  }
+
+  bool HasPeerAccess(const Context& a, const Context& b) const {
+    if (a.dev_mask() != b.dev_mask()) return false;
+    return peer_access_.count(std::make_pair(a.dev_id, b.dev_id)) ||
+        peer_access_.count(std::make_pair(b.dev_id, a.dev_id));
+  }
+
+  /*! \brief index of the context equal to ctx, or 0 if there is none */
+  static size_t FindRoot(const std::vector<Context>& ctxs, const Context& ctx) {
+    for (size_t i = 0; i < ctxs.size(); ++i) {
+      if (ctxs[i] == ctx) return i;
+    }
+    return 0;
+  }
+
+  /*!
+   * \brief reduce src along a binary tree. Every receiving device adds the
+   *  partial sum of its sender into a buffer on itself, the root being the
+   *  device of the merge buffer, whose sum buffer is the merge buffer.
+   */
+  const NDArray& ReduceTree(int key, const std::vector<NDArray>& src, int priority) {
+    auto* buf = &merge_buf_[key];
+    std::vector<Context> ctxs;
+    for (const auto& a : src) ctxs.push_back(a.ctx());
+    size_t root = FindRoot(ctxs, buf->merged.ctx());
+    if (buf->tree_sum.empty()) {
+      buf->tree_sum.resize(src.size());
+      buf->tree_recv.resize(src.size());
+    }
+    auto alloc = [&](NDArray* arr, const Context& ctx) {
+      if (arr->is_none()) {
+        *arr = NDArray(buf->merged.shape(), ctx, false, buf->merged.dtype());
+      }
+    };
+    if (ctxs[root] == buf->merged.ctx()) buf->tree_sum[root] = buf->merged;
+    std::vector<bool> summed(src.size(), false);
+    for (const auto& level : TreeSchedule(ctxs, root)) {
+      for (const auto& pair : level) {
+        size_t to = pair.first, from = pair.second;
+        NDArray& recv = buf->tree_recv[to];
+        NDArray& sum = buf->tree_sum[to];
+        alloc(&recv, ctxs[to]);
+        alloc(&sum, ctxs[to]);
+        CopyFromTo(summed[from] ? buf->tree_sum[from] : src[from], &recv, priority);
+        if (summed[to]) {
+          sum += recv;
+        } else {
+          ElementwiseSum({src[to], recv}, &sum, priority);
+          summed[to] = true;
+        }
+      }
+    }
+    if (buf->tree_sum[root].var() != buf->merged.var()) {
+      CopyFromTo(buf->tree_sum[root], &buf->merged, priority);
+    }
+    return buf->merged;
+  }
+
+  /*!
+   * \brief broadcast src along the tree used by ReduceTree, walked from the
+   *  root down, so that every device forwards the value it has received.
+   */
+  void BroadcastTree(const NDArray& src, const std::vector<NDArray*>& dst,
+                     int priority) {
+    std::vector<Context> ctxs;
+    for (const auto d : dst) ctxs.push_back(d->ctx());
+    size_t root = FindRoot(ctxs, src.ctx());
+    CopyFromTo(src, dst[root], priority);
+    auto levels = TreeSchedule(ctxs, root);
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+      for (const auto& pair : *it) {
+        CopyFromTo(*dst[pair.first], dst[pair.second], priority);
+      }
+    }
+  }
+
   using KeyAttrs = std::tuple<int, TShape, int>;
   // try to allocate buff on device evenly
   void InitMergeBuffer(const std::vector<Context>& devs) {
@@ -628,9 +857,17 @@ class CommDevice : public Comm {
     NDArray merged;
     /// \brief the gpu buffer
     std::vector<NDArray> copy_buf;
+    /// \brief partial sums of the tree reduce, on the device of each source
+    std::vector<NDArray> tree_sum;
+    /// \brief values received by the tree reduce, on the device of each source
+    std::vector<NDArray> tree_recv;
   };
   std::unordered_map<int, BufferEntry> merge_buf_;
   bool inited_;
+  /// \brief whether to reduce and broadcast along a tree over the devices
+  bool use_tree_;
+  /// \brief pairs of gpu ids with direct peer access enabled
+  std::set<std::pair<int, int>> peer_access_;
 };
 
 }  // namespace kvstore
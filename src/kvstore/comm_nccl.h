@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file comm_nccl.h
+ * \brief Reduce and broadcast over the GPUs of a machine with NCCL
+ */
+#ifndef MXNET_KVSTORE_COMM_NCCL_H_
+#define MXNET_KVSTORE_COMM_NCCL_H_
+#if MXNET_USE_NCCL
+#include <nccl.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./comm.h"
+#include "../common/cuda_utils.h"
+
+/*! \brief check the result of a NCCL call */
+#define NCCL_CALL(func)                                                    \
+  {                                                                        \
+    ncclResult_t e = (func);                                               \
+    CHECK_EQ(e, ncclSuccess) << "NCCL: " << ncclGetErrorString(e);         \
+  }
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief an implementation of Comm with the collectives of NCCL.
+ *
+ *  The sum of a key is a ncclReduce of the values of all the GPUs into the
+ *  merge buffer of the key, on a root GPU chosen to balance the buffers, and
+ *  its broadcast a ncclBcast from the root, both running over NVLink when the
+ *  GPUs have it. The keys of a BatchReduce or BatchBroadcast are issued as one
+ *  group of NCCL calls by a single engine operation. Every key must be pushed
+ *  and pulled with one value per GPU, on the same set of GPUs.
+ */
+class CommNCCL : public Comm {
+ public:
+  CommNCCL() {
+    nccl_var_ = Engine::Get()->NewVariable();
+  }
+
+  virtual ~CommNCCL() {
+    Engine::Get()->WaitForAll();
+    for (auto& dev : devs_) {
+      CUDA_CALL(cudaSetDevice(dev.ctx.dev_id));
+      CUDA_CALL(cudaStreamDestroy(dev.stream));
+      ncclCommDestroy(dev.comm);
+    }
+    Engine::Get()->DeleteVariable([](RunContext s) {}, pinned_ctx_, nccl_var_);
+  }
+
+  void Init(int key, const NDArrayStorageType stype, const TShape& shape,
+            int dtype = mshadow::kFloat32) override {
+    CHECK_EQ(stype, kDefaultStorage)
+        << "storage type " << stype << " not implemented for nccl yet";
+  }
+
+  const NDArray& Reduce(int key, const std::vector<NDArray>& src,
+                        int priority) override {
+    if (src.size() == 1) return src[0];
+    std::vector<NDArray> merged;
+    BatchReduce({key}, {src}, priority, &merged);
+    return merge_buf_[key];
+  }
+
+  void BatchReduce(const std::vector<int>& keys,
+                   const std::vector<std::vector<NDArray> >& srcs,
+                   int priority, std::vector<NDArray>* merged) override {
+    merged->resize(keys.size());
+    std::vector<Collective> ops;
+    std::vector<Engine::VarHandle> const_vars, mutable_vars = {nccl_var_};
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const auto& src = srcs[i];
+      if (src.size() == 1) {
+        (*merged)[i] = src[0];
+        continue;
+      }
+      InitDevices(src);
+      const NDArray& buf = MergeBuffer(keys[i], src[0]);
+      Collective op;
+      op.root = Rank(buf.ctx());
+      op.recv = buf;
+      op.arrays = src;
+      for (const auto& s : src) const_vars.push_back(s.var());
+      mutable_vars.push_back(buf.var());
+      ops.push_back(std::move(op));
+      (*merged)[i] = buf;
+    }
+    if (ops.empty()) return;
+    Engine::Get()->PushSync([this, ops](RunContext rctx) {
+        NCCL_CALL(ncclGroupStart());
+        for (const auto& op : ops) {
+          for (const auto& s : op.arrays) {
+            const TBlob& data = s.data();
+            int rank = Rank(s.ctx());
+            void* recv = rank == op.root ? op.recv.data().dptr_ : nullptr;
+            NCCL_CALL(ncclReduce(data.dptr_, recv, data.Size(), DataType(data.type_flag_),
+                                 ncclSum, op.root, devs_[rank].comm, devs_[rank].stream));
+          }
+        }
+        NCCL_CALL(ncclGroupEnd());
+        Synchronize();
+      }, pinned_ctx_, const_vars, mutable_vars,
+      FnProperty::kCPUPrioritized, priority, PROFILER_MESSAGE("KVStoreNCCLReduce"));
+  }
+
+  void Broadcast(int key, const NDArray& src,
+                 const std::vector<NDArray*> dst, int priority) override {
+    BatchBroadcast({key}, {src}, {dst}, priority);
+  }
+
+  void BatchBroadcast(const std::vector<int>& keys,
+                      const std::vector<NDArray>& srcs,
+                      const std::vector<std::vector<NDArray*> >& dsts,
+                      int priority) override {
+    std::vector<Collective> ops;
+    std::vector<Engine::VarHandle> const_vars, mutable_vars = {nccl_var_};
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const auto& dst = dsts[i];
+      if (dst.size() == 1) {
+        CopyFromTo(srcs[i], dst[0], priority);
+        continue;
+      }
+      std::vector<NDArray> arrays;
+      for (const auto d : dst) arrays.push_back(*d);
+      InitDevices(arrays);
+      // send from the gpu the key is reduced on, the copy of src to it being
+      // the only transfer which does not go over the gpu links
+      auto it = merge_buf_.find(keys[i]);
+      Collective op;
+      op.root = it != merge_buf_.end() ? Rank(it->second.ctx()) :
+          keys[i] % static_cast<int>(devs_.size());
+      for (size_t j = 0; j < arrays.size(); ++j) {
+        if (Rank(arrays[j].ctx()) == op.root) {
+          if (arrays[j].var() != srcs[i].var()) CopyFromTo(srcs[i], dst[j], priority);
+          const_vars.push_back(arrays[j].var());
+        } else {
+          mutable_vars.push_back(arrays[j].var());
+        }
+      }
+      op.arrays = std::move(arrays);
+      ops.push_back(std::move(op));
+    }
+    if (ops.empty()) return;
+    Engine::Get()->PushSync([this, ops](RunContext rctx) {
+        NCCL_CALL(ncclGroupStart());
+        for (const auto& op : ops) {
+          for (const auto& d : op.arrays) {
+            const TBlob& data = d.data();
+            int rank = Rank(d.ctx());
+            NCCL_CALL(ncclBcast(data.dptr_, data.Size(), DataType(data.type_flag_),
+                                op.root, devs_[rank].comm, devs_[rank].stream));
+          }
+        }
+        NCCL_CALL(ncclGroupEnd());
+        Synchronize();
+      }, pinned_ctx_, const_vars, mutable_vars,
+      FnProperty::kCPUPrioritized, priority, PROFILER_MESSAGE("KVStoreNCCLBroadcast"));
+  }
+
+  void BroadcastRowSparse(int key, const NDArray& src,
+                          const std::vector<std::pair<NDArray*, NDArray>>& dst,
+                          const bool use_copy,
+                          const int priority) override {
+    LOG(FATAL) << "Not implemented yet";
+  }
+
+ private:
+  /*! \brief the keys of a group of NCCL calls */
+  struct Collective {
+    /*! \brief rank of the root gpu */
+    int root;
+    /*! \brief one array per gpu, the values to reduce or the ones to broadcast to */
+    std::vector<NDArray> arrays;
+    /*! \brief the array receiving the sum on the root */
+    NDArray recv;
+  };
+  /*! \brief the NCCL communicator of a gpu and the stream its collectives run on */
+  struct Device {
+    Context ctx;
+    ncclComm_t comm;
+    cudaStream_t stream;
+  };
+
+  /*! \brief create the communicators the first time, over the gpus of arrays */
+  void InitDevices(const std::vector<NDArray>& arrays) {
+    if (!devs_.empty()) {
+      CHECK_EQ(arrays.size(), devs_.size())
+          << "the nccl kvstore expects one value per gpu for every key";
+      return;
+    }
+    std::vector<int> dev_ids;
+    for (const auto& a : arrays) {
+      CHECK_EQ(a.ctx().dev_mask(), gpu::kDevMask)
+          << "the nccl kvstore only sums and broadcasts arrays on gpus";
+      CHECK_EQ(rank_.count(a.ctx().dev_id), 0U)
+          << "the nccl kvstore expects one value per gpu, got two on gpu "
+          << a.ctx().dev_id;
+      rank_[a.ctx().dev_id] = static_cast<int>(dev_ids.size());
+      dev_ids.push_back(a.ctx().dev_id);
+    }
+    std::vector<ncclComm_t> comms(dev_ids.size());
+    NCCL_CALL(ncclCommInitAll(comms.data(), static_cast<int>(dev_ids.size()), dev_ids.data()));
+    devs_.resize(dev_ids.size());
+    buf_size_.resize(dev_ids.size(), 0);
+    for (size_t i = 0; i < dev_ids.size(); ++i) {
+      devs_[i].ctx = Context::GPU(dev_ids[i]);
+      devs_[i].comm = comms[i];
+      CUDA_CALL(cudaSetDevice(dev_ids[i]));
+      CUDA_CALL(cudaStreamCreateWithFlags(&devs_[i].stream, cudaStreamNonBlocking));
+    }
+  }
+
+  int Rank(const Context& ctx) const {
+    auto it = rank_.find(ctx.dev_id);
+    CHECK(it != rank_.end() && ctx.dev_mask() == gpu::kDevMask)
+        << "gpu " << ctx.dev_id << " is not one of the gpus of the nccl kvstore";
+    return it->second;
+  }
+
+  /*! \brief the merge buffer of key, put on the gpu holding the fewest elements so far */
+  const NDArray& MergeBuffer(int key, const NDArray& like) {
+    NDArray& buf = merge_buf_[key];
+    if (buf.is_none()) {
+      size_t rank = 0;
+      for (size_t i = 1; i < buf_size_.size(); ++i) {
+        if (buf_size_[i] < buf_size_[rank]) rank = i;
+      }
+      buf = NDArray(like.shape(), devs_[rank].ctx, false, like.dtype());
+      buf_size_[rank] += like.shape().Size();
+    }
+    return buf;
+  }
+
+  void Synchronize() {
+    for (const auto& dev : devs_) {
+      CUDA_CALL(cudaStreamSynchronize(dev.stream));
+    }
+  }
+
+  static ncclDataType_t DataType(int type_flag) {
+    switch (type_flag) {
+      case mshadow::kFloat32: return ncclFloat;
+      case mshadow::kFloat64: return ncclDouble;
+      case mshadow::kFloat16: return ncclHalf;
+      case mshadow::kUint8: return ncclUint8;
+      case mshadow::kInt32: return ncclInt;
+      default:
+        LOG(FATAL) << "type " << type_flag << " not supported by the nccl kvstore";
+        return ncclFloat;
+    }
+  }
+
+  /*! \brief the gpus, in the order of their ranks */
+  std::vector<Device> devs_;
+  /*! \brief rank of every gpu id */
+  std::unordered_map<int, int> rank_;
+  /*! \brief number of elements of the merge buffers of every rank */
+  std::vector<size_t> buf_size_;
+  /*! \brief the sum of every key, on its root gpu */
+  std::unordered_map<int, NDArray> merge_buf_;
+  /*!
+   * \brief written by all the NCCL operations, which must be issued in the
+   *  same order on all their communicators
+   */
+  Engine::VarHandle nccl_var_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_USE_NCCL
+#endif  // MXNET_KVSTORE_COMM_NCCL_H_
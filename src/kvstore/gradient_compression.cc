@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gradient_compression.cc
+ * \brief Gradient compression for the distributed kvstore
+ */
+#include <dmlc/json.h>
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "./gradient_compression.h"
+
+namespace mxnet {
+namespace kvstore {
+
+DMLC_REGISTER_PARAMETER(GradientCompressionParam);
+
+namespace {
+/*! \brief number of values packed into one real_t by 2bit compression */
+const size_t kTwoBitValuesPerWord = sizeof(real_t) * 4;
+static_assert(sizeof(real_t) == sizeof(uint32_t), "2bit codes are packed into real_t");
+/*! \brief codes of the 2bit values */
+const uint32_t kTwoBitPositive = 1;
+const uint32_t kTwoBitNegative = 2;
+}  // namespace
+
+void GradientCompression::SetParams(
+    const std::vector<std::pair<std::string, std::string> >& kwargs) {
+  param_.Init(kwargs);
+  if (param_.type == kTwoBitCompression) {
+    CHECK_GT(param_.threshold, 0.0f) << "threshold of 2bit compression must be positive";
+  }
+}
+
+std::string GradientCompression::EncodeParams() const {
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  param_.Save(&writer);
+  return os.str();
+}
+
+void GradientCompression::DecodeParams(const std::string& str) {
+  std::istringstream is(str);
+  dmlc::JSONReader reader(&is);
+  param_.Load(&reader);
+}
+
+size_t GradientCompression::GetCompressedSize(size_t size) const {
+  switch (param_.type) {
+    case kNoCompression:
+      return size;
+    case kTwoBitCompression:
+      return (size + kTwoBitValuesPerWord - 1) / kTwoBitValuesPerWord;
+    default:
+      LOG(FATAL) << "unknown gradient compression type " << param_.type;
+  }
+  return 0;
+}
+
+void GradientCompression::Quantize(const real_t* grad, real_t* residual,
+                                   real_t* out, size_t size) const {
+  CHECK_EQ(param_.type, kTwoBitCompression);
+  const real_t threshold = param_.threshold;
+  long nword = GetCompressedSize(size); // NOLINT(*)
+  #pragma omp parallel for schedule(static)
+  for (long j = 0; j < nword; ++j) { // NOLINT(*)
+    size_t begin = static_cast<size_t>(j) * kTwoBitValuesPerWord;
+    size_t end = std::min(begin + kTwoBitValuesPerWord, size);
+    uint32_t bits = 0;
+    for (size_t i = begin; i < end; ++i) {
+      real_t r = residual[i] + grad[i];
+      uint32_t shift = 2 * (i - begin);
+      if (r >= threshold) {
+        bits |= kTwoBitPositive << shift;
+        r -= threshold;
+      } else if (r <= -threshold) {
+        bits |= kTwoBitNegative << shift;
+        r += threshold;
+      }
+      residual[i] = r;
+    }
+    // the payload is sent as raw bytes, never used as a float
+    std::memcpy(out + j, &bits, sizeof(bits));
+  }
+}
+
+void GradientCompression::Dequantize(const real_t* in, real_t* out, size_t size) const {
+  CHECK_EQ(param_.type, kTwoBitCompression);
+  const real_t threshold = param_.threshold;
+  long nword = GetCompressedSize(size); // NOLINT(*)
+  #pragma omp parallel for schedule(static)
+  for (long j = 0; j < nword; ++j) { // NOLINT(*)
+    size_t begin = static_cast<size_t>(j) * kTwoBitValuesPerWord;
+    size_t end = std::min(begin + kTwoBitValuesPerWord, size);
+    uint32_t bits;
+    std::memcpy(&bits, in + j, sizeof(bits));
+    for (size_t i = begin; i < end; ++i) {
+      uint32_t code = (bits >> (2 * (i - begin))) & 3;
+      out[i] = code == kTwoBitPositive ? threshold :
+               code == kTwoBitNegative ? -threshold : 0.0f;
+    }
+  }
+}
+
+}  // namespace kvstore
+}  // namespace mxnet
@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gradient_compression.h
+ * \brief Gradient compression for the distributed kvstore
+ */
+#ifndef MXNET_KVSTORE_GRADIENT_COMPRESSION_H_
+#define MXNET_KVSTORE_GRADIENT_COMPRESSION_H_
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+enum GradientCompressionType {
+  kNoCompression,
+  kTwoBitCompression
+};
+
+struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
+  int type;
+  float threshold;
+  DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
+    DMLC_DECLARE_FIELD(type)
+    .add_enum("none", kNoCompression)
+    .add_enum("2bit", kTwoBitCompression)
+    .set_default(kNoCompression)
+    .describe("Type of gradient compression.");
+    DMLC_DECLARE_FIELD(threshold)
+    .set_default(0.5f)
+    .describe("Threshold of 2bit compression. Values of the accumulated gradient "
+              "whose magnitude is at least the threshold are sent as +threshold "
+              "or -threshold, the others are sent as 0.");
+  }
+};
+
+/*!
+ * \brief Compresses dense gradients pushed by the workers.
+ *
+ *  With 2bit compression every value is sent as 2 bits, so 16 values are
+ *  packed into one real_t of the payload. The worker keeps a residual per key
+ *  holding the part of the gradients that has not been sent yet. The gradient
+ *  is added to the residual, the values of the residual reaching the threshold
+ *  are sent as +threshold or -threshold and subtracted from the residual.
+ */
+class GradientCompression {
+ public:
+  /*!
+   * \brief set the parameters from key-value pairs, such as
+   *  {"type": "2bit", "threshold": "0.5"}
+   */
+  void SetParams(const std::vector<std::pair<std::string, std::string> >& kwargs);
+  /*! \brief whether gradients are compressed */
+  bool enabled() const {
+    return param_.type != kNoCompression;
+  }
+  /*! \brief the threshold of 2bit compression */
+  float threshold() const {
+    return param_.threshold;
+  }
+  /*! \brief serialize the parameters, to be sent to the servers */
+  std::string EncodeParams() const;
+  /*! \brief set the parameters from the string given by \ref EncodeParams */
+  void DecodeParams(const std::string& str);
+  /*!
+   * \brief number of real_t in the compressed form of size values
+   */
+  size_t GetCompressedSize(size_t size) const;
+  /*!
+   * \brief add grad to residual and write the compressed residual to out
+   * \param grad the gradient, size values
+   * \param residual the residual, size values, updated in place
+   * \param out the compressed values, GetCompressedSize(size) values
+   * \param size the number of values
+   */
+  void Quantize(const real_t* grad, real_t* residual, real_t* out, size_t size) const;
+  /*!
+   * \brief decompress the values written by \ref Quantize
+   * \param in the compressed values, GetCompressedSize(size) values
+   * \param out the decompressed values, size values
+   * \param size the number of values
+   */
+  void Dequantize(const real_t* in, real_t* out, size_t size) const;
+
+ private:
+  GradientCompressionParam param_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_GRADIENT_COMPRESSION_H_
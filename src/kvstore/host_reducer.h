@@ -0,0 +1,233 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file host_reducer.h
+ * \brief Reduce the pushes of the worker processes running on the same host
+ */
+#ifndef MXNET_KVSTORE_HOST_REDUCER_H_
+#define MXNET_KVSTORE_HOST_REDUCER_H_
+#include <dmlc/logging.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "mxnet/base.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief Sums the values pushed by the worker processes of one host in POSIX
+ *  shared memory, so that only one of them, the leader, pushes to servers.
+ *
+ *  The workers sharing the shared memory namespace of the host form a group.
+ *  Every worker copies its values of a key into its own slot of a segment of
+ *  the key and, except for the leader, counts its arrival in the segment. The
+ *  leader waits for the other workers on a background thread, adds their
+ *  slots into its own and hands the sum over. Workers must push the same keys
+ *  the same number of times, and may write the next values of a key only once
+ *  the leader has read the previous ones, which the servers guarantee by
+ *  answering the pushes of a round after the update.
+ */
+class HostReducer {
+ public:
+  /*!
+   * \brief join the group of the job, must be called before the workers of
+   *  the job synchronize and \ref Start
+   * \param job_name name unique to the job, shared by all its workers
+   */
+  explicit HostReducer(const std::string& job_name)
+      : prefix_("/mxnet_" + std::to_string(std::hash<std::string>()(job_name))) {
+    group_ = static_cast<Group*>(Map(prefix_ + "_group", sizeof(Group)));
+    local_rank_ = group_->num_workers.fetch_add(1);
+  }
+  /*!
+   * \brief stop the background thread and remove the shared memory, must be
+   *  called once all the workers have finished their pushes
+   */
+  ~HostReducer() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        exit_ = true;
+      }
+      cond_.notify_one();
+      thread_.join();
+    }
+    for (auto& kv : segments_) {
+      munmap(kv.second.header, kv.second.bytes);
+      shm_unlink(SegmentName(kv.first).c_str());
+    }
+    munmap(group_, sizeof(Group));
+    shm_unlink((prefix_ + "_group").c_str());
+  }
+  /*!
+   * \brief get the size of the group, once all the workers have joined it
+   */
+  void Start() {
+    local_size_ = group_->num_workers.load();
+    CHECK_LT(local_rank_, local_size_);
+    if (is_leader() && local_size_ > 1) {
+      thread_ = std::thread([this]() { Run(); });
+    }
+  }
+  /*! \brief rank of this worker in its host */
+  int local_rank() const { return local_rank_; }
+  /*! \brief number of workers of the host */
+  int local_size() const { return local_size_; }
+  /*! \brief whether this worker pushes the sum of the host */
+  bool is_leader() const { return local_rank_ == 0; }
+  /*!
+   * \brief copy the values of key into the slot of this worker
+   */
+  void Contribute(int key, const real_t* data, size_t size) {
+    Segment& seg = GetSegment(key, size);
+    std::memcpy(seg.slots + local_rank_ * size, data, size * sizeof(real_t));
+    if (!is_leader()) seg.header->arrived.fetch_add(1, std::memory_order_release);
+  }
+  /*!
+   * \brief wait for the other workers on the background thread, then call
+   *  on_reduced with the sum, which stays valid until the next Contribute
+   *  of key. Only called by the leader, after its Contribute.
+   */
+  void ReduceAsync(int key, size_t size, const std::function<void(real_t*)>& on_reduced) {
+    CHECK(is_leader());
+    Segment& seg = GetSegment(key, size);
+    if (local_size_ == 1) {
+      on_reduced(seg.slots);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      pending_.push_back(Task{&seg, size, on_reduced});
+    }
+    cond_.notify_one();
+  }
+
+ private:
+  /*! \brief shared by the workers of the group */
+  struct Group {
+    std::atomic<int> num_workers;
+  };
+  /*! \brief header of the segment of a key, padded to keep the slots aligned */
+  struct Header {
+    std::atomic<int> arrived;
+    char padding[64 - sizeof(std::atomic<int>)];
+  };
+  /*! \brief segment of a key, a header followed by one slot per worker */
+  struct Segment {
+    Header* header;
+    real_t* slots;
+    size_t size;
+    size_t bytes;
+  };
+  /*! \brief a reduction waiting for the other workers */
+  struct Task {
+    Segment* seg;
+    size_t size;
+    std::function<void(real_t*)> on_reduced;
+  };
+  /*! \brief open, or create zero filled, and map a shared memory object */
+  static void* Map(const std::string& name, size_t bytes) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+    CHECK_GE(fd, 0) << "shm_open " << name << " failed: " << strerror(errno);
+    // every worker extends the object to the same size, new bytes are zero
+    CHECK_EQ(ftruncate(fd, bytes), 0) << "ftruncate " << name << " failed: " << strerror(errno);
+    void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(addr != MAP_FAILED) << "mmap " << name << " failed: " << strerror(errno);
+    return addr;
+  }
+  std::string SegmentName(int key) const {
+    return prefix_ + "_" + std::to_string(key);
+  }
+  Segment& GetSegment(int key, size_t size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Segment& seg = segments_[key];
+    if (seg.header == nullptr) {
+      seg.size = size;
+      seg.bytes = sizeof(Header) + local_size_ * size * sizeof(real_t);
+      seg.header = static_cast<Header*>(Map(SegmentName(key), seg.bytes));
+      seg.slots = reinterpret_cast<real_t*>(seg.header + 1);
+    }
+    CHECK_EQ(seg.size, size) << "The value size cannot be changed";
+    return seg;
+  }
+  /*! \brief body of the background thread of the leader */
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      cond_.wait(lock, [this]() { return exit_ || !pending_.empty(); });
+      if (exit_) break;
+      // the order of the keys may differ among the workers
+      for (auto it = pending_.begin(); it != pending_.end();) {
+        Header* header = it->seg->header;
+        if (header->arrived.load(std::memory_order_acquire) < local_size_ - 1) {
+          ++it;
+          continue;
+        }
+        Task task = std::move(*it);
+        it = pending_.erase(it);
+        lock.unlock();
+        real_t* sum = task.seg->slots;
+        for (int r = 1; r < local_size_; ++r) {
+          const real_t* slot = task.seg->slots + r * task.size;
+          for (size_t i = 0; i < task.size; ++i) sum[i] += slot[i];
+        }
+        header->arrived.store(0, std::memory_order_relaxed);
+        task.on_reduced(sum);
+        lock.lock();
+      }
+      if (!pending_.empty()) {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        lock.lock();
+      }
+    }
+  }
+  // prefix of the names of the shared memory objects
+  std::string prefix_;
+  // group of the workers of the host
+  Group* group_;
+  int local_rank_;
+  int local_size_{1};
+  // protects the fields below
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::unordered_map<int, Segment> segments_;
+  std::list<Task> pending_;
+  bool exit_{false};
+  std::thread thread_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_HOST_REDUCER_H_
@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file key_fusion.h
+ * \brief Send the pushes and pulls of small keys in fused messages
+ */
+#ifndef MXNET_KVSTORE_KEY_FUSION_H_
+#define MXNET_KVSTORE_KEY_FUSION_H_
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "mxnet/base.h"
+#include "ps/ps.h"
+#include "./kvstore_dist_server.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief Packs the dense pushes and pulls of small keys into fused requests.
+ *
+ *  Every push or pull joins a pending bucket, and the bucket is sent as one
+ *  request with all its keys once it holds flush_size values, or at the next
+ *  cycle of a background thread otherwise, so that keys pushed one at a time
+ *  by the frontend are still fused. ps-lite slices the request into one
+ *  message per server. A fused request has the highest priority of its
+ *  keys. The callback of a push or pull is called once the whole fused
+ *  request is answered.
+ */
+class KeyFusion {
+ public:
+  /*! \brief called once a push or pull is done */
+  typedef std::function<void()> Callback;
+  /*!
+   * \param worker the worker sending the fused requests
+   * \param flush_size number of values that makes a bucket be sent at once
+   * \param cycle_time period of the background thread in milliseconds
+   */
+  KeyFusion(ps::KVWorker<real_t>* worker, size_t flush_size, int cycle_time)
+      : worker_(worker), flush_size_(flush_size), cycle_time_(cycle_time) {
+    thread_ = std::thread([this]() { Run(); });
+  }
+  /*!
+   * \brief send the pending buckets and stop the background thread
+   */
+  ~KeyFusion() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      exit_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+  }
+  /*!
+   * \brief push the len values at data to the partition ps_key of a small
+   *  key. data must stay valid until on_complete is called.
+   */
+  void Push(ps::Key ps_key, const real_t* data, int len, int priority,
+            const Callback& on_complete) {
+    Add(&push_, Entry{ps_key, const_cast<real_t*>(data), len, priority, on_complete}, true);
+  }
+  /*!
+   * \brief pull the len values of the partition ps_key of a small key into
+   *  data, which is written when on_complete is called.
+   */
+  void Pull(ps::Key ps_key, real_t* data, int len, int priority,
+            const Callback& on_complete) {
+    Add(&pull_, Entry{ps_key, data, len, priority, on_complete}, false);
+  }
+
+ private:
+  /*! \brief a push or pull waiting in a bucket */
+  struct Entry {
+    ps::Key key;
+    real_t* data;
+    int len;
+    int priority;
+    Callback on_complete;
+  };
+  /*! \brief the pending pushes or pulls */
+  struct Bucket {
+    std::vector<Entry> entries;
+    size_t size{0};
+  };
+  /*! \brief state of a fused pull, kept until it is answered */
+  struct PullRequest {
+    std::vector<Entry> entries;
+    ps::SArray<ps::Key> keys;
+    ps::SArray<real_t> vals;
+    ps::SArray<int> lens;
+  };
+
+  void Add(Bucket* bucket, const Entry& entry, bool push) {
+    std::vector<Entry> full;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      bucket->entries.push_back(entry);
+      bucket->size += entry.len;
+      if (bucket->size >= flush_size_) Take(bucket, &full);
+    }
+    if (!full.empty()) Send(&full, push);
+  }
+  /*! \brief move the entries out of bucket, mu_ must be held */
+  static void Take(Bucket* bucket, std::vector<Entry>* entries) {
+    entries->swap(bucket->entries);
+    bucket->entries.clear();
+    bucket->size = 0;
+  }
+  /*! \brief send the entries as one request, keys in increasing order */
+  void Send(std::vector<Entry>* entries, bool push) {
+    std::sort(entries->begin(), entries->end(), [](const Entry& a, const Entry& b) {
+        return a.key < b.key;
+      });
+    size_t n = entries->size(), total = 0;
+    ps::SArray<ps::Key> keys(n);
+    ps::SArray<int> lens(n);
+    int priority = (*entries)[0].priority;
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = (*entries)[i].key;
+      lens[i] = (*entries)[i].len;
+      total += lens[i];
+      priority = std::max(priority, (*entries)[i].priority);
+    }
+    int cmd = EncodeCmd(kFusedPushPull, priority);
+    if (push) {
+      ps::SArray<real_t> vals(total);
+      size_t offset = 0;
+      for (const auto& e : *entries) {
+        std::memcpy(vals.data() + offset, e.data, e.len * sizeof(real_t));
+        offset += e.len;
+      }
+      auto done = std::make_shared<std::vector<Entry>>(std::move(*entries));
+      worker_->ZPush(keys, vals, lens, cmd, [done]() {
+          for (const auto& e : *done) e.on_complete();
+        });
+    } else {
+      auto req = std::make_shared<PullRequest>();
+      req->entries = std::move(*entries);
+      req->keys = keys;
+      req->vals.resize(total);
+      req->lens = lens;
+      worker_->ZPull(req->keys, &req->vals, &req->lens, cmd, [req]() {
+          size_t offset = 0;
+          for (const auto& e : req->entries) {
+            std::memcpy(e.data, req->vals.data() + offset, e.len * sizeof(real_t));
+            offset += e.len;
+          }
+          for (const auto& e : req->entries) e.on_complete();
+        });
+    }
+  }
+  /*! \brief body of the background thread */
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      cond_.wait_for(lock, std::chrono::milliseconds(cycle_time_), [this]() { return exit_; });
+      std::vector<Entry> pushes, pulls;
+      Take(&push_, &pushes);
+      Take(&pull_, &pulls);
+      bool exit = exit_;
+      lock.unlock();
+      if (!pushes.empty()) Send(&pushes, true);
+      if (!pulls.empty()) Send(&pulls, false);
+      if (exit) break;
+      lock.lock();
+    }
+  }
+  // the worker sending the requests
+  ps::KVWorker<real_t>* worker_;
+  // bucket size sent without waiting for the next cycle
+  size_t flush_size_;
+  // period of the background thread in milliseconds
+  int cycle_time_;
+  // protects the fields below
+  std::mutex mu_;
+  std::condition_variable cond_;
+  Bucket push_;
+  Bucket pull_;
+  bool exit_{false};
+  std::thread thread_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KEY_FUSION_H_
@@ -24,6 +24,7 @@
 #include <mxnet/kvstore.h>
 #include <stdlib.h>
 #include <dmlc/logging.h>
+#include <atomic>
 #include "./kvstore_local.h"
 #if MXNET_USE_DIST_KVSTORE
 #include "./kvstore_dist.h"
@@ -31,6 +32,19 @@
 
 namespace mxnet {
 
+namespace {
+/*! \brief the kvstore returned by KVStore::DistWorker */
+std::atomic<KVStore*> dist_worker{nullptr};
+}  // namespace
+
+KVStore* KVStore::DistWorker() {
+  return dist_worker.load();
+}
+
+void KVStore::SetDistWorker(KVStore* kv) {
+  dist_worker.store(kv);
+}
+
 KVStore* KVStore::Create(const char *type_name) {
   std::string tname = type_name;
   std::transform(tname.begin(), tname.end(), tname.begin(), ::tolower);
@@ -42,20 +56,37 @@ KVStore* KVStore::Create(const char *type_name) {
   if (has("device")) {
     use_device_comm = true;
   }
+  bool use_nccl = has("nccl");
 
-  if (has("dist")) {
+  if (has("dist") && has("allreduce")) {
+#if MXNET_USE_DIST_KVSTORE
+    kv = new kvstore::KVStoreDistAllreduce(use_device_comm, use_nccl);
+#else
+    LOG(FATAL) << "compile with USE_DIST_KVSTORE=1 to use " << tname;
+    return nullptr;
+#endif  // MXNET_USE_DIST_KVSTORE
+  } else if (has("dist")) {
 #if MXNET_USE_DIST_KVSTORE
-    kv = new kvstore::KVStoreDist(use_device_comm);
-    if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
-      // configure the server to be the sync mode
-      kv->SendCommandToServers(kvstore::kSyncMode, "");
+    kv = new kvstore::KVStoreDist(use_device_comm, use_nccl);
+    if (has("_ssp") && kv->IsWorkerNode() && kv->get_rank() == 0) {
+      // configure the server to bound the staleness of the workers
+      kv->SendCommandToServers(kvstore::kSSPMode, std::to_string(
+          dmlc::GetEnv("MXNET_KVSTORE_SSP_STALENESS", 2)));
+    } else if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
+      // configure the server to be the sync mode, not waiting for the
+      // pushes of the slowest backup workers of every round
+      const int backup_workers = dmlc::GetEnv("MXNET_KVSTORE_BACKUP_WORKERS", 0);
+      CHECK(backup_workers == 0 || !dmlc::GetEnv("MXNET_KVSTORE_DIST_HIERARCHICAL", false))
+          << "MXNET_KVSTORE_BACKUP_WORKERS is not supported with MXNET_KVSTORE_DIST_HIERARCHICAL, "
+          << "the pushes of the workers of a host carry the values of the others";
+      kv->SendCommandToServers(kvstore::kSyncMode, std::to_string(backup_workers));
     }
 #else
     LOG(FATAL) << "compile with USE_DIST_KVSTORE=1 to use " << tname;
     return nullptr;
 #endif  // MXNET_USE_DIST_KVSTORE
   } else {
-    kv =  new kvstore::KVStoreLocal(use_device_comm);
+    kv =  new kvstore::KVStoreLocal(use_device_comm, use_nccl);
   }
   kv->type_ = tname;
   return kv;
@@ -23,14 +23,21 @@
  */
 #ifndef MXNET_KVSTORE_KVSTORE_DIST_H_
 #define MXNET_KVSTORE_KVSTORE_DIST_H_
+#include <cstring>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include "./kvstore_local.h"
 #include "mxnet/engine.h"
 #include "ps/ps.h"
 #include "./kvstore_dist_server.h"
+#include "./gradient_compression.h"
+#include "./host_reducer.h"
+#include "./key_fusion.h"
+#include "./kvstore_dist_allreduce.h"
+#include "../common/bfloat16.h"
 #if MKL_EXPERIMENTAL == 1
 #include <mkl_memory.h>
 #include "../operator/mkl/mkl_memory-inl.h"
@@ -51,23 +58,48 @@ namespace kvstore {
  */
 class KVStoreDist : public KVStoreLocal {
  public:
-  explicit KVStoreDist(bool use_device_comm)
-      : KVStoreLocal(use_device_comm), ps_worker_(nullptr), server_(nullptr) {
+  explicit KVStoreDist(bool use_device_comm, bool use_nccl = false)
+      : KVStoreLocal(use_device_comm, use_nccl), ps_worker_(nullptr), server_(nullptr) {
     if (IsWorkerNode()) {
+      bool hierarchical = dmlc::GetEnv("MXNET_KVSTORE_DIST_HIERARCHICAL", false);
+      if (hierarchical) {
+        // the workers of a host join its group before the barrier
+        host_reducer_.reset(new HostReducer(
+            dmlc::GetEnv("DMLC_PS_ROOT_URI", std::string()) + ":" +
+            dmlc::GetEnv("DMLC_PS_ROOT_PORT", std::string())));
+      }
       ps_worker_ = new ps::KVWorker<real_t>(0);
       ps::StartAsync("mxnet\0");
       if (!ps::Postoffice::Get()->is_recovery()) {
         ps::Postoffice::Get()->Barrier(
           ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
       }
+      if (host_reducer_) host_reducer_->Start();
+      // keep the parts handed out by the first server
+      static_cast<ps::SimpleApp*>(ps_worker_)->set_response_handle(
+          [this](const ps::SimpleData& recved, ps::SimpleApp* app) {
+            if (recved.head == kNextPart) {
+              std::lock_guard<std::mutex> lk(parts_mu_);
+              parts_[recved.timestamp] = std::stoi(recved.body);
+            }
+          });
+      SetDistWorker(this);
     }
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
+    fusion_bound_ = dmlc::GetEnv("MXNET_KVSTORE_FUSION_BOUND", 0);
+    if (IsWorkerNode() && fusion_bound_ > 0) {
+      key_fusion_.reset(new KeyFusion(ps_worker_, bigarray_bound_,
+                                      dmlc::GetEnv("MXNET_KVSTORE_FUSION_CYCLE_TIME", 1)));
+    }
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    balanced_placement_ = dmlc::GetEnv("MXNET_KVSTORE_BALANCED_PLACEMENT", true);
+    bf16_ = dmlc::GetEnv("MXNET_KVSTORE_BF16", false);
   }
 
   virtual ~KVStoreDist() {
     Engine::Get()->WaitForAll();
     if (IsWorkerNode()) {
+      if (DistWorker() == this) SetDistWorker(nullptr);
       if (barrier_before_exit_) {
         Barrier();
         if (get_rank() == 0) {
@@ -75,17 +107,104 @@ class KVStoreDist : public KVStoreLocal {
           SendCommandToServers(kStopServer, "");
         }
       }
+      host_reducer_.reset();
+      key_fusion_.reset();
       ps::Finalize(barrier_before_exit_);
       delete ps_worker_;
     }
   }
 
-  void Init(const std::vector<int>& keys,
-            const std::vector<NDArray>& values) override {
+  void set_updater(const Updater& updater) override {
+    CHECK(updater) << "invalid updater";
+    if (IsServerNode()) {
+      CHECK_NOTNULL(server_)->set_updater(updater);
+    } else {
+      updater_ = updater;
+    }
+  }
+
+  void SetGradientCompression(
+      const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    gradient_compression_.SetParams(kwargs);
+    if (IsWorkerNode() && get_rank() == 0) {
+      // the servers need the parameters to decompress the pushes
+      SendCommandToServers(kSetGradientCompression, gradient_compression_.EncodeParams());
+    }
+  }
+
+  void Barrier() override {
+    ps::Postoffice::Get()->Barrier(ps::kWorkerGroup);
+  }
+
+
+  void SendCommandToServers(int cmd_id,
+                            const std::string& cmd_body) override {
+    CHECK_NOTNULL(ps_worker_);
+    ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
+  }
+
+  int NextPart(const std::string& name, int epoch, int num_parts) override {
+    CHECK_NOTNULL(ps_worker_);
+    const std::string body =
+        std::to_string(epoch) + " " + std::to_string(num_parts) + " " + name;
+    const int ts = ps_worker_->Request(kNextPart, body,
+                                       ps::Postoffice::Get()->ServerRankToID(0));
+    ps_worker_->Wait(ts);
+    std::lock_guard<std::mutex> lk(parts_mu_);
+    auto it = parts_.find(ts);
+    CHECK(it != parts_.end()) << "no part received for " << name;
+    const int part = it->second;
+    parts_.erase(it);
+    return part;
+  }
+
+  int get_group_size() const override { return ps::NumWorkers(); }
+
+  int get_rank() const override { return ps::MyRank(); }
+
+  int get_num_dead_node(int node_id, int timeout) const override {
+    int number = 0;
+    auto dead_nodes = ps::Postoffice::Get()->GetDeadNodes(timeout);
+    const auto& watch_nodes = ps::Postoffice::Get()->GetNodeIDs(node_id);
+    std::unordered_set<int> watch_set(watch_nodes.begin(), watch_nodes.end());
+    for (int r : dead_nodes) {
+      if (watch_set.find(r) != watch_set.end()) number++;
+    }
+    return number;
+  }
+
+  void RunServer(const Controller& controller) override {
+    CHECK(!IsWorkerNode());
+    if (IsServerNode()) {
+      server_ = new KVStoreDistServer();
+      server_->set_controller(controller);
+    }
+    // the workers of a dist_sync_allreduce kvstore meet at the scheduler
+    std::unique_ptr<AllreduceRendezvous> rendezvous;
+    if (IsSchedulerNode()) rendezvous.reset(new AllreduceRendezvous());
+
+    ps::StartAsync("mxnet_server\0");
+    if (!ps::Postoffice::Get()->is_recovery()) {
+      ps::Postoffice::Get()->Barrier(
+        ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
+    }
+    if (server_) server_->Run();
+    ps::Finalize();
+    rendezvous.reset();
+    if (server_) {
+      delete server_;
+    }
+    server_ = nullptr;
+  }
+
+ private:
+  void InitImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values) override {
     CheckUnique(keys);
     for (size_t i = 0; i < keys.size(); ++i) {
       comm_->Init(keys[i], values[i].storage_type(), values[i].shape(), values[i].dtype());
     }
+    if (balanced_placement_) PlaceKeys(keys, values);
     if (get_rank() == 0) {
       Push_(keys, values, 0, false);
       // wait until the push is finished
@@ -100,15 +219,15 @@ class KVStoreDist : public KVStoreLocal {
     }
   }
 
-  void Push(const std::vector<int>& keys,
-            const std::vector<NDArray>& values,
-            int priority) override {
+  void PushImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values,
+                int priority) override {
     Push_(keys, values, priority, true);
   }
 
-  void Pull(const std::vector<int>& keys,
-            const std::vector<NDArray*>& values,
-            int priority) override {
+  void PullImpl(const std::vector<int>& keys,
+                const std::vector<NDArray*>& values,
+                int priority) override {
     std::vector<int> uniq_keys;
     std::vector<std::vector<NDArray*> > grouped_vals;
     GroupKVPairsPull(keys, values, &uniq_keys, &grouped_vals);
@@ -126,7 +245,22 @@ class KVStoreDist : public KVStoreLocal {
         recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
                            true, grouped_vals[i][0]->dtype());
       }
-      auto pull_from_servers = [this, key, recv_buf](
+      if (recv_buf.dtype() == mshadow::kFloat16) {
+        PullFP16(key, recv_buf, priority);
+        comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
+        continue;
+      }
+      if (IsFused(recv_buf)) {
+        PullFused(key, recv_buf, priority);
+        comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
+        continue;
+      }
+      if (bf16_ && recv_buf.dtype() == mshadow::kFloat32) {
+        PullBF16(key, recv_buf, priority);
+        comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
+        continue;
+      }
+      auto pull_from_servers = [this, key, recv_buf, priority](
           RunContext rctx, Engine::CallbackOnComplete cb) {
         // convert to ps keys
         size_t size = recv_buf.shape().Size();
@@ -139,7 +273,8 @@ class KVStoreDist : public KVStoreLocal {
         auto vals = new ps::SArray<real_t>(data, size, false);
         // issue pull
         CHECK_NOTNULL(ps_worker_)->ZPull(
-          pskv.keys, vals, &pskv.lens, kDefaultPushPull, [vals, cb](){ delete vals; cb(); });
+          pskv.keys, vals, &pskv.lens, EncodeCmd(kDefaultPushPull, priority),
+          [vals, cb](){ delete vals; cb(); });
       };
 
       CHECK_NOTNULL(Engine::Get())->PushAsync(
@@ -147,7 +282,7 @@ class KVStoreDist : public KVStoreLocal {
           pinned_ctx_,
           {},
           {recv_buf.var()},
-          FnProperty::kNormal,
+          FnProperty::kCPUPrioritized,
           priority,
           PROFILER_MESSAGE("KVStoreDistDefaultPull"));
 
@@ -155,9 +290,9 @@ class KVStoreDist : public KVStoreLocal {
     }
   }
 
-  void PullRowSparse(const std::vector<int>& keys,
-                     const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                     const int priority = 0) {
+  void PullRowSparseImpl(const std::vector<int>& keys,
+                         const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
+                         int priority = 0) override {
     std::vector<int> uniq_keys;
     std::vector<std::vector<std::pair<NDArray*, NDArray>>> grouped_val_rowids;
     GroupKVPairsPullRsp(keys, val_rowids, &uniq_keys, &grouped_val_rowids);
@@ -187,73 +322,44 @@ class KVStoreDist : public KVStoreLocal {
         target_val_rowids[i].second = indices;
         num_rows += indices.shape().Size();
       }
-      if (num_vals > 1) {
-        // TODO(haibin) aggregate over all unique indices
-        LOG(FATAL) << "RowSparsePull with multiple values is not implemented yet";
-      } else {
-        auto& indices = target_val_rowids[0].second;
-        PullRowSparse_(key, &recv_buf, indices, priority);
-        comm_->BroadcastRowSparse(key, recv_buf, grouped_val_rowid, num_vals == 1, priority);
-      }
+      // the devices often request overlapping rows, which are pulled once
+      // and then retained for every device
+      NDArray indices = num_vals == 1 ? target_val_rowids[0].second :
+          UnionRowIds(target_val_rowids, num_rows, priority);
+      PullRowSparse_(key, &recv_buf, indices, priority);
+      comm_->BroadcastRowSparse(key, recv_buf, grouped_val_rowid, num_vals == 1, priority);
     }
   }
 
-  void set_updater(const Updater& updater) override {
-    CHECK(updater) << "invalid updater";
-    if (IsServerNode()) {
-      CHECK_NOTNULL(server_)->set_updater(updater);
-    } else {
-      updater_ = updater;
-    }
-  }
-
-  void Barrier() override {
-    ps::Postoffice::Get()->Barrier(ps::kWorkerGroup);
-  }
-
-
-  void SendCommandToServers(int cmd_id,
-                            const std::string& cmd_body) override {
-    CHECK_NOTNULL(ps_worker_);
-    ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
-  }
-
-  int get_group_size() const override { return ps::NumWorkers(); }
-
-  int get_rank() const override { return ps::MyRank(); }
-
-  int get_num_dead_node(int node_id, int timeout) const override {
-    int number = 0;
-    auto dead_nodes = ps::Postoffice::Get()->GetDeadNodes(timeout);
-    const auto& watch_nodes = ps::Postoffice::Get()->GetNodeIDs(node_id);
-    std::unordered_set<int> watch_set(watch_nodes.begin(), watch_nodes.end());
-    for (int r : dead_nodes) {
-      if (watch_set.find(r) != watch_set.end()) number++;
-    }
-    return number;
-  }
-
-  void RunServer(const Controller& controller) override {
-    CHECK(!IsWorkerNode());
-    if (IsServerNode()) {
-      server_ = new KVStoreDistServer();
-      server_->set_controller(controller);
-    }
-
-    ps::StartAsync("mxnet_server\0");
-    if (!ps::Postoffice::Get()->is_recovery()) {
-      ps::Postoffice::Get()->Barrier(
-        ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
-    }
-    if (server_) server_->Run();
-    ps::Finalize();
-    if (server_) {
-      delete server_;
+  /**
+   * \brief the sorted union of the unique row ids of several values, as int64
+   *  on the pinned context
+   * \param num_rows the total number of row ids of the values
+   */
+  NDArray UnionRowIds(const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
+                      size_t num_rows, int priority) {
+    NDArray all(TShape(mshadow::Shape1(num_rows)), pinned_ctx_, false, mshadow::kInt64);
+    std::vector<NDArray> row_ids;
+    std::vector<Engine::VarHandle> const_vars;
+    for (const auto& val_rowid : val_rowids) {
+      row_ids.push_back(val_rowid.second);
+      const_vars.push_back(val_rowid.second.var());
     }
-    server_ = nullptr;
+    Engine::Get()->PushSync([all, row_ids](RunContext rctx) {
+        int64_t* out = all.data().dptr<int64_t>();
+        for (const auto& row_id : row_ids) {
+          const TBlob& ids = row_id.data();
+          MSHADOW_IDX_TYPE_SWITCH(ids.type_flag_, IType, {
+            std::copy(ids.dptr<IType>(), ids.dptr<IType>() + ids.Size(), out);
+          });
+          out += ids.Size();
+        }
+      }, pinned_ctx_, const_vars, {all.var()},
+      FnProperty::kCPUPrioritized, priority, PROFILER_MESSAGE("KVStoreUnionRowIds"));
+    Unique(&all, priority);
+    return all;
   }
 
- private:
   void Push_(const std::vector<int>& keys,
              const std::vector<NDArray>& values,
              int priority,
@@ -287,9 +393,22 @@ class KVStoreDist : public KVStoreLocal {
       }
 
       // push to servers
-      if (storage_type == kDefaultStorage) {
+      if (storage_type == kDefaultStorage && merged.dtype() == mshadow::kFloat16) {
+        PushFP16(key, send_buf, priority, !do_merge);
+      } else if (storage_type == kDefaultStorage && do_merge &&
+                 gradient_compression_.enabled()) {
+        PushCompressed(key, send_buf, priority);
+      } else if (storage_type == kDefaultStorage && do_merge &&
+                 host_reducer_ && host_reducer_->local_size() > 1) {
+        PushHierarchical(key, send_buf, priority);
+      } else if (do_merge && IsFused(send_buf)) {
+        PushFused(key, send_buf, priority);
+      } else if (storage_type == kDefaultStorage && do_merge && bf16_ &&
+                 merged.dtype() == mshadow::kFloat32) {
+        PushBF16(key, send_buf, priority);
+      } else if (storage_type == kDefaultStorage) {
       auto push_to_servers =
-          [this, key, send_buf](RunContext rctx, Engine::CallbackOnComplete cb) {
+          [this, key, send_buf, priority](RunContext rctx, Engine::CallbackOnComplete cb) {
           // convert to ps keys
           size_t size = send_buf.shape().Size();
           PSKV& pskv = EncodeKey(key, size);
@@ -301,14 +420,14 @@ class KVStoreDist : public KVStoreLocal {
           // do push. false means no delete
           ps::SArray<real_t> vals(data, size, false);
           CHECK_NOTNULL(ps_worker_)->ZPush(
-              pskv.keys, vals, pskv.lens, 0, [cb]() { cb(); });
+              pskv.keys, vals, pskv.lens, EncodeCmd(kDefaultPushPull, priority), [cb]() { cb(); });
         };
         Engine::Get()->PushAsync(
             push_to_servers,
             pinned_ctx_,
             {send_buf.var()},
             {},
-            FnProperty::kNormal,
+            FnProperty::kCPUPrioritized,
             priority,
             PROFILER_MESSAGE("KVStoreDistDefaultPush"));
       } else if (storage_type == kRowSparseStorage) {
@@ -319,10 +438,303 @@ class KVStoreDist : public KVStoreLocal {
     }
   }
 
+  // push dense gradient compressed by gradient_compression_
+  void PushCompressed(int key, const NDArray& send_buf, int priority) {
+    CHECK_EQ(send_buf.dtype(), mshadow::kFloat32)
+      << "gradient compression only supports float32 values";
+    size_t size = send_buf.shape().Size();
+    auto& residual = residual_[key];
+    if (residual.is_none()) {
+      residual = NDArray(send_buf.shape(), pinned_ctx_, false, send_buf.dtype());
+      residual = 0;
+    }
+    auto& compr_buf = compr_buf_[key];
+    if (compr_buf.is_none()) {
+      // every partition is rounded up to a whole word at most
+      size_t compr_size = gradient_compression_.GetCompressedSize(size) + ps::NumServers();
+      compr_buf = NDArray(TShape(mshadow::Shape1(compr_size)), pinned_ctx_,
+                          true, mshadow::kFloat32);
+    }
+    auto push_to_servers = [this, key, size, send_buf, residual, compr_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      PSKV& pskv = EncodeKey(key, size);
+      PSKV& compr_pskv = EncodeCompressedKey(key, size);
+#if MKL_EXPERIMENTAL == 1
+      mkl_set_tblob_eager_mode(send_buf.data());
+#endif
+      const real_t* grad = send_buf.data().dptr<real_t>();
+      real_t* res = residual.data().dptr<real_t>();
+      real_t* data = compr_buf.data().dptr<real_t>();
+      // every partition is compressed on its own, so that each server can
+      // decompress its part
+      size_t offset = 0, compr_offset = 0;
+      for (size_t i = 0; i < pskv.lens.size(); ++i) {
+        gradient_compression_.Quantize(grad + offset, res + offset,
+                                       data + compr_offset, pskv.lens[i]);
+        offset += pskv.lens[i];
+        compr_offset += compr_pskv.lens[i];
+      }
+      // do push. false means no delete
+      ps::SArray<real_t> vals(data, compr_pskv.size, false);
+      CHECK_NOTNULL(ps_worker_)->ZPush(
+          compr_pskv.keys, vals, compr_pskv.lens, EncodeCmd(kCompressedPushPull, priority),
+          [cb]() { cb(); });
+    };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {residual.var(), compr_buf.var()},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistCompressedPush"));
+  }
+
+  // push dense values summed over the workers of the host, only the leader
+  // of the host sends them to the servers
+  void PushHierarchical(int key, const NDArray& send_buf, int priority) {
+    CHECK_EQ(send_buf.dtype(), mshadow::kFloat32)
+      << "hierarchical push only supports float32 values";
+    auto push_to_servers = [this, key, send_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      size_t size = send_buf.shape().Size();
+      PSKV* pskv = &EncodeKey(key, size);
+#if MKL_EXPERIMENTAL == 1
+      mkl_set_tblob_eager_mode(send_buf.data());
+#endif
+      host_reducer_->Contribute(key, send_buf.data().dptr<real_t>(), size);
+      if (!host_reducer_->is_leader()) {
+        // the servers still count every worker in a round, and answer once
+        // the values of the leader are merged
+        ps::SArray<real_t> vals;
+        ps::SArray<int> lens(pskv->keys.size(), 0);
+        CHECK_NOTNULL(ps_worker_)->ZPush(
+            pskv->keys, vals, lens, EncodeCmd(kLocalReducedPush, priority), [cb]() { cb(); });
+        return;
+      }
+      host_reducer_->ReduceAsync(key, size, [this, pskv, size, priority, cb](real_t* sum) {
+          // do push. false means no delete
+          ps::SArray<real_t> vals(sum, size, false);
+          CHECK_NOTNULL(ps_worker_)->ZPush(
+              pskv->keys, vals, pskv->lens, EncodeCmd(kDefaultPushPull, priority),
+              [cb]() { cb(); });
+        });
+    };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistHierarchicalPush"));
+  }
+
+  /**
+   * \brief whether the pushes and pulls of a dense float32 value are fused
+   *  with the ones of other small keys
+   */
+  bool IsFused(const NDArray& buf) const {
+    size_t size = buf.shape().Size();
+    return key_fusion_ && buf.storage_type() == kDefaultStorage &&
+        buf.dtype() == mshadow::kFloat32 && size < fusion_bound_ && size < bigarray_bound_;
+  }
+
+  // push a small dense value in the fused request of its bucket
+  void PushFused(int key, const NDArray& send_buf, int priority) {
+    auto push_to_servers = [this, key, send_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      size_t size = send_buf.shape().Size();
+      PSKV& pskv = EncodeKey(key, size);
+#if MKL_EXPERIMENTAL == 1
+      mkl_set_tblob_eager_mode(send_buf.data());
+#endif
+      key_fusion_->Push(pskv.keys[0], send_buf.data().dptr<real_t>(), size, priority,
+                        [cb]() { cb(); });
+    };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistFusedPush"));
+  }
+
+  // pull a small dense value in the fused request of its bucket
+  void PullFused(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      size_t size = recv_buf.shape().Size();
+      PSKV& pskv = EncodeKey(key, size);
+#if MKL_EXPERIMENTAL == 1
+      mkl_set_tblob_eager_mode(recv_buf.data());
+#endif
+      key_fusion_->Pull(pskv.keys[0], recv_buf.data().dptr<real_t>(), size, priority,
+                        [cb]() { cb(); });
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistFusedPull"));
+  }
+
+  // push dense float16 values, which are sent as float16 except for the
+  // initialization: the servers store float32 values, whose size is then
+  // used to decode the float16 pushes
+  void PushFP16(int key, const NDArray& send_buf, int priority, bool init) {
+    auto push_to_servers = [this, key, send_buf, init, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      using mshadow::half::half_t;
+      size_t size = send_buf.shape().Size();
+      PSKV& pskv = EncodeKey(key, size);
+      const half_t* data = send_buf.data().dptr<half_t>();
+      if (init) {
+        ps::SArray<real_t> vals(size);
+        for (size_t i = 0; i < size; ++i) {
+          vals[i] = static_cast<real_t>(data[i]);
+        }
+        CHECK_NOTNULL(ps_worker_)->ZPush(
+            pskv.keys, vals, pskv.lens, EncodeCmd(kDefaultPushPull, priority), [cb]() { cb(); });
+      } else {
+        PSKV& fp16_pskv = EncodeFP16Key(key, size);
+        ps::SArray<real_t> vals(fp16_pskv.size);
+        // every partition starts at a whole word
+        size_t offset = 0, fp16_offset = 0;
+        for (size_t i = 0; i < pskv.lens.size(); ++i) {
+          std::memcpy(vals.data() + fp16_offset, data + offset,
+                      pskv.lens[i] * sizeof(half_t));
+          offset += pskv.lens[i];
+          fp16_offset += fp16_pskv.lens[i];
+        }
+        CHECK_NOTNULL(ps_worker_)->ZPush(
+            fp16_pskv.keys, vals, fp16_pskv.lens, EncodeCmd(kFP16PushPull, priority),
+            [cb]() { cb(); });
+      }
+    };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistFP16Push"));
+  }
+
+  // pull dense float16 values, which are sent as float16
+  void PullFP16(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      size_t size = recv_buf.shape().Size();
+      PSKV* pskv = &EncodeKey(key, size);
+      PSKV* fp16_pskv = &EncodeFP16Key(key, size);
+      auto vals = new ps::SArray<real_t>(fp16_pskv->size);
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        fp16_pskv->keys, vals, &fp16_pskv->lens, EncodeCmd(kFP16PushPull, priority),
+        [vals, recv_buf, pskv, fp16_pskv, cb]() {
+          using mshadow::half::half_t;
+          half_t* data = recv_buf.data().dptr<half_t>();
+          size_t offset = 0, fp16_offset = 0;
+          for (size_t i = 0; i < pskv->lens.size(); ++i) {
+            std::memcpy(data + offset, vals->data() + fp16_offset,
+                        pskv->lens[i] * sizeof(half_t));
+            offset += pskv->lens[i];
+            fp16_offset += fp16_pskv->lens[i];
+          }
+          delete vals;
+          cb();
+        });
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistFP16Pull"));
+  }
+
+  // push dense float32 values as bfloat16, which the servers merge as float32
+  void PushBF16(int key, const NDArray& send_buf, int priority) {
+    auto push_to_servers = [this, key, send_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      using common::bf16_t;
+      size_t size = send_buf.shape().Size();
+      PSKV& pskv = EncodeKey(key, size);
+      PSKV& bf16_pskv = EncodeFP16Key(key, size);
+      const real_t* data = send_buf.data().dptr<real_t>();
+      ps::SArray<real_t> vals(bf16_pskv.size);
+      bf16_t* dst = reinterpret_cast<bf16_t*>(vals.data());
+      // every partition starts at a whole word
+      size_t offset = 0, bf16_offset = 0;
+      for (size_t i = 0; i < pskv.lens.size(); ++i) {
+        for (int j = 0; j < pskv.lens[i]; ++j) {
+          dst[2 * bf16_offset + j] = bf16_t(data[offset + j]);
+        }
+        offset += pskv.lens[i];
+        bf16_offset += bf16_pskv.lens[i];
+      }
+      CHECK_NOTNULL(ps_worker_)->ZPush(
+          bf16_pskv.keys, vals, bf16_pskv.lens, EncodeCmd(kBF16PushPull, priority),
+          [cb]() { cb(); });
+    };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistBF16Push"));
+  }
+
+  // pull dense float32 values, which are sent as bfloat16
+  void PullBF16(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      size_t size = recv_buf.shape().Size();
+      PSKV* pskv = &EncodeKey(key, size);
+      PSKV* bf16_pskv = &EncodeFP16Key(key, size);
+      auto vals = new ps::SArray<real_t>(bf16_pskv->size);
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        bf16_pskv->keys, vals, &bf16_pskv->lens, EncodeCmd(kBF16PushPull, priority),
+        [vals, recv_buf, pskv, bf16_pskv, cb]() {
+          using common::bf16_t;
+          real_t* data = recv_buf.data().dptr<real_t>();
+          const bf16_t* src = reinterpret_cast<const bf16_t*>(vals->data());
+          size_t offset = 0, bf16_offset = 0;
+          for (size_t i = 0; i < pskv->lens.size(); ++i) {
+            for (int j = 0; j < pskv->lens[i]; ++j) {
+              data[offset + j] = static_cast<real_t>(src[2 * bf16_offset + j]);
+            }
+            offset += pskv->lens[i];
+            bf16_offset += bf16_pskv->lens[i];
+          }
+          delete vals;
+          cb();
+        });
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kCPUPrioritized,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistBF16Pull"));
+  }
+
   // pull row sparse weight into `recv_buf` based on indices given by `indices`
   void PullRowSparse_(int key, NDArray *recv_buf, const NDArray& indices, int priority) {
     using namespace rowsparse;
-    auto pull_from_servers = [this, key, recv_buf, indices]
+    auto pull_from_servers = [this, key, recv_buf, indices, priority]
                              (RunContext rctx, Engine::CallbackOnComplete cb) {
       // allocate memory for the buffer
       size_t num_rows = indices.shape().Size();
@@ -343,7 +755,8 @@ class KVStoreDist : public KVStoreLocal {
                   << pskv.keys << " size: " << size;
       }
       auto vals = new ps::SArray<real_t>(data, size, false);
-      CHECK_NOTNULL(ps_worker_)->ZPull(pskv.keys, vals, &pskv.lens, kRowSparsePushPull,
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        pskv.keys, vals, &pskv.lens, EncodeCmd(kRowSparsePushPull, priority),
         [vals, cb]() { delete vals; cb(); });
       // copy indices to recv_buf
       mshadow::Copy(recv_buf->aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
@@ -354,7 +767,7 @@ class KVStoreDist : public KVStoreLocal {
         pinned_ctx_,
         {indices.var()},
         {recv_buf->var()},
-        FnProperty::kNormal,
+        FnProperty::kCPUPrioritized,
         priority,
         PROFILER_MESSAGE("KVStoreDistRowSparsePull"));
   }
@@ -362,7 +775,7 @@ class KVStoreDist : public KVStoreLocal {
   // push row sparse gradient
   void PushRowSparse(int key, const NDArray &send_buf, int priority) {
     using namespace rowsparse;
-    auto push_to_servers = [this, key, &send_buf]
+    auto push_to_servers = [this, key, &send_buf, priority]
                            (RunContext rctx, Engine::CallbackOnComplete cb) {
 #if MKL_EXPERIMENTAL == 1
       mkl_set_tblob_eager_mode(send_buf.data());
@@ -382,7 +795,8 @@ class KVStoreDist : public KVStoreLocal {
                   << pskv.keys << " size: " << size;
       }
       ps::SArray<real_t> vals(data, size, false);
-      CHECK_NOTNULL(ps_worker_)->ZPush(pskv.keys, vals, pskv.lens, kRowSparsePushPull, [cb]() {
+      CHECK_NOTNULL(ps_worker_)->ZPush(
+        pskv.keys, vals, pskv.lens, EncodeCmd(kRowSparsePushPull, priority), [cb]() {
         cb();
       });
     };
@@ -391,7 +805,7 @@ class KVStoreDist : public KVStoreLocal {
         pinned_ctx_,
         {send_buf.var()},
         {},
-        FnProperty::kNormal,
+        FnProperty::kCPUPrioritized,
         priority,
         PROFILER_MESSAGE("KVStoreDistRowSparsePush"));
   }
@@ -420,11 +834,80 @@ class KVStoreDist : public KVStoreLocal {
    */
   std::unordered_map<int, PSKV> ps_kv_;
 
+  /**
+   * \brief cache all key partitions of compressed pushes
+   */
+  std::unordered_map<int, PSKV> compr_ps_kv_;
+
+  /**
+   * \brief cache all key partitions of float16 and bfloat16 values
+   */
+  std::unordered_map<int, PSKV> fp16_ps_kv_;
+
   /**
    * \brief serizelize EncodeRowSparseKey and EncodeKey
    */
   std::mutex mu_;
 
+  /**
+   * \brief the parts received from the first server, by the timestamp of the request
+   */
+  std::unordered_map<int, int> parts_;
+  std::mutex parts_mu_;
+
+  /**
+   * \brief assign the dense keys being initialized to the servers by their
+   *  sizes in bytes. The keys are placed from the biggest one on, so that
+   *  every worker computes the same placement. A key smaller than
+   *  bigarray_bound_ goes to the server holding the fewest bytes so far, a
+   *  bigger one is sliced over the servers so as to even out their loads.
+   */
+  void PlaceKeys(const std::vector<int>& keys, const std::vector<NDArray>& values) {
+    size_t num_servers = ps::NumServers();
+    CHECK_GT(num_servers, 0U);
+    if (server_bytes_.empty()) server_bytes_.resize(num_servers, 0);
+    std::vector<std::pair<size_t, size_t>> order;  // (bytes, index)
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (values[i].storage_type() != kDefaultStorage) continue;
+      order.emplace_back(values[i].shape().Size() * mshadow::mshadow_sizeof(values[i].dtype()), i);
+    }
+    std::sort(order.begin(), order.end(), [&keys](const std::pair<size_t, size_t>& a,
+                                                  const std::pair<size_t, size_t>& b) {
+        return a.first != b.first ? a.first > b.first : keys[a.second] < keys[b.second];
+      });
+    for (const auto& o : order) {
+      size_t size = values[o.second].shape().Size();
+      size_t unit = o.first / std::max<size_t>(size, 1);
+      std::vector<size_t> parts(num_servers, 0);
+      size_t least = std::min_element(server_bytes_.begin(), server_bytes_.end()) -
+          server_bytes_.begin();
+      if (size < bigarray_bound_ || num_servers == 1) {
+        parts[least] = size;
+      } else {
+        // fill the servers up to the level at which the key is used up
+        std::vector<size_t> loads = server_bytes_;
+        std::sort(loads.begin(), loads.end());
+        double level = 0, filled = 0;
+        for (size_t n = 1; n <= num_servers; ++n) {
+          filled += loads[n - 1];
+          level = (static_cast<double>(o.first) + filled) / n;
+          if (n == num_servers || level <= loads[n]) break;
+        }
+        size_t assigned = 0;
+        for (size_t i = 0; i < num_servers; ++i) {
+          double room = level - static_cast<double>(server_bytes_[i]);
+          parts[i] = room > 0 ? std::min(size - assigned, static_cast<size_t>(room / unit)) : 0;
+          assigned += parts[i];
+        }
+        // the rounding leftover goes to the least loaded server
+        parts[least] += size - assigned;
+      }
+      for (size_t i = 0; i < num_servers; ++i) server_bytes_[i] += parts[i] * unit;
+      std::lock_guard<std::mutex> lock(mu_);
+      key_parts_[keys[o.second]] = parts;
+    }
+  }
+
   /**
    * \brief convert to keys in ps
    */
@@ -440,8 +923,24 @@ class KVStoreDist : public KVStoreLocal {
       int num_servers = krs.size();
       CHECK_GT(num_servers, 0);
 
-      // a simple heuristic for load balance
-      if (size < bigarray_bound_) {
+      std::vector<size_t> parts;
+      mu_.lock();
+      auto placed = key_parts_.find(key);
+      if (placed != key_parts_.end()) parts = placed->second;
+      mu_.unlock();
+      if (!parts.empty()) {
+        // the placement computed by PlaceKeys
+        pskv.size = 0;
+        for (int i = 0; i < num_servers; ++i) {
+          if (parts[i] == 0) continue;
+          ps::Key ps_key = krs[i].begin() + key;
+          CHECK_LT(ps_key, krs[i].end());
+          pskv.keys.push_back(ps_key);
+          pskv.lens.push_back(parts[i]);
+          pskv.size += parts[i];
+        }
+        CHECK_EQ(static_cast<size_t>(pskv.size), size);
+      } else if (size < bigarray_bound_) {
         // send it to a single random picked server
         int server = (key * 9973) % num_servers;
         ps::Key ps_key = krs[server].begin() + key;
@@ -468,6 +967,49 @@ class KVStoreDist : public KVStoreLocal {
     return pskv;
   }
 
+  /**
+   * \brief convert to keys in ps for values sent in a packed form, with the
+   *  same partitions as \ref EncodeKey
+   * \param packed_ps_kv the cache of the packed keys
+   * \param packed_len gives the number of real_t of a packed partition
+   */
+  template<typename F>
+  inline PSKV& EncodePackedKey(int key, size_t size,
+                               std::unordered_map<int, PSKV>* packed_ps_kv,
+                               F packed_len) {
+    PSKV& pskv = EncodeKey(key, size);
+    std::lock_guard<std::mutex> lock(mu_);
+    PSKV& packed_pskv = (*packed_ps_kv)[key];
+    if (packed_pskv.keys.empty()) {
+      packed_pskv.keys = pskv.keys;
+      packed_pskv.size = 0;
+      for (int len : pskv.lens) {
+        int plen = packed_len(len);
+        packed_pskv.lens.push_back(plen);
+        packed_pskv.size += plen;
+      }
+    }
+    return packed_pskv;
+  }
+
+  /**
+   * \brief convert to keys in ps for a compressed push
+   */
+  inline PSKV& EncodeCompressedKey(int key, size_t size) {
+    return EncodePackedKey(key, size, &compr_ps_kv_, [this](size_t len) {
+        return gradient_compression_.GetCompressedSize(len);
+      });
+  }
+
+  /**
+   * \brief convert to keys in ps for float16 or bfloat16 values, two per real_t
+   */
+  inline PSKV& EncodeFP16Key(int key, size_t size) {
+    return EncodePackedKey(key, size, &fp16_ps_kv_, [](size_t len) {
+        return (len + 1) / 2;
+      });
+  }
+
   // TODO(haibin) this encoding method for row sparse keys doesn't allow cross-layer batching
   inline PSKV& EncodeRowSparseKey(const int key, const int64_t size, const int64_t num_rows,
                                   const int64_t *offsets, const size_t unit_len,
@@ -538,9 +1080,33 @@ class KVStoreDist : public KVStoreLocal {
    * \brief threshold for partition
    */
   size_t bigarray_bound_;
+  /// \brief whether the dense keys are placed on the servers by \ref PlaceKeys
+  bool balanced_placement_;
+  /// \brief whether dense float32 values are sent as bfloat16
+  bool bf16_;
+  /// \brief number of values of every placed key on each server
+  std::unordered_map<int, std::vector<size_t>> key_parts_;
+  /// \brief bytes of the placed keys on each server
+  std::vector<size_t> server_bytes_;
   /// \brief send & recver buffer
   std::unordered_map<int, NDArray> comm_buf_;
   bool log_verbose_;
+  /**
+   * \brief compression of the dense pushes
+   */
+  GradientCompression gradient_compression_;
+  /// \brief gradients not sent yet by the compressed pushes
+  std::unordered_map<int, NDArray> residual_;
+  /// \brief send buffer of the compressed pushes
+  std::unordered_map<int, NDArray> compr_buf_;
+  /// \brief sums the pushes of the workers of the host, if hierarchical
+  std::unique_ptr<HostReducer> host_reducer_;
+  /**
+   * \brief values smaller than it are sent in fused requests, if positive
+   */
+  size_t fusion_bound_;
+  /// \brief packs the pushes and pulls of small values
+  std::unique_ptr<KeyFusion> key_fusion_;
 };
 
 }  // namespace kvstore
@@ -0,0 +1,248 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file   kvstore_dist_allreduce.h
+ * @brief  distributed implementation summing over the workers by allreduce
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+#define MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./kvstore_local.h"
+#include "./kvstore_dist_server.h"
+#include "./ring_allreduce.h"
+#include "mxnet/engine.h"
+#include "ps/ps.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief runs on the scheduler, sends the addresses of all the workers of a
+ *  dist_sync_allreduce kvstore to every worker once they are all known
+ */
+class AllreduceRendezvous {
+ public:
+  AllreduceRendezvous() {
+    using namespace std::placeholders;
+    app_ = new ps::SimpleApp(0);
+    app_->set_request_handle(std::bind(&AllreduceRendezvous::Handle, this, _1, _2));
+  }
+  ~AllreduceRendezvous() {
+    delete app_;
+  }
+
+ private:
+  void Handle(const ps::SimpleData& recved, ps::SimpleApp* app) {
+    CHECK_EQ(recved.head, kAllreduceRendezvous) << "unexpected command " << recved.head;
+    int rank;
+    std::string addr;
+    std::istringstream is(recved.body);
+    is >> rank >> addr;
+    addrs_.resize(ps::NumWorkers());
+    CHECK_GE(rank, 0);
+    CHECK_LT(rank, ps::NumWorkers());
+    addrs_[rank] = addr;
+    requests_.push_back(recved);
+    if (requests_.size() == addrs_.size()) {
+      std::string body;
+      for (const auto& a : addrs_) body += a + " ";
+      for (const auto& req : requests_) app->Response(req, body);
+      requests_.clear();
+    }
+  }
+  ps::SimpleApp* app_;
+  std::vector<std::string> addrs_;
+  std::vector<ps::SimpleData> requests_;
+};
+
+/**
+ * \brief distributed kvstore without servers
+ *
+ * Every worker keeps all the values, as \ref KVStoreLocal does. A push first
+ * reduces the values of the devices through \ref Comm, then sums the result
+ * over the workers with a ring allreduce, and finally updates the value of
+ * the key, by the updater if set. All workers thus run the same updates on
+ * the same sums, and hold the same values. The initial values are those of
+ * worker 0.
+ *
+ * All workers must init and push the same keys in the same order, which is
+ * the order of the allreduces. Only dense float32 values are supported.
+ */
+class KVStoreDistAllreduce : public KVStoreLocal {
+ public:
+  explicit KVStoreDistAllreduce(bool use_device_comm, bool use_nccl = false)
+      : KVStoreLocal(use_device_comm, use_nccl) {
+    using namespace std::placeholders;
+    CHECK(IsWorkerNode()) << "dist_sync_allreduce only runs on workers";
+    app_ = new ps::SimpleApp(0);
+    app_->set_response_handle(std::bind(&KVStoreDistAllreduce::HandleResponse, this, _1, _2));
+    ps::StartAsync("mxnet\0");
+    if (!ps::Postoffice::Get()->is_recovery()) {
+      ps::Postoffice::Get()->Barrier(
+        ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
+    }
+    if (ps::NumWorkers() > 1) Connect();
+  }
+
+  virtual ~KVStoreDistAllreduce() {
+    Engine::Get()->WaitForAll();
+    ring_.reset();
+    if (barrier_before_exit_) {
+      Barrier();
+      if (get_rank() == 0 && ps::NumServers() > 0) {
+        // servers started by the launcher have nothing to do
+        app_->Wait(app_->Request(kStopServer, "", ps::kServerGroup));
+      }
+    }
+    ps::Finalize(barrier_before_exit_);
+    delete app_;
+  }
+
+  void Barrier() override {
+    ps::Postoffice::Get()->Barrier(ps::kWorkerGroup);
+  }
+
+  int get_group_size() const override { return ps::NumWorkers(); }
+
+  int get_rank() const override { return ps::MyRank(); }
+
+ private:
+  void InitImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values) override {
+    KVStoreLocal::InitImpl(keys, values);
+    for (int key : keys) {
+      NDArray& local = local_[key];
+      CheckValue(local);
+      // the sum is the value of worker 0
+      if (get_rank() != 0) local = 0;
+      Allreduce(&local, 0);
+    }
+  }
+
+  void PushImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values,
+                int priority) override {
+    std::vector<int> uniq_keys;
+    std::vector<std::vector<NDArray> > grouped_vals;
+    GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals);
+    for (const auto& vals : grouped_vals) CheckValue(vals[0]);
+    std::vector<NDArray> reduced;
+    comm_->BatchReduce(uniq_keys, grouped_vals, priority, &reduced);
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      int key = uniq_keys[i];
+      const NDArray& merged = reduced[i];
+      // the reduced values may belong to the caller, sum a copy of them
+      auto& buf = allreduce_buf_[key];
+      if (buf.is_none()) {
+        buf = NDArray(merged.shape(), pinned_ctx_, true, merged.dtype());
+      }
+      CopyFromTo(merged, &buf, priority);
+      Allreduce(&buf, priority);
+      UpdateLocal(key, buf);
+    }
+  }
+
+  void CheckValue(const NDArray& value) {
+    CHECK_EQ(value.storage_type(), kDefaultStorage)
+      << "dist_sync_allreduce only supports dense values";
+    CHECK_EQ(value.dtype(), mshadow::kFloat32)
+      << "dist_sync_allreduce only supports float32 values";
+  }
+
+  /**
+   * \brief sum value over the workers in place
+   */
+  void Allreduce(NDArray* value, int priority) {
+    if (ring_ == nullptr) return;
+    uint64_t seq = next_seq_++;
+    NDArray buf = *value;
+    auto allreduce = [this, seq, buf](RunContext rctx, Engine::CallbackOnComplete cb) {
+      ring_->AllreduceAsync(seq, buf.data().dptr<real_t>(), buf.shape().Size(),
+                            [cb]() { cb(); });
+    };
+    Engine::Get()->PushAsync(
+        allreduce,
+        pinned_ctx_,
+        {},
+        {buf.var()},
+        FnProperty::kNormal,
+        priority,
+        PROFILER_MESSAGE("KVStoreDistAllreduce"));
+  }
+
+  /**
+   * \brief exchange the addresses through the scheduler and connect the ring
+   */
+  void Connect() {
+    int port;
+    int listen_fd = RingAllreduce::Listen(&port);
+    std::string host = dmlc::GetEnv("DMLC_NODE_HOST", std::string());
+    if (host.empty()) {
+      host = RingAllreduce::LocalAddress(dmlc::GetEnv("DMLC_PS_ROOT_URI", std::string()),
+                                         dmlc::GetEnv("DMLC_PS_ROOT_PORT", 0));
+    }
+    std::ostringstream os;
+    os << get_rank() << " " << host << ":" << port;
+    app_->Wait(app_->Request(kAllreduceRendezvous, os.str(), ps::kScheduler));
+    std::vector<std::string> addrs;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      std::istringstream is(addrs_body_);
+      std::string addr;
+      while (is >> addr) addrs.push_back(addr);
+    }
+    CHECK_EQ(addrs.size(), static_cast<size_t>(get_group_size()));
+    const std::string& right = addrs[(get_rank() + 1) % get_group_size()];
+    size_t colon = right.rfind(':');
+    int right_fd = RingAllreduce::Connect(right.substr(0, colon),
+                                          std::stoi(right.substr(colon + 1)));
+    int left_fd = RingAllreduce::Accept(listen_fd);
+    close(listen_fd);
+    ring_.reset(new RingAllreduce(get_rank(), get_group_size(), left_fd, right_fd));
+  }
+
+  void HandleResponse(const ps::SimpleData& recved, ps::SimpleApp* app) {
+    if (recved.head == kAllreduceRendezvous) {
+      std::lock_guard<std::mutex> lock(mu_);
+      addrs_body_ = recved.body;
+    }
+  }
+
+  /// \brief for the commands to the scheduler and the servers
+  ps::SimpleApp* app_;
+  /// \brief the ring, null with a single worker
+  std::unique_ptr<RingAllreduce> ring_;
+  /// \brief sequence number of the next allreduce
+  uint64_t next_seq_{0};
+  /// \brief the pushed values summed over the workers
+  std::unordered_map<int, NDArray> allreduce_buf_;
+  /// \brief the addresses of the workers sent by the scheduler
+  std::string addrs_body_;
+  std::mutex mu_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
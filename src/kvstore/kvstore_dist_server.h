@@ -23,16 +23,27 @@
  */
 #ifndef MXNET_KVSTORE_KVSTORE_DIST_SERVER_H_
 #define MXNET_KVSTORE_KVSTORE_DIST_SERVER_H_
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
 #include <queue>
+#include <map>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
 #include <functional>
 #include <future>
+#include <thread>
 #include <vector>
 #include "ps/ps.h"
 #include "mxnet/kvstore.h"
+#include "./gradient_compression.h"
+#include "../common/bfloat16.h"
 #include "../operator/tensor/elemwise_binary_op.h"
 #include "../operator/tensor/init_op.h"
 
@@ -41,8 +52,39 @@ namespace kvstore {
 
 static const int kRowSparsePushPull = 1;
 static const int kDefaultPushPull = 0;
+static const int kCompressedPushPull = 2;
+static const int kFP16PushPull = 3;
+static const int kLocalReducedPush = 4;
+static const int kFusedPushPull = 5;
+static const int kBF16PushPull = 6;
 static const int kStopServer = -1;
 static const int kSyncMode = -2;
+static const int kSetGradientCompression = -3;
+static const int kAllreduceRendezvous = -4;
+static const int kSSPMode = -5;
+static const int kSaveShards = -6;
+static const int kLoadShards = -7;
+static const int kNextPart = -8;
+
+/**
+ * \brief the command of a data request carries the type of the request,
+ *  such as \ref kDefaultPushPull, in its low bits and the priority of the
+ *  request above them
+ */
+static const int kCmdTypeBits = 4;
+
+inline int EncodeCmd(int type, int priority) {
+  return type + priority * (1 << kCmdTypeBits);
+}
+
+inline int DecodeCmdType(int cmd) {
+  int type = cmd % (1 << kCmdTypeBits);
+  return type < 0 ? type + (1 << kCmdTypeBits) : type;
+}
+
+inline int DecodeCmdPriority(int cmd) {
+  return (cmd - DecodeCmdType(cmd)) / (1 << kCmdTypeBits);
+}
 
 /**
  * \brief executor runs a function using the thread called \ref Start
@@ -106,6 +148,82 @@ class Executor {
   std::condition_variable cond_;
 };
 
+/**
+ * \brief runs functions on a pool of threads. Every key is hashed to one of
+ *  the threads, which runs the functions of highest priority first, and the
+ *  functions of the same priority in the order they are pushed.
+ */
+class KeyedExecutor {
+ public:
+  typedef std::function<void()> Func;
+
+  explicit KeyedExecutor(int num_threads) {
+    CHECK_GT(num_threads, 0);
+    for (int i = 0; i < num_threads; ++i) {
+      queues_.emplace_back(new Queue());
+      Queue* q = queues_.back().get();
+      threads_.emplace_back([q]() { Run(q); });
+    }
+  }
+
+  /**
+   * \brief run the functions pushed so far and stop the threads
+   */
+  ~KeyedExecutor() {
+    for (auto& q : queues_) {
+      std::lock_guard<std::mutex> lk(q->mu);
+      q->exit = true;
+      q->cond.notify_one();
+    }
+    for (auto& t : threads_) t.join();
+  }
+
+  /**
+   * \brief run func on the thread of key. threadsafe
+   */
+  void Push(int key, int priority, const Func& func) {
+    Queue* q = queues_[static_cast<size_t>(key) % queues_.size()].get();
+    std::lock_guard<std::mutex> lk(q->mu);
+    q->funcs.push(Task{priority, q->next_seq++, func});
+    q->cond.notify_one();
+  }
+
+ private:
+  struct Task {
+    int priority;
+    uint64_t seq;
+    Func func;
+  };
+  struct TaskOrder {
+    bool operator()(const Task& a, const Task& b) const {
+      return a.priority != b.priority ? a.priority < b.priority : a.seq > b.seq;
+    }
+  };
+  struct Queue {
+    std::priority_queue<Task, std::vector<Task>, TaskOrder> funcs;
+    uint64_t next_seq = 0;
+    bool exit = false;
+    std::mutex mu;
+    std::condition_variable cond;
+  };
+
+  static void Run(Queue* q) {
+    std::unique_lock<std::mutex> lk(q->mu);
+    while (true) {
+      q->cond.wait(lk, [q]{ return q->exit || !q->funcs.empty(); });
+      if (q->funcs.empty()) break;
+      Func func = q->funcs.top().func;
+      q->funcs.pop();
+      lk.unlock();
+      func();
+      lk.lock();
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+};
+
 class KVStoreDistServer {
  public:
   KVStoreDistServer() {
@@ -116,10 +234,16 @@ class KVStoreDistServer {
     ps_server_->set_request_handle(
         std::bind(&KVStoreDistServer::DataHandleEx, this, _1, _2, _3));
     sync_mode_ = false;
+    backup_workers_ = 0;
+    staleness_ = -1;
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    zero_copy_pull_ = dmlc::GetEnv("MXNET_KVSTORE_SERVER_ZERO_COPY_PULL", false);
+    // requests are queued by priority while the previous ones are handled
+    key_exec_.reset(new KeyedExecutor(dmlc::GetEnv("MXNET_KVSTORE_SERVER_NTHREADS", 1)));
   }
 
   ~KVStoreDistServer() {
+    key_exec_.reset();
     delete ps_server_;
   }
 
@@ -150,7 +274,24 @@ class KVStoreDistServer {
     if (recved.head == kStopServer) {
       exec_.Stop();
     } else if (recved.head == kSyncMode) {
+      // the body is the number of backup workers, empty for older workers
+      backup_workers_ = recved.body.empty() ? 0 : std::stoi(recved.body);
+      CHECK_GE(backup_workers_, 0) << "the number of backup workers cannot be negative";
+      CHECK_LT(backup_workers_, ps::NumWorkers())
+          << "the number of backup workers must be smaller than the number of workers";
       sync_mode_ = true;
+    } else if (recved.head == kSSPMode) {
+      staleness_ = std::stoi(recved.body);
+      CHECK_GE(staleness_, 0) << "the staleness of dist_ssp cannot be negative";
+    } else if (recved.head == kSetGradientCompression) {
+      gradient_compression_.DecodeParams(recved.body);
+    } else if (recved.head == kSaveShards) {
+      SaveShards(recved.body);
+    } else if (recved.head == kLoadShards) {
+      LoadShards(recved.body);
+    } else if (recved.head == kNextPart) {
+      app->Response(recved, NextPart(recved.body));
+      return;
     } else {
       // let the main thread to execute ctrl, which is necessary for python
       exec_.Exec([this, recved]() {
@@ -161,11 +302,109 @@ class KVStoreDistServer {
     app->Response(recved);
   }
 
-  void DataHandleEx(const ps::KVMeta& req_meta,
+  /**
+   * \brief hand out the next part of the data and epoch of the request
+   *  "epoch num_parts name" of a worker, -1 once all were handed out
+   */
+  std::string NextPart(const std::string& body) {
+    std::istringstream is(body);
+    int epoch, num_parts;
+    std::string name;
+    CHECK(is >> epoch >> num_parts && std::getline(is >> std::ws, name))
+        << "invalid request of a part " << body;
+    std::lock_guard<std::mutex> lk(parts_mu_);
+    int& next = next_part_[std::make_pair(name, epoch)];
+    return std::to_string(next < num_parts ? next++ : -1);
+  }
+
+  /**
+   * \brief the file of the values stored by this server, every server
+   *  writing and reading its own file in parallel
+   */
+  static std::string ShardFile(const std::string& prefix) {
+    return prefix + "-server" + std::to_string(ps::MyRank()) + ".params";
+  }
+
+  /**
+   * \brief write the values stored by this server, the slices of the keys
+   *  partitioned over the servers included, named by their keys
+   */
+  void SaveShards(const std::string& prefix) {
+    std::vector<NDArray> data;
+    std::vector<std::string> names;
+    {
+      std::lock_guard<std::mutex> lk(map_mu_);
+      for (const auto& kv : store_) {
+        if (kv.second.is_none()) continue;
+        names.push_back(std::to_string(kv.first));
+        data.push_back(kv.second);
+      }
+    }
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(ShardFile(prefix).c_str(), "w"));
+    NDArray::Save(fo.get(), data, names);
+  }
+
+  /**
+   * \brief restore the values written by \ref SaveShards into the stored
+   *  values, which must be initialized with the same number of servers and
+   *  the same placement of the keys
+   */
+  void LoadShards(const std::string& prefix) {
+    std::vector<NDArray> data;
+    std::vector<std::string> names;
+    {
+      std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(ShardFile(prefix).c_str(), "r"));
+      NDArray::Load(fi.get(), &data, &names);
+    }
+    CHECK_EQ(names.size(), data.size()) << "Invalid shard file " << ShardFile(prefix);
+    for (size_t i = 0; i < data.size(); ++i) {
+      int key = std::stoi(names[i]);
+      auto& stored = GetStored(key);
+      CHECK(!stored.is_none()) << "init key " << key << " before restoring it";
+      CHECK_EQ(stored.shape(), data[i].shape())
+          << "key " << key << " is not placed on the servers as when it was saved";
+      CopyFromTo(data[i], &stored, 0);
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+      GetStored(std::stoi(names[i])).WaitToRead();
+    }
+  }
+
+  void DataHandleEx(const ps::KVMeta& meta,
                     const ps::KVPairs<real_t>& req_data,
                     ps::KVServer<real_t>* server) {
+    // the handlers see the type of the request only
+    ps::KVMeta req_meta = meta;
+    req_meta.cmd = DecodeCmdType(meta.cmd);
+    int priority = DecodeCmdPriority(meta.cmd);
+    if (req_meta.cmd == kFusedPushPull) {
+      // the keys of a fused request are handled one by one
+      DataHandleFused(req_meta, req_data, priority, server);
+      return;
+    }
+    CHECK(!req_data.keys.empty());
+    key_exec_->Push(DecodeKey(req_data.keys[0]), priority,
+                    [this, req_meta, req_data, server]() {
+        DataHandleKey(req_meta, req_data, server);
+      });
+  }
+
+  /**
+   * \brief handle a request whose keys all belong to one key
+   */
+  void DataHandleKey(const ps::KVMeta& req_meta,
+                     const ps::KVPairs<real_t>& req_data,
+                     ps::KVServer<real_t>* server) {
     if (req_meta.cmd == kRowSparsePushPull) {
       DataHandleRowSparse(req_meta, req_data, server);
+    } else if (req_meta.cmd == kCompressedPushPull) {
+      DataHandleCompressed(req_meta, req_data, server);
+    } else if (req_meta.cmd == kFP16PushPull) {
+      DataHandle16Bit<mshadow::half::half_t>(req_meta, req_data, server);
+    } else if (req_meta.cmd == kBF16PushPull) {
+      DataHandle16Bit<common::bf16_t>(req_meta, req_data, server);
+    } else if (req_meta.cmd == kLocalReducedPush) {
+      DataHandleLocalReduced(req_meta, req_data, server);
     } else {
       DataHandleDefault(req_meta, req_data, server);
     }
@@ -174,7 +413,15 @@ class KVStoreDistServer {
 
   inline void ApplyUpdates(const int key, MergeBuf *merged, NDArray *stored,
                            ps::KVServer<real_t>* server) {
-    if (merged->request.size() == (size_t) ps::NumWorkers()) {
+    const size_t num_merged = ps::NumWorkers() - backup_workers_;
+    if (merged->request.size() == num_merged) {
+      if (backup_workers_ > 0) {
+        // dense values are scaled as if all the workers had pushed
+        GetBackupClock(key).rounds++;
+        if (merged->array.storage_type() == kDefaultStorage) {
+          merged->array *= static_cast<real_t>(ps::NumWorkers()) / num_merged;
+        }
+      }
       // let the main thread to execute updater_, which is necessary for python
       if (updater_) {
         exec_.Exec([this, key, merged, stored](){
@@ -189,7 +436,7 @@ class KVStoreDistServer {
         LOG(INFO) << "sync response to " << merged->request.size() << " workers";
       }
       for (const auto& req : merged->request) {
-        server->Response(req);
+        RespondPush(req, server);
       }
       merged->request.clear();
       stored->WaitToRead();
@@ -198,6 +445,26 @@ class KVStoreDistServer {
     }
   }
 
+  /**
+   * \brief whether a sync push of key is the push of a round already applied
+   *  without waiting for it, with backup workers. It is answered without
+   *  being merged, and the pushes of its worker then count for the round in
+   *  progress. Pushes of a key are handled in order.
+   */
+  bool IsLatePush(int key, const ps::KVMeta& req_meta) {
+    if (backup_workers_ == 0) return false;
+    auto& backup = GetBackupClock(key);
+    if (backup.clock.empty()) backup.clock.resize(ps::NumWorkers(), 0);
+    int& clock = backup.clock[ps::Postoffice::IDtoRank(req_meta.sender)];
+    if (++clock > backup.rounds) return false;
+    clock = backup.rounds;
+    if (log_verbose_) {
+      LOG(INFO) << "drop the late push of key " << key << " from worker "
+                << ps::Postoffice::IDtoRank(req_meta.sender);
+    }
+    return true;
+  }
+
   void DecodeRowIds(const ps::SArray<ps::Key> &keys, int64_t *indices,
                     const int64_t master_key, const int64_t num_rows) {
     indices[0] = 0;
@@ -213,7 +480,7 @@ class KVStoreDistServer {
                        ps::KVServer<real_t>* server) {
     int master_key = DecodeKey(req_data.keys[0]);
     auto num_rows = req_data.keys.size() - 1;
-    auto& stored = store_[master_key];
+    auto& stored = GetStored(master_key);
     if (req_meta.push) {
       CHECK_GT(req_data.lens.size(), 0) << "req_data.lens cannot be empty";
       CHECK_EQ(req_data.lens[0], 0);
@@ -246,7 +513,11 @@ class KVStoreDistServer {
       // synced push
       if (sync_mode_) {
         if (log_verbose_) LOG(INFO) << "sync push: " << master_key << " " << req_data.keys;
-        auto& merged = merge_buf_[master_key];
+        if (IsLatePush(master_key, req_meta)) {
+          RespondPush(req_meta, server);
+          return;
+        }
+        auto& merged = GetMergeBuf(master_key);
         if (merged.array.is_none()) {
           merged.array = NDArray(kRowSparseStorage, stored.shape(), Context());
         }
@@ -290,7 +561,8 @@ class KVStoreDistServer {
               inputs.push_back(recved);
               inputs.push_back(merged.array);
               outputs.push_back(out);
-              op::BinaryComputeRspRspImpl<cpu, cpu>({}, {}, inputs, {kWriteTo}, outputs);
+              op::BinaryComputeRspRspImpl<cpu, mshadow::op::plus>({}, {}, inputs, {kWriteTo},
+                                                                   outputs);
             }, recved.ctx(), const_vars, {out.var()},
             FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
           CopyFromTo(out, &merged.array, 0);
@@ -301,7 +573,7 @@ class KVStoreDistServer {
         // async push
         if (log_verbose_) LOG(INFO) << "async push: " << master_key;
         if (num_rows == 0) {
-          server->Response(req_meta);
+          RespondAsyncPush(req_meta, master_key, server);
           return;
         }
         auto unit_len = req_data.lens[1];
@@ -318,7 +590,7 @@ class KVStoreDistServer {
             CHECK(updater_);
             updater_(master_key, recved, &stored);
           });
-        server->Response(req_meta);
+        RespondAsyncPush(req_meta, master_key, server);
         stored.WaitToRead();
       }
     } else {
@@ -368,7 +640,7 @@ class KVStoreDistServer {
     }
 
     int key = DecodeKey(req_data.keys[0]);
-    auto& stored = store_[key];
+    auto& stored = GetStored(key);
 
     // there used several WaitToRead, this is because \a recved's memory
     // could be deallocated when this function returns. so we need to make sure
@@ -385,27 +657,8 @@ class KVStoreDistServer {
         CopyFromTo(recved, &stored, 0);
         server->Response(req_meta);
         stored.WaitToRead();
-      } else if (sync_mode_) {
-        // synced push
-        auto& merged = merge_buf_[key];
-        if (merged.array.is_none()) {
-          merged.array = NDArray(dshape, Context());
-        }
-        if (merged.request.size() == 0) {
-          CopyFromTo(recved, &merged.array, 0);
-        } else {
-          merged.array += recved;
-        }
-        merged.request.push_back(req_meta);
-        ApplyUpdates(key, &merged, &stored, server);
       } else {
-        // async push
-        exec_.Exec([this, key, &recved, &stored](){
-            CHECK(updater_);
-            updater_(key, recved, &stored);
-          });
-        server->Response(req_meta);
-        stored.WaitToRead();
+        DataHandlePush(req_meta, key, recved, server);
       }
     } else {
       // pull
@@ -414,12 +667,297 @@ class KVStoreDistServer {
       auto len = stored.shape().Size();
       response.keys = req_data.keys;
       response.lens = {len};
-      // TODO(mli) try to remove this CopyFrom
-      response.vals.CopyFrom(static_cast<const float*>(stored.data().dptr_), len);
+      if (sync_mode_ && zero_copy_pull_) {
+        // send the stored value itself, which the transport reads after this
+        // returns. It is only written by the next round of pushes, which the
+        // workers issue after receiving their pulls. false means no delete
+        response.vals = ps::SArray<real_t>(static_cast<real_t*>(stored.data().dptr_),
+                                           len, false);
+      } else {
+        response.vals.CopyFrom(static_cast<const float*>(stored.data().dptr_), len);
+      }
       server->Response(req_meta, response);
     }
   }
 
+  /**
+   * \brief merge or apply a dense push into the initialized value of key
+   */
+  void DataHandlePush(const ps::KVMeta& req_meta, int key, const NDArray& recved,
+                      ps::KVServer<real_t>* server) {
+    auto& stored = GetStored(key);
+    if (sync_mode_) {
+      // synced push
+      if (IsLatePush(key, req_meta)) {
+        RespondPush(req_meta, server);
+        return;
+      }
+      auto& merged = GetMergeBuf(key);
+      if (merged.array.is_none()) {
+        merged.array = NDArray(recved.shape(), Context());
+      }
+      if (merged.request.size() == 0) {
+        CopyFromTo(recved, &merged.array, 0);
+      } else {
+        merged.array += recved;
+      }
+      merged.request.push_back(req_meta);
+      ApplyUpdates(key, &merged, &stored, server);
+    } else {
+      // async push
+      exec_.Exec([this, key, &recved, &stored](){
+          CHECK(updater_);
+          updater_(key, recved, &stored);
+        });
+      RespondAsyncPush(req_meta, key, server);
+      stored.WaitToRead();
+    }
+  }
+
+  /**
+   * \brief answer an applied push of key when not in sync mode. In the ssp
+   *  mode, the push of a worker more than staleness_ pushes of key ahead of
+   *  the slowest worker is answered once the slowest one catches up.
+   */
+  void RespondAsyncPush(const ps::KVMeta& req_meta, int key, ps::KVServer<real_t>* server) {
+    if (staleness_ < 0) {
+      RespondPush(req_meta, server);
+      return;
+    }
+    auto& ssp = GetSSPClock(key);
+    if (ssp.clock.empty()) ssp.clock.resize(ps::NumWorkers(), 0);
+    ++ssp.clock[ps::Postoffice::IDtoRank(req_meta.sender)];
+    int slowest = *std::min_element(ssp.clock.begin(), ssp.clock.end());
+    ssp.waiting.push_back(req_meta);
+    for (auto it = ssp.waiting.begin(); it != ssp.waiting.end();) {
+      if (ssp.clock[ps::Postoffice::IDtoRank(it->sender)] - slowest <= staleness_) {
+        RespondPush(*it, server);
+        it = ssp.waiting.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  /**
+   * \brief answer a dense push, a fused push is answered once all its keys
+   *  are done
+   */
+  void RespondPush(const ps::KVMeta& req_meta, ps::KVServer<real_t>* server) {
+    if (req_meta.cmd == kFusedPushPull) {
+      std::lock_guard<std::mutex> lk(fused_mu_);
+      auto it = fused_pending_.find(std::make_pair(req_meta.sender, req_meta.timestamp));
+      CHECK(it != fused_pending_.end());
+      if (--it->second > 0) return;
+      fused_pending_.erase(it);
+    }
+    server->Response(req_meta);
+  }
+
+  /**
+   * \brief push and pull of several small dense keys in one request, each
+   *  of them handled as a default push or pull
+   */
+  void DataHandleFused(const ps::KVMeta& req_meta,
+                       const ps::KVPairs<real_t> &req_data,
+                       int priority,
+                       ps::KVServer<real_t>* server) {
+    size_t num_keys = req_data.keys.size();
+    CHECK_EQ(req_data.lens.size(), num_keys);
+    if (req_meta.push) {
+      {
+        std::lock_guard<std::mutex> lk(fused_mu_);
+        fused_pending_[std::make_pair(req_meta.sender, req_meta.timestamp)] = num_keys;
+      }
+      size_t offset = 0;
+      for (size_t i = 0; i < num_keys; ++i) {
+        int key = DecodeKey(req_data.keys[i]);
+        size_t len = req_data.lens[i];
+        CHECK_LE(offset + len, req_data.vals.size());
+        key_exec_->Push(key, priority, [this, req_meta, req_data, server, key, offset, len]() {
+            auto& stored = GetStored(key);
+            CHECK(!stored.is_none()) << "init " << key << " first";
+            CHECK_EQ(stored.shape().Size(), len);
+            TBlob recv_blob(const_cast<real_t*>(req_data.vals.data()) + offset,  // NOLINT(*)
+                            mshadow::Shape1(len), cpu::kDevMask);
+            // merged or applied before returning, so that the request can be freed
+            NDArray recved = NDArray(recv_blob, 0);
+            DataHandlePush(req_meta, key, recved, server);
+          });
+        offset += len;
+      }
+    } else {
+      auto response = std::make_shared<ps::KVPairs<real_t>>();
+      response->keys = req_data.keys;
+      std::vector<int> lens(num_keys);
+      size_t total = 0;
+      for (size_t i = 0; i < num_keys; ++i) {
+        int key = DecodeKey(req_data.keys[i]);
+        auto& stored = GetStored(key);
+        CHECK(!stored.is_none()) << "init " << key << " first";
+        lens[i] = stored.shape().Size();
+        total += lens[i];
+      }
+      response->lens.CopyFrom(lens.begin(), lens.end());
+      response->vals.resize(total);
+      // the last key copied sends the response
+      auto remaining = std::make_shared<std::atomic<size_t>>(num_keys);
+      size_t offset = 0;
+      for (size_t i = 0; i < num_keys; ++i) {
+        int key = DecodeKey(req_data.keys[i]);
+        size_t len = lens[i];
+        key_exec_->Push(key, priority,
+                        [this, req_meta, server, response, remaining, key, offset, len]() {
+            const auto& stored = GetStored(key);
+            std::memcpy(response->vals.data() + offset, stored.data().dptr_,
+                        len * sizeof(real_t));
+            if (--(*remaining) == 0) server->Response(req_meta, *response);
+          });
+        offset += len;
+      }
+    }
+  }
+
+  void DataHandleCompressed(const ps::KVMeta& req_meta,
+                            const ps::KVPairs<real_t> &req_data,
+                            ps::KVServer<real_t>* server) {
+    CHECK(req_meta.push) << "compressed pull is not supported";
+    CHECK(gradient_compression_.enabled())
+      << "received a compressed push while gradient compression is not set";
+    CHECK_EQ(req_data.keys.size(), (size_t)1);
+    CHECK_EQ(req_data.lens.size(), (size_t)1);
+    CHECK_EQ(req_data.vals.size(), (size_t)req_data.lens[0]);
+
+    int key = DecodeKey(req_data.keys[0]);
+    auto& stored = GetStored(key);
+    CHECK(!stored.is_none()) << "init " << key << " first";
+    size_t size = stored.shape().Size();
+    CHECK_EQ(req_data.vals.size(), gradient_compression_.GetCompressedSize(size));
+    // the previous push of this key may still be reading the buffer
+    auto& decomp_buf = GetDecompBuf(key);
+    if (decomp_buf.is_none()) {
+      decomp_buf = NDArray(stored.shape(), Context());
+    }
+    decomp_buf.WaitToWrite();
+    gradient_compression_.Dequantize(req_data.vals.data(),
+                                     decomp_buf.data().dptr<real_t>(), size);
+    DataHandlePush(req_meta, key, decomp_buf, server);
+  }
+
+  /**
+   * \brief push and pull of float16 or bfloat16 values, two per real_t. The
+   *  values are stored and merged as float32, the size is given by the
+   *  initialization.
+   */
+  template<typename DType>
+  void DataHandle16Bit(const ps::KVMeta& req_meta,
+                       const ps::KVPairs<real_t> &req_data,
+                       ps::KVServer<real_t>* server) {
+    CHECK_EQ(req_data.keys.size(), (size_t)1);
+    int key = DecodeKey(req_data.keys[0]);
+    auto& stored = GetStored(key);
+    CHECK(!stored.is_none()) << "init " << key << " first";
+    size_t size = stored.shape().Size();
+    size_t fp16_len = (size + 1) / 2;
+    if (req_meta.push) {
+      CHECK_EQ(req_data.lens.size(), (size_t)1);
+      CHECK_EQ(req_data.vals.size(), fp16_len);
+      // the previous push of this key may still be reading the buffer
+      auto& decomp_buf = GetDecompBuf(key);
+      if (decomp_buf.is_none()) {
+        decomp_buf = NDArray(stored.shape(), Context());
+      }
+      decomp_buf.WaitToWrite();
+      const DType* src = reinterpret_cast<const DType*>(req_data.vals.data());
+      real_t* dst = decomp_buf.data().dptr<real_t>();
+      for (size_t i = 0; i < size; ++i) {
+        dst[i] = static_cast<real_t>(src[i]);
+      }
+      DataHandlePush(req_meta, key, decomp_buf, server);
+    } else {
+      ps::KVPairs<real_t> response;
+      response.keys = req_data.keys;
+      response.lens = {static_cast<int>(fp16_len)};
+      response.vals.resize(fp16_len, 0);
+      const real_t* src = static_cast<const real_t*>(stored.data().dptr_);
+      DType* dst = reinterpret_cast<DType*>(response.vals.data());
+      for (size_t i = 0; i < size; ++i) {
+        dst[i] = DType(src[i]);
+      }
+      server->Response(req_meta, response);
+    }
+  }
+
+  /**
+   * \brief push without values of a worker whose values are in the push of
+   *  the leader of its host
+   */
+  void DataHandleLocalReduced(const ps::KVMeta& req_meta,
+                              const ps::KVPairs<real_t> &req_data,
+                              ps::KVServer<real_t>* server) {
+    CHECK(req_meta.push);
+    CHECK_EQ(req_data.keys.size(), (size_t)1);
+    CHECK_EQ(req_data.vals.size(), (size_t)0);
+    int key = DecodeKey(req_data.keys[0]);
+    auto& stored = GetStored(key);
+    CHECK(!stored.is_none()) << "init " << key << " first";
+    if (sync_mode_) {
+      auto& merged = GetMergeBuf(key);
+      if (merged.array.is_none()) {
+        merged.array = NDArray(stored.shape(), Context());
+      }
+      if (merged.request.size() == 0) {
+        // the values of the round are added to it
+        merged.array = 0;
+      }
+      merged.request.push_back(req_meta);
+      ApplyUpdates(key, &merged, &stored, server);
+    } else {
+      RespondAsyncPush(req_meta, key, server);
+    }
+  }
+
+  /**
+   * \brief the entries of a key in the maps below, which stay valid when other
+   *  keys are added. threadsafe
+   */
+  NDArray& GetStored(int key) {
+    std::lock_guard<std::mutex> lk(map_mu_);
+    return store_[key];
+  }
+  MergeBuf& GetMergeBuf(int key) {
+    std::lock_guard<std::mutex> lk(map_mu_);
+    return merge_buf_[key];
+  }
+  NDArray& GetDecompBuf(int key) {
+    std::lock_guard<std::mutex> lk(map_mu_);
+    return decomp_buf_[key];
+  }
+  /**
+   * \brief pushes of a key counted by worker in the ssp mode
+   */
+  struct SSPClock {
+    std::vector<int> clock;
+    /** \brief pushes of workers too far ahead, not answered yet */
+    std::list<ps::KVMeta> waiting;
+  };
+  SSPClock& GetSSPClock(int key) {
+    std::lock_guard<std::mutex> lk(map_mu_);
+    return ssp_clock_[key];
+  }
+  /**
+   * \brief pushes of a key counted by worker and rounds of the key applied,
+   *  with backup workers
+   */
+  struct BackupClock {
+    std::vector<int> clock;
+    int rounds = 0;
+  };
+  BackupClock& GetBackupClock(int key) {
+    std::lock_guard<std::mutex> lk(map_mu_);
+    return backup_clock_[key];
+  }
+
   int DecodeKey(ps::Key key) {
     auto kr = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()];
     return key - kr.begin();
@@ -428,18 +966,58 @@ class KVStoreDistServer {
   /**
    * \brief user defined
    */
-  bool sync_mode_;
+  std::atomic<bool> sync_mode_;
+  /**
+   * \brief number of the slowest pushes of every round of a key the sync
+   *  mode does not wait for
+   */
+  std::atomic<int> backup_workers_;
+  /**
+   * \brief maximal number of pushes a worker can be ahead in the ssp mode,
+   *  negative if not in the ssp mode
+   */
+  std::atomic<int> staleness_;
   KVStore::Controller controller_;
   KVStore::Updater updater_;
 
   std::unordered_map<int, NDArray> store_;
   std::unordered_map<int, MergeBuf> merge_buf_;
+  /**
+   * \brief decompressed values of the compressed and 16 bit pushes
+   */
+  std::unordered_map<int, NDArray> decomp_buf_;
+  /**
+   * \brief number of keys not done yet of the fused pushes, by sender and
+   *  timestamp
+   */
+  std::map<std::pair<int, int>, size_t> fused_pending_;
+  std::mutex fused_mu_;
+  std::unordered_map<int, SSPClock> ssp_clock_;
+  std::unordered_map<int, BackupClock> backup_clock_;
+  /**
+   * \brief protects the lookups in store_, merge_buf_, decomp_buf_, ssp_clock_
+   *  and backup_clock_
+   */
+  std::mutex map_mu_;
+  /**
+   * \brief the next part to hand out of every data and epoch
+   */
+  std::map<std::pair<std::string, int>, int> next_part_;
+  std::mutex parts_mu_;
+  /**
+   * \brief queues the requests by priority and handles the ones of distinct
+   *  keys in parallel
+   */
+  std::unique_ptr<KeyedExecutor> key_exec_;
+  GradientCompression gradient_compression_;
 
   Executor exec_;
   ps::KVServer<float>* ps_server_;
 
   // whether to LOG verbose information
   bool log_verbose_;
+  // whether to answer the default pulls of the sync mode without copying the stored values
+  bool zero_copy_pull_;
 };
 
 }  // namespace kvstore
@@ -33,6 +33,7 @@
 #include <functional>
 #include <algorithm>
 #include "./comm.h"
+#include "./comm_nccl.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -50,9 +51,16 @@ class KVStoreLocal : public KVStore {
  public:
   /*
    * \param use_device_comm
+   * \param use_nccl sum and broadcast over the gpus with NCCL
    */
-  explicit KVStoreLocal(bool use_device_comm) : KVStore() {
-    if (use_device_comm) {
+  explicit KVStoreLocal(bool use_device_comm, bool use_nccl = false) : KVStore() {
+    if (use_nccl) {
+#if MXNET_USE_NCCL
+      comm_ = new CommNCCL();
+#else
+      LOG(FATAL) << "compile with USE_NCCL=1 to use the nccl kvstore";
+#endif  // MXNET_USE_NCCL
+    } else if (use_device_comm) {
       comm_ = new CommDevice();
     } else {
       comm_ = new CommCPU();
@@ -67,7 +75,7 @@ class KVStoreLocal : public KVStore {
   void Init(const std::vector<int>& keys,
             const std::vector<NDArray>& values) override {
     SetKeyType(kIntKey);
-    Init_(keys, values);
+    InitImpl(keys, values);
   }
 
   void Init(const std::vector<std::string>& str_keys,
@@ -84,28 +92,28 @@ class KVStoreLocal : public KVStore {
       reverse_str_key_dict_[key] = str_key;
       keys[i] = key;
     }
-    Init_(keys, values);
+    InitImpl(keys, values);
   }
 
   void Push(const std::vector<int>& keys,
             const std::vector<NDArray>& values,
             int priority) override {
     SetKeyType(kIntKey);
-    Push_(keys, values, priority);
+    PushImpl(keys, values, priority);
   }
 
   void Pull(const std::vector<int>& keys,
             const std::vector<NDArray*>& values,
             int priority) override {
     SetKeyType(kIntKey);
-    Pull_(keys, values, priority);
+    PullImpl(keys, values, priority);
   }
 
   void PullRowSparse(const std::vector<int>& keys,
                      const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
                      int priority = 0) override {
     SetKeyType(kIntKey);
-    PullRowSparse_(keys, val_rowids, priority);
+    PullRowSparseImpl(keys, val_rowids, priority);
   }
 
   void Push(const std::vector<std::string>& str_keys,
@@ -114,7 +122,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
-    Push_(keys, values, priority);
+    PushImpl(keys, values, priority);
   }
 
   void Pull(const std::vector<std::string>& str_keys,
@@ -123,7 +131,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
-    Pull_(keys, values, priority);
+    PullImpl(keys, values, priority);
   }
 
   void PullRowSparse(const std::vector<std::string>& str_keys,
@@ -132,12 +140,15 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
-    PullRowSparse_(keys, val_rowids, priority);
+    PullRowSparseImpl(keys, val_rowids, priority);
   }
 
- private:
-  void Init_(const std::vector<int>& keys,
-             const std::vector<NDArray>& values) {
+ protected:
+  /**
+   * \brief initialize keys, shared by the int and string key interfaces
+   */
+  virtual void InitImpl(const std::vector<int>& keys,
+                        const std::vector<NDArray>& values) {
     for (size_t i = 0; i < keys.size(); ++i) {
       CHECK(local_.find(keys[i]) == local_.end())
           << "duplicate init of key " << keys[i];
@@ -146,63 +157,80 @@ class KVStoreLocal : public KVStore {
     }
   }
 
-  void Push_(const std::vector<int>& keys,
-             const std::vector<NDArray>& values,
-             int priority) {
+  /**
+   * \brief push keys, shared by the int and string key interfaces
+   */
+  virtual void PushImpl(const std::vector<int>& keys,
+                        const std::vector<NDArray>& values,
+                        int priority) {
     std::vector<int> uniq_keys;
     std::vector<std::vector<NDArray> > grouped_vals;
     GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals);
+    std::vector<NDArray> merged;
+    comm_->BatchReduce(uniq_keys, grouped_vals, priority, &merged);
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
-      int key = uniq_keys[i];
-      const NDArray& merged = comm_->Reduce(key, grouped_vals[i], priority);
-      NDArray& local = local_[key];
-      if (updater_ != nullptr) {
-        CHECK(!local.is_none()) << "key " << key << " has not been inited";
-        // if merged is on gpu, we may need copy weight from cpu to gpu
-        if (merged.ctx().dev_mask() != cpu::kDevMask &&
-            local.ctx().dev_mask() == cpu::kDevMask) {
-          local = local.Copy(merged.ctx());
-        }
-        // call the updater with string keys
-        // if string keys are used and str_updater_ is available
-        // otherwise fallback to updater_ which uses int key interface
-        if (key_type_ == kStringKey && str_updater_ != nullptr) {
-          // TODO(haibin) CHECK(str_updater_ != nullptr) if use_str_key
-          // after all language bindings picks up string interface changes
-          const std::string &str_key = reverse_str_key_dict_[key];
-          // TODO(haibin) avoid reverse key lookup if use_str_key
-          str_updater_(str_key, merged,  &local);
-        } else {
-          updater_(key, merged,  &local);
-        }
+      UpdateLocal(uniq_keys[i], merged[i]);
+    }
+  }
+
+  /**
+   * \brief update the stored value of key with merged, by the updater if set
+   */
+  void UpdateLocal(int key, const NDArray& merged) {
+    NDArray& local = local_[key];
+    if (updater_ != nullptr) {
+      CHECK(!local.is_none()) << "key " << key << " has not been inited";
+      // if merged is on gpu, we may need copy weight from cpu to gpu
+      if (merged.ctx().dev_mask() != cpu::kDevMask &&
+          local.ctx().dev_mask() == cpu::kDevMask) {
+        local = local.Copy(merged.ctx());
+      }
+      // call the updater with string keys
+      // if string keys are used and str_updater_ is available
+      // otherwise fallback to updater_ which uses int key interface
+      if (key_type_ == kStringKey && str_updater_ != nullptr) {
+        // TODO(haibin) CHECK(str_updater_ != nullptr) if use_str_key
+        // after all language bindings picks up string interface changes
+        const std::string &str_key = reverse_str_key_dict_[key];
+        // TODO(haibin) avoid reverse key lookup if use_str_key
+        str_updater_(str_key, merged,  &local);
       } else {
-        if (merged.storage_type() != local.storage_type()) {
-          local = merged.Copy(local.ctx());
-        } else {
-          local = merged;
-        }
+        updater_(key, merged,  &local);
+      }
+    } else {
+      if (merged.storage_type() != local.storage_type()) {
+        local = merged.Copy(local.ctx());
+      } else {
+        local = merged;
       }
     }
   }
 
-  void Pull_(const std::vector<int>& keys,
-             const std::vector<NDArray*>& values,
-             int priority) {
+  /**
+   * \brief pull keys, shared by the int and string key interfaces
+   */
+  virtual void PullImpl(const std::vector<int>& keys,
+                        const std::vector<NDArray*>& values,
+                        int priority) {
     std::vector<int> uniq_keys;
     std::vector<std::vector<NDArray*> > grouped_vals;
     GroupKVPairsPull(keys, values, &uniq_keys, &grouped_vals);
 
+    std::vector<NDArray> locals(uniq_keys.size());
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
-      const NDArray& local = local_[key];
-      CHECK(!local.is_none()) << "key " << key << " has not been inited";
-      comm_->Broadcast(key, local, grouped_vals[i], priority);
+      locals[i] = local_[key];
+      CHECK(!locals[i].is_none()) << "key " << key << " has not been inited";
     }
+    comm_->BatchBroadcast(uniq_keys, locals, grouped_vals, priority);
   }
 
-  void PullRowSparse_(const std::vector<int>& keys,
-                      const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                      int priority = 0) {
+  /**
+   * \brief pull row sparse keys, shared by the int and string key interfaces
+   */
+  virtual void PullRowSparseImpl(const std::vector<int>& keys,
+                                 const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
+                                 int priority = 0) {
     std::vector<int> uniq_keys;
     std::vector<std::vector<std::pair<NDArray*, NDArray>>> grouped_val_rowids;
     GroupKVPairsPullRsp(keys, val_rowids, &uniq_keys, &grouped_val_rowids);
@@ -224,7 +252,6 @@ class KVStoreLocal : public KVStore {
     }
   }
 
- protected:
   /**
    * \brief set the key type of the kvstore if haven't already.
    * If the key type is already defined, check if it matches the provided key type
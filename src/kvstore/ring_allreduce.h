@@ -0,0 +1,284 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file ring_allreduce.h
+ * \brief Ring allreduce over TCP connections between the workers
+ */
+#ifndef MXNET_KVSTORE_RING_ALLREDUCE_H_
+#define MXNET_KVSTORE_RING_ALLREDUCE_H_
+#include <dmlc/logging.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mxnet/base.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief Sums arrays over all the workers with the bandwidth optimal ring
+ *  algorithm: a reduce-scatter followed by an allgather, where every worker
+ *  sends and receives 2 * (n - 1) / n times the size of the array.
+ *
+ *  Every worker sends to the next one in the ring and receives from the
+ *  previous one. The reductions run on a background thread in the order of
+ *  their sequence numbers, which all workers must assign in the same order,
+ *  whatever the order their arrays become ready in.
+ */
+class RingAllreduce {
+ public:
+  /*!
+   * \brief constructor, takes the ownership of the connections
+   * \param rank rank of this worker
+   * \param size number of workers
+   * \param left_fd connection from the previous worker
+   * \param right_fd connection to the next worker
+   */
+  RingAllreduce(int rank, int size, int left_fd, int right_fd)
+      : rank_(rank), size_(size), left_fd_(left_fd), right_fd_(right_fd) {
+    for (int fd : {left_fd_, right_fd_}) {
+      CHECK_EQ(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK), 0);
+    }
+    thread_ = std::thread([this]() { Run(); });
+  }
+  ~RingAllreduce() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      exit_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+    close(left_fd_);
+    close(right_fd_);
+  }
+  /*!
+   * \brief sum data over the workers in place, then call on_complete
+   * \param seq sequence number, starting from 0 without gaps
+   */
+  void AllreduceAsync(uint64_t seq, real_t* data, size_t size,
+                      const std::function<void()>& on_complete) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      CHECK(pending_.find(seq) == pending_.end()) << "duplicate sequence number " << seq;
+      pending_[seq] = Task{data, size, on_complete};
+    }
+    cond_.notify_one();
+  }
+  /*!
+   * \brief listen on a port chosen by the system
+   * \param port the port
+   * \return the listening socket
+   */
+  static int Listen(int* port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_GE(fd, 0) << "socket failed: " << strerror(errno);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = 0;
+    CHECK_EQ(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0)
+      << "bind failed: " << strerror(errno);
+    CHECK_EQ(listen(fd, 16), 0) << "listen failed: " << strerror(errno);
+    socklen_t len = sizeof(addr);
+    CHECK_EQ(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+    *port = ntohs(addr.sin_port);
+    return fd;
+  }
+  /*!
+   * \brief accept a connection
+   */
+  static int Accept(int listen_fd) {
+    int fd;
+    do {
+      fd = accept(listen_fd, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    CHECK_GE(fd, 0) << "accept failed: " << strerror(errno);
+    SetNoDelay(fd);
+    return fd;
+  }
+  /*!
+   * \brief connect to host:port
+   */
+  static int Connect(const std::string& host, int port) {
+    addrinfo* res = Resolve(host, port, SOCK_STREAM);
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    CHECK_GE(fd, 0) << "socket failed: " << strerror(errno);
+    int ret;
+    do {
+      ret = connect(fd, res->ai_addr, res->ai_addrlen);
+    } while (ret != 0 && errno == EINTR);
+    CHECK_EQ(ret, 0) << "connect to " << host << ":" << port << " failed: " << strerror(errno);
+    freeaddrinfo(res);
+    SetNoDelay(fd);
+    return fd;
+  }
+  /*!
+   * \brief the address of the interface used to reach host:port
+   */
+  static std::string LocalAddress(const std::string& host, int port) {
+    addrinfo* res = Resolve(host, port, SOCK_DGRAM);
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    CHECK_GE(fd, 0) << "socket failed: " << strerror(errno);
+    // connecting an udp socket sends nothing, it only picks the interface
+    CHECK_EQ(connect(fd, res->ai_addr, res->ai_addrlen), 0)
+      << "cannot route to " << host << ": " << strerror(errno);
+    freeaddrinfo(res);
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    CHECK_EQ(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+    close(fd);
+    char buf[INET_ADDRSTRLEN];
+    CHECK(inet_ntop(AF_INET, &addr.sin_addr, buf, sizeof(buf)) != nullptr);
+    return buf;
+  }
+
+ private:
+  struct Task {
+    real_t* data;
+    size_t size;
+    std::function<void()> on_complete;
+  };
+  static addrinfo* Resolve(const std::string& host, int port, int socktype) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = socktype;
+    addrinfo* res = nullptr;
+    int ret = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+    CHECK_EQ(ret, 0) << "cannot resolve " << host << ": " << gai_strerror(ret);
+    return res;
+  }
+  static void SetNoDelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  /*! \brief body of the background thread */
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      cond_.wait(lock, [this]() {
+          return exit_ || pending_.find(next_seq_) != pending_.end();
+        });
+      if (exit_) break;
+      auto it = pending_.find(next_seq_);
+      Task task = std::move(it->second);
+      pending_.erase(it);
+      ++next_seq_;
+      lock.unlock();
+      Allreduce(task.data, task.size);
+      task.on_complete();
+      lock.lock();
+    }
+  }
+  /*! \brief begin of the c-th of the size_ chunks of an array */
+  size_t ChunkBegin(size_t size, int c) const {
+    return size * c / size_;
+  }
+  void Allreduce(real_t* data, size_t size) {
+    auto chunk = [this](int c) { return ((c % size_) + size_) % size_; };
+    recv_buf_.resize(size / size_ + 1);
+    // reduce-scatter: after it, this worker has the sum of chunk rank_ + 1
+    for (int s = 0; s < size_ - 1; ++s) {
+      int send_c = chunk(rank_ - s), recv_c = chunk(rank_ - s - 1);
+      size_t send_begin = ChunkBegin(size, send_c), recv_begin = ChunkBegin(size, recv_c);
+      size_t recv_len = ChunkBegin(size, recv_c + 1) - recv_begin;
+      SendRecv(data + send_begin, ChunkBegin(size, send_c + 1) - send_begin,
+               recv_buf_.data(), recv_len);
+      real_t* dst = data + recv_begin;
+      for (size_t i = 0; i < recv_len; ++i) dst[i] += recv_buf_[i];
+    }
+    // allgather of the summed chunks
+    for (int s = 0; s < size_ - 1; ++s) {
+      int send_c = chunk(rank_ + 1 - s), recv_c = chunk(rank_ - s);
+      size_t send_begin = ChunkBegin(size, send_c), recv_begin = ChunkBegin(size, recv_c);
+      SendRecv(data + send_begin, ChunkBegin(size, send_c + 1) - send_begin,
+               data + recv_begin, ChunkBegin(size, recv_c + 1) - recv_begin);
+    }
+  }
+  /*! \brief send to the next worker while receiving from the previous one */
+  void SendRecv(const real_t* send_data, size_t send_len, real_t* recv_data, size_t recv_len) {
+    const char* send_ptr = reinterpret_cast<const char*>(send_data);
+    char* recv_ptr = reinterpret_cast<char*>(recv_data);
+    size_t send_left = send_len * sizeof(real_t), recv_left = recv_len * sizeof(real_t);
+    while (send_left != 0 || recv_left != 0) {
+      pollfd fds[2];
+      int nfds = 0;
+      if (send_left != 0) fds[nfds++] = {right_fd_, POLLOUT, 0};
+      if (recv_left != 0) fds[nfds++] = {left_fd_, POLLIN, 0};
+      int ret = poll(fds, nfds, -1);
+      if (ret < 0 && errno == EINTR) continue;
+      CHECK_GT(ret, 0) << "poll failed: " << strerror(errno);
+      if (send_left != 0) {
+        ssize_t n = ::send(right_fd_, send_ptr, send_left, MSG_NOSIGNAL);
+        if (n > 0) {
+          send_ptr += n;
+          send_left -= n;
+        } else {
+          CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            << "send to worker " << (rank_ + 1) % size_ << " failed: " << strerror(errno);
+        }
+      }
+      if (recv_left != 0) {
+        ssize_t n = ::recv(left_fd_, recv_ptr, recv_left, 0);
+        CHECK_NE(n, 0) << "worker " << (rank_ + size_ - 1) % size_ << " closed the connection";
+        if (n > 0) {
+          recv_ptr += n;
+          recv_left -= n;
+        } else {
+          CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            << "recv from worker " << (rank_ + size_ - 1) % size_ << " failed: "
+            << strerror(errno);
+        }
+      }
+    }
+  }
+  int rank_;
+  int size_;
+  int left_fd_;
+  int right_fd_;
+  // buffer of the received chunks, only used by the background thread
+  std::vector<real_t> recv_buf_;
+  // protects the fields below
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::map<uint64_t, Task> pending_;
+  uint64_t next_seq_{0};
+  bool exit_{false};
+  std::thread thread_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_RING_ALLREDUCE_H_
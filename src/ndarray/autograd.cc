@@ -25,7 +25,12 @@
 #include <mxnet/operator.h>
 #include <mxnet/executor.h>
 #include <nnvm/pass_functions.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
 #include <unordered_set>
+#include <utility>
 #include <iostream>
 #include "../executor/graph_executor.h"
 #include "./autograd.h"
@@ -74,7 +79,10 @@ bool AGNodeEntry::is_none() const {
   return ag_node == nullptr || ag_node->outputs.empty();
 }
 
-AutogradRuntime::AutogradRuntime() {}
+AutogradRuntime::AutogradRuntime() {
+  engine_ref_ = Engine::_GetSharedRef();
+  storage_ref_ = Storage::_GetSharedRef();
+}
 
 void AutogradRuntime::MarkVariables(
     const std::vector<NDArray*>& variables,
@@ -243,7 +251,8 @@ void AutogradRuntime::RecordOp(nnvm::NodeAttrs&& attrs,
 
 void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
                                       const std::vector<NDArray>& ograds,
-                                      bool retain_graph, bool is_train) {
+                                      bool retain_graph, bool is_train,
+                                      bool create_graph) {
   static auto& fmutate_inputs = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
   std::vector<AGNodeEntry> heads;
   Symbol sym;
@@ -258,6 +267,15 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
     sym.outputs.emplace_back(i.entry_.nn_entry());
   }
 
+  // the backward executor is kept for the structure of the graph: the
+  // operators with their attributes and inputs, and the shapes, types,
+  // storage types and contexts of the node outputs
+  static const int cache_size = dmlc::GetEnv("MXNET_AUTOGRAD_BACKWARD_CACHE_SIZE", 4);
+  const bool use_cache = cache_size > 0 && !create_graph;
+  std::ostringstream key;
+  std::unordered_map<const AGNode*, uint32_t> visit_index;
+  std::vector<AGNodePtr> visited;
+
   std::unordered_set<AGNode*> mutable_set;
   std::vector<AGNodePtr> vlist;
   std::vector<NDArray> args, args_grad;
@@ -271,8 +289,11 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
           << "forgot to set retain_graph=True the first time. If you are training "
           << "recurrent model (like LSTMs) maybe you forgot to detach the hidden "
           << "state from the previous iteration before feeding it to the next iteration.";
+      visit_index[n.get()] = visited.size();
+      visited.push_back(n);
       if (n->nn_node->is_variable()) {
         vlist.push_back(n);
+        if (use_cache) key << "var" << n->grad_req;
       } else {
         if (n->state) {
           saved_states.insert({n->nn_node.get(), n->state});
@@ -282,11 +303,36 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
             mutable_set.insert(n->inputs[i].ag_node.get());
           }
         }
+        if (use_cache) {
+          std::vector<std::pair<std::string, std::string> > attrs(
+              n->nn_node->attrs.dict.begin(), n->nn_node->attrs.dict.end());
+          std::sort(attrs.begin(), attrs.end());
+          key << n->nn_node->op()->name << '{';
+          for (const auto& kv : attrs) {
+            key << kv.first.size() << kv.first << kv.second.size() << kv.second;
+          }
+          key << "}(";
+          for (const auto& e : n->inputs) {
+            key << visit_index.at(e.ag_node.get()) << ':' << e.index << ':' << e.version << ',';
+          }
+          key << ')' << static_cast<bool>(n->state);
+        }
       }
       for (uint32_t i = 0; i < n->outputs.size(); ++i) {
         feed_dict.insert({NodeEntry{n->nn_node, i, 0}, n->outputs[i]});
+        if (use_cache) {
+          const NDArray& out = n->outputs[i];
+          key << '[' << out.shape() << out.dtype() << ',' << out.storage_type() << ','
+              << out.ctx().dev_type << ',' << out.ctx().dev_id << ']';
+        }
       }
+      if (use_cache) key << ';';
     });
+  if (use_cache) {
+    for (const auto& i : heads) {
+      key << visit_index.at(i.ag_node.get()) << ':' << i.index << ',';
+    }
+  }
 
   bool has_writeto = false;
   for (const auto& n : vlist) {
@@ -295,6 +341,12 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
     } else {
       if (n->grad_req != kNullOp) {
         n->fresh_out_grad = true;
+        // the gradient is overwritten, drop the graph recorded for it before
+        const AGNodeEntry& e = n->out_grads[0].entry_;
+        if (e.ag_node != nullptr &&
+            (e.ag_node->nn_node == nullptr || !e.ag_node->nn_node->is_variable())) {
+          n->out_grads[0].entry_.clear();
+        }
       }
       args.push_back(n->outputs[0]);
       args_grad.push_back(n->out_grads[0]);
@@ -303,14 +355,71 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
     }
   }
 
+  // a recorded array sharing memory with a gradient, like a gradient recorded
+  // with create_graph, is copied so that it is read before being overwritten
+  std::unordered_set<engine::VarHandle> grad_vars;
+  for (size_t i = 0; i < args_grad.size(); ++i) {
+    if (grad_reqs[i] != kNullOp) grad_vars.insert(args_grad[i].var());
+  }
+  auto unalias = [&grad_vars](NDArray* arr) {
+    if (grad_vars.count(arr->var()) == 0) return;
+    NDArray copy = arr->storage_type() == kDefaultStorage ?
+        NDArray(arr->shape(), arr->ctx(), true, arr->dtype()) :
+        NDArray(arr->storage_type(), arr->shape(), arr->ctx(), true, arr->dtype());
+    CopyFromTo(*arr, &copy);
+    *arr = copy;
+  };
+  for (auto& kv : feed_dict) unalias(&kv.second);
+
   if (args.size()) {
-    std::map<std::string, Context> ctx_map;
-    auto exec = new exec::GraphExecutor();
-    // (TODO) too hack here
-    exec->saved_states_ = saved_states;
-    exec->Init(sym, args[0].ctx(), ctx_map,
-               args, args_grad, grad_reqs,
-               aux_states, nullptr, feed_dict);
+    BackwardCache cache;
+    if (use_cache) {
+      cache.key = key.str();
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      for (auto it = backward_cache_.begin(); it != backward_cache_.end(); ++it) {
+        if (it->key == cache.key) {
+          cache = std::move(*it);
+          backward_cache_.erase(it);
+          break;
+        }
+      }
+    }
+    if (cache.exec != nullptr) {
+      // same structure as a graph differentiated before, bind the new arrays
+      // to its executor and keep the memory plan and the allocated buffers
+      std::unordered_map<uint32_t, NDArray> feed_entries;
+      std::unordered_map<uint32_t, OpStatePtr> node_states;
+      size_t entry = 0;
+      for (size_t i = 0; i < visited.size(); ++i) {
+        const AGNodePtr& n = visited[i];
+        if (n->state) node_states.emplace(cache.node_ids[i], n->state);
+        for (NDArray out : n->outputs) {
+          unalias(&out);
+          feed_entries.emplace(cache.entry_ids[entry++], out);
+        }
+      }
+      cache.exec->Rebind(args, args_grad, grad_reqs, aux_states, feed_entries, node_states);
+    } else {
+      std::map<std::string, Context> ctx_map;
+      cache.exec = std::make_shared<GraphExecutor>();
+      // (TODO) too hack here
+      cache.exec->saved_states_ = saved_states;
+      cache.exec->keep_backward_outputs_ = create_graph;
+      cache.exec->Init(sym, args[0].ctx(), ctx_map,
+                       args, args_grad, grad_reqs,
+                       aux_states, nullptr, feed_dict);
+      if (use_cache) {
+        const auto& idx = cache.exec->graph_.indexed_graph();
+        for (const auto& n : visited) {
+          const uint32_t nid = idx.node_id(n->nn_node.get());
+          cache.node_ids.push_back(nid);
+          for (uint32_t i = 0; i < n->outputs.size(); ++i) {
+            cache.entry_ids.push_back(idx.entry_id(nid, i));
+          }
+        }
+      }
+    }
+    GraphExecutor* exec = cache.exec.get();
 
     std::vector<NDArray> head_grads;
     head_grads.reserve(exec->head_grad_array_.size());
@@ -331,15 +440,35 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
     // exec->Print(os);
     // LOG(INFO) << os.str();
 
+    // without retaining the graph the recorded arrays are only held by the
+    // executor from here on, which drops each of them once the last backward
+    // operator reading it has run instead of keeping them to the end
+    exec->release_forward_entries_ = !retain_graph && !create_graph;
+    if (exec->release_forward_entries_) {
+      feed_dict.clear();
+      for (auto& i : heads) {
+        i.ag_node->clear_history();
+      }
+    }
     exec->Backward(head_grads, is_train);
-    delete exec;
+    if (create_graph) {
+      RecordBackward(exec, visited, head_grads);
+    }
+    if (use_cache) {
+      exec->ReleaseArrays();
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      backward_cache_.push_front(std::move(cache));
+      if (backward_cache_.size() > static_cast<size_t>(cache_size)) {
+        backward_cache_.pop_back();
+      }
+    }
   }
 
-  if (!retain_graph) {
+  if (!retain_graph && !create_graph) {
     for (auto& i : heads) {
       i.ag_node->clear_history();
     }
-  } else if (has_writeto) {
+  } else if (retain_graph && has_writeto) {
     LOG(INFO)
         << "Warning: when calling backward with retain_graph=True, grad_req for "
         << "Parameters should be set to 'add'. Otherwise the second backward "
@@ -349,5 +478,48 @@ void AutogradRuntime::ComputeGradient(const std::vector<NDArray>& outputs,
   }
 }
 
+void AutogradRuntime::RecordBackward(GraphExecutor* exec,
+                                     const std::vector<AGNodePtr>& visited,
+                                     const std::vector<NDArray>& head_grads) {
+  const auto& idx = exec->graph_.indexed_graph();
+  // the arrays of the graph, forward outputs refer to their recorded nodes
+  std::vector<NDArray> buff(idx.num_node_entries());
+  for (const auto& n : visited) {
+    for (uint32_t i = 0; i < n->outputs.size(); ++i) {
+      NDArray& arr = buff[idx.entry_id(NodeEntry{n->nn_node, i, 0})];
+      arr = n->outputs[i];
+      arr.entry_ = AGNodeEntry{n, i, 0};
+    }
+  }
+  for (size_t i = exec->num_forward_inputs_; i < idx.input_nodes().size(); ++i) {
+    const uint32_t nid = idx.input_nodes().at(i);
+    buff[idx.entry_id(nid, 0)] = head_grads[exec->head_grad_map_.at(idx[nid].source)];
+  }
+  for (size_t nid = exec->num_forward_nodes_; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable() || exec->op_nodes_[nid].skip_exec_node) continue;
+    std::vector<NDArray> inputs, outputs;
+    for (const auto& e : inode.inputs) {
+      inputs.push_back(buff[idx.entry_id(e)]);
+    }
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      outputs.push_back(exec->data_entry_[idx.entry_id(nid, i)]);
+      outputs.back().entry_.clear();
+    }
+    RecordOp(nnvm::NodeAttrs(inode.source->attrs), &inputs, &outputs);
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      buff[idx.entry_id(nid, i)] = std::move(outputs[i]);
+    }
+  }
+  // x.grad now refers to the node computing it
+  size_t j = exec->num_forward_outputs_;
+  for (const auto& n : visited) {
+    if (!n->nn_node->is_variable() || n->grad_req == kNullOp) continue;
+    if (idx.mutable_input_nodes().count(idx.node_id(n->nn_node.get()))) continue;
+    CHECK_LT(j, idx.outputs().size());
+    n->out_grads[0].entry_ = buff[idx.entry_id(idx.outputs()[j++])].entry_;
+  }
+}
+
 }  // namespace autograd
 }  // namespace mxnet
@@ -26,7 +26,9 @@
 
 #include <dmlc/logging.h>
 #include <mxnet/base.h>
+#include <mxnet/engine.h>
 #include <mxnet/ndarray.h>
+#include <mxnet/storage.h>
 #include <mxnet/op_attr_types.h>
 #include <mxnet/c_api.h>
 #include <nnvm/symbolic.h>
@@ -34,9 +36,18 @@
 #include <nnvm/graph.h>
 #include <vector>
 #include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 namespace mxnet {
+// forward declaration
+namespace exec {
+class GraphExecutor;
+}
+
 namespace autograd {
 
 class AGNode {
@@ -108,10 +119,15 @@ class AutogradRuntime {
                 const OpStatePtr& state = OpStatePtr(),
                 std::vector<bool>* p_save_inputs = nullptr,
                 std::vector<bool>* p_save_outputs = nullptr);
-  /*! \brief compute the gradient of outputs w.r.t variables. */
+  /*!
+   * \brief compute the gradient of outputs w.r.t variables.
+   * \param create_graph whether to record the backward pass, so that the
+   *  gradients can be differentiated again. The graph is then retained.
+   */
   void ComputeGradient(const std::vector<NDArray>& outputs,
                        const std::vector<NDArray>& ograds,
-                       bool retain_graph, bool is_train);
+                       bool retain_graph, bool is_train,
+                       bool create_graph = false);
   /*! \return AutogradRuntime singleton */
   static AutogradRuntime* Get();
   /*! \brief Get shared pointer reference to AutogradRuntime singleton.
@@ -128,6 +144,24 @@ class AutogradRuntime {
   AutogradRuntime();
 
  private:
+  /*!
+   * \brief record the backward nodes run by exec as operators reading the
+   *  recorded forward outputs, and attach the results to the gradients.
+   */
+  void RecordBackward(exec::GraphExecutor* exec,
+                      const std::vector<AGNodePtr>& visited,
+                      const std::vector<NDArray>& head_grads);
+  /*! \brief backward executor kept for the structure of a recorded graph */
+  struct BackwardCache {
+    /*! \brief the structure of the graph, see ComputeGradient */
+    std::string key;
+    /*! \brief executor released after its last run */
+    std::shared_ptr<exec::GraphExecutor> exec;
+    /*! \brief node id in the executor of every node in visiting order */
+    std::vector<uint32_t> node_ids;
+    /*! \brief entry id in the executor of every node output in visiting order */
+    std::vector<uint32_t> entry_ids;
+  };
   /*! \brief AutogradRuntime singleton. */
   static AutogradRuntime* instance_;
   /*! \brief indicate whether is training. */
@@ -142,6 +176,13 @@ class AutogradRuntime {
   std::atomic<uint64_t> node_count_{0};
   /*! \brief variable count used for naming */
   std::atomic<uint64_t> variable_count_{0};
+  /*! \brief engine and storage outlive the arrays of the cached executors */
+  std::shared_ptr<Engine> engine_ref_;
+  std::shared_ptr<Storage> storage_ref_;
+  /*! \brief protects backward_cache_ */
+  std::mutex cache_mutex_;
+  /*! \brief backward executors, most recently used first */
+  std::list<BackwardCache> backward_cache_;
 };
 
 }  // namespace autograd
@@ -29,6 +29,17 @@
 #include <mxnet/ndarray.h>
 #include <mxnet/resource.h>
 #include <mshadow/tensor.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <utility>
 #include "./ndarray_function.h"
 #include "../common/utils.h"
 #include "../operator/tensor/matrix_op-inl.h"
@@ -38,6 +49,10 @@
 #if MXNET_USE_OPENCV
 #include <opencv2/opencv.hpp>
 #endif  // MXNET_USE_OPENCV
+#if MXNET_USE_CUDA
+#include <cuda.h>
+#include "../common/cuda_utils.h"
+#endif  // MXNET_USE_CUDA
 
 namespace dmlc {
 DMLC_REGISTRY_ENABLE(::mxnet::NDArrayFunctionReg);
@@ -377,6 +392,18 @@ size_t num_aux_data(NDArrayStorageType stype) {
   return num;
 }
 
+/*!
+ * \brief the number of non-zeros to reserve the storage of a sparse array on
+ *  the gpu for: nnz rounded up to a power of two, at most bound. The copies of
+ *  a varying number of non-zeros then reuse the storage of the destination,
+ *  instead of allocating on the device between the copies of the stream.
+ */
+inline size_t ReservedNonZeros(size_t nnz, size_t bound) {
+  size_t reserved = 1;
+  while (reserved < nnz) reserved <<= 1;
+  return std::max(std::min(reserved, bound), nnz);
+}
+
 // Make a copy of a CSR NDArray
 template<typename from_xpu, typename to_xpu>
 inline void CopyFromToCsrImpl(const NDArray from, NDArray *to, RunContext ctx) {
@@ -389,6 +416,12 @@ inline void CopyFromToCsrImpl(const NDArray from, NDArray *to, RunContext ctx) {
     return;
   }
   // Allocate storage
+  if (std::is_same<to_xpu, mshadow::gpu>::value) {
+    const TShape reserved = Shape1(ReservedNonZeros(from.aux_shape(csr::kIdx).Size(),
+                                                    to->shape().Size()));
+    to->CheckAndAllocAuxData(csr::kIdx, reserved);
+    to->CheckAndAllocData(reserved);
+  }
   to->CheckAndAllocAuxData(csr::kIndPtr, from.aux_shape(csr::kIndPtr));
   to->CheckAndAllocAuxData(csr::kIdx, from.aux_shape(csr::kIdx));
   to->CheckAndAllocData(from.aux_shape(csr::kIdx));
@@ -415,6 +448,9 @@ inline void CopyFromToRspImpl(const NDArray from, NDArray *to, RunContext ctx) {
     return;
   }
   auto aux_shape = from.aux_shape(rowsparse::kIdx);
+  if (std::is_same<to_xpu, mshadow::gpu>::value) {
+    to->CheckAndAlloc({Shape1(ReservedNonZeros(aux_shape.Size(), to->shape()[0]))});
+  }
   to->CheckAndAlloc({aux_shape});
   TBlob val = to->data();
   TBlob idx = to->aux_data(rowsparse::kIdx);
@@ -547,6 +583,112 @@ void CopyFromTo(const NDArray &from, NDArray *to, int priority) {
   }
 }
 
+/*!
+ * \brief copy dense arrays of the same type between two devices, merging the
+ *  copies of adjacent regions to adjacent regions
+ */
+template<typename from_xpu, typename to_xpu>
+void CopyFromToDnsBatchImpl(const std::vector<NDArray>& from, const std::vector<NDArray>& to,
+                            RunContext rctx) {
+  const Context from_ctx = from[0].ctx(), to_ctx = to[0].ctx();
+  size_t i = 0;
+  while (i < from.size()) {
+    char* src = static_cast<char*>(from[i].data().dptr_);
+    char* dst = static_cast<char*>(to[i].data().dptr_);
+    size_t size = from[i].shape().Size() * mshadow::mshadow_sizeof(from[i].dtype());
+    for (++i; i < from.size(); ++i) {
+      const size_t next = from[i].shape().Size() * mshadow::mshadow_sizeof(from[i].dtype());
+      if (from[i].data().dptr_ != src + size || to[i].data().dptr_ != dst + size) break;
+      size += next;
+    }
+    TBlob src_blob(src, mshadow::Shape1(size), from_xpu::kDevMask, mshadow::kUint8);
+    TBlob dst_blob(dst, mshadow::Shape1(size), to_xpu::kDevMask, mshadow::kUint8);
+    ndarray::Copy<from_xpu, to_xpu>(src_blob, &dst_blob, from_ctx, to_ctx, rctx);
+  }
+  if (std::is_same<from_xpu, mshadow::gpu>::value || std::is_same<to_xpu, mshadow::gpu>::value) {
+    // Wait GPU kernel to complete
+    rctx.get_stream<gpu>()->Wait();
+  }
+}
+
+void CopyFromTo(const std::vector<NDArray> &from, std::vector<NDArray> *to, int priority) {
+  CHECK_EQ(from.size(), to->size());
+  // the copies run out of order when a destination is read or written by
+  // another copy, they are then issued one by one
+  std::vector<Engine::VarHandle> read_vars, write_vars;
+  for (size_t i = 0; i < from.size(); ++i) {
+    read_vars.push_back(from[i].var());
+    write_vars.push_back((*to)[i].var());
+  }
+  std::sort(read_vars.begin(), read_vars.end());
+  std::sort(write_vars.begin(), write_vars.end());
+  bool independent = std::adjacent_find(write_vars.begin(), write_vars.end()) == write_vars.end();
+  for (size_t i = 0; independent && i < write_vars.size(); ++i) {
+    independent = !std::binary_search(read_vars.begin(), read_vars.end(), write_vars[i]);
+  }
+  // group the dense copies by pair of contexts, in order
+  std::map<std::pair<Context, Context>, std::vector<size_t> > groups;
+  for (size_t i = 0; i < from.size(); ++i) {
+    const NDArray& src = from[i];
+    const NDArray& dst = (*to)[i];
+    if (!independent || src.storage_type() != kDefaultStorage ||
+        dst.storage_type() != kDefaultStorage || src.dtype() != dst.dtype() ||
+        src.shape() != dst.shape() || src.shape().ndim() == 0) {
+      CopyFromTo(src, &(*to)[i], priority);
+    } else {
+      groups[std::make_pair(src.ctx(), dst.ctx())].push_back(i);
+    }
+  }
+  for (const auto& group : groups) {
+    if (group.second.size() == 1) {
+      CopyFromTo(from[group.second[0]], &(*to)[group.second[0]], priority);
+      continue;
+    }
+    // important: callback must always capture by value
+    std::vector<NDArray> srcs, dsts;
+    std::vector<Engine::VarHandle> const_vars, mutable_vars;
+    for (size_t i : group.second) {
+      srcs.push_back(from[i]);
+      dsts.push_back((*to)[i]);
+      const_vars.push_back(from[i].var());
+      mutable_vars.push_back((*to)[i].var());
+    }
+    Engine::Get()->DeduplicateVarHandle(&const_vars, &mutable_vars);
+    const Context from_ctx = group.first.first, to_ctx = group.first.second;
+    int a = from_ctx.dev_mask();
+    int b = to_ctx.dev_mask();
+    if (a == cpu::kDevMask && b == cpu::kDevMask) {
+      Engine::Get()->PushSync([srcs, dsts](RunContext ctx) {
+          CopyFromToDnsBatchImpl<cpu, cpu>(srcs, dsts, ctx);
+        }, from_ctx, const_vars, mutable_vars,
+        FnProperty::kNormal, priority, PROFILER_MESSAGE("CopyCPU2CPU"));
+    } else {
+#if MXNET_USE_CUDA
+      if (a == cpu::kDevMask && b == gpu::kDevMask) {
+        Engine::Get()->PushSync([srcs, dsts](RunContext ctx) {
+            CopyFromToDnsBatchImpl<cpu, gpu>(srcs, dsts, ctx);
+          }, to_ctx, const_vars, mutable_vars,
+          FnProperty::kCopyToGPU, priority, PROFILER_MESSAGE("CopyCPU2GPU"));
+      } else if (a == gpu::kDevMask && b == cpu::kDevMask) {
+        Engine::Get()->PushSync([srcs, dsts](RunContext ctx) {
+            CopyFromToDnsBatchImpl<gpu, cpu>(srcs, dsts, ctx);
+          }, from_ctx, const_vars, mutable_vars,
+          FnProperty::kCopyFromGPU, priority, PROFILER_MESSAGE("CopyGPU2CPU"));
+      } else if (a == gpu::kDevMask && b == gpu::kDevMask) {
+        Engine::Get()->PushSync([srcs, dsts](RunContext ctx) {
+            CopyFromToDnsBatchImpl<gpu, gpu>(srcs, dsts, ctx);
+          }, from_ctx, const_vars, mutable_vars,
+          FnProperty::kCopyFromGPU, priority, PROFILER_MESSAGE("CopyGPU2GPU"));
+      } else {
+        LOG(FATAL) << "unknown device mask";
+      }
+#else
+      LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+#endif
+    }
+  }
+}
+
 void ElementwiseSum(const std::vector<NDArray> &source, NDArray *out, int priority) {
   std::vector<Engine::VarHandle> const_vars;
   const_vars.reserve(source.size());
@@ -1037,6 +1179,324 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
 }
 
+/* magic number of the mappable format, written first in the file */
+const uint64_t kMXAPINDArrayMappedMagic = 0x113;
+/* version of the mappable format */
+const uint64_t kMXAPINDArrayMappedVersion = 1;
+/* alignment of the data region and of every array in the mappable format */
+const size_t kMappedPageAlign = 4096, kMappedArrayAlign = 64;
+
+inline size_t MappedAlign(size_t size, size_t align) {
+  return (size + align - 1) / align * align;
+}
+
+void NDArray::SaveMappable(dmlc::Stream* fo,
+                           const std::vector<NDArray>& data,
+                           const std::vector<std::string>& names) {
+  CHECK(names.size() == 0 || names.size() == data.size())
+      << "the number of names must match the number of arrays";
+  // the content of the arrays on cpu
+  std::vector<TBlob> blobs(data.size());
+  std::vector<NDArray> cpu_data(data.size());
+  size_t index_size = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    CHECK_EQ(data[i].storage_type(), kDefaultStorage)
+        << "The mappable format only supports dense arrays";
+    index_size += sizeof(uint64_t) + (names.size() ? names[i].size() : 0) +
+                  4 * sizeof(int32_t) + data[i].shape().ndim() * sizeof(int64_t) +
+                  2 * sizeof(uint64_t);
+    if (data[i].is_none()) continue;
+    if (data[i].ctx().dev_mask() != cpu::kDevMask) {
+      cpu_data[i] = data[i].Copy(Context::CPU());
+    } else {
+      cpu_data[i] = data[i];
+    }
+    cpu_data[i].WaitToRead();
+    blobs[i] = cpu_data[i].data();
+    CHECK(blobs[i].CheckContiguous());
+  }
+  const size_t data_offset = MappedAlign(5 * sizeof(uint64_t) + index_size, kMappedPageAlign);
+  uint64_t header[5] = {kMXAPINDArrayMappedMagic, kMXAPINDArrayMappedVersion,
+                        data.size(), names.size(), data_offset};
+  fo->Write(header, sizeof(header));
+  std::vector<uint64_t> offsets(data.size()), sizes(data.size());
+  size_t offset = data_offset;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i].is_none()) continue;
+    offsets[i] = offset;
+    sizes[i] = blobs[i].Size() * mshadow::mshadow_sizeof(blobs[i].type_flag_);
+    offset = MappedAlign(offset + sizes[i], kMappedArrayAlign);
+  }
+  // the index
+  for (size_t i = 0; i < data.size(); ++i) {
+    uint64_t name_size = names.size() ? names[i].size() : 0;
+    fo->Write(&name_size, sizeof(name_size));
+    if (name_size != 0) fo->Write(names[i].c_str(), name_size);
+    const TShape& shape = data[i].shape();
+    Context ctx = data[i].is_none() ? Context::CPU() : data[i].ctx();
+    int32_t attrs[4] = {data[i].is_none() ? mshadow::kFloat32 : blobs[i].type_flag_,
+                        static_cast<int32_t>(ctx.dev_type), ctx.dev_id,
+                        static_cast<int32_t>(shape.ndim())};
+    fo->Write(attrs, sizeof(attrs));
+    for (index_t j = 0; j < shape.ndim(); ++j) {
+      int64_t dim = shape[j];
+      fo->Write(&dim, sizeof(dim));
+    }
+    fo->Write(&offsets[i], sizeof(offsets[i]));
+    fo->Write(&sizes[i], sizeof(sizes[i]));
+  }
+  // the content, every array aligned
+  const std::string zeros(kMappedPageAlign, '\0');
+  size_t pos = 5 * sizeof(uint64_t) + index_size;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i].is_none()) continue;
+    fo->Write(zeros.data(), offsets[i] - pos);
+    fo->Write(blobs[i].dptr_, sizes[i]);
+    pos = offsets[i] + sizes[i];
+  }
+}
+
+namespace {
+/*!
+ * \brief map a local file copy-on-write, or read another file into memory
+ * \return the owner of the memory
+ */
+std::shared_ptr<void> MapFile(const std::string& fname, char** dptr, size_t* size) {
+#ifndef _WIN32
+  const bool local = fname.find("://") == std::string::npos ||
+                     fname.compare(0, 7, "file://") == 0;
+  if (local) {
+    const std::string path = fname.compare(0, 7, "file://") == 0 ? fname.substr(7) : fname;
+    int fd = open(path.c_str(), O_RDONLY);
+    CHECK_NE(fd, -1) << "Cannot open " << fname << ": " << strerror(errno);
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat " << fname;
+    *size = static_cast<size_t>(st.st_size);
+    void* ptr = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    CHECK(ptr != MAP_FAILED) << "Cannot map " << fname << ": " << strerror(errno);
+    close(fd);
+    *dptr = static_cast<char*>(ptr);
+    const size_t length = *size;
+    return std::shared_ptr<void>(ptr, [length](void* p) { munmap(p, length); });
+  }
+#endif  // _WIN32
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r"));
+  auto buffer = std::make_shared<std::string>();
+  char buf[1 << 16];
+  size_t nread;
+  while ((nread = fi->Read(buf, sizeof(buf))) != 0) buffer->append(buf, nread);
+  *dptr = &(*buffer)[0];
+  *size = buffer->size();
+  return buffer;
+}
+}  // namespace
+
+void NDArray::ExportCUDAIPC(std::string* ipc_handle, size_t* offset) const {
+#if MXNET_USE_CUDA
+  CHECK_EQ(storage_type(), kDefaultStorage) << "Only dense NDArrays can be shared";
+  CHECK_EQ(ctx().dev_mask(), gpu::kDevMask) << "Only GPU NDArrays have a CUDA IPC handle";
+  this->WaitToRead();
+  CUDA_CALL(cudaSetDevice(ctx().dev_id));
+  char* dptr = static_cast<char*>(ptr_->shandle.dptr) + byte_offset_;
+  // the pools carve blocks out of larger allocations, the handle is the one
+  // of the whole allocation
+  CUdeviceptr base;
+  size_t size;
+  CHECK_EQ(cuMemGetAddressRange(&base, &size, reinterpret_cast<CUdeviceptr>(dptr)),
+           CUDA_SUCCESS) << "Cannot find the allocation of the NDArray";
+  cudaIpcMemHandle_t handle;
+  CUDA_CALL(cudaIpcGetMemHandle(&handle, reinterpret_cast<void*>(base)));
+  ipc_handle->assign(reinterpret_cast<const char*>(&handle), sizeof(handle));
+  *offset = dptr - reinterpret_cast<char*>(base);
+#else
+  LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+#endif  // MXNET_USE_CUDA
+}
+
+NDArray NDArray::ImportCUDAIPC(const std::string& ipc_handle, size_t offset,
+                               const TShape& shape, int dtype, int dev_id) {
+#if MXNET_USE_CUDA
+  cudaIpcMemHandle_t handle;
+  CHECK_EQ(ipc_handle.size(), sizeof(handle)) << "Invalid CUDA IPC handle";
+  std::memcpy(&handle, ipc_handle.data(), sizeof(handle));
+  CUDA_CALL(cudaSetDevice(dev_id));
+  void* base = nullptr;
+  CUDA_CALL(cudaIpcOpenMemHandle(&base, handle, cudaIpcMemLazyEnablePeerAccess));
+  std::shared_ptr<void> holder(base, [dev_id](void* p) {
+      cudaSetDevice(dev_id);
+      cudaIpcCloseMemHandle(p);
+    });
+  TBlob data(static_cast<char*>(base) + offset, shape, gpu::kDevMask, dtype);
+  return NDArray(data, dev_id, holder);
+#else
+  LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+  return NDArray();
+#endif  // MXNET_USE_CUDA
+}
+
+namespace {
+/*! \brief the DLPack tensor of an NDArray, and the NDArray it keeps alive */
+struct NDArrayDLManager {
+  NDArray handle;
+  TShape shape;
+  DLManagedTensor tensor;
+};
+
+/*! \brief the mshadow type flag of a DLPack data type */
+int DLDataTypeToTypeFlag(const DLDataType& dtype) {
+  CHECK_EQ(dtype.lanes, 1U) << "Vector types are not supported by DLPack import";
+  switch (dtype.code) {
+    case kDLFloat:
+      if (dtype.bits == 16) return mshadow::kFloat16;
+      if (dtype.bits == 32) return mshadow::kFloat32;
+      if (dtype.bits == 64) return mshadow::kFloat64;
+      break;
+    case kDLUInt:
+      if (dtype.bits == 8) return mshadow::kUint8;
+      break;
+    case kDLInt:
+      if (dtype.bits == 8) return mshadow::kInt8;
+      if (dtype.bits == 32) return mshadow::kInt32;
+      if (dtype.bits == 64) return mshadow::kInt64;
+      break;
+  }
+  LOG(FATAL) << "Unsupported DLPack data type: code " << static_cast<int>(dtype.code)
+             << ", bits " << static_cast<int>(dtype.bits);
+  return -1;
+}
+}  // namespace
+
+DLManagedTensor* NDArray::ToDLPack() const {
+  CHECK_EQ(storage_type(), kDefaultStorage) << "Only dense NDArrays can be shared with DLPack";
+  CHECK(!is_none()) << "Cannot share an empty NDArray with DLPack";
+  NDArrayDLManager* manager = new NDArrayDLManager;
+  manager->handle = *this;
+  manager->shape = shape_;
+  // the DLTensor of a TBlob points to the shape of the TBlob, use the copy
+  // owned by the manager instead
+  manager->tensor.dl_tensor = data().dltensor();
+  manager->tensor.dl_tensor.shape = manager->shape.data();
+  manager->tensor.manager_ctx = manager;
+  manager->tensor.deleter = [](DLManagedTensor* tensor) {
+    delete static_cast<NDArrayDLManager*>(tensor->manager_ctx);
+  };
+  return &manager->tensor;
+}
+
+NDArray NDArray::FromDLPack(DLManagedTensor* tensor) {
+  const DLTensor& dl = tensor->dl_tensor;
+  CHECK(dl.ctx.device_type == kDLCPU || dl.ctx.device_type == kDLGPU)
+    << "Only CPU and GPU DLPack tensors can be imported";
+  TShape shape(dl.shape, dl.shape + dl.ndim);
+  if (dl.strides != nullptr) {
+    int64_t stride = 1;
+    for (int i = dl.ndim - 1; i >= 0; --i) {
+      CHECK(shape[i] == 1 || dl.strides[i] == stride)
+        << "Only compact DLPack tensors can be imported";
+      stride *= shape[i];
+    }
+  }
+  const int dev_mask = dl.ctx.device_type == kDLCPU ? cpu::kDevMask : gpu::kDevMask;
+  TBlob data(static_cast<char*>(dl.data) + dl.byte_offset, shape, dev_mask,
+             DLDataTypeToTypeFlag(dl.dtype), dl.ctx.device_id);
+  std::shared_ptr<void> holder(static_cast<void*>(tensor), [](void* p) {
+      DLManagedTensor* t = static_cast<DLManagedTensor*>(p);
+      if (t->deleter != nullptr) t->deleter(t);
+    });
+  return NDArray(data, dl.ctx.device_id, holder);
+}
+
+bool NDArray::LoadMapped(const std::string& fname,
+                         const std::vector<std::string>& select,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys) {
+  {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r"));
+    uint64_t magic = 0;
+    if (fi->Read(&magic, sizeof(magic)) != sizeof(magic) ||
+        magic != kMXAPINDArrayMappedMagic) {
+      return false;
+    }
+  }
+  char* base = nullptr;
+  size_t size = 0;
+  std::shared_ptr<void> holder = MapFile(fname, &base, &size);
+  CHECK_GE(size, 5 * sizeof(uint64_t)) << "Invalid NDArray file format";
+  const uint64_t* header = reinterpret_cast<const uint64_t*>(base);
+  CHECK_EQ(header[1], kMXAPINDArrayMappedVersion)
+      << "Unsupported version " << header[1] << " of the mappable NDArray format";
+  const size_t num_arrays = header[2], num_names = header[3];
+  CHECK(num_names == 0 || num_names == num_arrays) << "Invalid NDArray file format";
+  // parse the index
+  std::vector<NDArray> arrays(num_arrays);
+  std::vector<std::string> names(num_names);
+  const char* p = base + 5 * sizeof(uint64_t);
+  auto read = [&](void* dst, size_t n) {
+    CHECK_LE(p + n, base + size) << "Invalid NDArray file format";
+    std::memcpy(dst, p, n);
+    p += n;
+  };
+  std::vector<Context> ctxs(num_arrays, Context::CPU());
+  std::map<std::string, size_t> name_index;
+  for (size_t i = 0; i < num_arrays; ++i) {
+    uint64_t name_size;
+    read(&name_size, sizeof(name_size));
+    std::string name(name_size, '\0');
+    if (name_size != 0) read(&name[0], name_size);
+    if (num_names != 0) {
+      names[i] = name;
+      name_index[name] = i;
+    }
+    int32_t attrs[4];
+    read(attrs, sizeof(attrs));
+    TShape shape(attrs[3]);
+    for (index_t j = 0; j < shape.ndim(); ++j) {
+      int64_t dim;
+      read(&dim, sizeof(dim));
+      shape[j] = dim;
+    }
+    uint64_t offset, nbytes;
+    read(&offset, sizeof(offset));
+    read(&nbytes, sizeof(nbytes));
+    if (shape.ndim() == 0) continue;
+    CHECK_EQ(nbytes, shape.Size() * mshadow::mshadow_sizeof(attrs[0]))
+        << "Invalid NDArray file format";
+    CHECK_LE(offset + nbytes, size) << "Invalid NDArray file format";
+    ctxs[i] = Context::Create(static_cast<Context::DeviceType>(attrs[1]), attrs[2]);
+    TBlob blob(base + offset, shape, cpu::kDevMask, attrs[0]);
+    arrays[i] = NDArray(blob, 0, holder);
+  }
+  // pick the selected arrays
+  std::vector<size_t> picked;
+  if (select.empty()) {
+    for (size_t i = 0; i < num_arrays; ++i) picked.push_back(i);
+    *keys = names;
+  } else {
+    CHECK_NE(num_names, 0U) << "Cannot select arrays by name in " << fname
+                            << ", which has no names";
+    keys->clear();
+    for (const auto& name : select) {
+      auto it = name_index.find(name);
+      CHECK(it != name_index.end()) << "Cannot find array " << name << " in " << fname;
+      picked.push_back(it->second);
+      keys->push_back(name);
+    }
+  }
+  data->clear();
+  for (size_t i : picked) {
+    if (ctxs[i].dev_mask() == cpu::kDevMask || arrays[i].is_none()) {
+      data->push_back(arrays[i]);
+    } else {
+#if MXNET_USE_CUDA
+      data->push_back(arrays[i].Copy(ctxs[i]));
+#else
+      data->push_back(arrays[i]);
+#endif
+    }
+  }
+  return true;
+}
+
 NDArray NDArray::Copy(Context ctx) const {
   NDArray ret;
   if (kDefaultStorage == storage_type()) {
@@ -1052,6 +1512,30 @@ NDArray NDArray::Copy(Context ctx) const {
   return ret;
 }
 
+NDArray NDArray::StorageTwin() const {
+  CHECK_EQ(storage_type(), kDefaultStorage)
+      << "StorageTwin is only supported for default storage arrays";
+  ptr_->CheckAndAlloc();
+  NDArray ret(TShape(mshadow::Shape1(ptr_->shandle.size)), ctx(), false, mshadow::kUint8);
+  ret.shape_ = shape_;
+  ret.dtype_ = dtype_;
+  ret.byte_offset_ = byte_offset_;
+  return ret;
+}
+
+void NDArray::SwapStorage(const NDArray& twin) const {
+  CHECK(storage_type() == kDefaultStorage && twin.storage_type() == kDefaultStorage)
+      << "SwapStorage is only supported for default storage arrays";
+  CHECK(!ptr_->static_data && !twin.ptr_->static_data)
+      << "SwapStorage cannot exchange memory not owned by the arrays";
+  ptr_->CheckAndAlloc();
+  twin.ptr_->CheckAndAlloc();
+  CHECK(ptr_->shandle.ctx == twin.ptr_->shandle.ctx &&
+        ptr_->shandle.size == twin.ptr_->shandle.size)
+      << "SwapStorage requires an array created by StorageTwin";
+  std::swap(ptr_->shandle, twin.ptr_->shandle);
+}
+
 void NDArray::SyncCopyFromCPU(const void *data, size_t size) const {
   TShape dshape = this->shape();
   CHECK_EQ(dshape.Size(), size)
@@ -1202,6 +1686,43 @@ void NDArray::SyncCopyToCPU(void *data, size_t size) const {
   }
 }
 
+void NDArray::CopyToCPUAsync(void *data, size_t size,
+                             const std::function<void()>& on_complete) const {
+  TShape dshape = this->shape();
+  CHECK_EQ(dshape.Size(), size)
+      << "Memory size do not match";
+  CHECK_EQ(this->storage_type(), kDefaultStorage)
+      << "CopyToCPUAsync only supports dense NDArrays";
+  TBlob dst(data, dshape, cpu::kDevMask, this->dtype_, 0); // NOLINT(*)
+  // the copy holds the array alive until it is done
+  NDArray src = *this;
+  if (this->ctx().dev_mask() == cpu::kDevMask) {
+    Engine::Get()->PushAsync([src, dst, on_complete](RunContext rctx,
+                                                     Engine::CallbackOnComplete done) {
+        TBlob tmp = dst;
+        ndarray::Copy<cpu, cpu>(src.data(), &tmp, Context::CPU(), Context::CPU(), rctx);
+        done();
+        on_complete();
+      }, this->ctx(), {this->var()}, {},
+      FnProperty::kNormal, 0, PROFILER_MESSAGE("AsyncCopyCPU2CPU"));
+  } else {
+#if MXNET_USE_CUDA
+    Engine::Get()->PushAsync([src, dst, on_complete](RunContext rctx,
+                                                     Engine::CallbackOnComplete done) {
+        TBlob tmp = dst;
+        ndarray::Copy<gpu, cpu>(src.data(), &tmp, src.ctx(), Context::CPU(), rctx);
+        // Wait GPU kernel to complete
+        rctx.get_stream<gpu>()->Wait();
+        done();
+        on_complete();
+      }, this->ctx(), {this->var()}, {},
+      FnProperty::kCopyFromGPU, 0, PROFILER_MESSAGE("AsyncCopyGPU2CPU"));
+#else
+    LOG(FATAL) << "GPU is not enabled";
+#endif
+  }
+}
+
 #if MXNET_PREDICT_ONLY == 0
 // register API function
 // those with underscore will be registered at NDArray
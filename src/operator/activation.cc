@@ -29,6 +29,9 @@
 #include "./mkl/mkl_memory-inl.h"
 #include "./mkl/mkl_relu-inl.h"
 #endif  // MXNET_USE_MKL2017
+#if MXNET_USE_NNPACK == 1
+#include "./nnpack/nnpack_activation-inl.h"
+#endif  // MXNET_USE_NNPACK
 
 namespace mxnet {
 namespace op {
@@ -48,6 +51,11 @@ Operator *CreateOp<cpu>(ActivationParam param, int dtype, const TShape& dshape)
   }
   if (enableMKLWarnGenerated())
     LOG(INFO) << MKLReluOp<cpu, float>::getName() << " Skip MKL optimization";
+#endif
+#if MXNET_USE_NNPACK == 1
+  if (param.act_type == activation::kReLU && dtype == mshadow::kFloat32) {
+    return new NNPACKReluOp<cpu, float>();
+  }
 #endif
   MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
     switch (param.act_type) {
@@ -63,6 +63,7 @@ struct BatchNormParam : public dmlc::Parameter<BatchNormParam> {
   bool output_mean_var;
   int axis;
   bool cudnn_off;
+  bool backward_from_output;
   DMLC_DECLARE_PARAMETER(BatchNormParam) {
     DMLC_DECLARE_FIELD(eps).set_default(1e-3f)
     .describe("Epsilon to prevent div 0. "
@@ -81,6 +82,10 @@ struct BatchNormParam : public dmlc::Parameter<BatchNormParam> {
       .describe("Specify which shape axis the channel is specified");
     DMLC_DECLARE_FIELD(cudnn_off).set_default(false)
       .describe("Do not select CUDNN operator, if available");
+    DMLC_DECLARE_FIELD(backward_from_output).set_default(false)
+      .describe("Compute the gradients from the output instead of the input, which lets "
+                "the output be written over the input. gamma must not be zero. "
+                "The cuDNN and MKL operators are not used then.");
   }
 };
 
@@ -123,7 +128,7 @@ class BatchNormOp : public Operator {
     } else {
       CHECK_GE(out_data.size(), 1U);
       CHECK_GE(req.size(), 1U);
-      CHECK_EQ(req[batchnorm::kOut], kWriteTo);
+      CHECK(IsWriting(req[batchnorm::kOut]));
     }
     Stream<xpu> *s = ctx.get_stream<xpu>();
     DoForward(s, ctx, in_data, req, out_data, aux_states);
@@ -314,6 +319,16 @@ class BatchNormProp : public OperatorProperty {
     const std::vector<int> &out_grad,
     const std::vector<int> &in_data,
     const std::vector<int> &out_data) const override {
+    if (param_.backward_from_output) {
+      // the normalized input is recovered from the output, gamma and beta
+      return {out_grad[batchnorm::kOut],
+              out_data[batchnorm::kOut],
+              out_data[batchnorm::kMean],
+              out_data[batchnorm::kVar],
+              in_data[batchnorm::kGamma],
+              in_data[batchnorm::kBeta]
+             };
+    }
     return {out_grad[batchnorm::kOut],
             out_data[batchnorm::kMean],
             out_data[batchnorm::kVar],
@@ -322,6 +337,15 @@ class BatchNormProp : public OperatorProperty {
            };
   }
 
+  std::vector<std::pair<int, void*> > ForwardInplaceOption(
+    const std::vector<int> &in_data,
+    const std::vector<void*> &out_data) const override {
+    if (param_.backward_from_output) {
+      return {{in_data[batchnorm::kData], out_data[batchnorm::kOut]}};
+    }
+    return {};
+  }
+
   int NumVisibleOutputs() const override {
     if (param_.output_mean_var) {
       return 3;
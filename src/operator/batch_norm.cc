@@ -25,6 +25,7 @@
 
 #include "batch_norm-inl.h"
 #include <nnvm/op_attr_types.h>
+#include "../engine/openmp.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
 #include "./mkl/mkl_memory-inl.h"
@@ -115,26 +116,26 @@ void BatchNormOp<xpu, DType, AccReal>::DoForward(mshadow::Stream<cpu> *,
   const size_t channelCount = inputData.ChannelCount();
   const size_t itemCountPerChannel = inputData.Size() / channelCount;
 
-  #pragma omp parallel for
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
   for (int channel = 0; channel < static_cast<int>(channelCount); ++channel) {
     if (is_train_and_not_global_stats) {
-      // compute mean per input
-      mean[channel] = 0;
-      ForEachFast(inputData, channel, [mean, channel](const DType *in_data) {
-        mean[channel] += *in_data; });
-      mean[channel] /= itemCountPerChannel;
+      // compute mean per input, the sums are kept in registers so that
+      // the loops vectorize
+      AccReal sumData = 0;
+      ForEachFast(inputData, channel, [&sumData](const DType *in_data) {
+        sumData += *in_data; });
+      mean[channel] = sumData / itemCountPerChannel;
 
       // compute variance per input
       const AccReal thisMean = mean[channel];
-      var[channel] = 0;
+      AccReal sum = 0;
       ForEachFast(inputData, channel,
-                  [var, thisMean, channel](const DType *current_in_data) {
+                  [&sum, thisMean](const DType *current_in_data) {
                     const AccReal current = *current_in_data;
-                    var[channel] += (current - thisMean) * (current - thisMean);
+                    sum += (current - thisMean) * (current - thisMean);
                   });
 
-      const AccReal sum = var[channel];
-
       AccReal invstd;
       if (sum == 0 && param_.eps == 0.0) {
         // Nobody likes to divide by zero
@@ -196,9 +197,12 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
                                                   const std::vector<OpReqType> &req,
                                                   const std::vector<TBlob> &in_grad,
                                                   const std::vector<TBlob> &aux_states) {
-  // Input Data
-  batchnorm::BNTensor3<DType> inputData(in_data[batchnorm::kData], param_.axis);
+  // Input Data, or the output it is recovered from
+  batchnorm::BNTensor3<DType> inputData(param_.backward_from_output ?
+                                        out_data[batchnorm::kOut] : in_data[batchnorm::kData],
+                                        param_.axis);
   const TBlob &weights   = in_data[batchnorm::kGamma];
+  const TBlob &bias      = in_data[batchnorm::kBeta];
 
   // Input Grad
   batchnorm::BNTensor3<DType> gradIn(in_grad[batchnorm::kData], param_.axis);
@@ -227,7 +231,8 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
 
   const bool is_train_and_not_global_stats = ctx.is_train && !param_.use_global_stats;
 
-  #pragma omp parallel for
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
   for (int channel = 0; channel < static_cast<int>(channelCount); ++channel) {
     const AccReal *weight = weights.dptr<AccReal>();
     const AccReal w = !param_.fix_gamma ? weight[channel] : AccReal(1);
@@ -249,6 +254,13 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
       invstd = VARIANCE_TO_INVSTD(runningVarDataPtr[channel], param_.eps);
     }
 
+    // X - E[x] = (center of the data) * scale, the output is (X - E[x]) * invstd * w + b
+    AccReal center = mean, scale = 1;
+    if (param_.backward_from_output) {
+      center = bias.dptr<AccReal>()[channel];
+      scale = AccReal(1) / (invstd * w);
+    }
+
     // sumGradOut over all gradOutput in feature plane
     AccReal sumGradOut = 0;
     ForEachFast(gradOut, static_cast<size_t>(channel),
@@ -259,8 +271,8 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
     // dot product of the Q(X) and gradOuput
     AccReal dotp = 0;
     ForEachFast(inputData, gradOut, static_cast<size_t>(channel),
-                [&dotp, mean](const DType *thisInputData, const DType *gradOut_data) {
-                  dotp += (*thisInputData - mean) * (*gradOut_data);
+                [&dotp, center, scale](const DType *thisInputData, const DType *gradOut_data) {
+                  dotp += (*thisInputData - center) * scale * (*gradOut_data);
                 });
 
     if (!gradIn.IsEmpty() && IsWriting(req[batchnorm::kData])) {  // if there's a grad input
@@ -271,10 +283,10 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
         // dL/dX = (Q(dL/dY) - dot(Y, dL/dY) * Y) / σ * w
 
         // projection of gradOutput on to output scaled by std
-        const AccReal k = dotp * invstd * invstd / itemCount;
+        const AccReal k = dotp * invstd * invstd / itemCount * scale;
         ForEachFast(inputData, gradIn, static_cast<size_t>(channel),
-                    [&mean, &k](const DType *inputDataPtr, DType *gradIn_data) {
-                      *gradIn_data = (*inputDataPtr - mean) * k;
+                    [&center, &k](const DType *inputDataPtr, DType *gradIn_data) {
+                      *gradIn_data = (*inputDataPtr - center) * k;
                     });
 
         const AccReal iw = invstd * w;
@@ -296,19 +308,16 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(mshadow::Stream<cpu> *,
       }
     }
 
-    // May want to make this a param eventually
-    const AccReal scale = 1.0f;
-
     if (IsWriting(req[batchnorm::kGamma])) {
       if (!param_.fix_gamma) {
-        gradWeightData[channel] = scale * dotp * invstd;
+        gradWeightData[channel] = dotp * invstd;
       } else {
         gradWeightData[channel] = AccReal(0);
       }
     }
 
     if (IsWriting(req[batchnorm::kBeta])) {
-      gradBiasData[channel] = scale * sumGradOut;
+      gradBiasData[channel] = sumGradOut;
     }
   }
 }
@@ -320,6 +329,7 @@ Operator *CreateOp<cpu>(BatchNormParam param, const int dtype, const TShape& sha
 #if MXNET_USE_MKL2017 == 1
   if (shape.ndim() == 4
       && param.axis == mxnet::op::batchnorm::DEFAULT_AXIS
+      && !param.backward_from_output
       && !mxnet::op::batchnorm::disable_mkl) {
     switch (dtype) {
       case mshadow::kFloat32:
@@ -33,6 +33,7 @@
 #define FIX_GAMMA_FLAG        8
 #define IS_TRAINING_FLAG      16
 #define USE_GLOBAL_STATS_FLAG 32
+#define FROM_OUTPUT_FLAG      64
 
 #if MXNET_USE_CUDNN == 1 && CUDNN_MAJOR >= 5
 #include "./cudnn_batch_norm-inl.h"
@@ -123,14 +124,16 @@ struct VarOp {
 
 template<typename DType, typename AccReal, typename DeviceTensor>
 struct GradOp {
-  __device__ GradOp(AccReal m, const DeviceTensor i, const DeviceTensor g)
-    : mean(m), input(i), gradOutput(g) {}
+  __device__ GradOp(AccReal m, AccReal s, const DeviceTensor i, const DeviceTensor g)
+    : mean(m), scale(s), input(i), gradOutput(g) {}
   __device__ __forceinline__ Float2<DType, AccReal> operator()(int batch, int plane, int n) {
     const DType g = gradOutput.get_ref(batch, plane, n);
-    const DType c = ScalarConvert<AccReal, DType>::to(input.get_ref(batch, plane, n) - mean);
+    const DType c = ScalarConvert<AccReal, DType>::to(
+      (input.get_ref(batch, plane, n) - mean) * scale);
     return Float2<DType, AccReal>(g, g * c);
   }
   const AccReal mean;
+  const AccReal scale;
   const DeviceTensor input;
   const DeviceTensor gradOutput;
 };
@@ -302,6 +305,7 @@ struct CUDATensors {
   DeviceTensor1 gradWeight;
   DeviceTensor1 gradBias;
   DeviceTensor1 weight;
+  DeviceTensor1 bias;
   DeviceTensor1 runningMean;
   DeviceTensor1 runningVar;
   DeviceTensor1 saveMean;
@@ -336,10 +340,18 @@ static __global__ void BatchNormalizationBackwardKernel(
                       ScalarConvert<DType, AccReal>::to(tensors.weight[plane]) : AccReal(1);
   const AccReal norm = AccReal(1) / N;
 
+  // input - mean = (input - center) * scale, where input is the output of
+  // the forward pass when the gradients are computed from it
+  AccReal center = mean, scale = 1;
+  if ((flags & FROM_OUTPUT_FLAG) != 0) {
+    center = ScalarConvert<DType, AccReal>::to(tensors.bias[plane]);
+    scale = AccReal(1) / (invstd * weightVal);
+  }
+
   // Compute two values across (batch, x/y/z) in one pass:
   // 1. Sum(gradOutput)
   // 2. DotProduct(input - mean, gradOutput)
-  GradOp<DType, AccReal, DeviceTensor> g(mean, input, gradOutput);
+  GradOp<DType, AccReal, DeviceTensor> g(center, scale, input, gradOutput);
   Float2< DType, AccReal > res = reduce < Float2 < DType, AccReal >,
     GradOp< DType, AccReal, DeviceTensor >, DeviceTensor > (g, gradOutput, plane);
   const AccReal gradOutputSum = res.v1;
@@ -366,7 +378,7 @@ static __global__ void BatchNormalizationBackwardKernel(
         const DType gradOut = gradOutput.get_ref(batch, plane, x);
         if (is_train_and_not_global_stats) {
           const DType inp = input.get_ref(batch, plane, x);
-          const AccReal proj = (inp - mean) * projScale;
+          const AccReal proj = (inp - center) * scale * projScale;
           gradInput.get_ref(batch, plane, x) =
             ScalarConvert<AccReal, DType>::to((gradOut - proj - gradMean) * gradScale);
         } else {
@@ -537,7 +549,8 @@ static void BatchNormalizationBackward(mshadow::Stream<gpu> *s,
                                        double momentum,
                                        double eps) {
   batchnorm::BNTensor3<DType> input = batchnorm::BNTensor3<DType>(
-    in_data[batchnorm::kData], param.axis);
+    param.backward_from_output ? out_data[batchnorm::kOut] : in_data[batchnorm::kData],
+    param.axis);
   batchnorm::BNTensor3<DType>gradOutput = batchnorm::BNTensor3<DType>(
     out_grad[batchnorm::kOut], param.axis);
   batchnorm::BNTensor3<DType>gradInput = batchnorm::BNTensor3<DType>(
@@ -548,6 +561,7 @@ static void BatchNormalizationBackward(mshadow::Stream<gpu> *s,
   tensors.gradWeight = devicetensor<AccReal, 1>(in_grad[batchnorm::kGamma]);
   tensors.gradBias = devicetensor<AccReal, 1>(in_grad[batchnorm::kBeta]);
   tensors.weight = devicetensor<AccReal, 1>(in_data[batchnorm::kGamma]);
+  tensors.bias = devicetensor<AccReal, 1>(in_data[batchnorm::kBeta]);
   tensors.runningMean = devicetensor<AccReal, 1>(aux_states[batchnorm::kMovingMean]);
   tensors.runningVar = devicetensor<AccReal, 1>(aux_states[batchnorm::kMovingVar]);
   tensors.saveMean = devicetensor<AccReal, 1>(out_data[batchnorm::kMean]);
@@ -578,6 +592,7 @@ static inline uint32_t SetupFlags(const OpContext &ctx,
   flags |= ctx.is_train ? IS_TRAINING_FLAG : 0;
   flags |= params.fix_gamma ? FIX_GAMMA_FLAG : 0;
   flags |= params.use_global_stats ? USE_GLOBAL_STATS_FLAG : 0;
+  flags |= params.backward_from_output ? FROM_OUTPUT_FLAG : 0;
   if (BatchNormOp<xpu, DType, AccReal>::IsWriting(req[batchnorm::kData])) {
     flags |= WRITE_DATA_FLAG;
   }
@@ -642,8 +657,11 @@ Operator *CreateOp<gpu>(BatchNormParam param, const int dtype, const TShape& sha
   param.axis = mxnet::op::batchnorm::GetRealAxis(shape, param.axis);
   Operator *op = NULL;
 #if MXNET_USE_CUDNN == 1 && CUDNN_MAJOR >= 5
-  if (!param.use_global_stats && !param.cudnn_off && shape.ndim() <= 4
-      && param.axis == mxnet::op::batchnorm::DEFAULT_AXIS) {
+  // cuDNN takes the channels last in NHWC from v7
+  const bool cudnn_axis = param.axis == mxnet::op::batchnorm::DEFAULT_AXIS ||
+      (CUDNN_MAJOR >= 7 && shape.ndim() == 4 && param.axis == 3);
+  if (!param.use_global_stats && !param.cudnn_off && !param.backward_from_output &&
+      shape.ndim() <= 4 && cudnn_axis) {
     MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
       op = new CuDNNBatchNormOp<DType>(param);
     })
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batch_norm_fold-inl.h
+ * \brief Fold the statistics of a BatchNorm into the weight and bias of the
+ *  preceding layer, used by the inference graphs of the executor.
+ */
+#ifndef MXNET_OPERATOR_BATCH_NORM_FOLD_INL_H_
+#define MXNET_OPERATOR_BATCH_NORM_FOLD_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <vector>
+#include "./operator_common.h"
+#include "./mshadow_op.h"
+#include "./mxnet_op.h"
+
+namespace mxnet {
+namespace op {
+
+struct FoldBatchNormParam : public dmlc::Parameter<FoldBatchNormParam> {
+  float eps;
+  bool fix_gamma;
+  bool no_bias;
+  DMLC_DECLARE_PARAMETER(FoldBatchNormParam) {
+    DMLC_DECLARE_FIELD(eps).set_default(1e-3f)
+    .describe("Epsilon of the BatchNorm.");
+    DMLC_DECLARE_FIELD(fix_gamma).set_default(true)
+    .describe("Whether the BatchNorm uses a gamma of 1.");
+    DMLC_DECLARE_FIELD(no_bias).set_default(false)
+    .describe("Whether the layer has no bias input.");
+  }
+};
+
+namespace fold_bn {
+enum FoldBatchNormOutputs {kWeight, kBias};
+}  // namespace fold_bn
+
+/*! \brief number of inputs: weight, optional bias, gamma, beta, mean and var */
+inline uint32_t FoldBatchNormNumInputs(const nnvm::NodeAttrs& attrs) {
+  const FoldBatchNormParam& param = nnvm::get<FoldBatchNormParam>(attrs.parsed);
+  return param.no_bias ? 5 : 6;
+}
+
+inline bool FoldBatchNormShape(const nnvm::NodeAttrs& attrs,
+                               std::vector<TShape> *in_attrs,
+                               std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), FoldBatchNormNumInputs(attrs));
+  CHECK_EQ(out_attrs->size(), 2U);
+  // the folded weight has the shape of the weight, in both directions
+  SHAPE_ASSIGN_CHECK(*out_attrs, fold_bn::kWeight, (*in_attrs)[0]);
+  SHAPE_ASSIGN_CHECK(*in_attrs, 0, (*out_attrs)[fold_bn::kWeight]);
+  const TShape& wshape = (*in_attrs)[0];
+  if (wshape.ndim() == 0) return false;
+  const TShape channel = mshadow::Shape1(wshape[0]);
+  for (size_t i = 1; i < in_attrs->size(); ++i) {
+    SHAPE_ASSIGN_CHECK(*in_attrs, i, channel);
+  }
+  SHAPE_ASSIGN_CHECK(*out_attrs, fold_bn::kBias, channel);
+  return true;
+}
+
+struct FoldBatchNormWeightKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* weight,
+                                  const DType* gamma, const DType* var,
+                                  const DType eps, const bool fix_gamma,
+                                  const int inner, const OpReqType req) {
+    const int c = i / inner;
+    const DType g = fix_gamma ? DType(1) : gamma[c];
+    KERNEL_ASSIGN(out[i], req, weight[i] * g / mshadow_op::square_root::Map(var[c] + eps));
+  }
+};
+
+struct FoldBatchNormBiasKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int c, DType* out, const DType* bias,
+                                  const DType* gamma, const DType* beta,
+                                  const DType* mean, const DType* var,
+                                  const DType eps, const bool fix_gamma,
+                                  const OpReqType req) {
+    const DType g = fix_gamma ? DType(1) : gamma[c];
+    const DType b = bias == nullptr ? DType(0) : bias[c];
+    KERNEL_ASSIGN(out[c], req,
+                  (b - mean[c]) * g / mshadow_op::square_root::Map(var[c] + eps) + beta[c]);
+  }
+};
+
+template<typename xpu>
+void FoldBatchNormCompute(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  const FoldBatchNormParam& param = nnvm::get<FoldBatchNormParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), FoldBatchNormNumInputs(attrs));
+  CHECK_EQ(outputs.size(), 2U);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob& weight = inputs[0];
+  const int off = param.no_bias ? 0 : 1;
+  const TBlob& gamma = inputs[1 + off];
+  const TBlob& beta = inputs[2 + off];
+  const TBlob& mean = inputs[3 + off];
+  const TBlob& var = inputs[4 + off];
+  const int channels = weight.shape_[0];
+  MSHADOW_REAL_TYPE_SWITCH(weight.type_flag_, DType, {
+    if (req[fold_bn::kWeight] != kNullOp) {
+      Kernel<FoldBatchNormWeightKernel, xpu>::Launch(s, weight.Size(),
+        outputs[fold_bn::kWeight].dptr<DType>(), weight.dptr<DType>(),
+        gamma.dptr<DType>(), var.dptr<DType>(), static_cast<DType>(param.eps),
+        param.fix_gamma, static_cast<int>(weight.Size() / channels),
+        req[fold_bn::kWeight]);
+    }
+    if (req[fold_bn::kBias] != kNullOp) {
+      Kernel<FoldBatchNormBiasKernel, xpu>::Launch(s, channels,
+        outputs[fold_bn::kBias].dptr<DType>(),
+        param.no_bias ? static_cast<DType*>(nullptr) : inputs[1].dptr<DType>(),
+        gamma.dptr<DType>(), beta.dptr<DType>(), mean.dptr<DType>(), var.dptr<DType>(),
+        static_cast<DType>(param.eps), param.fix_gamma, req[fold_bn::kBias]);
+    }
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_BATCH_NORM_FOLD_INL_H_
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batch_norm_fold.cc
+ * \brief Fold the statistics of a BatchNorm into the weight and bias of the
+ *  preceding layer
+ */
+#include <string>
+#include <vector>
+#include "./batch_norm_fold-inl.h"
+#include "./elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(FoldBatchNormParam);
+
+NNVM_REGISTER_OP(_FoldBatchNorm)
+.describe(R"code(Fold the statistics of a BatchNorm into the weight and bias of
+the Convolution or FullyConnected layer feeding it.
+
+With :math:`s = \gamma / \sqrt{var + \epsilon}` for every output channel, the
+outputs are the weight scaled by :math:`s` along its first axis and
+:math:`(bias - mean) \cdot s + \beta`.
+
+The graph executor creates this operator for inference graphs when
+MXNET_EXEC_ENABLE_BATCHNORM_FOLDING is set.
+
+)code" ADD_FILELINE)
+.set_num_inputs(FoldBatchNormNumInputs)
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<FoldBatchNormParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    const FoldBatchNormParam& param = nnvm::get<FoldBatchNormParam>(attrs.parsed);
+    if (param.no_bias) {
+      return std::vector<std::string>{"weight", "gamma", "beta", "moving_mean", "moving_var"};
+    }
+    return std::vector<std::string>{"weight", "bias", "gamma", "beta", "moving_mean",
+                                    "moving_var"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"weight", "bias"};
+  })
+// the moving statistics are declared mutable so that they stay auxiliary
+// states of the executor, as they were for the BatchNorm. They are only read.
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    const uint32_t n = FoldBatchNormNumInputs(attrs);
+    return std::vector<uint32_t>{n - 2, n - 1};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", FoldBatchNormShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, 2>)
+.set_attr<FCompute>("FCompute<cpu>", FoldBatchNormCompute<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "Weight of the layer")
+.add_argument("bias", "NDArray-or-Symbol", "Bias of the layer, absent if no_bias")
+.add_argument("gamma", "NDArray-or-Symbol", "gamma of the BatchNorm")
+.add_argument("beta", "NDArray-or-Symbol", "beta of the BatchNorm")
+.add_argument("moving_mean", "NDArray-or-Symbol", "moving mean of the BatchNorm")
+.add_argument("moving_var", "NDArray-or-Symbol", "moving variance of the BatchNorm")
+.add_arguments(FoldBatchNormParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
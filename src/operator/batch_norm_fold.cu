@@ -0,0 +1,34 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batch_norm_fold.cu
+ * \brief Fold the statistics of a BatchNorm into the weight and bias of the
+ *  preceding layer
+ */
+#include "./batch_norm_fold-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_FoldBatchNorm)
+.set_attr<FCompute>("FCompute<gpu>", FoldBatchNormCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
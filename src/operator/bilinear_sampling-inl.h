@@ -0,0 +1,198 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bilinear_sampling-inl.h
+ * \brief cpu kernels of the bilinear sampling shared by BilinearSampler and
+ *  SpatialTransformer
+ */
+#ifndef MXNET_OPERATOR_BILINEAR_SAMPLING_INL_H_
+#define MXNET_OPERATOR_BILINEAR_SAMPLING_INL_H_
+
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief The four input pixels sampled by every point of an output row, top
+ *  left, top right, bottom left and bottom right, with their weights. The
+ *  pixels outside of the input have a zero mask and weight, and a valid
+ *  index, so that the loops over the row need no branch.
+ */
+template<typename DType>
+struct BilinearSamplingRow {
+  /*! \brief index of the pixels in an input channel */
+  std::vector<int> index[4];
+  /*! \brief 1 for the pixels inside of the input, 0 for the others */
+  std::vector<DType> mask[4];
+  /*! \brief interpolation weights of the pixels, zero outside of the input */
+  std::vector<DType> weight[4];
+  /*! \brief weight of the left and top pixels, before masking */
+  std::vector<DType> x_w, y_w;
+
+  explicit BilinearSamplingRow(int width) : x_w(width), y_w(width) {
+    for (int k = 0; k < 4; ++k) {
+      index[k].resize(width);
+      mask[k].resize(width);
+      weight[k].resize(width);
+    }
+  }
+  /*!
+   * \brief Set up the row from its source coordinates, normalized to [-1, 1].
+   * \param grid_x the x coordinates of the row
+   * \param grid_y the y coordinates of the row
+   */
+  void Init(const DType* grid_x, const DType* grid_y, int width, int i_h, int i_w) {
+    for (int w = 0; w < width; ++w) {
+      const DType y_real = (grid_y[w] + 1) * (i_h - 1) / 2;
+      const DType x_real = (grid_x[w] + 1) * (i_w - 1) / 2;
+      const int top = static_cast<int>(floor(y_real));
+      const int left = static_cast<int>(floor(x_real));
+      const DType top_w = DType(1) - (y_real - DType(top));
+      const DType left_w = DType(1) - (x_real - DType(left));
+      y_w[w] = top_w;
+      x_w[w] = left_w;
+      const DType wy[2] = {top_w, DType(1) - top_w};
+      const DType wx[2] = {left_w, DType(1) - left_w};
+      for (int k = 0; k < 4; ++k) {
+        const int y = top + k / 2, x = left + k % 2;
+        const bool inside = y >= 0 && y < i_h && x >= 0 && x < i_w;
+        index[k][w] = inside ? y * i_w + x : 0;
+        mask[k][w] = DType(inside ? 1 : 0);
+        weight[k][w] = inside ? wy[k / 2] * wx[k % 2] : DType(0);
+      }
+    }
+  }
+};
+
+/*! \return the number of threads for work items, 1 if too few to split */
+inline int BilinearSamplingThreads(size_t work) {
+  if (work < static_cast<size_t>(engine::OpenMP::Get()->min_parallel_size())) return 1;
+  return engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+}
+
+/*!
+ * \brief Sample data (n, c, i_h, i_w) at grid (n, 2, o_h, o_w), x first, into
+ *  out (n, c, o_h, o_w). The rows of the output are split over the threads,
+ *  and the weights of a row are shared by its channels.
+ */
+template<typename DType>
+inline void BilinearSamplingForwardCPU(DType* out, const DType* data, const DType* grid,
+                                       int n, int c, int i_h, int i_w, int o_h, int o_w) {
+  const int rows = n * o_h;
+  const int omp_threads = BilinearSamplingThreads(static_cast<size_t>(rows) * o_w * c);
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    BilinearSamplingRow<DType> row(o_w);
+    #pragma omp for
+    for (int r = 0; r < rows; ++r) {
+      const int b = r / o_h, h = r % o_h;
+      const DType* grid_x = grid + (b * 2 * o_h + h) * o_w;
+      row.Init(grid_x, grid_x + o_h * o_w, o_w, i_h, i_w);
+      for (int ch = 0; ch < c; ++ch) {
+        const DType* plane = data + static_cast<size_t>(b * c + ch) * i_h * i_w;
+        DType* dst = out + (static_cast<size_t>(b * c + ch) * o_h + h) * o_w;
+        for (int w = 0; w < o_w; ++w) {
+          dst[w] = row.weight[0][w] * plane[row.index[0][w]] +
+                   row.weight[1][w] * plane[row.index[1][w]] +
+                   row.weight[2][w] * plane[row.index[2][w]] +
+                   row.weight[3][w] * plane[row.index[3][w]];
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Gradients of BilinearSamplingForwardCPU. gdata is accumulated to.
+ *  The gradient of the grid is added to ggrid when add_grid is set and
+ *  written otherwise, ggrid may be the grid itself.
+ *
+ *  Without atomics, the scatter into gdata is split by channel planes, which
+ *  no two threads share, and the gradient of the grid, a sum over the
+ *  channels, is gathered by output row in a second pass.
+ */
+template<typename DType>
+inline void BilinearSamplingBackwardCPU(DType* gdata, DType* ggrid, bool add_grid,
+                                        const DType* grad, const DType* data, const DType* grid,
+                                        int n, int c, int i_h, int i_w, int o_h, int o_w) {
+  const int omp_threads = BilinearSamplingThreads(static_cast<size_t>(n) * c * o_h * o_w);
+  const int planes = n * c;
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    BilinearSamplingRow<DType> row(o_w);
+    #pragma omp for
+    for (int p = 0; p < planes; ++p) {
+      const int b = p / c;
+      DType* dst = gdata + static_cast<size_t>(p) * i_h * i_w;
+      for (int h = 0; h < o_h; ++h) {
+        const DType* grid_x = grid + (b * 2 * o_h + h) * o_w;
+        const DType* g = grad + (static_cast<size_t>(p) * o_h + h) * o_w;
+        row.Init(grid_x, grid_x + o_h * o_w, o_w, i_h, i_w);
+        for (int w = 0; w < o_w; ++w) {
+          for (int k = 0; k < 4; ++k) dst[row.index[k][w]] += g[w] * row.weight[k][w];
+        }
+      }
+    }
+  }
+  const int rows = n * o_h;
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    BilinearSamplingRow<DType> row(o_w);
+    std::vector<DType> gx(o_w), gy(o_w);
+    #pragma omp for
+    for (int r = 0; r < rows; ++r) {
+      const int b = r / o_h, h = r % o_h;
+      const size_t offset = (static_cast<size_t>(b) * 2 * o_h + h) * o_w;
+      row.Init(grid + offset, grid + offset + o_h * o_w, o_w, i_h, i_w);
+      std::fill(gx.begin(), gx.end(), DType(0));
+      std::fill(gy.begin(), gy.end(), DType(0));
+      for (int ch = 0; ch < c; ++ch) {
+        const DType* plane = data + static_cast<size_t>(b * c + ch) * i_h * i_w;
+        const DType* g = grad + (static_cast<size_t>(b * c + ch) * o_h + h) * o_w;
+        for (int w = 0; w < o_w; ++w) {
+          const DType tl = row.mask[0][w] * plane[row.index[0][w]];
+          const DType tr = row.mask[1][w] * plane[row.index[1][w]];
+          const DType bl = row.mask[2][w] * plane[row.index[2][w]];
+          const DType br = row.mask[3][w] * plane[row.index[3][w]];
+          // gradients of the weights of the top left pixel, the opposite of the coordinates'
+          gy[w] -= g[w] * (tr - br + (tl - tr - bl + br) * row.x_w[w]);
+          gx[w] -= g[w] * (bl - br + (tl - tr - bl + br) * row.y_w[w]);
+        }
+      }
+      DType* ggrid_x = ggrid + offset;
+      DType* ggrid_y = ggrid_x + o_h * o_w;
+      for (int w = 0; w < o_w; ++w) {
+        const DType dy = gy[w] * (i_h - 1) / 2, dx = gx[w] * (i_w - 1) / 2;
+        ggrid_y[w] = add_grid ? ggrid_y[w] + dy : dy;
+        ggrid_x[w] = add_grid ? ggrid_x[w] + dx : dx;
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_BILINEAR_SAMPLING_INL_H_
@@ -0,0 +1,245 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file beam_search-inl.h
+ * \brief one step of the beam search decoding of a batch
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_BEAM_SEARCH_INL_H_
+#define MXNET_OPERATOR_CONTRIB_BEAM_SEARCH_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace beam_search {
+enum BeamSearchInputs {kScores, kBeamScores, kFinished};
+enum BeamSearchOutputs {kOutScores, kTokens, kBeamIndices, kOutFinished};
+/*! \brief words of the vocabulary of a beam searched by one thread of the first pass */
+const int kChunkSize = 512;
+}  // namespace beam_search
+
+struct BeamSearchParam : public dmlc::Parameter<BeamSearchParam> {
+  int beam_size;
+  int eos_id;
+  DMLC_DECLARE_PARAMETER(BeamSearchParam) {
+    DMLC_DECLARE_FIELD(beam_size).set_lower_bound(1)
+    .describe("The number of hypotheses kept for every example after the step.");
+    DMLC_DECLARE_FIELD(eos_id).set_lower_bound(0)
+    .describe("The end of sequence token. A hypothesis which emits it is finished, "
+              "and only extends with it again, at no cost.");
+  }
+};
+
+inline bool BeamSearchShape(const nnvm::NodeAttrs& attrs,
+                            std::vector<TShape> *in_attrs,
+                            std::vector<TShape> *out_attrs) {
+  using namespace beam_search;
+  const BeamSearchParam& param = nnvm::get<BeamSearchParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 4U);
+  const TShape& sshape = (*in_attrs)[kScores];
+  if (sshape.ndim() == 0) return false;
+  CHECK_EQ(sshape.ndim(), 3U)
+      << "beam_search_step needs scores of shape (batch_size, beam, vocab_size)";
+  CHECK_LT(param.eos_id, static_cast<int>(sshape[2]))
+      << "eos_id " << param.eos_id << " is out of the vocabulary of size " << sshape[2];
+  CHECK_LE(param.beam_size, static_cast<int>(sshape[1] * sshape[2]))
+      << "beam_size " << param.beam_size << " exceeds the number of candidates";
+  SHAPE_ASSIGN_CHECK(*in_attrs, kBeamScores, Shape2(sshape[0], sshape[1]));
+  SHAPE_ASSIGN_CHECK(*in_attrs, kFinished, Shape2(sshape[0], sshape[1]));
+  for (int i = 0; i < 4; ++i) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, i, Shape2(sshape[0], param.beam_size));
+  }
+  return true;
+}
+
+/*!
+ * \brief insert a candidate in the list of the k best ones, sorted by
+ *  decreasing score then increasing index, whose empty slots have index -1
+ */
+template<typename DType>
+MSHADOW_XINLINE void BeamSearchInsert(DType score, int index, int k,
+                                      DType *scores, int *indices) {
+  if (indices[k - 1] >= 0 && !(score > scores[k - 1] ||
+                               (score == scores[k - 1] && index < indices[k - 1]))) {
+    return;
+  }
+  int j = k - 1;
+  while (j > 0 && (indices[j - 1] < 0 || score > scores[j - 1] ||
+                   (score == scores[j - 1] && index < indices[j - 1]))) {
+    scores[j] = scores[j - 1];
+    indices[j] = indices[j - 1];
+    --j;
+  }
+  scores[j] = score;
+  indices[j] = index;
+}
+
+/*!
+ * \brief the k best candidates of the chunk i % num_chunks of the vocabulary
+ *  for the beam i / num_chunks, indexed by beam * vocab_size + token
+ */
+struct beam_search_chunk_topk {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *top_scores, int *top_indices,
+                                  const DType *scores, const DType *beam_scores,
+                                  const DType *finished, int beam, int vocab_size,
+                                  int num_chunks, int k, int eos_id) {
+    const int row = i / num_chunks;
+    const int begin = (i % num_chunks) * beam_search::kChunkSize;
+    const int end = begin + beam_search::kChunkSize < vocab_size ?
+                    begin + beam_search::kChunkSize : vocab_size;
+    DType *out_scores = top_scores + static_cast<size_t>(i) * k;
+    int *out_indices = top_indices + static_cast<size_t>(i) * k;
+    for (int j = 0; j < k; ++j) out_indices[j] = -1;
+    const DType base = beam_scores[row];
+    const int offset = (row % beam) * vocab_size;
+    if (finished[row] != DType(0)) {
+      // a finished hypothesis only extends with the end of sequence token
+      if (eos_id >= begin && eos_id < end && base > mshadow::red::limits::MinValue<DType>()) {
+        out_scores[0] = base;
+        out_indices[0] = offset + eos_id;
+      }
+      return;
+    }
+    const DType *row_scores = scores + static_cast<size_t>(row) * vocab_size;
+    for (int w = begin; w < end; ++w) {
+      const DType score = base + row_scores[w];
+      if (score > mshadow::red::limits::MinValue<DType>()) {
+        BeamSearchInsert(score, offset + w, k, out_scores, out_indices);
+      }
+    }
+  }
+};
+
+/*!
+ * \brief merge the candidates of the chunks of example i into its k best
+ *  hypotheses. When there are fewer candidates, the last hypotheses are
+ *  finished with the lowest score.
+ */
+struct beam_search_select {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out_scores, DType *tokens, DType *beam_indices,
+                                  DType *out_finished, const OpReqType req,
+                                  DType *best_scores, int *best_indices,
+                                  const DType *top_scores, const int *top_indices,
+                                  const DType *finished, int num_candidates, int beam,
+                                  int vocab_size, int k, int eos_id) {
+    DType *scores = best_scores + static_cast<size_t>(i) * k;
+    int *indices = best_indices + static_cast<size_t>(i) * k;
+    for (int j = 0; j < k; ++j) indices[j] = -1;
+    const size_t start = static_cast<size_t>(i) * num_candidates;
+    for (int c = 0; c < num_candidates; ++c) {
+      const int index = top_indices[start + c];
+      if (index >= 0) {
+        BeamSearchInsert(top_scores[start + c], index, k, scores, indices);
+      }
+    }
+    for (int j = 0; j < k; ++j) {
+      const int out = i * k + j;
+      if (indices[j] >= 0) {
+        const int src = indices[j] / vocab_size;
+        const int token = indices[j] % vocab_size;
+        const bool done = finished[i * beam + src] != DType(0) || token == eos_id;
+        KERNEL_ASSIGN(out_scores[out], req, scores[j]);
+        KERNEL_ASSIGN(tokens[out], req, DType(token));
+        KERNEL_ASSIGN(beam_indices[out], req, DType(src));
+        KERNEL_ASSIGN(out_finished[out], req, DType(done));
+      } else {
+        KERNEL_ASSIGN(out_scores[out], req, mshadow::red::limits::MinValue<DType>());
+        KERNEL_ASSIGN(tokens[out], req, DType(eos_id));
+        KERNEL_ASSIGN(beam_indices[out], req, DType(0));
+        KERNEL_ASSIGN(out_finished[out], req, DType(1));
+      }
+    }
+  }
+};
+
+template<typename xpu>
+void BeamSearchStepForward(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  using namespace beam_search;
+  const BeamSearchParam& param = nnvm::get<BeamSearchParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 4U);
+  for (int i = 1; i < 4; ++i) CHECK_EQ(req[i], req[0]);
+  if (req[0] == kNullOp) return;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TShape& sshape = inputs[kScores].shape_;
+  const int batch = sshape[0];
+  const int beam = sshape[1];
+  const int vocab_size = sshape[2];
+  const int k = param.beam_size;
+  if (batch == 0) return;
+  const int num_chunks = (vocab_size + kChunkSize - 1) / kChunkSize;
+  const int num_candidates = beam * num_chunks * k;
+
+  MSHADOW_REAL_TYPE_SWITCH(inputs[kScores].type_flag_, DType, {
+    // workspace: the k best candidates of every chunk of every beam, then
+    // the k best of every example, in 8 bytes aligned parts
+    auto aligned = [](size_t bytes) { return (bytes + 7) / 8 * 8; };
+    const size_t num_top = static_cast<size_t>(batch) * num_candidates;
+    const size_t num_best = static_cast<size_t>(batch) * k;
+    const size_t top_scores_bytes = aligned(sizeof(DType) * num_top);
+    const size_t top_indices_bytes = aligned(sizeof(int) * num_top);
+    const size_t best_scores_bytes = aligned(sizeof(DType) * num_best);
+    const size_t best_indices_bytes = aligned(sizeof(int) * num_best);
+    Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+        Shape1(top_scores_bytes + top_indices_bytes + best_scores_bytes + best_indices_bytes), s);
+    char *ptr = workspace.dptr_;
+    DType *top_scores = reinterpret_cast<DType*>(ptr);
+    ptr += top_scores_bytes;
+    int *top_indices = reinterpret_cast<int*>(ptr);
+    ptr += top_indices_bytes;
+    DType *best_scores = reinterpret_cast<DType*>(ptr);
+    ptr += best_scores_bytes;
+    int *best_indices = reinterpret_cast<int*>(ptr);
+
+    const DType *finished = inputs[kFinished].dptr<DType>();
+    Kernel<beam_search_chunk_topk, xpu>::Launch(s, batch * beam * num_chunks,
+        top_scores, top_indices, inputs[kScores].dptr<DType>(),
+        inputs[kBeamScores].dptr<DType>(), finished, beam, vocab_size, num_chunks, k,
+        param.eos_id);
+    Kernel<beam_search_select, xpu>::Launch(s, batch,
+        outputs[kOutScores].dptr<DType>(), outputs[kTokens].dptr<DType>(),
+        outputs[kBeamIndices].dptr<DType>(), outputs[kOutFinished].dptr<DType>(), req[0],
+        best_scores, best_indices, top_scores, top_indices, finished, num_candidates,
+        beam, vocab_size, k, param.eos_id);
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_BEAM_SEARCH_INL_H_
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file beam_search.cc
+ * \brief one step of the beam search decoding of a batch
+ */
+#include "./beam_search-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(BeamSearchParam);
+
+NNVM_REGISTER_OP(_contrib_beam_search_step)
+.describe(R"code(Select the best hypotheses of every example of a batch after one step
+of beam search decoding.
+
+``scores`` is (batch_size, beam, vocab_size), the scores of the next token of
+every hypothesis, usually their log probabilities, ``beam_scores`` is
+(batch_size, beam), the accumulated scores of the hypotheses, and
+``finished`` is (batch_size, beam), 1 for the hypotheses which already emitted
+``eos_id``. The candidates of an example are the hypotheses extended with
+every token, of score ``beam_scores + scores``, except that a finished
+hypothesis only extends with ``eos_id``, keeping its score. The ``beam_size``
+best candidates of every example are selected, by decreasing score then
+increasing beam and token.
+
+The outputs are (batch_size, beam_size): the scores of the selected
+candidates, their last tokens, the beams they extend, and whether they are
+finished. The decoder states of the next step are gathered with the beams,
+``take(states, arange(batch_size) * beam + beam_indices)``, and the
+hypotheses are rebuilt from the tokens and beams of every step at the end.
+The first step can use a beam of 1, or ``beam_scores`` of -inf except for
+the first hypothesis. An example with fewer candidates than ``beam_size``
+gets finished hypotheses with the lowest score.
+
+The whole step runs in two kernels: the best candidates of chunks of the
+vocabulary of every hypothesis, then the best of every example.
+
+Example::
+
+  scores = [[[-1, -2, -3], [-0.5, -4, -1]]]
+  beam_scores = [[-1, -2]]
+  finished = [[0, 0]]
+  beam_search_step(scores, beam_scores, finished, beam_size=2, eos_id=0) =
+      [[-2, -2.5]], [[0, 0]], [[0, 1]], [[1, 1]]
+
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<BeamSearchParam>)
+.set_num_inputs(3)
+.set_num_outputs(4)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"scores", "beam_scores", "finished"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"scores", "tokens", "beam_indices", "finished"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", BeamSearchShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 4>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", BeamSearchStepForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("scores", "NDArray-or-Symbol", "The scores of the next token of every hypothesis")
+.add_argument("beam_scores", "NDArray-or-Symbol", "The scores of the hypotheses")
+.add_argument("finished", "NDArray-or-Symbol", "Whether the hypotheses are finished")
+.add_arguments(BeamSearchParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
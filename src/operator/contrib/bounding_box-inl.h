@@ -0,0 +1,360 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bounding_box-inl.h
+ * \brief non-maximum suppression of boxes, shared by box_nms and the
+ *  detection and proposal operators
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_BOUNDING_BOX_INL_H_
+#define MXNET_OPERATOR_CONTRIB_BOUNDING_BOX_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../tensor/ordering_op-inl.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief layout of a batch of boxes given to BoxNMS: box i of image b is
+ *  the stride values at (b * num + i) * stride, with the corners x1, y1,
+ *  x2, y2 from coord on. The boxes of every image are sorted by decreasing
+ *  score.
+ */
+struct BoxNMSLayout {
+  /*! \brief number of images */
+  int batch;
+  /*! \brief number of boxes of every image */
+  int num;
+  /*! \brief number of values of a box */
+  int stride;
+  /*! \brief position of x1 in a box */
+  int coord;
+  /*! \brief position of the class id in a box, boxes of different classes
+   *  do not suppress each other. -1 to suppress regardless of the class. */
+  int id;
+  /*! \brief 1 for pixel coordinates where a box is x2 - x1 + 1 wide, 0 otherwise */
+  float offset;
+};
+
+/*! \brief intersection over union of the boxes of corners a and b */
+template<typename DType>
+MSHADOW_XINLINE float BoxIoU(const DType *a, const DType *b, float offset) {
+  const float ax1 = static_cast<float>(a[0]), ay1 = static_cast<float>(a[1]);
+  const float ax2 = static_cast<float>(a[2]), ay2 = static_cast<float>(a[3]);
+  const float bx1 = static_cast<float>(b[0]), by1 = static_cast<float>(b[1]);
+  const float bx2 = static_cast<float>(b[2]), by2 = static_cast<float>(b[3]);
+  const float w = fmaxf(fminf(ax2, bx2) - fmaxf(ax1, bx1) + offset, 0.0f);
+  const float h = fmaxf(fminf(ay2, by2) - fmaxf(ay1, by1) + offset, 0.0f);
+  const float inter = w * h;
+  const float u = (ax2 - ax1 + offset) * (ay2 - ay1 + offset) +
+                  (bx2 - bx1 + offset) * (by2 - by1 + offset) - inter;
+  return u <= 0.0f ? 0.0f : inter / u;
+}
+
+/*! \brief number of 64-bit words of the suppression mask of an image of num boxes */
+inline size_t BoxNMSMaskWords(int num) {
+  const size_t blocks = (num + 63) / 64;
+  return static_cast<size_t>(num) * blocks;
+}
+
+/*!
+ * \brief number of images whose suppression masks the gpu computes at once,
+ *  so that the masks of a batch stay around 64MB
+ */
+inline int BoxNMSMaskImages(int batch, int num) {
+  const size_t kMaxMaskWords = (static_cast<size_t>(64) << 20) / sizeof(uint64_t);
+  const size_t kMaxGridImages = 65535;
+  const size_t words = std::max<size_t>(BoxNMSMaskWords(num), 1);
+  const size_t images = std::min(std::min<size_t>(batch, kMaxMaskWords / words), kMaxGridImages);
+  return static_cast<int>(std::max<size_t>(1, images));
+}
+
+/*!
+ * \brief the buffers of BoxNMS in a workspace: the number of candidate
+ *  boxes of every image, the kept boxes and their number, and on gpu the
+ *  suppression masks
+ */
+struct BoxNMSBuffers {
+  int *num_valid;
+  int *keep;
+  int *num_keep;
+  uint64_t *mask;
+
+  /*! \brief bytes of the buffers, a multiple of 8 */
+  template<typename xpu>
+  static size_t Size(int batch, int num) {
+    const size_t mask_words = std::is_same<xpu, gpu>::value ?
+        BoxNMSMaskImages(batch, num) * BoxNMSMaskWords(num) : 0;
+    const size_t ints = 2 * static_cast<size_t>(batch) + static_cast<size_t>(batch) * num;
+    return mask_words * sizeof(uint64_t) + (ints + 1) / 2 * sizeof(uint64_t);
+  }
+
+  /*! \brief the buffers in a workspace of Size bytes aligned to 8 bytes */
+  template<typename xpu>
+  static BoxNMSBuffers Create(char *workspace, int batch, int num) {
+    const size_t mask_words = std::is_same<xpu, gpu>::value ?
+        BoxNMSMaskImages(batch, num) * BoxNMSMaskWords(num) : 0;
+    BoxNMSBuffers buffers;
+    buffers.mask = reinterpret_cast<uint64_t*>(workspace);
+    buffers.num_valid = reinterpret_cast<int*>(buffers.mask + mask_words);
+    buffers.num_keep = buffers.num_valid + batch;
+    buffers.keep = buffers.num_keep + batch;
+    return buffers;
+  }
+};
+
+/*!
+ * \brief greedy non-maximum suppression of every image of a batch of boxes
+ *  sorted by decreasing score: a box is kept unless it overlaps a kept box
+ *  of the same class with an IoU above thresh.
+ *
+ *  On cpu the boxes are only compared to the boxes kept so far, which stops
+ *  after max_keep of them, and the images are spread over the OpenMP
+ *  threads. The suppression mask is not used.
+ *
+ * \param boxes the boxes, see BoxNMSLayout
+ * \param num_valid the candidates of image b are its first num_valid[b] boxes
+ * \param thresh the IoU above which a box is suppressed
+ * \param max_keep the largest number of boxes kept per image
+ * \param keep returns the indices of the kept boxes of image b, in
+ *  decreasing score from keep + b * num
+ * \param num_keep returns the number of kept boxes of every image
+ * \param mask the suppression masks of BoxNMSBuffers
+ */
+template<typename DType>
+inline void BoxNMS(mshadow::Stream<cpu> *s, const BoxNMSLayout &layout, const DType *boxes,
+                   const int *num_valid, float thresh, int max_keep,
+                   int *keep, int *num_keep, uint64_t *mask) {
+  const int omp_threads = std::max(1, std::min(layout.batch,
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount()));
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int b = 0; b < layout.batch; ++b) {
+    const DType *image = boxes + static_cast<size_t>(b) * layout.num * layout.stride;
+    int *kept = keep + static_cast<size_t>(b) * layout.num;
+    int count = 0;
+    for (int i = 0; i < num_valid[b] && count < max_keep; ++i) {
+      const DType *box = image + static_cast<size_t>(i) * layout.stride;
+      bool suppressed = false;
+      for (int k = 0; k < count && !suppressed; ++k) {
+        const DType *other = image + static_cast<size_t>(kept[k]) * layout.stride;
+        if (layout.id >= 0 &&
+            static_cast<float>(other[layout.id]) != static_cast<float>(box[layout.id])) continue;
+        suppressed = BoxIoU(box + layout.coord, other + layout.coord, layout.offset) > thresh;
+      }
+      if (!suppressed) kept[count++] = i;
+    }
+    num_keep[b] = count;
+  }
+}
+
+/*!
+ * \brief gpu version of BoxNMS. Blocks of 64 x 64 pairs of boxes set the
+ *  bits of the boxes suppressed by every box, then one block per image scans
+ *  the boxes in order and keeps the ones not suppressed by a kept box. The
+ *  masks of BoxNMSMaskImages images are computed at once, nothing goes
+ *  through the host.
+ */
+template<typename DType>
+void BoxNMS(mshadow::Stream<gpu> *s, const BoxNMSLayout &layout, const DType *boxes,
+            const int *num_valid, float thresh, int max_keep,
+            int *keep, int *num_keep, uint64_t *mask);
+
+struct BoxNMSParam : public dmlc::Parameter<BoxNMSParam> {
+  float overlap_thresh;
+  float valid_thresh;
+  int topk;
+  int coord_start;
+  int score_index;
+  int id_index;
+  bool force_suppress;
+  DMLC_DECLARE_PARAMETER(BoxNMSParam) {
+    DMLC_DECLARE_FIELD(overlap_thresh).set_default(0.5)
+    .describe("Overlapping(IoU) threshold to suppress object with smaller score.");
+    DMLC_DECLARE_FIELD(valid_thresh).set_default(0)
+    .describe("Filter input boxes to those whose scores greater than valid_thresh.");
+    DMLC_DECLARE_FIELD(topk).set_default(-1)
+    .describe("Apply nms to topk boxes with descending scores, -1 to no restriction.");
+    DMLC_DECLARE_FIELD(coord_start).set_default(2)
+    .describe("Start index of the consecutive 4 coordinates x1, y1, x2, y2.");
+    DMLC_DECLARE_FIELD(score_index).set_default(1)
+    .describe("Index of the scores/confidence of boxes.");
+    DMLC_DECLARE_FIELD(id_index).set_default(-1)
+    .describe("Optional, index of the class categories, -1 to disable.");
+    DMLC_DECLARE_FIELD(force_suppress).set_default(false)
+    .describe("Optional, if set false and id_index is provided, nms will only apply"
+              " to boxes belongs to the same category");
+  }
+};
+
+inline bool BoxNMSShape(const nnvm::NodeAttrs& attrs,
+                        std::vector<TShape> *in_attrs,
+                        std::vector<TShape> *out_attrs) {
+  const BoxNMSParam& param = nnvm::get<BoxNMSParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const TShape& dshape = (*in_attrs)[0];
+  if (dshape.ndim() == 0) return false;
+  CHECK_GE(dshape.ndim(), 2U) << "box_nms needs boxes of shape (..., num_boxes, box_width)";
+  const int width = dshape[dshape.ndim() - 1];
+  CHECK_GE(width, 5) << "box_nms needs at least a score and 4 coordinates in a box";
+  CHECK(param.coord_start >= 0 && param.coord_start + 4 <= width)
+      << "coord_start " << param.coord_start << " is out of the boxes of width " << width;
+  CHECK(param.score_index >= 0 && param.score_index < width)
+      << "score_index " << param.score_index << " is out of the boxes of width " << width;
+  CHECK_LT(param.id_index, width)
+      << "id_index " << param.id_index << " is out of the boxes of width " << width;
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, dshape);
+  return true;
+}
+
+/*! \brief sort keys of the boxes, the boxes which are not candidates go last */
+struct box_nms_keys {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, float *keys, int *index, const DType *data,
+                                  int width, int score_index, float valid_thresh,
+                                  float invalid_key) {
+    const float score = static_cast<float>(data[static_cast<size_t>(i) * width + score_index]);
+    keys[i] = score > valid_thresh ? score : invalid_key;
+    index[i] = i;
+  }
+};
+
+/*! \brief the number of candidates of image i, at most topk */
+struct box_nms_count_valid {
+  MSHADOW_XINLINE static void Map(int i, int *num_valid, const float *keys, int num,
+                                  int topk, float invalid_key) {
+    const float *image_keys = keys + static_cast<size_t>(i) * num;
+    int count = 0;
+    while (count < num && count < topk && image_keys[count] != invalid_key) ++count;
+    num_valid[i] = count;
+  }
+};
+
+/*! \brief gather the boxes in the sorted order */
+struct box_nms_gather {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *sorted, const DType *data, const int *index,
+                                  int width) {
+    const int box = i / width;
+    sorted[i] = data[static_cast<size_t>(index[box]) * width + i % width];
+  }
+};
+
+/*! \brief write the kept boxes of every image first, and -1 in the other rows */
+struct box_nms_output {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, const OpReqType req, const DType *sorted,
+                                  const int *keep, const int *num_keep, int num, int width) {
+    const int box = i / width;
+    const int b = box / num;
+    const int j = box % num;
+    if (j < num_keep[b]) {
+      const size_t src = (static_cast<size_t>(b) * num + keep[box]) * width + i % width;
+      KERNEL_ASSIGN(out[i], req, sorted[src]);
+    } else {
+      KERNEL_ASSIGN(out[i], req, DType(-1));
+    }
+  }
+};
+
+template<typename xpu>
+void BoxNMSForward(const nnvm::NodeAttrs& attrs,
+                   const OpContext& ctx,
+                   const std::vector<TBlob>& inputs,
+                   const std::vector<OpReqType>& req,
+                   const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const BoxNMSParam& param = nnvm::get<BoxNMSParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 1U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace) << "box_nms does not support inplace";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TShape& dshape = inputs[0].shape_;
+  const int width = dshape[dshape.ndim() - 1];
+  const int num = dshape[dshape.ndim() - 2];
+  const int batch = dshape.Size() / (static_cast<size_t>(num) * width);
+  const int total = batch * num;
+  if (total == 0) return;
+  const int topk = param.topk > 0 ? std::min(param.topk, num) : num;
+  const float invalid_key = -std::numeric_limits<float>::infinity();
+  BoxNMSLayout layout;
+  layout.batch = batch;
+  layout.num = num;
+  layout.stride = width;
+  layout.coord = param.coord_start;
+  layout.id = param.force_suppress ? -1 : param.id_index;
+  layout.offset = 0.0f;
+
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    // workspace: the sorted boxes, the sort keys and indices, the buffers
+    // of BoxNMS and the space of the sort, in 8 bytes aligned parts
+    auto aligned = [](size_t bytes) { return (bytes + 7) / 8 * 8; };
+    const size_t sorted_bytes = aligned(sizeof(DType) * total * width);
+    const size_t keys_bytes = aligned(sizeof(float) * total);
+    const size_t index_bytes = aligned(sizeof(int) * total);
+    const size_t nms_bytes = BoxNMSBuffers::Size<xpu>(batch, num);
+    size_t sort_bytes = SortByKeyWorkspaceSize<float, int, xpu>(total);
+    sort_bytes = std::max(sort_bytes, SortByKeyWorkspaceSize<int, float, xpu>(total));
+    sort_bytes = std::max(sort_bytes, SortByKeyWorkspaceSize<int, int, xpu>(total));
+    Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+        Shape1(sorted_bytes + keys_bytes + 2 * index_bytes + nms_bytes + sort_bytes), s);
+    char *ptr = workspace.dptr_;
+    DType *sorted = reinterpret_cast<DType*>(ptr);
+    ptr += sorted_bytes;
+    Tensor<xpu, 1, float> keys(reinterpret_cast<float*>(ptr), Shape1(total), s);
+    ptr += keys_bytes;
+    Tensor<xpu, 1, int> index(reinterpret_cast<int*>(ptr), Shape1(total), s);
+    ptr += index_bytes;
+    Tensor<xpu, 1, int> batch_id(reinterpret_cast<int*>(ptr), Shape1(total), s);
+    ptr += index_bytes;
+    BoxNMSBuffers buffers = BoxNMSBuffers::Create<xpu>(ptr, batch, num);
+    ptr += nms_bytes;
+    Tensor<xpu, 1, char> sort_work(ptr, Shape1(sort_bytes), s);
+
+    const DType *data = inputs[0].dptr<DType>();
+    Kernel<box_nms_keys, xpu>::Launch(s, total, keys.dptr_, index.dptr_, data, width,
+                                      param.score_index, param.valid_thresh, invalid_key);
+    TopKSort(keys, index, batch_id, sort_work, num, num, false);
+    Kernel<box_nms_count_valid, xpu>::Launch(s, batch, buffers.num_valid, keys.dptr_, num,
+                                             topk, invalid_key);
+    Kernel<box_nms_gather, xpu>::Launch(s, total * width, sorted, data, index.dptr_, width);
+    BoxNMS(s, layout, sorted, buffers.num_valid, param.overlap_thresh, num,
+           buffers.keep, buffers.num_keep, buffers.mask);
+    Kernel<box_nms_output, xpu>::Launch(s, total * width, outputs[0].dptr<DType>(), req[0],
+                                        sorted, buffers.keep, buffers.num_keep, num, width);
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_BOUNDING_BOX_INL_H_
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bounding_box.cc
+ * \brief non-maximum suppression of boxes
+ */
+#include "./bounding_box-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(BoxNMSParam);
+
+NNVM_REGISTER_OP(_contrib_box_nms)
+.describe(R"code(Apply non-maximum suppression to the boxes of every image of a batch.
+
+The input is (..., num_boxes, box_width), every row of the last axis is a
+box with a score at ``score_index``, the corners x1, y1, x2, y2 from
+``coord_start`` on and optionally a class id at ``id_index``. The leading
+axes are images, which are processed independently.
+
+The boxes with a score above ``valid_thresh`` are sorted by decreasing
+score, only the ``topk`` first ones are candidates, and a candidate is
+kept unless it overlaps a kept box with a higher score with an IoU above
+``overlap_thresh``. Boxes of different classes do not suppress each other
+unless ``force_suppress`` is set or ``id_index`` is -1.
+
+The output has the shape of the input: the kept boxes of every image come
+first in decreasing score, and the remaining rows are filled with -1.
+
+On gpu the suppression runs entirely on the device, with a bitmask of the
+pairs of overlapping boxes computed in parallel.
+
+Example::
+
+  x = [[0, 0.5, 0.1, 0.1, 0.2, 0.2], [1, 0.4, 0.1, 0.1, 0.2, 0.2],
+       [0, 0.3, 0.1, 0.1, 0.14, 0.14], [2, 0.6, 0.5, 0.5, 0.7, 0.8]]
+  box_nms(x, overlap_thresh=0.1, coord_start=2, score_index=1, id_index=0,
+      force_suppress=True) = [[2, 0.6, 0.5, 0.5, 0.7, 0.8], [0, 0.5, 0.1, 0.1, 0.2, 0.2],
+                              [-1, -1, -1, -1, -1, -1], [-1, -1, -1, -1, -1, -1]]
+
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<BoxNMSParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", BoxNMSShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", BoxNMSForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "The input boxes")
+.add_arguments(BoxNMSParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bounding_box.cu
+ * \brief non-maximum suppression of boxes, gpu kernels
+ */
+#include "./bounding_box-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace box_nms {
+/*! \brief boxes of a block of the suppression mask, one bit of a word each */
+const int kBlockBoxes = 64;
+/*! \brief threads of the scan of the mask of an image */
+const int kScanThreads = 32;
+}  // namespace box_nms
+
+/*!
+ * \brief bit j of word c of row i of the mask of an image is set when the
+ *  box i suppresses the box 64 * c + j, which comes after it. The blocks
+ *  below the diagonal are never read and are skipped.
+ */
+template<typename DType>
+__global__ void BoxNMSMaskKernel(const BoxNMSLayout layout, const DType *boxes,
+                                 const int *num_valid, const float thresh,
+                                 const int image_begin, uint64_t *mask) {
+  using box_nms::kBlockBoxes;
+  const int image = image_begin + blockIdx.z;
+  const int row_block = blockIdx.y;
+  const int col_block = blockIdx.x;
+  const int n = num_valid[image];
+  const int row_start = row_block * kBlockBoxes;
+  const int col_start = col_block * kBlockBoxes;
+  if (col_block < row_block || row_start >= n || col_start >= n) return;
+  const int row_size = min(n - row_start, kBlockBoxes);
+  const int col_size = min(n - col_start, kBlockBoxes);
+  const DType *image_boxes = boxes + static_cast<size_t>(image) * layout.num * layout.stride;
+
+  __shared__ float block_boxes[kBlockBoxes * 5];
+  if (threadIdx.x < col_size) {
+    const DType *box = image_boxes + static_cast<size_t>(col_start + threadIdx.x) * layout.stride;
+    for (int k = 0; k < 4; ++k) {
+      block_boxes[threadIdx.x * 5 + k] = static_cast<float>(box[layout.coord + k]);
+    }
+    block_boxes[threadIdx.x * 5 + 4] = layout.id >= 0 ? static_cast<float>(box[layout.id]) : 0.f;
+  }
+  __syncthreads();
+
+  if (threadIdx.x < row_size) {
+    const int i = row_start + threadIdx.x;
+    const DType *box = image_boxes + static_cast<size_t>(i) * layout.stride;
+    float cur_box[4];
+    for (int k = 0; k < 4; ++k) cur_box[k] = static_cast<float>(box[layout.coord + k]);
+    const float cur_id = layout.id >= 0 ? static_cast<float>(box[layout.id]) : 0.f;
+    uint64_t bits = 0;
+    for (int j = row_block == col_block ? threadIdx.x + 1 : 0; j < col_size; ++j) {
+      if (block_boxes[j * 5 + 4] == cur_id &&
+          BoxIoU(cur_box, block_boxes + j * 5, layout.offset) > thresh) {
+        bits |= 1ULL << j;
+      }
+    }
+    const int col_blocks = (layout.num + kBlockBoxes - 1) / kBlockBoxes;
+    mask[(static_cast<size_t>(blockIdx.z) * layout.num + i) * col_blocks + col_block] = bits;
+  }
+}
+
+/*!
+ * \brief keep the boxes of an image in order unless a kept box suppresses
+ *  them. The threads share the bits of the suppressed boxes in shared
+ *  memory and merge the row of every kept box: the bit of a box is only set
+ *  by the boxes before it, so they all take the same decisions.
+ */
+__global__ void BoxNMSScanKernel(const int num, const int *num_valid, const int max_keep,
+                                 const int image_begin, const uint64_t *mask,
+                                 int *keep, int *num_keep) {
+  using box_nms::kBlockBoxes;
+  extern __shared__ uint64_t removed[];
+  const int image = image_begin + blockIdx.x;
+  const int n = num_valid[image];
+  const int col_blocks = (num + kBlockBoxes - 1) / kBlockBoxes;
+  const int valid_blocks = (n + kBlockBoxes - 1) / kBlockBoxes;
+  const uint64_t *image_mask = mask + static_cast<size_t>(blockIdx.x) * num * col_blocks;
+  int *image_keep = keep + static_cast<size_t>(image) * num;
+  for (int c = threadIdx.x; c < valid_blocks; c += blockDim.x) removed[c] = 0;
+  __syncthreads();
+  int count = 0;
+  for (int i = 0; i < n && count < max_keep; ++i) {
+    const int block = i / kBlockBoxes;
+    if (removed[block] & (1ULL << (i % kBlockBoxes))) continue;
+    if (threadIdx.x == 0) image_keep[count] = i;
+    ++count;
+    const uint64_t *row = image_mask + static_cast<size_t>(i) * col_blocks;
+    for (int c = block + threadIdx.x; c < valid_blocks; c += blockDim.x) removed[c] |= row[c];
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) num_keep[image] = count;
+}
+
+template<typename DType>
+void BoxNMS(mshadow::Stream<gpu> *s, const BoxNMSLayout &layout, const DType *boxes,
+            const int *num_valid, float thresh, int max_keep,
+            int *keep, int *num_keep, uint64_t *mask) {
+  using box_nms::kBlockBoxes;
+  using box_nms::kScanThreads;
+  if (layout.batch == 0 || layout.num == 0) return;
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  const int col_blocks = (layout.num + kBlockBoxes - 1) / kBlockBoxes;
+  const int chunk = BoxNMSMaskImages(layout.batch, layout.num);
+  CHECK_LE(col_blocks * sizeof(uint64_t), 48U << 10)
+      << "non-maximum suppression supports at most " << (48 << 10) / sizeof(uint64_t) * 64
+      << " boxes per image on gpu, got " << layout.num;
+  for (int begin = 0; begin < layout.batch; begin += chunk) {
+    const int images = std::min(chunk, layout.batch - begin);
+    dim3 grid(col_blocks, col_blocks, images);
+    BoxNMSMaskKernel<<<grid, kBlockBoxes, 0, stream>>>(
+        layout, boxes, num_valid, thresh, begin, mask);
+    BoxNMSScanKernel<<<images, kScanThreads, col_blocks * sizeof(uint64_t), stream>>>(
+        layout.num, num_valid, max_keep, begin, mask, keep, num_keep);
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(BoxNMSScanKernel);
+}
+
+template void BoxNMS<float>(mshadow::Stream<gpu> *s, const BoxNMSLayout &layout,
+                            const float *boxes, const int *num_valid, float thresh,
+                            int max_keep, int *keep, int *num_keep, uint64_t *mask);
+template void BoxNMS<double>(mshadow::Stream<gpu> *s, const BoxNMSLayout &layout,
+                             const double *boxes, const int *num_valid, float thresh,
+                             int max_keep, int *keep, int *num_keep, uint64_t *mask);
+template void BoxNMS<mshadow::half::half_t>(mshadow::Stream<gpu> *s, const BoxNMSLayout &layout,
+                                            const mshadow::half::half_t *boxes,
+                                            const int *num_valid, float thresh, int max_keep,
+                                            int *keep, int *num_keep, uint64_t *mask);
+
+NNVM_REGISTER_OP(_contrib_box_nms)
+.set_attr<FCompute>("FCompute<gpu>", BoxNMSForward<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
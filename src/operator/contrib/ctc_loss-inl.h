@@ -55,6 +55,16 @@ enum CTCLossOpOutputs { kOut, kGrad };
 enum CTCLossOpForwardResource { kTempSpace };
 }
 
+// The cpu workspace of one utterance, for the longest labels and data of the
+// minibatch: the log-softmax of its activations, its alphas, two columns of
+// betas, the occupancy of the alphabet at one step and its labels with blanks.
+template <typename T>
+inline size_t ctc_cpu_utterance_bytes(int maxL, int maxT, int alphabet_size) {
+  const size_t S = 2 * maxL + 1;
+  return sizeof(T) * (alphabet_size * maxT + S * maxT + 2 * S + alphabet_size) +
+         sizeof(int) * S;
+}
+
 template <typename T>
 inline void get_workspace_size(std::vector<int> *label_lengths,
                                std::vector<int> *data_lengths,
@@ -103,29 +113,7 @@ inline void get_workspace_size(std::vector<int> *label_lengths,
     *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
 
   } else {
-    // cpu can eventually replace all minibatch with
-    // max number of concurrent threads if memory is
-    // really tight
-
-    // per minibatch memory
-    size_t per_minibatch_bytes = 0;
-
-    // output
-    per_minibatch_bytes += sizeof(T) * alphabet_size;
-
-    // alphas
-    per_minibatch_bytes += sizeof(T) * S * maxT;
-
-    // betas
-    per_minibatch_bytes += sizeof(T) * S;
-
-    // labels w/blanks, e_inc, s_inc
-    per_minibatch_bytes += 3 * sizeof(int) * S;
-
-    *size_bytes = per_minibatch_bytes * minibatch;
-
-    // probs
-    *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
+    *size_bytes = ctc_cpu_utterance_bytes<T>(maxL, maxT, alphabet_size) * minibatch;
   }
 }
 
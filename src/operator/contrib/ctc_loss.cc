@@ -24,25 +24,160 @@
 */
 
 #include "./ctc_loss-inl.h"
-#include "./ctc_include/detail/cpu_ctc.h"
+#include "./ctc_include/detail/ctc_helper.h"
+#include "../../engine/openmp.h"
 
 namespace mshadow {
+namespace ctc_cpu {
+
+template <typename DType>
+inline DType LogAdd(DType a, DType b) {
+  if (a == ctc_helper::neg_inf<DType>()) return b;
+  if (b == ctc_helper::neg_inf<DType>()) return a;
+  return std::max(a, b) + std::log1p(std::exp(-std::abs(a - b)));
+}
+
+// The loss of one utterance of T steps and L labels, and when grad is not
+// null its gradient with respect to the activations, before the softmax.
+// The log-softmax of every step is computed once, here, next to the
+// recursions which use it, instead of materializing the probabilities of
+// the whole minibatch first and taking their logarithms in the recursions.
+// The gradient of the steps from T to num_steps is zero, and so are the loss and the
+// gradient of an utterance too short for its labels.
+template <typename DType>
+DType UtteranceCost(const DType *act, DType *grad, const int *labels,
+                    int T, int L, int num_steps, int stride, int alphabet_size,
+                    int blank_label, int max_T, int max_S, void *workspace) {
+  const int A = alphabet_size;
+  const int S = 2 * L + 1;
+  const DType neg_inf = ctc_helper::neg_inf<DType>();
+  DType *logp = static_cast<DType *>(workspace);
+  DType *alphas = logp + A * max_T;
+  DType *betas = alphas + max_S * max_T;
+  DType *occupancy = betas + 2 * max_S;
+  int *ext = reinterpret_cast<int *>(occupancy + A);
+
+  if (grad != nullptr) {
+    for (int t = T; t < num_steps; ++t) {
+      std::fill(grad + t * stride, grad + t * stride + A, DType(0));
+    }
+  }
+  int repeats = 0;
+  for (int i = 1; i < L; ++i) repeats += labels[i] == labels[i - 1];
+  if (T == 0 || L + repeats > T) {
+    if (grad != nullptr) {
+      for (int t = 0; t < T; ++t) {
+        std::fill(grad + t * stride, grad + t * stride + A, DType(0));
+      }
+    }
+    return DType(0);
+  }
+
+  for (int t = 0; t < T; ++t) {
+    const DType *x = act + t * stride;
+    DType *y = logp + t * A;
+    DType m = x[0];
+    for (int k = 1; k < A; ++k) m = std::max(m, x[k]);
+    DType sum = 0;
+    for (int k = 0; k < A; ++k) sum += std::exp(x[k] - m);
+    const DType lse = m + std::log(sum);
+    for (int k = 0; k < A; ++k) y[k] = x[k] - lse;
+  }
+  for (int s = 0; s < S; ++s) {
+    ext[s] = s % 2 ? labels[s / 2] : blank_label;
+  }
+
+  // alphas, the log probability of the prefixes ending at s at step t
+  std::fill(alphas, alphas + S * T, neg_inf);
+  alphas[0] = logp[ext[0]];
+  if (S > 1) alphas[1] = logp[ext[1]];
+  for (int t = 1; t < T; ++t) {
+    const DType *prev = alphas + (t - 1) * S;
+    DType *cur = alphas + t * S;
+    const DType *lp = logp + t * A;
+    // the states before lo cannot finish the labels in the steps left
+    const int lo = std::max(0, S - 2 * (T - t));
+    const int hi = std::min(S, 2 * (t + 1));
+    for (int s = lo; s < hi; ++s) {
+      DType a = prev[s];
+      if (s > 0) a = LogAdd(a, prev[s - 1]);
+      if (s > 1 && ext[s] != blank_label && ext[s] != ext[s - 2]) {
+        a = LogAdd(a, prev[s - 2]);
+      }
+      cur[s] = a + lp[ext[s]];
+    }
+  }
+  const DType *last = alphas + (T - 1) * S;
+  const DType log_z = S > 1 ? LogAdd(last[S - 1], last[S - 2]) : last[0];
+  if (grad == nullptr) return -log_z;
+
+  // betas, the log probability of the suffixes after step t from s, the
+  // emission of step t excluded, kept for two steps only
+  DType *beta = betas, *next = betas + max_S;
+  std::fill(beta, beta + S, neg_inf);
+  beta[S - 1] = 0;
+  if (S > 1) beta[S - 2] = 0;
+  for (int t = T - 1; t >= 0; --t) {
+    if (t < T - 1) {
+      std::swap(beta, next);
+      const DType *lp = logp + (t + 1) * A;
+      for (int s = 0; s < S; ++s) {
+        DType b = next[s] + lp[ext[s]];
+        if (s + 1 < S) b = LogAdd(b, next[s + 1] + lp[ext[s + 1]]);
+        if (s + 2 < S && ext[s + 2] != blank_label && ext[s + 2] != ext[s]) {
+          b = LogAdd(b, next[s + 2] + lp[ext[s + 2]]);
+        }
+        beta[s] = b;
+      }
+    }
+    const DType *alpha = alphas + t * S;
+    std::fill(occupancy, occupancy + A, neg_inf);
+    for (int s = 0; s < S; ++s) {
+      occupancy[ext[s]] = LogAdd(occupancy[ext[s]], alpha[s] + beta[s]);
+    }
+    const DType *lp = logp + t * A;
+    DType *g = grad + t * stride;
+    for (int k = 0; k < A; ++k) {
+      g[k] = std::exp(lp[k]) - std::exp(occupancy[k] - log_z);
+    }
+  }
+  return -log_z;
+}
+
+}  // namespace ctc_cpu
 
 template <typename DType>
 ctcStatus_t compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
                              DType *costs, DType *grads, int *labels,
                              int *label_lengths, int *data_lengths,
                              void *workspace, int train) {
-  int minibatch = static_cast<int>(activations.size(1));
-  int alphabet_size = static_cast<int>(activations.size(2));
-  int blank_label = 0;
-  mxnet_warpctc::CpuCTC<DType> ctc(alphabet_size, minibatch, workspace, blank_label);
-  if (train)
-    return ctc.cost_and_grad(activations.dptr_, grads, costs, labels,
-                             label_lengths, data_lengths);
-  else
-    return ctc.score_forward(activations.dptr_, costs, labels, label_lengths,
-                             data_lengths);
+  const int max_T = static_cast<int>(activations.size(0));
+  const int minibatch = static_cast<int>(activations.size(1));
+  const int alphabet_size = static_cast<int>(activations.size(2));
+  const int blank_label = 0;
+  const int stride = minibatch * alphabet_size;
+  // the workspace is laid out as in get_workspace_size
+  const int max_L = *std::max_element(label_lengths, label_lengths + minibatch);
+  const int max_data = *std::max_element(data_lengths, data_lengths + minibatch);
+  CHECK_LE(max_data, max_T) << "The data lengths cannot exceed the sequence length.";
+  const size_t utterance_bytes =
+      mxnet::op::ctc_cpu_utterance_bytes<DType>(max_L, max_data, alphabet_size);
+  std::vector<int> label_offsets(minibatch + 1, 0);
+  for (int mb = 0; mb < minibatch; ++mb) {
+    label_offsets[mb + 1] = label_offsets[mb] + label_lengths[mb];
+  }
+  // the utterances differ in length, hence the dynamic schedule
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads) schedule(dynamic)
+  for (int mb = 0; mb < minibatch; ++mb) {
+    costs[mb] = ctc_cpu::UtteranceCost(
+        activations.dptr_ + mb * alphabet_size,
+        train ? grads + mb * alphabet_size : nullptr,
+        labels + label_offsets[mb], data_lengths[mb], label_lengths[mb],
+        max_T, stride, alphabet_size, blank_label, max_data, 2 * max_L + 1,
+        static_cast<char *>(workspace) + mb * utterance_bytes);
+  }
+  return CTC_STATUS_SUCCESS;
 }
 
 }  // namespace mshadow
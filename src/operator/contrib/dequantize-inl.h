@@ -30,6 +30,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
+#include "./quantization_utils.h"
 
 namespace mxnet {
 namespace op {
@@ -54,6 +55,14 @@ struct dequantize {
   }
 };
 
+struct dequantize_symmetric {
+  template<typename SrcDType>
+  MSHADOW_XINLINE static void Map(int i, float *out, const SrcDType *in,
+                                  const float *imin_range, const float *imax_range) {
+    out[i] = QuantizedToFloat(in[i], MaxAbs(*imin_range, *imax_range));
+  }
+};
+
 template<typename xpu>
 void DequantizeCompute(const nnvm::NodeAttrs& attrs,
                      const OpContext& ctx,
@@ -65,7 +74,16 @@ void DequantizeCompute(const nnvm::NodeAttrs& attrs,
   Stream<xpu> *s = ctx.get_stream<xpu>();
 
   const DequantizeParam& param = nnvm::get<DequantizeParam>(attrs.parsed);
-  // for now, only supports dequantize from float to uint8
+  if (inputs[0].type_flag_ == mshadow::kInt8) {
+    Kernel<dequantize_symmetric, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<float>(),
+      inputs[0].dptr<int8_t>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+    return;
+  } else if (inputs[0].type_flag_ == mshadow::kInt32) {
+    Kernel<dequantize_symmetric, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<float>(),
+      inputs[0].dptr<int32_t>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+    return;
+  }
+  // the uint8 values are mapped linearly to [min_range, max_range]
   typedef float   DstDType;
   typedef uint8_t SrcDType;
   double min_limit = static_cast<double>(std::numeric_limits<SrcDType>::min());
@@ -101,8 +119,9 @@ inline bool DequantizeType(const nnvm::NodeAttrs& attrs,
   const DequantizeParam& param = nnvm::get<DequantizeParam>(attrs.parsed);
   CHECK_EQ(in_attrs->size(), 3U);
   CHECK_EQ(out_attrs->size(), 1U);
-  CHECK_EQ((*in_attrs)[0], mshadow::kUint8)
-    << "`dequantize` only supports uint8 input for now";
+  CHECK((*in_attrs)[0] == mshadow::kUint8 || (*in_attrs)[0] == mshadow::kInt8 ||
+        (*in_attrs)[0] == mshadow::kInt32)
+    << "`dequantize` only supports uint8, int8 and int32 input for now";
   CHECK_EQ((*in_attrs)[1], mshadow::kFloat32)
     << "the second input of `dequantize` should be a tensor with type of float";
   CHECK_EQ((*in_attrs)[2], mshadow::kFloat32)
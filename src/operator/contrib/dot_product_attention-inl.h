@@ -0,0 +1,338 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dot_product_attention-inl.h
+ * \brief fused scaled dot product attention with an online softmax
+ *
+ *  out[n, t] = sum_s softmax_s(scale * q[n, t] . k[n, s]) * v[n, s] over the
+ *  keys s a query row t may attend to. The scores are reduced key by key with
+ *  a running maximum and sum, so only the log of the sum of the exponentials
+ *  of every query row is kept for the backward, which computes the scores
+ *  again. The memory is linear in the sequence lengths.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_DOT_PRODUCT_ATTENTION_INL_H_
+#define MXNET_OPERATOR_CONTRIB_DOT_PRODUCT_ATTENTION_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+struct DotProductAttentionParam : public dmlc::Parameter<DotProductAttentionParam> {
+  float scale;
+  bool causal;
+  bool use_length;
+  int num_heads;
+  DMLC_DECLARE_PARAMETER(DotProductAttentionParam) {
+    DMLC_DECLARE_FIELD(scale).set_default(0.0f)
+    .describe("Multiplier of the scores, 1 / sqrt(head dimension) when set to 0.");
+    DMLC_DECLARE_FIELD(causal).set_default(false)
+    .describe("Whether query t only attends to the keys up to t.");
+    DMLC_DECLARE_FIELD(use_length).set_default(false)
+    .describe("Whether to take the number of valid keys of every sequence "
+              "from the extra input valid_length, the other keys are masked.");
+    DMLC_DECLARE_FIELD(num_heads).set_default(1).set_lower_bound(1)
+    .describe("Number of heads folded in the first axis as batch * num_heads + head, "
+              "the heads of a sequence share its valid_length.");
+  }
+};
+
+/*! \brief sizes and masks of an attention, passed to the kernels by value */
+struct AttentionGeometry {
+  /*! \brief number of (batch, head) pairs, query rows, keys and dimensions */
+  int N, T, S, D, Dv;
+  int num_heads;
+  bool causal, use_length;
+  float scale;
+
+  AttentionGeometry(const DotProductAttentionParam& param, const TShape& qshape,
+                    const TShape& vshape)
+    : N(qshape[0]), T(qshape[1]), S(vshape[1]), D(qshape[2]), Dv(vshape[2]),
+      num_heads(param.num_heads), causal(param.causal), use_length(param.use_length),
+      scale(param.scale != 0.0f ? param.scale : 1.0f / std::sqrt(static_cast<float>(qshape[2]))) {}
+
+  /*!
+   * \brief end of the keys query row t of n attends to, all the masks keep
+   *  a prefix of the keys
+   */
+  template<typename DType>
+  MSHADOW_XINLINE int KeyEnd(int n, int t, const DType *length) const {
+    int end = S;
+    if (use_length) {
+      const int len = static_cast<int>(length[n / num_heads]);
+      end = len < end ? len : end;
+    }
+    if (causal && t + 1 < end) end = t + 1;
+    return end > 0 ? end : 0;
+  }
+  /*! \brief first query row of n attending to key s, or T if there is none */
+  template<typename DType>
+  MSHADOW_XINLINE int QueryBegin(int n, int s, const DType *length) const {
+    if (use_length && s >= static_cast<int>(length[n / num_heads])) return T;
+    return causal ? (s < T ? s : T) : 0;
+  }
+};
+
+inline bool DotProductAttentionShape(const nnvm::NodeAttrs& attrs,
+                                     std::vector<TShape> *in_attrs,
+                                     std::vector<TShape> *out_attrs) {
+  const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), param.use_length ? 4U : 3U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  const TShape& qshape = (*in_attrs)[0];
+  const TShape& kshape = (*in_attrs)[1];
+  const TShape& vshape = (*in_attrs)[2];
+  if (qshape.ndim() == 0 || kshape.ndim() == 0 || vshape.ndim() == 0) return false;
+  CHECK_EQ(qshape.ndim(), 3U) << "query must be (batch * num_heads, query length, dim)";
+  CHECK_EQ(kshape.ndim(), 3U) << "key must be (batch * num_heads, key length, dim)";
+  CHECK_EQ(vshape.ndim(), 3U) << "value must be (batch * num_heads, key length, value dim)";
+  CHECK_EQ(kshape[0], qshape[0]) << "query and key have different batch sizes";
+  CHECK_EQ(kshape[2], qshape[2]) << "query and key have different dimensions";
+  CHECK_EQ(vshape[0], kshape[0]) << "key and value have different batch sizes";
+  CHECK_EQ(vshape[1], kshape[1]) << "key and value have different lengths";
+  CHECK_EQ(qshape[0] % param.num_heads, 0U) << "batch size is not a multiple of num_heads";
+  if (param.use_length) {
+    SHAPE_ASSIGN_CHECK(*in_attrs, 3, mshadow::Shape1(qshape[0] / param.num_heads));
+  }
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::Shape3(qshape[0], qshape[1], vshape[2]));
+  SHAPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::Shape2(qshape[0], qshape[1]));
+  return true;
+}
+
+/*! \brief the inputs share their type, the log sum of exponentials is float or double */
+inline bool DotProductAttentionType(const nnvm::NodeAttrs& attrs,
+                                    std::vector<int> *in_attrs,
+                                    std::vector<int> *out_attrs) {
+  CHECK_EQ(out_attrs->size(), 2U);
+  std::vector<int> out_type{out_attrs->at(0)};
+  if (!ElemwiseType<-1, 1>(attrs, in_attrs, &out_type)) return false;
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, out_type[0]);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, out_type[0] == mshadow::kFloat64 ?
+                    mshadow::kFloat64 : mshadow::kFloat32);
+  return true;
+}
+
+/*! \brief scores of a query row reduced at once on cpu */
+const int kAttentionCpuKeyTile = 64;
+
+template<typename AccReal, typename DType>
+inline AccReal AttentionDot(const DType *a, const DType *b, int len) {
+  AccReal sum = 0;
+  for (int i = 0; i < len; ++i) sum += static_cast<AccReal>(a[i]) * static_cast<AccReal>(b[i]);
+  return sum;
+}
+
+template<typename DType, typename AccReal>
+inline void DotProductAttentionForward(mshadow::Stream<cpu> *s, const AttentionGeometry& g,
+                                       const DType *query, const DType *key, const DType *value,
+                                       const DType *length, OpReqType req,
+                                       DType *out, AccReal *lse) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    std::vector<AccReal> acc(g.Dv);
+    AccReal scores[kAttentionCpuKeyTile];
+    #pragma omp for
+    for (int i = 0; i < g.N * g.T; ++i) {
+      const int n = i / g.T, t = i % g.T;
+      const DType *q = query + static_cast<size_t>(i) * g.D;
+      const DType *k = key + static_cast<size_t>(n) * g.S * g.D;
+      const DType *v = value + static_cast<size_t>(n) * g.S * g.Dv;
+      const int end = g.KeyEnd(n, t, length);
+      AccReal m = -std::numeric_limits<AccReal>::infinity(), l = 0;
+      std::fill(acc.begin(), acc.end(), AccReal(0));
+      for (int s0 = 0; s0 < end; s0 += kAttentionCpuKeyTile) {
+        const int s1 = std::min(end, s0 + kAttentionCpuKeyTile);
+        AccReal tile_max = m;
+        for (int s = s0; s < s1; ++s) {
+          scores[s - s0] = g.scale * AttentionDot<AccReal>(q, k + static_cast<size_t>(s) * g.D, g.D);
+          tile_max = std::max(tile_max, scores[s - s0]);
+        }
+        // rescale what was summed relative to the previous maximum
+        const AccReal alpha = std::exp(m - tile_max);
+        l *= alpha;
+        for (int d = 0; d < g.Dv; ++d) acc[d] *= alpha;
+        for (int s = s0; s < s1; ++s) {
+          const AccReal p = std::exp(scores[s - s0] - tile_max);
+          const DType *vs = v + static_cast<size_t>(s) * g.Dv;
+          l += p;
+          for (int d = 0; d < g.Dv; ++d) acc[d] += p * static_cast<AccReal>(vs[d]);
+        }
+        m = tile_max;
+      }
+      DType *o = out + static_cast<size_t>(i) * g.Dv;
+      const AccReal rl = l > 0 ? AccReal(1) / l : AccReal(0);
+      for (int d = 0; d < g.Dv; ++d) KERNEL_ASSIGN(o[d], req, DType(acc[d] * rl));
+      lse[i] = l > 0 ? m + std::log(l) : AccReal(0);
+    }
+  }
+}
+
+/*!
+ * \brief cpu backward, in two passes parallel over the query rows and over
+ *  the keys so that no gradient is shared by two threads. With
+ *  p = exp(score - lse) and ds = p * (ograd . v - ograd . out), the first
+ *  pass sums dq = scale * ds * k over the keys of every query row and keeps
+ *  ograd . out in delta, the second sums dk = scale * ds * q and
+ *  dv = p * ograd over the query rows of every key.
+ */
+template<typename DType, typename AccReal>
+inline void DotProductAttentionBackward(mshadow::Stream<cpu> *s, const AttentionGeometry& g,
+                                        const DType *ograd, const DType *query,
+                                        const DType *key, const DType *value,
+                                        const DType *length, const DType *out,
+                                        const AccReal *lse, AccReal *delta,
+                                        const std::vector<OpReqType>& req,
+                                        DType *qgrad, DType *kgrad, DType *vgrad) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    std::vector<AccReal> acc(std::max(g.D, g.Dv)), acc_v(g.Dv);
+    #pragma omp for
+    for (int i = 0; i < g.N * g.T; ++i) {
+      const int n = i / g.T, t = i % g.T;
+      const DType *q = query + static_cast<size_t>(i) * g.D;
+      const DType *k = key + static_cast<size_t>(n) * g.S * g.D;
+      const DType *v = value + static_cast<size_t>(n) * g.S * g.Dv;
+      const DType *dout = ograd + static_cast<size_t>(i) * g.Dv;
+      const AccReal dt = AttentionDot<AccReal>(dout, out + static_cast<size_t>(i) * g.Dv, g.Dv);
+      delta[i] = dt;
+      const int end = g.KeyEnd(n, t, length);
+      std::fill(acc.begin(), acc.begin() + g.D, AccReal(0));
+      for (int j = 0; j < end; ++j) {
+        const DType *kj = k + static_cast<size_t>(j) * g.D;
+        const AccReal p = std::exp(g.scale * AttentionDot<AccReal>(q, kj, g.D) - lse[i]);
+        const AccReal ds = p * (AttentionDot<AccReal>(dout, v + static_cast<size_t>(j) * g.Dv,
+                                                      g.Dv) - dt);
+        for (int d = 0; d < g.D; ++d) acc[d] += ds * static_cast<AccReal>(kj[d]);
+      }
+      DType *dq = qgrad + static_cast<size_t>(i) * g.D;
+      for (int d = 0; d < g.D; ++d) KERNEL_ASSIGN(dq[d], req[0], DType(g.scale * acc[d]));
+    }
+    #pragma omp for
+    for (int i = 0; i < g.N * g.S; ++i) {
+      const int n = i / g.S, j = i % g.S;
+      const DType *kj = key + static_cast<size_t>(i) * g.D;
+      const DType *vj = value + static_cast<size_t>(i) * g.Dv;
+      std::fill(acc.begin(), acc.begin() + g.D, AccReal(0));
+      std::fill(acc_v.begin(), acc_v.end(), AccReal(0));
+      for (int t = g.QueryBegin(n, j, length); t < g.T; ++t) {
+        const size_t row = static_cast<size_t>(n) * g.T + t;
+        const DType *q = query + row * g.D;
+        const DType *dout = ograd + row * g.Dv;
+        const AccReal p = std::exp(g.scale * AttentionDot<AccReal>(q, kj, g.D) - lse[row]);
+        const AccReal ds = p * (AttentionDot<AccReal>(dout, vj, g.Dv) - delta[row]);
+        for (int d = 0; d < g.D; ++d) acc[d] += ds * static_cast<AccReal>(q[d]);
+        for (int d = 0; d < g.Dv; ++d) acc_v[d] += p * static_cast<AccReal>(dout[d]);
+      }
+      DType *dk = kgrad + static_cast<size_t>(i) * g.D;
+      DType *dv = vgrad + static_cast<size_t>(i) * g.Dv;
+      for (int d = 0; d < g.D; ++d) KERNEL_ASSIGN(dk[d], req[1], DType(g.scale * acc[d]));
+      for (int d = 0; d < g.Dv; ++d) KERNEL_ASSIGN(dv[d], req[2], DType(acc_v[d]));
+    }
+  }
+}
+
+template<typename DType, typename AccReal>
+void DotProductAttentionForward(mshadow::Stream<gpu> *s, const AttentionGeometry& g,
+                                const DType *query, const DType *key, const DType *value,
+                                const DType *length, OpReqType req,
+                                DType *out, AccReal *lse);
+
+template<typename DType, typename AccReal>
+void DotProductAttentionBackward(mshadow::Stream<gpu> *s, const AttentionGeometry& g,
+                                 const DType *ograd, const DType *query,
+                                 const DType *key, const DType *value,
+                                 const DType *length, const DType *out,
+                                 const AccReal *lse, AccReal *delta,
+                                 const std::vector<OpReqType>& req,
+                                 DType *qgrad, DType *kgrad, DType *vgrad);
+
+template<typename xpu>
+void DotProductAttentionCompute(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<TBlob>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<TBlob>& outputs) {
+  const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK_NE(req[1], kAddTo) << "the log sum of exponentials cannot be added to";
+  const AttentionGeometry g(param, inputs[0].shape_, inputs[2].shape_);
+  if (g.N == 0 || g.T == 0) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[0].type_flag_, DType, AccReal, {
+    const DType *length = param.use_length ? inputs[3].dptr<DType>() : nullptr;
+    DotProductAttentionForward(s, g, inputs[0].dptr<DType>(), inputs[1].dptr<DType>(),
+                               inputs[2].dptr<DType>(), length, req[0],
+                               outputs[0].dptr<DType>(), outputs[1].dptr<AccReal>());
+  });
+}
+
+/*!
+ * \brief inputs are the gradient of the output, query, key, value, the
+ *  valid_length when use_length is set, the output and its log sums of
+ *  exponentials. valid_length gets no gradient.
+ */
+template<typename xpu>
+void DotProductAttentionGradCompute(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+  const size_t num_args = param.use_length ? 4U : 3U;
+  CHECK_EQ(inputs.size(), num_args + 3U);
+  CHECK_EQ(outputs.size(), num_args);
+  const TBlob& out = inputs[num_args + 1];
+  const TBlob& lse = inputs[num_args + 2];
+  const AttentionGeometry g(param, inputs[1].shape_, inputs[3].shape_);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[1].type_flag_, DType, AccReal, {
+    if (param.use_length && req[3] != kNullOp && req[3] != kAddTo) {
+      Kernel<set_zero, xpu>::Launch(s, outputs[3].Size(), outputs[3].dptr<DType>());
+    }
+    if (g.N == 0 || (g.T == 0 && g.S == 0)) return;
+    mshadow::Tensor<xpu, 1, AccReal> delta = ctx.requested[0].get_space_typed<xpu, 1, AccReal>(
+        mshadow::Shape1(std::max(g.N * g.T, 1)), s);
+    const DType *length = param.use_length ? inputs[4].dptr<DType>() : nullptr;
+    DotProductAttentionBackward(s, g, inputs[0].dptr<DType>(), inputs[1].dptr<DType>(),
+                                inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), length,
+                                out.dptr<DType>(), lse.dptr<AccReal>(), delta.dptr_, req,
+                                outputs[0].dptr<DType>(), outputs[1].dptr<DType>(),
+                                outputs[2].dptr<DType>());
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_DOT_PRODUCT_ATTENTION_INL_H_
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dot_product_attention.cc
+ * \brief fused scaled dot product attention
+ */
+#include "./dot_product_attention-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(DotProductAttentionParam);
+
+NNVM_REGISTER_OP(_contrib_dot_product_attention)
+.describe(R"code(Scaled dot product attention with masks, fused in one operator.
+
+`query` is (N, T, D), `key` is (N, S, D) and `value` is (N, S, Dv), where N is
+batch * num_heads. The output is (N, T, Dv) with
+
+`out[n, t] = sum_s softmax_s(scale * dot(query[n, t], key[n, s])) * value[n, s]`
+
+over the keys s that query t attends to: all of them by default, the first
+``valid_length[n / num_heads]`` ones with ``use_length``, and the ones up to
+t with ``causal``.
+
+This replaces ``batch_dot``, scaling, ``SequenceMask``, ``softmax`` and
+another ``batch_dot``. The softmax is computed online over tiles of keys, so
+the (N, T, S) scores are never stored: the backward recomputes them from the
+log of the sum of the exponentials of every query row, and the memory is
+linear in the sequence lengths.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<DotProductAttentionParam>)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+    return param.use_length ? 4 : 3;
+  })
+.set_num_outputs(2)
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+  [](const NodeAttrs& attrs) { return 1; })
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+    std::vector<std::string> names{"query", "key", "value"};
+    if (param.use_length) names.push_back("valid_length");
+    return names;
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "lse"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", DotProductAttentionShape)
+.set_attr<nnvm::FInferType>("FInferType", DotProductAttentionType)
+.set_attr<FCompute>("FCompute<cpu>", DotProductAttentionCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads{ograds[0]};
+    heads.insert(heads.end(), n->inputs.begin(), n->inputs.end());
+    heads.emplace_back(nnvm::NodeEntry{n, 0, 0});
+    heads.emplace_back(nnvm::NodeEntry{n, 1, 0});
+    return MakeGradNode("_backward_contrib_dot_product_attention", n, heads, n->attrs.dict);
+  })
+.add_argument("query", "NDArray-or-Symbol", "Queries of shape (N, T, D)")
+.add_argument("key", "NDArray-or-Symbol", "Keys of shape (N, S, D)")
+.add_argument("value", "NDArray-or-Symbol", "Values of shape (N, S, Dv)")
+.add_argument("valid_length", "NDArray-or-Symbol",
+              "Number of valid keys of every sequence, of shape (N / num_heads,)")
+.add_arguments(DotProductAttentionParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_dot_product_attention)
+.set_attr_parser(ParamParser<DotProductAttentionParam>)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+    return param.use_length ? 7 : 6;
+  })
+.set_num_outputs([](const NodeAttrs& attrs) {
+    const DotProductAttentionParam& param = nnvm::get<DotProductAttentionParam>(attrs.parsed);
+    return param.use_length ? 4 : 3;
+  })
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", DotProductAttentionGradCompute<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,353 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dot_product_attention.cu
+ * \brief fused scaled dot product attention, gpu kernels
+ *
+ *  A block of kRowsPerBlock warps handles as many query rows (forward and
+ *  query gradient) or keys (key and value gradients) of one sequence. The
+ *  blocks walk over tiles of 32 keys or query rows loaded in shared memory,
+ *  lane j scores the row j of the tile, and the scores stay in registers:
+ *  they are broadcast by warp shuffles to the lanes, which own the output
+ *  dimensions d = lane + 32 * i.
+ */
+#include "./dot_product_attention-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace attention {
+const int kWarpSize = 32;
+const int kRowsPerBlock = 4;
+/*! \brief rows of the keys or query rows of a tile, one per lane */
+const int kTile = kWarpSize;
+/*! \brief head dimensions supported on gpu, kept in kMaxHeadDim / 32 registers per lane */
+const int kMaxHeadDim = 128;
+const int kRegs = kMaxHeadDim / kWarpSize;
+const size_t kMaxSharedMemory = 48 * 1024;
+}  // namespace attention
+
+template<typename T>
+__device__ __forceinline__ T AttentionShflXor(T value, int lane_mask) {
+#if CUDA_VERSION >= 9000
+  return __shfl_xor_sync(0xFFFFFFFF, value, lane_mask, attention::kWarpSize);
+#else
+  return __shfl_xor(value, lane_mask, attention::kWarpSize);
+#endif
+}
+
+template<typename T>
+__device__ __forceinline__ T AttentionShfl(T value, int src_lane) {
+#if CUDA_VERSION >= 9000
+  return __shfl_sync(0xFFFFFFFF, value, src_lane, attention::kWarpSize);
+#else
+  return __shfl(value, src_lane, attention::kWarpSize);
+#endif
+}
+
+template<typename T>
+__device__ __forceinline__ T AttentionWarpSum(T value) {
+  for (int mask = attention::kWarpSize / 2; mask > 0; mask >>= 1) {
+    value += AttentionShflXor(value, mask);
+  }
+  return value;
+}
+
+template<typename T>
+__device__ __forceinline__ T AttentionWarpMax(T value) {
+  for (int mask = attention::kWarpSize / 2; mask > 0; mask >>= 1) {
+    value = max(value, AttentionShflXor(value, mask));
+  }
+  return value;
+}
+
+/*!
+ * \brief load rows [r0, r0 + kTile) of a (rows, dim) matrix in a tile with
+ *  rows of stride dim + 1, so that the lanes reading a row each hit distinct
+ *  banks, and the rows from end on as zeros
+ */
+template<typename DType, typename AccReal>
+__device__ __forceinline__ void AttentionLoadTile(const DType *src, int r0, int end, int dim,
+                                                  AccReal *tile) {
+  for (int i = threadIdx.x; i < attention::kTile * dim; i += blockDim.x) {
+    const int j = i / dim, d = i % dim;
+    tile[j * (dim + 1) + d] = r0 + j < end ?
+        static_cast<AccReal>(src[static_cast<size_t>(r0 + j) * dim + d]) : AccReal(0);
+  }
+}
+
+/*! \brief load the row of a warp in shared memory, zeros when the row is out of range */
+template<typename DType, typename AccReal>
+__device__ __forceinline__ void AttentionLoadRow(const DType *src, bool valid, int dim,
+                                                 AccReal *row) {
+  for (int d = threadIdx.x % attention::kWarpSize; d < dim; d += attention::kWarpSize) {
+    row[d] = valid ? static_cast<AccReal>(src[d]) : AccReal(0);
+  }
+}
+
+template<typename AccReal>
+__device__ __forceinline__ AccReal AttentionDotRow(const AccReal *a, const AccReal *b, int dim) {
+  AccReal sum = 0;
+  for (int d = 0; d < dim; ++d) sum += a[d] * b[d];
+  return sum;
+}
+
+template<typename DType, typename AccReal>
+__global__ void DotProductAttentionFwdKernel(const AttentionGeometry g, const DType *query,
+                                             const DType *key, const DType *value,
+                                             const DType *length, const OpReqType req,
+                                             DType *out, AccReal *lse) {
+  using namespace attention;
+  extern __shared__ char attention_smem[];
+  AccReal *k_tile = reinterpret_cast<AccReal*>(attention_smem);
+  AccReal *v_tile = k_tile + kTile * (g.D + 1);
+  AccReal *q_rows = v_tile + kTile * (g.Dv + 1);
+  const int n = blockIdx.y;
+  const int warp = threadIdx.x / kWarpSize, lane = threadIdx.x % kWarpSize;
+  const int t = blockIdx.x * kRowsPerBlock + warp;
+  // the key ends grow with the query rows, the last row of the block has the largest
+  const int block_end = g.KeyEnd(n, min(g.T, (blockIdx.x + 1) * kRowsPerBlock) - 1, length);
+  const int end = t < g.T ? g.KeyEnd(n, t, length) : 0;
+  const size_t row = static_cast<size_t>(n) * g.T + t;
+  AccReal *q = q_rows + warp * g.D;
+  AttentionLoadRow(query + row * g.D, t < g.T, g.D, q);
+  const DType *k = key + static_cast<size_t>(n) * g.S * g.D;
+  const DType *v = value + static_cast<size_t>(n) * g.S * g.Dv;
+  AccReal m = mshadow::red::limits::MinValue<AccReal>(), l = 0;
+  AccReal acc[kRegs];
+  for (int i = 0; i < kRegs; ++i) acc[i] = 0;
+  for (int s0 = 0; s0 < block_end; s0 += kTile) {
+    __syncthreads();
+    AttentionLoadTile(k, s0, block_end, g.D, k_tile);
+    AttentionLoadTile(v, s0, block_end, g.Dv, v_tile);
+    __syncthreads();
+    const bool valid = s0 + lane < end;
+    const AccReal score = valid ?
+        g.scale * AttentionDotRow(q, k_tile + lane * (g.D + 1), g.D) :
+        mshadow::red::limits::MinValue<AccReal>();
+    const AccReal m_new = max(m, AttentionWarpMax(score));
+    const AccReal p = valid ? exp(score - m_new) : AccReal(0);
+    const AccReal alpha = exp(m - m_new);
+    l = l * alpha + AttentionWarpSum(p);
+    for (int i = 0; i < kRegs; ++i) acc[i] *= alpha;
+    const int tile_len = min(kTile, end - s0);
+    for (int j = 0; j < tile_len; ++j) {
+      const AccReal pj = AttentionShfl(p, j);
+      for (int i = 0; i < kRegs; ++i) {
+        const int d = lane + i * kWarpSize;
+        if (d < g.Dv) acc[i] += pj * v_tile[j * (g.Dv + 1) + d];
+      }
+    }
+    m = m_new;
+  }
+  if (t >= g.T) return;
+  const AccReal rl = l > 0 ? AccReal(1) / l : AccReal(0);
+  for (int i = 0; i < kRegs; ++i) {
+    const int d = lane + i * kWarpSize;
+    if (d < g.Dv) KERNEL_ASSIGN(out[row * g.Dv + d], req, DType(acc[i] * rl));
+  }
+  if (lane == 0) lse[row] = l > 0 ? m + log(l) : AccReal(0);
+}
+
+/*! \brief gradient of the query rows, and delta = ograd . out of every row */
+template<typename DType, typename AccReal>
+__global__ void DotProductAttentionBwdQueryKernel(const AttentionGeometry g, const DType *ograd,
+                                                  const DType *query, const DType *key,
+                                                  const DType *value, const DType *length,
+                                                  const DType *out, const AccReal *lse,
+                                                  const OpReqType req, AccReal *delta,
+                                                  DType *qgrad) {
+  using namespace attention;
+  extern __shared__ char attention_smem[];
+  AccReal *k_tile = reinterpret_cast<AccReal*>(attention_smem);
+  AccReal *v_tile = k_tile + kTile * (g.D + 1);
+  AccReal *q_rows = v_tile + kTile * (g.Dv + 1);
+  AccReal *do_rows = q_rows + kRowsPerBlock * g.D;
+  const int n = blockIdx.y;
+  const int warp = threadIdx.x / kWarpSize, lane = threadIdx.x % kWarpSize;
+  const int t = blockIdx.x * kRowsPerBlock + warp;
+  const int block_end = g.KeyEnd(n, min(g.T, (blockIdx.x + 1) * kRowsPerBlock) - 1, length);
+  const int end = t < g.T ? g.KeyEnd(n, t, length) : 0;
+  const size_t row = static_cast<size_t>(n) * g.T + t;
+  AccReal *q = q_rows + warp * g.D;
+  AccReal *dout = do_rows + warp * g.Dv;
+  AttentionLoadRow(query + row * g.D, t < g.T, g.D, q);
+  AttentionLoadRow(ograd + row * g.Dv, t < g.T, g.Dv, dout);
+  AccReal dt = 0;
+  for (int d = lane; d < g.Dv && t < g.T; d += kWarpSize) {
+    dt += dout[d] * static_cast<AccReal>(out[row * g.Dv + d]);
+  }
+  dt = AttentionWarpSum(dt);
+  if (t < g.T && lane == 0) delta[row] = dt;
+  const AccReal lse_t = t < g.T ? lse[row] : AccReal(0);
+  const DType *k = key + static_cast<size_t>(n) * g.S * g.D;
+  const DType *v = value + static_cast<size_t>(n) * g.S * g.Dv;
+  AccReal acc[kRegs];
+  for (int i = 0; i < kRegs; ++i) acc[i] = 0;
+  for (int s0 = 0; s0 < block_end; s0 += kTile) {
+    __syncthreads();
+    AttentionLoadTile(k, s0, block_end, g.D, k_tile);
+    AttentionLoadTile(v, s0, block_end, g.Dv, v_tile);
+    __syncthreads();
+    AccReal ds = 0;
+    if (s0 + lane < end) {
+      const AccReal p = exp(g.scale * AttentionDotRow(q, k_tile + lane * (g.D + 1), g.D) - lse_t);
+      ds = p * (AttentionDotRow(dout, v_tile + lane * (g.Dv + 1), g.Dv) - dt);
+    }
+    const int tile_len = min(kTile, end - s0);
+    for (int j = 0; j < tile_len; ++j) {
+      const AccReal dsj = AttentionShfl(ds, j);
+      for (int i = 0; i < kRegs; ++i) {
+        const int d = lane + i * kWarpSize;
+        if (d < g.D) acc[i] += dsj * k_tile[j * (g.D + 1) + d];
+      }
+    }
+  }
+  if (t >= g.T || req == kNullOp) return;
+  for (int i = 0; i < kRegs; ++i) {
+    const int d = lane + i * kWarpSize;
+    if (d < g.D) KERNEL_ASSIGN(qgrad[row * g.D + d], req, DType(g.scale * acc[i]));
+  }
+}
+
+/*! \brief gradients of the keys and the values, one warp per key */
+template<typename DType, typename AccReal>
+__global__ void DotProductAttentionBwdKeyKernel(const AttentionGeometry g, const DType *ograd,
+                                                const DType *query, const DType *key,
+                                                const DType *value, const DType *length,
+                                                const AccReal *lse, const AccReal *delta,
+                                                const OpReqType kreq, const OpReqType vreq,
+                                                DType *kgrad, DType *vgrad) {
+  using namespace attention;
+  extern __shared__ char attention_smem[];
+  AccReal *q_tile = reinterpret_cast<AccReal*>(attention_smem);
+  AccReal *do_tile = q_tile + kTile * (g.D + 1);
+  AccReal *k_rows = do_tile + kTile * (g.Dv + 1);
+  AccReal *v_rows = k_rows + kRowsPerBlock * g.D;
+  const int n = blockIdx.y;
+  const int warp = threadIdx.x / kWarpSize, lane = threadIdx.x % kWarpSize;
+  const int s = blockIdx.x * kRowsPerBlock + warp;
+  // the first query rows grow with the keys, the first key of the block has the smallest
+  const int block_begin = g.QueryBegin(n, blockIdx.x * kRowsPerBlock, length);
+  const int begin = s < g.S ? g.QueryBegin(n, s, length) : g.T;
+  const size_t krow = static_cast<size_t>(n) * g.S + s;
+  AccReal *kr = k_rows + warp * g.D;
+  AccReal *vr = v_rows + warp * g.Dv;
+  AttentionLoadRow(key + krow * g.D, s < g.S, g.D, kr);
+  AttentionLoadRow(value + krow * g.Dv, s < g.S, g.Dv, vr);
+  const DType *q = query + static_cast<size_t>(n) * g.T * g.D;
+  const DType *dout = ograd + static_cast<size_t>(n) * g.T * g.Dv;
+  AccReal acc_k[kRegs], acc_v[kRegs];
+  for (int i = 0; i < kRegs; ++i) acc_k[i] = acc_v[i] = 0;
+  for (int t0 = block_begin; t0 < g.T; t0 += kTile) {
+    __syncthreads();
+    AttentionLoadTile(q, t0, g.T, g.D, q_tile);
+    AttentionLoadTile(dout, t0, g.T, g.Dv, do_tile);
+    __syncthreads();
+    const int t = t0 + lane;
+    AccReal p = 0, ds = 0;
+    if (t >= begin && t < g.T) {
+      const size_t row = static_cast<size_t>(n) * g.T + t;
+      p = exp(g.scale * AttentionDotRow(kr, q_tile + lane * (g.D + 1), g.D) - lse[row]);
+      ds = p * (AttentionDotRow(vr, do_tile + lane * (g.Dv + 1), g.Dv) - delta[row]);
+    }
+    const int tile_len = min(kTile, g.T - t0);
+    for (int j = 0; j < tile_len; ++j) {
+      const AccReal pj = AttentionShfl(p, j);
+      const AccReal dsj = AttentionShfl(ds, j);
+      for (int i = 0; i < kRegs; ++i) {
+        const int d = lane + i * kWarpSize;
+        if (d < g.D) acc_k[i] += dsj * q_tile[j * (g.D + 1) + d];
+        if (d < g.Dv) acc_v[i] += pj * do_tile[j * (g.Dv + 1) + d];
+      }
+    }
+  }
+  if (s >= g.S) return;
+  for (int i = 0; i < kRegs; ++i) {
+    const int d = lane + i * kWarpSize;
+    if (d < g.D) KERNEL_ASSIGN(kgrad[krow * g.D + d], kreq, DType(g.scale * acc_k[i]));
+    if (d < g.Dv) KERNEL_ASSIGN(vgrad[krow * g.Dv + d], vreq, DType(acc_v[i]));
+  }
+}
+
+/*! \brief shared memory of the kernels: two tiles and the rows of the warps */
+template<typename AccReal>
+inline size_t AttentionSharedMemory(const AttentionGeometry& g) {
+  using namespace attention;
+  CHECK_LE(g.D, kMaxHeadDim) << "dot_product_attention supports head dimensions up to "
+                             << kMaxHeadDim << " on gpu";
+  CHECK_LE(g.Dv, kMaxHeadDim) << "dot_product_attention supports value dimensions up to "
+                              << kMaxHeadDim << " on gpu";
+  const size_t size = (kTile * (g.D + 1) + kTile * (g.Dv + 1) +
+                       kRowsPerBlock * (g.D + g.Dv)) * sizeof(AccReal);
+  CHECK_LE(size, kMaxSharedMemory) << "dot_product_attention: head dimensions too large "
+                                   << "for the shared memory in this precision";
+  return size;
+}
+
+template<typename DType, typename AccReal>
+void DotProductAttentionForward(mshadow::Stream<gpu> *s, const AttentionGeometry& g,
+                                const DType *query, const DType *key, const DType *value,
+                                const DType *length, OpReqType req,
+                                DType *out, AccReal *lse) {
+  using namespace attention;
+  const size_t smem = AttentionSharedMemory<AccReal>(g);
+  const dim3 grid((g.T + kRowsPerBlock - 1) / kRowsPerBlock, g.N);
+  DotProductAttentionFwdKernel<DType, AccReal>
+    <<<grid, kRowsPerBlock * kWarpSize, smem, mshadow::Stream<gpu>::GetStream(s)>>>(
+      g, query, key, value, length, req, out, lse);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(DotProductAttentionFwdKernel);
+}
+
+template<typename DType, typename AccReal>
+void DotProductAttentionBackward(mshadow::Stream<gpu> *s, const AttentionGeometry& g,
+                                 const DType *ograd, const DType *query,
+                                 const DType *key, const DType *value,
+                                 const DType *length, const DType *out,
+                                 const AccReal *lse, AccReal *delta,
+                                 const std::vector<OpReqType>& req,
+                                 DType *qgrad, DType *kgrad, DType *vgrad) {
+  using namespace attention;
+  const size_t smem = AttentionSharedMemory<AccReal>(g);
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  if (g.T > 0) {
+    const dim3 grid((g.T + kRowsPerBlock - 1) / kRowsPerBlock, g.N);
+    DotProductAttentionBwdQueryKernel<DType, AccReal>
+      <<<grid, kRowsPerBlock * kWarpSize, smem, stream>>>(
+        g, ograd, query, key, value, length, out, lse, req[0], delta, qgrad);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(DotProductAttentionBwdQueryKernel);
+  }
+  if (g.S > 0 && (req[1] != kNullOp || req[2] != kNullOp)) {
+    const dim3 grid((g.S + kRowsPerBlock - 1) / kRowsPerBlock, g.N);
+    DotProductAttentionBwdKeyKernel<DType, AccReal>
+      <<<grid, kRowsPerBlock * kWarpSize, smem, stream>>>(
+        g, ograd, query, key, value, length, lse, delta, req[1], req[2], kgrad, vgrad);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(DotProductAttentionBwdKeyKernel);
+  }
+}
+
+NNVM_REGISTER_OP(_contrib_dot_product_attention)
+.set_attr<FCompute>("FCompute<gpu>", DotProductAttentionCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_contrib_dot_product_attention)
+.set_attr<FCompute>("FCompute<gpu>", DotProductAttentionGradCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -27,12 +27,14 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include <iostream>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
+#include "./fft_plan.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -54,14 +56,14 @@ struct FFTParam : public dmlc::Parameter<FFTParam> {
   }
 };
 
-#if MXNET_USE_CUDA
 template<typename xpu, typename DType>
-class FFTOp : public Operator {
+class FFTOp;
+
+template<typename DType>
+class FFTOp<cpu, DType> : public Operator {
  public:
   explicit FFTOp(FFTParam p) {
     this->param_ = p;
-    init_cufft_ = false;
-    dim_ = 0;
   }
 
   virtual void Forward(const OpContext &ctx,
@@ -69,71 +71,105 @@ class FFTOp : public Operator {
                        const std::vector<OpReqType> &req,
                        const std::vector<TBlob> &out_data,
                        const std::vector<TBlob> &aux_args) {
-    using namespace mshadow;
-    using namespace mshadow::expr;
     CHECK_EQ(in_data.size(), 1);
     CHECK_EQ(out_data.size(), 1);
+    if (req[fft::kOutComplex] == kNullOp) return;
+    const TShape& ishape = in_data[fft::kData].shape_;
+    const int n_ffts = ishape.ProdShape(0, ishape.ndim()-1);
+    const CPUFFTPlan& plan = GetPlan(ishape[ishape.ndim()-1]);
+    CPUFFTRows(plan, n_ffts, in_data[fft::kData].dptr<DType>(), false, false,
+               req[fft::kOutComplex], out_data[fft::kOutComplex].dptr<DType>(), true);
+  }
 
-    // the last dimention should be the dimension of fft vector
-    if (!init_cufft_) {
-      n_ffts = in_data[fft::kData].shape_.ProdShape(0, in_data[fft::kData].ndim()-1);
-      dim_ = in_data[fft::kData].shape_[in_data[fft::kData].ndim()-1];
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_args) {
+    CHECK_EQ(out_grad.size(), 1);
+    CHECK(in_data.size() == 1 && in_grad.size() == 1);
+    CHECK_EQ(req.size(), 1);
+    if (req[fft::kData] == kNullOp) return;
+    const TShape& ishape = in_grad[fft::kData].shape_;
+    const int n_ffts = ishape.ProdShape(0, ishape.ndim()-1);
+    const CPUFFTPlan& plan = GetPlan(ishape[ishape.ndim()-1]);
+    // the real part of the inverse transform, not normalized, as on gpu
+    CPUFFTRows(plan, n_ffts, out_grad[fft::kOutComplex].dptr<DType>(), true, true,
+               req[fft::kData], in_grad[fft::kData].dptr<DType>(), false);
+  }
 
-      stride_ = param_.compute_size*dim_;
+ private:
+  const CPUFFTPlan& GetPlan(int dim) {
+    if (plan_ == nullptr || plan_->size() != dim) plan_.reset(new CPUFFTPlan(dim));
+    return *plan_;
+  }
 
-      init_cufft_ = true;
+  FFTParam param_;
+  std::unique_ptr<CPUFFTPlan> plan_;
+};  // class FFTOp<cpu>
 
-      // will handle the (possibly) incomplete group later
-      num_compute = n_ffts / param_.compute_size;
-    }
+#if MXNET_USE_CUDA
+template<typename DType>
+class FFTOp<gpu, DType> : public Operator {
+ public:
+  explicit FFTOp(FFTParam p) {
+    this->param_ = p;
+    n_ffts = -1;
+    dim_ = 0;
+  }
 
+  ~FFTOp() {
+    DestroyPlans();
+  }
 
-    Stream<xpu> *s = ctx.get_stream<xpu>();
-    // const TShape& oshape = out_data[fft::kOutComplex].shape_;
-    const TShape& ishape = in_data[fft::kData].shape_;
-    const TShape& oshape = out_data[fft::kOutComplex].shape_;
-    Tensor<xpu, 2, DType> data = in_data[fft::kData].get_with_shape<xpu, 2, DType>(
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(in_data.size(), 1);
+    CHECK_EQ(out_data.size(), 1);
+
+    Stream<gpu> *s = ctx.get_stream<gpu>();
+    // the last dimention should be the dimension of fft vector
+    SetupPlans(in_data[fft::kData].shape_, s);
+    Tensor<gpu, 2, DType> data = in_data[fft::kData].get_with_shape<gpu, 2, DType>(
           Shape2(n_ffts, dim_), s);
-    Tensor<xpu, 2, DType> out = out_data[fft::kOutComplex].get_with_shape<xpu, 2, DType>(
+    Tensor<gpu, 2, DType> out = out_data[fft::kOutComplex].get_with_shape<gpu, 2, DType>(
           Shape2(n_ffts, dim_*2), s);
 
     // need temp space to pad the data into complex numbers due to cufft interface
-    Tensor<xpu, 1, DType> workspace =
-            ctx.requested[fft::kTempSpace].get_space_typed<xpu, 1, DType>(
+    Tensor<gpu, 1, DType> workspace =
+            ctx.requested[fft::kTempSpace].get_space_typed<gpu, 1, DType>(
                 Shape1(param_.compute_size*dim_*2), s);
-    Tensor<xpu, 2, DType> complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
+    Tensor<gpu, 2, DType> complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
                                               Shape2(param_.compute_size, dim_*2), s);
     // start fft
-    cufftHandle plan;
-    cufftPlanMany(&plan, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0, CUFFT_C2C, param_.compute_size);
-    for (size_t idx=0; idx < num_compute; ++idx) {
+    for (int idx = 0; idx < num_compute; ++idx) {
       complex_data = complex_pad_imag(data.Slice(idx*param_.compute_size,
                                                  idx*param_.compute_size+param_.compute_size));
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(complex_data.dptr_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(out.dptr_ + 2*idx*stride_);
-      CHECK_EQ(cufftExecC2C(plan, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
+      CHECK_EQ(cufftExecC2C(plan_, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
     }
-    cufftDestroy(plan);
 
     // handle the remaining samples
-    size_t remain_num = n_ffts - param_.compute_size*num_compute;
-    if (remain_num > 0) {
-      cufftHandle plan_remain;
-      cufftPlanMany(&plan_remain, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
-                    CUFFT_C2C, remain_num);
-
-      complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
-                                          Shape2(remain_num, dim_*2), s);
+    if (remain_num_ > 0) {
+      complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
+                                          Shape2(remain_num_, dim_*2), s);
       complex_data = complex_pad_imag(data.Slice(
-          num_compute*param_.compute_size, num_compute*param_.compute_size+remain_num));
+          num_compute*param_.compute_size, num_compute*param_.compute_size+remain_num_));
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(complex_data.dptr_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(out.dptr_ + 2*num_compute*stride_);
-      CHECK_EQ(cufftExecC2C(plan_remain, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
-      cufftDestroy(plan_remain);
+      CHECK_EQ(cufftExecC2C(plan_remain_, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
     }
   }
 
@@ -150,56 +186,46 @@ class FFTOp : public Operator {
     CHECK(in_data.size() == 1 && in_grad.size() == 1);
     CHECK_EQ(req.size(), 1);
 
-    Stream<xpu> *s = ctx.get_stream<xpu>();
-
-    const TShape& ishape = in_grad[fft::kData].shape_;
-    const TShape& oshape = out_grad[fft::kOutComplex].shape_;
-    Tensor<xpu, 2, DType> gdata = in_grad[fft::kData].get_with_shape<xpu, 2, DType>(
+    Stream<gpu> *s = ctx.get_stream<gpu>();
+    SetupPlans(in_grad[fft::kData].shape_, s);
+    Tensor<gpu, 2, DType> gdata = in_grad[fft::kData].get_with_shape<gpu, 2, DType>(
           Shape2(n_ffts, dim_), s);
-    Tensor<xpu, 2, DType> grad = out_grad[fft::kOutComplex].get_with_shape<xpu, 2, DType>(
+    Tensor<gpu, 2, DType> grad = out_grad[fft::kOutComplex].get_with_shape<gpu, 2, DType>(
           Shape2(n_ffts, dim_*2), s);
     // need temp space to pad the data into complex numbers due to cufft interface
-    Tensor<xpu, 1, DType> workspace =
-            ctx.requested[fft::kTempSpace].get_space_typed<xpu, 1, DType>(
+    Tensor<gpu, 1, DType> workspace =
+            ctx.requested[fft::kTempSpace].get_space_typed<gpu, 1, DType>(
                 Shape1(param_.compute_size*dim_*2), s);
-    Tensor<xpu, 2, DType> complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
+    Tensor<gpu, 2, DType> complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
                                               Shape2(param_.compute_size, dim_*2), s);
 
     // by default, we think forward is firstly conducted
     // In this solution, out_grad must comes from a fft of real signal,
     // so that it is Hermitian symmetric, giving a real output
     // but if it is not, remember that we have implemented complex_take_real, and use this
-    cufftHandle plan;
-    cufftPlanMany(&plan, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0, CUFFT_C2C, param_.compute_size);
-    for (size_t idx = 0; idx < num_compute; ++idx) {
+    for (int idx = 0; idx < num_compute; ++idx) {
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(grad.dptr_ + 2*idx*stride_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(complex_data.dptr_);
-      CHECK_EQ(cufftExecC2C(plan, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
+      CHECK_EQ(cufftExecC2C(plan_, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
 
       Assign(gdata.Slice(idx*param_.compute_size, (idx+1)*param_.compute_size),
              req[fft::kData], complex_toreal(complex_data));
     }
-    cufftDestroy(plan);
 
     // handle the remaining samples
-    size_t remain_num = n_ffts - param_.compute_size*num_compute;
-    if (remain_num > 0) {
-      cufftHandle plan_remain;
-      cufftPlanMany(&plan_remain, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
-                    CUFFT_C2C, remain_num);
-      complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
-                                              Shape2(remain_num, dim_*2), s);
+    if (remain_num_ > 0) {
+      complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
+                                              Shape2(remain_num_, dim_*2), s);
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(grad.dptr_ + 2*num_compute*stride_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(complex_data.dptr_);
-      CHECK_EQ(cufftExecC2C(plan_remain, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
+      CHECK_EQ(cufftExecC2C(plan_remain_, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
 
       Assign(gdata.Slice(param_.compute_size*num_compute,
-                         param_.compute_size*num_compute+remain_num),
+                         param_.compute_size*num_compute+remain_num_),
              req[fft::kData], complex_toreal(complex_data));
-      cufftDestroy(plan_remain);
     }
     // for bp, we should not divide it
     // but for comparison with np.fft.ifft, we should do it.
@@ -207,10 +233,46 @@ class FFTOp : public Operator {
   }
 
  private:
+  /*!
+   * \brief create the plans of the sub-batches of compute_size and of the
+   *  remaining samples when the shape changes, and bind them to the stream
+   */
+  void SetupPlans(const TShape& shape, mshadow::Stream<gpu> *s) {
+    const int n = shape.ProdShape(0, shape.ndim()-1);
+    const int dim = shape[shape.ndim()-1];
+    if (n != n_ffts || dim != dim_) {
+      DestroyPlans();
+      n_ffts = n;
+      dim_ = dim;
+      stride_ = param_.compute_size*dim_;
+      // will handle the (possibly) incomplete group later
+      num_compute = n_ffts / param_.compute_size;
+      remain_num_ = n_ffts - param_.compute_size*num_compute;
+      if (num_compute > 0) {
+        CHECK_EQ(cufftPlanMany(&plan_, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
+                               CUFFT_C2C, param_.compute_size), CUFFT_SUCCESS);
+      }
+      if (remain_num_ > 0) {
+        CHECK_EQ(cufftPlanMany(&plan_remain_, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
+                               CUFFT_C2C, remain_num_), CUFFT_SUCCESS);
+      }
+    }
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+    if (num_compute > 0) CHECK_EQ(cufftSetStream(plan_, stream), CUFFT_SUCCESS);
+    if (remain_num_ > 0) CHECK_EQ(cufftSetStream(plan_remain_, stream), CUFFT_SUCCESS);
+  }
+
+  void DestroyPlans() {
+    if (n_ffts < 0) return;
+    if (num_compute > 0) cufftDestroy(plan_);
+    if (remain_num_ > 0) cufftDestroy(plan_remain_);
+    n_ffts = -1;
+  }
+
   FFTParam param_;
-  int dim_, stride_, num_compute, n_ffts;
-  bool init_cufft_;
-};  // class FFTOp
+  int dim_, stride_, num_compute, n_ffts, remain_num_;
+  cufftHandle plan_, plan_remain_;
+};  // class FFTOp<gpu>
 #endif  // MXNET_USE_CUDA
 
 // Declare Factory Function, used for dispatch specialization
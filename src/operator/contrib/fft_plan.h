@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fft_plan.h
+ * \brief the cpu FFT of the fft and ifft operators
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
+#define MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
+
+#include <mxnet/base.h>
+#include <mxnet/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "../mxnet_op.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief a complex to complex FFT of length n on cpu. The twiddle factors,
+ *  and for a length which is not a power of 2 the chirp of Bluestein's
+ *  algorithm and its transform, are computed once when the plan is created.
+ */
+class CPUFFTPlan {
+ public:
+  typedef std::complex<double> Complex;
+
+  explicit CPUFFTPlan(int n) : n_(n) {
+    CHECK_GT(n, 0) << "the length of a FFT must be positive";
+    m_ = 1;
+    while (m_ < n) m_ <<= 1;
+    if (m_ != n) {
+      // a power of 2 FFT of size at least 2n - 1 computes the convolution
+      m_ = 1;
+      while (m_ < 2 * n - 1) m_ <<= 1;
+    }
+    const double pi = std::acos(-1.0);
+    twiddle_.resize(m_ / 2);
+    for (int k = 0; k < m_ / 2; ++k) twiddle_[k] = std::polar(1.0, -2 * pi * k / m_);
+    reverse_.resize(m_);
+    int log_m = 0;
+    while ((1 << log_m) < m_) ++log_m;
+    for (int i = 0; i < m_; ++i) {
+      int r = 0;
+      for (int b = 0; b < log_m; ++b) r |= ((i >> b) & 1) << (log_m - 1 - b);
+      reverse_[i] = r;
+    }
+    if (m_ != n_) {
+      // chirp[k] = exp(-i pi k^2 / n), and k^2 is taken modulo 2n for precision
+      chirp_.resize(n_);
+      for (int k = 0; k < n_; ++k) {
+        const int64_t k2 = static_cast<int64_t>(k) * k % (2 * n_);
+        chirp_[k] = std::polar(1.0, -pi * k2 / n_);
+      }
+      kernel_.assign(m_, Complex(0, 0));
+      kernel_[0] = std::conj(chirp_[0]);
+      for (int k = 1; k < n_; ++k) {
+        kernel_[k] = kernel_[m_ - k] = std::conj(chirp_[k]);
+      }
+      Radix2(kernel_.data());
+    }
+  }
+  /*! \brief the length of the transform */
+  int size() const { return n_; }
+  /*! \brief the number of complex numbers of the work space of Execute */
+  int work_size() const { return m_ == n_ ? 0 : m_; }
+  /*!
+   * \brief transform the n complex numbers of data in place, the inverse
+   *  transform being not normalized
+   */
+  void Execute(Complex *data, bool inverse, Complex *work) const {
+    // the inverse transform is the conjugate of the transform of the conjugate
+    if (inverse) {
+      for (int k = 0; k < n_; ++k) data[k] = std::conj(data[k]);
+    }
+    if (m_ == n_) {
+      Radix2(data);
+    } else {
+      for (int k = 0; k < n_; ++k) work[k] = data[k] * chirp_[k];
+      std::fill(work + n_, work + m_, Complex(0, 0));
+      Radix2(work);
+      for (int k = 0; k < m_; ++k) work[k] = std::conj(work[k] * kernel_[k]);
+      Radix2(work);
+      const double scale = 1.0 / m_;
+      for (int k = 0; k < n_; ++k) data[k] = std::conj(work[k]) * scale * chirp_[k];
+    }
+    if (inverse) {
+      for (int k = 0; k < n_; ++k) data[k] = std::conj(data[k]);
+    }
+  }
+
+ private:
+  /*! \brief the iterative radix 2 FFT of size m in place */
+  void Radix2(Complex *a) const {
+    for (int i = 0; i < m_; ++i) {
+      if (i < reverse_[i]) std::swap(a[i], a[reverse_[i]]);
+    }
+    for (int len = 2; len <= m_; len <<= 1) {
+      const int half = len / 2;
+      const int step = m_ / len;
+      for (int i = 0; i < m_; i += len) {
+        for (int k = 0; k < half; ++k) {
+          const Complex u = a[i + k];
+          const Complex v = a[i + k + half] * twiddle_[k * step];
+          a[i + k] = u + v;
+          a[i + k + half] = u - v;
+        }
+      }
+    }
+  }
+
+  int n_, m_;
+  std::vector<Complex> twiddle_;
+  std::vector<int> reverse_;
+  std::vector<Complex> chirp_;
+  std::vector<Complex> kernel_;
+};
+
+/*!
+ * \brief transform the rows of in, of n real numbers or of n interleaved
+ *  complex numbers, into the rows of out, of the real parts of the results
+ *  or of the interleaved complex results, in parallel over the rows
+ */
+template<typename DType>
+inline void CPUFFTRows(const CPUFFTPlan &plan, int rows, const DType *in, bool in_complex,
+                       bool inverse, OpReqType req, DType *out, bool out_complex) {
+  typedef CPUFFTPlan::Complex Complex;
+  const int n = plan.size();
+  const int in_stride = in_complex ? 2 * n : n;
+  const int out_stride = out_complex ? 2 * n : n;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    std::vector<Complex> data(n), work(plan.work_size());
+    #pragma omp for
+    for (int r = 0; r < rows; ++r) {
+      const DType *x = in + static_cast<size_t>(r) * in_stride;
+      for (int k = 0; k < n; ++k) {
+        data[k] = in_complex ? Complex(x[2 * k], x[2 * k + 1]) : Complex(x[k], 0);
+      }
+      plan.Execute(data.data(), inverse, work.data());
+      DType *y = out + static_cast<size_t>(r) * out_stride;
+      for (int k = 0; k < n; ++k) {
+        if (out_complex) {
+          KERNEL_ASSIGN(y[2 * k], req, DType(data[k].real()));
+          KERNEL_ASSIGN(y[2 * k + 1], req, DType(data[k].imag()));
+        } else {
+          KERNEL_ASSIGN(y[k], req, DType(data[k].real()));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
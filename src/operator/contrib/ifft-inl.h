@@ -28,11 +28,13 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
+#include "./fft_plan.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -54,14 +56,14 @@ struct IFFTParam : public dmlc::Parameter<IFFTParam> {
   }
 };
 
-#if MXNET_USE_CUDA
 template<typename xpu, typename DType>
-class IFFTOp : public Operator {
+class IFFTOp;
+
+template<typename DType>
+class IFFTOp<cpu, DType> : public Operator {
  public:
   explicit IFFTOp(IFFTParam p) {
     this->param_ = p;
-    init_cufft_ = false;
-    dim_ = 0;
   }
 
   virtual void Forward(const OpContext &ctx,
@@ -69,71 +71,108 @@ class IFFTOp : public Operator {
                        const std::vector<OpReqType> &req,
                        const std::vector<TBlob> &out_data,
                        const std::vector<TBlob> &aux_args) {
-    using namespace mshadow;
-    using namespace mshadow::expr;
     CHECK_EQ(in_data.size(), 1);
     CHECK_EQ(out_data.size(), 1);
+    if (req[ifft::kOut] == kNullOp) return;
+    const TShape& oshape = out_data[ifft::kOut].shape_;
+    const int n_iffts = oshape.ProdShape(0, oshape.ndim()-1);
+    const CPUFFTPlan& plan = GetPlan(oshape[oshape.ndim()-1]);
+    // not normalized, to be consistant with caffe and the gpu implementation
+    CPUFFTRows(plan, n_iffts, in_data[ifft::kData].dptr<DType>(), true, true,
+               req[ifft::kOut], out_data[ifft::kOut].dptr<DType>(), false);
+  }
 
-    if (!init_cufft_) {
-      n_iffts = in_data[ifft::kData].shape_.ProdShape(0, in_data[ifft::kData].ndim()-1);
-      // remember that input is complex
-      dim_ = in_data[ifft::kData].shape_[in_data[ifft::kData].ndim()-1]/2;
-      // stride_ in the number of complex numbers
-      stride_ = param_.compute_size*dim_;
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_args) {
+    CHECK_EQ(out_grad.size(), 1);
+    CHECK(in_data.size() == 1 && in_grad.size() == 1);
+    CHECK_EQ(req.size(), 1);
+    if (req[ifft::kData] == kNullOp) return;
+    const TShape& oshape = out_grad[ifft::kOut].shape_;
+    const int n_iffts = oshape.ProdShape(0, oshape.ndim()-1);
+    const CPUFFTPlan& plan = GetPlan(oshape[oshape.ndim()-1]);
+    CPUFFTRows(plan, n_iffts, out_grad[ifft::kOut].dptr<DType>(), false, false,
+               req[ifft::kData], in_grad[ifft::kData].dptr<DType>(), true);
+  }
 
-      init_cufft_ = true;
+ private:
+  const CPUFFTPlan& GetPlan(int dim) {
+    if (plan_ == nullptr || plan_->size() != dim) plan_.reset(new CPUFFTPlan(dim));
+    return *plan_;
+  }
 
-      num_compute = n_iffts/param_.compute_size;
-    }
+  IFFTParam param_;
+  std::unique_ptr<CPUFFTPlan> plan_;
+};  // class IFFTOp<cpu>
 
-    Stream<xpu> *s = ctx.get_stream<xpu>();
-    const TShape& ishape = in_data[ifft::kData].shape_;
-    const TShape& oshape = out_data[ifft::kOut].shape_;
-    Tensor<xpu, 2, DType> data = in_data[ifft::kData].get_with_shape<xpu, 2, DType>(
+#if MXNET_USE_CUDA
+template<typename DType>
+class IFFTOp<gpu, DType> : public Operator {
+ public:
+  explicit IFFTOp(IFFTParam p) {
+    this->param_ = p;
+    n_iffts = -1;
+    dim_ = 0;
+  }
+
+  ~IFFTOp() {
+    DestroyPlans();
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(in_data.size(), 1);
+    CHECK_EQ(out_data.size(), 1);
+
+    Stream<gpu> *s = ctx.get_stream<gpu>();
+    SetupPlans(out_data[ifft::kOut].shape_, s);
+    Tensor<gpu, 2, DType> data = in_data[ifft::kData].get_with_shape<gpu, 2, DType>(
           Shape2(n_iffts, dim_*2), s);
-    Tensor<xpu, 2, DType> out = out_data[ifft::kOut].get_with_shape<xpu, 2, DType>(
+    Tensor<gpu, 2, DType> out = out_data[ifft::kOut].get_with_shape<gpu, 2, DType>(
           Shape2(n_iffts, dim_), s);
     // need temp space to store the intermediate complex matrices
-    Tensor<xpu, 1, DType> workspace =
-            ctx.requested[ifft::kTempSpace].get_space_typed<xpu, 1, DType>(
+    Tensor<gpu, 1, DType> workspace =
+            ctx.requested[ifft::kTempSpace].get_space_typed<gpu, 1, DType>(
                 Shape1(param_.compute_size*dim_*2), s);
-    Tensor<xpu, 2, DType> complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
+    Tensor<gpu, 2, DType> complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
                                               Shape2(param_.compute_size, dim_*2), s);
     // start ifft
-    cufftHandle plan;
-    cufftPlanMany(&plan, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0, CUFFT_C2C, param_.compute_size);
-    for (size_t idx=0; idx < num_compute; ++idx) {
+    for (int idx = 0; idx < num_compute; ++idx) {
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(data.dptr_ + 2*idx*stride_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(complex_data.dptr_);
-      CHECK_EQ(cufftExecC2C(plan, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
+      CHECK_EQ(cufftExecC2C(plan_, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
 
       Assign(out.Slice(idx*param_.compute_size, (idx+1)*param_.compute_size),
              req[ifft::kOut], complex_toreal(complex_data));
     }
-    cufftDestroy(plan);
     // handle the remaining samples
-    size_t remain_num = n_iffts - param_.compute_size*num_compute;
-    if (remain_num > 0) {
-      cufftHandle plan_remain;
-      cufftPlanMany(&plan_remain, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
-                    CUFFT_C2C, remain_num);
-
-      complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
-                                              Shape2(remain_num, dim_*2), s);
+    if (remain_num_ > 0) {
+      complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
+                                              Shape2(remain_num_, dim_*2), s);
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(data.dptr_ + 2*num_compute*stride_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(complex_data.dptr_);
-      CHECK_EQ(cufftExecC2C(plan_remain, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
-        Assign(out.Slice(param_.compute_size*num_compute,
-                         param_.compute_size*num_compute+remain_num),
+      CHECK_EQ(cufftExecC2C(plan_remain_, in_tmp, out_tmp, CUFFT_INVERSE), CUFFT_SUCCESS);
+      Assign(out.Slice(param_.compute_size*num_compute,
+                       param_.compute_size*num_compute+remain_num_),
              req[ifft::kOut], complex_toreal(complex_data));
-      cufftDestroy(plan_remain);
     }
     // commenting this out to be consistant with caffe
     // out /= dim_;
   }
+
   virtual void Backward(const OpContext &ctx,
                         const std::vector<TBlob> &out_grad,
                         const std::vector<TBlob> &in_data,
@@ -147,61 +186,86 @@ class IFFTOp : public Operator {
     CHECK(in_data.size() == 1 && in_grad.size() == 1);
     CHECK_EQ(req.size(), 1);
 
-    Stream<xpu> *s = ctx.get_stream<xpu>();
-
-    const TShape& ishape = in_grad[ifft::kData].shape_;
-    const TShape& oshape = out_grad[ifft::kOut].shape_;
-    Tensor<xpu, 2, DType> gdata = in_grad[ifft::kData].get_with_shape<xpu, 2, DType>(
+    Stream<gpu> *s = ctx.get_stream<gpu>();
+    SetupPlans(out_grad[ifft::kOut].shape_, s);
+    Tensor<gpu, 2, DType> gdata = in_grad[ifft::kData].get_with_shape<gpu, 2, DType>(
           Shape2(n_iffts, dim_*2), s);
-    Tensor<xpu, 2, DType> grad = out_grad[ifft::kOut].get_with_shape<xpu, 2, DType>(
+    Tensor<gpu, 2, DType> grad = out_grad[ifft::kOut].get_with_shape<gpu, 2, DType>(
           Shape2(n_iffts, dim_), s);
     // need temp space to pad the data into complex numbers due to cufft interface
-    Tensor<xpu, 1, DType> workspace =
-            ctx.requested[ifft::kTempSpace].get_space_typed<xpu, 1, DType>(
+    Tensor<gpu, 1, DType> workspace =
+            ctx.requested[ifft::kTempSpace].get_space_typed<gpu, 1, DType>(
                 Shape1(param_.compute_size*dim_*2), s);
-    Tensor<xpu, 2, DType> complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
+    Tensor<gpu, 2, DType> complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
                                               Shape2(param_.compute_size, dim_*2), s);
     // start fft
-    cufftHandle plan;
-    cufftPlanMany(&plan, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0, CUFFT_C2C, param_.compute_size);
-    for (size_t idx = 0; idx < num_compute; ++idx) {
+    for (int idx = 0; idx < num_compute; ++idx) {
       complex_data = complex_pad_imag(grad.Slice(idx*param_.compute_size,
                                                  idx*param_.compute_size+param_.compute_size));
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(complex_data.dptr_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(gdata.dptr_ + 2*idx*stride_);
-      CHECK_EQ(cufftExecC2C(plan, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
+      CHECK_EQ(cufftExecC2C(plan_, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
     }
-    cufftDestroy(plan);
 
     // handle the remaining samples
-    size_t remain_num = n_iffts - param_.compute_size*num_compute;
-    if (remain_num > 0) {
-      cufftHandle plan_remain;
-      cufftPlanMany(&plan_remain, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
-                    CUFFT_C2C, remain_num);
-      complex_data = Tensor<xpu, 2, DType>(workspace.dptr_,
-                                          Shape2(remain_num, dim_*2), s);
+    if (remain_num_ > 0) {
+      complex_data = Tensor<gpu, 2, DType>(workspace.dptr_,
+                                          Shape2(remain_num_, dim_*2), s);
       complex_data = complex_pad_imag(grad.Slice(
-          num_compute*param_.compute_size, num_compute*param_.compute_size+remain_num));
+          num_compute*param_.compute_size, num_compute*param_.compute_size+remain_num_));
 
       cufftComplex* in_tmp = const_cast<cufftComplex*>(
         reinterpret_cast<const cufftComplex*>(complex_data.dptr_));
       cufftComplex* out_tmp = reinterpret_cast<cufftComplex*>(gdata.dptr_ + 2*num_compute*stride_);
-      CHECK_EQ(cufftExecC2C(plan_remain, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
-      cufftDestroy(plan_remain);
+      CHECK_EQ(cufftExecC2C(plan_remain_, in_tmp, out_tmp, CUFFT_FORWARD), CUFFT_SUCCESS);
     }
     // commenting this out to be consistant with caffe
     // gdata /= dim_;
   }
 
  private:
-  IFFTParam param_;
-  int dim_, stride_, num_compute, n_iffts;
-  bool init_cufft_;
-};  // class IFFTOp
+  /*!
+   * \brief create the plans of the sub-batches of compute_size and of the
+   *  remaining samples when the shape changes, and bind them to the stream
+   */
+  void SetupPlans(const TShape& oshape, mshadow::Stream<gpu> *s) {
+    const int n = oshape.ProdShape(0, oshape.ndim()-1);
+    const int dim = oshape[oshape.ndim()-1];
+    if (n != n_iffts || dim != dim_) {
+      DestroyPlans();
+      n_iffts = n;
+      dim_ = dim;
+      // stride_ in the number of complex numbers
+      stride_ = param_.compute_size*dim_;
+      num_compute = n_iffts/param_.compute_size;
+      remain_num_ = n_iffts - param_.compute_size*num_compute;
+      if (num_compute > 0) {
+        CHECK_EQ(cufftPlanMany(&plan_, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
+                               CUFFT_C2C, param_.compute_size), CUFFT_SUCCESS);
+      }
+      if (remain_num_ > 0) {
+        CHECK_EQ(cufftPlanMany(&plan_remain_, 1, &dim_, nullptr, 0, 0, nullptr, 0, 0,
+                               CUFFT_C2C, remain_num_), CUFFT_SUCCESS);
+      }
+    }
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+    if (num_compute > 0) CHECK_EQ(cufftSetStream(plan_, stream), CUFFT_SUCCESS);
+    if (remain_num_ > 0) CHECK_EQ(cufftSetStream(plan_remain_, stream), CUFFT_SUCCESS);
+  }
 
+  void DestroyPlans() {
+    if (n_iffts < 0) return;
+    if (num_compute > 0) cufftDestroy(plan_);
+    if (remain_num_ > 0) cufftDestroy(plan_remain_);
+    n_iffts = -1;
+  }
+
+  IFFTParam param_;
+  int dim_, stride_, num_compute, n_iffts, remain_num_;
+  cufftHandle plan_, plan_remain_;
+};  // class IFFTOp<gpu>
 #endif  // MXNET_USE_CUDA
 
 // Declare Factory Function, used for dispatch specialization
@@ -43,8 +43,7 @@
 #include "../operator_common.h"
 #include "../mshadow_op.h"
 #include "./multi_proposal-inl.h"
-
-#define DIVUP(m, n) ((m) / (n) + ((m) % (n) > 0))
+#include "./bounding_box-inl.h"
 
 #define FRCNN_CUDA_CHECK(condition) \
   /* Code block avoids redefinition of cudaError_t error */ \
@@ -266,113 +265,6 @@ __global__ void ReorderProposalsKernel(const int count,
   }
 }
 
-__device__ inline float devIoU(float const * const a, float const * const b) {
-  float left = max(a[0], b[0]), right = min(a[2], b[2]);
-  float top = max(a[1], b[1]), bottom = min(a[3], b[3]);
-  float width = max(right - left + 1, 0.f), height = max(bottom - top + 1, 0.f);
-  float interS = width * height;
-  float Sa = (a[2] - a[0] + 1) * (a[3] - a[1] + 1);
-  float Sb = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
-  return interS / (Sa + Sb - interS);
-}
-
-__global__ void nms_kernel(const int n_boxes, const float nms_overlap_thresh,
-                           const float *dev_boxes, uint64_t *dev_mask) {
-  const int threadsPerBlock = sizeof(uint64_t) * 8;
-  const int row_start = blockIdx.y;
-  const int col_start = blockIdx.x;
-
-  // if (row_start > col_start) return;
-
-  const int row_size =
-        min(n_boxes - row_start * threadsPerBlock, threadsPerBlock);
-  const int col_size =
-        min(n_boxes - col_start * threadsPerBlock, threadsPerBlock);
-
-  __shared__ float block_boxes[threadsPerBlock * 5];
-  if (threadIdx.x < col_size) {
-    block_boxes[threadIdx.x * 5 + 0] =
-        dev_boxes[(threadsPerBlock * col_start + threadIdx.x) * 5 + 0];
-    block_boxes[threadIdx.x * 5 + 1] =
-        dev_boxes[(threadsPerBlock * col_start + threadIdx.x) * 5 + 1];
-    block_boxes[threadIdx.x * 5 + 2] =
-        dev_boxes[(threadsPerBlock * col_start + threadIdx.x) * 5 + 2];
-    block_boxes[threadIdx.x * 5 + 3] =
-        dev_boxes[(threadsPerBlock * col_start + threadIdx.x) * 5 + 3];
-    block_boxes[threadIdx.x * 5 + 4] =
-        dev_boxes[(threadsPerBlock * col_start + threadIdx.x) * 5 + 4];
-  }
-  __syncthreads();
-
-  if (threadIdx.x < row_size) {
-    const int cur_box_idx = threadsPerBlock * row_start + threadIdx.x;
-    const float *cur_box = dev_boxes + cur_box_idx * 5;
-    int i = 0;
-    uint64_t t = 0;
-    int start = 0;
-    if (row_start == col_start) {
-      start = threadIdx.x + 1;
-    }
-    for (i = start; i < col_size; i++) {
-      if (devIoU(cur_box, block_boxes + i * 5) > nms_overlap_thresh) {
-        t |= 1ULL << i;
-      }
-    }
-    const int col_blocks = DIVUP(n_boxes, threadsPerBlock);
-    dev_mask[cur_box_idx * col_blocks + col_start] = t;
-  }
-}
-
-void _nms(const mshadow::Tensor<gpu, 2>& boxes,
-          const float nms_overlap_thresh,
-          int *keep,
-          int *num_out) {
-  const int threadsPerBlock = sizeof(uint64_t) * 8;
-  const int boxes_num = boxes.size(0);
-  const int boxes_dim = boxes.size(1);
-
-  float* boxes_dev = boxes.dptr_;
-  uint64_t* mask_dev = NULL;
-
-  const int col_blocks = DIVUP(boxes_num, threadsPerBlock);
-  FRCNN_CUDA_CHECK(cudaMalloc(&mask_dev,
-                              boxes_num * col_blocks * sizeof(uint64_t)));
-
-  dim3 blocks(DIVUP(boxes_num, threadsPerBlock),
-              DIVUP(boxes_num, threadsPerBlock));
-  dim3 threads(threadsPerBlock);
-  nms_kernel<<<blocks, threads>>>(boxes_num,
-                                  nms_overlap_thresh,
-                                  boxes_dev,
-                                  mask_dev);
-  FRCNN_CUDA_CHECK(cudaPeekAtLastError());
-  std::vector<uint64_t> mask_host(boxes_num * col_blocks);
-  FRCNN_CUDA_CHECK(cudaMemcpy(&mask_host[0],
-                              mask_dev,
-                              sizeof(uint64_t) * boxes_num * col_blocks,
-                              cudaMemcpyDeviceToHost));
-
-  std::vector<uint64_t> remv(col_blocks);
-  memset(&remv[0], 0, sizeof(uint64_t) * col_blocks);
-
-  int num_to_keep = 0;
-  for (int i = 0; i < boxes_num; i++) {
-    int nblock = i / threadsPerBlock;
-    int inblock = i % threadsPerBlock;
-
-    if (!(remv[nblock] & (1ULL << inblock))) {
-      keep[num_to_keep++] = i;
-      uint64_t *p = &mask_host[0] + i * col_blocks;
-      for (int j = nblock; j < col_blocks; j++) {
-        remv[j] |= p[j];
-      }
-    }
-  }
-  *num_out = num_to_keep;
-
-  FRCNN_CUDA_CHECK(cudaFree(mask_dev));
-}
-
 // copy proposals to output
 // dets (top_n, 5); keep (top_n, ); out (top_n, )
 // count should be top_n (total anchors or proposals)
@@ -380,13 +272,14 @@ template<typename Dtype>
 __global__ void PrepareOutput(const int count,
                               const Dtype* dets,
                               const int* keep,
-                              const int out_size,
+                              const int* num_keep,
                               const int image_index,
                               Dtype* out,
                               Dtype* score) {
   for (int index = blockIdx.x * blockDim.x + threadIdx.x;
        index < count;
        index += blockDim.x * gridDim.x) {
+    const int out_size = *num_keep;
     out[index * 5] = image_index;
     if (index < out_size) {
       int keep_i = keep[index];
@@ -518,12 +411,9 @@ class MultiProposalGPUOp : public Operator{
 
     float* workspace_ordered_proposals_ptr = NULL;
     FRCNN_CUDA_CHECK(cudaMalloc(&workspace_ordered_proposals_ptr,
-        sizeof(float) * rpn_pre_nms_top_n * 5));
-    Tensor<xpu, 2> workspace_ordered_proposals(workspace_ordered_proposals_ptr,
-        Shape2(rpn_pre_nms_top_n, 5));
-
-    int* keep;
-    FRCNN_CUDA_CHECK(cudaMalloc(&keep, sizeof(int) * rpn_pre_nms_top_n));
+        sizeof(float) * num_images * rpn_pre_nms_top_n * 5));
+    Tensor<xpu, 3> workspace_ordered_proposals(workspace_ordered_proposals_ptr,
+        Shape3(num_images, rpn_pre_nms_top_n, 5));
 
     for (int b = 0; b < num_images; b++) {
         CheckLaunchParam(dimGrid, dimBlock, "CopyScore");
@@ -546,31 +436,42 @@ class MultiProposalGPUOp : public Operator{
         CheckLaunchParam(dimGrid, dimBlock, "ReorderProposals");
         ReorderProposalsKernel << <dimGrid, dimBlock >> >(
             rpn_pre_nms_top_n, workspace_proposals.dptr_ + b * count_anchors * 5,
-            order.dptr_, workspace_ordered_proposals.dptr_);
+            order.dptr_, workspace_ordered_proposals.dptr_ + b * rpn_pre_nms_top_n * 5);
         FRCNN_CUDA_CHECK(cudaPeekAtLastError());
+        dimGrid.x = (count_anchors + kMaxThreadsPerBlock - 1) / kMaxThreadsPerBlock;
+    }
 
-        // perform nms
-        std::vector<int> _keep(workspace_ordered_proposals.size(0));
-        int out_size = 0;
-        _nms(workspace_ordered_proposals,
-            param_.threshold,
-            &_keep[0],
-            &out_size);
-
-        // copy nms result to gpu
-        FRCNN_CUDA_CHECK(cudaMemcpy(keep, &_keep[0], sizeof(int) * _keep.size(),
-            cudaMemcpyHostToDevice));
-
-        // copy results after nms
-        dimGrid.x = (rpn_post_nms_top_n + kMaxThreadsPerBlock - 1) / kMaxThreadsPerBlock;
-        CheckLaunchParam(dimGrid, dimBlock, "PrepareOutput");
+    // perform nms of all the images at once on the gpu, the boxes are in pixels
+    BoxNMSLayout layout;
+    layout.batch = num_images;
+    layout.num = rpn_pre_nms_top_n;
+    layout.stride = 5;
+    layout.coord = 0;
+    layout.id = -1;
+    layout.offset = 1.0f;
+    char* nms_workspace_ptr = NULL;
+    FRCNN_CUDA_CHECK(cudaMalloc(&nms_workspace_ptr,
+        BoxNMSBuffers::Size<gpu>(num_images, rpn_pre_nms_top_n)));
+    BoxNMSBuffers nms = BoxNMSBuffers::Create<gpu>(nms_workspace_ptr, num_images,
+                                                   rpn_pre_nms_top_n);
+    std::vector<int> num_valid(num_images, rpn_pre_nms_top_n);
+    FRCNN_CUDA_CHECK(cudaMemcpy(nms.num_valid, &num_valid[0], sizeof(int) * num_images,
+        cudaMemcpyHostToDevice));
+    BoxNMS(s, layout, workspace_ordered_proposals.dptr_, nms.num_valid, param_.threshold,
+           rpn_post_nms_top_n, nms.keep, nms.num_keep, nms.mask);
+
+    // copy results after nms
+    dimGrid.x = (rpn_post_nms_top_n + kMaxThreadsPerBlock - 1) / kMaxThreadsPerBlock;
+    CheckLaunchParam(dimGrid, dimBlock, "PrepareOutput");
+    for (int b = 0; b < num_images; b++) {
         PrepareOutput << <dimGrid, dimBlock >> >(
-            rpn_post_nms_top_n, workspace_ordered_proposals.dptr_, keep, out_size, b,
+            rpn_post_nms_top_n, workspace_ordered_proposals.dptr_ + b * rpn_pre_nms_top_n * 5,
+            nms.keep + b * rpn_pre_nms_top_n, nms.num_keep + b, b,
             out.dptr_ + b * rpn_post_nms_top_n * 5, out_score.dptr_ + b * rpn_post_nms_top_n);
         FRCNN_CUDA_CHECK(cudaPeekAtLastError());
     }
     // free temporary memory
-    FRCNN_CUDA_CHECK(cudaFree(keep));
+    FRCNN_CUDA_CHECK(cudaFree(nms_workspace_ptr));
     FRCNN_CUDA_CHECK(cudaFree(workspace_ordered_proposals_ptr));
     FRCNN_CUDA_CHECK(cudaFree(workspace_proposals_ptr));
     FRCNN_CUDA_CHECK(cudaFree(score_ptr));
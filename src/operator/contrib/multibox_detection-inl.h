@@ -35,6 +35,7 @@
 #include <utility>
 #include <valarray>
 #include "../operator_common.h"
+#include "./bounding_box-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -98,10 +99,15 @@ class MultiBoxDetectionOp : public Operator {
        .get_with_shape<xpu, 2, DType>(Shape2(ashape[1], 4), s);
      Tensor<xpu, 3, DType> out = out_data[mboxdet_enum::kOut]
        .get<xpu, 3, DType>(s);
-     Tensor<xpu, 3, DType> temp_space = ctx.requested[mboxdet_enum::kTempSpace]
-       .get_space_typed<xpu, 3, DType>(out.shape_, s);
+     // the buffers of the nms come first, their size is a multiple of 8 bytes
+     const size_t nms_bytes = BoxNMSBuffers::Size<xpu>(out.size(0), out.size(1));
+     Tensor<xpu, 1, char> workspace = ctx.requested[mboxdet_enum::kTempSpace]
+       .get_space_typed<xpu, 1, char>(Shape1(nms_bytes + out.shape_.Size() * sizeof(DType)), s);
+     BoxNMSBuffers nms = BoxNMSBuffers::Create<xpu>(workspace.dptr_, out.size(0), out.size(1));
+     Tensor<xpu, 3, DType> temp_space(reinterpret_cast<DType*>(workspace.dptr_ + nms_bytes),
+                                      out.shape_, s);
      out = -1.f;
-     MultiBoxDetectionForward(out, cls_prob, loc_pred, anchors, temp_space,
+     MultiBoxDetectionForward(out, cls_prob, loc_pred, anchors, temp_space, nms,
        param_.threshold, param_.clip, param_.variances, param_.nms_threshold,
        param_.force_suppress, param_.nms_topk);
   }
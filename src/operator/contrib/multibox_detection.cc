@@ -69,21 +69,13 @@ inline void TransformLocations(DType *out, const DType *anchors,
   out[3] = clip ? std::max(DType(0), std::min(DType(1), oy + oh)) : (oy + oh);
 }
 
-template<typename DType>
-inline DType CalculateOverlap(const DType *a, const DType *b) {
-  DType w = std::max(DType(0), std::min(a[2], b[2]) - std::max(a[0], b[0]));
-  DType h = std::max(DType(0), std::min(a[3], b[3]) - std::max(a[1], b[1]));
-  DType i = w * h;
-  DType u = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - i;
-  return u <= 0.f ? static_cast<DType>(0) : static_cast<DType>(i / u);
-}
-
 template<typename DType>
 inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
                                      const Tensor<cpu, 3, DType> &cls_prob,
                                      const Tensor<cpu, 2, DType> &loc_pred,
                                      const Tensor<cpu, 2, DType> &anchors,
                                      const Tensor<cpu, 3, DType> &temp_space,
+                                     const mxnet::op::BoxNMSBuffers &nms,
                                      const float threshold,
                                      const bool clip,
                                      const nnvm::Tuple<float> &variances,
@@ -100,6 +92,7 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
     const DType *p_loc_pred = loc_pred.dptr_ + nbatch * num_anchors * 4;
     DType *p_out = out.dptr_ + nbatch * num_anchors * 6;
     int valid_count = 0;
+    nms.num_valid[nbatch] = 0;
     for (int i = 0; i < num_anchors; ++i) {
       // find the predicted class id and probability
       DType score = -1;
@@ -137,7 +130,7 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
       sorter.push_back(SortElemDescend<DType>(p_out[i * 6 + 1], i));
     }
     std::stable_sort(sorter.begin(), sorter.end());
-    // re-order output
+    // re-order output, and only keep the top k detections
     DType *ptemp = temp_space.dptr_ + nbatch * num_anchors * 6;
     int nkeep = static_cast<int>(sorter.size());
     if (nms_topk > 0 && nms_topk < nkeep) {
@@ -148,23 +141,33 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
         p_out[i * 6 + j] = ptemp[sorter[i].index * 6 + j];
       }
     }
-    // apply nms
-    for (int i = 0; i < valid_count; ++i) {
-      int offset_i = i * 6;
-      if (p_out[offset_i] < 0) continue;  // skip eliminated
-      for (int j = i + 1; j < valid_count; ++j) {
-        int offset_j = j * 6;
-        if (p_out[offset_j] < 0) continue;  // skip eliminated
-        if (force_suppress || (p_out[offset_i] == p_out[offset_j])) {
-          // when foce_suppress == true or class_id equals
-          DType iou = CalculateOverlap(p_out + offset_i + 2, p_out + offset_j + 2);
-          if (iou >= nms_threshold) {
-            p_out[offset_j] = -1;
-          }
-        }
-      }
+    for (int i = nkeep; i < valid_count; ++i) {
+      p_out[i * 6] = -1;
     }
+    nms.num_valid[nbatch] = nkeep;
   }  // end iter batch
+
+  // apply nms on all the images, then discard the suppressed detections
+  mxnet::op::BoxNMSLayout layout;
+  layout.batch = num_batches;
+  layout.num = num_anchors;
+  layout.stride = 6;
+  layout.coord = 2;
+  layout.id = force_suppress ? -1 : 0;
+  layout.offset = 0.0f;
+  mxnet::op::BoxNMS(out.stream_, layout, out.dptr_, nms.num_valid, nms_threshold,
+                    num_anchors, nms.keep, nms.num_keep, nms.mask);
+  for (int nbatch = 0; nbatch < num_batches; ++nbatch) {
+    DType *p_out = out.dptr_ + nbatch * num_anchors * 6;
+    const int *keep = nms.keep + nbatch * num_anchors;
+    for (int i = 0, k = 0; i < nms.num_valid[nbatch]; ++i) {
+      if (k < nms.num_keep[nbatch] && keep[k] == i) {
+        ++k;
+      } else {
+        p_out[i * 6] = -1;
+      }
+    }
+  }
 }
 }  // namespace mshadow
 
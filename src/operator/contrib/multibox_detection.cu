@@ -40,15 +40,6 @@ __device__ void Clip(DType *value, const DType lower, const DType upper) {
   if ((*value) > upper) *value = upper;
 }
 
-template<typename DType>
-__device__ void CalculateOverlap(const DType *a, const DType *b, DType *iou) {
-  DType w = max(DType(0), min(a[2], b[2]) - max(a[0], b[0]));
-  DType h = max(DType(0), min(a[3], b[3]) - max(a[1], b[1]));
-  DType i = w * h;
-  DType u = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - i;
-  (*iou) =  u <= 0.f ? static_cast<DType>(0) : static_cast<DType>(i / u);
-}
-
 template<typename DType>
 __global__ void DetectionForwardKernel(DType *out, const DType *cls_prob,
                                        const DType *loc_pred, const DType *anchors,
@@ -57,7 +48,7 @@ __global__ void DetectionForwardKernel(DType *out, const DType *cls_prob,
                                        const bool clip, const float vx,
                                        const float vy, const float vw,
                                        const float vh, const float nms_threshold,
-                                       const bool force_suppress, const int nms_topk) {
+                                       const int nms_topk, int *num_valid) {
   const int nbatch = blockIdx.x;  // each block for each batch
   int index = threadIdx.x;
   __shared__ int valid_count;
@@ -121,8 +112,10 @@ __global__ void DetectionForwardKernel(DType *out, const DType *cls_prob,
   }
   __syncthreads();
 
-  if (valid_count < 1 || nms_threshold <= 0 || nms_threshold > 1) return;
-  // if (index == 0) printf("%d\n", valid_count);
+  if (valid_count < 1 || nms_threshold <= 0 || nms_threshold > 1) {
+    if (index == 0) num_valid[nbatch] = 0;
+    return;
+  }
 
   // descent sort according to scores
   const int size = valid_count;
@@ -181,23 +174,32 @@ __global__ void DetectionForwardKernel(DType *out, const DType *cls_prob,
     __syncthreads();
   }
 
-  // apply NMS
-  for (int compare_pos = 0; compare_pos < ntop; ++compare_pos) {
-    DType compare_id = out[compare_pos * 6];
-    if (compare_id < 0) continue;  // not a valid positive detection, skip
-    DType *compare_loc_ptr = out + compare_pos * 6 + 2;
-    for (int i = compare_pos + index + 1; i < ntop; i += blockDim.x) {
-      DType class_id = out[i * 6];
-      if (class_id < 0) continue;
-      if (force_suppress || (class_id == compare_id)) {
-        DType iou;
-        CalculateOverlap(compare_loc_ptr, out + i * 6 + 2, &iou);
-        if (iou >= nms_threshold) {
-          out[i * 6] = -1;
-        }
+  // the top k detections are the candidates of the nms
+  if (index == 0) num_valid[nbatch] = ntop;
+}
+
+/*!
+ * \brief discard the candidates suppressed by the nms, the indices of the
+ *  kept ones are in increasing order
+ */
+template<typename DType>
+__global__ void DetectionSuppressKernel(DType *out, const int *num_valid, const int *keep,
+                                        const int *num_keep, const int num_anchors) {
+  const int nbatch = blockIdx.x;  // each block for each batch
+  out += nbatch * num_anchors * 6;
+  keep += nbatch * num_anchors;
+  const int kept = num_keep[nbatch];
+  for (int i = threadIdx.x; i < num_valid[nbatch]; i += blockDim.x) {
+    int lo = 0, hi = kept;
+    while (lo < hi) {
+      const int mid = (lo + hi) / 2;
+      if (keep[mid] < i) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
       }
     }
-    __syncthreads();
+    if (lo == kept || keep[lo] != i) out[i * 6] = -1;
   }
 }
 }  // namespace cuda
@@ -208,6 +210,7 @@ inline void MultiBoxDetectionForward(const Tensor<gpu, 3, DType> &out,
                                      const Tensor<gpu, 2, DType> &loc_pred,
                                      const Tensor<gpu, 2, DType> &anchors,
                                      const Tensor<gpu, 3, DType> &temp_space,
+                                     const mxnet::op::BoxNMSBuffers &nms,
                                      const float threshold,
                                      const bool clip,
                                      const nnvm::Tuple<float> &variances,
@@ -226,7 +229,20 @@ inline void MultiBoxDetectionForward(const Tensor<gpu, 3, DType> &out,
     cls_prob.dptr_, loc_pred.dptr_, anchors.dptr_, temp_space.dptr_,
     num_classes, num_anchors, threshold, clip,
     variances[0], variances[1], variances[2], variances[3],
-    nms_threshold, force_suppress, nms_topk);
+    nms_threshold, nms_topk, nms.num_valid);
+  MULTIBOX_DETECTION_CUDA_CHECK(cudaPeekAtLastError());
+  // apply nms on all the images at once
+  mxnet::op::BoxNMSLayout layout;
+  layout.batch = num_batches;
+  layout.num = num_anchors;
+  layout.stride = 6;
+  layout.coord = 2;
+  layout.id = force_suppress ? -1 : 0;
+  layout.offset = 0.0f;
+  mxnet::op::BoxNMS(out.stream_, layout, out.dptr_, nms.num_valid, nms_threshold,
+                    num_anchors, nms.keep, nms.num_keep, nms.mask);
+  cuda::DetectionSuppressKernel<<<num_blocks, num_threads, 0, stream>>>(out.dptr_,
+    nms.num_valid, nms.keep, nms.num_keep, num_anchors);
   MULTIBOX_DETECTION_CUDA_CHECK(cudaPeekAtLastError());
 }
 }  // namespace mshadow
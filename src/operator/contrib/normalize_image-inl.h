@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file normalize_image-inl.h
+ * \brief convert, mirror and normalize a batch of images on the device
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_NORMALIZE_IMAGE_INL_H_
+#define MXNET_OPERATOR_CONTRIB_NORMALIZE_IMAGE_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+
+namespace mxnet {
+namespace op {
+
+struct NormalizeImageParam : public dmlc::Parameter<NormalizeImageParam> {
+  nnvm::Tuple<float> mean;
+  nnvm::Tuple<float> std;
+  float scale;
+  bool mirror;
+  bool rand_mirror;
+  DMLC_DECLARE_PARAMETER(NormalizeImageParam) {
+    DMLC_DECLARE_FIELD(mean).set_default(nnvm::Tuple<float>({0.0f}))
+    .describe("Mean of every channel, or a single mean for all channels.");
+    DMLC_DECLARE_FIELD(std).set_default(nnvm::Tuple<float>({1.0f}))
+    .describe("Standard deviation of every channel, or a single one for all channels.");
+    DMLC_DECLARE_FIELD(scale).set_default(1.0f)
+    .describe("Multiplier applied after the normalization.");
+    DMLC_DECLARE_FIELD(mirror).set_default(false)
+    .describe("Whether to mirror all images horizontally.");
+    DMLC_DECLARE_FIELD(rand_mirror).set_default(false)
+    .describe("Whether to mirror every image horizontally with probability 0.5.");
+  }
+};
+
+/*! \brief maximal number of channels of an image */
+const int kMaxImageChannels = 4;
+
+/*! \brief one value per channel, passed to the kernels by value */
+struct ImageChannelValues {
+  float v[kMaxImageChannels];
+};
+
+inline bool NormalizeImageShape(const nnvm::NodeAttrs& attrs,
+                                std::vector<TShape> *in_attrs,
+                                std::vector<TShape> *out_attrs) {
+  const NormalizeImageParam& param = nnvm::get<NormalizeImageParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const TShape& dshape = (*in_attrs)[0];
+  if (dshape.ndim() == 0) return false;
+  CHECK_EQ(dshape.ndim(), 4U) << "normalize_image expects images in (N, C, H, W) layout";
+  CHECK_LE(dshape[1], static_cast<index_t>(kMaxImageChannels))
+    << "normalize_image supports at most " << kMaxImageChannels << " channels";
+  CHECK(param.mean.ndim() == 1U || param.mean.ndim() == dshape[1])
+    << "mean must have one value or one value per channel";
+  CHECK(param.std.ndim() == 1U || param.std.ndim() == dshape[1])
+    << "std must have one value or one value per channel";
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, dshape);
+  return true;
+}
+
+inline bool NormalizeImageType(const nnvm::NodeAttrs& attrs,
+                               std::vector<int> *in_attrs,
+                               std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kFloat32);
+  return (*in_attrs)[0] != -1;
+}
+
+struct NormalizeImageKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, float* out, const DType* in, const float* flip,
+                                  const ImageChannelValues mean,
+                                  const ImageChannelValues scale,
+                                  const int channels, const int height, const int width,
+                                  const bool mirror, const OpReqType req) {
+    const int w = i % width;
+    const int c = (i / (width * height)) % channels;
+    const int n = i / (width * height * channels);
+    const bool flipped = mirror || (flip != nullptr && flip[n] < 0.5f);
+    const int src = flipped ? i + width - 1 - 2 * w : i;
+    KERNEL_ASSIGN(out[i], req, (static_cast<float>(in[src]) - mean.v[c]) * scale.v[c]);
+  }
+};
+
+template<typename xpu>
+void NormalizeImageCompute(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const NormalizeImageParam& param = nnvm::get<NormalizeImageParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TShape& dshape = inputs[0].shape_;
+  const int channels = dshape[1];
+  ImageChannelValues mean, scale;
+  for (int c = 0; c < channels; ++c) {
+    mean.v[c] = param.mean[param.mean.ndim() == 1U ? 0 : c];
+    scale.v[c] = param.scale / param.std[param.std.ndim() == 1U ? 0 : c];
+  }
+  float* flip = nullptr;
+  if (param.rand_mirror && !param.mirror) {
+    Random<xpu, float> *prnd = ctx.requested[0].get_random<xpu, float>(s);
+    Tensor<xpu, 1, float> uniform =
+      ctx.requested[1].get_space_typed<xpu, 1, float>(Shape1(dshape[0]), s);
+    prnd->SampleUniform(&uniform, 0, 1);
+    flip = uniform.dptr_;
+  }
+  MSHADOW_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    Kernel<NormalizeImageKernel, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<float>(), inputs[0].dptr<DType>(), flip, mean, scale,
+      channels, static_cast<int>(dshape[2]), static_cast<int>(dshape[3]),
+      param.mirror, req[0]);
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_NORMALIZE_IMAGE_INL_H_
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file normalize_image.cc
+ * \brief convert, mirror and normalize a batch of images on the device
+ */
+#include "./normalize_image-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(NormalizeImageParam);
+
+NNVM_REGISTER_OP(_contrib_normalize_image)
+.describe(R"code(Convert a batch of images to float32, mirror and normalize them.
+
+`data` is a batch of images in (N, C, H, W) layout of any type, typically
+the ``uint8`` batches of ``ImageRecordUInt8Iter``. Every element becomes
+
+`out[n, c, h, w] = (data[n, c, h, w'] - mean[c]) / std[c] * scale`
+
+where `w' = W - 1 - w` for the mirrored images and `w' = w` otherwise.
+
+Running this operator on the GPU instead of normalizing in the iterator
+copies 4x less data to the device and frees the CPU threads of the iterator
+for decoding.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<NormalizeImageParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape", NormalizeImageShape)
+.set_attr<nnvm::FInferType>("FInferType", NormalizeImageType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const nnvm::NodeAttrs& attrs) {
+    const NormalizeImageParam& param = nnvm::get<NormalizeImageParam>(attrs.parsed);
+    if (param.rand_mirror && !param.mirror) {
+      return std::vector<ResourceRequest>{ResourceRequest::kRandom,
+                                          ResourceRequest::kTempSpace};
+    }
+    return std::vector<ResourceRequest>();
+  })
+.set_attr<FCompute>("FCompute<cpu>", NormalizeImageCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "Batch of images in (N, C, H, W) layout")
+.add_arguments(NormalizeImageParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
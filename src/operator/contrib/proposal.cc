@@ -24,6 +24,7 @@
 */
 
 #include "./proposal-inl.h"
+#include "./bounding_box-inl.h"
 
 //============================
 // Bounding Box Transform Utils
@@ -209,59 +210,6 @@ inline void ReorderProposals(const mshadow::Tensor<cpu, 2>& prev_dets,
   }
 }
 
-// greedily keep the max detections (already sorted)
-inline void NonMaximumSuppression(const mshadow::Tensor<cpu, 2>& dets,
-                                  const float thresh,
-                                  const index_t post_nms_top_n,
-                                  mshadow::Tensor<cpu, 1> *area,
-                                  mshadow::Tensor<cpu, 1> *suppressed,
-                                  mshadow::Tensor<cpu, 1> *keep,
-                                  index_t *out_size) {
-  CHECK_EQ(dets.shape_[1], 5) << "dets: [x1, y1, x2, y2, score]";
-  CHECK_GT(dets.shape_[0], 0);
-  CHECK_EQ(dets.CheckContiguous(), true);
-  CHECK_EQ(area->CheckContiguous(), true);
-  CHECK_EQ(suppressed->CheckContiguous(), true);
-  CHECK_EQ(keep->CheckContiguous(), true);
-  // calculate area
-  for (index_t i = 0; i < dets.size(0); ++i) {
-    (*area)[i] = (dets[i][2] - dets[i][0] + 1) *
-                 (dets[i][3] - dets[i][1] + 1);
-  }
-
-  // calculate nms
-  *out_size = 0;
-  for (index_t i = 0; i < dets.size(0) && (*out_size) < post_nms_top_n; ++i) {
-    float ix1 = dets[i][0];
-    float iy1 = dets[i][1];
-    float ix2 = dets[i][2];
-    float iy2 = dets[i][3];
-    float iarea = (*area)[i];
-
-    if ((*suppressed)[i] > 0.0f) {
-      continue;
-    }
-
-    (*keep)[(*out_size)++] = i;
-    for (index_t j = i + 1; j < dets.size(0); j ++) {
-      if ((*suppressed)[j] > 0.0f) {
-        continue;
-      }
-      float xx1 = std::max(ix1, dets[j][0]);
-      float yy1 = std::max(iy1, dets[j][1]);
-      float xx2 = std::min(ix2, dets[j][2]);
-      float yy2 = std::min(iy2, dets[j][3]);
-      float w = std::max(0.0f, xx2 - xx1 + 1.0f);
-      float h = std::max(0.0f, yy2 - yy1 + 1.0f);
-      float inter = w * h;
-      float ovr = inter / (iarea + (*area)[j] - inter);
-      if (ovr > thresh) {
-        (*suppressed)[j] = 1.0f;
-      }
-    }
-  }
-}
-
 }  // namespace utils
 }  // namespace op
 }  // namespace mxnet
@@ -314,7 +262,7 @@ class ProposalOp : public Operator{
     rpn_pre_nms_top_n = std::min(rpn_pre_nms_top_n, count);
     int rpn_post_nms_top_n = std::min(param_.rpn_post_nms_top_n, rpn_pre_nms_top_n);
 
-    int workspace_size = count * 5 + 2 * count + rpn_pre_nms_top_n * 5 + 3 * rpn_pre_nms_top_n;
+    int workspace_size = count * 5 + 2 * count + rpn_pre_nms_top_n * 5;
     Tensor<cpu, 1> workspace = ctx.requested[proposal::kTempResource].get_space<cpu>(
       Shape1(workspace_size), s);
     int start = 0;
@@ -325,8 +273,6 @@ class ProposalOp : public Operator{
     Tensor<cpu, 2> workspace_ordered_proposals(workspace.dptr_ + start,
                                                Shape2(rpn_pre_nms_top_n, 5));
     start += rpn_pre_nms_top_n * 5;
-    Tensor<cpu, 2> workspace_nms(workspace.dptr_ + start, Shape2(3, rpn_pre_nms_top_n));
-    start += 3 * rpn_pre_nms_top_n;
     CHECK_EQ(workspace_size, start) << workspace_size << " " << start << std::endl;
 
     // Generate anchors
@@ -385,25 +331,24 @@ class ProposalOp : public Operator{
                             rpn_pre_nms_top_n,
                             &workspace_ordered_proposals);
 
-    index_t out_size = 0;
-    Tensor<cpu, 1> area = workspace_nms[0];
-    Tensor<cpu, 1> suppressed = workspace_nms[1];
-    Tensor<cpu, 1> keep = workspace_nms[2];
-    suppressed = 0;  // surprised!
-
-    utils::NonMaximumSuppression(workspace_ordered_proposals,
-                                 param_.threshold,
-                                 rpn_post_nms_top_n,
-                                 &area,
-                                 &suppressed,
-                                 &keep,
-                                 &out_size);
+    // greedily keep the max detections, the boxes are in pixels
+    BoxNMSLayout layout;
+    layout.batch = 1;
+    layout.num = rpn_pre_nms_top_n;
+    layout.stride = 5;
+    layout.coord = 0;
+    layout.id = -1;
+    layout.offset = 1.0f;
+    std::vector<int> keep(rpn_pre_nms_top_n);
+    int out_size = 0;
+    BoxNMS(s, layout, workspace_ordered_proposals.dptr_, &rpn_pre_nms_top_n,
+           param_.threshold, rpn_post_nms_top_n, keep.data(), &out_size, nullptr);
 
     // fill in output rois
     for (index_t i = 0; i < out.size(0); ++i) {
       // batch index 0
       out[i][0] = 0;
-      if (i < out_size) {
+      if (i < static_cast<index_t>(out_size)) {
         index_t index = keep[i];
         for (index_t j = 0; j < 4; ++j) {
           out[i][j + 1] =  workspace_ordered_proposals[index][j];
@@ -418,7 +363,7 @@ class ProposalOp : public Operator{
 
     // fill in output score
     for (index_t i = 0; i < out_score.size(0); i++) {
-      if (i < out_size) {
+      if (i < static_cast<index_t>(out_size)) {
         index_t index = keep[i];
         out_score[i][0] = workspace_ordered_proposals[index][4];
       } else {
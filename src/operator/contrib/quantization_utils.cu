@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantization_utils.cu
+ * \brief int8 matrix product on gpu
+ */
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+struct int8_gemm_nt {
+  MSHADOW_XINLINE static void Map(int i, int32_t *C, const int8_t *A, const int8_t *B,
+                                  int N, int K, int lda, int ldb, int ldc, bool packed) {
+    const int row = i / N;
+    const int col = i % N;
+    const int8_t *a = A + static_cast<int64_t>(row) * lda;
+    const int8_t *b = B + static_cast<int64_t>(col) * ldb;
+    int32_t sum = 0;
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 610
+    if (packed) {
+      const int *a4 = reinterpret_cast<const int*>(a);
+      const int *b4 = reinterpret_cast<const int*>(b);
+      for (int k = 0; k < K / 4; ++k) sum = __dp4a(a4[k], b4[k], sum);
+      C[static_cast<int64_t>(row) * ldc + col] = sum;
+      return;
+    }
+#endif
+    for (int k = 0; k < K; ++k) sum += static_cast<int32_t>(a[k]) * b[k];
+    C[static_cast<int64_t>(row) * ldc + col] = sum;
+  }
+};
+
+void Int8GemmNT(mshadow::Stream<gpu> *s, int M, int N, int K,
+                const int8_t *A, int lda, const int8_t *B, int ldb,
+                int32_t *C, int ldc) {
+  // the rows are read as int32 words when they are 4 bytes aligned
+  const bool packed = K % 4 == 0 && lda % 4 == 0 && ldb % 4 == 0 &&
+      reinterpret_cast<uintptr_t>(A) % 4 == 0 && reinterpret_cast<uintptr_t>(B) % 4 == 0;
+  mxnet_op::Kernel<int8_gemm_nt, gpu>::Launch(s, M * N, C, A, B, N, K, lda, ldb, ldc, packed);
+}
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,282 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantization_utils.h
+ * \brief Helpers shared by the int8 operators
+ *
+ *  An int8 or int32 tensor q comes with the float scalars min_range and
+ *  max_range, and stands for the real values q * r / range(T) where
+ *  r = max(|min_range|, |max_range|) and range(T) is the largest value of T.
+ *  The quantization is symmetric, 0 is always represented exactly.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
+
+#include <mxnet/base.h>
+#include <nnvm/node.h>
+#include <nnvm/op.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief largest magnitude of the values of a quantized type */
+template<typename T>
+struct QuantizedRange;
+
+template<>
+struct QuantizedRange<int8_t> {
+  MSHADOW_XINLINE static float Value() { return 127.0f; }
+};
+
+template<>
+struct QuantizedRange<int32_t> {
+  MSHADOW_XINLINE static float Value() { return 2147483647.0f; }
+};
+
+/*! \brief the real value of the largest magnitude of a range */
+MSHADOW_XINLINE float MaxAbs(float a, float b) {
+  return fmaxf(fabsf(a), fabsf(b));
+}
+
+/*! \brief quantize a real value to T given the real value r of range(T) */
+template<typename T>
+MSHADOW_XINLINE T FloatToQuantized(float value, float r) {
+  const float limit = QuantizedRange<T>::Value();
+  const float scaled = r == 0.0f ? 0.0f : fminf(fabsf(value) * (limit / r) + 0.5f, limit);
+  return static_cast<T>(value < 0.0f ? -scaled : scaled);
+}
+
+/*! \brief the real value of a quantized value given the real value r of range(T) */
+template<typename T>
+MSHADOW_XINLINE float QuantizedToFloat(T value, float r) {
+  return static_cast<float>(value) * (r / QuantizedRange<T>::Value());
+}
+
+/*! \brief the outputs of the operators that keep the range of their input */
+struct quantized_range_copy {
+  MSHADOW_XINLINE static void Map(int i, float *omin_range, float *omax_range,
+                                  const float *imin_range, const float *imax_range) {
+    *omin_range = *imin_range;
+    *omax_range = *imax_range;
+  }
+};
+
+/*!
+ * \brief the range of the int32 products of two int8 tensors: a unit of the
+ *  products is worth the product of the units of the operands.
+ */
+struct quantization_range_for_multiplication {
+  MSHADOW_XINLINE static void Map(int i, float *min_c, float *max_c,
+                                  const float *min_a, const float *max_a,
+                                  const float *min_b, const float *max_b) {
+    const float unit_a = MaxAbs(*min_a, *max_a) / QuantizedRange<int8_t>::Value();
+    const float unit_b = MaxAbs(*min_b, *max_b) / QuantizedRange<int8_t>::Value();
+    const float r = unit_a * unit_b * QuantizedRange<int32_t>::Value();
+    *min_c = -r;
+    *max_c = r;
+  }
+};
+
+/*!
+ * \brief add the int8 bias of every channel to the int32 products
+ *  out[(n * channels + c) * inner + j], rescaled to the unit of the products.
+ */
+struct quantized_bias_add {
+  MSHADOW_XINLINE static void Map(int i, int32_t *out, const int8_t *bias,
+                                  const float *min_out, const float *max_out,
+                                  const float *min_bias, const float *max_bias,
+                                  int channels, int inner) {
+    const float unit_out = MaxAbs(*min_out, *max_out) / QuantizedRange<int32_t>::Value();
+    const float unit_bias = MaxAbs(*min_bias, *max_bias) / QuantizedRange<int8_t>::Value();
+    const int c = (i / inner) % channels;
+    const float value = static_cast<float>(bias[c]) * (unit_bias / unit_out);
+    out[i] += static_cast<int32_t>(value < 0.0f ? value - 0.5f : value + 0.5f);
+  }
+};
+
+/*!
+ * \brief C[i * ldc + j] = sum_k A[i * lda + k] * B[j * ldb + k] on int8
+ *  operands with int32 accumulation.
+ *
+ *  Both operands are read along k, so the dot products are contiguous and
+ *  vectorized by the compiler. Blocks of four rows of B share every load of
+ *  A, and the blocks are spread over the OpenMP threads.
+ */
+inline void Int8GemmNT(mshadow::Stream<cpu> *s, int M, int N, int K,
+                       const int8_t *A, int lda, const int8_t *B, int ldb,
+                       int32_t *C, int ldc) {
+  const int kBlock = 4;
+  const int nblock = (N + kBlock - 1) / kBlock;
+  const int64_t work = static_cast<int64_t>(M) * N * K;
+  const int omp_threads = work < engine::OpenMP::Get()->min_parallel_size() ?
+      1 : engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads) schedule(static)
+  for (int t = 0; t < M * nblock; ++t) {
+    const int i = t / nblock;
+    const int j0 = (t % nblock) * kBlock;
+    const int8_t *a = A + static_cast<int64_t>(i) * lda;
+    int32_t *c = C + static_cast<int64_t>(i) * ldc;
+    if (j0 + kBlock <= N) {
+      const int8_t *b0 = B + static_cast<int64_t>(j0) * ldb;
+      const int8_t *b1 = b0 + ldb;
+      const int8_t *b2 = b1 + ldb;
+      const int8_t *b3 = b2 + ldb;
+      int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+      for (int k = 0; k < K; ++k) {
+        const int32_t ak = a[k];
+        s0 += ak * b0[k];
+        s1 += ak * b1[k];
+        s2 += ak * b2[k];
+        s3 += ak * b3[k];
+      }
+      c[j0] = s0;
+      c[j0 + 1] = s1;
+      c[j0 + 2] = s2;
+      c[j0 + 3] = s3;
+    } else {
+      for (int j = j0; j < N; ++j) {
+        const int8_t *b = B + static_cast<int64_t>(j) * ldb;
+        int32_t sum = 0;
+        for (int k = 0; k < K; ++k) sum += static_cast<int32_t>(a[k]) * b[k];
+        c[j] = sum;
+      }
+    }
+  }
+}
+
+/*!
+ * \brief gpu version of Int8GemmNT, the dot products use dp4a on devices of
+ *  compute capability 6.1 and above when K is a multiple of 4.
+ */
+void Int8GemmNT(mshadow::Stream<gpu> *s, int M, int N, int K,
+                const int8_t *A, int lda, const int8_t *B, int ldb,
+                int32_t *C, int ldc);
+
+/*!
+ * \brief gather the int8 patches of one image, col[p * K + k] holds the
+ *  input value k = (c * kernel_h + kh) * kernel_w + kw of the output position p.
+ */
+struct int8_im2col {
+  MSHADOW_XINLINE static void Map(int i, int8_t *col, const int8_t *data,
+                                  int height, int width, int kernel_h, int kernel_w,
+                                  int out_w, int stride_h, int stride_w,
+                                  int pad_h, int pad_w, int dilate_h, int dilate_w,
+                                  int K) {
+    const int p = i / K;
+    const int k = i % K;
+    const int kw = k % kernel_w;
+    const int kh = (k / kernel_w) % kernel_h;
+    const int c = k / (kernel_w * kernel_h);
+    const int h = (p / out_w) * stride_h - pad_h + kh * dilate_h;
+    const int w = (p % out_w) * stride_w - pad_w + kw * dilate_w;
+    col[i] = (h >= 0 && h < height && w >= 0 && w < width) ?
+        data[(static_cast<int64_t>(c) * height + h) * width + w] : 0;
+  }
+};
+
+/*! \brief number of int8 inputs of the quantized convolution and fully connected ops */
+template<typename Param>
+inline uint32_t QuantizedNumDataInputs(const NodeAttrs& attrs) {
+  return nnvm::get<Param>(attrs.parsed).no_bias ? 2 : 3;
+}
+
+/*!
+ * \brief names of the inputs of the quantized convolution and fully connected
+ *  ops: data, weight and bias followed by their ranges
+ */
+template<typename Param>
+inline std::vector<std::string> QuantizedListInputNames(const NodeAttrs& attrs) {
+  std::vector<std::string> names{"data", "weight", "bias"};
+  names.resize(QuantizedNumDataInputs<Param>(attrs));
+  const size_t n = names.size();
+  for (size_t i = 0; i < n; ++i) {
+    names.push_back("min_" + names[i]);
+    names.push_back("max_" + names[i]);
+  }
+  return names;
+}
+
+inline std::vector<std::string> QuantizedListOutputNames(const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "min_output", "max_output"};
+}
+
+/*!
+ * \brief types of the quantized convolution and fully connected ops,
+ *  int8 inputs with float ranges giving int32 outputs
+ */
+template<typename Param>
+inline bool QuantizedGemmType(const nnvm::NodeAttrs& attrs,
+                              std::vector<int> *in_attrs,
+                              std::vector<int> *out_attrs) {
+  const uint32_t n = QuantizedNumDataInputs<Param>(attrs);
+  CHECK_EQ(in_attrs->size(), 3 * n);
+  CHECK_EQ(out_attrs->size(), 3U);
+  for (uint32_t i = 0; i < n; ++i) {
+    TYPE_ASSIGN_CHECK(*in_attrs, i, mshadow::kInt8);
+  }
+  for (uint32_t i = n; i < 3 * n; ++i) {
+    TYPE_ASSIGN_CHECK(*in_attrs, i, mshadow::kFloat32);
+  }
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kInt32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::kFloat32);
+  return true;
+}
+
+/*! \brief types of the operators from int8 data with its range to int8 data */
+inline bool QuantizedInt8Type(const nnvm::NodeAttrs& attrs,
+                              std::vector<int> *in_attrs,
+                              std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_attrs, 1, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*in_attrs, 2, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::kFloat32);
+  return true;
+}
+
+/*!
+ * \brief create the node of the quantized operator op_name with the
+ *  attributes of the float node attrs, for FQuantizedOp
+ */
+inline nnvm::NodePtr CreateQuantizedNode(const std::string& op_name,
+                                         const nnvm::NodeAttrs& attrs) {
+  nnvm::NodePtr node = nnvm::Node::Create();
+  node->attrs.op = nnvm::Op::Get(op_name);
+  node->attrs.name = attrs.name + "_quantized";
+  node->attrs.dict = attrs.dict;
+  if (node->op()->attr_parser != nullptr) {
+    node->op()->attr_parser(&(node->attrs));
+  }
+  return node;
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
@@ -30,6 +30,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
+#include "./quantization_utils.h"
 
 namespace mxnet {
 namespace op {
@@ -39,8 +40,10 @@ struct QuantizeParam : public dmlc::Parameter<QuantizeParam> {
   DMLC_DECLARE_PARAMETER(QuantizeParam) {
     DMLC_DECLARE_FIELD(out_type)
     .add_enum("uint8", mshadow::kUint8)
+    .add_enum("int8", mshadow::kInt8)
     .set_default(mshadow::kUint8)
-    .describe("Output data type.");
+    .describe("Output data type. int8 values are symmetric around 0, with "
+              "max(|min_range|, |max_range|) mapped to 127.");
   }
 };
 
@@ -57,6 +60,19 @@ struct quantize {
   }
 };
 
+struct quantize_int8 {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, float *omin_range,
+                                  float *omax_range, const float *in,
+                                  const float *imin_range, const float *imax_range) {
+    const float r = MaxAbs(*imin_range, *imax_range);
+    out[i] = FloatToQuantized<int8_t>(in[i], r);
+    if (i == 0) {
+      *omin_range = -r;
+      *omax_range = r;
+    }
+  }
+};
+
 template<typename xpu>
 void QuantizeCompute(const nnvm::NodeAttrs& attrs,
                      const OpContext& ctx,
@@ -68,7 +84,13 @@ void QuantizeCompute(const nnvm::NodeAttrs& attrs,
   Stream<xpu> *s = ctx.get_stream<xpu>();
 
   const QuantizeParam& param = nnvm::get<QuantizeParam>(attrs.parsed);
-  // for now, only supports quantize from uint8 to float
+  if (param.out_type == mshadow::kInt8) {
+    Kernel<quantize_int8, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<int8_t>(), outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+      inputs[0].dptr<float>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+    return;
+  }
+  // for now, only supports quantize from float to uint8
   // TODO(ziheng) consider add MSHADOW_INTEGER_TYPE_SWITCH
   typedef uint8_t DstDType;
   typedef float SrcDType;
@@ -108,7 +130,7 @@ inline bool QuantizeType(const nnvm::NodeAttrs& attrs,
     << "the second input of `quantize` should be a tensor with type of float";
   CHECK_EQ((*in_attrs)[2], mshadow::kFloat32)
     << "the third input of `quantize` should be a tensor with type of float";
-  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kUint8);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, param.out_type);
   TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
   TYPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::kFloat32);
   return (*in_attrs)[0] != -1;
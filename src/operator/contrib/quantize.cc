@@ -37,6 +37,12 @@ the input data. Each value of the tensor will undergo the following:
 `out[i] = (in[i] - min_range) * range(OUTPUT_TYPE) / (max_range - min_range)`
 
 here `range(T) = numeric_limits<T>::max() - numeric_limits<T>::min()`
+
+With `out_type` int8 the quantization is symmetric, with `r = max(|min_range|, |max_range|)`:
+
+`out[i] = sign(in[i]) * min(|in[i]| * 127 / r + 0.5, 127)`
+
+and the output range is `[-r, r]`. The int8 operators expect this form.
 )code" ADD_FILELINE)
 .set_attr_parser(ParamParser<QuantizeParam>)
 .set_num_inputs(3)
@@ -0,0 +1,250 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantize_graph_pass.cc
+ * \brief Replace the supported operators of a float graph by their int8
+ *  versions, and set the calibrated ranges of the quantized graph.
+ */
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace op {
+
+using nnvm::Graph;
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::NodePtr;
+using nnvm::Op;
+
+namespace {
+/*! \brief an int8 entry and the entries of its range */
+struct QuantizedEntry {
+  NodeEntry data;
+  NodeEntry min;
+  NodeEntry max;
+};
+
+/*! \brief create a node of op_name, or a variable if op_name is empty */
+NodePtr CreateNode(const std::string& op_name, const std::string& name) {
+  NodePtr node = Node::Create();
+  node->attrs.name = name;
+  node->attrs.op = op_name.empty() ? nullptr : Op::Get(op_name);
+  return node;
+}
+
+void ParseAttrs(const NodePtr& node) {
+  if (node->op()->attr_parser != nullptr) {
+    node->op()->attr_parser(&(node->attrs));
+  }
+}
+
+/*! \brief the name of an output of a node in the names of the inserted nodes */
+std::string EntryName(const NodeEntry& e) {
+  if (e.node->num_outputs() == 1) return e.node->attrs.name;
+  return e.node->attrs.name + std::to_string(e.index);
+}
+
+std::string FloatToString(float value) {
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+  return os.str();
+}
+}  // namespace
+
+/*!
+ * \brief replace the nodes registering FQuantizedOp by their int8 versions.
+ *
+ *  The float inputs of a quantized node go through a quantize node with the
+ *  range given by min and max nodes, except the parameters listed in
+ *  "offline_params", which are replaced by the variables <name>_quantize,
+ *  <name>_min and <name>_max holding their int8 values and range. The int32
+ *  outputs of the operators registering FNeedRequantize are converted to
+ *  int8 by a requantize node named <name>_requantize. The int8 outputs used
+ *  by float nodes go through a dequantize node. The operators without
+ *  requantization, such as pooling and relu, are only quantized when their
+ *  input already is, as they are too cheap to pay for a quantization.
+ *  The nodes whose names are in "excluded_nodes" are kept in float.
+ */
+Graph QuantizeGraph(Graph src) {
+  static const auto& quantized_op_map = Op::GetAttr<FQuantizedOp>("FQuantizedOp");
+  static const auto& need_requantize_map = Op::GetAttr<FNeedRequantize>("FNeedRequantize");
+  const auto& excluded_nodes = src.GetAttr<std::unordered_set<std::string> >("excluded_nodes");
+  const auto& offline_params = src.GetAttr<std::unordered_set<std::string> >("offline_params");
+
+  // the node of the new graph computing every node of src, for the quantized
+  // nodes its outputs are the int8 outputs followed by their ranges
+  std::unordered_map<const Node*, NodePtr> mirror;
+  std::unordered_set<const Node*> quantized;
+  // the inserted quantize and dequantize nodes, shared by all the uses of an entry
+  std::map<std::pair<const Node*, uint32_t>, QuantizedEntry> int8_entries;
+  std::map<std::pair<const Node*, uint32_t>, NodeEntry> float_entries;
+
+  auto float_entry = [&](const NodeEntry& e) -> NodeEntry {
+    const NodePtr& m = mirror.at(e.node.get());
+    if (!quantized.count(e.node.get())) return NodeEntry{m, e.index, e.version};
+    const auto key = std::make_pair(e.node.get(), e.index);
+    auto it = float_entries.find(key);
+    if (it != float_entries.end()) return it->second;
+    const uint32_t n = e.node->num_outputs();
+    NodePtr dequantize = CreateNode("_contrib_dequantize", EntryName(e) + "_dequantize");
+    dequantize->inputs.emplace_back(NodeEntry{m, e.index, 0});
+    dequantize->inputs.emplace_back(NodeEntry{m, n + 2 * e.index, 0});
+    dequantize->inputs.emplace_back(NodeEntry{m, n + 2 * e.index + 1, 0});
+    dequantize->attrs.dict["out_type"] = "float32";
+    ParseAttrs(dequantize);
+    return float_entries[key] = NodeEntry{dequantize, 0, 0};
+  };
+
+  auto int8_entry = [&](const NodeEntry& e) -> QuantizedEntry {
+    const NodePtr& m = mirror.at(e.node.get());
+    if (quantized.count(e.node.get())) {
+      const uint32_t n = e.node->num_outputs();
+      return QuantizedEntry{NodeEntry{m, e.index, 0}, NodeEntry{m, n + 2 * e.index, 0},
+                            NodeEntry{m, n + 2 * e.index + 1, 0}};
+    }
+    const auto key = std::make_pair(e.node.get(), e.index);
+    auto it = int8_entries.find(key);
+    if (it != int8_entries.end()) return it->second;
+    const std::string name = EntryName(e);
+    QuantizedEntry ret;
+    if (e.node->is_variable() && offline_params.count(name)) {
+      ret.data = NodeEntry{CreateNode("", name + "_quantize"), 0, 0};
+      ret.min = NodeEntry{CreateNode("", name + "_min"), 0, 0};
+      ret.max = NodeEntry{CreateNode("", name + "_max"), 0, 0};
+    } else {
+      const NodeEntry input{m, e.index, e.version};
+      NodePtr min_node = CreateNode("min", name + "_min");
+      min_node->inputs.emplace_back(input);
+      ParseAttrs(min_node);
+      NodePtr max_node = CreateNode("max", name + "_max");
+      max_node->inputs.emplace_back(input);
+      ParseAttrs(max_node);
+      NodePtr quantize = CreateNode("_contrib_quantize", name + "_quantize");
+      quantize->inputs.emplace_back(input);
+      quantize->inputs.emplace_back(NodeEntry{min_node, 0, 0});
+      quantize->inputs.emplace_back(NodeEntry{max_node, 0, 0});
+      quantize->attrs.dict["out_type"] = "int8";
+      ParseAttrs(quantize);
+      ret = QuantizedEntry{NodeEntry{quantize, 0, 0}, NodeEntry{quantize, 1, 0},
+                           NodeEntry{quantize, 2, 0}};
+    }
+    return int8_entries[key] = ret;
+  };
+
+  nnvm::DFSVisit(src.outputs, [&](const NodePtr& node) {
+    // the variables are kept, as the executor identifies them by address
+    if (node->is_variable()) {
+      mirror[node.get()] = node;
+      return;
+    }
+    NodePtr qnode;
+    bool requantize = false;
+    if (!excluded_nodes.count(node->attrs.name) && quantized_op_map.count(node->op())) {
+      qnode = quantized_op_map[node->op()](node->attrs);
+      requantize = qnode != nullptr && need_requantize_map.count(qnode->op()) &&
+          need_requantize_map[qnode->op()](qnode->attrs);
+      if (qnode != nullptr && !requantize && !quantized.count(node->inputs[0].node.get())) {
+        qnode = nullptr;
+      }
+    }
+    if (qnode == nullptr) {
+      NodePtr copy = Node::Create();
+      copy->attrs = node->attrs;
+      for (const auto& e : node->inputs) copy->inputs.push_back(float_entry(e));
+      for (const auto& dep : node->control_deps) {
+        copy->control_deps.push_back(mirror.at(dep.get()));
+      }
+      mirror[node.get()] = copy;
+      return;
+    }
+    std::vector<QuantizedEntry> inputs;
+    for (const auto& e : node->inputs) inputs.push_back(int8_entry(e));
+    for (const auto& q : inputs) qnode->inputs.push_back(q.data);
+    for (const auto& q : inputs) {
+      qnode->inputs.push_back(q.min);
+      qnode->inputs.push_back(q.max);
+    }
+    for (const auto& dep : node->control_deps) {
+      qnode->control_deps.push_back(mirror.at(dep.get()));
+    }
+    if (requantize) {
+      NodePtr requantize_node = CreateNode("_contrib_requantize",
+                                           node->attrs.name + "_requantize");
+      for (uint32_t i = 0; i < 3; ++i) {
+        requantize_node->inputs.emplace_back(NodeEntry{qnode, i, 0});
+      }
+      ParseAttrs(requantize_node);
+      qnode = requantize_node;
+    }
+    mirror[node.get()] = qnode;
+    quantized.insert(node.get());
+  });
+
+  Graph ret;
+  for (const auto& e : src.outputs) ret.outputs.push_back(float_entry(e));
+  return ret;
+}
+
+/*!
+ * \brief set the ranges of the requantize nodes of a quantized graph from
+ *  "calib_table", which maps the name of the output of a float layer,
+ *  <name>_output, to the range of its values.
+ */
+Graph SetCalibTableToQuantizedGraph(Graph g) {
+  static const Op* requantize_op = Op::Get("_contrib_requantize");
+  static const std::string suffix = "_requantize";
+  const auto& calib_table =
+      g.GetAttr<std::unordered_map<std::string, std::pair<float, float> > >("calib_table");
+  nnvm::DFSVisit(g.outputs, [&](const NodePtr& node) {
+    const std::string& name = node->attrs.name;
+    if (node->op() != requantize_op || name.size() <= suffix.size()) return;
+    auto it = calib_table.find(name.substr(0, name.size() - suffix.size()) + "_output");
+    if (it == calib_table.end()) return;
+    node->attrs.dict["min_calib_range"] = FloatToString(it->second.first);
+    node->attrs.dict["max_calib_range"] = FloatToString(it->second.second);
+    ParseAttrs(node);
+  });
+  return g;
+}
+
+NNVM_REGISTER_PASS(QuantizeGraph)
+.describe("Return a graph running the supported operators of src on int8 data")
+.set_body(QuantizeGraph)
+.set_change_graph(true);
+
+NNVM_REGISTER_PASS(SetCalibTableToQuantizedGraph)
+.describe("Set the calibrated ranges of the requantize operators of a quantized graph")
+.set_body(SetCalibTableToQuantizedGraph)
+.set_change_graph(false);
+
+}  // namespace op
+}  // namespace mxnet
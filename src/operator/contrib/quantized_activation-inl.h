@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_activation-inl.h
+ * \brief relu of int8 data
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_ACTIVATION_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_ACTIVATION_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../activation-inl.h"
+#include "../elemwise_op_common.h"
+#include "../mxnet_op.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+inline bool QuantizedActivationShape(const nnvm::NodeAttrs& attrs,
+                                     std::vector<TShape> *in_shape,
+                                     std::vector<TShape> *out_shape) {
+  const ActivationParam& param = nnvm::get<ActivationParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 3U);
+  CHECK_EQ(param.act_type, activation::kReLU)
+    << "quantized_act only supports the relu activation";
+  SHAPE_ASSIGN_CHECK(*in_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*in_shape, 2, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 2, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, in_shape->at(0));
+  SHAPE_ASSIGN_CHECK(*in_shape, 0, out_shape->at(0));
+  return !shape_is_none(out_shape->at(0));
+}
+
+struct quantized_relu {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, const int8_t *in) {
+    out[i] = in[i] > 0 ? in[i] : 0;
+  }
+};
+
+template<typename xpu>
+void QuantizedActivationCompute(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<TBlob>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  CHECK(req[0] == kWriteTo || req[0] == kWriteInplace)
+    << "quantized_act only supports kWriteTo and kWriteInplace";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  Kernel<quantized_relu, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<int8_t>(),
+                                      inputs[0].dptr<int8_t>());
+  Kernel<quantized_range_copy, xpu>::Launch(s, 1, outputs[1].dptr<float>(),
+    outputs[2].dptr<float>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_ACTIVATION_INL_H_
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_conv-inl.h
+ * \brief int8 convolution with int32 outputs
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_CONV_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_CONV_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <string>
+#include <vector>
+#include "../convolution-inl.h"
+#include "../elemwise_op_common.h"
+#include "../mxnet_op.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief parse the convolution parameter, filling the defaults of 2D convolutions */
+inline void QuantizedConvParamParser(nnvm::NodeAttrs* attrs) {
+  using namespace mshadow;
+  ConvolutionParam param;
+  param.Init(attrs->dict);
+  if (param.kernel.ndim() == 2) {
+    param.layout = param.layout ? param.layout.value() : mshadow::kNCHW;
+    if (param.stride.ndim() == 0) param.stride = Shape2(1, 1);
+    if (param.dilate.ndim() == 0) param.dilate = Shape2(1, 1);
+    if (param.pad.ndim() == 0) param.pad = Shape2(0, 0);
+  }
+  attrs->parsed = std::move(param);
+}
+
+inline bool QuantizedConvShape(const nnvm::NodeAttrs& attrs,
+                               std::vector<TShape> *in_shape,
+                               std::vector<TShape> *out_shape) {
+  using namespace mshadow;
+  const ConvolutionParam& param = nnvm::get<ConvolutionParam>(attrs.parsed);
+  const uint32_t n = QuantizedNumDataInputs<ConvolutionParam>(attrs);
+  CHECK_EQ(in_shape->size(), 3 * n);
+  CHECK_EQ(out_shape->size(), 3U);
+  CHECK_EQ(param.kernel.ndim(), 2U) << "quantized_conv only supports 2D convolution";
+  CHECK_EQ(param.layout.value(), mshadow::kNCHW) << "quantized_conv only supports NCHW layout";
+  for (uint32_t i = n; i < 3 * n; ++i) {
+    SHAPE_ASSIGN_CHECK(*in_shape, i, TShape{1});
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 2, TShape{1});
+  const TShape& dshape = in_shape->at(0);
+  if (shape_is_none(dshape)) return false;
+  CHECK_EQ(dshape.ndim(), 4U) << "quantized_conv expects input data of shape (N, C, H, W)";
+  CHECK_EQ(dshape[1] % param.num_group, 0U)
+    << "input num_filter must divide group size";
+  CHECK_EQ(param.num_filter % param.num_group, 0U)
+    << "output num_filter must divide group size";
+  SHAPE_ASSIGN_CHECK(*in_shape, 1, Shape4(param.num_filter, dshape[1] / param.num_group,
+                                          param.kernel[0], param.kernel[1]));
+  if (!param.no_bias) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 2, Shape1(param.num_filter));
+  }
+  const index_t dilated_h = param.DilatedKernelSize(0);
+  const index_t dilated_w = param.DilatedKernelSize(1);
+  CHECK(dilated_h <= dshape[2] + 2 * param.pad[0] && dilated_w <= dshape[3] + 2 * param.pad[1])
+    << "kernel size exceed input";
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, Shape4(dshape[0], param.num_filter,
+      (dshape[2] + 2 * param.pad[0] - dilated_h) / param.stride[0] + 1,
+      (dshape[3] + 2 * param.pad[1] - dilated_w) / param.stride[1] + 1));
+  return true;
+}
+
+template<typename xpu>
+void QuantizedConvCompute(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const ConvolutionParam& param = nnvm::get<ConvolutionParam>(attrs.parsed);
+  const uint32_t n = QuantizedNumDataInputs<ConvolutionParam>(attrs);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_conv only supports kWriteTo";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TShape& dshape = inputs[0].shape_;
+  const TShape& oshape = outputs[0].shape_;
+  const int channels = dshape[1], height = dshape[2], width = dshape[3];
+  const int kernel_h = param.kernel[0], kernel_w = param.kernel[1];
+  const int out_h = oshape[2], out_w = oshape[3];
+  const int group = param.num_group;
+  const int filters = param.num_filter / group;
+  // length of the patches of all channels, and of the channels of a group
+  const int col_k = channels * kernel_h * kernel_w;
+  const int group_k = col_k / group;
+  const int positions = out_h * out_w;
+  Tensor<xpu, 1, int8_t> col = ctx.requested[0].get_space_typed<xpu, 1, int8_t>(
+      Shape1(positions * col_k), s);
+  const int8_t *data = inputs[0].dptr<int8_t>();
+  const int8_t *weight = inputs[1].dptr<int8_t>();
+  int32_t *out = outputs[0].dptr<int32_t>();
+  for (index_t b = 0; b < dshape[0]; ++b) {
+    Kernel<int8_im2col, xpu>::Launch(s, positions * col_k, col.dptr_,
+      data + static_cast<int64_t>(b) * channels * height * width, height, width,
+      kernel_h, kernel_w, out_w, param.stride[0], param.stride[1], param.pad[0],
+      param.pad[1], param.dilate[0], param.dilate[1], col_k);
+    for (int g = 0; g < group; ++g) {
+      Int8GemmNT(s, filters, positions, group_k,
+                 weight + static_cast<int64_t>(g) * filters * group_k, group_k,
+                 col.dptr_ + g * group_k, col_k,
+                 out + (static_cast<int64_t>(b) * param.num_filter + g * filters) * positions,
+                 positions);
+    }
+  }
+  float *min_out = outputs[1].dptr<float>();
+  float *max_out = outputs[2].dptr<float>();
+  Kernel<quantization_range_for_multiplication, xpu>::Launch(s, 1, min_out, max_out,
+    inputs[n].dptr<float>(), inputs[n + 1].dptr<float>(),
+    inputs[n + 2].dptr<float>(), inputs[n + 3].dptr<float>());
+  if (!param.no_bias) {
+    Kernel<quantized_bias_add, xpu>::Launch(s, outputs[0].Size(), out,
+      inputs[2].dptr<int8_t>(), min_out, max_out, inputs[n + 4].dptr<float>(),
+      inputs[n + 5].dptr<float>(), static_cast<int>(param.num_filter), positions);
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_CONV_INL_H_
@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file quantized_embedding-inl.h
+ * \brief embedding lookup in an int8 or float16 weight, dequantized by row
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_EMBEDDING_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_EMBEDDING_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <cmath>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace qembedding {
+enum QuantizedEmbeddingOpInputs {kData, kWeight, kScale};
+enum QuantizedEmbeddingUpdateInputs {kUpdateWeight, kUpdateScale, kRows};
+}  // namespace qembedding
+
+struct QuantizedEmbeddingParam : public dmlc::Parameter<QuantizedEmbeddingParam> {
+  int input_dim;
+  int output_dim;
+  int dtype;
+  DMLC_DECLARE_PARAMETER(QuantizedEmbeddingParam) {
+    DMLC_DECLARE_FIELD(input_dim).set_lower_bound(1)
+    .describe("Vocabulary size of the input indices.");
+    DMLC_DECLARE_FIELD(output_dim).set_lower_bound(1)
+    .describe("Dimension of the embedding vectors.");
+    DMLC_DECLARE_FIELD(dtype).set_default(mshadow::kInt8)
+    .add_enum("int8", mshadow::kInt8)
+    .add_enum("float16", mshadow::kFloat16)
+    .describe("Data type of weight.");
+  }
+};
+
+/*! \brief switch over the types of the weights of a quantized embedding */
+#define QUANTIZED_EMBEDDING_TYPE_SWITCH(type, WType, ...)              \
+  switch (type) {                                                    \
+  case mshadow::kInt8:                                               \
+    {                                                                \
+      typedef int8_t WType;                                          \
+      {__VA_ARGS__}                                                  \
+    }                                                                \
+    break;                                                           \
+  case mshadow::kFloat16:                                            \
+    {                                                                \
+      typedef mshadow::half::half_t WType;                           \
+      {__VA_ARGS__}                                                  \
+    }                                                                \
+    break;                                                           \
+  default:                                                           \
+    LOG(FATAL) << "The weight of a quantized embedding must be int8 or float16"; \
+  }
+
+inline bool QuantizedEmbeddingShape(const nnvm::NodeAttrs& attrs,
+                                    std::vector<TShape> *in_attrs,
+                                    std::vector<TShape> *out_attrs) {
+  using namespace mshadow;
+  const QuantizedEmbeddingParam& param = nnvm::get<QuantizedEmbeddingParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  SHAPE_ASSIGN_CHECK(*in_attrs, qembedding::kWeight, Shape2(param.input_dim, param.output_dim));
+  SHAPE_ASSIGN_CHECK(*in_attrs, qembedding::kScale, Shape1(param.input_dim));
+  const TShape &dshape = (*in_attrs)[qembedding::kData];
+  if (dshape.ndim() == 0) return false;
+  TShape oshape(dshape.ndim() + 1);
+  for (size_t i = 0; i < dshape.ndim(); ++i) {
+    oshape[i] = dshape[i];
+  }
+  oshape[dshape.ndim()] = param.output_dim;
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, oshape);
+  return true;
+}
+
+inline bool QuantizedEmbeddingType(const nnvm::NodeAttrs& attrs,
+                                   std::vector<int> *in_attrs,
+                                   std::vector<int> *out_attrs) {
+  const QuantizedEmbeddingParam& param = nnvm::get<QuantizedEmbeddingParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  CHECK_NE((*in_attrs)[qembedding::kData], -1) << "First input must have specified type";
+  TYPE_ASSIGN_CHECK(*in_attrs, qembedding::kWeight, param.dtype);
+  TYPE_ASSIGN_CHECK(*in_attrs, qembedding::kScale, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kFloat32);
+  return true;
+}
+
+inline bool QuantizedEmbeddingStorageType(const nnvm::NodeAttrs& attrs,
+                                          const Context& ctx,
+                                          std::vector<int> *in_attrs,
+                                          std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  // the weight is either dense or the row_sparse result of a row_sparse_pull
+  type_assign(&((*in_attrs)[qembedding::kScale]), kDefaultStorage);
+  type_assign(&((*out_attrs)[0]), kDefaultStorage);
+  return true;
+}
+
+/*!
+ * \brief lookup of the rows idx of the K x M weight, multiplied by their
+ *  scale, i is the index of the element of the output
+ */
+struct QuantizedTake {
+  template<typename WType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, float* out, const WType* weight, const float* scale,
+                                  const IType* idx, const nnvm::dim_t M, const nnvm::dim_t K) {
+    using nnvm::dim_t;
+    dim_t j = static_cast<dim_t>(idx[i / M]);
+    if (j <= 0) j = 0;
+    else if (j >= K) j = K - 1;
+    out[i] = static_cast<float>(weight[j * M + i % M]) * scale[j];
+  }
+};
+
+/*!
+ * \brief lookup in a row_sparse weight, whose nnr sorted row indices are
+ *  weight_idx, the rows missing from the weight are zeros
+ */
+struct QuantizedTakeRsp {
+  template<typename WType, typename IType, typename RType>
+  MSHADOW_XINLINE static void Map(int i, float* out, const WType* weight, const float* scale,
+                                  const RType* weight_idx, const IType* idx,
+                                  const nnvm::dim_t M, const nnvm::dim_t K,
+                                  const nnvm::dim_t nnr) {
+    using nnvm::dim_t;
+    dim_t j = static_cast<dim_t>(idx[i / M]);
+    if (j <= 0) j = 0;
+    else if (j >= K) j = K - 1;
+    dim_t lo = 0, hi = nnr;
+    while (lo < hi) {
+      const dim_t mid = lo + (hi - lo) / 2;
+      if (static_cast<dim_t>(weight_idx[mid]) < j) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    out[i] = (lo < nnr && static_cast<dim_t>(weight_idx[lo]) == j) ?
+             static_cast<float>(weight[lo * M + i % M]) * scale[j] : 0.0f;
+  }
+};
+
+template<typename xpu>
+void QuantizedEmbeddingForward(const nnvm::NodeAttrs& attrs,
+                               const OpContext& ctx,
+                               const std::vector<TBlob>& inputs,
+                               const std::vector<OpReqType>& req,
+                               const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  CHECK_EQ(req[0], kWriteTo);
+  const TBlob& weight = inputs[qembedding::kWeight];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  QUANTIZED_EMBEDDING_TYPE_SWITCH(weight.type_flag_, WType, {
+    MSHADOW_TYPE_SWITCH(inputs[qembedding::kData].type_flag_, IType, {
+      Kernel<QuantizedTake, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<float>(),
+        weight.dptr<WType>(), inputs[qembedding::kScale].dptr<float>(),
+        inputs[qembedding::kData].dptr<IType>(),
+        static_cast<nnvm::dim_t>(weight.shape_[1]), static_cast<nnvm::dim_t>(weight.shape_[0]));
+    });
+  });
+}
+
+template<typename xpu>
+void QuantizedEmbeddingForwardEx(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<NDArray>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<NDArray>& outputs) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  CHECK_EQ(req[0], kWriteTo);
+  const NDArray& data = inputs[qembedding::kData];
+  const NDArray& weight = inputs[qembedding::kWeight];
+  const TBlob out = outputs[0].data();
+  CHECK_EQ(data.storage_type(), kDefaultStorage);
+  CHECK_EQ(inputs[qembedding::kScale].storage_type(), kDefaultStorage);
+  CHECK_EQ(weight.storage_type(), kRowSparseStorage)
+    << "quantized_embedding expects a default or row_sparse weight";
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  if (!weight.storage_initialized()) {
+    Kernel<set_zero, xpu>::Launch(s, out.Size(), out.dptr<float>());
+    return;
+  }
+  QUANTIZED_EMBEDDING_TYPE_SWITCH(weight.dtype(), WType, {
+    MSHADOW_TYPE_SWITCH(data.dtype(), IType, {
+      MSHADOW_IDX_TYPE_SWITCH(weight.aux_type(kIdx), RType, {
+        Kernel<QuantizedTakeRsp, xpu>::Launch(s, out.Size(), out.dptr<float>(),
+          weight.data().dptr<WType>(), inputs[qembedding::kScale].data().dptr<float>(),
+          weight.aux_data(kIdx).dptr<RType>(), data.data().dptr<IType>(),
+          static_cast<nnvm::dim_t>(weight.shape()[1]),
+          static_cast<nnvm::dim_t>(weight.shape()[0]),
+          static_cast<nnvm::dim_t>(weight.aux_shape(kIdx)[0]));
+      });
+    });
+  });
+}
+
+/*! \brief scale of a row stored as int8, which maps its largest magnitude to 127 */
+MSHADOW_XINLINE float QuantizedRowScale(const float* row, nnvm::dim_t M, int8_t) {
+  float amax = 0.0f;
+  for (nnvm::dim_t k = 0; k < M; ++k) {
+    amax = fmaxf(amax, fabsf(row[k]));
+  }
+  return amax / 127.0f;
+}
+
+/*! \brief rows stored as float16 keep their values */
+MSHADOW_XINLINE float QuantizedRowScale(const float* row, nnvm::dim_t M, mshadow::half::half_t) {
+  return 1.0f;
+}
+
+MSHADOW_XINLINE void QuantizeValue(float value, float inv_scale, int8_t* out) {
+  *out = static_cast<int8_t>(fminf(fmaxf(roundf(value * inv_scale), -127.0f), 127.0f));
+}
+
+MSHADOW_XINLINE void QuantizeValue(float value, float inv_scale, mshadow::half::half_t* out) {
+  *out = mshadow::half::half_t(value);
+}
+
+/*!
+ * \brief store the r-th of the float32 rows, whose row index is row_idx[r],
+ *  or r if row_idx is null, in the weight and its scale
+ */
+struct QuantizeRowsKernel {
+  template<typename WType, typename RType>
+  MSHADOW_XINLINE static void Map(int r, WType* weight, float* scale, const float* rows,
+                                  const RType* row_idx, const nnvm::dim_t M) {
+    const nnvm::dim_t j = row_idx ? static_cast<nnvm::dim_t>(row_idx[r]) : r;
+    const float* src = rows + r * M;
+    const float row_scale = QuantizedRowScale(src, M, WType());
+    const float inv_scale = row_scale > 0.0f ? 1.0f / row_scale : 0.0f;
+    for (nnvm::dim_t k = 0; k < M; ++k) {
+      QuantizeValue(src[k], inv_scale, weight + j * M + k);
+    }
+    scale[j] = row_scale;
+  }
+};
+
+inline bool QuantizedEmbeddingUpdateShape(const nnvm::NodeAttrs& attrs,
+                                          std::vector<TShape> *in_attrs,
+                                          std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  SHAPE_ASSIGN_CHECK(*in_attrs, qembedding::kRows, (*in_attrs)[qembedding::kUpdateWeight]);
+  SHAPE_ASSIGN_CHECK(*in_attrs, qembedding::kUpdateWeight, (*in_attrs)[qembedding::kRows]);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, (*in_attrs)[qembedding::kUpdateWeight]);
+  const TShape& wshape = (*in_attrs)[qembedding::kUpdateWeight];
+  if (wshape.ndim() == 0) return false;
+  CHECK_EQ(wshape.ndim(), 2U) << "The weight of a quantized embedding must be 2D";
+  SHAPE_ASSIGN_CHECK(*in_attrs, qembedding::kUpdateScale, mshadow::Shape1(wshape[0]));
+  return true;
+}
+
+inline bool QuantizedEmbeddingUpdateType(const nnvm::NodeAttrs& attrs,
+                                         std::vector<int> *in_attrs,
+                                         std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, (*in_attrs)[qembedding::kUpdateWeight]);
+  TYPE_ASSIGN_CHECK(*in_attrs, qembedding::kUpdateWeight, (*out_attrs)[0]);
+  TYPE_ASSIGN_CHECK(*in_attrs, qembedding::kUpdateScale, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*in_attrs, qembedding::kRows, mshadow::kFloat32);
+  return (*in_attrs)[qembedding::kUpdateWeight] != -1;
+}
+
+inline bool QuantizedEmbeddingUpdateStorageType(const nnvm::NodeAttrs& attrs,
+                                                const Context& ctx,
+                                                std::vector<int> *in_attrs,
+                                                std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  type_assign(&((*in_attrs)[qembedding::kUpdateWeight]), kDefaultStorage);
+  type_assign(&((*in_attrs)[qembedding::kUpdateScale]), kDefaultStorage);
+  type_assign(&((*out_attrs)[0]), kDefaultStorage);
+  return true;
+}
+
+/*! \brief requantize all the rows of the weight from the dense rows */
+template<typename xpu>
+void QuantizedEmbeddingUpdate(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx,
+                              const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK(req[0] == kWriteTo || req[0] == kWriteInplace)
+    << "quantized_embedding_update does not support kAddTo";
+  const TBlob& rows = inputs[qembedding::kRows];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  QUANTIZED_EMBEDDING_TYPE_SWITCH(outputs[0].type_flag_, WType, {
+    Kernel<QuantizeRowsKernel, xpu>::Launch(s, rows.shape_[0], outputs[0].dptr<WType>(),
+      inputs[qembedding::kUpdateScale].dptr<float>(), rows.dptr<float>(),
+      static_cast<const int64_t*>(nullptr), static_cast<nnvm::dim_t>(rows.shape_[1]));
+  });
+}
+
+/*! \brief requantize the rows of the weight which are in the row_sparse rows */
+template<typename xpu>
+void QuantizedEmbeddingUpdateEx(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<NDArray>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<NDArray>& outputs) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  const NDArray& rows = inputs[qembedding::kRows];
+  CHECK_EQ(rows.storage_type(), kRowSparseStorage)
+    << "quantized_embedding_update expects default or row_sparse rows";
+  if (!rows.storage_initialized()) return;
+  const TBlob weight = outputs[0].data();
+  CHECK_EQ(weight.dptr_, inputs[qembedding::kUpdateWeight].data().dptr_)
+    << "quantized_embedding_update only writes the rows given, out must be the weight";
+  const TBlob rows_data = rows.data();
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  QUANTIZED_EMBEDDING_TYPE_SWITCH(weight.type_flag_, WType, {
+    MSHADOW_IDX_TYPE_SWITCH(rows.aux_type(kIdx), RType, {
+      Kernel<QuantizeRowsKernel, xpu>::Launch(s, rows_data.shape_[0], weight.dptr<WType>(),
+        inputs[qembedding::kUpdateScale].data().dptr<float>(), rows_data.dptr<float>(),
+        rows.aux_data(kIdx).dptr<RType>(), static_cast<nnvm::dim_t>(weight.shape_[1]));
+    });
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_EMBEDDING_INL_H_
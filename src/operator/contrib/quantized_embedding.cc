@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file quantized_embedding.cc
+ * \brief embedding lookup in an int8 or float16 weight, dequantized by row
+ */
+#include "./quantized_embedding-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(QuantizedEmbeddingParam);
+
+NNVM_REGISTER_OP(_contrib_quantized_embedding)
+.describe(R"code(Maps integer indices to float32 embeddings stored as int8 or float16.
+
+The weight of shape (input_dim, output_dim) has type ``dtype``, and every row has a
+float32 scale, so that the embedding of the index j is::
+
+  out = weight[j] * scale[j]
+
+computed by the lookup without dequantizing the whole weight. An int8 weight takes a
+quarter of the memory of a float32 one, and a float16 weight, whose scales are usually
+ones, half of it. The weight and scales are written from float32 rows
+by ``quantized_embedding_update``.
+
+The weight can have the default storage type, or ``row_sparse`` storage type, as the
+output of ``kvstore.row_sparse_pull`` with the indices of the batch. The lookup of a row
+that is missing from a ``row_sparse`` weight gives zeros.
+
+For an input array of shape (d1, ..., dK),
+the shape of an output array is (d1, ..., dK, output_dim).
+
+Examples::
+
+  weight = [[ 127,  -64],
+            [  10,  127]]
+  scale = [0.5, 0.01]
+
+  quantized_embedding(x=[1, 0], weight, scale, input_dim=2, output_dim=2) =
+      [[  0.1,   1.27],
+       [ 63.5, -32.  ]]
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<QuantizedEmbeddingParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "weight", "scale"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedEmbeddingShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedEmbeddingType)
+.set_attr<FInferStorageType>("FInferStorageType", QuantizedEmbeddingStorageType)
+.set_attr<FCompute>("FCompute<cpu>", QuantizedEmbeddingForward<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", QuantizedEmbeddingForwardEx<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "The input array to the embedding operator.")
+.add_argument("weight", "NDArray-or-Symbol", "The int8 or float16 embedding weight matrix.")
+.add_argument("scale", "NDArray-or-Symbol", "The float32 scale of every row of the weight.")
+.add_arguments(QuantizedEmbeddingParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_quantized_embedding_update)
+.describe(R"code(Writes float32 rows into the int8 or float16 weight of
+``quantized_embedding`` and their scales.
+
+An int8 row is scaled so that its largest magnitude is 127, and rounded, a float16 row
+keeps its values and gets a scale of 1. When ``rows`` has ``row_sparse`` storage type,
+such as the rows of the weight updated by an optimizer from a ``row_sparse`` gradient, only
+its rows are written, and ``out`` must be the weight. Otherwise all the rows are written.
+The scales are updated in place.
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"weight", "scale", "rows"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedEmbeddingUpdateShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedEmbeddingUpdateType)
+.set_attr<FInferStorageType>("FInferStorageType", QuantizedEmbeddingUpdateStorageType)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{qembedding::kUpdateScale};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedEmbeddingUpdate<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", QuantizedEmbeddingUpdateEx<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "The int8 or float16 embedding weight matrix.")
+.add_argument("scale", "NDArray-or-Symbol", "The float32 scale of every row of the weight.")
+.add_argument("rows", "NDArray-or-Symbol", "The float32 rows to write.");
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_fully_connected-inl.h
+ * \brief int8 fully connected layer with int32 outputs
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_FULLY_CONNECTED_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_FULLY_CONNECTED_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <vector>
+#include "../fully_connected-inl.h"
+#include "../elemwise_op_common.h"
+#include "../mxnet_op.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+inline bool QuantizedFullyConnectedShape(const nnvm::NodeAttrs& attrs,
+                                         std::vector<TShape> *in_shape,
+                                         std::vector<TShape> *out_shape) {
+  using namespace mshadow;
+  const FullyConnectedParam& param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+  const uint32_t n = QuantizedNumDataInputs<FullyConnectedParam>(attrs);
+  CHECK_EQ(in_shape->size(), 3 * n);
+  CHECK_EQ(out_shape->size(), 3U);
+  for (uint32_t i = n; i < 3 * n; ++i) {
+    SHAPE_ASSIGN_CHECK(*in_shape, i, TShape{1});
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 2, TShape{1});
+  const TShape& dshape = in_shape->at(0);
+  if (shape_is_none(dshape)) return false;
+  index_t num_input;
+  TShape oshape;
+  if (param.flatten) {
+    num_input = dshape.ProdShape(1, dshape.ndim());
+    oshape = Shape2(dshape[0], param.num_hidden);
+  } else {
+    num_input = dshape[dshape.ndim() - 1];
+    oshape = dshape;
+    oshape[dshape.ndim() - 1] = param.num_hidden;
+  }
+  SHAPE_ASSIGN_CHECK(*in_shape, 1, Shape2(param.num_hidden, num_input));
+  if (!param.no_bias) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 2, Shape1(param.num_hidden));
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return true;
+}
+
+template<typename xpu>
+void QuantizedFullyConnectedCompute(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const FullyConnectedParam& param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+  const uint32_t n = QuantizedNumDataInputs<FullyConnectedParam>(attrs);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_fully_connected only supports kWriteTo";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const int num_hidden = param.num_hidden;
+  const int num_input = inputs[1].shape_[1];
+  const int batch = inputs[0].Size() / num_input;
+  int32_t *out = outputs[0].dptr<int32_t>();
+  Int8GemmNT(s, batch, num_hidden, num_input, inputs[0].dptr<int8_t>(), num_input,
+             inputs[1].dptr<int8_t>(), num_input, out, num_hidden);
+  float *min_out = outputs[1].dptr<float>();
+  float *max_out = outputs[2].dptr<float>();
+  Kernel<quantization_range_for_multiplication, xpu>::Launch(s, 1, min_out, max_out,
+    inputs[n].dptr<float>(), inputs[n + 1].dptr<float>(),
+    inputs[n + 2].dptr<float>(), inputs[n + 3].dptr<float>());
+  if (!param.no_bias) {
+    Kernel<quantized_bias_add, xpu>::Launch(s, outputs[0].Size(), out,
+      inputs[2].dptr<int8_t>(), min_out, max_out, inputs[n + 4].dptr<float>(),
+      inputs[n + 5].dptr<float>(), num_hidden, 1);
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_FULLY_CONNECTED_INL_H_
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_fully_connected.cc
+ * \brief
+ */
+#include "./quantized_fully_connected-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_quantized_fully_connected)
+.describe(R"code(Fully connected layer on int8 data and weight with int32 accumulation.
+
+The inputs are the int8 data, weight and bias of a FullyConnected, produced by `quantize`
+with `out_type` int8, followed by the min and max range of each of them. The outputs
+are the int32 result and its range: a unit of the result is worth the product of the
+units of the data and the weight. The bias is rescaled to this unit before it is added.
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    return 3 * QuantizedNumDataInputs<FullyConnectedParam>(attrs);
+  })
+.set_num_outputs(3)
+.set_attr_parser(ParamParser<FullyConnectedParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+                                 QuantizedListInputNames<FullyConnectedParam>)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", QuantizedListOutputNames)
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedFullyConnectedShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedGemmType<FullyConnectedParam>)
+.set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs& attrs) { return true; })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedFullyConnectedCompute<cpu>)
+.add_argument("data", "NDArray-or-Symbol", "Input data of type int8.")
+.add_argument("weight", "NDArray-or-Symbol", "Weight of type int8.")
+.add_argument("bias", "NDArray-or-Symbol", "Bias of type int8, absent if no_bias.")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data.")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data.")
+.add_argument("min_weight", "NDArray-or-Symbol", "Minimum value of weight.")
+.add_argument("max_weight", "NDArray-or-Symbol", "Maximum value of weight.")
+.add_argument("min_bias", "NDArray-or-Symbol", "Minimum value of bias.")
+.add_argument("max_bias", "NDArray-or-Symbol", "Maximum value of bias.")
+.add_arguments(FullyConnectedParam::__FIELDS__());
+
+NNVM_REGISTER_OP(FullyConnected)
+.set_attr<FQuantizedOp>("FQuantizedOp", [](const NodeAttrs& attrs) {
+    return CreateQuantizedNode("_contrib_quantized_fully_connected", attrs);
+  });
+
+}  // namespace op
+}  // namespace mxnet
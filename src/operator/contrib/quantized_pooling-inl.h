@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_pooling-inl.h
+ * \brief max and average pooling of int8 data
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_POOLING_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_POOLING_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <string>
+#include <vector>
+#include "../pooling-inl.h"
+#include "../elemwise_op_common.h"
+#include "../mxnet_op.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief parse the pooling parameter, filling the defaults of 2D poolings */
+inline void QuantizedPoolingParamParser(nnvm::NodeAttrs* attrs) {
+  using namespace mshadow;
+  PoolingParam param;
+  param.Init(attrs->dict);
+  if (param.kernel.ndim() == 2) {
+    if (param.stride.ndim() == 0) param.stride = Shape2(1, 1);
+    if (param.pad.ndim() == 0) param.pad = Shape2(0, 0);
+  }
+  attrs->parsed = std::move(param);
+}
+
+/*! \brief whether the quantized pooling supports a pooling */
+inline bool QuantizedPoolingSupported(const PoolingParam& param) {
+  return param.kernel.ndim() == 2 && param.pool_type != pool_enum::kSumPooling;
+}
+
+inline bool QuantizedPoolingShape(const nnvm::NodeAttrs& attrs,
+                                  std::vector<TShape> *in_shape,
+                                  std::vector<TShape> *out_shape) {
+  const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 3U);
+  CHECK(QuantizedPoolingSupported(param))
+    << "quantized_pooling only supports 2D max and avg pooling";
+  SHAPE_ASSIGN_CHECK(*in_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*in_shape, 2, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_shape, 2, TShape{1});
+  const TShape& dshape = in_shape->at(0);
+  if (shape_is_none(dshape)) return false;
+  CHECK_EQ(dshape.ndim(), 4U)
+    << "quantized_pooling expects input data of shape (N, C, H, W)";
+  TShape oshape = dshape;
+  if (param.global_pool) {
+    oshape[2] = 1;
+    oshape[3] = 1;
+  } else {
+    for (int i = 0; i < 2; ++i) {
+      CHECK(param.kernel[i] <= dshape[2 + i] + 2 * param.pad[i])
+        << "kernel size (" << param.kernel[i] << ") exceeds input (" << dshape[2 + i]
+        << " padded to " << (dshape[2 + i] + 2 * param.pad[i]) << ")";
+      if (param.pooling_convention == pool_enum::kValid) {
+        oshape[2 + i] = 1 + (dshape[2 + i] + 2 * param.pad[i] - param.kernel[i]) /
+                            param.stride[i];
+      } else {
+        oshape[2 + i] = 1 + static_cast<int>(ceil(static_cast<float>(
+                            dshape[2 + i] + 2 * param.pad[i] - param.kernel[i]) /
+                            param.stride[i]));
+      }
+    }
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return true;
+}
+
+/*!
+ * \brief one output of a max or average pooling, the average is taken over
+ *  the window clipped to the padded input and rounded to the nearest value
+ */
+struct quantized_pool {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, const int8_t *in,
+                                  int height, int width, int out_h, int out_w,
+                                  int kernel_h, int kernel_w, int stride_h, int stride_w,
+                                  int pad_h, int pad_w, bool is_max) {
+    const int ow = i % out_w;
+    const int oh = (i / out_w) % out_h;
+    const int8_t *src = in + static_cast<int64_t>(i / (out_w * out_h)) * height * width;
+    int hstart = oh * stride_h - pad_h;
+    int wstart = ow * stride_w - pad_w;
+    int hend = hstart + kernel_h < height + pad_h ? hstart + kernel_h : height + pad_h;
+    int wend = wstart + kernel_w < width + pad_w ? wstart + kernel_w : width + pad_w;
+    const int pool_size = (hend - hstart) * (wend - wstart);
+    hstart = hstart < 0 ? 0 : hstart;
+    wstart = wstart < 0 ? 0 : wstart;
+    hend = hend < height ? hend : height;
+    wend = wend < width ? wend : width;
+    if (is_max) {
+      int8_t value = -128;
+      for (int h = hstart; h < hend; ++h) {
+        for (int w = wstart; w < wend; ++w) {
+          if (src[h * width + w] > value) value = src[h * width + w];
+        }
+      }
+      out[i] = value;
+    } else {
+      int32_t sum = 0;
+      for (int h = hstart; h < hend; ++h) {
+        for (int w = wstart; w < wend; ++w) {
+          sum += src[h * width + w];
+        }
+      }
+      const int32_t half = pool_size / 2;
+      out[i] = static_cast<int8_t>(sum >= 0 ? (sum + half) / pool_size
+                                            : -((-sum + half) / pool_size));
+    }
+  }
+};
+
+template<typename xpu>
+void QuantizedPoolingCompute(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_pooling only supports kWriteTo";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TShape& dshape = inputs[0].shape_;
+  const TShape& oshape = outputs[0].shape_;
+  const int kernel_h = param.global_pool ? dshape[2] : param.kernel[0];
+  const int kernel_w = param.global_pool ? dshape[3] : param.kernel[1];
+  const int stride_h = param.global_pool ? 1 : param.stride[0];
+  const int stride_w = param.global_pool ? 1 : param.stride[1];
+  const int pad_h = param.global_pool ? 0 : param.pad[0];
+  const int pad_w = param.global_pool ? 0 : param.pad[1];
+  Kernel<quantized_pool, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<int8_t>(),
+    inputs[0].dptr<int8_t>(), dshape[2], dshape[3], oshape[2], oshape[3],
+    kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w,
+    param.pool_type == pool_enum::kMaxPooling);
+  Kernel<quantized_range_copy, xpu>::Launch(s, 1, outputs[1].dptr<float>(),
+    outputs[2].dptr<float>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_POOLING_INL_H_
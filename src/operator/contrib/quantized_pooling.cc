@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file quantized_pooling.cc
+ * \brief
+ */
+#include "./quantized_pooling-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_quantized_pooling)
+.describe(R"code(2D max or average pooling of int8 data.
+
+The inputs are the int8 data and its min and max range. The output has the range of
+the input. The averages are rounded to the nearest int8 value.
+
+Only the NCHW layout is supported.
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr_parser(QuantizedPoolingParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "min_data", "max_data"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", QuantizedListOutputNames)
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedPoolingShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedInt8Type)
+.set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs& attrs) { return false; })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedPoolingCompute<cpu>)
+.add_argument("data", "NDArray-or-Symbol", "Input data of type int8.")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data.")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data.")
+.add_arguments(PoolingParam::__FIELDS__());
+
+NNVM_REGISTER_OP(Pooling)
+.set_attr<FQuantizedOp>("FQuantizedOp", [](const NodeAttrs& attrs) {
+    nnvm::NodeAttrs parsed = attrs;
+    QuantizedPoolingParamParser(&parsed);
+    if (!QuantizedPoolingSupported(nnvm::get<PoolingParam>(parsed.parsed))) {
+      return nnvm::NodePtr();
+    }
+    return CreateQuantizedNode("_contrib_quantized_pooling", attrs);
+  });
+
+}  // namespace op
+}  // namespace mxnet
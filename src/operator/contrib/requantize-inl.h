@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file requantize-inl.h
+ * \brief convert the int32 outputs of the int8 operators back to int8
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_REQUANTIZE_INL_H_
+#define MXNET_OPERATOR_CONTRIB_REQUANTIZE_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <dmlc/optional.h>
+#include <string>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../tensor/broadcast_reduce-inl.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+struct RequantizeParam : public dmlc::Parameter<RequantizeParam> {
+  dmlc::optional<float> min_calib_range;
+  dmlc::optional<float> max_calib_range;
+  DMLC_DECLARE_PARAMETER(RequantizeParam) {
+    DMLC_DECLARE_FIELD(min_calib_range)
+    .set_default(dmlc::optional<float>())
+    .describe("The minimum real value of the output, found by calibration. "
+              "If absent, the range of the output is that of the input values.");
+    DMLC_DECLARE_FIELD(max_calib_range)
+    .set_default(dmlc::optional<float>())
+    .describe("The maximum real value of the output, found by calibration. "
+              "If absent, the range of the output is that of the input values.");
+  }
+};
+
+/*!
+ * \brief requantize with the real threshold *r of the output, which is the
+ *  calibrated one, or the one of the largest input magnitude *max_abs.
+ */
+struct requantize {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, float *omin_range, float *omax_range,
+                                  const int32_t *in, const float *imin_range,
+                                  const float *imax_range, const int32_t *max_abs,
+                                  float calib_range) {
+    const float irange = MaxAbs(*imin_range, *imax_range);
+    const float r = max_abs ? QuantizedToFloat(*max_abs, irange) : calib_range;
+    out[i] = FloatToQuantized<int8_t>(QuantizedToFloat(in[i], irange), r);
+    if (i == 0) {
+      *omin_range = -r;
+      *omax_range = r;
+    }
+  }
+};
+
+inline std::vector<ResourceRequest> RequantizeResource(const NodeAttrs& attrs) {
+  const RequantizeParam& param = nnvm::get<RequantizeParam>(attrs.parsed);
+  if (param.min_calib_range.has_value() && param.max_calib_range.has_value()) {
+    return std::vector<ResourceRequest>();
+  }
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+}
+
+template<typename xpu>
+void RequantizeCompute(const nnvm::NodeAttrs& attrs,
+                       const OpContext& ctx,
+                       const std::vector<TBlob>& inputs,
+                       const std::vector<OpReqType>& req,
+                       const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const RequantizeParam& param = nnvm::get<RequantizeParam>(attrs.parsed);
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const int n = inputs[0].Size();
+  if (param.min_calib_range.has_value() && param.max_calib_range.has_value()) {
+    const float r = MaxAbs(param.min_calib_range.value(), param.max_calib_range.value());
+    Kernel<requantize, xpu>::Launch(s, n, outputs[0].dptr<int8_t>(),
+      outputs[1].dptr<float>(), outputs[2].dptr<float>(), inputs[0].dptr<int32_t>(),
+      inputs[1].dptr<float>(), inputs[2].dptr<float>(),
+      static_cast<const int32_t*>(nullptr), r);
+    return;
+  }
+  // use the largest magnitude of the values as the range of the output
+  const TBlob big = inputs[0].reshape(Shape2(1, n));
+  size_t reduce_size = broadcast::ReduceWorkspaceSize<2, int32_t>(
+      s, TBlob(static_cast<int32_t*>(nullptr), Shape2(1, 1), xpu::kDevMask), kWriteTo, big);
+  reduce_size = (reduce_size + sizeof(int32_t) - 1) / sizeof(int32_t) * sizeof(int32_t);
+  // the largest magnitude is stored after the workspace of the reduction
+  Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+      Shape1(reduce_size + sizeof(int32_t)), s);
+  const TBlob small(reinterpret_cast<int32_t*>(workspace.dptr_ + reduce_size),
+                    Shape2(1, 1), xpu::kDevMask);
+  Tensor<xpu, 1, char> reduce_space(workspace.dptr_, Shape1(reduce_size), s);
+  broadcast::Reduce<mshadow::red::maximum, 2, int32_t, mshadow_op::abs>(
+      s, small, kWriteTo, reduce_space, big);
+  Kernel<requantize, xpu>::Launch(s, n, outputs[0].dptr<int8_t>(),
+    outputs[1].dptr<float>(), outputs[2].dptr<float>(), inputs[0].dptr<int32_t>(),
+    inputs[1].dptr<float>(), inputs[2].dptr<float>(), small.dptr<int32_t>(), 0.0f);
+}
+
+inline bool RequantizeShape(const nnvm::NodeAttrs& attrs,
+                            std::vector<TShape> *in_attrs,
+                            std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  for (size_t i = 1; i < 3; ++i) {
+    SHAPE_ASSIGN_CHECK(*in_attrs, i, TShape{1});
+  }
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
+  SHAPE_ASSIGN_CHECK(*out_attrs, 1, TShape{1});
+  SHAPE_ASSIGN_CHECK(*out_attrs, 2, TShape{1});
+  return !shape_is_none(in_attrs->at(0));
+}
+
+inline bool RequantizeType(const nnvm::NodeAttrs& attrs,
+                           std::vector<int> *in_attrs,
+                           std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, mshadow::kInt32);
+  TYPE_ASSIGN_CHECK(*in_attrs, 1, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*in_attrs, 2, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::kFloat32);
+  return true;
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_REQUANTIZE_INL_H_
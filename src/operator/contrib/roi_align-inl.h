@@ -0,0 +1,317 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file roi_align-inl.h
+ * \brief region of interest align, the bilinear interpolation of ROIPooling
+ *  without the quantization of the regions and their bins
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_ROI_ALIGN_INL_H_
+#define MXNET_OPERATOR_CONTRIB_ROI_ALIGN_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <cmath>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace roialign {
+enum ROIAlignOpInputs {kData, kBox};
+enum ROIAlignOpOutputs {kOut};
+}  // namespace roialign
+
+struct ROIAlignParam : public dmlc::Parameter<ROIAlignParam> {
+  TShape pooled_size;
+  float spatial_scale;
+  int sample_ratio;
+  DMLC_DECLARE_PARAMETER(ROIAlignParam) {
+    DMLC_DECLARE_FIELD(pooled_size)
+    .set_expect_ndim(2).enforce_nonzero()
+    .describe("ROI Align output shape (h,w) ");
+    DMLC_DECLARE_FIELD(spatial_scale).set_range(0.0, 1.0)
+    .describe("Ratio of input feature map height (or w) to raw image height (or w). "
+    "Equals the reciprocal of total stride in convolutional layers");
+    DMLC_DECLARE_FIELD(sample_ratio).set_default(-1)
+    .describe("The number of sampling points of every bin along each axis, "
+              "or -1 for ceil(roi size / pooled size), adapted to every region.");
+  }
+};
+
+inline bool ROIAlignShape(const nnvm::NodeAttrs& attrs,
+                          std::vector<TShape> *in_attrs,
+                          std::vector<TShape> *out_attrs) {
+  using namespace mshadow;
+  const ROIAlignParam& param = nnvm::get<ROIAlignParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 2U) << "Input:[data, rois]";
+  CHECK_EQ(out_attrs->size(), 1U);
+  // data: [batch_size, c, h, w]
+  const TShape& dshape = (*in_attrs)[roialign::kData];
+  // bbox: [num_rois, 5]
+  const TShape& bshape = (*in_attrs)[roialign::kBox];
+  if (dshape.ndim() == 0 || bshape.ndim() == 0) return false;
+  CHECK_EQ(dshape.ndim(), 4U) << "data should be a 4D tensor";
+  CHECK_EQ(bshape.ndim(), 2U) << "bbox should be a 2D tensor of shape [batch, 5]";
+  CHECK_EQ(bshape[1], 5U) << "bbox should be a 2D tensor of shape [batch, 5]";
+  // out: [num_rois, c, pooled_h, pooled_w]
+  SHAPE_ASSIGN_CHECK(*out_attrs, roialign::kOut,
+                     Shape4(bshape[0], dshape[1], param.pooled_size[0], param.pooled_size[1]));
+  return true;
+}
+
+/*!
+ * \brief a region [batch_index, x1, y1, x2, y2] in the coordinates of the
+ *  feature map, and the grid of sampling points of its bins
+ */
+struct ROIAlignBox {
+  int batch;
+  float start_h, start_w, bin_h, bin_w;
+  int grid_h, grid_w;
+
+  template<typename DType>
+  MSHADOW_XINLINE ROIAlignBox(const DType *roi, float spatial_scale,
+                              int pooled_h, int pooled_w, int sample_ratio) {
+    batch = static_cast<int>(roi[0]);
+    start_w = static_cast<float>(roi[1]) * spatial_scale;
+    start_h = static_cast<float>(roi[2]) * spatial_scale;
+    // malformed regions are forced to be 1x1
+    float roi_w = static_cast<float>(roi[3]) * spatial_scale - start_w;
+    float roi_h = static_cast<float>(roi[4]) * spatial_scale - start_h;
+    roi_w = roi_w > 1.0f ? roi_w : 1.0f;
+    roi_h = roi_h > 1.0f ? roi_h : 1.0f;
+    bin_w = roi_w / pooled_w;
+    bin_h = roi_h / pooled_h;
+    grid_w = sample_ratio > 0 ? sample_ratio : static_cast<int>(ceilf(bin_w));
+    grid_h = sample_ratio > 0 ? sample_ratio : static_cast<int>(ceilf(bin_h));
+  }
+  /*! \brief the coordinates of the sample iy, ix of the bin ph, pw */
+  MSHADOW_XINLINE float y(int ph, int iy) const {
+    return start_h + ph * bin_h + (iy + 0.5f) * bin_h / grid_h;
+  }
+  MSHADOW_XINLINE float x(int pw, int ix) const {
+    return start_w + pw * bin_w + (ix + 0.5f) * bin_w / grid_w;
+  }
+};
+
+/*!
+ * \brief the offsets in a channel of the 4 pixels around y, x and their
+ *  bilinear weights, false for a point out of the feature map
+ */
+MSHADOW_XINLINE bool ROIAlignBilinear(float y, float x, int height, int width,
+                                      int *pos, float *weight) {
+  if (y < -1.0f || y > height || x < -1.0f || x > width) return false;
+  y = y > 0.0f ? y : 0.0f;
+  x = x > 0.0f ? x : 0.0f;
+  int y_low = static_cast<int>(y);
+  int x_low = static_cast<int>(x);
+  int y_high, x_high;
+  if (y_low >= height - 1) {
+    y_high = y_low = height - 1;
+    y = y_low;
+  } else {
+    y_high = y_low + 1;
+  }
+  if (x_low >= width - 1) {
+    x_high = x_low = width - 1;
+    x = x_low;
+  } else {
+    x_high = x_low + 1;
+  }
+  const float ly = y - y_low, lx = x - x_low;
+  const float hy = 1.0f - ly, hx = 1.0f - lx;
+  pos[0] = y_low * width + x_low;
+  pos[1] = y_low * width + x_high;
+  pos[2] = y_high * width + x_low;
+  pos[3] = y_high * width + x_high;
+  weight[0] = hy * hx;
+  weight[1] = hy * lx;
+  weight[2] = ly * hx;
+  weight[3] = ly * lx;
+  return true;
+}
+
+/*!
+ * \brief in parallel over the regions, whose interpolation of the sampling
+ *  points is computed once and shared by all the channels
+ */
+template<typename DType, typename AccReal>
+inline void ROIAlignForward(mshadow::Stream<cpu> *s, const ROIAlignParam& param,
+                            const DType *data, const DType *rois, int num_rois, int batch,
+                            int channels, int height, int width, OpReqType req, DType *out) {
+  const int pooled_h = param.pooled_size[0];
+  const int pooled_w = param.pooled_size[1];
+  const int bin_size = pooled_h * pooled_w;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int r = 0; r < num_rois; ++r) {
+    const ROIAlignBox box(rois + r * 5, param.spatial_scale, pooled_h, pooled_w,
+                          param.sample_ratio);
+    DType *roi_out = out + static_cast<size_t>(r) * channels * bin_size;
+    if (box.batch < 0 || box.batch >= batch) {
+      for (int i = 0; i < channels * bin_size; ++i) KERNEL_ASSIGN(roi_out[i], req, DType(0));
+      continue;
+    }
+    // 4 pixels and weights per sampling point, the points out of the map weigh 0
+    const int count = box.grid_h * box.grid_w;
+    std::vector<int> pos(bin_size * count * 4, 0);
+    std::vector<float> weight(bin_size * count * 4, 0.0f);
+    for (int ph = 0, k = 0; ph < pooled_h; ++ph) {
+      for (int pw = 0; pw < pooled_w; ++pw) {
+        for (int iy = 0; iy < box.grid_h; ++iy) {
+          for (int ix = 0; ix < box.grid_w; ++ix, k += 4) {
+            ROIAlignBilinear(box.y(ph, iy), box.x(pw, ix), height, width,
+                             &pos[k], &weight[k]);
+          }
+        }
+      }
+    }
+    for (int c = 0; c < channels; ++c) {
+      const DType *plane = data + (static_cast<size_t>(box.batch) * channels + c) * height * width;
+      DType *bins = roi_out + c * bin_size;
+      for (int b = 0, k = 0; b < bin_size; ++b) {
+        AccReal sum = 0;
+        for (int j = 0; j < count * 4; ++j, ++k) {
+          sum += weight[k] * static_cast<AccReal>(plane[pos[k]]);
+        }
+        KERNEL_ASSIGN(bins[b], req, DType(sum / count));
+      }
+    }
+  }
+}
+
+/*!
+ * \brief adds the gradient of the output to igrad, in parallel over the
+ *  channels: a thread owns the channel in all the images, so the regions,
+ *  which overlap, are accumulated without atomics
+ */
+template<typename DType, typename AccReal>
+inline void ROIAlignBackward(mshadow::Stream<cpu> *s, const ROIAlignParam& param,
+                             const DType *ograd, const DType *rois, int num_rois, int batch,
+                             int channels, int height, int width, DType *igrad) {
+  const int pooled_h = param.pooled_size[0];
+  const int pooled_w = param.pooled_size[1];
+  const int bin_size = pooled_h * pooled_w;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int c = 0; c < channels; ++c) {
+    for (int r = 0; r < num_rois; ++r) {
+      const ROIAlignBox box(rois + r * 5, param.spatial_scale, pooled_h, pooled_w,
+                            param.sample_ratio);
+      if (box.batch < 0 || box.batch >= batch) continue;
+      DType *plane = igrad + (static_cast<size_t>(box.batch) * channels + c) * height * width;
+      const DType *bins = ograd + (static_cast<size_t>(r) * channels + c) * bin_size;
+      const AccReal scale = AccReal(1) / (box.grid_h * box.grid_w);
+      for (int ph = 0; ph < pooled_h; ++ph) {
+        for (int pw = 0; pw < pooled_w; ++pw) {
+          const AccReal g = static_cast<AccReal>(bins[ph * pooled_w + pw]) * scale;
+          for (int iy = 0; iy < box.grid_h; ++iy) {
+            for (int ix = 0; ix < box.grid_w; ++ix) {
+              int pos[4];
+              float weight[4];
+              if (ROIAlignBilinear(box.y(ph, iy), box.x(pw, ix), height, width, pos, weight)) {
+                for (int j = 0; j < 4; ++j) {
+                  plane[pos[j]] = DType(static_cast<AccReal>(plane[pos[j]]) + weight[j] * g);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template<typename DType, typename AccReal>
+void ROIAlignForward(mshadow::Stream<gpu> *s, const ROIAlignParam& param,
+                     const DType *data, const DType *rois, int num_rois, int batch,
+                     int channels, int height, int width, OpReqType req, DType *out);
+
+template<typename DType, typename AccReal>
+void ROIAlignBackward(mshadow::Stream<gpu> *s, const ROIAlignParam& param,
+                      const DType *ograd, const DType *rois, int num_rois, int batch,
+                      int channels, int height, int width, DType *igrad);
+
+template<typename xpu>
+void ROIAlignCompute(const nnvm::NodeAttrs& attrs,
+                     const OpContext& ctx,
+                     const std::vector<TBlob>& inputs,
+                     const std::vector<OpReqType>& req,
+                     const std::vector<TBlob>& outputs) {
+  const ROIAlignParam& param = nnvm::get<ROIAlignParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[roialign::kOut] == kNullOp) return;
+  CHECK_NE(req[roialign::kOut], kWriteInplace) << "ROIAlign does not support inplace";
+  const TShape& dshape = inputs[roialign::kData].shape_;
+  const int num_rois = inputs[roialign::kBox].shape_[0];
+  if (num_rois == 0) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[roialign::kData].type_flag_, DType, AccReal, {
+    ROIAlignForward<DType, AccReal>(s, param, inputs[roialign::kData].dptr<DType>(),
+                                    inputs[roialign::kBox].dptr<DType>(), num_rois,
+                                    dshape[0], dshape[1], dshape[2], dshape[3],
+                                    req[roialign::kOut], outputs[roialign::kOut].dptr<DType>());
+  });
+}
+
+/*!
+ * \brief inputs are the gradient of the output and the regions, which get
+ *  no gradient
+ */
+template<typename xpu>
+void ROIAlignGradCompute(const nnvm::NodeAttrs& attrs,
+                         const OpContext& ctx,
+                         const std::vector<TBlob>& inputs,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  const ROIAlignParam& param = nnvm::get<ROIAlignParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK_NE(req[roialign::kData], kWriteInplace) << "ROIAlign does not support inplace";
+  const TShape& dshape = outputs[roialign::kData].shape_;
+  const int num_rois = inputs[1].shape_[0];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(outputs[roialign::kData].type_flag_, DType, AccReal, {
+    if (req[roialign::kBox] != kNullOp && req[roialign::kBox] != kAddTo) {
+      Kernel<set_zero, xpu>::Launch(s, outputs[roialign::kBox].Size(),
+                                    outputs[roialign::kBox].dptr<DType>());
+    }
+    if (req[roialign::kData] == kNullOp) return;
+    if (req[roialign::kData] == kWriteTo) {
+      Kernel<set_zero, xpu>::Launch(s, outputs[roialign::kData].Size(),
+                                    outputs[roialign::kData].dptr<DType>());
+    }
+    if (num_rois == 0) return;
+    ROIAlignBackward<DType, AccReal>(s, param, inputs[0].dptr<DType>(), inputs[1].dptr<DType>(),
+                                     num_rois, dshape[0], dshape[1], dshape[2], dshape[3],
+                                     outputs[roialign::kData].dptr<DType>());
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_ROI_ALIGN_INL_H_
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file roi_align.cc
+ * \brief region of interest align
+ */
+#include "./roi_align-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(ROIAlignParam);
+
+NNVM_REGISTER_OP(_contrib_ROIAlign)
+.describe(R"code(Performs Region of Interest (ROI) Align on the input array.
+
+ROI Align is ROI pooling without the quantization of the regions and of
+their bins, as used in Mask R-CNN: every region is divided in
+*pooled_size* bins, and the output of a bin is the average of the values of
+the feature map at ``sample_ratio`` x ``sample_ratio`` regularly spaced
+points of the bin, interpolated bilinearly. The points outside the feature
+map count as 0.
+
+``rois`` is a 2D array of shape (num_rois, 5), every row being
+[batch_index, x1, y1, x2, y2] in the coordinates of the image, scaled by
+``spatial_scale`` to the coordinates of the feature map. The output is
+(num_rois, channels, pooled_size[0], pooled_size[1]), and the regions get
+no gradient.
+
+On cpu the regions are processed in parallel and the interpolation of the
+points of a region is shared by its channels; the gradient is computed in
+parallel over the channels, without atomics.
+
+Reference: *Mask R-CNN*, K. He *et al*., 2017.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<ROIAlignParam>)
+.set_num_inputs(2)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "rois"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", ROIAlignShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
+.set_attr<FCompute>("FCompute<cpu>", ROIAlignCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads{ograds[roialign::kOut], n->inputs[roialign::kBox]};
+    return MakeGradNode("_backward_ROIAlign", n, heads, n->attrs.dict);
+  })
+.add_argument("data", "NDArray-or-Symbol", "Input data to the pooling operator, a 4D Feature maps")
+.add_argument("rois", "NDArray-or-Symbol", "Bounding box coordinates, a 2D array")
+.add_arguments(ROIAlignParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_ROIAlign)
+.set_attr_parser(ParamParser<ROIAlignParam>)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FCompute>("FCompute<cpu>", ROIAlignGradCompute<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file roi_align.cu
+ * \brief region of interest align, gpu kernels
+ *
+ *  A thread computes an output bin, the consecutive threads the consecutive
+ *  bins of a row, whose sampling points are neighbours in the feature map.
+ *  The overlapping regions share the pixels of the gradient, which take
+ *  atomic additions, but the samples of a bin falling around the same pixels
+ *  are summed in registers first and added once.
+ */
+#include "./roi_align-inl.h"
+#include "../../common/cuda_utils.h"
+
+namespace mxnet {
+namespace op {
+
+template<typename DType, typename AccReal>
+__global__ void ROIAlignForwardKernel(const int count, const DType *data, const DType *rois,
+                                      const int batch, const int channels,
+                                      const int height, const int width,
+                                      const int pooled_h, const int pooled_w,
+                                      const float spatial_scale, const int sample_ratio,
+                                      const OpReqType req, DType *out) {
+  CUDA_KERNEL_LOOP(index, count) {
+    const int pw = index % pooled_w;
+    const int ph = (index / pooled_w) % pooled_h;
+    const int c = (index / pooled_w / pooled_h) % channels;
+    const int r = index / pooled_w / pooled_h / channels;
+    const ROIAlignBox box(rois + r * 5, spatial_scale, pooled_h, pooled_w, sample_ratio);
+    AccReal sum = 0;
+    if (box.batch >= 0 && box.batch < batch) {
+      const DType *plane = data + (static_cast<size_t>(box.batch) * channels + c) * height * width;
+      for (int iy = 0; iy < box.grid_h; ++iy) {
+        for (int ix = 0; ix < box.grid_w; ++ix) {
+          int pos[4];
+          float weight[4];
+          if (ROIAlignBilinear(box.y(ph, iy), box.x(pw, ix), height, width, pos, weight)) {
+            for (int j = 0; j < 4; ++j) {
+              sum += weight[j] * static_cast<AccReal>(plane[pos[j]]);
+            }
+          }
+        }
+      }
+      sum /= box.grid_h * box.grid_w;
+    }
+    KERNEL_ASSIGN(out[index], req, DType(sum));
+  }
+}
+
+template<typename DType, typename AccReal>
+__global__ void ROIAlignBackwardKernel(const int count, const DType *ograd, const DType *rois,
+                                       const int batch, const int channels,
+                                       const int height, const int width,
+                                       const int pooled_h, const int pooled_w,
+                                       const float spatial_scale, const int sample_ratio,
+                                       DType *igrad) {
+  CUDA_KERNEL_LOOP(index, count) {
+    const int pw = index % pooled_w;
+    const int ph = (index / pooled_w) % pooled_h;
+    const int c = (index / pooled_w / pooled_h) % channels;
+    const int r = index / pooled_w / pooled_h / channels;
+    const ROIAlignBox box(rois + r * 5, spatial_scale, pooled_h, pooled_w, sample_ratio);
+    if (box.batch < 0 || box.batch >= batch) continue;
+    DType *plane = igrad + (static_cast<size_t>(box.batch) * channels + c) * height * width;
+    const AccReal g = static_cast<AccReal>(ograd[index]) / (box.grid_h * box.grid_w);
+    // the pixels of the previous samples, and their pending gradients
+    int last = -1;
+    int pos[4];
+    AccReal acc[4] = {0, 0, 0, 0};
+    for (int iy = 0; iy < box.grid_h; ++iy) {
+      for (int ix = 0; ix < box.grid_w; ++ix) {
+        int p[4];
+        float weight[4];
+        if (!ROIAlignBilinear(box.y(ph, iy), box.x(pw, ix), height, width, p, weight)) {
+          continue;
+        }
+        if (p[0] != last || p[3] != pos[3]) {
+          if (last >= 0) {
+            for (int j = 0; j < 4; ++j) atomicAdd(plane + pos[j], DType(acc[j]));
+          }
+          for (int j = 0; j < 4; ++j) {
+            pos[j] = p[j];
+            acc[j] = 0;
+          }
+          last = p[0];
+        }
+        for (int j = 0; j < 4; ++j) acc[j] += weight[j] * g;
+      }
+    }
+    if (last >= 0) {
+      for (int j = 0; j < 4; ++j) atomicAdd(plane + pos[j], DType(acc[j]));
+    }
+  }
+}
+
+template<typename DType, typename AccReal>
+void ROIAlignForward(mshadow::Stream<gpu> *s, const ROIAlignParam& param,
+                     const DType *data, const DType *rois, int num_rois, int batch,
+                     int channels, int height, int width, OpReqType req, DType *out) {
+  using namespace mxnet_op;
+  const int pooled_h = param.pooled_size[0];
+  const int pooled_w = param.pooled_size[1];
+  const int count = num_rois * channels * pooled_h * pooled_w;
+  // NOLINT_NEXT_LINE(whitespace/operators)
+  ROIAlignForwardKernel<DType, AccReal><<<cuda_get_num_blocks(count),
+      mshadow::cuda::kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+      count, data, rois, batch, channels, height, width, pooled_h, pooled_w,
+      param.spatial_scale, param.sample_ratio, req, out);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(ROIAlignForwardKernel);
+}
+
+template<typename DType, typename AccReal>
+void ROIAlignBackward(mshadow::Stream<gpu> *s, const ROIAlignParam& param,
+                      const DType *ograd, const DType *rois, int num_rois, int batch,
+                      int channels, int height, int width, DType *igrad) {
+  using namespace mxnet_op;
+  const int pooled_h = param.pooled_size[0];
+  const int pooled_w = param.pooled_size[1];
+  const int count = num_rois * channels * pooled_h * pooled_w;
+  // NOLINT_NEXT_LINE(whitespace/operators)
+  ROIAlignBackwardKernel<DType, AccReal><<<cuda_get_num_blocks(count),
+      mshadow::cuda::kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+      count, ograd, rois, batch, channels, height, width, pooled_h, pooled_w,
+      param.spatial_scale, param.sample_ratio, igrad);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(ROIAlignBackwardKernel);
+}
+
+NNVM_REGISTER_OP(_contrib_ROIAlign)
+.set_attr<FCompute>("FCompute<gpu>", ROIAlignCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_ROIAlign)
+.set_attr<FCompute>("FCompute<gpu>", ROIAlignGradCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,445 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file sync_batch_norm-inl.h
+ * \brief Batch normalization with the statistics of the batch shared
+ *  by the copies of the layer on all the devices of an executor group
+*/
+#ifndef MXNET_OPERATOR_CONTRIB_SYNC_BATCH_NORM_INL_H_
+#define MXNET_OPERATOR_CONTRIB_SYNC_BATCH_NORM_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../operator_common.h"
+#include "../mshadow_op.h"
+
+namespace mxnet {
+namespace op {
+
+namespace syncbatchnorm {
+enum SyncBatchNormOpInputs {kData, kGamma, kBeta};
+enum SyncBatchNormOpOutputs {kOut, kMean, kVar};
+enum SyncBatchNormOpAuxiliary {kMovingMean, kMovingVar};
+enum SyncBatchNormResource {kTempSpace};
+}  // namespace syncbatchnorm
+
+struct SyncBatchNormParam : public dmlc::Parameter<SyncBatchNormParam> {
+  float eps;
+  float momentum;
+  bool fix_gamma;
+  bool use_global_stats;
+  bool output_mean_var;
+  int ndev;
+  std::string key;
+  DMLC_DECLARE_PARAMETER(SyncBatchNormParam) {
+    DMLC_DECLARE_FIELD(eps).set_default(1e-3f)
+    .describe("Epsilon to prevent div 0");
+    DMLC_DECLARE_FIELD(momentum).set_default(0.9f)
+    .describe("Momentum for moving average");
+    DMLC_DECLARE_FIELD(fix_gamma).set_default(true)
+    .describe("Fix gamma while training");
+    DMLC_DECLARE_FIELD(use_global_stats).set_default(false)
+    .describe("Whether use global moving statistics instead of local batch-norm. "
+              "This will force change batch-norm into a scale shift operator.");
+    DMLC_DECLARE_FIELD(output_mean_var).set_default(false)
+    .describe("Output All,normal mean and var");
+    DMLC_DECLARE_FIELD(ndev).set_default(1).set_lower_bound(1)
+    .describe("The number of devices the batch is split over");
+    DMLC_DECLARE_FIELD(key).set_default("")
+    .describe("Name shared by the copies of this layer on the devices, "
+              "and by no other layer. Required when ndev is larger than 1.");
+  }
+};
+
+/*!
+ * \brief Sums a buffer over the copies of a layer on the devices of an
+ *  executor group. Every copy adds its values and blocks until all the
+ *  ndev copies have arrived, then reads back the sum. A round cannot end
+ *  before every copy has joined it, so the sum stays valid until the
+ *  slowest copy has read it.
+ */
+class SyncBatchNormReducer {
+ public:
+  explicit SyncBatchNormReducer(int ndev) : ndev_(ndev) {}
+  /*!
+   * \brief the reducer of a key, created on first use
+   * \param key the key of the layer and of the pass
+   * \param ndev the number of copies of the layer
+   */
+  static std::shared_ptr<SyncBatchNormReducer> Get(const std::string& key, int ndev) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<SyncBatchNormReducer> > reducers;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<SyncBatchNormReducer>& reducer = reducers[key];
+    if (reducer == nullptr) {
+      reducer = std::make_shared<SyncBatchNormReducer>(ndev);
+    }
+    CHECK_EQ(reducer->ndev_, ndev)
+        << "SyncBatchNorm layers with key " << key
+        << " disagree on the number of devices";
+    return reducer;
+  }
+  /*! \brief replace values by their sum over the copies of the layer */
+  void AllReduce(real_t *values, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (count_ == 0) {
+      sum_.assign(values, values + size);
+    } else {
+      CHECK_EQ(sum_.size(), size) << "SyncBatchNorm copies disagree on the number of channels";
+      for (size_t i = 0; i < size; ++i) sum_[i] += values[i];
+    }
+    if (++count_ == ndev_) {
+      count_ = 0;
+      ++round_;
+      cond_.notify_all();
+    } else {
+      const uint64_t round = round_;
+      cond_.wait(lock, [this, round] { return round_ != round; });
+    }
+    std::copy(sum_.begin(), sum_.end(), values);
+  }
+
+ private:
+  /*! \brief the number of copies of the layer */
+  const int ndev_;
+  /*! \brief the number of copies in the current round */
+  int count_ = 0;
+  /*! \brief the number of completed rounds */
+  uint64_t round_ = 0;
+  std::vector<real_t> sum_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+template<typename xpu>
+class SyncBatchNormOp : public Operator {
+ public:
+  explicit SyncBatchNormOp(SyncBatchNormParam param) {
+    this->param_ = param;
+    CHECK(param_.ndev == 1 || !param_.key.empty())
+        << "SyncBatchNorm needs a key when ndev is larger than 1";
+    forward_reducer_ = SyncBatchNormReducer::Get(param_.key + "_forward", param_.ndev);
+    backward_reducer_ = SyncBatchNormReducer::Get(param_.key + "_backward", param_.ndev);
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_states) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(in_data.size(), 3U);
+    CHECK_EQ(aux_states.size(), 2U);
+    if (ctx.is_train) {
+      CHECK_EQ(out_data.size(), 3U);
+      CHECK_EQ(req.size(), 3U);
+    } else {
+      CHECK_GE(out_data.size(), 1U);
+      CHECK_GE(req.size(), 1U);
+      CHECK_EQ(req[syncbatchnorm::kOut], kWriteTo);
+    }
+
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 4> data = Get4D(in_data[syncbatchnorm::kData], s);
+    Tensor<xpu, 4> out = Get4D(out_data[syncbatchnorm::kOut], s);
+    Tensor<xpu, 1> slope = in_data[syncbatchnorm::kGamma].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> bias = in_data[syncbatchnorm::kBeta].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> moving_mean = aux_states[syncbatchnorm::kMovingMean].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> moving_var = aux_states[syncbatchnorm::kMovingVar].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> mean = out_data[syncbatchnorm::kMean].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> var = out_data[syncbatchnorm::kVar].get<xpu, 1, real_t>(s);
+
+    if (param_.fix_gamma) slope = 1.f;
+
+    if (ctx.is_train && !param_.use_global_stats) {
+      CHECK(req[syncbatchnorm::kMean] == kNullOp || req[syncbatchnorm::kMean] == kWriteTo);
+      CHECK(req[syncbatchnorm::kVar] == kNullOp || req[syncbatchnorm::kVar] == kWriteTo);
+      // the sums of x and x^2 of every channel and the number of values
+      // they cover go through a single reduction
+      const index_t channels = mean.shape_[0];
+      mean = sumall_except_dim<1>(data);
+      var = sumall_except_dim<1>(F<mshadow_op::square>(data));
+      const real_t total = AllReduce(forward_reducer_.get(), mean, var,
+                                     data.shape_.Size() / channels, s);
+      mean *= 1.0f / total;
+      var = var * (1.0f / total) - F<mshadow_op::square>(mean);
+      var = F<mshadow_op::relu>(var);
+      Assign(out, req[syncbatchnorm::kOut], broadcast<1>(slope, out.shape_) *
+             (data - broadcast<1>(mean, data.shape_)) /
+             F<mshadow_op::square_root>(broadcast<1>(var + param_.eps, data.shape_)) +
+             broadcast<1>(bias, out.shape_));
+    } else {
+      Assign(out, req[syncbatchnorm::kOut], broadcast<1>(slope /
+                                          F<mshadow_op::square_root>(moving_var + param_.eps),
+                                          data.shape_) * data +
+             broadcast<1>(bias - (slope * moving_mean) /
+                          F<mshadow_op::square_root>(moving_var + param_.eps), data.shape_));
+      mean = F<mshadow_op::identity>(moving_mean);
+      var  = F<mshadow_op::identity>(moving_var);
+    }
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_states) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(out_grad.size(), param_.output_mean_var ? 3U : 1U);
+    CHECK_EQ(in_data.size(), 3U);
+    CHECK_EQ(out_data.size(), 3U);
+    CHECK_EQ(in_grad.size(), 3U);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 4> data = Get4D(in_data[syncbatchnorm::kData], s);
+    Tensor<xpu, 4> grad = Get4D(out_grad[syncbatchnorm::kOut], s);
+    Tensor<xpu, 4> grad_in = Get4D(in_grad[syncbatchnorm::kData], s);
+    Tensor<xpu, 1> mean = out_data[syncbatchnorm::kMean].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> var = out_data[syncbatchnorm::kVar].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> slope = in_data[syncbatchnorm::kGamma].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> gslope = in_grad[syncbatchnorm::kGamma].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> gbias = in_grad[syncbatchnorm::kBeta].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> moving_mean = aux_states[syncbatchnorm::kMovingMean].get<xpu, 1, real_t>(s);
+    Tensor<xpu, 1> moving_var = aux_states[syncbatchnorm::kMovingVar].get<xpu, 1, real_t>(s);
+
+    if (param_.fix_gamma) slope = 1.f;
+
+    if (ctx.is_train && !param_.use_global_stats) {
+      const index_t channels = mean.shape_[0];
+      Tensor<xpu, 2> workspace = ctx.requested[syncbatchnorm::kTempSpace].get_space<xpu>(
+          mshadow::Shape2(5, channels), s);
+      Tensor<xpu, 1> sum_grad = workspace[0];
+      Tensor<xpu, 1> sum_grad_xmu = workspace[1];
+      Tensor<xpu, 1> total_grad = workspace[2];
+      Tensor<xpu, 1> total_grad_xmu = workspace[3];
+      Tensor<xpu, 1> inv_std = workspace[4];
+
+      moving_mean = moving_mean * param_.momentum + mean * (1 - param_.momentum);
+      moving_var = moving_var * param_.momentum + var * (1 - param_.momentum);
+      inv_std = 1.0f / F<mshadow_op::square_root>(var + param_.eps);
+      sum_grad = sumall_except_dim<1>(grad);
+      sum_grad_xmu = sumall_except_dim<1>(grad * (data - broadcast<1>(mean, data.shape_)));
+      // the parameters get the gradient of this device only, the sum over
+      // the devices is left to the kvstore as for any other parameter
+      total_grad = F<mshadow_op::identity>(sum_grad);
+      total_grad_xmu = F<mshadow_op::identity>(sum_grad_xmu);
+      const real_t total = AllReduce(backward_reducer_.get(), total_grad, total_grad_xmu,
+                                     data.shape_.Size() / channels, s);
+      total_grad *= 1.0f / total;
+      total_grad_xmu *= 1.0f / total;
+      total_grad_xmu *= F<mshadow_op::square>(inv_std);
+      if (!param_.fix_gamma) {
+        Assign(gslope, req[syncbatchnorm::kGamma], sum_grad_xmu * inv_std);
+      } else {
+        Assign(gslope, req[syncbatchnorm::kGamma], 0.0f);
+      }
+      Assign(gbias, req[syncbatchnorm::kBeta], F<mshadow_op::identity>(sum_grad));
+      Assign(grad_in, req[syncbatchnorm::kData],
+             broadcast<1>(slope * inv_std, data.shape_) *
+             (grad - broadcast<1>(total_grad, data.shape_) -
+              (data - broadcast<1>(mean, data.shape_)) *
+              broadcast<1>(total_grad_xmu, data.shape_)));
+    } else {
+      if (!param_.fix_gamma) {
+        Assign(gslope, req[syncbatchnorm::kGamma],
+               sumall_except_dim<1>(
+                   grad * (data - broadcast<1>(moving_mean, data.shape_)) /
+                   F<mshadow_op::square_root>(broadcast<1>(moving_var + param_.eps, data.shape_))));
+      } else {
+        Assign(gslope, req[syncbatchnorm::kGamma], 0.0f);
+      }
+      Assign(gbias, req[syncbatchnorm::kBeta], sumall_except_dim<1>(grad));
+      Assign(grad_in, req[syncbatchnorm::kData], (grad * broadcast<1>(slope, data.shape_)) *
+             broadcast<1>(
+                 1.0f / F<mshadow_op::square_root>(moving_var + param_.eps), data.shape_));
+    }
+  }
+
+ private:
+  inline mshadow::Tensor<xpu, 4> Get4D(const TBlob &blob, mshadow::Stream<xpu> *s) {
+    if (blob.ndim() == 4) return blob.get<xpu, 4, real_t>(s);
+    mshadow::Shape<4> dshape = mshadow::Shape4(blob.shape_[0], blob.shape_[1], 1, 1);
+    for (index_t i = 2; i < blob.ndim(); ++i) dshape[2] *= blob.shape_[i];
+    return blob.get_with_shape<xpu, 4, real_t>(dshape, s);
+  }
+
+  /*!
+   * \brief replace a and b by their sums over the devices through the host,
+   *  in one reduction with the count of the values they sum on this device
+   * \return the count of the values summed over all the devices
+   */
+  inline real_t AllReduce(SyncBatchNormReducer *reducer,
+                          mshadow::Tensor<xpu, 1> a, mshadow::Tensor<xpu, 1> b,
+                          index_t count, mshadow::Stream<xpu> *s) {
+    using namespace mshadow;
+    const index_t channels = a.shape_[0];
+    host_.resize(2 * channels + 1);
+    Tensor<cpu, 1> host_a(host_.data(), Shape1(channels));
+    Tensor<cpu, 1> host_b(host_.data() + channels, Shape1(channels));
+    Copy(host_a, a, s);
+    Copy(host_b, b, s);
+    s->Wait();
+    host_[2 * channels] = static_cast<real_t>(count);
+    reducer->AllReduce(host_.data(), host_.size());
+    Copy(a, host_a, s);
+    Copy(b, host_b, s);
+    s->Wait();
+    return host_[2 * channels];
+  }
+
+  SyncBatchNormParam param_;
+  std::shared_ptr<SyncBatchNormReducer> forward_reducer_;
+  std::shared_ptr<SyncBatchNormReducer> backward_reducer_;
+  /*! \brief host buffer of the reductions */
+  std::vector<real_t> host_;
+};  // class SyncBatchNormOp
+
+template<typename xpu>
+Operator *CreateOp(SyncBatchNormParam param, int dtype);
+
+
+#if DMLC_USE_CXX11
+class SyncBatchNormProp : public OperatorProperty {
+ public:
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    param_.Init(kwargs);
+  }
+
+  std::map<std::string, std::string> GetParams() const override {
+    return param_.__DICT__();
+  }
+
+  bool InferShape(std::vector<TShape> *in_shape,
+                  std::vector<TShape> *out_shape,
+                  std::vector<TShape> *aux_shape) const override {
+    using namespace mshadow;
+    CHECK_EQ(in_shape->size(), 3U) << "Input:[data, gamma, beta]";
+    const TShape &dshape = in_shape->at(0);
+    if (dshape.ndim() == 0) return false;
+    CHECK_GE(dshape.ndim(), 2U) << "SyncBatchNorm normalizes along axis 1";
+    in_shape->at(1) = TShape(Shape1(dshape[1]));
+    in_shape->at(2) = TShape(Shape1(dshape[1]));
+    out_shape->clear();
+    out_shape->push_back(dshape);
+    out_shape->push_back(Shape1(dshape[1]));
+    out_shape->push_back(Shape1(dshape[1]));
+
+    aux_shape->clear();
+    aux_shape->push_back(Shape1(dshape[1]));
+    aux_shape->push_back(Shape1(dshape[1]));
+    return true;
+  }
+
+  bool InferType(std::vector<int> *in_type,
+                 std::vector<int> *out_type,
+                 std::vector<int> *aux_type) const override {
+    CHECK_EQ(in_type->size(), 3U);
+    for (index_t i = 0; i < in_type->size(); ++i) {
+      if ((*in_type)[i] == -1) {
+        (*in_type)[i] = mshadow::kFloat32;
+      } else {
+        CHECK_EQ((*in_type)[i], mshadow::kFloat32) << "SyncBatchNorm only supports float32, "
+                                                   << "given " << (*in_type)[i]
+                                                   << " at " << ListArguments()[i];
+      }
+    }
+    aux_type->assign(this->ListAuxiliaryStates().size(), mshadow::kFloat32);
+    out_type->assign(this->ListOutputs().size(), mshadow::kFloat32);
+    return true;
+  }
+
+  OperatorProperty* Copy() const override {
+    auto ptr = new SyncBatchNormProp();
+    ptr->param_ = param_;
+    return ptr;
+  }
+
+  std::string TypeString() const override {
+    return "_contrib_SyncBatchNorm";
+  }
+
+  std::vector<int> DeclareBackwardDependency(
+    const std::vector<int> &out_grad,
+    const std::vector<int> &in_data,
+    const std::vector<int> &out_data) const override {
+    return {out_grad[syncbatchnorm::kOut],
+            out_data[syncbatchnorm::kMean],
+            out_data[syncbatchnorm::kVar],
+            in_data[syncbatchnorm::kData],
+            in_data[syncbatchnorm::kGamma]
+           };
+  }
+
+  std::vector<ResourceRequest> BackwardResource(
+      const std::vector<TShape> &in_shape) const override {
+    return {ResourceRequest::kTempSpace};
+  }
+
+  int NumVisibleOutputs() const override {
+    if (param_.output_mean_var) {
+      return 3;
+    }
+    return 1;
+  }
+
+  int NumOutputs() const override {
+    return 3;
+  }
+
+  std::vector<std::string> ListArguments() const override {
+    return {"data", "gamma", "beta"};
+  }
+
+  std::vector<std::string> ListOutputs() const override {
+    return {"output", "mean", "var"};
+  }
+
+  std::vector<std::string> ListAuxiliaryStates() const override {
+    return {"moving_mean", "moving_var"};
+  }
+
+  Operator* CreateOperator(Context ctx) const override {
+      LOG(FATAL) << "Not Implemented.";
+      return NULL;
+  }
+
+  Operator* CreateOperatorEx(Context ctx, std::vector<TShape> *in_shape,
+      std::vector<int> *in_type) const override;
+
+ private:
+  SyncBatchNormParam param_;
+};  // class SyncBatchNormProp
+
+#endif  // DMLC_USE_CXX11
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_SYNC_BATCH_NORM_INL_H_
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file sync_batch_norm.cc
+ * \brief Batch normalization synchronized across devices
+*/
+
+#include "./sync_batch_norm-inl.h"
+#include <nnvm/op_attr_types.h>
+
+namespace mxnet {
+namespace op {
+template<>
+Operator *CreateOp<cpu>(SyncBatchNormParam param, int dtype) {
+  return new SyncBatchNormOp<cpu>(param);
+}
+
+// DO_BIND_DISPATCH comes from operator_common.h
+Operator *SyncBatchNormProp::CreateOperatorEx(Context ctx, std::vector<TShape> *in_shape,
+    std::vector<int> *in_type) const {
+    std::vector<TShape> out_shape, aux_shape;
+    std::vector<int> out_type, aux_type;
+    CHECK(InferType(in_type, &out_type, &aux_type));
+    CHECK(InferShape(in_shape, &out_shape, &aux_shape));
+    DO_BIND_DISPATCH(CreateOp, param_, (*in_type)[0]);
+}
+
+DMLC_REGISTER_PARAMETER(SyncBatchNormParam);
+
+MXNET_REGISTER_OP_PROPERTY(_contrib_SyncBatchNorm, SyncBatchNormProp)
+.describe(R"code(Batch normalization with the statistics of the whole batch when the
+batch is split over several devices.
+
+Behaves like ``BatchNorm_v1``, except that in training the mean and the
+variance of every channel are computed over the parts of the batch on all
+the ``ndev`` devices of the executor group instead of the part on each
+device. Likewise the gradient of ``data`` accounts for the whole batch.
+This matters when every device only holds a few samples, as in detection
+and segmentation.
+
+The copies of the layer on the devices find each other by ``key``, which
+must be the same for the copies of a layer and different from the key of
+any other layer. Each copy waits for the others in both the forward and
+the backward pass, so the copies must run concurrently, one per device:
+the operator hangs with ``MXNET_ENGINE_TYPE=NaiveEngine`` when ``ndev`` is
+larger than 1, and every forward in training must run on all the ``ndev``
+devices. The sums of a layer go through the host in one buffer of
+``2 * channels + 1`` values per pass.
+
+The gradients of ``gamma`` and ``beta`` are those of the part of the batch
+on each device, to be summed over the devices by the kvstore as usual.
+
+Only float32 is supported.
+
+)code" ADD_FILELINE)
+.add_argument("data", "NDArray-or-Symbol", "Input data to batch normalization")
+.add_argument("gamma", "NDArray-or-Symbol", "gamma array")
+.add_argument("beta", "NDArray-or-Symbol", "beta array")
+.add_arguments(SyncBatchNormParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_SyncBatchNorm)
+.set_attr<nnvm::FSetInputVarAttrOnCompose>("FSetInputVarAttrOnCompose",
+    [](const nnvm::NodeAttrs& attrs, nnvm::NodePtr var, const int index) {
+      if (var->attrs.dict.find("__init__") != var->attrs.dict.end()) return;
+      if (index == 3) {
+        var->attrs.dict["__init__"] = "[\"zero\", {}]";
+      } else if (index == 4) {
+        var->attrs.dict["__init__"] = "[\"one\", {}]";
+      }
+    });
+
+}  // namespace op
+}  // namespace mxnet
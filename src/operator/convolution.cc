@@ -24,6 +24,8 @@
 */
 
 #include "./convolution-inl.h"
+#include "./nn/cpu_convolution-inl.h"
+#include "./impl_autotune-inl.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
 #include "./mkl/mkl_memory-inl.h"
@@ -50,14 +52,23 @@ Operator* CreateOp<cpu>(ConvolutionParam param, int dtype,
     })
     return op;
   }
+  // the implementations supporting the convolution, the first one is used
+  // unless MXNET_OP_AUTOTUNE picks the fastest
+  std::vector<ImplAutotuneReg::Candidate> candidates;
 #if MXNET_USE_MKL2017 == 1
   if ((param.dilate[0] == 1 && param.dilate[1] == 1)
       && param.kernel.ndim() == 2) {
     switch (dtype) {
     case mshadow::kFloat32:
-      return new MKLConvolutionOp<cpu, float>(param);
+      candidates.push_back({"mkl", [param]() -> Operator* {
+        return new MKLConvolutionOp<cpu, float>(param);
+      }});
+      break;
     case mshadow::kFloat64:
-      return new MKLConvolutionOp<cpu, double>(param);
+      candidates.push_back({"mkl", [param]() -> Operator* {
+        return new MKLConvolutionOp<cpu, double>(param);
+      }});
+      break;
     default:
       break;
     }
@@ -69,19 +80,36 @@ Operator* CreateOp<cpu>(ConvolutionParam param, int dtype,
       && param.kernel.ndim() == 2 && (!param.no_bias)
       && param.num_group == 1 && (batch_size == 1 ||
       ((batch_size > 1) && (param.stride[0] == 1) &&
-      (param.stride[1] == 1)))) {
-    switch (dtype) {
-    case mshadow::kFloat32:
+      (param.stride[1] == 1))) && dtype == mshadow::kFloat32) {
+    candidates.push_back({"nnpack", [param]() -> Operator* {
       return new NNPACKConvolutionOp<cpu, float>(param);
-    default:
-      break;
-    }
+    }});
   }
 #endif
+  // Forward passes which avoid im2col for the shapes they are faster on
+  if (param.kernel.ndim() == 2 && (dtype == mshadow::kFloat32 || dtype == mshadow::kFloat64)) {
+    const TShape& ishape = (*in_shape)[conv::kData];
+    MSHADOW_SGL_DBL_TYPE_SWITCH(dtype, DType, {
+      if (DepthwiseDirectConvolutionOp<DType>::Supported(param, ishape)) {
+        candidates.push_back({"depthwise_direct", [param]() -> Operator* {
+          return new DepthwiseDirectConvolutionOp<DType>(param);
+        }});
+      }
+      if (WinogradConvolutionOp<DType>::Supported(param, ishape, (*out_shape)[conv::kOut])) {
+        candidates.push_back({"winograd", [param]() -> Operator* {
+          return new WinogradConvolutionOp<DType>(param);
+        }});
+      }
+    })
+  }
   MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
-    op = new ConvolutionOp<cpu, DType>(param);
+    candidates.push_back({"im2col", [param]() -> Operator* {
+      return new ConvolutionOp<cpu, DType>(param);
+    }});
   })
-  return op;
+  return ImplAutotuneReg::Get()->Create("Convolution", param.__DICT__(), candidates,
+                                        *in_shape, *out_shape, dtype, ctx,
+                                        {ResourceRequest::kTempSpace});
 }
 
 // DO_BIND_DISPATCH comes from operator_common.h
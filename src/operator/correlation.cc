@@ -22,20 +22,36 @@
  * \brief correlation op
  * \author Xu Dong
 */
+#include <algorithm>
+#include <cmath>
 #include "./correlation-inl.h"
 #include "./mshadow_op.h"
+#include "../engine/openmp.h"
 
 namespace mshadow {
 template<typename Dtype>
 void AddPad(const Tensor<cpu, 4, Dtype> &original,
             const Tensor<cpu, 4, Dtype> &out,
-            int pad_size)
-{ for (index_t nbatch = 0 ; nbatch < original.size(0) ; nbatch++)
-  for (index_t channel = 0 ; channel < original.size(1) ; channel++)
-    for (index_t h = 0 ; h < original.size(2) ; h++)
-      for (index_t w = 0 ; w < original.size(3) ; w++)
-         out[nbatch][h+pad_size][w+pad_size][channel] = original[nbatch][channel][h][w];
+            int pad_size) {
+  // to the padded NHWC layout, in parallel over the rows of the images
+  const int num = original.size(0), channels = original.size(1);
+  const int height = original.size(2), width = original.size(3);
+  const int padded_width = out.size(2);
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int row = 0; row < num * height; ++row) {
+    const int n = row / height, h = row % height;
+    Dtype *dst = out.dptr_ + ((n * out.size(1) + h + pad_size) * padded_width + pad_size) *
+                 channels;
+    for (int c = 0; c < channels; ++c) {
+      const Dtype *src = original.dptr_ + ((n * channels + c) * height + h) * width;
+      for (int w = 0; w < width; ++w) dst[w * channels + c] = src[w];
+    }
+  }
 }
+
+// In the padded NHWC inputs, a row of a patch is kernel_size * channels
+// contiguous values, over which the comparisons run.
 template<typename Dtype>
 inline void CorrelationForward(const Tensor<cpu, 4, Dtype> &out,
                                const Tensor<cpu, 4, Dtype> &data1,
@@ -47,38 +63,48 @@ inline void CorrelationForward(const Tensor<cpu, 4, Dtype> &out,
                                int max_displacement_, int kernel_size_,
                                int neighborhood_grid_radius_, int neighborhood_grid_width_,
                                int  kernel_radius_, int stride1_, int stride2_) {
-  const index_t bnum = data1.size(0);
+  const int bnum = data1.size(0);
   const int bchannels = data1.size(1);
   const int sumelems = kernel_size_ * kernel_size_ * bchannels;
+  const int padded_height = tmp1.size(1), padded_width = tmp1.size(2);
+  const int row_size = kernel_size_ * bchannels;
   AddPad<Dtype>(data1, tmp1, pad_size_);
-  index_t top_channels_unsigned_ = static_cast<index_t>(top_channels_);
   AddPad<Dtype>(data2, tmp2, pad_size_);
-  for (index_t i = 0 ; i < static_cast<index_t>(top_height_) ; i++)
-      for (index_t j = 0 ; j < static_cast<index_t>(top_width_); j++)
-        for (index_t nbatch = 0 ; nbatch < bnum ; nbatch++) {
-            int x1 = j*stride1_+max_displacement_;
-            int y1 = i*stride1_+max_displacement_;
-            for (index_t top_channel = 0 ; top_channel < top_channels_unsigned_ ; top_channel++) {
-              int s2o = (top_channel % neighborhood_grid_width_ -\
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int row = 0; row < bnum * top_height_; ++row) {
+    const int nbatch = row / top_height_, i = row % top_height_;
+    const Dtype *image1 = tmp1.dptr_ + nbatch * padded_height * padded_width * bchannels;
+    const Dtype *image2 = tmp2.dptr_ + nbatch * padded_height * padded_width * bchannels;
+    for (int j = 0; j < top_width_; ++j) {
+      const int x1 = j * stride1_ + max_displacement_;
+      const int y1 = i * stride1_ + max_displacement_;
+      for (int top_channel = 0; top_channel < top_channels_; ++top_channel) {
+        const int s2o = (top_channel % neighborhood_grid_width_ -
                          neighborhood_grid_radius_) * stride2_;
-              int s2p = (top_channel / neighborhood_grid_width_ -\
+        const int s2p = (top_channel / neighborhood_grid_width_ -
                          neighborhood_grid_radius_) * stride2_;
-              int x2 = x1 + s2o;
-              int y2 = y1 + s2p;
-              for (index_t h = 0; h < static_cast<index_t>(kernel_size_); h++)
-                for (index_t w = 0; w < static_cast<index_t>(kernel_size_); w++)
-                  for (index_t channel = 0; channel < static_cast<index_t>(bchannels); channel++) {
-                    if (is_multiply == true)
-                        out[nbatch][top_channel][i][j] += \
-                        tmp1[nbatch][y1+h][x1+w][channel]*tmp2[nbatch][y2+h][x2+w][channel];
-                    else
-                        out[nbatch][top_channel][i][j] += \
-                        fabsf(tmp1[nbatch][y1+h][x1+w][channel]-tmp2[nbatch][y2+h][x2+w][channel]);
-                  }
-              out[nbatch][top_channel][i][j] /= sumelems;
-            }
+        const int x2 = x1 + s2o;
+        const int y2 = y1 + s2p;
+        Dtype sum = 0;
+        for (int h = 0; h < kernel_size_; ++h) {
+          const Dtype *p1 = image1 + ((y1 + h) * padded_width + x1) * bchannels;
+          const Dtype *p2 = image2 + ((y2 + h) * padded_width + x2) * bchannels;
+          if (is_multiply) {
+            for (int k = 0; k < row_size; ++k) sum += p1[k] * p2[k];
+          } else {
+            for (int k = 0; k < row_size; ++k) sum += std::abs(p1[k] - p2[k]);
+          }
         }
+        out[nbatch][top_channel][i][j] = sum / sumelems;
+      }
+    }
+  }
 }
+
+// In parallel over the blocks of channels of every image, whose gradients
+// depend on the same channels of the inputs only, so that no two threads
+// add to the same element.
 template<typename Dtype>
 inline void CorrelationBackward(const Tensor<cpu, 4, Dtype> &out_grad,
                                 const Tensor<cpu, 4, Dtype> &in_grad1,
@@ -94,54 +120,59 @@ inline void CorrelationBackward(const Tensor<cpu, 4, Dtype> &out_grad,
                                 int stride2_, int num,
                                 int channels, int height, int width
                             ) {
+  const int kChannelBlock = 32;
+  const int num_blocks = (channels + kChannelBlock - 1) / kChannelBlock;
   const float sumelems = kernel_size_ * kernel_size_ * channels;
-  for (index_t i = 0 ; i < static_cast<index_t>(top_height_) ; i++)
-     for (index_t j = 0 ; j < static_cast<index_t>(top_width_); j++)
-        for (index_t nbatch = 0 ; nbatch < static_cast<index_t>(num) ; nbatch++) {
-            int x1 = j*stride1_+max_displacement_;
-            int y1 = i*stride1_+max_displacement_;
-            for (int top_channel = 0 ; top_channel < top_channels_ ; top_channel++) {
-              int s2o = (top_channel % neighborhood_grid_width_ - \
-              neighborhood_grid_radius_) * stride2_;
-              int s2p = (top_channel / neighborhood_grid_width_ - \
-              neighborhood_grid_radius_) * stride2_;
-              int x2 = x1 + s2o;
-              int y2 = y1 + s2p;
-              for (int h = 0; h < kernel_size_; h++)
-                for (int w = 0; w < kernel_size_; w++)
-                  for (int channel = 0 ; channel < channels; channel++) {
-                    if (is_multiply == true) {
-                      if ((y1 +  h - pad_size_ >= 0) && (x1 + w - pad_size_ >= 0) && \
-                      (y1 + h < height +pad_size_) && (x1 + w < width + pad_size_)) {
-                        in_grad1[nbatch][channel][y1+h-pad_size_][x1+w-pad_size_] += \
-                        out_grad[nbatch][top_channel][i][j] * \
-                        tmp2[nbatch][y2+h][x2+w][channel]/sumelems;
-                       }
-                       if ((y2 +  h - pad_size_ >= 0) && (x2 + w -pad_size_ >=0) && \
-                       (y2 + h < height +pad_size_) && (x2 + w < width + pad_size_)) {
-                       in_grad2[nbatch][channel][y2+h-pad_size_][x2+w-pad_size_] += \
-                       out_grad[nbatch][top_channel][i][j] * \
-                       tmp1[nbatch][y1+h][x1+w][channel]/sumelems;
-                       }
-                    } else {
-                      if ((y1 +  h - pad_size_ >= 0) && (x1 + w -pad_size_ >=0) && \
-                      (y1 + h < height + pad_size_) && (x1 + w < width + pad_size_)) {
-                        Dtype sign  = (tmp1[nbatch][y1+h][x1+w][channel] >= \
-                        tmp2[nbatch][y2+h][x2+w][channel])? Dtype(1.0) : Dtype(-1.0);
-                        in_grad1[nbatch][channel][y1+h-pad_size_][x1+w-pad_size_] +=\
-                        out_grad[nbatch][top_channel][i][j]*sign/sumelems;
-                      }
-                      if ((y2 +  h - pad_size_ >= 0) && (x2 + w - pad_size_ >=0) && \
-                      (y2 + h < height + pad_size_) && (x2 + w < width + pad_size_)) {
-                        Dtype sign  = (tmp1[nbatch][y1+h][x1+w][channel] >= \
-                        tmp2[nbatch][y2+h][x2+w][channel])? Dtype(-1.0) : Dtype(1.0);
-                        in_grad2[nbatch][channel][y2+h-pad_size_][x2+w-pad_size_] +=\
-                        out_grad[nbatch][top_channel][i][j]*sign/sumelems;
-                       }
-                    }
-                  }
-               }
-         }
+  const int padded_height = tmp1.size(1), padded_width = tmp1.size(2);
+  const int plane = height * width;
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int task = 0; task < num * num_blocks; ++task) {
+    const int nbatch = task / num_blocks;
+    const int c_begin = (task % num_blocks) * kChannelBlock;
+    const int c_end = std::min(c_begin + kChannelBlock, channels);
+    const Dtype *image1 = tmp1.dptr_ + nbatch * padded_height * padded_width * channels;
+    const Dtype *image2 = tmp2.dptr_ + nbatch * padded_height * padded_width * channels;
+    Dtype *grad1 = in_grad1.dptr_ + nbatch * channels * plane;
+    Dtype *grad2 = in_grad2.dptr_ + nbatch * channels * plane;
+    for (int i = 0; i < top_height_; ++i) {
+      for (int j = 0; j < top_width_; ++j) {
+        const int x1 = j * stride1_ + max_displacement_;
+        const int y1 = i * stride1_ + max_displacement_;
+        for (int top_channel = 0; top_channel < top_channels_; ++top_channel) {
+          const int s2o = (top_channel % neighborhood_grid_width_ -
+                           neighborhood_grid_radius_) * stride2_;
+          const int s2p = (top_channel / neighborhood_grid_width_ -
+                           neighborhood_grid_radius_) * stride2_;
+          const int x2 = x1 + s2o;
+          const int y2 = y1 + s2p;
+          const Dtype g = out_grad[nbatch][top_channel][i][j] / sumelems;
+          for (int h = 0; h < kernel_size_; ++h) {
+            for (int w = 0; w < kernel_size_; ++w) {
+              const Dtype *p1 = image1 + ((y1 + h) * padded_width + x1 + w) * channels;
+              const Dtype *p2 = image2 + ((y2 + h) * padded_width + x2 + w) * channels;
+              const int yy1 = y1 + h - pad_size_, xx1 = x1 + w - pad_size_;
+              const int yy2 = y2 + h - pad_size_, xx2 = x2 + w - pad_size_;
+              const bool in1 = yy1 >= 0 && xx1 >= 0 && yy1 < height && xx1 < width;
+              const bool in2 = yy2 >= 0 && xx2 >= 0 && yy2 < height && xx2 < width;
+              Dtype *q1 = grad1 + yy1 * width + xx1;
+              Dtype *q2 = grad2 + yy2 * width + xx2;
+              for (int c = c_begin; c < c_end; ++c) {
+                if (is_multiply) {
+                  if (in1) q1[c * plane] += g * p2[c];
+                  if (in2) q2[c * plane] += g * p1[c];
+                } else {
+                  const Dtype sign = p1[c] >= p2[c] ? Dtype(1) : Dtype(-1);
+                  if (in1) q1[c * plane] += g * sign;
+                  if (in2) q2[c * plane] -= g * sign;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
 }
 }  // namespace mshadow
 namespace mxnet {
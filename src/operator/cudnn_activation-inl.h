@@ -153,13 +153,11 @@ class CuDNNActivationOp : public Operator {
     typename DataType<DType>::ScaleType beta = 0.0f;
     Stream<gpu> *s = ctx.get_stream<gpu>();
     Tensor<gpu, 4, DType> grad;
-    Tensor<gpu, 4, DType> data;
     Tensor<gpu, 4, DType> output_data;
     Tensor<gpu, 4, DType> input_grad;
     if (in_grad[activation::kData].ndim() == 2) {
       Shape<4> dshape = Shape4(in_grad[activation::kData].shape_[0],
                                in_grad[activation::kData].shape_[1], 1, 1);
-      data = in_data[activation::kData].get_with_shape<gpu, 4, DType>(dshape, s);
       grad = out_grad[activation::kOut].get_with_shape<gpu, 4, DType>(dshape, s);
       output_data = out_data[activation::kOut].get_with_shape<gpu, 4, DType>(dshape, s);
       input_grad = in_grad[activation::kData].get_with_shape<gpu, 4, DType>(dshape, s);
@@ -175,12 +173,13 @@ class CuDNNActivationOp : public Operator {
         size_left /= dshape[i];
       }
       dshape[3] = size_left;
-      data = in_data[activation::kData].get_with_shape<gpu, 4, DType>(dshape, s);
       output_data = out_data[activation::kOut].get_with_shape<gpu, 4, DType>(dshape, s);
       grad = out_grad[activation::kOut].get_with_shape<gpu, 4, DType>(dshape, s);
       input_grad = in_grad[activation::kData].get_with_shape<gpu, 4, DType>(dshape, s);
     }
     CHECK_EQ(s->dnn_handle_ownership_, mshadow::Stream<gpu>::OwnHandle);
+    // the input is not kept for the backward pass, relu, sigmoid and tanh
+    // get the same gradients when it is replaced by the output
     #if CUDNN_MAJOR <= 4
     CUDNN_CALL(cudnnActivationBackward(s->dnn_handle_,
                                        mode_,
@@ -190,7 +189,7 @@ class CuDNNActivationOp : public Operator {
                                        shape_desc_,
                                        grad.dptr_,
                                        shape_desc_,
-                                       data.dptr_,
+                                       output_data.dptr_,
                                        &beta,
                                        shape_desc_,
                                        input_grad.dptr_));
@@ -203,7 +202,7 @@ class CuDNNActivationOp : public Operator {
                                        shape_desc_,
                                        grad.dptr_,
                                        shape_desc_,
-                                       data.dptr_,
+                                       output_data.dptr_,
                                        &beta,
                                        shape_desc_,
                                        input_grad.dptr_));
@@ -25,9 +25,13 @@
 #ifndef MXNET_OPERATOR_CUDNN_ALGOREG_INL_H_
 #define MXNET_OPERATOR_CUDNN_ALGOREG_INL_H_
 
+#include <dmlc/parameter.h>
 #include <algorithm>
+#include <fstream>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "../common/cuda_utils.h"
 #include "./convolution-inl.h"
@@ -64,6 +68,11 @@ class CuDNNAlgo {
 template<typename ParamType>
 class CuDNNAlgoReg {
  public:
+  /*!
+   * \brief name of the registry, which prefixes its records in the cache file
+   */
+  explicit CuDNNAlgoReg(const std::string& name) : name_(name) {}
+
   bool Find(const ParamType &param,
             const std::vector<TShape> &in_shape,
             const std::vector<TShape> &out_shape,
@@ -71,6 +80,7 @@ class CuDNNAlgoReg {
             cudnnDataType_t cudnn_forward_compute_type,
             cudnnDataType_t cudnn_backward_compute_type,
             int sm_arch,
+            int dev_id,
             CuDNNAlgo<cudnnConvolutionFwdAlgo_t> *fwd,
             CuDNNAlgo<cudnnConvolutionBwdDataAlgo_t> *bwd,
             CuDNNAlgo<cudnnConvolutionBwdFilterAlgo_t> *flt) {
@@ -85,6 +95,16 @@ class CuDNNAlgoReg {
       *flt = i->second.flt;
       return true;
     }
+    // look for the algorithms tuned by an earlier process
+    LoadCacheFile();
+    auto j = cached_.find(CacheKey(key, dev_id));
+    if (j != cached_.end()) {
+      reg_[key] = j->second;
+      *fwd = j->second.fwd;
+      *bwd = j->second.bwd;
+      *flt = j->second.flt;
+      return true;
+    }
     return false;
   }
 
@@ -95,6 +115,7 @@ class CuDNNAlgoReg {
                 cudnnDataType_t cudnn_forward_compute_type,
                 cudnnDataType_t cudnn_backward_compute_type,
                 int sm_arch,
+                int dev_id,
                 const CuDNNAlgo<cudnnConvolutionFwdAlgo_t> &fwd,
                 const CuDNNAlgo<cudnnConvolutionBwdDataAlgo_t> &bwd,
                 const CuDNNAlgo<cudnnConvolutionBwdFilterAlgo_t> &flt) {
@@ -117,6 +138,7 @@ class CuDNNAlgoReg {
     reg_[key].fwd = fwd;
     reg_[key].bwd = bwd;
     reg_[key].flt = flt;
+    AppendCacheFile(CacheKey(key, dev_id), reg_[key]);
   }
 
   static CuDNNAlgoReg *Get();
@@ -164,8 +186,75 @@ class CuDNNAlgoReg {
     }
   };
 
+  /*!
+   * \brief the key of a record in the cache file, made of the name of the
+   *  registry, the GPU model, the cuDNN version and the fields of key
+   */
+  std::string CacheKey(const ParamKey& key, int dev_id) {
+    auto it = device_names_.find(dev_id);
+    if (it == device_names_.end()) {
+      cudaDeviceProp prop;
+      CUDA_CALL(cudaGetDeviceProperties(&prop, dev_id));
+      it = device_names_.emplace(dev_id, std::string(prop.name)).first;
+    }
+    std::ostringstream os;
+    os << name_ << ';' << it->second << ';' << cudnnGetVersion() << ';';
+    for (const auto& kv : key.param.__DICT__()) os << kv.first << '=' << kv.second << ',';
+    os << ';' << key.data_shape << ';' << key.weight_shape << ';' << key.out_shape
+       << ';' << key.cudnn_data_type << ';' << key.cudnn_forward_compute_type
+       << ';' << key.cudnn_backward_compute_type << ';' << key.sm_arch;
+    std::string ret = os.str();
+    std::replace(ret.begin(), ret.end(), '\t', ' ');
+    std::replace(ret.begin(), ret.end(), '\n', ' ');
+    return ret;
+  }
+  /*!
+   * \brief read the records of the cache file named by
+   *  MXNET_CUDNN_AUTOTUNE_CACHE once, lock_ must be held.
+   *  Every line is a key and the algorithms, separated by a tab.
+   */
+  void LoadCacheFile() {
+    if (cache_loaded_) return;
+    cache_loaded_ = true;
+    cache_file_ = dmlc::GetEnv("MXNET_CUDNN_AUTOTUNE_CACHE", std::string());
+    if (cache_file_.empty()) return;
+    std::ifstream is(cache_file_);
+    std::string line;
+    while (std::getline(is, line)) {
+      size_t tab = line.find('\t');
+      if (tab == std::string::npos) continue;
+      std::istringstream values(line.substr(tab + 1));
+      int fwd, fwd_tc, bwd, bwd_tc, flt, flt_tc;
+      if (!(values >> fwd >> fwd_tc >> bwd >> bwd_tc >> flt >> flt_tc)) continue;
+      CudnnAlgorithms& algos = cached_[line.substr(0, tab)];
+      algos.fwd.Set(static_cast<cudnnConvolutionFwdAlgo_t>(fwd), fwd_tc != 0);
+      algos.bwd.Set(static_cast<cudnnConvolutionBwdDataAlgo_t>(bwd), bwd_tc != 0);
+      algos.flt.Set(static_cast<cudnnConvolutionBwdFilterAlgo_t>(flt), flt_tc != 0);
+    }
+  }
+  /*! \brief append a record to the cache file, lock_ must be held */
+  void AppendCacheFile(const std::string& key, const CudnnAlgorithms& algos) {
+    LoadCacheFile();
+    if (cache_file_.empty() || cached_.count(key)) return;
+    cached_[key] = algos;
+    std::ostringstream os;
+    os << key << '\t' << algos.fwd.AlgoNumber() << ' ' << algos.fwd.IsTensorCoreAlgo()
+       << ' ' << algos.bwd.AlgoNumber() << ' ' << algos.bwd.IsTensorCoreAlgo()
+       << ' ' << algos.flt.AlgoNumber() << ' ' << algos.flt.IsTensorCoreAlgo() << '\n';
+    // a single write per line, so that processes sharing the file do not mix lines
+    std::ofstream fo(cache_file_, std::ios::app);
+    fo << os.str() << std::flush;
+  }
+
+  std::string name_;
   std::mutex lock_;
   std::unordered_map<ParamKey, CudnnAlgorithms, ParamHash> reg_;
+  // the records of the cache file
+  std::unordered_map<std::string, CudnnAlgorithms> cached_;
+  // name of every GPU by device id
+  std::unordered_map<int, std::string> device_names_;
+  std::string cache_file_;
+  bool cache_loaded_ = false;
 };
 
 typedef CuDNNAlgoReg<ConvolutionParam> CuDNNConvAlgoReg;
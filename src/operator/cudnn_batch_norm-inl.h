@@ -91,15 +91,27 @@ class CuDNNBatchNormOp : public Operator {
           shape_[i] = 1;
         }
       }
+      channels_ = mshadow::Shape1(shape_[param_.axis]);
       CUDNN_CALL(cudnnCreateTensorDescriptor(&io_desc_));
       CUDNN_CALL(cudnnCreateTensorDescriptor(&mean_desc_));
-      CUDNN_CALL(cudnnSetTensor4dDescriptor(io_desc_,
-                                            CUDNN_TENSOR_NCHW,
-                                            dtype_,
-                                            shape_[0],
-                                            shape_[1],
-                                            shape_[2],
-                                            shape_[3]));
+      // the channels are last in NHWC, the sizes are given in NCHW order
+      if (param_.axis == 3) {
+        CUDNN_CALL(cudnnSetTensor4dDescriptor(io_desc_,
+                                              CUDNN_TENSOR_NHWC,
+                                              dtype_,
+                                              shape_[0],
+                                              shape_[3],
+                                              shape_[1],
+                                              shape_[2]));
+      } else {
+        CUDNN_CALL(cudnnSetTensor4dDescriptor(io_desc_,
+                                              CUDNN_TENSOR_NCHW,
+                                              dtype_,
+                                              shape_[0],
+                                              shape_[1],
+                                              shape_[2],
+                                              shape_[3]));
+      }
       CUDNN_CALL(cudnnDeriveBNTensorDescriptor(mean_desc_,
                                                io_desc_,
                                                CUDNN_BATCHNORM_SPATIAL));
@@ -120,15 +132,15 @@ class CuDNNBatchNormOp : public Operator {
 
     MSHADOW_REAL_TYPE_SWITCH(dtype_param_, DTypeParam, {
       Tensor<gpu, 1, DTypeParam> gamma =
-        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> beta =
-        in_data[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_data[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> moving_mean =
         aux_states[cudnnbatchnorm::kMovingMean]
-        .get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        .get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> moving_inv_var =
         aux_states[cudnnbatchnorm::kMovingInvVar]
-        .get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        .get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       typename DataType<DType>::ScaleType a = 1.0f;
       typename DataType<DType>::ScaleType b = 0.0f;
 
@@ -136,10 +148,10 @@ class CuDNNBatchNormOp : public Operator {
 
       if (ctx.is_train) {
         Tensor<gpu, 1, DTypeParam> save_mean =
-          out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+          out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
         Tensor<gpu, 1, DTypeParam> save_inv_var =
           out_data[cudnnbatchnorm::kInvVar]
-          .get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+          .get_with_shape<gpu, 1, DTypeParam>(channels_, s);
         CUDNN_CALL(cudnnBatchNormalizationForwardTraining(s->dnn_handle_,
                                                           mode,
                                                           &a,
@@ -208,15 +220,15 @@ class CuDNNBatchNormOp : public Operator {
 #endif
     MSHADOW_REAL_TYPE_SWITCH(dtype_param_, DTypeParam, {
       Tensor<gpu, 1, DTypeParam> gamma =
-        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> dbeta =
-        in_grad[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_grad[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> dgamma =
-        in_grad[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_grad[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> save_mean =
-        out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> save_inv_var =
-        out_data[cudnnbatchnorm::kInvVar].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        out_data[cudnnbatchnorm::kInvVar].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
 
       typename DataType<DType>::ScaleType a = 1.0f;
       typename DataType<DType>::ScaleType b = 0.0f;
@@ -250,15 +262,15 @@ class CuDNNBatchNormOp : public Operator {
 #else  // CUDNN_VERSION < 4007
     MSHADOW_REAL_TYPE_SWITCH(dtype_param_, DTypeParam, {
       Tensor<gpu, 1, DTypeParam> gamma =
-        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_data[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> dbeta =
-        in_grad[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_grad[cudnnbatchnorm::kBeta].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> dgamma =
-        in_grad[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        in_grad[cudnnbatchnorm::kGamma].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> save_mean =
-        out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        out_data[cudnnbatchnorm::kMean].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
       Tensor<gpu, 1, DTypeParam> save_inv_var =
-        out_data[cudnnbatchnorm::kInvVar].get_with_shape<gpu, 1, DTypeParam>(Shape1(shape_[1]), s);
+        out_data[cudnnbatchnorm::kInvVar].get_with_shape<gpu, 1, DTypeParam>(channels_, s);
 
       typename DataType<DType>::ScaleType a = 1.0f;
       typename DataType<DType>::ScaleType b = 0.0f;
@@ -294,6 +306,7 @@ class CuDNNBatchNormOp : public Operator {
   int dtype_param_;
   cudnnTensorDescriptor_t io_desc_, mean_desc_;
   mshadow::Shape<4> shape_;
+  mshadow::Shape<1> channels_;
   BatchNormParam param_;
 };
 #endif  // defined(__CUDACC__)
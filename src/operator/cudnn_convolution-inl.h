@@ -315,11 +315,12 @@ class CuDNNConvolutionOp : public Operator {
                        const Context &ctx) {
     using namespace mshadow;
 
-    // NDHWC not supported, NHWC not supported in true fp16
+    // NDHWC not supported, NHWC not supported in true fp16 before cuDNN v7,
+    // which runs it on the tensor cores
     auto layout_val = param.layout.value();
     auto true_fp16 = DataType<DType>::kFlag == kFloat16 &&
       (forward_compute_type == kFloat16 || backward_compute_type == kFloat16);
-    if (layout_val == kNDHWC || layout_val == kNHWC && true_fp16)
+    if (layout_val == kNDHWC || layout_val == kNHWC && true_fp16 && CUDNN_MAJOR < 7)
       return false;
 
     // Permits graceful fallback to pseudo-fp16 on heterogenous systems
@@ -582,8 +583,8 @@ class CuDNNConvolutionOp : public Operator {
                   cudnnDataType_t cudnn_backward_compute_type) {
     if (!CuDNNConvAlgoReg::Get()->Find(param_, in_shape, out_shape, dtype_,
                                        cudnn_forward_compute_type, cudnn_backward_compute_type,
-                                       SMArch(ctx.dev_id), &forward_algo_, &back_algo_,
-                                       &back_algo_w_)) {
+                                       SMArch(ctx.dev_id), ctx.dev_id, &forward_algo_,
+                                       &back_algo_, &back_algo_w_)) {
       // Not in algo registry, must determine via *Get*() or *Find*()
       Engine::VarHandle var = Engine::Get()->NewVariable();
       Engine::Get()->PushSync([=](RunContext rctx) {
@@ -774,8 +775,9 @@ class CuDNNConvolutionOp : public Operator {
         CuDNNConvAlgoReg::Get()->Register(param_, in_shape, out_shape, dtype_,
                                           cudnn_forward_compute_type,
                                           cudnn_backward_compute_type,
-                                          SMArch(ctx.dev_id), this->forward_algo_,
-                                          this->back_algo_, this->back_algo_w_);
+                                          SMArch(ctx.dev_id), ctx.dev_id,
+                                          this->forward_algo_, this->back_algo_,
+                                          this->back_algo_w_);
       }, ctx, {}, {var});
       Engine::Get()->WaitForVar(var);
       Engine::Get()->DeleteVariable([](RunContext s) {}, ctx, var);
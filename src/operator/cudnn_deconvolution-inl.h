@@ -601,7 +601,7 @@ class CuDNNDeconvolutionOp : public Operator {
     if (!CuDNNDeconvAlgoReg::Get()->Find(param_, in_shape, out_shape, dtype_,
                                          cudnn_forward_compute_type,
                                          cudnn_backward_compute_type,
-                                         SMArch(ctx.dev_id), &forward_algo_,
+                                         SMArch(ctx.dev_id), ctx.dev_id, &forward_algo_,
                                          &back_algo_, &back_algo_w_)) {
       // Not in algo registry, must determine via *Get*() or *Find*()
       Engine::VarHandle var = Engine::Get()->NewVariable();
@@ -796,8 +796,9 @@ class CuDNNDeconvolutionOp : public Operator {
         CuDNNDeconvAlgoReg::Get()->Register(param_, in_shape, out_shape, dtype_,
                                             cudnn_forward_compute_type,
                                             cudnn_backward_compute_type,
-                                            SMArch(ctx.dev_id), this->forward_algo_,
-                                            this->back_algo_, this->back_algo_w_);
+                                            SMArch(ctx.dev_id), ctx.dev_id,
+                                            this->forward_algo_, this->back_algo_,
+                                            this->back_algo_w_);
       }, ctx, {}, {var});
       Engine::Get()->WaitForVar(var);
       Engine::Get()->DeleteVariable([](RunContext s) {}, ctx, var);
@@ -188,24 +188,29 @@ class CuDNNPoolingOp : public Operator {
         // 2d conv
         Tensor<gpu, 4, DType> data = in_data[pool_enum::kData].get<gpu, 4, DType>(s);
         Tensor<gpu, 4, DType> out = out_data[pool_enum::kOut].get<gpu, 4, DType>(s);
-        mshadow::Shape<4> dshape = data.shape_;
+        // the descriptors take the sizes in NCHW order whatever the format
+        const int layout = param_.layout ? param_.layout.value() : kNCHW;
+        mshadow::Shape<4> dshape = ConvertLayout(data.shape_, layout, kNCHW);
+        mshadow::Shape<4> oshape = ConvertLayout(out.shape_, layout, kNCHW);
+        const cudnnTensorFormat_t format =
+            layout == kNHWC ? CUDNN_TENSOR_NHWC : CUDNN_TENSOR_NCHW;
         CUDNN_CALL(cudnnCreatePoolingDescriptor(&pooling_desc_));
         CUDNN_CALL(cudnnCreateTensorDescriptor(&in_desc_));
         CUDNN_CALL(cudnnCreateTensorDescriptor(&out_desc_));
         CUDNN_CALL(cudnnSetTensor4dDescriptor(in_desc_,
-                                              CUDNN_TENSOR_NCHW,
+                                              format,
                                               dtype_,
-                                              data.shape_[0],
-                                              data.shape_[1],
-                                              data.shape_[2],
-                                              data.shape_[3]));
+                                              dshape[0],
+                                              dshape[1],
+                                              dshape[2],
+                                              dshape[3]));
         CUDNN_CALL(cudnnSetTensor4dDescriptor(out_desc_,
-                                              CUDNN_TENSOR_NCHW,
+                                              format,
                                               dtype_,
-                                              out.shape_[0],
-                                              out.shape_[1],
-                                              out.shape_[2],
-                                              out.shape_[3]));
+                                              oshape[0],
+                                              oshape[1],
+                                              oshape[2],
+                                              oshape[3]));
         #if CUDNN_MAJOR >= 5
         CUDNN_CALL(cudnnSetPooling2dDescriptor(pooling_desc_,
                                                mode_,
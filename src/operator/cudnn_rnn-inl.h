@@ -32,6 +32,7 @@
 #include <utility>
 #include <cstdint>
 #include "./rnn-inl.h"
+#include "./sequence_op_common.h"
 
 namespace mxnet {
 namespace op {
@@ -43,12 +44,9 @@ class CuDNNRNNOp : public Operator {
     this->param_ = param;
     init_cudnn_ = false;
     dtype_ = mshadow::DataType<DType>::kCudnnFlag;
-    // TensorCore algos only allowed on fp16-I/O convolutions if permitted by the global policy.
-    // No tests in place for fp16 RNNs, so leave TensorCore disabled for now.
-    cudnn_tensor_core_ = false;
-    // When fp16 RNN tests are introduced, we can enable TensorCore as follows:
-//    cudnn_tensor_core =
-//        mshadow::DataType<DType>::kFlag == mshadow::kFloat16 && GetEnvAllowTensorCore();
+    // TensorCore algos only allowed on fp16-I/O RNNs if permitted by the global policy.
+    cudnn_tensor_core_ =
+        mshadow::DataType<DType>::kFlag == mshadow::kFloat16 && GetEnvAllowTensorCore();
     // Defaults
     input_mode_ = CUDNN_LINEAR_INPUT;  // Don't support this yet
     // RNN Mode
@@ -108,7 +106,7 @@ class CuDNNRNNOp : public Operator {
                        const std::vector<TBlob> &out_data,
                        const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
-    size_t in_expected = param_.lstm_q_ ? 4 : 3;
+    size_t in_expected = (param_.lstm_q_ ? 4 : 3) + param_.packed;
     size_t out_expected = param_.lstm_q_ ? 3 : 2;
     if (!param_.state_outputs)
         out_expected = 1;
@@ -117,10 +115,10 @@ class CuDNNRNNOp : public Operator {
     CHECK_EQ(out_data.size(), out_expected);
     Stream<gpu> *s = ctx.get_stream<gpu>();
     // get input + output tensors
-    Tensor<gpu, 3, DType> x = in_data[rnn_enum::kData].get<gpu, 3, DType>(s);
+    Tensor<gpu, 3, DType> x = SeqTensor(in_data[rnn_enum::kData], in_data, s);
     Tensor<gpu, 1, DType> w = in_data[rnn_enum::kParams].get<gpu, 1, DType>(s);
     Tensor<gpu, 3, DType> hx = in_data[rnn_enum::kState].get<gpu, 3, DType>(s);
-    Tensor<gpu, 3, DType> y = out_data[rnn_enum::kOut].get<gpu, 3, DType>(s);
+    Tensor<gpu, 3, DType> y = SeqTensor(out_data[rnn_enum::kOut], in_data, s);
 
     void * hy_ptr = NULL;
     if (param_.state_outputs)
@@ -140,7 +138,14 @@ class CuDNNRNNOp : public Operator {
     CHECK_EQ(y.CheckContiguous(), true);
 
     if (!init_cudnn_) {
-      Init(s, in_data, out_data);
+      Init(s, in_data, out_data, ctx.is_train);
+    }
+    if (param_.packed) {
+      SetBatchSizes(s, in_data[rnn_batch_sizes_index(param_.mode)]);
+      // the padding rows of the output
+      const index_t rows = packed_rows_ * y.size(2);
+      Tensor<gpu, 1, DType> padding(y.dptr_ + rows, Shape1(y.shape_.Size() - rows), s);
+      padding = mshadow::expr::ScalarExp<DType>(0.0f);
     }
     // Get temp space
     int temp_size = workspace_size_;
@@ -150,7 +155,7 @@ class CuDNNRNNOp : public Operator {
     if (ctx.is_train) {
       CUDNN_CALL(cudnnRNNForwardTraining(s->dnn_handle_,
                                          rnn_desc_,
-                                         param_.seq_length_,
+                                         num_steps_,
                                          x_desc_vec_.data(),
                                          x.dptr_,
                                          hx_desc_,
@@ -173,7 +178,7 @@ class CuDNNRNNOp : public Operator {
       // inference mode
       CUDNN_CALL(cudnnRNNForwardInference(s->dnn_handle_,
                                           rnn_desc_,
-                                          param_.seq_length_,
+                                          num_steps_,
                                           x_desc_vec_.data(),
                                           x.dptr_,
                                           hx_desc_,
@@ -201,7 +206,7 @@ class CuDNNRNNOp : public Operator {
                         const std::vector<TBlob> &in_grad,
                         const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
-    size_t in_expected = param_.lstm_q_ ? 4 : 3;
+    size_t in_expected = (param_.lstm_q_ ? 4 : 3) + param_.packed;
     size_t out_expected = param_.lstm_q_ ? 3 : 2;
     if (!param_.state_outputs)
       out_expected = 1;
@@ -215,14 +220,14 @@ class CuDNNRNNOp : public Operator {
     CHECK_NE(req[rnn_enum::kState], kAddTo) << "AddTo is not supported for state";
     Stream<gpu> *s = ctx.get_stream<gpu>();
     // get input + output tensors
-    Tensor<gpu, 3, DType> x = in_data[rnn_enum::kData].get<gpu, 3, DType>(s);
-    Tensor<gpu, 3, DType> dx = in_grad[rnn_enum::kData].get<gpu, 3, DType>(s);
+    Tensor<gpu, 3, DType> x = SeqTensor(in_data[rnn_enum::kData], in_data, s);
+    Tensor<gpu, 3, DType> dx = SeqTensor(in_grad[rnn_enum::kData], in_data, s);
     Tensor<gpu, 1, DType> w = in_data[rnn_enum::kParams].get<gpu, 1, DType>(s);
     Tensor<gpu, 1, DType> dw = in_grad[rnn_enum::kParams].get<gpu, 1, DType>(s);
     Tensor<gpu, 3, DType> hx = in_data[rnn_enum::kState].get<gpu, 3, DType>(s);
     Tensor<gpu, 3, DType> dhx = in_grad[rnn_enum::kState].get<gpu, 3, DType>(s);
-    Tensor<gpu, 3, DType> y = out_data[rnn_enum::kOut].get<gpu, 3, DType>(s);
-    Tensor<gpu, 3, DType> dy = out_grad[rnn_enum::kOut].get<gpu, 3, DType>(s);
+    Tensor<gpu, 3, DType> y = SeqTensor(out_data[rnn_enum::kOut], in_data, s);
+    Tensor<gpu, 3, DType> dy = SeqTensor(out_grad[rnn_enum::kOut], in_data, s);
     if (req[rnn_enum::kParams] != kAddTo) {
       dw = mshadow::expr::ScalarExp<DType>(0.0f);
     }
@@ -253,7 +258,19 @@ class CuDNNRNNOp : public Operator {
     CHECK_EQ(dy.CheckContiguous(), true);
 
     if (!init_cudnn_) {
-      Init(s, in_data, out_data);
+      Init(s, in_data, out_data, true);
+    }
+    if (param_.packed) {
+      const int bs_index = rnn_batch_sizes_index(param_.mode);
+      SetBatchSizes(s, in_data[bs_index]);
+      // the padding rows of the gradient of the data
+      const index_t rows = packed_rows_ * dx.size(2);
+      Tensor<gpu, 1, DType> padding(dx.dptr_ + rows, Shape1(dx.shape_.Size() - rows), s);
+      padding = mshadow::expr::ScalarExp<DType>(0.0f);
+      if (req[bs_index] != kNullOp && req[bs_index] != kAddTo) {
+        Tensor<gpu, 1, DType> dbs = in_grad[bs_index].FlatTo1D<gpu, DType>(s);
+        dbs = mshadow::expr::ScalarExp<DType>(0.0f);
+      }
     }
 
     // Get temp space
@@ -263,7 +280,7 @@ class CuDNNRNNOp : public Operator {
                               mshadow::Shape1(temp_size), s);
     CUDNN_CALL(cudnnRNNBackwardData(s->dnn_handle_,
                                     rnn_desc_,
-                                    param_.seq_length_,
+                                    num_steps_,
                                     y_desc_vec_.data(),
                                     y.dptr_,
                                     dy_desc_vec_.data(),
@@ -290,7 +307,7 @@ class CuDNNRNNOp : public Operator {
                                     reserve_space_byte_));
     CUDNN_CALL(cudnnRNNBackwardWeights(s->dnn_handle_,
                                        rnn_desc_,
-                                       param_.seq_length_,
+                                       num_steps_,
                                        x_desc_vec_.data(),
                                        x.dptr_,
                                        hx_desc_,
@@ -306,14 +323,67 @@ class CuDNNRNNOp : public Operator {
   }
 
  private:
+  // Packed sequences of shape (seq_len * batch, size) are viewed as
+  // (seq_len, batch, size), the steps are given to cuDNN by their descriptors.
+  inline mshadow::Tensor<gpu, 3, DType> SeqTensor(const TBlob &blob,
+                                                  const std::vector<TBlob> &in_data,
+                                                  mshadow::Stream<gpu> *s) const {
+    if (!param_.packed) return blob.get<gpu, 3, DType>(s);
+    const index_t seq_len = in_data[rnn_batch_sizes_index(param_.mode)].Size();
+    return blob.get_with_shape<gpu, 3, DType>(
+        mshadow::Shape3(seq_len, blob.shape_[0] / seq_len, blob.shape_[1]), s);
+  }
+
+  // Sets the batch sizes of the step descriptors to the ones of the packed
+  // sequences, cuDNN skips the steps past the end of the sequences. The steps
+  // of zero batch are left out. The workspace and reserve sizes of the full
+  // batch, computed at Init, bound the ones of the packed sequences.
+  inline void SetBatchSizes(mshadow::Stream<gpu> *s, const TBlob &batch_sizes) {
+    std::vector<int> batch_sizes_vec(param_.seq_length_);
+    IndexTensorToVector(batch_sizes.get<gpu, 1, DType>(s), &batch_sizes_vec);
+    CheckBatchSizes(batch_sizes_vec, param_.batch_size_);
+    if (batch_sizes_vec == batch_sizes_) return;
+    batch_sizes_ = batch_sizes_vec;
+    num_steps_ = 0;
+    packed_rows_ = 0;
+    const int output_size = param_.bidirectional ? param_.state_size * 2 : param_.state_size;
+    for (int t = 0; t < param_.seq_length_ && batch_sizes_[t] > 0; ++t) {
+      SetStepDescriptor(x_desc_vec_[t], batch_sizes_[t], param_.input_size_);
+      SetStepDescriptor(dx_desc_vec_[t], batch_sizes_[t], param_.input_size_);
+      SetStepDescriptor(y_desc_vec_[t], batch_sizes_[t], output_size);
+      SetStepDescriptor(dy_desc_vec_[t], batch_sizes_[t], output_size);
+      ++num_steps_;
+      packed_rows_ += batch_sizes_[t];
+    }
+  }
+
+  inline void SetStepDescriptor(cudnnTensorDescriptor_t desc, int batch, int size) {
+    int dimA[3] = {batch, size, 1};
+    int strideA[3] = {size, 1, 1};
+    CUDNN_CALL(cudnnSetTensorNdDescriptor(desc, dtype_, 3, dimA, strideA));
+  }
+
+  // The persistent kernel keeps the recurrent weights on chip across the
+  // timesteps, which removes the per step gemm launches dominating the latency
+  // of small batches. It is only picked for operators first run for inference,
+  // on padded sequences.
+  inline bool UsePersistentAlgo(int batch_size, bool is_train) const {
+    const int max_batch = dmlc::GetEnv("MXNET_CUDNN_RNN_PERSIST_MAX_BATCH", 0);
+    if (is_train || param_.packed || batch_size > max_batch) return false;
+    int device_id;
+    CUDA_CALL(cudaGetDevice(&device_id));
+    return ComputeCapabilityMajor(device_id) >= 6;
+  }
+
   inline void Init(mshadow::Stream<gpu> *s,
                    const std::vector<TBlob> &in_data,
-                   const std::vector<TBlob> &out_data) {
+                   const std::vector<TBlob> &out_data,
+                   bool is_train) {
     using namespace mshadow;
     #if CUDNN_MAJOR >= 5
     format_ = CUDNN_TENSOR_NCHW;
     #endif
-    size_t in_expected = param_.lstm_q_ ? 4 : 3;
+    size_t in_expected = (param_.lstm_q_ ? 4 : 3) + param_.packed;
     size_t out_expected = param_.lstm_q_ ? 3 : 2;
     if (!param_.state_outputs)
       out_expected = 1;
@@ -323,11 +393,12 @@ class CuDNNRNNOp : public Operator {
     if (!init_cudnn_) {
       init_cudnn_ = true;
       // get input + output tensors
-      Tensor<gpu, 3, DType> x = in_data[rnn_enum::kData].get<gpu, 3, DType>(s);
+      Tensor<gpu, 3, DType> x = SeqTensor(in_data[rnn_enum::kData], in_data, s);
       Tensor<gpu, 1, DType> w = in_data[rnn_enum::kParams].get<gpu, 1, DType>(s);
       param_.seq_length_ = x.shape_[0];
       param_.batch_size_ = x.shape_[1];
       param_.input_size_ = x.shape_[2];
+      num_steps_ = param_.seq_length_;
 
       // Tensor Descriptors
       std::vector<cudnnTensorDescriptor_t> x_vec(param_.seq_length_);
@@ -458,7 +529,8 @@ class CuDNNRNNOp : public Operator {
       CUDNN_CALL(cudnnCreateRNNDescriptor(&rnn_desc_));
 
       #if CUDNN_MAJOR >= 6
-        cudnnRNNAlgo_t rnn_algo = CUDNN_RNN_ALGO_STANDARD;
+        cudnnRNNAlgo_t rnn_algo = UsePersistentAlgo(param_.batch_size_, is_train) ?
+            CUDNN_RNN_ALGO_PERSIST_STATIC : CUDNN_RNN_ALGO_STANDARD;
         CUDNN_CALL(cudnnSetRNNDescriptor_v6(s->dnn_handle_,
                                             rnn_desc_,
                                             param_.state_size,
@@ -575,6 +647,9 @@ class CuDNNRNNOp : public Operator {
   uint64_t seed_ = 17 + rand() % 4096;  // NOLINT(runtime/threadsafe_fn)
   size_t workspace_byte_, reserve_space_byte_, dropout_byte_;
   int workspace_size_, dropout_size_;
+  // steps given to cuDNN, the batch sizes and rows of the packed sequences they were set for
+  int num_steps_, packed_rows_;
+  std::vector<int> batch_sizes_;
   std::vector<cudnnTensorDescriptor_t> x_desc_vec_, y_desc_vec_, dx_desc_vec_, dy_desc_vec_;
   cudnnTensorDescriptor_t hx_desc_, cx_desc_;
   cudnnTensorDescriptor_t hy_desc_, cy_desc_;
@@ -29,6 +29,7 @@
 #include <dmlc/parameter.h>
 #include <mxnet/operator.h>
 #include <mxnet/c_api.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <string>
@@ -40,6 +41,7 @@
 #include <condition_variable>
 #include <queue>
 #include "../operator_common.h"
+#include "../../ndarray/autograd.h"
 
 namespace mxnet {
 namespace op {
@@ -69,6 +71,96 @@ class Registry {
   std::map<std::string, CustomOpPropCreator> registry_;
 };
 
+/*!
+ * \brief Runs the frontend callbacks of the custom operators on dedicated
+ *  worker threads.
+ *
+ *  Custom operators are asynchronous: Forward and Backward queue the
+ *  callback and return, so the engine thread is released while the frontend
+ *  runs. The callback sees the arrays through NDArrays with fresh engine
+ *  variables, the operations it pushes on them are scheduled as usual, and the
+ *  operator completes once these operations are done.
+ */
+class CustomOperator {
+ public:
+  /*!
+   * \brief queue func, it runs with the given autograd states, and
+   *  ctx.async_on_complete is called once the pending writes to arrs are done.
+   */
+  template<typename Func>
+  void Push(const Func& func, const OpContext& ctx, bool recording, bool training,
+            const std::vector<NDArray>& arrs) {
+    auto task = [=]() {
+      bool prev_recording = autograd::AutogradRuntime::Get()->SetIsRecording(recording);
+      bool prev_training = autograd::AutogradRuntime::Get()->SetIsTraining(training);
+      func();
+      autograd::AutogradRuntime::Get()->SetIsTraining(prev_training);
+      autograd::AutogradRuntime::Get()->SetIsRecording(prev_recording);
+      if (naive_engine_) {
+        ctx.async_on_complete();
+        return;
+      }
+      std::vector<engine::VarHandle> vars;
+      for (const auto& nd : arrs) {
+        if (!nd.is_none()) vars.push_back(nd.var());
+      }
+      Engine::Get()->PushSync([ctx](RunContext rctx) {
+          ctx.async_on_complete();
+        }, ctx.run_ctx.ctx, vars, {}, FnProperty::kNormal, 0,
+        PROFILER_MESSAGE("CustomOperator"));
+    };
+    if (naive_engine_) {
+      task();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push(task);
+    }
+    cv_.notify_one();
+  }
+
+  static CustomOperator* Get();
+
+ private:
+  CustomOperator() {
+    const char *type = getenv("MXNET_ENGINE_TYPE");
+    naive_engine_ = type != nullptr && std::string(type) == "NaiveEngine";
+    if (naive_engine_) return;
+    const int nthreads = std::max(dmlc::GetEnv("MXNET_CUSTOM_OP_NUM_THREADS", 1), 1);
+    for (int i = 0; i < nthreads; ++i) {
+      workers_.emplace_back([this]() { ThreadMain(); });
+    }
+  }
+  ~CustomOperator() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      destructing_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+  }
+  void ThreadMain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this]() { return destructing_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      std::function<void()> task = std::move(queue_.front());
+      queue_.pop();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+  /*! \brief NaiveEngine runs the callbacks on the calling thread */
+  bool naive_engine_;
+  bool destructing_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::queue<std::function<void()> > queue_;
+  std::vector<std::thread> workers_;
+};
+
 }  // namespace custom
 }  // namespace op
 }  // namespace mxnet
@@ -35,13 +35,8 @@
 #include <algorithm>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
-
-#if defined(USE_MKL) && defined(_OPENMP)
-#include <omp.h>
-
-#include <mkl_vml_functions.h>
-#include <mkl_vsl.h>
-#endif  // USE_MKL && _OPENMP
+#include "./mxnet_op.h"
+#include "../common/random_generator.h"
 
 namespace dropout {
 enum DropoutOpInputs {kData};
@@ -53,28 +48,6 @@ enum DropoutOpMode {kTraining, kAlways};
 namespace mxnet {
 namespace op {
 
-#if defined(USE_MKL) && defined(_OPENMP)
-static void bernoulli_generate(int n, double p, int* r) {
-  int seed = 17 + rand() % 4096;  // NOLINT(runtime/threadsafe_fn)
-  int nthr = omp_get_max_threads();
-# pragma omp parallel num_threads(nthr)
-  {
-    const int ithr = omp_get_thread_num();
-    const int avg_amount = (n + nthr - 1) / nthr;
-    const int my_offset = ithr * avg_amount;
-    const int my_amount = std::min(my_offset + avg_amount, n) - my_offset;
-    if (my_amount > 0) {
-      VSLStreamStatePtr stream;
-      vslNewStream(&stream, VSL_BRNG_MCG31, seed);
-      vslSkipAheadStream(stream, my_offset);
-      viRngBernoulli(VSL_RNG_METHOD_BERNOULLI_ICDF, stream, my_amount,
-        r + my_offset, p);
-      vslDeleteStream(&stream);
-    }
-  }
-}
-#endif  // USE_MKL && _OPENMP
-
 struct DropoutParam : public dmlc::Parameter<DropoutParam> {
   float p;
   int mode;
@@ -90,6 +63,46 @@ struct DropoutParam : public dmlc::Parameter<DropoutParam> {
   }
 };  // struct DropoutParam
 
+/*!
+ * \brief keeps the elements 8 * i to 8 * i + 7 with probability pkeep and
+ *  packs whether they are kept in bit 0 to 7 of mask[i]. The random numbers
+ *  come from the counters of the parallel random resource.
+ */
+template<int req>
+struct DropoutForwardKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, uint8_t *mask, const DType *data,
+                                  common::random::PhiloxStream rnd, real_t pkeep, int count) {
+    const DType scale = DType(1.0f / pkeep);
+    const int begin = i * 8;
+    const int end = begin + 8 < count ? begin + 8 : count;
+    uint8_t bits = 0;
+    for (int j = begin; j < end; ++j) {
+      const bool keep = rnd.Uniform(j) < pkeep;
+      bits |= static_cast<uint8_t>(keep) << (j - begin);
+      KERNEL_ASSIGN(out[j], req, keep ? data[j] * scale : DType(0.0f));
+    }
+    mask[i] = bits;
+  }
+};
+
+/*! \brief gradient of the elements 8 * i to 8 * i + 7 given their packed mask */
+template<int req>
+struct DropoutBackwardKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *igrad, const uint8_t *mask, const DType *ograd,
+                                  real_t pkeep, int count) {
+    const DType scale = DType(1.0f / pkeep);
+    const int begin = i * 8;
+    const int end = begin + 8 < count ? begin + 8 : count;
+    const uint8_t bits = mask[i];
+    for (int j = begin; j < end; ++j) {
+      const bool keep = (bits >> (j - begin)) & 1;
+      KERNEL_ASSIGN(igrad[j], req, keep ? ograd[j] * scale : DType(0.0f));
+    }
+  }
+};
+
 template<typename xpu, typename DType>
 class DropoutOp : public Operator {
  public:
@@ -113,23 +126,14 @@ class DropoutOp : public Operator {
     Tensor<xpu, 2, DType> data = in_data[dropout::kData].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> out = out_data[dropout::kOut].FlatTo2D<xpu, DType>(s);
     if (ctx.is_train || mode_ == dropout::kAlways) {
-      Tensor<xpu, 2, DType> mask = out_data[dropout::kMask].FlatTo2D<xpu, DType>(s);
-#if !defined(__CUDACC__) && defined(USE_MKL) && defined(_OPENMP)
-      DType* outptr = out.dptr_;
-      DType* dataptr = data.dptr_;
-      int* maskptr = reinterpret_cast<int*>(mask.dptr_);
-      int count = mask.shape_[0]*mask.shape_[1];
-      bernoulli_generate(count, this->pkeep_, maskptr);
-  #pragma omp parallel for
-      for (int i = 0; i < count; ++i) {
-        outptr[i] = dataptr[i] * maskptr[i] * (1.0f / pkeep_);
-      }
-#else
-      Random<xpu> *prnd = ctx.requested[dropout::kRandom].get_random<xpu, real_t>(s);
-      mask = tcast<DType>(F<mshadow_op::threshold>(
-             prnd->uniform(mask.shape_), pkeep_) * (1.0f / pkeep_));
-      Assign(out, req[dropout::kOut], data * mask);
-#endif  // USE_MKL && _OPENMP
+      const int count = data.shape_.Size();
+      common::random::PhiloxStream rnd =
+          ctx.requested[dropout::kRandom].get_parallel_random()->Take(count);
+      MXNET_ASSIGN_REQ_SWITCH(req[dropout::kOut], Req, {
+        mxnet_op::Kernel<DropoutForwardKernel<Req>, xpu>::Launch(
+            s, out_data[dropout::kMask].Size(), out.dptr_,
+            out_data[dropout::kMask].dptr<uint8_t>(), data.dptr_, rnd, pkeep_, count);
+      });
     } else {
       Assign(out, req[dropout::kOut], F<mshadow_op::identity>(data));
     }
@@ -148,23 +152,14 @@ class DropoutOp : public Operator {
     CHECK_EQ(in_grad.size(), 1U);
     Stream<xpu> *s = ctx.get_stream<xpu>();
     Tensor<xpu, 2, DType> grad = out_grad[dropout::kOut].FlatTo2D<xpu, DType>(s);
-    Tensor<xpu, 2, DType> mask = out_data[dropout::kMask].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> gdata = in_grad[dropout::kData].FlatTo2D<xpu, DType>(s);
     if (ctx.is_train || mode_ == dropout::kAlways) {
-#if !defined(__CUDACC__) && defined(USE_MKL) && defined(_OPENMP)
-      DType* ingradptr = gdata.dptr_;
-      DType* outgradptr = grad.dptr_;
-      int* maskptr = reinterpret_cast<int*>(mask.dptr_);
-
-      int count = mask.shape_[0]*mask.shape_[1];
-
-      #pragma omp parallel for
-      for (int i = 0; i < count; ++i) {
-        ingradptr[i] = outgradptr[i] * maskptr[i] * (1.0f / pkeep_);
-      }
-#else  // USE_MKL && _OPENMP
-      Assign(gdata, req[dropout::kData], grad * mask);
-#endif  // USE_MKL && _OPENMP
+      MXNET_ASSIGN_REQ_SWITCH(req[dropout::kData], Req, {
+        mxnet_op::Kernel<DropoutBackwardKernel<Req>, xpu>::Launch(
+            s, out_data[dropout::kMask].Size(), gdata.dptr_,
+            out_data[dropout::kMask].dptr<uint8_t>(), grad.dptr_, pkeep_,
+            static_cast<int>(grad.shape_.Size()));
+      });
     } else {
       Assign(gdata, req[dropout::kData], F<mshadow_op::identity>(grad));
     }
@@ -199,7 +194,8 @@ class DropoutProp : public OperatorProperty {
     if (dshape.ndim() == 0) return false;
     out_shape->clear();
     out_shape->push_back(dshape);
-    out_shape->push_back(dshape);
+    // the mask keeps one bit per element
+    out_shape->push_back(Shape1((dshape.Size() + 7) / 8));
     return true;
   }
 
@@ -214,9 +210,9 @@ class DropoutProp : public OperatorProperty {
       return false;
     }
 
-    size_t nout = this->ListOutputs().size();
     out_type->clear();
-    for (size_t i = 0; i < nout; ++i) out_type->push_back(dtype);
+    out_type->push_back(dtype);
+    out_type->push_back(mshadow::kUint8);
     return true;
   }
 
@@ -253,7 +249,7 @@ class DropoutProp : public OperatorProperty {
 
   std::vector<ResourceRequest> ForwardResource(
     const std::vector<TShape> &in_shape) const override {
-    return {ResourceRequest::kRandom};
+    return {ResourceRequest::kParallelRandom};
   }
 
   int NumVisibleOutputs() const override {
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fused_pointwise.cc
+ * \brief Pointwise operators fused into one kernel compiled at runtime with NVRTC
+ */
+#include <mxnet/base.h>
+#if ((MXNET_USE_CUDA) && (MXNET_USE_NVRTC))
+#include <mxnet/mxrtc.h>
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./operator_common.h"
+#include "./elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+struct FusedPointwiseParam : public dmlc::Parameter<FusedPointwiseParam> {
+  int num_inputs;
+  std::string code;
+  DMLC_DECLARE_PARAMETER(FusedPointwiseParam) {
+    DMLC_DECLARE_FIELD(num_inputs).set_lower_bound(1)
+    .describe("Number of inputs.");
+    DMLC_DECLARE_FIELD(code)
+    .describe("CUDA statements computing the output r of type DType from the "
+              "inputs v0, v1, ...");
+  }
+};
+
+DMLC_REGISTER_PARAMETER(FusedPointwiseParam);
+
+/*!
+ * \brief get the compiled kernel of a fused node, kernels are loaded once
+ *  per code, data type and device, and compiled once per machine when
+ *  MXNET_RTC_CACHE_DIR is set.
+ */
+CUfunction GetFusedPointwiseKernel(const FusedPointwiseParam& param, int dtype, int dev_id) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, CUfunction> kernels;
+  std::string type_name;
+  if (dtype == mshadow::kFloat32) {
+    type_name = "float";
+  } else if (dtype == mshadow::kFloat64) {
+    type_name = "double";
+  } else {
+    LOG(FATAL) << "_FusedPointwise only supports float32 and float64, set "
+               << "MXNET_EXEC_ENABLE_POINTWISE_FUSION=0 for other types.";
+  }
+  std::string key = type_name + ";" + std::to_string(dev_id) + ";" + param.code;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = kernels.find(key);
+  if (it != kernels.end()) return it->second;
+
+  std::string source = "typedef " + type_name + " DType;\n"
+      "extern \"C\" __global__ void fused_pointwise(";
+  for (int i = 0; i < param.num_inputs; ++i) {
+    source += "const DType* in" + std::to_string(i) + ", ";
+  }
+  source += "DType* out, int add, long long n) {\n"
+      "for (long long i = blockIdx.x * static_cast<long long>(blockDim.x) + threadIdx.x;\n"
+      "     i < n; i += static_cast<long long>(blockDim.x) * gridDim.x) {\n";
+  for (int i = 0; i < param.num_inputs; ++i) {
+    source += "const DType v" + std::to_string(i) + " = in" + std::to_string(i) + "[i];\n";
+  }
+  source += param.code + "out[i] = add ? out[i] + r : r;\n}\n}\n";
+  std::string ptx = MXRtc::GetPTX("fused_pointwise", source, dev_id);
+  CUmodule module;
+  CUfunction func;
+  CUresult err;
+  CHECK_EQ(err = cuModuleLoadDataEx(&module, ptx.c_str(), 0, 0, 0), CUDA_SUCCESS)
+      << "CudaError: " << err;
+  CHECK_EQ(err = cuModuleGetFunction(&func, module, "fused_pointwise"), CUDA_SUCCESS)
+      << "CudaError: " << err;
+  kernels[key] = func;
+  return func;
+}
+
+void FusedPointwiseCompute(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  const FusedPointwiseParam& param = nnvm::get<FusedPointwiseParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), static_cast<size_t>(param.num_inputs));
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  long long n = outputs[0].Size();  // NOLINT(*)
+  if (n == 0) return;
+  mshadow::Stream<gpu>* s = ctx.get_stream<gpu>();
+  CUfunction func = GetFusedPointwiseKernel(param, outputs[0].type_flag_,
+                                            ctx.run_ctx.ctx.dev_id);
+  std::vector<void*> ptrs;
+  for (const auto& in : inputs) ptrs.push_back(in.dptr_);
+  void* out = outputs[0].dptr_;
+  int add = req[0] == kAddTo;
+  std::vector<void*> args;
+  for (auto& p : ptrs) args.push_back(&p);
+  args.push_back(&out);
+  args.push_back(&add);
+  args.push_back(&n);
+  const unsigned int kThreads = 256;
+  const unsigned int kMaxBlocks = 4096;
+  unsigned int blocks = static_cast<unsigned int>(
+      std::min<long long>((n + kThreads - 1) / kThreads, kMaxBlocks));  // NOLINT(*)
+  CUresult err;
+  CHECK_EQ(err = cuLaunchKernel(func, blocks, 1, 1, kThreads, 1, 1, 0,
+                                mshadow::Stream<gpu>::GetStream(s), args.data(), 0),
+           CUDA_SUCCESS) << "CudaError: " << err;
+}
+
+NNVM_REGISTER_OP(_FusedPointwise)
+.describe(R"code(Pointwise operators fused into one kernel compiled at runtime.
+
+The graph executor creates this operator when MXNET_EXEC_ENABLE_POINTWISE_FUSION
+is set, for groups of elementwise arithmetic, scalar and activation operators.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+    const FusedPointwiseParam& param = nnvm::get<FusedPointwiseParam>(attrs.parsed);
+    return static_cast<uint32_t>(param.num_inputs);
+  })
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<FusedPointwiseParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<-1, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, 1>)
+.set_attr<nnvm::FInplaceOption>("FInplaceOption",
+  [](const NodeAttrs& attrs){
+    return std::vector<std::pair<int, int> >{{0, 0}};
+  })
+.set_attr<FCompute>("FCompute<gpu>", FusedPointwiseCompute)
+.add_argument("data", "NDArray-or-Symbol[]", "Inputs of the fused operators")
+.add_arguments(FusedPointwiseParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // ((MXNET_USE_CUDA) && (MXNET_USE_NVRTC))
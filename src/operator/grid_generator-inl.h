@@ -34,6 +34,7 @@
 #include <utility>
 #include <string>
 #include "./mshadow_op.h"
+#include "./mxnet_op.h"
 #include "./operator_common.h"
 #include "./linalg.h"
 
@@ -43,7 +44,6 @@ namespace op {
 namespace grid {
 enum GridGeneratorOpInputs {kData};
 enum GridGeneratorOpOutputs {kOut, kGridDst};
-enum GridGeneratorOpResource {kTempSpace};
 enum GridGeneratorTransformType {kAffine, kWarp};
 }
 
@@ -64,6 +64,50 @@ struct GridGeneratorParam : public dmlc::Parameter<GridGeneratorParam> {
   }
 };
 
+/*! \brief the target coordinates x, y and 1 of an affine grid, normalized to [-1, 1] */
+struct AffineGridDst {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* grid_dst, int height, int width) {
+    const int size = height * width;
+    grid_dst[i] = DType(-1.0 + (i % width) * (2.0 / (width - 1)));
+    grid_dst[size + i] = DType(-1.0 + (i / width) * (2.0 / (height - 1)));
+    grid_dst[2 * size + i] = DType(1);
+  }
+};
+
+/*!
+ * \brief the normalized source coordinates of a warp, the target coordinates
+ *  plus the optical flow, and the target coordinates of its grid_dst output
+ */
+template<int req>
+struct WarpGridSrc {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, DType* grid_dst, const DType* flow,
+                                  int height, int width) {
+    const int size = height * width;
+    const int p = i % size;
+    const bool is_x = (i / size) % 2 == 0;
+    const DType coord = is_x ? DType(p % width) : DType(p / width);
+    const DType scale = DType(((is_x ? width : height) - 1.0) / 2.0);
+    KERNEL_ASSIGN(out[i], req, (flow[i] + coord) / scale - DType(1));
+    // the first batch writes the target coordinates
+    if (i < 2 * size) grid_dst[i] = coord;
+  }
+};
+
+/*! \brief the gradient of the optical flow of a warp */
+template<int req>
+struct WarpGridSrcBackward {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* gdata, const DType* grad,
+                                  int height, int width) {
+    const int size = height * width;
+    const bool is_x = (i / size) % 2 == 0;
+    const DType scale = DType(((is_x ? width : height) - 1.0) / 2.0);
+    KERNEL_ASSIGN(gdata[i], req, grad[i] / scale);
+  }
+};
+
 template<typename xpu, typename DType>
 class GridGeneratorOp : public Operator {
  public:
@@ -93,15 +137,8 @@ class GridGeneratorOp : public Operator {
         Tensor<xpu, 2, DType> data = in_data[grid::kData]
           .get_with_shape<xpu, 2, DType>(data_shape, s);
         // x, y, 1
-        grid_dst[0] = range<DType>(0, grid_dst.shape_[1]);
-        grid_dst[0] = grid_dst[0] - tcast<DType>(tcast<int>(grid_dst[0] /
-          scalar<DType>(param_.target_shape[1]))) * scalar<DType>(param_.target_shape[1]);
-        grid_dst[0] = scalar<DType>(-1.0) + grid_dst[0] *
-          scalar<DType>(2.0 / (param_.target_shape[1] - 1));
-        grid_dst[1] = range<DType>(0, grid_dst.shape_[1]);
-        grid_dst[1] = scalar<DType>(-1.0) + tcast<DType>(tcast<int>(grid_dst[1] /
-          scalar<DType>(param_.target_shape[1]))) * scalar<DType>(2.0/(param_.target_shape[0] - 1));
-        grid_dst[2] = scalar<DType>(1.0);
+        mxnet_op::Kernel<AffineGridDst, xpu>::Launch(s, grid_dst.shape_[1], grid_dst.dptr_,
+          param_.target_shape[0], param_.target_shape[1]);
         // Legacy approach shown here for comparison:
         //   Assign(out, req[grid::kOut], dot(data, grid_dst));
         linalg_gemm(data, grid_dst, out, false, false, s, req[grid::kOut]);
@@ -115,17 +152,10 @@ class GridGeneratorOp : public Operator {
         Tensor<xpu, 4, DType> out = out_data[grid::kOut].get<xpu, 4, DType>(s);
         // grid_dst : (2, H, W)
         Tensor<xpu, 3, DType> grid_dst = out_data[grid::kGridDst].get<xpu, 3, DType>(s);
-        Tensor<xpu, 2, DType> workspace = ctx.requested[grid::kTempSpace]
-          .get_space_typed<xpu, 2, DType>(Shape2(2, 1), s);
-        grid_dst[0] = repmat(range<DType>(0, data.size(3)), data.size(2));
-        grid_dst[1] = reshape(range<DType>(0, data.size(2), 1, data.size(3)),
-                              Shape2(data.size(2), data.size(3)));
-        workspace[0] = scalar<DType>((DType(data.size(3)) - 1.0) / 2.0);
-        workspace[1] = scalar<DType>((DType(data.size(2)) - 1.0) / 2.0);
-        Assign(out, req[grid::kOut],
-               (data + broadcast_with_axis(grid_dst, -1, data.shape_[0])) /
-                 broadcast_to(reshape(workspace, Shape4(1, 2, 1, 1)),
-                              TShape(data.shape_)) - scalar<DType>(1));
+        MXNET_ASSIGN_REQ_SWITCH(req[grid::kOut], Req, {
+          mxnet_op::Kernel<WarpGridSrc<Req>, xpu>::Launch(s, out.shape_.Size(), out.dptr_,
+            grid_dst.dptr_, data.dptr_, data.size(2), data.size(3));
+        });
         break;
       }
     }
@@ -162,13 +192,10 @@ class GridGeneratorOp : public Operator {
       case grid::kWarp: {
         Tensor<xpu, 4, DType> grad = out_grad[grid::kOut].get<xpu, 4, DType>(s);
         Tensor<xpu, 4, DType> gdata = in_grad[grid::kData].get<xpu, 4, DType>(s);
-        Tensor<xpu, 2, DType> workspace = ctx.requested[grid::kTempSpace]
-          .get_space_typed<xpu, 2, DType>(Shape2(2, 1), s);
-        workspace[0] = scalar<DType>((DType(gdata.size(3)) - 1.0) / 2.0);
-        workspace[1] = scalar<DType>((DType(gdata.size(2)) - 1.0) / 2.0);
-        Assign(gdata, req[grid::kData],
-               grad / broadcast_to(reshape(workspace, Shape4(1, 2, 1, 1)),
-                                   TShape(gdata.shape_)));
+        MXNET_ASSIGN_REQ_SWITCH(req[grid::kData], Req, {
+          mxnet_op::Kernel<WarpGridSrcBackward<Req>, xpu>::Launch(s, gdata.shape_.Size(),
+            gdata.dptr_, grad.dptr_, gdata.size(2), gdata.size(3));
+        });
         break;
       }
     }
@@ -298,32 +325,6 @@ class GridGeneratorProp : public OperatorProperty {
     return {};
   }
 
-  std::vector<ResourceRequest> ForwardResource(
-    const std::vector<TShape> &in_shape) const override {
-    switch (param_.transform_type) {
-    case grid::kAffine: {
-      return{};
-    }
-    case grid::kWarp: {
-      return{ ResourceRequest::kTempSpace };
-    }
-    }
-    return{};
-  }
-
-  std::vector<ResourceRequest> BackwardResource(
-      const std::vector<TShape> &in_shape) const override {
-    switch (param_.transform_type) {
-      case grid::kAffine: {
-        return {};
-      }
-      case grid::kWarp: {
-        return {ResourceRequest::kTempSpace};
-      }
-    }
-    return {};
-  }
-
   Operator* CreateOperator(Context ctx) const override {
     LOG(FATAL) << "Not Implemented.";
     return NULL;
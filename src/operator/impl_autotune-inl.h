@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file impl_autotune-inl.h
+ * \brief Registry of the fastest implementation of an operator for its
+ *  parameters, shapes, type and context.
+ */
+#ifndef MXNET_OPERATOR_IMPL_AUTOTUNE_INL_H_
+#define MXNET_OPERATOR_IMPL_AUTOTUNE_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/resource.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief Chooses among the implementations available for an operator, e.g.
+ *  im2col, MKL, NNPACK or Winograd for a CPU convolution. When
+ *  MXNET_OP_AUTOTUNE is set, the forward pass of every implementation is
+ *  timed the first time a key is seen and the fastest is kept for the key.
+ *  The winners are appended to the file named by MXNET_OP_AUTOTUNE_CACHE,
+ *  and read from it by later processes.
+ */
+class ImplAutotuneReg {
+ public:
+  /*! \brief an implementation of the operator */
+  struct Candidate {
+    /*! \brief name of the implementation, stored in the cache file */
+    std::string name;
+    /*! \brief create the operator */
+    std::function<Operator*()> create;
+  };
+
+  static ImplAutotuneReg *Get();
+
+  /*!
+   * \brief create the operator with the fastest implementation
+   * \param op_name name of the operator
+   * \param params parameters of the operator
+   * \param candidates the implementations supporting the parameters and
+   *  shapes, in the order preferred without tuning
+   * \param in_shape shapes of the inputs
+   * \param out_shape shapes of the outputs
+   * \param dtype type of the inputs and outputs
+   * \param ctx context of the operator
+   * \param requests resources requested by the forward pass
+   * \return the created operator, from the first candidate without tuning
+   */
+  Operator* Create(const std::string& op_name,
+                   const std::map<std::string, std::string>& params,
+                   const std::vector<Candidate>& candidates,
+                   const std::vector<TShape>& in_shape,
+                   const std::vector<TShape>& out_shape,
+                   int dtype, Context ctx,
+                   const std::vector<ResourceRequest>& requests);
+
+ private:
+  /*! \brief the key of an operator in the registry and the cache file */
+  std::string Key(const std::string& op_name,
+                  const std::map<std::string, std::string>& params,
+                  const std::vector<TShape>& in_shape,
+                  int dtype, Context ctx) const;
+  /*! \brief the best time among a few forward passes of every candidate, in seconds */
+  std::vector<double> Time(const std::vector<Candidate>& candidates,
+                           const std::vector<TShape>& in_shape,
+                           const std::vector<TShape>& out_shape,
+                           int dtype, Context ctx,
+                           const std::vector<ResourceRequest>& requests) const;
+  /*! \brief read the cache file once, lock_ must be held */
+  void LoadCacheFile();
+  /*! \brief append a record to the cache file, lock_ must be held */
+  void AppendCacheFile(const std::string& key, const std::string& name);
+
+  std::mutex lock_;
+  // name of the fastest implementation by key, tuned or read from the cache file
+  std::unordered_map<std::string, std::string> winners_;
+  std::string cache_file_;
+  bool cache_loaded_ = false;
+};
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_IMPL_AUTOTUNE_INL_H_
@@ -0,0 +1,179 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file impl_autotune.cc
+ * \brief Registry of the fastest implementation of an operator.
+ */
+#include <mxnet/engine.h>
+#include <mxnet/ndarray.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include "./impl_autotune-inl.h"
+#include "../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+ImplAutotuneReg *ImplAutotuneReg::Get() {
+  static ImplAutotuneReg inst;
+  return &inst;
+}
+
+Operator* ImplAutotuneReg::Create(const std::string& op_name,
+                                  const std::map<std::string, std::string>& params,
+                                  const std::vector<Candidate>& candidates,
+                                  const std::vector<TShape>& in_shape,
+                                  const std::vector<TShape>& out_shape,
+                                  int dtype, Context ctx,
+                                  const std::vector<ResourceRequest>& requests) {
+  CHECK(!candidates.empty()) << "No implementation of " << op_name;
+  static bool enabled = dmlc::GetEnv("MXNET_OP_AUTOTUNE", false);
+  if (!enabled || candidates.size() == 1U) return candidates[0].create();
+  const std::string key = Key(op_name, params, in_shape, dtype, ctx);
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    LoadCacheFile();
+    auto it = winners_.find(key);
+    if (it != winners_.end()) {
+      for (const auto& c : candidates) {
+        if (c.name == it->second) return c.create();
+      }
+    }
+  }
+  // not tuned yet, or the winner is not available in this build
+  const std::vector<double> times = Time(candidates, in_shape, out_shape, dtype, ctx, requests);
+  const size_t best = std::min_element(times.begin(), times.end()) - times.begin();
+  std::ostringstream os;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    os << ' ' << candidates[i].name << '=' << times[i] * 1000 << "ms";
+  }
+  LOG(INFO) << "Autotuned " << op_name << " for input " << in_shape[0] << ':' << os.str()
+            << ", using " << candidates[best].name;
+  std::lock_guard<std::mutex> guard(lock_);
+  winners_[key] = candidates[best].name;
+  AppendCacheFile(key, candidates[best].name);
+  return candidates[best].create();
+}
+
+std::string ImplAutotuneReg::Key(const std::string& op_name,
+                                 const std::map<std::string, std::string>& params,
+                                 const std::vector<TShape>& in_shape,
+                                 int dtype, Context ctx) const {
+  // the speed of the CPU implementations depends on the number of threads
+  std::ostringstream os;
+  os << op_name << ';' << ctx.dev_mask() << ';'
+     << engine::OpenMP::Get()->GetRecommendedOMPThreadCount() << ';';
+  for (const auto& kv : params) os << kv.first << '=' << kv.second << ',';
+  os << ';';
+  for (const auto& s : in_shape) os << s;
+  os << ';' << dtype;
+  std::string ret = os.str();
+  std::replace(ret.begin(), ret.end(), '\t', ' ');
+  std::replace(ret.begin(), ret.end(), '\n', ' ');
+  return ret;
+}
+
+std::vector<double> ImplAutotuneReg::Time(const std::vector<Candidate>& candidates,
+                                          const std::vector<TShape>& in_shape,
+                                          const std::vector<TShape>& out_shape,
+                                          int dtype, Context ctx,
+                                          const std::vector<ResourceRequest>& requests) const {
+  const int kRuns = 3;
+  std::vector<NDArray> inputs, outputs;
+  std::vector<Engine::VarHandle> const_vars, mutate_vars;
+  for (const auto& s : in_shape) {
+    inputs.emplace_back(s, ctx, false, dtype);
+    inputs.back() = 1.0f;
+    const_vars.push_back(inputs.back().var());
+  }
+  for (const auto& s : out_shape) {
+    outputs.emplace_back(s, ctx, false, dtype);
+    mutate_vars.push_back(outputs.back().var());
+  }
+  std::vector<Resource> requested;
+  for (const auto& req : requests) {
+    requested.push_back(ResourceManager::Get()->Request(ctx, req));
+    mutate_vars.push_back(requested.back().var);
+  }
+  std::vector<double> times(candidates.size());
+  Engine::Get()->PushSync([&](RunContext rctx) {
+      OpContext op_ctx;
+      op_ctx.is_train = false;
+      op_ctx.run_ctx = rctx;
+      op_ctx.requested = requested;
+      std::vector<TBlob> in_data, out_data, aux_data;
+      for (auto& nd : inputs) in_data.push_back(nd.data());
+      for (auto& nd : outputs) out_data.push_back(nd.data());
+      std::vector<OpReqType> req(out_data.size(), kWriteTo);
+      auto wait = [&rctx]() {
+        if (rctx.ctx.dev_mask() == gpu::kDevMask) {
+#if MXNET_USE_CUDA
+          rctx.get_stream<gpu>()->Wait();
+#endif
+        }
+      };
+      for (size_t i = 0; i < candidates.size(); ++i) {
+        std::unique_ptr<Operator> op(candidates[i].create());
+        // the first run sets the operator up
+        op->Forward(op_ctx, in_data, req, out_data, aux_data);
+        wait();
+        times[i] = std::numeric_limits<double>::max();
+        for (int r = 0; r < kRuns; ++r) {
+          auto start = std::chrono::steady_clock::now();
+          op->Forward(op_ctx, in_data, req, out_data, aux_data);
+          wait();
+          std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+          times[i] = std::min(times[i], elapsed.count());
+        }
+      }
+    }, ctx, const_vars, mutate_vars, FnProperty::kNormal, 0, PROFILER_MESSAGE("AutotuneOp"));
+  Engine::Get()->WaitForVar(outputs[0].var());
+  return times;
+}
+
+void ImplAutotuneReg::LoadCacheFile() {
+  if (cache_loaded_) return;
+  cache_loaded_ = true;
+  cache_file_ = dmlc::GetEnv("MXNET_OP_AUTOTUNE_CACHE", std::string());
+  if (cache_file_.empty()) return;
+  // every line is a key and the name of the fastest implementation, separated by a tab
+  std::ifstream is(cache_file_);
+  std::string line;
+  while (std::getline(is, line)) {
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) continue;
+    winners_[line.substr(0, tab)] = line.substr(tab + 1);
+  }
+}
+
+void ImplAutotuneReg::AppendCacheFile(const std::string& key, const std::string& name) {
+  if (cache_file_.empty()) return;
+  // a single write per line, so that processes sharing the file do not mix lines
+  std::ofstream fo(cache_file_, std::ios::app);
+  fo << (key + '\t' + name + '\n') << std::flush;
+}
+
+}  // namespace op
+}  // namespace mxnet
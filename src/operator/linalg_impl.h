@@ -30,6 +30,7 @@
 #include <algorithm>
 
 #include "../common/cuda_utils.h"
+#include "../engine/openmp.h"
 
 // Convenience functions.
 inline void linalg_check_batch_size(int A, int B, int C) {
@@ -38,6 +39,29 @@ inline void linalg_check_batch_size(int A, int B, int C) {
   CHECK_GT(A, 0) << "Zero batch size for arguments to linear algebra operator";
 }
 
+// Calls f(i) for the matrices i of a batch on cpu and returns the number of calls
+// returning non-zero. The matrices are processed in parallel, each by a single
+// threaded BLAS/LAPACK call, unless they are large enough for the library to
+// parallelize a single call efficiently.
+template<typename F>
+inline int linalg_batch_for(int batch_size, int matrix_size, F f) {
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  int failed(0);
+  if (omp_threads < 2 || batch_size < 2 || matrix_size > 256 * 256) {
+    for (int i = 0; i < batch_size; ++i) {
+      failed += (f(i) != 0);
+    }
+  } else {
+#ifndef __CUDACC__
+    #pragma omp parallel for num_threads(omp_threads) reduction(+:failed)
+#endif
+    for (int i = 0; i < batch_size; ++i) {
+      failed += (f(i) != 0);
+    }
+  }
+  return failed;
+}
+
 //////////////////////////////// GEMM ////////////////////////////////////////////
 
 // CPU/GPU-versions of BLAS3 function "gemm". Please refer to the BLAS3-documentation
@@ -56,7 +80,7 @@ inline void check_gemm(const Tensor<xpu, 2, DType>& A, const Tensor<xpu, 2, DTyp
     << "Non compatible matrix dimensions between inputs A and B for gemm";
 }
 
-#if MSHADOW_USE_CBLAS == 1
+#if (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 #define LINALG_CPU_GEMM(fname, DType) \
 template<> inline \
@@ -75,9 +99,11 @@ void linalg_batch_gemm<cpu, DType>(const Tensor<cpu, 3, DType>& A, const Tensor<
                                    const Tensor<cpu, 3, DType>& C, DType alpha, DType beta, \
                                    bool tA, bool tB, Stream<cpu> *s) { \
   linalg_check_batch_size(A.size(0), B.size(0), C.size(0)); \
-  for (index_t i = 0; i < A.size(0); ++i) { \
+  check_gemm(A[0], B[0], C[0], alpha, beta, tA, tB); \
+  linalg_batch_for(A.size(0), C[0].MSize(), [&](int i) { \
     linalg_gemm(A[i], B[i], C[i], alpha, beta, tA, tB); \
-  } \
+    return 0; \
+  }); \
 }
 
 #else
@@ -98,7 +124,7 @@ void linalg_batch_gemm<cpu, DType>(const Tensor<cpu, 3, DType>& A, const Tensor<
   LOG(FATAL) << "linalg_batch_gemm not implemented by mxnet for cpu, needs cblas!"; \
 }
 
-#endif  // MSHADOW_USE_CBLAS == 1
+#endif  // (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 LINALG_CPU_GEMM(sgemm, float)
 LINALG_CPU_GEMM(dgemm, double)
@@ -117,6 +143,17 @@ void linalg_gemm<cpu, mshadow::half::half_t>(const Tensor<cpu, 2, mshadow::half:
   LOG(FATAL) << "FP16 gemm on cpu not implemented!";
 }
 
+// Specialization of linalg_batch_gemm<cpu, DType> for DType=mshadow::half::half_t.
+template<> inline
+void linalg_batch_gemm<cpu, mshadow::half::half_t>(
+    const Tensor<cpu, 3, mshadow::half::half_t>& A,
+    const Tensor<cpu, 3, mshadow::half::half_t>& B,
+    const Tensor<cpu, 3, mshadow::half::half_t>& C,
+    mshadow::half::half_t alpha, mshadow::half::half_t beta,
+    bool tA, bool tB, Stream<cpu> *s) {
+  LOG(FATAL) << "FP16 batch gemm on cpu not implemented!";
+}
+
 #ifdef __CUDACC__
 
 template<typename DType>
@@ -196,6 +233,36 @@ void linalg_gemm<gpu, mshadow::half::half_t>(const Tensor<gpu, 2, mshadow::half:
 }
 
 
+#if CUDA_VERSION >= 8000
+
+// The matrices of a batch are equally spaced, which saves building the arrays
+// of pointers to the matrices of the non-strided interface on every call.
+#define LINALG_GPU_BATCH_GEMM(fname, DType) \
+template<> inline \
+void linalg_batch_gemm<gpu, DType>(const Tensor<gpu, 3, DType>& A, const Tensor<gpu, 3, DType>& B, \
+                                   const Tensor<gpu, 3, DType>& C, DType alpha, DType beta, \
+                                   bool tA, bool tB, Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using mshadow::gpu; \
+  CHECK_NOTNULL(s); \
+  linalg_check_batch_size(A.size(0), B.size(0), C.size(0)); \
+  check_gemm(A[0], B[0], C[0], alpha, beta, tA, tB); \
+  CUBLAS_CALL(cublas##fname(Stream<gpu>::GetBlasHandle(s), \
+                            (tB ? CUBLAS_OP_T : CUBLAS_OP_N), \
+                            (tA ? CUBLAS_OP_T : CUBLAS_OP_N), \
+                            C.size(2), C.size(1), (tB ? B.size(2) : B.size(1)), \
+                            &alpha, B.dptr_, B.stride_, \
+                            static_cast<int64_t>(B.size(1)) * B.stride_, \
+                            A.dptr_, A.stride_, \
+                            static_cast<int64_t>(A.size(1)) * A.stride_, \
+                            &beta, C.dptr_, C.stride_, \
+                            static_cast<int64_t>(C.size(1)) * C.stride_, A.size(0))) \
+}
+LINALG_GPU_BATCH_GEMM(SgemmStridedBatched, float)
+LINALG_GPU_BATCH_GEMM(DgemmStridedBatched, double)
+
+#else
+
 #define LINALG_GPU_BATCH_GEMM(fname, DType) \
 template<> inline \
 void linalg_batch_gemm<gpu, DType>(const Tensor<gpu, 3, DType>& A, const Tensor<gpu, 3, DType>& B, \
@@ -233,6 +300,53 @@ void linalg_batch_gemm<gpu, DType>(const Tensor<gpu, 3, DType>& A, const Tensor<
 LINALG_GPU_BATCH_GEMM(SgemmBatched, float)
 LINALG_GPU_BATCH_GEMM(DgemmBatched, double)
 
+#endif  // CUDA_VERSION >= 8000
+
+// Specialization of linalg_batch_gemm<gpu, DType> for DType=mshadow::half::half_t.
+// The products are accumulated in fp32 and run on TensorCores if permitted by the
+// global policy.
+template<> inline
+void linalg_batch_gemm<gpu, mshadow::half::half_t>(
+    const Tensor<gpu, 3, mshadow::half::half_t>& A,
+    const Tensor<gpu, 3, mshadow::half::half_t>& B,
+    const Tensor<gpu, 3, mshadow::half::half_t>& C,
+    mshadow::half::half_t alpha, mshadow::half::half_t beta,
+    bool tA, bool tB, Stream<gpu> *s) {
+  using namespace mxnet;
+  using mshadow::gpu;
+  CHECK_NOTNULL(s);
+  linalg_check_batch_size(A.size(0), B.size(0), C.size(0));
+  check_gemm(A[0], B[0], C[0], alpha, beta, tA, tB);
+#if CUDA_VERSION >= 9000
+  auto blas_handle = Stream<gpu>::GetBlasHandle(s);
+  auto cublas_math_mode = GetEnvAllowTensorCore() ? CUBLAS_TENSOR_OP_MATH
+                                                  : CUBLAS_DEFAULT_MATH;
+  auto previous_math_mode = SetCublasMathMode(blas_handle, cublas_math_mode);
+  float alpha_f = float(alpha);  // NOLINT(*)
+  float beta_f = float(beta);  // NOLINT(*)
+  CUBLAS_CALL(cublasGemmStridedBatchedEx(blas_handle,
+                                         (tB ? CUBLAS_OP_T : CUBLAS_OP_N),
+                                         (tA ? CUBLAS_OP_T : CUBLAS_OP_N),
+                                         C.size(2), C.size(1), (tB ? B.size(2) : B.size(1)),
+                                         &alpha_f,
+                                         B.dptr_, CUDA_R_16F, B.stride_,
+                                         static_cast<int64_t>(B.size(1)) * B.stride_,
+                                         A.dptr_, CUDA_R_16F, A.stride_,
+                                         static_cast<int64_t>(A.size(1)) * A.stride_,
+                                         &beta_f,
+                                         C.dptr_, CUDA_R_16F, C.stride_,
+                                         static_cast<int64_t>(C.size(1)) * C.stride_,
+                                         A.size(0), CUDA_R_32F,
+                                         GetEnvAllowTensorCore() ? CUBLAS_GEMM_DEFAULT_TENSOR_OP
+                                                                 : CUBLAS_GEMM_DEFAULT));
+  SetCublasMathMode(blas_handle, previous_math_mode);
+#else
+  for (index_t i = 0; i < A.size(0); ++i) {
+    linalg_gemm(A[i], B[i], C[i], alpha, beta, tA, tB, s);
+  }
+#endif  // CUDA_VERSION >= 9000
+}
+
 #endif  // __CUDACC__
 
 //////////////////////////////// TRSM ////////////////////////////////////////////
@@ -253,7 +367,7 @@ inline void check_trsm(const Tensor<xpu, 2, DType>& A, const Tensor<xpu, 2, DTyp
     << "Non compatible matrix dimensions between inputs A and B for trsm";
 }
 
-#if MSHADOW_USE_CBLAS == 1
+#if (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 #define LINALG_CPU_TRSM(fname, DType) \
 template<> inline \
@@ -271,9 +385,11 @@ template<> inline \
 void linalg_batch_trsm<cpu, DType>(const Tensor<cpu, 3, DType>& A, const Tensor<cpu, 3, DType>& B, \
                    DType alpha, bool rightside, bool lower, bool transpose, Stream<cpu> *s) { \
   linalg_check_batch_size(A.size(0), B.size(0), B.size(0)); \
-  for (index_t i = 0; i < A.size(0); ++i) { \
+  check_trsm(A[0], B[0], alpha, rightside, lower, transpose); \
+  linalg_batch_for(A.size(0), B[0].MSize(), [&](int i) { \
     linalg_trsm(A[i], B[i], alpha, rightside, lower, transpose); \
-  } \
+    return 0; \
+  }); \
 }
 
 #else
@@ -292,7 +408,7 @@ void linalg_batch_trsm<cpu, DType>(const Tensor<cpu, 3, DType>& A, const Tensor<
   LOG(FATAL) << "linalg_batch_trsm not implemented, needs cblas!"; \
 }
 
-#endif  // MSHADOW_USE_CBLAS == 1
+#endif  // (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 LINALG_CPU_TRSM(strsm, float)
 LINALG_CPU_TRSM(dtrsm, double)
@@ -389,7 +505,7 @@ inline void linalg_gemm(const Tensor<xpu, 2, DType>& A,
   }
 }
 
-#if MSHADOW_USE_CBLAS == 0
+#if (MSHADOW_USE_CBLAS == 0 && MSHADOW_USE_MKL == 0)
 
 // A template for a cpu linalg_gemm implementation using mshadow::dot()
 #define LINALG_CPU_GEMM_NO_CBLAS(DType) \
@@ -442,7 +558,7 @@ void linalg_gemm<cpu, DType>(const Tensor<cpu, 2, DType>& A, \
 LINALG_CPU_GEMM_NO_CBLAS(float)
 LINALG_CPU_GEMM_NO_CBLAS(double)
 
-#endif  // (MSHADOW_USE_CBLAS == 0)
+#endif  // (MSHADOW_USE_CBLAS == 0 && MSHADOW_USE_MKL == 0)
 
 //////////////////////////////// TRMM ////////////////////////////////////////////
 
@@ -462,7 +578,7 @@ inline void check_trmm(const Tensor<xpu, 2, DType>& A, const Tensor<xpu, 2, DTyp
     << "Non compatible matrix dimensions between inputs A and B for trmm";
 }
 
-#if MSHADOW_USE_CBLAS == 1
+#if (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 #define LINALG_CPU_TRMM(fname, DType) \
 template<> inline \
@@ -484,7 +600,7 @@ void linalg_trmm<cpu, DType>(const Tensor<cpu, 2, DType>& A, const Tensor<cpu, 2
   LOG(FATAL) << "linalg_trmm not implemented, needs cblas!"; \
 }
 
-#endif  // MSHADOW_USE_CBLAS == 1
+#endif  // (MSHADOW_USE_CBLAS == 1 || MSHADOW_USE_MKL == 1)
 
 #define LINALG_XPU_BATCH_TRMM(xpu, DType) \
 template<> inline \
@@ -496,11 +612,23 @@ void linalg_batch_trmm<xpu, DType>(const Tensor<xpu, 3, DType>& A, const Tensor<
   } \
 }
 
+#define LINALG_CPU_BATCH_TRMM(DType) \
+template<> inline \
+void linalg_batch_trmm<cpu, DType>(const Tensor<cpu, 3, DType>& A, const Tensor<cpu, 3, DType>& B, \
+                    DType alpha, bool rightside, bool lower, bool transpose, Stream<cpu> *s) { \
+  linalg_check_batch_size(A.size(0), B.size(0), B.size(0)); \
+  check_trmm(A[0], B[0], alpha, rightside, lower, transpose); \
+  linalg_batch_for(A.size(0), B[0].MSize(), [&](int i) { \
+    linalg_trmm(A[i], B[i], alpha, rightside, lower, transpose, s); \
+    return 0; \
+  }); \
+}
+
 LINALG_CPU_TRMM(strmm, float)
 LINALG_CPU_TRMM(dtrmm, double)
 
-LINALG_XPU_BATCH_TRMM(cpu, float)
-LINALG_XPU_BATCH_TRMM(cpu, double)
+LINALG_CPU_BATCH_TRMM(float)
+LINALG_CPU_BATCH_TRMM(double)
 
 #ifdef __CUDACC__
 
@@ -554,15 +682,19 @@ void linalg_potrf<cpu, DType>(const Tensor<cpu, 2, DType>& A, bool lower, Stream
 LINALG_CPU_POTRF(spotrf, float)
 LINALG_CPU_POTRF(dpotrf, double)
 
-#define LINALG_CPU_BATCH_POTRF(DType) \
+#define LINALG_CPU_BATCH_POTRF(fname, DType) \
 template<> inline \
 void linalg_batch_potrf<cpu, DType>(const Tensor<cpu, 3, DType>& A, bool lower, Stream<cpu> *s) { \
-  for (index_t i = 0; i < A.size(0); ++i) { \
-    linalg_potrf(A[i], lower); \
-  } \
+  CHECK_GT(A.size(0), 0); \
+  check_potrf(A[0], lower); \
+  int failed(linalg_batch_for(A.size(0), A[0].MSize(), [&](int i) { \
+    return MXNET_LAPACK_##fname(MXNET_LAPACK_ROW_MAJOR, (lower ? 'L' : 'U'), A[i].size(0), \
+                                A[i].dptr_, A[i].stride_); \
+  })); \
+  CHECK_EQ(failed, 0) << #fname << " failed in lapack on cpu."; \
 }
-LINALG_CPU_BATCH_POTRF(float)
-LINALG_CPU_BATCH_POTRF(double)
+LINALG_CPU_BATCH_POTRF(spotrf, float)
+LINALG_CPU_BATCH_POTRF(dpotrf, double)
 
 #if defined(__CUDACC__) && MXNET_USE_CUSOLVER == 1
 
@@ -600,6 +732,36 @@ void linalg_potrf<gpu, DType>(const Tensor<gpu, 2, DType>& A, bool lower, Stream
 LINALG_GPU_POTRF(DnSpotrf, float)
 LINALG_GPU_POTRF(DnDpotrf, double)
 
+#if CUDA_VERSION >= 9010
+
+// Factorizes all the matrices of the batch in one call of the batched cusolver kernel.
+#define LINALG_GPU_BATCH_POTRF(fname, DType) \
+template<> inline \
+void linalg_batch_potrf<gpu, DType>(const Tensor<gpu, 3, DType>& A, bool lower, Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using mshadow::gpu; \
+  CHECK_NOTNULL(s); \
+  CHECK_GT(A.size(0), 0); \
+  check_potrf(A[0], lower); \
+  Storage::Handle offsets = Storage::Get()->Alloc(sizeof(DType*)*A.size(0), Context::GPU()); \
+  Storage::Handle info = Storage::Get()->Alloc(sizeof(int)*A.size(0), Context::GPU()); \
+  using namespace mshadow::cuda; \
+  int ngrid = std::min(kMaxGridNum, \
+                       static_cast<int>((A.size(0) + kBaseThreadNum - 1) / kBaseThreadNum)); \
+  linalgCollectBatchOffsetsGPU<<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>> \
+    (static_cast<DType **>(offsets.dptr), A.dptr_, A.size(1)*A.stride_, A.size(0)); \
+  CUSOLVER_CALL(cusolver##fname(Stream<gpu>::GetSolverHandle(s), \
+                (lower ? CUBLAS_FILL_MODE_UPPER : CUBLAS_FILL_MODE_LOWER), \
+                A.size(1), static_cast<DType **>(offsets.dptr), A.stride_, \
+                static_cast<int *>(info.dptr), A.size(0))); \
+  Storage::Get()->Free(offsets); \
+  Storage::Get()->Free(info); \
+}
+LINALG_GPU_BATCH_POTRF(DnSpotrfBatched, float)
+LINALG_GPU_BATCH_POTRF(DnDpotrfBatched, double)
+
+#else
+
 #define LINALG_GPU_BATCH_POTRF(fname, DType) \
 template<> inline \
 void linalg_batch_potrf<gpu, DType>(const Tensor<gpu, 3, DType>& A, bool lower, Stream<gpu> *s) { \
@@ -623,6 +785,8 @@ void linalg_batch_potrf<gpu, DType>(const Tensor<gpu, 3, DType>& A, bool lower,
 LINALG_GPU_BATCH_POTRF(DnSpotrf, float)
 LINALG_GPU_BATCH_POTRF(DnDpotrf, double)
 
+#endif  // CUDA_VERSION >= 9010
+
 #endif
 
 //////////////////////////////// POTRI ////////////////////////////////////////////
@@ -648,15 +812,19 @@ void linalg_potri<cpu, DType>(const Tensor<cpu, 2, DType>& A, bool lower, Stream
 LINALG_CPU_POTRI(spotri, float)
 LINALG_CPU_POTRI(dpotri, double)
 
-#define LINALG_CPU_BATCH_POTRI(DType) \
+#define LINALG_CPU_BATCH_POTRI(fname, DType) \
 template<> inline \
 void linalg_batch_potri<cpu, DType>(const Tensor<cpu, 3, DType>& A, bool lower, Stream<cpu> *s) { \
-  for (index_t i = 0; i < A.size(0); ++i) { \
-    linalg_potri(A[i], lower); \
-  } \
-}
-LINALG_CPU_BATCH_POTRI(float)
-LINALG_CPU_BATCH_POTRI(double)
+  CHECK_GT(A.size(0), 0); \
+  check_potri(A[0], lower); \
+  int failed(linalg_batch_for(A.size(0), A[0].MSize(), [&](int i) { \
+    return MXNET_LAPACK_##fname(MXNET_LAPACK_ROW_MAJOR, (lower ? 'L' : 'U'), A[i].size(0), \
+                                A[i].dptr_, A[i].stride_); \
+  })); \
+  CHECK_EQ(failed, 0) << #fname << " failed in lapack on cpu."; \
+}
+LINALG_CPU_BATCH_POTRI(spotri, float)
+LINALG_CPU_BATCH_POTRI(dpotri, double)
 
 #ifdef __CUDACC__
 
@@ -25,9 +25,12 @@
 #define MXNET_OPERATOR_LOSS_BINARY_OP_INL_H_
 
 #include <mxnet/operator_util.h>
+#include <algorithm>
 #include <vector>
 #include "./mshadow_op.h"
+#include "./mxnet_op.h"
 #include "./elemwise_op_common.h"
+#include "../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
@@ -46,37 +49,151 @@ inline bool SoftmaxCrossEntropyShape(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+namespace softmax_ce {
+/*! \brief length of the chunks of the rows of the logits reduced at once */
+const int kChunk = 4096;
+}  // namespace softmax_ce
+
+MSHADOW_XINLINE float SoftmaxCEExp(float a) { return expf(a); }
+MSHADOW_XINLINE double SoftmaxCEExp(double a) { return ::exp(a); }
+MSHADOW_XINLINE float SoftmaxCELog(float a) { return logf(a); }
+MSHADOW_XINLINE double SoftmaxCELog(double a) { return ::log(a); }
+
+/*!
+ * \brief the log of the sum of the exponentials of every row, from the
+ *  maximum and the sum of the exponentials relative to it of every chunk
+ */
+struct softmax_ce_merge_chunks {
+  template<typename AccReal>
+  MSHADOW_XINLINE static void Map(int r, AccReal *lse, const AccReal *stats, int nchunk) {
+    const AccReal *row = stats + static_cast<size_t>(r) * nchunk * 2;
+    AccReal m = row[0], sum = row[1];
+    for (int c = 1; c < nchunk; ++c) {
+      const AccReal mc = row[2 * c], sc = row[2 * c + 1];
+      if (mc > m) {
+        sum = sum * SoftmaxCEExp(m - mc) + sc;
+        m = mc;
+      } else {
+        sum += sc * SoftmaxCEExp(mc - m);
+      }
+    }
+    lse[r] = m + SoftmaxCELog(sum);
+  }
+};
+
+/*! \brief sum over the rows of the loss log(sum(exp(x))) - x[label] */
+struct softmax_ce_loss {
+  template<typename DType, typename AccReal>
+  MSHADOW_XINLINE static void Map(int i, DType *out, const DType *data, const DType *label,
+                                  const AccReal *lse, int N, int V, OpReqType req) {
+    AccReal loss = 0;
+    for (int r = 0; r < N; ++r) {
+      const int k = static_cast<int>(label[r]);
+      loss += lse[r] - static_cast<AccReal>(data[static_cast<size_t>(r) * V + k]);
+    }
+    KERNEL_ASSIGN(out[0], req, DType(loss));
+  }
+};
+
+/*!
+ * \brief the maximum and the sum of the exponentials relative to it of every
+ *  chunk of the rows of the (N, V) logits, stats[2 * (r * nchunk + c)] and
+ *  the next element for chunk c of row r
+ */
+template<typename DType, typename AccReal>
+inline void SoftmaxCEChunkStats(mshadow::Stream<cpu> *s, const DType *data,
+                                int N, int V, int nchunk, AccReal *stats) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < N * nchunk; ++i) {
+    const DType *x = data + static_cast<size_t>(i / nchunk) * V;
+    const int begin = (i % nchunk) * softmax_ce::kChunk;
+    const int end = std::min(V, begin + softmax_ce::kChunk);
+    AccReal m = static_cast<AccReal>(x[begin]);
+    for (int j = begin + 1; j < end; ++j) {
+      m = std::max(m, static_cast<AccReal>(x[j]));
+    }
+    AccReal sum = 0;
+    for (int j = begin; j < end; ++j) {
+      sum += SoftmaxCEExp(static_cast<AccReal>(x[j]) - m);
+    }
+    stats[2 * i] = m;
+    stats[2 * i + 1] = sum;
+  }
+}
+
+/*! \brief igrad = scale * (softmax(data) - one_hot(label)) by chunks of the rows */
+template<typename DType, typename AccReal>
+inline void SoftmaxCEGrad(mshadow::Stream<cpu> *s, const DType *data, const DType *label,
+                          const AccReal *lse, const DType *scale, int N, int V, int nchunk,
+                          OpReqType req, DType *igrad) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const AccReal a = static_cast<AccReal>(scale[0]);
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < N * nchunk; ++i) {
+    const int r = i / nchunk;
+    const size_t offset = static_cast<size_t>(r) * V;
+    const int begin = (i % nchunk) * softmax_ce::kChunk;
+    const int end = std::min(V, begin + softmax_ce::kChunk);
+    const AccReal l = lse[r];
+    for (int j = begin; j < end; ++j) {
+      const AccReal g = a * SoftmaxCEExp(static_cast<AccReal>(data[offset + j]) - l);
+      KERNEL_ASSIGN(igrad[offset + j], req, DType(g));
+    }
+    const int k = static_cast<int>(label[r]);
+    if (req != kNullOp && k >= begin && k < end) {
+      igrad[offset + k] = DType(static_cast<AccReal>(igrad[offset + k]) - a);
+    }
+  }
+}
+
+template<typename DType, typename AccReal>
+void SoftmaxCEChunkStats(mshadow::Stream<gpu> *s, const DType *data,
+                         int N, int V, int nchunk, AccReal *stats);
+
+template<typename DType, typename AccReal>
+void SoftmaxCEGrad(mshadow::Stream<gpu> *s, const DType *data, const DType *label,
+                   const AccReal *lse, const DType *scale, int N, int V, int nchunk,
+                   OpReqType req, DType *igrad);
+
+/*!
+ * \brief the log of the sum of the exponentials of the rows of data, merged
+ *  from the statistics of the chunks of the rows, so that neither the
+ *  softmax nor any other (N, V) temporary is stored
+ */
+template<typename xpu, typename DType, typename AccReal>
+inline mshadow::Tensor<xpu, 1, AccReal> SoftmaxCELogSumExp(const OpContext& ctx,
+                                                          const TBlob& data) {
+  using namespace mxnet_op;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const int N = data.shape_[0], V = data.shape_[1];
+  const int nchunk = (V + softmax_ce::kChunk - 1) / softmax_ce::kChunk;
+  mshadow::Tensor<xpu, 1, AccReal> workspace = ctx.requested[0].get_space_typed<xpu, 1, AccReal>(
+      mshadow::Shape1(N + N * nchunk * 2), s);
+  AccReal *lse = workspace.dptr_, *stats = workspace.dptr_ + N;
+  SoftmaxCEChunkStats(s, data.dptr<DType>(), N, V, nchunk, stats);
+  Kernel<softmax_ce_merge_chunks, xpu>::Launch(s, N, lse, stats, nchunk);
+  return mshadow::Tensor<xpu, 1, AccReal>(lse, mshadow::Shape1(N), s);
+}
+
 template<typename xpu>
 void SoftmaxCrossEntropyForward(const nnvm::NodeAttrs& attrs,
                                 const OpContext& ctx,
                                 const std::vector<TBlob>& inputs,
                                 const std::vector<OpReqType>& req,
                                 const std::vector<TBlob>& outputs) {
-  using namespace mshadow::expr;
+  using namespace mxnet_op;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   CHECK_EQ(outputs[0].type_flag_, inputs[0].type_flag_)
     << "Binary function only support input/output with the same type";
   CHECK_EQ(outputs[0].type_flag_, inputs[1].type_flag_)
     << "Binary function only support input/output with the same type";
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Tensor<xpu, 1, DType> out = outputs[0].get<xpu, 1, DType>(s);
-    mshadow::Tensor<xpu, 1, DType> mlabel = inputs[1].get<xpu, 1, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> mdata = inputs[0].get<xpu, 2, DType>(s);
-    mshadow::Tensor<xpu, 1, DType> workspace = ctx.requested[0].get_space_typed<xpu, 1, DType>(
-        mshadow::Shape1(mdata.shape_.Size() + mlabel.size(0)), s);
-    mshadow::Tensor<xpu, 2, DType> temp1(workspace.dptr_, mdata.shape_, s);
-    mshadow::Tensor<xpu, 2, DType> temp2(workspace.dptr_ + mdata.shape_.Size(),
-        mshadow::Shape2(1, mlabel.size(0)), s);
-    // calculate softmax on temp
-    // TODO(tqchen): change to SoftmaxLog later
-    mshadow::Softmax(temp1, mdata);
-    // choose the softmax rows
-    mshadow::Tensor<xpu, 1, DType> tdst = temp2[0];
-    tdst = F<mshadow_op::negation>(
-        F<mshadow_op::log>(
-            F<mshadow_op::maximum>(mat_choose_row_element(temp1, mlabel),
-                                   scalar<DType>(1e-8f))));
-    ASSIGN_DISPATCH(out, req[0], sumall_except_dim<0>(temp2));
+  if (req[0] == kNullOp) return;
+  const int N = inputs[0].shape_[0], V = inputs[0].shape_[1];
+  MSHADOW_REAL_TYPE_SWITCH_EX(outputs[0].type_flag_, DType, AccReal, {
+    mshadow::Tensor<xpu, 1, AccReal> lse = SoftmaxCELogSumExp<xpu, DType, AccReal>(ctx, inputs[0]);
+    Kernel<softmax_ce_loss, xpu>::Launch(s, 1, outputs[0].dptr<DType>(), inputs[0].dptr<DType>(),
+                                         inputs[1].dptr<DType>(), lse.dptr_, N, V, req[0]);
   });
 }
 
@@ -86,20 +203,16 @@ void SoftmaxCrossEntropyBackward(const nnvm::NodeAttrs& attrs,
                                  const std::vector<TBlob>& inputs,
                                  const std::vector<OpReqType>& req,
                                  const std::vector<TBlob>& outputs) {
-  using namespace mshadow::expr;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   CHECK_EQ(req[1], kNullOp)
       << "SoftmaxCrossEntropy: Cannot take gradient wrt label";
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Tensor<xpu, 1, DType> mlabel = inputs[2].get<xpu, 1, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> mdata = inputs[1].get<xpu, 2, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> mdata_grad = outputs[0].get<xpu, 2, DType>(s);
-    mshadow::Tensor<xpu, 1, DType> mscale = inputs[0].get<xpu, 1, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> temp = ctx.requested[0].get_space_typed<xpu, 2, DType>(
-        mdata.shape_, s);
-    mshadow::Softmax(temp, mdata);
-    mshadow::SoftmaxGrad(temp, temp, mlabel);
-    ASSIGN_DISPATCH(mdata_grad, req[0], broadcast_scalar(mscale, temp.shape_) * temp);
+  if (req[0] == kNullOp) return;
+  const int N = inputs[1].shape_[0], V = inputs[1].shape_[1];
+  const int nchunk = (V + softmax_ce::kChunk - 1) / softmax_ce::kChunk;
+  MSHADOW_REAL_TYPE_SWITCH_EX(outputs[0].type_flag_, DType, AccReal, {
+    mshadow::Tensor<xpu, 1, AccReal> lse = SoftmaxCELogSumExp<xpu, DType, AccReal>(ctx, inputs[1]);
+    SoftmaxCEGrad(s, inputs[1].dptr<DType>(), inputs[2].dptr<DType>(), lse.dptr_,
+                  inputs[0].dptr<DType>(), N, V, nchunk, req[0], outputs[0].dptr<DType>());
   });
 }
 
@@ -55,6 +55,12 @@ Example::
 
   softmax_cross_entropy(data, label) = - log(0.66524084) - log(0.97962922) = 0.4281871
 
+The softmax is never stored: the log of the sum of the exponentials of every
+row is reduced by chunks of the row, and the backward computes the gradient
+from it in place of the data when the data is not used by other operators. The
+memory used besides the data and its gradient is a few values per chunk of
+4096 elements of a row, which suits large vocabularies.
+
 )code" ADD_FILELINE)
 .set_num_inputs(2)
 .set_num_outputs(1)
@@ -77,6 +83,10 @@ NNVM_REGISTER_OP(_backward_softmax_cross_entropy)
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
   })
 .set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<nnvm::FInplaceOption>("FInplaceOption",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::pair<int, int> >{{1, 0}};
+  })
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxCrossEntropyBackward<cpu>);
 
 }  // namespace op
@@ -26,6 +26,92 @@
 namespace mxnet {
 namespace op {
 
+namespace softmax_ce {
+const int kThreads = 256;
+}  // namespace softmax_ce
+
+/*! \brief block (c, r) reduces chunk c of row r, see SoftmaxCEChunkStats */
+template<typename DType, typename AccReal>
+__global__ void SoftmaxCEChunkStatsKernel(const DType *data, int V, AccReal *stats) {
+  using namespace softmax_ce;
+  __shared__ AccReal smax[kThreads];
+  __shared__ AccReal ssum[kThreads];
+  const int begin = blockIdx.x * kChunk;
+  const int end = min(V, begin + kChunk);
+  const DType *x = data + static_cast<size_t>(blockIdx.y) * V;
+  // running maximum and sum of the exponentials relative to it of a thread
+  AccReal m = static_cast<AccReal>(x[begin]), sum = 0;
+  for (int j = begin + threadIdx.x; j < end; j += kThreads) {
+    const AccReal v = static_cast<AccReal>(x[j]);
+    if (v > m) {
+      sum = sum * SoftmaxCEExp(m - v) + 1;
+      m = v;
+    } else {
+      sum += SoftmaxCEExp(v - m);
+    }
+  }
+  smax[threadIdx.x] = m;
+  ssum[threadIdx.x] = sum;
+  __syncthreads();
+  for (int offset = kThreads / 2; offset > 0; offset >>= 1) {
+    if (threadIdx.x < offset) {
+      const AccReal mb = smax[threadIdx.x + offset], sb = ssum[threadIdx.x + offset];
+      if (mb > m) {
+        sum = sum * SoftmaxCEExp(m - mb) + sb;
+        m = mb;
+      } else {
+        sum += sb * SoftmaxCEExp(mb - m);
+      }
+      smax[threadIdx.x] = m;
+      ssum[threadIdx.x] = sum;
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    const size_t i = static_cast<size_t>(blockIdx.y) * gridDim.x + blockIdx.x;
+    stats[2 * i] = m;
+    stats[2 * i + 1] = sum;
+  }
+}
+
+/*! \brief block (c, r) writes the gradient of chunk c of row r, see SoftmaxCEGrad */
+template<typename DType, typename AccReal>
+__global__ void SoftmaxCEGradKernel(const DType *data, const DType *label, const AccReal *lse,
+                                    const DType *scale, int V, OpReqType req, DType *igrad) {
+  using namespace softmax_ce;
+  const int begin = blockIdx.x * kChunk;
+  const int end = min(V, begin + kChunk);
+  const size_t offset = static_cast<size_t>(blockIdx.y) * V;
+  const AccReal a = static_cast<AccReal>(scale[0]);
+  const AccReal l = lse[blockIdx.y];
+  const int k = static_cast<int>(label[blockIdx.y]);
+  for (int j = begin + threadIdx.x; j < end; j += kThreads) {
+    AccReal p = SoftmaxCEExp(static_cast<AccReal>(data[offset + j]) - l);
+    if (j == k) p -= 1;
+    KERNEL_ASSIGN(igrad[offset + j], req, DType(a * p));
+  }
+}
+
+template<typename DType, typename AccReal>
+void SoftmaxCEChunkStats(mshadow::Stream<gpu> *s, const DType *data,
+                         int N, int V, int nchunk, AccReal *stats) {
+  const dim3 grid(nchunk, N);
+  SoftmaxCEChunkStatsKernel<DType, AccReal>
+    <<<grid, softmax_ce::kThreads, 0, mshadow::Stream<gpu>::GetStream(s)>>>(data, V, stats);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(SoftmaxCEChunkStatsKernel);
+}
+
+template<typename DType, typename AccReal>
+void SoftmaxCEGrad(mshadow::Stream<gpu> *s, const DType *data, const DType *label,
+                   const AccReal *lse, const DType *scale, int N, int V, int nchunk,
+                   OpReqType req, DType *igrad) {
+  const dim3 grid(nchunk, N);
+  SoftmaxCEGradKernel<DType, AccReal>
+    <<<grid, softmax_ce::kThreads, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+      data, label, lse, scale, V, req, igrad);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(SoftmaxCEGradKernel);
+}
+
 NNVM_REGISTER_OP(softmax_cross_entropy)
 .set_attr<FCompute>("FCompute<gpu>", SoftmaxCrossEntropyForward<gpu>);
 
@@ -28,6 +28,7 @@
 #include <dmlc/omp.h>
 #include <mxnet/base.h>
 #include <algorithm>
+#include "../engine/openmp.h"
 #ifdef __CUDACC__
 #include "../common/cuda_utils.h"
 #endif  // __CUDACC__
@@ -78,7 +79,7 @@ inline int get_num_threads<gpu>(const int N) {
 
 template<>
 inline int get_num_threads<cpu>(const int N) {
-  return omp_get_max_threads();
+  return engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
 }
 
 /*! \brief operator request type switch */
@@ -219,13 +220,46 @@ struct Kernel;
 
 template<typename OP>
 struct Kernel<OP, cpu> {
+  /*!
+   * \brief call OP::Map(i, args...) for i in [0, N), in parallel when N is
+   *  at least MXNET_CPU_PARALLEL_SIZE, with the number of threads the engine
+   *  leaves to every CPU operator
+   */
   template<typename ...Args>
-  inline static void Launch(mshadow::Stream<cpu> *s, int N, Args... args) {
-#if (MXNET_USE_CUDA == 0)
-    #pragma omp parallel for
+  inline static void Launch(mshadow::Stream<cpu> *s, const int N, Args... args) {
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    if (omp_threads < 2 || N < engine::OpenMP::Get()->min_parallel_size()) {
+      for (int i = 0; i < N; ++i) {
+        OP::Map(i, args...);
+      }
+    } else {
+#ifndef __CUDACC__
+      #pragma omp parallel for num_threads(omp_threads)
 #endif
-    for (int i = 0; i < N; ++i) {
-      OP::Map(i, args...);
+      for (int i = 0; i < N; ++i) {
+        OP::Map(i, args...);
+      }
+    }
+  }
+  /*!
+   * \brief call OP::Map(begin, end, args...) over contiguous ranges covering
+   *  [0, N), one range per thread, so that OP can vectorize its inner loop
+   */
+  template<typename ...Args>
+  inline static void LaunchEx(mshadow::Stream<cpu> *s, const int N, Args... args) {
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    if (omp_threads < 2 || N < engine::OpenMP::Get()->min_parallel_size()) {
+      OP::Map(0, N, args...);
+    } else {
+      const int length = (N + omp_threads - 1) / omp_threads;
+#ifndef __CUDACC__
+      #pragma omp parallel for num_threads(omp_threads)
+#endif
+      for (int i = 0; i < omp_threads; ++i) {
+        const int begin = i * length;
+        const int end = std::min(begin + length, N);
+        if (begin < end) OP::Map(begin, end, args...);
+      }
     }
   }
 };
@@ -0,0 +1,423 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cpu_convolution-inl.h
+ * \brief CPU 2D convolutions which avoid the im2col buffer: the Winograd
+ *  F(2x2, 3x3) forward of 3x3 stride 1 convolutions, whose backward is the one
+ *  of ConvolutionOp, and direct loops for depthwise convolutions.
+ */
+#ifndef MXNET_OPERATOR_NN_CPU_CONVOLUTION_INL_H_
+#define MXNET_OPERATOR_NN_CPU_CONVOLUTION_INL_H_
+
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "../convolution-inl.h"
+#include "../linalg.h"
+#include "../mxnet_op.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace winograd {
+/*!
+ * \brief u = G g G^T of a 3x3 filter g, the 16 values are written with the stride ld
+ *  G = [1 0 0; 1/2 1/2 1/2; 1/2 -1/2 1/2; 0 0 1]
+ */
+template<typename DType>
+inline void TransformFilter(const DType *g, DType *u, const index_t ld) {
+  DType t[4][3];
+  for (int j = 0; j < 3; ++j) {
+    t[0][j] = g[j];
+    t[1][j] = (g[j] + g[3 + j] + g[6 + j]) * DType(0.5);
+    t[2][j] = (g[j] - g[3 + j] + g[6 + j]) * DType(0.5);
+    t[3][j] = g[6 + j];
+  }
+  for (int i = 0; i < 4; ++i) {
+    u[(i * 4) * ld] = t[i][0];
+    u[(i * 4 + 1) * ld] = (t[i][0] + t[i][1] + t[i][2]) * DType(0.5);
+    u[(i * 4 + 2) * ld] = (t[i][0] - t[i][1] + t[i][2]) * DType(0.5);
+    u[(i * 4 + 3) * ld] = t[i][2];
+  }
+}
+
+/*!
+ * \brief v = B^T d B of a 4x4 input tile d, the 16 values are written with the stride ld
+ *  B^T = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1]
+ */
+template<typename DType>
+inline void TransformInput(const DType d[4][4], DType *v, const index_t ld) {
+  DType t[4][4];
+  for (int j = 0; j < 4; ++j) {
+    t[0][j] = d[0][j] - d[2][j];
+    t[1][j] = d[1][j] + d[2][j];
+    t[2][j] = d[2][j] - d[1][j];
+    t[3][j] = d[1][j] - d[3][j];
+  }
+  for (int i = 0; i < 4; ++i) {
+    v[(i * 4) * ld] = t[i][0] - t[i][2];
+    v[(i * 4 + 1) * ld] = t[i][1] + t[i][2];
+    v[(i * 4 + 2) * ld] = t[i][2] - t[i][1];
+    v[(i * 4 + 3) * ld] = t[i][1] - t[i][3];
+  }
+}
+
+/*!
+ * \brief y = A^T m A of a 4x4 product tile m read with the stride ld
+ *  A^T = [1 1 1 0; 0 1 -1 -1]
+ */
+template<typename DType>
+inline void TransformOutput(const DType *m, const index_t ld, DType y[2][2]) {
+  DType t[2][4];
+  for (int j = 0; j < 4; ++j) {
+    const DType m0 = m[j * ld], m1 = m[(4 + j) * ld];
+    const DType m2 = m[(8 + j) * ld], m3 = m[(12 + j) * ld];
+    t[0][j] = m0 + m1 + m2;
+    t[1][j] = m1 - m2 - m3;
+  }
+  for (int i = 0; i < 2; ++i) {
+    y[i][0] = t[i][0] + t[i][1] + t[i][2];
+    y[i][1] = t[i][1] - t[i][2] - t[i][3];
+  }
+}
+}  // namespace winograd
+
+/*!
+ * \brief Forward of 3x3 stride 1 convolutions with the Winograd F(2x2, 3x3) algorithm.
+ *  The filters and the 4x4 input tiles overlapping by 2 are transformed, and the
+ *  products of the 16 transformed positions are 16 gemms of sizes
+ *  (num_filter x channels) x (channels x tiles). The result is about 2.25 times
+ *  fewer multiplications than im2col and a buffer of 16/4 instead of 9 times the
+ *  size of the output per channel.
+ */
+template<typename DType>
+class WinogradConvolutionOp : public ConvolutionOp<cpu, DType> {
+ public:
+  explicit WinogradConvolutionOp(ConvolutionParam p)
+      : ConvolutionOp<cpu, DType>(p), param_(p) {
+    // convert MBytes first to Bytes and then to elements.
+    param_.workspace = (param_.workspace << 20) / sizeof(DType);
+  }
+
+  /*! \brief whether the convolution is a case the Winograd forward is worth for */
+  static bool Supported(const ConvolutionParam& param,
+                        const TShape& ishape, const TShape& oshape) {
+    if (param.kernel.ndim() != 2 || param.num_group != 1) return false;
+    if (param.kernel[0] != 3 || param.kernel[1] != 3) return false;
+    if (param.stride[0] != 1 || param.stride[1] != 1) return false;
+    if (param.dilate[0] != 1 || param.dilate[1] != 1) return false;
+    // the transforms do not pay off for few channels
+    if (ishape[1] < 16 || oshape[1] < 16) return false;
+    const size_t tiles = ((oshape[2] + 1) / 2) * ((oshape[3] + 1) / 2);
+    const size_t size = 16 * (ishape[1] * oshape[1] + (ishape[1] + oshape[1]) * tiles);
+    return size * sizeof(DType) <= (param.workspace << 20);
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    CHECK_EQ(req[conv::kOut], kWriteTo);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_data[conv::kData].shape_;
+    const TShape& oshape = out_data[conv::kOut].shape_;
+    const index_t num = ishape[0], C = ishape[1], H = ishape[2], W = ishape[3];
+    const index_t K = oshape[1], OH = oshape[2], OW = oshape[3];
+    const int pad_h = param_.pad[0], pad_w = param_.pad[1];
+    const index_t TH = (OH + 1) / 2, TW = (OW + 1) / 2, tiles = TH * TW;
+    // images transformed together, bounded by the workspace
+    const size_t image_size = 16 * (C + K) * tiles;
+    const size_t filter_size = 16 * K * C;
+    const size_t avail = param_.workspace > filter_size ? param_.workspace - filter_size : 0;
+    const index_t step = std::max<size_t>(1, std::min<size_t>(num, avail / image_size));
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+        .get_space_typed<cpu, 1, DType>(Shape1(filter_size + step * image_size), s);
+    DType *U = workspace.dptr_;
+    DType *V = U + 16 * K * C;
+    DType *M = V + 16 * C * step * tiles;
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+    // U[e][k][c], transformed filters
+    const DType *weight = in_data[conv::kWeight].dptr<DType>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t kc = 0; kc < K * C; ++kc) {
+      winograd::TransformFilter(weight + kc * 9, U + kc, K * C);
+    }
+    const DType *data = in_data[conv::kData].dptr<DType>();
+    DType *out = out_data[conv::kOut].dptr<DType>();
+    const DType *bias = param_.no_bias ? nullptr : in_data[conv::kBias].dptr<DType>();
+    for (index_t n0 = 0; n0 < num; n0 += step) {
+      const index_t count = std::min(step, num - n0);
+      const index_t P = count * tiles;
+      // V[e][c][p], transformed input tiles
+      #pragma omp parallel for num_threads(omp_threads)
+      for (index_t cp = 0; cp < C * count; ++cp) {
+        const index_t c = cp % C, n = cp / C;
+        const DType *plane = data + ((n0 + n) * C + c) * H * W;
+        for (index_t ty = 0; ty < TH; ++ty) {
+          for (index_t tx = 0; tx < TW; ++tx) {
+            DType d[4][4];
+            const int y0 = static_cast<int>(ty * 2) - pad_h;
+            const int x0 = static_cast<int>(tx * 2) - pad_w;
+            for (int i = 0; i < 4; ++i) {
+              for (int j = 0; j < 4; ++j) {
+                const int y = y0 + i, x = x0 + j;
+                d[i][j] = (y >= 0 && y < static_cast<int>(H) && x >= 0 && x < static_cast<int>(W)) ?
+                    plane[y * W + x] : DType(0);
+              }
+            }
+            winograd::TransformInput(d, V + c * P + n * tiles + ty * TW + tx, C * P);
+          }
+        }
+      }
+      // M[e] = U[e] V[e]
+      for (int e = 0; e < 16; ++e) {
+        Tensor<cpu, 2, DType> u(U + e * K * C, Shape2(K, C), s);
+        Tensor<cpu, 2, DType> v(V + e * C * P, Shape2(C, P), s);
+        Tensor<cpu, 2, DType> m(M + e * K * P, Shape2(K, P), s);
+        linalg_gemm(u, v, m, false, false, s, kWriteTo);
+      }
+      // output tiles, the last row and column of tiles can be partial
+      #pragma omp parallel for num_threads(omp_threads)
+      for (index_t kp = 0; kp < K * count; ++kp) {
+        const index_t k = kp % K, n = kp / K;
+        DType *plane = out + ((n0 + n) * K + k) * OH * OW;
+        const DType b = bias == nullptr ? DType(0) : bias[k];
+        for (index_t ty = 0; ty < TH; ++ty) {
+          for (index_t tx = 0; tx < TW; ++tx) {
+            DType y[2][2];
+            winograd::TransformOutput(M + k * P + n * tiles + ty * TW + tx, K * P, y);
+            for (index_t i = 0; i < 2 && ty * 2 + i < OH; ++i) {
+              for (index_t j = 0; j < 2 && tx * 2 + j < OW; ++j) {
+                plane[(ty * 2 + i) * OW + tx * 2 + j] = y[i][j] + b;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  ConvolutionParam param_;
+};  // class WinogradConvolutionOp
+
+namespace depthwise {
+/*!
+ * \brief the outputs [begin, end) of a row or column reading the input
+ *  o * stride + offset inside [0, size)
+ */
+inline void ValidRange(int offset, int stride, int size, int out_size, int* begin, int* end) {
+  *begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  *end = size - 1 - offset < 0 ? 0 : std::min(out_size, (size - 1 - offset) / stride + 1);
+  *begin = std::min(*begin, *end);
+}
+
+/*! \brief out[o] += w * in[o * stride], contiguous when stride is 1 so that it vectorizes */
+template<typename DType>
+inline void AxpyRow(DType w, const DType *in, int stride, int n, DType *out) {
+  if (stride == 1) {
+    for (int o = 0; o < n; ++o) out[o] += w * in[o];
+  } else {
+    for (int o = 0; o < n; ++o) out[o] += w * in[o * stride];
+  }
+}
+
+/*! \brief in[o * stride] += w * out[o], the transpose of AxpyRow */
+template<typename DType>
+inline void AxpyRowTranspose(DType w, const DType *out, int stride, int n, DType *in) {
+  if (stride == 1) {
+    for (int o = 0; o < n; ++o) in[o] += w * out[o];
+  } else {
+    for (int o = 0; o < n; ++o) in[o * stride] += w * out[o];
+  }
+}
+
+/*! \brief sum of out[o] * in[o * stride] */
+template<typename DType>
+inline DType DotRow(const DType *out, const DType *in, int stride, int n) {
+  DType sum = 0;
+  if (stride == 1) {
+    for (int o = 0; o < n; ++o) sum += out[o] * in[o];
+  } else {
+    for (int o = 0; o < n; ++o) sum += out[o] * in[o * stride];
+  }
+  return sum;
+}
+}  // namespace depthwise
+
+/*!
+ * \brief Depthwise convolutions, with as many groups as input and output
+ *  channels, as direct loops over every channel plane instead of one small
+ *  gemm per channel. Every kernel tap updates the rows of the output it
+ *  reaches, which are contiguous for stride 1 and vectorized by the compiler.
+ */
+template<typename DType>
+class DepthwiseDirectConvolutionOp : public ConvolutionOp<cpu, DType> {
+ public:
+  explicit DepthwiseDirectConvolutionOp(ConvolutionParam p)
+      : ConvolutionOp<cpu, DType>(p), param_(p) {}
+
+  /*! \brief whether the convolution is depthwise */
+  static bool Supported(const ConvolutionParam& param, const TShape& ishape) {
+    return param.kernel.ndim() == 2 && param.num_group > 1 &&
+        param.num_group == ishape[1] && param.num_filter == ishape[1];
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    CHECK_EQ(req[conv::kOut], kWriteTo);
+    const Geometry geo(param_, in_data[conv::kData].shape_, out_data[conv::kOut].shape_);
+    const DType *data = in_data[conv::kData].dptr<DType>();
+    const DType *weight = in_data[conv::kWeight].dptr<DType>();
+    const DType *bias = param_.no_bias ? nullptr : in_data[conv::kBias].dptr<DType>();
+    DType *out = out_data[conv::kOut].dptr<DType>();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t nc = 0; nc < geo.num * geo.C; ++nc) {
+      const index_t c = nc % geo.C;
+      const DType *plane = data + nc * geo.H * geo.W;
+      const DType *filter = weight + c * geo.kernel_h * geo.kernel_w;
+      DType *out_plane = out + nc * geo.OH * geo.OW;
+      std::fill(out_plane, out_plane + geo.OH * geo.OW,
+                bias == nullptr ? DType(0) : bias[c]);
+      geo.ForEachRow([&](int i, int j, int oy, int y, int x0, int begin, int end) {
+        depthwise::AxpyRow(filter[i * geo.kernel_w + j], plane + y * geo.W + x0 +
+                           begin * geo.stride_w, geo.stride_w, end - begin,
+                           out_plane + oy * geo.OW + begin);
+      });
+    }
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob>& out_grad,
+                        const std::vector<TBlob>& in_data,
+                        const std::vector<TBlob>& out_data,
+                        const std::vector<OpReqType>& req,
+                        const std::vector<TBlob>& in_grad,
+                        const std::vector<TBlob>& aux_args) {
+    CHECK_EQ(out_grad.size(), 1U);
+    const size_t expected = param_.no_bias == 0 ? 3 : 2;
+    CHECK(in_data.size() == expected && in_grad.size() == expected);
+    CHECK_EQ(req.size(), expected);
+    const Geometry geo(param_, in_data[conv::kData].shape_, out_grad[conv::kOut].shape_);
+    const DType *data = in_data[conv::kData].dptr<DType>();
+    const DType *weight = in_data[conv::kWeight].dptr<DType>();
+    const DType *ograd = out_grad[conv::kOut].dptr<DType>();
+    const index_t ksize = geo.kernel_h * geo.kernel_w;
+    const index_t isize = geo.H * geo.W, osize = geo.OH * geo.OW;
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    // gradient w.r.t. input data
+    if (req[conv::kData] != kNullOp) {
+      DType *igrad = in_grad[conv::kData].dptr<DType>();
+      const bool add_to = req[conv::kData] == kAddTo;
+      #pragma omp parallel for num_threads(omp_threads)
+      for (index_t nc = 0; nc < geo.num * geo.C; ++nc) {
+        const DType *filter = weight + (nc % geo.C) * ksize;
+        const DType *out_plane = ograd + nc * osize;
+        DType *plane = igrad + nc * isize;
+        if (!add_to) std::fill(plane, plane + isize, DType(0));
+        geo.ForEachRow([&](int i, int j, int oy, int y, int x0, int begin, int end) {
+          depthwise::AxpyRowTranspose(filter[i * geo.kernel_w + j], out_plane + oy * geo.OW +
+                                      begin, geo.stride_w, end - begin,
+                                      plane + y * geo.W + x0 + begin * geo.stride_w);
+        });
+      }
+    }
+    // gradient w.r.t. weight and bias, every channel sums over the batch
+    const bool do_weight = req[conv::kWeight] != kNullOp;
+    const bool do_bias = !param_.no_bias && req[conv::kBias] != kNullOp;
+    if (!do_weight && !do_bias) return;
+    DType *wgrad = in_grad[conv::kWeight].dptr<DType>();
+    DType *bgrad = param_.no_bias ? nullptr : in_grad[conv::kBias].dptr<DType>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t c = 0; c < geo.C; ++c) {
+      std::vector<DType> sum(ksize, DType(0));
+      DType bias_sum = 0;
+      for (index_t n = 0; n < geo.num; ++n) {
+        const DType *plane = data + (n * geo.C + c) * isize;
+        const DType *out_plane = ograd + (n * geo.C + c) * osize;
+        if (do_weight) {
+          geo.ForEachRow([&](int i, int j, int oy, int y, int x0, int begin, int end) {
+            sum[i * geo.kernel_w + j] += depthwise::DotRow(out_plane + oy * geo.OW + begin,
+                plane + y * geo.W + x0 + begin * geo.stride_w, geo.stride_w, end - begin);
+          });
+        }
+        if (do_bias) {
+          for (index_t p = 0; p < osize; ++p) bias_sum += out_plane[p];
+        }
+      }
+      if (do_weight) {
+        for (index_t k = 0; k < ksize; ++k) {
+          KERNEL_ASSIGN(wgrad[c * ksize + k], req[conv::kWeight], sum[k]);
+        }
+      }
+      if (do_bias) {
+        KERNEL_ASSIGN(bgrad[c], req[conv::kBias], bias_sum);
+      }
+    }
+  }
+
+ private:
+  /*! \brief sizes of a depthwise convolution */
+  struct Geometry {
+    index_t num, C;
+    int H, W, OH, OW;
+    int kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, dilate_h, dilate_w;
+    Geometry(const ConvolutionParam& param, const TShape& ishape, const TShape& oshape)
+      : num(ishape[0]), C(ishape[1]), H(ishape[2]), W(ishape[3]), OH(oshape[2]), OW(oshape[3]),
+        kernel_h(param.kernel[0]), kernel_w(param.kernel[1]),
+        stride_h(param.stride[0]), stride_w(param.stride[1]),
+        pad_h(param.pad[0]), pad_w(param.pad[1]),
+        dilate_h(param.dilate[0]), dilate_w(param.dilate[1]) {}
+    /*!
+     * \brief call f(i, j, oy, y, x0, begin, end) for every tap (i, j) and output row oy
+     *  reading the input row y, output ox in [begin, end) reads x0 + ox * stride_w
+     */
+    template<typename F>
+    void ForEachRow(F f) const {
+      for (int i = 0; i < kernel_h; ++i) {
+        int oy_begin, oy_end;
+        depthwise::ValidRange(i * dilate_h - pad_h, stride_h, H, OH, &oy_begin, &oy_end);
+        for (int j = 0; j < kernel_w; ++j) {
+          const int x0 = j * dilate_w - pad_w;
+          int begin, end;
+          depthwise::ValidRange(x0, stride_w, W, OW, &begin, &end);
+          if (begin == end) continue;
+          for (int oy = oy_begin; oy < oy_end; ++oy) {
+            f(i, j, oy, oy * stride_h + i * dilate_h - pad_h, x0, begin, end);
+          }
+        }
+      }
+    }
+  };
+
+  ConvolutionParam param_;
+};  // class DepthwiseDirectConvolutionOp
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_CPU_CONVOLUTION_INL_H_
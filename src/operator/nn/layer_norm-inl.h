@@ -0,0 +1,323 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file layer_norm-inl.h
+ * \brief Layer normalization with fused statistics and affine transform
+ *
+ *  The normalized axis of length M is read as the rows of the data: with K
+ *  the size of the axes after it, row r starts at (r / K) * M * K + r % K and
+ *  its elements are K apart. The rows are contiguous when the last axis is
+ *  normalized, which is the fast path of the kernels.
+ */
+#ifndef MXNET_OPERATOR_NN_LAYER_NORM_INL_H_
+#define MXNET_OPERATOR_NN_LAYER_NORM_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../tensor/broadcast_reduce_op.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace layernorm {
+enum LayerNormOpInputs {kData, kGamma, kBeta};
+enum LayerNormOpOutputs {kOut, kMean, kStd};
+enum LayerNormBackwardInputs {kBwdOutGrad, kBwdData, kBwdGamma, kBwdMean, kBwdStd};
+enum LayerNormBackwardOutputs {kDataGrad, kGammaGrad, kBetaGrad};
+}  // namespace layernorm
+
+struct LayerNormParam : public dmlc::Parameter<LayerNormParam> {
+  int axis;
+  float eps;
+  bool output_mean_var;
+  DMLC_DECLARE_PARAMETER(LayerNormParam) {
+    DMLC_DECLARE_FIELD(axis).set_default(-1)
+      .describe("The axis to perform layer normalization. "
+                "Usually, this should be be axis of the channel dimension. "
+                "Negative values means indexing from right to left.");
+    DMLC_DECLARE_FIELD(eps).set_default(1e-5f)
+      .describe("An `epsilon` parameter to prevent division by 0.");
+    DMLC_DECLARE_FIELD(output_mean_var).set_default(false)
+      .describe("Output the mean and std calculated along the given axis.");
+  }
+};
+
+/*! \brief the rows of the data normalized by LayerNorm */
+struct LayerNormRows {
+  /*! \brief number of rows */
+  index_t N;
+  /*! \brief length of a row */
+  index_t M;
+  /*! \brief distance between the elements of a row */
+  index_t K;
+
+  LayerNormRows(const TShape& shape, int axis) : M(shape[axis]), K(1) {
+    for (index_t i = axis + 1; i < shape.ndim(); ++i) K *= shape[i];
+    N = shape.Size() / M;
+  }
+  /*! \brief offset of the first element of row r */
+  MSHADOW_XINLINE index_t Offset(index_t r) const {
+    return (r / K) * M * K + r % K;
+  }
+};
+
+inline bool LayerNormShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape> *in_shape,
+                           std::vector<TShape> *out_shape) {
+  using namespace layernorm;
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U) << "Input:[data, gamma, beta]";
+  const TShape &dshape = in_shape->at(kData);
+  if (dshape.ndim() == 0) return false;
+  const int axis = CheckAxis(param.axis, dshape.ndim());
+  const index_t channel = dshape[axis];
+  SHAPE_ASSIGN_CHECK(*in_shape, kGamma, TShape(mshadow::Shape1(channel)));
+  SHAPE_ASSIGN_CHECK(*in_shape, kBeta, TShape(mshadow::Shape1(channel)));
+  TShape moments_shape = dshape;
+  moments_shape[axis] = 1;
+  out_shape->clear();
+  out_shape->push_back(dshape);
+  out_shape->push_back(moments_shape);
+  out_shape->push_back(moments_shape);
+  return true;
+}
+
+/*!
+ * \brief mean and variance of a row in one pass. The sums are taken from
+ *  the first value of the row, which keeps them accurate when the mean is
+ *  large against the deviation, and leaves a loop the compiler vectorizes.
+ */
+template<typename DType, typename AccReal>
+inline void LayerNormRowMoments(const DType *x, index_t M, index_t stride,
+                                AccReal *mean, AccReal *var) {
+  const AccReal shift = static_cast<AccReal>(x[0]);
+  AccReal sum = 0, sq_sum = 0;
+  for (index_t j = 0; j < M; ++j) {
+    const AccReal d = static_cast<AccReal>(x[j * stride]) - shift;
+    sum += d;
+    sq_sum += d * d;
+  }
+  const AccReal m = sum / M;
+  *mean = shift + m;
+  *var = std::max(sq_sum / M - m * m, AccReal(0));
+}
+
+/*! \brief out = (x - mean) / std * gamma + beta on a row */
+template<bool add_to, typename DType, typename AccReal>
+inline void LayerNormRowAffine(const DType *x, const DType *gamma, const DType *beta,
+                               index_t M, index_t stride, AccReal mean, AccReal rstd,
+                               DType *out) {
+  for (index_t j = 0; j < M; ++j) {
+    const AccReal y = (static_cast<AccReal>(x[j * stride]) - mean) * rstd *
+                      static_cast<AccReal>(gamma[j]) + static_cast<AccReal>(beta[j]);
+    if (add_to) {
+      out[j * stride] = DType(static_cast<AccReal>(out[j * stride]) + y);
+    } else {
+      out[j * stride] = DType(y);
+    }
+  }
+}
+
+template<typename DType, typename AccReal>
+inline void LayerNormForward(mshadow::Stream<cpu> *s, const LayerNormRows& rows,
+                             const DType *data, const DType *gamma, const DType *beta,
+                             AccReal eps, OpReqType req,
+                             DType *out, DType *mean, DType *stddev) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int r = 0; r < static_cast<int>(rows.N); ++r) {
+    const index_t offset = rows.Offset(r);
+    const DType *x = data + offset;
+    DType *y = out + offset;
+    AccReal m, var;
+    if (rows.K == 1) {
+      LayerNormRowMoments(x, rows.M, 1, &m, &var);
+    } else {
+      LayerNormRowMoments(x, rows.M, rows.K, &m, &var);
+    }
+    const AccReal sd = std::sqrt(var + eps);
+    mean[r] = DType(m);
+    stddev[r] = DType(sd);
+    const AccReal rstd = AccReal(1) / sd;
+    if (req == kAddTo) {
+      LayerNormRowAffine<true>(x, gamma, beta, rows.M, rows.K, m, rstd, y);
+    } else if (rows.K == 1) {
+      LayerNormRowAffine<false>(x, gamma, beta, rows.M, 1, m, rstd, y);
+    } else {
+      LayerNormRowAffine<false>(x, gamma, beta, rows.M, rows.K, m, rstd, y);
+    }
+  }
+}
+
+/*!
+ * \brief the gradients of a row: with xhat = (x - mean) / std and
+ *  g = ograd * gamma, igrad = (g - mean(g) - xhat * mean(g * xhat)) / std,
+ *  and the sums of ograd * xhat and of ograd added to gamma_sum and beta_sum.
+ */
+template<typename DType, typename AccReal>
+inline void LayerNormRowBackward(const DType *ograd, const DType *x, const DType *gamma,
+                                 index_t M, index_t stride, AccReal mean, AccReal rstd,
+                                 OpReqType req, DType *igrad,
+                                 AccReal *gamma_sum, AccReal *beta_sum) {
+  AccReal g_sum = 0, gx_sum = 0;
+  for (index_t j = 0; j < M; ++j) {
+    const AccReal dy = static_cast<AccReal>(ograd[j * stride]);
+    const AccReal xhat = (static_cast<AccReal>(x[j * stride]) - mean) * rstd;
+    const AccReal g = dy * static_cast<AccReal>(gamma[j]);
+    g_sum += g;
+    gx_sum += g * xhat;
+    gamma_sum[j] += dy * xhat;
+    beta_sum[j] += dy;
+  }
+  if (req == kNullOp) return;
+  const AccReal g_mean = g_sum / M, gx_mean = gx_sum / M;
+  for (index_t j = 0; j < M; ++j) {
+    const AccReal xhat = (static_cast<AccReal>(x[j * stride]) - mean) * rstd;
+    const AccReal g = static_cast<AccReal>(ograd[j * stride]) * static_cast<AccReal>(gamma[j]);
+    const AccReal dx = (g - g_mean - xhat * gx_mean) * rstd;
+    if (req == kAddTo) {
+      igrad[j * stride] = DType(static_cast<AccReal>(igrad[j * stride]) + dx);
+    } else {
+      igrad[j * stride] = DType(dx);
+    }
+  }
+}
+
+/*!
+ * \brief cpu backward. The rows are split in one block per thread, every
+ *  block sums the gradients of gamma and beta in its own part of workspace,
+ *  and the parts are added at the end.
+ */
+template<typename DType, typename AccReal>
+inline void LayerNormBackward(mshadow::Stream<cpu> *s, const Resource& temp,
+                              const LayerNormRows& rows, const DType *ograd,
+                              const DType *data, const DType *gamma,
+                              const DType *mean, const DType *stddev,
+                              const std::vector<OpReqType>& req,
+                              DType *igrad, DType *gamma_grad, DType *beta_grad) {
+  using namespace layernorm;
+  const index_t M = rows.M;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int nblock = std::max(1, std::min(omp_threads, static_cast<int>(rows.N)));
+  const index_t block_len = (rows.N + nblock - 1) / nblock;
+  mshadow::Tensor<cpu, 1, AccReal> workspace = temp.get_space_typed<cpu, 1, AccReal>(
+      mshadow::Shape1(nblock * 2 * M), s);
+  AccReal *sums = workspace.dptr_;
+  std::fill(sums, sums + workspace.shape_.Size(), AccReal(0));
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int b = 0; b < nblock; ++b) {
+    AccReal *gamma_sum = sums + b * 2 * M;
+    AccReal *beta_sum = gamma_sum + M;
+    const index_t end = std::min(rows.N, (b + 1) * block_len);
+    for (index_t r = b * block_len; r < end; ++r) {
+      const index_t offset = rows.Offset(r);
+      const AccReal m = static_cast<AccReal>(mean[r]);
+      const AccReal rstd = AccReal(1) / static_cast<AccReal>(stddev[r]);
+      LayerNormRowBackward(ograd + offset, data + offset, gamma, M, rows.K, m, rstd,
+                           req[kDataGrad], igrad + offset, gamma_sum, beta_sum);
+    }
+  }
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int j = 0; j < static_cast<int>(M); ++j) {
+    AccReal gamma_sum = 0, beta_sum = 0;
+    for (int b = 0; b < nblock; ++b) {
+      gamma_sum += sums[b * 2 * M + j];
+      beta_sum += sums[b * 2 * M + M + j];
+    }
+    KERNEL_ASSIGN(gamma_grad[j], req[kGammaGrad], DType(gamma_sum));
+    KERNEL_ASSIGN(beta_grad[j], req[kBetaGrad], DType(beta_sum));
+  }
+}
+
+template<typename DType, typename AccReal>
+void LayerNormForward(mshadow::Stream<gpu> *s, const LayerNormRows& rows,
+                      const DType *data, const DType *gamma, const DType *beta,
+                      AccReal eps, OpReqType req,
+                      DType *out, DType *mean, DType *stddev);
+
+template<typename DType, typename AccReal>
+void LayerNormBackward(mshadow::Stream<gpu> *s, const Resource& temp,
+                       const LayerNormRows& rows, const DType *ograd,
+                       const DType *data, const DType *gamma,
+                       const DType *mean, const DType *stddev,
+                       const std::vector<OpReqType>& req,
+                       DType *igrad, DType *gamma_grad, DType *beta_grad);
+
+template<typename xpu>
+void LayerNormCompute(const nnvm::NodeAttrs& attrs,
+                      const OpContext& ctx,
+                      const std::vector<TBlob>& inputs,
+                      const std::vector<OpReqType>& req,
+                      const std::vector<TBlob>& outputs) {
+  using namespace layernorm;
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 3U);
+  if (req[kOut] == kNullOp) return;
+  const TShape& dshape = inputs[kData].shape_;
+  const LayerNormRows rows(dshape, CheckAxis(param.axis, dshape.ndim()));
+  if (rows.N == 0 || rows.M == 0) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[kData].type_flag_, DType, AccReal, {
+    LayerNormForward<DType, AccReal>(s, rows, inputs[kData].dptr<DType>(),
+                                     inputs[kGamma].dptr<DType>(), inputs[kBeta].dptr<DType>(),
+                                     static_cast<AccReal>(param.eps), req[kOut],
+                                     outputs[kOut].dptr<DType>(), outputs[kMean].dptr<DType>(),
+                                     outputs[kStd].dptr<DType>());
+  });
+}
+
+template<typename xpu>
+void LayerNormGradCompute(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  using namespace layernorm;
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 5U);
+  CHECK_EQ(outputs.size(), 3U);
+  const TShape& dshape = inputs[kBwdData].shape_;
+  const LayerNormRows rows(dshape, CheckAxis(param.axis, dshape.ndim()));
+  if (rows.N == 0 || rows.M == 0) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[kBwdData].type_flag_, DType, AccReal, {
+    LayerNormBackward<DType, AccReal>(s, ctx.requested[0], rows,
+                                      inputs[kBwdOutGrad].dptr<DType>(),
+                                      inputs[kBwdData].dptr<DType>(),
+                                      inputs[kBwdGamma].dptr<DType>(),
+                                      inputs[kBwdMean].dptr<DType>(),
+                                      inputs[kBwdStd].dptr<DType>(), req,
+                                      outputs[kDataGrad].dptr<DType>(),
+                                      outputs[kGammaGrad].dptr<DType>(),
+                                      outputs[kBetaGrad].dptr<DType>());
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_LAYER_NORM_INL_H_
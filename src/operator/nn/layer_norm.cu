@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file layer_norm.cu
+ * \brief GPU Implementation of layer normalization
+ *
+ *  Every row is handled by one warp: the statistics of the lanes are
+ *  computed by Welford's method and merged with warp shuffles, so one block
+ *  of kRowsPerBlock warps normalizes as many rows with no shared memory.
+ */
+#include "./layer_norm-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace layernorm {
+const int kWarpSize = 32;
+const int kRowsPerBlock = 4;
+/*! \brief rows summed by the threads of a column in a block of the gamma and beta gradients */
+const int kColumnBlockRows = 8;
+/*! \brief lower bound of the rows of a block of the gamma and beta gradients */
+const int kMinRowsPerPart = 64;
+const int kMaxParts = 256;
+}  // namespace layernorm
+
+template<typename T>
+__device__ __forceinline__ T LayerNormShflXor(T value, int lane_mask) {
+#if CUDA_VERSION >= 9000
+  return __shfl_xor_sync(0xFFFFFFFF, value, lane_mask, layernorm::kWarpSize);
+#else
+  return __shfl_xor(value, lane_mask, layernorm::kWarpSize);
+#endif
+}
+
+template<typename T>
+__device__ __forceinline__ T LayerNormShfl(T value, int src_lane) {
+#if CUDA_VERSION >= 9000
+  return __shfl_sync(0xFFFFFFFF, value, src_lane, layernorm::kWarpSize);
+#else
+  return __shfl(value, src_lane, layernorm::kWarpSize);
+#endif
+}
+
+/*! \brief sum of a value over the lanes of a warp, on every lane */
+template<typename T>
+__device__ __forceinline__ T LayerNormWarpSum(T value) {
+  for (int mask = layernorm::kWarpSize / 2; mask > 0; mask >>= 1) {
+    value += LayerNormShflXor(value, mask);
+  }
+  return value;
+}
+
+/*! \brief merge the Welford statistics of the values b into the ones of a */
+template<typename AccReal>
+__device__ __forceinline__ void LayerNormWelfordMerge(AccReal *count, AccReal *mean, AccReal *m2,
+                                                      AccReal count_b, AccReal mean_b,
+                                                      AccReal m2_b) {
+  const AccReal n = *count + count_b;
+  if (n == 0) return;
+  const AccReal delta = mean_b - *mean;
+  const AccReal w = count_b / n;
+  *mean += delta * w;
+  *m2 += m2_b + delta * delta * *count * w;
+  *count = n;
+}
+
+template<typename DType, typename AccReal>
+__global__ void LayerNormFwdKernel(const LayerNormRows rows, const DType *data,
+                                   const DType *gamma, const DType *beta,
+                                   const AccReal eps, const OpReqType req,
+                                   DType *out, DType *mean, DType *stddev) {
+  using namespace layernorm;
+  const index_t r = blockIdx.x * blockDim.y + threadIdx.y;
+  // the lanes of a warp leave together, the shuffles below see a full warp
+  if (r >= rows.N) return;
+  const int lane = threadIdx.x;
+  const index_t offset = rows.Offset(r);
+  AccReal count = 0, m = 0, m2 = 0;
+  for (index_t j = lane; j < rows.M; j += kWarpSize) {
+    const AccReal v = static_cast<AccReal>(data[offset + j * rows.K]);
+    count += 1;
+    const AccReal delta = v - m;
+    m += delta / count;
+    m2 += delta * (v - m);
+  }
+  for (int mask = kWarpSize / 2; mask > 0; mask >>= 1) {
+    const AccReal count_b = LayerNormShflXor(count, mask);
+    const AccReal m_b = LayerNormShflXor(m, mask);
+    const AccReal m2_b = LayerNormShflXor(m2, mask);
+    LayerNormWelfordMerge(&count, &m, &m2, count_b, m_b, m2_b);
+  }
+  // the merges are not symmetric, take the statistics of one lane
+  m = LayerNormShfl(m, 0);
+  m2 = LayerNormShfl(m2, 0);
+  const AccReal sd = sqrt(m2 / rows.M + eps);
+  if (lane == 0) {
+    mean[r] = DType(m);
+    stddev[r] = DType(sd);
+  }
+  const AccReal rstd = AccReal(1) / sd;
+  for (index_t j = lane; j < rows.M; j += kWarpSize) {
+    const index_t i = offset + j * rows.K;
+    const AccReal y = (static_cast<AccReal>(data[i]) - m) * rstd *
+                      static_cast<AccReal>(gamma[j]) + static_cast<AccReal>(beta[j]);
+    KERNEL_ASSIGN(out[i], req, DType(y));
+  }
+}
+
+template<typename DType, typename AccReal>
+__global__ void LayerNormBwdDataKernel(const LayerNormRows rows, const DType *ograd,
+                                       const DType *data, const DType *gamma,
+                                       const DType *mean, const DType *stddev,
+                                       const OpReqType req, DType *igrad) {
+  using namespace layernorm;
+  const index_t r = blockIdx.x * blockDim.y + threadIdx.y;
+  if (r >= rows.N) return;
+  const int lane = threadIdx.x;
+  const index_t offset = rows.Offset(r);
+  const AccReal m = static_cast<AccReal>(mean[r]);
+  const AccReal rstd = AccReal(1) / static_cast<AccReal>(stddev[r]);
+  AccReal g_sum = 0, gx_sum = 0;
+  for (index_t j = lane; j < rows.M; j += kWarpSize) {
+    const index_t i = offset + j * rows.K;
+    const AccReal g = static_cast<AccReal>(ograd[i]) * static_cast<AccReal>(gamma[j]);
+    g_sum += g;
+    gx_sum += g * (static_cast<AccReal>(data[i]) - m) * rstd;
+  }
+  const AccReal g_mean = LayerNormWarpSum(g_sum) / rows.M;
+  const AccReal gx_mean = LayerNormWarpSum(gx_sum) / rows.M;
+  for (index_t j = lane; j < rows.M; j += kWarpSize) {
+    const index_t i = offset + j * rows.K;
+    const AccReal xhat = (static_cast<AccReal>(data[i]) - m) * rstd;
+    const AccReal g = static_cast<AccReal>(ograd[i]) * static_cast<AccReal>(gamma[j]);
+    KERNEL_ASSIGN(igrad[i], req, DType((g - g_mean - xhat * gx_mean) * rstd));
+  }
+}
+
+/*!
+ * \brief partial sums of the gamma and beta gradients: block (x, y) sums the
+ *  kWarpSize columns from x * kWarpSize over the rows of part y, which are
+ *  read by column so that the loads of a row are contiguous.
+ */
+template<typename DType, typename AccReal>
+__global__ void LayerNormBwdGammaBetaPartKernel(const LayerNormRows rows, const DType *ograd,
+                                                const DType *data, const DType *mean,
+                                                const DType *stddev, const index_t rows_per_part,
+                                                AccReal *part) {
+  using namespace layernorm;
+  __shared__ AccReal gamma_buf[kColumnBlockRows][kWarpSize];
+  __shared__ AccReal beta_buf[kColumnBlockRows][kWarpSize];
+  const index_t j = blockIdx.x * kWarpSize + threadIdx.x;
+  const index_t begin = blockIdx.y * rows_per_part;
+  const index_t end = min(rows.N, begin + rows_per_part);
+  AccReal gamma_sum = 0, beta_sum = 0;
+  if (j < rows.M) {
+    for (index_t r = begin + threadIdx.y; r < end; r += kColumnBlockRows) {
+      const index_t i = rows.Offset(r) + j * rows.K;
+      const AccReal dy = static_cast<AccReal>(ograd[i]);
+      const AccReal xhat = (static_cast<AccReal>(data[i]) - static_cast<AccReal>(mean[r])) /
+                           static_cast<AccReal>(stddev[r]);
+      gamma_sum += dy * xhat;
+      beta_sum += dy;
+    }
+  }
+  gamma_buf[threadIdx.y][threadIdx.x] = gamma_sum;
+  beta_buf[threadIdx.y][threadIdx.x] = beta_sum;
+  __syncthreads();
+  if (threadIdx.y == 0 && j < rows.M) {
+    for (int y = 1; y < kColumnBlockRows; ++y) {
+      gamma_sum += gamma_buf[y][threadIdx.x];
+      beta_sum += beta_buf[y][threadIdx.x];
+    }
+    part[blockIdx.y * 2 * rows.M + j] = gamma_sum;
+    part[blockIdx.y * 2 * rows.M + rows.M + j] = beta_sum;
+  }
+}
+
+template<typename DType, typename AccReal>
+__global__ void LayerNormBwdGammaBetaSumKernel(const index_t M, const int nparts,
+                                               const AccReal *part,
+                                               const OpReqType gamma_req,
+                                               const OpReqType beta_req,
+                                               DType *gamma_grad, DType *beta_grad) {
+  const index_t j = blockIdx.x * blockDim.x + threadIdx.x;
+  if (j >= M) return;
+  AccReal gamma_sum = 0, beta_sum = 0;
+  for (int p = 0; p < nparts; ++p) {
+    gamma_sum += part[p * 2 * M + j];
+    beta_sum += part[p * 2 * M + M + j];
+  }
+  KERNEL_ASSIGN(gamma_grad[j], gamma_req, DType(gamma_sum));
+  KERNEL_ASSIGN(beta_grad[j], beta_req, DType(beta_sum));
+}
+
+template<typename DType, typename AccReal>
+void LayerNormForward(mshadow::Stream<gpu> *s, const LayerNormRows& rows,
+                      const DType *data, const DType *gamma, const DType *beta,
+                      AccReal eps, OpReqType req,
+                      DType *out, DType *mean, DType *stddev) {
+  using namespace layernorm;
+  const dim3 block(kWarpSize, kRowsPerBlock);
+  const int nblock = (rows.N + kRowsPerBlock - 1) / kRowsPerBlock;
+  LayerNormFwdKernel<DType, AccReal>
+    <<<nblock, block, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+      rows, data, gamma, beta, eps, req, out, mean, stddev);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(LayerNormFwdKernel);
+}
+
+template<typename DType, typename AccReal>
+void LayerNormBackward(mshadow::Stream<gpu> *s, const Resource& temp,
+                       const LayerNormRows& rows, const DType *ograd,
+                       const DType *data, const DType *gamma,
+                       const DType *mean, const DType *stddev,
+                       const std::vector<OpReqType>& req,
+                       DType *igrad, DType *gamma_grad, DType *beta_grad) {
+  using namespace layernorm;
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  if (req[kDataGrad] != kNullOp) {
+    const dim3 block(kWarpSize, kRowsPerBlock);
+    const int nblock = (rows.N + kRowsPerBlock - 1) / kRowsPerBlock;
+    LayerNormBwdDataKernel<DType, AccReal><<<nblock, block, 0, stream>>>(
+      rows, ograd, data, gamma, mean, stddev, req[kDataGrad], igrad);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(LayerNormBwdDataKernel);
+  }
+  if (req[kGammaGrad] == kNullOp && req[kBetaGrad] == kNullOp) return;
+  const int nparts = std::max(1, std::min(kMaxParts,
+                                          static_cast<int>(rows.N / kMinRowsPerPart)));
+  const index_t rows_per_part = (rows.N + nparts - 1) / nparts;
+  mshadow::Tensor<gpu, 1, AccReal> part = temp.get_space_typed<gpu, 1, AccReal>(
+      mshadow::Shape1(nparts * 2 * rows.M), s);
+  const dim3 grid((rows.M + kWarpSize - 1) / kWarpSize, nparts);
+  const dim3 block(kWarpSize, kColumnBlockRows);
+  LayerNormBwdGammaBetaPartKernel<DType, AccReal><<<grid, block, 0, stream>>>(
+    rows, ograd, data, mean, stddev, rows_per_part, part.dptr_);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(LayerNormBwdGammaBetaPartKernel);
+  const int nthreads = mshadow::cuda::kBaseThreadNum;
+  LayerNormBwdGammaBetaSumKernel<DType, AccReal>
+    <<<(rows.M + nthreads - 1) / nthreads, nthreads, 0, stream>>>(
+      rows.M, nparts, part.dptr_, req[kGammaGrad], req[kBetaGrad], gamma_grad, beta_grad);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(LayerNormBwdGammaBetaSumKernel);
+}
+
+NNVM_REGISTER_OP(LayerNorm)
+.set_attr<FCompute>("FCompute<gpu>", LayerNormCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_LayerNorm)
+.set_attr<FCompute>("FCompute<gpu>", LayerNormGradCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
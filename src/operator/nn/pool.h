@@ -81,6 +81,7 @@
 #include <mxnet/operator.h>
 #include <algorithm>
 #include "../mxnet_op.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
@@ -108,22 +109,23 @@ inline void pool_max_1d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_w = stride[0];
   const index_t in_data_offset = ishape[2];
   const index_t out_data_offset = oshape[2];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pw = 0; pw < pooled_width; ++pw) {
-        int wstart = pw * stride_w - pad_w;
-        int wend = std::min(wstart + kernel_w, width);
-        wstart = std::max(wstart, 0);
-        DType max_val = MinValue<DType>();
-        for (int w = wstart; w < wend; ++w) {
-          if (in_data[w] > max_val) {
-            max_val = in_data[w];
-          }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int pw = 0; pw < pooled_width; ++pw) {
+      int wstart = pw * stride_w - pad_w;
+      int wend = std::min(wstart + kernel_w, width);
+      wstart = std::max(wstart, 0);
+      DType max_val = MinValue<DType>();
+      for (int w = wstart; w < wend; ++w) {
+        if (in_data_plane[w] > max_val) {
+          max_val = in_data_plane[w];
         }
-        out_data[pw] = max_val;
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
+      out_data_plane[pw] = max_val;
     }
   }
 }
@@ -144,31 +146,32 @@ inline void pool_max_2d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_h = stride[0], stride_w = stride[1];
   const index_t in_data_offset = ishape[2] * ishape[3];
   const index_t out_data_offset = oshape[2] * oshape[3];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int ph = 0; ph < pooled_height; ++ph) {
-        for (int pw = 0; pw < pooled_width; ++pw) {
-          int hstart = ph * stride_h - pad_h;
-          int wstart = pw * stride_w - pad_w;
-          int hend = std::min(hstart + kernel_h, height);
-          int wend = std::min(wstart + kernel_w, width);
-          hstart = std::max(hstart, 0);
-          wstart = std::max(wstart, 0);
-          const int pool_index = ph * pooled_width + pw;
-          DType max_val = MinValue<DType>();
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              const int in_index = h * width + w;
-              if (in_data[in_index] > max_val) {
-                max_val = in_data[in_index];
-              }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = ph * stride_h - pad_h;
+        int wstart = pw * stride_w - pad_w;
+        int hend = std::min(hstart + kernel_h, height);
+        int wend = std::min(wstart + kernel_w, width);
+        hstart = std::max(hstart, 0);
+        wstart = std::max(wstart, 0);
+        const int pool_index = ph * pooled_width + pw;
+        DType max_val = MinValue<DType>();
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            const int in_index = h * width + w;
+            if (in_data_plane[in_index] > max_val) {
+              max_val = in_data_plane[in_index];
             }
           }
-          out_data[pool_index] = max_val;
         }
+        out_data_plane[pool_index] = max_val;
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
     }
   }
 }
@@ -189,38 +192,39 @@ inline void pool_max_3d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
   const index_t in_data_offset = ishape[2] * ishape[3] * ishape[4];
   const index_t out_data_offset = oshape[2] * oshape[3] * oshape[4];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pd = 0; pd < pooled_depth; ++pd) {
-        for (int ph = 0; ph < pooled_height; ++ph) {
-          for (int pw = 0; pw < pooled_width; ++pw) {
-            int dstart = pd * stride_d - pad_d;
-            int hstart = ph * stride_h - pad_h;
-            int wstart = pw * stride_w - pad_w;
-            int dend = std::min(dstart + kernel_d, depth);
-            int hend = std::min(hstart + kernel_h, height);
-            int wend = std::min(wstart + kernel_w, width);
-            dstart = std::max(dstart, 0);
-            hstart = std::max(hstart, 0);
-            wstart = std::max(wstart, 0);
-            const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
-            DType max_val = MinValue<DType>();
-            for (int d = dstart; d < dend; ++d) {
-              for (int h = hstart; h < hend; ++h) {
-                for (int w = wstart; w < wend; ++w) {
-                  const int in_index = (d * height + h) * width + w;
-                  if (in_data[in_index] > max_val) {
-                    max_val = in_data[in_index];
-                  }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int pd = 0; pd < pooled_depth; ++pd) {
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          int dstart = pd * stride_d - pad_d;
+          int hstart = ph * stride_h - pad_h;
+          int wstart = pw * stride_w - pad_w;
+          int dend = std::min(dstart + kernel_d, depth);
+          int hend = std::min(hstart + kernel_h, height);
+          int wend = std::min(wstart + kernel_w, width);
+          dstart = std::max(dstart, 0);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
+          DType max_val = MinValue<DType>();
+          for (int d = dstart; d < dend; ++d) {
+            for (int h = hstart; h < hend; ++h) {
+              for (int w = wstart; w < wend; ++w) {
+                const int in_index = (d * height + h) * width + w;
+                if (in_data_plane[in_index] > max_val) {
+                  max_val = in_data_plane[in_index];
                 }
               }
             }
-            out_data[pool_index] = max_val;
           }
+          out_data_plane[pool_index] = max_val;
         }
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
     }
   }
 }
@@ -240,22 +244,23 @@ inline void pool_sum_1d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_w = stride[0];
   const index_t in_data_offset = ishape[2];
   const index_t out_data_offset = oshape[2];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pw = 0; pw < pooled_width; ++pw) {
-        int wstart = pw * stride_w - pad_w;
-        int wend = std::min(wstart + kernel_w, width + pad_w);
-        int pool_size = (wend - wstart);
-        wstart = std::max(wstart, 0);
-        wend = std::min(wend, width);
-        DType sum = 0;
-        for (int w = wstart; w < wend; ++w) {
-          sum += in_data[w];
-        }
-        out_data[pw] = (getAvg? sum/pool_size : sum);
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int pw = 0; pw < pooled_width; ++pw) {
+      int wstart = pw * stride_w - pad_w;
+      int wend = std::min(wstart + kernel_w, width + pad_w);
+      int pool_size = (wend - wstart);
+      wstart = std::max(wstart, 0);
+      wend = std::min(wend, width);
+      DType sum = 0;
+      for (int w = wstart; w < wend; ++w) {
+        sum += in_data_plane[w];
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
+      out_data_plane[pw] = (getAvg? sum/pool_size : sum);
     }
   }
 }
@@ -275,30 +280,31 @@ inline void pool_sum_2d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_h = stride[0], stride_w = stride[1];
   const index_t in_data_offset = ishape[2] * ishape[3];
   const index_t out_data_offset = oshape[2] * oshape[3];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int ph = 0; ph < pooled_height; ++ph) {
-        for (int pw = 0; pw < pooled_width; ++pw) {
-          int hstart = ph * stride_h - pad_h;
-          int wstart = pw * stride_w - pad_w;
-          int hend = std::min(hstart + kernel_h, height + pad_h);
-          int wend = std::min(wstart + kernel_w, width + pad_w);
-          int pool_size = (hend - hstart) * (wend - wstart);
-          hstart = std::max(hstart, 0);
-          wstart = std::max(wstart, 0);
-          hend = std::min(hend, height);
-          wend = std::min(wend, width);
-          DType sum = 0;
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              sum += in_data[h*width+w];
-            }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = ph * stride_h - pad_h;
+        int wstart = pw * stride_w - pad_w;
+        int hend = std::min(hstart + kernel_h, height + pad_h);
+        int wend = std::min(wstart + kernel_w, width + pad_w);
+        int pool_size = (hend - hstart) * (wend - wstart);
+        hstart = std::max(hstart, 0);
+        wstart = std::max(wstart, 0);
+        hend = std::min(hend, height);
+        wend = std::min(wend, width);
+        DType sum = 0;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            sum += in_data_plane[h*width+w];
           }
-          out_data[ph*pooled_width+pw] = (getAvg? sum/pool_size : sum);
         }
+        out_data_plane[ph*pooled_width+pw] = (getAvg? sum/pool_size : sum);
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
     }
   }
 }
@@ -318,38 +324,39 @@ inline void pool_sum_3d_cpu(const DType* in_data, const TShape& ishape, const TS
   const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
   const index_t in_data_offset = ishape[2] * ishape[3] * ishape[4];
   const index_t out_data_offset = oshape[2] * oshape[3] * oshape[4];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pd = 0; pd < pooled_depth; ++pd) {
-        for (int ph = 0; ph < pooled_height; ++ph) {
-          for (int pw = 0; pw < pooled_width; ++pw) {
-            int dstart = pd * stride_d - pad_d;
-            int hstart = ph * stride_h - pad_h;
-            int wstart = pw * stride_w - pad_w;
-            int dend = std::min(dstart + kernel_d, depth + pad_d);
-            int hend = std::min(hstart + kernel_h, height + pad_h);
-            int wend = std::min(wstart + kernel_w, width + pad_w);
-            int pool_size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-            dstart = std::max(dstart, 0);
-            hstart = std::max(hstart, 0);
-            wstart = std::max(wstart, 0);
-            dend = std::min(dend, depth);
-            hend = std::min(hend, height);
-            wend = std::min(wend, width);
-            DType sum = 0;
-            for (int d = dstart; d < dend; ++d) {
-              for (int h = hstart; h < hend; ++h) {
-                for (int w = wstart; w < wend; ++w) {
-                  sum += in_data[(d*height+h)*width+w];
-                }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_data_offset;
+    DType* out_data_plane = out_data + plane * out_data_offset;
+    for (int pd = 0; pd < pooled_depth; ++pd) {
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          int dstart = pd * stride_d - pad_d;
+          int hstart = ph * stride_h - pad_h;
+          int wstart = pw * stride_w - pad_w;
+          int dend = std::min(dstart + kernel_d, depth + pad_d);
+          int hend = std::min(hstart + kernel_h, height + pad_h);
+          int wend = std::min(wstart + kernel_w, width + pad_w);
+          int pool_size = (dend - dstart) * (hend - hstart) * (wend - wstart);
+          dstart = std::max(dstart, 0);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          dend = std::min(dend, depth);
+          hend = std::min(hend, height);
+          wend = std::min(wend, width);
+          DType sum = 0;
+          for (int d = dstart; d < dend; ++d) {
+            for (int h = hstart; h < hend; ++h) {
+              for (int w = wstart; w < wend; ++w) {
+                sum += in_data_plane[(d*height+h)*width+w];
               }
             }
-            out_data[(pd*pooled_height+ph)*pooled_width+pw] = (getAvg? sum/pool_size : sum);
           }
+          out_data_plane[(pd*pooled_height+ph)*pooled_width+pw] = (getAvg? sum/pool_size : sum);
         }
       }
-      in_data += in_data_offset;
-      out_data += out_data_offset;
     }
   }
 }
@@ -371,29 +378,30 @@ inline void unpool_max_1d_cpu(const DType* out_grad, const DType* in_data,
   const int stride_w = stride[0];
   const index_t in_offset = ishape[2];
   const index_t out_offset = oshape[2];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pw = 0; pw < pooled_width; ++pw) {
-        int wstart = pw * stride_w - pad_w;
-        int wend = std::min(wstart + kernel_w, width);
-        wstart = std::max(wstart, 0);
-        int max_idx = -1;
-        for (int w = wstart; w < wend; ++w) {
-          if (in_data[w] == out_data[pw]) {
-            max_idx = w;
-            break;
-          }
-        }
-        // In the case where pad > 0 and kernel = 1, for example,
-        // max_idx can be -1 reaching this step.
-        if (max_idx >= 0) {
-          in_grad[max_idx] += out_grad[pw];
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_offset;
+    DType* in_grad_plane = in_grad + plane * in_offset;
+    const DType* out_data_plane = out_data + plane * out_offset;
+    const DType* out_grad_plane = out_grad + plane * out_offset;
+    for (int pw = 0; pw < pooled_width; ++pw) {
+      int wstart = pw * stride_w - pad_w;
+      int wend = std::min(wstart + kernel_w, width);
+      wstart = std::max(wstart, 0);
+      int max_idx = -1;
+      for (int w = wstart; w < wend; ++w) {
+        if (in_data_plane[w] == out_data_plane[pw]) {
+          max_idx = w;
+          break;
         }
       }
-      in_data += in_offset;
-      in_grad += in_offset;
-      out_data += out_offset;
-      out_grad += out_offset;
+      // In the case where pad > 0 and kernel = 1, for example,
+      // max_idx can be -1 reaching this step.
+      if (max_idx >= 0) {
+        in_grad_plane[max_idx] += out_grad_plane[pw];
+      }
     }
   }
 }
@@ -415,41 +423,42 @@ inline void unpool_max_2d_cpu(const DType* out_grad, const DType* in_data,
   const int stride_h = stride[0], stride_w = stride[1];
   const index_t in_offset = ishape[2] * ishape[3];
   const index_t out_offset = oshape[2] * oshape[3];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int ph = 0; ph < pooled_height; ++ph) {
-        for (int pw = 0; pw < pooled_width; ++pw) {
-          int hstart = ph * stride_h - pad_h;
-          int wstart = pw * stride_w - pad_w;
-          int hend = std::min(hstart + kernel_h, height);
-          int wend = std::min(wstart + kernel_w, width);
-          hstart = std::max(hstart, 0);
-          wstart = std::max(wstart, 0);
-          const int pool_index = ph * pooled_width + pw;
-          int max_idx = -1;
-          bool found = false;
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              const int idx = h * width + w;
-              if (in_data[idx] == out_data[pool_index]) {
-                max_idx = idx;
-                found = true;
-                break;
-              }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_offset;
+    DType* in_grad_plane = in_grad + plane * in_offset;
+    const DType* out_data_plane = out_data + plane * out_offset;
+    const DType* out_grad_plane = out_grad + plane * out_offset;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = ph * stride_h - pad_h;
+        int wstart = pw * stride_w - pad_w;
+        int hend = std::min(hstart + kernel_h, height);
+        int wend = std::min(wstart + kernel_w, width);
+        hstart = std::max(hstart, 0);
+        wstart = std::max(wstart, 0);
+        const int pool_index = ph * pooled_width + pw;
+        int max_idx = -1;
+        bool found = false;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            const int idx = h * width + w;
+            if (in_data_plane[idx] == out_data_plane[pool_index]) {
+              max_idx = idx;
+              found = true;
+              break;
             }
-            if (found) break;
-          }
-          // In the case where pad > 0 and kernel = 1, for example,
-          // max_idx can be -1 reaching this step.
-          if (max_idx >= 0) {
-            in_grad[max_idx] += out_grad[pool_index];
           }
+          if (found) break;
+        }
+        // In the case where pad > 0 and kernel = 1, for example,
+        // max_idx can be -1 reaching this step.
+        if (max_idx >= 0) {
+          in_grad_plane[max_idx] += out_grad_plane[pool_index];
         }
       }
-      in_data += in_offset;
-      in_grad += in_offset;
-      out_data += out_offset;
-      out_grad += out_offset;
     }
   }
 }
@@ -471,49 +480,50 @@ inline void unpool_max_3d_cpu(const DType* out_grad, const DType* in_data,
   const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
   const index_t in_offset = ishape[2] * ishape[3] * ishape[4];
   const index_t out_offset = oshape[2] * oshape[3] * oshape[4];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pd = 0; pd < pooled_depth; ++pd) {
-        for (int ph = 0; ph < pooled_height; ++ph) {
-          for (int pw = 0; pw < pooled_width; ++pw) {
-            int dstart = pd * stride_d - pad_d;
-            int hstart = ph * stride_h - pad_h;
-            int wstart = pw * stride_w - pad_w;
-            int dend = std::min(dstart + kernel_d, depth);
-            int hend = std::min(hstart + kernel_h, height);
-            int wend = std::min(wstart + kernel_w, width);
-            dstart = std::max(dstart, 0);
-            hstart = std::max(hstart, 0);
-            wstart = std::max(wstart, 0);
-            const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
-            int max_idx = -1;
-            bool found = false;
-            for (int d = dstart; d < dend; ++d) {
-              for (int h = hstart; h < hend; ++h) {
-                for (int w = wstart; w < wend; ++w) {
-                  const int idx = (d * height + h) * width + w;
-                  if (in_data[idx] == out_data[pool_index]) {
-                    max_idx = idx;
-                    found = true;
-                    break;
-                  }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    const DType* in_data_plane = in_data + plane * in_offset;
+    DType* in_grad_plane = in_grad + plane * in_offset;
+    const DType* out_data_plane = out_data + plane * out_offset;
+    const DType* out_grad_plane = out_grad + plane * out_offset;
+    for (int pd = 0; pd < pooled_depth; ++pd) {
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          int dstart = pd * stride_d - pad_d;
+          int hstart = ph * stride_h - pad_h;
+          int wstart = pw * stride_w - pad_w;
+          int dend = std::min(dstart + kernel_d, depth);
+          int hend = std::min(hstart + kernel_h, height);
+          int wend = std::min(wstart + kernel_w, width);
+          dstart = std::max(dstart, 0);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
+          int max_idx = -1;
+          bool found = false;
+          for (int d = dstart; d < dend; ++d) {
+            for (int h = hstart; h < hend; ++h) {
+              for (int w = wstart; w < wend; ++w) {
+                const int idx = (d * height + h) * width + w;
+                if (in_data_plane[idx] == out_data_plane[pool_index]) {
+                  max_idx = idx;
+                  found = true;
+                  break;
                 }
-                if (found) break;
               }
               if (found) break;
             }
-            // In the case where pad > 0 and kernel = 1, for example,
-            // max_idx can be -1 reaching this step.
-            if (max_idx >= 0) {
-              in_grad[max_idx] += out_grad[pool_index];
-            }
+            if (found) break;
+          }
+          // In the case where pad > 0 and kernel = 1, for example,
+          // max_idx can be -1 reaching this step.
+          if (max_idx >= 0) {
+            in_grad_plane[max_idx] += out_grad_plane[pool_index];
           }
         }
       }
-      in_data += in_offset;
-      in_grad += in_offset;
-      out_data += out_offset;
-      out_grad += out_offset;
     }
   }
 }
@@ -534,23 +544,24 @@ inline void unpool_sum_1d_cpu(const DType* out_grad, const TShape& ishape,
   const int stride_w = stride[0];
   const index_t in_grad_offset = ishape[2];
   const index_t out_grad_offset = oshape[2];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pw = 0; pw < pooled_width; ++pw) {
-        int wstart = pw * stride_w - pad_w;
-        int wend = std::min(wstart + kernel_w, width + pad_w);
-        int pool_size = 1;
-        if (isAvg) {
-          pool_size = wend - wstart;
-        }
-        wstart = std::max(wstart, 0);
-        wend = std::min(wend, width);
-        for (int w = wstart; w < wend; ++w) {
-          in_grad[w] += out_grad[pw] / pool_size;
-        }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    DType* in_grad_plane = in_grad + plane * in_grad_offset;
+    const DType* out_grad_plane = out_grad + plane * out_grad_offset;
+    for (int pw = 0; pw < pooled_width; ++pw) {
+      int wstart = pw * stride_w - pad_w;
+      int wend = std::min(wstart + kernel_w, width + pad_w);
+      int pool_size = 1;
+      if (isAvg) {
+        pool_size = wend - wstart;
+      }
+      wstart = std::max(wstart, 0);
+      wend = std::min(wend, width);
+      for (int w = wstart; w < wend; ++w) {
+        in_grad_plane[w] += out_grad_plane[pw] / pool_size;
       }
-      in_grad += in_grad_offset;
-      out_grad += out_grad_offset;
     }
   }
 }
@@ -571,32 +582,33 @@ inline void unpool_sum_2d_cpu(const DType* out_grad, const TShape& ishape,
   const int stride_h = stride[0], stride_w = stride[1];
   const index_t in_grad_offset = ishape[2] * ishape[3];
   const index_t out_grad_offset = oshape[2] * oshape[3];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int ph = 0; ph < pooled_height; ++ph) {
-        for (int pw = 0; pw < pooled_width; ++pw) {
-          int hstart = ph * stride_h - pad_h;
-          int wstart = pw * stride_w - pad_w;
-          int hend = std::min(hstart + kernel_h, height + pad_h);
-          int wend = std::min(wstart + kernel_w, width + pad_w);
-          int pool_size = 1;
-          if (isAvg) {
-            pool_size = (hend - hstart) * (wend - wstart);
-          }
-          hstart = std::max(hstart, 0);
-          wstart = std::max(wstart, 0);
-          hend = std::min(hend, height);
-          wend = std::min(wend, width);
-          const int pool_index = ph * pooled_width + pw;
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              in_grad[h*width+w] += out_grad[pool_index] / pool_size;
-            }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    DType* in_grad_plane = in_grad + plane * in_grad_offset;
+    const DType* out_grad_plane = out_grad + plane * out_grad_offset;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = ph * stride_h - pad_h;
+        int wstart = pw * stride_w - pad_w;
+        int hend = std::min(hstart + kernel_h, height + pad_h);
+        int wend = std::min(wstart + kernel_w, width + pad_w);
+        int pool_size = 1;
+        if (isAvg) {
+          pool_size = (hend - hstart) * (wend - wstart);
+        }
+        hstart = std::max(hstart, 0);
+        wstart = std::max(wstart, 0);
+        hend = std::min(hend, height);
+        wend = std::min(wend, width);
+        const int pool_index = ph * pooled_width + pw;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            in_grad_plane[h*width+w] += out_grad_plane[pool_index] / pool_size;
           }
         }
       }
-      in_grad += in_grad_offset;
-      out_grad += out_grad_offset;
     }
   }
 }
@@ -617,40 +629,41 @@ inline void unpool_sum_3d_cpu(const DType* out_grad, const TShape& ishape,
   const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
   const index_t in_grad_offset = ishape[2] * ishape[3] * ishape[4];
   const index_t out_grad_offset = oshape[2] * oshape[3] * oshape[4];
-  for (index_t n = 0; n < oshape[0]; ++n) {
-    for (index_t c = 0; c < oshape[1]; ++c) {
-      for (int pd = 0; pd < pooled_depth; ++pd) {
-        for (int ph = 0; ph < pooled_height; ++ph) {
-          for (int pw = 0; pw < pooled_width; ++pw) {
-            int dstart = pd * stride_d - pad_d;
-            int hstart = ph * stride_h - pad_h;
-            int wstart = pw * stride_w - pad_w;
-            int dend = std::min(dstart + kernel_d, depth + pad_d);
-            int hend = std::min(hstart + kernel_h, height + pad_h);
-            int wend = std::min(wstart + kernel_w, width + pad_w);
-            int pool_size = 1;
-            if (isAvg) {
-              pool_size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-            }
-            dstart = std::max(dstart, 0);
-            hstart = std::max(hstart, 0);
-            wstart = std::max(wstart, 0);
-            dend = std::min(dend, depth);
-            hend = std::min(hend, height);
-            wend = std::min(wend, width);
-            const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
-            for (int d = dstart; d < dend; ++d) {
-              for (int h = hstart; h < hend; ++h) {
-                for (int w = wstart; w < wend; ++w) {
-                  in_grad[(d*height+h)*width+w] += out_grad[pool_index] / pool_size;
-                }
+  const int num_planes = oshape[0] * oshape[1];
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int plane = 0; plane < num_planes; ++plane) {
+    DType* in_grad_plane = in_grad + plane * in_grad_offset;
+    const DType* out_grad_plane = out_grad + plane * out_grad_offset;
+    for (int pd = 0; pd < pooled_depth; ++pd) {
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          int dstart = pd * stride_d - pad_d;
+          int hstart = ph * stride_h - pad_h;
+          int wstart = pw * stride_w - pad_w;
+          int dend = std::min(dstart + kernel_d, depth + pad_d);
+          int hend = std::min(hstart + kernel_h, height + pad_h);
+          int wend = std::min(wstart + kernel_w, width + pad_w);
+          int pool_size = 1;
+          if (isAvg) {
+            pool_size = (dend - dstart) * (hend - hstart) * (wend - wstart);
+          }
+          dstart = std::max(dstart, 0);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          dend = std::min(dend, depth);
+          hend = std::min(hend, height);
+          wend = std::min(wend, width);
+          const int pool_index = (pd * pooled_height + ph) * pooled_width + pw;
+          for (int d = dstart; d < dend; ++d) {
+            for (int h = hstart; h < hend; ++h) {
+              for (int w = wstart; w < wend; ++w) {
+                in_grad_plane[(d*height+h)*width+w] += out_grad_plane[pool_index] / pool_size;
               }
             }
           }
         }
       }
-      in_grad += in_grad_offset;
-      out_grad += out_grad_offset;
     }
   }
 }
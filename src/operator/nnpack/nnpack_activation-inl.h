@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file nnpack_activation-inl.h
+ * \brief relu activation running the vectorized NNPACK kernel, NEON on ARM
+*/
+#ifndef MXNET_OPERATOR_NNPACK_NNPACK_ACTIVATION_INL_H_
+#define MXNET_OPERATOR_NNPACK_NNPACK_ACTIVATION_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <vector>
+#include "../activation-inl.h"
+#include "../mshadow_op.h"
+#include "nnpack.h"
+#include "nnpack_util.h"
+
+namespace mxnet {
+namespace op {
+
+template <typename xpu, typename DType>
+class NNPACKReluOp : public ActivationOp<xpu, mshadow_op::relu, mshadow_op::relu_grad, DType> {
+ public:
+  virtual void Forward(const OpContext &ctx, const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    if (req[activation::kOut] == kAddTo) {
+      ActivationOp<xpu, mshadow_op::relu, mshadow_op::relu_grad, DType>::Forward(
+          ctx, in_data, req, out_data, aux_args);
+      return;
+    }
+    if (req[activation::kOut] == kNullOp) return;
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 1, DType> data = in_data[activation::kData].FlatTo1D<xpu, DType>(s);
+    Tensor<xpu, 1, DType> out = out_data[activation::kOut].FlatTo1D<xpu, DType>(s);
+    // the array is seen as one image whose channels are its elements
+    nnp_status status = nnp_relu_output(
+      1,                             // size_t batch size of input tensor
+      data.shape_.Size(),            // size_t channels,
+      data.dptr_,                    // const float input[],
+      out.dptr_,                     // float output[],
+      0.0f,                          // float negative_slope,
+      nnpackinitialize.threadpool);  // pthreadpool_t threadpool,
+    if (nnp_status_success != status) {
+      LOG(FATAL) << "nnpack relu feedforward failed status=" << status;
+    }
+  }
+};  // class NNPACKReluOp
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NNPACK_NNPACK_ACTIVATION_INL_H_
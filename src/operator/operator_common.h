@@ -400,9 +400,9 @@ void FCompExFallback(const nnvm::NodeAttrs& attrs,
       post_temp_dst.push_back(inputs[idx]);
     }
   }
-  CastNonDefaultStorage<xpu>(pre_temp_src, pre_temp_dst, ctx, true);
+  CastNonDefaultStorage<xpu>(pre_temp_src, pre_temp_dst, ctx, true, fname);
   fcompute(attrs, ctx, in_blobs, req, out_blobs);
-  CastNonDefaultStorage<xpu>(post_temp_src, post_temp_dst, ctx, true);
+  CastNonDefaultStorage<xpu>(post_temp_src, post_temp_dst, ctx, true, fname);
 }
 
 #define CHECK_RSP_ALL_ROWS_NON_ZERO(rsp, func, param)                              \
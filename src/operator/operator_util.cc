@@ -479,7 +479,9 @@ void SimpleOpRegEntryImpl::RegisterSourceImperative() {
     std::vector<Engine::VarHandle> write_vars = {ret.var()};
     for (ResourceRequest req : resource_requests_) {
       env.resource.push_back(ResourceManager::Get()->Request(ret.ctx(), req));
-      write_vars.push_back(env.resource.back().var);
+      if (env.resource.back().var != nullptr) {
+        write_vars.push_back(env.resource.back().var);
+      }
     }
     // check if the function exist
     int dev_mask = ret.ctx().dev_mask();
@@ -657,7 +659,9 @@ void SimpleOpRegEntryImpl::RegisterUnaryImperative() {
     std::vector<Engine::VarHandle> write_vars = {ret.var()};
     for (ResourceRequest req : resource_requests_) {
       env.resource.push_back(ResourceManager::Get()->Request(src.ctx(), req));
-      write_vars.push_back(env.resource.back().var);
+      if (env.resource.back().var != nullptr) {
+        write_vars.push_back(env.resource.back().var);
+      }
     }
 
     // check if the function exist
@@ -927,7 +931,9 @@ void SimpleOpRegEntryImpl::RegisterBinaryImperative() {
     std::vector<Engine::VarHandle> write_vars = {ret.var()};
     for (ResourceRequest req : resource_requests_) {
       env.resource.push_back(ResourceManager::Get()->Request(lhs.ctx(), req));
-      write_vars.push_back(env.resource.back().var);
+      if (env.resource.back().var != nullptr) {
+        write_vars.push_back(env.resource.back().var);
+      }
     }
 
     // check if the function exist
@@ -31,6 +31,9 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
@@ -45,6 +48,7 @@ struct SGDParam : public dmlc::Parameter<SGDParam> {
   float wd;
   float rescale_grad;
   float clip_gradient;
+  bool lazy_update;
   DMLC_DECLARE_PARAMETER(SGDParam) {
     DMLC_DECLARE_FIELD(lr)
     .describe("Learning rate");
@@ -61,6 +65,10 @@ struct SGDParam : public dmlc::Parameter<SGDParam> {
     .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
               "If clip_gradient <= 0, gradient clipping is turned off. "
               "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(lazy_update)
+    .set_default(true)
+    .describe("If true, a row_sparse gradient updates only the rows of the weight "
+              "whose indices appear in grad.indices, even if the weight is dense.");
   }
 };
 
@@ -259,6 +267,10 @@ inline void SGDUpdateEx(const nnvm::NodeAttrs& attrs,
   } else if (weight_stype == kRowSparseStorage && grad_stype == kDefaultStorage) {
     NDArray out = outputs[0];
     SGDUpdateRspDnsImpl<xpu>(param, ctx, inputs[0], inputs[1].data(), req[0], &out);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage &&
+             param.lazy_update) {
+    TBlob out_blob = outputs[0].data();
+    SGDUpdateDnsRspImpl<xpu>(param, ctx, inputs[0].data(), inputs[1], req[0], &out_blob);
   } else {
     FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs, SGDUpdate<xpu>, "SGDUpdate");
   }
@@ -270,6 +282,7 @@ struct SGDMomParam : public dmlc::Parameter<SGDMomParam> {
   float wd;
   float rescale_grad;
   float clip_gradient;
+  bool lazy_update;
   DMLC_DECLARE_PARAMETER(SGDMomParam) {
     DMLC_DECLARE_FIELD(lr)
     .describe("Learning rate");
@@ -289,6 +302,10 @@ struct SGDMomParam : public dmlc::Parameter<SGDMomParam> {
     .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
               "If clip_gradient <= 0, gradient clipping is turned off. "
               "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(lazy_update)
+    .set_default(true)
+    .describe("If true, a row_sparse gradient updates only the rows of the weight "
+              "whose indices appear in grad.indices, even if the weight is dense.");
   }
 };
 
@@ -437,6 +454,298 @@ inline void MP_SGDMomUpdate(const nnvm::NodeAttrs& attrs,
   });
 }
 
+struct MultiSGDParam : public dmlc::Parameter<MultiSGDParam> {
+  nnvm::Tuple<float> lrs;
+  nnvm::Tuple<float> wds;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiSGDParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates, one per weight.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decays, one per weight.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .set_lower_bound(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiSGDMomParam : public dmlc::Parameter<MultiSGDMomParam> {
+  nnvm::Tuple<float> lrs;
+  nnvm::Tuple<float> wds;
+  float momentum;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiSGDMomParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates, one per weight.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decays, one per weight.");
+    DMLC_DECLARE_FIELD(momentum)
+    .set_default(0.0f)
+    .describe("The decay rate of momentum estimates at each epoch.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .set_lower_bound(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+inline float MultiSGDMomentum(const MultiSGDParam& param) { return 0.0f; }
+inline float MultiSGDMomentum(const MultiSGDMomParam& param) { return param.momentum; }
+
+/*!
+ * \brief shapes of the multi-tensor sgd updates, the inputs come in groups of
+ *  input_stride arrays of the shape of one weight.
+ */
+template<typename ParamType, int input_stride>
+inline bool MultiSGDShape(const nnvm::NodeAttrs& attrs,
+                          std::vector<TShape> *in_attrs,
+                          std::vector<TShape> *out_attrs) {
+  const ParamType& param = nnvm::get<ParamType>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), static_cast<size_t>(input_stride * param.num_weights));
+  CHECK_EQ(out_attrs->size(), static_cast<size_t>(param.num_weights));
+  CHECK_EQ(param.lrs.ndim(), static_cast<size_t>(param.num_weights))
+    << "lrs must hold one learning rate per weight";
+  CHECK_EQ(param.wds.ndim(), static_cast<size_t>(param.num_weights))
+    << "wds must hold one weight decay per weight";
+  bool all_inferred = true;
+  for (int i = 0; i < param.num_weights; ++i) {
+    std::vector<TShape> in(in_attrs->begin() + i * input_stride,
+                           in_attrs->begin() + (i + 1) * input_stride);
+    std::vector<TShape> out{(*out_attrs)[i]};
+    all_inferred = ElemwiseShape<input_stride, 1>(attrs, &in, &out) && all_inferred;
+    std::copy(in.begin(), in.end(), in_attrs->begin() + i * input_stride);
+    (*out_attrs)[i] = out[0];
+  }
+  return all_inferred;
+}
+
+/*!
+ * \brief types of the multi-tensor sgd updates, the first num_fp32_inputs
+ *  arrays of every group, the mixed precision states, are float32.
+ */
+template<typename ParamType, int input_stride, int num_fp32_inputs>
+inline bool MultiSGDType(const nnvm::NodeAttrs& attrs,
+                         std::vector<int> *in_attrs,
+                         std::vector<int> *out_attrs) {
+  const ParamType& param = nnvm::get<ParamType>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), static_cast<size_t>(input_stride * param.num_weights));
+  CHECK_EQ(out_attrs->size(), static_cast<size_t>(param.num_weights));
+  bool all_inferred = true;
+  for (int i = 0; i < param.num_weights; ++i) {
+    std::vector<int> in(in_attrs->begin() + i * input_stride,
+                        in_attrs->begin() + (i + 1) * input_stride);
+    std::vector<int> out{(*out_attrs)[i]};
+    if (num_fp32_inputs > 0) {
+      all_inferred = MP_SGD_InferType<input_stride - num_fp32_inputs, 1, input_stride>(
+          attrs, &in, &out) && all_inferred;
+    } else {
+      all_inferred = ElemwiseType<input_stride, 1>(attrs, &in, &out) && all_inferred;
+    }
+    std::copy(in.begin(), in.end(), in_attrs->begin() + i * input_stride);
+    (*out_attrs)[i] = out[0];
+  }
+  return all_inferred;
+}
+
+/*!
+ * \brief the tensors updated by one launch of MultiSGDKernel, passed by value
+ *  to the kernel. offsets holds the running sum of the sizes of the tensors.
+ */
+template<typename DType, typename MPDType>
+struct MultiSGDKernelParam {
+  static const int N = 56;
+  int count;
+  int offsets[N + 1];
+  DType* weights[N];
+  DType* grads[N];
+  MPDType* mom[N];
+  MPDType* weights32[N];
+  DType* out_data[N];
+  float lrs[N];
+  float wds[N];
+  float clip_gradient;
+  float rescale_grad;
+  float momentum;
+};
+
+/*!
+ * \brief sgd update of element i of the concatenation of the tensors, so that
+ *  the work is balanced over the threads whatever the sizes of the tensors.
+ */
+template<typename MPDType, bool has_momentum, bool has_mixed_precision>
+struct MultiSGDKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const MultiSGDKernelParam<DType, MPDType> param,
+                                  const OpReqType req) {
+    int lo = 0, hi = param.count;
+    while (hi - lo > 1) {
+      const int mid = (lo + hi) / 2;
+      if (param.offsets[mid] <= i) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    const int t = lo;
+    const int j = i - param.offsets[t];
+    const float lr = param.lrs[t];
+    const float wd = param.wds[t];
+    MPDType w = has_mixed_precision ? param.weights32[t][j] :
+                                      static_cast<MPDType>(param.weights[t][j]);
+    MPDType g = param.rescale_grad * static_cast<MPDType>(param.grads[t][j]);
+    if (param.clip_gradient >= 0.0f) {
+      g = mshadow_op::clip::Map(g, static_cast<MPDType>(param.clip_gradient));
+    }
+    if (has_momentum) {
+      const MPDType mom = param.momentum * param.mom[t][j] - lr * wd * w - lr * g;
+      param.mom[t][j] = mom;
+      w = w + mom;
+    } else {
+      w = (1.f - lr * wd) * w - lr * g;
+    }
+    if (has_mixed_precision) {
+      param.weights32[t][j] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[t][j], req, w);
+  }
+};
+
+/*!
+ * \brief update num_weights weights with one kernel launch per group of
+ *  MultiSGDKernelParam::N tensors. The inputs of a weight are the weight, the
+ *  gradient, the momentum if has_momentum and the float32 weight if
+ *  has_mixed_precision.
+ */
+template<typename xpu, typename ParamType, bool has_momentum, bool has_mixed_precision>
+inline void MultiSGDUpdate(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const ParamType& param = nnvm::get<ParamType>(attrs.parsed);
+  const int input_stride = 2 + has_momentum + has_mixed_precision;
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    typedef typename std::conditional<has_mixed_precision, float, DType>::type MPDType;
+    typedef MultiSGDKernelParam<DType, MPDType> KernelParam;
+    for (int start = 0; start < param.num_weights; start += KernelParam::N) {
+      KernelParam kp;
+      kp.count = std::min(param.num_weights - start, static_cast<int>(KernelParam::N));
+      kp.clip_gradient = param.clip_gradient;
+      kp.rescale_grad = param.rescale_grad;
+      kp.momentum = MultiSGDMomentum(param);
+      kp.offsets[0] = 0;
+      for (int t = 0; t < kp.count; ++t) {
+        const int k = start + t;
+        // all the weights share the request of the first one, inplace updates
+        CHECK_EQ(req[k], req[start]) << "weights " << start << " and " << k
+          << " of " << attrs.name << " have different write requests";
+        const TBlob *in = &inputs[k * input_stride];
+        CHECK_EQ(in[0].type_flag_, inputs[0].type_flag_) << "weights " << start << " and " << k
+          << " of " << attrs.name << " have different types";
+        kp.weights[t] = in[0].dptr<DType>();
+        kp.grads[t] = in[1].dptr<DType>();
+        kp.mom[t] = has_momentum ? in[2].dptr<MPDType>() : nullptr;
+        kp.weights32[t] = has_mixed_precision ? in[input_stride - 1].dptr<MPDType>() : nullptr;
+        kp.out_data[t] = outputs[k].dptr<DType>();
+        kp.lrs[t] = param.lrs[k];
+        kp.wds[t] = param.wds[k];
+        kp.offsets[t + 1] = kp.offsets[t] + static_cast<int>(in[0].Size());
+      }
+      Kernel<MultiSGDKernel<MPDType, has_momentum, has_mixed_precision>, xpu>::Launch(
+          s, kp.offsets[kp.count], kp, req[start]);
+    }
+  });
+}
+
+struct MultiAllFiniteParam : public dmlc::Parameter<MultiAllFiniteParam> {
+  int num_arrays;
+  bool init_output;
+  DMLC_DECLARE_PARAMETER(MultiAllFiniteParam) {
+    DMLC_DECLARE_FIELD(num_arrays)
+    .set_default(1)
+    .set_lower_bound(1)
+    .describe("Number of arrays.");
+    DMLC_DECLARE_FIELD(init_output)
+    .set_default(true)
+    .describe("Initialize the output to 1. If false, the arrays are only checked "
+              "against the value already in the output.");
+  }
+};
+
+inline bool MultiAllFiniteShape(const nnvm::NodeAttrs& attrs,
+                                std::vector<TShape> *in_attrs,
+                                std::vector<TShape> *out_attrs) {
+  const MultiAllFiniteParam& param = nnvm::get<MultiAllFiniteParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), static_cast<size_t>(param.num_arrays));
+  CHECK_EQ(out_attrs->size(), 1U);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::Shape1(1));
+  return true;
+}
+
+inline bool MultiAllFiniteType(const nnvm::NodeAttrs& attrs,
+                               std::vector<int> *in_attrs,
+                               std::vector<int> *out_attrs) {
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kFloat32);
+  for (int dtype : *in_attrs) {
+    if (dtype == -1) return false;
+  }
+  return true;
+}
+
+struct AllFiniteKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, float* out, const DType* in) {
+    // x - x is 0 for every finite x, and NaN for infinities and NaNs
+    if (static_cast<float>(in[i] - in[i]) != 0.0f) out[0] = 0.0f;
+  }
+};
+
+/*!
+ * \brief Writes 1 if all the values of the arrays are finite and 0 otherwise,
+ *  so that dynamic loss scaling can skip the updates of overflowing steps.
+ */
+template<typename xpu>
+inline void MultiAllFiniteUpdate(const nnvm::NodeAttrs& attrs,
+                                 const OpContext &ctx,
+                                 const std::vector<TBlob> &inputs,
+                                 const std::vector<OpReqType> &req,
+                                 const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const MultiAllFiniteParam& param = nnvm::get<MultiAllFiniteParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  Tensor<xpu, 1, float> out = outputs[0].FlatTo1D<xpu, float>(s);
+  if (param.init_output) out = 1.0f;
+  for (const TBlob& in : inputs) {
+    MSHADOW_REAL_TYPE_SWITCH(in.type_flag_, DType, {
+      Kernel<AllFiniteKernel, xpu>::Launch(s, in.Size(), out.dptr_, in.dptr<DType>());
+    });
+  }
+}
+
 template<int req>
 struct SGDMomDnsRspDnsKernel {
   template<typename DType, typename IType>
@@ -620,6 +929,11 @@ inline void SGDMomUpdateEx(const nnvm::NodeAttrs& attrs,
       mom_stype == kRowSparseStorage) {
      NDArray out = outputs[0];
      SGDMomUpdateRspDnsImpl<xpu>(param, ctx, weight, grad.data(), mom, req[0], &out);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage &&
+      mom_stype == kDefaultStorage && param.lazy_update) {
+     TBlob out_blob = outputs[0].data();
+     SGDMomUpdateDnsRspDnsImpl<xpu>(param, ctx, weight.data(), grad, mom.data(),
+                                    req[0], &out_blob);
   } else {
     // inputs[2] is a mutable input
     FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs,
@@ -635,6 +949,7 @@ struct AdamParam : public dmlc::Parameter<AdamParam> {
   float wd;
   float rescale_grad;
   float clip_gradient;
+  bool lazy_update;
   DMLC_DECLARE_PARAMETER(AdamParam) {
     DMLC_DECLARE_FIELD(lr)
     .describe("Learning rate");
@@ -660,6 +975,10 @@ struct AdamParam : public dmlc::Parameter<AdamParam> {
     .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
               "If clip_gradient <= 0, gradient clipping is turned off. "
               "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(lazy_update)
+    .set_default(true)
+    .describe("If true, a row_sparse gradient updates only the rows of the weight "
+              "whose indices appear in grad.indices, even if the weight is dense.");
   }
 };
 
@@ -834,6 +1153,15 @@ inline void AdamUpdateEx(const nnvm::NodeAttrs& attrs,
      NDArray out = outputs[0];
      AdamUpdateRspRspRspImpl<xpu>(param, ctx, inputs[0], inputs[1], inputs[2],
                                   inputs[3], req[0], &out);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage &&
+             out_stype == kDefaultStorage && param.lazy_update) {
+     TBlob out_blob = outputs[0].data();
+     AdamUpdateDnsRspDnsImpl<xpu>(param, ctx, inputs[0].data(), inputs[1], inputs[2].data(),
+                                  inputs[3].data(), req[0], &out_blob);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage) {
+    // inputs[2] and inputs[3] are mutable inputs
+    FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs,
+                         AdamUpdate<xpu>, "AdamUpdate", {2, 3});
   } else {
     LOG(FATAL) << "Unexpected storage types: weight.stype = " << weight_stype
                << ", var.stype = " << var_stype << ", mean.stype = " << mean_stype
@@ -841,6 +1169,684 @@ inline void AdamUpdateEx(const nnvm::NodeAttrs& attrs,
   }
 }
 
+struct FtrlParam : public dmlc::Parameter<FtrlParam> {
+  float lr;
+  float lamda1;
+  float beta;
+  float wd;
+  float rescale_grad;
+  float clip_gradient;
+  DMLC_DECLARE_PARAMETER(FtrlParam) {
+    DMLC_DECLARE_FIELD(lr)
+    .describe("Learning rate");
+    DMLC_DECLARE_FIELD(lamda1)
+    .set_default(0.01f)
+    .describe("The L1 regularization coefficient.");
+    DMLC_DECLARE_FIELD(beta)
+    .set_default(1.0f)
+    .describe("Per-Coordinate Learning Rate beta.");
+    DMLC_DECLARE_FIELD(wd)
+    .set_default(0.0f)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+  }
+};
+
+/*! \brief ftrl update of the element data_i of weight, z and n with the gradient g */
+template<typename DType>
+MSHADOW_XINLINE void FtrlUpdateElem(const nnvm::dim_t data_i, DType* out_data,
+    DType* z_data, DType* n_data, const DType* weight_data, DType g,
+    const DType clip_gradient, const DType lamda1, const DType beta,
+    const DType lr, const DType wd, const DType rescale_grad, const OpReqType req) {
+  using namespace mshadow_op;
+  g *= rescale_grad;
+  if (clip_gradient >= 0.0f) {
+    g = clip::Map(g, clip_gradient);
+  }
+  const DType n_old = n_data[data_i];
+  const DType n_new = n_old + g * g;
+  z_data[data_i] += g - (square_root::Map(n_new) - square_root::Map(n_old)) *
+                    weight_data[data_i] / lr;
+  n_data[data_i] = n_new;
+  const DType z = z_data[data_i];
+  KERNEL_ASSIGN(out_data[data_i], req, abs::Map(z) > lamda1 ?
+                (sign::Map(z) * lamda1 - z) / ((beta + square_root::Map(n_new)) / lr + wd) :
+                DType(0));
+}
+
+struct FtrlKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out_data, DType* z_data, DType* n_data,
+    const DType* weight_data, const DType* grad_data, const DType clip_gradient,
+    const DType lamda1, const DType beta, const DType lr, const DType wd,
+    const DType rescale_grad, const OpReqType req) {
+    FtrlUpdateElem(i, out_data, z_data, n_data, weight_data, grad_data[i], clip_gradient,
+                   lamda1, beta, lr, wd, rescale_grad, req);
+  }
+};
+
+template<typename xpu>
+inline void FtrlUpdate(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const FtrlParam& param = nnvm::get<FtrlParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  if (req[0] == kNullOp) return;
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    Kernel<FtrlKernel, xpu>::Launch(s, inputs[0].Size(), outputs[0].dptr<DType>(),
+      inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), inputs[0].dptr<DType>(),
+      inputs[1].dptr<DType>(), static_cast<DType>(param.clip_gradient),
+      static_cast<DType>(param.lamda1), static_cast<DType>(param.beta),
+      static_cast<DType>(param.lr), static_cast<DType>(param.wd),
+      static_cast<DType>(param.rescale_grad), req[0]);
+  });
+}
+
+/*!
+ * Note: this kernel performs sparse ftrl update. For each row-slice in row_sparse
+ * gradient, it finds the corresponding elements in weight, z and n and performs
+ * the update.
+ * The kernel assumes dense weight/z/n, and row_sparse gradient
+ */
+struct FtrlDnsRspDnsKernel {
+  template<typename DType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, const nnvm::dim_t row_length, DType* out_data,
+    DType* z_data, DType* n_data, const DType* weight_data, const IType* grad_idx,
+    const DType* grad_data, const DType clip_gradient, const DType lamda1, const DType beta,
+    const DType lr, const DType wd, const DType rescale_grad, const OpReqType req) {
+    using nnvm::dim_t;
+    const dim_t row_offset = grad_idx[i] * row_length;
+    for (dim_t j = 0; j < row_length; j++) {
+      FtrlUpdateElem(row_offset + j, out_data, z_data, n_data, weight_data,
+                     grad_data[i * row_length + j], clip_gradient, lamda1, beta,
+                     lr, wd, rescale_grad, req);
+    }
+  }
+};
+
+template<typename xpu>
+inline void FtrlUpdateDnsRspDnsImpl(const FtrlParam& param,
+                                    const OpContext& ctx,
+                                    const TBlob& weight,
+                                    const NDArray& grad,
+                                    const TBlob& z,
+                                    const TBlob& n,
+                                    const OpReqType& req,
+                                    TBlob *out) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  if (!grad.storage_initialized() || req == kNullOp) return;
+  CHECK_EQ(req, kWriteInplace) << "kWriteInplace is expected for sparse ftrl_update";
+  CHECK_GT(weight.shape_.Size(), 0);
+  CHECK_GT(z.shape_.Size(), 0);
+  CHECK_GT(n.shape_.Size(), 0);
+  MSHADOW_REAL_TYPE_SWITCH(weight.type_flag_, DType, {
+    MSHADOW_IDX_TYPE_SWITCH(grad.aux_type(kIdx), IType, {
+      const nnvm::dim_t num_rows = grad.aux_shape(kIdx)[0];
+      const auto row_length = weight.shape_.ProdShape(1, weight.ndim());
+      Kernel<FtrlDnsRspDnsKernel, xpu>::Launch(s, num_rows, row_length,
+        out->dptr<DType>(), z.dptr<DType>(), n.dptr<DType>(), weight.dptr<DType>(),
+        grad.aux_data(kIdx).dptr<IType>(), grad.data().dptr<DType>(),
+        static_cast<DType>(param.clip_gradient), static_cast<DType>(param.lamda1),
+        static_cast<DType>(param.beta), static_cast<DType>(param.lr),
+        static_cast<DType>(param.wd), static_cast<DType>(param.rescale_grad), req);
+    });
+  });
+}
+
+template<typename xpu>
+inline void FtrlUpdateRspRspRspImpl(const FtrlParam& param,
+                                    const OpContext& ctx,
+                                    const NDArray& weight,
+                                    const NDArray& grad,
+                                    const NDArray& z,
+                                    const NDArray& n,
+                                    const OpReqType& req,
+                                    NDArray *out) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  CHECK_RSP_ALL_ROWS_NON_ZERO(weight, "FtrlUpdate", "weights");
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  // fill z and n with zero values in order to reuse the dns rsp impl
+  if (!z.storage_initialized()) {
+    NDArray z_zeros = z;
+    FillDnsZerosRspImpl(s, &z_zeros);
+  }
+  if (!n.storage_initialized()) {
+    NDArray n_zeros = n;
+    FillDnsZerosRspImpl(s, &n_zeros);
+  }
+  TBlob out_blob = out->data();
+  // reuse dns rsp implementation when storage_shape == shape
+  FtrlUpdateDnsRspDnsImpl<xpu>(param, ctx, weight.data(), grad, z.data(),
+                               n.data(), req, &out_blob);
+}
+
+template<typename xpu>
+inline void FtrlUpdateEx(const nnvm::NodeAttrs& attrs,
+                         const OpContext &ctx,
+                         const std::vector<NDArray> &inputs,
+                         const std::vector<OpReqType> &req,
+                         const std::vector<NDArray> &outputs) {
+  const FtrlParam& param = nnvm::get<FtrlParam>(attrs.parsed);
+  const auto weight_stype = inputs[0].storage_type();
+  const auto grad_stype = inputs[1].storage_type();
+  const auto z_stype = inputs[2].storage_type();
+  const auto n_stype = inputs[3].storage_type();
+  const auto out_stype = outputs[0].storage_type();
+  CHECK_EQ(z_stype, weight_stype) << "Inconsistent storage type detected between "
+           << " z.stype = " << z_stype << " and weight.stype = " << weight_stype;
+  CHECK_EQ(n_stype, weight_stype) << "Inconsistent storage type detected between "
+           << " n.stype = " << n_stype << " and weight.stype = " << weight_stype;
+  if (weight_stype == kRowSparseStorage && grad_stype == kRowSparseStorage &&
+      out_stype == kRowSparseStorage) {
+    NDArray out = outputs[0];
+    FtrlUpdateRspRspRspImpl<xpu>(param, ctx, inputs[0], inputs[1], inputs[2],
+                                 inputs[3], req[0], &out);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage &&
+             out_stype == kDefaultStorage) {
+    TBlob out_blob = outputs[0].data();
+    FtrlUpdateDnsRspDnsImpl<xpu>(param, ctx, inputs[0].data(), inputs[1], inputs[2].data(),
+                                 inputs[3].data(), req[0], &out_blob);
+  } else {
+    LOG(FATAL) << "Unexpected storage types: weight.stype = " << weight_stype
+               << ", z.stype = " << z_stype << ", n.stype = " << n_stype
+               << ", grad.stype = " << grad_stype;
+  }
+}
+
+struct AdagradParam : public dmlc::Parameter<AdagradParam> {
+  float lr;
+  float epsilon;
+  float wd;
+  float rescale_grad;
+  float clip_gradient;
+  DMLC_DECLARE_PARAMETER(AdagradParam) {
+    DMLC_DECLARE_FIELD(lr)
+    .describe("Learning rate");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-7f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(wd)
+    .set_default(0.0f)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+  }
+};
+
+/*! \brief adagrad update of the element data_i of weight and history with the gradient g */
+template<typename DType>
+MSHADOW_XINLINE void AdagradUpdateElem(const nnvm::dim_t data_i, DType* out_data,
+    DType* history_data, const DType* weight_data, DType g, const DType clip_gradient,
+    const DType lr, const DType wd, const DType epsilon, const DType rescale_grad,
+    const OpReqType req) {
+  using namespace mshadow_op;
+  g *= rescale_grad;
+  if (clip_gradient >= 0.0f) {
+    g = clip::Map(g, clip_gradient);
+  }
+  history_data[data_i] += g * g;
+  KERNEL_ASSIGN(out_data[data_i], req, weight_data[data_i] - lr *
+                (g / square_root::Map(history_data[data_i] + epsilon) +
+                 wd * weight_data[data_i]));
+}
+
+struct AdagradKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out_data, DType* history_data,
+    const DType* weight_data, const DType* grad_data, const DType clip_gradient,
+    const DType lr, const DType wd, const DType epsilon, const DType rescale_grad,
+    const OpReqType req) {
+    AdagradUpdateElem(i, out_data, history_data, weight_data, grad_data[i], clip_gradient,
+                      lr, wd, epsilon, rescale_grad, req);
+  }
+};
+
+template<typename xpu>
+inline void AdagradUpdate(const nnvm::NodeAttrs& attrs,
+                          const OpContext &ctx,
+                          const std::vector<TBlob> &inputs,
+                          const std::vector<OpReqType> &req,
+                          const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const AdagradParam& param = nnvm::get<AdagradParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  if (req[0] == kNullOp) return;
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    Kernel<AdagradKernel, xpu>::Launch(s, inputs[0].Size(), outputs[0].dptr<DType>(),
+      inputs[2].dptr<DType>(), inputs[0].dptr<DType>(), inputs[1].dptr<DType>(),
+      static_cast<DType>(param.clip_gradient), static_cast<DType>(param.lr),
+      static_cast<DType>(param.wd), static_cast<DType>(param.epsilon),
+      static_cast<DType>(param.rescale_grad), req[0]);
+  });
+}
+
+/*!
+ * Note: this kernel performs sparse adagrad update. For each row-slice in row_sparse
+ * gradient, it finds the corresponding elements in weight and history and performs
+ * the update.
+ * The kernel assumes dense weight/history, and row_sparse gradient
+ */
+struct AdagradDnsRspDnsKernel {
+  template<typename DType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, const nnvm::dim_t row_length, DType* out_data,
+    DType* history_data, const DType* weight_data, const IType* grad_idx,
+    const DType* grad_data, const DType clip_gradient, const DType lr, const DType wd,
+    const DType epsilon, const DType rescale_grad, const OpReqType req) {
+    using nnvm::dim_t;
+    const dim_t row_offset = grad_idx[i] * row_length;
+    for (dim_t j = 0; j < row_length; j++) {
+      AdagradUpdateElem(row_offset + j, out_data, history_data, weight_data,
+                        grad_data[i * row_length + j], clip_gradient, lr, wd,
+                        epsilon, rescale_grad, req);
+    }
+  }
+};
+
+template<typename xpu>
+inline void AdagradUpdateDnsRspDnsImpl(const AdagradParam& param,
+                                       const OpContext& ctx,
+                                       const TBlob& weight,
+                                       const NDArray& grad,
+                                       const TBlob& history,
+                                       const OpReqType& req,
+                                       TBlob *out) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  if (!grad.storage_initialized() || req == kNullOp) return;
+  CHECK_EQ(req, kWriteInplace) << "kWriteInplace is expected for sparse adagrad_update";
+  CHECK_GT(weight.shape_.Size(), 0);
+  CHECK_GT(history.shape_.Size(), 0);
+  MSHADOW_REAL_TYPE_SWITCH(weight.type_flag_, DType, {
+    MSHADOW_IDX_TYPE_SWITCH(grad.aux_type(kIdx), IType, {
+      const nnvm::dim_t num_rows = grad.aux_shape(kIdx)[0];
+      const auto row_length = weight.shape_.ProdShape(1, weight.ndim());
+      Kernel<AdagradDnsRspDnsKernel, xpu>::Launch(s, num_rows, row_length,
+        out->dptr<DType>(), history.dptr<DType>(), weight.dptr<DType>(),
+        grad.aux_data(kIdx).dptr<IType>(), grad.data().dptr<DType>(),
+        static_cast<DType>(param.clip_gradient), static_cast<DType>(param.lr),
+        static_cast<DType>(param.wd), static_cast<DType>(param.epsilon),
+        static_cast<DType>(param.rescale_grad), req);
+    });
+  });
+}
+
+template<typename xpu>
+inline void AdagradUpdateEx(const nnvm::NodeAttrs& attrs,
+                            const OpContext &ctx,
+                            const std::vector<NDArray> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<NDArray> &outputs) {
+  const AdagradParam& param = nnvm::get<AdagradParam>(attrs.parsed);
+  const auto weight_stype = inputs[0].storage_type();
+  const auto grad_stype = inputs[1].storage_type();
+  const auto history_stype = inputs[2].storage_type();
+  const auto out_stype = outputs[0].storage_type();
+  CHECK_EQ(history_stype, weight_stype) << "Inconsistent storage type detected between "
+           << " history.stype = " << history_stype << " and weight.stype = " << weight_stype;
+  if (weight_stype == kRowSparseStorage && grad_stype == kRowSparseStorage &&
+      out_stype == kRowSparseStorage) {
+    CHECK_RSP_ALL_ROWS_NON_ZERO(inputs[0], "AdagradUpdate", "weights");
+    // fill history with zero values in order to reuse the dns rsp impl
+    if (!inputs[2].storage_initialized()) {
+      NDArray history_zeros = inputs[2];
+      FillDnsZerosRspImpl(ctx.get_stream<xpu>(), &history_zeros);
+    }
+    TBlob out_blob = outputs[0].data();
+    // reuse dns rsp implementation when storage_shape == shape
+    AdagradUpdateDnsRspDnsImpl<xpu>(param, ctx, inputs[0].data(), inputs[1],
+                                    inputs[2].data(), req[0], &out_blob);
+  } else if (weight_stype == kDefaultStorage && grad_stype == kRowSparseStorage &&
+             out_stype == kDefaultStorage) {
+    TBlob out_blob = outputs[0].data();
+    AdagradUpdateDnsRspDnsImpl<xpu>(param, ctx, inputs[0].data(), inputs[1],
+                                    inputs[2].data(), req[0], &out_blob);
+  } else {
+    LOG(FATAL) << "Unexpected storage types: weight.stype = " << weight_stype
+               << ", history.stype = " << history_stype
+               << ", grad.stype = " << grad_stype;
+  }
+}
+
+struct LARSParam : public dmlc::Parameter<LARSParam> {
+  float lr;
+  float momentum;
+  float eta;
+  float epsilon;
+  float wd;
+  float rescale_grad;
+  float clip_gradient;
+  DMLC_DECLARE_PARAMETER(LARSParam) {
+    DMLC_DECLARE_FIELD(lr)
+    .describe("Learning rate");
+    DMLC_DECLARE_FIELD(momentum)
+    .set_default(0.9f)
+    .describe("The decay rate of momentum estimates at each epoch.");
+    DMLC_DECLARE_FIELD(eta)
+    .set_default(0.001f)
+    .describe("The trust coefficient of the layer-wise learning rate.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-9f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(wd)
+    .set_default(0.0f)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+  }
+};
+
+struct LAMBParam : public dmlc::Parameter<LAMBParam> {
+  float lr;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float wd;
+  int t;
+  bool bias_correction;
+  float lower_bound;
+  float upper_bound;
+  float rescale_grad;
+  float clip_gradient;
+  DMLC_DECLARE_PARAMETER(LAMBParam) {
+    DMLC_DECLARE_FIELD(lr)
+    .describe("Learning rate");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-6f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(wd)
+    .set_default(0.0f)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(t)
+    .set_default(1)
+    .set_lower_bound(1)
+    .describe("Index of the update, for the bias correction of the moments.");
+    DMLC_DECLARE_FIELD(bias_correction)
+    .set_default(true)
+    .describe("Whether to correct the bias of the moment estimates.");
+    DMLC_DECLARE_FIELD(lower_bound)
+    .set_default(-1.0f)
+    .describe("Lower bound of the weight norm of the trust ratio, ignored if negative.");
+    DMLC_DECLARE_FIELD(upper_bound)
+    .set_default(-1.0f)
+    .describe("Upper bound of the weight norm of the trust ratio, ignored if negative.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+  }
+};
+
+/*!
+ * \brief Split of the n elements of a layer into the chunks whose partial
+ *  squared norms are reduced by one thread each. Element k of chunk i is
+ *  i * chunk_step + k * elem_step: the chunks are contiguous on cpu and
+ *  interleaved on gpu, where neighbouring threads read neighbouring elements.
+ */
+struct TrustRatioChunks {
+  int num_chunks;
+  int chunk_size;
+  int chunk_step;
+  int elem_step;
+};
+
+template<typename xpu>
+inline TrustRatioChunks GetTrustRatioChunks(int n);
+
+template<>
+inline TrustRatioChunks GetTrustRatioChunks<cpu>(int n) {
+  TrustRatioChunks c;
+  c.num_chunks = std::max(1, std::min(n / 1024,
+      4 * engine::OpenMP::Get()->GetRecommendedOMPThreadCount()));
+  c.chunk_size = (n + c.num_chunks - 1) / c.num_chunks;
+  c.chunk_step = c.chunk_size;
+  c.elem_step = 1;
+  return c;
+}
+
+template<>
+inline TrustRatioChunks GetTrustRatioChunks<gpu>(int n) {
+  TrustRatioChunks c;
+  c.num_chunks = std::max(1, std::min(n, 8192));
+  c.chunk_size = (n + c.num_chunks - 1) / c.num_chunks;
+  c.chunk_step = 1;
+  c.elem_step = c.num_chunks;
+  return c;
+}
+
+/*! \brief partial squared norms of the weight and of the clipped rescaled gradient */
+struct LARSNormKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, float* partial, const DType* weight,
+                                  const DType* grad, const int n, const TrustRatioChunks c,
+                                  const float rescale_grad, const float clip_gradient) {
+    float w_sum = 0.0f, g_sum = 0.0f;
+    for (int k = 0; k < c.chunk_size; ++k) {
+      const int j = i * c.chunk_step + k * c.elem_step;
+      if (j >= n) break;
+      const float w = static_cast<float>(weight[j]);
+      float g = rescale_grad * static_cast<float>(grad[j]);
+      if (clip_gradient >= 0.0f) g = mshadow_op::clip::Map(g, clip_gradient);
+      w_sum += w * w;
+      g_sum += g * g;
+    }
+    partial[2 * i] = w_sum;
+    partial[2 * i + 1] = g_sum;
+  }
+};
+
+/*! \brief layer-wise learning rate of LARS from the partial squared norms */
+struct LARSTrustRatioKernel {
+  MSHADOW_XINLINE static void Map(int i, float* ratio, const float* partial, const int num_chunks,
+                                  const float eta, const float wd, const float epsilon) {
+    float w_sum = 0.0f, g_sum = 0.0f;
+    for (int k = 0; k < num_chunks; ++k) {
+      w_sum += partial[2 * k];
+      g_sum += partial[2 * k + 1];
+    }
+    const float w_norm = sqrtf(w_sum);
+    const float g_norm = sqrtf(g_sum);
+    *ratio = (w_norm > 0.0f && g_norm > 0.0f) ?
+        eta * w_norm / (g_norm + wd * w_norm + epsilon) : 1.0f;
+  }
+};
+
+struct LARSUpdateKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, DType* mom, const DType* weight,
+                                  const DType* grad, const float* ratio, const float lr,
+                                  const float momentum, const float wd,
+                                  const float rescale_grad, const float clip_gradient,
+                                  const OpReqType req) {
+    const float w = static_cast<float>(weight[i]);
+    float g = rescale_grad * static_cast<float>(grad[i]);
+    if (clip_gradient >= 0.0f) g = mshadow_op::clip::Map(g, clip_gradient);
+    const float m = momentum * static_cast<float>(mom[i]) + lr * (*ratio) * (g + wd * w);
+    mom[i] = static_cast<DType>(m);
+    KERNEL_ASSIGN(out[i], req, static_cast<DType>(w - m));
+  }
+};
+
+/*!
+ * \brief LARS update of one layer: the norms of the weight and of the gradient
+ *  are reduced in one pass, turned into the layer-wise learning rate on the
+ *  device, and applied by the update kernel within the same operator.
+ */
+template<typename xpu>
+inline void LARSUpdate(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const LARSParam& param = nnvm::get<LARSParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  const int n = inputs[0].Size();
+  const TrustRatioChunks c = GetTrustRatioChunks<xpu>(n);
+  Tensor<xpu, 1, float> workspace = ctx.requested[0].get_space_typed<xpu, 1, float>(
+      Shape1(2 * c.num_chunks + 1), s);
+  float* ratio = workspace.dptr_ + 2 * c.num_chunks;
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    Kernel<LARSNormKernel, xpu>::Launch(s, c.num_chunks, workspace.dptr_,
+      inputs[0].dptr<DType>(), inputs[1].dptr<DType>(), n, c,
+      param.rescale_grad, param.clip_gradient);
+    Kernel<LARSTrustRatioKernel, xpu>::Launch(s, 1, ratio, workspace.dptr_, c.num_chunks,
+      param.eta, param.wd, param.epsilon);
+    Kernel<LARSUpdateKernel, xpu>::Launch(s, n, outputs[0].dptr<DType>(),
+      inputs[2].dptr<DType>(), inputs[0].dptr<DType>(), inputs[1].dptr<DType>(), ratio,
+      param.lr, param.momentum, param.wd, param.rescale_grad, param.clip_gradient, req[0]);
+  });
+}
+
+/*! \brief the LAMB update direction of one element from its updated moments */
+MSHADOW_XINLINE float LAMBDirection(const float mean, const float var, const float w,
+                                    const float beta1_correction, const float beta2_correction,
+                                    const float epsilon, const float wd) {
+  return (mean / beta1_correction) / (sqrtf(var / beta2_correction) + epsilon) + wd * w;
+}
+
+/*!
+ * \brief update the moments of LAMB, and reduce the partial squared norms of
+ *  the weight and of the update direction in the same pass
+ */
+struct LAMBMomentNormKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, float* partial, DType* mean, DType* var,
+                                  const DType* weight, const DType* grad, const int n,
+                                  const TrustRatioChunks c, const float beta1,
+                                  const float beta2, const float beta1_correction,
+                                  const float beta2_correction, const float epsilon,
+                                  const float wd, const float rescale_grad,
+                                  const float clip_gradient) {
+    float w_sum = 0.0f, r_sum = 0.0f;
+    for (int k = 0; k < c.chunk_size; ++k) {
+      const int j = i * c.chunk_step + k * c.elem_step;
+      if (j >= n) break;
+      const float w = static_cast<float>(weight[j]);
+      float g = rescale_grad * static_cast<float>(grad[j]);
+      if (clip_gradient >= 0.0f) g = mshadow_op::clip::Map(g, clip_gradient);
+      const float m = beta1 * static_cast<float>(mean[j]) + (1.0f - beta1) * g;
+      const float v = beta2 * static_cast<float>(var[j]) + (1.0f - beta2) * g * g;
+      mean[j] = static_cast<DType>(m);
+      var[j] = static_cast<DType>(v);
+      const float r = LAMBDirection(m, v, w, beta1_correction, beta2_correction, epsilon, wd);
+      w_sum += w * w;
+      r_sum += r * r;
+    }
+    partial[2 * i] = w_sum;
+    partial[2 * i + 1] = r_sum;
+  }
+};
+
+/*! \brief trust ratio of LAMB from the partial squared norms */
+struct LAMBTrustRatioKernel {
+  MSHADOW_XINLINE static void Map(int i, float* ratio, const float* partial, const int num_chunks,
+                                  const float lower_bound, const float upper_bound) {
+    float w_sum = 0.0f, r_sum = 0.0f;
+    for (int k = 0; k < num_chunks; ++k) {
+      w_sum += partial[2 * k];
+      r_sum += partial[2 * k + 1];
+    }
+    float w_norm = sqrtf(w_sum);
+    const float r_norm = sqrtf(r_sum);
+    if (lower_bound >= 0.0f && w_norm < lower_bound) w_norm = lower_bound;
+    if (upper_bound >= 0.0f && w_norm > upper_bound) w_norm = upper_bound;
+    *ratio = (w_norm > 0.0f && r_norm > 0.0f) ? w_norm / r_norm : 1.0f;
+  }
+};
+
+struct LAMBUpdateKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* mean, const DType* var,
+                                  const DType* weight, const float* ratio, const float lr,
+                                  const float beta1_correction, const float beta2_correction,
+                                  const float epsilon, const float wd, const OpReqType req) {
+    const float w = static_cast<float>(weight[i]);
+    const float r = LAMBDirection(static_cast<float>(mean[i]), static_cast<float>(var[i]), w,
+                                  beta1_correction, beta2_correction, epsilon, wd);
+    KERNEL_ASSIGN(out[i], req, static_cast<DType>(w - lr * (*ratio) * r));
+  }
+};
+
+/*!
+ * \brief LAMB update of one layer. The moments are updated in the pass that
+ *  reduces the norms of the weight and of the update direction, the direction
+ *  is recomputed from the moments by the update kernel instead of being stored.
+ */
+template<typename xpu>
+inline void LAMBUpdate(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const LAMBParam& param = nnvm::get<LAMBParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  const int n = inputs[0].Size();
+  const TrustRatioChunks c = GetTrustRatioChunks<xpu>(n);
+  const float beta1_correction = param.bias_correction ?
+      1.0f - std::pow(param.beta1, static_cast<float>(param.t)) : 1.0f;
+  const float beta2_correction = param.bias_correction ?
+      1.0f - std::pow(param.beta2, static_cast<float>(param.t)) : 1.0f;
+  Tensor<xpu, 1, float> workspace = ctx.requested[0].get_space_typed<xpu, 1, float>(
+      Shape1(2 * c.num_chunks + 1), s);
+  float* ratio = workspace.dptr_ + 2 * c.num_chunks;
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    Kernel<LAMBMomentNormKernel, xpu>::Launch(s, c.num_chunks, workspace.dptr_,
+      inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), inputs[0].dptr<DType>(),
+      inputs[1].dptr<DType>(), n, c, param.beta1, param.beta2, beta1_correction,
+      beta2_correction, param.epsilon, param.wd, param.rescale_grad, param.clip_gradient);
+    Kernel<LAMBTrustRatioKernel, xpu>::Launch(s, 1, ratio, workspace.dptr_, c.num_chunks,
+      param.lower_bound, param.upper_bound);
+    Kernel<LAMBUpdateKernel, xpu>::Launch(s, n, outputs[0].dptr<DType>(),
+      inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), inputs[0].dptr<DType>(), ratio,
+      param.lr, beta1_correction, beta2_correction, param.epsilon, param.wd, req[0]);
+  });
+}
+
 // This RMSProp code follows the version in
 // http://arxiv.org/pdf/1308.0850v5.pdf Eq(38) - Eq(45)
 // by Alex Graves, 2013.
@@ -23,6 +23,8 @@
  * \author Junyuan Xie
  */
 #include "./optimizer_op-inl.h"
+#include <string>
+#include <vector>
 
 namespace mxnet {
 namespace op {
@@ -30,8 +32,15 @@ namespace op {
 DMLC_REGISTER_PARAMETER(SGDParam);
 DMLC_REGISTER_PARAMETER(SGDMomParam);
 DMLC_REGISTER_PARAMETER(AdamParam);
+DMLC_REGISTER_PARAMETER(LARSParam);
+DMLC_REGISTER_PARAMETER(LAMBParam);
 DMLC_REGISTER_PARAMETER(RMSPropParam);
 DMLC_REGISTER_PARAMETER(RMSPropAlexParam);
+DMLC_REGISTER_PARAMETER(FtrlParam);
+DMLC_REGISTER_PARAMETER(AdagradParam);
+DMLC_REGISTER_PARAMETER(MultiSGDParam);
+DMLC_REGISTER_PARAMETER(MultiSGDMomParam);
+DMLC_REGISTER_PARAMETER(MultiAllFiniteParam);
 
 NNVM_REGISTER_OP(sgd_update)
 .describe(R"code(Update function for Stochastic Gradient Descent (SDG) optimizer.
@@ -42,6 +51,8 @@ It updates the weights using::
 
 If weight is stored with `row_sparse` storage type,
 only the row slices whose indices appear in grad.indices are updated.
+The same holds for a default weight with a `row_sparse` gradient when
+``lazy_update`` is true, and the weight decay is then applied to those rows only.
 
 )code" ADD_FILELINE)
 .set_num_inputs(2)
@@ -76,6 +87,8 @@ Where the parameter ``momentum`` is the decay rate of momentum estimates at each
 
 If weights are stored with `row_sparse` storage type,
 only the row slices whose indices appear in grad.indices are updated (for both weight and momentum).
+The same holds for a default weight and momentum with a `row_sparse` gradient when
+``lazy_update`` is true, and the weight decay is then applied to those rows only.
 
 )code" ADD_FILELINE)
 .set_num_inputs(3)
@@ -129,6 +142,134 @@ NNVM_REGISTER_OP(mp_sgd_mom_update)
 .add_argument("weight32", "NDArray-or-Symbol", "Weight32")
 .add_arguments(SGDMomParam::__FIELDS__());
 
+/*!
+ * \brief names of the inputs of the multi-tensor sgd updates, the arrays of
+ *  every weight in the order of input_names
+ */
+template<typename ParamType>
+inline std::vector<std::string> MultiSGDInputNames(const nnvm::NodeAttrs& attrs,
+                                                   const std::vector<std::string>& input_names) {
+  const ParamType& param = nnvm::get<ParamType>(attrs.parsed);
+  std::vector<std::string> names;
+  for (int i = 0; i < param.num_weights; ++i) {
+    for (const std::string& name : input_names) {
+      names.push_back(name + "_" + std::to_string(i));
+    }
+  }
+  return names;
+}
+
+/*! \brief indices of the states of the multi-tensor sgd updates, the inputs after the grad */
+template<typename ParamType, int input_stride>
+inline std::vector<uint32_t> MultiSGDMutateInputs(const nnvm::NodeAttrs& attrs) {
+  const ParamType& param = nnvm::get<ParamType>(attrs.parsed);
+  std::vector<uint32_t> ret;
+  for (int i = 0; i < param.num_weights; ++i) {
+    for (int j = 2; j < input_stride; ++j) {
+      ret.push_back(static_cast<uint32_t>(i * input_stride + j));
+    }
+  }
+  return ret;
+}
+
+#define MXNET_REGISTER_MULTI_SGD(name, ParamType, has_mom, has_mp, ...)              \
+  NNVM_REGISTER_OP(name)                                                              \
+  .set_num_inputs([](const nnvm::NodeAttrs& attrs) {                                 \
+      return static_cast<uint32_t>(nnvm::get<ParamType>(attrs.parsed).num_weights     \
+                                   * (2 + has_mom + has_mp));                         \
+    })                                                                                \
+  .set_num_outputs([](const nnvm::NodeAttrs& attrs) {                                \
+      return static_cast<uint32_t>(nnvm::get<ParamType>(attrs.parsed).num_weights);   \
+    })                                                                                \
+  .set_attr_parser(ParamParser<ParamType>)                                            \
+  .set_attr<nnvm::FListInputNames>("FListInputNames",                                 \
+    [](const nnvm::NodeAttrs& attrs) {                                                \
+      return MultiSGDInputNames<ParamType>(attrs, {__VA_ARGS__});                     \
+    })                                                                                \
+  .set_attr<nnvm::FInferShape>("FInferShape",                                         \
+                               MultiSGDShape<ParamType, 2 + has_mom + has_mp>)        \
+  .set_attr<nnvm::FInferType>("FInferType",                                           \
+                              MultiSGDType<ParamType, 2 + has_mom + has_mp,           \
+                                           has_mp ? 1 + has_mom : 0>)                 \
+  .set_attr<nnvm::FMutateInputs>("FMutateInputs",                                     \
+                                 MultiSGDMutateInputs<ParamType, 2 + has_mom + has_mp>) \
+  .set_attr<FCompute>("FCompute<cpu>",                                                \
+                      MultiSGDUpdate<cpu, ParamType, has_mom, has_mp>)                \
+  .add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and states")       \
+  .add_arguments(ParamType::__FIELDS__())
+
+MXNET_REGISTER_MULTI_SGD(multi_sgd_update, MultiSGDParam, false, false, "weight", "grad")
+.describe(R"code(Update function for Stochastic Gradient Descent (SDG) optimizer on
+several weights with one kernel launch.
+
+It updates every weight i of the list weight_0, grad_0, weight_1, grad_1, ... by::
+
+  weight_i = weight_i - lrs[i] * (gradient_i + wds[i] * weight_i)
+
+The tensors are processed as one concatenated array, so the updates of many small
+weights cost one operator and one kernel launch instead of one per weight.
+
+)code" ADD_FILELINE);
+
+MXNET_REGISTER_MULTI_SGD(multi_sgd_mom_update, MultiSGDMomParam, true, false,
+                         "weight", "grad", "mom")
+.describe(R"code(Momentum update function for Stochastic Gradient Descent (SGD)
+optimizer on several weights with one kernel launch.
+
+It updates every weight i of the list weight_0, grad_0, mom_0, weight_1, ... by::
+
+  mom_i = momentum * mom_i - lrs[i] * (gradient_i + wds[i] * weight_i)
+  weight_i = weight_i + mom_i
+
+)code" ADD_FILELINE);
+
+MXNET_REGISTER_MULTI_SGD(multi_mp_sgd_update, MultiSGDParam, false, true,
+                         "weight", "grad", "weight32")
+.describe(R"code(Updater function for multi-precision sgd optimizer on several
+weights with one kernel launch, the float32 weights weight32_i are updated and
+cast to the weights.
+
+)code" ADD_FILELINE);
+
+MXNET_REGISTER_MULTI_SGD(multi_mp_sgd_mom_update, MultiSGDMomParam, true, true,
+                         "weight", "grad", "mom", "weight32")
+.describe(R"code(Momentum updater function for multi-precision sgd optimizer on
+several weights with one kernel launch, the momentums and the float32 weights are
+updated in float32.
+
+)code" ADD_FILELINE);
+
+NNVM_REGISTER_OP(multi_all_finite)
+.describe(R"code(Check whether all the values of the arrays are finite.
+
+The output is a single float32 value, 1 if no array holds an infinity or a NaN and
+0 otherwise. With dynamic loss scaling of float16 training, the loss is multiplied
+by a large scale before the backward pass and the gradients are divided by it in
+the update, the steps whose gradients overflow are skipped and the scale reduced.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+    const MultiAllFiniteParam& param = nnvm::get<MultiAllFiniteParam>(attrs.parsed);
+    return static_cast<uint32_t>(param.num_arrays);
+  })
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<MultiAllFiniteParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const nnvm::NodeAttrs& attrs) {
+    const MultiAllFiniteParam& param = nnvm::get<MultiAllFiniteParam>(attrs.parsed);
+    std::vector<std::string> names;
+    for (int i = 0; i < param.num_arrays; ++i) {
+      names.push_back("array_" + std::to_string(i));
+    }
+    return names;
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", MultiAllFiniteShape)
+.set_attr<nnvm::FInferType>("FInferType", MultiAllFiniteType)
+.set_attr<FCompute>("FCompute<cpu>", MultiAllFiniteUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Arrays")
+.set_key_var_num_args("num_arrays")
+.add_arguments(MultiAllFiniteParam::__FIELDS__());
+
 NNVM_REGISTER_OP(adam_update)
 .describe(R"code(Update function for Adam optimizer. Adam is seen as a generalization
 of AdaGrad.
@@ -149,6 +290,11 @@ It updates the weights using::
  v = beta2*v + (1-beta2)*(grad**2)
  w += - learning_rate * m / (sqrt(v) + epsilon)
 
+If w, m and v are stored with `row_sparse` storage type, or they are stored with the
+default storage type, the gradient is `row_sparse` and ``lazy_update`` is true,
+only the row slices whose indices appear in grad.indices are updated (for w, m and v),
+and the weight decay is applied to those rows only.
+
 )code" ADD_FILELINE)
 .set_num_inputs(4)
 .set_num_outputs(1)
@@ -168,6 +314,77 @@ It updates the weights using::
 .add_arguments(AdamParam::__FIELDS__());
 
 
+NNVM_REGISTER_OP(lars_update)
+.describe(R"code(Update function for the LARS optimizer, momentum SGD with a layer-wise
+learning rate for large batch training.
+
+It updates the weights using::
+
+ g = rescale_grad * clip(grad, clip_gradient)
+ local_lr = eta * norm(w) / (norm(g) + wd * norm(w) + epsilon)
+ mom = momentum * mom + lr * local_lr * (g + wd * w)
+ w = w - mom
+
+local_lr is 1 if the norm of w or g is 0. The norms are reduced and the weights
+updated within the operator, without synchronizing with the host.
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<LARSParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<3, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 1>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{2};
+  })
+.set_attr<FCompute>("FCompute<cpu>", LARSUpdate<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "Weight")
+.add_argument("grad", "NDArray-or-Symbol", "Gradient")
+.add_argument("mom", "NDArray-or-Symbol", "Momentum")
+.add_arguments(LARSParam::__FIELDS__());
+
+NNVM_REGISTER_OP(lamb_update)
+.describe(R"code(Update function for the LAMB optimizer, Adam with a layer-wise trust
+ratio for large batch training.
+
+It updates the weights using::
+
+ g = rescale_grad * clip(grad, clip_gradient)
+ m = beta1 * m + (1 - beta1) * g
+ v = beta2 * v + (1 - beta2) * g^2
+ r = (m / (1 - beta1^t)) / (sqrt(v / (1 - beta2^t)) + epsilon) + wd * w
+ w = w - lr * norm(w) / norm(r) * r
+
+The bias corrections are skipped if ``bias_correction`` is false, and norm(w) is
+clipped to ``[lower_bound, upper_bound]`` when they are given. The moments and
+both norms are computed in one pass over the layer.
+
+)code" ADD_FILELINE)
+.set_num_inputs(4)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<LAMBParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<4, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<4, 1>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{2, 3};
+  })
+.set_attr<FCompute>("FCompute<cpu>", LAMBUpdate<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "Weight")
+.add_argument("grad", "NDArray-or-Symbol", "Gradient")
+.add_argument("mean", "NDArray-or-Symbol", "Moving mean")
+.add_argument("var", "NDArray-or-Symbol", "Moving variance")
+.add_arguments(LAMBParam::__FIELDS__());
+
 NNVM_REGISTER_OP(rmsprop_update)
 .describe(R"code(Update function for `RMSProp` optimizer.
 
@@ -259,5 +476,72 @@ to be 0.9 and the learning rate :math:`\eta` to be 0.0001.
 .add_argument("delta", "NDArray-or-Symbol", "delta")
 .add_arguments(RMSPropAlexParam::__FIELDS__());
 
+
+NNVM_REGISTER_OP(ftrl_update)
+.describe(R"code(Update function for Ftrl optimizer.
+Referenced from *Ad Click Prediction: a View from the Trenches*, available at
+http://dl.acm.org/citation.cfm?id=2488200.
+
+It updates the weights using::
+
+ rescaled_grad = clip(grad * rescale_grad, clip_gradient)
+ z += rescaled_grad - (sqrt(n + rescaled_grad**2) - sqrt(n)) * weight / learning_rate
+ n += rescaled_grad**2
+ w = (sign(z) * lamda1 - z) / ((beta + sqrt(n)) / learning_rate + wd) * (abs(z) > lamda1)
+
+If the gradient is stored with `row_sparse` storage type, only the row slices whose
+indices appear in grad.indices are updated (for w, z and n).
+
+)code" ADD_FILELINE)
+.set_num_inputs(4)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<FtrlParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<4, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<4, 1>)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{2, 3};
+  })
+.set_attr<FCompute>("FCompute<cpu>", FtrlUpdate<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", FtrlUpdateEx<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "Weight")
+.add_argument("grad", "NDArray-or-Symbol", "Gradient")
+.add_argument("z", "NDArray-or-Symbol", "z")
+.add_argument("n", "NDArray-or-Symbol", "Square of grad")
+.add_arguments(FtrlParam::__FIELDS__());
+
+NNVM_REGISTER_OP(adagrad_update)
+.describe(R"code(Update function for AdaGrad optimizer.
+
+Referenced from *Adaptive Subgradient Methods for Online Learning and Stochastic Optimization*,
+and available at http://www.jmlr.org/papers/volume12/duchi11a/duchi11a.pdf.
+
+It updates the weights using::
+
+ rescaled_grad = clip(grad * rescale_grad, clip_gradient)
+ history += rescaled_grad**2
+ w -= learning_rate * (rescaled_grad / sqrt(history + epsilon) + wd * w)
+
+If the gradient is stored with `row_sparse` storage type, only the row slices whose
+indices appear in grad.indices are updated (for w and history), and the weight decay
+is applied to those rows only.
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<AdagradParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<3, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 1>)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{2};
+  })
+.set_attr<FCompute>("FCompute<cpu>", AdagradUpdate<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", AdagradUpdateEx<cpu>)
+.add_argument("weight", "NDArray-or-Symbol", "Weight")
+.add_argument("grad", "NDArray-or-Symbol", "Gradient")
+.add_argument("history", "NDArray-or-Symbol", "History")
+.add_arguments(AdagradParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
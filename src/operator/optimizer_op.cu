@@ -41,15 +41,44 @@ NNVM_REGISTER_OP(mp_sgd_update)
 NNVM_REGISTER_OP(mp_sgd_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", MP_SGDMomUpdate<gpu>);
 
+NNVM_REGISTER_OP(multi_sgd_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, MultiSGDParam, false, false>);
+
+NNVM_REGISTER_OP(multi_sgd_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, MultiSGDMomParam, true, false>);
+
+NNVM_REGISTER_OP(multi_mp_sgd_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, MultiSGDParam, false, true>);
+
+NNVM_REGISTER_OP(multi_mp_sgd_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, MultiSGDMomParam, true, true>);
+
+NNVM_REGISTER_OP(multi_all_finite)
+.set_attr<FCompute>("FCompute<gpu>", MultiAllFiniteUpdate<gpu>);
+
 NNVM_REGISTER_OP(adam_update)
 .set_attr<FCompute>("FCompute<gpu>", AdamUpdate<gpu>)
 .set_attr<FComputeEx>("FComputeEx<gpu>", AdamUpdateEx<gpu>);
 
+NNVM_REGISTER_OP(lars_update)
+.set_attr<FCompute>("FCompute<gpu>", LARSUpdate<gpu>);
+
+NNVM_REGISTER_OP(lamb_update)
+.set_attr<FCompute>("FCompute<gpu>", LAMBUpdate<gpu>);
+
 NNVM_REGISTER_OP(rmsprop_update)
 .set_attr<FCompute>("FCompute<gpu>", RMSPropUpdate<gpu>);
 
 NNVM_REGISTER_OP(rmspropalex_update)
 .set_attr<FCompute>("FCompute<gpu>", RMSPropAlexUpdate<gpu>);
 
+NNVM_REGISTER_OP(ftrl_update)
+.set_attr<FCompute>("FCompute<gpu>", FtrlUpdate<gpu>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", FtrlUpdateEx<gpu>);
+
+NNVM_REGISTER_OP(adagrad_update)
+.set_attr<FCompute>("FCompute<gpu>", AdagradUpdate<gpu>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", AdagradUpdateEx<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
@@ -28,6 +28,7 @@
 
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
+#include <dmlc/optional.h>
 #include <mxnet/operator.h>
 #include <algorithm>
 #include <map>
@@ -48,6 +49,7 @@ struct PoolingParam : public dmlc::Parameter<PoolingParam> {
   int pooling_convention;
   bool global_pool;
   bool cudnn_off;
+  dmlc::optional<int> layout;
   DMLC_DECLARE_PARAMETER(PoolingParam) {
     DMLC_DECLARE_FIELD(global_pool).set_default(false)
     .describe("Ignore kernel size, do global pooling based on current input feature map. ");
@@ -76,6 +78,16 @@ struct PoolingParam : public dmlc::Parameter<PoolingParam> {
 
     DMLC_DECLARE_FIELD(pad).set_default(TShape())
     .describe("pad for pooling: (y, x) or (d, y, x)");
+
+    DMLC_DECLARE_FIELD(layout)
+    .add_enum("NCW", mshadow::kNCW)
+    .add_enum("NCHW", mshadow::kNCHW)
+    .add_enum("NCDHW", mshadow::kNCDHW)
+    .add_enum("NHWC", mshadow::kNHWC)
+    .set_default(dmlc::optional<int>())
+    .describe("Set layout for input and output. Empty for\n    "
+              "default layout: NCW for 1d, NCHW for 2d and NCDHW for 3d. "
+              "NHWC is only supported by cuDNN.");
   }
 };
 
@@ -156,16 +168,24 @@ class PoolingProp : public OperatorProperty {
     using namespace mshadow;
     param_.Init(kwargs);
     if (param_.kernel.ndim() == 1) {
+      param_.layout = param_.layout ? param_.layout.value() : mshadow::kNCW;
       if (param_.stride.ndim() == 0) param_.stride = Shape1(1);
       if (param_.pad.ndim() == 0) param_.pad = Shape1(0);
     } else if (param_.kernel.ndim() == 2) {
+      param_.layout = param_.layout ? param_.layout.value() : mshadow::kNCHW;
       if (param_.stride.ndim() == 0) param_.stride = Shape2(1, 1);
       if (param_.pad.ndim() == 0) param_.pad = Shape2(0, 0);
     } else {
       CHECK_EQ(param_.kernel.ndim(), 3U) << param_.kernel.ndim() << "D pooling not supported";
+      param_.layout = param_.layout ? param_.layout.value() : mshadow::kNCDHW;
       if (param_.stride.ndim() == 0) param_.stride = Shape3(1, 1, 1);
       if (param_.pad.ndim() == 0) param_.pad = Shape3(0, 0, 0);
     }
+    const int layout = param_.layout.value();
+    CHECK(param_.kernel.ndim() == 1 ? layout == mshadow::kNCW :
+          param_.kernel.ndim() == 2 ? layout == mshadow::kNCHW || layout == mshadow::kNHWC :
+          layout == mshadow::kNCDHW)
+      << "Pooling: the layout does not match the " << param_.kernel.ndim() << "D kernel";
     CHECK_EQ(param_.stride.ndim(), param_.kernel.ndim())
       << "stride and kernel should have the same length";
     CHECK_EQ(param_.pad.ndim(), param_.kernel.ndim())
@@ -186,6 +206,18 @@ class PoolingProp : public OperatorProperty {
                                 << " Or 5D in (batch, channel, d, y, x)";
     TShape oshape = dshape;
     if (dshape.ndim() ==  0) return false;
+    if (param_.layout.value() == mshadow::kNHWC) {
+      // the shapes are inferred in NCHW
+      CHECK_EQ(dshape.ndim(), 4U) << "Pooling: Input data should be 4D in (batch, y, x, channel)";
+      PoolingProp nchw;
+      nchw.param_ = param_;
+      nchw.param_.layout = mshadow::kNCHW;
+      std::vector<TShape> nchw_shape{
+        ConvertLayout(dshape.get<4>(), mshadow::kNHWC, mshadow::kNCHW)};
+      nchw.InferShape(&nchw_shape, out_shape, aux_shape);
+      (*out_shape)[0] = ConvertLayout((*out_shape)[0].get<4>(), mshadow::kNCHW, mshadow::kNHWC);
+      return true;
+    }
     if (param_.kernel.ndim() == 1) {
       CHECK_EQ(dshape.ndim(), 3U) << "Pooling: Input data should be 3D in (batch, channel, x)";
       if (param_.global_pool) {
@@ -38,6 +38,8 @@ namespace op {
 template<>
 Operator *CreateOp<cpu>(PoolingParam param, int dtype) {
   Operator *op = NULL;
+  CHECK(!param.layout || param.layout.value() != mshadow::kNHWC)
+    << "Pooling: NHWC layout is only supported by cuDNN";
   // TODO(lingyan): kFull use exclude padding algorithm now
 #if MXNET_USE_MKL2017 == 1
     if (param.kernel.ndim() == 2
@@ -52,6 +52,8 @@ Operator *CreateOp<gpu>(PoolingParam param, int dtype) {
   }
   if (op) return op;
 #endif  // MXNET_USE_CUDNN
+  CHECK(!param.layout || param.layout.value() != mshadow::kNHWC)
+    << "Pooling: NHWC layout is only supported by cuDNN";
   MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
     if (pool_enum::kMaxPooling == param.pool_type
         || pool_enum::kAvgPooling == param.pool_type
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file multisample_op.cu
+ * \brief GPU-implementation of multi-sampling operators
+ */
+#include "./multisample_op.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(sample_uniform)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, UniformSampler>);
+
+NNVM_REGISTER_OP(sample_normal)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, NormalSampler>);
+
+NNVM_REGISTER_OP(sample_gamma)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, GammaSampler>);
+
+NNVM_REGISTER_OP(sample_exponential)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, ExponentialSampler>);
+
+NNVM_REGISTER_OP(sample_poisson)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, PoissonSampler>);
+
+NNVM_REGISTER_OP(sample_negative_binomial)
+.set_attr<FCompute>("FCompute<gpu>", MultiSampleOpForward<gpu, NegativeBinomialSampler>);
+
+NNVM_REGISTER_OP(sample_generalized_negative_binomial)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiSampleOpForward<gpu, GeneralizedNegativeBinomialSampler>);
+
+}  // namespace op
+}  // namespace mxnet
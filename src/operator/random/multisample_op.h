@@ -30,6 +30,7 @@
 #include "../mxnet_op.h"
 #include "../operator_common.h"
 #include "../elemwise_op_common.h"
+#include "../../common/random_generator.h"
 
 namespace mxnet {
 namespace op {
@@ -133,7 +134,83 @@ inline bool MultiSampleOpType(const nnvm::NodeAttrs& attrs,
 }
 
 
-template<typename xpu, typename generator>
+/*!
+ * \brief samplers of the distributions, drawing one number from the subsequence
+ *  of an output element for the parameters of its distribution.
+ */
+struct UniformSampler {
+  MSHADOW_XINLINE static float Sample(float low, float high,
+                                      common::random::PhiloxSequence* seq) {
+    return low + (high - low) * seq->Uniform();
+  }
+};
+
+struct NormalSampler {
+  MSHADOW_XINLINE static float Sample(float mu, float sigma,
+                                      common::random::PhiloxSequence* seq) {
+    return mu + sigma * seq->Normal();
+  }
+};
+
+struct GammaSampler {
+  MSHADOW_XINLINE static float Sample(float alpha, float beta,
+                                      common::random::PhiloxSequence* seq) {
+    return beta * seq->Gamma(alpha);
+  }
+};
+
+struct ExponentialSampler {
+  MSHADOW_XINLINE static float Sample(float lambda, float,
+                                      common::random::PhiloxSequence* seq) {
+    return -logf(seq->UniformPositive()) / lambda;
+  }
+};
+
+struct PoissonSampler {
+  MSHADOW_XINLINE static float Sample(float lambda, float,
+                                      common::random::PhiloxSequence* seq) {
+    return seq->Poisson(lambda);
+  }
+};
+
+// Negative binomial distribution as defined in C++ standard library, drawn
+// as the mixture Poisson(Gamma(k, (1-p)/p))
+struct NegativeBinomialSampler {
+  MSHADOW_XINLINE static float Sample(float k, float p,
+                                      common::random::PhiloxSequence* seq) {
+    return seq->Poisson(seq->Gamma(k) * (1.0f - p) / p);
+  }
+};
+
+// Generalized form of the negative binomial distribution which is generated by
+// a poisson-gamma mixture: X ~ NegBin(mu, alpha) corresponds to
+// X ~ Poisson(Gamma(1/alpha,mu*alpha)). We allow the boundary case alpha = 0
+// where the negative binomial equals the Poisson distribution.
+struct GeneralizedNegativeBinomialSampler {
+  MSHADOW_XINLINE static float Sample(float mu, float alpha,
+                                      common::random::PhiloxSequence* seq) {
+    return seq->Poisson(alpha == 0.0f ? mu : seq->Gamma(1.0f / alpha) * mu * alpha);
+  }
+};
+
+/*!
+ * \brief element i of the N x M output is drawn from the distribution i / M,
+ *  so all the samples are computed in parallel and do not depend on the
+ *  number of threads.
+ */
+template<typename sampler, int req>
+struct MultiSampleKernel {
+  template<typename IType, typename OType>
+  MSHADOW_XINLINE static void Map(int i, int M, const IType* in1, const IType* in2,
+                                  OType* out, common::random::PhiloxStream rnd) {
+    common::random::PhiloxSequence seq(rnd, i);
+    const float sample = sampler::Sample(static_cast<float>(in1[i / M]),
+                                         static_cast<float>(in2[i / M]), &seq);
+    KERNEL_ASSIGN(out[i], req, OType(sample));
+  }
+};
+
+template<typename xpu, typename sampler>
 void MultiSampleOpForward(const nnvm::NodeAttrs& attrs,
                        const OpContext& ctx,
                        const std::vector<TBlob>& inputs,
@@ -145,7 +222,6 @@ void MultiSampleOpForward(const nnvm::NodeAttrs& attrs,
   CHECK_EQ(outputs.size(), 1);
   CHECK_EQ(req.size(), 1);
   using namespace mxnet_op;
-  const MultiSampleParam& param = nnvm::get<MultiSampleParam>(attrs.parsed);
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   const TBlob& in0 = inputs[0];
   const TBlob& in1 = (inputs.size() == 1 ? inputs[0] : inputs[1]);
@@ -158,32 +234,15 @@ void MultiSampleOpForward(const nnvm::NodeAttrs& attrs,
   CHECK_EQ(out.Size() % in0.Size(), 0);
   const int N(in0.Size()), M(out.Size()/in0.Size());
 
-  // Seed for the sampling process. In order to guarantee deterministic
-  // behaviour for single threaded cpu, this is taken from mshadow random generator.
-  const int seed(ctx.requested[0].get_random<xpu, float>(s)->GetRandInt());
+  // Every sample takes its own subsequence of the parallel random resource, two
+  // distributions with the same parameters still give different samples.
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(N * M);
 
   MSHADOW_TYPE_SWITCH(in0.type_flag_, IType, {
     MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, OType, {
       MXNET_ASSIGN_REQ_SWITCH(req[0], req_type, {
-        // Get the output as a 2D-tensor with dimensions NxM
-        Tensor<xpu, 2, OType> samples = out.get_with_shape<xpu, 2, OType>(Shape2(N, M), s);
-        const IType *iptr1 = in0.dptr<IType>(), *iptr2 = in1.dptr<IType>();
-
-        // The seeds for the different generators are itself a random sequence. We don't
-        // want to create the same samples in case that we have two samplers with same
-        // input parameters.
-        std::mt19937 seed_generator(seed);
-        for (int i = 0; i < N; ++i) {
-          // Generate seed for this sampler. Must be mutexed as calling
-          // a random generator is not thread safe.
-          int seed = seed_generator();
-          typename generator::template Sampler<OType> sampler(iptr1[i], iptr2[i], seed);
-          // Get the sub-tensor that will hold the results of this sampler.
-          Tensor<xpu, 1, OType> slice = samples.Slice(i, i+1).FlatTo1D();
-          for (int j = 0; j < M; ++j) {
-            KERNEL_ASSIGN(slice[j], req_type, sampler());
-          }
-        }
+        Kernel<MultiSampleKernel<sampler, req_type>, xpu>::Launch(
+          s, N * M, M, in0.dptr<IType>(), in1.dptr<IType>(), out.dptr<OType>(), rnd);
       });
     });
   });
@@ -30,6 +30,7 @@
 #include "../mxnet_op.h"
 #include "../operator_common.h"
 #include "../elemwise_op_common.h"
+#include "../../common/random_generator.h"
 
 namespace mxnet {
 namespace op {
@@ -107,29 +108,62 @@ inline bool SampleMultinomialOpType(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+/*!
+ * \brief the distributions with more outcomes than this draw their samples by
+ *  a binary search in their cumulative sums instead of a linear scan.
+ */
+const index_t kMultinomialLinearMax = 32;
+
+/*! \brief cumulative sums of the probabilities of distribution i */
+struct MultinomialCdfKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, index_t K, const DType* dist, DType* cdf) {
+    DType acc = 0;
+    for (index_t k = 0; k < K; ++k) {
+      acc += dist[i*K + k];
+      cdf[i*K + k] = acc;
+    }
+  }
+};
+
+/*!
+ * \brief sample i of the N x M output, drawn from distribution i / M with the
+ *  uniform number of the counter i. The outcome is the first one whose
+ *  cumulative probability exceeds the uniform number, found by a binary
+ *  search when the cumulative sums are given.
+ */
 struct SampleMultinomialKernel {
   template<typename DType, typename IType>
   MSHADOW_XINLINE static void Map(int i, index_t K, index_t M,
-                                  DType* dist, float* uniform, IType* out,
+                                  const DType* dist, const DType* cdf,
+                                  common::random::PhiloxStream rnd, IType* out,
                                   DType* prob) {
-    for (index_t j = 0; j < M; ++j) {
-      DType loc = static_cast<DType>(uniform[i*M + j]);
+    const index_t row = i / M;
+    const DType loc = static_cast<DType>(rnd.Uniform(i));
+    index_t k = K - 1;
+    if (cdf != nullptr) {
+      index_t lo = 0;
+      const DType* sums = cdf + row*K;
+      while (lo < k) {
+        const index_t mid = (lo + k) / 2;
+        if (sums[mid] > loc) {
+          k = mid;
+        } else {
+          lo = mid + 1;
+        }
+      }
+    } else {
       DType acc = 0;
-      bool found = false;
-      for (index_t k = 0; k < K; ++k) {
-        acc += dist[i*K + k];
+      for (index_t j = 0; j < K; ++j) {
+        acc += dist[row*K + j];
         if (acc > loc) {
-          found = true;
-          out[i*M + j] = static_cast<IType>(k);
-          if (prob != nullptr) prob[i*M + j] = logf(dist[i*K + k]);
+          k = j;
           break;
         }
       }
-      if (!found) {
-        out[i*M + j] = static_cast<IType>(K-1);
-        if (prob != nullptr) prob[i*M + j] = logf(dist[i*K + K - 1]);
-      }
     }
+    out[i] = static_cast<IType>(k);
+    if (prob != nullptr) prob[i] = logf(dist[row*K + k]);
   }
 };
 
@@ -149,13 +183,15 @@ void SampleMultinomialForward(const nnvm::NodeAttrs& attrs,
   index_t M = outputs[0].Size()/N;
 
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(N*M);
   MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
-    Random<xpu, float> *prnd = ctx.requested[0].get_random<xpu, float>(s);
-    Tensor<xpu, 1, float> uniform =
-      ctx.requested[1].get_space_typed<xpu, 1, float>(Shape1(N*M), s);
-    prnd->SampleUniform(&uniform, 0, 1);
+    DType* cdf = nullptr;
+    if (K > kMultinomialLinearMax) {
+      cdf = ctx.requested[1].get_space_typed<xpu, 1, DType>(Shape1(N*K), s).dptr_;
+      Kernel<MultinomialCdfKernel, xpu>::Launch(s, N, K, inputs[0].dptr<DType>(), cdf);
+    }
     Kernel<SampleMultinomialKernel, xpu>::Launch(
-      s, N, K, M, inputs[0].dptr<DType>(), uniform.dptr_, outputs[0].dptr<int>(),
+      s, N*M, K, M, inputs[0].dptr<DType>(), cdf, rnd, outputs[0].dptr<int>(),
       param.get_prob ? outputs[1].dptr<DType>() : nullptr);
   });
 }
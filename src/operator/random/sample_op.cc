@@ -34,18 +34,18 @@ DMLC_REGISTER_PARAMETER(SamplePoissonParam);
 DMLC_REGISTER_PARAMETER(SampleNegBinomialParam);
 DMLC_REGISTER_PARAMETER(SampleGenNegBinomialParam);
 
-#define MXNET_OPERATOR_REGISTER_SAMPLE(name, ParamType)                 \
+#define MXNET_OPERATOR_REGISTER_SAMPLE(name, ParamType, resource)       \
   NNVM_REGISTER_OP(name)                                                \
   .set_num_inputs(0)                                                    \
   .set_num_outputs(1)                                                   \
   .set_attr_parser(ParamParser<ParamType>)                              \
   .set_attr<nnvm::FInferShape>("FInferShape", InitShape<ParamType>)     \
   .set_attr<nnvm::FInferType>("FInferType", SampleOpType<ParamType>)    \
-  .set_attr<FResourceRequest>("FResourceRequest", SampleResource)       \
+  .set_attr<FResourceRequest>("FResourceRequest", resource)             \
   .add_arguments(ParamType::__FIELDS__())
 
 // Add "uniform" alias for backward compatibility
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_uniform, SampleUniformParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_uniform, SampleUniformParam, SampleParallelResource)
 .add_alias("uniform")
 .add_alias("_sample_uniform")
 .add_alias("random_uniform")
@@ -66,7 +66,7 @@ Example::
 .set_attr<FComputeEx>("FComputeEx<cpu>", SampleUniformEx_<cpu>);
 
 // Add "normal" alias for backward compatibility
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_normal, SampleNormalParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_normal, SampleNormalParam, SampleParallelResource)
 .add_alias("normal")
 .add_alias("_sample_normal")
 .add_alias("random_normal")
@@ -84,7 +84,7 @@ Example::
 .set_attr<FCompute>("FCompute<cpu>", SampleNormal_<cpu>)
 .set_attr<FComputeEx>("FComputeEx<cpu>", SampleNormalEx_<cpu>);
 
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_gamma, SampleGammaParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_gamma, SampleGammaParam, SampleParallelResource)
 .add_alias("_sample_gamma")
 .add_alias("random_gamma")
 .describe(R"code(Draw random samples from a gamma distribution.
@@ -99,7 +99,8 @@ Example::
 .set_attr<FCompute>("FCompute<cpu>", SampleGamma_<cpu>)
 .set_attr<FComputeEx>("FComputeEx<cpu>", SampleGammaEx_<cpu>);
 
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_exponential, SampleExponentialParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_exponential, SampleExponentialParam,
+                               SampleParallelResource)
 .add_alias("_sample_exponential")
 .add_alias("random_exponential")
 .describe(R"code(Draw random samples from an exponential distribution.
@@ -113,7 +114,7 @@ Example::
 )code" ADD_FILELINE)
 .set_attr<FCompute>("FCompute<cpu>", SampleExponential_<cpu>);
 
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_poisson, SamplePoissonParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_poisson, SamplePoissonParam, SampleParallelResource)
 .add_alias("_sample_poisson")
 .add_alias("random_poisson")
 .describe(R"code(Draw random samples from a Poisson distribution.
@@ -128,7 +129,8 @@ Example::
 )code" ADD_FILELINE)
 .set_attr<FCompute>("FCompute<cpu>", SamplePoisson_<cpu>);
 
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_negative_binomial, SampleNegBinomialParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_negative_binomial, SampleNegBinomialParam,
+                               SampleParallelResource)
 .add_alias("_sample_negbinomial")
 .add_alias("random_negative_binomial")
 .describe(R"code(Draw random samples from a negative binomial distribution.
@@ -144,7 +146,8 @@ Example::
 )code" ADD_FILELINE)
 .set_attr<FCompute>("FCompute<cpu>", SampleNegBinomial_<cpu>);
 
-MXNET_OPERATOR_REGISTER_SAMPLE(_random_generalized_negative_binomial, SampleGenNegBinomialParam)
+MXNET_OPERATOR_REGISTER_SAMPLE(_random_generalized_negative_binomial, SampleGenNegBinomialParam,
+                               SampleParallelResource)
 .add_alias("_sample_gennegbinomial")
 .add_alias("random_generalized_negative_binomial")
 .describe(R"code(Draw random samples from a generalized negative binomial distribution.
@@ -29,8 +29,10 @@
 #include <string>
 #include <vector>
 #include "../mshadow_op.h"
+#include "../mxnet_op.h"
 #include "../elemwise_op_common.h"
 #include "../tensor/init_op.h"
+#include "../../common/random_generator.h"
 
 namespace mxnet {
 namespace op {
@@ -260,6 +262,74 @@ void SampleComputeEx_(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*!
+ * \brief kernels of the distributions drawn from the parallel random resource,
+ *  element i only depends on the counter i of the request.
+ */
+struct SampleUniformKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float low, float high) {
+    out[i] = DType(low + (high - low) * rnd.Uniform(i));
+  }
+};
+
+struct SampleNormalKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float loc, float scale) {
+    out[i] = DType(loc + scale * rnd.Normal(i));
+  }
+};
+
+struct SampleExponentialKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float lam) {
+    out[i] = DType(-logf(1.0f - rnd.Uniform(i)) / lam);
+  }
+};
+
+/*! \brief the rejection samplers draw the words of the subsequence of element i */
+struct SampleGammaKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float alpha, float beta) {
+    common::random::PhiloxSequence seq(rnd, i);
+    out[i] = DType(beta * seq.Gamma(alpha));
+  }
+};
+
+struct SamplePoissonKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float lam) {
+    common::random::PhiloxSequence seq(rnd, i);
+    out[i] = DType(seq.Poisson(lam));
+  }
+};
+
+/*! \brief negative binomial as the Poisson-gamma mixture Poisson(Gamma(k, (1-p)/p)) */
+struct SampleNegBinomialKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float k, float p) {
+    common::random::PhiloxSequence seq(rnd, i);
+    out[i] = DType(seq.Poisson(seq.Gamma(k) * (1.0f - p) / p));
+  }
+};
+
+/*! \brief Poisson(Gamma(1/alpha, mu*alpha)), which is Poisson(mu) for alpha = 0 */
+struct SampleGenNegBinomialKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, common::random::PhiloxStream rnd,
+                                  float mu, float alpha) {
+    common::random::PhiloxSequence seq(rnd, i);
+    const float lam = alpha == 0.0f ? mu : seq.Gamma(1.0f / alpha) * mu * alpha;
+    out[i] = DType(seq.Poisson(lam));
+  }
+};
+
 template<typename xpu>
 void SampleUniformDnsImpl(const nnvm::NodeAttrs& attrs,
                           const OpContext& ctx,
@@ -269,10 +339,11 @@ void SampleUniformDnsImpl(const nnvm::NodeAttrs& attrs,
   using namespace mshadow::expr;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   const SampleUniformParam& param = nnvm::get<SampleUniformParam>(attrs.parsed);
+  const int n = output->Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(output->type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = output->FlatTo2D<xpu, DType>(s);
-    prnd->SampleUniform(&out, param.low, param.high);
+    mxnet_op::Kernel<SampleUniformKernel, xpu>::Launch(
+        s, n, output->dptr<DType>(), rnd, param.low, param.high);
   });
 }
 
@@ -306,10 +377,11 @@ void SampleNormalDnsImpl(const nnvm::NodeAttrs& attrs,
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   const SampleNormalParam& param = nnvm::get<SampleNormalParam>(attrs.parsed);
   CHECK_GT(param.scale, 0) << "scale parameter in gaussian has to be positive";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SampleGaussian(&out, param.loc, param.scale);  // NOLINT(*)
+    mxnet_op::Kernel<SampleNormalKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, param.loc, param.scale);
   });
 }
 
@@ -343,10 +415,11 @@ void SampleGammaDnsImpl(const nnvm::NodeAttrs& attrs,
   const SampleGammaParam& param = nnvm::get<SampleGammaParam>(attrs.parsed);
   CHECK_GT(param.alpha, 0) << "alpha parameter in gamma distribution has to be positive";
   CHECK_GT(param.beta, 0) << "beta parameter in gamma distribution has to be positive";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SampleGamma(&out, param.alpha, param.beta);  // NOLINT(*)
+    mxnet_op::Kernel<SampleGammaKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, param.alpha, param.beta);
   });
 }
 
@@ -380,10 +453,11 @@ void SampleExponential_(const nnvm::NodeAttrs& attrs,
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   const SampleExponentialParam& param = nnvm::get<SampleExponentialParam>(attrs.parsed);
   CHECK_GT(param.lam, 0) << "lambda parameter in exponential distribution has to be positive";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SampleExponential(&out, param.lam);  // NOLINT(*)
+    mxnet_op::Kernel<SampleExponentialKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, param.lam);
   });
 }
 
@@ -398,10 +472,11 @@ void SamplePoisson_(const nnvm::NodeAttrs& attrs,
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   const SamplePoissonParam& param = nnvm::get<SamplePoissonParam>(attrs.parsed);
   CHECK_GE(param.lam, 0) << "lambda parameter in poisson distribution has to be non-negative";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SamplePoisson(&out, param.lam);  // NOLINT(*)
+    mxnet_op::Kernel<SamplePoissonKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, param.lam);
   });
 }
 
@@ -417,10 +492,11 @@ void SampleNegBinomial_(const nnvm::NodeAttrs& attrs,
   const SampleNegBinomialParam& param = nnvm::get<SampleNegBinomialParam>(attrs.parsed);
   CHECK_GE(param.k, 0) << "k parameter in negative binomial distribution has to be non-negative";
   CHECK_GE(param.p, 0) << "p parameter in negative binomial distribution has to be non-negative";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SampleNegativeBinomial(&out, param.k, param.p);  // NOLINT(*)
+    mxnet_op::Kernel<SampleNegBinomialKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, static_cast<float>(param.k), param.p);
   });
 }
 
@@ -438,10 +514,11 @@ void SampleGenNegBinomial_(const nnvm::NodeAttrs& attrs,
     << "mu parameter in generalized negative binomial distribution has to be non-negative";
   CHECK_GE(param.alpha, 0)
     << "alpha parameter in generalized negative binomial distribution has to be non-negative";
+  const int n = outputs[0].Size();
+  common::random::PhiloxStream rnd = ctx.requested[0].get_parallel_random()->Take(n);
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Random<xpu, DType> *prnd = ctx.requested[0].get_random<xpu, DType>(s);
-    mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-    prnd->SampleGeneralizedNegativeBinomial(&out, param.mu, param.alpha);  // NOLINT(*)
+    mxnet_op::Kernel<SampleGenNegBinomialKernel, xpu>::Launch(
+        s, n, outputs[0].dptr<DType>(), rnd, param.mu, param.alpha);
   });
 }
 
@@ -481,8 +558,9 @@ inline bool SampleOpType(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
-inline std::vector<ResourceRequest> SampleResource(const NodeAttrs& attrs) {
-  return { ResourceRequest::kRandom, ResourceRequest::kTempSpace };
+/*! \brief the resource of the distributions computed from counters */
+inline std::vector<ResourceRequest> SampleParallelResource(const NodeAttrs& attrs) {
+  return { ResourceRequest::kParallelRandom };
 }
 
 }  // namespace op
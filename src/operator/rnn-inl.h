@@ -68,6 +68,11 @@ inline int rnn_single_param_size(int inputSize,
   return size;
 }
 
+// index of the batch sizes input of packed sequences, after the states
+inline int rnn_batch_sizes_index(int mode) {
+  return mode == rnn_enum::kLstm ? 4 : 3;
+}
+
 inline int rnn_param_size(int layerNum,
                           int inputSize,
                           int hiddenSize,
@@ -88,7 +93,7 @@ inline int rnn_param_size(int layerNum,
 struct RNNParam : public dmlc::Parameter<RNNParam> {
   uint32_t state_size;
   uint32_t num_layers;
-  bool bidirectional, state_outputs;
+  bool bidirectional, state_outputs, packed;
   int mode;
   float p, pkeep_;
   int seq_length_, batch_size_, input_size_;
@@ -117,24 +122,29 @@ struct RNNParam : public dmlc::Parameter<RNNParam> {
 
     DMLC_DECLARE_FIELD(state_outputs).set_default(false)
     .describe("Whether to have the states as symbol outputs.");
+
+    DMLC_DECLARE_FIELD(packed).set_default(false)
+    .describe("Whether data holds packed sequences of shape "
+              "[sequence len * batch, input size] as returned by SequencePack, "
+              "with an extra input batch_sizes. The steps past the end of the "
+              "sequences are skipped.");
   }
 };
 
+/*!
+ * \brief the cpu implementation of the fused RNN, Forward and Backward are
+ *  defined in rnn.cc, the gpu uses CuDNNRNNOp
+ */
 template<typename xpu, typename DType>
 class RNNOp : public Operator {
  public:
-  explicit RNNOp(RNNParam p) {
-  }
+  explicit RNNOp(RNNParam p) : param_(p) {}
 
   virtual void Forward(const OpContext &ctx,
                        const std::vector<TBlob> &in_data,
                        const std::vector<OpReqType> &req,
                        const std::vector<TBlob> &out_data,
-                       const std::vector<TBlob> &aux_args) {
-    using namespace mshadow;
-    using namespace mshadow::expr;
-    // TODO(sbodenstein): add MShadow implementation
-  }
+                       const std::vector<TBlob> &aux_args);
 
   virtual void Backward(const OpContext &ctx,
                         const std::vector<TBlob> &out_grad,
@@ -142,14 +152,12 @@ class RNNOp : public Operator {
                         const std::vector<TBlob> &out_data,
                         const std::vector<OpReqType> &req,
                         const std::vector<TBlob> &in_grad,
-                        const std::vector<TBlob> &aux_args) {
-    using namespace mshadow;
-    using namespace mshadow::expr;
-    // TODO(sbodenstein): add MShadow implementation
-  }
+                        const std::vector<TBlob> &aux_args);
 
  private:
   RNNParam param_;
+  // outputs of the hidden layers and gate activations of the last training forward
+  std::vector<DType> reserve_;
 };  // class RNNOp
 
 template<typename xpu>
@@ -159,11 +167,12 @@ Operator* CreateOp(RNNParam param, int dtype);
 class RNNProp : public OperatorProperty {
  public:
   std::vector<std::string> ListArguments() const override {
-    if (param_.mode == rnn_enum::kLstm) {
-      return {"data", "parameters", "state", "state_cell"};
-    } else {
-      return {"data", "parameters", "state"};
-    }
+    std::vector<std::string> arguments = {"data", "parameters", "state"};
+    if (param_.mode == rnn_enum::kLstm)
+      arguments.push_back("state_cell");
+    if (param_.packed)
+      arguments.push_back("batch_sizes");
+    return arguments;
   }
 
   std::vector<std::string> ListOutputs() const override {
@@ -196,17 +205,34 @@ class RNNProp : public OperatorProperty {
                   std::vector<TShape> *aux_shape) const override {
     using namespace mshadow;
     if (param_.mode == rnn_enum::kLstm) {
-      CHECK_EQ(in_shape->size(), 4U) << "Input:[data, parameters, state, cell_state]";
+      CHECK_EQ(in_shape->size(), param_.packed ? 5U : 4U)
+          << "Input:[data, parameters, state, cell_state]";
     } else {
-      CHECK_EQ(in_shape->size(), 3U) << "Input:[data, parameters, state]";
+      CHECK_EQ(in_shape->size(), param_.packed ? 4U : 3U) << "Input:[data, parameters, state]";
     }
     const TShape &dshape = (*in_shape)[rnn_enum::kData];
     if (dshape.ndim() ==  0) return false;
-    CHECK_EQ(dshape.ndim(), 3U) \
-        << "Input data should be rank-3 tensor of dim [sequence length, batch size, input size]";
-    // data: [sequence len, batch, input dimension]
-    int batch_size = dshape[1];
-    int input_size = dshape[2];
+    int batch_size, input_size;
+    if (param_.packed) {
+      // data: [sequence len * batch, input dimension]
+      const TShape &bshape = (*in_shape)[rnn_batch_sizes_index(param_.mode)];
+      if (bshape.ndim() == 0) return false;
+      CHECK_EQ(dshape.ndim(), 2U) \
+          << "Packed input data should be rank-2 tensor of dim "
+          << "[sequence length * batch size, input size]";
+      CHECK_EQ(bshape.ndim(), 1U) << "batch_sizes should be a vector of dim [sequence length]";
+      CHECK_EQ(dshape[0] % bshape[0], 0U)
+          << "Packed input data of shape " << dshape << " does not hold "
+          << bshape[0] << " steps";
+      batch_size = dshape[0] / bshape[0];
+      input_size = dshape[1];
+    } else {
+      CHECK_EQ(dshape.ndim(), 3U) \
+          << "Input data should be rank-3 tensor of dim [sequence length, batch size, input size]";
+      // data: [sequence len, batch, input dimension]
+      batch_size = dshape[1];
+      input_size = dshape[2];
+    }
     int numDirections = param_.bidirectional ? 2 : 1;
     int total_layers = numDirections * param_.num_layers;  // double for bidirectional
     SHAPE_ASSIGN_CHECK(*in_shape,
@@ -226,15 +252,15 @@ class RNNProp : public OperatorProperty {
     SHAPE_ASSIGN_CHECK(*in_shape, rnn_enum::kParams, Shape1(param_size));
 
     out_shape->clear();
-    // output: [sequence len, batch, output size]
+    // output: [sequence len, batch, output size], packed as the data
     TShape oshape = dshape;
-    oshape[2] = numDirections * param_.state_size;
+    oshape[dshape.ndim() - 1] = numDirections * param_.state_size;
     out_shape->push_back(oshape);
     if (!param_.state_outputs) {
       return true;
     } else {
       // outStateShape: [layer_num, batch, state size]
-      TShape outStateShape = dshape;
+      TShape outStateShape(3);
       outStateShape[0] = total_layers;
       outStateShape[1] = batch_size;
       outStateShape[2] = param_.state_size;
@@ -303,6 +329,9 @@ class RNNProp : public OperatorProperty {
         dep.push_back(out_grad[rnn_enum::kStateCellOut]);
       }
     }
+    if (param_.packed) {
+      dep.push_back(in_data[rnn_batch_sizes_index(param_.mode)]);
+    }
     return dep;
   }
 
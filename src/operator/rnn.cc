@@ -24,14 +24,149 @@
 */
 
 #include "./rnn-inl.h"
+#include "./rnn_impl.h"
+#include "./sequence_op_common.h"
 
 namespace mxnet {
 namespace op {
+
+/*!
+ * \brief sizes of the problem given the data of shape (seq_len, batch, input_size),
+ *  or (seq_len * batch, input_size) for packed sequences
+ */
+template<typename DType>
+inline rnn_impl::RNNShape GetRNNShape(const RNNParam& param, const std::vector<TBlob>& in_data) {
+  const TShape& dshape = in_data[rnn_enum::kData].shape_;
+  rnn_impl::RNNShape p;
+  p.mode = param.mode;
+  p.state_size = param.state_size;
+  p.num_layers = param.num_layers;
+  p.num_dirs = param.bidirectional ? 2 : 1;
+  if (param.packed) {
+    const TBlob& batch_sizes = in_data[rnn_batch_sizes_index(param.mode)];
+    p.seq_len = batch_sizes.Size();
+    p.batch = dshape[0] / p.seq_len;
+    p.input_size = dshape[1];
+    p.batch_sizes.resize(p.seq_len);
+    IndexTensorToVector(batch_sizes.FlatTo1D<cpu, DType>(), &p.batch_sizes);
+    CheckBatchSizes(p.batch_sizes, p.batch);
+    p.offsets.resize(p.seq_len + 1, 0);
+    for (int t = 0; t < p.seq_len; ++t) {
+      p.offsets[t + 1] = p.offsets[t] + p.batch_sizes[t];
+    }
+  } else {
+    p.seq_len = dshape[0];
+    p.batch = dshape[1];
+    p.input_size = dshape[2];
+  }
+  return p;
+}
+
+template<typename xpu, typename DType>
+void RNNOp<xpu, DType>::Forward(const OpContext &ctx,
+                                const std::vector<TBlob> &in_data,
+                                const std::vector<OpReqType> &req,
+                                const std::vector<TBlob> &out_data,
+                                const std::vector<TBlob> &aux_args) {
+  using namespace mshadow;
+  const bool lstm = param_.mode == rnn_enum::kLstm;
+  CHECK_EQ(in_data.size(), (lstm ? 4U : 3U) + param_.packed);
+  CHECK_EQ(out_data.size(), param_.state_outputs ? (lstm ? 3U : 2U) : 1U);
+  CHECK(!ctx.is_train || param_.p == 0)
+    << "Dropout between the layers of RNN is not supported on cpu yet";
+  CHECK_NE(req[rnn_enum::kOut], kAddTo) << "AddTo is not supported by RNN";
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const rnn_impl::RNNShape p = GetRNNShape<DType>(param_, in_data);
+  const size_t ws_size = rnn_impl::RNNForwardWorkspaceSize(p);
+  // the reserve is only kept when a backward pass follows
+  size_t temp_size = ws_size;
+  if (ctx.is_train) {
+    reserve_.resize(p.reserve_size());
+  } else {
+    temp_size += p.reserve_size();
+  }
+  Tensor<cpu, 1, DType> temp = ctx.requested[rnn_enum::kTempSpace]
+    .get_space_typed<cpu, 1, DType>(Shape1(temp_size), s);
+  DType *reserve = ctx.is_train ? reserve_.data() : temp.dptr_ + ws_size;
+  DType *hy = nullptr, *cy = nullptr;
+  if (param_.state_outputs) {
+    hy = out_data[rnn_enum::kStateOut].dptr<DType>();
+    if (lstm) cy = out_data[rnn_enum::kStateCellOut].dptr<DType>();
+  }
+  rnn_impl::RNNForward(p, s, in_data[rnn_enum::kData].dptr<DType>(),
+                       in_data[rnn_enum::kParams].dptr<DType>(),
+                       in_data[rnn_enum::kState].dptr<DType>(),
+                       lstm ? in_data[rnn_enum::kStateCell].dptr<DType>() : nullptr,
+                       out_data[rnn_enum::kOut].dptr<DType>(), hy, cy, reserve, temp.dptr_);
+}
+
+template<typename xpu, typename DType>
+void RNNOp<xpu, DType>::Backward(const OpContext &ctx,
+                                 const std::vector<TBlob> &out_grad,
+                                 const std::vector<TBlob> &in_data,
+                                 const std::vector<TBlob> &out_data,
+                                 const std::vector<OpReqType> &req,
+                                 const std::vector<TBlob> &in_grad,
+                                 const std::vector<TBlob> &aux_args) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  const bool lstm = param_.mode == rnn_enum::kLstm;
+  CHECK_EQ(in_grad.size(), (lstm ? 4U : 3U) + param_.packed);
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const rnn_impl::RNNShape p = GetRNNShape<DType>(param_, in_data);
+  CHECK_EQ(reserve_.size(), p.reserve_size())
+    << "RNN backward needs a forward pass run with is_train=True";
+  // the gradients of the data and of the initial states are computed in the
+  // workspace and then assigned with their req
+  const TBlob &dx = in_grad[rnn_enum::kData];
+  const TBlob &dhx = in_grad[rnn_enum::kState];
+  const size_t ws_size = rnn_impl::RNNBackwardWorkspaceSize(p);
+  const size_t state_size = dhx.shape_.Size();
+  Tensor<cpu, 1, DType> temp = ctx.requested[rnn_enum::kTempSpace]
+    .get_space_typed<cpu, 1, DType>(Shape1(ws_size + dx.shape_.Size() +
+                                           (lstm ? 2 : 1) * state_size), s);
+  Tensor<cpu, 1, DType> dx_temp(temp.dptr_ + ws_size, Shape1(dx.shape_.Size()), s);
+  Tensor<cpu, 1, DType> dhx_temp(dx_temp.dptr_ + dx_temp.size(0), Shape1(state_size), s);
+  Tensor<cpu, 1, DType> dcx_temp(dhx_temp.dptr_ + state_size, Shape1(state_size), s);
+
+  Tensor<cpu, 1, DType> dw = in_grad[rnn_enum::kParams].FlatTo1D<cpu, DType>(s);
+  const bool need_dw = req[rnn_enum::kParams] != kNullOp;
+  if (req[rnn_enum::kParams] == kWriteTo || req[rnn_enum::kParams] == kWriteInplace) {
+    dw = DType(0);
+  }
+  const DType *dhy = nullptr, *dcy = nullptr;
+  if (param_.state_outputs) {
+    dhy = out_grad[rnn_enum::kStateOut].dptr<DType>();
+    if (lstm) dcy = out_grad[rnn_enum::kStateCellOut].dptr<DType>();
+  }
+  rnn_impl::RNNBackward(p, s, in_data[rnn_enum::kData].dptr<DType>(),
+                        in_data[rnn_enum::kParams].dptr<DType>(),
+                        in_data[rnn_enum::kState].dptr<DType>(),
+                        lstm ? in_data[rnn_enum::kStateCell].dptr<DType>() : nullptr,
+                        out_data[rnn_enum::kOut].dptr<DType>(),
+                        out_grad[rnn_enum::kOut].dptr<DType>(), dhy, dcy,
+                        dx_temp.dptr_, dw.dptr_, dhx_temp.dptr_, dcx_temp.dptr_,
+                        reserve_.data(), temp.dptr_, need_dw);
+  Tensor<cpu, 1, DType> dx_out = dx.FlatTo1D<cpu, DType>(s);
+  Tensor<cpu, 1, DType> dhx_out = dhx.FlatTo1D<cpu, DType>(s);
+  Assign(dx_out, req[rnn_enum::kData], F<mshadow_op::identity>(dx_temp));
+  Assign(dhx_out, req[rnn_enum::kState], F<mshadow_op::identity>(dhx_temp));
+  if (lstm) {
+    Tensor<cpu, 1, DType> dcx_out = in_grad[rnn_enum::kStateCell].FlatTo1D<cpu, DType>(s);
+    Assign(dcx_out, req[rnn_enum::kStateCell], F<mshadow_op::identity>(dcx_temp));
+  }
+  const int bs_index = rnn_batch_sizes_index(param_.mode);
+  if (param_.packed && req[bs_index] != kNullOp && req[bs_index] != kAddTo) {
+    Tensor<cpu, 1, DType> dbs = in_grad[bs_index].FlatTo1D<cpu, DType>(s);
+    dbs = DType(0);
+  }
+}
+
 template<>
 Operator *CreateOp<cpu>(RNNParam param, int dtype) {
-  LOG(FATAL) << "RNN is only available for gpu at the moment.";
   Operator *op = NULL;
-  MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
+  // the cpu gemm has no half precision
+  MSHADOW_SGL_DBL_TYPE_SWITCH(dtype, DType, {
     op = new RNNOp<cpu, DType>(param);
   });
   return op;
@@ -53,6 +188,8 @@ MXNET_REGISTER_OP_PROPERTY(RNN, RNNProp)
 .add_argument("state", "NDArray-or-Symbol", "initial hidden state of the RNN")
 .add_argument("state_cell", "NDArray-or-Symbol",
               "initial cell state for LSTM networks (only for LSTM)")
+.add_argument("batch_sizes", "NDArray-or-Symbol",
+              "batch sizes of the steps of packed sequences (only when packed)")
 .add_arguments(RNNParam::__FIELDS__());
 }  // namespace op
 }  // namespace mxnet
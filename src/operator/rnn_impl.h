@@ -0,0 +1,563 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rnn_impl.h
+ * \brief CPU implementation of the fused RNN operator
+ *
+ *  The parameters are packed as in the cuDNN implementation: the i2h and h2h
+ *  weights of every layer and direction, stacked as (gates * state_size, input)
+ *  with the gates in the order [i, f, c, o] for lstm and [r, z, n] for gru,
+ *  followed by the i2h and h2h biases in the same order.
+ *
+ *  The i2h products of all the timesteps of a layer are computed by a single
+ *  gemm, only the h2h products are computed step by step. The gate
+ *  nonlinearities and the state updates of a step are fused in one kernel.
+ *
+ *  With packed sequences, the rows of the step t are the batch_sizes[t]
+ *  sequences longer than t, stored after the rows of the previous steps, and
+ *  the steps only compute their rows. In the backward direction, the
+ *  sequences ending at a step start from their initial state.
+*/
+#ifndef MXNET_OPERATOR_RNN_IMPL_H_
+#define MXNET_OPERATOR_RNN_IMPL_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "./linalg.h"
+#include "./mshadow_op.h"
+#include "./mxnet_op.h"
+#include "./operator_common.h"
+#include "./rnn-inl.h"
+
+namespace mxnet {
+namespace op {
+namespace rnn_impl {
+
+using mshadow::Shape2;
+using mshadow::Stream;
+using mshadow::Tensor;
+using mxnet_op::Kernel;
+
+/*! \brief number of gates of a cell */
+inline int NumGates(int mode) {
+  switch (mode) {
+    case rnn_enum::kLstm: return 4;
+    case rnn_enum::kGru: return 3;
+    default: return 1;
+  }
+}
+
+/*! \brief number of values per state kept for the backward pass of a step */
+inline int CacheWidth(int mode) {
+  switch (mode) {
+    case rnn_enum::kLstm: return 5;  // i, f, c~, o and c
+    case rnn_enum::kGru: return 4;   // r, z, n and the h2h part of n
+    default: return 0;               // the hidden state is the output
+  }
+}
+
+/*! \brief sizes of the problem and location of the parameters of every layer */
+struct RNNShape {
+  int mode, seq_len, batch, input_size, state_size, num_layers, num_dirs;
+  /*! \brief batch sizes of the steps of packed sequences, empty when padded */
+  std::vector<int> batch_sizes;
+  /*! \brief first row of every step of packed sequences, and the number of rows */
+  std::vector<int> offsets;
+  int gates() const { return NumGates(mode); }
+  bool packed() const { return !batch_sizes.empty(); }
+  int step_batch(int t) const { return packed() ? batch_sizes[t] : batch; }
+  int step_offset(int t) const { return packed() ? offsets[t] : t * batch; }
+  /*! \brief number of rows of all the steps */
+  int rows() const { return step_offset(seq_len); }
+  int layer_input(int l) const { return l == 0 ? input_size : num_dirs * state_size; }
+  /*! \brief offset of the i2h weight of layer l and direction d, the h2h weight follows */
+  size_t weight_offset(int l, int d) const {
+    const size_t gh = gates() * state_size;
+    size_t off = 0;
+    for (int i = 0; i < l; ++i) {
+      off += num_dirs * gh * (layer_input(i) + state_size);
+    }
+    return off + d * gh * (layer_input(l) + state_size);
+  }
+  /*! \brief offset of the i2h bias of layer l and direction d, the h2h bias follows */
+  size_t bias_offset(int l, int d) const {
+    return weight_offset(num_layers, 0) +
+        static_cast<size_t>(l * num_dirs + d) * 2 * gates() * state_size;
+  }
+  /*! \brief size of the outputs of the hidden layers and of the caches of the steps */
+  size_t reserve_size() const {
+    const size_t tn = static_cast<size_t>(seq_len) * batch;
+    return (num_layers - 1) * tn * num_dirs * state_size +
+        num_layers * num_dirs * tn * CacheWidth(mode) * state_size;
+  }
+};
+
+/*! \brief gx[i] += bias of its gate, the h2h bias of the gru n gate is applied in the step */
+struct RNNAddBias {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* gx, const DType* bx, const DType* bh,
+                                  const int gh, const int skip_bh_from) {
+    const int k = i % gh;
+    gx[i] += bx[k] + (k < skip_bh_from ? bh[k] : DType(0));
+  }
+};
+
+/*! \brief fused lstm step, i runs over the batch * state_size values */
+struct LSTMFwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* gx, const DType* gh,
+                                  const DType* c_prev, const int ldc,
+                                  DType* h, const int ldh, DType* cache) {
+    const int n = i / H, j = i % H;
+    const DType* x = gx + n * 4 * H;
+    const DType* y = gh + n * 4 * H;
+    const DType it = mshadow_op::sigmoid::Map(x[j] + y[j]);
+    const DType ft = mshadow_op::sigmoid::Map(x[H + j] + y[H + j]);
+    const DType gt = mshadow_op::tanh::Map(x[2 * H + j] + y[2 * H + j]);
+    const DType ot = mshadow_op::sigmoid::Map(x[3 * H + j] + y[3 * H + j]);
+    const DType ct = ft * c_prev[n * ldc + j] + it * gt;
+    DType* c = cache + n * 5 * H;
+    c[j] = it;
+    c[H + j] = ft;
+    c[2 * H + j] = gt;
+    c[3 * H + j] = ot;
+    c[4 * H + j] = ct;
+    h[n * ldh + j] = ot * mshadow_op::tanh::Map(ct);
+  }
+};
+
+/*! \brief fused gru step, i runs over the batch * state_size values */
+struct GRUFwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* gx, const DType* gh,
+                                  const DType* bh, const DType* h_prev, const int ldp,
+                                  DType* h, const int ldh, DType* cache) {
+    const int n = i / H, j = i % H;
+    const DType* x = gx + n * 3 * H;
+    const DType* y = gh + n * 3 * H;
+    const DType rt = mshadow_op::sigmoid::Map(x[j] + y[j]);
+    const DType zt = mshadow_op::sigmoid::Map(x[H + j] + y[H + j]);
+    const DType hn = y[2 * H + j] + bh[2 * H + j];
+    const DType nt = mshadow_op::tanh::Map(x[2 * H + j] + rt * hn);
+    DType* c = cache + n * 4 * H;
+    c[j] = rt;
+    c[H + j] = zt;
+    c[2 * H + j] = nt;
+    c[3 * H + j] = hn;
+    h[n * ldh + j] = (DType(1) - zt) * nt + zt * h_prev[n * ldp + j];
+  }
+};
+
+/*! \brief fused vanilla rnn step, i runs over the batch * state_size values */
+struct VanillaFwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* gx, const DType* gh,
+                                  DType* h, const int ldh, const bool relu) {
+    const int n = i / H, j = i % H;
+    const DType v = gx[i] + gh[i];
+    h[n * ldh + j] = relu ? (v > DType(0) ? v : DType(0)) : mshadow_op::tanh::Map(v);
+  }
+};
+
+/*!
+ * \brief backward of a lstm step: the gradients of the pre-activation gates,
+ *  dc holds the gradient of the cell state of the step and receives the one of
+ *  the previous step
+ */
+struct LSTMBwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* dy, const int ldy,
+                                  const DType* dh_next, DType* dc, const DType* cache,
+                                  const DType* c_prev, const int ldc, DType* dgates) {
+    const int n = i / H, j = i % H;
+    const DType* c = cache + n * 5 * H;
+    const DType it = c[j], ft = c[H + j], gt = c[2 * H + j], ot = c[3 * H + j];
+    const DType tc = mshadow_op::tanh::Map(c[4 * H + j]);
+    const DType dh = dy[n * ldy + j] + dh_next[i];
+    const DType dct = dc[i] + dh * ot * (DType(1) - tc * tc);
+    DType* dg = dgates + n * 4 * H;
+    dg[j] = dct * gt * it * (DType(1) - it);
+    dg[H + j] = dct * c_prev[n * ldc + j] * ft * (DType(1) - ft);
+    dg[2 * H + j] = dct * it * (DType(1) - gt * gt);
+    dg[3 * H + j] = dh * tc * ot * (DType(1) - ot);
+    dc[i] = dct * ft;
+  }
+};
+
+/*!
+ * \brief backward of a gru step: the gradients of the pre-activation i2h and h2h
+ *  gates, dh_next receives the direct part of the gradient of the previous state
+ */
+struct GRUBwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* dy, const int ldy,
+                                  DType* dh_next, const DType* cache,
+                                  const DType* h_prev, const int ldp,
+                                  DType* dgx, DType* dgh) {
+    const int n = i / H, j = i % H;
+    const DType* c = cache + n * 4 * H;
+    const DType rt = c[j], zt = c[H + j], nt = c[2 * H + j], hn = c[3 * H + j];
+    const DType dh = dy[n * ldy + j] + dh_next[i];
+    const DType dn = dh * (DType(1) - zt) * (DType(1) - nt * nt);
+    const DType dr = dn * hn * rt * (DType(1) - rt);
+    const DType dz = dh * (h_prev[n * ldp + j] - nt) * zt * (DType(1) - zt);
+    DType* x = dgx + n * 3 * H;
+    DType* y = dgh + n * 3 * H;
+    x[j] = dr;
+    x[H + j] = dz;
+    x[2 * H + j] = dn;
+    y[j] = dr;
+    y[H + j] = dz;
+    y[2 * H + j] = dn * rt;
+    dh_next[i] = dh * zt;
+  }
+};
+
+/*! \brief backward of a vanilla rnn step */
+struct VanillaBwdStep {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, const int H, const DType* dy, const int ldy,
+                                  const DType* dh_next, const DType* h, const int ldh,
+                                  DType* dgates, const bool relu) {
+    const int n = i / H, j = i % H;
+    const DType dh = dy[n * ldy + j] + dh_next[i];
+    const DType ht = h[n * ldh + j];
+    dgates[i] = relu ? (ht > DType(0) ? dh : DType(0)) : dh * (DType(1) - ht * ht);
+  }
+};
+
+/*! \brief out[i] = in[(i / cols) * ld + i % cols] */
+struct CopyStrided {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* in,
+                                  const int cols, const int ld) {
+    out[i] = in[(i / cols) * ld + i % cols];
+  }
+};
+
+/*! \brief out[k] += sum of the rows of the column k of a rows x cols matrix */
+struct ColumnSumAdd {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int k, DType* out, const DType* in,
+                                  const int rows, const int cols) {
+    DType sum = DType(0);
+    for (int r = 0; r < rows; ++r) sum += in[r * cols + k];
+    out[k] += sum;
+  }
+};
+
+/*! \brief a rows x cols view of the memory at ptr with leading dimension ld */
+template<typename DType>
+inline Tensor<cpu, 2, DType> Mat(const DType* ptr, int rows, int cols, int ld,
+                                 Stream<cpu>* s) {
+  Tensor<cpu, 2, DType> ret(const_cast<DType*>(ptr), Shape2(rows, cols), ld, s);
+  return ret;
+}
+
+/*!
+ * \brief the states before the step t of the direction d, with their leading
+ *  dimension in ld: the states of the previous step, seq being the state of
+ *  its first row with a leading dimension ld_seq, or the initial states init.
+ *  The sequences of packed sequences which start after the first step of the
+ *  backward direction mix both, they are gathered in buf.
+ */
+template<typename DType>
+inline const DType* PrevState(const RNNShape& p, int d, int t, const DType* seq, int ld_seq,
+                              const DType* init, DType* buf, int* ld, Stream<cpu>* s) {
+  const int H = p.state_size;
+  const int t_prev = d == 0 ? t - 1 : t + 1;
+  if (t_prev < 0 || t_prev >= p.seq_len) {
+    *ld = H;
+    return init;
+  }
+  const DType* prev = seq + static_cast<size_t>(p.step_offset(t_prev)) * ld_seq;
+  const int n = p.step_batch(t), n_prev = p.step_batch(t_prev);
+  if (n_prev >= n) {
+    *ld = ld_seq;
+    return prev;
+  }
+  Kernel<CopyStrided, cpu>::Launch(s, n_prev * H, buf, prev, H, ld_seq);
+  std::copy(init + static_cast<size_t>(n_prev) * H, init + static_cast<size_t>(n) * H,
+            buf + static_cast<size_t>(n_prev) * H);
+  *ld = H;
+  return buf;
+}
+
+/*!
+ * \brief copies the states of the last step of every sequence in the direction
+ *  d to states, seq being the state of the first row of the steps with a
+ *  leading dimension ld_seq
+ */
+template<typename DType>
+inline void FinalStates(const RNNShape& p, int d, const DType* seq, int ld_seq,
+                        DType* states, Stream<cpu>* s) {
+  const int H = p.state_size;
+  for (int t = 0; t < p.seq_len; ++t) {
+    // the sequences whose last step is t, the first step ends all of them backward
+    const int end = p.step_batch(t);
+    const int begin = d == 1 ? (t == 0 ? 0 : end) :
+                      (t + 1 < p.seq_len ? p.step_batch(t + 1) : 0);
+    if (end > begin) {
+      Kernel<CopyStrided, cpu>::Launch(s, (end - begin) * H,
+        states + static_cast<size_t>(begin) * H,
+        seq + (static_cast<size_t>(p.step_offset(t)) + begin) * ld_seq, H, ld_seq);
+    }
+  }
+}
+
+/*! \brief size of the workspace of RNNForward */
+inline size_t RNNForwardWorkspaceSize(const RNNShape& p) {
+  const size_t gh = p.gates() * p.state_size;
+  return (static_cast<size_t>(p.seq_len) + 1) * p.batch * gh + 2 * p.batch * p.state_size;
+}
+
+/*!
+ * \brief forward pass
+ * \param x input of shape (seq_len, batch, input_size)
+ * \param hx, cx initial states of shape (num_layers * num_dirs, batch, state_size)
+ * \param y output of shape (seq_len, batch, num_dirs * state_size)
+ * \param hy, cy final states, can be nullptr
+ * \param reserve memory of reserve_size() values kept for the backward pass
+ * \param ws workspace of RNNForwardWorkspaceSize() values
+ */
+template<typename DType>
+void RNNForward(const RNNShape& p, Stream<cpu>* s, const DType* x, const DType* w,
+                const DType* hx, const DType* cx, DType* y, DType* hy, DType* cy,
+                DType* reserve, DType* ws) {
+  const int T = p.seq_len, N = p.batch, H = p.state_size, D = p.num_dirs;
+  const int G = p.gates(), GH = G * H, C = CacheWidth(p.mode) * H;
+  const int TN = T * N, DH = D * H, R = p.rows();
+  DType* gx = ws;
+  DType* gh = ws + static_cast<size_t>(TN) * GH;
+  DType* h_buf = gh + static_cast<size_t>(N) * GH;
+  DType* c_buf = h_buf + static_cast<size_t>(N) * H;
+  DType* layer_out = reserve;
+  DType* caches = reserve + static_cast<size_t>(p.num_layers - 1) * TN * DH;
+  const DType* layer_in = x;
+  for (int l = 0; l < p.num_layers; ++l) {
+    const int I = p.layer_input(l);
+    DType* out = l == p.num_layers - 1 ? y : layer_out + static_cast<size_t>(l) * TN * DH;
+    for (int d = 0; d < D; ++d) {
+      const DType* wx = w + p.weight_offset(l, d);
+      const DType* wh = wx + static_cast<size_t>(GH) * I;
+      const DType* bx = w + p.bias_offset(l, d);
+      const DType* bh = bx + GH;
+      DType* cache = caches + static_cast<size_t>(l * D + d) * TN * C;
+      const int state = l * D + d;
+      // the i2h products of all the steps at once
+      linalg_gemm(Mat(layer_in, R, I, I, s), Mat(wx, GH, I, I, s), Mat(gx, R, GH, GH, s),
+                  false, true, s, kWriteTo);
+      Kernel<RNNAddBias, cpu>::Launch(s, R * GH, gx, bx, bh, GH,
+                                      p.mode == rnn_enum::kGru ? 2 * H : GH);
+      for (int step = 0; step < T; ++step) {
+        const int t = d == 0 ? step : T - 1 - step;
+        const int nt = p.step_batch(t);
+        if (nt == 0) continue;
+        const size_t off = p.step_offset(t);
+        int ldp;
+        const DType* h_prev = PrevState(p, d, t, out + d * H, DH,
+                                        hx + static_cast<size_t>(state) * N * H, h_buf, &ldp, s);
+        DType* h = out + off * DH + d * H;
+        linalg_gemm(Mat(h_prev, nt, H, ldp, s), Mat(wh, GH, H, H, s), Mat(gh, nt, GH, GH, s),
+                    false, true, s, kWriteTo);
+        const DType* gx_t = gx + off * GH;
+        DType* cache_t = cache + off * C;
+        switch (p.mode) {
+          case rnn_enum::kLstm: {
+            int ldc;
+            const DType* c_prev = PrevState(p, d, t, cache + 4 * H, C,
+                                            cx + static_cast<size_t>(state) * N * H, c_buf,
+                                            &ldc, s);
+            Kernel<LSTMFwdStep, cpu>::Launch(s, nt * H, H, gx_t, gh, c_prev, ldc,
+                                             h, DH, cache_t);
+            break;
+          }
+          case rnn_enum::kGru:
+            Kernel<GRUFwdStep, cpu>::Launch(s, nt * H, H, gx_t, gh, bh, h_prev, ldp,
+                                            h, DH, cache_t);
+            break;
+          default:
+            Kernel<VanillaFwdStep, cpu>::Launch(s, nt * H, H, gx_t, gh, h, DH,
+                                                p.mode == rnn_enum::kRnnRelu);
+        }
+      }
+      // the final states are the ones of the last step of each direction
+      if (hy != nullptr) {
+        FinalStates(p, d, out + d * H, DH, hy + static_cast<size_t>(state) * N * H, s);
+      }
+      if (cy != nullptr && p.mode == rnn_enum::kLstm) {
+        FinalStates(p, d, cache + 4 * H, C, cy + static_cast<size_t>(state) * N * H, s);
+      }
+    }
+    layer_in = out;
+  }
+  // the padding rows of packed sequences
+  std::fill(y + static_cast<size_t>(R) * DH, y + static_cast<size_t>(TN) * DH, DType(0));
+}
+
+/*! \brief size of the workspace of RNNBackward */
+inline size_t RNNBackwardWorkspaceSize(const RNNShape& p) {
+  const size_t tn = static_cast<size_t>(p.seq_len) * p.batch;
+  const size_t gh = p.gates() * p.state_size;
+  const size_t width = std::max(p.input_size, p.num_dirs * p.state_size);
+  return 2 * tn * gh + 2 * tn * width + 4 * p.batch * p.state_size;
+}
+
+/*!
+ * \brief backward pass, the gradients of the weights are added to dw
+ * \param dy gradient of the output
+ * \param dhy, dcy gradients of the final states, can be nullptr
+ * \param dx gradient of the input, written
+ * \param dhx, dcx gradients of the initial states, written, dcx is only for lstm
+ * \param y output of the forward pass and reserve the memory it filled
+ */
+template<typename DType>
+void RNNBackward(const RNNShape& p, Stream<cpu>* s, const DType* x, const DType* w,
+                 const DType* hx, const DType* cx, const DType* y, const DType* dy,
+                 const DType* dhy, const DType* dcy, DType* dx, DType* dw,
+                 DType* dhx, DType* dcx, const DType* reserve, DType* ws, bool need_dw) {
+  const int T = p.seq_len, N = p.batch, H = p.state_size, D = p.num_dirs;
+  const int G = p.gates(), GH = G * H, C = CacheWidth(p.mode) * H;
+  const int TN = T * N, DH = D * H, NH = N * H, R = p.rows();
+  const size_t width = std::max(p.input_size, DH);
+  DType* dgx = ws;
+  DType* dgh = p.mode == rnn_enum::kGru ? dgx + static_cast<size_t>(TN) * GH : dgx;
+  DType* dy_buf[2] = {ws + 2 * static_cast<size_t>(TN) * GH,
+                      ws + 2 * static_cast<size_t>(TN) * GH + TN * width};
+  DType* dh_next = ws + 2 * static_cast<size_t>(TN) * GH + 2 * TN * width;
+  DType* dc_next = dh_next + NH;
+  DType* h_buf = dc_next + NH;
+  DType* c_buf = h_buf + NH;
+  const DType* layer_out = reserve;
+  const DType* caches = reserve + static_cast<size_t>(p.num_layers - 1) * TN * DH;
+  const DType* dlayer_out = dy;
+  for (int l = p.num_layers - 1; l >= 0; --l) {
+    const int I = p.layer_input(l);
+    const DType* in = l == 0 ? x : layer_out + static_cast<size_t>(l - 1) * TN * DH;
+    const DType* out = l == p.num_layers - 1 ? y : layer_out + static_cast<size_t>(l) * TN * DH;
+    DType* din = l == 0 ? dx : dy_buf[l % 2];
+    for (int d = 0; d < D; ++d) {
+      const size_t w_off = p.weight_offset(l, d), b_off = p.bias_offset(l, d);
+      const DType* wx = w + w_off;
+      const DType* wh = wx + static_cast<size_t>(GH) * I;
+      DType* dwx = dw + w_off;
+      DType* dwh = dwx + static_cast<size_t>(GH) * I;
+      const DType* cache = caches + static_cast<size_t>(l * D + d) * TN * C;
+      const int state = l * D + d;
+      const DType* h0 = hx + static_cast<size_t>(state) * NH;
+      if (dhy != nullptr) {
+        std::copy(dhy + static_cast<size_t>(state) * NH,
+                  dhy + static_cast<size_t>(state + 1) * NH, dh_next);
+      } else {
+        std::fill(dh_next, dh_next + NH, DType(0));
+      }
+      if (p.mode == rnn_enum::kLstm) {
+        if (dcy != nullptr) {
+          std::copy(dcy + static_cast<size_t>(state) * NH,
+                    dcy + static_cast<size_t>(state + 1) * NH, dc_next);
+        } else {
+          std::fill(dc_next, dc_next + NH, DType(0));
+        }
+      }
+      // the rows of dh_next and dc_next past the batch of a step keep the
+      // gradients of the sequences ending before it, or starting after it backward
+      for (int step = T - 1; step >= 0; --step) {
+        const int t = d == 0 ? step : T - 1 - step;
+        const int nt = p.step_batch(t);
+        if (nt == 0) continue;
+        const size_t off = p.step_offset(t);
+        int ldp;
+        const DType* h_prev = PrevState(p, d, t, out + d * H, DH, h0, h_buf, &ldp, s);
+        const DType* dy_t = dlayer_out + off * DH + d * H;
+        const DType* cache_t = cache + off * C;
+        DType* dgx_t = dgx + off * GH;
+        DType* dgh_t = dgh + off * GH;
+        OpReqType dh_req = kWriteTo;
+        switch (p.mode) {
+          case rnn_enum::kLstm: {
+            int ldc;
+            const DType* c_prev = PrevState(p, d, t, cache + 4 * H, C,
+                                            cx + static_cast<size_t>(state) * NH, c_buf,
+                                            &ldc, s);
+            Kernel<LSTMBwdStep, cpu>::Launch(s, nt * H, H, dy_t, DH, dh_next, dc_next,
+                                             cache_t, c_prev, ldc, dgx_t);
+            break;
+          }
+          case rnn_enum::kGru:
+            Kernel<GRUBwdStep, cpu>::Launch(s, nt * H, H, dy_t, DH, dh_next, cache_t,
+                                            h_prev, ldp, dgx_t, dgh_t);
+            dh_req = kAddTo;
+            break;
+          default:
+            Kernel<VanillaBwdStep, cpu>::Launch(s, nt * H, H, dy_t, DH, dh_next,
+              out + off * DH + d * H, DH, dgx_t, p.mode == rnn_enum::kRnnRelu);
+        }
+        // gradient of the previous hidden state through the h2h weight
+        linalg_gemm(Mat(dgh_t, nt, GH, GH, s), Mat(wh, GH, H, H, s), Mat(dh_next, nt, H, H, s),
+                    false, false, s, dh_req);
+        // the previous states of packed sequences are not a shift of the outputs
+        if (need_dw && p.packed()) {
+          linalg_gemm(Mat(dgh_t, nt, GH, GH, s), Mat(h_prev, nt, H, ldp, s),
+                      Mat(dwh, GH, H, H, s), true, false, s, kAddTo);
+        }
+      }
+      std::copy(dh_next, dh_next + NH, dhx + static_cast<size_t>(state) * NH);
+      if (p.mode == rnn_enum::kLstm) {
+        std::copy(dc_next, dc_next + NH, dcx + static_cast<size_t>(state) * NH);
+      }
+      if (need_dw) {
+        DType* dbx = dw + b_off;
+        DType* dbh = dbx + GH;
+        linalg_gemm(Mat(dgx, R, GH, GH, s), Mat(in, R, I, I, s), Mat(dwx, GH, I, I, s),
+                    true, false, s, kAddTo);
+        // the previous states of the steps are the outputs shifted by one step,
+        // and the initial state for the first step
+        const int first = d == 0 ? 0 : T - 1;
+        if (T > 1 && !p.packed()) {
+          const size_t shifted = d == 0 ? static_cast<size_t>(N) * GH : 0;
+          const size_t prev = d == 0 ? 0 : static_cast<size_t>(N) * DH;
+          linalg_gemm(Mat(dgh + shifted, (T - 1) * N, GH, GH, s),
+                      Mat(out + prev + d * H, (T - 1) * N, H, DH, s),
+                      Mat(dwh, GH, H, H, s), true, false, s, kAddTo);
+        }
+        if (!p.packed()) {
+          linalg_gemm(Mat(dgh + static_cast<size_t>(first) * N * GH, N, GH, GH, s),
+                      Mat(h0, N, H, H, s), Mat(dwh, GH, H, H, s), true, false, s, kAddTo);
+        }
+        Kernel<ColumnSumAdd, cpu>::Launch(s, GH, dbx, dgx, R, GH);
+        Kernel<ColumnSumAdd, cpu>::Launch(s, GH, dbh, dgh, R, GH);
+      }
+      // gradient of the input of the layer, summed over the directions
+      linalg_gemm(Mat(dgx, R, GH, GH, s), Mat(wx, GH, I, I, s), Mat(din, R, I, I, s),
+                  false, false, s, d == 0 ? kWriteTo : kAddTo);
+    }
+    dlayer_out = din;
+  }
+  // the padding rows of packed sequences
+  std::fill(dx + static_cast<size_t>(R) * p.input_size,
+            dx + static_cast<size_t>(TN) * p.input_size, DType(0));
+}
+
+}  // namespace rnn_impl
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_RNN_IMPL_H_
@@ -34,7 +34,7 @@
 #include <utility>
 #include <vector>
 #include "./mshadow_op.h"
-#include "./operator_common.h"
+#include "./mxnet_op.h"
 #include "./operator_common.h"
 #include "./sequence_op_common.h"
 
@@ -48,12 +48,46 @@ enum SequenceLastOpOutputs { kOut };
 
 struct SequenceLastParam : public dmlc::Parameter<SequenceLastParam> {
   bool use_sequence_length;
+  bool packed;
   DMLC_DECLARE_PARAMETER(SequenceLastParam) {
     DMLC_DECLARE_FIELD(use_sequence_length)
         .set_default(false)
         .describe(
             "If set to true, this layer takes in an extra input parameter `sequence_length` "
             "to specify variable length sequence");
+    DMLC_DECLARE_FIELD(packed)
+        .set_default(false)
+        .describe(
+            "If set to true, `data` holds packed sequences as returned by SequencePack, "
+            "and the extra input is the `batch_sizes` of their steps");
+  }
+  int NumInputs() const { return (use_sequence_length || packed) ? 2 : 1; }
+};
+
+/*!
+ * \brief the last step of the sequence i of packed sequences is copied to
+ *  last, or its gradient in last is copied to the packed gradient
+ */
+struct PackedLastKernel {
+  template <typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *last, DType *packed, const OpReqType req,
+                                  const index_t max_seq_len, const index_t other_dim,
+                                  const DType *batch_sizes, const bool backward) {
+    index_t off = 0, last_off = 0;
+    for (index_t t = 0; t < max_seq_len; ++t) {
+      const index_t step_batch = static_cast<index_t>(batch_sizes[t]);
+      if (static_cast<index_t>(i) < step_batch) last_off = off;
+      off += step_batch;
+    }
+    DType *row = packed + (last_off + i) * other_dim;
+    DType *out = last + i * other_dim;
+    for (index_t j = 0; j < other_dim; ++j) {
+      if (backward) {
+        KERNEL_ASSIGN(row[j], req, out[j]);
+      } else {
+        KERNEL_ASSIGN(out[j], req, row[j]);
+      }
+    }
   }
 };
 
@@ -69,9 +103,14 @@ class SequenceLastOp : public Operator {
     using namespace mshadow;
     using namespace mshadow::expr;
 
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
     CHECK_EQ(out_data.size(), 1U);
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      PackedLast(s, in_data[seq_last::kData], in_data[seq_last::kSequenceLength],
+                 out_data[seq_last::kOut], req[seq_last::kOut], false);
+      return;
+    }
 
     // Get any size input + output into required form
     index_t n = in_data[seq_last::kData].size(1);
@@ -112,12 +151,21 @@ class SequenceLastOp : public Operator {
     using namespace mshadow;
     using namespace mshadow::expr;
     CHECK_EQ(out_grad.size(), 1U);
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
 
     // break immediately if null grad
     if (req[seq_last::kData] == kNullOp) return;
 
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      if (req[seq_last::kData] == kWriteTo) {
+        Tensor<xpu, 1, DType> data_grad = in_grad[seq_last::kData].FlatTo1D<xpu, DType>(s);
+        data_grad = 0.0f;
+      }
+      PackedLast(s, in_grad[seq_last::kData], in_data[seq_last::kSequenceLength],
+                 out_grad[seq_last::kOut], kAddTo, true);
+      return;
+    }
 
     // Get any size input + output into required form
     index_t n = in_grad[seq_last::kData].size(1);
@@ -148,6 +196,19 @@ class SequenceLastOp : public Operator {
   }
 
  private:
+  /*! \brief gathers the last steps of packed sequences, or scatters their gradient */
+  void PackedLast(mshadow::Stream<xpu> *s, const TBlob &packed, const TBlob &batch_sizes,
+                  const TBlob &last, const OpReqType req, const bool backward) {
+    const index_t max_seq_len = batch_sizes.Size();
+    const index_t n = packed.shape_[0] / max_seq_len;
+    std::vector<int> batch_sizes_vec(max_seq_len);
+    IndexTensorToVector(batch_sizes.get<xpu, 1, DType>(s), &batch_sizes_vec);
+    CheckBatchSizes(batch_sizes_vec, n);
+    mxnet_op::Kernel<PackedLastKernel, xpu>::Launch(
+        s, n, last.dptr<DType>(), packed.dptr<DType>(), req, max_seq_len,
+        packed.Size() / packed.shape_[0], batch_sizes.dptr<DType>(), backward);
+  }
+
   SequenceLastParam param_;
 };  // class SequenceLastOp
 
@@ -160,7 +221,9 @@ class SequenceLastProp : public OperatorProperty {
   int NumOutputs() const override { return 1; }
 
   std::vector<std::string> ListArguments() const override {
-    if (param_.use_sequence_length)
+    if (param_.packed)
+      return {"data", "batch_sizes"};
+    else if (param_.use_sequence_length)
       return {"data", "sequence_length"};
     else
       return {"data"};
@@ -180,10 +243,26 @@ class SequenceLastProp : public OperatorProperty {
   bool InferShape(std::vector<TShape> *in_shape, std::vector<TShape> *out_shape,
                   std::vector<TShape> *aux_shape) const override {
     using namespace mshadow;
-    CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
+    CHECK_EQ(in_shape->size(), static_cast<size_t>(param_.NumInputs()))
         << "Input:[data, sequence_length]";
 
     const TShape &dshape = (*in_shape)[seq_last::kData];
+    if (param_.packed) {
+      // packed data: [max_sequence_length * batch_size, other_feature_dims]
+      const TShape &bshape = (*in_shape)[seq_last::kSequenceLength];
+      if (dshape.ndim() == 0 || bshape.ndim() == 0) return false;
+      CHECK_GT(dshape.ndim(), 1U)
+          << "The packed data array must be of rank 2 or greater.";
+      CHECK_EQ(bshape.ndim(), 1U) << "batch_sizes must be a vector";
+      CHECK_EQ(dshape[0] % bshape[0], 0U)
+          << "The packed data array of shape " << dshape << " does not hold "
+          << bshape[0] << " steps";
+      TShape oshape = dshape;
+      oshape[0] = dshape[0] / bshape[0];
+      out_shape->clear();
+      out_shape->push_back(oshape);
+      return true;
+    }
     CHECK_GT(dshape.ndim(), 2U)
         << "The data array must be of rank 3 or greater.";
     // seq length vector is same as batch size
@@ -203,7 +282,7 @@ class SequenceLastProp : public OperatorProperty {
 
   bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                  std::vector<int> *aux_type) const override {
-    CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_GE(in_type->size(), static_cast<size_t>(param_.NumInputs()));
     int dtype = (*in_type)[0];
     CHECK_NE(dtype, -1) << "First input must have specified type";
     for (index_t i = 0; i < in_type->size(); ++i) {
@@ -232,7 +311,7 @@ class SequenceLastProp : public OperatorProperty {
   std::vector<int> DeclareBackwardDependency(
       const std::vector<int> &out_grad, const std::vector<int> &in_data,
       const std::vector<int> &out_data) const override {
-    if (param_.use_sequence_length)
+    if (param_.use_sequence_length || param_.packed)
       return {out_grad[seq_last::kOut], in_data[seq_last::kSequenceLength]};
     else
       return {out_grad[seq_last::kOut]};
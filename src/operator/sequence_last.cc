@@ -55,6 +55,10 @@ an input array of positive ints of dimension [batch_size]. To use this parameter
 set `use_sequence_length` to `True`, otherwise each example in the batch is assumed
 to have the max sequence length.
 
+With `packed` set to `True`, `data` holds packed sequences of the form
+[max_sequence_length * batch_size, other_feature_dims] as returned by `SequencePack`,
+and the extra input is the `batch_sizes` of their steps instead of `sequence_length`.
+
 .. note:: Alternatively, you can also use `take` operator.
 
 Example::
@@ -93,7 +97,8 @@ Example::
                   "n-dimensional input array of the form [max_sequence_length,"
                   " batch_size, other_feature_dims] where n>2")
     .add_argument("sequence_length", "NDArray-or-Symbol",
-                  "vector of sequence lengths of the form [batch_size]")
+                  "vector of sequence lengths of the form [batch_size], or of the"
+                  " batch sizes of the steps of the form [max_sequence_length] when packed")
     .add_arguments(SequenceLastParam::__FIELDS__());
 
 }  // namespace op
@@ -36,7 +36,8 @@
 #include <utility>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
-#include "./operator_common.h"
+#include "./mxnet_op.h"
+#include "./sequence_op_common.h"
 
 namespace mxnet {
 namespace op {
@@ -49,6 +50,7 @@ enum SequenceMaskOpOutputs { kOut };
 struct SequenceMaskParam : public dmlc::Parameter<SequenceMaskParam> {
   bool use_sequence_length;
   float value;
+  bool packed;
   DMLC_DECLARE_PARAMETER(SequenceMaskParam) {
     DMLC_DECLARE_FIELD(use_sequence_length)
         .set_default(false)
@@ -57,6 +59,33 @@ struct SequenceMaskParam : public dmlc::Parameter<SequenceMaskParam> {
             "to specify variable length sequence");
     DMLC_DECLARE_FIELD(value).set_default(0.).describe(
         "The value to be used as a mask.");
+    DMLC_DECLARE_FIELD(packed)
+        .set_default(false)
+        .describe(
+            "If set to true, `data` holds packed sequences as returned by SequencePack, "
+            "and the extra input is the `batch_sizes` of their steps. Only the padding "
+            "rows past the packed steps are masked.");
+  }
+  int NumInputs() const { return (use_sequence_length || packed) ? 2 : 1; }
+};
+
+/*! \brief sets the padding rows of the sequence i of packed sequences to value */
+struct PackedMaskKernel {
+  template <typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *data, const index_t max_seq_len,
+                                  const index_t batch_size, const index_t other_dim,
+                                  const DType *batch_sizes, const DType value) {
+    const index_t n = static_cast<index_t>(i);
+    const index_t total = PackedTotal(batch_sizes, max_seq_len);
+    index_t off = 0;
+    for (index_t t = 0; t < max_seq_len; ++t) {
+      const index_t step_batch = static_cast<index_t>(batch_sizes[t]);
+      if (n >= step_batch) {
+        DType *row = data + PackedRow(t, n, off, total, step_batch, batch_size) * other_dim;
+        for (index_t j = 0; j < other_dim; ++j) row[j] = value;
+      }
+      off += step_batch;
+    }
   }
 };
 
@@ -71,9 +100,17 @@ class SequenceMaskOp : public Operator {
                        const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
     using namespace mshadow::expr;
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
     CHECK_EQ(out_data.size(), 1U);
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      Tensor<xpu, 1, DType> data = in_data[seq_mask::kData].FlatTo1D<xpu, DType>(s);
+      Tensor<xpu, 1, DType> out = out_data[seq_mask::kOut].FlatTo1D<xpu, DType>(s);
+      Assign(out, req[seq_mask::kOut], F<mshadow_op::identity>(data));
+      PackedMask(s, out_data[seq_mask::kOut], in_data[seq_mask::kSequenceLength],
+                 static_cast<DType>(param_.value));
+      return;
+    }
 
     // Get any size input + output into required form
     int max_seq_len = in_data[seq_mask::kData].size(0);
@@ -104,8 +141,15 @@ class SequenceMaskOp : public Operator {
     using namespace mshadow;
     using namespace mshadow::expr;
     CHECK_EQ(out_grad.size(), 1U);
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      Tensor<xpu, 1, DType> data_grad = in_grad[seq_mask::kData].FlatTo1D<xpu, DType>(s);
+      Tensor<xpu, 1, DType> output_grad = out_grad[seq_mask::kOut].FlatTo1D<xpu, DType>(s);
+      Assign(data_grad, req[seq_mask::kData], F<mshadow_op::identity>(output_grad));
+      PackedMask(s, in_grad[seq_mask::kData], in_data[seq_mask::kSequenceLength], DType(0));
+      return;
+    }
 
     // Get any size input + output into required form
     int max_seq_len = in_grad[seq_mask::kData].size(0);
@@ -131,6 +175,16 @@ class SequenceMaskOp : public Operator {
   }
 
  private:
+  /*! \brief masks the padding rows of packed sequences */
+  void PackedMask(mshadow::Stream<xpu> *s, const TBlob &data, const TBlob &batch_sizes,
+                  const DType value) {
+    const index_t max_seq_len = batch_sizes.Size();
+    const index_t batch_size = data.shape_[0] / max_seq_len;
+    mxnet_op::Kernel<PackedMaskKernel, xpu>::Launch(
+        s, batch_size, data.dptr<DType>(), max_seq_len, batch_size,
+        data.Size() / data.shape_[0], batch_sizes.dptr<DType>(), value);
+  }
+
   SequenceMaskParam param_;
 };  // class SequenceMaskOp
 
@@ -145,7 +199,9 @@ class SequenceMaskProp : public OperatorProperty {
   int NumOutputs() const override { return 1; }
 
   std::vector<std::string> ListArguments() const override {
-    if (param_.use_sequence_length)
+    if (param_.packed)
+      return {"data", "batch_sizes"};
+    else if (param_.use_sequence_length)
       return {"data", "sequence_length"};
     else
       return {"data"};
@@ -165,10 +221,24 @@ class SequenceMaskProp : public OperatorProperty {
   bool InferShape(std::vector<TShape> *in_shape, std::vector<TShape> *out_shape,
                   std::vector<TShape> *aux_shape) const override {
     using namespace mshadow;
-    CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
+    CHECK_EQ(in_shape->size(), static_cast<size_t>(param_.NumInputs()))
         << "Input:[data, sequence_length]";
 
     const TShape &dshape = (*in_shape)[seq_mask::kData];
+    if (param_.packed) {
+      // packed data: [max_sequence_length * batch_size, other_feature_dims]
+      const TShape &bshape = (*in_shape)[seq_mask::kSequenceLength];
+      if (dshape.ndim() == 0 || bshape.ndim() == 0) return false;
+      CHECK_GT(dshape.ndim(), 1U)
+          << "The packed data array must be of rank 2 or greater.";
+      CHECK_EQ(bshape.ndim(), 1U) << "batch_sizes must be a vector";
+      CHECK_EQ(dshape[0] % bshape[0], 0U)
+          << "The packed data array of shape " << dshape << " does not hold "
+          << bshape[0] << " steps";
+      out_shape->clear();
+      out_shape->push_back(dshape);
+      return true;
+    }
     CHECK_GT(dshape.ndim(), 2U)
         << "The data array must be of rank 3 or greater.";
     // seq length vector is same as batch size
@@ -184,7 +254,7 @@ class SequenceMaskProp : public OperatorProperty {
 
   bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                  std::vector<int> *aux_type) const override {
-    CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_GE(in_type->size(), static_cast<size_t>(param_.NumInputs()));
     int dtype = (*in_type)[0];
     CHECK_NE(dtype, -1) << "First input must have specified type";
     for (index_t i = 0; i < in_type->size(); ++i) {
@@ -213,7 +283,7 @@ class SequenceMaskProp : public OperatorProperty {
   std::vector<int> DeclareBackwardDependency(
       const std::vector<int> &out_grad, const std::vector<int> &in_data,
       const std::vector<int> &out_data) const override {
-    if (param_.use_sequence_length)
+    if (param_.use_sequence_length || param_.packed)
       return {out_grad[seq_mask::kOut], in_data[seq_mask::kSequenceLength]};
     else
       return {out_grad[seq_mask::kOut]};
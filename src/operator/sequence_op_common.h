@@ -32,6 +32,51 @@
 namespace mxnet {
 namespace op {
 
+/*!
+ * Packed sequences hold the steps of a batch of sequences sorted by
+ * decreasing length one after the other: the rows of the step t are the
+ * batch_sizes[t] sequences longer than t. An array of packed sequences keeps
+ * the size of the padded one, (max_sequence_length * batch_size,
+ * other_feature_dims), its rows past the sum of the batch sizes are the
+ * padding, in the order of the padded steps.
+ */
+
+/*! \brief sum of the batch sizes of the steps of packed sequences */
+template <typename DType>
+MSHADOW_XINLINE index_t PackedTotal(const DType *batch_sizes, index_t max_seq_len) {
+  index_t total = 0;
+  for (index_t t = 0; t < max_seq_len; ++t) total += static_cast<index_t>(batch_sizes[t]);
+  return total;
+}
+
+/*!
+ * \brief row of the step t of the sequence i in packed sequences, or of its
+ *  padding when the sequence is not longer than t
+ * \param off number of rows of the steps before t
+ * \param total sum of the batch sizes
+ * \param step_batch batch size of the step t
+ */
+MSHADOW_XINLINE index_t PackedRow(index_t t, index_t i, index_t off, index_t total,
+                                  index_t step_batch, index_t batch_size) {
+  return i < step_batch ? off + i : total + t * batch_size - off + (i - step_batch);
+}
+
+/*!
+ * \brief checks that batch_sizes are the batch sizes of the steps of packed
+ *  sequences of batch_size sequences
+ */
+template <typename RType>
+inline void CheckBatchSizes(const std::vector<RType> &batch_sizes, index_t batch_size) {
+  CHECK(!batch_sizes.empty() && batch_sizes[0] == static_cast<RType>(batch_size))
+      << "The first step of packed sequences must hold all the " << batch_size
+      << " sequences";
+  for (size_t t = 1; t < batch_sizes.size(); ++t) {
+    CHECK(batch_sizes[t] >= 0 && batch_sizes[t] <= batch_sizes[t - 1])
+        << "The batch sizes of packed sequences must be non-increasing, got "
+        << batch_sizes[t] << " after " << batch_sizes[t - 1] << " at step " << t;
+  }
+}
+
 template <typename DType, typename RType>
 typename std::enable_if<std::is_integral<RType>::value>::type
 IndexTensorToVector(mshadow::Tensor<gpu, 1, DType> data,
@@ -0,0 +1,217 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file sequence_pack-inl.h
+ * \brief conversions between padded and packed sequences
+*/
+#ifndef MXNET_OPERATOR_SEQUENCE_PACK_INL_H_
+#define MXNET_OPERATOR_SEQUENCE_PACK_INL_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/operator_util.h>
+#include <vector>
+#include "./mxnet_op.h"
+#include "./operator_common.h"
+#include "./elemwise_op_common.h"
+#include "./sequence_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace seq_pack {
+enum SequencePackOpInputs { kData, kSequenceLength };
+enum SequencePackOpOutputs { kOut, kBatchSizes };
+}
+
+/*! \brief batch_sizes[t] is the number of sequences longer than t */
+struct PackedBatchSizesKernel {
+  template <typename DType>
+  MSHADOW_XINLINE static void Map(int t, DType *batch_sizes, const DType *lengths,
+                                  const index_t batch_size) {
+    index_t n = 0;
+    for (index_t i = 0; i < batch_size; ++i) {
+      if (static_cast<index_t>(lengths[i]) > static_cast<index_t>(t)) ++n;
+    }
+    batch_sizes[t] = static_cast<DType>(n);
+  }
+};
+
+/*!
+ * \brief copies the steps of the sequence i between the padded and the
+ *  packed layouts, the padding of the output is zero
+ */
+struct PackSequenceKernel {
+  template <typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out, const DType *in, const OpReqType req,
+                                  const index_t max_seq_len, const index_t batch_size,
+                                  const index_t other_dim, const DType *batch_sizes,
+                                  const bool unpack) {
+    const index_t total = PackedTotal(batch_sizes, max_seq_len);
+    index_t off = 0;
+    for (index_t t = 0; t < max_seq_len; ++t) {
+      const index_t step_batch = static_cast<index_t>(batch_sizes[t]);
+      const index_t packed_row = PackedRow(t, i, off, total, step_batch, batch_size);
+      const index_t padded_row = t * batch_size + i;
+      const bool valid = static_cast<index_t>(i) < step_batch;
+      DType *dst = out + (unpack ? padded_row : packed_row) * other_dim;
+      const DType *src = in + (unpack ? packed_row : padded_row) * other_dim;
+      for (index_t j = 0; j < other_dim; ++j) {
+        KERNEL_ASSIGN(dst[j], req, valid ? src[j] : DType(0));
+      }
+      off += step_batch;
+    }
+  }
+};
+
+/*!
+ * \brief packs or unpacks the (max_seq_len, batch_size, other_dim) sequences
+ *  with the batch sizes already in batch_sizes
+ */
+template <typename xpu, typename DType>
+inline void PackSequences(mshadow::Stream<xpu> *s, const TBlob &in, const TBlob &batch_sizes,
+                          const OpReqType req, const TBlob &out, const bool unpack) {
+  if (req == kNullOp) return;
+  const TShape &padded = unpack ? out.shape_ : in.shape_;
+  const index_t max_seq_len = padded[0], batch_size = padded[1];
+  const index_t other_dim = padded.Size() / max_seq_len / batch_size;
+  mxnet_op::Kernel<PackSequenceKernel, xpu>::Launch(
+      s, batch_size, out.dptr<DType>(), in.dptr<DType>(), req, max_seq_len, batch_size,
+      other_dim, batch_sizes.dptr<DType>(), unpack);
+}
+
+/*! \brief data (T, N, ...) and sequence_length (N,) to packed (T * N, ...) and batch_sizes (T,) */
+inline bool SequencePackShape(const nnvm::NodeAttrs& attrs,
+                              std::vector<TShape> *in_attrs,
+                              std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  const TShape &dshape = (*in_attrs)[seq_pack::kData];
+  if (dshape.ndim() == 0) return false;
+  CHECK_GT(dshape.ndim(), 2U)
+      << "The data array must be of rank 3 or greater.";
+  SHAPE_ASSIGN_CHECK(*in_attrs, seq_pack::kSequenceLength, mshadow::Shape1(dshape[1]));
+  TShape oshape(dshape.ndim() - 1);
+  oshape[0] = dshape[0] * dshape[1];
+  for (index_t i = 1; i < oshape.ndim(); ++i) oshape[i] = dshape[i + 1];
+  SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kOut, oshape);
+  SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kBatchSizes, mshadow::Shape1(dshape[0]));
+  return true;
+}
+
+/*! \brief packed (T * N, ...) and batch_sizes (T,) to data (T, N, ...) */
+inline bool SequenceUnpackShape(const nnvm::NodeAttrs& attrs,
+                                std::vector<TShape> *in_attrs,
+                                std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const TShape &dshape = (*in_attrs)[seq_pack::kData];
+  const TShape &bshape = (*in_attrs)[1];
+  if (dshape.ndim() == 0 || bshape.ndim() == 0) return false;
+  CHECK_GT(dshape.ndim(), 1U)
+      << "The packed array must be of rank 2 or greater.";
+  CHECK_EQ(bshape.ndim(), 1U) << "batch_sizes must be a vector";
+  const index_t max_seq_len = bshape[0];
+  CHECK_EQ(dshape[0] % max_seq_len, 0U)
+      << "The packed array of shape " << dshape << " does not hold " << max_seq_len
+      << " steps";
+  TShape oshape(dshape.ndim() + 1);
+  oshape[0] = max_seq_len;
+  oshape[1] = dshape[0] / max_seq_len;
+  for (index_t i = 2; i < oshape.ndim(); ++i) oshape[i] = dshape[i - 1];
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, oshape);
+  return true;
+}
+
+template <typename xpu>
+void SequencePackForward(const nnvm::NodeAttrs& attrs,
+                         const OpContext& ctx,
+                         const std::vector<TBlob>& inputs,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob &data = inputs[seq_pack::kData];
+  const index_t max_seq_len = data.shape_[0], batch_size = data.shape_[1];
+  MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+    Tensor<xpu, 1, DType> lengths =
+        inputs[seq_pack::kSequenceLength].get<xpu, 1, DType>(s);
+    std::vector<index_t> lengths_vec(batch_size);
+    IndexTensorToVector(lengths, &lengths_vec);
+    for (index_t i = 0; i < batch_size; ++i) {
+      CHECK(lengths_vec[i] >= 1 && lengths_vec[i] <= max_seq_len)
+          << "The length " << lengths_vec[i] << " of the sequence " << i
+          << " is out of [1, " << max_seq_len << "]";
+      CHECK(i == 0 || lengths_vec[i] <= lengths_vec[i - 1])
+          << "The sequences to pack must be sorted by decreasing length";
+    }
+    // the batch sizes are always written, the packing reads them
+    mxnet_op::Kernel<PackedBatchSizesKernel, xpu>::Launch(
+        s, max_seq_len, outputs[seq_pack::kBatchSizes].dptr<DType>(), lengths.dptr_,
+        batch_size);
+    PackSequences<xpu, DType>(s, data, outputs[seq_pack::kBatchSizes],
+                              req[seq_pack::kOut], outputs[seq_pack::kOut], false);
+  });
+}
+
+template <typename xpu>
+void SequenceUnpackForward(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    PackSequences<xpu, DType>(s, inputs[0], inputs[1], req[0], outputs[0], true);
+  });
+}
+
+/*!
+ * \brief the gradient of the padded data is the unpacked gradient of the
+ *  packed one, or the packed gradient of the padded one for SequenceUnpack
+ *  inputs: output gradient, batch sizes
+ *  outputs: gradient of the data, zero gradient of the lengths or batch sizes
+ */
+template <typename xpu, bool unpack>
+void SequencePackBackward(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    PackSequences<xpu, DType>(s, inputs[0], inputs[1], req[0], outputs[0], unpack);
+    if (req[1] != kNullOp && req[1] != kAddTo) {
+      Tensor<xpu, 1, DType> grad = outputs[1].FlatTo1D<xpu, DType>(s);
+      grad = DType(0);
+    }
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_SEQUENCE_PACK_INL_H_
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file sequence_pack.cc
+ * \brief conversions between padded and packed sequences
+*/
+#include "./sequence_pack-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(SequencePack)
+.describe(R"code(Packs variable-length sequences, without their padding.
+
+This function takes an n-dimensional input array of the form
+[max_sequence_length, batch_size, other_feature_dims] and the lengths of its sequences,
+positive ints of dimension [batch_size] sorted in decreasing order. It returns the
+packed sequences, of the form [max_sequence_length * batch_size, other_feature_dims],
+where the steps of the sequences are stored one after the other, and the batch sizes
+of the steps: step t holds the ``batch_sizes[t]`` sequences longer than t. The rows
+past the sum of the batch sizes are zeros.
+
+The packed sequences are taken by ``RNN``, ``SequenceLast``, ``SequenceMask`` and
+``SequenceReverse`` with ``packed=True``, which skip the padding of the sequences.
+``SequenceUnpack`` restores the padded layout.
+
+Example::
+
+   x = [[[  1.,   2.],
+         [  3.,   4.]],
+
+        [[  5.,   6.],
+         [  7.,   8.]],
+
+        [[  9.,  10.],
+         [ 11.,  12.]]]
+
+   packed, batch_sizes = SequencePack(x, sequence_length=[3, 1])
+
+   packed = [[  1.,   2.],
+             [  3.,   4.],
+             [  5.,   6.],
+             [  9.,  10.],
+             [  0.,   0.],
+             [  0.,   0.]]
+
+   batch_sizes = [2, 1, 1]
+
+)code" ADD_FILELINE)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "sequence_length"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "batch_sizes"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", SequencePackShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 2>)
+.set_attr<FCompute>("FCompute<cpu>", SequencePackForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    return MakeGradNode("_backward_SequencePack", n,
+                        {ograds[seq_pack::kOut], nnvm::NodeEntry{n, seq_pack::kBatchSizes, 0}},
+                        n->attrs.dict);
+  })
+.add_argument("data", "NDArray-or-Symbol",
+              "n-dimensional input array of the form [max_sequence_length,"
+              " batch_size, other_feature_dims] where n>2")
+.add_argument("sequence_length", "NDArray-or-Symbol",
+              "vector of the sequence lengths of the form [batch_size], in decreasing order");
+
+NNVM_REGISTER_OP(_backward_SequencePack)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FCompute>("FCompute<cpu>", SequencePackBackward<cpu, true>);
+
+NNVM_REGISTER_OP(SequenceUnpack)
+.describe(R"code(Restores the padded layout of packed sequences.
+
+This function takes packed sequences of the form
+[max_sequence_length * batch_size, other_feature_dims] and the batch sizes of their
+steps, as returned by ``SequencePack``, and returns an array of the form
+[max_sequence_length, batch_size, other_feature_dims] padded with zeros.
+
+Example::
+
+   packed = [[  1.,   2.],
+             [  3.,   4.],
+             [  5.,   6.],
+             [  9.,  10.],
+             [  0.,   0.],
+             [  0.,   0.]]
+
+   SequenceUnpack(packed, batch_sizes=[2, 1, 1]) =
+                [[[  1.,   2.],
+                  [  3.,   4.]],
+
+                 [[  5.,   6.],
+                  [  0.,   0.]],
+
+                 [[  9.,  10.],
+                  [  0.,   0.]]]
+
+)code" ADD_FILELINE)
+.set_num_inputs(2)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "batch_sizes"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", SequenceUnpackShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
+.set_attr<FCompute>("FCompute<cpu>", SequenceUnpackForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    return MakeGradNode("_backward_SequenceUnpack", n,
+                        {ograds[0], n->inputs[1]}, n->attrs.dict);
+  })
+.add_argument("data", "NDArray-or-Symbol",
+              "packed sequences of the form [max_sequence_length * batch_size,"
+              " other_feature_dims]")
+.add_argument("batch_sizes", "NDArray-or-Symbol",
+              "vector of the batch sizes of the steps of the form [max_sequence_length]");
+
+NNVM_REGISTER_OP(_backward_SequenceUnpack)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FCompute>("FCompute<cpu>", SequencePackBackward<cpu, false>);
+
+}  // namespace op
+}  // namespace mxnet
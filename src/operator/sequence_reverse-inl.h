@@ -50,6 +50,7 @@ enum SequenceReverseOpOutputs { kOut };
 
 struct SequenceReverseParam : public dmlc::Parameter<SequenceReverseParam> {
   bool use_sequence_length;
+  bool packed;
   DMLC_DECLARE_PARAMETER(SequenceReverseParam) {
     DMLC_DECLARE_FIELD(use_sequence_length)
         .set_default(false)
@@ -57,6 +58,49 @@ struct SequenceReverseParam : public dmlc::Parameter<SequenceReverseParam> {
             "If set to true, this layer takes in an extra input parameter "
             "`sequence_length` "
             "to specify variable length sequence");
+    DMLC_DECLARE_FIELD(packed)
+        .set_default(false)
+        .describe(
+            "If set to true, `data` holds packed sequences as returned by SequencePack, "
+            "and the extra input is the `batch_sizes` of their steps");
+  }
+  int NumInputs() const { return (use_sequence_length || packed) ? 2 : 1; }
+};
+
+/*!
+ * \brief reverses the steps of the sequence i of packed sequences, its
+ *  padding is copied as is
+ */
+struct PackedReverseKernel {
+  template <typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *out_data, const DType *in_data,
+                                  const OpReqType req, const index_t max_seq_len,
+                                  const index_t batch_size, const index_t other_dim,
+                                  const DType *batch_sizes) {
+    const index_t n = static_cast<index_t>(i);
+    // length of the sequence and first row of its last step
+    index_t len = 0, last_off = 0, total = 0;
+    for (index_t t = 0; t < max_seq_len; ++t) {
+      const index_t step_batch = static_cast<index_t>(batch_sizes[t]);
+      if (n < step_batch) {
+        len = t + 1;
+        last_off = total;
+      }
+      total += step_batch;
+    }
+    index_t off = 0, rev_off = last_off;
+    for (index_t t = 0; t < max_seq_len; ++t) {
+      const index_t step_batch = static_cast<index_t>(batch_sizes[t]);
+      const index_t in_row = PackedRow(t, n, off, total, step_batch, batch_size);
+      const index_t out_row = t < len ? rev_off + n : in_row;
+      for (index_t j = 0; j < other_dim; ++j) {
+        KERNEL_ASSIGN(out_data[out_row * other_dim + j], req,
+                      in_data[in_row * other_dim + j]);
+      }
+      // rows of the step len - 2 - t, ahead of the step len - 1 - t
+      if (t + 1 < len) rev_off -= static_cast<index_t>(batch_sizes[len - 2 - t]);
+      off += step_batch;
+    }
   }
 };
 
@@ -118,15 +162,32 @@ class SequenceReverseOp : public Operator {
         other_dim, tensor_numel, indices);
   }
 
+  /*! \brief reverses packed sequences with the batch sizes of their steps */
+  void packed_sequence_reverse(const TBlob &data, const TBlob &batch_sizes,
+                               const TBlob &out, const OpReqType req,
+                               mshadow::Stream<xpu> *const s) {
+    const index_t max_seq_len = batch_sizes.Size();
+    const index_t batch_size = data.shape_[0] / max_seq_len;
+    mxnet_op::Kernel<PackedReverseKernel, xpu>::Launch(
+        s, batch_size, out.dptr<DType>(), data.dptr<DType>(), req, max_seq_len,
+        batch_size, data.Size() / data.shape_[0], batch_sizes.dptr<DType>());
+  }
+
   virtual void Forward(const OpContext &ctx, const std::vector<TBlob> &in_data,
                        const std::vector<OpReqType> &req,
                        const std::vector<TBlob> &out_data,
                        const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
     using namespace mshadow::expr;
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
     CHECK_EQ(out_data.size(), 1U);
     Stream<xpu> *const s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      packed_sequence_reverse(in_data[seq_reverse::kData],
+                              in_data[seq_reverse::kSequenceLength],
+                              out_data[seq_reverse::kOut], req[seq_reverse::kOut], s);
+      return;
+    }
 
     // Get any size input + output into required form
     int max_seq_len = in_data[seq_reverse::kData].size(0);
@@ -158,8 +219,15 @@ class SequenceReverseOp : public Operator {
     using namespace mshadow;
     using namespace mshadow::expr;
     CHECK_EQ(out_grad.size(), 1U);
-    CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_EQ(in_data.size(), static_cast<size_t>(param_.NumInputs()));
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (param_.packed) {
+      // the reversal of the steps is its own inverse
+      packed_sequence_reverse(out_grad[seq_reverse::kOut],
+                              in_data[seq_reverse::kSequenceLength],
+                              in_grad[seq_reverse::kData], req[seq_reverse::kData], s);
+      return;
+    }
 
     // Get any size input + output into required form
     int max_seq_len = in_grad[seq_reverse::kData].size(0);
@@ -197,7 +265,9 @@ class SequenceReverseProp : public OperatorProperty {
   int NumOutputs() const override { return 1; }
 
   std::vector<std::string> ListArguments() const override {
-    if (param_.use_sequence_length)
+    if (param_.packed)
+      return {"data", "batch_sizes"};
+    else if (param_.use_sequence_length)
       return {"data", "sequence_length"};
     else
       return {"data"};
@@ -217,10 +287,24 @@ class SequenceReverseProp : public OperatorProperty {
   bool InferShape(std::vector<TShape> *in_shape, std::vector<TShape> *out_shape,
                   std::vector<TShape> *aux_shape) const override {
     using namespace mshadow;
-    CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
+    CHECK_EQ(in_shape->size(), static_cast<size_t>(param_.NumInputs()))
         << "Input:[data, sequence_length]";
 
     const TShape &dshape = (*in_shape)[seq_reverse::kData];
+    if (param_.packed) {
+      // packed data: [max_sequence_length * batch_size, other_feature_dims]
+      const TShape &bshape = (*in_shape)[seq_reverse::kSequenceLength];
+      if (dshape.ndim() == 0 || bshape.ndim() == 0) return false;
+      CHECK_GT(dshape.ndim(), 1U)
+          << "The packed data array must be of rank 2 or greater.";
+      CHECK_EQ(bshape.ndim(), 1U) << "batch_sizes must be a vector";
+      CHECK_EQ(dshape[0] % bshape[0], 0U)
+          << "The packed data array of shape " << dshape << " does not hold "
+          << bshape[0] << " steps";
+      out_shape->clear();
+      out_shape->push_back(dshape);
+      return true;
+    }
     CHECK_GT(dshape.ndim(), 2U)
         << "The data array must be of rank 3 or greater.";
     // seq length vector is same as batch size
@@ -236,7 +320,7 @@ class SequenceReverseProp : public OperatorProperty {
 
   bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                  std::vector<int> *aux_type) const override {
-    CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+    CHECK_GE(in_type->size(), static_cast<size_t>(param_.NumInputs()));
     int dtype = (*in_type)[0];
     CHECK_NE(dtype, -1) << "First input must have specified type";
     for (index_t i = 0; i < in_type->size(); ++i) {
@@ -265,7 +349,7 @@ class SequenceReverseProp : public OperatorProperty {
   std::vector<int> DeclareBackwardDependency(
       const std::vector<int> &out_grad, const std::vector<int> &in_data,
       const std::vector<int> &out_data) const override {
-    if (param_.use_sequence_length)
+    if (param_.use_sequence_length || param_.packed)
       return {out_grad[seq_reverse::kOut],
               in_data[seq_reverse::kSequenceLength]};
     else
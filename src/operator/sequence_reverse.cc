@@ -54,6 +54,11 @@ Parameter `sequence_length` is used to handle variable-length sequences.
 To use this parameter, set `use_sequence_length` to `True`,
 otherwise each example in the batch is assumed to have the max sequence length.
 
+With `packed` set to `True`, `data` holds packed sequences of the form
+[max_sequence_length * batch_size, other_feature_dims] as returned by `SequencePack`,
+and the extra input is the `batch_sizes` of their steps instead of `sequence_length`.
+The output holds the reversed sequences packed the same way.
+
 Example::
 
    x = [[[  1.,   2.,   3.],
@@ -114,7 +119,8 @@ Example::
                   "n-dimensional input array of the form [max_sequence_length,"
                   " batch_size, other dims] where n>2 ")
     .add_argument("sequence_length", "NDArray-or-Symbol",
-                  "vector of sequence lengths of the form [batch_size]")
+                  "vector of sequence lengths of the form [batch_size], or of the"
+                  " batch sizes of the steps of the form [max_sequence_length] when packed")
     .add_arguments(SequenceReverseParam::__FIELDS__());
 
 }  // namespace op
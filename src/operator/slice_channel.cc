@@ -108,7 +108,20 @@ Example::
 .add_argument("data", "NDArray-or-Symbol", "The input")
 .add_arguments(SliceChannelParam::__FIELDS__());
 
-NNVM_REGISTER_OP(SliceChannel).add_alias("split");
+NNVM_REGISTER_OP(SliceChannel).add_alias("split")
+.set_attr<FOutputViews>("FOutputViews",
+  [](const NodeAttrs& attrs, const TShape& ishape, std::vector<size_t>* offsets) {
+    SliceChannelParam param;
+    param.InitAllowUnknown(attrs.dict);
+    const int axis = param.axis < 0 ? param.axis + ishape.ndim() : param.axis;
+    for (int i = 0; i < axis; ++i) {
+      if (ishape[i] != 1) return false;
+    }
+    const size_t size = ishape.Size() / param.num_outputs;
+    offsets->clear();
+    for (int i = 0; i < param.num_outputs; ++i) offsets->push_back(i * size);
+    return true;
+  });
 
 }  // namespace op
 }  // namespace mxnet
@@ -32,8 +32,10 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include "./operator_common.h"
+#include "./tensor/transpose_cpu.h"
 
 namespace mxnet {
 namespace op {
@@ -117,6 +119,13 @@ class SwapAxisOp : public Operator {
 
     Reshape2Five(&inter_shape, shape_in, dim1, dim2);
 
+    if (std::is_same<xpu, cpu>::value) {
+      TShape shape5(inter_shape.shape_, inter_shape.shape_ + 5);
+      TShape axes5 = {0, 3, 2, 1, 4};
+      TransposeCPU(data_in.dptr<DType>(), data_out.dptr<DType>(), shape5, axes5);
+      return;
+    }
+
     Tensor<xpu, 5, DType> inter_data_in = data_in.get_with_shape<xpu, 5, DType>(inter_shape, s);
 
     Shape<5> inter_shape2 = inter_shape;
@@ -281,6 +281,119 @@ __global__ void reduce_kernel_M1(const int N, const bool addto,
   }
 }
 
+// Reduction of the rows of big, a (N, M) matrix, when the reduced axes are its
+// innermost ones. Rows up to kReduceRowsWarpMax long are reduced by one warp, longer
+// rows by a block of kReduceRowsBlock threads, which can be split in Mnext parts
+// reduced by different blocks when there are few rows.
+enum ReduceRowsMode {kReduceGeneric, kReduceRowsWarp, kReduceRowsBlock};
+const int kReduceRowsWarps = 8;
+const int kReduceRowsBlock = 256;
+const int kReduceRowsWarpMax = 1024;
+const int kReduceRowsSplitN = 256;
+
+// Shuffles value down the warp as 32 bit words, so that any type can be exchanged.
+template<typename DType>
+__device__ __forceinline__ DType reduce_shfl_down(DType value, int delta) {
+  const int nword = (sizeof(DType) + sizeof(int) - 1) / sizeof(int);
+  int word[nword];
+  memcpy(word, &value, sizeof(DType));
+  #pragma unroll
+  for (int w = 0; w < nword; ++w) {
+#if CUDA_VERSION >= 9000
+    word[w] = __shfl_down_sync(0xFFFFFFFF, word[w], delta);
+#else
+    word[w] = __shfl_down(word[w], delta);
+#endif
+  }
+  DType ret;
+  memcpy(&ret, word, sizeof(DType));
+  return ret;
+}
+
+// Reduces val over the warp, the result is in lane 0.
+template<typename Reducer, typename DType>
+__device__ __forceinline__ void reduce_warp(DType *val) {
+  #pragma unroll
+  for (int delta = 16; delta > 0; delta >>= 1) {
+    DType other = reduce_shfl_down(*val, delta);
+    Reducer::Reduce(*val, other);
+  }
+}
+
+template<typename Reducer, typename DType, typename OP>
+__launch_bounds__(kReduceRowsWarps * 32)
+__global__ void reduce_rows_warp_kernel(const int N, const int M, const bool addto,
+                                        const DType* __restrict big, DType *small) {
+  for (int row = blockIdx.x*blockDim.y + threadIdx.y; row < N; row += blockDim.y*gridDim.x) {
+    const DType* in = big + static_cast<size_t>(row)*M;
+    DType val;
+    Reducer::SetInitValue(val);
+    for (int k = threadIdx.x; k < M; k += warpSize) {
+      Reducer::Reduce(val, OP::Map(in[k]));
+    }
+    reduce_warp<Reducer>(&val);
+    if (threadIdx.x == 0) {
+      assign(&small[row], addto, val);
+    }
+  }
+}
+
+template<typename Reducer, typename DType, typename OP>
+__launch_bounds__(kReduceRowsBlock)
+__global__ void reduce_rows_block_kernel(const int N, const int M, const bool addto,
+                                         const DType* __restrict big, DType *small,
+                                         const int Mnext) {
+  extern __shared__ char shWarpChar[];
+  DType* shWarp = reinterpret_cast<DType*>(shWarpChar);
+  const int warp = threadIdx.x / warpSize;
+  const int lane = threadIdx.x % warpSize;
+  const int nwarp = blockDim.x / warpSize;
+  for (int m0 = blockIdx.y; m0 < Mnext; m0 += gridDim.y) {
+    // This TB handles M range [Mstart, ...., Mend - 1] of its rows
+    const int Mstart = (int)((uint64_t)M*(uint64_t)m0/(uint64_t)Mnext);
+    const int Mend   = (int)((uint64_t)M*(uint64_t)(m0 + 1)/(uint64_t)Mnext);
+    for (int row = blockIdx.x; row < N; row += gridDim.x) {
+      const DType* in = big + static_cast<size_t>(row)*M;
+      DType val;
+      Reducer::SetInitValue(val);
+      for (int k = Mstart + threadIdx.x; k < Mend; k += blockDim.x) {
+        Reducer::Reduce(val, OP::Map(in[k]));
+      }
+      reduce_warp<Reducer>(&val);
+      if (lane == 0) shWarp[warp] = val;
+      __syncthreads();
+      if (warp == 0) {
+        if (lane < nwarp) {
+          val = shWarp[lane];
+        } else {
+          Reducer::SetInitValue(val);
+        }
+        reduce_warp<Reducer>(&val);
+        if (lane == 0) {
+          assign(&small[row + m0*N], addto, val);
+        }
+      }
+      __syncthreads();
+    }
+  }
+}
+
+// Returns true when the reduced axes of big are its innermost ones, big is then
+// a row major (N, M) matrix whose rows are reduced.
+template<int ndim>
+inline bool reduce_innermost(const Shape<ndim>& small, const Shape<ndim>& big) {
+  bool outer = false;
+  for (int i = ndim - 1; i >= 0; --i) {
+    if (big[i] == 1) continue;
+    if (small[i] == big[i]) {
+      outer = true;
+    } else if (outer) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Returns the stride with which the fastest dimension is moving.
 // Used to detect memory access scatter.
 template<int ndim>
@@ -309,6 +422,7 @@ struct ReduceImplConfig {
   int N;
   int M;
   int Mnext;
+  ReduceRowsMode rows_mode;
   struct {
     dim3 blockDim;
     dim3 gridDim;
@@ -368,11 +482,40 @@ ReduceImplConfig<ndim> ConfigureReduceImpl(const TBlob& small, const TBlob& big,
   }
 
   config.workspace_size = 0;
+  config.rows_mode = kReduceGeneric;
+  config.Mnext = 1;
 
   if (config.M == 1) {
     config.kernel_1.blockDim.x = kMaxThreadsPerBlock;
     config.kernel_1.gridDim.x = std::min((unsigned int)kBaseGridNum,
       (config.N + config.kernel_1.blockDim.x - 1)/config.kernel_1.blockDim.x);
+  } else if (!multiOp && reduce_innermost(small.shape_.get<ndim>(), big.shape_.get<ndim>())) {
+    // Contiguous rows, chosen by their length
+    if (config.M <= kReduceRowsWarpMax) {
+      config.rows_mode = kReduceRowsWarp;
+      config.kernel_1.blockDim = dim3(config.warpSize, kReduceRowsWarps);
+      config.kernel_1.gridDim = dim3(std::min((unsigned int)kBaseGridNum,
+        ceil_idiv<unsigned int>(config.N, kReduceRowsWarps)));
+      config.kernel_1.shMemSize = 0;
+    } else {
+      config.rows_mode = kReduceRowsBlock;
+      if (config.N < kReduceRowsSplitN) {
+        // Few long rows, split them between blocks
+        int maxMblock = kReduceRowsBlock*config.maxLoopPerTB;
+        config.Mnext = std::min(kBaseGridNum, (config.M + maxMblock - 1) / maxMblock);
+      }
+      config.kernel_1.blockDim = dim3(kReduceRowsBlock);
+      config.kernel_1.gridDim = dim3(std::min((unsigned int)kBaseGridNum,
+                                              (unsigned int)config.N),
+                                     config.Mnext);
+      config.kernel_1.shMemSize = (kReduceRowsBlock / config.warpSize)*sizeof(DType);
+    }
+    if (config.Mnext > 1) {
+      config.workspace_size += config.N*config.Mnext*sizeof(DType);
+      config.kernel_2.blockSize = kMaxThreadsPerBlock;
+      config.kernel_2.gridSize = std::min((int)kBaseGridNum,
+        (config.N + config.kernel_2.blockSize - 1)/config.kernel_2.blockSize );
+    }
   } else {
 
     int reduce_strides[3];
@@ -507,6 +650,27 @@ void ReduceImpl(cudaStream_t stream, const TBlob& small, const OpReqType req,
     <<< config.kernel_1.gridDim, config.kernel_1.blockDim, 0, stream >>>(
       config.N, req == kAddTo, big.dptr<DType>(), small.dptr<DType>(), big.shape_.get<ndim>(),
       small.shape_.get<ndim>());
+  } else if (config.rows_mode == kReduceRowsWarp) {
+    reduce_rows_warp_kernel<Reducer, DType, OP>
+    <<< config.kernel_1.gridDim, config.kernel_1.blockDim, 0, stream >>>(
+      config.N, config.M, req == kAddTo, big.dptr<DType>(), small.dptr<DType>());
+  } else if (config.rows_mode == kReduceRowsBlock) {
+    DType* small_dptr = small.dptr<DType>();
+    bool addto = (req == kAddTo);
+    if (config.Mnext > 1) {
+      small_dptr = reinterpret_cast<DType*>(workspace.dptr_);
+      addto = false;
+      CHECK_EQ(workspace.CheckContiguous(), true);
+      CHECK_GE(workspace.size(0), config.workspace_size);
+    }
+    reduce_rows_block_kernel<Reducer, DType, OP>
+    <<< config.kernel_1.gridDim, config.kernel_1.blockDim, config.kernel_1.shMemSize, stream >>>(
+      config.N, config.M, addto, big.dptr<DType>(), small_dptr, config.Mnext);
+    if (config.Mnext > 1) {
+      reduce_lines_kernel<Reducer, DType>
+      <<< config.kernel_2.gridSize, config.kernel_2.blockSize, 0, stream >>>
+        (config.N, config.Mnext, req == kAddTo, config.N, small_dptr, small.dptr<DType>());
+    }
   } else {
 
     DType* small_dptr = small.dptr<DType>();
@@ -33,6 +33,7 @@
 #include "../elemwise_op_common.h"
 #include "./elemwise_binary_op.h"
 #include "../operator_common.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
@@ -175,12 +176,78 @@ MSHADOW_XINLINE void seq_reduce_assign(const int idx, const int M, const bool ad
 
 #else
 
+/*!
+ * \brief number of threads of a CPU broadcast or reduce touching size elements
+ *  and the tasks splitting rows of inner elements into segments, so that
+ *  there are enough of them for all the threads
+ */
+inline int cpu_num_threads(const int size, const int rows, const int inner,
+                           int* nseg, int* seg_len) {
+  const int omp_threads = size < engine::OpenMP::Get()->min_parallel_size()
+      ? 1 : engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  *nseg = rows >= omp_threads ? 1 : std::min(inner, (omp_threads + rows - 1) / rows);
+  *nseg = std::max(*nseg, 1);
+  *seg_len = (inner + *nseg - 1) / *nseg;
+  return omp_threads;
+}
+
+/*!
+ * \brief out[i] (+)= OP(lhs[i * lstep], rhs[i * rstep]) for i in [begin, end),
+ *  the steps are 0 for a broadcast input, which keeps the loop vectorizable
+ */
+template<bool addto, int lstep, int rstep, typename DType, typename OP>
+inline void binary_broadcast_row(const DType* __restrict lhs, const DType* __restrict rhs,
+                                 DType* out, const int begin, const int end) {
+  for (int i = begin; i < end; ++i) {
+    const DType val = OP::Map(lhs[i * lstep], rhs[i * rstep]);
+    if (addto) {
+      out[i] += val;
+    } else {
+      out[i] = val;
+    }
+  }
+}
+
+template<bool addto, typename DType, typename OP>
+inline void binary_broadcast_row(const DType* lhs, const int lstep, const DType* rhs,
+                                 const int rstep, DType* out, const int begin, const int end) {
+  if (lstep && rstep) {
+    binary_broadcast_row<addto, 1, 1, DType, OP>(lhs, rhs, out, begin, end);
+  } else if (lstep) {
+    binary_broadcast_row<addto, 1, 0, DType, OP>(lhs, rhs, out, begin, end);
+  } else if (rstep) {
+    binary_broadcast_row<addto, 0, 1, DType, OP>(lhs, rhs, out, begin, end);
+  } else {
+    binary_broadcast_row<addto, 0, 0, DType, OP>(lhs, rhs, out, begin, end);
+  }
+}
+
 template<int ndim, typename DType, typename OP>
 void binary_broadcast_compute(const int N, const bool addto, const DType *lhs,
                               const DType *rhs, DType *out, const Shape<ndim> lshape,
                               const Shape<ndim> rshape, const Shape<ndim> oshape) {
-  for (int idx = 0; idx < N; ++idx) {
-    binary_broadcast_assign<ndim, DType, OP>(idx, addto, lhs, rhs, out, lshape, rshape, oshape);
+  // the coordinates are computed once per row of the innermost dimension,
+  // which is then processed with constant steps
+  const int inner = oshape[ndim - 1];
+  if (N == 0 || inner == 0) return;
+  const int rows = N / inner;
+  const Shape<ndim> lstride = calc_stride(lshape), rstride = calc_stride(rshape);
+  int nseg, seg_len;
+  const int omp_threads = cpu_num_threads(N, rows, inner, &nseg, &seg_len);
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int t = 0; t < rows * nseg; ++t) {
+    const int row = t / nseg;
+    const int begin = (t % nseg) * seg_len;
+    const int end = std::min(begin + seg_len, inner);
+    int j, k;
+    unravel_dot(row * inner, oshape, lstride, rstride, &j, &k);
+    if (addto) {
+      binary_broadcast_row<true, DType, OP>(lhs + j, lstride[ndim - 1], rhs + k,
+                                            rstride[ndim - 1], out + row * inner, begin, end);
+    } else {
+      binary_broadcast_row<false, DType, OP>(lhs + j, lstride[ndim - 1], rhs + k,
+                                             rstride[ndim - 1], out + row * inner, begin, end);
+    }
   }
 }
 
@@ -194,14 +261,129 @@ void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                            out.shape_.get<ndim>());
 }
 
+/*!
+ * \brief reduce contiguous elements into one value. The reducers take
+ *  volatile references, so sums, the common case, are specialized below.
+ */
+template<typename Reducer, typename DType, typename OP>
+struct contiguous_reduce {
+  /*! \brief reduce OP(big[i]) for i in [0, len) into val */
+  static inline void Reduce(const DType* __restrict big, const int len, DType* val) {
+    for (int i = 0; i < len; ++i) {
+      Reducer::Reduce(*val, OP::Map(big[i]));
+    }
+  }
+  /*! \brief reduce OP(big[i]) into acc[i] for i in [0, len) */
+  static inline void ReduceRow(const DType* __restrict big, const int len,
+                               DType* __restrict acc) {
+    for (int i = 0; i < len; ++i) {
+      Reducer::Reduce(acc[i], OP::Map(big[i]));
+    }
+  }
+};
+
+template<typename DType, typename OP>
+struct contiguous_reduce<mshadow::red::sum, DType, OP> {
+  static inline void Reduce(const DType* __restrict big, const int len, DType* val) {
+    // independent partial sums, which the compiler keeps in vector registers
+    const int kBlock = 8;
+    DType acc[kBlock];
+    for (int b = 0; b < kBlock; ++b) acc[b] = DType(0);
+    int i = 0;
+    for (; i + kBlock <= len; i += kBlock) {
+      for (int b = 0; b < kBlock; ++b) acc[b] += OP::Map(big[i + b]);
+    }
+    for (; i < len; ++i) acc[0] += OP::Map(big[i]);
+    DType sum = acc[0];
+    for (int b = 1; b < kBlock; ++b) sum += acc[b];
+    *val += sum;
+  }
+  static inline void ReduceRow(const DType* __restrict big, const int len,
+                               DType* __restrict acc) {
+    for (int i = 0; i < len; ++i) acc[i] += OP::Map(big[i]);
+  }
+};
+
+/*!
+ * \brief reduce the elements [kbegin, kend) of the reduced index of the
+ *  output starting at big, when the innermost dimension, of size len,
+ *  is reduced. Every run along that dimension is contiguous.
+ */
+template<typename Reducer, int ndim, typename DType, typename OP>
+inline void seq_reduce_inner(const DType* big, const int kbegin, const int kend,
+                             const int len, const Shape<ndim>& rshape,
+                             const Shape<ndim>& rstride, DType* val) {
+  for (int k = kbegin; k < kend;) {
+    const int offset = k % len;
+    const int run = std::min(kend - k, len - offset);
+    const int base = unravel_dot(k - offset, rshape, rstride) + offset;
+    contiguous_reduce<Reducer, DType, OP>::Reduce(big + base, run, val);
+    k += run;
+  }
+}
+
 template<typename Reducer, int ndim, typename DType, typename OP>
 void seq_reduce_compute(const int N, const int M, const bool addto,
                         const DType *big, DType *small, const Shape<ndim> bshape,
                         const Shape<ndim> sshape, const Shape<ndim> rshape,
                         const Shape<ndim> rstride) {
-  for (int idx = 0; idx < N; ++idx) {
-    seq_reduce_assign<Reducer, ndim, DType, OP>(idx, M, addto, big, small, bshape, sshape, rshape,
-      rstride);
+  if (N == 0) return;
+  const int size = N * M;
+  const int inner = bshape[ndim - 1];
+  if (sshape[ndim - 1] == 1 && inner > 1) {
+    // the innermost dimension is reduced. With few outputs, the reduced
+    // elements of every output are split into blocks reduced in parallel.
+    int nseg, seg_len;
+    const int omp_threads = cpu_num_threads(size, N, M, &nseg, &seg_len);
+    std::vector<DType> partial(N * nseg);
+    #pragma omp parallel for num_threads(omp_threads)
+    for (int t = 0; t < N * nseg; ++t) {
+      const int idx = t / nseg;
+      const int kbegin = (t % nseg) * seg_len;
+      const int j = ravel(unravel(idx, sshape), bshape);
+      DType val;
+      Reducer::SetInitValue(val);
+      seq_reduce_inner<Reducer, ndim, DType, OP>(big + j, kbegin, std::min(kbegin + seg_len, M),
+                                                 inner, rshape, rstride, &val);
+      partial[t] = val;
+    }
+    for (int idx = 0; idx < N; ++idx) {
+      DType val = partial[idx * nseg];
+      for (int seg = 1; seg < nseg; ++seg) Reducer::Reduce(val, partial[idx * nseg + seg]);
+      assign(&small[idx], addto, val);
+    }
+  } else if (sshape[ndim - 1] >= 8) {
+    // the innermost dimension is kept, every reduced element adds a
+    // contiguous row of big to a row of outputs
+    const int rows = N / inner;
+    int nseg, seg_len;
+    const int omp_threads = cpu_num_threads(size, rows, inner, &nseg, &seg_len);
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      std::vector<DType> acc(seg_len);
+      #pragma omp for
+      for (int t = 0; t < rows * nseg; ++t) {
+        const int row = t / nseg;
+        const int begin = (t % nseg) * seg_len;
+        const int len = std::min(begin + seg_len, inner) - begin;
+        const int j = ravel(unravel(row * inner, sshape), bshape) + begin;
+        for (int i = 0; i < len; ++i) Reducer::SetInitValue(acc[i]);
+        for (int k = 0; k < M; ++k) {
+          contiguous_reduce<Reducer, DType, OP>::ReduceRow(
+              big + j + unravel_dot(k, rshape, rstride), len, acc.data());
+        }
+        DType* out = small + row * inner + begin;
+        for (int i = 0; i < len; ++i) assign(&out[i], addto, acc[i]);
+      }
+    }
+  } else {
+    const int omp_threads = size < engine::OpenMP::Get()->min_parallel_size()
+        ? 1 : engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (int idx = 0; idx < N; ++idx) {
+      seq_reduce_assign<Reducer, ndim, DType, OP>(idx, M, addto, big, small, bshape, sshape,
+        rshape, rstride);
+    }
   }
 }
 
@@ -268,6 +450,9 @@ void seq_reduce_compute(const int N, const int M, const bool addto,
                         const Shape<ndim> lhs_shape, const Shape<ndim> lhs_stride,
                         const Shape<ndim> rhs_shape, const Shape<ndim> rhs_stride,
                         const Shape<ndim>& lhs_shape0, const Shape<ndim>& rhs_shape0) {
+  const int omp_threads = N * M < engine::OpenMP::Get()->min_parallel_size()
+      ? 1 : engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
   for (int idx = 0; idx < N; ++idx) {
     seq_reduce_assign<Reducer, ndim, DType, OP1, OP2>(idx, M, addto, big, lhs, rhs, small,
       big_shape, lhs_shape0, rhs_shape0, small_shape, rshape, lhs_shape, rhs_shape, rstride,
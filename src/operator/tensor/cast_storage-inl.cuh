@@ -583,6 +583,47 @@ inline void CastStorageDnsCsrImpl(const OpContext& ctx,
   });
 }
 
+/*!
+ * \brief Warp kernel for copying csr.data to its corresponding dns matrix.
+ * Parallelized by matrix rows: 1 warp/row
+ */
+struct CopyCsrDataToDnsWarpKernel {
+  template<typename DType, typename IType, typename CType>
+  __device__ __forceinline__ static void Map(int tid,
+                                             DType* dns_data,
+                                             const CType* col_idx,
+                                             const IType* indptr,
+                                             const DType* csr_data,
+                                             const nnvm::dim_t num_rows,
+                                             const nnvm::dim_t num_cols) {
+    using nnvm::dim_t;
+    const dim_t row_id = tid / 32;      // global warp id
+    const dim_t lane   = tid & (32-1);  // local thread id within warp
+    if (row_id < num_rows) {
+      const dim_t offset = row_id * num_cols;
+      for (dim_t j = indptr[row_id] + lane; j < indptr[row_id+1]; j += 32) {
+        dns_data[offset+col_idx[j]] = csr_data[j];
+      }
+    }
+  }
+};
+
+/*!
+ * \brief GPU implementation of copying csr.data to its corresponding dns matrix,
+ *  one warp per row so that the non-zeros of a row are read coalesced.
+ */
+template<typename DType, typename IType, typename CType>
+inline void CopyCsrDataToDnsImpl(mshadow::Stream<gpu>* s,
+                                 DType* dns_data,
+                                 const CType* col_idx,
+                                 const IType* indptr,
+                                 const DType* csr_data,
+                                 const nnvm::dim_t num_rows,
+                                 const nnvm::dim_t num_cols) {
+  mxnet_op::Kernel<CopyCsrDataToDnsWarpKernel, gpu>::Launch(s, num_rows * 32,
+      dns_data, col_idx, indptr, csr_data, num_rows, num_cols);
+}
+
 }  // namespace op
 }  // namespace mxnet
 
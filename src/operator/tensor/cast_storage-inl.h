@@ -291,6 +291,57 @@ struct CopyCsrDataToDns {
   }
 };
 
+/*!
+ * \brief CPU kernel for copying csr.data to its corresponding dns matrix,
+ *  parallelized by row blocks balanced by the number of non-zeros.
+ */
+struct CopyCsrDataToDnsByRowBlocks {
+  /*!
+   * \brief
+   * \param i           the i-th thread
+   * \param row_bounds  the rows [row_bounds[i], row_bounds[i+1]) are copied by thread i
+   */
+  template<typename DType, typename IType, typename CType>
+  MSHADOW_CINLINE static void Map(int i,
+                                  DType* dns_data,
+                                  const CType* col_idx,
+                                  const IType* indptr,
+                                  const DType* csr_data,
+                                  const nnvm::dim_t num_cols,
+                                  const nnvm::dim_t* row_bounds) {
+    for (nnvm::dim_t j = row_bounds[i]; j < row_bounds[i+1]; ++j) {
+      CopyCsrDataToDns::Map(j, dns_data, col_idx, indptr, csr_data, num_cols);
+    }
+  }
+};
+
+template<typename xpu, typename DType, typename IType, typename CType>
+inline void CopyCsrDataToDnsImpl(mshadow::Stream<xpu>* s,
+                                 DType* dns_data,
+                                 const CType* col_idx,
+                                 const IType* indptr,
+                                 const DType* csr_data,
+                                 const nnvm::dim_t num_rows,
+                                 const nnvm::dim_t num_cols) {
+  mxnet_op::Kernel<CopyCsrDataToDns, xpu>::Launch(s, num_rows,
+      dns_data, col_idx, indptr, csr_data, num_cols);
+}
+
+template<typename DType, typename IType, typename CType>
+inline void CopyCsrDataToDnsImpl(mshadow::Stream<cpu>* s,
+                                 DType* dns_data,
+                                 const CType* col_idx,
+                                 const IType* indptr,
+                                 const DType* csr_data,
+                                 const nnvm::dim_t num_rows,
+                                 const nnvm::dim_t num_cols) {
+  const nnvm::dim_t num_threads = mxnet_op::get_num_threads<cpu>(num_rows);
+  std::vector<nnvm::dim_t> row_bounds;
+  common::PartitionCsrRows(indptr, num_rows, num_threads, &row_bounds);
+  mxnet_op::Kernel<CopyCsrDataToDnsByRowBlocks, cpu>::Launch(s, num_threads,
+      dns_data, col_idx, indptr, csr_data, num_cols, row_bounds.data());
+}
+
 /*!
  * \brief Casts a csr matrix to dns format.
  */
@@ -316,9 +367,7 @@ void CastStorageCsrDnsImpl(const OpContext& ctx,
         const IType* indptr = csr.aux_data(csr::kIndPtr).dptr<IType>();
         const CType* col_idx = csr.aux_data(csr::kIdx).dptr<CType>();
         const DType* csr_data = csr.data().dptr<DType>();
-        num_threads = num_rows;
-        mxnet_op::Kernel<CopyCsrDataToDns, xpu>::Launch(s, num_threads,
-            dns_data, col_idx, indptr, csr_data, num_cols);
+        CopyCsrDataToDnsImpl(s, dns_data, col_idx, indptr, csr_data, num_rows, num_cols);
       });
     });
   });
@@ -332,60 +332,133 @@ struct DotCsrTransDnsRspWarpKernel {
 };
 
 /*!
- * \brief GPU Kernel of dot(csr.T, rsp1) = rsp2
- * Parallelization by rows: 1 thread/row
- * TODO: write a faster kernel optimized for GPU
+ * \brief GPU kernel marking the columns of the csr matrix rows which are
+ *  non-zero rows of an rsp matrix, i.e. the non-zero rows of dot(csr.T, rsp)
+ * Parallelization by rsp rows: 1 warp/row
  */
-struct DotCsrTransRspRspByRowsKernel {
+struct MarkCsrColByRspRowsWarpKernel {
   /*!
    * \brief
-   * \param tid           global thread id
-   * \param out           output rsp matrix data
-   * \param row_idx_out   output rsp matrix non-zero row indices
-   * \param data_l        csr matrix data
-   * \param indptr_l      csr matrix row index pointer
-   * \param col_idx_l     csr matrix column indices
-   * \param data_r        rsp1 matrix data
-   * \param row_idx_r     rsp1 matrix non-zero row indices
-   * \param num_cols_r    rsp1 matrix number of cols
-   * \param nnr_r         rsp1 matrix number of non-zero rows
-   * \param nnr_out       output rsp matrix number of non-zero rows
+   * \param tid        global thread id
+   * \param flg        flg array to mark non-zero columns
+   * \param col_idx_l  csr matrix column indices
+   * \param indptr_l   csr matrix row index pointer
+   * \param row_idx_r  rsp matrix non-zero row indices
+   * \param nnr_r      rsp matrix number of non-zero rows
+   */
+  template<typename CType, typename IType, typename RType>
+  __device__ __forceinline__ static void Map(int tid,
+                                             nnvm::dim_t* flg,
+                                             const CType* col_idx_l,
+                                             const IType* indptr_l,
+                                             const RType* row_idx_r,
+                                             const nnvm::dim_t nnr_r) {
+    typedef unsigned long long int uint64_cu;
+    static_assert(sizeof(uint64_cu) == sizeof(nnvm::dim_t), "unexpected sizeof dim_t");
+
+    const nnvm::dim_t warp_id = tid / 32;      // global warp   id
+    const nnvm::dim_t lane    = tid & (32-1);  // local  thread id within warp
+
+    if (warp_id < nnr_r) {
+      uint64_cu zero = 0;
+      uint64_cu one = 1;
+      const RType row = row_idx_r[warp_id];
+      for (IType j = indptr_l[row]+lane; j < indptr_l[row+1]; j+=32) {
+        atomicCAS(reinterpret_cast<uint64_cu*>(flg+col_idx_l[j]), zero, one);
+      }
+    }
+  }
+};
+
+/*!
+ * \brief GPU warp kernel of dot(csr.T, rsp1) = rsp2
+ * Parallelization by columns: 1 warp computes one lhs column for one rhs column.
+ * Only the lhs columns matching the non-zero rows of rsp1 are visited.
+ */
+struct DotCsrTransRspRspWarpKernel {
+  /*!
+   * \brief
+   * \param tid              global thread id
+   * \param out              output rsp matrix data
+   * \param row_flg_sum_out  inclusive prefix sum array over 0/1 marked row flag array
+   * \param data_l           csr matrix data
+   * \param indptr_l         csr matrix row index pointer
+   * \param col_idx_l        csr matrix column indices
+   * \param data_r           rsp1 matrix data
+   * \param row_idx_r        rsp1 matrix non-zero row indices
+   * \param num_cols_r       rsp1 matrix number of columns
    */
   template<typename DType, typename IType, typename CType, typename RType>
   __device__ __forceinline__ static void Map(int tid,
                                              DType* out,
-                                             const RType* row_idx_out,
+                                             const nnvm::dim_t* row_flg_sum_out,
                                              const DType* data_l,
                                              const IType* indptr_l,
                                              const CType* col_idx_l,
                                              const DType* data_r,
                                              const RType* row_idx_r,
-                                             const nnvm::dim_t num_cols_r,
-                                             const nnvm::dim_t nnr_r,
-                                             const nnvm::dim_t nnr_out) {
+                                             const nnvm::dim_t num_cols_r) {
     using nnvm::dim_t;
-    // This thread computes non-zero row 'tid' of the output matrix
-    // The actual row id corresponding to the lhs row is row_idx_out[tid]
-    if (tid < nnr_out) {
-      const dim_t offset_out = tid * num_cols_r;
-      // Iterate over rhs matrix rows (or, equivalently, lhs columns worthy taking a look at)
-      for (dim_t i = 0; i < nnr_r; i++) {
-        const RType j = row_idx_r[i];  // j is the actual rhs row id (= lhs column id)
-        if (indptr_l[j] == indptr_l[j+1]) continue;
-        const dim_t offset_r = i * num_cols_r;
-        // Iterate over lhs column j to find possible non-zero value in this row
-        // TODO: remove sequential search, this is a bottleneck
-        for (IType k = indptr_l[j]; k < indptr_l[j+1]; k++) {
-          const CType col_idx = col_idx_l[k];
-          if (col_idx == row_idx_out[tid]) {
-            for (dim_t l = 0; l < num_cols_r; l++) {
-              out[offset_out+l] += data_l[k] * data_r[offset_r+l];
-            }
-          } else if (col_idx > row_idx_out[tid]) {
-            break;
-          }
-        }
-      }
+    const dim_t warp_id = tid / 32;           // global warp id
+    const dim_t lane = tid & (32-1);          // local thread id within warp
+    const dim_t irow_r = warp_id / num_cols_r;  // rsp1 storage row that this warp computes
+    const dim_t kcol = warp_id % num_cols_r;    // rhs column that this warp computes
+    const dim_t icol = static_cast<dim_t>(row_idx_r[irow_r]);  // matching lhs column
+
+    // Compute range of nnz elements in this column
+    const dim_t low  = static_cast<dim_t>(indptr_l[icol]);
+    const dim_t high = static_cast<dim_t>(indptr_l[icol+1]);
+    const DType val_r = data_r[irow_r*num_cols_r+kcol];
+
+    // Iterate through the nnz elements in this column
+    for (dim_t j = low+lane; j < high; j+=32) {
+      const dim_t irow = static_cast<dim_t>(col_idx_l[j]);
+      const dim_t rsp_row = row_flg_sum_out[irow]-1;
+      atomicAdd(static_cast<DType *>(&(out[rsp_row*num_cols_r+kcol])), data_l[j]*val_r);
+    }
+  }
+};
+
+/*!
+ * \brief GPU warp kernel of dot(csr.T, rsp) = dns
+ * Parallelization by columns: 1 warp computes one lhs column for one rhs column.
+ * Only the lhs columns matching the non-zero rows of rsp are visited.
+ */
+struct DotCsrTransRspDnsWarpKernel {
+  /*!
+   * \brief
+   * \param tid         global thread id
+   * \param out         output dns matrix data
+   * \param data_l      csr matrix data
+   * \param indptr_l    csr matrix row index pointer
+   * \param col_idx_l   csr matrix column indices
+   * \param data_r      rsp matrix data
+   * \param row_idx_r   rsp matrix non-zero row indices
+   * \param num_cols_r  rsp matrix number of columns
+   */
+  template<typename DType, typename IType, typename CType, typename RType>
+  __device__ __forceinline__ static void Map(int tid,
+                                             DType* out,
+                                             const DType* data_l,
+                                             const IType* indptr_l,
+                                             const CType* col_idx_l,
+                                             const DType* data_r,
+                                             const RType* row_idx_r,
+                                             const nnvm::dim_t num_cols_r) {
+    using nnvm::dim_t;
+    const dim_t warp_id = tid / 32;
+    const dim_t lane = tid & (32-1);
+    const dim_t irow_r = warp_id / num_cols_r;
+    const dim_t kcol = warp_id % num_cols_r;
+    const dim_t icol = static_cast<dim_t>(row_idx_r[irow_r]);
+
+    const dim_t low  = static_cast<dim_t>(indptr_l[icol]);
+    const dim_t high = static_cast<dim_t>(indptr_l[icol+1]);
+    const DType val_r = data_r[irow_r*num_cols_r+kcol];
+
+    for (dim_t j = low+lane; j < high; j+=32) {
+      const dim_t irow = static_cast<dim_t>(col_idx_l[j]);
+      atomicAdd(static_cast<DType *>(&(out[irow*num_cols_r+kcol])), data_l[j]*val_r);
     }
   }
 };
@@ -682,8 +755,6 @@ inline void DotCsrDnsRspImpl(const OpContext& ctx,
 
 /*!
  * \brief GPU Impl of dot(csr, rsp1) = rsp2 and dot(csr.T, rsp1) = rsp2
- * TODO: Optimize for GPU; this is a baseline implementation providing
- *       the operator functionality, it is not yet fully optimized for GPU.
  */
 inline void DotCsrRspRspImpl(const OpContext& ctx,
                              const gpu& gpu_dev,
@@ -716,7 +787,6 @@ inline void DotCsrRspRspImpl(const OpContext& ctx,
   const TBlob data_r = rhs.data();
   const TBlob row_idx_r = rhs.aux_data(rowsparse::kIdx);
 
-  const dim_t num_rows_l = lhs.shape()[0];
   const dim_t num_cols_l = lhs.shape()[1];
   const dim_t num_cols_r = rhs.shape()[1];
   const dim_t nnr_r = rhs.storage_shape()[0];
@@ -734,7 +804,7 @@ inline void DotCsrRspRspImpl(const OpContext& ctx,
           if (trans_lhs) {
             // Compute number of non-zero rows (nnr) of output matrix
             // - alloc temp storage for row_flg array and for cub's prefix sum
-            // - mark non-zero columns of csr matrix in row_flg
+            // - mark the columns of the csr rows matching the non-zero rows of rsp1
             // - compute inclusive prefix sum over marked array
             // - copy last value (nnr_out) from device to host
             dim_t* row_flg_out = NULL;
@@ -753,10 +823,10 @@ inline void DotCsrRspRspImpl(const OpContext& ctx,
             d_temp_storage = workspace.dptr_ + num_cols_l*sizeof(dim_t);
             num_threads = num_cols_l;
             Kernel<set_zero, gpu>::Launch(s, num_threads, row_flg_out);
-            num_threads = num_rows_l * threads_per_warp;
-            Kernel<MarkCsrColWarpKernel, gpu>::Launch(s, num_threads,
+            num_threads = nnr_r * threads_per_warp;
+            Kernel<MarkCsrColByRspRowsWarpKernel, gpu>::Launch(s, num_threads,
                 row_flg_out, col_idx_l.dptr<CType>(), indptr_l.dptr<IType>(),
-                num_rows_l, num_cols_l);
+                row_idx_r.dptr<RType>(), nnr_r);
             cub::DeviceScan::InclusiveSum(d_temp_storage,
                                           temp_storage_bytes,
                                           row_flg_out,
@@ -784,12 +854,12 @@ inline void DotCsrRspRspImpl(const OpContext& ctx,
                 row_idx_out, row_flg_out, num_cols_l);
 
             // Perform matrix-matrix multiply
-            num_threads = nnr_out;
-            Kernel<DotCsrTransRspRspByRowsKernel, gpu>::Launch(s, num_threads,
-                data_out, row_idx_out,
+            if (0 == nnr_out) return;
+            num_threads = threads_per_warp * nnr_r * num_cols_r;
+            Kernel<DotCsrTransRspRspWarpKernel, gpu>::Launch(s, num_threads,
+                data_out, row_flg_out,
                 data_l.dptr<DType>(), indptr_l.dptr<IType>(), col_idx_l.dptr<CType>(),
-                data_r.dptr<DType>(), row_idx_r.dptr<RType>(),
-                num_cols_r, nnr_r, nnr_out);
+                data_r.dptr<DType>(), row_idx_r.dptr<RType>(), num_cols_r);
           } else {
             LOG(FATAL) << "DotCsrRspRspImpl has not implemented dot(csr, rsp1) = rsp2 yet.";
           }
@@ -834,7 +904,12 @@ inline void DotCsrRspDnsImpl(const OpContext& ctx,
   const dim_t num_rows = ret->shape_[0];
   const dim_t num_cols = ret->shape_[1];
   const dim_t nnr_r = rhs.storage_shape()[0];
+  const dim_t threads_per_warp = mxnet_op::cuda_get_device_prop().warpSize;
   dim_t num_threads;
+  // TODO: remove kernel dependency on warpSize=32
+  if (trans_lhs && threads_per_warp != 32) {
+    LOG(FATAL) << "DotCsrRspDnsImpl GPU kernels expect warpSize=32";
+  }
 
   const TBlob data_l = lhs.data();
   const TBlob indptr_l = lhs.aux_data(csr::kIndPtr);
@@ -851,7 +926,11 @@ inline void DotCsrRspDnsImpl(const OpContext& ctx,
             Kernel<set_zero, gpu>::Launch(s, num_threads, ret->dptr<DType>());
           }
           if (trans_lhs) {
-            LOG(FATAL) << "DotCsrRspDnsImpl has not implemented dot(csr.T, rsp) = dns yet.";
+            num_threads = threads_per_warp * nnr_r * num_cols;
+            Kernel<DotCsrTransRspDnsWarpKernel, gpu>::Launch(s, num_threads,
+                ret->dptr<DType>(),
+                data_l.dptr<DType>(), indptr_l.dptr<IType>(), col_idx_l.dptr<CType>(),
+                data_r.dptr<DType>(), row_idx_r.dptr<RType>(), num_cols);
           } else {
             // TODO: Consider implementing a vector kernel for SpMV (similar to DotCsrDnsDns)
             // Alloc temp storage for row_flg array
@@ -33,6 +33,7 @@
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
 #include "../mxnet_op.h"
+#include "../linalg.h"
 #ifdef __CUDACC__
 #include "./dot-inl.cuh"
 #endif  // __CUDACC__
@@ -232,12 +233,13 @@ inline bool DotBackwardInferStorageType(const nnvm::NodeAttrs& attrs,
 
 /*!
  * \brief CPU Kernel of dot(csr, dns1) = dns2
- * Parallelization by row blocks
+ * Parallelization by row blocks balanced by the number of non-zeros
  */
 struct DotCsrDnsDnsByRowBlocks {
   /*!
    * \brief
    * \param i the i-th thread
+   * \param row_bounds the rows [row_bounds[i], row_bounds[i+1]) are computed by thread i
    */
   template<typename DType, typename IType, typename CType>
   MSHADOW_CINLINE static void Map(int i,
@@ -246,14 +248,10 @@ struct DotCsrDnsDnsByRowBlocks {
                                   const IType* indptr_l,
                                   const CType* col_idx_l,
                                   const DType* data_r,
-                                  const nnvm::dim_t seg_len,
-                                  const nnvm::dim_t num_rows,
+                                  const nnvm::dim_t* row_bounds,
                                   const nnvm::dim_t num_cols) {
     using nnvm::dim_t;
-    const dim_t seg_start = i * seg_len;
-    if (seg_start >= num_rows) return;
-    const dim_t seg_end = std::min(seg_start + seg_len, num_rows);
-    for (dim_t j = seg_start; j < seg_end; ++j) {
+    for (dim_t j = row_bounds[i]; j < row_bounds[i+1]; ++j) {
       if (indptr_l[j] == indptr_l[j+1]) continue;
       const dim_t offset_out = j * num_cols;
       for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
@@ -354,15 +352,15 @@ struct DotCsrTransDnsRspByRowBlocks {
 
 /*!
  * \brief CPU Kernel of dot(csr, rsp) = dns
- * Parallelization by row blocks
+ * Parallelization by row blocks balanced by the number of non-zeros
  */
 struct DotCsrRspDnsByRowBlocks {
   /*!
    * \brief
-   * \param i         the i-th thread
-   * \param nnr_r     storage_shape[0] of the rsp
-   * \param num_rows  dns.shape[0]
-   * \param num_cols  dns.shape[1]
+   * \param i           the i-th thread
+   * \param nnr_r       storage_shape[0] of the rsp
+   * \param num_cols    dns.shape[1]
+   * \param row_bounds  the rows [row_bounds[i], row_bounds[i+1]) are computed by thread i
    */
   template<typename DType, typename IType, typename CType, typename RType>
   MSHADOW_CINLINE static void Map(int i,
@@ -373,14 +371,10 @@ struct DotCsrRspDnsByRowBlocks {
                                   const DType* data_r,
                                   const RType* row_idx_r,
                                   const nnvm::dim_t nnr_r,
-                                  const nnvm::dim_t num_rows,
                                   const nnvm::dim_t num_cols,
-                                  const nnvm::dim_t seg_len) {
+                                  const nnvm::dim_t* row_bounds) {
     using nnvm::dim_t;
-    const dim_t seg_start = i * seg_len;
-    if (seg_start >= num_rows) return;
-    const dim_t seg_end = std::min(seg_start + seg_len, num_rows);
-    for (dim_t j = seg_start; j < seg_end; ++j) {
+    for (dim_t j = row_bounds[i]; j < row_bounds[i+1]; ++j) {
       if (indptr_l[j] == indptr_l[j+1]) continue;
       const dim_t offset_out = j * num_cols;
       // Use binary search to find the lower_bound of val in row_idx array
@@ -421,6 +415,50 @@ struct DotCsrRspDnsByRowBlocks {
   }
 };
 
+/*!
+ * \brief CPU Kernel of dot(csr.T(), rsp) = dns
+ * Parallelization by row blocks
+ */
+struct DotCsrTransRspDnsByRowBlocks {
+  /*!
+   * \brief
+   * \param i the i-th thread
+   * \param nnr_r number of non-zero rows of rhs matrix
+   * \param num_rows number of rows of out matrix
+   * \param num_cols number of cols of out matrix
+   */
+  template<typename DType, typename IType, typename CType, typename RType>
+  MSHADOW_CINLINE static void Map(int i,
+                                  DType* out,
+                                  const DType* data_l,
+                                  const IType* indptr_l,
+                                  const CType* col_idx_l,
+                                  const DType* data_r,
+                                  const RType* row_idx_r,
+                                  const nnvm::dim_t nnr_r,
+                                  const nnvm::dim_t num_rows,
+                                  const nnvm::dim_t num_cols,
+                                  const nnvm::dim_t seg_len) {
+    using nnvm::dim_t;
+    const dim_t seg_start = i * seg_len;
+    if (seg_start >= num_rows) return;
+    const dim_t seg_end = (i + 1) * seg_len;
+    for (dim_t rid = 0; rid < nnr_r; ++rid) {
+      const RType j = row_idx_r[rid];
+      if (indptr_l[j] == indptr_l[j+1]) continue;
+      const dim_t offset_r = rid * num_cols;
+      for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
+        const CType col_idx = col_idx_l[k];
+        if (col_idx < seg_start || col_idx >= seg_end) continue;
+        const dim_t offset_out = col_idx * num_cols;
+        for (dim_t l = 0; l < num_cols; ++l) {
+          out[offset_out+l] += data_r[offset_r+l] * data_l[k];
+        }
+      }
+    }
+  }
+};
+
 /*!
  * \brief CPU Kernel of dot(csr.T(), rsp1) = rsp2, with row_idx marked for non-zero rows
  * Parallelization by row blocks
@@ -502,17 +540,20 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
               s, num_threads, data_out.dptr<DType>());
         }
         num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
-        dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
         if (trans_lhs) {
+          dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
           mxnet_op::Kernel<DotCsrTransDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
               col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
               lhs.shape()[0], data_out.shape_[0], data_out.shape_[1]);
         } else {
+          std::vector<dim_t> row_bounds;
+          common::PartitionCsrRows(indptr_l.dptr<IType>(), data_out.shape_[0],
+                                   num_threads, &row_bounds);
           mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-              col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-              data_out.shape_[0], data_out.shape_[1]);
+              col_idx_l.dptr<CType>(), data_r.dptr<DType>(), row_bounds.data(),
+              data_out.shape_[1]);
         }
       });
     });
@@ -588,7 +629,7 @@ inline void DotCsrDnsRspImpl(const OpContext& ctx,
 }
 
 /*!
- * \brief CPU Impl of dot(csr, rsp) = dns
+ * \brief CPU Impl of dot(csr, rsp) = dns and dot(csr.T, rsp) = dns
  */
 inline void DotCsrRspDnsImpl(const OpContext& ctx,
                              const cpu& cpu_dev,
@@ -637,13 +678,20 @@ inline void DotCsrRspDnsImpl(const OpContext& ctx,
           num_threads = mxnet_op::get_num_threads<cpu>(ret->shape_[0]);
           dim_t seg_len = (ret->shape_[0] + num_threads - 1) / num_threads;
           if (trans_lhs) {
-            LOG(FATAL) << "DotCsrRspDnsImpl has not implemented dot(csr.T, rsp) = dns yet";
+            mxnet_op::Kernel<DotCsrTransRspDnsByRowBlocks, cpu>::Launch(s, num_threads,
+                ret->dptr<DType>(), data_l.dptr<DType>(),
+                indptr_l.dptr<IType>(), col_idx_l.dptr<CType>(), data_r.dptr<DType>(),
+                row_idx_r.dptr<RType>(), rhs.storage_shape()[0],
+                ret->shape_[0], ret->shape_[1], seg_len);
           } else {
+            std::vector<dim_t> row_bounds;
+            common::PartitionCsrRows(indptr_l.dptr<IType>(), ret->shape_[0],
+                                     num_threads, &row_bounds);
             mxnet_op::Kernel<DotCsrRspDnsByRowBlocks, cpu>::Launch(s, num_threads,
                 ret->dptr<DType>(), data_l.dptr<DType>(),
                 indptr_l.dptr<IType>(), col_idx_l.dptr<CType>(), data_r.dptr<DType>(),
                 row_idx_r.dptr<RType>(), rhs.storage_shape()[0],
-                ret->shape_[0], ret->shape_[1], seg_len);
+                ret->shape_[1], row_bounds.data());
           }
         });
       });
@@ -845,6 +893,20 @@ void DotBackwardEx(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*!
+ * \brief C = op(A) * op(B) for batch_dot. It goes through linalg_batch_gemm, a
+ *  single strided batched cublas call on gpu, in which fp16 is accumulated in
+ *  fp32 and uses TensorCores when allowed.
+ */
+template<typename xpu, typename DType>
+inline void BatchDotGEMM(const TBlob& C, const TBlob& A, const TBlob& B,
+                         bool tA, bool tB, OpReqType req, mshadow::Stream<xpu> *s) {
+  if (kNullOp == req) return;
+  linalg_batch_gemm(A.get<xpu, 3, DType>(s), B.get<xpu, 3, DType>(s),
+                    C.get<xpu, 3, DType>(s), DType(1.0f),
+                    DType(kAddTo == req ? 1.0f : 0.0f), tA, tB, s);
+}
+
 template<typename xpu>
 void BatchDotForward_(const nnvm::NodeAttrs& attrs,
                       const OpContext& ctx,
@@ -859,33 +921,12 @@ void BatchDotForward_(const nnvm::NodeAttrs& attrs,
       << "Binary function only support input/output with the same type";
   CHECK_EQ(outputs[0].type_flag_, inputs[1].type_flag_)
       << "Binary function only support input/output with the same type";
-  CHECK(outputs[0].type_flag_ == kFloat32 || outputs[0].type_flag_ == kFloat64)
-      << "dot only supports float32 and float64";
-  MSHADOW_SGL_DBL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Tensor<xpu, 3, DType> out = outputs[0].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mlhs = inputs[0].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mrhs = inputs[1].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 1, DType*> workspace =
-      ctx.requested[0].get_space_typed<xpu, 1, DType*>(mshadow::Shape1(3 * out.size(0)), s);
-    if (kNullOp != req[0]) {
-      if (param.transpose_a && param.transpose_b) {
-        mshadow::BatchGEMM<true, true>(out, mlhs, mrhs, (DType)1.0f,
-                                       (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                       workspace);
-      } else if (!param.transpose_a && param.transpose_b) {
-        mshadow::BatchGEMM<false, true>(out, mlhs, mrhs, (DType)1.0f,
-                                       (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                       workspace);
-      } else if (param.transpose_a && !param.transpose_b) {
-        mshadow::BatchGEMM<true, false>(out, mlhs, mrhs, (DType)1.0f,
-                                       (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                       workspace);
-      } else {
-        mshadow::BatchGEMM<false, false>(out, mlhs, mrhs, (DType)1.0f,
-                                       (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                       workspace);
-      }
-    }
+  CHECK(outputs[0].type_flag_ == kFloat16 || outputs[0].type_flag_ == kFloat32 ||
+        outputs[0].type_flag_ == kFloat64)
+      << "batch_dot only supports float16, float32 and float64";
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    BatchDotGEMM<xpu, DType>(outputs[0], inputs[0], inputs[1],
+                             param.transpose_a, param.transpose_b, req[0], s);
   });
 }
 
@@ -901,75 +942,37 @@ void BatchDotBackward_(const nnvm::NodeAttrs& attrs,
   const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
   CHECK_NE(req[1], kWriteInplace);
   CHECK_NE(req[0], kWriteInplace);
-  CHECK(outputs[0].type_flag_ == kFloat32 || outputs[0].type_flag_ == kFloat64)
-      << "dot only supports float32 and float64";
-  MSHADOW_SGL_DBL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Tensor<xpu, 3, DType> mout_grad = inputs[0].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mlhs_data = inputs[1].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mrhs_data = inputs[2].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mlhs_grad = outputs[0].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 3, DType> mrhs_grad = outputs[1].get<xpu, 3, DType>(s);
-    mshadow::Tensor<xpu, 2, DType*> workspace =
-      ctx.requested[0].get_space_typed<xpu, 2, DType*>(
-        mshadow::Shape2(2, 3 * mout_grad.size(0)), s);
-    mshadow::Tensor<xpu, 1, DType*> rhs_workspace = workspace[0];
-    mshadow::Tensor<xpu, 1, DType*> lhs_workspace = workspace[1];
+  CHECK(outputs[0].type_flag_ == kFloat16 || outputs[0].type_flag_ == kFloat32 ||
+        outputs[0].type_flag_ == kFloat64)
+      << "batch_dot only supports float16, float32 and float64";
+  const TBlob& dz = inputs[0];
+  const TBlob& x = inputs[1];
+  const TBlob& y = inputs[2];
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
     if (param.transpose_a && param.transpose_b) {
       // Gradient of z = dot(x.T, y.T)
       // dy = dot(x, dz).T = dot(dz.T, x.T)
       // dx = dot(dz, y).T = dot(y.T, dz.T)
-      if (kNullOp != req[1]) {
-        mshadow::BatchGEMM<true, true>(mrhs_grad, mout_grad, mlhs_data, (DType)1.0f,
-                                        (kAddTo == req[1]) ? (DType)1.0f :  (DType)0.0f,
-                                        rhs_workspace);
-      }
-      if (kNullOp != req[0]) {
-        mshadow::BatchGEMM<true, true>(mlhs_grad, mrhs_data, mout_grad, (DType)1.0f,
-                                        (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                        lhs_workspace);
-      }
+      BatchDotGEMM<xpu, DType>(outputs[1], dz, x, true, true, req[1], s);
+      BatchDotGEMM<xpu, DType>(outputs[0], y, dz, true, true, req[0], s);
     } else if (!param.transpose_a && param.transpose_b) {
       // Gradient of z = dot(x, y.T)
       // dy = dot(x.T, dz).T = dot(dz.T, x)
       // dx = dot(dz, y)
-      if (kNullOp != req[1]) {
-        mshadow::BatchGEMM<true, false>(mrhs_grad, mout_grad, mlhs_data, (DType)1.0f,
-                                        (kAddTo == req[1]) ? (DType)1.0f : (DType)0.0f,
-                                        rhs_workspace);
-      }
-      if (kNullOp != req[0]) {
-        mshadow::BatchGEMM<false, false>(mlhs_grad, mout_grad, mrhs_data, (DType)1.0f,
-                                        (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                        lhs_workspace);
-      }
+      BatchDotGEMM<xpu, DType>(outputs[1], dz, x, true, false, req[1], s);
+      BatchDotGEMM<xpu, DType>(outputs[0], dz, y, false, false, req[0], s);
     } else if (param.transpose_a && !param.transpose_b) {
       // Gradient of z = dot(x.T, y)
       // dy = dot(x, dz)
       // dx = dot(dz, y.T).T = dot(y, dz.T)
-      if (kNullOp != req[1]) {
-        mshadow::BatchGEMM<false, false>(mrhs_grad, mlhs_data, mout_grad, (DType)1.0f,
-                                        (kAddTo == req[1]) ? (DType)1.0f : (DType)0.0f,
-                                        rhs_workspace);
-      }
-      if (kNullOp != req[0]) {
-        mshadow::BatchGEMM<false, true>(mlhs_grad, mrhs_data, mout_grad, (DType)1.0f,
-                                        (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                        lhs_workspace);
-      }
+      BatchDotGEMM<xpu, DType>(outputs[1], x, dz, false, false, req[1], s);
+      BatchDotGEMM<xpu, DType>(outputs[0], y, dz, false, true, req[0], s);
     } else {
       // Gradient of z = dot(x, y)
       // dy = dot(x.T, dz)
       // dx = dot(dz, y.T)
-      if (kNullOp != req[1]) {
-        mshadow::BatchGEMM<true, false>(mrhs_grad, mlhs_data, mout_grad, (DType)1.0f,
-                                        (kAddTo == req[1]) ? (DType)1.0f : (DType)0.0f,
-                                        rhs_workspace);
-      }
-      if (kNullOp != req[0]) {
-        mshadow::BatchGEMM<false, true>(mlhs_grad, mout_grad, mrhs_data, (DType)1.0f,
-                                        (kAddTo == req[0]) ? (DType)1.0f : (DType)0.0f,
-                                        lhs_workspace);
-      }
+      BatchDotGEMM<xpu, DType>(outputs[1], x, dz, true, false, req[1], s);
+      BatchDotGEMM<xpu, DType>(outputs[0], dz, y, false, true, req[0], s);
     }
   });
 }
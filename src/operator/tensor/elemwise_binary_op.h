@@ -29,6 +29,7 @@
 #include <string>
 #include <utility>
 #include <typeinfo>
+#include <algorithm>
 #include "../mxnet_op.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
@@ -143,118 +144,375 @@ void BinaryBackwardUseNone_(const nnvm::NodeAttrs& attrs,
   }
 }
 
-// TODO(haibin) This is a single-thread inefficient implementation
-// This implementation only works on CPU
+/*!
+ * \brief out[i] = OP(lhs, rhs) on the rows of a merged row_sparse result,
+ *  a negative position of a row in one of the inputs stands for a row of zeros
+ */
+template<typename OP>
+struct ElemwiseRspRspKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* lhs, const DType* rhs,
+                                  const int* lhs_pos, const int* rhs_pos, const int row_len) {
+    const int k = i / row_len;
+    const int j = i % row_len;
+    const DType l = lhs_pos[k] >= 0 ? lhs[lhs_pos[k] * row_len + j] : DType(0);
+    const DType r = rhs_pos[k] >= 0 ? rhs[rhs_pos[k] * row_len + j] : DType(0);
+    out[i] = OP::Map(l, r);
+  }
+};
+
+/*!
+ * \brief row_sparse OP row_sparse = row_sparse. The row indices are merged in
+ *  one pass, the union of the rows is kept for ops like plus and minus and
+ *  only the common rows for ops with OP(0, x) = OP(x, 0) = 0 like mul.
+ *  The values are then computed in parallel over the merged rows.
+ */
 template<typename xpu, typename OP>
 void BinaryComputeRspRspImpl(const nnvm::NodeAttrs& attrs,
                              const OpContext& ctx,
                              const std::vector<NDArray>& inputs,
                              const std::vector<OpReqType>& req,
-                             const std::vector<NDArray>& outputs) {
-  if (req[0] == kNullOp) return;
-  CHECK(req[0] == kWriteTo) << "only kWriteTo is supported for rowsparse elemwise_add";
+                             const std::vector<NDArray>& outputs,
+                             bool intersect = false) {
   using namespace rowsparse;
   using namespace mshadow;
-  auto &lhs = inputs[0];
-  auto &rhs = inputs[1];
-  auto &output = outputs[0];
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo) << "only kWriteTo is supported for row_sparse outputs";
+  const NDArray& lhs = inputs[0];
+  const NDArray& rhs = inputs[1];
+  NDArray output = outputs[0];
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const size_t num_rows_l = lhs.storage_initialized() ? lhs.aux_shape(kIdx)[0] : 0;
+  const size_t num_rows_r = rhs.storage_initialized() ? rhs.aux_shape(kIdx)[0] : 0;
+  const int row_len = output.shape().ProdShape(1, output.shape().ndim());
+  MSHADOW_IDX_TYPE_SWITCH(lhs.aux_type(kIdx), IType, {
+    CHECK_EQ(rhs.aux_type(kIdx), lhs.aux_type(kIdx));
+    const IType* idx_l = num_rows_l ? lhs.aux_data(kIdx).dptr<IType>() : nullptr;
+    const IType* idx_r = num_rows_r ? rhs.aux_data(kIdx).dptr<IType>() : nullptr;
+    std::vector<IType> idx_out;
+    std::vector<int> pos_l, pos_r;
+    idx_out.reserve(intersect ? std::min(num_rows_l, num_rows_r) : num_rows_l + num_rows_r);
+    size_t il = 0, ir = 0;
+    while (il < num_rows_l || ir < num_rows_r) {
+      const bool take_l = ir == num_rows_r || (il < num_rows_l && idx_l[il] <= idx_r[ir]);
+      const bool take_r = il == num_rows_l || (ir < num_rows_r && idx_r[ir] <= idx_l[il]);
+      if (intersect && !(take_l && take_r)) {
+        if (take_l) ++il; else ++ir;
+        if (il == num_rows_l || ir == num_rows_r) break;
+        continue;
+      }
+      idx_out.push_back(take_l ? idx_l[il] : idx_r[ir]);
+      pos_l.push_back(take_l ? static_cast<int>(il++) : -1);
+      pos_r.push_back(take_r ? static_cast<int>(ir++) : -1);
+    }
+    const size_t nnr = idx_out.size();
+    if (nnr == 0) {
+      FillZerosRspImpl(s, &output);
+      return;
+    }
+    output.CheckAndAlloc({Shape1(nnr)});
+    std::copy(idx_out.begin(), idx_out.end(), output.aux_data(kIdx).dptr<IType>());
+    MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
+      mxnet_op::Kernel<ElemwiseRspRspKernel<OP>, cpu>::Launch(s, nnr * row_len,
+        output.data().dptr<DType>(),
+        num_rows_l ? lhs.data().dptr<DType>() : nullptr,
+        num_rows_r ? rhs.data().dptr<DType>() : nullptr,
+        pos_l.data(), pos_r.data(), row_len);
+    });
+  });
+}
 
-  bool init_l = lhs.storage_initialized();
-  bool init_r = rhs.storage_initialized();
-  Stream<xpu> *s = ctx.get_stream<xpu>();
-  // both inputs are zeros
-  if (!init_l && !init_r) {
-    NDArray out = output;
-    FillZerosRspImpl(s, &out);
-    return;
+/*! \brief number of non-zeros of the merge of row i of two csr matrices */
+struct ElemwiseCsrCsrCount {
+  template<typename IType, typename CType>
+  MSHADOW_XINLINE static void Map(int i, IType* out_indptr,
+                                  const IType* indptr_l, const CType* col_l,
+                                  const IType* indptr_r, const CType* col_r,
+                                  const bool intersect) {
+    IType jl = indptr_l[i], jr = indptr_r[i];
+    const IType el = indptr_l[i + 1], er = indptr_r[i + 1];
+    IType nnz = 0;
+    while (jl < el && jr < er) {
+      if (col_l[jl] == col_r[jr]) {
+        ++jl;
+        ++jr;
+        ++nnz;
+      } else if (col_l[jl] < col_r[jr]) {
+        ++jl;
+        if (!intersect) ++nnz;
+      } else {
+        ++jr;
+        if (!intersect) ++nnz;
+      }
+    }
+    if (!intersect) nnz += (el - jl) + (er - jr);
+    out_indptr[i + 1] = nnz;
   }
-  // Memory Estimation: This is (roughly) the number of result rows. We still
-  // need to subtract the number of common rows
-  unsigned int num_rows_l = lhs.aux_shape(kIdx)[0];
-  unsigned int num_rows_r = rhs.aux_shape(kIdx)[0];
-  unsigned int num_rows_total = num_rows_l + num_rows_r;
-  auto row_len = output.shape().ProdShape(1, output.shape().ndim());
-  output.CheckAndAlloc({Shape1(num_rows_total)});
-  CHECK_GT(row_len, 0);
-  MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
-    MSHADOW_TYPE_SWITCH(lhs.aux_type(kIdx), IType, {
-      // Indices
-      auto indices_l = lhs.aux_data(kIdx).dptr<IType>();
-      auto indices_r = rhs.aux_data(kIdx).dptr<IType>();
-      auto indices_out = output.aux_data(kIdx).dptr<IType>();
-      // Data
-      auto data_l = lhs.data().get_with_shape<cpu, 2, DType>(Shape2(num_rows_l, row_len), s);
-      auto data_r = rhs.data().get_with_shape<cpu, 2, DType>(Shape2(num_rows_r, row_len), s);
-      auto out = output.data().get_with_shape<cpu, 2, DType>(Shape2(num_rows_total, row_len), s);
+};
 
-      // TODO(haibin) A more appropriate way: Copy to output, then apply ops
-      size_t iter_l = 0;
-      size_t iter_r = 0;
-      size_t iter_out = 0;
-      int32_t num_common_rows = 0;
-      while (iter_l < num_rows_l && iter_r < num_rows_r) {
-        auto idx_l = indices_l[iter_l];
-        auto idx_r = indices_r[iter_r];
-        if (idx_l == idx_r) {
-          // Same row
-          indices_out[iter_out] = idx_l;
-          Copy(out[iter_out], data_l[iter_l++], s);
-          out[iter_out] += data_r[iter_r++];
-          num_common_rows++;
-        } else if (idx_l < idx_r) {
-          // Left only
-          indices_out[iter_out] = idx_l;
-          Copy(out[iter_out], data_l[iter_l++], s);
-        } else {
-          // Right only
-          indices_out[iter_out] = idx_r;
-          Copy(out[iter_out], data_r[iter_r++], s);
-        }
-        iter_out++;
-      }
-      // Copying over the rest of the rows
-      while (iter_l < num_rows_l) {
-        indices_out[iter_out] = indices_l[iter_l];
-        Copy(out[iter_out++], data_l[iter_l++], s);
+/*! \brief fill the columns and values of the merge of row i of two csr matrices */
+template<typename OP>
+struct ElemwiseCsrCsrKernel {
+  template<typename DType, typename IType, typename CType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, CType* col_out, const IType* indptr_out,
+                                  const DType* val_l, const IType* indptr_l, const CType* col_l,
+                                  const DType* val_r, const IType* indptr_r, const CType* col_r,
+                                  const bool intersect) {
+    IType jl = indptr_l[i], jr = indptr_r[i], k = indptr_out[i];
+    const IType el = indptr_l[i + 1], er = indptr_r[i + 1];
+    while (jl < el || jr < er) {
+      const bool take_l = jr == er || (jl < el && col_l[jl] <= col_r[jr]);
+      const bool take_r = jl == el || (jr < er && col_r[jr] <= col_l[jl]);
+      if (intersect && !(take_l && take_r)) {
+        if (take_l) ++jl; else ++jr;
+        if (jl == el || jr == er) break;
+        continue;
       }
-      while (iter_r < num_rows_r) {
-        indices_out[iter_out] = indices_r[iter_r];
-        Copy(out[iter_out++], data_r[iter_r++], s);
+      col_out[k] = take_l ? col_l[jl] : col_r[jr];
+      out[k++] = OP::Map(take_l ? val_l[jl++] : DType(0), take_r ? val_r[jr++] : DType(0));
+    }
+  }
+};
+
+/*!
+ * \brief csr OP csr = csr, the rows are merged in parallel: the non-zeros of
+ *  every row are counted first, then the columns and values are filled
+ */
+template<typename xpu, typename OP>
+void BinaryComputeCsrCsrImpl(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<NDArray>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<NDArray>& outputs,
+                             bool intersect = false) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo) << "only kWriteTo is supported for csr outputs";
+  const NDArray& lhs = inputs[0];
+  const NDArray& rhs = inputs[1];
+  NDArray output = outputs[0];
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  if (!lhs.storage_initialized() && !rhs.storage_initialized()) {
+    FillZerosCsrImpl(s, &output);
+    return;
+  }
+  // an empty operand is merged as a matrix of empty rows
+  if (!lhs.storage_initialized() || !rhs.storage_initialized()) {
+    if (intersect) {
+      FillZerosCsrImpl(s, &output);
+      return;
+    }
+    // 0 OP x is not x for every OP, the fallback handles this rare case
+    FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs, BinaryCompute<xpu, OP>,
+                         "BinaryCompute");
+    return;
+  }
+  const int num_rows = output.shape()[0];
+  MSHADOW_IDX_TYPE_SWITCH(lhs.aux_type(csr::kIndPtr), IType, {
+    MSHADOW_IDX_TYPE_SWITCH(lhs.aux_type(csr::kIdx), CType, {
+      const IType* indptr_l = lhs.aux_data(csr::kIndPtr).dptr<IType>();
+      const IType* indptr_r = rhs.aux_data(csr::kIndPtr).dptr<IType>();
+      const CType* col_l = lhs.aux_data(csr::kIdx).dptr<CType>();
+      const CType* col_r = rhs.aux_data(csr::kIdx).dptr<CType>();
+      output.CheckAndAllocAuxData(csr::kIndPtr, Shape1(num_rows + 1));
+      IType* indptr_out = output.aux_data(csr::kIndPtr).dptr<IType>();
+      indptr_out[0] = 0;
+      Kernel<ElemwiseCsrCsrCount, cpu>::Launch(s, num_rows, indptr_out, indptr_l, col_l,
+                                               indptr_r, col_r, intersect);
+      for (int i = 0; i < num_rows; ++i) indptr_out[i + 1] += indptr_out[i];
+      const index_t nnz = static_cast<index_t>(indptr_out[num_rows]);
+      if (nnz == 0) {
+        FillZerosCsrImpl(s, &output);
+        return;
       }
-      auto new_sshape = TShape(output.aux_shape(rowsparse::kIdx));
-      CHECK_GT(new_sshape[0], num_common_rows);
-      new_sshape[0] -= num_common_rows;
-      output.set_aux_shape(rowsparse::kIdx, new_sshape);
+      output.CheckAndAllocAuxData(csr::kIdx, Shape1(nnz));
+      output.CheckAndAllocData(Shape1(nnz));
+      MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
+        Kernel<ElemwiseCsrCsrKernel<OP>, cpu>::Launch(s, num_rows,
+          output.data().dptr<DType>(), output.aux_data(csr::kIdx).dptr<CType>(), indptr_out,
+          lhs.data().dptr<DType>(), indptr_l, col_l,
+          rhs.data().dptr<DType>(), indptr_r, col_r, intersect);
+      });
     });
   });
 }
 
-template<typename xpu, typename OP>
-void BinaryComputeEx(const nnvm::NodeAttrs& attrs,
-                         const OpContext& ctx,
-                         const std::vector<NDArray>& inputs,
-                         const std::vector<OpReqType>& req,
-                         const std::vector<NDArray>& outputs) {
+/*!
+ * \brief out[i] = OP(rsp, dns) on the rows of a row_sparse operand, the
+ *  dense operand is the lhs when reverse is true
+ */
+template<typename OP, bool reverse>
+struct ElemwiseRspDnsKernel {
+  template<typename DType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* rsp, const IType* idx,
+                                  const DType* dns, const int row_len) {
+    const DType d = dns[static_cast<int64_t>(idx[i / row_len]) * row_len + i % row_len];
+    out[i] = reverse ? OP::Map(d, rsp[i]) : OP::Map(rsp[i], d);
+  }
+};
+
+/*!
+ * \brief the dense result of a row_sparse OP dense, row_pos gives the position
+ *  of every row in the row_sparse operand or -1 for a row of zeros
+ */
+template<typename OP, bool reverse>
+struct ElemwiseRspDnsDnsKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* rsp, const int* row_pos,
+                                  const DType* dns, const int row_len) {
+    const int k = row_pos[i / row_len];
+    const DType r = k >= 0 ? rsp[k * row_len + i % row_len] : DType(0);
+    out[i] = reverse ? OP::Map(dns[i], r) : OP::Map(r, dns[i]);
+  }
+};
+
+/*!
+ * \brief row_sparse OP dense (dense OP row_sparse when reverse is true).
+ *  For ops with OP(0, x) = 0, like mul and div, the result is row_sparse with
+ *  the rows of the row_sparse operand. Otherwise the result is dense and the
+ *  row_sparse operand is read through a lookup of its rows instead of being
+ *  densified.
+ */
+template<typename xpu, typename OP, bool reverse>
+void BinaryComputeRspDnsImpl(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<NDArray>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<NDArray>& outputs) {
   using namespace mshadow;
-  using namespace mshadow::expr;
-  Stream<xpu> *s = ctx.get_stream<xpu>();
-  CHECK_EQ(inputs.size(), 2);
-  CHECK_EQ(outputs.size(), 1);
-  if (typeid(OP) == typeid(mshadow::op::plus)) {
-    // If any input is dense, fallback to FCompute
-    // TODO(haibin) implement dns + rsp in a separate kernel
-    if (common::ContainsDefaultStorage(inputs)) {
-      FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs,
-                           BinaryCompute<xpu, OP>, "BinaryCompute");
+  using namespace mxnet_op;
+  if (req[0] == kNullOp) return;
+  const NDArray& rsp = inputs[reverse ? 1 : 0];
+  const NDArray& dns = inputs[reverse ? 0 : 1];
+  NDArray output = outputs[0];
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const int row_len = output.shape().ProdShape(1, output.shape().ndim());
+  const size_t nnr = rsp.storage_initialized() ? rsp.aux_shape(rowsparse::kIdx)[0] : 0;
+  if (output.storage_type() == kRowSparseStorage) {
+    CHECK_EQ(req[0], kWriteTo) << "only kWriteTo is supported for row_sparse outputs";
+    if (nnr == 0) {
+      FillZerosRspImpl(s, &output);
       return;
     }
-    CHECK_EQ(inputs[0].storage_type(), kRowSparseStorage) << "Sparse type not supported yet";
-    CHECK_EQ(inputs[1].storage_type(), kRowSparseStorage) << "Sparse type not supported yet";
-    BinaryComputeRspRspImpl<xpu, OP>(attrs, ctx, inputs, req, outputs);
+    output.CheckAndAlloc({Shape1(nnr)});
+    MSHADOW_IDX_TYPE_SWITCH(rsp.aux_type(rowsparse::kIdx), IType, {
+      const IType* idx = rsp.aux_data(rowsparse::kIdx).dptr<IType>();
+      std::copy(idx, idx + nnr, output.aux_data(rowsparse::kIdx).dptr<IType>());
+      MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
+        Kernel<ElemwiseRspDnsKernel<OP, reverse>, cpu>::Launch(s, nnr * row_len,
+          output.data().dptr<DType>(), rsp.data().dptr<DType>(), idx,
+          dns.data().dptr<DType>(), row_len);
+      });
+    });
     return;
+  }
+  CHECK(req[0] == kWriteTo || req[0] == kWriteInplace)
+    << "only kWriteTo is supported for dense outputs of row_sparse operands";
+  // a lookup of the rows is much smaller than the densified operand
+  std::vector<int> row_pos(output.shape()[0], -1);
+  MSHADOW_IDX_TYPE_SWITCH(rsp.aux_type(rowsparse::kIdx), IType, {
+    const IType* idx = nnr ? rsp.aux_data(rowsparse::kIdx).dptr<IType>() : nullptr;
+    for (size_t k = 0; k < nnr; ++k) row_pos[idx[k]] = static_cast<int>(k);
+  });
+  MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
+    Kernel<ElemwiseRspDnsDnsKernel<OP, reverse>, cpu>::Launch(s, output.shape().Size(),
+      output.data().dptr<DType>(), nnr ? rsp.data().dptr<DType>() : nullptr,
+      row_pos.data(), dns.data().dptr<DType>(), row_len);
+  });
+}
+
+/*!
+ * \brief storage types of ops with OP(0, x) = OP(x, 0) = 0 like mul: the
+ *  result of a row_sparse operand with a dense one stays row_sparse
+ */
+inline bool ElemwiseMulStorageType(const nnvm::NodeAttrs& attrs,
+                                   const Context& ctx,
+                                   std::vector<int> *in_attrs,
+                                   std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U) << " in operator " << attrs.name;
+  CHECK_EQ(out_attrs->size(), 1U) << " in operator " << attrs.name;
+  for (int& stype : *in_attrs) {
+    if (stype == kUndefinedStorage) stype = kDefaultStorage;
+  }
+  const int lhs = (*in_attrs)[0], rhs = (*in_attrs)[1];
+  if ((lhs == kRowSparseStorage && rhs != kCSRStorage) ||
+      (rhs == kRowSparseStorage && lhs != kCSRStorage)) {
+    STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kRowSparseStorage);
+  } else if (lhs == kCSRStorage && rhs == kCSRStorage) {
+    STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kCSRStorage);
   } else {
-    LOG(FATAL) << "Not implemented";
+    STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kDefaultStorage);
+  }
+  return true;
+}
+
+/*!
+ * \brief storage types of div: only row_sparse / dense stays row_sparse, the
+ *  zeros of the lhs are kept as zeros
+ */
+inline bool ElemwiseDivStorageType(const nnvm::NodeAttrs& attrs,
+                                   const Context& ctx,
+                                   std::vector<int> *in_attrs,
+                                   std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U) << " in operator " << attrs.name;
+  CHECK_EQ(out_attrs->size(), 1U) << " in operator " << attrs.name;
+  for (int& stype : *in_attrs) {
+    if (stype == kUndefinedStorage) stype = kDefaultStorage;
+  }
+  if ((*in_attrs)[0] == kRowSparseStorage && (*in_attrs)[1] == kDefaultStorage) {
+    STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kRowSparseStorage);
+  } else {
+    STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kDefaultStorage);
+  }
+  return true;
+}
+
+/*!
+ * \brief elementwise binary ops on sparse operands, the combinations without
+ *  a native kernel fall back to the dense FCompute
+ * \tparam zero_preserving whether OP(0, x) = OP(x, 0) = 0, in which case only
+ *  the common non-zeros of two sparse operands are computed
+ */
+template<typename xpu, typename OP, bool zero_preserving = false>
+void BinaryComputeEx(const nnvm::NodeAttrs& attrs,
+                     const OpContext& ctx,
+                     const std::vector<NDArray>& inputs,
+                     const std::vector<OpReqType>& req,
+                     const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  const auto lhs = inputs[0].storage_type();
+  const auto rhs = inputs[1].storage_type();
+  const auto out = outputs[0].storage_type();
+  // two sparse operands of div would give 0 / 0 at their common zeros
+  const bool merge = !std::is_same<OP, mshadow::op::div>::value;
+  if (std::is_same<xpu, cpu>::value) {
+    if (merge && lhs == kRowSparseStorage && rhs == kRowSparseStorage &&
+        out == kRowSparseStorage) {
+      BinaryComputeRspRspImpl<xpu, OP>(attrs, ctx, inputs, req, outputs, zero_preserving);
+      return;
+    }
+    if (merge && lhs == kCSRStorage && rhs == kCSRStorage && out == kCSRStorage) {
+      BinaryComputeCsrCsrImpl<xpu, OP>(attrs, ctx, inputs, req, outputs, zero_preserving);
+      return;
+    }
+    // a row_sparse result only holds the rows of the row_sparse operand when
+    // OP(0, x) = 0, which is true for mul and for the numerator of div
+    const bool lhs_zero = zero_preserving || std::is_same<OP, mshadow::op::div>::value;
+    if (lhs == kRowSparseStorage && rhs == kDefaultStorage &&
+        (out == kDefaultStorage || (out == kRowSparseStorage && lhs_zero))) {
+      BinaryComputeRspDnsImpl<xpu, OP, false>(attrs, ctx, inputs, req, outputs);
+      return;
+    }
+    if (lhs == kDefaultStorage && rhs == kRowSparseStorage &&
+        (out == kDefaultStorage || (out == kRowSparseStorage && zero_preserving))) {
+      BinaryComputeRspDnsImpl<xpu, OP, true>(attrs, ctx, inputs, req, outputs);
+      return;
+    }
   }
+  FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs, BinaryCompute<xpu, OP>,
+                       "BinaryCompute");
 }
 
 template<typename xpu, typename LOP, typename ROP>
@@ -33,6 +33,7 @@ MXNET_OPERATOR_REGISTER_BINARY(elemwise_add)
 The storage type of ``elemwise_add`` output depends on storage types of inputs
 
 - elemwise_add(row_sparse, row_sparse) = row_sparse
+- elemwise_add(csr, csr) = csr
 - otherwise, ``elemwise_add`` generates output with default storage
 
 )code")
@@ -44,7 +45,8 @@ The storage type of ``elemwise_add`` output depends on storage types of inputs
 // specialized gradient add function to do add to optimization
 // this must differ from elemwise_add to prevent add to optimization in forward pass.
 MXNET_OPERATOR_REGISTER_BINARY(_grad_add)
-.set_attr<FCompute>("FCompute<cpu>", BinaryCompute<cpu, mshadow::op::plus>);
+.set_attr<FCompute>("FCompute<cpu>", BinaryCompute<cpu, mshadow::op::plus>)
+.set_attr<nnvm::FGradient>("FGradient", CloneGradient{"_backward_add"});
 
 NNVM_REGISTER_OP(_backward_add)
 .set_num_inputs(1)
@@ -62,7 +64,18 @@ NNVM_REGISTER_OP(_backward_add)
 
 MXNET_OPERATOR_REGISTER_BINARY(_sub)
 .add_alias("_minus").add_alias("_Minus")
+.describe(R"code(Subtracts arguments element-wise.
+
+The storage type of ``_sub`` output depends on storage types of inputs
+
+- _sub(row_sparse, row_sparse) = row_sparse
+- _sub(csr, csr) = csr
+- otherwise, ``_sub`` generates output with default storage
+
+)code")
 .set_attr<FCompute>("FCompute<cpu>", BinaryCompute<cpu, mshadow::op::minus>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BinaryComputeEx<cpu, mshadow::op::minus>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseStorageType<2, 1>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_backward_sub"});
 
 NNVM_REGISTER_OP(_backward_sub)
@@ -74,11 +87,30 @@ NNVM_REGISTER_OP(_backward_sub)
     return std::vector<std::pair<int, int> >{{0, 0}, {0, 1}};
   })
 .set_attr<FCompute>("FCompute<cpu>", BinaryBackwardUseNone<cpu, mshadow_op::identity,
-                                                                mshadow_op::negation>);
+                                                                mshadow_op::negation>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    // the outputs are ograd and -ograd
+    auto p = MakeNode("_sub", n->attrs.name + "_backward",
+                      {ograds[0], ograds[1]}, nullptr, &n);
+    return std::vector<nnvm::NodeEntry>{nnvm::NodeEntry{p, 0, 0}};
+  });
 
 MXNET_OPERATOR_REGISTER_BINARY(_mul)
 .add_alias("_Mul")
+.describe(R"code(Multiplies arguments element-wise.
+
+The storage type of ``_mul`` output depends on storage types of inputs
+
+- _mul(row_sparse, row_sparse) = row_sparse
+- _mul(row_sparse, default) = _mul(default, row_sparse) = row_sparse
+- _mul(csr, csr) = csr
+- otherwise, ``_mul`` generates output with default storage
+
+)code")
 .set_attr<FCompute>("FCompute<cpu>", BinaryCompute<cpu, mshadow::op::mul>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BinaryComputeEx<cpu, mshadow::op::mul, true>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseMulStorageType)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_mul"});
 
 NNVM_REGISTER_OP(_backward_mul)
@@ -90,11 +122,42 @@ NNVM_REGISTER_OP(_backward_mul)
     return std::vector<std::pair<int, int> >{{0, 1}};
   })
 .set_attr<FCompute>("FCompute<cpu>", BinaryBackwardUseIn<cpu, mshadow_op::right,
-                                                              mshadow_op::left>);
+                                                              mshadow_op::left>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    // the outputs are ograd * rhs and ograd * lhs
+    const nnvm::NodeEntry& ograd = n->inputs[0];
+    const nnvm::NodeEntry& lhs = n->inputs[1];
+    const nnvm::NodeEntry& rhs = n->inputs[2];
+    auto ograd_lhs = MakeNode("_mul", n->attrs.name + "_ograd_lhs_backward",
+                              {ograds[0], rhs}, nullptr, &n);
+    auto ograd_rhs = MakeNode("_mul", n->attrs.name + "_ograd_rhs_backward",
+                              {ograds[1], lhs}, nullptr, &n);
+    auto ograd_grad = MakeNode("elemwise_add", n->attrs.name + "_ograd_backward",
+                               {nnvm::NodeEntry{ograd_lhs, 0, 0},
+                                nnvm::NodeEntry{ograd_rhs, 0, 0}}, nullptr, &n);
+    auto lhs_grad = MakeNode("_mul", n->attrs.name + "_lhs_backward",
+                             {ograds[1], ograd}, nullptr, &n);
+    auto rhs_grad = MakeNode("_mul", n->attrs.name + "_rhs_backward",
+                             {ograds[0], ograd}, nullptr, &n);
+    return std::vector<nnvm::NodeEntry>{nnvm::NodeEntry{ograd_grad, 0, 0},
+                                        nnvm::NodeEntry{lhs_grad, 0, 0},
+                                        nnvm::NodeEntry{rhs_grad, 0, 0}};
+  });
 
 MXNET_OPERATOR_REGISTER_BINARY(_div)
 .add_alias("_Div")
+.describe(R"code(Divides arguments element-wise.
+
+The storage type of ``_div`` output depends on storage types of inputs
+
+- _div(row_sparse, default) = row_sparse, the rows missing from the lhs stay zeros
+- otherwise, ``_div`` generates output with default storage
+
+)code")
 .set_attr<FCompute>("FCompute<cpu>", BinaryCompute<cpu, mshadow::op::div>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BinaryComputeEx<cpu, mshadow::op::div>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseDivStorageType)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_div"});
 
 NNVM_REGISTER_OP(_backward_div)
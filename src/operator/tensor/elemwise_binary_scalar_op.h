@@ -29,6 +29,7 @@
 #include <utility>
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
+#include "./elemwise_unary_op.h"
 
 namespace mxnet {
 namespace op {
@@ -49,6 +50,17 @@ void BinaryScalarCompute(const nnvm::NodeAttrs& attrs,
   });
 }
 
+/*! \brief FComputeEx of the scalar ops with OP(0, scalar) = 0 like mul and div */
+template<typename xpu, typename OP>
+void BinaryScalarComputeEx(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<NDArray>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<NDArray>& outputs) {
+  SparseValueComputeEx<xpu>(attrs, ctx, inputs, req, outputs,
+                            BinaryScalarCompute<xpu, OP>, "BinaryScalarCompute");
+}
+
 template<typename xpu, typename OP>
 void BinaryScalarBackward(const nnvm::NodeAttrs& attrs,
                           const OpContext& ctx,
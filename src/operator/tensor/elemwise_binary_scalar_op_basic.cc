@@ -43,12 +43,20 @@ MXNET_OPERATOR_REGISTER_BINARY_SCALAR(_rminus_scalar)
 .add_alias("_RMinusScalar");
 
 MXNET_OPERATOR_REGISTER_BINARY_SCALAR(_mul_scalar)
+.describe(R"code(Multiplies an array by a scalar, row_sparse and csr inputs keep their storage.
+)code")
 .set_attr<FCompute>("FCompute<cpu>", BinaryScalarCompute<cpu, mshadow::op::mul>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BinaryScalarComputeEx<cpu, mshadow::op::mul>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseStorageType<1, 1>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_mul_scalar"})
 .add_alias("_MulScalar");
 
 MXNET_OPERATOR_REGISTER_BINARY_SCALAR(_div_scalar)
+.describe(R"code(Divides an array by a scalar, row_sparse and csr inputs keep their storage.
+)code")
 .set_attr<FCompute>("FCompute<cpu>", BinaryScalarCompute<cpu, mshadow::op::div>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BinaryScalarComputeEx<cpu, mshadow::op::div>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseStorageType<1, 1>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_div_scalar"})
 .add_alias("_DivScalar");
 
@@ -37,10 +37,12 @@ NNVM_REGISTER_OP(_rminus_scalar)
 .set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow_op::rminus>);
 
 NNVM_REGISTER_OP(_mul_scalar)
-.set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow::op::mul>);
+.set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow::op::mul>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", BinaryScalarComputeEx<gpu, mshadow::op::mul>);
 
 NNVM_REGISTER_OP(_div_scalar)
-.set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow::op::div>);
+.set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow::op::div>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", BinaryScalarComputeEx<gpu, mshadow::op::div>);
 
 NNVM_REGISTER_OP(_rdiv_scalar)
 .set_attr<FCompute>("FCompute<gpu>", BinaryScalarCompute<gpu, mshadow_op::rdiv>);
@@ -26,6 +26,7 @@
 #define MXNET_OPERATOR_TENSOR_ELEMWISE_SUM_H_
 
 #include <dmlc/logging.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 #include "../operator_common.h"
@@ -52,6 +53,79 @@ struct Sum {
   }
 };
 
+/*!
+ * \brief the inputs of a sum of more than 4 arrays, passed by value to the kernels
+ */
+template<typename DType>
+struct SumInputs {
+  static const int kMaxInputs = 64;
+  const DType* ptr[kMaxInputs];
+  int num;
+};
+
+/*!
+ * \brief out = sum of the inputs in a single pass, which reads every input
+ *  once and writes out once for any number of inputs
+ */
+struct SumN {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const OpReqType req,
+                                  const SumInputs<DType> ins) {
+    DType sum = ins.ptr[0][i];
+    for (int j = 1; j < ins.num; ++j) {
+      sum += ins.ptr[j][i];
+    }
+    KERNEL_ASSIGN(out[i], req, sum);
+  }
+  /*!
+   * \brief out[begin, end) on cpu, by blocks which stay in the L1 cache, so that
+   *  the loops over a block are vectorized
+   */
+  template<typename DType>
+  static void Map(int begin, int end, DType* out, const OpReqType req,
+                  const SumInputs<DType> ins) {
+    const int kBlock = 256;
+    DType acc[kBlock];
+    for (int b = begin; b < end; b += kBlock) {
+      const int n = std::min(kBlock, end - b);
+      const DType* in = ins.ptr[0] + b;
+      for (int k = 0; k < n; ++k) {
+        acc[k] = in[k];
+      }
+      for (int j = 1; j < ins.num; ++j) {
+        in = ins.ptr[j] + b;
+        for (int k = 0; k < n; ++k) {
+          acc[k] += in[k];
+        }
+      }
+      DType* o = out + b;
+      if (req == kAddTo) {
+        for (int k = 0; k < n; ++k) {
+          o[k] += acc[k];
+        }
+      } else {
+        for (int k = 0; k < n; ++k) {
+          o[k] = acc[k];
+        }
+      }
+    }
+  }
+};
+
+template<typename DType>
+inline void LaunchSumN(mshadow::Stream<cpu> *s, int N, DType* out, OpReqType req,
+                       const SumInputs<DType>& ins) {
+  mxnet_op::Kernel<SumN, cpu>::LaunchEx(s, N, out, req, ins);
+}
+
+#ifdef __CUDACC__
+template<typename DType>
+inline void LaunchSumN(mshadow::Stream<gpu> *s, int N, DType* out, OpReqType req,
+                       const SumInputs<DType>& ins) {
+  mxnet_op::Kernel<SumN, gpu>::Launch(s, N, out, req, ins);
+}
+#endif  // __CUDACC__
+
 template<typename xpu, typename DType>
 void ElementWiseSumCompute_(const nnvm::NodeAttrs& attrs,
                             const OpContext& ctx,
@@ -89,11 +163,16 @@ void ElementWiseSumCompute_(const nnvm::NodeAttrs& attrs,
       break;
     }
     default: {
-      DType* in_0_dptr = in_data[0].dptr<DType>();
-      Kernel<Sum, xpu>::Launch(s, out_size, out_dptr, req[0], in_0_dptr);
-      for (size_t i = 1; i < size; ++i) {
-        DType* in_dptr = in_data[i].dptr<DType>();
-        Kernel<Sum, xpu>::Launch(s, out_size, out_dptr, req[0], out_dptr, in_dptr);
+      // a single pass up to kMaxInputs inputs, the next ones are added to out.
+      // When out is inplace, it is the first input, which is read in the first pass.
+      for (size_t begin = 0; begin < size; begin += SumInputs<DType>::kMaxInputs) {
+        SumInputs<DType> ins;
+        ins.num = static_cast<int>(std::min<size_t>(SumInputs<DType>::kMaxInputs,
+                                                    size - begin));
+        for (int i = 0; i < ins.num; ++i) {
+          ins.ptr[i] = in_data[begin + i].dptr<DType>();
+        }
+        LaunchSumN(s, out_size, out_dptr, begin == 0 ? req[0] : kAddTo, ins);
       }
       break;
     }
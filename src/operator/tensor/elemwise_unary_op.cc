@@ -369,8 +369,12 @@ Example::
 
    square([2, 3, 4]) = [4, 9, 16]
 
+The storage type of ``square`` output is the storage type of the input.
+
 )code" ADD_FILELINE)
 .set_attr<FCompute>("FCompute<cpu>", UnaryCompute<cpu, mshadow_op::square>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", UnaryComputeEx<cpu, mshadow_op::square>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseStorageType<1, 1>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_square"});
 
 MXNET_OPERATOR_REGISTER_BINARY(_backward_square)
@@ -387,8 +391,12 @@ Example::
 
    sqrt([4, 9, 16]) = [2, 3, 4]
 
+The storage type of ``sqrt`` output is the storage type of the input.
+
 )code" ADD_FILELINE)
 .set_attr<FCompute>("FCompute<cpu>", UnaryCompute<cpu, mshadow_op::square_root>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", UnaryComputeEx<cpu, mshadow_op::square_root>)
+.set_attr<FInferStorageType>("FInferStorageType", ElemwiseStorageType<1, 1>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseOut{"_backward_sqrt"});
 
 MXNET_OPERATOR_REGISTER_BINARY(_backward_sqrt)
@@ -116,14 +116,16 @@ NNVM_REGISTER_OP(fix)
 
 // square
 NNVM_REGISTER_OP(square)
-.set_attr<FCompute>("FCompute<gpu>", UnaryCompute<gpu, mshadow_op::square>);
+.set_attr<FCompute>("FCompute<gpu>", UnaryCompute<gpu, mshadow_op::square>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", UnaryComputeEx<gpu, mshadow_op::square>);
 
 NNVM_REGISTER_OP(_backward_square)
 .set_attr<FCompute>("FCompute<gpu>", BinaryCompute<gpu, unary_bwd<mshadow_op::square_grad> >);
 
 // sqrt
 NNVM_REGISTER_OP(sqrt)
-.set_attr<FCompute>("FCompute<gpu>", UnaryCompute<gpu, mshadow_op::square_root>);
+.set_attr<FCompute>("FCompute<gpu>", UnaryCompute<gpu, mshadow_op::square_root>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", UnaryComputeEx<gpu, mshadow_op::square_root>);
 
 NNVM_REGISTER_OP(_backward_sqrt)
 .set_attr<FCompute>("FCompute<gpu>", BinaryCompute<gpu, unary_bwd<mshadow_op::square_root_grad> >);
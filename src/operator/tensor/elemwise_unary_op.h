@@ -25,6 +25,7 @@
 #define MXNET_OPERATOR_TENSOR_ELEMWISE_UNARY_OP_H_
 
 #include <mxnet/operator_util.h>
+#include <string>
 #include <vector>
 #include <utility>
 #include "../mxnet_op.h"
@@ -162,6 +163,51 @@ void IdentityComputeEx(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*!
+ * \brief run the dense fcompute of an op with f(0) = 0 on the stored values of a
+ *  row_sparse or csr input, the output keeps the indices of the input. Other
+ *  combinations of storage types fall back to the dense fcompute.
+ */
+template<typename xpu>
+void SparseValueComputeEx(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<NDArray>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<NDArray>& outputs,
+                          FCompute fcompute,
+                          const std::string& fname) {
+  CHECK_EQ(inputs.size(), 1U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  const auto in_stype = inputs[0].storage_type();
+  const auto out_stype = outputs[0].storage_type();
+  if (in_stype != out_stype || in_stype == kDefaultStorage) {
+    FCompExFallback<xpu>(attrs, ctx, inputs, req, outputs, fcompute, fname);
+    return;
+  }
+  if (!inputs[0].storage_initialized()) {
+    FillComputeZerosEx<xpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  CHECK_EQ(req[0], kWriteTo) << fname << " only supports kWriteTo for sparse outputs";
+  outputs[0].CheckAndAlloc(inputs[0].aux_shapes());
+  for (size_t i = 0; i < mxnet::num_aux_data(out_stype); ++i) {
+    IdentityCompute<xpu>(attrs, ctx, {inputs[0].aux_data(i)}, req, {outputs[0].aux_data(i)});
+  }
+  fcompute(attrs, ctx, {inputs[0].data()}, req, {outputs[0].data()});
+}
+
+/*! \brief FComputeEx of the unary ops with OP(0) = 0 */
+template<typename xpu, typename OP>
+void UnaryComputeEx(const nnvm::NodeAttrs& attrs,
+                    const OpContext& ctx,
+                    const std::vector<NDArray>& inputs,
+                    const std::vector<OpReqType>& req,
+                    const std::vector<NDArray>& outputs) {
+  SparseValueComputeEx<xpu>(attrs, ctx, inputs, req, outputs,
+                            UnaryCompute<xpu, OP>, "UnaryCompute");
+}
+
 inline bool IdentityAttrLikeRhsStorageType(const nnvm::NodeAttrs& attrs,
                                            const Context& ctx,
                                            std::vector<int> *in_attrs,
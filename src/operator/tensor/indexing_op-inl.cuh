@@ -307,6 +307,103 @@ inline void AddTakeGradLargeBatch(mshadow::Tensor<gpu, 2, DType> dst,
   MSHADOW_CUDA_POST_KERNEL_CHECK(AddTakeGradLargeBatchKernel);
 }
 
+/*! \brief mark the first lookup of every row in the sorted lookups */
+struct MarkSegmentHeads {
+  MSHADOW_XINLINE static void Map(int i, int* flag, const int* sorted) {
+    flag[i] = (i == 0 || sorted[i] != sorted[i - 1]) ? 1 : 0;
+  }
+};
+
+/*!
+ * \brief write the row index and the first lookup of every unique row,
+ *  slot is the inclusive prefix sum of the segment heads
+ */
+struct FillSegmentStarts {
+  template<typename RType>
+  MSHADOW_XINLINE static void Map(int i, RType* idx_out, int* seg_start, const int* slot,
+                                  const int* sorted, const int num_lookups) {
+    if (i == 0 || sorted[i] != sorted[i - 1]) {
+      idx_out[slot[i] - 1] = static_cast<RType>(sorted[i]);
+      seg_start[slot[i] - 1] = i;
+    }
+    if (i == num_lookups - 1) {
+      seg_start[slot[i]] = num_lookups;
+    }
+  }
+};
+
+inline void SparseEmbeddingOpBackwardRspImpl(const OpContext& ctx,
+                                             const gpu& gpu_dev,
+                                             const TBlob& ograd,
+                                             const TBlob& data,
+                                             const OpReqType req,
+                                             const NDArray& output) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK_EQ(req, kWriteTo) << "SparseEmbedding layer doesn't support "
+                          << "weight gradient calculation with req != write";
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  const dim_t num_lookups = data.Size();
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape().ProdShape(1, output.shape().ndim());
+  NDArray out = output;
+  if (num_lookups == 0) {
+    FillZerosRspImpl(s, &out);
+    return;
+  }
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  // workspace = [temp storage of sort and scan, sorted rows, original positions,
+  //              segment slots, segment starts]
+  size_t scan_bytes = 0;
+  int* null_ptr = nullptr;
+  cub::DeviceScan::InclusiveSum(nullptr, scan_bytes, null_ptr, null_ptr,
+                                static_cast<int>(num_lookups), stream);
+  const size_t temp_bytes = std::max(SortByKeyWorkspaceSize<int, int, gpu>(num_lookups),
+                                     scan_bytes);
+  const size_t int_bytes = num_lookups * sizeof(int);
+  Tensor<gpu, 1, char> workspace = ctx.requested[embedding::kTempSpace]
+    .get_space_typed<gpu, 1, char>(Shape1(temp_bytes + 4 * int_bytes + sizeof(int)), s);
+  Tensor<gpu, 1, char> temp_storage(workspace.dptr_, Shape1(temp_bytes), s);
+  int* sorted_ptr = reinterpret_cast<int*>(workspace.dptr_ + temp_bytes);
+  int* order_ptr = sorted_ptr + num_lookups;
+  int* slot_ptr = order_ptr + num_lookups;
+  int* seg_start_ptr = slot_ptr + num_lookups;
+  Tensor<gpu, 1, int> sorted(sorted_ptr, Shape1(num_lookups), s);
+  Tensor<gpu, 1, int> order(order_ptr, Shape1(num_lookups), s);
+
+  // sort the lookups by row
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    Kernel<tcast_clip, gpu>::Launch(s, num_lookups, sorted_ptr, data.dptr<IType>(),
+                                    static_cast<int>(num_rows));
+  });
+  order = range<int>(0, num_lookups);
+  const int num_bits = ilog2(num_rows - 1);
+  SortByKey(sorted, order, true, &temp_storage, 0, num_bits);
+  // the slot of every lookup in the output is the number of unique rows up to it
+  Kernel<MarkSegmentHeads, gpu>::Launch(s, num_lookups, slot_ptr, sorted_ptr);
+  cub::DeviceScan::InclusiveSum(temp_storage.dptr_, scan_bytes, slot_ptr, slot_ptr,
+                                static_cast<int>(num_lookups), stream);
+  int nnr = 0;
+  CUDA_CALL(cudaMemcpy(&nnr, slot_ptr + num_lookups - 1, sizeof(int),
+                       cudaMemcpyDeviceToHost));
+
+  out.CheckAndAlloc({Shape1(nnr)});
+  MSHADOW_TYPE_SWITCH(ograd.type_flag_, DType, {
+    MSHADOW_IDX_TYPE_SWITCH(out.aux_type(kIdx), RType, {
+      Kernel<FillSegmentStarts, gpu>::Launch(s, num_lookups,
+        out.aux_data(kIdx).dptr<RType>(), seg_start_ptr, slot_ptr, sorted_ptr,
+        static_cast<int>(num_lookups));
+      Kernel<AddTakeGradRspKernel, gpu>::Launch(s, nnr * row_length,
+        out.data().dptr<DType>(), ograd.dptr<DType>(), seg_start_ptr, order_ptr,
+        row_length);
+    });
+  });
+}
+
 }  // namespace op
 }  // namespace mxnet
 #endif  // MXNET_OPERATOR_TENSOR_INDEXING_OP_CUH_
@@ -35,6 +35,7 @@
 #include <utility>
 #include <algorithm>
 #include <type_traits>
+#include <unordered_map>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
@@ -283,6 +284,48 @@ void AddTakeGradLargeBatchCaller(const OpContext& ctx, mshadow::Tensor<xpu, 2, D
   mxnet::op::AddTakeGradLargeBatch(dst, sorted_data, original_index, src, &temp_storage);
 }
 
+/*! \brief whether MXNET_ENFORCE_DETERMINISM asks for results that are the same on every run */
+inline bool EnforceDeterminism() {
+  static const bool enforce = dmlc::GetEnv("MXNET_ENFORCE_DETERMINISM", false);
+  return enforce;
+}
+
+/*!
+ * \brief Accumulate the gradient of the lookups, dst[index[i]] += src[i].
+ *  Small problems are summed up directly by AddTakeGrad. On gpu AddTakeGrad adds
+ *  with atomics, whose contention on the rows looked up often (padding, stop words)
+ *  serializes the lookups and whose result depends on the order of the additions.
+ *  It is then only used for small batches spread over many more rows, and never when
+ *  determinism is enforced. Otherwise the lookups are sorted by row and every segment
+ *  of lookups is summed up by one thread block, in the order of the lookups.
+ */
+template<typename xpu, typename IndexType, typename DType>
+void AddTakeGradCaller(const OpContext& ctx, mshadow::Tensor<xpu, 2, DType> dst,
+                       const mshadow::Tensor<xpu, 1, IndexType>& index,
+                       const mshadow::Tensor<xpu, 2, DType> &src) {
+  // shape_out_prod ~= the number of elements loaded in AddTakeGrad
+  // shape_in_prod  ~= the number of elements stored in AddTakeGrad
+  // When the number of elements processed is low, use AddTakeGrad.
+  // The approximate cut-off value 16384 was found experimentally on Titan X Pascal
+  uint64_t shape_in_prod =
+    static_cast<uint64_t>(dst.shape_[0])*
+    static_cast<uint64_t>(dst.shape_[1]);
+  uint64_t shape_out_prod =
+    static_cast<uint64_t>(src.shape_[0])*
+    static_cast<uint64_t>(src.shape_[1]);
+  bool small = shape_out_prod < (uint64_t)16384 && shape_in_prod < (uint64_t)16384;
+  if (std::is_same<xpu, gpu>::value) {
+    // at most one lookup in 4 rows on average, few collisions unless the batch is skewed
+    small = small && !EnforceDeterminism() &&
+            static_cast<uint64_t>(src.shape_[0]) * 4 <= static_cast<uint64_t>(dst.shape_[0]);
+  }
+  if (small) {
+    AddTakeGrad(dst, index, src);
+  } else {
+    AddTakeGradLargeBatchCaller(ctx, dst, index, src);
+  }
+}
+
 template<typename xpu>
 void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
                          const OpContext& ctx,
@@ -314,21 +357,7 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
         if (req[embedding::kWeight] == kWriteTo) {
           grad_in = scalar<DType>(0.0f);
         }
-        // shape_out_prod ~= the number of elements loaded in AddTakeGrad
-        // shape_in_prod  ~= the number of elements stored in AddTakeGrad
-        // When the number of elements processed is low, use AddTakeGrad.
-        // The approximate cut-off value 16384 was found experimentally on Titan X Pascal
-        uint64_t shape_in_prod =
-          static_cast<uint64_t>(grad_in.shape_[0])*
-          static_cast<uint64_t>(grad_in.shape_[1]);
-        uint64_t shape_out_prod =
-          static_cast<uint64_t>(grad_out.shape_[0])*
-          static_cast<uint64_t>(grad_out.shape_[1]);
-        if (shape_out_prod < (uint64_t)16384 && shape_in_prod < (uint64_t)16384) {
-          AddTakeGrad(grad_in, data, grad_out);
-        } else {
-          AddTakeGradLargeBatchCaller(ctx, grad_in, data, grad_out);
-        }
+        AddTakeGradCaller(ctx, grad_in, data, grad_out);
       } else {
         LOG(FATAL) << "wrong req";
       }
@@ -336,6 +365,249 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
   });
 }
 
+inline bool SparseEmbeddingForwardStorageType(const nnvm::NodeAttrs& attrs,
+                                              const Context& ctx,
+                                              std::vector<int> *in_attrs,
+                                              std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  // the weight is either dense or the row_sparse result of a row_sparse_pull
+  type_assign(&((*out_attrs)[embedding::kOut]), kDefaultStorage);
+  return true;
+}
+
+inline bool SparseEmbeddingBackwardStorageType(const nnvm::NodeAttrs& attrs,
+                                               const Context& ctx,
+                                               std::vector<int> *in_attrs,
+                                               std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  type_assign(&((*out_attrs)[embedding::kData]), kDefaultStorage);
+  type_assign(&((*out_attrs)[embedding::kWeight]), kRowSparseStorage);
+  return true;
+}
+
+/*!
+ * \brief The backward storage types of Embedding and take, the gradient of the
+ *  looked up array, at position kGrad, is row_sparse when it is bound as row_sparse
+ *  and dense otherwise.
+ */
+template<int kGrad>
+inline bool LookupBackwardStorageType(const nnvm::NodeAttrs& attrs,
+                                      const Context& ctx,
+                                      std::vector<int> *in_attrs,
+                                      std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  for (size_t i = 0; i < in_attrs->size(); ++i) {
+    type_assign(&((*in_attrs)[i]), kDefaultStorage);
+  }
+  for (int i = 0; i < static_cast<int>(out_attrs->size()); ++i) {
+    if (i == kGrad && (*out_attrs)[i] == kRowSparseStorage) continue;
+    type_assign(&((*out_attrs)[i]), kDefaultStorage);
+  }
+  return true;
+}
+
+/*!
+ * \brief Take from a row_sparse weight, the rows missing from the weight are zeros
+ *  weight_idx holds the nnr sorted row indices of the weight, K is its total number of rows
+ */
+struct TakeRsp {
+  template<typename DType, typename IType, typename RType>
+  MSHADOW_XINLINE static void Map(int i, DType* out_data, const DType* weight_data,
+                                  const RType* weight_idx, const IType* idx,
+                                  const nnvm::dim_t M, const nnvm::dim_t K,
+                                  const nnvm::dim_t nnr) {
+    using nnvm::dim_t;
+    dim_t j = static_cast<dim_t>(idx[i / M]);
+    if (j <= 0) j = 0;
+    else if (j >= K) j = K - 1;
+    // binary search for the row j in the weight
+    dim_t lo = 0, hi = nnr;
+    while (lo < hi) {
+      const dim_t mid = lo + (hi - lo) / 2;
+      if (static_cast<dim_t>(weight_idx[mid]) < j) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    out_data[i] = (lo < nnr && static_cast<dim_t>(weight_idx[lo]) == j) ?
+                  weight_data[lo * M + i % M] : DType(0);
+  }
+};
+
+template<typename xpu>
+void SparseEmbeddingOpForwardEx(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<NDArray>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<NDArray>& outputs) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  CHECK_EQ(req[embedding::kOut], kWriteTo);
+  const NDArray& data = inputs[embedding::kData];
+  const NDArray& weight = inputs[embedding::kWeight];
+  const NDArray& out = outputs[embedding::kOut];
+  CHECK_EQ(data.storage_type(), kDefaultStorage);
+  CHECK_EQ(out.storage_type(), kDefaultStorage);
+  if (weight.storage_type() == kDefaultStorage) {
+    EmbeddingOpForward<xpu>(attrs, ctx, {data.data(), weight.data()}, req, {out.data()});
+    return;
+  }
+  CHECK_EQ(weight.storage_type(), kRowSparseStorage)
+    << "SparseEmbedding expects a default or row_sparse weight";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob out_data = out.data();
+  MSHADOW_TYPE_SWITCH(out_data.type_flag_, DType, {
+    if (!weight.storage_initialized()) {
+      Kernel<set_zero, xpu>::Launch(s, out_data.Size(), out_data.dptr<DType>());
+      return;
+    }
+    MSHADOW_TYPE_SWITCH(data.dtype(), IType, {
+      MSHADOW_IDX_TYPE_SWITCH(weight.aux_type(kIdx), RType, {
+        const nnvm::dim_t row_length = weight.shape()[1];
+        Kernel<TakeRsp, xpu>::Launch(s, out_data.Size(), out_data.dptr<DType>(),
+          weight.data().dptr<DType>(), weight.aux_data(kIdx).dptr<RType>(),
+          data.data().dptr<IType>(), row_length,
+          static_cast<nnvm::dim_t>(weight.shape()[0]),
+          static_cast<nnvm::dim_t>(weight.aux_shape(kIdx)[0]));
+      });
+    });
+  });
+}
+
+/*!
+ * \brief Sum the gradient rows of the lookups of every unique row.
+ *  The lookups order[seg_start[k]], ..., order[seg_start[k + 1] - 1] hit the k-th
+ *  unique row, i is the index of the element of the nnr x M output
+ */
+struct AddTakeGradRspKernel {
+  template<typename DType, typename SType, typename OType>
+  MSHADOW_XINLINE static void Map(int i, DType* out, const DType* ograd,
+                                  const SType* seg_start, const OType* order,
+                                  const nnvm::dim_t M) {
+    using nnvm::dim_t;
+    const dim_t k = i / M;
+    const dim_t j = i % M;
+    DType sum = DType(0);
+    for (dim_t p = seg_start[k]; p < seg_start[k + 1]; ++p) {
+      sum += ograd[static_cast<dim_t>(order[p]) * M + j];
+    }
+    out[i] = sum;
+  }
+};
+
+/*!
+ * \brief CPU: the row_sparse gradient of the weight of SparseEmbedding.
+ *  The looked-up rows are aggregated with a hash map, so the cost only
+ *  depends on the number of lookups and not on the number of rows of the weight.
+ */
+inline void SparseEmbeddingOpBackwardRspImpl(const OpContext& ctx,
+                                             const cpu& cpu_dev,
+                                             const TBlob& ograd,
+                                             const TBlob& data,
+                                             const OpReqType req,
+                                             const NDArray& output) {
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK_EQ(req, kWriteTo) << "SparseEmbedding layer doesn't support "
+                          << "weight gradient calculation with req != write";
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const dim_t num_lookups = data.Size();
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape().ProdShape(1, output.shape().ndim());
+  NDArray out = output;
+  if (num_lookups == 0) {
+    FillZerosRspImpl(s, &out);
+    return;
+  }
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    MSHADOW_TYPE_SWITCH(ograd.type_flag_, DType, {
+      MSHADOW_IDX_TYPE_SWITCH(output.aux_type(kIdx), RType, {
+        const IType* data_ptr = data.dptr<IType>();
+        // slot of every looked-up row, clipped as in the forward lookup
+        std::vector<dim_t> rows(num_lookups);
+        std::unordered_map<dim_t, dim_t> slots;
+        slots.reserve(num_lookups);
+        for (dim_t i = 0; i < num_lookups; ++i) {
+          dim_t j = static_cast<dim_t>(data_ptr[i]);
+          if (j <= 0) j = 0;
+          else if (j >= num_rows) j = num_rows - 1;
+          rows[i] = j;
+          slots.emplace(j, 0);
+        }
+        // the row indices of a row_sparse array are sorted
+        std::vector<dim_t> unique_rows;
+        unique_rows.reserve(slots.size());
+        for (const auto& kv : slots) unique_rows.push_back(kv.first);
+        std::sort(unique_rows.begin(), unique_rows.end());
+        const dim_t nnr = unique_rows.size();
+        for (dim_t k = 0; k < nnr; ++k) slots[unique_rows[k]] = k;
+        // group the lookups by slot with a counting sort
+        std::vector<dim_t> seg_start(nnr + 1, 0);
+        for (dim_t i = 0; i < num_lookups; ++i) ++seg_start[slots[rows[i]] + 1];
+        for (dim_t k = 0; k < nnr; ++k) seg_start[k + 1] += seg_start[k];
+        std::vector<dim_t> order(num_lookups);
+        std::vector<dim_t> cursor(seg_start.begin(), seg_start.end() - 1);
+        for (dim_t i = 0; i < num_lookups; ++i) order[cursor[slots[rows[i]]]++] = i;
+
+        out.CheckAndAlloc({mshadow::Shape1(nnr)});
+        RType* idx_out = out.aux_data(kIdx).dptr<RType>();
+        for (dim_t k = 0; k < nnr; ++k) idx_out[k] = static_cast<RType>(unique_rows[k]);
+        Kernel<AddTakeGradRspKernel, cpu>::Launch(s, nnr * row_length,
+          out.data().dptr<DType>(), ograd.dptr<DType>(), seg_start.data(), order.data(),
+          row_length);
+      });
+    });
+  });
+}
+
+/*!
+ * \brief GPU: the row_sparse gradient of the weight of SparseEmbedding.
+ *  The lookups are sorted by row, the unique rows are found with a prefix sum
+ *  over the segment heads and every segment is summed up.
+ */
+inline void SparseEmbeddingOpBackwardRspImpl(const OpContext& ctx,
+                                             const gpu& gpu_dev,
+                                             const TBlob& ograd,
+                                             const TBlob& data,
+                                             const OpReqType req,
+                                             const NDArray& output);
+
+template<typename xpu>
+void SparseEmbeddingOpBackwardEx(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<NDArray>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  const NDArray& weight_grad = outputs[1];
+  const NDArray& ograd = inputs[0];
+  const NDArray& data = inputs[1];
+  CHECK_EQ(req[embedding::kData], kNullOp)
+          << "SparseEmbedding layer doesn't support calculate data gradient";
+  CHECK_EQ(data.storage_type(), kDefaultStorage);
+  CHECK_EQ(ograd.storage_type(), kDefaultStorage);
+  CHECK_EQ(weight_grad.dtype(), ograd.dtype());
+  if (weight_grad.storage_type() == kRowSparseStorage) {
+    SparseEmbeddingOpBackwardRspImpl(ctx, xpu(), ograd.data(), data.data(),
+                                     req[embedding::kWeight], weight_grad);
+  } else if (weight_grad.storage_type() == kDefaultStorage) {
+    EmbeddingOpBackward<xpu>(attrs, ctx, {ograd.data(), data.data()}, req,
+                             {outputs[0].data(), weight_grad.data()});
+  } else {
+    LOG(FATAL) << "Unexpected storage type for the weight gradient of SparseEmbedding: "
+               << weight_grad.storage_type();
+  }
+}
+
 namespace take_ {  // to avoid name conflict
 enum TakeOpInputs {kArr, kIdx};
 enum TakeOpOutputs {kOut};
@@ -475,21 +747,7 @@ void TakeOpBackward(const nnvm::NodeAttrs& attrs,
         if (req[take_::kArr] == kWriteTo) {
           grad_in = scalar<DType>(0.0f);
         }
-        // shape_out_prod ~= the number of elements loaded in AddTakeGrad
-        // shape_in_prod  ~= the number of elements stored in AddTakeGrad
-        // When the number of elements processed is low, use AddTakeGrad.
-        // The approximate cut-off value 16384 was found experimentally on Titan X Pascal
-        uint64_t shape_in_prod =
-          static_cast<uint64_t>(grad_in.shape_[0])*
-          static_cast<uint64_t>(grad_in.shape_[1]);
-        uint64_t shape_out_prod =
-          static_cast<uint64_t>(grad_out.shape_[0])*
-          static_cast<uint64_t>(grad_out.shape_[1]);
-        if (shape_out_prod < (uint64_t)16384 && shape_in_prod < (uint64_t)16384) {
-          AddTakeGrad(grad_in, idx, grad_out);
-        } else {
-          AddTakeGradLargeBatchCaller(ctx, grad_in, idx, grad_out);
-        }
+        AddTakeGradCaller(ctx, grad_in, idx, grad_out);
       } else {
         LOG(FATAL) << "wrong req";
       }
@@ -497,6 +755,29 @@ void TakeOpBackward(const nnvm::NodeAttrs& attrs,
   });
 }
 
+template<typename xpu>
+void TakeOpBackwardEx(const nnvm::NodeAttrs& attrs,
+                      const OpContext& ctx,
+                      const std::vector<NDArray>& inputs,
+                      const std::vector<OpReqType>& req,
+                      const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK_EQ(req[take_::kIdx], kNullOp)
+    << "take layer doesn't support gradient into index";
+  const NDArray& arr_grad = outputs[take_::kArr];
+  CHECK_EQ(inputs[0].storage_type(), kDefaultStorage);
+  CHECK_EQ(inputs[1].storage_type(), kDefaultStorage);
+  CHECK_EQ(arr_grad.dtype(), inputs[0].dtype());
+  if (arr_grad.storage_type() == kRowSparseStorage) {
+    SparseEmbeddingOpBackwardRspImpl(ctx, xpu(), inputs[0].data(), inputs[1].data(),
+                                     req[take_::kArr], arr_grad);
+  } else {
+    LOG(FATAL) << "Unexpected storage type for the gradient of take: "
+               << arr_grad.storage_type();
+  }
+}
+
 inline bool BatchTakeOpShape(const nnvm::NodeAttrs& attrs,
                              std::vector<TShape> *in_attrs,
                              std::vector<TShape> *out_attrs) {
@@ -34,6 +34,8 @@
 #include "../channel_op_common.h"
 #include "../mxnet_op.h"
 #include "broadcast_reduce_op.h"
+#include "./elemwise_unary_op.h"
+#include "./transpose_cpu.h"
 
 #if MXNET_USE_CUDA
 #include <thrust/device_vector.h>
@@ -219,6 +221,12 @@ void TransposeImpl(RunContext ctx,
   using namespace mshadow::expr;
   CHECK_EQ(src.type_flag_, ret.type_flag_);
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  if (std::is_same<xpu, cpu>::value && axes.ndim() > 1) {
+    MSHADOW_TYPE_SWITCH(ret.type_flag_, DType, {
+      TransposeCPU(src.dptr<DType>(), ret.dptr<DType>(), src.shape_, axes);
+    });
+    return;
+  }
   MSHADOW_TYPE_SWITCH(ret.type_flag_, DType, {
     switch (axes.ndim()) {
      case 0:
@@ -999,6 +1007,33 @@ void Clip(const nnvm::NodeAttrs& attrs,
   });
 }
 
+/*! \brief sparse inputs stay sparse when the interval of clip contains 0 */
+inline bool ClipStorageType(const nnvm::NodeAttrs& attrs,
+                            const Context& ctx,
+                            std::vector<int> *in_attrs,
+                            std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const ClipParam& param = nnvm::get<ClipParam>(attrs.parsed);
+  if (param.a_min <= 0.f && param.a_max >= 0.f) {
+    return ElemwiseStorageType<1, 1>(attrs, ctx, in_attrs, out_attrs);
+  }
+  if ((*in_attrs)[0] == kUndefinedStorage) {
+    STORAGE_TYPE_ASSIGN_CHECK(*in_attrs, 0, kDefaultStorage);
+  }
+  STORAGE_TYPE_ASSIGN_CHECK(*out_attrs, 0, kDefaultStorage);
+  return true;
+}
+
+template<typename xpu>
+void ClipEx(const nnvm::NodeAttrs& attrs,
+            const OpContext& ctx,
+            const std::vector<NDArray>& inputs,
+            const std::vector<OpReqType>& req,
+            const std::vector<NDArray>& outputs) {
+  SparseValueComputeEx<xpu>(attrs, ctx, inputs, req, outputs, Clip<xpu>, "Clip");
+}
+
 template<typename xpu>
 void ClipGrad_(const nnvm::NodeAttrs& attrs,
                const OpContext& ctx,
@@ -365,6 +365,18 @@ Examples::
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
 .set_attr<FCompute>("FCompute<cpu>", SliceAxis<cpu>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_backward_slice_axis"})
+.set_attr<FOutputViews>("FOutputViews",
+  [](const NodeAttrs& attrs, const TShape& ishape, std::vector<size_t>* offsets) {
+    const SliceAxisParam& param = nnvm::get<SliceAxisParam>(attrs.parsed);
+    int axis, begin, end;
+    GetSliceAxisParams(param, ishape, &axis, &begin, &end);
+    if (ishape.Size() == 0) return false;
+    for (int i = 0; i < axis; ++i) {
+      if (ishape[i] != 1) return false;
+    }
+    *offsets = {ishape.Size() / ishape[axis] * begin};
+    return true;
+  })
 .add_argument("data", "NDArray-or-Symbol", "Source input")
 .add_arguments(SliceAxisParam::__FIELDS__());
 
@@ -389,6 +401,9 @@ Example::
 
     clip(x,1,8) = [ 1.,  1.,  2.,  3.,  4.,  5.,  6.,  7.,  8.,  8.]
 
+The storage type of ``clip`` output is the storage type of the input when
+``a_min <= 0 <= a_max``, and default otherwise.
+
 )code" ADD_FILELINE)
 .set_num_inputs(1)
 .set_num_outputs(1)
@@ -396,6 +411,8 @@ Example::
 .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<1, 1>)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
 .set_attr<FCompute>("FCompute<cpu>", Clip<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", ClipEx<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", ClipStorageType)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{ "_backward_clip" })
 .add_argument("data", "NDArray-or-Symbol", "Input array.")
 .add_arguments(ClipParam::__FIELDS__());
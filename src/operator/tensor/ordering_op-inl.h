@@ -34,6 +34,7 @@
 #include "../elemwise_op_common.h"
 #include "./sort_op.h"
 #include "./indexing_op.h"
+#include "../../engine/openmp.h"
 
 namespace mshadow {
 template<typename xpu, int src_dim, typename DType, int dst_dim>
@@ -151,6 +152,150 @@ inline void ParseTopKParam(const TShape& src_shape, const TopKParam& param, TSha
                                       << *element_num << ", get k = " << *k;
 }
 
+/*! \brief the TopKParam computing sort and argsort */
+inline TopKParam ToTopKParam(const TopKParam& param) {
+  return param;
+}
+
+inline TopKParam ToTopKParam(const SortParam& param) {
+  TopKParam topk_param;
+  topk_param.axis = param.axis;
+  topk_param.is_ascend = param.is_ascend;
+  topk_param.k = 0;
+  topk_param.ret_typ = topk_enum::kReturnValue;
+  return topk_param;
+}
+
+inline TopKParam ToTopKParam(const ArgSortParam& param) {
+  TopKParam topk_param;
+  topk_param.axis = param.axis;
+  topk_param.is_ascend = param.is_ascend;
+  topk_param.k = 0;
+  topk_param.ret_typ = topk_enum::kReturnIndices;
+  return topk_param;
+}
+
+/*!
+ * \brief bytes of the workspace of TopKImpl
+ * \param src_shape shape of the input
+ * \param param the parameters of topk
+ * \param temp_size returns the bytes of the part given to SortByKey
+ */
+template<typename xpu>
+inline size_t TopKWorkspaceSize(const TShape& src_shape, const TopKParam& param,
+                                size_t *temp_size) {
+  int batch_size, element_num, axis, k;
+  bool do_transpose, is_ascend;
+  TShape target_shape;
+  ParseTopKParam(src_shape, param,
+                 &target_shape, &batch_size, &element_num, &axis, &k, &do_transpose, &is_ascend);
+  const size_t n = src_shape.Size();
+  *temp_size = mxnet::op::SortByKeyWorkspaceSize<int, int, xpu>(n);
+  *temp_size = std::max(*temp_size, mxnet::op::SortByKeyWorkspaceSize<int, real_t, xpu>(n));
+  *temp_size = std::max(*temp_size, mxnet::op::SortByKeyWorkspaceSize<real_t, int, xpu>(n));
+  size_t workspace_size = *temp_size + sizeof(real_t) * n + sizeof(int) * n * 2;
+  if (param.ret_typ == topk_enum::kReturnMask) {
+    workspace_size += sizeof(int) * batch_size * k + sizeof(real_t) * batch_size * k;
+  }
+  return workspace_size;
+}
+
+/*! \brief FTempSpaceSize of topk, sort and argsort */
+template<typename xpu, typename ParamType>
+inline size_t TopKTempSpaceSize(const nnvm::NodeAttrs& attrs,
+                                const std::vector<TShape>& in_shape,
+                                const std::vector<int>& in_type) {
+  size_t temp_size;
+  return TopKWorkspaceSize<xpu>(in_shape[0], ToTopKParam(nnvm::get<ParamType>(attrs.parsed)),
+                                &temp_size);
+}
+
+/*!
+ * \brief Sort every row of N elements of dat, keeping the original global
+ *  indices of the elements in ind, so that the first K elements of every row
+ *  are the top K ones in order. Equal elements keep their original order.
+ *  This is the generic version, which sorts the whole array three times.
+ * \param dat the rows of data to sort
+ * \param ind the global indices of the elements, range(0, dat.size(0)) on entry
+ * \param batch_id returns the row of every element of ind
+ * \param work temporary space of SortByKey
+ * \param K number of elements of every row which have to be sorted
+ * \param N number of elements of every row
+ * \param is_ascend whether to sort in ascending order
+ */
+template<typename xpu, typename DType>
+inline void TopKSort(mshadow::Tensor<xpu, 1, DType> dat,
+                     mshadow::Tensor<xpu, 1, int> ind,
+                     mshadow::Tensor<xpu, 1, int> batch_id,
+                     mshadow::Tensor<xpu, 1, char> work,
+                     int K, int N, bool is_ascend) {
+  // Sort the data and keep record of the correspondence to global indices.
+  mxnet::op::SortByKey(dat, ind, is_ascend, &work);
+  // Calculate the corresponding batch indices of the elements
+  batch_id = ind / N;
+  // Since the SortByKey performs stable sort, the second SortByKey will reorder
+  //   the dat based on the order of the batch_id
+  mxnet::op::SortByKey(batch_id, dat, true, &work);
+  // Reorder the indices
+  batch_id = ind / N;
+  mxnet::op::SortByKey(batch_id, ind, true, &work);
+}
+
+/*!
+ * \brief CPU version of TopKSort. The rows are sorted independently in
+ *  parallel, and only the first K elements of a row are ordered, with a heap,
+ *  when K is small compared to N.
+ */
+template<typename DType>
+inline void TopKSort(mshadow::Tensor<cpu, 1, DType> dat,
+                     mshadow::Tensor<cpu, 1, int> ind,
+                     mshadow::Tensor<cpu, 1, int> batch_id,
+                     mshadow::Tensor<cpu, 1, char> work,
+                     int K, int N, bool is_ascend) {
+  const int M = dat.size(0) / N;
+  const bool full_sort = K * 8 > N;
+  const DType *vals = dat.dptr_;
+  const int omp_threads = std::max(1, std::min(M,
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount()));
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < M; ++i) {
+    int *row_ind = ind.dptr_ + i * N;
+    // ties are broken by the index, which gives the order of a stable sort
+    auto greater = [vals](int a, int b) {
+      return vals[a] > vals[b] || (vals[a] == vals[b] && a < b);
+    };
+    auto less = [vals](int a, int b) {
+      return vals[a] < vals[b] || (vals[a] == vals[b] && a < b);
+    };
+    if (full_sort) {
+      if (is_ascend) {
+        std::sort(row_ind, row_ind + N, less);
+      } else {
+        std::sort(row_ind, row_ind + N, greater);
+      }
+    } else {
+      if (is_ascend) {
+        std::partial_sort(row_ind, row_ind + K, row_ind + N, less);
+      } else {
+        std::partial_sort(row_ind, row_ind + K, row_ind + N, greater);
+      }
+    }
+  }
+  // gather the sorted values, every row only reads its own elements
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < M; ++i) {
+    std::vector<DType> row_vals(K);
+    const int *row_ind = ind.dptr_ + i * N;
+    for (int j = 0; j < K; ++j) {
+      row_vals[j] = vals[row_ind[j]];
+    }
+    std::copy(row_vals.begin(), row_vals.end(), dat.dptr_ + i * N);
+    for (int j = 0; j < N; ++j) {
+      batch_id.dptr_[i * N + j] = i;
+    }
+  }
+}
+
 /*!
    * \brief Implementation of the TopK operation
    *
@@ -190,13 +335,8 @@ void TopKImpl(RunContext ctx,
   ParseTopKParam(src.shape_, param,
                  &target_shape, &batch_size, &element_num, &axis, &k, &do_transpose, &is_ascend);
   Tensor<xpu, 3, real_t> dat = src.FlatTo3D<xpu, real_t>(axis, axis, s);
-  size_t temp_size = mxnet::op::SortByKeyWorkspaceSize<int, int, xpu>(src.Size());
-  temp_size = std::max(temp_size, mxnet::op::SortByKeyWorkspaceSize<int, real_t, xpu>(src.Size()));
-  temp_size = std::max(temp_size, mxnet::op::SortByKeyWorkspaceSize<real_t, int, xpu>(src.Size()));
-  size_t workspace_size = temp_size + sizeof(real_t) * src.Size() + sizeof(int) * src.Size() * 2;
-  if (param.ret_typ == topk_enum::kReturnMask) {
-    workspace_size += sizeof(int) * batch_size * k + sizeof(real_t) * batch_size * k;
-  }
+  size_t temp_size;
+  size_t workspace_size = TopKWorkspaceSize<xpu>(src.shape_, param, &temp_size);
   workspace = resource.get_space_typed<xpu, 1, char>(Shape1(workspace_size), s);
   char* workspace_curr_ptr = workspace.dptr_;
   sorted_dat = Tensor<xpu, 1, real_t>(reinterpret_cast<real_t*>(workspace_curr_ptr),
@@ -229,19 +369,10 @@ void TopKImpl(RunContext ctx,
   }
   temp_workspace = Tensor<xpu, 1, char>(workspace_curr_ptr, Shape1(temp_size), s);  // temp space
   workspace_curr_ptr += temp_size;
-  // 2. Perform inplace batch sort using the `SortByKey` in MShadow
-  // After sorting, each batch in `sorted_dat` will be sorted in the corresponding order
-  //   and the `indices` will contain the corresponding index in `sorted_dat`
-  // Sort the data and keep record of the correspondence to global indices.
-  mxnet::op::SortByKey(sorted_dat, indices, is_ascend, &temp_workspace);
-  // Calculate the corresponding batch indices of the elements
-  batch_id = indices / element_num;
-  // Since the SortByKey performs stable sort, the second SortByKey will reorder
-  //   the sorted_dat based on the order of the batch_id
-  mxnet::op::SortByKey(batch_id, sorted_dat, true, &temp_workspace);
-  // Reorder the indices
-  batch_id = indices / element_num;
-  mxnet::op::SortByKey(batch_id, indices, true, &temp_workspace);
+  // 2. Perform inplace batch sort
+  // After sorting, the first k elements of each batch in `sorted_dat` will be sorted in the
+  //   corresponding order and the `indices` will contain the corresponding index in `sorted_dat`
+  TopKSort(sorted_dat, indices, batch_id, temp_workspace, k, element_num, is_ascend);
 
   // 3. Assign results to the ret blob
   if (param.ret_typ == topk_enum::kReturnMask) {
@@ -326,12 +457,7 @@ void Sort(const nnvm::NodeAttrs& attrs,
           const std::vector<TBlob>& outputs) {
   const SortParam& param = nnvm::get<SortParam>(attrs.parsed);
   CHECK_EQ(req[0], kWriteTo) << "Sort does not support inplace";
-  TopKParam topk_param;
-  topk_param.axis = param.axis;
-  topk_param.is_ascend = param.is_ascend;
-  topk_param.k = 0;
-  topk_param.ret_typ = topk_enum::kReturnValue;
-  TopKImpl<xpu>(ctx.run_ctx, ctx.requested[0], inputs[0], outputs, topk_param);
+  TopKImpl<xpu>(ctx.run_ctx, ctx.requested[0], inputs[0], outputs, ToTopKParam(param));
 }
 
 template<typename xpu>
@@ -342,12 +468,7 @@ void ArgSort(const nnvm::NodeAttrs& attrs,
              const std::vector<TBlob>& outputs) {
   const ArgSortParam& param = nnvm::get<ArgSortParam>(attrs.parsed);
   CHECK_EQ(req[0], kWriteTo) << "ArgSort does not support inplace";
-  TopKParam topk_param;
-  topk_param.axis = param.axis;
-  topk_param.is_ascend = param.is_ascend;
-  topk_param.k = 0;
-  topk_param.ret_typ = topk_enum::kReturnIndices;
-  TopKImpl<xpu>(ctx.run_ctx, ctx.requested[0], inputs[0], outputs, topk_param);
+  TopKImpl<xpu>(ctx.run_ctx, ctx.requested[0], inputs[0], outputs, ToTopKParam(param));
 }
 
 template<typename xpu>
@@ -486,24 +607,14 @@ inline bool SortShape(const nnvm::NodeAttrs& attrs,
                       std::vector<TShape> *in_attrs,
                       std::vector<TShape> *out_attrs) {
   const SortParam& param = nnvm::get<SortParam>(attrs.parsed);
-  TopKParam topk_param;
-  topk_param.axis = param.axis;
-  topk_param.is_ascend = param.is_ascend;
-  topk_param.k = 0;
-  topk_param.ret_typ = topk_enum::kReturnValue;
-  return TopKShapeImpl(topk_param, in_attrs, out_attrs);
+  return TopKShapeImpl(ToTopKParam(param), in_attrs, out_attrs);
 }
 
 inline bool ArgSortShape(const nnvm::NodeAttrs& attrs,
                          std::vector<TShape> *in_attrs,
                          std::vector<TShape> *out_attrs) {
   const ArgSortParam& param = nnvm::get<ArgSortParam>(attrs.parsed);
-  TopKParam topk_param;
-  topk_param.axis = param.axis;
-  topk_param.is_ascend = param.is_ascend;
-  topk_param.k = 0;
-  topk_param.ret_typ = topk_enum::kReturnIndices;
-  return TopKShapeImpl(topk_param, in_attrs, out_attrs);
+  return TopKShapeImpl(ToTopKParam(param), in_attrs, out_attrs);
 }
 }  // namespace op
 }  // namespace mxnet
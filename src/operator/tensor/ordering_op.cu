@@ -28,15 +28,18 @@
 namespace mxnet {
 namespace op {
 NNVM_REGISTER_OP(topk)
-.set_attr<FCompute>("FCompute<gpu>", TopK<gpu>);
+.set_attr<FCompute>("FCompute<gpu>", TopK<gpu>)
+.set_attr<FTempSpaceSize>("FTempSpaceSize<gpu>", TopKTempSpaceSize<gpu, TopKParam>);
 
 NNVM_REGISTER_OP(_backward_topk)
 .set_attr<FCompute>("FCompute<gpu>", TopKBackward_<gpu>);
 
 NNVM_REGISTER_OP(sort)
-.set_attr<FCompute>("FCompute<gpu>", Sort<gpu>);
+.set_attr<FCompute>("FCompute<gpu>", Sort<gpu>)
+.set_attr<FTempSpaceSize>("FTempSpaceSize<gpu>", TopKTempSpaceSize<gpu, SortParam>);
 
 NNVM_REGISTER_OP(argsort)
-.set_attr<FCompute>("FCompute<gpu>", ArgSort<gpu>);
+.set_attr<FCompute>("FCompute<gpu>", ArgSort<gpu>)
+.set_attr<FTempSpaceSize>("FTempSpaceSize<gpu>", TopKTempSpaceSize<gpu, ArgSortParam>);
 }  // namespace op
 }  // namespace mxnet
@@ -27,6 +27,7 @@
 #include <mxnet/operator_util.h>
 #include <vector>
 #include <utility>
+#include <type_traits>
 #include "./init_op.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
@@ -134,6 +135,40 @@ struct SparseRetainRspThreadKernel {
   }
 };
 
+/*!
+ * \brief GPU kernel retaining the rows of a rsp, parallelized by the
+ * elements of the output: every thread searches for the row of its element
+ * and copies or zeros it, so that the rows are copied coalesced and the
+ * output needs no separate zeroing. The searches of the threads of a row
+ * read the same indices.
+ */
+struct SparseRetainRspElemKernel {
+  template<typename DType, typename RType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, DType* out_data, RType* out_idx,
+                                  const DType* in_data, const RType* in_idx,
+                                  const IType* idx, const size_t nnr,
+                                  const size_t row_length) {
+    const size_t row = i / row_length;
+    const size_t col = i % row_length;
+    const RType irow = idx[row];
+    int j = -1, left = 0, right = nnr - 1;
+    while (left <= right) {
+      int m = left + (right - left) / 2;
+      const auto in_idx_m = in_idx[m];
+      if (in_idx_m == irow) {
+        j = m;
+        break;
+      } else if (in_idx_m < irow) {
+        left = m + 1;
+      } else {
+        right = m - 1;
+      }
+    }
+    if (col == 0) out_idx[row] = irow;
+    out_data[i] = (j >= 0) ? in_data[j * row_length + col] : DType(0);
+  }
+};
+
 /*!
  * \brief This kernel should be invoked when the row indices
  * to be retained are all in the input rsp.
@@ -258,6 +293,18 @@ void SparseRetainOpForwardRspImpl(mshadow::Stream<xpu> *s,
 
   using namespace mxnet_op;
   MSHADOW_TYPE_SWITCH(output_data.type_flag_, DType, {  // output data type
+    if (std::is_same<xpu, gpu>::value && input_idx.Size() != input_nd.shape()[0]) {
+      // every output element is written by SparseRetainRspElemKernel
+      MSHADOW_IDX_TYPE_SWITCH(output_idx.type_flag_, RType, {
+        MSHADOW_TYPE_SWITCH(idx_data.type_flag_, IType, {
+          Kernel<SparseRetainRspElemKernel, xpu>::Launch(s, output_data.Size(),
+              output_data.dptr<DType>(), output_idx.dptr<RType>(), input_data.dptr<DType>(),
+              input_idx.dptr<RType>(), idx_data.dptr<IType>(), input_data.shape_[0],
+              row_length);
+        });
+      });
+      return;
+    }
     Kernel<set_zero, xpu>::Launch(s, output_data.Size(), output_data.dptr<DType>());
     MSHADOW_IDX_TYPE_SWITCH(output_idx.type_flag_, RType, {  // row index data type
       MSHADOW_TYPE_SWITCH(idx_data.type_flag_, IType, {  // index array data type
@@ -336,6 +383,24 @@ struct SparseRetainRspGradKernel {
   }
 };
 
+/*!
+ * \brief GPU kernel of the gradient of sparse_retain,
+ * parallelized by the elements of the gradient
+ */
+template<int req>
+struct SparseRetainRspGradElemKernel {
+  template<typename DType, typename RType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, DType* in_grad, RType* in_grad_idx,
+                                  const DType* out_grad, const IType* idx,
+                                  const size_t row_length) {
+    const size_t row = i / row_length;
+    const size_t col = i % row_length;
+    const RType irow = idx[row];
+    if (col == 0) in_grad_idx[row] = irow;
+    KERNEL_ASSIGN(in_grad[i], req, out_grad[static_cast<size_t>(irow) * row_length + col]);
+  }
+};
+
 template<typename xpu>
 void SparseRetainOpBackwardEx(const nnvm::NodeAttrs& attrs,
                               const OpContext& ctx,
@@ -380,9 +445,15 @@ void SparseRetainOpBackwardEx(const nnvm::NodeAttrs& attrs,
     MSHADOW_IDX_TYPE_SWITCH(in_grad_idx.type_flag_, RType, {  // row index data type
       MSHADOW_TYPE_SWITCH(idx_data.type_flag_, IType, {  // index array data type
         MXNET_ASSIGN_REQ_SWITCH(req[sr::kArr], req_type, {
-          Kernel<SparseRetainRspGradKernel<req_type>, xpu>::Launch(
-              s, in_grad_idx.Size(), in_grad_data.dptr<DType>(), in_grad_idx.dptr<RType>(),
-              out_grad_data.dptr<DType>(), idx_data.dptr<IType>(), row_length);
+          if (std::is_same<xpu, gpu>::value) {
+            Kernel<SparseRetainRspGradElemKernel<req_type>, xpu>::Launch(
+                s, in_grad_data.Size(), in_grad_data.dptr<DType>(), in_grad_idx.dptr<RType>(),
+                out_grad_data.dptr<DType>(), idx_data.dptr<IType>(), row_length);
+          } else {
+            Kernel<SparseRetainRspGradKernel<req_type>, xpu>::Launch(
+                s, in_grad_idx.Size(), in_grad_data.dptr<DType>(), in_grad_idx.dptr<RType>(),
+                out_grad_data.dptr<DType>(), idx_data.dptr<IType>(), row_length);
+          }
         });
       });
     });
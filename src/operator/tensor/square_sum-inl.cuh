@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file square_sum-inl.cuh
+ * \brief GPU kernels of the square_sum op.
+ */
+#ifndef MXNET_OPERATOR_TENSOR_SQUARE_SUM_INL_CUH_
+#define MXNET_OPERATOR_TENSOR_SQUARE_SUM_INL_CUH_
+
+#include <cub/cub.cuh>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief Warp kernel for the square sum of a rsp on axis=1.
+ * Parallelized by the non-zero rows: 1 warp/row
+ */
+template<int req, bool keepdim>
+struct SquareSumRspRowWarpKernel {
+  /*!
+   * \param tid          global thread id
+   * \param out_row_idx  row idx of the output, only written when keepdim
+   * \param out_data     output data
+   * \param in_row_idx   row idx of the input
+   * \param in_data      input data
+   * \param nnr          number of non-zero rows of the input
+   * \param num_cols     number of columns of the input
+   */
+  template<typename IType, typename DType>
+  __device__ __forceinline__ static void Map(int tid, IType* out_row_idx, DType* out_data,
+                                             const IType* in_row_idx, const DType* in_data,
+                                             const int64_t nnr, const int64_t num_cols) {
+    typedef cub::WarpReduce<DType> WarpReduce;
+    const int warps_per_block = mshadow::cuda::kBaseThreadNum / 32;
+    __shared__ typename WarpReduce::TempStorage temp_storage[warps_per_block];
+
+    const int64_t row   = tid / 32;          // global warp id
+    const int warp_lane = threadIdx.x / 32;  // local  warp id within thread block
+    const int lane      = tid & (32-1);      // local  thread id within warp
+    if (row < nnr) {
+      DType sum = 0;
+      const int64_t offset = row * num_cols;
+      for (int64_t j = lane; j < num_cols; j += 32) {
+        const DType val = in_data[offset+j];
+        sum += val * val;
+      }
+      sum = WarpReduce(temp_storage[warp_lane]).Sum(sum);
+      if (lane == 0) {
+        if (keepdim) {
+          out_row_idx[row] = in_row_idx[row];
+          KERNEL_ASSIGN(out_data[row], req, sum);
+        } else {
+          KERNEL_ASSIGN(out_data[in_row_idx[row]], req, sum);
+        }
+      }
+    }
+  }
+};
+
+template<int req, bool keepdim, typename IType, typename DType>
+inline void SquareSumRspRowsImpl(mshadow::Stream<gpu>* s, IType* out_row_idx, DType* out_data,
+                                 const IType* in_row_idx, const DType* in_data,
+                                 const int64_t nnr, const int64_t num_cols) {
+  mxnet_op::Kernel<SquareSumRspRowWarpKernel<req, keepdim>, gpu>::Launch(s, nnr * 32,
+      out_row_idx, out_data, in_row_idx, in_data, nnr, num_cols);
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_TENSOR_SQUARE_SUM_INL_CUH_
@@ -152,6 +152,33 @@ struct SquareSumRspKernel<req, 1, true> {
   }
 };
 
+/*!
+ * \brief CPU: square sum of the non-zero rows of a rsp on axis=1,
+ *  by the thread kernels above
+ */
+template<int req, bool keepdim, typename IType, typename DType>
+inline void SquareSumRspRowsImpl(mshadow::Stream<cpu>* s, IType* out_row_idx, DType* out_data,
+                                 const IType* in_row_idx, const DType* in_data,
+                                 const int64_t nnr, const int64_t num_cols) {
+  using mxnet_op::Kernel;
+  if (keepdim) {
+    Kernel<SquareSumRspKernel<req, 1, true>, cpu>::Launch(s, nnr, out_row_idx, out_data,
+        in_row_idx, in_data, num_cols);
+  } else {
+    Kernel<SquareSumRspKernel<req, 1, false>, cpu>::Launch(s, nnr, out_data, in_row_idx,
+        in_data, num_cols);
+  }
+}
+
+/*!
+ * \brief GPU: square sum of the non-zero rows of a rsp on axis=1,
+ *  one warp reduces every row so that the row is read coalesced
+ */
+template<int req, bool keepdim, typename IType, typename DType>
+inline void SquareSumRspRowsImpl(mshadow::Stream<gpu>* s, IType* out_row_idx, DType* out_data,
+                                 const IType* in_row_idx, const DType* in_data,
+                                 const int64_t nnr, const int64_t num_cols);
+
 template<int req, int axis, int ograd_stype = kDefaultStorage>
 struct SquareSumRspGradKernel;
 
@@ -283,9 +310,9 @@ void SquareSumRspImpl(const nnvm::NodeAttrs& attrs,
       MSHADOW_TYPE_SWITCH(out_data.type_flag_, DType, {
         MSHADOW_IDX_TYPE_SWITCH(in_row_idx.type_flag_, IType, {
           MXNET_ASSIGN_REQ_SWITCH(req, req_type, {
-            Kernel<SquareSumRspKernel<req_type, 1, true>, xpu>::Launch(s, nnr,
-                out_row_idx.dptr<IType>(), out_data.dptr<DType>(), in_row_idx.dptr<IType>(),
-                in_data.dptr<DType>(), num_cols);
+            SquareSumRspRowsImpl<req_type, true>(s, out_row_idx.dptr<IType>(),
+                out_data.dptr<DType>(), in_row_idx.dptr<IType>(), in_data.dptr<DType>(),
+                nnr, num_cols);
           })
         })
       })
@@ -298,8 +325,9 @@ void SquareSumRspImpl(const nnvm::NodeAttrs& attrs,
       MSHADOW_TYPE_SWITCH(out_data.type_flag_, DType, {
         MSHADOW_IDX_TYPE_SWITCH(in_row_idx.type_flag_, IType, {
           MXNET_ASSIGN_REQ_SWITCH(req, req_type, {
-            Kernel<SquareSumRspKernel<req_type, 1, false>, xpu>::Launch(s, nnr,
-                out_data.dptr<DType>(), in_row_idx.dptr<IType>(), in_data.dptr<DType>(), num_cols);
+            SquareSumRspRowsImpl<req_type, false>(s, static_cast<IType*>(nullptr),
+                out_data.dptr<DType>(), in_row_idx.dptr<IType>(), in_data.dptr<DType>(),
+                nnr, num_cols);
           })
         })
       })
@@ -370,6 +398,7 @@ void SquareSumRspGradImpl(const nnvm::NodeAttrs& attrs,
     const TBlob ograd_row_idx = ograd.aux_data(rowsparse::kIdx);
     CHECK(ograd_row_idx.Size() == in_row_idx.Size() || in_row_idx.Size() == in_data.shape_[0]);
     MSHADOW_IDX_TYPE_SWITCH(igrad_row_idx.type_flag_, IType, {
+      // the row indices stay on the device on gpu, where only their number is checked
       if (std::is_same<xpu, cpu>::value) {
         const IType* first1 = ograd_row_idx.dptr<IType>();
         const IType* last1 = first1 + ograd_row_idx.Size();
@@ -382,9 +411,6 @@ void SquareSumRspGradImpl(const nnvm::NodeAttrs& attrs,
                                                       " when ograd and input are both"
                                                       " row-sparse";
         }
-      } else {
-        LOG(FATAL) << "SquareSumRspGradImpl has not implemented GPU version when"
-                      " ograd and input are both row-sparse";
       }
       MSHADOW_TYPE_SWITCH(igrad_data.type_flag_, DType, {
         MXNET_ASSIGN_REQ_SWITCH(req, req_type, {
@@ -453,4 +479,8 @@ void SquareSumOpBackwardEx(const nnvm::NodeAttrs& attrs,
 }  // namespace op
 }  // namespace mxnet
 
+#ifdef __CUDACC__
+#include "./square_sum-inl.cuh"
+#endif  // __CUDACC__
+
 #endif  // MXNET_OPERATOR_TENSOR_SQUARE_SUM_INL_H_
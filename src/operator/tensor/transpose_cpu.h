@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file transpose_cpu.h
+ * \brief cache blocked transpose of a tensor on cpu
+ */
+#ifndef MXNET_OPERATOR_TENSOR_TRANSPOSE_CPU_H_
+#define MXNET_OPERATOR_TENSOR_TRANSPOSE_CPU_H_
+
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief out = transpose(in, axes) on cpu, where out axis i is the axis axes[i]
+ *  of in. The axes of size 1 are dropped and the axes staying next to each
+ *  other are merged first, so that swapaxis and NCHW <-> NHWC are a batch of
+ *  transposes of 2-D matrices. These are copied by square tiles which fit in
+ *  the registers or the L1 cache, in parallel. When the last axis does not
+ *  move, rows are copied as a whole instead.
+ */
+template<typename DType>
+inline void TransposeCPU(const DType *in, DType *out, const TShape& shape, const TShape& axes) {
+  const int kTile = 16;
+  const int ndim = shape.ndim();
+  // rank of the axes of size larger than 1 among themselves, in the input order
+  std::vector<int> rank(ndim, -1);
+  int nkept = 0;
+  for (int i = 0; i < ndim; ++i) {
+    if (shape[i] > 1) rank[i] = nkept++;
+  }
+  // groups of axes consecutive in both the input and the output, in the output order
+  std::vector<int> group_start, group_end;
+  std::vector<size_t> group_size;
+  for (int j = 0; j < ndim; ++j) {
+    const int r = rank[axes[j]];
+    if (r < 0) continue;
+    if (!group_end.empty() && group_end.back() == r - 1) {
+      group_end.back() = r;
+      group_size.back() *= shape[axes[j]];
+    } else {
+      group_start.push_back(r);
+      group_end.push_back(r);
+      group_size.push_back(shape[axes[j]]);
+    }
+  }
+  const int m = static_cast<int>(group_start.size());
+  size_t total = 1;
+  for (int j = 0; j < m; ++j) total *= group_size[j];
+  // strides of the groups in the input, which is ordered by group_start
+  std::vector<size_t> istride(m), ostride(m);
+  for (int j = 0; j < m; ++j) {
+    istride[j] = 1;
+    for (int k = 0; k < m; ++k) {
+      if (group_start[k] > group_start[j]) istride[j] *= group_size[k];
+    }
+  }
+  for (int j = m - 1; j >= 0; --j) {
+    ostride[j] = (j == m - 1) ? 1 : ostride[j + 1] * group_size[j + 1];
+  }
+  if (m <= 1) {
+    std::memcpy(out, in, total * sizeof(DType));
+    return;
+  }
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const bool parallel = omp_threads > 1 &&
+      total >= static_cast<size_t>(engine::OpenMP::Get()->min_parallel_size());
+  // offset in the input of the output index idx over the groups in dims, in the output order
+  auto in_offset = [&](size_t idx, const std::vector<int>& dims, size_t *out_off) {
+    size_t off = 0, ooff = 0;
+    for (int k = static_cast<int>(dims.size()) - 1; k >= 0; --k) {
+      const size_t i = idx % group_size[dims[k]];
+      idx /= group_size[dims[k]];
+      off += i * istride[dims[k]];
+      ooff += i * ostride[dims[k]];
+    }
+    *out_off = ooff;
+    return off;
+  };
+  if (istride[m - 1] == 1) {
+    // the last axis stays last: copy whole rows
+    std::vector<int> dims;
+    for (int j = 0; j < m - 1; ++j) dims.push_back(j);
+    const size_t row = group_size[m - 1];
+    const int nrows = total / row;
+#ifndef __CUDACC__
+    #pragma omp parallel for num_threads(omp_threads) if (parallel)
+#endif
+    for (int r = 0; r < nrows; ++r) {
+      size_t ooff;
+      const size_t ioff = in_offset(r, dims, &ooff);
+      std::memcpy(out + ooff, in + ioff, row * sizeof(DType));
+    }
+    return;
+  }
+  // the last output axis q is read with stride is_q, the last input axis p is
+  // written with stride os_p: a batch of 2-D transposes over the other axes
+  int p = 0;
+  for (int j = 0; j < m; ++j) {
+    if (istride[j] == 1) p = j;
+  }
+  const int q = m - 1;
+  const size_t np = group_size[p], nq = group_size[q];
+  const size_t is_q = istride[q], os_p = ostride[p];
+  std::vector<int> dims;
+  for (int j = 0; j < m; ++j) {
+    if (j != p && j != q) dims.push_back(j);
+  }
+  const int nouter = total / (np * nq);
+  const int ntile_q = (nq + kTile - 1) / kTile;
+#ifndef __CUDACC__
+  #pragma omp parallel for num_threads(omp_threads) if (parallel)
+#endif
+  for (int w = 0; w < nouter * ntile_q; ++w) {
+    size_t ooff;
+    const size_t ioff = in_offset(w / ntile_q, dims, &ooff);
+    const size_t q0 = (w % ntile_q) * kTile;
+    const size_t q1 = std::min(q0 + kTile, nq);
+    for (size_t p0 = 0; p0 < np; p0 += kTile) {
+      const DType *src = in + ioff + q0 * is_q + p0;
+      DType *dst = out + ooff + p0 * os_p + q0;
+      if (q1 - q0 == static_cast<size_t>(kTile) && p0 + kTile <= np) {
+        // full tile with constant bounds, which the compiler unrolls and vectorizes
+        DType tile[kTile][kTile];
+        for (int i = 0; i < kTile; ++i) {
+          for (int j = 0; j < kTile; ++j) {
+            tile[j][i] = src[i * is_q + j];
+          }
+        }
+        for (int j = 0; j < kTile; ++j) {
+          for (int i = 0; i < kTile; ++i) {
+            dst[j * os_p + i] = tile[j][i];
+          }
+        }
+      } else {
+        const size_t p1 = std::min(p0 + kTile, np);
+        for (size_t i = 0; i < q1 - q0; ++i) {
+          for (size_t j = 0; j < p1 - p0; ++j) {
+            dst[j * os_p + i] = src[i * is_q + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_TENSOR_TRANSPOSE_CPU_H_
@@ -31,6 +31,7 @@
 #include <limits>
 #include <atomic>
 #include "./common/lazy_alloc_array.h"
+#include "./common/random_generator.h"
 
 namespace mxnet {
 namespace resource {
@@ -79,6 +80,25 @@ struct SpaceAllocator {
   }
 };
 
+/*!
+ * \brief temporal space of an engine worker thread. The operators running on
+ *  a thread use its space one after the other, so the resource needs no
+ *  engine variable and never orders two operators.
+ */
+struct ThreadLocalSpace {
+  SpaceAllocator space;
+  // keep the storage alive until the threads exit
+  std::shared_ptr<Storage> storage_ref;
+  ThreadLocalSpace() : storage_ref(Storage::_GetSharedRef()) {
+    space.ctx = Context::CPU();
+  }
+  ~ThreadLocalSpace() {
+    space.ReleaseAll();
+  }
+  static SpaceAllocator* Get() {
+    return &dmlc::ThreadLocalStore<ThreadLocalSpace>::Get()->space;
+  }
+};
 
 // Implements resource manager
 class ResourceManagerImpl : public ResourceManager {
@@ -87,20 +107,27 @@ class ResourceManagerImpl : public ResourceManager {
       : global_seed_(0) {
     cpu_temp_space_copy_ = dmlc::GetEnv("MXNET_CPU_TEMP_COPY", 4);
     gpu_temp_space_copy_ = dmlc::GetEnv("MXNET_GPU_TEMP_COPY", 1);
+    cpu_temp_per_thread_ = dmlc::GetEnv("MXNET_CPU_TEMP_PER_THREAD", false);
+    cpu_parallel_rand_copy_ = dmlc::GetEnv("MXNET_CPU_PARALLEL_RAND_COPY", 4);
+    gpu_parallel_rand_copy_ = dmlc::GetEnv("MXNET_GPU_PARALLEL_RAND_COPY", 4);
     engine_ref_ = Engine::_GetSharedRef();
     storage_ref_ = Storage::_GetSharedRef();
     cpu_rand_.reset(new ResourceRandom<cpu>(
         Context::CPU(), global_seed_));
     cpu_space_.reset(new ResourceTempSpace(
         Context::CPU(), cpu_temp_space_copy_));
+    cpu_parallel_rand_.reset(new ResourceParallelRandom(
+        Context::CPU(), cpu_parallel_rand_copy_, global_seed_));
   }
   ~ResourceManagerImpl() {
     // need explicit delete, before engine get killed
     cpu_rand_.reset(nullptr);
     cpu_space_.reset(nullptr);
+    cpu_parallel_rand_.reset(nullptr);
 #if MXNET_USE_CUDA
     gpu_rand_.Clear();
     gpu_space_.Clear();
+    gpu_parallel_rand_.Clear();
 #endif
     if (engine_ref_ != nullptr) {
       engine_ref_ = nullptr;
@@ -115,7 +142,17 @@ class ResourceManagerImpl : public ResourceManager {
     if (ctx.dev_mask() == cpu::kDevMask) {
       switch (req.type) {
         case ResourceRequest::kRandom: return cpu_rand_->resource;
-        case ResourceRequest::kTempSpace: return cpu_space_->GetNext();
+        case ResourceRequest::kTempSpace: {
+          if (cpu_temp_per_thread_) {
+            Resource ret;
+            ret.req = req;
+            ret.var = nullptr;
+            ret.ptr_ = nullptr;
+            return ret;
+          }
+          return cpu_space_->GetNext();
+        }
+        case ResourceRequest::kParallelRandom: return cpu_parallel_rand_->GetNext();
         default: LOG(FATAL) << "Unknown supported type " << req.type;
       }
     } else {
@@ -132,6 +169,11 @@ class ResourceManagerImpl : public ResourceManager {
               return new ResourceTempSpace(ctx, gpu_temp_space_copy_);
             })->GetNext();
         }
+        case ResourceRequest::kParallelRandom: {
+          return gpu_parallel_rand_.Get(ctx.dev_id, [ctx, this]() {
+              return new ResourceParallelRandom(ctx, gpu_parallel_rand_copy_, global_seed_);
+            })->GetNext();
+        }
         default: LOG(FATAL) << "Unknown supported type " << req.type;
       }
 #else
@@ -145,10 +187,14 @@ class ResourceManagerImpl : public ResourceManager {
   void SeedRandom(uint32_t seed) override {
     global_seed_ = seed;
     cpu_rand_->Seed(global_seed_);
+    cpu_parallel_rand_->Seed(global_seed_);
 #if MXNET_USE_CUDA
     gpu_rand_.ForEach([seed](size_t i, ResourceRandom<gpu> *p) {
         p->Seed(seed);
       });
+    gpu_parallel_rand_.ForEach([seed](size_t i, ResourceParallelRandom *p) {
+        p->Seed(seed);
+      });
 #endif
   }
 
@@ -238,10 +284,76 @@ class ResourceManagerImpl : public ResourceManager {
       return resource[ptr % space.size()];
     }
   };
+  /*!
+   * \brief counter-based random number resources, requests get the copies
+   *  in round robin and the copies are independent streams of the seed.
+   */
+  struct ResourceParallelRandom {
+    /*! \brief the context of the device */
+    Context ctx;
+    /*! \brief the generators */
+    std::vector<common::random::RandGenerator*> sampler;
+    /*! \brief resource representation */
+    std::vector<Resource> resource;
+    /*! \brief current pointer to the round roubin alloator */
+    std::atomic<size_t> curr_ptr;
+    /*! \brief constructor */
+    explicit ResourceParallelRandom(Context ctx, size_t ncopy, uint32_t global_seed)
+        : ctx(ctx), sampler(ncopy), resource(ncopy), curr_ptr(0) {
+      for (size_t i = 0; i < sampler.size(); ++i) {
+        sampler[i] = new common::random::RandGenerator(global_seed, StreamId(i));
+        resource[i].var = Engine::Get()->NewVariable();
+        resource[i].id = static_cast<int32_t>(i);
+        resource[i].ptr_ = sampler[i];
+        resource[i].req = ResourceRequest(ResourceRequest::kParallelRandom);
+      }
+    }
+    ~ResourceParallelRandom() {
+      for (size_t i = 0; i < sampler.size(); ++i) {
+        common::random::RandGenerator *r = sampler[i];
+        Engine::Get()->DeleteVariable(
+            [r](RunContext rctx) {
+              MSHADOW_CATCH_ERROR(delete r);
+            }, ctx, resource[i].var);
+      }
+    }
+    // the stream of copy i, distinct over the devices
+    inline uint32_t StreamId(size_t i) const {
+      return static_cast<uint32_t>(ctx.dev_mask() * kMaxNumGPUs + ctx.dev_id) << 16 |
+          static_cast<uint32_t>(i);
+    }
+    // restart all the copies on the streams of the seed
+    inline void Seed(uint32_t global_seed) {
+      for (size_t i = 0; i < sampler.size(); ++i) {
+        common::random::RandGenerator *r = sampler[i];
+        const uint32_t stream = StreamId(i);
+        Engine::Get()->PushSync([r, global_seed, stream](RunContext rctx) {
+            r->Seed(global_seed, stream);
+          }, ctx, {}, {resource[i].var},
+          FnProperty::kNormal, 0, PROFILER_MESSAGE("ResourceParallelRandomSetSeed"));
+      }
+      curr_ptr.store(0);
+    }
+    // get next resource in round roubin matter
+    inline Resource GetNext() {
+      const size_t kMaxDigit = std::numeric_limits<size_t>::max() / 2;
+      size_t ptr = ++curr_ptr;
+      if (ptr > kMaxDigit) {
+        curr_ptr.store((ptr + 1) % sampler.size());
+      }
+      return resource[ptr % sampler.size()];
+    }
+  };
   /*! \brief number of copies in CPU temp space */
   int cpu_temp_space_copy_;
   /*! \brief number of copies in GPU temp space */
   int gpu_temp_space_copy_;
+  /*! \brief whether the CPU temp space is the space of the executing thread */
+  bool cpu_temp_per_thread_;
+  /*! \brief number of copies in CPU parallel random resource */
+  int cpu_parallel_rand_copy_;
+  /*! \brief number of copies in GPU parallel random resource */
+  int gpu_parallel_rand_copy_;
   /*! \brief Reference to the engine */
   std::shared_ptr<Engine> engine_ref_;
   /*! \brief Reference to the storage */
@@ -252,20 +364,26 @@ class ResourceManagerImpl : public ResourceManager {
   std::unique_ptr<ResourceRandom<cpu> > cpu_rand_;
   /*! \brief CPU temp space resources */
   std::unique_ptr<ResourceTempSpace> cpu_space_;
+  /*! \brief CPU parallel random number resources */
+  std::unique_ptr<ResourceParallelRandom> cpu_parallel_rand_;
 #if MXNET_USE_CUDA
   /*! \brief random number generator for GPU */
   common::LazyAllocArray<ResourceRandom<gpu> > gpu_rand_;
   /*! \brief temp space for GPU */
   common::LazyAllocArray<ResourceTempSpace> gpu_space_;
+  /*! \brief parallel random number generators for GPU */
+  common::LazyAllocArray<ResourceParallelRandom> gpu_parallel_rand_;
 #endif
 };
 }  // namespace resource
 
 void* Resource::get_space_internal(size_t size) const {
+  if (ptr_ == nullptr) return resource::ThreadLocalSpace::Get()->GetSpace(size);
   return static_cast<resource::SpaceAllocator*>(ptr_)->GetSpace(size);
 }
 
 void* Resource::get_host_space_internal(size_t size) const {
+  if (ptr_ == nullptr) return resource::ThreadLocalSpace::Get()->GetHostSpace(size);
   return static_cast<resource::SpaceAllocator*>(ptr_)->GetHostSpace(size);
 }
 
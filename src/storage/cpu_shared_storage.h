@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file cpu_shared_storage.h
+ * \brief CPU storage in POSIX shared memory
+ */
+#ifndef MXNET_STORAGE_CPU_SHARED_STORAGE_H_
+#define MXNET_STORAGE_CPU_SHARED_STORAGE_H_
+
+#include <dmlc/logging.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "mxnet/base.h"
+#include "mxnet/storage.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage of the kCPUShared context. Every allocation is a POSIX
+ *  shared memory object named after the id of the creating process and a
+ *  counter of the process, which other processes map with Attach. The name
+ *  is unlinked when the creating process frees the allocation, the mappings
+ *  of the other processes stay valid until they free theirs.
+ */
+class CPUSharedStorage {
+ public:
+  /*!
+   * \brief Allocation of handle->size bytes, sets dptr, shared_pid and shared_id.
+   * \param handle the handle to allocate.
+   */
+  inline void Alloc(Storage::Handle* handle);
+  /*!
+   * \brief Map the allocation given by handle->shared_pid and shared_id.
+   * \param handle the handle to map, sets dptr.
+   */
+  inline void Attach(Storage::Handle* handle);
+  /*!
+   * \brief Deallocation.
+   * \param handle the handle to free.
+   */
+  inline void Free(const Storage::Handle& handle);
+
+ private:
+  /*! \return the name of the shared memory object of an allocation */
+  static std::string SharedName(int shared_pid, int shared_id) {
+    char name[32];
+    snprintf(name, sizeof(name), "/mx_%08x_%08x", shared_pid, shared_id);
+    return name;
+  }
+  /*! \return the mapped size of an allocation, mmap rejects empty ones */
+  static size_t MappedSize(size_t size) {
+    return std::max<size_t>(size, 1);
+  }
+  /*! \brief map size bytes of fd */
+  static void* Map(int fd, size_t size, const std::string& name) {
+    void* ptr = mmap(nullptr, MappedSize(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK(ptr != MAP_FAILED) << "Cannot map shared memory " << name << ": " << strerror(errno);
+    close(fd);
+    return ptr;
+  }
+  /*! \brief counter of the allocations of this process */
+  std::atomic<int> counter_{0};
+};
+
+inline void CPUSharedStorage::Alloc(Storage::Handle* handle) {
+#ifndef _WIN32
+  handle->shared_pid = static_cast<int>(getpid());
+  handle->shared_id = counter_++;
+  const std::string name = SharedName(handle->shared_pid, handle->shared_id);
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  CHECK_NE(fd, -1) << "Cannot create shared memory " << name << ": " << strerror(errno);
+  CHECK_EQ(ftruncate(fd, MappedSize(handle->size)), 0)
+      << "Cannot allocate " << handle->size << " bytes of shared memory " << name
+      << ": " << strerror(errno);
+  handle->dptr = Map(fd, handle->size, name);
+#else
+  LOG(FATAL) << "Shared memory is not supported on Windows";
+#endif  // _WIN32
+}
+
+inline void CPUSharedStorage::Attach(Storage::Handle* handle) {
+#ifndef _WIN32
+  const std::string name = SharedName(handle->shared_pid, handle->shared_id);
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  CHECK_NE(fd, -1) << "Cannot open shared memory " << name << ": " << strerror(errno);
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat shared memory " << name;
+  CHECK_GE(static_cast<size_t>(st.st_size), handle->size)
+      << "Shared memory " << name << " is smaller than the array";
+  handle->dptr = Map(fd, handle->size, name);
+#else
+  LOG(FATAL) << "Shared memory is not supported on Windows";
+#endif  // _WIN32
+}
+
+inline void CPUSharedStorage::Free(const Storage::Handle& handle) {
+#ifndef _WIN32
+  munmap(handle.dptr, MappedSize(handle.size));
+  if (handle.shared_pid == static_cast<int>(getpid())) {
+    shm_unlink(SharedName(handle.shared_pid, handle.shared_id).c_str());
+  }
+#endif  // _WIN32
+}
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_CPU_SHARED_STORAGE_H_
@@ -24,6 +24,7 @@
 #ifndef MXNET_STORAGE_NAIVE_STORAGE_MANAGER_H_
 #define MXNET_STORAGE_NAIVE_STORAGE_MANAGER_H_
 
+#include <atomic>
 #include "storage_manager.h"
 #include "mxnet/base.h"
 
@@ -37,9 +38,11 @@ template <class DeviceStorage>
 class NaiveStorageManager final : public StorageManager {
  public:
   /*!
-   * \brief Default constructor.
+   * \brief Constructor.
+   * \param storage The device storage blocks are allocated from.
    */
-  NaiveStorageManager() = default;
+  explicit NaiveStorageManager(DeviceStorage storage = DeviceStorage())
+      : storage_(storage) {}
   /*!
    * \brief Default destructor.
    */
@@ -48,21 +51,30 @@ class NaiveStorageManager final : public StorageManager {
   void Free(void* ptr, size_t) override;
 
   void DirectFree(void* ptr, size_t size) override {
-    DeviceStorage::Free(ptr);
+    storage_.Free(ptr);
+  }
+
+  void GetStats(Storage::Stats* stats) override {
+    stats->num_miss = num_alloc_.load();
   }
 
  private:
+  // number of allocations, every one of them goes to the device
+  std::atomic<uint64_t> num_alloc_{0};
+  // device storage
+  DeviceStorage storage_;
   DISALLOW_COPY_AND_ASSIGN(NaiveStorageManager);
 };  // class NaiveStorageManager
 
 template <class DeviceStorage>
 void* NaiveStorageManager<DeviceStorage>::Alloc(size_t size) {
-  return DeviceStorage::Alloc(size);
+  ++num_alloc_;
+  return storage_.Alloc(size);
 }
 
 template <class DeviceStorage>
 void NaiveStorageManager<DeviceStorage>::Free(void* ptr, size_t) {
-  DeviceStorage::Free(ptr);
+  storage_.Free(ptr);
 }
 
 }  // namespace storage
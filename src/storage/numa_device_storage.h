@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file numa_device_storage.h
+ * \brief CPU storage placed on a NUMA node.
+ */
+#ifndef MXNET_STORAGE_NUMA_DEVICE_STORAGE_H_
+#define MXNET_STORAGE_NUMA_DEVICE_STORAGE_H_
+
+#include <dmlc/logging.h>
+#include <cstdlib>
+#include <new>
+#include "mxnet/base.h"
+#include "./cpu_device_storage.h"
+#include "../common/numa.h"
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#endif
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief CPU storage whose pages are placed on a given NUMA node.
+ *
+ *  Blocks of at least one page are page aligned and cover whole pages, so
+ *  they can be placed on the node before they are touched. Smaller blocks
+ *  share pages with other allocations and are left to CPUDeviceStorage.
+ */
+class NUMADeviceStorage {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param node The node, memory is not placed if it is negative.
+   */
+  explicit NUMADeviceStorage(int node = -1) : node_(node) {}
+  /*!
+   * \brief Allocation on the node.
+   * \param size Size to allocate.
+   * \return Pointer to the storage.
+   */
+  inline void* Alloc(size_t size);
+  /*!
+   * \brief Deallocation.
+   * \param ptr Pointer to deallocate.
+   */
+  inline void Free(void* ptr) {
+    CPUDeviceStorage::Free(ptr);
+  }
+
+ private:
+  /*! \return size of a memory page */
+  static size_t PageSize() {
+#if _MSC_VER
+    return 4096;
+#else
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+#endif
+  }
+  /*! \brief the node memory is placed on */
+  int node_;
+};  // class NUMADeviceStorage
+
+inline void* NUMADeviceStorage::Alloc(size_t size) {
+  const size_t page_size = PageSize();
+  if (node_ < 0 || size < page_size) return CPUDeviceStorage::Alloc(size);
+  size_t num_bytes = (size + page_size - 1) / page_size * page_size;
+  void* ptr;
+#if _MSC_VER
+  ptr = _aligned_malloc(num_bytes, page_size);
+  if (ptr == NULL) throw std::bad_alloc();
+#else
+  int ret = posix_memalign(&ptr, page_size, num_bytes);
+  if (ret != 0) throw std::bad_alloc();
+#endif
+  common::BindMemoryToNUMANode(ptr, num_bytes, node_);
+  return ptr;
+}
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_NUMA_DEVICE_STORAGE_H_
@@ -28,7 +28,13 @@
   #include <cuda_runtime.h>
 #endif  // MXNET_USE_CUDA
 #include <mxnet/base.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
 #include <unordered_map>
+#include <set>
+#include <string>
 #include <vector>
 #include <mutex>
 #include <new>
@@ -42,19 +48,30 @@ namespace storage {
 #if MXNET_USE_CUDA
 /*!
  * \brief Storage manager with a memory pool on gpu.
+ *
+ *  When given a profile file, the pool records the largest number of blocks
+ *  of every size in use at the same time, and writes it to the file when it
+ *  is destroyed. The blocks listed in an existing profile are allocated at
+ *  construction, so that the first iterations of a new process find them in
+ *  the pool instead of calling cudaMalloc.
  */
 class GPUPooledStorageManager final : public StorageManager {
  public:
   /*!
-   * \brief Default constructor.
+   * \brief Constructor.
+   * \param dev_id The id of the device of the pool.
+   * \param profile The allocation profile preloaded and updated, if not empty.
    */
-  GPUPooledStorageManager() {
+  explicit GPUPooledStorageManager(int dev_id = 0, const std::string& profile = "")
+      : dev_id_(dev_id), profile_file_(profile) {
     reserve_ = dmlc::GetEnv("MXNET_GPU_MEM_POOL_RESERVE", 5);
+    if (!profile_file_.empty()) Preload();
   }
   /*!
    * \brief Default destructor.
    */
   ~GPUPooledStorageManager() {
+    if (!profile_file_.empty()) WriteProfile();
     ReleaseAll();
   }
 
@@ -62,25 +79,74 @@ class GPUPooledStorageManager final : public StorageManager {
   void Free(void* ptr, size_t raw_size) override;
 
   void DirectFree(void* ptr, size_t raw_size) override {
-    cudaError_t err = cudaFree(ptr);
+    std::lock_guard<std::mutex> lock(mutex_);
     size_t size = raw_size + NDEV;
+    --num_in_use_[size];
+    DeviceFree(ptr, size);
+  }
+
+  void GetStats(Storage::Stats* stats) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats->bytes_cached = cached_memory_;
+    stats->num_miss = num_miss_;
+    stats->num_release_all = num_release_all_;
+  }
+
+ private:
+  /*! \brief block counts by size of every device, as stored in a profile */
+  using Profile = std::map<int, std::map<size_t, size_t>>;
+  /*!
+   * \brief Read a profile file, one "dev_id size count" line per block size.
+   *  A missing file is an empty profile.
+   */
+  static Profile ReadProfile(const std::string& fname);
+  /*! \brief allocate the blocks of the profile of this device into the pool */
+  void Preload();
+  /*!
+   * \brief Write the peak block counts of this device to the profile file,
+   *  keeping the larger of the preloaded and the observed counts.
+   */
+  void WriteProfile();
+  /*! \brief give a block back to the device */
+  void DeviceFree(void* ptr, size_t size) {
+    cudaError_t err = cudaFree(ptr);
     // ignore unloading error, as memory has already been recycled
     if (err != cudaSuccess && err != cudaErrorCudartUnloading) {
       LOG(FATAL) << "CUDA: " << cudaGetErrorString(err);
     }
     used_memory_ -= size;
   }
-
- private:
+  /*! \brief count a block of size handed out to the user */
+  void RecordInUse(size_t size) {
+    size_t in_use = ++num_in_use_[size];
+    size_t& peak = peak_in_use_[size];
+    peak = std::max(peak, in_use);
+  }
   void ReleaseAll();
   // internal mutex
   std::mutex mutex_;
   // used memory
   size_t used_memory_ = 0;
+  // memory cached in the pool
+  size_t cached_memory_ = 0;
+  // number of allocations that went to cudaMalloc
+  uint64_t num_miss_ = 0;
+  // number of calls to ReleaseAll
+  uint64_t num_release_all_ = 0;
   // percentage of reserved memory
   int reserve_;
   // number of devices
   const int NDEV = 32;
+  // id of the device
+  int dev_id_;
+  // allocation profile file, empty if not profiling
+  std::string profile_file_;
+  // number of blocks of every size handed out to the user
+  std::unordered_map<size_t, size_t> num_in_use_;
+  // largest number of blocks of every size handed out at the same time
+  std::unordered_map<size_t, size_t> peak_in_use_;
+  // block counts of the profile preloaded at construction
+  std::map<size_t, size_t> preloaded_;
   // memory pool
   std::unordered_map<size_t, std::vector<void*>> memory_pool_;
   DISALLOW_COPY_AND_ASSIGN(GPUPooledStorageManager);
@@ -89,6 +155,7 @@ class GPUPooledStorageManager final : public StorageManager {
 void* GPUPooledStorageManager::Alloc(size_t raw_size) {
   std::lock_guard<std::mutex> lock(mutex_);
   size_t size = raw_size + NDEV;
+  RecordInUse(size);
   auto&& reuse_it = memory_pool_.find(size);
   if (reuse_it == memory_pool_.end() || reuse_it->second.size() == 0) {
     size_t free, total;
@@ -102,11 +169,13 @@ void* GPUPooledStorageManager::Alloc(size_t raw_size) {
       LOG(FATAL) << "cudaMalloc failed: " << cudaGetErrorString(e);
     }
     used_memory_ += size;
+    ++num_miss_;
     return ret;
   } else {
     auto&& reuse_pool = reuse_it->second;
     auto ret = reuse_pool.back();
     reuse_pool.pop_back();
+    cached_memory_ -= size;
     return ret;
   }
 }
@@ -114,20 +183,421 @@ void* GPUPooledStorageManager::Alloc(size_t raw_size) {
 void GPUPooledStorageManager::Free(void* ptr, size_t raw_size) {
   std::lock_guard<std::mutex> lock(mutex_);
   size_t size = raw_size + NDEV;
+  --num_in_use_[size];
   auto&& reuse_pool = memory_pool_[size];
   reuse_pool.push_back(ptr);
+  cached_memory_ += size;
 }
 
 void GPUPooledStorageManager::ReleaseAll() {
   for (auto&& i : memory_pool_) {
     for (auto&& j : i.second) {
-      DirectFree(j, i.first - NDEV);
+      DeviceFree(j, i.first);
     }
   }
   memory_pool_.clear();
+  cached_memory_ = 0;
+  ++num_release_all_;
+}
+
+GPUPooledStorageManager::Profile
+GPUPooledStorageManager::ReadProfile(const std::string& fname) {
+  Profile profile;
+  std::ifstream is(fname);
+  int dev_id;
+  size_t size, count;
+  while (is >> dev_id >> size >> count) {
+    profile[dev_id][size] = count;
+  }
+  return profile;
+}
+
+void GPUPooledStorageManager::Preload() {
+  preloaded_ = ReadProfile(profile_file_)[dev_id_];
+  if (preloaded_.empty()) return;
+  CUDA_CALL(cudaSetDevice(dev_id_));
+  size_t free, total;
+  cudaMemGetInfo(&free, &total);
+  // leave the reserved percentage of the memory free
+  size_t avail = free > total * reserve_ / 100 ? free - total * reserve_ / 100 : 0;
+  for (auto&& i : preloaded_) {
+    for (size_t j = 0; j < i.second; ++j) {
+      void* ret = nullptr;
+      if (i.first > avail || cudaMalloc(&ret, i.first) != cudaSuccess) {
+        cudaGetLastError();
+        LOG(WARNING) << "Preloading the GPU memory pool of device " << dev_id_
+                     << " stopped at " << (used_memory_ >> 20) << " MB, the profile "
+                     << profile_file_ << " does not fit into the free memory";
+        return;
+      }
+      avail -= i.first;
+      used_memory_ += i.first;
+      cached_memory_ += i.first;
+      memory_pool_[i.first].push_back(ret);
+    }
+  }
+}
+
+void GPUPooledStorageManager::WriteProfile() {
+  // the pools are destroyed one after the other with the storage, so the
+  // profiles of the other devices are kept by reading them back first
+  Profile profile = ReadProfile(profile_file_);
+  std::map<size_t, size_t>& counts = profile[dev_id_];
+  counts = preloaded_;
+  for (auto&& i : peak_in_use_) {
+    counts[i.first] = std::max(counts[i.first], i.second);
+  }
+  const std::string tmp = profile_file_ + ".tmp";
+  {
+    std::ofstream os(tmp);
+    for (auto&& dev : profile) {
+      for (auto&& i : dev.second) {
+        if (i.second != 0) os << dev.first << ' ' << i.first << ' ' << i.second << '\n';
+      }
+    }
+    if (!os) {
+      LOG(WARNING) << "Cannot write the GPU memory pool profile " << tmp;
+      return;
+    }
+  }
+  // replace the profile at once, so that a process starting now reads a whole file
+  if (std::rename(tmp.c_str(), profile_file_.c_str()) != 0) {
+    LOG(WARNING) << "Cannot write the GPU memory pool profile " << profile_file_;
+  }
+}
+/*!
+ * \brief Storage manager with a memory pool on gpu that rounds requests
+ *  to size classes.
+ *
+ *  Requests are rounded up to 1/4-step logarithmic buckets, so arrays whose
+ *  shapes vary slightly from batch to batch share the same cached blocks.
+ *  Cached blocks are split to serve smaller requests, and neighboring free
+ *  blocks carved from the same cudaMalloc segment are coalesced on free.
+ *  Small requests are served from their own pool of larger segments, so that
+ *  they do not fragment the blocks used by big arrays.
+ */
+class GPUPooledRoundedStorageManager final : public StorageManager {
+ public:
+  /*!
+   * \brief Default constructor.
+   */
+  GPUPooledRoundedStorageManager() {
+    reserve_ = dmlc::GetEnv("MXNET_GPU_MEM_POOL_RESERVE", 5);
+  }
+  /*!
+   * \brief Default destructor.
+   */
+  ~GPUPooledRoundedStorageManager() {
+    ReleaseAll();
+  }
+
+  void* Alloc(size_t raw_size) override;
+  void Free(void* ptr, size_t raw_size) override;
+  void DirectFree(void* ptr, size_t raw_size) override;
+
+  void GetStats(Storage::Stats* stats) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats->bytes_cached = 0;
+    for (auto&& free_blocks : free_blocks_) {
+      for (const Block* block : free_blocks) stats->bytes_cached += block->size;
+    }
+    stats->num_miss = num_miss_;
+    stats->num_release_all = num_release_all_;
+  }
+
+ private:
+  /*! \brief a contiguous piece of a segment returned by cudaMalloc */
+  struct Block {
+    /*! \brief start address of the block */
+    char* ptr;
+    /*! \brief size of the block in bytes */
+    size_t size;
+    /*! \brief index of the pool the block belongs to */
+    int pool;
+    /*! \brief whether the block is in the free list */
+    bool free;
+    /*! \brief neighboring blocks in the same segment */
+    Block* prev;
+    Block* next;
+  };
+  /*! \brief order free blocks by size, then address, for best-fit lookup */
+  struct BlockCompare {
+    bool operator()(const Block* a, const Block* b) const {
+      if (a->size != b->size) return a->size < b->size;
+      return a->ptr < b->ptr;
+    }
+  };
+  /*! \brief pool for requests no larger than kSmallSize */
+  static const int kSmallPool = 0;
+  /*! \brief pool for all other requests */
+  static const int kLargePool = 1;
+  /*! \brief minimum block size, also the alignment of every block */
+  static const size_t kMinBlockSize = 512;
+  /*! \brief largest request served from the small pool */
+  static const size_t kSmallSize = 1 << 20;
+  /*! \brief size of the segments backing the small pool */
+  static const size_t kSmallSegment = 2 << 20;
+  /*!
+   * \brief Round size up to its size class. Sizes in (2^k, 2^(k+1)] are
+   *  rounded to multiples of 2^(k-2), with kMinBlockSize as the finest step.
+   */
+  static size_t RoundSize(size_t size) {
+    size_t step = kMinBlockSize;
+    while (step * 8 < size) step <<= 1;
+    return (size + step - 1) / step * step;
+  }
+  /*!
+   * \brief Mark an allocated block as free and merge it with its free
+   *  neighbors. The resulting block is not put into the free list.
+   */
+  Block* Coalesce(void* ptr);
+  /*! \brief allocate a new segment from the device */
+  Block* MallocSegment(size_t size, int pool);
+  /*! \brief return all fully free segments to the device */
+  void ReleaseAll();
+  // internal mutex
+  std::mutex mutex_;
+  // used memory
+  size_t used_memory_ = 0;
+  // number of segments allocated with cudaMalloc
+  uint64_t num_miss_ = 0;
+  // number of calls to ReleaseAll
+  uint64_t num_release_all_ = 0;
+  // percentage of reserved memory
+  int reserve_;
+  // number of devices
+  const int NDEV = 32;
+  // free blocks of each pool
+  std::set<Block*, BlockCompare> free_blocks_[2];
+  // blocks handed out to the user, indexed by address
+  std::unordered_map<void*, Block*> allocated_blocks_;
+  DISALLOW_COPY_AND_ASSIGN(GPUPooledRoundedStorageManager);
+};  // class GPUPooledRoundedStorageManager
+
+void* GPUPooledRoundedStorageManager::Alloc(size_t raw_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t size = RoundSize(raw_size + NDEV);
+  int pool = size <= kSmallSize ? kSmallPool : kLargePool;
+  Block key{nullptr, size, pool, true, nullptr, nullptr};
+  auto&& free_blocks = free_blocks_[pool];
+  auto it = free_blocks.lower_bound(&key);
+  Block* block = nullptr;
+  if (it != free_blocks.end()) {
+    block = *it;
+    free_blocks.erase(it);
+  } else {
+    block = MallocSegment(size, pool);
+  }
+  // split off the tail of the block if it is big enough to be reused
+  size_t remain = block->size - size;
+  size_t min_split = kMinBlockSize;
+  if (pool == kLargePool) min_split = kSmallSize;
+  if (remain >= min_split) {
+    Block* tail = new Block{block->ptr + size, remain, pool, true, block, block->next};
+    if (block->next != nullptr) block->next->prev = tail;
+    block->next = tail;
+    block->size = size;
+    free_blocks.insert(tail);
+  }
+  block->free = false;
+  allocated_blocks_[block->ptr] = block;
+  return block->ptr;
+}
+
+void GPUPooledRoundedStorageManager::Free(void* ptr, size_t raw_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Block* block = Coalesce(ptr);
+  free_blocks_[block->pool].insert(block);
+}
+
+void GPUPooledRoundedStorageManager::DirectFree(void* ptr, size_t raw_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Block* block = Coalesce(ptr);
+  if (block->prev != nullptr || block->next != nullptr) {
+    // other parts of the segment are still in use, keep it cached
+    free_blocks_[block->pool].insert(block);
+    return;
+  }
+  cudaError_t err = cudaFree(block->ptr);
+  // ignore unloading error, as memory has already been recycled
+  if (err != cudaSuccess && err != cudaErrorCudartUnloading) {
+    LOG(FATAL) << "CUDA: " << cudaGetErrorString(err);
+  }
+  used_memory_ -= block->size;
+  delete block;
+}
+
+GPUPooledRoundedStorageManager::Block*
+GPUPooledRoundedStorageManager::Coalesce(void* ptr) {
+  auto it = allocated_blocks_.find(ptr);
+  CHECK(it != allocated_blocks_.end())
+    << "Cannot free memory that was not allocated by this pool";
+  Block* block = it->second;
+  allocated_blocks_.erase(it);
+  block->free = true;
+  if (block->prev != nullptr && block->prev->free) {
+    Block* prev = block->prev;
+    free_blocks_[prev->pool].erase(prev);
+    prev->size += block->size;
+    prev->next = block->next;
+    if (block->next != nullptr) block->next->prev = prev;
+    delete block;
+    block = prev;
+  }
+  if (block->next != nullptr && block->next->free) {
+    Block* next = block->next;
+    free_blocks_[next->pool].erase(next);
+    block->size += next->size;
+    block->next = next->next;
+    if (next->next != nullptr) next->next->prev = block;
+    delete next;
+  }
+  return block;
+}
+
+GPUPooledRoundedStorageManager::Block*
+GPUPooledRoundedStorageManager::MallocSegment(size_t size, int pool) {
+  size_t segment = pool == kSmallPool ? std::max(size, static_cast<size_t>(kSmallSegment)) : size;
+  size_t free, total;
+  cudaMemGetInfo(&free, &total);
+  if (free <= total * reserve_ / 100 || segment > free - total * reserve_ / 100)
+    ReleaseAll();
+
+  void* ret = nullptr;
+  cudaError_t e = cudaMalloc(&ret, segment);
+  if (e == cudaErrorMemoryAllocation) {
+    // clear the error, give the cached segments back and try once more
+    cudaGetLastError();
+    ReleaseAll();
+    e = cudaMalloc(&ret, segment);
+  }
+  if (e != cudaSuccess && e != cudaErrorCudartUnloading) {
+    LOG(FATAL) << "cudaMalloc failed: " << cudaGetErrorString(e);
+  }
+  used_memory_ += segment;
+  ++num_miss_;
+  return new Block{static_cast<char*>(ret), segment, pool, true, nullptr, nullptr};
+}
+
+void GPUPooledRoundedStorageManager::ReleaseAll() {
+  for (auto&& free_blocks : free_blocks_) {
+    for (auto it = free_blocks.begin(); it != free_blocks.end();) {
+      Block* block = *it;
+      // only blocks spanning a whole segment can be handed back to cudaFree
+      if (block->prev != nullptr || block->next != nullptr) {
+        ++it;
+        continue;
+      }
+      cudaError_t err = cudaFree(block->ptr);
+      // ignore unloading error, as memory has already been recycled
+      if (err != cudaSuccess && err != cudaErrorCudartUnloading) {
+        LOG(FATAL) << "CUDA: " << cudaGetErrorString(err);
+      }
+      used_memory_ -= block->size;
+      it = free_blocks.erase(it);
+      delete block;
+    }
+  }
+  ++num_release_all_;
 }
 #endif  // MXNET_USE_CUDA
 
+/*!
+ * \brief Storage manager with a memory pool for host memory.
+ *
+ *  Freed blocks are cached by size and handed out again to requests of the
+ *  same size. The pool keeps at most limit bytes cached, anything freed
+ *  beyond that goes straight back to the DeviceStorage.
+ */
+template <class DeviceStorage>
+class CPUPooledStorageManager final : public StorageManager {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param limit Maximum number of bytes kept in the pool.
+   * \param storage The device storage blocks are allocated from.
+   */
+  explicit CPUPooledStorageManager(size_t limit, DeviceStorage storage = DeviceStorage())
+      : limit_(limit), storage_(storage) {}
+  /*!
+   * \brief Default destructor.
+   */
+  ~CPUPooledStorageManager() {
+    ReleaseAll();
+  }
+
+  void* Alloc(size_t size) override;
+  void Free(void* ptr, size_t size) override;
+
+  void DirectFree(void* ptr, size_t size) override {
+    storage_.Free(ptr);
+  }
+
+  void GetStats(Storage::Stats* stats) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats->bytes_cached = cached_memory_;
+    stats->num_miss = num_miss_;
+  }
+
+ private:
+  void ReleaseAll();
+  // internal mutex
+  std::mutex mutex_;
+  // bytes currently cached in the pool
+  size_t cached_memory_ = 0;
+  // number of allocations that went to the device
+  uint64_t num_miss_ = 0;
+  // maximum bytes cached in the pool
+  size_t limit_;
+  // memory pool
+  std::unordered_map<size_t, std::vector<void*>> memory_pool_;
+  // device storage
+  DeviceStorage storage_;
+  DISALLOW_COPY_AND_ASSIGN(CPUPooledStorageManager);
+};  // class CPUPooledStorageManager
+
+template <class DeviceStorage>
+void* CPUPooledStorageManager<DeviceStorage>::Alloc(size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&& reuse_it = memory_pool_.find(size);
+    if (reuse_it != memory_pool_.end() && reuse_it->second.size() != 0) {
+      auto&& reuse_pool = reuse_it->second;
+      auto ret = reuse_pool.back();
+      reuse_pool.pop_back();
+      cached_memory_ -= size;
+      return ret;
+    }
+    ++num_miss_;
+  }
+  // allocate outside of the lock, page-locking memory can be slow
+  return storage_.Alloc(size);
+}
+
+template <class DeviceStorage>
+void CPUPooledStorageManager<DeviceStorage>::Free(void* ptr, size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_memory_ + size <= limit_) {
+      memory_pool_[size].push_back(ptr);
+      cached_memory_ += size;
+      return;
+    }
+  }
+  storage_.Free(ptr);
+}
+
+template <class DeviceStorage>
+void CPUPooledStorageManager<DeviceStorage>::ReleaseAll() {
+  for (auto&& i : memory_pool_) {
+    for (auto&& j : i.second) {
+      storage_.Free(j);
+    }
+  }
+  memory_pool_.clear();
+  cached_memory_ = 0;
+}
+
 }  // namespace storage
 }  // namespace mxnet
 
@@ -23,13 +23,25 @@
 #include <mshadow/tensor.h>
 #include <dmlc/logging.h>
 #include <array>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include "./storage_manager.h"
+#include "./storage_trace.h"
 #include "./naive_storage_manager.h"
 #include "./pooled_storage_manager.h"
+#include "./thread_cached_storage_manager.h"
 #include "./cpu_device_storage.h"
+#include "./cpu_shared_storage.h"
+#include "./numa_device_storage.h"
 #include "./pinned_memory_storage.h"
 #include "../common/cuda_utils.h"
 #include "../common/lazy_alloc_array.h"
+#include "../common/numa.h"
+#include "../engine/profiler.h"
 
 namespace mxnet {
 
@@ -37,10 +49,19 @@ namespace mxnet {
 class StorageImpl : public Storage {
  public:
   Handle Alloc(size_t size, Context ctx) override;
+  Handle AttachShared(int shared_pid, int shared_id, size_t size) override;
   void Free(Handle handle) override;
   void DirectFree(Handle handle) override;
-  StorageImpl() {}
-  virtual ~StorageImpl() = default;
+  Stats GetStats(Context ctx) override;
+  void RegisterHostMemory(void* ptr, size_t size) override;
+  void UnregisterHostMemory(void* ptr) override;
+  StorageImpl() {
+    const std::string trace_file = dmlc::GetEnv("MXNET_STORAGE_TRACE", std::string());
+    if (!trace_file.empty()) trace_.reset(new storage::TraceRecorder(trace_file));
+  }
+  virtual ~StorageImpl() {
+    for (auto&& i : host_regions_) HostUnregister(i.first);
+  }
 
  private:
   static constexpr size_t kMaxNumberOfDevices = Context::kMaxDevType + 1;
@@ -49,9 +70,49 @@ class StorageImpl : public Storage {
   static int num_gpu_device;
 #endif  // MXNET_USE_CUDA
 
+  /*!
+   * \brief Create the storage manager for host memory given by DeviceStorage.
+   * \param type_env Environment variable holding the pool type.
+   * \param default_type Pool type used when type_env is not set.
+   * \param storage The device storage blocks are allocated from.
+   */
+  template <class DeviceStorage>
+  static storage::StorageManager* CreateHostStorageManager(
+      const char* type_env, const char* default_type,
+      DeviceStorage storage = DeviceStorage()) {
+    const std::string pool_type = dmlc::GetEnv(type_env, std::string(default_type));
+    if (pool_type == "Naive") {
+      return new storage::NaiveStorageManager<DeviceStorage>(storage);
+    } else if (pool_type == "Pooled") {
+      size_t limit = dmlc::GetEnv("MXNET_CPU_MEM_POOL_LIMIT", 1024);
+      return WithThreadCache(
+          new storage::CPUPooledStorageManager<DeviceStorage>(limit << 20, storage),
+          "MXNET_CPU_MEM_POOL_THREAD_CACHE");
+    }
+    LOG(FATAL) << "Unknown memory pool type " << pool_type
+               << ", " << type_env << " must be Naive or Pooled";
+    return nullptr;
+  }
+
+  /*!
+   * \brief Put per-thread caches in front of manager if enabled by type_env.
+   * \param manager The storage manager to wrap.
+   * \param type_env Environment variable holding the largest cached block in KB.
+   */
+  static storage::StorageManager* WithThreadCache(storage::StorageManager* manager,
+                                                  const char* type_env) {
+    size_t max_block = dmlc::GetEnv(type_env, 0);
+    if (max_block == 0) return manager;
+    return new storage::ThreadCachedStorageManager(manager, max_block << 10,
+                                                   kThreadCacheDepotLimit);
+  }
+  /*! \brief bytes shared by all threads in the depot of a thread cached pool */
+  static constexpr size_t kThreadCacheDepotLimit = 64 << 20;
+
   static void ActivateDevice(Context ctx) {
     switch (ctx.dev_type) {
-      case Context::kCPU: break;
+      case Context::kCPU:
+      case Context::kCPUShared: break;
       case Context::kGPU:
       case Context::kCPUPinned: {
 #if MXNET_USE_CUDA
@@ -65,9 +126,44 @@ class StorageImpl : public Storage {
         LOG(FATAL) << "Unimplemented device";
     }
   }
+  /*! \brief counters kept for every context */
+  struct Counters {
+    std::atomic<size_t> bytes_in_use{0};
+    std::atomic<size_t> peak_bytes_in_use{0};
+    std::atomic<uint64_t> num_alloc{0};
+    std::atomic<uint64_t> num_free{0};
+  };
+  /*! \return the counters of ctx, or nullptr if the device id is out of range */
+  Counters* GetCounters(Context ctx) {
+    if (ctx.dev_id < 0 || static_cast<size_t>(ctx.dev_id) >= kMaxNumberOfDeviceIDs) {
+      return nullptr;
+    }
+    return &counters_.at(ctx.dev_type)[ctx.dev_id];
+  }
+  /*! \brief update the counters after an allocation */
+  void RecordAlloc(Context ctx, size_t size);
+  /*! \brief update the counters after a free */
+  void RecordFree(Context ctx, size_t size);
+  /*! \brief record an allocation or free of bytes, negative for a free, in the profiler */
+  void EmitMemoryStat(Context ctx, int64_t bytes, size_t in_use);
+  /*! \brief page-lock a host region for all gpus */
+  static void HostRegister(char* ptr, size_t size);
+  /*! \brief undo HostRegister */
+  static void HostUnregister(char* ptr);
   // internal storage managers
   std::array<common::LazyAllocArray<storage::StorageManager>,
              kMaxNumberOfDevices> storage_managers_;
+  // storage of the kCPUShared context, which is not pooled
+  storage::CPUSharedStorage shared_storage_;
+  // allocation counters
+  std::array<std::array<Counters, kMaxNumberOfDeviceIDs>,
+             kMaxNumberOfDevices> counters_;
+  // recorder of the allocations and frees, if MXNET_STORAGE_TRACE is set
+  std::unique_ptr<storage::TraceRecorder> trace_;
+  // mutex of host_regions_
+  std::mutex host_mutex_;
+  // sizes of the registered host memory regions, by start address
+  std::map<char*, size_t> host_regions_;
 };  // struct Storage::Impl
 #if MXNET_USE_CUDA
 int StorageImpl::num_gpu_device = 0;
@@ -78,13 +174,26 @@ Storage::Handle StorageImpl::Alloc(size_t size, Context ctx) {
   Handle hd;
   hd.ctx = ctx;
   hd.size = size;
+  if (ctx.dev_type == Context::kCPUShared) {
+    shared_storage_.Alloc(&hd);
+    RecordAlloc(ctx, size);
+    if (trace_) trace_->RecordAlloc(hd);
+    return hd;
+  }
   auto&& device = storage_managers_.at(ctx.dev_type);
   std::shared_ptr<storage::StorageManager> manager = device.Get(
       ctx.dev_id, [ctx]() {
         storage::StorageManager *ptr = nullptr;
         switch (ctx.dev_type) {
           case Context::kCPU: {
-            ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            int node = common::GetNUMANodeOfCPUContext(ctx.dev_id);
+            if (node >= 0) {
+              ptr = CreateHostStorageManager<storage::NUMADeviceStorage>(
+                  "MXNET_CPU_MEM_POOL_TYPE", "Naive", storage::NUMADeviceStorage(node));
+            } else {
+              ptr = CreateHostStorageManager<storage::CPUDeviceStorage>(
+                  "MXNET_CPU_MEM_POOL_TYPE", "Naive");
+            }
             break;
           }
           case Context::kCPUPinned: {
@@ -95,12 +204,15 @@ Storage::Handle StorageImpl::Alloc(size_t size, Context ctx) {
               num_gpu_device = 0;
             }
             if (num_gpu_device > 0) {
-              ptr = new storage::NaiveStorageManager<storage::PinnedMemoryStorage>();
+              ptr = CreateHostStorageManager<storage::PinnedMemoryStorage>(
+                  "MXNET_CPU_PINNED_MEM_POOL_TYPE", "Pooled");
             } else {
-              ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+              ptr = CreateHostStorageManager<storage::CPUDeviceStorage>(
+                  "MXNET_CPU_MEM_POOL_TYPE", "Naive");
             }
 #else
-            ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            ptr = CreateHostStorageManager<storage::CPUDeviceStorage>(
+                "MXNET_CPU_MEM_POOL_TYPE", "Naive");
 #endif  // MXNET_USE_CUDA
             break;
           }
@@ -108,7 +220,18 @@ Storage::Handle StorageImpl::Alloc(size_t size, Context ctx) {
 #if MXNET_USE_CUDA
             CUDA_CALL(cudaGetDeviceCount(&num_gpu_device));
             CHECK_GT(num_gpu_device, 0) << "GPU usage requires at least 1 GPU";
-            ptr = new storage::GPUPooledStorageManager();
+            const std::string pool_type = dmlc::GetEnv("MXNET_GPU_MEM_POOL_TYPE",
+                                                       std::string("Naive"));
+            if (pool_type == "Naive") {
+              ptr = new storage::GPUPooledStorageManager(
+                  ctx.dev_id, dmlc::GetEnv("MXNET_GPU_MEM_POOL_PRELOAD", std::string()));
+            } else if (pool_type == "Round") {
+              ptr = new storage::GPUPooledRoundedStorageManager();
+            } else {
+              LOG(FATAL) << "Unknown memory pool type " << pool_type
+                         << ", MXNET_GPU_MEM_POOL_TYPE must be Naive or Round";
+            }
+            ptr = WithThreadCache(ptr, "MXNET_GPU_MEM_POOL_THREAD_CACHE");
 #else
             LOG(FATAL) << "Compile with USE_CUDA=1 to enable GPU usage";
 #endif  // MXNET_USE_CUDA
@@ -120,11 +243,30 @@ Storage::Handle StorageImpl::Alloc(size_t size, Context ctx) {
       });
   this->ActivateDevice(ctx);
   hd.dptr = manager->Alloc(size);
+  RecordAlloc(ctx, size);
+  if (trace_) trace_->RecordAlloc(hd);
+  return hd;
+}
+
+Storage::Handle StorageImpl::AttachShared(int shared_pid, int shared_id, size_t size) {
+  Handle hd;
+  hd.ctx = Context::CPUShared(0);
+  hd.size = size;
+  hd.shared_pid = shared_pid;
+  hd.shared_id = shared_id;
+  shared_storage_.Attach(&hd);
+  RecordAlloc(hd.ctx, size);
   return hd;
 }
 
 void StorageImpl::Free(Storage::Handle handle) {
   const Context &ctx = handle.ctx;
+  if (ctx.dev_type == Context::kCPUShared) {
+    shared_storage_.Free(handle);
+    RecordFree(ctx, handle.size);
+    if (trace_) trace_->RecordFree(handle);
+    return;
+  }
   auto&& device = storage_managers_.at(ctx.dev_type);
   std::shared_ptr<storage::StorageManager> manager = device.Get(
       ctx.dev_id, []() {
@@ -133,10 +275,16 @@ void StorageImpl::Free(Storage::Handle handle) {
       });
   this->ActivateDevice(ctx);
   manager->Free(handle.dptr, handle.size);
+  RecordFree(ctx, handle.size);
+  if (trace_) trace_->RecordFree(handle);
 }
 
 void StorageImpl::DirectFree(Storage::Handle handle) {
   const Context &ctx = handle.ctx;
+  if (ctx.dev_type == Context::kCPUShared) {
+    this->Free(handle);
+    return;
+  }
   auto&& device = storage_managers_.at(ctx.dev_type);
   std::shared_ptr<storage::StorageManager> manager = device.Get(
       ctx.dev_id, []() {
@@ -146,6 +294,107 @@ void StorageImpl::DirectFree(Storage::Handle handle) {
   this->ActivateDevice(ctx);
   // directly free ths data.
   manager->DirectFree(handle.dptr, handle.size);
+  RecordFree(ctx, handle.size);
+  if (trace_) trace_->RecordFree(handle);
+}
+
+Storage::Stats StorageImpl::GetStats(Context ctx) {
+  Stats stats;
+  auto&& device = storage_managers_.at(ctx.dev_type);
+  std::shared_ptr<storage::StorageManager> manager = device.Get(
+      ctx.dev_id, []() {
+        return static_cast<storage::StorageManager*>(nullptr);
+      });
+  if (manager != nullptr) manager->GetStats(&stats);
+  Counters* counters = GetCounters(ctx);
+  if (counters != nullptr) {
+    stats.bytes_in_use = counters->bytes_in_use.load();
+    stats.peak_bytes_in_use = counters->peak_bytes_in_use.load();
+    stats.num_alloc = counters->num_alloc.load();
+    stats.num_free = counters->num_free.load();
+  }
+  return stats;
+}
+
+void StorageImpl::RegisterHostMemory(void* ptr, size_t size) {
+  CHECK(ptr != nullptr && size != 0) << "Cannot register an empty host memory region";
+  char* begin = static_cast<char*>(ptr);
+  std::lock_guard<std::mutex> lock(host_mutex_);
+  // the driver refuses overlapping regions, tell which one is in the way
+  auto next = host_regions_.lower_bound(begin);
+  CHECK(next == host_regions_.end() || next->first >= begin + size)
+      << "Host memory region " << ptr << " of " << size << " bytes overlaps the region "
+      << static_cast<void*>(next->first) << " already registered";
+  if (next != host_regions_.begin()) {
+    auto prev = std::prev(next);
+    CHECK(prev->first + prev->second <= begin)
+        << "Host memory region " << ptr << " of " << size << " bytes overlaps the region "
+        << static_cast<void*>(prev->first) << " already registered";
+  }
+  HostRegister(begin, size);
+  host_regions_[begin] = size;
+}
+
+void StorageImpl::UnregisterHostMemory(void* ptr) {
+  std::lock_guard<std::mutex> lock(host_mutex_);
+  auto it = host_regions_.find(static_cast<char*>(ptr));
+  CHECK(it != host_regions_.end()) << "Host memory " << ptr << " is not registered";
+  HostUnregister(it->first);
+  host_regions_.erase(it);
+}
+
+void StorageImpl::HostRegister(char* ptr, size_t size) {
+#if MXNET_USE_CUDA
+  int num_gpus = 0;
+  if (cudaGetDeviceCount(&num_gpus) != cudaSuccess || num_gpus == 0) {
+    cudaGetLastError();
+    return;
+  }
+  // portable, so that the region counts as page-locked on every gpu
+  CUDA_CALL(cudaHostRegister(ptr, size, cudaHostRegisterPortable));
+#endif  // MXNET_USE_CUDA
+}
+
+void StorageImpl::HostUnregister(char* ptr) {
+#if MXNET_USE_CUDA
+  int num_gpus = 0;
+  if (cudaGetDeviceCount(&num_gpus) != cudaSuccess || num_gpus == 0) {
+    cudaGetLastError();
+    return;
+  }
+  cudaError_t err = cudaHostUnregister(ptr);
+  // ignore unloading error, as the pages are unlocked with the driver
+  if (err != cudaSuccess && err != cudaErrorCudartUnloading) {
+    LOG(FATAL) << "CUDA: " << cudaGetErrorString(err);
+  }
+#endif  // MXNET_USE_CUDA
+}
+
+void StorageImpl::RecordAlloc(Context ctx, size_t size) {
+  Counters* counters = GetCounters(ctx);
+  if (counters == nullptr) return;
+  ++counters->num_alloc;
+  size_t in_use = counters->bytes_in_use.fetch_add(size) + size;
+  size_t peak = counters->peak_bytes_in_use.load();
+  while (in_use > peak &&
+         !counters->peak_bytes_in_use.compare_exchange_weak(peak, in_use)) {}
+  EmitMemoryStat(ctx, static_cast<int64_t>(size), in_use);
+}
+
+void StorageImpl::RecordFree(Context ctx, size_t size) {
+  Counters* counters = GetCounters(ctx);
+  if (counters == nullptr) return;
+  ++counters->num_free;
+  EmitMemoryStat(ctx, -static_cast<int64_t>(size), counters->bytes_in_use.fetch_sub(size) - size);
+}
+
+void StorageImpl::EmitMemoryStat(Context ctx, int64_t bytes, size_t in_use) {
+#if MXNET_USE_PROFILER
+  engine::Profiler *profiler = engine::Profiler::Get();
+  if (profiler->GetState() == engine::Profiler::kRunning) {
+    profiler->AddMemoryStat(ctx.dev_type, ctx.dev_id, bytes, in_use);
+  }
+#endif  // MXNET_USE_PROFILER
 }
 
 std::shared_ptr<Storage> Storage::_GetSharedRef() {
@@ -24,6 +24,7 @@
 #ifndef MXNET_STORAGE_STORAGE_MANAGER_H_
 #define MXNET_STORAGE_STORAGE_MANAGER_H_
 
+#include <mxnet/storage.h>
 #include <cstddef>
 
 namespace mxnet {
@@ -52,6 +53,12 @@ class StorageManager {
    * \param size Size of the storage.
    */
   virtual void DirectFree(void* ptr, size_t size) = 0;
+  /*!
+   * \brief Fill in the statistics only known to the manager, which are
+   *  bytes_cached, num_miss and num_release_all.
+   * \param stats The statistics to fill in.
+   */
+  virtual void GetStats(Storage::Stats* stats) = 0;
   /*!
    * \brief Destructor.
    */
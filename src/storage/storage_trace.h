@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file storage_trace.h
+ * \brief Recording of the allocations and frees of the storage, replayed by
+ *  the storage benchmarks against the storage managers.
+ */
+#ifndef MXNET_STORAGE_STORAGE_TRACE_H_
+#define MXNET_STORAGE_STORAGE_TRACE_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/storage.h>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace storage {
+
+/*! \brief one allocation or free of a trace */
+struct TraceEvent {
+  /*! \brief microseconds since the start of the recording */
+  int64_t time;
+  /*! \brief index of the thread, in the order the threads were first seen */
+  int thread;
+  /*! \brief 'a' for an allocation, 'f' for a free */
+  char type;
+  /*! \brief device type of the context */
+  int dev_type;
+  /*! \brief device id of the context */
+  int dev_id;
+  /*! \brief index of the allocation in the trace, shared by its free */
+  uint64_t id;
+  /*! \brief size in bytes */
+  size_t size;
+};
+
+/*!
+ * \brief Writes the allocations and frees to a text file, one event per line:
+ *  time thread type dev_type dev_id id size. The frees of blocks allocated
+ *  before the recording started are left out.
+ */
+class TraceRecorder {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param fname The file the trace is written to.
+   */
+  explicit TraceRecorder(const std::string& fname)
+      : file_(std::fopen(fname.c_str(), "w")),
+        start_(std::chrono::steady_clock::now()) {
+    CHECK(file_ != nullptr) << "Cannot open the storage trace file " << fname;
+  }
+  ~TraceRecorder() {
+    std::fclose(file_);
+  }
+  /*!
+   * \brief Record an allocation.
+   * \param handle The allocated storage.
+   */
+  void RecordAlloc(const Storage::Handle& handle) {
+    if (handle.dptr == nullptr) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_id_++;
+    live_[handle.dptr] = id;
+    Write('a', handle, id);
+  }
+  /*!
+   * \brief Record a free.
+   * \param handle The freed storage.
+   */
+  void RecordFree(const Storage::Handle& handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = live_.find(handle.dptr);
+    if (it == live_.end()) return;
+    Write('f', handle, it->second);
+    live_.erase(it);
+  }
+
+ private:
+  void Write(char type, const Storage::Handle& handle, uint64_t id) {
+    std::thread::id tid = std::this_thread::get_id();
+    auto it = threads_.find(tid);
+    if (it == threads_.end()) {
+      it = threads_.emplace(tid, static_cast<int>(threads_.size())).first;
+    }
+    int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    std::fprintf(file_, "%" PRId64 " %d %c %d %d %" PRIu64 " %zu\n", time, it->second, type,
+                 static_cast<int>(handle.ctx.dev_type), handle.ctx.dev_id, id, handle.size);
+  }
+  /*! \brief protects everything below */
+  std::mutex mutex_;
+  std::FILE* file_;
+  std::chrono::steady_clock::time_point start_;
+  uint64_t next_id_{0};
+  /*! \brief trace id of the blocks in use */
+  std::unordered_map<void*, uint64_t> live_;
+  std::unordered_map<std::thread::id, int> threads_;
+};
+
+/*!
+ * \brief Read a trace written by TraceRecorder.
+ * \param fname The trace file.
+ * \return The events, in the order they were recorded.
+ */
+inline std::vector<TraceEvent> LoadTrace(const std::string& fname) {
+  std::FILE* file = std::fopen(fname.c_str(), "r");
+  CHECK(file != nullptr) << "Cannot open the storage trace file " << fname;
+  std::vector<TraceEvent> events;
+  TraceEvent e;
+  while (std::fscanf(file, "%" SCNd64 " %d %c %d %d %" SCNu64 " %zu", &e.time, &e.thread,
+                     &e.type, &e.dev_type, &e.dev_id, &e.id, &e.size) == 7) {
+    events.push_back(e);
+  }
+  std::fclose(file);
+  return events;
+}
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_STORAGE_TRACE_H_
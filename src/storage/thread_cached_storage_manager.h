@@ -0,0 +1,214 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file thread_cached_storage_manager.h
+ * \brief Storage manager with per-thread caches in front of another manager.
+ */
+#ifndef MXNET_STORAGE_THREAD_CACHED_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_THREAD_CACHED_STORAGE_MANAGER_H_
+
+#include <dmlc/thread_local.h>
+#include <mxnet/base.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "./storage_manager.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage manager that keeps per-thread caches of blocks in front of
+ *  another storage manager.
+ *
+ *  Every thread owns one magazine of cached blocks per size. Alloc and Free
+ *  only touch the magazine of the calling thread and take no lock. Full
+ *  magazines are handed over to a shared depot, and empty ones are refilled
+ *  from it, so the shared lock is taken once every kMagazineSize operations,
+ *  also when blocks are allocated on one thread and freed on another. Only
+ *  blocks no larger than max_block are cached, bigger ones go straight to the
+ *  underlying manager.
+ */
+class ThreadCachedStorageManager final : public StorageManager {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param base The storage manager to cache, ownership is taken.
+   * \param max_block Largest block size cached per thread.
+   * \param depot_limit Maximum number of bytes kept in the shared depot.
+   */
+  ThreadCachedStorageManager(StorageManager* base, size_t max_block, size_t depot_limit)
+      : shared_(std::make_shared<Shared>()), max_block_(max_block),
+        depot_limit_(depot_limit), id_(NextID()) {
+    shared_->base = base;
+  }
+  /*!
+   * \brief Destructor, returns all cached blocks to the underlying manager.
+   */
+  ~ThreadCachedStorageManager() {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    for (ThreadCache* cache : shared_->caches) {
+      for (auto&& kv : cache->magazines) {
+        for (void* ptr : kv.second) shared_->base->Free(ptr, kv.first);
+      }
+      cache->magazines.clear();
+    }
+    for (auto&& kv : shared_->depot) {
+      for (auto&& magazine : kv.second) {
+        for (void* ptr : magazine) shared_->base->Free(ptr, kv.first);
+      }
+    }
+    shared_->depot.clear();
+    delete shared_->base;
+    // threads exiting after this point find no manager to flush into
+    shared_->base = nullptr;
+  }
+
+  void* Alloc(size_t size) override;
+  void Free(void* ptr, size_t size) override;
+
+  void DirectFree(void* ptr, size_t size) override {
+    shared_->base->DirectFree(ptr, size);
+  }
+  /*!
+   * \brief Statistics of the underlying manager. Blocks cached in the depot
+   *  count as cached, the ones held by the thread magazines are not counted.
+   */
+  void GetStats(Storage::Stats* stats) override {
+    shared_->base->GetStats(stats);
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    stats->bytes_cached += shared_->depot_bytes;
+  }
+
+ private:
+  /*! \brief number of blocks held by one magazine */
+  static const size_t kMagazineSize = 16;
+  /*! \brief a stack of cached blocks of the same size */
+  typedef std::vector<void*> Magazine;
+  struct ThreadCache;
+  /*! \brief state shared by the manager and the caches of all threads */
+  struct Shared {
+    /*! \brief protects every field below */
+    std::mutex mutex;
+    /*! \brief underlying manager, null once the owner is destroyed */
+    StorageManager* base{nullptr};
+    /*! \brief full magazines by block size */
+    std::unordered_map<size_t, std::vector<Magazine>> depot;
+    /*! \brief bytes held by the depot */
+    size_t depot_bytes{0};
+    /*! \brief caches of the threads using this manager */
+    std::unordered_set<ThreadCache*> caches;
+  };
+  /*! \brief blocks cached by one thread */
+  struct ThreadCache {
+    /*! \brief keep the shared state alive until the thread exits */
+    std::shared_ptr<Shared> shared;
+    /*! \brief current magazine by block size */
+    std::unordered_map<size_t, Magazine> magazines;
+    ~ThreadCache() {
+      if (shared == nullptr) return;
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      if (shared->base != nullptr) {
+        for (auto&& kv : magazines) {
+          for (void* ptr : kv.second) shared->base->Free(ptr, kv.first);
+        }
+      }
+      shared->caches.erase(this);
+    }
+  };
+  /*! \brief caches of the calling thread, indexed by manager id */
+  struct ThreadCacheMap {
+    std::unordered_map<uint64_t, ThreadCache> caches;
+  };
+  /*! \brief get the cache of the calling thread for this manager */
+  ThreadCache* GetThreadCache() {
+    auto&& caches = dmlc::ThreadLocalStore<ThreadCacheMap>::Get()->caches;
+    auto it = caches.find(id_);
+    if (it != caches.end()) return &it->second;
+    ThreadCache* cache = &caches[id_];
+    cache->shared = shared_;
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    shared_->caches.insert(cache);
+    return cache;
+  }
+  /*! \brief ids are never reused, unlike the address of a manager */
+  static uint64_t NextID() {
+    static std::atomic<uint64_t> counter{0};
+    return counter++;
+  }
+  // state shared with the thread caches
+  std::shared_ptr<Shared> shared_;
+  // largest block size cached per thread
+  size_t max_block_;
+  // maximum bytes held by the depot
+  size_t depot_limit_;
+  // unique id of this manager
+  uint64_t id_;
+  DISALLOW_COPY_AND_ASSIGN(ThreadCachedStorageManager);
+};  // class ThreadCachedStorageManager
+
+inline void* ThreadCachedStorageManager::Alloc(size_t size) {
+  if (size > max_block_) return shared_->base->Alloc(size);
+  auto&& magazine = GetThreadCache()->magazines[size];
+  if (magazine.empty()) {
+    {
+      std::lock_guard<std::mutex> lock(shared_->mutex);
+      auto it = shared_->depot.find(size);
+      if (it != shared_->depot.end() && !it->second.empty()) {
+        magazine.swap(it->second.back());
+        it->second.pop_back();
+        shared_->depot_bytes -= magazine.size() * size;
+      }
+    }
+    if (magazine.empty()) return shared_->base->Alloc(size);
+  }
+  void* ret = magazine.back();
+  magazine.pop_back();
+  return ret;
+}
+
+inline void ThreadCachedStorageManager::Free(void* ptr, size_t size) {
+  if (size > max_block_) {
+    shared_->base->Free(ptr, size);
+    return;
+  }
+  auto&& magazine = GetThreadCache()->magazines[size];
+  if (magazine.size() == kMagazineSize) {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    size_t bytes = magazine.size() * size;
+    if (shared_->depot_bytes + bytes <= depot_limit_) {
+      shared_->depot[size].emplace_back();
+      shared_->depot[size].back().swap(magazine);
+      shared_->depot_bytes += bytes;
+    } else {
+      for (void* p : magazine) shared_->base->Free(p, size);
+      magazine.clear();
+    }
+  }
+  magazine.push_back(ptr);
+}
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_THREAD_CACHED_STORAGE_MANAGER_H_
@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file engine_perf_test.cc
+ * \brief throughput and latency benchmarks of the engines, run with --perf.
+ *  Every measurement is printed as one line of JSON.
+*/
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <mxnet/engine.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/engine/engine_impl.h"
+#include "test_util.h"
+
+namespace {
+
+using mxnet::Engine;
+using mxnet::RunContext;
+
+/*! \brief microseconds since an arbitrary origin */
+inline int64_t NowInUsec() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*! \brief an engine to benchmark */
+struct EngineConfig {
+  std::string name;
+  // number of CPU worker threads, 0 when the ops run in the pushing thread
+  int workers;
+  std::function<Engine*()> create;
+};
+
+/*!
+ * \brief the engines benchmarked. MXNET_ENGINE_TYPE=ThreadedEngine is the
+ *  pooled engine, whose pool size is fixed.
+ */
+std::vector<EngineConfig> EngineConfigs() {
+  std::vector<EngineConfig> configs;
+  configs.push_back({"NaiveEngine", 0, mxnet::engine::CreateNaiveEngine});
+  configs.push_back({"ThreadedEnginePooled", 16, mxnet::engine::CreateThreadedEnginePooled});
+  for (int workers : {1, 2, 4, 8}) {
+    configs.push_back({"ThreadedEnginePerDevice", workers, [workers]() {
+        setenv("MXNET_CPU_WORKER_NTHREADS", std::to_string(workers).c_str(), 1);
+        Engine* engine = mxnet::engine::CreateThreadedEnginePerDevice();
+        unsetenv("MXNET_CPU_WORKER_NTHREADS");
+        return engine;
+      }});
+  }
+  return configs;
+}
+
+/*! \brief the variables read and written by an op of a workload */
+struct OpDeps {
+  std::vector<int> reads;
+  int write;
+};
+
+/*!
+ * \brief generate the dependency pattern of a workload over width + 1 variables
+ *  - parallel: every op writes the next of width variables
+ *  - chain: every op writes the same variable
+ *  - fan_out: an op writes a variable, then width ops each read it
+ *  - fan_in: width ops write one variable each, then an op reads all of them
+ */
+std::vector<OpDeps> GeneratePattern(const std::string& pattern, int num_ops, int width) {
+  std::vector<OpDeps> ops;
+  std::vector<int> all(width);
+  for (int j = 0; j < width; ++j) all[j] = j + 1;
+  while (static_cast<int>(ops.size()) < num_ops) {
+    if (pattern == "parallel") {
+      ops.push_back({{}, static_cast<int>(ops.size()) % width + 1});
+    } else if (pattern == "chain") {
+      ops.push_back({{}, 0});
+    } else if (pattern == "fan_out") {
+      ops.push_back({{}, 0});
+      for (int j = 1; j <= width; ++j) ops.push_back({{0}, j});
+    } else if (pattern == "fan_in") {
+      for (int j = 1; j <= width; ++j) ops.push_back({{}, j});
+      ops.push_back({all, 0});
+    } else {
+      LOG(FATAL) << "unknown pattern " << pattern;
+    }
+  }
+  ops.resize(num_ops);
+  return ops;
+}
+
+/*! \brief push the workload on a new engine and print its throughput and latency */
+void RunWorkload(const EngineConfig& config, const std::string& pattern,
+                 int num_ops, int width) {
+  std::unique_ptr<Engine> engine(config.create());
+  std::vector<OpDeps> ops = GeneratePattern(pattern, num_ops, width);
+  std::vector<Engine::VarHandle> vars;
+  for (int i = 0; i <= width; ++i) vars.push_back(engine->NewVariable());
+  std::vector<int64_t> pushed(num_ops), done(num_ops);
+  int64_t* done_ptr = done.data();
+
+  int64_t start = NowInUsec();
+  for (int i = 0; i < num_ops; ++i) {
+    std::vector<Engine::VarHandle> reads;
+    for (int r : ops[i].reads) reads.push_back(vars[r]);
+    pushed[i] = NowInUsec();
+    engine->PushAsync([done_ptr, i](RunContext ctx, Engine::CallbackOnComplete cb) {
+        done_ptr[i] = NowInUsec();
+        cb();
+      }, mxnet::Context::CPU(), reads, {vars[ops[i].write]});
+  }
+  int64_t push_end = NowInUsec();
+  engine->WaitForAll();
+  int64_t end = NowInUsec();
+
+  std::vector<int64_t> latency(num_ops);
+  double latency_sum = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    latency[i] = done[i] - pushed[i];
+    latency_sum += latency[i];
+  }
+  std::sort(latency.begin(), latency.end());
+  auto seconds = [](int64_t us) { return std::max<int64_t>(us, 1) * 1e-6; };
+  std::printf("{\"engine\": \"%s\", \"workers\": %d, \"pattern\": \"%s\", \"width\": %d, "
+              "\"num_ops\": %d, \"push_ops_per_sec\": %.1f, \"ops_per_sec\": %.1f, "
+              "\"latency_us_mean\": %.2f, \"latency_us_p50\": %lld, "
+              "\"latency_us_p99\": %lld}\n",
+              config.name.c_str(), config.workers, pattern.c_str(), width, num_ops,
+              num_ops / seconds(push_end - start), num_ops / seconds(end - start),
+              latency_sum / num_ops,
+              static_cast<long long>(latency[num_ops / 2]),         // NOLINT(*)
+              static_cast<long long>(latency[num_ops * 99 / 100]));  // NOLINT(*)
+  std::fflush(stdout);
+  for (auto var : vars) {
+    engine->DeleteVariable([](RunContext) {}, mxnet::Context::CPU(), var);
+  }
+  engine->WaitForAll();
+}
+
+}  // namespace
+
+TEST(EnginePerf, Throughput) {
+  if (!mxnet::test::performanceRun) return;
+  const int num_ops = 20000;
+  for (const auto& config : EngineConfigs()) {
+    for (const std::string pattern : {"parallel", "chain", "fan_out", "fan_in"}) {
+      for (int width : {1, 8, 64}) {
+        if (pattern == "chain" && width != 1) continue;
+        RunWorkload(config, pattern, num_ops, width);
+      }
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file object_pool_test.cc
+ * \brief tests of the object pool, and its allocation throughput with --perf
+*/
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../src/common/object_pool.h"
+#include "test_util.h"
+
+namespace {
+
+/*! \brief an object of the size of an engine operator block */
+struct PoolObject : public mxnet::common::ObjectPoolAllocatable<PoolObject> {
+  int64_t value[8];
+};
+
+/*! \brief microseconds since an arbitrary origin */
+inline int64_t NowInUsec() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ * \brief num_threads threads each create num_objects objects and hand them
+ *  to the next thread, which deletes them, like the engine does with the
+ *  operators pushed by one thread and finished by the workers.
+ * \return the number of New and Delete per second
+ */
+double ProducerConsumer(int num_threads, int num_objects) {
+  std::vector<std::vector<PoolObject*> > handoff(num_threads);
+  std::vector<std::mutex> mutex(num_threads);
+  std::atomic<int> checked{0};
+  const int64_t start = NowInUsec();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      const int next = (t + 1) % num_threads;
+      std::vector<PoolObject*> batch;
+      for (int i = 0; i < num_objects; ++i) {
+        PoolObject* obj = PoolObject::New();
+        obj->value[0] = t;
+        batch.push_back(obj);
+        if (batch.size() == 32 || i + 1 == num_objects) {
+          std::lock_guard<std::mutex> lock(mutex[next]);
+          handoff[next].insert(handoff[next].end(), batch.begin(), batch.end());
+          batch.clear();
+        }
+        std::vector<PoolObject*> received;
+        {
+          std::lock_guard<std::mutex> lock(mutex[t]);
+          received.swap(handoff[t]);
+        }
+        for (PoolObject* obj : received) {
+          if (obj->value[0] == (t + num_threads - 1) % num_threads) ++checked;
+          PoolObject::Delete(obj);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  // the objects handed over after their receiver stopped
+  for (auto& received : handoff) {
+    for (PoolObject* obj : received) {
+      ++checked;
+      PoolObject::Delete(obj);
+    }
+  }
+  const int64_t end = NowInUsec();
+  CHECK_EQ(checked.load(), num_threads * num_objects);
+  return 2.0 * num_threads * num_objects / ((end - start) * 1e-6);
+}
+
+}  // namespace
+
+TEST(ObjectPool, ReuseAcrossThreads) {
+  std::vector<PoolObject*> objs;
+  for (int i = 0; i < 1000; ++i) {
+    objs.push_back(PoolObject::New());
+    objs.back()->value[7] = i;
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(objs[i]->value[7], i);
+  }
+  // objects created here are deleted by another thread and created again
+  std::thread([&objs]() {
+    for (PoolObject* obj : objs) PoolObject::Delete(obj);
+  }).join();
+  objs.clear();
+  ProducerConsumer(4, 10000);
+}
+
+TEST(ObjectPool, Throughput) {
+  if (!mxnet::test::performanceRun) return;
+  for (int num_threads : {1, 2, 4, 8, 16}) {
+    const double rate = ProducerConsumer(num_threads, 1000000 / num_threads);
+    std::printf("{\"benchmark\": \"object_pool\", \"threads\": %d, \"ops_per_sec\": %.0f}\n",
+                num_threads, rate);
+    std::fflush(stdout);
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file profiler_test.cc
+ * \brief profiler record buffer tests
+*/
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/profiler.h"
+
+TEST(Profiler, RingBuffer) {
+  mxnet::engine::ProfileRingBuffer<int> buffer(4);
+  EXPECT_TRUE(buffer.Empty());
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(buffer.Push(i));
+  // a full buffer drops new records
+  EXPECT_FALSE(buffer.Push(4));
+  std::vector<int> records;
+  buffer.ConsumeAll([&records](int i) { records.push_back(i); });
+  EXPECT_EQ(records, std::vector<int>({0, 1, 2, 3}));
+  EXPECT_TRUE(buffer.Empty());
+  // consumed slots are reused
+  EXPECT_TRUE(buffer.Push(5));
+  records.clear();
+  buffer.ConsumeAll([&records](int i) { records.push_back(i); });
+  EXPECT_EQ(records, std::vector<int>({5}));
+}
+
+TEST(Profiler, RingBufferConcurrent) {
+  constexpr int kNumRecords = 100000;
+  mxnet::engine::ProfileRingBuffer<int> buffer(64);
+  std::thread producer([&buffer]() {
+    for (int i = 0; i < kNumRecords; ++i) {
+      while (!buffer.Push(i)) std::this_thread::yield();
+    }
+  });
+  int expected = 0;
+  while (expected < kNumRecords) {
+    buffer.ConsumeAll([&expected](int i) {
+      EXPECT_EQ(i, expected);
+      ++expected;
+    });
+  }
+  producer.join();
+}
@@ -27,12 +27,15 @@
 #include <gtest/gtest.h>
 #include <mxnet/engine.h>
 #include <dmlc/timer.h>
+#include <atomic>
 #include <cstdio>
 #include <thread>
 #include <chrono>
+#include <utility>
 #include <vector>
 
 #include "../src/engine/engine_impl.h"
+#include "../src/engine/threaded_engine.h"
 
 /**
  * present the following workload
@@ -154,6 +157,155 @@ TEST(Engine, RandSumExpr) {
   LOG(INFO) << "ThreadedEnginePerDevice\t" << t[3] << " sec";
 }
 
+TEST(Engine, WorkStealing) {
+  std::vector<Workload> workloads;
+  setenv("MXNET_CPU_WORK_STEALING", "1", 1);
+  setenv("MXNET_CPU_WORKER_NTHREADS", "4", 1);
+  mxnet::Engine* engine = mxnet::engine::CreateThreadedEnginePerDevice();
+  unsetenv("MXNET_CPU_WORK_STEALING");
+  unsetenv("MXNET_CPU_WORKER_NTHREADS");
+
+  int num_var = 100;
+  GenerateWorkload(10000, num_var, 2, 20, 1, 10, &workloads);
+  std::vector<double> expected(num_var, 1.0), actual(num_var, 1.0);
+  EvaluateWorloads(workloads, NULL, &expected);
+  double t = EvaluateWorloads(workloads, engine, &actual);
+  for (int j = 0; j < num_var; ++j) EXPECT_EQ(expected[j], actual[j]);
+  LOG(INFO) << "ThreadedEnginePerDevice with work stealing\t" << t << " sec";
+  delete engine;
+}
+
+TEST(Engine, OnVarReady) {
+  auto engine = mxnet::Engine::Get();
+  auto var = engine->NewVariable();
+  EXPECT_TRUE(engine->IsVarReady(var));
+  std::atomic<bool> written(false);
+  std::atomic<int> calls(0);
+  engine->PushSync([&written](mxnet::RunContext) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      written = true;
+    }, mxnet::Context::CPU(), {}, {var});
+  engine->OnVarReady(var, [&written, &calls]() {
+      EXPECT_TRUE(written);
+      ++calls;
+    });
+  engine->WaitForVar(var);
+  EXPECT_TRUE(engine->IsVarReady(var));
+  // the callback runs on the engine thread right after the write completes
+  for (int i = 0; i < 100 && calls == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(calls, 1);
+  engine->OnVarReady(var, [&calls]() { ++calls; });
+  EXPECT_EQ(calls, 2);
+  engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  engine->WaitForAll();
+}
+
+TEST(Engine, CancelToken) {
+  auto engine = mxnet::Engine::Get();
+  auto var = engine->NewVariable();
+  int runs = 0;
+  auto fn = [&runs](mxnet::RunContext, mxnet::Engine::CallbackOnComplete on_complete) {
+    ++runs;
+    on_complete();
+  };
+  auto token = mxnet::engine::CancelToken::Create();
+  engine->PushAsyncCancellable(fn, mxnet::Context::CPU(), {}, {var}, token);
+  engine->WaitForVar(var);
+  EXPECT_EQ(runs, 1);
+  token.Cancel();
+  engine->PushAsyncCancellable(fn, mxnet::Context::CPU(), {}, {var}, token);
+  engine->WaitForVar(var);
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(token.num_skipped(), 1);
+
+  auto expired = mxnet::engine::CancelToken::Create();
+  expired.SetDeadline(0);
+  engine->PushAsyncCancellable(fn, mxnet::Context::CPU(), {}, {var}, expired);
+  engine->PushAsyncCancellable(fn, mxnet::Context::CPU(), {}, {var},
+                               mxnet::engine::CancelToken());
+  engine->WaitForVar(var);
+  EXPECT_EQ(runs, 2);
+  EXPECT_EQ(expired.num_skipped(), 1);
+  engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var);
+  engine->WaitForAll();
+}
+
+TEST(Engine, PriorityLanes) {
+  setenv("MXNET_CPU_WORKER_NTHREADS", "1", 1);
+  mxnet::Engine* engine = mxnet::engine::CreateThreadedEnginePerDevice();
+  unsetenv("MXNET_CPU_WORKER_NTHREADS");
+  for (int priority : {mxnet::engine::kRealtimePriority, mxnet::engine::kBackgroundPriority - 1}) {
+    auto var1 = engine->NewVariable();
+    auto var2 = engine->NewVariable();
+    std::atomic<bool> done(false);
+    bool seen = false;
+    // the only normal worker waits for the operation of the other lane
+    engine->PushSync([&done, &seen](mxnet::RunContext) {
+        for (int i = 0; i < 1000 && !done; ++i) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        seen = done;
+      }, mxnet::Context::CPU(), {}, {var1}, mxnet::FnProperty::kNormal, 0);
+    engine->PushSync([&done](mxnet::RunContext) { done = true; },
+                     mxnet::Context::CPU(), {}, {var2}, mxnet::FnProperty::kNormal, priority);
+    engine->WaitForAll();
+    EXPECT_TRUE(seen);
+    engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var1);
+    engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), var2);
+  }
+  engine->WaitForAll();
+  delete engine;
+}
+
+/**
+ * push empty operations reading and writing a few shared variables from
+ * several threads, so that the time goes into the dependency tracking,
+ * return the number of operations run per second
+ */
+double VarDependencyThroughput(mxnet::Engine* engine, int num_threads,
+                               int num_oprs, int num_var) {
+  using namespace mxnet;
+  std::vector<Engine::VarHandle> vars;
+  for (int i = 0; i < num_var; ++i) vars.push_back(engine->NewVariable());
+  auto func = [](RunContext ctx, Engine::CallbackOnComplete cb) { cb(); };
+  double t = dmlc::GetTime();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([=, &vars]() {
+      for (int j = 0; j < num_oprs; ++j) {
+        int w = (i + j) % num_var;
+        engine->PushAsync(func, Context::CPU(),
+                          {vars[(w + 1) % num_var], vars[(w + 2) % num_var]}, {vars[w]});
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  engine->WaitForAll();
+  t = dmlc::GetTime() - t;
+  for (auto var : vars) engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return num_threads * num_oprs / t;
+}
+
+TEST(Engine, VarDependencyThroughput) {
+  const char* lock = MXNET_ENGINE_SPINLOCK ? "spin lock" : "mutex";
+  setenv("MXNET_CPU_WORKER_NTHREADS", "4", 1);
+  std::vector<std::pair<const char*, mxnet::Engine*> > engines = {
+    {"ThreadedEnginePooled", mxnet::engine::CreateThreadedEnginePooled()},
+    {"ThreadedEnginePerDevice", mxnet::engine::CreateThreadedEnginePerDevice()}};
+  unsetenv("MXNET_CPU_WORKER_NTHREADS");
+  for (auto& e : engines) {
+    for (int num_threads : {1, 4}) {
+      double ops = VarDependencyThroughput(e.second, num_threads, 50000, 8);
+      LOG(INFO) << e.first << " with " << lock << ", " << num_threads
+                << " pushing threads\t" << ops << " ops/sec";
+    }
+    delete e.second;
+  }
+}
+
 void Foo(mxnet::RunContext, int i) { printf("The fox says %d\n", i); }
 
 TEST(Engine, basics) {
@@ -40,6 +40,8 @@ namespace test {
 
 extern bool unitTestsWithCuda;
 extern bool debugOutput;
+// run the performance benchmarks, set with --perf
+extern bool performanceRun;
 
 /*! \brief Pause VTune analysis */
 struct VTunePause {
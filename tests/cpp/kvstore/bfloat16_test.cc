@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bfloat16_test.cc
+ * \brief tests of the bfloat16 values sent by the kvstore
+*/
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include "../../src/common/bfloat16.h"
+
+using mxnet::common::bf16_t;
+
+TEST(BFloat16, Exact) {
+  // the values with at most 8 significant bits are kept as they are
+  for (float v : {0.0f, -0.0f, 1.0f, -2.5f, 0.15625f, 255.0f}) {
+    EXPECT_EQ(static_cast<float>(bf16_t(v)), v);
+  }
+  EXPECT_EQ(static_cast<float>(bf16_t(65280.0f)), 65280.0f);
+  EXPECT_TRUE(std::signbit(static_cast<float>(bf16_t(-0.0f))));
+}
+
+TEST(BFloat16, Rounding) {
+  // 1 + 2^-8 is halfway between 1 and 1 + 2^-7, ties go to the even one
+  EXPECT_EQ(static_cast<float>(bf16_t(1.0f + std::ldexp(1.0f, -8))), 1.0f);
+  EXPECT_EQ(static_cast<float>(bf16_t(1.0f + 3 * std::ldexp(1.0f, -8))),
+            1.0f + std::ldexp(1.0f, -6));
+  EXPECT_EQ(static_cast<float>(bf16_t(1.0f + std::ldexp(1.0f, -8) + std::ldexp(1.0f, -20))),
+            1.0f + std::ldexp(1.0f, -7));
+  // the relative error is at most 2^-8
+  for (float v = 1.0e-30f; v < 1.0e30f; v *= 1.37f) {
+    const float r = static_cast<float>(bf16_t(v));
+    EXPECT_LE(std::fabs(r - v), v * std::ldexp(1.0f, -8));
+  }
+}
+
+TEST(BFloat16, Special) {
+  const float inf = std::numeric_limits<float>::infinity();
+  EXPECT_EQ(static_cast<float>(bf16_t(inf)), inf);
+  EXPECT_EQ(static_cast<float>(bf16_t(-inf)), -inf);
+  EXPECT_TRUE(std::isnan(static_cast<float>(bf16_t(std::nanf("")))));
+  // a NaN whose payload is in the dropped bits stays a NaN
+  EXPECT_TRUE(std::isnan(static_cast<float>(bf16_t(std::nanf("1")))));
+  // the largest float32 values round up to infinity, like any other rounding
+  EXPECT_EQ(static_cast<float>(bf16_t(std::numeric_limits<float>::max())), inf);
+}
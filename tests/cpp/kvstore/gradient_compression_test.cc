@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gradient_compression_test.cc
+ * \brief gradient compression tests
+*/
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../src/kvstore/gradient_compression.h"
+
+using mxnet::real_t;
+using mxnet::kvstore::GradientCompression;
+
+static GradientCompression TwoBitCompression(const std::string& threshold) {
+  GradientCompression gc;
+  gc.SetParams({{"type", "2bit"}, {"threshold", threshold}});
+  return gc;
+}
+
+TEST(GradientCompression, Params) {
+  GradientCompression gc;
+  EXPECT_FALSE(gc.enabled());
+  EXPECT_EQ(gc.GetCompressedSize(100), 100U);
+  gc = TwoBitCompression("0.25");
+  EXPECT_TRUE(gc.enabled());
+  EXPECT_EQ(gc.GetCompressedSize(16), 1U);
+  EXPECT_EQ(gc.GetCompressedSize(17), 2U);
+  GradientCompression decoded;
+  decoded.DecodeParams(gc.EncodeParams());
+  EXPECT_TRUE(decoded.enabled());
+  EXPECT_EQ(decoded.threshold(), 0.25f);
+}
+
+TEST(GradientCompression, TwoBit) {
+  const real_t threshold = 0.5f;
+  GradientCompression gc = TwoBitCompression("0.5");
+  const size_t size = 37;
+  std::vector<real_t> grad(size), residual(size, 0.0f), decoded(size);
+  std::vector<real_t> sent(size, 0.0f), total(size, 0.0f);
+  std::vector<real_t> compressed(gc.GetCompressedSize(size));
+  for (int step = 0; step < 5; ++step) {
+    for (size_t i = 0; i < size; ++i) {
+      grad[i] = (static_cast<int>(i % 7) - 3) * 0.3f;
+      total[i] += grad[i];
+    }
+    gc.Quantize(grad.data(), residual.data(), compressed.data(), size);
+    gc.Dequantize(compressed.data(), decoded.data(), size);
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_TRUE(decoded[i] == 0.0f || std::fabs(decoded[i]) == threshold);
+      sent[i] += decoded[i];
+      // no part of the gradients is lost, it is either sent or kept
+      EXPECT_NEAR(sent[i] + residual[i], total[i], 1e-5);
+    }
+  }
+}
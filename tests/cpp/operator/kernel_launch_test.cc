@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file kernel_launch_test.cc
+ * \brief tests of the CPU launch of mxnet_op kernels
+*/
+#include <gtest/gtest.h>
+#include <vector>
+#include "operator/mxnet_op.h"
+
+using namespace mxnet;
+using namespace mxnet::op::mxnet_op;
+
+struct count_index {
+  MSHADOW_XINLINE static void Map(int i, int* count) {
+    ++count[i];
+  }
+};
+
+struct count_range {
+  MSHADOW_XINLINE static void Map(int begin, int end, int* count) {
+    for (int i = begin; i < end; ++i) ++count[i];
+  }
+};
+
+TEST(KernelLaunch, CPU) {
+  for (int n : {0, 1, 100, 4095, 4096, 100003}) {
+    std::vector<int> count(n, 0), count_ex(n, 0);
+    Kernel<count_index, cpu>::Launch(nullptr, n, count.data());
+    Kernel<count_range, cpu>::LaunchEx(nullptr, n, count_ex.data());
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(count[i], 1);
+      EXPECT_EQ(count_ex[i], 1);
+    }
+  }
+}
@@ -0,0 +1,305 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file op_perf_test.cc
+ * \brief benchmark of registered operators, run with --perf.
+ *
+ *  The operators, attributes, input shapes and dtypes are read from the JSON
+ *  file MXNET_OP_PERF_CONFIG (default tests/cpp/operator/op_perf_config.json),
+ *  a list of objects
+ *
+ *    {"op": "FullyConnected", "attrs": {"num_hidden": "256"},
+ *     "shapes": [[[64, 512], [256, 512], [256]]],
+ *     "flops": [16777216], "dtypes": ["float32"], "backward": 1}
+ *
+ *  where every entry of shapes holds the shapes of all the inputs, and flops,
+ *  when given, the number of floating point operations of the forward pass
+ *  for the shapes at the same position. Every case runs forward, and backward
+ *  through autograd when backward is 1, on the CPU and on the GPU when CUDA
+ *  is available. The time, the bandwidth counting each input and output once
+ *  and the GFLOP/s of every case are printed as one line of JSON, and written
+ *  to MXNET_OP_PERF_OUTPUT when set. When MXNET_OP_PERF_BASELINE names the
+ *  output of an earlier run, a case slower than its baseline by more than
+ *  MXNET_OP_PERF_TOLERANCE (default 0.1) fails.
+*/
+#include <dmlc/json.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <gtest/gtest.h>
+#include <mxnet/base.h>
+#include <mxnet/c_api.h>
+#include <nnvm/c_api.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test_perf.h"
+#include "test_util.h"
+
+namespace mxnet {
+namespace test {
+namespace op_perf {
+
+#define MX_API_CALL(call) CHECK_EQ((call), 0) << MXGetLastError()
+
+/*! \brief an operator and the shapes and dtypes to run it with */
+struct PerfCase {
+  std::string op;
+  std::map<std::string, std::string> attrs;
+  std::vector<std::vector<std::vector<int> > > shapes;
+  std::vector<double> flops;
+  std::vector<std::string> dtypes{"float32"};
+  int backward{1};
+  int repeat{20};
+
+  void Load(dmlc::JSONReader* reader) {
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("op", &op);
+    helper.DeclareOptionalField("attrs", &attrs);
+    helper.DeclareField("shapes", &shapes);
+    helper.DeclareOptionalField("flops", &flops);
+    helper.DeclareOptionalField("dtypes", &dtypes);
+    helper.DeclareOptionalField("backward", &backward);
+    helper.DeclareOptionalField("repeat", &repeat);
+    helper.ReadAllFields(reader);
+  }
+};
+
+/*! \brief the measurements of a case, a negative value when not measured */
+struct PerfRecord {
+  std::string key;
+  double forward_ms{-1}, forward_gbps{-1}, forward_gflops{-1};
+  double backward_ms{-1}, backward_gbps{-1}, backward_gflops{-1};
+
+  void Save(dmlc::JSONWriter* writer) const {
+    writer->BeginObject(false);
+    writer->WriteObjectKeyValue("key", key);
+    writer->WriteObjectKeyValue("forward_ms", forward_ms);
+    writer->WriteObjectKeyValue("forward_gbps", forward_gbps);
+    writer->WriteObjectKeyValue("forward_gflops", forward_gflops);
+    writer->WriteObjectKeyValue("backward_ms", backward_ms);
+    writer->WriteObjectKeyValue("backward_gbps", backward_gbps);
+    writer->WriteObjectKeyValue("backward_gflops", backward_gflops);
+    writer->EndObject();
+  }
+  void Load(dmlc::JSONReader* reader) {
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("key", &key);
+    helper.DeclareField("forward_ms", &forward_ms);
+    helper.DeclareOptionalField("forward_gbps", &forward_gbps);
+    helper.DeclareOptionalField("forward_gflops", &forward_gflops);
+    helper.DeclareOptionalField("backward_ms", &backward_ms);
+    helper.DeclareOptionalField("backward_gbps", &backward_gbps);
+    helper.DeclareOptionalField("backward_gflops", &backward_gflops);
+    helper.ReadAllFields(reader);
+  }
+};
+
+inline std::string ShapeString(const std::vector<int>& shape) {
+  std::ostringstream os;
+  os << "(";
+  for (size_t i = 0; i < shape.size(); ++i) os << (i ? "," : "") << shape[i];
+  os << (shape.size() == 1 ? ",)" : ")");
+  return os.str();
+}
+
+/*! \brief invoke an operator by name, the outputs are appended to outputs */
+void Invoke(const std::string& op, const std::vector<NDArrayHandle>& inputs,
+            const std::map<std::string, std::string>& attrs,
+            std::vector<NDArrayHandle>* outputs) {
+  OpHandle handle;
+  MX_API_CALL(NNGetOpHandle(op.c_str(), &handle));
+  std::vector<const char*> keys, vals;
+  for (const auto& kv : attrs) {
+    keys.push_back(kv.first.c_str());
+    vals.push_back(kv.second.c_str());
+  }
+  int num_outputs = 0;
+  NDArrayHandle* out = nullptr;
+  MX_API_CALL(MXImperativeInvoke(handle, static_cast<int>(inputs.size()),
+                                 const_cast<NDArrayHandle*>(inputs.data()),
+                                 &num_outputs, &out, static_cast<int>(keys.size()),
+                                 keys.data(), vals.data()));
+  outputs->insert(outputs->end(), out, out + num_outputs);
+}
+
+void Free(std::vector<NDArrayHandle>* arrays) {
+  for (auto nd : *arrays) MX_API_CALL(MXNDArrayFree(nd));
+  arrays->clear();
+}
+
+/*! \brief total number of bytes of the arrays */
+double Bytes(const std::vector<NDArrayHandle>& arrays) {
+  double bytes = 0;
+  for (auto nd : arrays) {
+    mx_uint ndim;
+    const mx_uint* dims;
+    int dtype;
+    MX_API_CALL(MXNDArrayGetShape(nd, &ndim, &dims));
+    MX_API_CALL(MXNDArrayGetDType(nd, &dtype));
+    double size = mshadow::mshadow_sizeof(dtype);
+    for (mx_uint i = 0; i < ndim; ++i) size *= dims[i];
+    bytes += size;
+  }
+  return bytes;
+}
+
+/*! \brief run forward and backward of a case repeat times and measure them */
+PerfRecord RunCase(const PerfCase& c, const std::vector<std::vector<int> >& shapes,
+                   double flops, const std::string& dtype, const std::string& ctx) {
+  PerfRecord rec;
+  std::ostringstream key;
+  key << c.op << "|";
+  for (const auto& kv : c.attrs) key << kv.first << "=" << kv.second << ";";
+  key << "|";
+  for (const auto& s : shapes) key << ShapeString(s);
+  key << "|" << dtype << "|" << ctx;
+  rec.key = key.str();
+
+  std::vector<NDArrayHandle> inputs, outputs;
+  for (const auto& s : shapes) {
+    Invoke("_random_uniform", {},
+           {{"shape", ShapeString(s)}, {"dtype", dtype}, {"ctx", ctx}}, &inputs);
+  }
+  // warm up, which also selects the algorithms of cuDNN
+  for (int i = 0; i < 2; ++i) {
+    Invoke(c.op, inputs, c.attrs, &outputs);
+    Free(&outputs);
+  }
+  MX_API_CALL(MXNDArrayWaitAll());
+  const double in_bytes = Bytes(inputs);
+  Invoke(c.op, inputs, c.attrs, &outputs);
+  const double out_bytes = Bytes(outputs);
+  Free(&outputs);
+  MX_API_CALL(MXNDArrayWaitAll());
+
+  uint64_t start = perf::getMicroTickCount();
+  for (int i = 0; i < c.repeat; ++i) {
+    Invoke(c.op, inputs, c.attrs, &outputs);
+    Free(&outputs);
+  }
+  MX_API_CALL(MXNDArrayWaitAll());
+  rec.forward_ms = MICRO2MSF(perf::getMicroTickCount() - start) / c.repeat;
+  rec.forward_gbps = (in_bytes + out_bytes) / (rec.forward_ms * 1e6);
+  if (flops > 0) rec.forward_gflops = flops / (rec.forward_ms * 1e6);
+
+  if (c.backward) {
+    // gradients of all the inputs, the head gradients are ones
+    std::vector<NDArrayHandle> grads;
+    for (auto nd : inputs) {
+      Invoke("zeros_like", {nd}, {}, &grads);
+    }
+    std::vector<mx_uint> reqs(inputs.size(), 1);
+    int prev;
+    MX_API_CALL(MXAutogradSetIsRecording(1, &prev));
+    MX_API_CALL(MXAutogradSetIsTraining(1, &prev));
+    MX_API_CALL(MXAutogradMarkVariables(inputs.size(), inputs.data(), reqs.data(),
+                                        grads.data()));
+    Invoke(c.op, inputs, c.attrs, &outputs);
+    MX_API_CALL(MXAutogradSetIsRecording(0, &prev));
+    MX_API_CALL(MXAutogradSetIsTraining(0, &prev));
+    auto backward = [&]() {
+      return MXAutogradBackwardEx(outputs.size(), outputs.data(), nullptr, 1, 1);
+    };
+    if (backward() != 0) {
+      LOG(INFO) << "no backward for " << c.op << ": " << MXGetLastError();
+    } else {
+      MX_API_CALL(MXNDArrayWaitAll());
+      start = perf::getMicroTickCount();
+      for (int i = 0; i < c.repeat; ++i) MX_API_CALL(backward());
+      MX_API_CALL(MXNDArrayWaitAll());
+      rec.backward_ms = MICRO2MSF(perf::getMicroTickCount() - start) / c.repeat;
+      // reads the inputs and the head gradients, writes the input gradients
+      rec.backward_gbps = (2 * in_bytes + out_bytes) / (rec.backward_ms * 1e6);
+      if (flops > 0) rec.backward_gflops = 2 * flops / (rec.backward_ms * 1e6);
+    }
+    Free(&outputs);
+    Free(&grads);
+  }
+  Free(&inputs);
+  return rec;
+}
+
+}  // namespace op_perf
+}  // namespace test
+}  // namespace mxnet
+
+TEST(OpPerf, Sweep) {
+  using namespace mxnet::test::op_perf;
+  if (!mxnet::test::performanceRun) return;
+  const std::string config = dmlc::GetEnv("MXNET_OP_PERF_CONFIG",
+                                          std::string("tests/cpp/operator/op_perf_config.json"));
+  const std::string output = dmlc::GetEnv("MXNET_OP_PERF_OUTPUT", std::string());
+  const std::string baseline_file = dmlc::GetEnv("MXNET_OP_PERF_BASELINE", std::string());
+  const double tolerance = dmlc::GetEnv("MXNET_OP_PERF_TOLERANCE", 0.1);
+
+  std::vector<PerfCase> cases;
+  {
+    std::ifstream is(config);
+    CHECK(is.good()) << "cannot open " << config;
+    dmlc::JSONReader reader(&is);
+    reader.Read(&cases);
+  }
+  std::map<std::string, PerfRecord> baseline;
+  if (!baseline_file.empty()) {
+    std::ifstream is(baseline_file);
+    CHECK(is.good()) << "cannot open " << baseline_file;
+    std::string line;
+    while (std::getline(is, line)) {
+      if (line.empty()) continue;
+      std::istringstream ls(line);
+      dmlc::JSONReader reader(&ls);
+      PerfRecord rec;
+      reader.Read(&rec);
+      baseline[rec.key] = rec;
+    }
+  }
+  std::ofstream out;
+  if (!output.empty()) out.open(output);
+
+  std::vector<std::string> contexts = {"cpu(0)"};
+  if (mxnet::test::unitTestsWithCuda) contexts.push_back("gpu(0)");
+  for (const auto& c : cases) {
+    CHECK(c.flops.empty() || c.flops.size() == c.shapes.size())
+        << "flops of " << c.op << " must be given for every entry of shapes";
+    for (size_t i = 0; i < c.shapes.size(); ++i) {
+      for (const auto& dtype : c.dtypes) {
+        for (const auto& ctx : contexts) {
+          PerfRecord rec = RunCase(c, c.shapes[i], c.flops.empty() ? 0 : c.flops[i],
+                                   dtype, ctx);
+          std::ostringstream os;
+          dmlc::JSONWriter writer(&os);
+          writer.Write(rec);
+          std::cout << os.str() << std::endl;
+          if (out.is_open()) out << os.str() << std::endl;
+          auto it = baseline.find(rec.key);
+          if (it == baseline.end()) continue;
+          EXPECT_LE(rec.forward_ms, it->second.forward_ms * (1 + tolerance))
+              << "forward of " << rec.key << " regressed";
+          if (rec.backward_ms >= 0 && it->second.backward_ms >= 0) {
+            EXPECT_LE(rec.backward_ms, it->second.backward_ms * (1 + tolerance))
+                << "backward of " << rec.key << " regressed";
+          }
+        }
+      }
+    }
+  }
+}
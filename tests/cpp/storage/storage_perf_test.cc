@@ -0,0 +1,364 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file storage_perf_test.cc
+ * \brief replay of allocation traces against the storage managers, run with
+ *  --perf. The trace is the file given by MXNET_STORAGE_TRACE_REPLAY, as
+ *  recorded with MXNET_STORAGE_TRACE, or a synthetic one. Every measurement
+ *  is printed as one line of JSON.
+*/
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/storage.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "test_util.h"
+#include "../../src/storage/cpu_device_storage.h"
+#include "../../src/storage/naive_storage_manager.h"
+#include "../../src/storage/pooled_storage_manager.h"
+#include "../../src/storage/storage_trace.h"
+#include "../../src/storage/thread_cached_storage_manager.h"
+
+namespace {
+
+using mxnet::storage::StorageManager;
+using mxnet::storage::TraceEvent;
+
+/*! \brief microseconds since an arbitrary origin */
+inline int64_t NowInUsec() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*! \brief bytes held from the device by a storage manager */
+struct DeviceCounters {
+  std::mutex mutex;
+  std::unordered_map<void*, size_t> sizes;
+  size_t reserved{0};
+  size_t peak_reserved{0};
+};
+
+/*! \brief CPU device storage counting the bytes it holds, when given counters */
+class CountingCPUStorage {
+ public:
+  explicit CountingCPUStorage(std::shared_ptr<DeviceCounters> counters = nullptr)
+      : counters_(counters) {}
+  void* Alloc(size_t size) {
+    void* ptr = mxnet::storage::CPUDeviceStorage::Alloc(size);
+    if (counters_ != nullptr) {
+      std::lock_guard<std::mutex> lock(counters_->mutex);
+      counters_->sizes[ptr] = size;
+      counters_->reserved += size;
+      counters_->peak_reserved = std::max(counters_->peak_reserved, counters_->reserved);
+    }
+    return ptr;
+  }
+  void Free(void* ptr) {
+    if (counters_ != nullptr) {
+      std::lock_guard<std::mutex> lock(counters_->mutex);
+      counters_->reserved -= counters_->sizes.at(ptr);
+      counters_->sizes.erase(ptr);
+    }
+    mxnet::storage::CPUDeviceStorage::Free(ptr);
+  }
+
+ private:
+  std::shared_ptr<DeviceCounters> counters_;
+};
+
+/*! \brief a storage manager to benchmark */
+struct ManagerConfig {
+  std::string name;
+  /*!
+   * \brief create the manager, counting the device memory it holds in counters
+   *  if not null and the manager supports it
+   */
+  std::function<StorageManager*(std::shared_ptr<DeviceCounters> counters)> create;
+  bool gpu;
+};
+
+std::vector<ManagerConfig> Managers() {
+  using mxnet::storage::CPUPooledStorageManager;
+  using mxnet::storage::NaiveStorageManager;
+  using mxnet::storage::ThreadCachedStorageManager;
+  std::vector<ManagerConfig> managers = {
+    {"Naive", [](std::shared_ptr<DeviceCounters> counters) -> StorageManager* {
+        return new NaiveStorageManager<CountingCPUStorage>(CountingCPUStorage(counters));
+      }, false},
+    {"CPUPooled", [](std::shared_ptr<DeviceCounters> counters) -> StorageManager* {
+        return new CPUPooledStorageManager<CountingCPUStorage>(
+          size_t(1) << 30, CountingCPUStorage(counters));
+      }, false},
+    {"CPUPooledThreadCached", [](std::shared_ptr<DeviceCounters> counters) -> StorageManager* {
+        return new ThreadCachedStorageManager(
+          new CPUPooledStorageManager<CountingCPUStorage>(
+            size_t(1) << 30, CountingCPUStorage(counters)), 1 << 20, 64 << 20);
+      }, false}};
+#if MXNET_USE_CUDA
+  if (mxnet::test::unitTestsWithCuda) {
+    managers.push_back({"GPUPooled", [](std::shared_ptr<DeviceCounters>) -> StorageManager* {
+        return new mxnet::storage::GPUPooledStorageManager();
+      }, true});
+    managers.push_back({"GPUPooledRounded", [](std::shared_ptr<DeviceCounters>) -> StorageManager* {
+        return new mxnet::storage::GPUPooledRoundedStorageManager();
+      }, true});
+  }
+#endif  // MXNET_USE_CUDA
+  return managers;
+}
+
+/*!
+ * \brief a trace of num_threads threads with up to max_live blocks each. The
+ *  sizes are log-uniform between 256B and 4MB, rounded to 256B, and a quarter
+ *  of the blocks are freed by the next thread, like the engine workers freeing
+ *  the arrays the main thread allocated.
+ */
+std::vector<TraceEvent> SyntheticTrace(int num_threads, int num_events, int max_live) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> log_size(8, 22);
+  std::uniform_real_distribution<double> coin(0, 1);
+  std::vector<std::vector<TraceEvent> > live(num_threads), handed(num_threads);
+  std::vector<TraceEvent> trace;
+  uint64_t next_id = 0;
+  auto free_block = [&](int thread, std::vector<TraceEvent>* blocks, size_t i) {
+    TraceEvent e = (*blocks)[i];
+    e.time = trace.size();
+    e.thread = thread;
+    e.type = 'f';
+    trace.push_back(e);
+    (*blocks)[i] = blocks->back();
+    blocks->pop_back();
+  };
+  while (static_cast<int>(trace.size()) < num_events) {
+    const int thread = rng() % num_threads;
+    if (!handed[thread].empty()) {
+      free_block(thread, &handed[thread], 0);
+    } else if (live[thread].size() >= static_cast<size_t>(max_live) ||
+               (!live[thread].empty() && coin(rng) < 0.5)) {
+      const size_t i = rng() % live[thread].size();
+      if (coin(rng) < 0.25) {
+        handed[(thread + 1) % num_threads].push_back(live[thread][i]);
+        live[thread][i] = live[thread].back();
+        live[thread].pop_back();
+      } else {
+        free_block(thread, &live[thread], i);
+      }
+    } else {
+      const size_t size = std::max<size_t>(256, (size_t(std::exp2(log_size(rng))) >> 8) << 8);
+      TraceEvent e{static_cast<int64_t>(trace.size()), thread, 'a', 1, 0, next_id++, size};
+      trace.push_back(e);
+      live[thread].push_back(e);
+    }
+  }
+  for (int thread = 0; thread < num_threads; ++thread) {
+    while (!handed[thread].empty()) free_block(thread, &handed[thread], 0);
+    while (!live[thread].empty()) free_block(thread, &live[thread], 0);
+  }
+  return trace;
+}
+
+/*! \brief measurements of a trace replayed against a storage manager */
+struct ReplayStats {
+  double ops_per_sec{0};
+  size_t peak_in_use{0};
+  size_t peak_reserved{0};
+};
+
+/*!
+ * \brief replay every thread of the trace on its own thread and time it. A
+ *  free waits for its allocation when it happened on another thread.
+ */
+double TimedReplay(StorageManager* manager, const std::vector<TraceEvent>& trace, bool gpu) {
+  int num_threads = 0;
+  uint64_t num_ids = 0;
+  for (const auto& e : trace) {
+    num_threads = std::max(num_threads, e.thread + 1);
+    num_ids = std::max(num_ids, e.id + 1);
+  }
+  std::vector<std::vector<const TraceEvent*> > per_thread(num_threads);
+  for (const auto& e : trace) {
+    if (e.size != 0) per_thread[e.thread].push_back(&e);
+  }
+  std::unique_ptr<std::atomic<void*>[]> ptrs(new std::atomic<void*>[num_ids]);
+  for (uint64_t i = 0; i < num_ids; ++i) ptrs[i].store(nullptr);
+  std::vector<bool> freed(num_ids, false);
+  std::vector<size_t> sizes(num_ids, 0);
+  for (const auto& e : trace) {
+    if (e.type == 'f') freed[e.id] = true;
+    sizes[e.id] = e.size;
+  }
+
+  const int64_t start = NowInUsec();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+#if MXNET_USE_CUDA
+      if (gpu) CUDA_CALL(cudaSetDevice(0));
+#endif  // MXNET_USE_CUDA
+      for (const TraceEvent* e : per_thread[t]) {
+        if (e->type == 'a') {
+          ptrs[e->id].store(manager->Alloc(e->size), std::memory_order_release);
+        } else {
+          void* ptr;
+          while ((ptr = ptrs[e->id].load(std::memory_order_acquire)) == nullptr) {
+            std::this_thread::yield();
+          }
+          manager->Free(ptr, e->size);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  const int64_t elapsed = NowInUsec() - start;
+  // the blocks still in use at the end of the trace
+  for (uint64_t i = 0; i < num_ids; ++i) {
+    void* ptr = ptrs[i].load();
+    if (ptr != nullptr && !freed[i]) manager->Free(ptr, sizes[i]);
+  }
+  size_t num_events = 0;
+  for (const auto& events : per_thread) num_events += events.size();
+  return num_events / (std::max<int64_t>(elapsed, 1) * 1e-6);
+}
+
+/*!
+ * \brief replay the trace in order on one thread and measure the peak of the
+ *  bytes in use and of the bytes reserved: the bytes held from the device when
+ *  it is counted, the bytes in use plus the bytes cached by the manager otherwise
+ */
+void MemoryReplay(StorageManager* manager, const std::vector<TraceEvent>& trace,
+                  const std::shared_ptr<DeviceCounters>& counters, ReplayStats* stats) {
+  std::unordered_map<uint64_t, void*> ptrs;
+  size_t in_use = 0;
+  for (const auto& e : trace) {
+    if (e.size == 0) continue;
+    if (e.type == 'a') {
+      ptrs[e.id] = manager->Alloc(e.size);
+      in_use += e.size;
+    } else {
+      manager->Free(ptrs.at(e.id), e.size);
+      ptrs.erase(e.id);
+      in_use -= e.size;
+    }
+    stats->peak_in_use = std::max(stats->peak_in_use, in_use);
+    if (counters == nullptr) {
+      mxnet::Storage::Stats manager_stats;
+      manager->GetStats(&manager_stats);
+      stats->peak_reserved = std::max(stats->peak_reserved,
+                                      in_use + manager_stats.bytes_cached);
+    }
+  }
+  for (const auto& e : trace) {
+    auto it = ptrs.find(e.id);
+    if (it != ptrs.end()) {
+      manager->Free(it->second, e.size);
+      ptrs.erase(it);
+    }
+  }
+  if (counters != nullptr) stats->peak_reserved = counters->peak_reserved;
+}
+
+ReplayStats Replay(const ManagerConfig& config, const std::vector<TraceEvent>& trace) {
+  ReplayStats stats;
+  {
+    std::unique_ptr<StorageManager> manager(config.create(nullptr));
+    stats.ops_per_sec = TimedReplay(manager.get(), trace, config.gpu);
+  }
+  auto counters = config.gpu ? nullptr : std::make_shared<DeviceCounters>();
+  std::unique_ptr<StorageManager> manager(config.create(counters));
+  MemoryReplay(manager.get(), trace, counters, &stats);
+  return stats;
+}
+
+}  // namespace
+
+TEST(StoragePerf, TraceRecorder) {
+  const std::string fname = "storage_trace_test.txt";
+  {
+    mxnet::storage::TraceRecorder recorder(fname);
+    mxnet::Storage::Handle a, b;
+    a.dptr = &a;
+    a.size = 100;
+    b.dptr = &b;
+    b.size = 200;
+    b.ctx = mxnet::Context::GPU(1);
+    recorder.RecordAlloc(a);
+    std::thread([&recorder, &b]() { recorder.RecordAlloc(b); }).join();
+    recorder.RecordFree(a);
+    // not allocated while recording
+    mxnet::Storage::Handle c;
+    c.dptr = &c;
+    recorder.RecordFree(c);
+    recorder.RecordFree(b);
+  }
+  auto trace = mxnet::storage::LoadTrace(fname);
+  std::remove(fname.c_str());
+  ASSERT_EQ(trace.size(), 4U);
+  EXPECT_EQ(trace[0].type, 'a');
+  EXPECT_EQ(trace[0].size, 100U);
+  EXPECT_EQ(trace[1].thread, 1);
+  EXPECT_EQ(trace[1].dev_type, mxnet::Context::kGPU);
+  EXPECT_EQ(trace[1].dev_id, 1);
+  EXPECT_EQ(trace[2].type, 'f');
+  EXPECT_EQ(trace[2].id, trace[0].id);
+  EXPECT_EQ(trace[3].id, trace[1].id);
+  EXPECT_LE(trace[0].time, trace[3].time);
+}
+
+TEST(StoragePerf, Replay) {
+  auto trace = SyntheticTrace(2, 2000, 16);
+  for (const auto& config : Managers()) {
+    ReplayStats stats = Replay(config, trace);
+    EXPECT_GT(stats.ops_per_sec, 0);
+    EXPECT_GT(stats.peak_in_use, 0U);
+    EXPECT_GE(stats.peak_reserved, stats.peak_in_use) << config.name;
+    if (config.name == "Naive") EXPECT_EQ(stats.peak_reserved, stats.peak_in_use);
+  }
+}
+
+TEST(StoragePerf, ReplayThroughput) {
+  if (!mxnet::test::performanceRun) return;
+  const std::string fname = dmlc::GetEnv("MXNET_STORAGE_TRACE_REPLAY", std::string());
+  auto trace = fname.empty() ? SyntheticTrace(4, 400000, 64) : mxnet::storage::LoadTrace(fname);
+  int num_threads = 0;
+  for (const auto& e : trace) num_threads = std::max(num_threads, e.thread + 1);
+  for (const auto& config : Managers()) {
+    ReplayStats stats = Replay(config, trace);
+    std::printf("{\"benchmark\": \"storage_replay\", \"manager\": \"%s\", \"trace\": \"%s\", "
+                "\"events\": %zu, \"threads\": %d, \"ops_per_sec\": %.0f, "
+                "\"peak_in_use\": %zu, \"peak_reserved\": %zu, \"fragmentation\": %.4f}\n",
+                config.name.c_str(), fname.empty() ? "synthetic" : fname.c_str(),
+                trace.size(), num_threads, stats.ops_per_sec, stats.peak_in_use,
+                stats.peak_reserved,
+                1.0 - static_cast<double>(stats.peak_in_use) / stats.peak_reserved);
+    std::fflush(stdout);
+  }
+}
@@ -25,7 +25,14 @@
 #include <dmlc/logging.h>
 #include <mxnet/storage.h>
 #include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
 #include "test_util.h"
+#include "../../src/storage/pooled_storage_manager.h"
+#include "../../src/storage/cpu_device_storage.h"
+#include "../../src/storage/numa_device_storage.h"
+#include "../../src/storage/thread_cached_storage_manager.h"
 
 TEST(Storage, Basic_CPU) {
   constexpr size_t kSize = 1024;
@@ -61,3 +68,129 @@ TEST(Storage, Basic_GPU) {
 }
 #endif  // MXNET_USE_CUDA
 
+
+TEST(Storage, RegisterHostMemory) {
+  auto&& storage = mxnet::Storage::Get();
+  std::vector<char> buffer(1 << 16);
+  storage->RegisterHostMemory(buffer.data(), buffer.size() / 2);
+  // regions overlapping a registered one are refused
+  EXPECT_THROW(storage->RegisterHostMemory(buffer.data() + 16, 16), dmlc::Error);
+  storage->RegisterHostMemory(buffer.data() + buffer.size() / 2, buffer.size() / 2);
+  storage->UnregisterHostMemory(buffer.data());
+  storage->UnregisterHostMemory(buffer.data() + buffer.size() / 2);
+  EXPECT_THROW(storage->UnregisterHostMemory(buffer.data()), dmlc::Error);
+}
+
+#if MXNET_USE_CUDA
+TEST(Storage, RoundedPool_GPU) {
+  if (mxnet::test::unitTestsWithCuda) {
+    CUDA_CALL(cudaSetDevice(0));
+    mxnet::storage::GPUPooledRoundedStorageManager pool;
+    // requests within the same size class share the cached block
+    void *ptr = pool.Alloc(5000);
+    pool.Free(ptr, 5000);
+    EXPECT_EQ(pool.Alloc(4800), ptr);
+    pool.Free(ptr, 4800);
+    // a big cached block is split for a smaller request ...
+    constexpr size_t kBig = 16 << 20;
+    void *big = pool.Alloc(kBig);
+    pool.Free(big, kBig);
+    void *head = pool.Alloc(kBig / 4);
+    EXPECT_EQ(head, big);
+    void *tail = pool.Alloc(kBig / 2);
+    EXPECT_GT(static_cast<char*>(tail), static_cast<char*>(head));
+    EXPECT_LT(static_cast<char*>(tail), static_cast<char*>(big) + kBig);
+    // ... and coalesced again once the pieces are released
+    pool.Free(head, kBig / 4);
+    pool.Free(tail, kBig / 2);
+    EXPECT_EQ(pool.Alloc(kBig), big);
+    pool.DirectFree(big, kBig);
+  }
+}
+#endif  // MXNET_USE_CUDA
+
+#if MXNET_USE_CUDA
+TEST(Storage, PoolPreload_GPU) {
+  if (mxnet::test::unitTestsWithCuda) {
+    constexpr size_t kSize = 4096;
+    const std::string profile = "storage_test_profile.txt";
+    std::remove(profile.c_str());
+    CUDA_CALL(cudaSetDevice(0));
+    {
+      // the pool records two blocks in use at the same time
+      mxnet::storage::GPUPooledStorageManager pool(0, profile);
+      void *a = pool.Alloc(kSize);
+      void *b = pool.Alloc(kSize);
+      pool.Free(a, kSize);
+      pool.Free(b, kSize);
+      EXPECT_EQ(pool.Alloc(kSize), b);
+      pool.Free(b, kSize);
+    }
+    mxnet::storage::GPUPooledStorageManager pool(0, profile);
+    mxnet::Storage::Stats stats;
+    pool.GetStats(&stats);
+    EXPECT_GE(stats.bytes_cached, 2 * kSize);
+    void *a = pool.Alloc(kSize);
+    void *b = pool.Alloc(kSize);
+    pool.GetStats(&stats);
+    EXPECT_EQ(stats.num_miss, 0U);
+    pool.Free(a, kSize);
+    pool.Free(b, kSize);
+  }
+}
+#endif  // MXNET_USE_CUDA
+
+TEST(Storage, PooledPool_CPU) {
+  constexpr size_t kSize = 1024;
+  mxnet::storage::CPUPooledStorageManager<mxnet::storage::CPUDeviceStorage> pool(2 * kSize);
+  void *a = pool.Alloc(kSize);
+  void *b = pool.Alloc(kSize);
+  void *c = pool.Alloc(kSize);
+  pool.Free(a, kSize);
+  pool.Free(b, kSize);
+  // the pool is full, c goes back to the system
+  pool.Free(c, kSize);
+  void *d = pool.Alloc(kSize);
+  EXPECT_TRUE(d == a || d == b);
+  pool.Free(d, kSize);
+}
+
+TEST(Storage, NUMAPool_CPU) {
+  constexpr size_t kSize = 1 << 20;
+  mxnet::storage::CPUPooledStorageManager<mxnet::storage::NUMADeviceStorage> pool(
+    2 * kSize, mxnet::storage::NUMADeviceStorage(0));
+  // blocks spanning whole pages are page aligned
+  char *a = static_cast<char*>(pool.Alloc(kSize));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 4096, 0U);
+  a[0] = a[kSize - 1] = 1;
+  // small blocks fall back to the plain CPU storage
+  void *b = pool.Alloc(16);
+  pool.Free(a, kSize);
+  pool.Free(b, 16);
+  EXPECT_EQ(pool.Alloc(kSize), a);
+  pool.Free(a, kSize);
+}
+
+TEST(Storage, ThreadCache_CPU) {
+  constexpr size_t kSize = 256;
+  constexpr int kThreads = 4;
+  mxnet::storage::ThreadCachedStorageManager pool(
+    new mxnet::storage::CPUPooledStorageManager<mxnet::storage::CPUDeviceStorage>(1 << 20),
+    kSize, 1 << 16);
+  // blocks freed on one thread are reused by the next allocation on it
+  void *ptr = pool.Alloc(kSize);
+  pool.Free(ptr, kSize);
+  EXPECT_EQ(pool.Alloc(kSize), ptr);
+  pool.Free(ptr, kSize);
+  // blocks allocated on one thread can be freed on another
+  std::vector<void*> ptrs(64);
+  for (auto& p : ptrs) p = pool.Alloc(kSize);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kThreads; ++i) {
+    workers.emplace_back([&pool, &ptrs, i]() {
+      for (size_t j = i; j < ptrs.size(); j += kThreads) pool.Free(ptrs[j], kSize);
+      for (int j = 0; j < 1000; ++j) pool.Free(pool.Alloc(kSize), kSize);
+    });
+  }
+  for (auto& t : workers) t.join();
+}
@@ -42,6 +42,7 @@ bool debugOutput = false;
 #else
 bool debugOutput = false;
 #endif
+bool performanceRun = false;
 }}
 
 #if MXNET_USE_CUDA
@@ -85,6 +86,8 @@ int main(int argc, char ** argv) {
       mxnet::test::unitTestsWithCuda = true;
     } else if (!strcmp(argv[x], "--debug")) {
       mxnet::test::debugOutput = true;
+    } else if (!strcmp(argv[x], "--perf")) {
+      mxnet::test::performanceRun = true;
     }
   }
 
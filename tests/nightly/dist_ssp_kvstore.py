@@ -0,0 +1,61 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import sys
+sys.path.insert(0, "../../python/")
+import mxnet as mx
+import numpy as np
+import os
+
+keys = ['3', '5']
+shapes = [(2, 3), (1201, 1201)]
+rate = 2
+staleness = int(os.getenv('MXNET_KVSTORE_SSP_STALENESS', 2))
+
+def test_ssp_push_pull():
+    kv = mx.kv.create('dist_ssp')
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    kv.init(keys, [mx.nd.ones(s) for s in shapes])
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    nrepeat = 5
+    for i in range(1, nrepeat + 1):
+        for key, s in zip(keys, shapes):
+            kv.push(key, mx.nd.ones(s) * (my_rank + 1))
+            val = mx.nd.zeros(s)
+            kv.pull(key, out=val)
+            # every other worker has pushed at least i - staleness times
+            least = 1 + rate * i * (my_rank + 1)
+            for r in range(nworker):
+                if r != my_rank:
+                    least += rate * max(i - staleness, 0) * (r + 1)
+            assert np.all(val.asnumpy() >= least), (my_rank, i, val.asnumpy().min(), least)
+    # the pushes of every worker are applied once answered
+    mx.nd.waitall()
+    kv._barrier()
+    num = (nworker + 1) * nworker * rate / 2 * nrepeat + 1
+    for key, s in zip(keys, shapes):
+        val = mx.nd.zeros(s)
+        kv.pull(key, out=val)
+        assert np.all(val.asnumpy() == num), (my_rank, val.asnumpy(), num)
+    print('worker ' + str(my_rank) + ' is done')
+
+if __name__ == "__main__":
+    test_ssp_push_pull()
@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import sys
+sys.path.insert(0, "../../python/")
+import mxnet as mx
+import numpy as np
+
+def check_diff_to_scalar(A, x, rank=None):
+    """ assert A == x"""
+    assert(np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x)
+
+shape = (2, 3)
+big_shape = (1200, 1200)        # bigger than BIGARRAY_BOUND
+rate = 2
+threshold = 0.5
+
+def init_kv():
+    kv = mx.kv.create('dist_sync')
+    kv.set_gradient_compression({'type': '2bit', 'threshold': threshold})
+    kv.init('3', mx.nd.ones(shape))
+    kv.init('99', mx.nd.ones(big_shape))
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    return kv, kv.rank, kv.num_workers
+
+def test_sync_2bit_push_pull():
+    kv, my_rank, nworker = init_kv()
+    # values below the threshold are accumulated on the workers: pushing 0.4
+    # three times sends 0, 0.5 and 0.5
+    nrepeat = 3
+    for i in range(nrepeat):
+        kv.push('3', mx.nd.ones(shape) * 0.4)
+        kv.push('99', mx.nd.ones(big_shape) * 0.4)
+    num = 1 + nworker * rate * 1.0
+    val = mx.nd.zeros(shape)
+    kv.pull('3', out=val)
+    check_diff_to_scalar(val, num)
+    val2 = mx.nd.zeros(big_shape)
+    kv.pull('99', out=val2)
+    check_diff_to_scalar(val2, num)
+    # values beyond the threshold are sent as the threshold
+    kv.push('3', mx.nd.ones(shape) * -3)
+    kv.pull('3', out=val)
+    check_diff_to_scalar(val, num - nworker * rate * threshold)
+    print('worker ' + str(my_rank) + ' is done')
+
+if __name__ == "__main__":
+    test_sync_2bit_push_pull()
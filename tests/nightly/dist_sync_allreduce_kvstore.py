@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import sys
+sys.path.insert(0, "../../python/")
+import mxnet as mx
+import numpy as np
+
+def check_diff_to_scalar(A, x, rank=None):
+    """ assert A == x"""
+    assert(np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x)
+
+keys = ['3', '5']
+shapes = [(2, 3), (1201, 1201)]
+rate = 2
+
+def test_sync_allreduce_push_pull():
+    kv = mx.kv.create('dist_sync_allreduce')
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    # the initial values are the ones of worker 0
+    kv.init(keys, [mx.nd.ones(s) * (my_rank + 1) for s in shapes])
+    for key, s in zip(keys, shapes):
+        val = mx.nd.zeros(s)
+        kv.pull(key, out=val)
+        check_diff_to_scalar(val, 1, my_rank)
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    nrepeat = 3
+    for i in range(nrepeat):
+        for key, s in zip(keys, shapes):
+            kv.push(key, mx.nd.ones(s) * (my_rank + 1))
+    num = (nworker + 1) * nworker * rate / 2 * nrepeat + 1
+    for key, s in zip(keys, shapes):
+        val = mx.nd.zeros(s)
+        kv.pull(key, out=val)
+        check_diff_to_scalar(val, num, my_rank)
+    print('worker ' + str(my_rank) + ' is done')
+
+if __name__ == "__main__":
+    test_sync_allreduce_push_pull()
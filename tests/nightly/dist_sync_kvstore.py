@@ -36,6 +36,8 @@ rsp_keys = ['9', '11', '13']
 rate = 2
 shape = (2, 3)
 big_shape = (1200, 1200)        # bigger than BIGARRAY_BOUND
+fp16_keys = ['15', '101']
+fp16_shapes = [shape, (1201, 1201)]  # partitions of odd sizes
 
 
 def init_kv():
@@ -46,6 +48,8 @@ def init_kv():
     # init kv row_sparse keys
     kv.init(rsp_keys, [mx.nd.ones(shape).tostype('row_sparse')] * len(rsp_keys))
     kv.init('100', mx.nd.ones(big_shape).tostype('row_sparse'))
+    # init kv float16 keys
+    kv.init(fp16_keys, [mx.nd.ones(s, dtype='float16') for s in fp16_shapes])
     # worker info
     my_rank = kv.rank
     nworker = kv.num_workers
@@ -96,6 +100,15 @@ def test_sync_push_pull():
         for row in row_ids_np:
             expected[row] = updated_val[row]
         check_diff_to_scalar(val, expected)
+        # pull overlapping subsets of rows into several arrays at once
+        vals = [mx.nd.zeros(shape, stype='row_sparse') for _ in range(3)]
+        rows_np = [np.random.randint(num_rows, size=num_rows) for _ in vals]
+        kv.row_sparse_pull('9', out=vals, row_ids=[mx.nd.array(r, dtype='int64') for r in rows_np])
+        for v, rows in zip(vals, rows_np):
+            expected = mx.nd.zeros(shape)
+            for row in rows:
+                expected[row] = updated_val[row]
+            check_diff_to_scalar(v, expected)
 
     def check_row_sparse_keys_with_zeros(kv, my_rank, nworker):
         nrepeat = 3
@@ -166,10 +179,72 @@ def test_sync_push_pull():
             expected[row] = updated_val[row]
         check_diff_to_scalar(val, expected, rank=my_rank)
 
+    def check_fp16_keys(kv, my_rank, nworker):
+        nrepeat = 3
+        for i in range(nrepeat):
+            for key, s in zip(fp16_keys, fp16_shapes):
+                kv.push(key, mx.nd.ones(s, dtype='float16')*(my_rank+1))
+
+        num = (nworker + 1) * nworker * rate / 2 * nrepeat + 1
+        for key, s in zip(fp16_keys, fp16_shapes):
+            val = mx.nd.zeros(s, dtype='float16')
+            kv.pull(key, out=val)
+            check_diff_to_scalar(val, num)
+
+    def check_server_shards(kv, my_rank, nworker):
+        prefix = '/tmp/dist_sync_kvstore'
+        saved = mx.nd.zeros(big_shape)
+        kv.pull('99', out=saved)
+        kv._barrier()
+        if my_rank == 0:
+            kv.save_server_shards(prefix)
+        kv._barrier()
+        kv.push('99', mx.nd.ones(big_shape))
+        kv._barrier()
+        if my_rank == 0:
+            kv.load_server_shards(prefix)
+        kv._barrier()
+        val = mx.nd.zeros(big_shape)
+        kv.pull('99', out=val)
+        check_diff_to_scalar(val, saved)
+
+    def check_dynamic_parts(kv, my_rank, nworker):
+        try:
+            import cv2
+        except ImportError:
+            return
+        num_images, num_epochs = 40, 2
+        path_rec = '/tmp/dist_sync_kvstore_parts.rec'
+        if my_rank == 0:
+            record = mx.recordio.MXRecordIO(path_rec, 'w')
+            for i in range(num_images):
+                img = np.zeros((4, 4, 3), dtype=np.uint8)
+                header = mx.recordio.IRHeader(0, float(i), i, 0)
+                record.write(mx.recordio.pack_img(header, img, img_fmt='.png'))
+            record.close()
+        kv._barrier()
+        data_iter = mx.io.ImageRecordIter(path_imgrec=path_rec, data_shape=(3, 4, 4),
+                                          batch_size=1, preprocess_threads=1,
+                                          dynamic_parts=8)
+        counts = np.zeros(num_images)
+        for _ in range(num_epochs):
+            data_iter.reset()
+            for batch in data_iter:
+                counts[int(batch.label[0].asnumpy()[0])] += 1
+        # all the workers together read every image once per epoch
+        kv.init('dynamic_parts', mx.nd.zeros(num_images))
+        kv.push('dynamic_parts', mx.nd.array(counts))
+        val = mx.nd.zeros(num_images)
+        kv.pull('dynamic_parts', out=val)
+        check_diff_to_scalar(val, rate * num_epochs)
+
     check_default_keys(kv, my_rank, nworker)
+    check_fp16_keys(kv, my_rank, nworker)
     check_row_sparse_keys(kv, my_rank, nworker)
     check_row_sparse_keys_with_zeros(kv, my_rank, nworker)
     check_big_row_sparse_keys(kv, my_rank, nworker)
+    check_server_shards(kv, my_rank, nworker)
+    check_dynamic_parts(kv, my_rank, nworker)
     print('worker ' + str(my_rank) + ' is done')
 
 if __name__ == "__main__":
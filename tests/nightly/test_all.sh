@@ -53,6 +53,13 @@ juLog -name=Python.Local.KVStore -error=Error python test_kvstore.py
 
 # python: distributed kvstore
 juLog -name=Python.Distributed.KVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_kvstore.py
+juLog -name=Python.Distributed.2bitKVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_2bit_kvstore.py
+MXNET_KVSTORE_DIST_HIERARCHICAL=1 juLog -name=Python.Distributed.HierarchicalKVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_kvstore.py
+MXNET_KVSTORE_FUSION_BOUND=1000 juLog -name=Python.Distributed.FusedKVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_kvstore.py
+MXNET_KVSTORE_BF16=1 juLog -name=Python.Distributed.BF16KVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_kvstore.py
+MXNET_KVSTORE_SERVER_NTHREADS=4 juLog -name=Python.Distributed.ThreadedServerKVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_kvstore.py
+juLog -name=Python.Distributed.SSPKVStore -error=Error ../../tools/launch.py -n 4 python dist_ssp_kvstore.py
+juLog -name=Python.Distributed.AllreduceKVStore -error=Error ../../tools/launch.py -n 4 python dist_sync_allreduce_kvstore.py
 
 # download data
 juLog -name=DownloadData bash ./download.sh
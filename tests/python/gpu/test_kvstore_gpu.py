@@ -64,5 +64,32 @@ def test_row_sparse_pull():
     check_row_sparse_pull(kv, 4, mx.gpu(0))
 
 
+def test_nccl_push_pull():
+    try:
+        kv = mx.kv.create('nccl')
+    except mx.base.MXNetError:
+        # not built with NCCL
+        return
+    ctxs = []
+    for i in range(8):
+        try:
+            mx.nd.zeros((1,), ctx=mx.gpu(i)).wait_to_read()
+        except mx.base.MXNetError:
+            break
+        ctxs.append(mx.gpu(i))
+    kv.init(keys, [mx.nd.zeros(shape)] * len(keys))
+    for it in range(3):
+        vals = [[mx.nd.ones(shape, ctx=ctx) * (i + 1) for i, ctx in enumerate(ctxs)]
+                for _ in keys]
+        kv.push(keys, vals)
+        outs = [[mx.nd.zeros(shape, ctx=ctx) for ctx in ctxs] for _ in keys]
+        kv.pull(keys, out=outs)
+        expected = len(ctxs) * (len(ctxs) + 1) / 2
+        for out in outs:
+            for o in out:
+                assert_almost_equal(o.asnumpy(), np.full(shape, expected))
+
+
 if __name__ == '__main__':
     test_row_sparse_pull()
+    test_nccl_push_pull()
@@ -35,6 +35,7 @@ from test_loss import *
 from test_gluon_rnn import *
 from test_sparse_operator import test_cast_storage_ex, test_sparse_dot
 from test_sparse_operator import test_sparse_nd_zeros, test_sparse_retain
+from test_sparse_operator import test_sparse_square_sum, test_lookup_row_sparse_grad
 from test_sparse_ndarray import test_create_csr, test_create_row_sparse
 
 set_default_context(mx.gpu(0))
@@ -951,6 +952,30 @@ def test_fullyconnected_with_type():
     check_consistency(sym, ctx_list)
 
 
+def test_batch_dot_with_type():
+    # Sizes are divisible by 8 to test TensorCore on Volta GPU.
+    for transpose_a, transpose_b in [(False, False), (False, True), (True, False), (True, True)]:
+        lhs_shape = (3, 24, 16) if transpose_a else (3, 16, 24)
+        rhs_shape = (3, 8, 24) if transpose_b else (3, 24, 8)
+        sym = mx.sym.batch_dot(mx.sym.Variable('lhs'), mx.sym.Variable('rhs'),
+                               transpose_a=transpose_a, transpose_b=transpose_b)
+        ctx_list = [{'ctx': mx.gpu(0), 'lhs': lhs_shape, 'rhs': rhs_shape,
+                     'type_dict': {'lhs': np.float16, 'rhs': np.float16}},
+                    {'ctx': mx.gpu(0), 'lhs': lhs_shape, 'rhs': rhs_shape,
+                     'type_dict': {'lhs': np.float32, 'rhs': np.float32}},
+                    {'ctx': mx.cpu(0), 'lhs': lhs_shape, 'rhs': rhs_shape,
+                     'type_dict': {'lhs': np.float32, 'rhs': np.float32}}]
+        check_consistency(sym, ctx_list)
+
+
+def test_rnn_with_type():
+    fused = mx.rnn.FusedRNNCell(16, num_layers=2, mode='lstm', prefix='')
+    outputs, _ = fused.unroll(4, mx.sym.Variable('data'), merge_outputs=True)
+    ctx_list = [{'ctx': mx.gpu(0), 'data': (8, 4, 16), 'type_dict': {'data': np.float16}},
+                {'ctx': mx.gpu(0), 'data': (8, 4, 16), 'type_dict': {'data': np.float32}}]
+    check_consistency(outputs, ctx_list)
+
+
 def test_activation_with_type():
     sym = mx.sym.Activation(name='act', act_type='sigmoid')
     ctx_list = [{'ctx': mx.gpu(0), 'act_data': (2, 2, 10, 10), 'type_dict': {'act_data': np.float64}},
@@ -1149,6 +1174,31 @@ def test_unfuse():
         check_rnn_consistency(fused, stack)
         check_rnn_consistency(stack, fused)
 
+def test_rnn_persist_inference():
+    # the persistent cudnn kernel must match the standard one for small batches
+    dshape = (4, 10, 32)
+    data = mx.sym.Variable('data')
+    outputs = []
+    args = None
+    for max_batch in ['0', '8']:
+        os.environ['MXNET_CUDNN_RNN_PERSIST_MAX_BATCH'] = max_batch
+        try:
+            fused = mx.rnn.FusedRNNCell(64, num_layers=2, mode='lstm', prefix='')
+            sym, _ = fused.unroll(10, data, merge_outputs=True)
+            mod = mx.mod.Module(sym, label_names=None, context=mx.gpu(0))
+            mod.bind(data_shapes=[('data', dshape)], label_shapes=None, for_training=False)
+            if args is None:
+                mod.init_params()
+                args, _ = mod.get_params()
+                batch = mx.io.DataBatch(data=[mx.random.uniform(shape=dshape)], label=[])
+            else:
+                mod.set_params(args, {})
+            mod.forward(batch, is_train=False)
+            outputs.append(mod.get_outputs()[0].asnumpy())
+        finally:
+            del os.environ['MXNET_CUDNN_RNN_PERSIST_MAX_BATCH']
+    assert_allclose(outputs[0], outputs[1], rtol=1e-3, atol=1e-5)
+
 def test_psroipooling_with_type():
     np.random.seed(1234)
     arg_params = {
@@ -1390,6 +1440,77 @@ def test_gluon_ctc_consistency():
     assert_almost_equal(cpu_data.grad.asnumpy(), gpu_data.grad.asnumpy(), atol=1e-3, rtol=1e-3)
 
 
+def test_pointwise_fusion():
+    data = mx.sym.Variable('data')
+    bias = mx.sym.Variable('bias')
+    act = mx.sym.Activation(mx.sym.exp(data * 0.5) + bias, act_type='tanh')
+    out = mx.sym.sqrt(mx.sym.square(act) + 1) - data
+    shape = (17, 33)
+    args = {'data': mx.nd.random.uniform(-1, 1, shape, ctx=mx.gpu(0)),
+            'bias': mx.nd.random.uniform(-1, 1, shape, ctx=mx.gpu(0))}
+    results = []
+    for fusion in ['0', '1']:
+        os.environ['MXNET_EXEC_ENABLE_POINTWISE_FUSION'] = fusion
+        grads = {k: mx.nd.zeros(shape, ctx=mx.gpu(0)) for k in args}
+        exe = out.bind(mx.gpu(0), args=args, args_grad=grads)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones(shape, ctx=mx.gpu(0))])
+        results.append([exe.outputs[0].asnumpy()] + [grads[k].asnumpy() for k in sorted(grads)])
+    del os.environ['MXNET_EXEC_ENABLE_POINTWISE_FUSION']
+    for a, b in zip(*results):
+        assert_almost_equal(a, b, rtol=1e-5, atol=1e-6)
+
+
+def test_cuda_graphs():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.Pooling(net, kernel=(2, 2), stride=(2, 2), pool_type='max')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc')
+    results = []
+    for enable in ['0', '1']:
+        os.environ['MXNET_EXEC_ENABLE_CUDA_GRAPHS'] = enable
+        exe = net.simple_bind(mx.gpu(0), data=(1, 3, 16, 16), grad_req='null')
+        np.random.seed(0)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        outputs = []
+        # the later runs replay the captured graph, with new input values
+        for i in range(5):
+            exe.arg_dict['data'][:] = i + 1
+            exe.forward(is_train=False)
+            outputs.append(exe.outputs[0].asnumpy())
+        results.append(outputs)
+    del os.environ['MXNET_EXEC_ENABLE_CUDA_GRAPHS']
+    for a, b in zip(*results):
+        assert_almost_equal(a, b, rtol=1e-5, atol=1e-6)
+
+
+def test_nhwc_layout():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv1')
+    net = mx.sym.BatchNorm(net, fix_gamma=False, name='bn1')
+    act = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.Convolution(act, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv2')
+    net = mx.sym.Pooling(net + act, kernel=(2, 2), stride=(2, 2), pool_type='max')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc')
+    results = []
+    for enable in ['0', '1']:
+        os.environ['MXNET_EXEC_ENABLE_NHWC_LAYOUT'] = enable
+        exe = net.simple_bind(mx.gpu(0), data=(2, 3, 16, 16))
+        # the parameters keep their NCHW shapes
+        assert exe.arg_dict['conv1_weight'].shape == (8, 3, 3, 3)
+        np.random.seed(0)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((2, 10), ctx=mx.gpu(0))])
+        results.append([exe.outputs[0].asnumpy()] + [g.asnumpy() for g in exe.grad_arrays])
+    del os.environ['MXNET_EXEC_ENABLE_NHWC_LAYOUT']
+    for a, b in zip(*results):
+        assert_almost_equal(a, b, rtol=1e-4, atol=1e-5)
+
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
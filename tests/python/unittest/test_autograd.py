@@ -376,6 +376,69 @@ def test_get_symbol():
     assert len(get_symbol(y).list_arguments()) == 2
 
 
+def test_backward_reuse():
+    # the backward executor of a graph differentiated before is reused
+    for batch in [4, 4, 4, 6, 4]:
+        x = mx.nd.array(np.random.uniform(-1, 1, (batch, 5)))
+        w = mx.nd.array(np.random.uniform(-1, 1, (3, 5)))
+        b = mx.nd.array(np.random.uniform(-1, 1, (3,)))
+        x.attach_grad()
+        w.attach_grad()
+        b.attach_grad()
+        with record():
+            y = nd.FullyConnected(x, w, b, num_hidden=3)
+            z = nd.sum(nd.square(nd.relu(y)))
+        z.backward()
+        yn = np.maximum(np.dot(x.asnumpy(), w.asnumpy().T) + b.asnumpy(), 0)
+        dy = 2 * yn
+        assert_almost_equal(x.grad.asnumpy(), np.dot(dy, w.asnumpy()), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(w.grad.asnumpy(), np.dot(dy.T, x.asnumpy()), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(b.grad.asnumpy(), dy.sum(axis=0), rtol=1e-4, atol=1e-5)
+
+
+def test_create_graph():
+    x = mx.nd.array([1, 2, 3])
+    x.attach_grad()
+    with record():
+        y = nd._internal._mul(nd._internal._mul(x, x), x)
+    y.backward(create_graph=True)
+    assert_almost_equal(x.grad.asnumpy(), 3 * x.asnumpy() ** 2)
+    with record():
+        z = nd.sum(nd._internal._mul(x.grad, x))
+    z.backward()
+    # z = 3 * x^3
+    assert_almost_equal(x.grad.asnumpy(), 9 * x.asnumpy() ** 2)
+
+
+def test_backward_release():
+    # the recorded arrays are released during backward without retain_graph,
+    # the cached executor of the graph is then reused with retain_graph
+    x = mx.nd.array(np.random.uniform(0.5, 1, (4, 5)))
+    x.attach_grad(grad_req='add')
+    for retain in [False, True, False]:
+        x.grad[:] = 0
+        with record():
+            z = x
+            for _ in range(5):
+                z = nd.sigmoid(nd.square(z))
+            z = nd.sum(z)
+        z.backward(retain_graph=retain)
+        grad = x.grad.asnumpy()
+        if retain:
+            z.backward()
+            assert_almost_equal(x.grad.asnumpy(), 2 * grad, rtol=1e-5, atol=1e-6)
+        xn = x.asnumpy()
+        y, dys = xn, []
+        for _ in range(5):
+            s = 1.0 / (1.0 + np.exp(-y * y))
+            dys.append(2 * y * s * (1 - s))
+            y = s
+        expected = np.ones_like(xn)
+        for dy in reversed(dys):
+            expected *= dy
+        assert_almost_equal(grad, expected, rtol=1e-4, atol=1e-6)
+
+
 if __name__ == "__main__":
     import nose
     nose.runmodule()
@@ -0,0 +1,44 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import mxnet as mx
+import numpy as np
+from mxnet.test_utils import assert_almost_equal
+
+
+def test_bulk():
+    prev = mx.engine.set_bulk_size(0)
+    assert mx.engine.set_bulk_size(prev) == 0
+    with mx.engine.bulk(5):
+        x = mx.nd.zeros((10,))
+        y = mx.nd.ones((10,))
+        for i in range(12):
+            x += y
+            y = y * 2
+        # an op on another context and a read dispatch the merged ops
+        z = x.copyto(mx.cpu(1))
+        assert_almost_equal(z.asnumpy(), np.full((10,), 2 ** 12 - 1))
+        for i in range(3):
+            x[:] = i
+        assert_almost_equal(x.asnumpy(), np.full((10,), 2))
+    assert mx.engine.set_bulk_size(prev) == prev
+
+
+if __name__ == '__main__':
+    import nose
+    nose.runmodule()
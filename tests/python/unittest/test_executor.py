@@ -15,6 +15,7 @@
 # specific language governing permissions and limitations
 # under the License.
 
+import re
 import numpy as np
 import mxnet as mx
 
@@ -152,8 +153,275 @@ def test_reshape():
     # test base exec forward
     exe.forward(is_train=False)
     assert np.all(exe.outputs[0].asnumpy() == 4)
+    # test repeated shapes reuse the executor
+    assert exe.reshape(x=(3,4)) is new_exe
+    other_exe = exe.reshape(x=(2,4))
+    assert other_exe is not new_exe
+    other_exe.forward(is_train=False)
+    assert np.all(other_exe.outputs[0].asnumpy() == 4)
+    assert exe.reshape(x=(2,4)) is other_exe
+
+def test_mem_arena():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=32, name='fc1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=32, name='fc2')
+    net = mx.sym.Activation(net, act_type='tanh')
+    net = mx.sym.FullyConnected(net, num_hidden=8, name='fc3')
+
+    def run(arena):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_MEM_ARENA", arena, "0")
+        exe = net.simple_bind(mx.cpu(), data=(4, 16))
+        mx.test_utils.set_env_var("MXNET_EXEC_MEM_ARENA", prev_val)
+        np.random.seed(0)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((4, 8))])
+        return [exe.outputs[0].asnumpy()] + [g.asnumpy() for g in exe.grad_arrays]
+
+    for expected, actual in zip(run("0"), run("1")):
+        assert reldiff(expected, actual) < 1e-6
+
+def test_batchnorm_folding():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv1')
+    net = mx.sym.BatchNorm(net, fix_gamma=False, eps=1e-4, name='bn1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.Convolution(net, num_filter=4, kernel=(3, 3), no_bias=True, name='conv2')
+    net = mx.sym.BatchNorm(net, name='bn2')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc')
+    net = mx.sym.BatchNorm(net, fix_gamma=False, name='bn3')
+
+    def run(fold):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_BATCHNORM_FOLDING", fold, "0")
+        exe = net.simple_bind(mx.cpu(), data=(2, 3, 6, 6), grad_req='null')
+        mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_BATCHNORM_FOLDING", prev_val)
+        assert sorted(exe.aux_dict.keys()) == sorted(net.list_auxiliary_states())
+        np.random.seed(0)
+        for arr in exe.arg_arrays + exe.aux_arrays:
+            arr[:] = np.random.uniform(0.5, 1.5, arr.shape)
+        exe.forward(is_train=False)
+        return exe.outputs[0].asnumpy()
+
+    assert reldiff(run("0"), run("1")) < 1e-5
+
+def test_mirror_budget():
+    data = mx.sym.Variable('data')
+    net = data
+    for i in range(6):
+        net = mx.sym.FullyConnected(net, num_hidden=64, name='fc%d' % i)
+        net = mx.sym.Activation(net, act_type='tanh')
+    net = mx.sym.FullyConnected(net, num_hidden=8, name='out')
+
+    def run(budget):
+        prev_val = mx.test_utils.set_env_var("MXNET_BACKWARD_MIRROR_BUDGET_MB", budget, "0")
+        exe = net.simple_bind(mx.cpu(), data=(4096, 16))
+        mx.test_utils.set_env_var("MXNET_BACKWARD_MIRROR_BUDGET_MB", prev_val)
+        np.random.seed(0)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-0.5, 0.5, arr.shape)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((4096, 8))])
+        return [exe.outputs[0].asnumpy()] + [g.asnumpy() for g in exe.grad_arrays]
+
+    for expected, actual in zip(run("0"), run("2")):
+        assert reldiff(expected, actual) < 1e-6
+
+def test_split_branches():
+    data = mx.sym.Variable('data')
+    heads = mx.sym.split(data, num_outputs=4, axis=1)
+    branches = [mx.sym.sin(heads[0]) * 2, mx.sym.exp(heads[1]) + heads[1],
+                mx.sym.tanh(mx.sym.square(heads[2])), mx.sym.relu(heads[3]) - 1]
+    net = mx.sym.concat(*branches, dim=1)
+
+    def run(split):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_BULK_EXEC_SPLIT_BRANCHES", split, "0")
+        exe = net.simple_bind(mx.cpu(), data=(8, 16))
+        mx.test_utils.set_env_var("MXNET_EXEC_BULK_EXEC_SPLIT_BRANCHES", prev_val)
+        np.random.seed(0)
+        exe.arg_arrays[0][:] = np.random.uniform(-1, 1, (8, 16))
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((8, 16))])
+        return [exe.outputs[0].asnumpy(), exe.grad_arrays[0].asnumpy()]
+
+    for expected, actual in zip(run("0"), run("1")):
+        assert reldiff(expected, actual) < 1e-6
+
+def test_memory_plan_report():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=256, name='big')
+    net = mx.sym.Activation(net, act_type='relu', name='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=4, name='small')
+    exe = net.simple_bind(mx.cpu(), data=(1024, 16), grad_req='null')
+    report = exe.debug_str()
+    assert 'Peak of' in report
+    # the activations of the wide layer are the largest block alive at the peak
+    blocks = re.findall(r'\t(\d+) KB\t(.*)', report)
+    assert int(blocks[0][0]) == 1024
+    assert 'big' in blocks[0][1] or 'relu' in blocks[0][1]
+
+def test_memory_plan():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=256, name='big')
+    net = mx.sym.Activation(net, act_type='relu', name='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=4, name='small')
+    for grad_req in ['write', 'null']:
+        exe = net.simple_bind(mx.cpu(), data=(1024, 16), grad_req=grad_req)
+        plan = exe.memory_plan()
+        entries = dict((e['name'], e) for e in plan['entries'])
+        assert entries['data']['req'] == -1
+        assert entries['data']['storage_id'] == -2
+        assert entries['big']['bytes'] == 1024 * 256 * 4
+        assert entries['big']['storage_id'] >= 0
+        assert entries['relu']['req'] in [1, 2]
+        totals = plan['totals']
+        assert len(totals) == 1 and totals[0]['context'] == 'cpu(0)'
+        assert totals[0]['forward_bytes'] >= 1024 * 256 * 4
+        assert totals[0]['train_bytes'] >= totals[0]['forward_bytes']
+        if grad_req == 'null':
+            assert totals[0]['train_bytes'] == totals[0]['forward_bytes']
+
+def test_constant_folding():
+    data = mx.sym.Variable('data')
+    weight = mx.sym.Variable('weight')
+    scale = mx.sym.Variable('scale')
+    # the weight is stored transposed and scaled, only computed from the parameters
+    w = mx.sym.broadcast_mul(mx.sym.transpose(weight), mx.sym.reshape(scale, shape=(-1, 1)))
+    net = mx.sym.FullyConnected(data, weight=w, num_hidden=8, no_bias=True, name='fc')
+    net = mx.sym.Group([net, mx.sym.sum(w)])
+
+    def run(fold):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_CONSTANT_FOLDING", fold, "0")
+        exe = net.simple_bind(mx.cpu(), data=(2, 5), weight=(5, 8), scale=(8,),
+                              grad_req='null', shared_arg_names=['weight', 'scale'])
+        mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_CONSTANT_FOLDING", prev_val)
+        np.random.seed(0)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        outputs = []
+        for i in range(2):
+            # the data changes at every run, the parameters do not
+            exe.arg_dict['data'][:] = i + 1
+            exe.forward(is_train=False)
+            outputs.append([out.asnumpy() for out in exe.outputs])
+        return outputs
+
+    for folded, expected in zip(run("1"), run("0")):
+        for out, ref in zip(folded, expected):
+            assert reldiff(ref, out) < 1e-5
+
+def test_common_expr_elimination():
+    data = mx.sym.Variable('data')
+    a = mx.sym.transpose(mx.sym.slice_axis(data, axis=1, begin=0, end=4))
+    b = mx.sym.transpose(mx.sym.slice_axis(data, axis=1, begin=0, end=4))
+    c = mx.sym.transpose(mx.sym.slice_axis(data, axis=1, begin=1, end=5))
+    net = mx.sym.Group([a + b, b * c])
+
+    def run(eliminate):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_COMMON_EXPR_ELIMINATION",
+                                             eliminate, "0")
+        exe = net.simple_bind(mx.cpu(), data=(3, 6))
+        mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_COMMON_EXPR_ELIMINATION", prev_val)
+        exe.arg_dict['data'][:] = np.random.uniform(-1, 1, (3, 6))
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((4, 3)), mx.nd.ones((4, 3))])
+        num_transpose = len(re.findall(r'Op:transpose', exe.debug_str()))
+        return exe.outputs[0].asnumpy(), exe.grad_arrays[0].asnumpy(), num_transpose
+
+    np.random.seed(0)
+    out, grad, num_transpose = run("0")
+    np.random.seed(0)
+    merged_out, merged_grad, merged_transpose = run("1")
+    assert merged_transpose < num_transpose
+    assert reldiff(out, merged_out) < 1e-6
+    assert reldiff(grad, merged_grad) < 1e-6
+
+def test_inplace_concat():
+    data = mx.sym.Variable('data')
+    a = mx.sym.FullyConnected(data, num_hidden=4, name='fc1')
+    b = mx.sym.Activation(data, act_type='tanh')
+    c = mx.sym.FullyConnected(data, num_hidden=4, name='fc2')
+    inner = mx.sym.Concat(a, mx.sym.relu(c), dim=1)
+    net = mx.sym.Concat(inner, b, dim=1) * 2
+    # a batch of 2 is not contiguous in the output, this Concat still runs
+    other = mx.sym.Concat(mx.sym.reshape(a, shape=(2, 2)), mx.sym.reshape(c, shape=(2, 2)),
+                          dim=1)
+    net = mx.sym.Group([net, other])
+
+    def run(inplace):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_INPLACE_CONCAT", inplace, "0")
+        exe = net.simple_bind(mx.cpu(), data=(1, 5))
+        mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_INPLACE_CONCAT", prev_val)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((1, 13)), mx.nd.ones((2, 4))])
+        return [x.asnumpy() for x in exe.outputs + exe.grad_arrays]
+
+    np.random.seed(0)
+    expected = run("0")
+    np.random.seed(0)
+    for x, y in zip(expected, run("1")):
+        assert reldiff(x, y) < 1e-6
+
+def test_slice_view():
+    data = mx.sym.Variable('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=8, name='fc')
+    gates = mx.sym.split(mx.sym.reshape(fc, shape=(1, 4, 2)), num_outputs=4, axis=1)
+    step = mx.sym.slice_axis(mx.sym.reshape(fc, shape=(4, 2)), axis=0, begin=1, end=3)
+    # slicing the last axis of a batch of 2 still copies
+    batch = mx.sym.slice_axis(mx.sym.reshape(fc, shape=(2, 4)), axis=1, begin=1, end=3)
+    net = mx.sym.Group([gates[0] * gates[3], mx.sym.tanh(gates[1]), step + 1, batch * 2])
+
+    def run(view):
+        prev_val = mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_SLICE_VIEW", view, "0")
+        exe = net.simple_bind(mx.cpu(), data=(1, 3))
+        mx.test_utils.set_env_var("MXNET_EXEC_ENABLE_SLICE_VIEW", prev_val)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones(out.shape) for out in exe.outputs])
+        return [x.asnumpy() for x in exe.outputs + exe.grad_arrays]
+
+    np.random.seed(0)
+    expected = run("0")
+    np.random.seed(0)
+    for x, y in zip(expected, run("1")):
+        assert reldiff(x, y) < 1e-6
+
+def test_next_input():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=4, name='fc')
+    exe = net.simple_bind(mx.cpu(), data=(2, 3))
+    for arr in exe.arg_arrays:
+        arr[:] = np.random.uniform(-1, 1, arr.shape)
+    weight = exe.arg_dict['fc_weight'].asnumpy()
+    bias = exe.arg_dict['fc_bias'].asnumpy()
+    for i in range(3):
+        x = np.random.uniform(-1, 1, (2, 3))
+        exe.next_input('data')[:] = x
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.ones((2, 4))])
+        assert reldiff(exe.arg_dict['data'].asnumpy(), x) < 1e-6
+        assert reldiff(exe.outputs[0].asnumpy(), np.dot(x, weight.T) + bias) < 1e-6
+        assert reldiff(exe.grad_dict['fc_weight'].asnumpy(), np.dot(np.ones((4, 2)), x)) < 1e-6
+    # without a new input the bound one is used again
+    exe.forward()
+    assert reldiff(exe.outputs[0].asnumpy(), np.dot(x, weight.T) + bias) < 1e-6
 
 if __name__ == "__main__":
     test_bind(disable_bulk_exec=False)
     test_bind(disable_bulk_exec=True)
     test_reshape()
+    test_mem_arena()
+    test_batchnorm_folding()
+    test_mirror_budget()
+    test_split_branches()
+    test_memory_plan_report()
+    test_memory_plan()
+    test_constant_folding()
+    test_common_expr_elimination()
+    test_inplace_concat()
+    test_slice_view()
+    test_next_input()
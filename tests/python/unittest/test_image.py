@@ -52,6 +52,23 @@ def test_imdecode():
         cv_image = cv2.imread(img)
         assert_almost_equal(image.asnumpy(), cv_image)
 
+def test_imdecode_reduced():
+    try:
+        import cv2
+    except ImportError:
+        return
+    if not hasattr(cv2, 'IMREAD_REDUCED_COLOR_4'):
+        return
+    src = np.random.randint(0, 256, (300, 400, 3)).astype(np.uint8)
+    str_image = cv2.imencode('.jpg', src)[1].tostring()
+    # 1/4 is the smallest scale still at least 100x70
+    image = mx.image.imdecode(str_image, to_rgb=0, min_width=100, min_height=70)
+    assert image.shape == (75, 100, 3)
+    cv_image = cv2.imdecode(np.frombuffer(str_image, dtype=np.uint8), cv2.IMREAD_REDUCED_COLOR_4)
+    assert_almost_equal(image.asnumpy(), cv_image)
+    image = mx.image.imdecode(str_image, to_rgb=0)
+    assert image.shape == (300, 400, 3)
+
 def test_scale_down():
     assert mx.image.scale_down((640, 480), (720, 120)) == (640, 106)
     assert mx.image.scale_down((360, 1000), (480, 500)) == (360, 375)
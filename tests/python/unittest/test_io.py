@@ -196,7 +196,7 @@ def test_LibSVMIter():
                     bz_file.close()
         os.chdir("..")
 
-    def check_libSVMIter_synthetic():
+    def check_libSVMIter_synthetic(parse_threads=0):
         cwd = os.getcwd()
         data_path = os.path.join(cwd, 'data.t')
         label_path = os.path.join(cwd, 'label.t')
@@ -214,7 +214,8 @@ def test_LibSVMIter():
 
         data_dir = os.path.join(cwd, 'data')
         data_train = mx.io.LibSVMIter(data_libsvm=data_path, label_libsvm=label_path,
-                                      data_shape=(3, ), label_shape=(3, ), batch_size=3)
+                                      data_shape=(3, ), label_shape=(3, ), batch_size=3,
+                                      parse_threads=parse_threads)
 
         first = mx.nd.array([[ 0.5, 0., 1.2], [ 0., 0., 0.], [ 0.6, 2.4, 1.2]])
         second = mx.nd.array([[ 0., 0., -1.2], [ 0.5, 0., 1.2], [ 0., 0., 0.]])
@@ -254,6 +255,7 @@ def test_LibSVMIter():
         assert(num_batches == int(expected_num_batches)), (num_batches, expected_num_batches)
 
     check_libSVMIter_synthetic()
+    check_libSVMIter_synthetic(parse_threads=4)
     check_libSVMIter_news_data()
 
 def test_CSVIter():
@@ -274,7 +276,148 @@ def test_CSVIter():
         for batch in iter(data_train):
             assert_almost_equal(data_train.getdata().asnumpy(), expected.asnumpy())
 
+    def check_CSVIter_prefetch(iter_fn, **kwargs):
+        cwd = os.getcwd()
+        data_path = os.path.join(cwd, 'data.t')
+        label_path = os.path.join(cwd, 'label.t')
+        with open(data_path, 'w') as fout:
+            for i in range(1000):
+                fout.write(','.join([str(i) for _ in range(4)]) + '\n')
+        with open(label_path, 'w') as fout:
+            for i in range(1000):
+                fout.write(str(i) + '\n')
+
+        # batches are written in place into the recycled buffers of the prefetcher
+        data_train = iter_fn(data_csv=data_path, data_shape=(4,),
+                             label_csv=label_path, batch_size=100,
+                             prefetch_buffer=2, **kwargs)
+        for epoch in range(2):
+            data_train.reset()
+            num_batches = 0
+            for batch in iter(data_train):
+                data = batch.data[0].asnumpy()
+                label = batch.label[0].asnumpy().reshape((-1,))
+                assert_almost_equal(data, np.tile(label.reshape((-1, 1)), (1, 4)))
+                assert_almost_equal(label, np.arange(100) + num_batches * 100)
+                num_batches += 1
+            assert num_batches == 10
+
     check_CSVIter_synthetic()
+    check_CSVIter_prefetch(mx.io.CSVIter, ctx='cpu')
+    check_CSVIter_prefetch(mx.io.CSVIter, ctx='cpu_pinned')
+    check_CSVIter_prefetch(mx.io.CSVIter, parse_threads=4)
+    check_CSVIter_prefetch(mx.io.DevicePrefetchIter, base_iter='CSVIter',
+                           device='cpu', device_prefetch=3)
+
+def test_CSRBlockIter():
+    curr_path = os.path.dirname(os.path.abspath(os.path.expanduser(__file__)))
+    sys.path.insert(0, os.path.join(curr_path, '../../../tools'))
+    import libsvm2csrblock
+    cwd = os.getcwd()
+    src_path = os.path.join(cwd, 'data.t')
+    dst_path = os.path.join(cwd, 'data.csrb')
+    with open(src_path, 'w') as fout:
+        fout.write('1.0 0:0.5 2:1.2\n')
+        fout.write('-2.0\n')
+        fout.write('-3.0 0:0.6 1:2.4 2:1.2\n')
+        fout.write('4 2:-1.2\n')
+    libsvm2csrblock.convert(src_path, dst_path, num_features=3, batch_size=3)
+    first = np.array([[0.5, 0., 1.2], [0., 0., 0.], [0.6, 2.4, 1.2]])
+    second = np.array([[0., 0., -1.2], [0., 0., 0.], [0., 0., 0.]])
+    data_iter = mx.io.CSRBlockIter(data_path=dst_path)
+    for epoch in range(2):
+        data_iter.reset()
+        batches = list(data_iter)
+        assert len(batches) == 2
+        assert batches[0].data[0].stype == 'csr'
+        assert batches[1].pad == 2
+    data_iter.reset()
+    for i, batch in enumerate(data_iter):
+        expected = first if i == 0 else second
+        assert_almost_equal(batch.data[0].asnumpy(), expected)
+    data_iter.reset()
+    labels = [batch.label[0].asnumpy() for batch in data_iter]
+    assert_almost_equal(labels[0], np.array([1., -2., -3.]))
+    assert_almost_equal(labels[1][:1], np.array([4.]))
+    part = mx.io.CSRBlockIter(data_path=dst_path, num_parts=2, part_index=1)
+    assert len(list(part)) == 1
+
+def test_ImageRecordIter_index():
+    try:
+        import cv2
+    except ImportError:
+        return
+    num_images = 50
+    path_rec, path_idx = 'test_index.rec', 'test_index.idx'
+    record = mx.recordio.MXIndexedRecordIO(path_idx, path_rec, 'w')
+    for i in range(num_images):
+        img = np.random.randint(0, 256, (8, 8, 3)).astype(np.uint8)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        record.write_idx(i, mx.recordio.pack_img(header, img, img_fmt='.png'))
+    record.close()
+
+    def read_labels(**kwargs):
+        data_iter = mx.io.ImageRecordIter(path_imgrec=path_rec, path_imgidx=path_idx,
+                                          data_shape=(3, 8, 8), batch_size=5,
+                                          preprocess_threads=1, **kwargs)
+        epochs = []
+        for _ in range(2):
+            data_iter.reset()
+            epochs.append([int(l) for batch in data_iter
+                           for l in batch.label[0].asnumpy()])
+        return epochs
+
+    # every epoch reads all the records once, in a new global order
+    epochs = read_labels(shuffle=True, seed=1)
+    for labels in epochs:
+        assert sorted(labels) == list(range(num_images))
+    assert epochs[0] != epochs[1]
+    assert read_labels()[0] == list(range(num_images))
+    # the parts take disjoint slices of the same permutation
+    parts = [read_labels(shuffle=True, seed=1, num_parts=2, part_index=i)[0]
+             for i in range(2)]
+    assert len(parts[0]) == len(parts[1]) == num_images // 2
+    assert sorted(parts[0] + parts[1]) == list(range(num_images))
+    # decoding in worker processes delivers the same records
+    for labels in read_labels(shuffle=True, seed=1, worker_procs=2):
+        assert sorted(labels) == list(range(num_images))
+
+def test_ImageRecordIter_decoded_cache():
+    try:
+        import cv2
+    except ImportError:
+        return
+    num_images = 20
+    path_rec = 'test_decoded_cache.rec'
+    record = mx.recordio.MXRecordIO(path_rec, 'w')
+    for i in range(num_images):
+        img = np.random.randint(0, 256, (10, 12, 3)).astype(np.uint8)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        record.write(mx.recordio.pack_img(header, img, img_fmt='.png'))
+    record.close()
+
+    def read_epochs(**kwargs):
+        data_iter = mx.io.ImageRecordIter(path_imgrec=path_rec, data_shape=(3, 8, 8),
+                                          resize=8, batch_size=5, preprocess_threads=2,
+                                          **kwargs)
+        epochs = []
+        for _ in range(3):
+            data_iter.reset()
+            batches = [(batch.data[0].asnumpy(), batch.label[0].asnumpy())
+                       for batch in data_iter]
+            epochs.append((np.concatenate([d for d, _ in batches]),
+                           np.concatenate([l for _, l in batches])))
+        return epochs
+
+    # the epochs read from the cache return the images of the first one
+    for cache in ['mem', 'test_decoded_cache.bin']:
+        epochs = read_epochs(decoded_cache=cache)
+        for data, labels in epochs:
+            assert_almost_equal(data, epochs[0][0])
+            assert_almost_equal(labels, np.arange(num_images))
+    # every image is returned echo_factor times
+    for data, labels in read_epochs(decoded_cache='mem', echo_factor=2):
+        assert sorted(labels.astype(int)) == sorted(list(range(num_images)) * 2)
 
 if __name__ == "__main__":
     test_NDArrayIter()
@@ -285,3 +428,6 @@ if __name__ == "__main__":
     test_LibSVMIter()
     test_NDArrayIter_csr()
     test_CSVIter()
+    test_CSRBlockIter()
+    test_ImageRecordIter_index()
+    test_ImageRecordIter_decoded_cache()
@@ -148,6 +148,24 @@ def test_aggregator():
     check_aggregator(init_kv_with_str(), 'a', str_keys)
 
 
+def test_aggregator_many_keys():
+    """aggregate many small keys and a big one pushed together"""
+    num_devs = 4
+    devs = [mx.Context('cpu', i) for i in range(num_devs)]
+    shapes = [(i + 1, 3) for i in range(200)] + [(1000, 1001)]
+    kv = mx.kv.create()
+    key_list = list(range(len(shapes)))
+    kv.init(key_list, [mx.nd.zeros(s) for s in shapes])
+    vals = [[mx.nd.ones(s, d) * (i + 1) for i, d in enumerate(devs)] for s in shapes]
+    kv.push(key_list, vals)
+    outs = [[mx.nd.zeros(s, d) for d in devs] for s in shapes]
+    kv.pull(key_list, out=outs)
+    expected = num_devs * (num_devs + 1) / 2
+    for vv in outs:
+        for v in vv:
+            check_diff_to_scalar(v, expected)
+
+
 def test_sparse_aggregator():
     """aggregate sparse ndarray on muliple devices"""
 
@@ -242,6 +260,10 @@ def test_get_type():
     kv = mx.kv.create(kvtype)
     assert kv.type == kvtype
 
+def test_gradient_compression():
+    kv = mx.kv.create()
+    assert_exception(kv.set_gradient_compression, {'type': '2bit', 'threshold': 0.5})
+
 def test_invalid_pull():
     def check_ignored_pull_single(kv, key):
         dns_val = (mx.nd.ones(shape) * 2)
@@ -77,5 +77,41 @@ def test_chain():
         assert reldiff(a.asnumpy(), b.asnumpy()) < 1e-6
 
 
+def test_pipeline_executor():
+    data = mx.sym.Variable('data')
+    with mx.AttrScope(ctx_group='stage1'):
+        net = mx.sym.FullyConnected(data, num_hidden=16, name='fc1')
+        net = mx.sym.Activation(net, act_type='tanh')
+    with mx.AttrScope(ctx_group='stage2'):
+        net = mx.sym.FullyConnected(net, num_hidden=4, name='fc2')
+        net = mx.sym.SoftmaxOutput(net, name='softmax')
+    group2ctx = {'stage1': mx.cpu(0), 'stage2': mx.cpu(1)}
+    shapes = {'data': (8, 10), 'softmax_label': (8,)}
+    np.random.seed(0)
+    batch = {'data': np.random.uniform(-1, 1, shapes['data']),
+             'softmax_label': np.random.randint(0, 4, shapes['softmax_label'])}
+
+    ref = net.simple_bind(mx.cpu(0), group2ctx=group2ctx, **shapes)
+    for name, arr in ref.arg_dict.items():
+        arr[:] = batch[name] if name in batch else np.random.uniform(-0.1, 0.1, arr.shape)
+    ref.forward(is_train=True)
+    ref.backward()
+
+    for schedule in ['1f1b', 'gpipe']:
+        pexec = mx.executor.PipelineExecutor(net, mx.cpu(0), group2ctx, 4,
+                                             schedule=schedule, **shapes)
+        for name, arr in pexec.arg_dict.items():
+            ref.arg_dict[name].copyto(arr)
+        # run twice, the gradients must be cleared between the steps
+        for _ in range(2):
+            outputs = pexec.forward_backward(**batch)
+        assert reldiff(ref.outputs[0].asnumpy(), outputs[0].asnumpy()) < 1e-6
+        for name, grad in pexec.grad_dict.items():
+            assert reldiff(ref.grad_dict[name].asnumpy(), grad.asnumpy()) < 1e-5
+        outputs = pexec.forward(**batch)
+        assert reldiff(ref.outputs[0].asnumpy(), outputs[0].asnumpy()) < 1e-6
+
+
 if __name__ == '__main__':
     test_chain()
+    test_pipeline_executor()
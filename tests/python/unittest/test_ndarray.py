@@ -108,6 +108,28 @@ def test_ndarray_setitem():
     assert same(x.asnumpy(), x_np)
 
 
+def test_ndarray_shared_mem():
+    a = mx.nd.array(np.arange(12).reshape((3, 4)), ctx=mx.Context('cpu_shared', 0))
+    assert a.context == mx.Context('cpu_shared', 0)
+    shared_pid, shared_id, shape, dtype = a._to_shared_mem()
+    b = mx.nd.NDArray(mx.nd.ndarray._new_from_shared_mem(shared_pid, shared_id, shape, dtype))
+    assert same(a.asnumpy(), b.asnumpy())
+    b[:] = 1
+    b.wait_to_read()
+    assert same(a.asnumpy(), np.ones((3, 4)))
+
+
+def test_ndarray_is_ready():
+    a = mx.nd.ones((100, 100))
+    b = mx.nd.dot(a, a)
+    b.wait_to_read()
+    assert b.is_ready()
+    c = b + 1
+    c.wait_to_read()
+    assert c.is_ready()
+    assert b.is_ready()
+
+
 def test_ndarray_elementwise():
     np.random.seed(0)
     nrepeat = 10
@@ -202,6 +224,64 @@ def test_ndarray_copy():
     assert np.sum(np.abs(c.asnumpy() != d.asnumpy())) == 0.0
 
 
+def test_ndarray_asnumpy_async():
+    a = mx.nd.array(np.random.uniform(-10, 10, (10, 10)))
+    b = a * 2
+    copied = []
+    copies = [b.asnumpy_async(), b.asnumpy_async(callback=copied.append)]
+    out = np.empty((10, 10), dtype=np.float32)
+    copies.append((b + 1).asnumpy_async(out))
+    assert same(copies[0].wait(), a.asnumpy() * 2)
+    assert same(copies[1].wait(), a.asnumpy() * 2)
+    assert copies[2].wait() is out
+    assert same(out, a.asnumpy() * 2 + 1)
+    assert all(c.done() for c in copies)
+    assert len(copied) == 1 and same(copied[0], a.asnumpy() * 2)
+    try:
+        b.asnumpy_async(np.empty((5,), dtype=np.float32))
+        assert False
+    except ValueError:
+        pass
+
+
+def test_ndarray_invoke_batch():
+    shapes = [(2, 3), (4,), (5, 1, 2)]
+    weights = [mx.nd.array(np.random.uniform(size=s)) for s in shapes]
+    grads = [mx.nd.array(np.random.uniform(size=s)) for s in shapes]
+    expected = [w.asnumpy() - 0.1 * (g.asnumpy() + 0.01 * w.asnumpy())
+                for w, g in zip(weights, grads)]
+    out = mx.nd.zeros((2, 3))
+    ops = [('sgd_update', [w, g], [w], {'lr': 0.1, 'wd': 0.01})
+           for w, g in zip(weights, grads)]
+    # reads the updated weight, then is overwritten by a later op
+    ops.append(('_mul_scalar', [weights[0]], [out], {'scalar': 2}))
+    ops.append(('elemwise_add', [out, out], [out], {}))
+    mx.nd.invoke_batch(ops)
+    for w, e in zip(weights, expected):
+        assert_almost_equal(w.asnumpy(), e, rtol=1e-5, atol=1e-6)
+    assert_almost_equal(out.asnumpy(), expected[0] * 4, rtol=1e-5, atol=1e-6)
+    # cached parameters give the same results
+    mx.nd.invoke_batch([('_mul_scalar', [weights[1]], [weights[1]], {'scalar': 2})])
+    mx.nd.invoke_batch([('_mul_scalar', [weights[1]], [weights[1]], {'scalar': 2})])
+    assert_almost_equal(weights[1].asnumpy(), expected[1] * 4, rtol=1e-5, atol=1e-6)
+
+
+def test_ndarray_imperative_cache():
+    # the same operator and parameters called with different shapes and types
+    for repeat in range(2):
+        for shape in [(2, 3), (4, 5), (2, 3, 4)]:
+            for dtype in [np.float32, np.float64]:
+                x = np.random.uniform(size=shape).astype(dtype)
+                y = mx.nd.sum(mx.nd.array(x, dtype=dtype), axis=1)
+                assert y.dtype == dtype
+                assert_almost_equal(y.asnumpy(), x.sum(axis=1), rtol=1e-5)
+                out = mx.nd.empty(shape[::2], dtype=dtype)
+                mx.nd.sum(mx.nd.array(x, dtype=dtype), axis=1, out=out)
+                assert_almost_equal(out.asnumpy(), x.sum(axis=1), rtol=1e-5)
+            y = mx.nd.sum(mx.nd.ones(shape), axis=0)
+            assert y.shape == shape[1:]
+
+
 def test_ndarray_scalar():
     c = mx.nd.empty((10,10))
     d = mx.nd.empty((10,10))
@@ -264,6 +344,57 @@ def test_ndarray_saveload():
         assert np.sum(single_ndarray.asnumpy() != single_ndarray_loaded.asnumpy()) == 0
     os.remove(fname)
 
+def test_ndarray_saveload_mappable():
+    fname = 'tmp_mappable.bin'
+    data = [mx.nd.array(np.random.uniform(size=(3, 4))),
+            mx.nd.arange(7, dtype='int32'),
+            mx.nd.array(np.random.uniform(size=(2, 1, 5)), dtype='float64')]
+    mx.nd.save(fname, data, mappable=True)
+    data2 = mx.nd.load(fname)
+    assert len(data2) == len(data)
+    for x, y in zip(data, data2):
+        assert x.dtype == y.dtype
+        assert same(x.asnumpy(), y.asnumpy())
+    dmap = {'arg:w%d' % i : x for i, x in enumerate(data)}
+    mx.nd.save(fname, dmap, mappable=True)
+    dmap2 = mx.nd.load(fname)
+    assert sorted(dmap2.keys()) == sorted(dmap.keys())
+    # writes to a loaded array do not reach the file
+    dmap2['arg:w0'][:] = 0
+    subset = mx.nd.load(fname, names=['arg:w2', 'arg:w0'])
+    assert sorted(subset.keys()) == ['arg:w0', 'arg:w2']
+    for k, y in subset.items():
+        assert same(dmap[k].asnumpy(), y.asnumpy())
+    # selection also works with the default format
+    mx.nd.save(fname, dmap)
+    subset = mx.nd.load(fname, names=['arg:w1'])
+    assert list(subset.keys()) == ['arg:w1']
+    assert same(subset['arg:w1'].asnumpy(), dmap['arg:w1'].asnumpy())
+    os.remove(fname)
+
+def test_ndarray_save_background():
+    fname = 'tmp_background.bin'
+    data = {'w%d' % i: mx.nd.array(np.random.uniform(size=(5, 6))) for i in range(3)}
+    expected = {k: v.asnumpy() for k, v in data.items()}
+    mx.nd.save(fname, data, background=True)
+    # the updates after the save do not reach the file
+    for v in data.values():
+        v += 1
+    mx.nd.wait_saves()
+    data2 = mx.nd.load(fname)
+    assert sorted(data2.keys()) == sorted(expected.keys())
+    for k, y in data2.items():
+        assert same(expected[k], y.asnumpy())
+    os.remove(fname)
+    # a failed save is reported by the next wait
+    mx.nd.save(os.path.join('no_such_dir', fname), [mx.nd.ones((2,))], background=True)
+    try:
+        mx.nd.wait_saves()
+        assert False, 'the failed save was not reported'
+    except mx.base.MXNetError:
+        pass
+    mx.nd.wait_saves()
+
 def test_ndarray_legacy_load():
     data = []
     for i in range(6):
@@ -584,6 +715,24 @@ def test_order(ctx=default_context()):
     gt = gt_topk(a_npy, axis=None, ret_typ="indices", k=5*5*5*5, is_ascend=False)
     assert_almost_equal(nd_ret_argsort, gt)
 
+def test_topk_small_k():
+    # integer values give many ties, which keep the order of a stable sort
+    dat = np.random.randint(0, 10, size=(20, 100)).astype(np.float32)
+    a_nd = mx.nd.array(dat)
+    for k in [1, 3, 10, 100]:
+        for is_ascend in [True, False]:
+            key = dat if is_ascend else -dat
+            gt_indices = np.argsort(key, axis=1, kind='mergesort')[:, :k]
+            gt_values = np.array([dat[i, gt_indices[i]] for i in range(dat.shape[0])])
+            value, indices = mx.nd.topk(a_nd, axis=1, k=k, ret_typ="both", is_ascend=is_ascend)
+            assert_almost_equal(indices.asnumpy(), gt_indices)
+            assert_almost_equal(value.asnumpy(), gt_values)
+            if k == 1:
+                indices = mx.nd.topk(a_nd, axis=0, k=k, is_ascend=is_ascend)
+                gt = np.argsort(key, axis=0, kind='mergesort')[:1, :]
+                assert_almost_equal(indices.asnumpy(), gt)
+
+
 def test_ndarray_equal():
     x = mx.nd.zeros((2, 3))
     y = mx.nd.ones((2, 3))
@@ -673,17 +822,24 @@ def test_iter():
 
 def test_cached():
     sym = mx.sym.Convolution(kernel=(3, 3), num_filter=10) + 2
-    op = mx.nd.CachedOp(sym)
-    data = mx.nd.ones((3, 4, 10, 10))
-    weight = mx.nd.ones((10, 4, 3, 3))
-    bias = mx.nd.ones((10,))
-    o1 = op(data, weight, bias)
-    bias[:] = 2
-    o2 = op(data, weight, bias)
-    assert_almost_equal(o2.asnumpy(), o1.asnumpy()+1)
-    o2[:] = 0
-    op(data, weight, bias, out=o2)
-    assert_almost_equal(o2.asnumpy(), o1.asnumpy()+1)
+    for flags in [(), [('static_alloc', True)]]:
+        op = mx.nd.CachedOp(sym, flags)
+        data = mx.nd.ones((3, 4, 10, 10))
+        weight = mx.nd.ones((10, 4, 3, 3))
+        bias = mx.nd.ones((10,))
+        o1 = op(data, weight, bias)
+        bias[:] = 2
+        o2 = op(data, weight, bias)
+        assert_almost_equal(o2.asnumpy(), o1.asnumpy()+1)
+        o2[:] = 0
+        op(data, weight, bias, out=o2)
+        assert_almost_equal(o2.asnumpy(), o1.asnumpy()+1)
+        # new inputs and shapes between calls
+        o3 = op(data * 2, weight, bias)
+        o4 = op(mx.nd.ones((2, 4, 8, 8)), weight, bias)
+        assert_almost_equal(o3.asnumpy(), o1.asnumpy()+37)
+        assert_almost_equal(o4.asnumpy(), o1.asnumpy()[:2, :, :6, :6]+1)
+        assert_almost_equal(o2.asnumpy(), o1.asnumpy()+1)
 
 def test_output():
     shape = (2,2)
@@ -741,6 +897,32 @@ def test_ndarray_fluent():
     check_fluent_regular('broadcast_to', {'shape': (5, 17, 47)})
 
 
+def test_dlpack():
+    for dtype in [np.float16, np.float32, np.float64, np.uint8, np.int32, np.int64]:
+        x = mx.nd.array(np.arange(24).reshape(2, 3, 4), dtype=dtype)
+        y = mx.nd.from_dlpack(x.to_dlpack_for_read())
+        assert y.shape == x.shape
+        assert y.dtype == x.dtype
+        assert same(y.asnumpy(), x.asnumpy())
+        # the arrays share their data
+        y[:] = 7
+        assert same(x.asnumpy(), np.full((2, 3, 4), 7, dtype=dtype))
+    # the data outlives the exported array
+    x = mx.nd.ones((5, 6))[1:3]
+    capsule = x.to_dlpack_for_write()
+    del x
+    z = mx.nd.from_dlpack(capsule)
+    assert same(z.asnumpy(), np.ones((2, 6)))
+    # a capsule is consumed only once
+    try:
+        mx.nd.from_dlpack(capsule)
+        assert False
+    except ValueError:
+        pass
+    # unused capsules free their tensor
+    mx.nd.zeros((3, 3)).to_dlpack_for_read()
+
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
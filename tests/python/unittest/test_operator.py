@@ -68,6 +68,9 @@ def test_elementwise_sum():
         for dim in range(1, maxdim):
             shape = tuple(np.random.randint(1, int(1000**(1.0/dim)), size=dim))
             check_elementwise_sum_with_shape(shape, np.random.randint(1, 8))
+    # the single pass sum of more than 4 inputs, and of more inputs than one pass takes
+    for n in [5, 9, 70]:
+        check_elementwise_sum_with_shape((3, 300), n)
 
 
 def check_concat_with_shape(shapes, dimension, skip_second):
@@ -324,6 +327,18 @@ def test_swapaxes():
 
     assert_almost_equal(out, swap_)
 
+    shape = (5, 20, 3, 33, 2)
+    data_tmp = np.random.normal(size=shape)
+    for dim1, dim2 in [(1, 3), (0, 1), (2, 4), (3, 4)]:
+        exe = mx.symbol.SwapAxis(data=data, dim1=dim1, dim2=dim2).simple_bind(
+            default_context(), data=shape)
+        exe.arg_dict['data'][:] = data_tmp
+        exe.forward(is_train=True)
+        assert_almost_equal(exe.outputs[0].asnumpy(), np.swapaxes(data_tmp, dim1, dim2))
+        out_grad = np.random.normal(size=exe.outputs[0].shape)
+        exe.backward([mx.nd.array(out_grad)])
+        assert_almost_equal(exe.grad_dict['data'].asnumpy(), np.swapaxes(out_grad, dim1, dim2))
+
 
 def test_scalarop():
     data = mx.symbol.Variable('data')
@@ -969,6 +984,71 @@ def test_batchnorm_training():
         check_batchnorm_training(stype)
 
 
+def test_sync_batchnorm():
+    # on a single device the synchronized layer is a plain batch norm
+    for shape in [(2, 3), (2, 3, 2, 2), (3, 4, 2, 3, 2)]:
+        for fix_gamma in [True, False]:
+            s = shape[1],
+            data_tmp = np.random.normal(-0.1, 0.1, size=shape)
+            gamma = np.random.uniform(1, 3, size=s)
+            beta = np.random.uniform(-1, 1, size=s)
+            in_location = [mx.nd.array(data_tmp), mx.nd.array(gamma), mx.nd.array(beta)]
+            mean_std = [mx.nd.array(np.random.uniform(size=s)),
+                        mx.nd.array(np.random.uniform(1, 2, size=s))]
+            data = mx.symbol.Variable('data')
+            for use_global_stats in [False, True]:
+                test = mx.symbol.contrib.SyncBatchNorm(data, fix_gamma=fix_gamma,
+                                                       use_global_stats=use_global_stats,
+                                                       key='sync_bn')
+                check_numeric_gradient(test, in_location, mean_std, numeric_eps=1e-2, rtol=0.16)
+
+            ograd = np.random.uniform(-1, 1, size=shape)
+            outputs = []
+            for bn in [mx.symbol.BatchNorm(data, fix_gamma=fix_gamma, eps=1e-3, momentum=0.9),
+                       mx.symbol.contrib.SyncBatchNorm(data, fix_gamma=fix_gamma, key='sync_bn')]:
+                args = [mx.nd.array(data_tmp), mx.nd.array(gamma), mx.nd.array(beta)]
+                grads = [mx.nd.zeros(shape), mx.nd.zeros(s), mx.nd.zeros(s)]
+                aux = [mx.nd.zeros(s), mx.nd.ones(s)]
+                exe = bn.bind(default_context(), args=args, args_grad=grads, aux_states=aux)
+                exe.forward(is_train=True)
+                exe.backward([mx.nd.array(ograd)])
+                outputs.append([exe.outputs[0].asnumpy()] + [g.asnumpy() for g in grads] +
+                               [a.asnumpy() for a in aux])
+            for expected, actual in zip(*outputs):
+                assert_almost_equal(actual, expected, rtol=1e-3, atol=1e-4)
+
+
+def test_batchnorm_backward_from_output():
+    # the Conv-BN-ReLU block computes the same gradients when BatchNorm and
+    # Activation write over their inputs
+    shape = (4, 3, 5, 5)
+    for fix_gamma in [True, False]:
+        for use_global_stats in [False, True]:
+            data = mx.symbol.Variable('data')
+            outputs = []
+            for from_output in [False, True]:
+                conv = mx.symbol.Convolution(data, num_filter=3, kernel=(3, 3), pad=(1, 1),
+                                             name='conv')
+                bn = mx.symbol.BatchNorm(conv, fix_gamma=fix_gamma,
+                                         use_global_stats=use_global_stats,
+                                         backward_from_output=from_output, name='bn')
+                net = mx.symbol.Activation(bn, act_type='relu')
+                exe = net.simple_bind(default_context(), data=shape)
+                np.random.seed(0)
+                for name, arr in exe.arg_dict.items():
+                    if name == 'bn_gamma':
+                        arr[:] = np.random.uniform(1, 3, arr.shape)
+                    else:
+                        arr[:] = np.random.uniform(-1, 1, arr.shape)
+                exe.aux_dict['bn_moving_var'][:] = np.random.uniform(1, 2, (3,))
+                exe.forward(is_train=True)
+                exe.backward([mx.nd.array(np.random.uniform(-1, 1, shape))])
+                outputs.append([exe.outputs[0].asnumpy()] +
+                               [exe.grad_dict[name].asnumpy() for name in net.list_arguments()])
+            for expected, actual in zip(*outputs):
+                assert_almost_equal(actual, expected, rtol=1e-3, atol=1e-4)
+
+
 def test_convolution_grouping():
     num_filter = 4
     num_group = 2
@@ -1038,6 +1118,67 @@ def test_depthwise_convolution():
                         np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3, atol=1e-4)
 
 
+def test_depthwise_convolution_dilate():
+    # rectangular kernels, strides and dilations on odd sizes, with accumulated gradients
+    num_group = 8
+    for kernel, stride, dilate, pad in [((3, 5), (1, 2), (2, 1), (2, 1)),
+                                        ((5, 3), (2, 1), (1, 2), (0, 2)),
+                                        ((1, 3), (3, 3), (3, 1), (1, 0))]:
+        shape = (3, num_group, 13, 11)
+        x = mx.sym.Variable('x')
+        w = mx.sym.Variable('w')
+        b = mx.sym.Variable('b')
+        y1 = mx.sym.Convolution(data=x, weight=w, bias=b, num_filter=num_group, num_group=num_group,
+                                kernel=kernel, stride=stride, dilate=dilate, pad=pad)
+        xslice = mx.sym.SliceChannel(data=x, num_outputs=num_group, axis=1)
+        wslice = mx.sym.SliceChannel(data=w, num_outputs=num_group, axis=0)
+        bslice = mx.sym.SliceChannel(data=b, num_outputs=num_group, axis=0)
+        y2 = mx.sym.Concat(*[mx.sym.Convolution(data=xslice[i], weight=wslice[i], bias=bslice[i],
+                                                num_filter=1, kernel=kernel, stride=stride,
+                                                dilate=dilate, pad=pad)
+                             for i in range(num_group)])
+        wshape = (num_group, 1) + kernel
+        exe1 = y1.simple_bind(default_context(), x=shape, w=wshape, b=(num_group,), grad_req='add')
+        exe2 = y2.simple_bind(mx.cpu(), x=shape, w=wshape, b=(num_group,))
+        for arr1, arr2 in zip(exe1.arg_arrays, exe2.arg_arrays):
+            arr1[:] = np.random.normal(size=arr1.shape)
+            arr2[:] = arr1
+        for grad in exe1.grad_arrays:
+            grad[:] = 1
+        exe1.forward(is_train=True)
+        exe1.backward(exe1.outputs[0])
+        exe2.forward(is_train=True)
+        exe2.backward(exe2.outputs[0])
+        assert_almost_equal(exe1.outputs[0].asnumpy(), exe2.outputs[0].asnumpy(), rtol=1e-3, atol=1e-4)
+        for grad1, grad2 in zip(exe1.grad_arrays, exe2.grad_arrays):
+            assert_almost_equal(grad1.asnumpy(), grad2.asnumpy() + 1, rtol=1e-3, atol=1e-4)
+
+
+def test_convolution_3x3_forward():
+    # 3x3 stride 1 convolutions with many channels, odd output sizes leave partial tiles
+    def conv_ref(data, weight, bias, pad):
+        data = np.pad(data, ((0, 0), (0, 0), (pad, pad), (pad, pad)), 'constant')
+        n, c, h, w = data.shape
+        out = np.zeros((n, weight.shape[0], h - 2, w - 2))
+        for i in range(3):
+            for j in range(3):
+                out += np.einsum('nchw,kc->nkhw', data[:, :, i:i + h - 2, j:j + w - 2],
+                                 weight[:, :, i, j])
+        return out + bias.reshape((1, -1, 1, 1))
+
+    for num_filter, shape in [(16, (2, 16, 7, 9)), (32, (1, 24, 8, 8)), (20, (3, 16, 5, 4))]:
+        for pad in [0, 1]:
+            for dtype in [np.float32, np.float64]:
+                data = np.random.normal(size=shape).astype(dtype)
+                weight = np.random.normal(size=(num_filter, shape[1], 3, 3)).astype(dtype)
+                bias = np.random.normal(size=(num_filter,)).astype(dtype)
+                out = mx.nd.Convolution(mx.nd.array(data, dtype=dtype), mx.nd.array(weight, dtype=dtype),
+                                        mx.nd.array(bias, dtype=dtype), kernel=(3, 3), pad=(pad, pad),
+                                        num_filter=num_filter)
+                assert_almost_equal(out.asnumpy(), conv_ref(data, weight, bias, pad),
+                                    rtol=1e-3, atol=1e-3)
+
+
 def gen_broadcast_data(idx):
     # Manually set test cases
     binary_op_data_shape = np.array(
@@ -1520,6 +1661,37 @@ def test_reduce():
                         outgrad.reshape(keepdim_shape) * (np.equal(data, outdata.reshape(keepdim_shape)).astype(np.float)),
                       mx.symbol.min)
 
+def test_large_broadcast_reduce():
+    # large enough for the parallel CPU kernels, every reduced layout
+    shape = (3, 40, 50)
+    data = np.random.uniform(-1, 1, shape)
+    x = mx.nd.array(data)
+    for axis in [None, 0, 1, 2, (0, 2), (0, 1), (1, 2)]:
+        for np_func, nd_func in [(np.sum, mx.nd.sum), (np.max, mx.nd.max),
+                                 (np.prod, mx.nd.prod)]:
+            assert_almost_equal(nd_func(x, axis=axis).asnumpy(), np_func(data, axis=axis),
+                                rtol=1e-4, atol=1e-5)
+    for rshape in [(1, 40, 1), (3, 1, 50), (1, 1, 50), (3, 40, 1), (1, 1, 1)]:
+        rdata = np.random.uniform(-1, 1, rshape)
+        y = mx.nd.array(rdata)
+        assert_almost_equal(mx.nd.broadcast_add(x, y).asnumpy(), data + rdata)
+        assert_almost_equal(mx.nd.broadcast_mul(y, x).asnumpy(), rdata * data)
+
+def test_reduce_contiguous_axis():
+    # short rows, long rows and few very long rows reduced over the innermost axes
+    for shape, axis in [((64, 5), 1), ((33, 700), 1), ((20, 5000), 1), ((2, 100000), 1),
+                        ((4, 30, 60), (1, 2)), ((3, 1, 2000), (1, 2))]:
+        data = np.random.uniform(-1, 1, shape)
+        x = mx.nd.array(data)
+        for np_func, nd_func in [(np.sum, mx.nd.sum), (np.max, mx.nd.max), (np.min, mx.nd.min)]:
+            assert_almost_equal(nd_func(x, axis=axis).asnumpy(), np_func(data, axis=axis),
+                                rtol=1e-4, atol=1e-3)
+        out = mx.nd.ones((shape[0],))
+        mx.nd.sum(x, axis=axis, out=out)
+        assert_almost_equal(out.asnumpy(), np.sum(data, axis=axis), rtol=1e-4, atol=1e-3)
+        assert_almost_equal(mx.nd.norm(x).asnumpy(), np.array([np.linalg.norm(data)]),
+                            rtol=1e-4, atol=1e-3)
+
 def test_broadcast():
     sample_num = 200
     for i in range(sample_num):
@@ -1566,6 +1738,14 @@ def test_transpose():
             y = mx.nd.transpose(x)
             assert_allclose(np.transpose(x.asnumpy()), y.asnumpy())
 
+    # larger than the tiles of the cpu transpose, NCHW <-> NHWC and time major <-> batch major
+    for dims, axes in [((2, 35, 17, 19), (0, 2, 3, 1)), ((2, 17, 19, 35), (0, 3, 1, 2)),
+                       ((50, 33, 8), (1, 0, 2)), ((48, 1, 32), (2, 1, 0)), ((70, 40), (1, 0))]:
+        for dtype in [np.float32, np.float64, np.int32, np.uint8]:
+            x = mx.nd.array(np.random.uniform(0, 100, size=dims), dtype=dtype)
+            y = mx.nd.transpose(x, axes=axes)
+            assert_allclose(np.transpose(x.asnumpy(), axes=axes), y.asnumpy())
+
 
 def test_expand_dims():
     for ndim in range(1, 6):
@@ -1974,6 +2154,51 @@ def test_correlation():
     unittest_correlation((5,1,4,4), kernel_size = 3,max_displacement = 1,stride1 = 2,stride2 = 1,pad_size = 2,is_multiply = False)
     unittest_correlation((5,1,6,4), kernel_size = 3,max_displacement = 1,stride1 = 2,stride2 = 1,pad_size = 2,is_multiply = False)
     unittest_correlation((5,1,11,11), kernel_size = 5,max_displacement = 1,stride1 = 1,stride2 = 1,pad_size = 2,is_multiply = False)
+    # more channels than a block of the cpu backward
+    unittest_correlation((2,40,6,6), kernel_size = 3,max_displacement = 1,stride1 = 1,stride2 = 1,pad_size = 2,is_multiply = True)
+    unittest_correlation((2,40,6,6), kernel_size = 3,max_displacement = 1,stride1 = 1,stride2 = 1,pad_size = 2,is_multiply = False)
+
+
+def test_fft_ifft():
+    def to_complex(x):
+        return x[..., 0::2] + 1j * x[..., 1::2]
+
+    def to_interleaved(c):
+        out = np.zeros(c.shape[:-1] + (2 * c.shape[-1],))
+        out[..., 0::2] = c.real
+        out[..., 1::2] = c.imag
+        return out
+
+    # power of two and other lengths, batches above and below compute_size
+    for shape in [(3, 8), (2, 6), (5, 7), (2, 3, 2, 5), (1, 2, 4, 16)]:
+        d = shape[-1]
+        cshape = shape[:-1] + (2 * d,)
+        data = mx.sym.Variable('data')
+        # fft: real data to the interleaved complex transform
+        x = np.random.normal(size=shape)
+        out_grad = np.random.normal(size=cshape)
+        exe = mx.sym.contrib.fft(data, compute_size=4).simple_bind(
+            default_context(), data=shape)
+        exe.arg_dict['data'][:] = x
+        exe.forward(is_train=True)
+        assert_almost_equal(exe.outputs[0].asnumpy(), to_interleaved(np.fft.fft(x)),
+                            rtol=1e-3, atol=1e-4)
+        exe.backward([mx.nd.array(out_grad)])
+        # the gradient is the real part of the inverse transform, not normalized
+        assert_almost_equal(exe.grad_dict['data'].asnumpy(),
+                            (np.fft.ifft(to_complex(out_grad)) * d).real, rtol=1e-3, atol=1e-4)
+        # ifft: interleaved complex data to the real part of the inverse transform
+        x = np.random.normal(size=cshape)
+        out_grad = np.random.normal(size=shape)
+        exe = mx.sym.contrib.ifft(data, compute_size=4).simple_bind(
+            default_context(), data=cshape)
+        exe.arg_dict['data'][:] = x
+        exe.forward(is_train=True)
+        assert_almost_equal(exe.outputs[0].asnumpy(), (np.fft.ifft(to_complex(x)) * d).real,
+                            rtol=1e-3, atol=1e-4)
+        exe.backward([mx.nd.array(out_grad)])
+        assert_almost_equal(exe.grad_dict['data'].asnumpy(), to_interleaved(np.fft.fft(out_grad)),
+                            rtol=1e-3, atol=1e-4)
 
 
 def test_support_vector_machine_l1_svm():
@@ -2130,6 +2355,37 @@ def test_instance_normalization():
     check_instance_norm_with_shape((3,3,2,3,2,1,1), default_context())
 
 
+def check_layer_norm_with_shape(shape, axis, xpu, eps=1e-5):
+    X = mx.symbol.Variable('X')
+    G = mx.symbol.Variable('G')
+    B = mx.symbol.Variable('B')
+    Y = mx.symbol.LayerNorm(data=X, gamma=G, beta=B, axis=axis, eps=eps, output_mean_var=True)
+    # an offset against the deviation exercises the accuracy of the statistics
+    x = np.random.normal(10, 1, shape)
+    gamma = np.random.normal(0, 1, shape[axis])
+    beta = np.random.normal(0, 1, shape[axis])
+    bshape = [1] * len(shape)
+    bshape[axis] = shape[axis]
+    np_mean = x.mean(axis=axis, keepdims=True)
+    np_std = np.sqrt(x.var(axis=axis, keepdims=True) + eps)
+    np_out = (x - np_mean) / np_std * gamma.reshape(bshape) + beta.reshape(bshape)
+    exe = Y.bind(xpu, args={'X': mx.nd.array(x, ctx=xpu), 'G': mx.nd.array(gamma, ctx=xpu),
+                            'B': mx.nd.array(beta, ctx=xpu)})
+    exe.forward(is_train=False)
+    assert_almost_equal(exe.outputs[0].asnumpy(), np_out, rtol=1e-3, atol=1e-3)
+    assert_almost_equal(exe.outputs[1].asnumpy(), np_mean, rtol=1e-4, atol=1e-4)
+    assert_almost_equal(exe.outputs[2].asnumpy(), np_std, rtol=1e-3, atol=1e-3)
+    Y = mx.symbol.LayerNorm(data=X, gamma=G, beta=B, axis=axis, eps=eps)
+    check_numeric_gradient(Y, {'X': np.random.normal(0, 1, shape), 'G': gamma, 'B': beta},
+                           ctx=xpu, numeric_eps=1e-2, rtol=1e-2, atol=1e-2)
+
+
+def test_layer_norm():
+    for shape, axis in [((2, 5), -1), ((3, 4, 33), -1), ((3, 4, 5), 1),
+                        ((4, 3, 2, 3), 0), ((1, 1), -1), ((70, 6), -1)]:
+        check_layer_norm_with_shape(shape, axis, default_context())
+
+
 def check_l2_normalization(in_shape, mode, ctx=default_context(), norm_eps=1e-10):
     data = mx.symbol.Variable('data')
     out = mx.symbol.L2Normalization(data=data, mode=mode, eps=norm_eps)
@@ -2277,6 +2533,71 @@ def test_sequence_reverse():
     check_sequence_reverse(mx.cpu())
 
 
+def np_sequence_pack(x, lengths):
+    T, N = x.shape[:2]
+    batch_sizes = np.array([np.sum(lengths > t) for t in range(T)])
+    rows = [x[t, i] for t in range(T) for i in range(batch_sizes[t])]
+    packed = np.zeros((T * N,) + x.shape[2:])
+    packed[:len(rows)] = rows
+    return packed, batch_sizes
+
+
+def np_sequence_unpack(packed, lengths):
+    T = len(packed) // len(lengths)
+    x = np.zeros((T, len(lengths)) + packed.shape[1:])
+    row = 0
+    for t in range(T):
+        for i in range(np.sum(lengths > t)):
+            x[t, i] = packed[row]
+            row += 1
+    return x
+
+
+def test_sequence_pack():
+    T, N = 4, 3
+    lengths = np.array([4, 2, 1])
+    x = np.random.uniform(-1, 1, (T, N, 2, 3))
+    mask = (np.arange(T)[:, None] < lengths[None, :])[:, :, None, None]
+    np_packed, np_batch_sizes = np_sequence_pack(x, lengths)
+    packed, batch_sizes = mx.nd.SequencePack(mx.nd.array(x), mx.nd.array(lengths))
+    assert_almost_equal(packed.asnumpy(), np_packed)
+    assert_array_equal(batch_sizes.asnumpy(), np_batch_sizes)
+    assert_almost_equal(mx.nd.SequenceUnpack(packed, batch_sizes).asnumpy(), x * mask)
+
+    # the gradients are the unpacked and packed output gradients
+    data = mx.sym.Variable('data')
+    seq_len = mx.sym.Variable('seq_len')
+    sym = mx.sym.SequencePack(data, seq_len)[0]
+    ograd = np.random.uniform(-1, 1, np_packed.shape)
+    check_symbolic_backward(sym, {'data': x, 'seq_len': lengths}, [ograd],
+                            {'data': np_sequence_unpack(ograd, lengths)},
+                            grad_req={'data': 'write', 'seq_len': 'null'})
+    sym = mx.sym.SequenceUnpack(data, mx.sym.Variable('batch_sizes'))
+    ograd = np.random.uniform(-1, 1, x.shape)
+    check_symbolic_backward(sym, {'data': np_packed, 'batch_sizes': np_batch_sizes}, [ograd],
+                            {'data': np_sequence_pack(ograd, lengths)[0]},
+                            grad_req={'data': 'write', 'batch_sizes': 'null'})
+
+    # the sequence operators give the packed results of the padded sequences
+    args = [packed, batch_sizes]
+    nd_lengths = mx.nd.array(lengths)
+    last = mx.nd.SequenceLast(mx.nd.array(x), nd_lengths, use_sequence_length=True)
+    assert_almost_equal(mx.nd.SequenceLast(*args, packed=True).asnumpy(), last.asnumpy())
+    rev = mx.nd.SequenceReverse(mx.nd.array(x), nd_lengths, use_sequence_length=True)
+    assert_almost_equal(mx.nd.SequenceReverse(*args, packed=True).asnumpy(),
+                        np_sequence_pack(rev.asnumpy(), lengths)[0])
+    masked = mx.nd.SequenceMask(*args, packed=True, value=2.)
+    expected = np_packed.copy()
+    expected[np.sum(lengths):] = 2.
+    assert_almost_equal(masked.asnumpy(), expected)
+    for op, kwargs in [(mx.sym.SequenceLast, {}), (mx.sym.SequenceReverse, {}),
+                       (mx.sym.SequenceMask, {'value': 1.})]:
+        sym = op(data=mx.sym.Variable('data'), batch_sizes=mx.sym.Variable('batch_sizes'),
+                 packed=True, **kwargs)
+        check_numeric_gradient(sym, [np_packed, np_batch_sizes], grad_nodes={'data': 'write'},
+                               numeric_eps=1e-3, rtol=1e-2)
+
+
 def mathematical_core_binary(name,
                              forward_mxnet_call,
                              forward_numpy_call,
@@ -3316,6 +3637,26 @@ def test_log_softmax():
             check_numeric_gradient(sym, [data], rtol=0.05, atol=1e-3)
 
 
+def test_softmax_cross_entropy():
+    # the second shape spans several chunks of the rows
+    for shape in [(4, 7), (3, 10000)]:
+        data = np.random.uniform(-5, 5, size=shape)
+        label = np.random.randint(0, shape[1], size=shape[0])
+        prob = np_softmax(data, axis=1)
+        loss = -np.log(prob[np.arange(shape[0]), label]).sum()
+        sym = mx.sym.softmax_cross_entropy(mx.sym.Variable('data'), mx.sym.Variable('label'))
+        args = {'data': data, 'label': label}
+        check_symbolic_forward(sym, args, [np.array([loss])], rtol=1e-3, atol=1e-3)
+        grad = prob.copy()
+        grad[np.arange(shape[0]), label] -= 1
+        check_symbolic_backward(sym, args, [np.array([2.0])], {'data': 2 * grad},
+                                rtol=1e-3, atol=1e-5, grad_req={'data': 'write', 'label': 'null'})
+    data = np.random.uniform(-2, 2, size=(3, 5))
+    label = np.random.randint(0, 5, size=3)
+    check_numeric_gradient(sym, {'data': data, 'label': label}, grad_nodes=['data'],
+                           rtol=0.05, atol=1e-3)
+
+
 def test_pick():
     def test_pick_helper(index_type=np.int32):
         for _ in range(100):
@@ -3393,6 +3734,44 @@ def test_ctc_loss():
     check_ctc_loss(acts2, labels2, true_loss)
 
 
+def test_ctc_loss_with_lengths():
+    # every utterance of a batch with data and label lengths scores as alone
+    seq_len, batch, alphabet = 12, 5, 6
+    acts = np.random.uniform(-2, 2, (seq_len, batch, alphabet)).astype(np.float32)
+    data_lengths = np.array([12, 7, 9, 4, 1], dtype=np.float32)
+    label_lengths = np.array([5, 5, 1, 2, 1], dtype=np.float32)
+    labels = np.random.randint(1, alphabet, (batch, 5)).astype(np.float32)
+    labels[1] = 2  # too long for its data with the repeats, scores 0
+    data = mx.sym.Variable('data')
+    ctc = mx.sym.contrib.ctc_loss(data, mx.sym.Variable('label'),
+                                  mx.sym.Variable('data_lengths'),
+                                  mx.sym.Variable('label_lengths'),
+                                  use_data_lengths=True, use_label_lengths=True)
+    acts_grad = mx.nd.empty(acts.shape)
+    exe = ctc.bind(ctx=default_context(),
+                   args=[mx.nd.array(x) for x in [acts, labels, data_lengths, label_lengths]],
+                   args_grad={'data': acts_grad})
+    exe.forward(is_train=True)
+    exe.backward([mx.nd.ones((batch,))])
+    loss = exe.outputs[0].asnumpy()
+    grad = acts_grad.asnumpy()
+    assert loss[1] == 0
+    for b in range(batch):
+        T, L = int(data_lengths[b]), int(label_lengths[b])
+        assert_almost_equal(grad[T:, b], np.zeros((seq_len - T, alphabet)))
+        if b == 1:
+            continue
+        one = mx.sym.contrib.ctc_loss(data, mx.sym.Variable('label'), padding_mask=-1)
+        single_grad = mx.nd.empty((T, 1, alphabet))
+        single = one.bind(ctx=default_context(),
+                          args=[mx.nd.array(acts[:T, b:b+1]), mx.nd.array(labels[b:b+1, :L])],
+                          args_grad={'data': single_grad})
+        single.forward(is_train=True)
+        single.backward([mx.nd.ones((1,))])
+        assert_almost_equal(loss[b:b+1], single.outputs[0].asnumpy(), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(grad[:T, b:b+1], single_grad.asnumpy(), rtol=1e-4, atol=1e-5)
+
+
 def test_quantization_op():
     min0 = mx.nd.array([0.0])
     max0 = mx.nd.array([1.0])
@@ -3465,6 +3844,103 @@ def test_custom_op():
         y.backward()
 
 
+def np_box_nms(data, overlap_thresh, valid_thresh, topk, coord_start, score_index,
+               id_index, force_suppress):
+    def iou(a, b):
+        w = max(min(a[2], b[2]) - max(a[0], b[0]), 0)
+        h = max(min(a[3], b[3]) - max(a[1], b[1]), 0)
+        inter = w * h
+        union = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter
+        return 0 if union <= 0 else inter / union
+    boxes = data.reshape((-1,) + data.shape[-2:])
+    out = -np.ones_like(boxes)
+    for b, image in enumerate(boxes):
+        order = [i for i in np.argsort(-image[:, score_index], kind='mergesort')
+                 if image[i, score_index] > valid_thresh]
+        if topk > 0:
+            order = order[:topk]
+        kept = []
+        for i in order:
+            box = image[i]
+            if all(id_index >= 0 and not force_suppress and other[id_index] != box[id_index] or
+                   iou(box[coord_start:coord_start + 4],
+                       other[coord_start:coord_start + 4]) <= overlap_thresh
+                   for other in kept):
+                kept.append(box)
+        if kept:
+            out[b, :len(kept)] = kept
+    return out.reshape(data.shape)
+
+
+def test_box_nms():
+    def check_box_nms(shape, overlap_thresh, valid_thresh, topk, id_index, force_suppress):
+        data = np.random.uniform(0, 1, size=shape).astype(np.float32)
+        # class id, score and the corners x1, y1, x2, y2
+        data[..., 0] = np.random.randint(0, 3, size=shape[:-1])
+        data[..., 4:6] = data[..., 2:4] + np.random.uniform(0.05, 0.5, size=shape[:-1] + (2,))
+        expected = np_box_nms(data, overlap_thresh, valid_thresh, topk, 2, 1,
+                              id_index, force_suppress)
+        out = mx.nd.contrib.box_nms(mx.nd.array(data), overlap_thresh=overlap_thresh,
+                                    valid_thresh=valid_thresh, topk=topk, coord_start=2,
+                                    score_index=1, id_index=id_index,
+                                    force_suppress=force_suppress)
+        assert_almost_equal(out.asnumpy(), expected)
+
+    x = mx.nd.array([[0, 0.5, 0.1, 0.1, 0.2, 0.2], [1, 0.4, 0.1, 0.1, 0.2, 0.2],
+                     [0, 0.3, 0.1, 0.1, 0.14, 0.14], [2, 0.6, 0.5, 0.5, 0.7, 0.8]])
+    out = mx.nd.contrib.box_nms(x, overlap_thresh=0.1, coord_start=2, score_index=1,
+                                id_index=0, force_suppress=True)
+    assert_almost_equal(out.asnumpy(), np.array([[2, 0.6, 0.5, 0.5, 0.7, 0.8],
+                                                 [0, 0.5, 0.1, 0.1, 0.2, 0.2],
+                                                 [-1, -1, -1, -1, -1, -1],
+                                                 [-1, -1, -1, -1, -1, -1]]))
+    for shape in [(20, 6), (3, 100, 6), (2, 2, 130, 7)]:
+        for id_index, force_suppress in [(-1, False), (0, False), (0, True)]:
+            check_box_nms(shape, 0.5, 0, -1, id_index, force_suppress)
+        check_box_nms(shape, 0.3, 0.2, 17, 0, False)
+
+
+def np_beam_search_step(scores, beam_scores, finished, beam_size, eos_id):
+    batch, beam, vocab = scores.shape
+    cand = beam_scores[:, :, None] + scores
+    for b, j in zip(*np.nonzero(finished)):
+        cand[b, j] = -np.inf
+        cand[b, j, eos_id] = beam_scores[b, j]
+    cand = cand.reshape(batch, -1)
+    best = np.argsort(-cand, axis=1, kind='mergesort')[:, :beam_size]
+    out_scores = cand[np.arange(batch)[:, None], best]
+    beams = best // vocab
+    tokens = best % vocab
+    done = (finished[np.arange(batch)[:, None], beams] != 0) | (tokens == eos_id)
+    return out_scores, tokens, beams, done
+
+
+def test_beam_search_step():
+    def check_beam_search_step(batch, beam, vocab, beam_size, eos_id):
+        scores = np.log(np.random.dirichlet(np.ones(vocab), size=(batch, beam))).astype(np.float32)
+        beam_scores = np.random.uniform(-10, 0, (batch, beam)).astype(np.float32)
+        finished = (np.random.uniform(size=(batch, beam)) < 0.3).astype(np.float32)
+        outs = mx.nd.contrib.beam_search_step(mx.nd.array(scores), mx.nd.array(beam_scores),
+                                              mx.nd.array(finished), beam_size=beam_size,
+                                              eos_id=eos_id)
+        expected = np_beam_search_step(scores, beam_scores, finished, beam_size, eos_id)
+        assert_almost_equal(outs[0].asnumpy(), expected[0], rtol=1e-5, atol=1e-5)
+        for out, e in zip(outs[1:], expected[1:]):
+            assert same(out.asnumpy(), e.astype(np.float32))
+
+    for batch, beam, vocab, beam_size in [(1, 1, 7, 4), (3, 4, 10, 4), (2, 5, 1500, 3),
+                                          (4, 2, 513, 6)]:
+        check_beam_search_step(batch, beam, vocab, beam_size, eos_id=vocab // 2)
+    # a finished hypothesis carries its score and the end of sequence token
+    outs = mx.nd.contrib.beam_search_step(
+        mx.nd.array([[[-1, -2, -3], [-0.5, -4, -1]]]), mx.nd.array([[-1, -2]]),
+        mx.nd.array([[0, 1]]), beam_size=3, eos_id=2)
+    assert same(outs[0].asnumpy(), np.array([[-2, -2, -3]], dtype=np.float32))
+    assert same(outs[1].asnumpy(), np.array([[0, 2, 1]], dtype=np.float32))
+    assert same(outs[2].asnumpy(), np.array([[0, 1, 0]], dtype=np.float32))
+    assert same(outs[3].asnumpy(), np.array([[0, 1, 0]], dtype=np.float32))
+
+
 def test_psroipooling():
     for num_rois in [1, 2]:
         for num_classes, num_group in itertools.product([2, 3], [2, 3]):
@@ -3490,6 +3966,64 @@ def test_psroipooling():
                                                grad_nodes=grad_nodes, ctx=mx.gpu(0))
 
 
+def np_roi_align(data, rois, pooled_size, spatial_scale, sample_ratio):
+    _, C, H, W = data.shape
+    PH, PW = pooled_size
+    out = np.zeros((rois.shape[0], C, PH, PW))
+
+    def bilinear(plane, y, x):
+        if y < -1 or y > H or x < -1 or x > W:
+            return 0
+        y, x = max(y, 0), max(x, 0)
+        y0, x0 = int(y), int(x)
+        if y0 >= H - 1:
+            y0 = y1 = H - 1
+            y = y0
+        else:
+            y1 = y0 + 1
+        if x0 >= W - 1:
+            x0 = x1 = W - 1
+            x = x0
+        else:
+            x1 = x0 + 1
+        ly, lx = y - y0, x - x0
+        return ((1 - ly) * (1 - lx) * plane[..., y0, x0] + (1 - ly) * lx * plane[..., y0, x1] +
+                ly * (1 - lx) * plane[..., y1, x0] + ly * lx * plane[..., y1, x1])
+
+    for r, roi in enumerate(rois):
+        b = int(roi[0])
+        x1, y1, x2, y2 = roi[1:] * spatial_scale
+        roi_w, roi_h = max(x2 - x1, 1), max(y2 - y1, 1)
+        bin_h, bin_w = roi_h / PH, roi_w / PW
+        gh = sample_ratio if sample_ratio > 0 else int(np.ceil(bin_h))
+        gw = sample_ratio if sample_ratio > 0 else int(np.ceil(bin_w))
+        for ph in range(PH):
+            for pw in range(PW):
+                for iy in range(gh):
+                    for ix in range(gw):
+                        y = y1 + ph * bin_h + (iy + 0.5) * bin_h / gh
+                        x = x1 + pw * bin_w + (ix + 0.5) * bin_w / gw
+                        out[r, :, ph, pw] += bilinear(data[b], y, x)
+                out[r, :, ph, pw] /= gh * gw
+    return out
+
+
+def test_roi_align():
+    for sample_ratio, pooled_size in [(-1, (3, 3)), (2, (2, 4)), (1, (4, 3))]:
+        data = np.random.uniform(-1, 1, (2, 3, 8, 9))
+        # overlapping regions, partly out of the map, and a degenerate one
+        rois = np.array([[0, 0, 0, 63, 55], [1, 8.4, 10.2, 40.7, 33.1],
+                         [1, 12, 5, 76, 80], [0, -10, 20, 30, 21], [1, 30, 30, 30, 30]])
+        spatial_scale = 0.125
+        data_var = mx.sym.Variable('data')
+        rois_var = mx.sym.Variable('rois')
+        op = mx.sym.contrib.ROIAlign(data=data_var, rois=rois_var, pooled_size=pooled_size,
+                                     spatial_scale=spatial_scale, sample_ratio=sample_ratio)
+        expected = np_roi_align(data, rois, pooled_size, spatial_scale, sample_ratio)
+        check_symbolic_forward(op, [data, rois], [expected], rtol=1e-4, atol=1e-5)
+        check_numeric_gradient(op, [data, rois], grad_nodes=['data'], rtol=1e-2, atol=1e-3)
+
+
 def test_deformable_convolution():
     for num_batch in [1, 2]:
         for num_channel_data, num_deformable_group in itertools.product([4, 8], [1, 2]):
@@ -3801,6 +4335,17 @@ def test_laop():
     if grad_check == 1:
       check_numeric_gradient(test_sumlogdiag, [a])
 
+    # a large batch of different matrices, factorized in parallel on cpu
+    m = np.random.uniform(-1, 1, (64, 5, 5))
+    a = np.matmul(m, np.transpose(m, (0, 2, 1))) + 5 * np.eye(5)
+    l = np.linalg.cholesky(a)
+    check_symbolic_forward(test_potrf, [a], [l], rtol=1e-3, atol=1e-4)
+    check_symbolic_forward(test_potri, [l], [np.linalg.inv(a)], rtol=1e-3, atol=1e-4)
+    check_symbolic_forward(test_trmm2, [l, a], [-2 * np.matmul(l, a)], rtol=1e-3, atol=1e-3)
+    check_symbolic_forward(test_sumlogdiag, [l],
+                           [np.log(np.diagonal(l, axis1=1, axis2=2)).sum(axis=1)],
+                           rtol=1e-3, atol=1e-4)
+
 
 def test_stack():
     for _ in range(100):
@@ -3854,6 +4399,209 @@ def test_dropout():
     exe.backward([mx.nd.ones((10, 10))], is_train=False)
     assert (exe.grad_arrays[0].asnumpy() == exe.outputs[0].asnumpy()).all()
 
+    # the mask keeps one bit per element, the last byte is partly used
+    for dtype in [np.float16, np.float32, np.float64]:
+        x = mx.sym.var('data')
+        y = mx.sym.Dropout(x, p=0.3)
+        exe = y.simple_bind(ctx=default_context(), data=(3, 7, 5), type_dict={'data': dtype})
+        data = np.random.uniform(1, 2, (3, 7, 5)).astype(dtype)
+        exe.arg_arrays[0][:] = data
+        exe.forward(is_train=True)
+        out = exe.outputs[0].asnumpy()
+        kept = out != 0
+        assert_almost_equal(out[kept], data[kept] / 0.7, rtol=1e-3, atol=1e-3)
+        ograd = np.random.uniform(-1, 1, (3, 7, 5)).astype(dtype)
+        exe.backward([mx.nd.array(ograd, dtype=dtype)])
+        grad = exe.grad_arrays[0].asnumpy()
+        assert (grad[~kept] == 0).all()
+        assert_almost_equal(grad[kept], ograd[kept] / 0.7, rtol=1e-3, atol=1e-3)
+
+
+def test_normalize_image():
+    data = np.random.randint(0, 256, size=(3, 3, 5, 7)).astype(np.uint8)
+    mean = (123.0, 117.0, 104.0)
+    std = (58.0, 57.0, 57.5)
+    expected = (data.astype(np.float32) - np.array(mean).reshape((1, 3, 1, 1))) / \
+        np.array(std).reshape((1, 3, 1, 1)) * 0.5
+    out = mx.nd.contrib.normalize_image(mx.nd.array(data, dtype=np.uint8),
+                                        mean=mean, std=std, scale=0.5)
+    assert out.dtype == np.float32
+    assert_almost_equal(out.asnumpy(), expected, rtol=1e-5, atol=1e-5)
+    out = mx.nd.contrib.normalize_image(mx.nd.array(data, dtype=np.uint8),
+                                        mean=mean, std=std, scale=0.5, mirror=True)
+    assert_almost_equal(out.asnumpy(), expected[:, :, :, ::-1], rtol=1e-5, atol=1e-5)
+    out = mx.nd.contrib.normalize_image(mx.nd.array(data, dtype=np.uint8),
+                                        mean=mean, std=std, scale=0.5, rand_mirror=True)
+    for n in range(data.shape[0]):
+        image = out[n].asnumpy()
+        assert np.allclose(image, expected[n], rtol=1e-5, atol=1e-5) or \
+            np.allclose(image, expected[n, :, :, ::-1], rtol=1e-5, atol=1e-5)
+
+
+def np_dot_product_attention(q, k, v, scale, causal=False, length=None, num_heads=1):
+    scores = np.einsum('ntd,nsd->nts', q, k) * scale
+    mask = np.ones(scores.shape, dtype=bool)
+    if causal:
+        mask &= np.tril(np.ones(scores.shape[1:], dtype=bool))[np.newaxis]
+    if length is not None:
+        keys = np.arange(k.shape[1])
+        for n in range(q.shape[0]):
+            mask[n, :, keys >= length[n // num_heads]] = False
+    scores = np.where(mask, scores, -np.inf)
+    prob = np.exp(scores - np.max(scores, axis=2, keepdims=True))
+    prob = np.nan_to_num(prob / np.sum(prob, axis=2, keepdims=True))
+    return np.einsum('nts,nsd->ntd', prob, v)
+
+
+def test_dot_product_attention():
+    q_sym, k_sym, v_sym = mx.sym.Variable('q'), mx.sym.Variable('k'), mx.sym.Variable('v')
+    len_sym = mx.sym.Variable('len')
+    # the longer keys span several tiles of keys
+    for N, T, S, D, Dv in [(2, 3, 5, 4, 3), (2, 70, 70, 8, 5), (2, 35, 35, 2, 2),
+                           (4, 6, 6, 3, 3)]:
+        q = np.random.normal(size=(N, T, D))
+        k = np.random.normal(size=(N, S, D))
+        v = np.random.normal(size=(N, S, Dv))
+        length = np.random.randint(1, S + 1, size=N // 2)
+        for causal in [False, True]:
+            if causal and T != S:
+                continue
+            for use_length in [False, True]:
+                kwargs = {'causal': causal, 'use_length': use_length, 'num_heads': 2}
+                args = {'q': q, 'k': k, 'v': v}
+                if use_length:
+                    sym = mx.sym.contrib.dot_product_attention(q_sym, k_sym, v_sym, len_sym,
+                                                               **kwargs)
+                    args['len'] = length
+                else:
+                    sym = mx.sym.contrib.dot_product_attention(q_sym, k_sym, v_sym, **kwargs)
+                expected = np_dot_product_attention(q, k, v, 1 / np.sqrt(D), causal,
+                                                    length if use_length else None, 2)
+                check_symbolic_forward(sym, args, [expected], rtol=1e-3, atol=1e-4)
+                if N * T < 100:
+                    check_numeric_gradient(sym, args, grad_nodes=['q', 'k', 'v'],
+                                           numeric_eps=1e-3, rtol=1e-2, atol=1e-3)
+    sym = mx.sym.contrib.dot_product_attention(q_sym, k_sym, v_sym, scale=0.3)
+    check_symbolic_forward(sym, {'q': q, 'k': k, 'v': v},
+                           [np_dot_product_attention(q, k, v, 0.3)], rtol=1e-3, atol=1e-4)
+
+
+def check_fused_rnn_cpu(fused, stack, T, N, I):
+    data = mx.sym.Variable('data')
+    dshape = (N, T, I)
+
+    def get_module(cell, args=None):
+        cell.reset()
+        sym, _ = cell.unroll(T, data, merge_outputs=True)
+        mod = mx.mod.Module(sym, label_names=None, context=mx.cpu())
+        mod.bind(data_shapes=[('data', dshape)], label_shapes=None,
+                 inputs_need_grad=True)
+        if args is None:
+            mod.init_params(initializer=mx.init.Uniform(0.1))
+        else:
+            mod.set_params(args, {})
+        return mod
+
+    mod1 = get_module(fused)
+    args, _ = mod1.get_params()
+    args = stack.pack_weights(fused.unpack_weights(args))
+    mod2 = get_module(stack, args)
+
+    batch = mx.io.DataBatch(data=[mx.random.uniform(shape=dshape)], label=[])
+    outputs = []
+    for mod in [mod1, mod2]:
+        mod.forward(batch, is_train=True)
+        out = mod.get_outputs()[0]
+        mod.backward([mx.nd.ones(out.shape) * 0.1])
+        outputs.append(out.asnumpy())
+    assert_allclose(outputs[0], outputs[1], rtol=1e-3, atol=1e-5)
+    assert_allclose(mod1.get_input_grads()[0].asnumpy(),
+                    mod2.get_input_grads()[0].asnumpy(), rtol=1e-3, atol=1e-5)
+    grads1 = fused.unpack_weights({name: grad[0].copy() for name, grad in
+                                   zip(mod1._exec_group.param_names,
+                                       mod1._exec_group.grad_arrays)})
+    for name, grad in zip(mod2._exec_group.param_names, mod2._exec_group.grad_arrays):
+        assert_allclose(grads1[name].asnumpy(), grad[0].asnumpy(), rtol=1e-3, atol=1e-5)
+
+
+def test_rnn_cpu():
+    T, N, I, H = 5, 4, 6, 8
+    for mode in ['rnn_relu', 'rnn_tanh', 'lstm', 'gru']:
+        for num_layers, bidirectional in [(1, False), (2, False), (2, True)]:
+            fused = mx.rnn.FusedRNNCell(H, num_layers=num_layers, mode=mode,
+                                        bidirectional=bidirectional, prefix='')
+            stack = fused.unfuse()
+            check_fused_rnn_cpu(fused, stack, T, N, I)
+
+
+def test_rnn_packed():
+    # the packed sequences give the results of running every sequence alone
+    T, N, I, H = 5, 3, 4, 6
+    lengths = np.array([5, 3, 2])
+    mask = (np.arange(T)[:, None] < lengths[None, :])[:, :, None]
+    for mode in ['rnn_tanh', 'lstm', 'gru']:
+        for num_layers, bidirectional in [(1, False), (2, True)]:
+            kwargs = dict(state_size=H, num_layers=num_layers, mode=mode,
+                          bidirectional=bidirectional)
+            states = ['state', 'state_cell'] if mode == 'lstm' else ['state']
+            sym = mx.sym.RNN(*[mx.sym.Variable(name) for name in ['data', 'parameters'] + states],
+                             **kwargs)
+            arg_shapes, _, _ = sym.infer_shape(data=(T, N, I))
+            x = mx.nd.array(np.random.uniform(-1, 1, (T, N, I)) * mask)
+            w = mx.nd.array(np.random.uniform(-0.3, 0.3, arg_shapes[1]))
+            h0 = [mx.nd.array(np.random.uniform(-1, 1, arg_shapes[2])) for _ in states]
+            x.attach_grad()
+            w.attach_grad()
+            with mx.autograd.record():
+                packed, batch_sizes = mx.nd.SequencePack(x, mx.nd.array(lengths))
+                y = mx.nd.RNN(packed, w, *h0, batch_sizes=batch_sizes, packed=True, **kwargs)
+                out = mx.nd.SequenceUnpack(y, batch_sizes)
+            out.backward(mx.nd.ones(out.shape))
+            final = mx.nd.RNN(packed, w, *h0, batch_sizes=batch_sizes, packed=True,
+                              state_outputs=True, **kwargs)[1:]
+            out, dx = out.asnumpy(), x.grad.asnumpy()
+            final = [state.asnumpy() for state in final]
+            dw = np.zeros(w.shape)
+            for i, L in enumerate(lengths):
+                xi = mx.nd.array(x.asnumpy()[:L, i:i + 1])
+                hi = [mx.nd.array(h.asnumpy()[:, i:i + 1]) for h in h0]
+                wi = w.copy()
+                xi.attach_grad()
+                wi.attach_grad()
+                with mx.autograd.record():
+                    yi = mx.nd.RNN(xi, wi, *hi, **kwargs)
+                yi.backward(mx.nd.ones(yi.shape))
+                assert_almost_equal(out[:L, i:i + 1], yi.asnumpy(), rtol=1e-4, atol=1e-5)
+                assert_almost_equal(out[L:, i], np.zeros((T - L, out.shape[2])))
+                assert_almost_equal(dx[:L, i:i + 1], xi.grad.asnumpy(), rtol=1e-4, atol=1e-5)
+                final_i = mx.nd.RNN(xi, wi, *hi, state_outputs=True, **kwargs)[1:]
+                for state, state_i in zip(final, final_i):
+                    assert_almost_equal(state[:, i:i + 1], state_i.asnumpy(),
+                                        rtol=1e-4, atol=1e-5)
+                dw += wi.grad.asnumpy()
+            assert_almost_equal(w.grad.asnumpy(), dw, rtol=1e-3, atol=1e-5)
+
+
+def test_imperative_legacy_op_state_reuse():
+    # legacy operators called again with arrays of the same shapes share their state
+    weight = mx.nd.array(np.random.uniform(-1, 1, (4, 3, 3, 3)))
+    bias = mx.nd.array(np.random.uniform(-1, 1, (4,)))
+    sym = mx.sym.Convolution(data=mx.sym.Variable('data'), kernel=(3, 3), num_filter=4,
+                             name='conv')
+    for _ in range(3):
+        data = mx.nd.array(np.random.uniform(-1, 1, (2, 3, 8, 8)))
+        out = mx.nd.Convolution(data=data, weight=weight, bias=bias, kernel=(3, 3),
+                                num_filter=4)
+        exe = sym.bind(mx.cpu(), args={'data': data, 'conv_weight': weight,
+                                       'conv_bias': bias})
+        exe.forward(is_train=False)
+        assert_almost_equal(out.asnumpy(), exe.outputs[0].asnumpy(), rtol=1e-4, atol=1e-5)
+    for _ in range(3):
+        data = mx.nd.array(np.random.uniform(-1, 1, (2, 3, 8, 8)))
+        out = mx.nd.Pooling(data=data, kernel=(2, 2), stride=(2, 2), pool_type='max')
+        expected = data.asnumpy().reshape(2, 3, 4, 2, 4, 2).max(axis=(3, 5))
+        assert_almost_equal(out.asnumpy(), expected)
+
 
 if __name__ == '__main__':
     import nose
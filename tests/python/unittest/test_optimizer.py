@@ -205,8 +205,8 @@ def test_sgd():
                             compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, dtype)
                             # test operator fallback on cpu
                             if (default_context() == mx.cpu()):
-                                compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, dtype,
-                                                  g_stype='row_sparse')
+                                compare_optimizer(opt1(**kwarg), opt2(lazy_update=False, **kwarg),
+                                                  shape, dtype, g_stype='row_sparse')
                                 if dtype != np.float16:
                                     compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape[:2],
                                                       dtype, w_stype='csr', g_stype='csr')
@@ -306,6 +306,9 @@ def test_sparse_sgd():
                                               w_stype='row_sparse', g_stype='row_sparse')
                             compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, dtype,
                                               w_stype='row_sparse', g_stype='default')
+                            # lazy update of a dense weight
+                            compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, dtype,
+                                              g_stype='row_sparse')
 
 # ADAM
 
@@ -396,6 +399,10 @@ def test_adam():
         compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, np.float32)
         compare_optimizer(opt1(sparse_update=True, **kwarg), opt2(**kwarg), shape,
                           np.float32, w_stype='row_sparse', g_stype='row_sparse')
+        compare_optimizer(opt1(sparse_update=True, **kwarg), opt2(**kwarg), shape,
+                          np.float32, g_stype='row_sparse')
+        compare_optimizer(opt1(**kwarg), opt2(lazy_update=False, **kwarg), shape,
+                          np.float32, g_stype='row_sparse')
 
 # RMSProp
 class PyRMSProp(mx.optimizer.Optimizer):
@@ -538,6 +545,288 @@ def test_rms():
         compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, np.float32)
         compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, np.float32, g_stype='row_sparse')
 
+def test_multi_all_finite():
+    a = mx.nd.ones((3, 4))
+    b = mx.nd.zeros((5,), dtype=np.float16)
+    assert mx.nd.multi_all_finite(a, b, num_arrays=2).asscalar() == 1
+    for bad in [np.inf, -np.inf, np.nan]:
+        c = mx.nd.array([1, bad, 2])
+        assert mx.nd.multi_all_finite(a, c, num_arrays=2).asscalar() == 0
+    # the arrays are only checked against the output without init_output
+    out = mx.nd.zeros((1,))
+    mx.nd.multi_all_finite(a, num_arrays=1, init_output=False, out=out)
+    assert out.asscalar() == 0
+
+
+def test_dynamic_loss_scaler():
+    scaler = mx.optimizer.DynamicLossScaler(init_scale=8., scale_factor=2., scale_window=2)
+    grads = [mx.nd.ones((2, 2)), mx.nd.array([1, np.inf])]
+    assert scaler.has_overflow(grads)
+    scaler.update_scale(True)
+    assert scaler.loss_scale == 4.
+    assert not scaler.has_overflow(grads[:1])
+    scaler.update_scale(False)
+    assert scaler.loss_scale == 4.
+    scaler.update_scale(False)
+    assert scaler.loss_scale == 8.
+
+
+def test_multi_precision_master_copy():
+    # a float16 weight with multi_precision follows the float32 update of its master copy
+    shape = (3, 4, 5)
+    for opt_type, kwarg in [(mx.optimizer.Adam, {'rescale_grad': 0.5}),
+                            (mx.optimizer.RMSProp, {'clip_gradient': 0.4})]:
+        opt16 = opt_type(multi_precision=True, **kwarg)
+        opt32 = opt_type(**kwarg)
+        w32 = mx.random.uniform(shape=shape)
+        w16 = w32.astype(np.float16)
+        w32 = w16.astype(np.float32)
+        state16 = opt16.create_state_multi_precision(0, w16)
+        state32 = opt32.create_state_multi_precision(0, w32)
+        for _ in range(3):
+            g32 = mx.random.uniform(shape=shape)
+            g16 = g32.astype(np.float16)
+            opt16.update_multi_precision(0, w16, g16, state16)
+            opt32.update_multi_precision(0, w32, g16.astype(np.float32), state32)
+        assert w16.dtype == np.float16
+        assert_almost_equal(state16[0].asnumpy(), w32.asnumpy(), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(w16.asnumpy(), w32.asnumpy(), rtol=1e-3, atol=1e-3)
+
+
+def test_multi_sgd_update():
+    shapes = [(3, 4), (7,), (2, 3, 5), (1,)]
+    lrs = [0.1, 0.2, 0.05, 0.3]
+    wds = [0.01, 0.0, 0.02, 0.03]
+    kwargs = {'rescale_grad': 0.5, 'clip_gradient': 0.8}
+    for momentum in [0.0, 0.9]:
+        weights = [mx.random.uniform(shape=s) for s in shapes]
+        grads = [mx.random.uniform(-2, 2, shape=s) for s in shapes]
+        moms = [mx.random.uniform(shape=s) for s in shapes]
+        expected_w = [w.copy() for w in weights]
+        expected_m = [m.copy() for m in moms]
+        for w, g, m, lr, wd in zip(expected_w, grads, expected_m, lrs, wds):
+            if momentum > 0:
+                mx.nd.sgd_mom_update(w, g, m, out=w, lr=lr, wd=wd, momentum=momentum, **kwargs)
+            else:
+                mx.nd.sgd_update(w, g, out=w, lr=lr, wd=wd, **kwargs)
+        inputs = []
+        for w, g, m in zip(weights, grads, moms):
+            inputs += [w, g] + ([m] if momentum > 0 else [])
+        if momentum > 0:
+            mx.nd.multi_sgd_mom_update(*inputs, out=weights, num_weights=len(shapes), lrs=lrs,
+                                       wds=wds, momentum=momentum, **kwargs)
+        else:
+            mx.nd.multi_sgd_update(*inputs, out=weights, num_weights=len(shapes), lrs=lrs,
+                                   wds=wds, **kwargs)
+        for w, e in zip(weights, expected_w):
+            assert_almost_equal(w.asnumpy(), e.asnumpy(), rtol=1e-5, atol=1e-6)
+        if momentum > 0:
+            for m, e in zip(moms, expected_m):
+                assert_almost_equal(m.asnumpy(), e.asnumpy(), rtol=1e-5, atol=1e-6)
+
+
+def test_sgd_aggregated_updater():
+    # the updates of the weights given as lists match the separate updates
+    shapes = [(3, 4), (7,), (2, 3, 5), (1,), (6, 2)]
+    for kwarg in [{'momentum': 0.9}, {}, {'momentum': 0.9, 'multi_precision': True}]:
+        dtype = np.float16 if kwarg.get('multi_precision') else np.float32
+        updater1 = mx.optimizer.get_updater(mx.optimizer.SGD(learning_rate=0.1, wd=0.01, **kwarg))
+        opt2 = mx.optimizer.SGD(learning_rate=0.1, wd=0.01, **kwarg)
+        opt2.aggregate_num = 0
+        updater2 = mx.optimizer.get_updater(opt2)
+        weights1 = [mx.random.uniform(shape=s).astype(dtype) for s in shapes]
+        weights2 = [w.copy() for w in weights1]
+        for _ in range(2):
+            grads = [mx.random.uniform(shape=s).astype(dtype) for s in shapes]
+            updater1(list(range(len(shapes))), grads, weights1)
+            for i, (g, w) in enumerate(zip(grads, weights2)):
+                updater2(i, g, w)
+        for w1, w2 in zip(weights1, weights2):
+            assert_almost_equal(w1.asnumpy(), w2.asnumpy(), rtol=1e-3, atol=1e-4)
+
+
+# LARS and LAMB
+class PyLARS(mx.optimizer.Optimizer):
+    """python reference implementation of LARS"""
+    def __init__(self, momentum=0.9, eta=0.001, epsilon=1e-9, **kwargs):
+        super(PyLARS, self).__init__(**kwargs)
+        self.momentum = momentum
+        self.eta = eta
+        self.epsilon = epsilon
+
+    def create_state(self, index, weight):
+        return mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype)
+
+    def update(self, index, weight, grad, state):
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+        grad = grad * self.rescale_grad
+        if self.clip_gradient is not None:
+            grad = mx.nd.clip(grad, -self.clip_gradient, self.clip_gradient)
+        w_norm = mx.nd.norm(weight).asscalar()
+        g_norm = mx.nd.norm(grad).asscalar()
+        ratio = 1.0
+        if w_norm > 0 and g_norm > 0:
+            ratio = self.eta * w_norm / (g_norm + wd * w_norm + self.epsilon)
+        state[:] = self.momentum * state + lr * ratio * (grad + wd * weight)
+        weight[:] -= state
+
+
+class PyLAMB(mx.optimizer.Optimizer):
+    """python reference implementation of LAMB"""
+    def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-6,
+                 lower_bound=None, upper_bound=None, bias_correction=True, **kwargs):
+        super(PyLAMB, self).__init__(learning_rate=learning_rate, **kwargs)
+        self.beta1 = beta1
+        self.beta2 = beta2
+        self.epsilon = epsilon
+        self.lower_bound = lower_bound
+        self.upper_bound = upper_bound
+        self.bias_correction = bias_correction
+
+    def create_state(self, index, weight):
+        return (mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype),
+                mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype))
+
+    def update(self, index, weight, grad, state):
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+        t = self._index_update_count[index]
+        mean, var = state
+        grad = grad * self.rescale_grad
+        if self.clip_gradient is not None:
+            grad = mx.nd.clip(grad, -self.clip_gradient, self.clip_gradient)
+        mean[:] = self.beta1 * mean + (1. - self.beta1) * grad
+        var[:] = self.beta2 * var + (1. - self.beta2) * mx.nd.square(grad)
+        mean_hat, var_hat = mean, var
+        if self.bias_correction:
+            mean_hat = mean / (1. - self.beta1 ** t)
+            var_hat = var / (1. - self.beta2 ** t)
+        r = mean_hat / (mx.nd.sqrt(var_hat) + self.epsilon) + wd * weight
+        w_norm = mx.nd.norm(weight).asscalar()
+        if self.lower_bound is not None:
+            w_norm = max(w_norm, self.lower_bound)
+        if self.upper_bound is not None:
+            w_norm = min(w_norm, self.upper_bound)
+        r_norm = mx.nd.norm(r).asscalar()
+        ratio = w_norm / r_norm if w_norm > 0 and r_norm > 0 else 1.0
+        weight[:] -= lr * ratio * r
+
+
+def test_lars():
+    mx.random.seed(0)
+    # the large shape spreads the norms over several chunks
+    for shape in [(3, 4, 5), (64, 1000)]:
+        kwargs = [{},
+                  {'clip_gradient': 0.5, 'wd': 0.01},
+                  {'rescale_grad': 0.1, 'momentum': 0.5, 'eta': 0.01, 'wd': 0.001}]
+        for kwarg in kwargs:
+            compare_optimizer(PyLARS(**kwarg), mx.optimizer.LARS(**kwarg), shape, np.float32)
+
+
+def test_lamb():
+    mx.random.seed(0)
+    for shape in [(3, 4, 5), (64, 1000)]:
+        kwargs = [{},
+                  {'clip_gradient': 0.5, 'wd': 0.01},
+                  {'rescale_grad': 0.1, 'bias_correction': False},
+                  {'wd': 0.01, 'lower_bound': 0.5, 'upper_bound': 2.0}]
+        for kwarg in kwargs:
+            compare_optimizer(PyLAMB(**kwarg), mx.optimizer.LAMB(**kwarg), shape, np.float32)
+
+
+# FTRL and AdaGrad
+class PyFtrl(mx.optimizer.Optimizer):
+    """python reference implementation of ftrl"""
+    def __init__(self, lamda1=0.01, learning_rate=0.1, beta=1, sparse_update=False, **kwargs):
+        super(PyFtrl, self).__init__(**kwargs)
+        self.lamda1 = lamda1
+        self.beta = beta
+        self.lr = learning_rate
+        self.sparse_update = sparse_update
+
+    def create_state(self, index, weight):
+        return (mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype),  # z
+                mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype))  # n
+
+    def update(self, index, weight, grad, state):
+        self._update_count(index)
+        wd = self._get_wd(index)
+        lr = self._get_lr(index)
+        z, n = state
+        for row in range(weight.shape[0]):
+            all_zeros = mx.test_utils.almost_equal(grad[row].asnumpy(), np.zeros_like(grad[row].asnumpy()))
+            if all_zeros and self.sparse_update:
+                continue
+            g = grad[row] * self.rescale_grad
+            if self.clip_gradient is not None:
+                g = mx.nd.clip(g, -self.clip_gradient, self.clip_gradient)
+            z[row] += g - (mx.nd.sqrt(n[row] + g * g) - mx.nd.sqrt(n[row])) * weight[row] / lr
+            n[row] += g * g
+            weight[row] = (mx.nd.sign(z[row]) * self.lamda1 - z[row]) / \
+                          ((self.beta + mx.nd.sqrt(n[row])) / lr + wd) * (mx.nd.abs(z[row]) > self.lamda1)
+
+
+class PyAdaGrad(mx.optimizer.Optimizer):
+    """python reference implementation of adagrad"""
+    def __init__(self, eps=1e-7, sparse_update=False, **kwargs):
+        super(PyAdaGrad, self).__init__(**kwargs)
+        self.float_stable_eps = eps
+        self.sparse_update = sparse_update
+
+    def create_state(self, index, weight):
+        return mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype)
+
+    def update(self, index, weight, grad, state):
+        self._update_count(index)
+        wd = self._get_wd(index)
+        lr = self._get_lr(index)
+        for row in range(weight.shape[0]):
+            all_zeros = mx.test_utils.almost_equal(grad[row].asnumpy(), np.zeros_like(grad[row].asnumpy()))
+            if all_zeros and self.sparse_update:
+                continue
+            g = grad[row] * self.rescale_grad
+            if self.clip_gradient is not None:
+                g = mx.nd.clip(g, -self.clip_gradient, self.clip_gradient)
+            state[row] += g * g
+            weight[row] -= lr * (g / mx.nd.sqrt(state[row] + self.float_stable_eps) + wd * weight[row])
+
+
+def test_ftrl():
+    mx.random.seed(0)
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14},
+              {'rescale_grad': 0.8, 'lamda1': 0.02, 'beta': 0.5},
+              {'clip_gradient': 0.5, 'wd': 0.07},
+              {'rescale_grad': 0.8, 'wd': 0.05, 'learning_rate': 0.05}]
+    for kwarg in kwargs:
+        compare_optimizer(PyFtrl(**kwarg), mx.optimizer.Ftrl(**kwarg), shape, np.float32)
+        compare_optimizer(PyFtrl(sparse_update=True, **kwarg), mx.optimizer.Ftrl(**kwarg),
+                          shape, np.float32, w_stype='row_sparse', g_stype='row_sparse')
+        compare_optimizer(PyFtrl(sparse_update=True, **kwarg), mx.optimizer.Ftrl(**kwarg),
+                          shape, np.float32, g_stype='row_sparse')
+
+
+def test_adagrad():
+    mx.random.seed(0)
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14, 'eps': 1e-6},
+              {'clip_gradient': 0.5, 'wd': 0.07},
+              {'rescale_grad': 0.8, 'wd': 0.05, 'learning_rate': 0.05}]
+    for kwarg in kwargs:
+        compare_optimizer(PyAdaGrad(**kwarg), mx.optimizer.AdaGrad(**kwarg), shape, np.float32)
+        compare_optimizer(PyAdaGrad(sparse_update=True, **kwarg), mx.optimizer.AdaGrad(**kwarg),
+                          shape, np.float32, w_stype='row_sparse', g_stype='row_sparse')
+        compare_optimizer(PyAdaGrad(sparse_update=True, **kwarg), mx.optimizer.AdaGrad(**kwarg),
+                          shape, np.float32, g_stype='row_sparse')
+
+
 if __name__ == '__main__':
     test_adam()
     test_rms()
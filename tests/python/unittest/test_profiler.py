@@ -18,6 +18,7 @@
 from __future__ import print_function
 import mxnet as mx
 from mxnet import profiler
+import json
 import time
 import numpy as np
 
@@ -60,5 +61,84 @@ def test_profiler():
     print('duration: {0}s'.format(duration))
     print('          {0}ms/operator'.format(duration*1000/iter_num))
 
+def test_storage_stats():
+    ctx = mx.cpu(2)
+    before = profiler.storage_stats(ctx)
+    a = mx.nd.ones((256, 256), ctx=ctx)
+    a.wait_to_read()
+    stats = profiler.storage_stats(ctx)
+    assert stats['num_alloc'] == before['num_alloc'] + 1
+    assert stats['bytes_in_use'] == before['bytes_in_use'] + 256 * 256 * 4
+    assert stats['peak_bytes_in_use'] >= stats['bytes_in_use']
+    del a
+    mx.nd.waitall()
+    stats = profiler.storage_stats(ctx)
+    assert stats['num_free'] == before['num_free'] + 1
+    assert stats['bytes_in_use'] == before['bytes_in_use']
+
+def test_profile_incremental():
+    profile_filename = "test_profile_incremental.json"
+    profiler.profiler_set_config(mode='all', filename=profile_filename)
+    profiler.profiler_set_state('run')
+    a = mx.nd.ones((64, 64))
+    b = mx.nd.dot(a, a)
+    b.wait_to_read()
+    profiler.dump_profile(finished=False)
+    # the trace is an unterminated json array until the profile is finished
+    with open(profile_filename) as f:
+        events = json.loads(f.read() + ']')
+    assert any(e['ph'] == 'B' and e['name'] == 'dot' for e in events)
+    c = b + 1
+    c.wait_to_read()
+    profiler.dump_profile()
+    with open(profile_filename) as f:
+        events = json.load(f)
+    assert any(e['ph'] == 'B' and e['name'] == 'dot' for e in events)
+    assert any(e['ph'] == 'B' and e['name'] == '_plus_scalar' for e in events)
+    # the addition waited for the result of dot
+    assert any(e['ph'] == 'f' for e in events)
+    assert any(e['ph'] == 'C' for e in events)
+
+def test_aggregate_stats():
+    profiler.profiler_set_config(mode='all', filename='test_profile_aggregate.json')
+    profiler.profiler_set_state('run')
+    profiler.dumps(reset=True)
+    a = mx.nd.ones((64, 64))
+    for _ in range(5):
+        a = mx.nd.dot(a, a)
+    a.wait_to_read()
+    profiler.profiler_set_state('stop')
+    stats = profiler.dumps(reset=True)
+    rows = [line.split() for line in stats.splitlines()]
+    dot = [row for row in rows if row and row[0] == 'dot']
+    assert len(dot) == 1
+    count, total, min_time, max_time = [int(x) for x in dot[0][1:5]]
+    assert count == 5
+    assert min_time <= max_time <= total
+    assert 'dot' not in profiler.dumps()
+
+def test_dependency_wait():
+    profile_filename = "test_profile_wait.json"
+    profiler.profiler_set_config(mode='all', filename=profile_filename)
+    profiler.profiler_set_state('run')
+    a = mx.nd.ones((256, 256))
+    for _ in range(3):
+        a = mx.nd.dot(a, a)
+    a.wait_to_read()
+    profiler.dump_profile()
+    with open(profile_filename) as f:
+        events = json.load(f)
+    dots = [e for e in events if e['ph'] == 'B' and e['name'] == 'dot']
+    assert len(dots) == 3
+    for e in dots:
+        assert e['args']['dependency_wait_us'] >= 0
+        assert e['args']['worker_wait_us'] >= 0
+    # every dot but the first waited for the previous one
+    assert sum(e['args']['dependency_wait_us'] for e in dots[1:]) > 0
+
 if __name__ == '__main__':
     test_profiler()
+    test_storage_stats()
+    test_profile_incremental()
+    test_aggregate_stats()
+    test_dependency_wait()
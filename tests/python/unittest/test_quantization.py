@@ -0,0 +1,223 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import json
+import mxnet as mx
+import numpy as np
+from mxnet.test_utils import assert_almost_equal
+
+
+def test_quantize_int8():
+    data = mx.nd.array(np.random.uniform(-3, 2, size=(4, 5)))
+    qdata, qmin, qmax = mx.nd.contrib.quantize(data, mx.nd.min(data), mx.nd.max(data),
+                                               out_type='int8')
+    r = np.abs(data.asnumpy()).max()
+    assert qdata.dtype == np.int8
+    assert_almost_equal(qmin.asnumpy(), [-r])
+    assert_almost_equal(qmax.asnumpy(), [r])
+    back = mx.nd.contrib.dequantize(qdata, qmin, qmax, out_type='float32')
+    assert_almost_equal(back.asnumpy(), data.asnumpy(), atol=r / 127)
+
+
+def int8_array(shape):
+    return np.random.randint(-127, 128, size=shape).astype(np.int8)
+
+
+def full_range():
+    return mx.nd.array([-127]), mx.nd.array([127])
+
+
+def test_quantized_conv():
+    # with the ranges of int8 values, the real values are the int8 values themselves
+    def check(no_bias, num_group):
+        data = int8_array((2, 4, 7, 6))
+        weight = int8_array((6, 4 // num_group, 3, 3))
+        bias = int8_array((6,))
+        lo, hi = full_range()
+        kwargs = dict(kernel=(3, 3), num_filter=6, num_group=num_group, stride=(2, 1),
+                      pad=(1, 1), no_bias=no_bias)
+        inputs = [mx.nd.array(data, dtype=np.int8), mx.nd.array(weight, dtype=np.int8)]
+        ranges = [lo, hi, lo, hi]
+        if not no_bias:
+            inputs.append(mx.nd.array(bias, dtype=np.int8))
+            ranges += [lo, hi]
+        out, omin, omax = mx.nd.contrib.quantized_conv(*(inputs + ranges), **kwargs)
+        assert out.dtype == np.int32
+        expected = mx.nd.Convolution(mx.nd.array(data), mx.nd.array(weight),
+                                     None if no_bias else mx.nd.array(bias), **kwargs)
+        assert_almost_equal(out.asnumpy(), expected.asnumpy())
+        assert_almost_equal(omax.asnumpy(), [2147483647.0])
+        assert_almost_equal(omin.asnumpy(), [-2147483647.0])
+
+    for no_bias in [True, False]:
+        for num_group in [1, 2]:
+            check(no_bias, num_group)
+
+
+def test_quantized_fully_connected():
+    def check(no_bias):
+        data = int8_array((3, 2, 5))
+        weight = int8_array((7, 10))
+        bias = int8_array((7,))
+        lo, hi = full_range()
+        inputs = [mx.nd.array(data, dtype=np.int8), mx.nd.array(weight, dtype=np.int8)]
+        ranges = [lo, hi, lo, hi]
+        if not no_bias:
+            inputs.append(mx.nd.array(bias, dtype=np.int8))
+            ranges += [lo, hi]
+        out, _, _ = mx.nd.contrib.quantized_fully_connected(*(inputs + ranges), num_hidden=7,
+                                                            no_bias=no_bias)
+        expected = np.dot(data.reshape(3, 10).astype(np.float64), weight.T.astype(np.float64))
+        if not no_bias:
+            expected += bias
+        assert_almost_equal(out.asnumpy(), expected)
+
+    check(True)
+    check(False)
+
+
+def test_quantized_pooling():
+    data = int8_array((2, 3, 7, 8))
+    lo, hi = mx.nd.array([-2.0]), mx.nd.array([2.0])
+    for pool_type in ['max', 'avg']:
+        for global_pool in [False, True]:
+            kwargs = dict(kernel=(3, 3), stride=(2, 2), pad=(1, 1), pool_type=pool_type,
+                          global_pool=global_pool)
+            out, omin, omax = mx.nd.contrib.quantized_pooling(
+                mx.nd.array(data, dtype=np.int8), lo, hi, **kwargs)
+            expected = mx.nd.Pooling(mx.nd.array(data), **kwargs).asnumpy()
+            assert out.dtype == np.int8
+            if pool_type == 'max':
+                assert_almost_equal(out.asnumpy(), expected)
+            else:
+                assert np.abs(out.asnumpy() - expected).max() <= 0.5 + 1e-4
+            assert_almost_equal(omin.asnumpy(), [-2.0])
+            assert_almost_equal(omax.asnumpy(), [2.0])
+
+
+def test_quantized_act():
+    data = int8_array((3, 4))
+    lo, hi = full_range()
+    out, _, _ = mx.nd.contrib.quantized_act(mx.nd.array(data, dtype=np.int8), lo, hi,
+                                            act_type='relu')
+    assert_almost_equal(out.asnumpy(), np.maximum(data, 0))
+
+
+def test_requantize():
+    data = np.random.randint(-1000000, 1000000, size=(4, 6)).astype(np.int32)
+    lo, hi = mx.nd.array([-8.0]), mx.nd.array([8.0])
+    real = data.astype(np.float64) * 8.0 / 2147483647.0
+    # range of the values
+    out, omin, omax = mx.nd.contrib.requantize(mx.nd.array(data, dtype=np.int32), lo, hi)
+    r = np.abs(real).max()
+    assert out.dtype == np.int8
+    assert_almost_equal(omax.asnumpy(), [r], rtol=1e-4)
+    assert np.abs(out.asnumpy() - real * 127 / r).max() <= 0.5 + 1e-3
+    # calibrated range, the values out of it are clipped
+    out, omin, omax = mx.nd.contrib.requantize(mx.nd.array(data, dtype=np.int32), lo, hi,
+                                               min_calib_range=-r / 2, max_calib_range=r / 2)
+    assert_almost_equal(omax.asnumpy(), [r / 2], rtol=1e-4)
+    expected = np.clip(real * 254 / r, -127, 127)
+    assert np.abs(out.asnumpy() - expected).max() <= 0.5 + 1e-3
+
+
+def test_quantize_model():
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data, kernel=(3, 3), num_filter=8, pad=(1, 1), name='conv0')
+    act = mx.sym.Activation(conv, act_type='relu', name='relu0')
+    pool = mx.sym.Pooling(act, kernel=(2, 2), stride=(2, 2), pool_type='max', name='pool0')
+    fc = mx.sym.FullyConnected(pool, num_hidden=5, name='fc0')
+    sym = mx.sym.SoftmaxOutput(fc, name='softmax')
+    shape = (2, 3, 8, 8)
+    arg_shapes, _, _ = sym.infer_shape(data=shape)
+    arg_params = {name: mx.nd.array(np.random.uniform(-1, 1, size=s))
+                  for name, s in zip(sym.list_arguments(), arg_shapes)
+                  if name not in ['data', 'softmax_label']}
+    qsym, qarg_params, _ = mx.contrib.quantization.quantize_model(sym, arg_params, {})
+    ops = [node["op"] for node in json.loads(qsym.tojson())['nodes']]
+    for op in ['_contrib_quantized_conv', '_contrib_quantized_act',
+               '_contrib_quantized_pooling', '_contrib_quantized_fully_connected',
+               '_contrib_requantize', '_contrib_dequantize']:
+        assert op in ops
+    assert 'conv0_weight_quantize' in qarg_params
+    assert qarg_params['conv0_weight_quantize'].dtype == np.int8
+
+    x = mx.nd.array(np.random.uniform(-1, 1, size=shape))
+    def forward(s, params):
+        args = dict(params)
+        args['data'] = x
+        args['softmax_label'] = mx.nd.zeros((2,))
+        exe = s.bind(mx.cpu(), args)
+        exe.forward(is_train=False)
+        return exe.outputs[0].asnumpy()
+    float_out = forward(sym, arg_params)
+    int8_out = forward(qsym, qarg_params)
+    assert_almost_equal(int8_out, float_out, atol=0.05)
+
+
+def test_quantize_model_calibration():
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data, kernel=(3, 3), num_filter=8, pad=(1, 1), name='conv0')
+    act = mx.sym.Activation(conv, act_type='relu', name='relu0')
+    fc = mx.sym.FullyConnected(act, num_hidden=5, name='fc0')
+    sym = mx.sym.SoftmaxOutput(fc, name='softmax')
+    shape = (4, 3, 6, 6)
+    arg_shapes, _, _ = sym.infer_shape(data=shape)
+    arg_params = {name: mx.nd.array(np.random.uniform(-1, 1, size=s))
+                  for name, s in zip(sym.list_arguments(), arg_shapes)
+                  if name not in ['data', 'softmax_label']}
+    x = np.random.uniform(-1, 1, size=(16,) + shape[1:])
+    calib_data = mx.io.NDArrayIter(data=x, label=np.zeros((16,)), batch_size=4)
+    for calib_mode in ['naive', 'entropy']:
+        qsym, qarg_params, _ = mx.contrib.quantization.quantize_model(
+            sym, arg_params, {}, calib_mode=calib_mode, calib_data=calib_data)
+        nodes = json.loads(qsym.tojson())['nodes']
+        requantize = [node for node in nodes if node['op'] == '_contrib_requantize']
+        assert len(requantize) == 2
+        for node in requantize:
+            attrs = node.get('attrs', node.get('attr'))
+            assert float(attrs['max_calib_range']) > 0
+            assert float(attrs['min_calib_range']) < 0
+        args = dict(qarg_params)
+        args['data'] = mx.nd.array(x[:4])
+        args['softmax_label'] = mx.nd.zeros((4,))
+        exe = qsym.bind(mx.cpu(), args)
+        exe.forward(is_train=False)
+        float_args = dict(arg_params)
+        float_args['data'] = args['data']
+        float_args['softmax_label'] = args['softmax_label']
+        float_exe = sym.bind(mx.cpu(), float_args)
+        float_exe.forward(is_train=False)
+        assert_almost_equal(exe.outputs[0].asnumpy(), float_exe.outputs[0].asnumpy(), atol=0.05)
+
+
+def test_optimal_threshold():
+    # the outliers of a long tail are clipped
+    values = np.abs(np.concatenate([np.random.normal(size=100000), [50.0]]))
+    hist, _ = np.histogram(values, bins=2048, range=(0, 50.0))
+    th = mx.contrib.quantization._get_optimal_threshold(hist, 50.0 / 2048)
+    assert 1.0 < th < 25.0
+    # a uniform distribution is kept whole
+    hist = np.ones(2048)
+    th = mx.contrib.quantization._get_optimal_threshold(hist, 1.0)
+    assert th > 2000
+
+
+if __name__ == '__main__':
+    import nose
+    nose.runmodule()
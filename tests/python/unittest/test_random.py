@@ -50,70 +50,69 @@ def check_with_device(device, dtype):
             ]
         }
     ]
-    if device.device_type == 'cpu':
-        symbols.extend([
-            {
-                'name': 'gamma',
-                'symbol': mx.sym.random.gamma,
-                'multisymbol': mx.sym.sample_gamma,
-                'ndop': mx.random.gamma,
-                'params': { 'alpha': 9.0, 'beta': 0.5 },
-                'inputs': [ ('alpha', [ [ 0.0, 2.5 ], [ 9.75, 11.0 ] ]) , ('beta', [ [ 1.0, 0.7 ], [ 0.5, 0.3 ] ]) ],
-                'checks': [
-                    ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['alpha'] * params['beta'], tol),
-                    ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['alpha'] * params['beta'] ** 2), tol)
-                ]
-            },
-            {
-                'name': 'exponential',
-                'symbol': mx.sym.random.exponential,
-                'multisymbol': mx.sym.sample_exponential,
-                'ndop': mx.random.exponential,
-                'params': { 'lam': 4.0 },
-                'inputs': [ ('lam', [ [ 1.0, 8.5 ], [ 2.7 , 0.5 ] ]) ],
-                'checks': [
-                    ('mean', lambda x, params: np.mean(x.astype(np.float64)) - 1.0 / params['lam'], tol),
-                    ('std', lambda x, params: np.std(x.astype(np.float64)) - 1.0 / params['lam'], tol)
-                ]
-            },
-            {
-                'name': 'poisson',
-                'symbol': mx.sym.random.poisson,
-                'ndop': mx.random.poisson,
-                'multisymbol': mx.sym.sample_poisson,
-                'params': { 'lam': 4.0 },
-                'inputs': [ ('lam', [ [ 1.0, 8.5 ], [ 2.7 , 0.5 ] ]) ],
-                'checks': [
-                    ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['lam'], tol),
-                    ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['lam']), tol)
-                ]
-            },
-            {
-                'name': 'neg-binomial',
-                'symbol': mx.sym.random.negative_binomial,
-                'multisymbol': mx.sym.sample_negative_binomial,
-                'ndop': mx.random.negative_binomial,
-                'params': { 'k': 3, 'p': 0.4 },
-                'inputs': [ ('k', [ [ 20, 49 ], [ 15 , 16 ] ]) , ('p', [ [ 0.4 , 0.77 ], [ 0.5, 0.84 ] ]) ],
-                'checks': [
-                    ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['k'] * (1.0 - params['p']) /  params['p'], tol),
-                    ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['k'] * (1.0 - params['p']))/params['p'], tol)
-                ]
-            },
-            {
-                'name': 'gen-neg-binomial',
-                'symbol': mx.sym.random.generalized_negative_binomial,
-                'multisymbol': mx.sym.sample_generalized_negative_binomial,
-                'ndop': mx.random.generalized_negative_binomial,
-                'params': { 'mu': 2.0, 'alpha': 0.3 },
-                'inputs': [ ('mu', [ [ 2.0, 2.5 ], [ 1.3, 1.9 ] ]) , ('alpha', [ [ 1.0, 0.1 ], [ 0.2, 0.5 ] ]) ],
-                'checks': [
-                    ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['mu'], tol),
-                    ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['mu'] + params['alpha'] * params['mu'] ** 2 ), tol)
-                ]
-            }
-
-        ])
+    symbols.extend([
+        {
+            'name': 'gamma',
+            'symbol': mx.sym.random.gamma,
+            'multisymbol': mx.sym.sample_gamma,
+            'ndop': mx.random.gamma,
+            'params': { 'alpha': 9.0, 'beta': 0.5 },
+            'inputs': [ ('alpha', [ [ 0.0, 2.5 ], [ 9.75, 11.0 ] ]) , ('beta', [ [ 1.0, 0.7 ], [ 0.5, 0.3 ] ]) ],
+            'checks': [
+                ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['alpha'] * params['beta'], tol),
+                ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['alpha'] * params['beta'] ** 2), tol)
+            ]
+        },
+        {
+            'name': 'exponential',
+            'symbol': mx.sym.random.exponential,
+            'multisymbol': mx.sym.sample_exponential,
+            'ndop': mx.random.exponential,
+            'params': { 'lam': 4.0 },
+            'inputs': [ ('lam', [ [ 1.0, 8.5 ], [ 2.7 , 0.5 ] ]) ],
+            'checks': [
+                ('mean', lambda x, params: np.mean(x.astype(np.float64)) - 1.0 / params['lam'], tol),
+                ('std', lambda x, params: np.std(x.astype(np.float64)) - 1.0 / params['lam'], tol)
+            ]
+        },
+        {
+            'name': 'poisson',
+            'symbol': mx.sym.random.poisson,
+            'ndop': mx.random.poisson,
+            'multisymbol': mx.sym.sample_poisson,
+            'params': { 'lam': 4.0 },
+            'inputs': [ ('lam', [ [ 1.0, 8.5 ], [ 2.7 , 0.5 ] ]) ],
+            'checks': [
+                ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['lam'], tol),
+                ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['lam']), tol)
+            ]
+        },
+        {
+            'name': 'neg-binomial',
+            'symbol': mx.sym.random.negative_binomial,
+            'multisymbol': mx.sym.sample_negative_binomial,
+            'ndop': mx.random.negative_binomial,
+            'params': { 'k': 3, 'p': 0.4 },
+            'inputs': [ ('k', [ [ 20, 49 ], [ 15 , 16 ] ]) , ('p', [ [ 0.4 , 0.77 ], [ 0.5, 0.84 ] ]) ],
+            'checks': [
+                ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['k'] * (1.0 - params['p']) /  params['p'], tol),
+                ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['k'] * (1.0 - params['p']))/params['p'], tol)
+            ]
+        },
+        {
+            'name': 'gen-neg-binomial',
+            'symbol': mx.sym.random.generalized_negative_binomial,
+            'multisymbol': mx.sym.sample_generalized_negative_binomial,
+            'ndop': mx.random.generalized_negative_binomial,
+            'params': { 'mu': 2.0, 'alpha': 0.3 },
+            'inputs': [ ('mu', [ [ 2.0, 2.5 ], [ 1.3, 1.9 ] ]) , ('alpha', [ [ 1.0, 0.1 ], [ 0.2, 0.5 ] ]) ],
+            'checks': [
+                ('mean', lambda x, params: np.mean(x.astype(np.float64)) - params['mu'], tol),
+                ('std', lambda x, params: np.std(x.astype(np.float64)) - np.sqrt(params['mu'] + params['alpha'] * params['mu'] ** 2 ), tol)
+            ]
+        }
+
+    ])
 
     shape = (100, 100)
     for symbdic in symbols:
@@ -157,29 +156,28 @@ def check_with_device(device, dtype):
         for check_name, check_func, tol in symbdic['checks']:
             assert np.abs(check_func(ret1, params)) < tol, "symbolic test: %s check for `%s` did not pass" % (check_name, name)
 
-        # check multi-distribution sampling, only supports cpu for now
-        if device.device_type == 'cpu':
-            symbol = symbdic['multisymbol']
-            params = { 'shape' : shape, 'dtype' : dtype }
-            single_param = len(symbdic['inputs']) == 1;
-            v1 = mx.sym.Variable('v1')
-            v2 = mx.sym.Variable('v2')
-            Y = symbol(v1,**params) if single_param else symbol(v1,v2,**params)
-            bindings = { 'v1' : mx.nd.array(symbdic['inputs'][0][1]) }
-            if not single_param :
-                bindings.update({ 'v2' : mx.nd.array(symbdic['inputs'][1][1]) })
-            yexec = Y.bind(ctx=device, args=bindings)
-            yexec.forward()
-            un1 = yexec.outputs[0].copyto(device).asnumpy()
-            params = {}
-            for i, r in enumerate(symbdic['inputs'][0][1]):
-                for j, p1 in enumerate(r):
-                    params.update({ symbdic['inputs'][0][0] : p1 })
-                    if not single_param:
-                       params.update({ symbdic['inputs'][1][0] : symbdic['inputs'][1][1][i][j] })
-                    samples = un1[i,j]
-                    for check_name, check_func, tol in symbdic['checks']:
-                        assert np.abs(check_func(samples, params)) < tol, "symbolic test: %s check for `%s` did not pass" % (check_name, name)
+        # check multi-distribution sampling
+        symbol = symbdic['multisymbol']
+        params = { 'shape' : shape, 'dtype' : dtype }
+        single_param = len(symbdic['inputs']) == 1;
+        v1 = mx.sym.Variable('v1')
+        v2 = mx.sym.Variable('v2')
+        Y = symbol(v1,**params) if single_param else symbol(v1,v2,**params)
+        bindings = { 'v1' : mx.nd.array(symbdic['inputs'][0][1], ctx=device) }
+        if not single_param :
+            bindings.update({ 'v2' : mx.nd.array(symbdic['inputs'][1][1], ctx=device) })
+        yexec = Y.bind(ctx=device, args=bindings)
+        yexec.forward()
+        un1 = yexec.outputs[0].copyto(device).asnumpy()
+        params = {}
+        for i, r in enumerate(symbdic['inputs'][0][1]):
+            for j, p1 in enumerate(r):
+                params.update({ symbdic['inputs'][0][0] : p1 })
+                if not single_param:
+                   params.update({ symbdic['inputs'][1][0] : symbdic['inputs'][1][1][i][j] })
+                samples = un1[i,j]
+                for check_name, check_func, tol in symbdic['checks']:
+                    assert np.abs(check_func(samples, params)) < tol, "symbolic test: %s check for `%s` did not pass" % (check_name, name)
 
 def test_random():
     check_with_device(mx.context.current_context(), 'float16')
@@ -187,6 +185,32 @@ def test_random():
     check_with_device(mx.context.current_context(), 'float64')
 
 
+def test_parallel_random_streams():
+    # samplers of different branches draw different numbers, reproducible with the seed
+    shape = (50, 50)
+    a = mx.sym.uniform(shape=shape)
+    b = mx.sym.uniform(shape=shape)
+    c = mx.sym.Dropout(mx.sym.ones(shape=shape), p=0.5, mode='always')
+    exe = mx.sym.Group([a, b, c]).bind(mx.context.current_context(), {})
+    mx.random.seed(42)
+    out1 = [o.asnumpy() for o in exe.forward()]
+    mx.random.seed(42)
+    out2 = [o.asnumpy() for o in exe.forward()]
+    for x, y in zip(out1, out2):
+        assert same(x, y)
+    assert not same(out1[0], out1[1])
+    mask = out1[2]
+    assert np.all((mask == 0) | (mask == 2))
+    assert abs(np.mean(mask) - 1) < 0.1
+    mx.random.seed(42)
+    nd1 = mx.nd.normal(shape=shape).asnumpy()
+    nd2 = mx.nd.normal(shape=shape).asnumpy()
+    mx.random.seed(42)
+    nd3 = mx.nd.normal(shape=shape).asnumpy()
+    assert same(nd1, nd3)
+    assert not same(nd1, nd2)
+
+
 def test_sample_multinomial():
     x = mx.nd.array([[0,1,2,3,4],[4,3,2,1,0]])/10.0
     dx = mx.nd.ones_like(x)
@@ -211,6 +235,25 @@ def test_sample_multinomial():
         mx.test_utils.assert_almost_equal(real_dx, dx.asnumpy()[i])
 
 
+def test_sample_multinomial_many_outcomes():
+    # more outcomes than the linear scan handles, sampled by binary search
+    k = 100
+    p = np.arange(k, dtype=np.float32) + 1
+    p[::7] = 0
+    x = mx.nd.array(np.stack([p, p[::-1]]) / p.sum())
+    mx.random.seed(7)
+    y1 = mx.nd.sample_multinomial(x, shape=100000).asnumpy()
+    mx.random.seed(7)
+    y2 = mx.nd.sample_multinomial(x, shape=100000).asnumpy()
+    assert same(y1, y2)
+    x = x.asnumpy()
+    for i in range(x.shape[0]):
+        freq = np.bincount(y1[i], minlength=k) / 100000.0
+        assert np.all(freq[x[i] == 0] == 0)
+        assert np.abs(freq - x[i]).max() < 0.005
+
+
 if __name__ == '__main__':
     test_random()
     test_sample_multinomial()
+    test_sample_multinomial_many_outcomes()
@@ -84,6 +84,55 @@ def test_elemwise_add_ex_multiple_stages():
     exec_test.backward(out_grads=exec_test.outputs)
     assert_almost_equal(arr_grads[0].asnumpy(), arr_grads[1].asnumpy())
 
+def test_sparse_elemwise_binary_ex():
+    def check(op, np_op, lhs_stype, rhs_stype, out_stype, shape):
+        for lhs_density, rhs_density in [(0.5, 0.3), (0., 0.5), (0., 0.)]:
+            lhs = rand_ndarray(shape, lhs_stype, density=lhs_density)
+            rhs = rand_ndarray(shape, rhs_stype, density=rhs_density)
+            if op is mx.nd._internal._div:
+                # keep the divisors away from zero
+                rhs = rhs + 2 if rhs_stype == 'default' else rhs
+            out = op(lhs, rhs)
+            assert out.stype == out_stype, (op, lhs_stype, rhs_stype, out.stype)
+            assert_almost_equal(out.asnumpy(), np_op(lhs.asnumpy(), rhs.asnumpy()))
+
+    add, sub = mx.nd.elemwise_add, mx.nd._internal._sub
+    mul, div = mx.nd._internal._mul, mx.nd._internal._div
+    for shape in [rand_shape_2d(), rand_shape_3d()]:
+        for op, np_op in [(add, np.add), (sub, np.subtract)]:
+            check(op, np_op, 'row_sparse', 'row_sparse', 'row_sparse', shape)
+            check(op, np_op, 'row_sparse', 'default', 'default', shape)
+            check(op, np_op, 'default', 'row_sparse', 'default', shape)
+        check(mul, np.multiply, 'row_sparse', 'row_sparse', 'row_sparse', shape)
+        check(mul, np.multiply, 'row_sparse', 'default', 'row_sparse', shape)
+        check(mul, np.multiply, 'default', 'row_sparse', 'row_sparse', shape)
+        check(div, np.divide, 'row_sparse', 'default', 'row_sparse', shape)
+    shape = rand_shape_2d()
+    for op, np_op in [(add, np.add), (sub, np.subtract), (mul, np.multiply)]:
+        check(op, np_op, 'csr', 'csr', 'csr', shape)
+
+
+def test_sparse_elemwise_unary_ex():
+    def check(fn, np_fn, stype, out_stype):
+        for density in [0.5, 0.]:
+            data = rand_ndarray(rand_shape_2d(), stype, density=density)
+            if stype != 'default' and density > 0.:
+                data = mx.nd.abs(data).tostype(stype)
+            out = fn(data)
+            assert out.stype == out_stype, (stype, out.stype)
+            assert_almost_equal(out.asnumpy(), np_fn(data.asnumpy()))
+
+    for stype in ['row_sparse', 'csr']:
+        check(mx.nd.sqrt, np.sqrt, stype, stype)
+        check(mx.nd.square, np.square, stype, stype)
+        check(lambda x: x * 3, lambda x: x * 3, stype, stype)
+        check(lambda x: x / 4, lambda x: x / 4, stype, stype)
+        check(lambda x: mx.nd.clip(x, -0.5, 0.5), lambda x: np.clip(x, -0.5, 0.5),
+              stype, stype)
+        check(lambda x: mx.nd.clip(x, 0.2, 0.5), lambda x: np.clip(x, 0.2, 0.5),
+              stype, 'default')
+
+
 def test_cast_storage_ex():
     def check_cast_storage(shape, density, from_stype, to_stype, check_numeric_grad=True):
         x = mx.symbol.Variable('x', stype=from_stype)
@@ -158,6 +207,28 @@ def test_sparse_dot():
                                 grad_req={'lhs': 'null', 'rhs': 'write'},
                                 rtol=1e-3, atol=1e-4)
 
+    def test_dot_csr_trans_dns_out(lhs_shape, rhs_shape, lhs_density, rhs_density):
+        # dot(csr.T, rsp) written to a dense output
+        lhs_nd = rand_ndarray(lhs_shape, 'csr', density=lhs_density)
+        rhs_nd = rand_ndarray(rhs_shape, 'row_sparse', density=rhs_density)
+        out = mx.nd.zeros((lhs_shape[1], rhs_shape[1]))
+        mx.nd.dot(lhs_nd, rhs_nd, transpose_a=True, out=out)
+        out_np = np.dot(lhs_nd.asnumpy().T, rhs_nd.asnumpy())
+        assert_almost_equal(out.asnumpy(), out_np, rtol=1e-4, atol=1e-5)
+
+    def test_dot_csr_skewed(num_rows, num_cols, rhs_stype):
+        # a few dense rows hold most of the non-zeros
+        lhs_np = np.random.uniform(size=(num_rows, num_cols))
+        lhs_np[3:] *= np.random.uniform(size=(num_rows - 3, num_cols)) < 0.01
+        lhs_nd = mx.nd.array(lhs_np).tostype('csr')
+        assert_almost_equal(lhs_nd.tostype('default').asnumpy(), lhs_np)
+        rhs_nd = rand_ndarray((num_cols, 8), rhs_stype, density=0.5)
+        out = mx.nd.dot(lhs_nd, rhs_nd)
+        assert_almost_equal(out.asnumpy(), np.dot(lhs_np, rhs_nd.asnumpy()), rtol=1e-4, atol=1e-5)
+
+    test_dot_csr_skewed(200, 300, 'default')
+    test_dot_csr_skewed(200, 300, 'row_sparse')
+
     density = [1.00, 0.50, 0.10, 0.05, 0.01]
     for lhs_d in density:
         lhs_shape = rand_shape_2d(50, 200)
@@ -169,6 +240,7 @@ def test_sparse_dot():
         for rhs_d in density:
             test_dot_csr(lhs_shape, (lhs_shape[1], rnd.randint(1, 10)), 'row_sparse', False, lhs_d, rhs_d)
             test_dot_csr(lhs_shape, (lhs_shape[0], rnd.randint(1, 10)), 'row_sparse', True, lhs_d, rhs_d)
+            test_dot_csr_trans_dns_out(lhs_shape, (lhs_shape[0], rnd.randint(1, 10)), lhs_d, rhs_d)
 
 
 def test_sparse_slice():
@@ -248,8 +320,8 @@ def test_sparse_square_sum():
                 else:
                     assert ret.stype == 'default'
                 ret_expected = mx.nd.sum(dns*dns, axis=axis, keepdims=keepdim)
-                # check forward result
-                assert same(ret.asnumpy(), ret_expected.asnumpy())
+                # check forward result, the gpu kernels sum up in another order
+                assert_almost_equal(ret.asnumpy(), ret_expected.asnumpy())
 
                 rsp_data = mx.sym.Variable('data', stype='row_sparse')
                 test = mx.symbol._internal._square_sum(rsp_data, axis=axis, keepdims=keepdim)
@@ -368,6 +440,121 @@ def test_sparse_elementwise_sum():
         check_sparse_elementwise_sum_with_shape('row_sparse', shape, np.random.randint(1, 9))
 
 
+def test_sparse_embedding():
+    in_dim = 20
+    out_dim = 4
+    batch = 24
+    data = mx.sym.Variable("data")
+    embed = mx.sym.contrib.SparseEmbedding(data=data, input_dim=in_dim, output_dim=out_dim,
+                                           name="embed")
+    grad_req = {'data': 'null', 'embed_weight': 'write'}
+    exe_test = embed.simple_bind(default_context(), grad_req=grad_req, data=(batch,))
+    arg_map = dict(zip(embed.list_arguments(), exe_test.arg_arrays))
+    grad_map = dict(zip(embed.list_arguments(), exe_test.grad_arrays))
+    assert grad_map["embed_weight"].stype == 'row_sparse'
+    # repeated lookups of a few rows
+    np_data = np.random.randint(low=0, high=in_dim // 2, size=batch)
+    np_weight = np.random.uniform(-1, 1, arg_map["embed_weight"].shape)
+    np_onehot = np.zeros((batch, in_dim))
+    np_onehot[np.arange(batch), np_data] = 1.0
+    # forward
+    arg_map["data"][:] = np_data
+    arg_map["embed_weight"][:] = np_weight
+    exe_test.forward(is_train=True)
+    assert_almost_equal(exe_test.outputs[0].asnumpy(), np.dot(np_onehot, np_weight))
+    # backward
+    np_grad = np.random.uniform(-1, 1, exe_test.outputs[0].shape)
+    grad = mx.nd.zeros(np_grad.shape)
+    grad[:] = np_grad
+    exe_test.backward([grad])
+    weight_grad = grad_map["embed_weight"]
+    assert weight_grad.stype == 'row_sparse'
+    assert same(weight_grad.indices.asnumpy(), np.unique(np_data))
+    assert_almost_equal(weight_grad.asnumpy(), np.dot(np_onehot.T, np_grad), atol=1e-5)
+
+    # forward with the rows of a row_sparse weight pulled for the batch
+    rsp_weight = mx.nd.array(np_weight).tostype('row_sparse')
+    rows = mx.nd.array(np.unique(np_data)[:-1], dtype='int64')
+    retained = mx.nd.sparse.retain(rsp_weight, rows)
+    out = mx.nd.contrib.SparseEmbedding(data=mx.nd.array(np_data), weight=retained,
+                                        input_dim=in_dim, output_dim=out_dim)
+    assert_almost_equal(out.asnumpy(), np.dot(np_onehot, retained.asnumpy()))
+
+
+def test_lookup_row_sparse_grad():
+    in_dim = 30
+    batch = 50
+    # skewed lookups, half of them hit row 0
+    np_idx = np.random.randint(low=0, high=in_dim, size=batch)
+    np_idx[::2] = 0
+    for shape, make_sym in [((in_dim, 4), lambda d, w: mx.sym.Embedding(data=d, weight=w,
+                                                                    input_dim=in_dim,
+                                                                    output_dim=4)),
+                            ((in_dim, 3, 2), lambda d, w: mx.sym.take(w, d))]:
+        data = mx.sym.Variable('data')
+        weight = mx.sym.Variable('weight')
+        sym = make_sym(data, weight)
+        np_weight = np.random.uniform(-1, 1, shape)
+        weight_grad = mx.nd.zeros(shape).tostype('row_sparse')
+        exe = sym.bind(default_context(),
+                       args={'data': mx.nd.array(np_idx), 'weight': mx.nd.array(np_weight)},
+                       args_grad={'weight': weight_grad},
+                       grad_req={'data': 'null', 'weight': 'write'})
+        exe.forward(is_train=True)
+        np_grad = np.random.uniform(-1, 1, exe.outputs[0].shape)
+        exe.backward([mx.nd.array(np_grad)])
+        expected = np.zeros(shape)
+        for i, j in enumerate(np_idx):
+            expected[j] += np_grad[i]
+        assert weight_grad.stype == 'row_sparse'
+        assert same(weight_grad.indices.asnumpy(), np.unique(np_idx))
+        assert_almost_equal(weight_grad.asnumpy(), expected, atol=1e-5)
+
+
+def test_quantized_embedding():
+    in_dim = 20
+    out_dim = 6
+    batch = 16
+    np_rows = np.random.uniform(-1, 1, (in_dim, out_dim)).astype(np.float32)
+    np_data = np.random.randint(low=0, high=in_dim, size=batch)
+    data = mx.nd.array(np_data)
+    for dtype in ['int8', 'float16']:
+        weight = mx.nd.zeros((in_dim, out_dim), dtype=dtype)
+        scale = mx.nd.zeros((in_dim,))
+        mx.nd.contrib.quantized_embedding_update(weight, scale, mx.nd.array(np_rows), out=weight)
+        out = mx.nd.contrib.quantized_embedding(data=data, weight=weight, scale=scale,
+                                                input_dim=in_dim, output_dim=out_dim,
+                                                dtype=dtype)
+        assert out.dtype == np.float32
+        # an int8 value is within half a step of the float32 one
+        atol = (np.abs(np_rows).max() / 127 / 2 if dtype == 'int8' else 1e-3) + 1e-6
+        assert_almost_equal(out.asnumpy(), np_rows[np_data], rtol=0, atol=atol)
+
+        # only the row_sparse rows are written
+        np_new = np.random.uniform(-2, 2, (in_dim, out_dim)).astype(np.float32)
+        indices = np.array([1, 7, 12])
+        rows = mx.nd.sparse.retain(mx.nd.array(np_new).tostype('row_sparse'),
+                                   mx.nd.array(indices, dtype='int64'))
+        before = weight.asnumpy()
+        mx.nd.contrib.quantized_embedding_update(weight, scale, rows, out=weight)
+        expected = np_rows.copy()
+        expected[indices] = np_new[indices]
+        kept = np.setdiff1d(np.arange(in_dim), indices)
+        assert same(weight.asnumpy()[kept], before[kept])
+        dequantized = weight.asnumpy().astype(np.float32) * scale.asnumpy()[:, None]
+        atol = (np.abs(np_new).max() / 127 / 2 if dtype == 'int8' else 2e-3) + 1e-6
+        assert_almost_equal(dequantized, expected, rtol=0, atol=atol)
+
+        # lookup in the rows of a row_sparse weight
+        rsp_weight = mx.nd.sparse.retain(weight.tostype('row_sparse'),
+                                         mx.nd.array(indices, dtype='int64'))
+        out = mx.nd.contrib.quantized_embedding(data=data, weight=rsp_weight, scale=scale,
+                                                input_dim=in_dim, output_dim=out_dim,
+                                                dtype=dtype)
+        mask = np.isin(np_data, indices)[:, None]
+        assert_almost_equal(out.asnumpy(), dequantized[np_data] * mask)
+
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
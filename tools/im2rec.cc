@@ -24,11 +24,18 @@
  *  The 64bit zero pad was reserved for future purposes
  *
  *  Image List Format: unique-image-index label[s] path-to-image
+ *  The images are read, resized and encoded by num_thread threads, and
+ *  written in the order of the list, with the offsets of the records in a
+ *  .idx file next to every output file.
  * \sa dmlc/recordio.h
  */
+#include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include <iomanip>
 #include <sstream>
@@ -60,6 +67,164 @@ int GetInterMethod(int inter_method, int old_width, int old_height, int new_widt
         return inter_method;
     }
 }
+/*! \brief parameters of the packing of an image */
+struct PackParam {
+  int label_width = 1;
+  int pack_label = 0;
+  int new_size = -1;
+  int center_crop = 0;
+  int color_mode = CV_LOAD_IMAGE_COLOR;
+  int unchanged = 0;
+  int inter_method = CV_INTER_LINEAR;
+  std::string encoding = ".jpg";
+  std::vector<int> encode_params;
+  std::string root;
+};
+
+/*! \brief a line of the image list, packed into a record by a worker thread */
+struct PackTask {
+  std::string line;
+  uint64_t image_id;
+  std::string blob;
+  bool valid;
+};
+
+/*! \brief per thread buffers and random numbers of the packing */
+struct PackBuffers {
+  std::vector<unsigned char> decode_buf;
+  std::vector<unsigned char> encode_buf;
+  std::vector<float> label_buf;
+  std::mt19937 prnd;
+};
+
+/*! \brief read, resize and encode the image of the list line of task into its record */
+void PackImage(const PackParam& param, PackTask* task, PackBuffers* buf) {
+  using dmlc::BeginPtr;
+  const static size_t kBufferSize = 1 << 20UL;
+  mxnet::io::ImageRecordIO rec;
+  std::string fname, path;
+  std::string& blob = task->blob;
+  std::istringstream is(task->line);
+  task->valid = false;
+  blob.clear();
+  if (!(is >> rec.header.image_id[0] >> rec.header.label)) return;
+  task->image_id = rec.header.image_id[0];
+  std::vector<float>& label_buf = buf->label_buf;
+  label_buf.assign(param.label_width, 0.f);
+  label_buf[0] = rec.header.label;
+  for (int k = 1; k < param.label_width; ++k) {
+    CHECK(is >> label_buf[k])
+        << "Invalid ImageList, did you provide the correct label_width?";
+  }
+  if (param.pack_label) rec.header.flag = param.label_width;
+  rec.SaveHeader(&blob);
+  if (param.pack_label) {
+    size_t bsize = blob.size();
+    blob.resize(bsize + label_buf.size()*sizeof(float));
+    memcpy(BeginPtr(blob) + bsize,
+           BeginPtr(label_buf), label_buf.size()*sizeof(float));
+  }
+  CHECK(std::getline(is, fname));
+  // eliminate invalid chars in the end
+  while (fname.length() != 0 &&
+         (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
+    fname.resize(fname.length() - 1);
+  }
+  // eliminate invalid chars in beginning.
+  const char *p = fname.c_str();
+  while (isspace(*p)) ++p;
+  path = param.root + p;
+  // use "r" is equal to rb in dmlc::Stream
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path.c_str(), "r"));
+  std::vector<unsigned char>& decode_buf = buf->decode_buf;
+  decode_buf.clear();
+  size_t imsize = 0;
+  while (true) {
+    decode_buf.resize(imsize + kBufferSize);
+    size_t nread = fi->Read(BeginPtr(decode_buf) + imsize, kBufferSize);
+    imsize += nread;
+    decode_buf.resize(imsize);
+    if (nread != kBufferSize) break;
+  }
+  fi.reset();
+
+  if (param.unchanged != 1) {
+    const int new_size = param.new_size;
+    cv::Mat img = cv::imdecode(decode_buf, param.color_mode);
+    CHECK(img.data != NULL) << "OpenCV decode fail:" << path;
+    cv::Mat res = img;
+    if (new_size > 0) {
+      if (param.center_crop) {
+        if (img.rows > img.cols) {
+          int margin = (img.rows - img.cols)/2;
+          img = img(cv::Range(margin, margin+img.cols), cv::Range(0, img.cols));
+        } else {
+          int margin = (img.cols - img.rows)/2;
+          img = img(cv::Range(0, img.rows), cv::Range(margin, margin + img.rows));
+        }
+      }
+      int interpolation_method = 1;
+      if (img.rows > img.cols) {
+          if (img.cols != new_size) {
+              interpolation_method = GetInterMethod(param.inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, buf->prnd);
+              cv::resize(img, res, cv::Size(new_size, img.rows * new_size / img.cols), 0, 0, interpolation_method);
+          } else {
+              res = img.clone();
+          }
+      } else {
+          if (img.rows != new_size) {
+              interpolation_method = GetInterMethod(param.inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, buf->prnd);
+              cv::resize(img, res, cv::Size(new_size * img.cols / img.rows, new_size), 0, 0, interpolation_method);
+          } else {
+              res = img.clone();
+          }
+      }
+    }
+    std::vector<unsigned char>& encode_buf = buf->encode_buf;
+    encode_buf.clear();
+    CHECK(cv::imencode(param.encoding, res, encode_buf, param.encode_params));
+
+    // write buffer
+    size_t bsize = blob.size();
+    blob.resize(bsize + encode_buf.size());
+    memcpy(BeginPtr(blob) + bsize,
+           BeginPtr(encode_buf), encode_buf.size());
+  } else {
+    size_t bsize = blob.size();
+    blob.resize(bsize + decode_buf.size());
+    memcpy(BeginPtr(blob) + bsize,
+           BeginPtr(decode_buf), decode_buf.size());
+  }
+  task->valid = true;
+}
+
+/*! \brief a record file and its index */
+struct RecordOutput {
+  explicit RecordOutput(const std::string& fname) {
+    // the index is named as by tools/im2rec.py
+    std::string idx_name = fname;
+    const std::string ext = ".rec";
+    if (idx_name.size() > ext.size() &&
+        idx_name.compare(idx_name.size() - ext.size(), ext.size(), ext) == 0) {
+      idx_name.resize(idx_name.size() - ext.size());
+    }
+    idx_name += ".idx";
+    LOG(INFO) << "Write to output: " << fname << ", index: " << idx_name;
+    fo.reset(dmlc::Stream::Create(fname.c_str(), "w"));
+    writer.reset(new dmlc::RecordIOWriter(fo.get()));
+    fidx.reset(dmlc::Stream::Create(idx_name.c_str(), "w"));
+  }
+  void Write(const PackTask& task) {
+    std::ostringstream os;
+    os << task.image_id << '\t' << writer->Tell() << '\n';
+    const std::string line = os.str();
+    fidx->Write(line.data(), line.size());
+    writer->WriteRecord(dmlc::BeginPtr(task.blob), task.blob.size());
+  }
+  std::unique_ptr<dmlc::Stream> fo, fidx;
+  std::unique_ptr<dmlc::RecordIOWriter> writer;
+};
+
 int main(int argc, char *argv[]) {
   if (argc < 4) {
     printf("Usage: <image.lst> <image_root_dir> <output.rec> [additional parameters in form key=value]\n"\
@@ -74,20 +239,17 @@ int main(int argc, char *argv[]) {
            "\tquality=QUALITY[default=95] JPEG quality for encoding (1-100, default: 95) or PNG compression for encoding (1-9, default: 3).\n"\
            "\tencoding=ENCODING[default='.jpg'] Encoding type. Can be '.jpg' or '.png'\n"\
            "\tinter_method=INTER_METHOD[default=1] NN(0) BILINEAR(1) CUBIC(2) AREA(3) LANCZOS4(4) AUTO(9) RAND(10).\n"\
-           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n");
+           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n"\
+           "\tnum_thread=NUM_THREAD[default=number of cores] number of threads reading, resizing and encoding the images.\n"\
+           "\tnum_shard=NUM_SHARD[default=1] write the records into NUM_SHARD files, output_0.rec, output_1.rec, ..., in turn.\n");
     return 0;
   }
-  int label_width = 1;
-  int pack_label = 0;
-  int new_size = -1;
+  PackParam param;
   int nsplit = 1;
   int partid = 0;
-  int center_crop = 0;
   int quality = 95;
-  int color_mode = CV_LOAD_IMAGE_COLOR;
-  int unchanged = 0;
-  int inter_method = CV_INTER_LINEAR;
-  std::string encoding(".jpg");
+  int num_thread = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  int num_shard = 1;
   for (int i = 4; i < argc; ++i) {
     char key[128], val[128];
     int effct_len = 0;
@@ -99,50 +261,55 @@ int main(int argc, char *argv[]) {
 #endif
 
     if (effct_len == 2) {
-      if (!strcmp(key, "resize")) new_size = atoi(val);
-      if (!strcmp(key, "label_width")) label_width = atoi(val);
-      if (!strcmp(key, "pack_label")) pack_label = atoi(val);
+      if (!strcmp(key, "resize")) param.new_size = atoi(val);
+      if (!strcmp(key, "label_width")) param.label_width = atoi(val);
+      if (!strcmp(key, "pack_label")) param.pack_label = atoi(val);
       if (!strcmp(key, "nsplit")) nsplit = atoi(val);
       if (!strcmp(key, "part")) partid = atoi(val);
-      if (!strcmp(key, "center_crop")) center_crop = atoi(val);
+      if (!strcmp(key, "center_crop")) param.center_crop = atoi(val);
       if (!strcmp(key, "quality")) quality = atoi(val);
-      if (!strcmp(key, "color")) color_mode = atoi(val);
-      if (!strcmp(key, "encoding")) encoding = std::string(val);
-      if (!strcmp(key, "unchanged")) unchanged = atoi(val);
-      if (!strcmp(key, "inter_method")) inter_method = atoi(val);
+      if (!strcmp(key, "color")) param.color_mode = atoi(val);
+      if (!strcmp(key, "encoding")) param.encoding = std::string(val);
+      if (!strcmp(key, "unchanged")) param.unchanged = atoi(val);
+      if (!strcmp(key, "inter_method")) param.inter_method = atoi(val);
+      if (!strcmp(key, "num_thread")) num_thread = atoi(val);
+      if (!strcmp(key, "num_shard")) num_shard = atoi(val);
     }
   }
   // Check parameters ranges
-  if (color_mode != -1 && color_mode != 0 && color_mode != 1) {
+  if (param.color_mode != -1 && param.color_mode != 0 && param.color_mode != 1) {
     LOG(FATAL) << "Color mode must be -1, 0 or 1.";
   }
-  if (encoding != std::string(".jpg") && encoding != std::string(".png")) {
+  if (param.encoding != std::string(".jpg") && param.encoding != std::string(".png")) {
     LOG(FATAL) << "Encoding mode must be .jpg or .png.";
   }
-  if (label_width <= 1 && pack_label) {
+  if (param.label_width <= 1 && param.pack_label) {
     LOG(FATAL) << "pack_label can only be used when label_width > 1";
   }
-  if (new_size > 0) {
-    LOG(INFO) << "New Image Size: Short Edge " << new_size;
+  if (num_thread < 1 || num_shard < 1) {
+    LOG(FATAL) << "num_thread and num_shard must be positive.";
+  }
+  if (param.new_size > 0) {
+    LOG(INFO) << "New Image Size: Short Edge " << param.new_size;
   } else {
     LOG(INFO) << "Keep origin image size";
   }
-  if (center_crop) {
+  if (param.center_crop) {
     LOG(INFO) << "Center cropping to square";
   }
-  if (color_mode == 0) {
+  if (param.color_mode == 0) {
     LOG(INFO) << "Use gray images";
   }
-  if (color_mode == -1) {
+  if (param.color_mode == -1) {
     LOG(INFO) << "Keep original color mode";
   }
-  LOG(INFO) << "Encoding is " << encoding;
+  LOG(INFO) << "Encoding is " << param.encoding;
 
-  if (encoding == std::string(".png") && quality > 9) {
+  if (param.encoding == std::string(".png") && quality > 9) {
       quality = 3;
   }
-  if (inter_method != 1) {
-      switch (inter_method) {
+  if (param.inter_method != 1) {
+      switch (param.inter_method) {
         case 0:
             LOG(INFO) << "Use inter_method CV_INTER_NN";
             break;
@@ -166,137 +333,78 @@ int main(int argc, char *argv[]) {
             return 0;
       }
   }
+  LOG(INFO) << "Use " << num_thread << " threads";
   std::random_device rd;
-  std::mt19937 prnd(rd());
   using namespace dmlc;
-  const static size_t kBufferSize = 1 << 20UL;
-  std::string root = argv[2];
-  mxnet::io::ImageRecordIO rec;
+  param.root = argv[2];
   size_t imcnt = 0;
   double tstart = dmlc::GetTime();
-  dmlc::InputSplit *flist = dmlc::InputSplit::
-      Create(argv[1], partid, nsplit, "text");
+  std::unique_ptr<dmlc::InputSplit> flist(dmlc::InputSplit::
+      Create(argv[1], partid, nsplit, "text"));
   std::ostringstream os;
   if (nsplit == 1) {
     os << argv[3];
   } else {
     os << argv[3] << ".part" << std::setw(3) << std::setfill('0') << partid;
   }
-  LOG(INFO) << "Write to output: " << os.str();
-  dmlc::Stream *fo = dmlc::Stream::Create(os.str().c_str(), "w");
-  LOG(INFO) << "Output: " << os.str();
-  dmlc::RecordIOWriter writer(fo);
-  std::string fname, path, blob;
-  std::vector<unsigned char> decode_buf;
-  std::vector<unsigned char> encode_buf;
-  std::vector<int> encode_params;
-  if (encoding == std::string(".png")) {
-      encode_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
-      encode_params.push_back(quality);
+  std::vector<std::unique_ptr<RecordOutput> > outputs;
+  if (num_shard == 1) {
+    outputs.emplace_back(new RecordOutput(os.str()));
+  } else {
+    // out.rec is written as out_0.rec, out_1.rec, ... and out as out_0, out_1, ...
+    std::string base = os.str(), ext;
+    const size_t dot = base.rfind('.');
+    if (dot != std::string::npos && base.find('/', dot) == std::string::npos) {
+      ext = base.substr(dot);
+      base.resize(dot);
+    }
+    for (int k = 0; k < num_shard; ++k) {
+      outputs.emplace_back(new RecordOutput(base + "_" + std::to_string(k) + ext));
+    }
+  }
+  if (param.encoding == std::string(".png")) {
+      param.encode_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+      param.encode_params.push_back(quality);
       LOG(INFO) << "PNG encoding compression: " << quality;
   } else {
-      encode_params.push_back(CV_IMWRITE_JPEG_QUALITY);
-      encode_params.push_back(quality);
+      param.encode_params.push_back(CV_IMWRITE_JPEG_QUALITY);
+      param.encode_params.push_back(quality);
       LOG(INFO) << "JPEG encoding quality: " << quality;
   }
+  std::vector<PackBuffers> buffers(num_thread);
+  for (auto& buf : buffers) buf.prnd.seed(rd());
+  // the lines are packed in batches, whose records are written in order
+  // once all of them are encoded
+  const size_t batch_size = 256 * num_thread;
+  std::vector<PackTask> tasks(batch_size);
   dmlc::InputSplit::Blob line;
-  std::vector<float> label_buf(label_width, 0.f);
-
-  while (flist->NextRecord(&line)) {
-    std::string sline(static_cast<char*>(line.dptr), line.size);
-    std::istringstream is(sline);
-    if (!(is >> rec.header.image_id[0] >> rec.header.label)) continue;
-    label_buf[0] = rec.header.label;
-    for (int k = 1; k < label_width; ++k) {
-      CHECK(is >> label_buf[k])
-          << "Invalid ImageList, did you provide the correct label_width?";
-    }
-    if (pack_label) rec.header.flag = label_width;
-    rec.SaveHeader(&blob);
-    if (pack_label) {
-      size_t bsize = blob.size();
-      blob.resize(bsize + label_buf.size()*sizeof(float));
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(label_buf), label_buf.size()*sizeof(float));
-    }
-    CHECK(std::getline(is, fname));
-    // eliminate invalid chars in the end
-    while (fname.length() != 0 &&
-           (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
-      fname.resize(fname.length() - 1);
+  bool more = true;
+  while (more) {
+    size_t n = 0;
+    while (n < batch_size && (more = flist->NextRecord(&line))) {
+      tasks[n++].line.assign(static_cast<char*>(line.dptr), line.size);
     }
-    // eliminate invalid chars in beginning.
-    const char *p = fname.c_str();
-    while (isspace(*p)) ++p;
-    path = root + p;
-    // use "r" is equal to rb in dmlc::Stream
-    dmlc::Stream *fi = dmlc::Stream::Create(path.c_str(), "r");
-    decode_buf.clear();
-    size_t imsize = 0;
-    while (true) {
-      decode_buf.resize(imsize + kBufferSize);
-      size_t nread = fi->Read(BeginPtr(decode_buf) + imsize, kBufferSize);
-      imsize += nread;
-      decode_buf.resize(imsize);
-      if (nread != kBufferSize) break;
-    }
-    delete fi;
-
-
-    if (unchanged != 1) {
-      cv::Mat img = cv::imdecode(decode_buf, color_mode);
-      CHECK(img.data != NULL) << "OpenCV decode fail:" << path;
-      cv::Mat res = img;
-      if (new_size > 0) {
-        if (center_crop) {
-          if (img.rows > img.cols) {
-            int margin = (img.rows - img.cols)/2;
-            img = img(cv::Range(margin, margin+img.cols), cv::Range(0, img.cols));
-          } else {
-            int margin = (img.cols - img.rows)/2;
-            img = img(cv::Range(0, img.rows), cv::Range(margin, margin + img.rows));
-          }
-        }
-        int interpolation_method = 1;
-        if (img.rows > img.cols) {
-            if (img.cols != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, prnd);
-                cv::resize(img, res, cv::Size(new_size, img.rows * new_size / img.cols), 0, 0, interpolation_method);
-            } else {
-                res = img.clone();
-            }
-        } else {
-            if (img.rows != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, prnd);
-                cv::resize(img, res, cv::Size(new_size * img.cols / img.rows, new_size), 0, 0, interpolation_method);
-            } else {
-                res = img.clone();
-            }
-        }
+    std::atomic<size_t> next(0);
+    auto pack = [&](int tid) {
+      for (size_t i = next++; i < n; i = next++) {
+        PackImage(param, &tasks[i], &buffers[tid]);
       }
-      encode_buf.clear();
-      CHECK(cv::imencode(encoding, res, encode_buf, encode_params));
-
-      // write buffer
-      size_t bsize = blob.size();
-      blob.resize(bsize + encode_buf.size());
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(encode_buf), encode_buf.size());
-    } else {
-      size_t bsize = blob.size();
-      blob.resize(bsize + decode_buf.size());
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(decode_buf), decode_buf.size());
+    };
+    std::vector<std::thread> workers;
+    for (int tid = 1; tid < num_thread; ++tid) {
+      workers.emplace_back(pack, tid);
     }
-    writer.WriteRecord(BeginPtr(blob), blob.size());
-    // write header
-    ++imcnt;
-    if (imcnt % 1000 == 0) {
-      LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
+    pack(0);
+    for (auto& t : workers) t.join();
+    for (size_t i = 0; i < n; ++i) {
+      if (!tasks[i].valid) continue;
+      outputs[imcnt % num_shard]->Write(tasks[i]);
+      ++imcnt;
+      if (imcnt % 1000 == 0) {
+        LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
+      }
     }
   }
   LOG(INFO) << "Total: " << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
-  delete fo;
-  delete flist;
   return 0;
 }
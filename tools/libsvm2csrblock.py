@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+convert a libsvm file into a csr block file read by mx.io.CSRBlockIter
+"""
+import argparse
+import struct
+import numpy as np
+
+MAGIC = 0x4b4c42525343584d
+
+def write_block(fout, labels, indptr, indices, values, batch_size):
+    """write the rows of one block, padded with empty rows to batch_size"""
+    num_pad = batch_size - len(labels)
+    indptr = indptr + [indptr[-1]] * num_pad
+    labels = labels + [0.0] * num_pad
+    fout.write(struct.pack('<QQQ', batch_size, num_pad, len(indices)))
+    fout.write(np.array(indptr, dtype='<i8').tobytes())
+    fout.write(np.array(indices, dtype='<i8').tobytes())
+    fout.write(np.array(values, dtype='<f4').tobytes())
+    fout.write(np.array(labels, dtype='<f4').tobytes())
+    size = 4 * (len(values) + len(labels))
+    fout.write(b'\0' * ((8 - size % 8) % 8))
+
+def convert(src, dst, num_features, batch_size):
+    """convert the libsvm file src with zero-based indices into dst"""
+    with open(src) as fin, open(dst, 'wb') as fout:
+        fout.write(struct.pack('<QQQ', MAGIC, num_features, batch_size))
+        labels, indptr, indices, values = [], [0], [], []
+        for line in fin:
+            tokens = line.split('#')[0].split()
+            if not tokens:
+                continue
+            labels.append(float(tokens[0].split(':')[0]))
+            for token in tokens[1:]:
+                if token.startswith('qid:'):
+                    continue
+                pair = token.split(':')
+                index = int(pair[0])
+                assert index < num_features, 'index %d is out of range' % index
+                indices.append(index)
+                values.append(float(pair[1]) if len(pair) > 1 else 1.0)
+            indptr.append(len(indices))
+            if len(labels) == batch_size:
+                write_block(fout, labels, indptr, indices, values, batch_size)
+                labels, indptr, indices, values = [], [0], [], []
+        if labels:
+            write_block(fout, labels, indptr, indices, values, batch_size)
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Convert a libsvm file into a csr block file, whose blocks of '
+                    'batch-size rows are returned as batches by mx.io.CSRBlockIter.')
+    parser.add_argument('src', help='the libsvm file, with zero-based indices')
+    parser.add_argument('dst', help='the csr block file')
+    parser.add_argument('--num-features', type=int, required=True,
+                        help='the number of columns of the data')
+    parser.add_argument('--batch-size', type=int, required=True,
+                        help='the number of rows of each block')
+    args = parser.parse_args()
+    convert(args.src, args.dst, args.num_features, args.batch_size)